@@ -133,6 +133,40 @@ int my_aes_get_size(uint32 source_length, enum my_aes_opmode mode);
 */
 
 my_bool my_aes_needs_iv(my_aes_opmode opmode);
+
+/**
+  Cipher state that can be reused between calls
+
+  Setting up the cipher context and expanding the key costs more than
+  encrypting a short value. Callers that run the same key over many values
+  keep one of these around and pass it to the calls below; the key schedule
+  is only rebuilt when the key, mode, padding or direction changes.
+  A context must not be shared between threads.
+*/
+struct MyAesCtx;
+
+MyAesCtx *my_aes_ctx_create();
+void my_aes_ctx_destroy(MyAesCtx *ctx);
+
+/**
+  Same as my_aes_encrypt() above, reusing the state kept in ctx
+*/
+int my_aes_encrypt(MyAesCtx *ctx,
+                   const unsigned char *source, uint32 source_length,
+                   unsigned char *dest,
+                   const unsigned char *key, uint32 key_length,
+                   enum my_aes_opmode mode, const unsigned char *iv,
+                   bool padding = true);
+
+/**
+  Same as my_aes_decrypt() above, reusing the state kept in ctx
+*/
+int my_aes_decrypt(MyAesCtx *ctx,
+                   const unsigned char *source, uint32 source_length,
+                   unsigned char *dest,
+                   const unsigned char *key, uint32 key_length,
+                   enum my_aes_opmode mode, const unsigned char *iv,
+                   bool padding = true);
 }
 //C_MODE_END
 
@@ -16,6 +16,7 @@
 #include "my_aes.h"
 #include "my_aes_impl.h"
 #include <string>
+#include <string.h>
 #include <assert.h>
 
 #include <openssl/aes.h>
@@ -213,4 +214,118 @@ my_bool my_aes_needs_iv(my_aes_opmode opmode)
   DBUG_ASSERT(iv_length == 0 || iv_length == MY_AES_IV_SIZE);
   return iv_length != 0 ? TRUE : FALSE;
 }
+
+struct MyAesCtx
+{
+  EVP_CIPHER_CTX evp;
+  /* the fields below describe the key schedule loaded in evp */
+  bool initialized;
+  int encrypt;
+  enum my_aes_opmode mode;
+  bool padding;
+  std::string key;
+};
+
+MyAesCtx *my_aes_ctx_create()
+{
+  MyAesCtx *ctx= new MyAesCtx();
+  EVP_CIPHER_CTX_init(&ctx->evp);
+  ctx->initialized= false;
+  return ctx;
+}
+
+void my_aes_ctx_destroy(MyAesCtx *ctx)
+{
+  if (ctx == NULL)
+    return;
+  EVP_CIPHER_CTX_cleanup(&ctx->evp);
+  delete ctx;
+}
+
+/**
+  Get ctx ready for a new message
+
+  When the previous message used the same settings only the buffered state
+  and the IV are reset; OpenSSL keeps the expanded key (and uses AES-NI for
+  it when the CPU has it).
+*/
+static bool aes_ctx_begin(MyAesCtx *ctx, int encrypt,
+                          const unsigned char *key, uint32 key_length,
+                          enum my_aes_opmode mode, const unsigned char *iv,
+                          bool padding)
+{
+  if (ctx->initialized && ctx->encrypt == encrypt && ctx->mode == mode &&
+      ctx->padding == padding && ctx->key.size() == key_length &&
+      memcmp(ctx->key.data(), key, key_length) == 0)
+    return EVP_CipherInit_ex(&ctx->evp, NULL, NULL, NULL, iv, encrypt);
+
+  const EVP_CIPHER *cipher= aes_evp_type(mode);
+  /* The real key to be used for encryption */
+  unsigned char rkey[MAX_AES_KEY_LENGTH / 8];
+  my_aes_create_key(key, key_length, rkey, mode);
+
+  ctx->initialized= false;
+  if (!EVP_CipherInit_ex(&ctx->evp, cipher, NULL, rkey, iv, encrypt))
+    return false;
+  if (!EVP_CIPHER_CTX_set_padding(&ctx->evp, padding))
+    return false;
+  ctx->initialized= true;
+  ctx->encrypt= encrypt;
+  ctx->mode= mode;
+  ctx->padding= padding;
+  ctx->key.assign((const char *) key, key_length);
+  return true;
+}
+
+static int aes_ctx_run(MyAesCtx *ctx, int encrypt,
+                       const unsigned char *source, uint32 source_length,
+                       unsigned char *dest,
+                       const unsigned char *key, uint32 key_length,
+                       enum my_aes_opmode mode, const unsigned char *iv,
+                       bool padding)
+{
+  const EVP_CIPHER *cipher= aes_evp_type(mode);
+  int u_len, f_len;
+
+  if (!cipher || (EVP_CIPHER_iv_length(cipher) > 0 && !iv))
+    return MY_AES_BAD_DATA;
+
+  if (!aes_ctx_begin(ctx, encrypt, key, key_length, mode, iv, padding))
+    goto aes_error;                             /* Error */
+  if (!EVP_CipherUpdate(&ctx->evp, dest, &u_len, source, source_length))
+    goto aes_error;                             /* Error */
+  if (!EVP_CipherFinal_ex(&ctx->evp, dest + u_len, &f_len))
+    goto aes_error;                             /* Error */
+
+  return u_len + f_len;
+
+aes_error:
+  /* need to explicitly clean up the error if we want to ignore it */
+  ERR_clear_error();
+  /* the next call starts from a clean key schedule */
+  ctx->initialized= false;
+  return MY_AES_BAD_DATA;
+}
+
+int my_aes_encrypt(MyAesCtx *ctx,
+                   const unsigned char *source, uint32 source_length,
+                   unsigned char *dest,
+                   const unsigned char *key, uint32 key_length,
+                   enum my_aes_opmode mode, const unsigned char *iv,
+                   bool padding)
+{
+  return aes_ctx_run(ctx, 1, source, source_length, dest,
+                     key, key_length, mode, iv, padding);
+}
+
+int my_aes_decrypt(MyAesCtx *ctx,
+                   const unsigned char *source, uint32 source_length,
+                   unsigned char *dest,
+                   const unsigned char *key, uint32 key_length,
+                   enum my_aes_opmode mode, const unsigned char *iv,
+                   bool padding)
+{
+  return aes_ctx_run(ctx, 0, source, source_length, dest,
+                     key, key_length, mode, iv, padding);
+}
 }
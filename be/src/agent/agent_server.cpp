@@ -80,6 +80,10 @@ AgentServer::AgentServer(ExecEnv* exec_env,
 //    }
 //    boost::filesystem::create_directories(config::agent_tmp_dir);
 
+    if (exec_env != NULL) {
+        TaskWorkerPool::scheduler()->init_metrics(exec_env->metrics());
+    }
+
     // init task worker pool
     _create_table_workers = new TaskWorkerPool(
             TaskWorkerPool::TaskWorkerType::CREATE_TABLE,
@@ -14,6 +14,7 @@
 // under the License.
 
 #include "agent/file_downloader.h"
+#include <unistd.h>
 #include <cstdio>
 #include <cstring>
 #include <fstream>
@@ -147,8 +148,10 @@ AgentStatus FileDownloader::_install_opt(
 
     // Set max recv speed(bytes/s)
     if (status == PALO_SUCCESS) {
+        curl_off_t max_recv_speed = _downloader_param.max_download_speed_kbps > 0
+                ? _downloader_param.max_download_speed_kbps : config::max_download_speed_kbps;
         curl_ret = curl_easy_setopt(
-                curl, CURLOPT_MAX_RECV_SPEED_LARGE, config::max_download_speed_kbps * 1024);
+                curl, CURLOPT_MAX_RECV_SPEED_LARGE, max_recv_speed * 1024);
 
         if (curl_ret != CURLE_OK) {
             status = PALO_FILE_DOWNLOAD_INSTALL_OPT_FAILED;
@@ -223,6 +226,17 @@ AgentStatus FileDownloader::_install_opt(
                 }
             }
         } else if (output_type == OutputType::FILE) {
+            // Resume from local file length, curl fails if server ignores the range
+            if (_downloader_param.resume_offset > 0) {
+                curl_ret = curl_easy_setopt(curl, CURLOPT_RESUME_FROM_LARGE,
+                        (curl_off_t)_downloader_param.resume_offset);
+                if (curl_ret != CURLE_OK) {
+                    status = PALO_FILE_DOWNLOAD_INSTALL_OPT_FAILED;
+                    OLAP_LOG_WARNING("curl setopt RESUME_FROM failed.[error=%s]",
+                                     curl_easy_strerror(curl_ret));
+                }
+            }
+
             // Set callback function
             curl_ret = curl_easy_setopt(
                     curl,
@@ -345,10 +359,11 @@ AgentStatus FileDownloader::download_file() {
     FileHandler* file_handler = new FileHandler();
     OLAPStatus olap_status = OLAP_SUCCESS;
     // Prepare some infomation
+    uint64_t resume_offset = _downloader_param.resume_offset;
     if (status == PALO_SUCCESS) {
         olap_status = file_handler->open_with_mode(
                 _downloader_param.local_file_path,
-                O_CREAT | O_TRUNC | O_WRONLY, S_IRUSR | S_IWUSR);
+                O_CREAT | O_WRONLY | (resume_offset > 0 ? 0 : O_TRUNC), S_IRUSR | S_IWUSR);
 
         if (olap_status != OLAP_SUCCESS) {
             status = PALO_FILE_DOWNLOAD_INVALID_PARAM;
@@ -357,6 +372,16 @@ AgentStatus FileDownloader::download_file() {
         }
     }
 
+    // Drop the bytes after resume offset which may be written partially
+    if (status == PALO_SUCCESS && resume_offset > 0) {
+        if (ftruncate(file_handler->fd(), resume_offset) != 0
+                || file_handler->seek(resume_offset, SEEK_SET) != (off_t)resume_offset) {
+            status = PALO_FILE_DOWNLOAD_INVALID_PARAM;
+            OLAP_LOG_WARNING("seek loacal file failed.[file_path=%s offset=%lu]",
+                   _downloader_param.local_file_path.c_str(), resume_offset);
+        }
+    }
+
     char errbuf[CURL_ERROR_SIZE];
     if (status == PALO_SUCCESS) {
         status = _install_opt(OutputType::FILE, curl, errbuf, NULL, file_handler);
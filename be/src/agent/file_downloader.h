@@ -40,11 +40,19 @@ public:
     };
 
     struct FileDownloaderParam {
+        FileDownloaderParam() :
+                curl_opt_timeout(0), max_download_speed_kbps(0), resume_offset(0) {}
+
         std::string username;
         std::string password;
         std::string remote_file_path;
         std::string local_file_path;
         uint32_t curl_opt_timeout;
+        // 0 means use config::max_download_speed_kbps
+        uint32_t max_download_speed_kbps;
+        // download_file() keeps the first resume_offset bytes of local file
+        // and requests the rest by 'Range' header
+        uint64_t resume_offset;
     };
 
     explicit FileDownloader(const FileDownloaderParam& param);
@@ -22,6 +22,10 @@
 #include "gen_cpp/Status_types.h"
 #include "olap/olap_rootpath.h"
 #include "olap/utils.h"
+#include "runtime/fragment_mgr.h"
+#include "runtime/mem_tracker.h"
+#include "runtime/thread_resource_mgr.h"
+#include "util/priority_thread_pool.hpp"
 
 using std::fstream;
 using std::nothrow;
@@ -31,8 +35,9 @@ using apache::thrift::transport::TProcessor;
 
 namespace palo {
 
-HeartbeatServer::HeartbeatServer(TMasterInfo* master_info) :
+HeartbeatServer::HeartbeatServer(TMasterInfo* master_info, ExecEnv* exec_env) :
         _master_info(master_info),
+        _exec_env(exec_env),
         _epoch(0) {
     _olap_rootpath_instance = OLAPRootPath::get_instance();
 }
@@ -119,6 +124,11 @@ void HeartbeatServer::heartbeat(
         backend_info.__set_be_port(config::be_port);
         backend_info.__set_http_port(config::webserver_port);
         backend_info.__set_be_rpc_port(config::be_rpc_port);
+        if (_exec_env != NULL) {
+            TBackendLoad backend_load;
+            _get_backend_load(&backend_load);
+            heartbeat_result.__set_backend_load(backend_load);
+        }
     } else {
         status_code = TStatusCode::RUNTIME_ERROR;
     }
@@ -128,13 +138,50 @@ void HeartbeatServer::heartbeat(
     heartbeat_result.__set_backend_info(backend_info);
 }
 
+void HeartbeatServer::_get_backend_load(TBackendLoad* backend_load) {
+    if (_exec_env->thread_pool() != NULL) {
+        backend_load->__set_scan_queue_size(_exec_env->thread_pool()->get_queue_size());
+    }
+
+    if (_exec_env->thread_mgr() != NULL && _exec_env->thread_mgr()->cpu_busy_percent() >= 0) {
+        backend_load->__set_cpu_busy_percent(_exec_env->thread_mgr()->cpu_busy_percent());
+    }
+
+    MemTracker* mem_tracker = _exec_env->process_mem_tracker();
+    if (mem_tracker != NULL) {
+        backend_load->__set_mem_used_bytes(mem_tracker->consumption());
+        if (mem_tracker->has_limit()) {
+            backend_load->__set_mem_limit_bytes(mem_tracker->limit());
+        }
+    }
+
+    if (_exec_env->fragment_mgr() != NULL) {
+        backend_load->__set_num_running_fragments(
+                _exec_env->fragment_mgr()->num_running_fragments());
+    }
+
+    vector<OLAPRootPathLoad> root_paths_load;
+    _olap_rootpath_instance->get_all_root_path_load(&root_paths_load);
+    vector<TDiskLoad> disk_loads;
+    for (const OLAPRootPathLoad& root_path_load : root_paths_load) {
+        TDiskLoad disk_load;
+        disk_load.__set_root_path(root_path_load.root_path);
+        disk_load.__set_io_util_percent(static_cast<int32_t>(root_path_load.io_util));
+        disk_load.__set_read_latency_us(
+                static_cast<int64_t>(root_path_load.read_latency_ms * 1000));
+        disk_loads.push_back(disk_load);
+    }
+    backend_load->__set_disk_loads(disk_loads);
+}
+
 AgentStatus create_heartbeat_server(
         ExecEnv* exec_env,
         uint32_t server_port,
         ThriftServer** thrift_server,
         uint32_t worker_thread_num,
         TMasterInfo* local_master_info) {
-    HeartbeatServer* heartbeat_server = new (nothrow) HeartbeatServer(local_master_info);
+    HeartbeatServer* heartbeat_server =
+            new (nothrow) HeartbeatServer(local_master_info, exec_env);
     if (heartbeat_server == NULL) {
         return PALO_ERROR;
     }
@@ -30,7 +30,8 @@ const uint32_t HEARTBEAT_INTERVAL = 10;
 
 class HeartbeatServer : public HeartbeatServiceIf {
 public:
-    explicit HeartbeatServer(TMasterInfo* master_info);
+    // exec_env may be NULL, then no load is reported
+    explicit HeartbeatServer(TMasterInfo* master_info, ExecEnv* exec_env = NULL);
     virtual ~HeartbeatServer() {};
 
     virtual void init_cluster_id();
@@ -44,7 +45,13 @@ public:
     // * heartbeat_result: The result of heartbeat set
     virtual void heartbeat(THeartbeatResult& heartbeat_result, const TMasterInfo& master_info);
 private:
+    // Collects the load of this backend from the stats kept by the scanner pool, the
+    // thread and memory managers and the disk monitor. No new sampling is done, so a
+    // heartbeat stays cheap.
+    void _get_backend_load(TBackendLoad* backend_load);
+
     TMasterInfo* _master_info;
+    ExecEnv* _exec_env;
     OLAPRootPath* _olap_rootpath_instance;
     int64_t _epoch;
     DISALLOW_COPY_AND_ASSIGN(HeartbeatServer);
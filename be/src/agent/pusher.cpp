@@ -171,7 +171,7 @@ void Pusher::_get_file_name_from_path(const string& file_path, string* file_name
     *file_name = file_path.substr(found + 1) + "_" + boost::lexical_cast<string>(tid);
 }
 
-AgentStatus Pusher::process(vector<TTabletInfo>* tablet_infos) {
+AgentStatus Pusher::fetch_file() {
     AgentStatus status = PALO_SUCCESS;
 
     if (!_is_init) {
@@ -180,7 +180,7 @@ AgentStatus Pusher::process(vector<TTabletInfo>* tablet_infos) {
     }
 
     // Remote file not empty, need to download
-    if (_push_req.__isset.http_file_path) {
+    if (_push_req.__isset.http_file_path && !_is_file_fetched) {
         // Get file length
         uint64_t file_size = 0;
         uint64_t estimate_time_out = DEFAULT_DOWNLOAD_TIMEOUT;
@@ -250,7 +250,9 @@ AgentStatus Pusher::process(vector<TTabletInfo>* tablet_infos) {
             }
             
             if (status == PALO_SUCCESS) {
+                _remote_file_path = _push_req.http_file_path;
                 _push_req.http_file_path = _downloader_param.local_file_path;
+                _is_file_fetched = true;
                 break;
             }
 #ifndef BE_TEST
@@ -259,6 +261,12 @@ AgentStatus Pusher::process(vector<TTabletInfo>* tablet_infos) {
         }
     }
 
+    return status;
+}
+
+AgentStatus Pusher::process(vector<TTabletInfo>* tablet_infos) {
+    AgentStatus status = fetch_file();
+
     if (status == PALO_SUCCESS) {
         // Load delta file
         time_t push_begin = time(NULL);
@@ -270,6 +278,13 @@ AgentStatus Pusher::process(vector<TTabletInfo>* tablet_infos) {
         }
     }
 
+    if (_is_init) {
+        remove_file();
+    }
+    return status;
+}
+
+void Pusher::remove_file() {
     // Delete download file
     boost::filesystem::path download_file_path(_downloader_param.local_file_path);
     if (boost::filesystem::exists(download_file_path)) {
@@ -279,6 +294,10 @@ AgentStatus Pusher::process(vector<TTabletInfo>* tablet_infos) {
         }
     }
 
-    return status;
+    // A retry downloads the file again
+    if (_is_file_fetched) {
+        _push_req.http_file_path = _remote_file_path;
+        _is_file_fetched = false;
+    }
 }
 } // namespace palo
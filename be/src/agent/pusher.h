@@ -44,12 +44,27 @@ public:
     // * tablet_infos: The info of pushed tablet after push data
     virtual AgentStatus process(std::vector<TTabletInfo>* tablet_infos);
 
+    // Downloads the file to push, process() does this itself if it wasn't done
+    // before.
+    AgentStatus fetch_file();
+
+    // Removes the downloaded file, process() does this itself.
+    void remove_file();
+
+    // The push request, whose file path points to the local file once it is fetched.
+    const TPushReq& request() const {
+        return _push_req;
+    }
+
 private:
     AgentStatus _get_tmp_file_dir(const std::string& root_path, std::string* local_path);
     AgentStatus _download_file();
     void _get_file_name_from_path(const std::string& file_path, std::string* file_name);
     
     bool _is_init = false;
+    bool _is_file_fetched = false;
+    // The http path of a fetched file
+    std::string _remote_file_path;
     TPushReq _push_req;
     FileDownloader::FileDownloaderParam _downloader_param;
     CommandExecutor* _command_executor;
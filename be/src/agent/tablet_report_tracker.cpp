@@ -0,0 +1,92 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "agent/tablet_report_tracker.h"
+
+#include <time.h>
+
+#include "common/config.h"
+#include "util/hash_util.hpp"
+
+namespace palo {
+
+TabletReportTracker::TabletReportTracker() :
+        _acked_epoch(-1),
+        _master_accepts_incremental(false),
+        _last_full_report_time(0),
+        _pending_epoch(-1),
+        _pending_full(false) {
+}
+
+uint64_t TabletReportTracker::fingerprint(const TTablet& tablet) {
+    uint64_t hash = 0;
+    for (const TTabletInfo& info : tablet.tablet_infos) {
+        int64_t fields[] = {
+            info.schema_hash, info.version, info.version_hash, info.row_count,
+            info.data_size, info.__isset.storage_medium ? info.storage_medium + 1 : 0
+        };
+        hash = HashUtil::hash64(fields, sizeof(fields), hash);
+    }
+    return hash;
+}
+
+bool TabletReportTracker::prepare(int64_t epoch, TReportRequest* request) {
+    std::map<TTabletId, TTablet>& tablets = request->tablets;
+    _pending.clear();
+    _pending.reserve(tablets.size());
+    for (auto& it : tablets) {
+        _pending[it.first] = fingerprint(it.second);
+    }
+    _pending_epoch = epoch;
+
+    int64_t now = time(NULL);
+    int32_t full_interval = config::report_olap_table_full_interval_seconds;
+    _pending_full = full_interval <= 0 || epoch != _acked_epoch
+            || !_master_accepts_incremental
+            || now - _last_full_report_time >= full_interval;
+    if (_pending_full) {
+        return false;
+    }
+
+    std::set<TTabletId> removed_tablets;
+    for (auto& it : _acked) {
+        if (_pending.count(it.first) == 0) {
+            removed_tablets.insert(it.first);
+        }
+    }
+    for (auto it = tablets.begin(); it != tablets.end();) {
+        auto acked = _acked.find(it->first);
+        if (acked != _acked.end() && acked->second == _pending[it->first]) {
+            it = tablets.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    request->__set_incremental(true);
+    request->__set_removed_tablets(removed_tablets);
+    return true;
+}
+
+void TabletReportTracker::acknowledge(bool master_accepts_incremental) {
+    _acked.swap(_pending);
+    _pending.clear();
+    _acked_epoch = _pending_epoch;
+    _master_accepts_incremental = master_accepts_incremental;
+    if (_pending_full) {
+        _last_full_report_time = time(NULL);
+    }
+}
+
+}  // namespace palo
@@ -0,0 +1,72 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_AGENT_TABLET_REPORT_TRACKER_H
+#define BDG_PALO_BE_SRC_AGENT_TABLET_REPORT_TRACKER_H
+
+#include <stdint.h>
+
+#include <map>
+#include <set>
+#include <unordered_map>
+
+#include "gen_cpp/MasterService_types.h"
+#include "gen_cpp/Types_types.h"
+
+namespace palo {
+
+// Turns the full tablet reports of a backend into incremental ones.
+//
+// The tracker remembers a fingerprint of every tablet in the last report the master
+// accepted, and strips the tablets that didn't change since from the next report. The
+// tablets that disappeared meanwhile are reported as removed. A full report is sent
+// every config::report_olap_table_full_interval_seconds, as well as the first one to
+// a new master, so that the master recovers from anything a delta missed. Masters of
+// older releases take every report for a full one and would drop the tablets missing
+// from a delta, so only full reports are sent until the master accepted one and said
+// it understands incremental ones.
+//
+// Not thread-safe, it's used by the single tablet report thread.
+class TabletReportTracker {
+public:
+    TabletReportTracker();
+
+    // Prepares the tablets of 'request' for a report to the master of 'epoch', given
+    // all tablets of the backend in request->tablets. Returns true if the report became
+    // incremental.
+    bool prepare(int64_t epoch, TReportRequest* request);
+
+    // Called when the master accepted the last prepared report, with whether it
+    // accepts incremental reports (TMasterResult.accepts_incremental_report).
+    void acknowledge(bool master_accepts_incremental);
+
+private:
+    typedef std::unordered_map<TTabletId, uint64_t> Fingerprints;
+
+    // Covers the versions, sizes and storage medium of all schema hashes of 'tablet'.
+    static uint64_t fingerprint(const TTablet& tablet);
+
+    Fingerprints _acked;
+    int64_t _acked_epoch;
+    bool _master_accepts_incremental;
+    int64_t _last_full_report_time;
+
+    Fingerprints _pending;
+    int64_t _pending_epoch;
+    bool _pending_full;
+};
+
+}  // namespace palo
+#endif  // BDG_PALO_BE_SRC_AGENT_TABLET_REPORT_TRACKER_H
@@ -0,0 +1,202 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "agent/task_scheduler.h"
+
+#include <time.h>
+
+#include <chrono>
+
+#include "common/config.h"
+#include "common/logging.h"
+#include "gen_cpp/Types_types.h"
+
+namespace palo {
+
+// Waiters look at the priorities again at least this often, since they age.
+static const int64_t AGING_CHECK_INTERVAL_MS = 1000;
+
+static int64_t monotonic_millis() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+AgentTaskScheduler::AgentTaskScheduler(int max_running, int max_running_per_disk) :
+        _max_running(max_running),
+        _max_running_per_disk(max_running_per_disk),
+        _num_running(0),
+        _metrics(NULL) {
+}
+
+AgentTaskScheduler::Priority AgentTaskScheduler::priority_of(const TAgentTaskRequest& task) {
+    if (task.__isset.priority && task.priority == TPriority::HIGH) {
+        return HIGH;
+    }
+    switch (task.task_type) {
+    case TTaskType::ROLLUP:
+    case TTaskType::SCHEMA_CHANGE:
+    case TTaskType::STORAGE_MEDIUM_MIGRATE:
+    case TTaskType::CHECK_CONSISTENCY:
+        return LOW;
+    default:
+        return NORMAL;
+    }
+}
+
+void AgentTaskScheduler::init_metrics(MetricGroup* metrics) {
+    std::lock_guard<std::mutex> l(_lock);
+    DCHECK(_type_stats.empty());
+    _metrics = metrics;
+}
+
+AgentTaskScheduler::TypeStats* AgentTaskScheduler::get_type_stats(TTaskType::type type) {
+    auto it = _type_stats.find(type);
+    if (it != _type_stats.end()) {
+        return &it->second;
+    }
+    TypeStats* stats = &_type_stats[type];
+    if (_metrics != NULL) {
+        std::stringstream ss;
+        ss << "palo_be.agent_task." << _TTaskType_VALUES_TO_NAMES.at(type);
+        stats->queued_metric = _metrics->AddGauge(ss.str() + ".queued", 0L);
+        stats->started_metric = _metrics->AddCounter(ss.str() + ".started", 0L);
+        stats->wait_ms_metric = _metrics->AddCounter(ss.str() + ".wait_ms", 0L);
+    }
+    return stats;
+}
+
+void AgentTaskScheduler::task_queued(const TAgentTaskRequest& task) {
+    std::lock_guard<std::mutex> l(_lock);
+    TypeStats* stats = get_type_stats(task.task_type);
+    ++stats->num_queued;
+    if (stats->queued_metric != NULL) {
+        stats->queued_metric->increment(1);
+    }
+    _queued_time_ms[std::make_pair(task.task_type, task.signature)] = monotonic_millis();
+}
+
+void AgentTaskScheduler::task_dequeued(const TAgentTaskRequest& task) {
+    std::lock_guard<std::mutex> l(_lock);
+    dequeue_locked(task, monotonic_millis());
+}
+
+void AgentTaskScheduler::dequeue_locked(const TAgentTaskRequest& task, int64_t now_ms) {
+    TypeStats* stats = get_type_stats(task.task_type);
+    ++stats->num_started;
+    if (stats->started_metric != NULL) {
+        stats->started_metric->increment(1);
+    }
+    auto it = _queued_time_ms.find(std::make_pair(task.task_type, task.signature));
+    if (it == _queued_time_ms.end()) {
+        return;
+    }
+    int64_t wait_ms = now_ms - it->second;
+    _queued_time_ms.erase(it);
+    --stats->num_queued;
+    stats->total_wait_ms += wait_ms;
+    if (stats->queued_metric != NULL) {
+        stats->queued_metric->increment(-1);
+        stats->wait_ms_metric->increment(wait_ms);
+    }
+}
+
+bool AgentTaskScheduler::has_room(const Waiter& waiter) const {
+    if (_max_running > 0 && _num_running >= _max_running) {
+        return false;
+    }
+    if (_max_running_per_disk <= 0 || waiter.disk->empty()) {
+        return true;
+    }
+    auto it = _disk_running.find(*waiter.disk);
+    return it == _disk_running.end() || it->second < _max_running_per_disk;
+}
+
+std::list<AgentTaskScheduler::Waiter>::iterator AgentTaskScheduler::next_waiter(
+        int64_t now_ms) {
+    int64_t aging_ms = config::agent_task_priority_aging_seconds * 1000L;
+    auto best = _waiters.end();
+    int64_t best_priority = 0;
+    for (auto it = _waiters.begin(); it != _waiters.end(); ++it) {
+        if (!has_room(*it)) {
+            continue;
+        }
+        int64_t priority = it->priority;
+        if (aging_ms > 0) {
+            priority += (now_ms - it->wait_start_ms) / aging_ms;
+        }
+        if (best == _waiters.end() || priority > best_priority
+                || (priority == best_priority && it->wait_start_ms < best->wait_start_ms)) {
+            best = it;
+            best_priority = priority;
+        }
+    }
+    return best;
+}
+
+void AgentTaskScheduler::acquire(const TAgentTaskRequest& task, const std::string& disk) {
+    std::unique_lock<std::mutex> l(_lock);
+    int64_t now_ms = monotonic_millis();
+    auto queued = _queued_time_ms.find(std::make_pair(task.task_type, task.signature));
+    Waiter waiter;
+    waiter.priority = priority_of(task);
+    waiter.wait_start_ms = queued != _queued_time_ms.end() ? queued->second : now_ms;
+    waiter.disk = &disk;
+    auto it = _waiters.insert(_waiters.end(), waiter);
+    while (next_waiter(now_ms) != it) {
+        _cond.wait_for(l, std::chrono::milliseconds(AGING_CHECK_INTERVAL_MS));
+        now_ms = monotonic_millis();
+    }
+    _waiters.erase(it);
+    ++_num_running;
+    if (!disk.empty()) {
+        ++_disk_running[disk];
+    }
+    dequeue_locked(task, now_ms);
+    // the next waiter may fit as well
+    _cond.notify_all();
+}
+
+void AgentTaskScheduler::release(const std::string& disk) {
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        DCHECK_GT(_num_running, 0);
+        --_num_running;
+        if (!disk.empty()) {
+            auto it = _disk_running.find(disk);
+            DCHECK(it != _disk_running.end());
+            if (--it->second == 0) {
+                _disk_running.erase(it);
+            }
+        }
+    }
+    _cond.notify_all();
+}
+
+void AgentTaskScheduler::debug(std::stringstream* ss) {
+    std::lock_guard<std::mutex> l(_lock);
+    *ss << "running=" << _num_running << " waiting=" << _waiters.size() << "\n";
+    *ss << "type\tqueued\tstarted\tavg_wait_ms\n";
+    for (auto& it : _type_stats) {
+        const TypeStats& stats = it.second;
+        *ss << _TTaskType_VALUES_TO_NAMES.at(it.first)
+            << "\t" << stats.num_queued
+            << "\t" << stats.num_started
+            << "\t" << (stats.num_started > 0 ? stats.total_wait_ms / stats.num_started : 0)
+            << "\n";
+    }
+}
+
+}  // namespace palo
@@ -0,0 +1,143 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_AGENT_TASK_SCHEDULER_H
+#define BDG_PALO_BE_SRC_AGENT_TASK_SCHEDULER_H
+
+#include <stdint.h>
+
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include "gen_cpp/AgentService_types.h"
+#include "util/metrics.h"
+
+namespace palo {
+
+// Arbitrates between the worker threads of the agent task pools, so that the heavy
+// tasks of all types share one budget of running tasks, which goes to the most
+// important waiting task first.
+//
+// A worker takes a slot before it runs its task and gives it back when the task is
+// done. At most 'max_running' tasks run at the same time, and at most
+// 'max_running_per_disk' of them on the same root path, 0 disables either limit. A
+// freed slot goes to the waiting task of the highest priority whose disk has room, to
+// the one that waited longest among equals. A task gains a priority level for every
+// config::agent_task_priority_aging_seconds it waited, so the low priority tasks don't
+// starve. The worker threads of a type cap how many of its tasks run at once.
+//
+// The scheduler also counts the queued tasks and their wait per task type, from their
+// submission until they run.
+//
+// This class is thread-safe.
+class AgentTaskScheduler {
+public:
+    enum Priority {
+        LOW = 0,
+        NORMAL = 1,
+        HIGH = 2
+    };
+
+    AgentTaskScheduler(int max_running, int max_running_per_disk);
+
+    // High priority tasks are urgent, alters, storage medium migrations and consistency
+    // checks can wait, everything else is normal.
+    static Priority priority_of(const TAgentTaskRequest& task);
+
+    // Registers the queue depth and wait metrics of every task type with 'metrics'.
+    void init_metrics(MetricGroup* metrics);
+
+    // Called when 'task' is queued in its pool.
+    void task_queued(const TAgentTaskRequest& task);
+
+    // Called when 'task' is taken out of its pool's queue, with or without a slot.
+    void task_dequeued(const TAgentTaskRequest& task);
+
+    // Blocks until 'task' may run on 'disk', the root path of its tablet or empty if
+    // that's not known, and dequeues it.
+    void acquire(const TAgentTaskRequest& task, const std::string& disk);
+
+    void release(const std::string& disk);
+
+    void debug(std::stringstream* ss);
+
+    // Holds a slot for the lifetime of the object.
+    class Slot {
+    public:
+        Slot(AgentTaskScheduler* scheduler, const TAgentTaskRequest& task,
+             const std::string& disk) : _scheduler(scheduler), _disk(disk) {
+            _scheduler->acquire(task, disk);
+        }
+
+        ~Slot() {
+            _scheduler->release(_disk);
+        }
+
+    private:
+        AgentTaskScheduler* _scheduler;
+        std::string _disk;
+    };
+
+private:
+    struct Waiter {
+        int priority;
+        int64_t wait_start_ms;
+        const std::string* disk;
+    };
+
+    struct TypeStats {
+        int64_t num_queued;
+        int64_t num_started;
+        int64_t total_wait_ms;
+        IntGauge* queued_metric;
+        IntCounter* started_metric;
+        IntCounter* wait_ms_metric;
+
+        TypeStats() : num_queued(0), num_started(0), total_wait_ms(0),
+                queued_metric(NULL), started_metric(NULL), wait_ms_metric(NULL) { }
+    };
+
+    // Returns true if the task of 'waiter' can run now.
+    bool has_room(const Waiter& waiter) const;
+
+    // Returns the waiter that gets the next slot, _waiters.end() if none fits.
+    std::list<Waiter>::iterator next_waiter(int64_t now_ms);
+
+    TypeStats* get_type_stats(TTaskType::type type);
+
+    // Counts 'task' as started, and no longer queued if it was. Needs _lock.
+    void dequeue_locked(const TAgentTaskRequest& task, int64_t now_ms);
+
+    const int _max_running;
+    const int _max_running_per_disk;
+
+    std::mutex _lock;
+    std::condition_variable _cond;
+    int _num_running;
+    std::map<std::string, int> _disk_running;
+    std::list<Waiter> _waiters;
+
+    MetricGroup* _metrics;
+    std::map<TTaskType::type, TypeStats> _type_stats;
+    // submission time of the queued tasks by type and signature
+    std::map<std::pair<TTaskType::type, int64_t>, int64_t> _queued_time_ms;
+};
+
+}  // namespace palo
+#endif  // BDG_PALO_BE_SRC_AGENT_TASK_SCHEDULER_H
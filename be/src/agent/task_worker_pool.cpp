@@ -16,19 +16,26 @@
 #include "agent/task_worker_pool.h"
 #include <pthread.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <atomic>
 #include <csignal>
 #include <ctime>
 #include <fstream>
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
 #include <sys/stat.h>
+#include "boost/bind.hpp"
 #include "boost/filesystem.hpp"
 #include "boost/lexical_cast.hpp"
+#include "boost/thread.hpp"
 #include "agent/pusher.h"
 #include "agent/status.h"
+#include "agent/tablet_report_tracker.h"
+#include "agent/task_scheduler.h"
 #include "agent/utils.h"
 #include "gen_cpp/FrontendService.h"
 #include "gen_cpp/Types_types.h"
@@ -36,9 +43,11 @@
 #include "olap/olap_engine.h"
 #include "olap/olap_table.h"
 #include "olap/utils.h"
+#include "runtime/snapshot_loader.h"
 #include "common/resource_tls.h"
 #include "agent/cgroups_mgr.h"
 #include "service/backend_options.h"
+#include "util/io_throttle.h"
 
 using std::deque;
 using std::list;
@@ -72,6 +81,9 @@ map<TTaskType::type, map<string, uint32_t>> TaskWorkerPool::_s_total_task_user_c
 map<TTaskType::type, uint32_t> TaskWorkerPool::_s_total_task_count;
 FrontendServiceClientCache TaskWorkerPool::_master_service_client_cache;
 boost::mutex TaskWorkerPool::_disk_broken_lock;
+MutexLock TaskWorkerPool::_s_clone_download_lock;
+uint32_t TaskWorkerPool::_s_clone_downloading_count = 0;
+map<string, uint32_t> TaskWorkerPool::_s_clone_disk_downloading_count;
 boost::posix_time::time_duration TaskWorkerPool::_wait_duration;
 
 TaskWorkerPool::TaskWorkerPool(
@@ -196,14 +208,92 @@ void TaskWorkerPool::submit_task(const TAgentTaskRequest& task) {
 
     bool ret = _record_task_info(task_type, signature, user);
     if (ret == true) {
+        if (_is_scheduled()) {
+            scheduler()->task_queued(task);
+        }
         {
             lock_guard<MutexLock> worker_thread_lock(_worker_thread_lock);
-            _tasks.push_back(task);
+            // Urgent tasks go ahead of the others, the push workers pick them on their own
+            auto pos = _tasks.end();
+            if (_task_worker_type != PUSH && _task_worker_type != DELETE
+                    && AgentTaskScheduler::priority_of(task) == AgentTaskScheduler::HIGH) {
+                pos = std::find_if(_tasks.begin(), _tasks.end(),
+                        [](const TAgentTaskRequest& queued) {
+                            return AgentTaskScheduler::priority_of(queued)
+                                != AgentTaskScheduler::HIGH;
+                        });
+            }
+            _tasks.insert(pos, task);
             _worker_thread_condition_lock.notify();
         }
     }
 }
 
+AgentTaskScheduler* TaskWorkerPool::scheduler() {
+    static AgentTaskScheduler s_scheduler(
+            config::agent_task_max_running, config::agent_task_max_running_per_disk);
+    return &s_scheduler;
+}
+
+bool TaskWorkerPool::_is_scheduled() const {
+    switch (_task_worker_type) {
+    case PUSH:
+    case DELETE:
+    case ALTER_TABLE:
+    case CLONE:
+    case STORAGE_MEDIUM_MIGRATE:
+    case CHECK_CONSISTENCY:
+    case UPLOAD:
+    case RESTORE:
+    case MAKE_SNAPSHOT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+string TaskWorkerPool::_get_task_disk(const TAgentTaskRequest& task) {
+#ifndef BE_TEST
+    TTabletId tablet_id = 0;
+    TSchemaHash schema_hash = 0;
+    switch (task.task_type) {
+    case TTaskType::PUSH:
+        tablet_id = task.push_req.tablet_id;
+        schema_hash = task.push_req.schema_hash;
+        break;
+    case TTaskType::ROLLUP:
+    case TTaskType::SCHEMA_CHANGE:
+        tablet_id = task.alter_tablet_req.base_tablet_id;
+        schema_hash = task.alter_tablet_req.base_schema_hash;
+        break;
+    case TTaskType::CLONE:
+        tablet_id = task.clone_req.tablet_id;
+        schema_hash = task.clone_req.schema_hash;
+        break;
+    case TTaskType::STORAGE_MEDIUM_MIGRATE:
+        tablet_id = task.storage_medium_migrate_req.tablet_id;
+        schema_hash = task.storage_medium_migrate_req.schema_hash;
+        break;
+    case TTaskType::CHECK_CONSISTENCY:
+        tablet_id = task.check_consistency_req.tablet_id;
+        schema_hash = task.check_consistency_req.schema_hash;
+        break;
+    case TTaskType::MAKE_SNAPSHOT:
+        tablet_id = task.snapshot_req.tablet_id;
+        schema_hash = task.snapshot_req.schema_hash;
+        break;
+    default:
+        return "";
+    }
+    // a tablet that is cloned for the first time has no root path yet
+    SmartOLAPTable tablet = OLAPEngine::get_instance()->get_table(tablet_id, schema_hash);
+    if (tablet.get() != NULL) {
+        return tablet->storage_root_path_name();
+    }
+#endif
+    return "";
+}
+
 bool TaskWorkerPool::_record_task_info(
         const TTaskType::type task_type,
         int64_t signature,
@@ -489,6 +579,8 @@ void* TaskWorkerPool::_alter_table_worker_thread_callback(void* arg_this) {
             alter_tablet_request = agent_task_req.alter_tablet_req;
             worker_pool_this->_tasks.pop_front();
         }
+        AgentTaskScheduler::Slot slot(
+                scheduler(), agent_task_req, _get_task_disk(agent_task_req));
         // Try to register to cgroups_mgr
         CgroupsMgr::apply_system_cgroup();
         int64_t signatrue = agent_task_req.signature;
@@ -654,6 +746,7 @@ void* TaskWorkerPool::_push_worker_thread_callback(void* arg_this) {
     // Try to register to cgroups_mgr
     CgroupsMgr::apply_system_cgroup();
     TaskWorkerPool* worker_pool_this = (TaskWorkerPool*)arg_this;
+    ScopedIoClass io_class(IO_CLASS_LOAD);
 
     // gen high priority worker thread
     TPriority::type priority = TPriority::NORMAL;
@@ -707,10 +800,26 @@ void* TaskWorkerPool::_push_worker_thread_callback(void* arg_this) {
             continue;
         }
 #endif
+        AgentTaskScheduler::Slot slot(
+                scheduler(), agent_task_req, _get_task_disk(agent_task_req));
 
         OLAP_LOG_INFO("get push task. signature: %ld, user: %s, priority: %d",
                       agent_task_req.signature, user.c_str(), priority);
 
+        // Push the next versions of the tablet that are queued as well together
+        if (push_req.push_type == TPushType::LOAD && config::push_batch_max_tasks > 1) {
+            vector<TAgentTaskRequest> batch(1, agent_task_req);
+            worker_pool_this->_take_push_batch(&batch);
+            if (batch.size() > 1) {
+                worker_pool_this->_push_batch(batch);
+#ifndef BE_TEST
+                continue;
+#else
+                return (void*)0;
+#endif
+            }
+        }
+
         vector<TTabletInfo> tablet_infos;
         if (push_req.push_type == TPushType::LOAD || push_req.push_type == TPushType::LOAD_DELETE) {
 #ifndef BE_TEST
@@ -750,54 +859,154 @@ void* TaskWorkerPool::_push_worker_thread_callback(void* arg_this) {
             status = PALO_TASK_REQUEST_ERROR;
         }
 
-        // Return result to fe
-        vector<string> error_msgs;
-        TStatus task_status;
+        worker_pool_this->_finish_push_task(agent_task_req, status, tablet_infos);
+#ifndef BE_TEST
+    }
+#endif
 
-        TFinishTaskRequest finish_task_request;
-        finish_task_request.__set_backend(worker_pool_this->_backend);
-        finish_task_request.__set_task_type(agent_task_req.task_type);
-        finish_task_request.__set_signature(agent_task_req.signature);
-        if (push_req.push_type == TPushType::DELETE) {
-            finish_task_request.__set_request_version(push_req.version);
-            finish_task_request.__set_request_version_hash(push_req.version_hash);
-        }
+    return (void*)0;
+}
 
-        if (status == PALO_SUCCESS) {
-            OLAP_LOG_DEBUG("push ok.signature: %ld", agent_task_req.signature);
-            error_msgs.push_back("push success");
+void TaskWorkerPool::_take_push_batch(vector<TAgentTaskRequest>* batch) {
+    TTabletId tablet_id = batch->front().push_req.tablet_id;
+    TSchemaHash schema_hash = batch->front().push_req.schema_hash;
+    size_t max_tasks = config::push_batch_max_tasks;
+    for (int round = 0; round < 2 && batch->size() < max_tasks; ++round) {
+        if (round == 1) {
+            // give the next loads of the tablet a short window to arrive
+            if (config::push_batch_window_ms <= 0) {
+                break;
+            }
+            usleep(config::push_batch_window_ms * 1000);
+        }
+        lock_guard<MutexLock> worker_thread_lock(_worker_thread_lock);
+        bool found = true;
+        while (found && batch->size() < max_tasks) {
+            found = false;
+            int64_t next_version = batch->back().push_req.version + 1;
+            for (auto it = _tasks.begin(); it != _tasks.end(); ++it) {
+                const TPushReq& push_req = it->push_req;
+                if (push_req.push_type == TPushType::LOAD
+                        && push_req.tablet_id == tablet_id
+                        && push_req.schema_hash == schema_hash
+                        && push_req.version == next_version) {
+                    batch->push_back(*it);
+                    scheduler()->task_dequeued(*it);
+                    _tasks.erase(it);
+                    found = true;
+                    break;
+                }
+            }
+        }
+    }
+}
 
-            ++_s_report_version;
+void TaskWorkerPool::_push_batch(const vector<TAgentTaskRequest>& batch) {
+    OLAP_LOG_INFO("push tasks in batch. tablet: %ld, version: %ld-%ld, tasks: %lu",
+                  batch.front().push_req.tablet_id, batch.front().push_req.version,
+                  batch.back().push_req.version, batch.size());
+    size_t num_tasks = batch.size();
+    vector<std::unique_ptr<Pusher>> pushers;
+    vector<AgentStatus> statuses(num_tasks, PALO_SUCCESS);
+    vector<vector<TTabletInfo>> tablet_infos(num_tasks);
+    bool all_fetched = true;
+    for (size_t i = 0; i < num_tasks; ++i) {
+        pushers.emplace_back(new Pusher(batch[i].push_req));
+        statuses[i] = pushers[i]->init();
+        if (statuses[i] == PALO_SUCCESS) {
+            statuses[i] = pushers[i]->fetch_file();
+        }
+        all_fetched = all_fetched && statuses[i] == PALO_SUCCESS;
+    }
 
-            task_status.__set_status_code(TStatusCode::OK);
-            finish_task_request.__set_finish_tablet_infos(tablet_infos);
-        } else if (status == PALO_TASK_REQUEST_ERROR) {
-            OLAP_LOG_WARNING("push request push_type invalid. type: %d, signature: %ld",
-                             push_req.push_type, agent_task_req.signature);
-            error_msgs.push_back("push request push_type invalid.");
-            task_status.__set_status_code(TStatusCode::ANALYSIS_ERROR);
+    bool pushed = false;
+    if (all_fetched) {
+        vector<TPushReq> requests;
+        for (auto& pusher : pushers) {
+            requests.push_back(pusher->request());
+        }
+        OLAPStatus res = _command_executor->push_batch(requests, &tablet_infos);
+        if (res == OLAPStatus::OLAP_SUCCESS) {
+            pushed = true;
+            for (auto& pusher : pushers) {
+                pusher->remove_file();
+            }
         } else {
-            OLAP_LOG_WARNING("push failed, error_code: %d, signature: %ld",
-                             status, agent_task_req.signature);
-            error_msgs.push_back("push failed");
-            task_status.__set_status_code(TStatusCode::RUNTIME_ERROR);
+            OLAP_LOG_INFO("push batch failed, push the tasks one by one. res: %d", res);
         }
-        task_status.__set_error_msgs(error_msgs);
-        finish_task_request.__set_task_status(task_status);
-        finish_task_request.__set_report_version(_s_report_version);
+    }
 
-        worker_pool_this->_finish_task(finish_task_request);
-        worker_pool_this->_remove_task_info(
-                agent_task_req.task_type, agent_task_req.signature, user);
-#ifndef BE_TEST
+    // Each task is reported on its own
+    for (size_t i = 0; i < num_tasks; ++i) {
+        if (!pushed && statuses[i] == PALO_SUCCESS) {
+            tablet_infos[i].clear();
+            for (uint32_t retry_time = 0; retry_time < PUSH_MAX_RETRY; ++retry_time) {
+                statuses[i] = pushers[i]->process(&tablet_infos[i]);
+                // Internal error, need retry
+                if (statuses[i] != PALO_ERROR) {
+                    break;
+                }
+                OLAP_LOG_WARNING("push internal error, need retry.signature: %ld",
+                                 batch[i].signature);
+            }
+        }
+        _finish_push_task(batch[i], statuses[i], tablet_infos[i]);
     }
-#endif
+}
 
-    return (void*)0;
+void TaskWorkerPool::_finish_push_task(
+        const TAgentTaskRequest& agent_task_req,
+        AgentStatus status,
+        const vector<TTabletInfo>& tablet_infos) {
+    const TPushReq& push_req = agent_task_req.push_req;
+    string user;
+    if (agent_task_req.__isset.resource_info) {
+        user = agent_task_req.resource_info.user;
+    }
+
+    // Return result to fe
+    vector<string> error_msgs;
+    TStatus task_status;
+
+    TFinishTaskRequest finish_task_request;
+    finish_task_request.__set_backend(_backend);
+    finish_task_request.__set_task_type(agent_task_req.task_type);
+    finish_task_request.__set_signature(agent_task_req.signature);
+    if (push_req.push_type == TPushType::DELETE) {
+        finish_task_request.__set_request_version(push_req.version);
+        finish_task_request.__set_request_version_hash(push_req.version_hash);
+    }
+
+    if (status == PALO_SUCCESS) {
+        OLAP_LOG_DEBUG("push ok.signature: %ld", agent_task_req.signature);
+        error_msgs.push_back("push success");
+
+        ++_s_report_version;
+
+        task_status.__set_status_code(TStatusCode::OK);
+        finish_task_request.__set_finish_tablet_infos(tablet_infos);
+    } else if (status == PALO_TASK_REQUEST_ERROR) {
+        OLAP_LOG_WARNING("push request push_type invalid. type: %d, signature: %ld",
+                         push_req.push_type, agent_task_req.signature);
+        error_msgs.push_back("push request push_type invalid.");
+        task_status.__set_status_code(TStatusCode::ANALYSIS_ERROR);
+    } else {
+        OLAP_LOG_WARNING("push failed, error_code: %d, signature: %ld",
+                         status, agent_task_req.signature);
+        error_msgs.push_back("push failed");
+        task_status.__set_status_code(TStatusCode::RUNTIME_ERROR);
+    }
+    task_status.__set_error_msgs(error_msgs);
+    finish_task_request.__set_task_status(task_status);
+    finish_task_request.__set_report_version(_s_report_version);
+
+    _finish_task(finish_task_request);
+    _remove_task_info(agent_task_req.task_type, agent_task_req.signature, user);
 }
 
 void* TaskWorkerPool::_clone_worker_thread_callback(void* arg_this) {
     TaskWorkerPool* worker_pool_this = (TaskWorkerPool*)arg_this;
+    ScopedIoClass io_class(IO_CLASS_CLONE);
 
 #ifndef BE_TEST
     while (true) {
@@ -816,6 +1025,8 @@ void* TaskWorkerPool::_clone_worker_thread_callback(void* arg_this) {
             clone_req = agent_task_req.clone_req;
             worker_pool_this->_tasks.pop_front();
         }
+        AgentTaskScheduler::Slot slot(
+                scheduler(), agent_task_req, _get_task_disk(agent_task_req));
         // Try to register to cgroups_mgr
         CgroupsMgr::apply_system_cgroup();
         OLAP_LOG_INFO("get clone task. signature: %ld", agent_task_req.signature);
@@ -825,18 +1036,49 @@ void* TaskWorkerPool::_clone_worker_thread_callback(void* arg_this) {
         SmartOLAPTable tablet =
                 worker_pool_this->_command_executor->get_table(
                 clone_req.tablet_id, clone_req.schema_hash);
+        vector<Version> missing_versions;
         if (tablet.get() != NULL) {
-            OLAP_LOG_INFO("clone tablet exist yet. tablet_id: %ld, schema_hash: %ld, "
-                          "signature: %ld",
-                          clone_req.tablet_id, clone_req.schema_hash,
-                          agent_task_req.signature);
-            error_msgs.push_back("clone tablet exist yet.");
-            status = PALO_CREATE_TABLE_EXIST;
+            // The tablet only lacks of some latest deltas, copy them incrementally
+            if (clone_req.__isset.committed_version && clone_req.__isset.committed_version_hash) {
+                worker_pool_this->_get_missing_versions(
+                        tablet, clone_req.committed_version, &missing_versions);
+            }
+
+            if (missing_versions.empty()) {
+                OLAP_LOG_INFO("clone tablet exist yet. tablet_id: %ld, schema_hash: %ld, "
+                              "signature: %ld",
+                              clone_req.tablet_id, clone_req.schema_hash,
+                              agent_task_req.signature);
+                error_msgs.push_back("clone tablet exist yet.");
+                status = PALO_CREATE_TABLE_EXIST;
+            } else {
+                OLAP_LOG_INFO("clone tablet incrementally. tablet_id: %ld, schema_hash: %ld, "
+                              "missing versions: %d-%d, signature: %ld",
+                              clone_req.tablet_id, clone_req.schema_hash,
+                              missing_versions.front().first, missing_versions.back().second,
+                              agent_task_req.signature);
+            }
         }
+        bool is_incremental_clone = !missing_versions.empty();
 
         // Get local disk from olap
         string local_shard_root_path;
-        if (status == PALO_SUCCESS) {
+        if (is_incremental_clone) {
+            // Download into a temp dir on the disk of tablet, so that files
+            // could be hard linked into the tablet path
+            string time_str;
+            if (gen_timestamp_string(&time_str) != OLAP_SUCCESS) {
+                OLAP_LOG_WARNING("clone gen timestamp string failed. signature: %ld",
+                                 agent_task_req.signature);
+                error_msgs.push_back("clone gen timestamp string failed.");
+                status = PALO_ERROR;
+            } else {
+                stringstream clone_dir_stream;
+                clone_dir_stream << tablet->storage_root_path_name() << CLONE_PREFIX
+                                 << "/" << time_str << "." << agent_task_req.signature;
+                local_shard_root_path = clone_dir_stream.str();
+            }
+        } else if (status == PALO_SUCCESS) {
             OLAPStatus olap_status = worker_pool_this->_command_executor->obtain_shard_path(
                     clone_req.storage_medium, &local_shard_root_path);
             if (olap_status != OLAP_SUCCESS) {
@@ -854,12 +1096,47 @@ void* TaskWorkerPool::_clone_worker_thread_callback(void* arg_this) {
                     clone_req,
                     agent_task_req.signature,
                     local_shard_root_path,
+                    is_incremental_clone ? &missing_versions : NULL,
                     &src_host,
                     &src_file_path,
                     &error_msgs);
         }
 
-        if (status == PALO_SUCCESS) {
+        if (is_incremental_clone) {
+            if (status == PALO_SUCCESS) {
+                stringstream clone_data_path_stream;
+                clone_data_path_stream << local_shard_root_path
+                                       << "/" << clone_req.tablet_id
+                                       << "/" << clone_req.schema_hash;
+                OLAPStatus clone_status =
+                        worker_pool_this->_command_executor->clone_incremental_data(
+                                clone_data_path_stream.str(),
+                                clone_req.tablet_id,
+                                clone_req.schema_hash,
+                                missing_versions);
+                if (clone_status != OLAP_SUCCESS) {
+                    OLAP_LOG_WARNING("clone incremental data failed. status: %d, "
+                                     "signature: %ld",
+                                     clone_status, agent_task_req.signature);
+                    error_msgs.push_back("clone incremental data failed.");
+                    status = PALO_ERROR;
+                }
+            }
+
+            // The downloaded files have been linked into tablet, or are useless
+            try {
+                boost::filesystem::path clone_dir(local_shard_root_path);
+                if (!local_shard_root_path.empty() && boost::filesystem::exists(clone_dir)) {
+                    boost::filesystem::remove_all(clone_dir);
+                }
+            } catch (boost::filesystem::filesystem_error e) {
+                // Ignore the error, OLAP will sweep it
+                OLAP_LOG_WARNING("clone delete temp dir failed. "
+                                 "error: %s, clone dir: %s, signature: %ld",
+                                 e.what(), local_shard_root_path.c_str(),
+                                 agent_task_req.signature);
+            }
+        } else if (status == PALO_SUCCESS) {
             OLAP_LOG_INFO("clone copy done, src_host: %s, src_file_path: %s",
                           src_host.host.c_str(), src_file_path.c_str());
             // Load header
@@ -880,7 +1157,7 @@ void* TaskWorkerPool::_clone_worker_thread_callback(void* arg_this) {
 
 #ifndef BE_TEST
         // Clean useless dir, if failed, ignore it.
-        if (status != PALO_SUCCESS && status != PALO_CREATE_TABLE_EXIST) {
+        if (!is_incremental_clone && status != PALO_SUCCESS && status != PALO_CREATE_TABLE_EXIST) {
             stringstream local_data_path_stream;
             local_data_path_stream << local_shard_root_path
                                    << "/" << clone_req.tablet_id
@@ -991,10 +1268,30 @@ void* TaskWorkerPool::_clone_worker_thread_callback(void* arg_this) {
     return (void*)0;
 }
 
+void TaskWorkerPool::_get_missing_versions(
+        SmartOLAPTable tablet,
+        int64_t committed_version,
+        vector<Version>* missing_versions) {
+    tablet->obtain_header_rdlock();
+    const FileVersionMessage* latest_version = tablet->latest_version();
+    int64_t latest_end_version = latest_version == NULL ? -1 : latest_version->end_version();
+    tablet->release_header_lock();
+
+    // A tablet without any version is useless, it need a full clone
+    if (latest_version == NULL) {
+        return;
+    }
+
+    for (int64_t version = latest_end_version + 1; version <= committed_version; ++version) {
+        missing_versions->push_back(Version(version, version));
+    }
+}
+
 AgentStatus TaskWorkerPool::_clone_copy(
         const TCloneReq& clone_req,
         int64_t signature,
         const string& local_data_path,
+        const vector<Version>* missing_versions,
         TBackend* src_host,
         string* src_file_path,
         vector<string>* error_msgs) {
@@ -1019,6 +1316,15 @@ AgentStatus TaskWorkerPool::_clone_copy(
         TSnapshotRequest snapshot_request;
         snapshot_request.__set_tablet_id(clone_req.tablet_id);
         snapshot_request.__set_schema_hash(clone_req.schema_hash);
+        if (missing_versions != NULL) {
+            vector<TVersion> snapshot_versions;
+            for (const Version& version : *missing_versions) {
+                snapshot_versions.push_back(version.first);
+            }
+            snapshot_request.__set_version(clone_req.committed_version);
+            snapshot_request.__set_version_hash(clone_req.committed_version_hash);
+            snapshot_request.__set_missing_version(snapshot_versions);
+        }
 #ifndef BE_TEST
         agent_client.make_snapshot(
                 snapshot_request,
@@ -1167,149 +1473,303 @@ AgentStatus TaskWorkerPool::_clone_copy(
         }
 
         // Get copy from remote
-        for (auto file_name : file_name_list) {
-            download_retry_time = 0;
-            downloader_param.remote_file_path = http_host + HTTP_REQUEST_PREFIX
+        if (status == PALO_SUCCESS) {
+            string remote_url_prefix = http_host + HTTP_REQUEST_PREFIX
                 + HTTP_REQUEST_TOKEN_PARAM + token
-                + HTTP_REQUEST_FILE_PARAM + src_file_full_path + file_name;
-            downloader_param.local_file_path = local_file_full_path + file_name;
+                + HTTP_REQUEST_FILE_PARAM + src_file_full_path;
+            status = _download_clone_files(
+                    src_host->host, remote_url_prefix, local_file_full_path,
+                    file_name_list, signature);
+        }
 
-            // Get file length
-            uint64_t file_size = 0;
-            uint64_t estimate_time_out = 0;
+        // Release snapshot, if failed, ignore it. OLAP engine will drop useless snapshot
+        TAgentResult release_snapshot_result;
+#ifndef BE_TEST
+        agent_client.release_snapshot(
+                make_snapshot_result.snapshot_path,
+                &release_snapshot_result);
+#else
+        _agent_client->release_snapshot(
+                make_snapshot_result.snapshot_path,
+                &release_snapshot_result);
+#endif
+        if (release_snapshot_result.status.status_code != TStatusCode::OK) {
+            OLAP_LOG_WARNING("release snapshot failed. src_file_path: %s, signature: %ld",
+                             src_file_path->c_str(), signature);
+        }
+
+        if (status == PALO_SUCCESS) {
+            break;
+        }
+    } // clone copy from one backend
+    return status;
+}
+
+AgentStatus TaskWorkerPool::_download_clone_files(
+        const string& src_host,
+        const string& remote_url_prefix,
+        const string& local_file_full_path,
+        const vector<string>& file_name_list,
+        int64_t signature) {
+    // The header file is at the end of file_name_list, it must be downloaded
+    // after all data files, so that an interrupted clone can't be loaded.
+    vector<string> data_file_names;
+    vector<string> header_file_names;
+    for (const string& file_name : file_name_list) {
+        if (file_name.size() > 4 && file_name.substr(file_name.size() - 4, 4) == ".hdr") {
+            header_file_names.push_back(file_name);
+        } else {
+            data_file_names.push_back(file_name);
+        }
+    }
+
+    string disk = _get_clone_download_disk(local_file_full_path);
+    std::atomic<size_t> next_file_index(0);
+    std::atomic<bool> download_failed(false);
+    size_t thread_num = config::clone_download_thread_num > 0
+            ? config::clone_download_thread_num : 1;
+#ifdef BE_TEST
+    // mocked file downloader is shared, download one by one
+    thread_num = 1;
+#endif
+    thread_num = std::min(thread_num, data_file_names.size());
+    if (thread_num <= 1) {
+        _download_clone_file_worker(
+                src_host, remote_url_prefix, local_file_full_path, disk,
+                &data_file_names, &next_file_index, &download_failed, signature);
+    } else {
+        boost::thread_group download_threads;
+        for (size_t i = 0; i < thread_num; ++i) {
+            download_threads.create_thread(boost::bind(
+                    &TaskWorkerPool::_download_clone_file_worker, this,
+                    boost::cref(src_host), boost::cref(remote_url_prefix),
+                    boost::cref(local_file_full_path), boost::cref(disk),
+                    &data_file_names, &next_file_index, &download_failed, signature));
+        }
+        download_threads.join_all();
+    }
+
+    if (download_failed) {
+        return PALO_ERROR;
+    }
+
+    for (const string& file_name : header_file_names) {
+        AgentStatus status = _download_clone_file(
+                src_host, remote_url_prefix + file_name,
+                local_file_full_path + file_name, disk, signature);
+        if (status != PALO_SUCCESS) {
+            return status;
+        }
+    }
+    return PALO_SUCCESS;
+}
+
+void TaskWorkerPool::_download_clone_file_worker(
+        const string& src_host,
+        const string& remote_url_prefix,
+        const string& local_file_full_path,
+        const string& disk,
+        const vector<string>* file_names,
+        std::atomic<size_t>* next_file_index,
+        std::atomic<bool>* download_failed,
+        int64_t signature) {
+    ScopedIoClass io_class(IO_CLASS_CLONE);
+    while (!*download_failed) {
+        size_t index = next_file_index->fetch_add(1);
+        if (index >= file_names->size()) {
+            break;
+        }
+
+        const string& file_name = (*file_names)[index];
+        AgentStatus status = _download_clone_file(
+                src_host, remote_url_prefix + file_name,
+                local_file_full_path + file_name, disk, signature);
+        if (status != PALO_SUCCESS) {
+            *download_failed = true;
+        }
+    }
+}
 
-            downloader_param.curl_opt_timeout = GET_LENGTH_TIMEOUT;
+AgentStatus TaskWorkerPool::_download_clone_file(
+        const string& src_host,
+        const string& remote_file_url,
+        const string& local_file_path,
+        const string& disk,
+        int64_t signature) {
+    AgentStatus download_status = PALO_SUCCESS;
+    uint32_t download_retry_time = 0;
+    FileDownloader::FileDownloaderParam downloader_param;
+    downloader_param.remote_file_path = remote_file_url;
+    downloader_param.local_file_path = local_file_path;
+
+    // Get file length
+    uint64_t file_size = 0;
+    uint64_t estimate_time_out = 0;
+
+    downloader_param.curl_opt_timeout = GET_LENGTH_TIMEOUT;
 #ifndef BE_TEST
-            file_downloader_ptr = new FileDownloader(downloader_param);
-            if (file_downloader_ptr == NULL) {
-                OLAP_LOG_WARNING("clone copy create file downloader failed. try next backend");
-                status = PALO_ERROR;
-                break;
-            }
+    FileDownloader* file_downloader_ptr = new FileDownloader(downloader_param);
+    if (file_downloader_ptr == NULL) {
+        OLAP_LOG_WARNING("clone copy create file downloader failed. try next backend");
+        return PALO_ERROR;
+    }
 #endif
-            while (download_retry_time < DOWNLOAD_FILE_MAX_RETRY) {
+    while (download_retry_time < DOWNLOAD_FILE_MAX_RETRY) {
 #ifndef BE_TEST
-                download_status = file_downloader_ptr->get_length(&file_size);
+        download_status = file_downloader_ptr->get_length(&file_size);
 #else
-                download_status = _file_downloader_ptr->get_length(&file_size);
+        download_status = _file_downloader_ptr->get_length(&file_size);
 #endif
-                if (download_status != PALO_SUCCESS) {
-                    OLAP_LOG_WARNING("clone copy get file length failed. backend_ip: %s, "
-                                     "src_file_path: %s, signature: %ld",
-                                     src_host->host.c_str(),
-                                     downloader_param.remote_file_path.c_str(),
-                                     signature);
-                    ++download_retry_time;
-                    sleep(download_retry_time);
-                } else {
-                    break;
-                }
-            }
+        if (download_status != PALO_SUCCESS) {
+            OLAP_LOG_WARNING("clone copy get file length failed. backend_ip: %s, "
+                             "src_file_path: %s, signature: %ld",
+                             src_host.c_str(),
+                             downloader_param.remote_file_path.c_str(),
+                             signature);
+            ++download_retry_time;
+            sleep(download_retry_time);
+        } else {
+            break;
+        }
+    }
 
 #ifndef BE_TEST
-            if (file_downloader_ptr != NULL) {
-                delete file_downloader_ptr;
-                file_downloader_ptr = NULL;
-            }
+    if (file_downloader_ptr != NULL) {
+        delete file_downloader_ptr;
+        file_downloader_ptr = NULL;
+    }
 #endif
-            if (download_status != PALO_SUCCESS) {
-                OLAP_LOG_WARNING("clone copy get file length failed over max time. "
-                                 "backend_ip: %s, src_file_path: %s, signature: %ld",
-                                 src_host->host.c_str(),
-                                 downloader_param.remote_file_path.c_str(),
-                                 signature);
-                status = PALO_ERROR;
-                break;
-            }
+    if (download_status != PALO_SUCCESS) {
+        OLAP_LOG_WARNING("clone copy get file length failed over max time. "
+                         "backend_ip: %s, src_file_path: %s, signature: %ld",
+                         src_host.c_str(),
+                         downloader_param.remote_file_path.c_str(),
+                         signature);
+        return PALO_ERROR;
+    }
 
-            estimate_time_out = file_size / config::download_low_speed_limit_kbps / 1024;
-            if (estimate_time_out < config::download_low_speed_time) {
-                estimate_time_out = config::download_low_speed_time;
-            }
+    // Share the bandwidth caps with the other files being downloaded
+    downloader_param.max_download_speed_kbps = _acquire_clone_download_speed(disk);
+    estimate_time_out = file_size / config::download_low_speed_limit_kbps / 1024;
+    if (estimate_time_out < config::download_low_speed_time) {
+        estimate_time_out = config::download_low_speed_time;
+    }
 
-            // Download the file
-            download_retry_time = 0;
-            downloader_param.curl_opt_timeout = estimate_time_out;
+    // Download the file
+    download_retry_time = 0;
+    downloader_param.curl_opt_timeout = estimate_time_out;
 #ifndef BE_TEST
-            file_downloader_ptr = new FileDownloader(downloader_param);
-            if (file_downloader_ptr == NULL) {
-                OLAP_LOG_WARNING("clone copy create file downloader failed. try next backend");
-                status = PALO_ERROR;
-                break;
-            }
+    file_downloader_ptr = new FileDownloader(downloader_param);
+    if (file_downloader_ptr == NULL) {
+        OLAP_LOG_WARNING("clone copy create file downloader failed. try next backend");
+        _release_clone_download_speed(disk);
+        return PALO_ERROR;
+    }
 #endif
-            while (download_retry_time < DOWNLOAD_FILE_MAX_RETRY) {
+    while (download_retry_time < DOWNLOAD_FILE_MAX_RETRY) {
 #ifndef BE_TEST
-                download_status = file_downloader_ptr->download_file();
+        download_status = file_downloader_ptr->download_file();
 #else
-                download_status = _file_downloader_ptr->download_file();
+        download_status = _file_downloader_ptr->download_file();
 #endif
-                if (download_status != PALO_SUCCESS) {
-                    OLAP_LOG_WARNING("download file failed. backend_ip: %s, "
-                                     "src_file_path: %s, signature: %ld",
-                                     src_host->host.c_str(),
-                                     downloader_param.remote_file_path.c_str(),
-                                     signature);
-                } else {
-                    // Check file length
-                    boost::filesystem::path local_file_path(downloader_param.local_file_path);
-                    uint64_t local_file_size = boost::filesystem::file_size(local_file_path);
-                    if (local_file_size != file_size) {
-                        OLAP_LOG_WARNING("download file length error. backend_ip: %s, "
-                                         "src_file_path: %s, signature: %ld,"
-                                         "remote file size: %d, local file size: %d",
-                                         src_host->host.c_str(),
-                                         downloader_param.remote_file_path.c_str(),
-                                         signature, file_size, local_file_size);
-                        download_status = PALO_FILE_DOWNLOAD_FAILED;
-                    } else {
-                        chmod(downloader_param.local_file_path.c_str(), S_IRUSR | S_IWUSR);
-                        break;
-                    }
-                }
-                ++download_retry_time;
-                sleep(download_retry_time);
-            } // Try to download a file from remote backend
-
-#ifndef BE_TEST
-            if (file_downloader_ptr != NULL) {
-                delete file_downloader_ptr;
-                file_downloader_ptr = NULL;
+        if (download_status != PALO_SUCCESS) {
+            OLAP_LOG_WARNING("download file failed. backend_ip: %s, "
+                             "src_file_path: %s, signature: %ld",
+                             src_host.c_str(),
+                             downloader_param.remote_file_path.c_str(),
+                             signature);
+            // Resume from the received bytes next time. If a resumed download
+            // fails too, e.g. source doesn't support range, restart from zero.
+            boost::system::error_code ec;
+            uint64_t received_size = boost::filesystem::file_size(
+                    downloader_param.local_file_path, ec);
+            if (downloader_param.resume_offset == 0 && !ec
+                    && received_size > 0 && received_size < file_size) {
+                downloader_param.resume_offset = received_size;
+            } else {
+                downloader_param.resume_offset = 0;
             }
-#endif
-
-            if (download_status != PALO_SUCCESS) {
-                OLAP_LOG_WARNING("download file failed over max retry. backend_ip: %s, "
-                                 "src_file_path: %s, signature: %ld",
-                                 src_host->host.c_str(),
+        } else {
+            // Check file length
+            boost::filesystem::path local_file_path(downloader_param.local_file_path);
+            uint64_t local_file_size = boost::filesystem::file_size(local_file_path);
+            if (local_file_size != file_size) {
+                OLAP_LOG_WARNING("download file length error. backend_ip: %s, "
+                                 "src_file_path: %s, signature: %ld,"
+                                 "remote file size: %d, local file size: %d",
+                                 src_host.c_str(),
                                  downloader_param.remote_file_path.c_str(),
-                                 signature);
-                status = PALO_ERROR;
+                                 signature, file_size, local_file_size);
+                download_status = PALO_FILE_DOWNLOAD_FAILED;
+                downloader_param.resume_offset = 0;
+            } else {
+                chmod(downloader_param.local_file_path.c_str(), S_IRUSR | S_IWUSR);
                 break;
             }
-        } // Clone files from remote backend
+        }
+        ++download_retry_time;
+        sleep(download_retry_time);
+    } // Try to download a file from remote backend
+    _release_clone_download_speed(disk);
 
-        // Release snapshot, if failed, ignore it. OLAP engine will drop useless snapshot
-        TAgentResult release_snapshot_result;
 #ifndef BE_TEST
-        agent_client.release_snapshot(
-                make_snapshot_result.snapshot_path,
-                &release_snapshot_result);
-#else
-        _agent_client->release_snapshot(
-                make_snapshot_result.snapshot_path,
-                &release_snapshot_result);
+    if (file_downloader_ptr != NULL) {
+        delete file_downloader_ptr;
+        file_downloader_ptr = NULL;
+    }
 #endif
-        if (release_snapshot_result.status.status_code != TStatusCode::OK) {
-            OLAP_LOG_WARNING("release snapshot failed. src_file_path: %s, signature: %ld",
-                             src_file_path->c_str(), signature);
-        }
 
-        if (status == PALO_SUCCESS) {
-            break;
+    if (download_status != PALO_SUCCESS) {
+        OLAP_LOG_WARNING("download file failed over max retry. backend_ip: %s, "
+                         "src_file_path: %s, signature: %ld",
+                         src_host.c_str(),
+                         downloader_param.remote_file_path.c_str(),
+                         signature);
+        return PALO_ERROR;
+    }
+    return PALO_SUCCESS;
+}
+
+string TaskWorkerPool::_get_clone_download_disk(const string& local_path) {
+    OLAPRootPath::RootPathVec all_root_paths;
+    OLAPRootPath::get_instance()->get_all_available_root_path(&all_root_paths);
+
+    string disk;
+    for (const string& root_path : all_root_paths) {
+        if (local_path.compare(0, root_path.size(), root_path) == 0
+                && root_path.size() > disk.size()) {
+            disk = root_path;
         }
-    } // clone copy from one backend
-    return status;
+    }
+    return disk;
+}
+
+uint32_t TaskWorkerPool::_acquire_clone_download_speed(const string& disk) {
+    lock_guard<MutexLock> lock(_s_clone_download_lock);
+    uint32_t node_count = ++_s_clone_downloading_count;
+    uint32_t disk_count = ++_s_clone_disk_downloading_count[disk];
+
+    // The caps are shared by the files downloading at the same time. curl can't
+    // change the speed of a running transfer, so the share is taken at start.
+    uint32_t speed_kbps = config::max_download_speed_kbps;
+    if (config::clone_max_download_speed_kbps_per_node > 0) {
+        speed_kbps = std::min<uint32_t>(speed_kbps,
+                config::clone_max_download_speed_kbps_per_node / node_count);
+    }
+    if (config::clone_max_download_speed_kbps_per_disk > 0) {
+        speed_kbps = std::min<uint32_t>(speed_kbps,
+                config::clone_max_download_speed_kbps_per_disk / disk_count);
+    }
+    // Lower than low speed limit would make curl abort the transfer
+    return std::max<uint32_t>(speed_kbps, config::download_low_speed_limit_kbps);
+}
+
+void TaskWorkerPool::_release_clone_download_speed(const string& disk) {
+    lock_guard<MutexLock> lock(_s_clone_download_lock);
+    --_s_clone_downloading_count;
+    if (--_s_clone_disk_downloading_count[disk] == 0) {
+        _s_clone_disk_downloading_count.erase(disk);
+    }
 }
 
 void* TaskWorkerPool::_storage_medium_migrate_worker_thread_callback(void* arg_this) {
@@ -1332,6 +1792,8 @@ void* TaskWorkerPool::_storage_medium_migrate_worker_thread_callback(void* arg_t
             storage_medium_migrate_req = agent_task_req.storage_medium_migrate_req;
             worker_pool_this->_tasks.pop_front();
         }
+        AgentTaskScheduler::Slot slot(
+                scheduler(), agent_task_req, _get_task_disk(agent_task_req));
 
         TStatusCode::type status_code = TStatusCode::OK;
         vector<string> error_msgs;
@@ -1440,6 +1902,8 @@ void* TaskWorkerPool::_check_consistency_worker_thread_callback(void* arg_this)
             check_consistency_req = agent_task_req.check_consistency_req;
             worker_pool_this->_tasks.pop_front();
         }
+        AgentTaskScheduler::Slot slot(
+                scheduler(), agent_task_req, _get_task_disk(agent_task_req));
 
         TStatusCode::type status_code = TStatusCode::OK;
         vector<string> error_msgs;
@@ -1582,6 +2046,7 @@ void* TaskWorkerPool::_report_olap_table_worker_thread_callback(void* arg_this)
     request.__set_backend(worker_pool_this->_backend);
     request.__isset.tablets = true;
     AgentStatus status = PALO_SUCCESS;
+    TabletReportTracker tracker;
 
 #ifndef BE_TEST
     while (true) {
@@ -1595,6 +2060,9 @@ void* TaskWorkerPool::_report_olap_table_worker_thread_callback(void* arg_this)
         }
 
         request.tablets.clear();
+        request.__isset.incremental = false;
+        request.__isset.removed_tablets = false;
+        request.removed_tablets.clear();
 
         request.__set_report_version(_s_report_version);
         OLAPStatus report_all_tablets_info_status =
@@ -1616,12 +2084,21 @@ void* TaskWorkerPool::_report_olap_table_worker_thread_callback(void* arg_this)
 #endif
         }
 
+        bool incremental = tracker.prepare(worker_pool_this->_master_info.epoch, &request);
+
         TMasterResult result;
         status = worker_pool_this->_master_client->report(request, &result);
 
         if (status == PALO_SUCCESS) {
-            OLAP_LOG_INFO("finish report olap table success. return code: %d",
-                          result.status.status_code);
+            OLAP_LOG_INFO("finish report olap table success. return code: %d, incremental: %d, "
+                          "tablets: %lu, removed: %lu",
+                          result.status.status_code, incremental, request.tablets.size(),
+                          request.removed_tablets.size());
+            // a delta the master didn't apply is sent again as part of the next one
+            if (result.status.status_code == TStatusCode::OK) {
+                tracker.acknowledge(result.__isset.accepts_incremental_report
+                                    && result.accepts_incremental_report);
+            }
         } else {
             OLAP_LOG_WARNING("finish report olap table failed. status: %d", status);
         }
@@ -1658,6 +2135,8 @@ void* TaskWorkerPool::_upload_worker_thread_callback(void* arg_this) {
             upload_request = agent_task_req.upload_req;
             worker_pool_this->_tasks.pop_front();
         }
+        AgentTaskScheduler::Slot slot(
+                scheduler(), agent_task_req, _get_task_disk(agent_task_req));
         // Try to register to cgroups_mgr
         CgroupsMgr::apply_system_cgroup();
         OLAP_LOG_INFO("get upload task, signature: %ld", agent_task_req.signature);
@@ -1690,7 +2169,18 @@ void* TaskWorkerPool::_upload_worker_thread_callback(void* arg_this) {
         if (upload_request.__isset.tablet_id) {
             local_file_path_stream << "/" << upload_request.tablet_id;
         }
-        if (status_code == TStatusCode::OK) {
+        if (upload_request.__isset.broker_addrs && !upload_request.broker_addrs.empty()) {
+            SnapshotLoader loader(upload_request.broker_addrs,
+                                  upload_request.remote_source_properties);
+            Status status = loader.upload(local_file_path_stream.str(),
+                                          upload_request.remote_file_path);
+            if (!status.ok()) {
+                status_code = TStatusCode::RUNTIME_ERROR;
+                error_msgs.push_back(status.get_error_msg());
+                OLAP_LOG_WARNING("Upload file failed. Error: %s",
+                                 status.get_error_msg().c_str());
+            }
+        } else if (status_code == TStatusCode::OK) {
             string command = "sh " + config::trans_file_tool_path + " " + label + " upload " +
                          local_file_path_stream.str() + " " + upload_request.remote_file_path +
                          " " + info_file_path + " " + "file_list";
@@ -1745,6 +2235,8 @@ void* TaskWorkerPool::_restore_worker_thread_callback(void* arg_this) {
             restore_request = agent_task_req.restore_req;
             worker_pool_this->_tasks.pop_front();
         }
+        AgentTaskScheduler::Slot slot(
+                scheduler(), agent_task_req, _get_task_disk(agent_task_req));
         // Try to register to cgroups_mgr
         CgroupsMgr::apply_system_cgroup();
         OLAP_LOG_INFO("get restore task, signature: %ld", agent_task_req.signature);
@@ -1789,7 +2281,18 @@ void* TaskWorkerPool::_restore_worker_thread_callback(void* arg_this) {
         string local_file_path(local_file_path_stream.str());
 
         // Download files from remote source
-        if (status_code == TStatusCode::OK) {
+        if (status_code == TStatusCode::OK
+                && restore_request.__isset.broker_addrs && !restore_request.broker_addrs.empty()) {
+            SnapshotLoader loader(restore_request.broker_addrs,
+                                  restore_request.remote_source_properties);
+            Status status = loader.download(restore_request.remote_file_path, local_file_path);
+            if (!status.ok()) {
+                status_code = TStatusCode::RUNTIME_ERROR;
+                error_msgs.push_back(status.get_error_msg());
+                OLAP_LOG_WARNING("Download file failed. Error: %s",
+                                 status.get_error_msg().c_str());
+            }
+        } else if (status_code == TStatusCode::OK) {
             string command = "sh " + config::trans_file_tool_path + " " + label + " download " +
                          local_file_path + " " + restore_request.remote_file_path +
                          " " + info_file_path;
@@ -1832,7 +2335,8 @@ void* TaskWorkerPool::_restore_worker_thread_callback(void* arg_this) {
                 }
                 string file_path_suffix = file_name.substr(file_path_str_len - 4);
                 if (file_path_suffix != ".hdr" && file_path_suffix != ".idx" &&
-                        file_path_suffix != ".dat") {
+                        file_path_suffix != ".dat" &&
+                        file_name.substr(file_path_str_len - 5) != ".pack") {
                     continue;
                 }
 
@@ -1929,6 +2433,8 @@ void* TaskWorkerPool::_make_snapshot_thread_callback(void* arg_this) {
             snapshot_request = agent_task_req.snapshot_req;
             worker_pool_this->_tasks.pop_front();
         }
+        AgentTaskScheduler::Slot slot(
+                scheduler(), agent_task_req, _get_task_disk(agent_task_req));
         // Try to register to cgroups_mgr
         CgroupsMgr::apply_system_cgroup();
         OLAP_LOG_INFO("get snapshot task, signature: %ld", agent_task_req.signature);
@@ -25,6 +25,7 @@
 #include <vector>
 #include "agent/pusher.h"
 #include "agent/status.h"
+#include "agent/task_scheduler.h"
 #include "agent/utils.h"
 #include "gen_cpp/AgentService_types.h"
 #include "gen_cpp/HeartbeatService_types.h"
@@ -73,7 +74,16 @@ public:
     // * task: the task need callback thread to do
     virtual void submit_task(const TAgentTaskRequest& task);
 
+    // Shares the slots for running heavy tasks between the pools
+    static AgentTaskScheduler* scheduler();
+
 private:
+    // Returns true if the workers take a slot of the scheduler for every task
+    bool _is_scheduled() const;
+
+    // Root path of the tablet that 'task' works on, empty if there is none yet
+    static std::string _get_task_disk(const TAgentTaskRequest& task);
+
     bool _record_task_info(
             const TTaskType::type task_type, int64_t signature, const std::string& user);
     void _remove_task_info(
@@ -99,14 +109,69 @@ private:
     static void* _make_snapshot_thread_callback(void* arg_this);
     static void* _release_snapshot_thread_callback(void* arg_this);
 
+    // Moves the queued load pushes of the next versions of the tablet of the push task
+    // in 'batch' into 'batch', at most config::push_batch_max_tasks tasks in total.
+    void _take_push_batch(std::vector<TAgentTaskRequest>* batch);
+
+    // Pushes the tasks of 'batch' together and reports every one of them. The tasks
+    // are pushed one by one if they can't be pushed together.
+    void _push_batch(const std::vector<TAgentTaskRequest>& batch);
+
+    void _finish_push_task(
+            const TAgentTaskRequest& agent_task_req,
+            AgentStatus status,
+            const std::vector<TTabletInfo>& tablet_infos);
+
+    // Copy snapshot of clone tablet from one of src backends. Only the deltas
+    // in missing_versions are copied if it is not NULL.
     AgentStatus _clone_copy(
             const TCloneReq& clone_req,
             int64_t signature,
             const std::string& local_data_path,
+            const std::vector<Version>* missing_versions,
             TBackend* src_host,
             std::string* src_file_path,
             std::vector<std::string>* error_msgs);
 
+    // Download files of snapshot concurrently, header file at last.
+    AgentStatus _download_clone_files(
+            const std::string& src_host,
+            const std::string& remote_url_prefix,
+            const std::string& local_file_full_path,
+            const std::vector<std::string>& file_name_list,
+            int64_t signature);
+
+    void _download_clone_file_worker(
+            const std::string& src_host,
+            const std::string& remote_url_prefix,
+            const std::string& local_file_full_path,
+            const std::string& disk,
+            const std::vector<std::string>* file_names,
+            std::atomic<size_t>* next_file_index,
+            std::atomic<bool>* download_failed,
+            int64_t signature);
+
+    AgentStatus _download_clone_file(
+            const std::string& src_host,
+            const std::string& remote_file_url,
+            const std::string& local_file_path,
+            const std::string& disk,
+            int64_t signature);
+
+    // Versions in (local latest version, committed_version] are missing,
+    // empty if the tablet could not be cloned incrementally.
+    void _get_missing_versions(
+            SmartOLAPTable tablet,
+            int64_t committed_version,
+            std::vector<Version>* missing_versions);
+
+    // Root path which local_path belongs to
+    static std::string _get_clone_download_disk(const std::string& local_path);
+
+    // Get download speed(KB/s) of a file from the clone bandwidth caps
+    static uint32_t _acquire_clone_download_speed(const std::string& disk);
+    static void _release_clone_download_speed(const std::string& disk);
+
     void _alter_table(
             const TAlterTabletReq& create_rollup_request,
             int64_t signature,
@@ -152,6 +217,9 @@ private:
     static FrontendServiceClientCache _master_service_client_cache;
 
     static boost::mutex _disk_broken_lock;
+    static MutexLock _s_clone_download_lock;
+    static uint32_t _s_clone_downloading_count;
+    static std::map<std::string, uint32_t> _s_clone_disk_downloading_count;
     static boost::posix_time::time_duration _wait_duration;
 
     DISALLOW_COPY_AND_ASSIGN(TaskWorkerPool);
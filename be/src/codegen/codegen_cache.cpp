@@ -0,0 +1,64 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "codegen/codegen_cache.h"
+
+#include <boost/thread/locks.hpp>
+#include <llvm/ExecutionEngine/ExecutionEngine.h>
+#include <llvm/IR/LLVMContext.h>
+
+#include "common/config.h"
+
+namespace palo {
+
+CodegenCache::Entry::~Entry() {
+    execution_engine.reset();
+    context.reset();
+}
+
+CodegenCache* CodegenCache::instance() {
+    // Never destroyed: the entries must not outlive llvm, which tears itself down at
+    // exit.
+    static CodegenCache* s_instance = new CodegenCache(config::codegen_cache_capacity);
+    return s_instance;
+}
+
+boost::shared_ptr<CodegenCache::Entry> CodegenCache::lookup(const std::string& key) {
+    boost::lock_guard<boost::mutex> l(_lock);
+    boost::unordered_map<std::string, EntryList::iterator>::iterator it = _index.find(key);
+    if (it == _index.end()) {
+        return boost::shared_ptr<Entry>();
+    }
+    _entries.splice(_entries.begin(), _entries, it->second);
+    return it->second->second;
+}
+
+void CodegenCache::insert(const std::string& key, const boost::shared_ptr<Entry>& entry) {
+    if (_capacity <= 0) {
+        return;
+    }
+    boost::lock_guard<boost::mutex> l(_lock);
+    if (_index.find(key) != _index.end()) {
+        return;
+    }
+    _entries.push_front(std::make_pair(key, entry));
+    _index[key] = _entries.begin();
+    while (_entries.size() > _capacity) {
+        _index.erase(_entries.back().first);
+        _entries.pop_back();
+    }
+}
+
+}
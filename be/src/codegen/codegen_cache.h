@@ -0,0 +1,85 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_QUERY_CODEGEN_CODEGEN_CACHE_H
+#define BDG_PALO_BE_SRC_QUERY_CODEGEN_CODEGEN_CACHE_H
+
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+
+namespace llvm {
+class ExecutionEngine;
+class LLVMContext;
+}
+
+namespace palo {
+
+// Process-wide LRU cache of compiled codegen modules, so that fragment instances
+// generating the same IR don't optimize and jit compile it again. The key is the IR of
+// the functions to jit and everything they reference (see
+// LlvmCodeGen::module_cache_key()). It covers the tuple layouts, types and operators the
+// code was generated for, as the generated IR embeds them as constants.
+//
+// An entry shares the llvm context and execution engine of the LlvmCodeGen that
+// compiled it, the jitted code stays alive until both the entry is evicted and the last
+// LlvmCodeGen using it is destroyed. That memory is not counted by any mem tracker.
+// Code that embeds pointers of its fragment instance, like the hash table of a join,
+// never matches another instance, so the cache mostly helps scans and expressions.
+class CodegenCache {
+public:
+    struct Entry {
+        ~Entry();
+
+        // The engine must be released before the context.
+        boost::shared_ptr<llvm::LLVMContext> context;
+        boost::shared_ptr<llvm::ExecutionEngine> execution_engine;
+
+        // The jitted functions, in the order of the functions in the key.
+        std::vector<void*> fn_ptrs;
+    };
+
+    // 'capacity' is the max number of entries; 0 disables the cache.
+    CodegenCache(int capacity) : _capacity(capacity) { }
+
+    // The cache of this process, with config::codegen_cache_capacity entries.
+    static CodegenCache* instance();
+
+    // Returns the entry for 'key' or NULL.
+    boost::shared_ptr<Entry> lookup(const std::string& key);
+
+    // Adds 'entry' for 'key', evicting the least recently used entries beyond capacity.
+    // Does nothing if there is an entry for 'key' already.
+    void insert(const std::string& key, const boost::shared_ptr<Entry>& entry);
+
+private:
+    typedef std::list<std::pair<std::string, boost::shared_ptr<Entry> > > EntryList;
+
+    const int _capacity;
+
+    boost::mutex _lock;
+    // Most recently used first.
+    EntryList _entries;
+    boost::unordered_map<std::string, EntryList::iterator> _index;
+};
+
+}
+
+#endif
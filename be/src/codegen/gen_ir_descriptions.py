@@ -57,6 +57,7 @@ ir_functions = [
     ["EXPR_GET_DECIMAL_VAL", "4Expr15get_decimal_val"],
     ["HASH_CRC", "ir_crc_hash"],
     ["HASH_FNV", "ir_fnv_hash"],
+    ["HASH_FAST", "ir_fast_hash"],
     ["FROM_DECIMAL_VAL", "16from_decimal_val"],
     ["TO_DECIMAL_VAL", "14to_decimal_val"],
     ["FROM_DATETIME_VAL", "17from_datetime_val"],
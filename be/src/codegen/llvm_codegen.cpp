@@ -98,7 +98,6 @@ LlvmCodeGen::LlvmCodeGen(ObjectPool* pool, const std::string& name) :
         _is_compiled(false),
         _context(new llvm::LLVMContext()),
         _module(NULL),
-        _execution_engine(NULL),
         _scratch_buffer_offset(0),
         _debug_trace_fn(NULL) {
     DCHECK(s_llvm_initialized) << "Must call LlvmCodeGen::initialize_llvm first.";
@@ -109,6 +108,7 @@ LlvmCodeGen::LlvmCodeGen(ObjectPool* pool, const std::string& name) :
     _codegen_timer = ADD_TIMER(&_profile, "CodegenTime");
     _optimization_timer = ADD_TIMER(&_profile, "OptimizationTime");
     _compile_timer = ADD_TIMER(&_profile, "CompileTime");
+    _cache_hit_counter = ADD_COUNTER(&_profile, "ModuleCacheHit", TUnit::UNIT);
 
     _loaded_functions.resize(IRFunction::FN_END);
 }
@@ -688,6 +688,21 @@ Status LlvmCodeGen::finalize_module() {
     }
     SCOPED_TIMER(_profile.total_time_counter());
 
+    // Reuse the code compiled by an earlier fragment instance generating the same IR.
+    std::string cache_key;
+    if (!_fns_to_jit_compile.empty()) {
+        cache_key = module_cache_key();
+        _cache_entry = CodegenCache::instance()->lookup(cache_key);
+        if (_cache_entry != NULL) {
+            DCHECK_EQ(_cache_entry->fn_ptrs.size(), _fns_to_jit_compile.size());
+            for (int i = 0; i < _fns_to_jit_compile.size(); ++i) {
+                *_fns_to_jit_compile[i].second = _cache_entry->fn_ptrs[i];
+            }
+            COUNTER_UPDATE(_cache_hit_counter, 1);
+            return Status::OK;
+        }
+    }
+
     // Don't waste time optimizing module if there are no functions to JIT. This can happen
     // if the codegen object is created but no functions are successfully codegen'd.
     if (_optimizations_enabled // TODO(zc): && !FLAGS_disable_optimization_passes 
@@ -700,6 +715,9 @@ Status LlvmCodeGen::finalize_module() {
     for (int i = 0; i < _fns_to_jit_compile.size(); ++i) {
         *_fns_to_jit_compile[i].second = jit_function(_fns_to_jit_compile[i].first);
     }
+    if (!cache_key.empty()) {
+        add_to_cache(cache_key);
+    }
 #if 0
     if (FLAGS_opt_module_dir.size() != 0) {
         string path = FLAGS_opt_module_dir + "/" + id_ + "_opt.ll";
@@ -716,6 +734,81 @@ Status LlvmCodeGen::finalize_module() {
     return Status::OK;
 }
 
+// Appends the IR of 'value' to 'stream' if it is a function or global not visited yet,
+// and adds the functions and globals it references to 'worklist'.
+static void append_ir_for_cache_key(llvm::Value* value,
+                                    std::set<llvm::Value*>* visited,
+                                    std::vector<llvm::Function*>* worklist,
+                                    llvm::raw_ostream* stream) {
+    if (llvm::isa<llvm::Function>(value) || llvm::isa<llvm::GlobalVariable>(value)) {
+        if (!visited->insert(value).second) {
+            return;
+        }
+        if (llvm::isa<llvm::Function>(value)) {
+            // printed when it's taken from the worklist
+            worklist->push_back(llvm::cast<llvm::Function>(value));
+            return;
+        }
+        llvm::GlobalVariable* global = llvm::cast<llvm::GlobalVariable>(value);
+        global->print(*stream);
+        *stream << '\n';
+        if (global->hasInitializer()) {
+            append_ir_for_cache_key(global->getInitializer(), visited, worklist, stream);
+        }
+    } else if (llvm::isa<llvm::Constant>(value) && !llvm::isa<llvm::GlobalValue>(value)) {
+        // constant exprs and aggregates may reference functions and globals
+        llvm::User* user = llvm::cast<llvm::User>(value);
+        for (unsigned i = 0; i < user->getNumOperands(); ++i) {
+            append_ir_for_cache_key(user->getOperand(i), visited, worklist, stream);
+        }
+    }
+}
+
+std::string LlvmCodeGen::module_cache_key() {
+    std::string key;
+    llvm::raw_string_ostream stream(key);
+    // The generated IR embeds the tuple layouts, types and operators it was generated
+    // for as constants, so they are covered by the IR.
+    stream << "opt:" << _optimizations_enabled << '\n';
+    std::set<llvm::Value*> visited;
+    std::vector<Function*> worklist;
+    for (int i = 0; i < _fns_to_jit_compile.size(); ++i) {
+        stream << "jit:" << _fns_to_jit_compile[i].first->getName() << '\n';
+        append_ir_for_cache_key(_fns_to_jit_compile[i].first, &visited, &worklist, &stream);
+    }
+    while (!worklist.empty()) {
+        Function* fn = worklist.back();
+        worklist.pop_back();
+        fn->print(stream, NULL);
+        for (llvm::inst_iterator it = llvm::inst_begin(fn); it != llvm::inst_end(fn); ++it) {
+            for (unsigned i = 0; i < it->getNumOperands(); ++i) {
+                append_ir_for_cache_key(it->getOperand(i), &visited, &worklist, &stream);
+            }
+        }
+    }
+    return stream.str();
+}
+
+void LlvmCodeGen::add_to_cache(const std::string& key) {
+    boost::shared_ptr<CodegenCache::Entry> entry(new CodegenCache::Entry());
+    for (int i = 0; i < _fns_to_jit_compile.size(); ++i) {
+        if (*_fns_to_jit_compile[i].second == NULL) {
+            // Let later instances try again.
+            return;
+        }
+        entry->fn_ptrs.push_back(*_fns_to_jit_compile[i].second);
+    }
+    entry->context = _context;
+    entry->execution_engine = _execution_engine;
+    {
+        // The jitted code now lives as long as the engine, which may outlive this object.
+        boost::lock_guard<boost::mutex> l(_jitted_functions_lock);
+        _jitted_functions.clear();
+    }
+    _cache_entry = entry;
+    CodegenCache::instance()->insert(key, entry);
+}
+
 void LlvmCodeGen::optimize_module() {
     SCOPED_TIMER(_optimization_timer);
 
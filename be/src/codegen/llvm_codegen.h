@@ -25,6 +25,7 @@
 #include <string>
 #include <vector>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include <llvm/IR/DerivedTypes.h>
@@ -36,6 +37,7 @@
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Support/MemoryBuffer.h>
 
+#include "codegen/codegen_cache.h"
 #include "common/status.h"
 #include "runtime/primitive_type.h"
 #include "exprs/expr.h"
@@ -531,6 +533,14 @@ private:
     // Values are stored in '_llvm_intrinsics'
     Status load_intrinsics();
 
+    // Returns the key of the module in the CodegenCache: the IR of the functions to jit
+    // and of all functions and globals they reference.
+    std::string module_cache_key();
+
+    // Adds the compiled module to the CodegenCache under 'key' if all functions to jit
+    // were compiled.
+    void add_to_cache(const std::string& key);
+
     // Clears generated hash fns.  This is only used for testing.
     void clear_hash_fns();
 
@@ -545,6 +555,7 @@ private:
     RuntimeProfile::Counter* _codegen_timer;
     RuntimeProfile::Counter* _optimization_timer;
     RuntimeProfile::Counter* _compile_timer;
+    RuntimeProfile::Counter* _cache_hit_counter;
 
     // whether or not optimizations are enabled
     bool _optimizations_enabled;
@@ -564,14 +575,18 @@ private:
 
     // Top level llvm object.  Objects from different contexts do not share anything.
     // We can have multiple instances of the LlvmCodeGen object in different threads
-    boost::scoped_ptr<llvm::LLVMContext> _context;
+    // Shared with the CodegenCache entry of the module once it is compiled.
+    boost::shared_ptr<llvm::LLVMContext> _context;
 
     // Top level codegen object.  Contains everything to jit one 'unit' of code.
     // Owned by the _execution_engine.
     llvm::Module* _module;
 
     // Execution/Jitting engine.
-    boost::scoped_ptr<llvm::ExecutionEngine> _execution_engine;
+    boost::shared_ptr<llvm::ExecutionEngine> _execution_engine;
+
+    // The cache entry of the compiled module, if it was taken from or added to the cache.
+    boost::shared_ptr<CodegenCache::Entry> _cache_entry;
 
     // current offset into scratch buffer
     int _scratch_buffer_offset;
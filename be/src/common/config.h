@@ -63,6 +63,12 @@ namespace config {
     CONF_Int32(push_worker_count_normal_priority, "3");
     // the count of thread to high priority batch load
     CONF_Int32(push_worker_count_high_priority, "3");
+    // max number of queued load pushes of consecutive versions into a tablet that a push
+    // worker pushes together, 1 pushes every task on its own
+    CONF_Int32(push_batch_max_tasks, "8");
+    // how long a push worker waits for the next version of a tablet to arrive before
+    // it pushes a batch, 0 only batches the tasks queued already
+    CONF_Int32(push_batch_window_ms, "0");
     // the count of thread to delete
     CONF_Int32(delete_worker_count, "3");
     // the count of thread to alter table
@@ -71,10 +77,19 @@ namespace config {
     CONF_Int32(clone_worker_count, "3");
     // the count of thread to clone
     CONF_Int32(storage_medium_migrate_count, "1");
+    // the count of thread to copy files of one tablet when migrate storage medium
+    CONF_Int32(storage_medium_migrate_copy_thread_num, "4");
+    // the count of thread to load the tablets of one root path when BE starts,
+    // different shards of a root path are loaded concurrently
+    CONF_Int32(load_tablet_thread_num_per_root_path, "4");
+    // the max speed(MB/s) of storage medium migration writing to one root path, 0 means no limit
+    CONF_Int32(storage_medium_migrate_mbytes_per_sec, "100");
     // the count of thread to cancel delete data
     CONF_Int32(cancel_delete_data_worker_count, "3");
     // the count of thread to check consistency
     CONF_Int32(check_consistency_worker_count, "1");
+    // the count of consistency checksums cached in tablet header, 0 means always recompute
+    CONF_Int32(max_cached_checksums_per_tablet, "4");
     // the count of thread to upload
     CONF_Int32(upload_worker_count, "3");
     // the count of thread to restore
@@ -83,12 +98,26 @@ namespace config {
     CONF_Int32(make_snapshot_worker_count, "5");
     // the count of thread to release snapshot
     CONF_Int32(release_snapshot_worker_count, "5");
+    // max number of heavy agent tasks (pushes, deletes, alters, clones, storage medium
+    // migrations, consistency checks, uploads, restores and snapshots) running at the
+    // same time across their worker pools, 0 means no limit besides the worker counts.
+    // The urgent tasks get a free slot first, alters, migrations and checks last.
+    CONF_Int32(agent_task_max_running, "16");
+    // max number of those running on the same root path, 0 means no limit
+    CONF_Int32(agent_task_max_running_per_disk, "0");
+    // a waiting agent task gains a priority level for every this many seconds it waited,
+    // 0 means never
+    CONF_Int32(agent_task_priority_aging_seconds, "60");
     // the interval time(seconds) for agent report tasks signatrue to dm
     CONF_Int32(report_task_interval_seconds, "10");
     // the interval time(seconds) for agent report disk state to dm
     CONF_Int32(report_disk_state_interval_seconds, "600");
     // the interval time(seconds) for agent report olap table to dm
     CONF_Int32(report_olap_table_interval_seconds, "600");
+    // the tablet reports in between only carry the tablets that changed, 0 makes
+    // every report a full one. Incremental reports are only sent to a master that
+    // says it accepts them, still keep it 0 until the frontends are upgraded
+    CONF_Int32(report_olap_table_full_interval_seconds, "0");
     // the timeout(seconds) for alter table
     CONF_Int32(alter_table_timeout_seconds, "86400");
     // the timeout(seconds) for make snapshot
@@ -101,6 +130,12 @@ namespace config {
     CONF_Int32(download_low_speed_limit_kbps, "50");
     // download low speed time(seconds)
     CONF_Int32(download_low_speed_time, "300");
+    // the count of threads to download files of one clone task
+    CONF_Int32(clone_download_thread_num, "4");
+    // the max download speed of all clone tasks on this node(KB/s), 0 means no limit
+    CONF_Int32(clone_max_download_speed_kbps_per_node, "0");
+    // the max download speed of clone tasks writing to one disk(KB/s), 0 means no limit
+    CONF_Int32(clone_max_download_speed_kbps_per_disk, "0");
     // curl verbose mode
     CONF_Int64(curl_verbose_mode, "1");
     // seconds to sleep for each time check table status
@@ -111,6 +146,9 @@ namespace config {
     CONF_Int32(sleep_five_seconds, "5");
     // trans file tools dir
     CONF_String(trans_file_tool_path, "${PALO_HOME}/tools/trans_file_tool/trans_files.sh");
+    // number of files transferred at the same time by one upload or restore task
+    // when the snapshot is moved through broker
+    CONF_Int32(snapshot_transfer_thread_num, "4");
     // agent tmp dir
     CONF_String(agent_tmp_dir, "${PALO_HOME}/tmp");
 
@@ -149,8 +187,20 @@ namespace config {
     // or 3x the number of cores.  This keeps the cores busy without causing excessive
     // thrashing.
     CONF_Int32(num_threads_per_core, "3");
+    // interval of rebalancing the thread quotas of the fragments by their demand and
+    // the CPU load, 0 splits the threads evenly between the fragments.
+    CONF_Int32(thread_quota_rebalance_interval_ms, "500");
+    // the thread quotas shrink while the CPUs are busier than this percent.
+    CONF_Int32(thread_quota_contention_cpu_percent, "90");
     // if true, compresses tuple data in Serialize
     CONF_Bool(compress_rowbatches, "true");
+    // if true, repeated strings of a slot are written once per serialized row batch.
+    // receivers need no change, they already rebuild strings from their offsets.
+    CONF_Bool(share_rowbatch_strings, "true");
+    // if true, exchanged row batches are encoded column by column with per column
+    // dictionary and LZ4 compression, which replaces compress_rowbatches.
+    // all backends of a cluster must support the columnar format before enabling it.
+    CONF_Bool(columnar_rowbatches, "false");
     // serialize and deserialize each returned row batch
     CONF_Bool(serialize_batch, "false");
     // interval between profile reports; in seconds
@@ -161,6 +211,37 @@ namespace config {
     CONF_Int32(palo_scanner_thread_pool_thread_num, "48");
     // number of olap scanner thread pool size
     CONF_Int32(palo_scanner_thread_pool_queue_size, "102400");
+    // weights of resource groups in olap scanner thread pool, e.g. "normal:1,high:4",
+    // groups not listed have weight 1
+    CONF_String(palo_scanner_thread_pool_group_weights, "");
+    // if true and the machine has several NUMA nodes, the olap scanner threads are
+    // bound to the nodes and a tablet is scanned on the node of its storage root path.
+    CONF_Bool(enable_numa_affinity, "false");
+    // max number of threads that scan the files of one broker scan node concurrently
+    CONF_Int32(broker_scanner_num_threads, "4");
+    // uncompressed text files larger than this are split into ranges of this size,
+    // which are scanned by different broker scanner threads.
+    CONF_Int64(broker_scan_range_split_mb, "256");
+    // number of chunks a broker reader reads ahead concurrently, 0 reads synchronously
+    CONF_Int32(broker_reader_prefetch_depth, "2");
+    // size of the chunks a broker reader reads ahead
+    CONF_Int32(broker_reader_prefetch_chunk_kb, "2048");
+    // number of threads that decode the blocks of a bgzip or lz4 file concurrently
+    // during a load, 1 decodes on the scanner thread
+    CONF_Int32(load_decompress_threads, "4");
+    // exported rows are handed to the file writer thread in buffers of this size
+    CONF_Int32(export_write_buffer_kb, "1024");
+    // max number of buffers an export waits to be written before it blocks
+    CONF_Int32(export_max_pending_buffers, "4");
+    // number of files an export fragment writes at the same time, each one by a
+    // writer thread of its own
+    CONF_Int32(export_parallel_files, "1");
+    // errors of a load waiting to be written to the load error hub, more are dropped
+    CONF_Int32(load_error_hub_buffer_size, "1000");
+    // the load error hub keeps the first errors of a load and then 1 in
+    // load_error_hub_sample_rate of them, 0 keeps none of the later ones
+    CONF_Int64(load_error_hub_sample_after, "10");
+    CONF_Int64(load_error_hub_sample_rate, "100");
     // number of etl thread pool size
     CONF_Int32(etl_thread_pool_size, "8");
     // number of etl thread pool size
@@ -169,25 +250,116 @@ namespace config {
     CONF_Int32(port, "20001");
     // default thrift client connect timeout(in seconds)
     CONF_Int32(thrift_connect_timeout_seconds, "3");
+    // max number of thrift connections the client caches keep to a single host, in use
+    // or idle. A caller waits up to thrift_connect_timeout_seconds for one to be released
+    // once the limit is reached. 0 means no limit.
+    CONF_Int32(thrift_client_cache_max_per_host, "0");
+    // idle thrift connections are closed after this many seconds, 0 keeps them forever
+    CONF_Int32(thrift_client_cache_idle_timeout_s, "300");
+    // number of connections kept open to every broker this backend has used, so that a
+    // burst of loads doesn't start with connecting
+    CONF_Int32(broker_client_cache_warm_up_num, "4");
     // max row count number for single scan range
     CONF_Int32(palo_scan_range_row_count, "524288");
     // size of scanner queue between scanner thread and compute thread
     CONF_Int32(palo_scanner_queue_size, "1024");
     // single read execute fragment row size
     CONF_Int32(palo_scanner_row_num, "16384");
+    // adjust the number of running scanners of an olap scan node to the speed of
+    // its consumer instead of always running as many as the scanner queue allows
+    CONF_Bool(enable_adaptive_scanner_concurrency, "true");
+    // when an olap scan node has idle scanner slots but no scanner waiting, split
+    // the key ranges a running scanner hasn't started yet into a new scanner
+    CONF_Bool(enable_scanner_key_range_split, "true");
     // number of max scan keys
     CONF_Int32(palo_max_scan_key_num, "1024");
+    // skip-scan the fixed values of leading key columns whose combinations are more
+    // than palo_max_scan_key_num, instead of scanning the whole range
+    CONF_Bool(enable_olap_skip_scan, "true");
+    // max number of build rows of hash join whose join keys can be pushed down to
+    // the probe side scan as IN predicates. IN predicates with more than
+    // palo_max_scan_key_num values are pushed to storage as min/max range.
+    CONF_Int32(runtime_filter_max_in_num, "512000");
     // return_row / total_row
     CONF_Int32(palo_max_pushdown_conjuncts_return_rate, "90");
+    // if true, scan tablets in column batches instead of one tuple per row
+    // when the storage reader supports it, see OLAPReader::is_vectorized_supported
+    CONF_Bool(enable_vectorized_olap_scan, "false");
     // (Advanced) Maximum size of per-query receive-side buffer
     CONF_Int32(exchg_node_buffer_size_bytes, "10485760");
+    // Max number of row batches a data stream sender channel has in flight, i.e. sent
+    // but not yet acked by the receiver. A failed transmission is only retried when it
+    // was the only one in flight, so 1 keeps the retry for every batch.
+    CONF_Int32(data_stream_sender_max_in_flight_rpcs, "1");
+    // if true, a data stream sender hands its row batches to a receiver on the same
+    // backend directly instead of serializing them and sending them via rpc
+    CONF_Bool(enable_local_exchange, "true");
+    // if true, a data stream sender writes the tuple data of a row batch behind the
+    // thrift message instead of into it, so that it is copied neither when it is sent
+    // nor when it is received. The receivers of all backends must understand this, so
+    // only turn it on once every backend of the cluster is upgraded.
+    CONF_Bool(enable_exchange_out_of_band_tuple_data, "false");
+    // if true, data stream senders serialize their transmit_data requests with the thrift
+    // compact protocol, which is smaller for the many small integers of a row batch.
+    // The receivers of all backends must understand this, so only turn it on once every
+    // backend of the cluster is upgraded.
+    CONF_Bool(exchange_use_compact_protocol, "false");
+    // Max bytes of mem pool chunks a row batch keeps across reset() for its next rows.
+    CONF_Int64(row_batch_max_retained_bytes, "1048576");
+    // Max number of reset row batches an olap scan node or an exchange receiver keeps
+    // for reuse instead of allocating new ones.
+    CONF_Int32(row_batch_pool_max_free_batches, "16");
+    // Max number of rows and of bytes of the mysql rows a query result buffer holds
+    // until the FE fetches them. The result sink blocks once either is reached.
+    CONF_Int32(result_buffer_max_rows, "16384");
+    CONF_Int64(result_buffer_max_bytes, "33554432");
+    // Max size of the mysql rows of one fetch response. Batches the FE has not fetched
+    // yet are merged into one response up to this size.
+    CONF_Int64(result_packet_max_bytes, "4194304");
+    // Capacity of the cache of query results on a backend, 0 disables it. Only the
+    // results of fragments that read all of their input from local tablets, without an
+    // exchange, are cached, see ResultCache.
+    CONF_Int64(result_cache_capacity_bytes, "0");
+    // Results larger than this are not cached.
+    CONF_Int64(result_cache_max_entry_bytes, "8388608");
+    // Capacity of the cache of the partial aggregates of local tablets, 0 disables it.
+    // A query over tablets that only got new delta versions since the entry was made
+    // aggregates just the deltas, see PartialAggCache.
+    CONF_Int64(partial_agg_cache_capacity_bytes, "0");
+    // Partial aggregates larger than this are not cached.
+    CONF_Int64(partial_agg_cache_max_entry_bytes, "67108864");
+    // Capacity of the cache of the descriptor tables of plan fragments, shared by the
+    // executions of the same plan, 0 disables it. See FragmentTemplateCache.
+    CONF_Int64(fragment_template_cache_capacity_bytes, "67108864");
     // insert sort threadhold for sorter
     CONF_Int32(insertion_threadhold, "16");
     // the block_size every block allocate for sorter
     CONF_Int32(sorter_block_size, "8388608");
     // push_write_mbytes_per_sec
     CONF_Int32(push_write_mbytes_per_sec, "10");
+    // threads shared by all segment writers to encode columns of a row block in parallel,
+    // 0 means columns are encoded in the writing thread
+    CONF_Int32(segment_write_encode_thread_num, "4");
+    // max memory(MB) of free stream buffers kept for reuse by column writers
+    CONF_Int32(column_stream_buffer_pool_mb, "64");
+    // number of row blocks decoded ahead by the reading thread of a push,
+    // 0 means reading and writing the delta file on one thread
+    CONF_Int32(push_convert_queue_size, "4");
     CONF_Int32(base_expansion_write_mbytes_per_sec, "5");
+    // column file writer of compaction and schema change caches a whole segment in memory
+    // before flushing it, a value greater than 0 caps the segment size of these writers,
+    // including the segments of vertical merge. A small cap splits base versions of large
+    // tablets into many segments. 0 disables
+    CONF_Int64(compaction_max_buffered_segment_size, "0");
+    // a value greater than 0 makes compaction of tables with more value columns than this
+    // merge the key columns first, and then the value columns this many at a time in the
+    // recorded merge order, so that the readers of a merge keep only the key columns and
+    // one group of value columns of every source in memory. See Merger. 0 disables
+    CONF_Int32(vertical_compaction_column_group_size, "0");
+    // versions whose index and data files add up to less than this many bytes are packed
+    // into one file after they are written, saving a file and a file descriptor per file
+    // of small loads and compactions. Older releases can't read packed versions, 0 disables
+    CONF_Int64(packed_version_max_size, "0");
 
     CONF_Int64(column_dictionary_key_ration_threshold, "0");
     CONF_Int64(column_dictionary_key_size_threshold, "0");
@@ -197,6 +369,9 @@ namespace config {
     CONF_String(module_output, "");
     // memory_limiation_per_thread_for_schema_change unit GB
     CONF_Int32(memory_limiation_per_thread_for_schema_change, "2");
+    // number of threads sorting and merging row blocks in memory for one schema change
+    // with sorting, they share the memory limitation of the schema change
+    CONF_Int32(schema_change_sort_thread_num, "1");
 
     CONF_Int64(max_unpacked_row_block_size, "104857600");
 
@@ -204,11 +379,65 @@ namespace config {
     CONF_Int32(base_expansion_trigger_interval, "1");
     CONF_Int32(cumulative_check_interval, "1");
     CONF_Int32(disk_stat_monitor_interval, "5");
+    // choose root path for new tablet by disk load, otherwise randomly
+    CONF_Bool(enable_load_aware_root_path, "true");
+    // root paths whose load score fall in the same bucket are treated as equally loaded
+    CONF_Int32(root_path_load_score_bucket, "20");
+    // interval to move tablets from hot root path to cold one, 0 means disabled
+    CONF_Int32(root_path_rebalance_interval_sec, "0");
+    // a root path is hot only if its load score reaches this value
+    CONF_Int32(root_path_rebalance_hot_score, "80");
+    // the least load score difference between hot and cold root path to rebalance
+    CONF_Int32(root_path_rebalance_score_diff, "40");
+    // the least available capacity percent of cold root path to rebalance
+    CONF_Int32(root_path_rebalance_min_available_percent, "20");
+    // number of random tablets of the hot root path, of which the one read most
+    // recently is moved
+    CONF_Int32(root_path_rebalance_tablet_samples, "8");
+    // a read or write of the storage engine taking longer is logged, 0 means disabled
+    CONF_Int32(slow_io_threshold_ms, "500");
+    // interval to convert one row-oriented tablet to column files, 0 means disabled
+    CONF_Int32(column_file_convert_interval_sec, "0");
+    // the max speed(MB/s) of reading row-oriented data when converting, 0 means no limit
+    CONF_Int32(column_file_convert_mbytes_per_sec, "20");
     CONF_Int32(unused_index_monitor_interval, "30");
     CONF_String(storage_root_path, "${PALO_HOME}/storage");
+    // numa nodes of storage root paths if enable_numa_affinity is true, e.g.
+    // "/home/disk1/palo:0;/home/disk2/palo:1". paths not listed are on the node of
+    // their disk controller, or else spread over the nodes in turn.
+    CONF_String(storage_root_path_numa_nodes, "");
     CONF_Int32(min_percentage_of_error_disk, "50");
     CONF_Int32(default_num_rows_per_data_block, "1024");
     CONF_Int32(default_num_rows_per_column_file_block, "1024");
+    // if true, row index entries of column file record the null count of each block,
+    // and min/max only cover non-null values. Files written in this format can not be
+    // read by older versions, so only turn it on once no backend needs to be
+    // downgraded and every backend a tablet may be cloned to is upgraded.
+    CONF_Bool(column_index_with_null_count, "false");
+    // if true, SegmentReader decodes condition columns of a block first and only
+    // decodes the other columns for rows satisfying the conditions. the condition
+    // columns of a block with selected rows are decoded twice, so it only pays off
+    // for selective conditions
+    CONF_Bool(enable_segment_late_materialization, "false");
+    // if greater than 0, a bitmap index is written for every column whose number of
+    // distinct values in a segment does not exceed this value, 0 means disabled
+    CONF_Int32(bitmap_index_max_cardinality, "0");
+    // if true, segments record an NDV sketch and an equi-depth histogram of every
+    // column, they are merged per tablet and reported to FE for the planner. They grow
+    // segment headers, tablet headers and tablet reports of wide tables considerably,
+    // so keep it off until the planner uses them
+    CONF_Bool(enable_column_sketch, "false");
+    // bytes of every column stream to prefetch ahead of the current read position,
+    // the kernel reads them asynchronously while the current block is decoded.
+    // 0 means disabled
+    CONF_Int32(column_file_read_ahead_bytes, "262144");
+    // default level of columns compressed with zstd
+    CONF_Int32(zstd_compress_level, "3");
+    // if true, every data stream of a column without its own compression samples its
+    // first chunk and picks the codec with the best ratio among lz4, lzo and zstd,
+    // whose decompression is not slower than adaptive_compress_min_decompress_mb_per_sec
+    CONF_Bool(enable_adaptive_compress, "false");
+    CONF_Int32(adaptive_compress_min_decompress_mb_per_sec, "500");
     CONF_Int32(max_tablet_num_per_shard, "1024");
     // garbage sweep policy
     CONF_Int32(max_garbage_sweep_interval, "86400");
@@ -217,18 +446,59 @@ namespace config {
     // 仅仅是建议值，当磁盘空间不足时，trash下的文件保存期可不遵守这个参数
     CONF_Int32(trash_file_expire_time_sec, "259200");
     CONF_Int32(disk_capacity_insufficient_percentage, "90");
+    // max files and dirs unlinked per second when sweeping one root path, 0 means no limit
+    CONF_Int32(trash_sweep_max_unlink_per_sec_per_path, "2000");
     // check row nums for BE/CE and schema change. true is open, false is closed.
     CONF_Bool(row_nums_check, "true")
+    // version changes of a tablet header are appended to a delta log instead of rewriting
+    // the whole header file, which is rewritten after this many records, 0 disables the log.
+    // Older releases don't replay the log and would load a stale header, so only turn it
+    // on once no backend needs to be rolled back
+    CONF_Int32(header_log_max_records, "0");
     // be policy
     CONF_Int32(base_expansion_thread_num, "1");
     CONF_Int64(be_policy_start_time, "20");
     CONF_Int64(be_policy_end_time, "7");
     //file descriptors cache, by default, cache 30720 descriptors
     CONF_Int32(file_descriptor_cache_capacity, "30720");
+    // file descriptors cached per root path, each root path evicts on its own.
+    // 0 splits file_descriptor_cache_capacity evenly among the root paths
+    CONF_Int32(file_descriptor_cache_capacity_per_root_path, "0");
     CONF_Int64(index_stream_cache_capacity, "10737418240");
+    // mmap short key index files instead of copying them into memory, pages are
+    // shared with the page cache and can be reclaimed by the kernel under memory pressure
+    CONF_Bool(enable_index_mmap, "true");
+    // only validate file headers when loading tables at startup, the short key index
+    // of a version is loaded on its first access
+    CONF_Bool(enable_lazy_index_load, "true");
+    // the short key indices of a tablet not queried for this long are unloaded, and loaded
+    // again on the next access, 0 means disabled. Only with enable_lazy_index_load
+    CONF_Int32(cold_tablet_index_unload_sec, "3600");
+    // capacity of the cache holding decompressed data stream chunks, 0 means disabled
+    CONF_Int64(data_page_cache_capacity, "0");
+    // capacity of the cache holding rows returned by primary key lookups, 0 means disabled
+    CONF_Int64(row_cache_capacity, "0");
+    // the version written by a compaction of a tablet queried within this many seconds is
+    // read into the index stream and data page caches before it replaces the merged versions,
+    // whose index streams are evicted then. 0 means disabled
+    CONF_Int32(compaction_cache_warm_up_sec, "0");
+    // versions larger than this are not read into the caches after compaction
+    CONF_Int64(compaction_cache_warm_up_max_bytes, "268435456");
+    // total capacity shared by the index stream, data page and row caches, moved to the
+    // caches with the most hits per byte. 0 means each cache keeps its own capacity
+    CONF_Int64(cache_memory_budget_bytes, "0");
+    // interval to update the cache metrics and rebalance the caches, 0 means disabled
+    CONF_Int32(cache_manager_interval_sec, "10");
+    // max number of keys in one primary key lookup request
+    CONF_Int32(lookup_max_keys_per_request, "4096");
     CONF_Int64(max_packed_row_block_size, "20971520");
     CONF_Int32(cumulative_write_mbytes_per_sec, "100");
     CONF_Int64(ce_policy_delta_files_number, "5");
+    // compaction score of a tablet is its delta count weighted by query frequency,
+    // plus its cumulative delta size in unit of ce_policy_max_delta_file_size.
+    // a tablet queried this many times since its last compaction gets 1.5x weight,
+    // and the weight approaches 2x as it is queried more.
+    CONF_Int64(compaction_score_query_count_base, "100");
     // ce policy: max delta file's size unit:B
     CONF_Int32(cumulative_thread_num, "1");
     CONF_Int64(ce_policy_max_delta_file_size, "104857600");
@@ -236,6 +506,15 @@ namespace config {
     CONF_Double(be_policy_cumulative_base_ratio, "0.3");
     CONF_Int64(be_policy_be_interval_seconds, "604800");
     CONF_Int32(cumulative_source_overflow_ratio, "5");
+    // "default" merges the deltas after the cumulative layer point into the cumulative file
+    // before them. "size_tiered" merges ce_tier_fan_in adjacent versions of a size tier into
+    // one of the next tier, and all adjacent versions of the smallest tier at once, so that
+    // a row is rewritten about log(ce_policy_max_delta_file_size / ce_tier_base_size) times
+    CONF_String(cumulative_compaction_policy, "default");
+    CONF_Int32(ce_tier_fan_in, "4");
+    // versions smaller than this are in the smallest tier, tier i holds the versions
+    // smaller than ce_tier_base_size * ce_tier_fan_in ^ i
+    CONF_Int64(ce_tier_base_size, "4194304");
     CONF_Int32(delete_delta_expire_time, "1440");
     // Port to start debug webserver on
     CONF_Int32(webserver_port, "8040");
@@ -244,6 +523,22 @@ namespace config {
     CONF_String(webserver_doc_root, "${PALO_HOME}");
     // If true, webserver may serve static files from the webserver_doc_root
     CONF_Bool(enable_webserver_doc_root, "true");
+
+    // Max number of tablets the scan latency histogram keeps apart, scans of further
+    // tablets are counted together under tablet_id="other"
+    CONF_Int32(tablet_scan_latency_max_tablets, "1000");
+
+    // The access stats of the tablets are decayed every interval, so that a count
+    // weighs half after the half life. 0 disables the decay and the rates stay 0.
+    CONF_Int32(tablet_access_stats_decay_interval_sec, "60");
+    CONF_Int32(tablet_access_stats_half_life_sec, "1800");
+
+    // Max number of spans one thread records for a query run with enable_query_trace,
+    // the following spans of the thread are dropped
+    CONF_Int32(query_trace_max_events_per_thread, "10000");
+    // Number of the most recent traced queries whose trace is kept for /api/query_trace
+    CONF_Int32(query_trace_max_queries, "32");
+
     // The number of times to retry connecting to an RPC server. If zero or less,
     // connections will be retried until successful
     CONF_Int32(rpc_retry_times, "10");
@@ -251,16 +546,52 @@ namespace config {
     CONF_Int32(rpc_retry_interval_ms, "30000");
     //reactor number
     CONF_Int32(rpc_reactor_threads, "10")
+    // pin the reactor threads to cpus round-robin
+    CONF_Bool(rpc_reactor_cpu_affinity, "false");
+    // number of SO_REUSEPORT sockets the rpc port is listened on, each one accepts
+    // connections on a reactor of its own
+    CONF_Int32(rpc_listen_sockets, "1");
     // Period to update rate counters and sampling counters in ms.
     CONF_Int32(periodic_counter_update_period_ms, "500");
 
     // Used for mini Load
     CONF_Int64(load_data_reserve_hours, "24");
     CONF_Int64(mini_load_max_mb, "2048");
+    // if true, the body of a mini load without sub label is streamed to its etl job
+    // through memory instead of being saved to a file first.
+    CONF_Bool(enable_streaming_mini_load, "true");
+    // max size of the body of a streaming mini load buffered in memory, the client is
+    // slowed down beyond it until the etl job reads the data.
+    CONF_Int64(streaming_mini_load_buffer_mb, "64");
+    // a streaming mini load fails if its etl job doesn't read or its client doesn't send
+    // data for so long.
+    CONF_Int32(streaming_mini_load_timeout_s, "600");
 
     // Fragment thread pool
     CONF_Int32(fragment_pool_thread_num, "64");
     CONF_Int32(fragment_pool_queue_size, "1024");
+    // Max number of fragment pool threads running at the same time. Threads waiting
+    // for an exchange, a scanner or an rpc don't count, another one is started in
+    // their place, up to fragment_pool_thread_num. 0 means no limit.
+    CONF_Int32(fragment_pool_active_thread_num, "0");
+
+    // Admission control of fragments per resource group. A group runs at most
+    // admission_max_fragments_per_group fragments, whose memory limits add up to at most
+    // admission_mem_limit_per_group (bytes or a percentage of the physical memory);
+    // "0" disables either budget. Further fragments queue for up to
+    // admission_queue_timeout_ms and fail after that, at most
+    // admission_max_queued_fragments per group.
+    CONF_Int32(admission_max_fragments_per_group, "0");
+    CONF_String(admission_mem_limit_per_group, "0");
+    CONF_Int32(admission_queue_timeout_ms, "60000");
+    CONF_Int32(admission_max_queued_fragments, "1024");
+
+    // Max number of compiled codegen modules cached for reuse by later fragment
+    // instances generating the same code. 0 disables the cache.
+    // Off by default: every entry keeps the llvm context and execution engine of its
+    // module alive outside of any mem tracker, and the code of joins and aggregations
+    // embeds pointers of its fragment instance, so it is rarely reused.
+    CONF_Int32(codegen_cache_capacity, "0");
 
     //for cast
     CONF_Bool(cast, "true");
@@ -268,11 +599,35 @@ namespace config {
     // Spill to disk when query
     // Writable scratch directories, splitted by ";"
     CONF_String(query_scratch_dirs, "${PALO_HOME}");
+    // LZ4 compress the blocks spilled by BufferedBlockMgr2, trading cpu for scratch IO.
+    CONF_Bool(compress_spilled_blocks, "false");
+    // Scratch space a query may allocate, 0 means no limit.
+    CONF_Int64(query_scratch_limit_bytes, "0");
 
     // Control the number of disks on the machine.  If 0, this comes from the system settings.
     CONF_Int32(num_disks, "0");
     // The maximum number of the threads per disk is also the max queue depth per disk.
     CONF_Int32(num_threads_per_disk, "0");
+    // If positive, local disks do their IO through io_uring with up to this many
+    // requests in flight per disk (rounded up to a power of two), instead of one
+    // blocking request per disk thread.
+    // Disks fall back to threads if the kernel doesn't support io_uring (before 5.6).
+    CONF_Int32(disk_io_uring_queue_depth, "0");
+    // Shares of the disks of the IO classes when they compete for a disk of the
+    // DiskIoMgr: a class with twice the share gets twice as many requests served.
+    CONF_Int32(io_share_query, "8");
+    CONF_Int32(io_share_load, "4");
+    CONF_Int32(io_share_compaction, "2");
+    CONF_Int32(io_share_clone, "1");
+    CONF_Int32(io_share_backup, "1");
+    // Backend wide rate caps of the IO classes, 0 for no cap. They apply to the
+    // DiskIoMgr and to the file IO of the storage engine, e.g. compaction and clone.
+    CONF_Int64(io_rate_limit_query_mbytes_per_sec, "0");
+    CONF_Int64(io_rate_limit_load_mbytes_per_sec, "0");
+    CONF_Int64(io_rate_limit_compaction_mbytes_per_sec, "0");
+    CONF_Int64(io_rate_limit_clone_mbytes_per_sec, "0");
+    // also the bandwidth of snapshot uploads and restores through broker
+    CONF_Int64(io_rate_limit_backup_mbytes_per_sec, "0");
     // The read size is the size of the reads sent to os.
     // There is a trade off of latency and throughout, trying to keep disks busy but
     // not introduce seeks.  The literature seems to agree that with 8 MB reads, random
@@ -286,6 +641,16 @@ namespace config {
 
     CONF_Bool(disable_mem_pools, "false");
 
+    // Bytes of freed MemPool chunks each thread keeps for its next allocations.
+    CONF_Int64(mem_pool_thread_cache_bytes, "2097152");
+    // Bytes of freed MemPool chunks kept for all threads beyond their own ones. Chunks
+    // beyond that are returned to malloc.
+    CONF_Int64(mem_pool_reserved_bytes, "268435456");
+    // MemTrackers with children buffer changes of their consumption per cpu up to this
+    // many bytes before adding them to the shared counter, except near their limit.
+    // 0 updates the shared counter every time.
+    CONF_Int64(mem_tracker_consume_batch_bytes, "262144");
+
     // The probing algorithm of partitioned hash table.
     // Enable quadratic probing hash table
     CONF_Bool(enable_quadratic_probing, "false");
@@ -296,10 +661,108 @@ namespace config {
     // for partition
     CONF_Bool(enable_partitioned_hash_join, "false")
     CONF_Bool(enable_partitioned_aggregation, "false")
+    // If true, a query that exceeds its memory limit first drops cached row batches,
+    // shrinks the scanner queues and asks the spilling nodes to spill. It may overrun
+    // the limit by mem_limit_grace_percent until they did, before it fails.
+    CONF_Bool(enable_mem_limit_degradation, "true")
+    CONF_Int32(mem_limit_grace_percent, "10")
+    // Number of plans remembered to have exceeded their memory limit. Their next runs
+    // use the partitioned aggregation and hash join, which can spill.
+    CONF_Int32(mem_limit_exceeded_plan_cache_size, "1024")
+    // A streaming pre-aggregation stops aggregating and passes rows through once its
+    // hash tables are larger than this and reduce the input less than the ratio below.
+    CONF_Int64(streaming_preagg_max_hash_table_bytes, "2097152")
+    CONF_Double(streaming_preagg_min_reduction, "2.0")
+    // A pre-aggregated olap scan stops merging rows with equal key across versions and
+    // reads the versions one by one once a sample of this many rows is reduced less
+    // than the ratio below, the aggregation above merges them anyway. 0 disables it.
+    CONF_Int64(storage_merge_sample_rows, "65536")
+    CONF_Double(storage_merge_min_reduction, "1.1")
+    // If true, a top-n node with a limit passes the first ORDER BY value of its current
+    // n-th row down to the olap scan below it, which drops the rows and skips the
+    // blocks that are behind it.
+    CONF_Bool(enable_topn_runtime_bound, "true")
+    // A partition top-n passes on the rows it keeps and starts over once they take more
+    // memory than this, the sort and the filter above it are exact anyway.
+    CONF_Int64(partition_topn_max_memory_bytes, "67108864")
+    // The conjuncts of a node or an olap scanner are reordered by their cost and pass
+    // rate measured over this many batches, cheap and selective ones first. 0 disables it.
+    CONF_Int32(conjunct_reorder_interval_batches, "16")
+
+    // Max number of threads, including the fragment thread, that sort a run of the
+    // spilling sorter in memory. Threads beyond the first are only used if the query
+    // has thread tokens left. 1 disables the parallel sort.
+    CONF_Int32(spill_sort_max_threads, "4")
+
+    // Bytes of build rows that a cross join pairs with all rows of a probe batch before
+    // moving on, so that they stay in the CPU cache.
+    CONF_Int32(cross_join_tile_bytes, "262144")
+    // Max number of threads, including the fragment thread, that evaluate the conjuncts
+    // of a cross join with at most cross_join_parallel_max_build_rows build rows.
+    // 1 disables the parallel evaluation.
+    CONF_Int32(cross_join_max_threads, "4")
+    CONF_Int64(cross_join_parallel_max_build_rows, "2048")
+
+    // Max number of children of a union or merge node that are read at the same time,
+    // each by its own thread. Threads beyond the first are only used if the query has
+    // thread tokens left. 1 reads the children one after another.
+    CONF_Int32(union_max_parallel_children, "4")
+
+    // If true, the instances of a broadcast hash join on one backend build a single hash
+    // table and all probe it, instead of each building its own copy.
+    CONF_Bool(enable_shared_broadcast_hash_table, "false")
+
+    // If true, hash tables and in-memory sorts keep the length and first bytes of the
+    // first string key next to each row, so that short keys are compared without
+    // dereferencing the string data.
+    CONF_Bool(enable_string_key_prefix, "true")
+
+    // Bucket and node arrays of hash tables of at least this many bytes are mapped
+    // separately and backed by transparent huge pages, they grow with mremap() instead
+    // of being copied. -1 allocates them all with malloc.
+    CONF_Int64(hash_table_huge_page_min_bytes, "2097152")
+    // If true, a hash table that doubles its buckets splits the old buckets into the new
+    // ones a few at a time on the following inserts, instead of all at once.
+    CONF_Bool(enable_incremental_hash_table_resize, "true")
+    CONF_Int32(hash_table_split_buckets_per_insert, "4")
+
+    // If true, the segment, index and header files written under a root path are synced
+    // to disk before they are closed, in groups with the files closed at the same time,
+    // so that concurrent loads share the flushes of the disk.
+    CONF_Bool(enable_group_sync, "true")
+
+    // If true, a load into a UNIQUE_KEYS table looks up the previous row of each of its
+    // keys and records it in the delete bitmap of the table, and queries read the
+    // versions one by one skipping the replaced rows instead of merging them.
+    CONF_Bool(enable_unique_key_merge_on_write, "false")
+    // Versions with more rows are not looked up, and queries merge them as before.
+    // The lookup holds the header lock of the table.
+    CONF_Int64(merge_on_write_max_lookup_rows, "100000")
+
+    // If true, in-memory sorts encode the keys of every row into bytes that compare
+    // with memcmp like the keys do, as far as the key types allow, and compare the rows
+    // only where those tie. The sort of an etl job runs on up to dpp_sort_threads threads.
+    CONF_Bool(enable_normalized_sort_key, "true")
+    CONF_Int32(dpp_sort_threads, "4")
+
+    // Number of threads an etl job feeds the sorters of its partitions with, each one
+    // taking a group of the partitions. The rows are routed to the partitions on the
+    // sending thread, and at most data_spliter_queue_batches full batches wait for
+    // each feeding thread. 1 feeds the sorters on the sending thread.
+    CONF_Int32(data_spliter_threads, "4")
+    CONF_Int32(data_spliter_queue_batches, "4")
+
+    // the number of ranges of its integer key a mysql table is scanned in, by one
+    // connection each. 1 scans it in one query.
+    CONF_Int32(mysql_scan_split_num, "4");
 
     // for kudu
     // "The maximum size of the row batch queue, for Kudu scanners."
+    // 0 derives it from palo_scanner_queue_size.
     CONF_Int32(kudu_max_row_batches, "0")
+    // the max number of scan tokens of a kudu scan node processed at the same time,
+    // by tasks of the scanner thread pool.
+    CONF_Int32(kudu_scanner_thread_num, "8")
     // "The period at which Kudu Scanners should send keep-alive requests to the tablet "
     // "server to ensure that scanners do not time out.")
     // 150 * 1000 * 1000
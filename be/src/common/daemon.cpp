@@ -24,6 +24,7 @@
 #include "util/cpu_info.h"
 #include "util/debug_util.h"
 #include "util/disk_info.h"
+#include "util/numa_info.h"
 #include "util/logging.h"
 #include "util/mem_info.h"
 #include "util/network_util.h"
@@ -82,6 +83,7 @@ void init_daemon(int argc, char** argv) {
     init_thrift_logging();
     CpuInfo::init();
     DiskInfo::init();
+    NumaInfo::init();
     MemInfo::init();
     LibCache::init();
     Operators::init();
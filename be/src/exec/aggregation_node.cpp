@@ -33,6 +33,7 @@
 #include "exprs/agg_fn_evaluator.h"
 #include "exprs/expr.h"
 #include "exprs/slot_ref.h"
+#include "exprs/subexpr_cache.h"
 #include "gen_cpp/Exprs_types.h"
 #include "gen_cpp/PlanNodes_types.h"
 #include "runtime/descriptors.h"
@@ -68,6 +69,7 @@ AggregationNode::AggregationNode(
             _output_tuple_id(tnode.agg_node.output_tuple_id),
             _output_tuple_desc(NULL),
             _singleton_output_tuple(NULL),
+            _subexpr_cache(NULL),
             //_tuple_pool(new MemPool()),
             //
             _codegen_process_row_batch_fn(NULL),
@@ -106,6 +108,7 @@ Status AggregationNode::prepare(RuntimeState* state) {
         ADD_COUNTER(runtime_profile(), "LoadFactor", TUnit::DOUBLE_VALUE);
 
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
 
     _intermediate_tuple_desc =
         state->desc_tbl().get_tuple_descriptor(_intermediate_tuple_id);
@@ -150,6 +153,13 @@ Status AggregationNode::prepare(RuntimeState* state) {
         state->obj_pool()->add(_agg_fn_ctxs[i]);
     }
 
+    std::vector<ExprContext*> input_expr_ctxs = _probe_expr_ctxs;
+    for (int i = 0; i < _aggregate_evaluators.size(); ++i) {
+        const std::vector<ExprContext*>& ctxs = _aggregate_evaluators[i]->input_expr_ctxs();
+        input_expr_ctxs.insert(input_expr_ctxs.end(), ctxs.begin(), ctxs.end());
+    }
+    _subexpr_cache = SubExprCache::create(_pool, input_expr_ctxs);
+
     // TODO: how many buckets?
     _hash_tbl.reset(new HashTable(
             _build_expr_ctxs, _probe_expr_ctxs, 1, true, id(), mem_tracker(), 1024));
@@ -182,6 +192,7 @@ Status AggregationNode::prepare(RuntimeState* state) {
 Status AggregationNode::open(RuntimeState* state) {
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::OPEN));
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(ExecNode::open(state));
     RETURN_IF_ERROR(Expr::open(_probe_expr_ctxs, state));
     RETURN_IF_ERROR(Expr::open(_build_expr_ctxs, state));
@@ -264,6 +275,7 @@ Status AggregationNode::open(RuntimeState* state) {
 
 Status AggregationNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
     RETURN_IF_CANCELLED(state);
     RETURN_IF_ERROR(state->check_query_state());
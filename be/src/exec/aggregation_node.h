@@ -45,6 +45,7 @@ struct StringValue;
 class Tuple;
 class TupleDescriptor;
 class SlotDescriptor;
+class SubExprCache;
 
 // Node for in-memory hash aggregation.
 // The node creates a hash set of aggregation output tuples, which
@@ -101,6 +102,10 @@ private:
     Tuple* _singleton_output_tuple;  // result of aggregation w/o GROUP BY
     boost::scoped_ptr<MemPool> _tuple_pool;
 
+    /// Results of the calls shared by the grouping exprs and the aggregate inputs, NULL
+    /// if there are none.
+    SubExprCache* _subexpr_cache;
+
     /// IR for process row batch.  NULL if codegen is disabled.
     llvm::Function* _codegen_process_row_batch_fn;
 
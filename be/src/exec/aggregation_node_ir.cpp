@@ -21,6 +21,7 @@
 #include "exec/aggregation_node.h"
 
 #include "exec/hash_table.hpp"
+#include "exprs/subexpr_cache.h"
 #include "runtime/row_batch.h"
 #include "runtime/runtime_state.h"
 #include "runtime/tuple.h"
@@ -30,13 +31,16 @@ namespace palo {
 
 void AggregationNode::process_row_batch_no_grouping(RowBatch* batch, MemPool* pool) {
     for (int i = 0; i < batch->num_rows(); ++i) {
-        update_tuple(_singleton_output_tuple, batch->get_row(i));
+        TupleRow* row = batch->get_row(i);
+        SubExprCache::RowScope scope(_subexpr_cache, row);
+        update_tuple(_singleton_output_tuple, row);
     }
 }
 
 void AggregationNode::process_row_batch_with_grouping(RowBatch* batch, MemPool* pool) {
     for (int i = 0; i < batch->num_rows(); ++i) {
         TupleRow* row = batch->get_row(i);
+        SubExprCache::RowScope scope(_subexpr_cache, row);
         Tuple* agg_tuple = NULL;
         HashTable::Iterator it = _hash_tbl->find(row);
 
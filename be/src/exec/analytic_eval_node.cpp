@@ -51,6 +51,8 @@ AnalyticEvalNode::AnalyticEvalNode(ObjectPool* pool, const TPlanNode& tnode,
         _has_first_val_null_offset(false),
         _first_val_null_offset(0),
         _last_result_idx(-1),
+        _back_stack_tuple(NULL),
+        _num_back_stack_rows(0),
         _prev_pool_last_result_idx(-1),
         _prev_pool_last_window_idx(-1),
         _curr_tuple(NULL),
@@ -148,6 +150,7 @@ Status AnalyticEvalNode::init(const TPlanNode& tnode) {
 
 Status AnalyticEvalNode::prepare(RuntimeState* state) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(ExecNode::prepare(state));
     DCHECK(child(0)->row_desc().is_prefix_of(row_desc()));
     _child_tuple_desc = child(0)->row_desc().tuple_descriptors()[0];
@@ -166,6 +169,20 @@ Status AnalyticEvalNode::prepare(RuntimeState* state) {
                 mem_tracker(), &ctx));
         _fn_ctxs.push_back(ctx);
         state->obj_pool()->add(ctx);
+
+        bool uses_window_stacks = _fn_scope == ROWS && _window.__isset.window_start
+                && !_evaluators[i]->supports_remove();
+        if (uses_window_stacks) {
+            const SlotDescriptor* slot_desc = _intermediate_tuple_desc->slots()[i];
+            if (!_evaluators[i]->supports_merge() || slot_desc->type().is_string_type()) {
+                std::stringstream ss;
+                ss << "Analytic function " << _evaluators[i]->fn_name()
+                   << " is not supported with a ROWS window start bound.";
+                return Status(ss.str());
+            }
+            _window_stack_fns.push_back(i);
+        }
+        _uses_window_stacks.push_back(uses_window_stacks);
     }
 
     if (_partition_by_eq_expr_ctx != NULL || _order_by_eq_expr_ctx != NULL) {
@@ -195,6 +212,7 @@ Status AnalyticEvalNode::prepare(RuntimeState* state) {
 
 Status AnalyticEvalNode::open(RuntimeState* state) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(ExecNode::open(state));
     RETURN_IF_CANCELLED(state);
     //RETURN_IF_ERROR(QueryMaintenance(state));
@@ -228,6 +246,9 @@ Status AnalyticEvalNode::open(RuntimeState* state) {
     _curr_tuple = Tuple::create(_intermediate_tuple_desc->byte_size(), _mem_pool.get());
     AggFnEvaluator::init(_evaluators, _fn_ctxs, _curr_tuple);
     _dummy_result_tuple = Tuple::create(_result_tuple_desc->byte_size(), _mem_pool.get());
+    if (!_window_stack_fns.empty()) {
+        _back_stack_tuple = Tuple::create(_intermediate_tuple_desc->byte_size(), _mem_pool.get());
+    }
 
     // Initialize state for the first partition.
     init_next_partition(0);
@@ -379,6 +400,9 @@ void AnalyticEvalNode::add_result_tuple(int64_t stream_idx) {
     Tuple* result_tuple = Tuple::create(_result_tuple_desc->byte_size(),
                                         _curr_tuple_pool.get());
 
+    if (!_window_stack_fns.empty()) {
+        materialize_window_stacks();
+    }
     AggFnEvaluator::get_value(_evaluators, _fn_ctxs, _curr_tuple, result_tuple);
     DCHECK_GT(stream_idx, _last_result_idx);
     _result_tuples.push_back(std::pair<int64_t, Tuple*>(stream_idx, result_tuple));
@@ -438,7 +462,7 @@ inline void AnalyticEvalNode::try_remove_rows_before_window(int64_t stream_idx)
     DCHECK_EQ(remove_idx + std::max(_rows_start_offset, 0L), _window_tuples.front().first)
             << debug_state_string(true);
     TupleRow* remove_row = reinterpret_cast<TupleRow*>(&_window_tuples.front().second);
-    AggFnEvaluator::remove(_evaluators, _fn_ctxs, remove_row, _curr_tuple);
+    remove_window_row(remove_row);
     _window_tuples.pop_front();
 }
 
@@ -484,7 +508,7 @@ inline void AnalyticEvalNode::try_add_remaining_results(int64_t partition_idx,
             VLOG_ROW << id() << " Remove window_row_idx=" << _window_tuples.front().first
                      << " for result row at idx=" << next_result_idx;
             TupleRow* remove_row = reinterpret_cast<TupleRow*>(&_window_tuples.front().second);
-            AggFnEvaluator::remove(_evaluators, _fn_ctxs, remove_row, _curr_tuple);
+            remove_window_row(remove_row);
             _window_tuples.pop_front();
         }
 
@@ -547,6 +571,7 @@ inline void AnalyticEvalNode::init_next_partition(int64_t stream_idx) {
     }
 
     _window_tuples.clear();
+    reset_window_stacks();
 
     // Re-initialize _curr_tuple.
     VLOG_ROW << id() << " Reset curr_tuple";
@@ -584,6 +609,116 @@ inline void AnalyticEvalNode::init_next_partition(int64_t stream_idx) {
     }
 }
 
+inline void AnalyticEvalNode::add_window_row(TupleRow* row) {
+    if (_window_stack_fns.empty()) {
+        AggFnEvaluator::add(_evaluators, _fn_ctxs, row, _curr_tuple);
+        return;
+    }
+
+    for (int i = 0; i < _evaluators.size(); ++i) {
+        _evaluators[i]->add(_fn_ctxs[i], row,
+                            _uses_window_stacks[i] ? _back_stack_tuple : _curr_tuple);
+    }
+    ++_num_back_stack_rows;
+}
+
+inline void AnalyticEvalNode::remove_window_row(TupleRow* row) {
+    if (_window_stack_fns.empty()) {
+        AggFnEvaluator::remove(_evaluators, _fn_ctxs, row, _curr_tuple);
+        return;
+    }
+
+    for (int i = 0; i < _evaluators.size(); ++i) {
+        if (!_uses_window_stacks[i]) {
+            _evaluators[i]->remove(_fn_ctxs[i], row, _curr_tuple);
+        }
+    }
+    if (_front_stack_tuples.empty()) {
+        flip_window_stacks();
+    }
+    DCHECK(!_front_stack_tuples.empty());
+    _free_stack_tuples.push_back(_front_stack_tuples.back());
+    _front_stack_tuples.pop_back();
+}
+
+void AnalyticEvalNode::flip_window_stacks() {
+    DCHECK(_front_stack_tuples.empty());
+    DCHECK_EQ(_num_back_stack_rows, _window_tuples.size()) << debug_state_string(true);
+    VLOG_ROW << id() << " Flip " << _num_back_stack_rows << " rows to the front stack";
+
+    // Walk from the newest to the oldest row, so the aggregate of each row is the one of
+    // the row after it plus the row itself.
+    Tuple* next_tuple = NULL;
+    for (std::list<std::pair<int64_t, Tuple*> >::reverse_iterator it = _window_tuples.rbegin();
+            it != _window_tuples.rend(); ++it) {
+        Tuple* stack_tuple = NULL;
+        if (_free_stack_tuples.empty()) {
+            stack_tuple = Tuple::create(_intermediate_tuple_desc->byte_size(), _mem_pool.get());
+        } else {
+            stack_tuple = _free_stack_tuples.back();
+            _free_stack_tuples.pop_back();
+        }
+
+        TupleRow* row = reinterpret_cast<TupleRow*>(&it->second);
+        for (int j = 0; j < _window_stack_fns.size(); ++j) {
+            int i = _window_stack_fns[j];
+            if (next_tuple == NULL) {
+                _evaluators[i]->init(_fn_ctxs[i], stack_tuple);
+            } else {
+                copy_intermediate_slot(i, next_tuple, stack_tuple);
+            }
+            _evaluators[i]->add(_fn_ctxs[i], row, stack_tuple);
+        }
+        _front_stack_tuples.push_back(stack_tuple);
+        next_tuple = stack_tuple;
+    }
+
+    for (int j = 0; j < _window_stack_fns.size(); ++j) {
+        int i = _window_stack_fns[j];
+        _evaluators[i]->init(_fn_ctxs[i], _back_stack_tuple);
+    }
+    _num_back_stack_rows = 0;
+}
+
+void AnalyticEvalNode::reset_window_stacks() {
+    if (_window_stack_fns.empty()) {
+        return;
+    }
+    _free_stack_tuples.insert(_free_stack_tuples.end(),
+                              _front_stack_tuples.begin(), _front_stack_tuples.end());
+    _front_stack_tuples.clear();
+    for (int j = 0; j < _window_stack_fns.size(); ++j) {
+        int i = _window_stack_fns[j];
+        _evaluators[i]->init(_fn_ctxs[i], _back_stack_tuple);
+    }
+    _num_back_stack_rows = 0;
+}
+
+void AnalyticEvalNode::materialize_window_stacks() {
+    for (int j = 0; j < _window_stack_fns.size(); ++j) {
+        int i = _window_stack_fns[j];
+        if (_front_stack_tuples.empty()) {
+            copy_intermediate_slot(i, _back_stack_tuple, _curr_tuple);
+        } else {
+            copy_intermediate_slot(i, _front_stack_tuples.back(), _curr_tuple);
+            if (_num_back_stack_rows > 0) {
+                _evaluators[i]->merge(_fn_ctxs[i], _back_stack_tuple, _curr_tuple);
+            }
+        }
+    }
+}
+
+inline void AnalyticEvalNode::copy_intermediate_slot(int i, const Tuple* src, Tuple* dst) {
+    const SlotDescriptor* slot_desc = _intermediate_tuple_desc->slots()[i];
+    if (src->is_null(slot_desc->null_indicator_offset())) {
+        dst->set_null(slot_desc->null_indicator_offset());
+        return;
+    }
+    dst->set_not_null(slot_desc->null_indicator_offset());
+    memcpy(dst->get_slot(slot_desc->tuple_offset()), src->get_slot(slot_desc->tuple_offset()),
+           slot_desc->type().get_slot_size());
+}
+
 inline bool AnalyticEvalNode::prev_row_compare(ExprContext* pred_ctx) {
     DCHECK(pred_ctx != NULL);
     palo_udf::BooleanVal result = pred_ctx->get_boolean_val(_child_tuple_cmp_row);
@@ -665,7 +800,7 @@ Status AnalyticEvalNode::process_child_batch(RuntimeState* state) {
         if (_fn_scope != ROWS || !_window.__isset.window_start ||
                 stream_idx - _rows_start_offset >= _curr_partition_idx) {
             VLOG_ROW << id() << " Update idx=" << stream_idx;
-            AggFnEvaluator::add(_evaluators, _fn_ctxs, row, _curr_tuple);
+            add_window_row(row);
 
             if (_window.__isset.window_start) {
                 VLOG_ROW << id() << " Adding tuple to window at idx=" << stream_idx;
@@ -803,6 +938,7 @@ inline int64_t AnalyticEvalNode::num_output_rows_ready() const {
 
 Status AnalyticEvalNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
     RETURN_IF_CANCELLED(state);
     //RETURN_IF_ERROR(QueryMaintenance(state));
@@ -112,6 +112,8 @@ private:
         // window (by calling AggFnEvaluator::Remove() with the expired tuple to remove it
         // from the current row). When either the start or end boundaries are offset from the
         // current row, there is special casing around partition boundaries.
+        // Functions that cannot Remove() rows (e.g. min/max) are evaluated over such windows
+        // with two stacks of intermediate tuples instead, see _window_stack_fns.
         ROWS
     };
 
@@ -158,6 +160,29 @@ private:
     // current input row from _input_stream.
     void init_next_partition(int64_t stream_idx);
 
+    // Adds the input row to the window of all evaluators, i.e. to _curr_tuple and, for
+    // the evaluators in _window_stack_fns, to the back stack.
+    void add_window_row(TupleRow* row);
+
+    // Removes the oldest row of the window from all evaluators. 'row' must be the row at
+    // the front of _window_tuples.
+    void remove_window_row(TupleRow* row);
+
+    // Moves all rows of the back stack to the front stack, computing the aggregate of
+    // every row and all rows after it in the window. Only called if the front stack is
+    // empty.
+    void flip_window_stacks();
+
+    // Empties both stacks at the start of a new partition.
+    void reset_window_stacks();
+
+    // Writes the aggregate over the current window of the evaluators in
+    // _window_stack_fns to their intermediate slots in _curr_tuple.
+    void materialize_window_stacks();
+
+    // Copies the intermediate slot of the i-th evaluator from 'src' to 'dst'.
+    void copy_intermediate_slot(int i, const Tuple* src, Tuple* dst);
+
     // Produces a result tuple with analytic function results by calling GetValue() or
     // Finalize() for _curr_tuple on the _evaluators. The result tuple is stored in
     // _result_tuples with the index into _input_stream specified by stream_idx.
@@ -261,6 +286,25 @@ private:
     std::list<std::pair<int64_t, Tuple*> > _window_tuples;
     TupleDescriptor* _child_tuple_desc;
 
+    // Indexes into _evaluators of the functions without Remove() that are evaluated over a
+    // ROWS window with a start bound. Their window aggregate is kept in two stacks, which
+    // needs O(1) amortized Add()/Merge() calls per row for any function with a Merge():
+    // the back stack holds the newest rows of _window_tuples, of which only the aggregate
+    // _back_stack_tuple is stored. The front stack holds the oldest rows, and for each
+    // of them the aggregate from that row up to the last row on the front stack, the
+    // oldest row being at the back of _front_stack_tuples. Removing a row pops it from the
+    // front stack, which is refilled from the back stack once empty. The window aggregate
+    // is the merge of the top of the front stack and _back_stack_tuple.
+    // Only the intermediate slots of these evaluators are used in the stack tuples.
+    std::vector<int> _window_stack_fns;
+    std::vector<bool> _uses_window_stacks;
+    std::vector<Tuple*> _front_stack_tuples;
+    Tuple* _back_stack_tuple;
+    int64_t _num_back_stack_rows;
+
+    // Stack tuples that are no longer used, reused before allocating from _mem_pool.
+    std::vector<Tuple*> _free_stack_tuples;
+
     // Pools used to allocate result tuples (added to _result_tuples and later returned)
     // and window tuples (added to _window_tuples to buffer the current window). Resources
     // are transferred from _curr_tuple_pool to _prev_tuple_pool once it is at least
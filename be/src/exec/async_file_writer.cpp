@@ -0,0 +1,229 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "exec/async_file_writer.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include <lz4/lz4frame.h>
+#include <zstd/zstd.h>
+
+#include "common/logging.h"
+#include "util/stopwatch.hpp"
+
+namespace palo {
+
+// zstd's own default, a good deal faster than gzip at a better ratio
+static const int ZSTD_COMPRESSION_LEVEL = 3;
+
+AsyncFileWriter::AsyncFileWriter(FileWriter* file_writer, TCompressKind::type compress_kind,
+                                 size_t chunk_size, int max_pending_chunks) :
+        _file_writer(file_writer),
+        _compress_kind(compress_kind),
+        _chunk_size(std::max<size_t>(chunk_size, 1)),
+        _max_pending_chunks(std::max(max_pending_chunks, 1)),
+        _eos(false),
+        _status(Status::OK),
+        _opened(false),
+        _finished(false),
+        _bytes_written(0),
+        _write_time_ns(0) {
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+    close();
+}
+
+std::string AsyncFileWriter::file_suffix(TCompressKind::type compress_kind) {
+    switch (compress_kind) {
+    case TCompressKind::LZ4:
+        return ".lz4";
+    case TCompressKind::ZSTD:
+        return ".zst";
+    default:
+        return "";
+    }
+}
+
+Status AsyncFileWriter::open() {
+    if (_compress_kind != TCompressKind::NONE
+            && _compress_kind != TCompressKind::LZ4
+            && _compress_kind != TCompressKind::ZSTD) {
+        std::stringstream ss;
+        ss << "Unsupported compression of written files, compress_kind=" << _compress_kind;
+        return Status(ss.str());
+    }
+    RETURN_IF_ERROR(_file_writer->open());
+    _chunk.reserve(_chunk_size);
+    _write_thread = std::thread(&AsyncFileWriter::write_loop, this);
+    _opened = true;
+    return Status::OK;
+}
+
+Status AsyncFileWriter::write(const uint8_t* buf, size_t buf_len, size_t* written_len) {
+    DCHECK(_opened && !_finished);
+    *written_len = 0;
+    while (*written_len < buf_len) {
+        size_t len = std::min(buf_len - *written_len, _chunk_size - _chunk.size());
+        _chunk.append(reinterpret_cast<const char*>(buf) + *written_len, len);
+        *written_len += len;
+        if (_chunk.size() >= _chunk_size) {
+            RETURN_IF_ERROR(push_chunk());
+        }
+    }
+    return Status::OK;
+}
+
+Status AsyncFileWriter::push_chunk() {
+    std::unique_lock<std::mutex> l(_lock);
+    while (_status.ok() && _pending.size() >= _max_pending_chunks) {
+        _cond.wait(l);
+    }
+    RETURN_IF_ERROR(_status);
+    _pending.push_back(std::move(_chunk));
+    _cond.notify_all();
+    l.unlock();
+
+    _chunk.clear();
+    _chunk.reserve(_chunk_size);
+    return Status::OK;
+}
+
+Status AsyncFileWriter::finish() {
+    if (_finished) {
+        return _status;
+    }
+    _finished = true;
+    if (!_opened) {
+        _file_writer->close();
+        return _status;
+    }
+    if (!_chunk.empty()) {
+        // an error is kept in _status as well
+        push_chunk();
+    }
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        _eos = true;
+        _cond.notify_all();
+    }
+    _write_thread.join();
+    _file_writer->close();
+    _chunk.clear();
+    _chunk.shrink_to_fit();
+    return _status;
+}
+
+void AsyncFileWriter::close() {
+    Status status = finish();
+    if (!status.ok()) {
+        LOG(WARNING) << "Failed to write file: " << status.get_error_msg();
+    }
+}
+
+void AsyncFileWriter::write_loop() {
+    while (true) {
+        std::string chunk;
+        {
+            std::unique_lock<std::mutex> l(_lock);
+            while (_pending.empty() && !_eos) {
+                _cond.wait(l);
+            }
+            if (_pending.empty()) {
+                return;
+            }
+            chunk = std::move(_pending.front());
+            _pending.pop_front();
+            _cond.notify_all();
+        }
+
+        const uint8_t* data = nullptr;
+        size_t len = 0;
+        Status status = compress(chunk, &data, &len);
+        if (status.ok()) {
+            MonotonicStopWatch watch;
+            watch.start();
+            status = write_fully(data, len);
+            _write_time_ns += watch.elapsed_time();
+        }
+        if (!status.ok()) {
+            std::lock_guard<std::mutex> l(_lock);
+            _status = status;
+            _pending.clear();
+            _cond.notify_all();
+            return;
+        }
+        _bytes_written += len;
+    }
+}
+
+Status AsyncFileWriter::compress(const std::string& chunk, const uint8_t** data, size_t* len) {
+    switch (_compress_kind) {
+    case TCompressKind::LZ4: {
+        LZ4F_preferences_t prefs;
+        memset(&prefs, 0, sizeof(prefs));
+        // independent blocks can be decoded in parallel by the load decompressor
+        prefs.frameInfo.blockMode = LZ4F_blockIndependent;
+        prefs.frameInfo.contentSize = chunk.size();
+        _compressed.resize(LZ4F_compressFrameBound(chunk.size(), &prefs));
+        size_t ret = LZ4F_compressFrame(&_compressed[0], _compressed.size(),
+                                        chunk.data(), chunk.size(), &prefs);
+        if (LZ4F_isError(ret)) {
+            std::stringstream ss;
+            ss << "Failed to compress lz4 frame: " << LZ4F_getErrorName(ret);
+            return Status(ss.str());
+        }
+        *data = reinterpret_cast<const uint8_t*>(_compressed.data());
+        *len = ret;
+        return Status::OK;
+    }
+    case TCompressKind::ZSTD: {
+        _compressed.resize(ZSTD_compressBound(chunk.size()));
+        size_t ret = ZSTD_compress(&_compressed[0], _compressed.size(),
+                                   chunk.data(), chunk.size(), ZSTD_COMPRESSION_LEVEL);
+        if (ZSTD_isError(ret)) {
+            std::stringstream ss;
+            ss << "Failed to compress zstd frame: " << ZSTD_getErrorName(ret);
+            return Status(ss.str());
+        }
+        *data = reinterpret_cast<const uint8_t*>(_compressed.data());
+        *len = ret;
+        return Status::OK;
+    }
+    default:
+        *data = reinterpret_cast<const uint8_t*>(chunk.data());
+        *len = chunk.size();
+        return Status::OK;
+    }
+}
+
+Status AsyncFileWriter::write_fully(const uint8_t* data, size_t len) {
+    while (len > 0) {
+        size_t written_len = 0;
+        RETURN_IF_ERROR(_file_writer->write(data, len, &written_len));
+        if (written_len == 0) {
+            return Status("Failed to write file, no byte was written");
+        }
+        data += written_len;
+        len -= written_len;
+    }
+    return Status::OK;
+}
+
+} // end namespace palo
@@ -0,0 +1,114 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef BDG_PALO_BE_SRC_EXEC_ASYNC_FILE_WRITER_H
+#define BDG_PALO_BE_SRC_EXEC_ASYNC_FILE_WRITER_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "common/status.h"
+#include "exec/file_writer.h"
+#include "gen_cpp/Types_types.h"
+
+namespace palo {
+
+// Writes to another file writer on a thread of its own, so that the caller can go on
+// producing data while the earlier data is written.
+//
+// write() collects the data in chunks of 'chunk_size' bytes, a full chunk is handed to
+// the write thread. At most 'max_pending_chunks' chunks wait to be written, beyond
+// that write() blocks. If 'compress_kind' is LZ4 or ZSTD, each chunk is compressed into
+// a frame of its own on the write thread, the concatenated frames make a valid file of
+// that format. An error of the write thread is returned by the next write() or by
+// finish().
+class AsyncFileWriter : public FileWriter {
+public:
+    // Takes the ownership of 'file_writer', which must not be opened yet.
+    AsyncFileWriter(FileWriter* file_writer, TCompressKind::type compress_kind,
+                    size_t chunk_size, int max_pending_chunks);
+
+    virtual ~AsyncFileWriter();
+
+    virtual Status open() override;
+
+    virtual Status write(const uint8_t* buf, size_t buf_len, size_t* written_len) override;
+
+    // Writes all the data, closes the file and returns the first error.
+    Status finish();
+
+    // Like finish(), but errors are only logged.
+    virtual void close() override;
+
+    // Bytes written to the file, after the compression.
+    int64_t bytes_written() const {
+        return _bytes_written;
+    }
+
+    // Time the write thread spent in the underlying writer.
+    int64_t write_time_ns() const {
+        return _write_time_ns;
+    }
+
+    // Returns the suffix of the files compressed with 'compress_kind', e.g. ".zst".
+    static std::string file_suffix(TCompressKind::type compress_kind);
+
+private:
+    // Hands the current chunk to the write thread, waits for room if necessary.
+    Status push_chunk();
+
+    void write_loop();
+
+    // Compresses 'chunk' into '_compressed' and points 'data' and 'len' to the result.
+    Status compress(const std::string& chunk, const uint8_t** data, size_t* len);
+
+    Status write_fully(const uint8_t* data, size_t len);
+
+    std::unique_ptr<FileWriter> _file_writer;
+    const TCompressKind::type _compress_kind;
+    const size_t _chunk_size;
+    const size_t _max_pending_chunks;
+
+    // The chunk being filled by write()
+    std::string _chunk;
+    // Used by the write thread only
+    std::string _compressed;
+
+    std::mutex _lock;
+    // Notified when a chunk is queued or taken, when the input is done and on errors.
+    std::condition_variable _cond;
+    std::deque<std::string> _pending;
+    bool _eos;
+    Status _status;
+
+    std::thread _write_thread;
+    bool _opened;
+    bool _finished;
+
+    std::atomic<int64_t> _bytes_written;
+    std::atomic<int64_t> _write_time_ns;
+};
+
+} // end namespace palo
+
+#endif // BDG_PALO_BE_SRC_EXEC_ASYNC_FILE_WRITER_H
@@ -25,6 +25,7 @@
 #include "exprs/expr.h"
 #include "runtime/row_batch.h"
 #include "runtime/runtime_state.h"
+#include "util/blocking_aware_thread_pool.h"
 #include "util/debug_util.h"
 #include "util/runtime_profile.h"
 #include "gen_cpp/PlanNodes_types.h"
@@ -54,6 +55,7 @@ BlockingJoinNode::~BlockingJoinNode() {
 
 Status BlockingJoinNode::prepare(RuntimeState* state) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(ExecNode::prepare(state));
 
     _build_pool.reset(new MemPool(mem_tracker()));
@@ -103,6 +105,7 @@ void BlockingJoinNode::build_side_thread(RuntimeState* state, boost::promise<Sta
 Status BlockingJoinNode::open(RuntimeState* state) {
     RETURN_IF_ERROR(ExecNode::open(state));
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     // RETURN_IF_ERROR(Expr::open(_conjuncts, state));
 
     RETURN_IF_CANCELLED(state);
@@ -138,7 +141,12 @@ Status BlockingJoinNode::open(RuntimeState* state) {
 
     // Blocks until ConstructBuildSide has returned, after which the build side structures
     // are fully constructed.
-    RETURN_IF_ERROR(build_side_status.get_future().get());
+    boost::unique_future<Status> build_side_status_future = build_side_status.get_future();
+    {
+        BlockingAwareThreadPool::ScopedBlocking blocking;
+        build_side_status_future.wait();
+    }
+    RETURN_IF_ERROR(build_side_status_future.get());
     // We can close the right child to release its resources because its input has been
     // fully consumed.
     child(1)->close(state);
@@ -127,6 +127,7 @@ private:
     void create_output_row(TupleRow* out_row, TupleRow* left_row, TupleRow* build_row);
 
     friend class CrossJoinNode;
+    friend class PartitionedHashJoinNode;
 private:
     // Supervises ConstructBuildSide in a separate thread, and returns its status in the
     // promise parameter.
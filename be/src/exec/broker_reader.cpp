@@ -15,8 +15,10 @@
 
 #include "exec/broker_reader.h"
 
+#include <algorithm>
 #include <sstream>
 
+#include "common/config.h"
 #include "common/logging.h"
 #include "gen_cpp/PaloBrokerService_types.h"
 #include "gen_cpp/TPaloBrokerService.h"
@@ -43,7 +45,12 @@ BrokerReader::BrokerReader(
             _cur_offset(start_offset),
             _is_fd_valid(false),
             _eof(false),
-            _addr_idx(0) {
+            _addr_idx(0),
+            _prefetch_depth(0),
+            _prefetch_chunk_size(0),
+            _next_chunk_offset(start_offset),
+            _prefetch_eof(false),
+            _stop_prefetch(false) {
 }
 
 BrokerReader::~BrokerReader() {
@@ -61,12 +68,17 @@ inline const std::string& client_id(RuntimeState* state, const TNetworkAddress&
     return s_client_id;
 }
 #else
+// state is NULL when used outside of a query, e.g. by backup tasks
+inline ExecEnv* exec_env(RuntimeState* state) {
+    return state != NULL ? state->exec_env() : ExecEnv::GetInstance();
+}
+
 inline BrokerServiceClientCache* client_cache(RuntimeState* state) {
-    return state->exec_env()->broker_client_cache();
+    return exec_env(state)->broker_client_cache();
 }
 
 inline const std::string& client_id(RuntimeState* state, const TNetworkAddress& addr) {
-    return state->exec_env()->broker_mgr()->get_client_id(addr);
+    return exec_env(state)->broker_mgr()->get_client_id(addr);
 }
 #endif
 
@@ -114,21 +126,211 @@ Status BrokerReader::open() {
 
     _fd = response.fd;
     _is_fd_valid = true;
+
+    // Read ahead while the caller parses what it got
+    _prefetch_depth = std::max(config::broker_reader_prefetch_depth, 0);
+    _prefetch_chunk_size = std::max(config::broker_reader_prefetch_chunk_kb, 1) * 1024L;
+    _next_chunk_offset = _cur_offset;
     return Status::OK;
 }
 
 Status BrokerReader::read(uint8_t* buf, size_t* buf_len, bool* eof) {
+    if (_prefetch_depth > 0) {
+        if (_prefetch_threads.empty()) {
+            for (int i = 0; i < _prefetch_depth; ++i) {
+                _prefetch_threads.emplace_back(&BrokerReader::prefetch_worker, this);
+            }
+        }
+        return read_prefetched(buf, buf_len, eof);
+    }
+    if (_eof) {
+        *eof = true;
+        return Status::OK;
+    }
+
+    std::string data;
+    RETURN_IF_ERROR(pread(_cur_offset, *buf_len, &data, &_eof));
     if (_eof) {
         *eof = true;
         return Status::OK;
     }
-    
+
+    *buf_len = data.size();
+    memcpy(buf, data.data(), *buf_len);
+    _cur_offset += *buf_len; 
+    *eof = false;
+
+    return Status::OK;
+}
+
+Status BrokerReader::readat(int64_t position, int64_t nbytes, int64_t* bytes_read,
+                            void* out) {
+    *bytes_read = 0;
+    while (*bytes_read < nbytes) {
+        std::string data;
+        bool eof = false;
+        RETURN_IF_ERROR(pread(position + *bytes_read, nbytes - *bytes_read, &data, &eof));
+        if (eof || data.empty()) {
+            break;
+        }
+        size_t len = std::min<int64_t>(data.size(), nbytes - *bytes_read);
+        memcpy((uint8_t*)out + *bytes_read, data.data(), len);
+        *bytes_read += len;
+    }
+    return Status::OK;
+}
+
+Status BrokerReader::size(int64_t* size) {
+    const TNetworkAddress& broker_addr = _addresses[_addr_idx];
+    TBrokerListPathRequest request;
+    request.__set_version(TBrokerVersion::VERSION_ONE);
+    request.__set_path(_path);
+    request.__set_isRecursive(false);
+    request.__set_properties(_properties);
+
+    TBrokerListResponse response;
+    try {
+        Status status;
+        // 500ms is enough
+        BrokerServiceConnection client(client_cache(_state), broker_addr, 500, &status);
+        if (!status.ok()) {
+            LOG(WARNING) << "Create broker client failed. broker=" << broker_addr
+                << ", status=" << status.get_error_msg();
+            return status;
+        }
+
+        try {
+            client->listPath(response, request);
+        } catch (apache::thrift::transport::TTransportException& e) {
+            RETURN_IF_ERROR(client.reopen());
+            client->listPath(response, request);
+        }
+    } catch (apache::thrift::TException& e) {
+        std::stringstream ss;
+        ss << "Get file size from broker failed, broker:" << broker_addr
+            << " failed:" << e.what();
+        LOG(WARNING) << ss.str();
+        return Status(TStatusCode::THRIFT_RPC_ERROR, ss.str(), false);
+    }
+
+    if (response.opStatus.statusCode != TBrokerOperationStatusCode::OK) {
+        std::stringstream ss;
+        ss << "Get file size from broker failed, broker:" << broker_addr 
+            << " failed:" << response.opStatus.message;
+        LOG(WARNING) << ss.str();
+        return Status(ss.str());
+    }
+    if (response.files.size() != 1 || response.files[0].isDir) {
+        std::stringstream ss;
+        ss << "Broker path is not a file, path=" << _path;
+        return Status(ss.str());
+    }
+    *size = response.files[0].size;
+    return Status::OK;
+}
+
+Status BrokerReader::read_prefetched(uint8_t* buf, size_t* buf_len, bool* eof) {
+    std::unique_lock<std::mutex> l(_chunks_lock);
+    while (true) {
+        while ((_chunks.empty() && !_prefetch_eof)
+                || (!_chunks.empty() && !_chunks.front()->ready)) {
+            _chunks_cond.wait(l);
+        }
+        if (_chunks.empty()) {
+            *buf_len = 0;
+            *eof = true;
+            return Status::OK;
+        }
+        Chunk* chunk = _chunks.front().get();
+        RETURN_IF_ERROR(chunk->status);
+        if (chunk->pos < chunk->data.size()) {
+            size_t len = std::min(*buf_len, chunk->data.size() - chunk->pos);
+            memcpy(buf, chunk->data.data() + chunk->pos, len);
+            chunk->pos += len;
+            _cur_offset += len;
+            if (chunk->pos == chunk->data.size() && !chunk->eof) {
+                _chunks.pop_front();
+                _chunks_cond.notify_all();
+            }
+            *buf_len = len;
+            *eof = false;
+            return Status::OK;
+        }
+        if (chunk->eof) {
+            // the chunks behind it are past the end of the file
+            *buf_len = 0;
+            *eof = true;
+            return Status::OK;
+        }
+        _chunks.pop_front();
+        _chunks_cond.notify_all();
+    }
+}
+
+void BrokerReader::prefetch_worker() {
+    std::unique_lock<std::mutex> l(_chunks_lock);
+    while (true) {
+        while (!_stop_prefetch && !_prefetch_eof && _chunks.size() >= (size_t)_prefetch_depth) {
+            _chunks_cond.wait(l);
+        }
+        if (_stop_prefetch || _prefetch_eof) {
+            break;
+        }
+        std::shared_ptr<Chunk> chunk(new Chunk(_next_chunk_offset, _prefetch_chunk_size));
+        _next_chunk_offset += chunk->length;
+        _chunks.push_back(chunk);
+        l.unlock();
+
+        // The broker may return less than asked for, the chunk is filled up so that it
+        // ends where the next one begins.
+        Status status;
+        bool eof = false;
+        while (status.ok() && !eof && chunk->data.size() < chunk->length) {
+            std::string data;
+            status = pread(chunk->offset + chunk->data.size(),
+                           chunk->length - chunk->data.size(), &data, &eof);
+            if (status.ok() && !eof && data.empty()) {
+                LOG(WARNING) << "Broker returned no data before the end of file " << _path
+                    << " at offset " << chunk->offset + chunk->data.size();
+                eof = true;
+            }
+            if (chunk->data.empty()) {
+                chunk->data.swap(data);
+            } else {
+                chunk->data.append(data);
+            }
+        }
+
+        l.lock();
+        chunk->status = status;
+        chunk->eof = eof;
+        chunk->ready = true;
+        if (!status.ok() || eof) {
+            _prefetch_eof = true;
+        }
+        _chunks_cond.notify_all();
+    }
+}
+
+void BrokerReader::stop_prefetch() {
+    {
+        std::lock_guard<std::mutex> l(_chunks_lock);
+        _stop_prefetch = true;
+    }
+    _chunks_cond.notify_all();
+    for (auto& thread : _prefetch_threads) {
+        thread.join();
+    }
+    _prefetch_threads.clear();
+}
+
+Status BrokerReader::pread(int64_t offset, size_t length, std::string* data, bool* eof) {
     const TNetworkAddress& broker_addr = _addresses[_addr_idx];
     TBrokerPReadRequest request;
     request.__set_version(TBrokerVersion::VERSION_ONE);
     request.__set_fd(_fd);
-    request.__set_offset(_cur_offset);
-    request.__set_length(*buf_len);
+    request.__set_offset(offset);
+    request.__set_length(length);
 
     TBrokerReadResponse response;
     try {
@@ -157,7 +359,7 @@ Status BrokerReader::read(uint8_t* buf, size_t* buf_len, bool* eof) {
 
     if (response.opStatus.statusCode == TBrokerOperationStatusCode::END_OF_FILE) {
         // read the end of broker's file
-        *eof = _eof = true;
+        *eof = true;
         return Status::OK;
     } else if (response.opStatus.statusCode != TBrokerOperationStatusCode::OK) {
         std::stringstream ss;
@@ -167,15 +369,14 @@ Status BrokerReader::read(uint8_t* buf, size_t* buf_len, bool* eof) {
         return Status(ss.str());
     }
 
-    *buf_len = response.data.size();
-    memcpy(buf, response.data.data(), *buf_len);
-    _cur_offset += *buf_len; 
+    data->swap(response.data);
     *eof = false;
 
     return Status::OK;
 }
 
 void BrokerReader::close() {
+    stop_prefetch();
     if (!_is_fd_valid) {
         return;
     }
@@ -17,8 +17,14 @@
 
 #include <stdint.h>
 
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <map>
+#include <thread>
+#include <vector>
 
 #include "common/status.h"
 #include "exec/file_reader.h"
@@ -35,6 +41,7 @@ class RuntimeState;
 // Reader of broker file
 class BrokerReader : public FileReader {
 public:
+    // state may be NULL out of a query, the global ExecEnv is used then
     BrokerReader(RuntimeState* state,
                  const std::vector<TNetworkAddress>& broker_addresses,
                  const std::map<std::string, std::string>& properties,
@@ -47,8 +54,41 @@ public:
     // Read 
     virtual Status read(uint8_t* buf, size_t* buf_len, bool* eof) override;
 
+    virtual Status readat(int64_t position, int64_t nbytes, int64_t* bytes_read,
+                          void* out) override;
+
+    // Asks the broker for the size of the file
+    virtual Status size(int64_t* size) override;
+
     virtual void close() override;
 private:
+    // A range of the file read ahead by a prefetch thread
+    struct Chunk {
+        int64_t offset;
+        size_t length;
+        std::string data;
+        // Position of the next byte to hand out
+        size_t pos;
+        bool ready;
+        bool eof;
+        Status status;
+
+        Chunk(int64_t offset_, size_t length_) :
+            offset(offset_), length(length_), pos(0), ready(false), eof(false) { }
+    };
+
+    // Reads up to 'length' bytes at 'offset' with one pread to the broker.
+    Status pread(int64_t offset, size_t length, std::string* data, bool* eof);
+
+    // Fills the next chunks of the file until the reader is closed or the end of the
+    // file is reached.
+    void prefetch_worker();
+
+    // Hands out the bytes of the prefetched chunks in order
+    Status read_prefetched(uint8_t* buf, size_t* buf_len, bool* eof);
+
+    void stop_prefetch();
+
     RuntimeState* _state;
     const std::vector<TNetworkAddress>& _addresses;
     const std::map<std::string, std::string>& _properties;
@@ -61,6 +101,20 @@ private:
     bool _eof;
 
     int _addr_idx;
+
+    // With config::broker_reader_prefetch_depth > 0 that many chunks are read ahead
+    // concurrently, each by one of the prefetch threads. The threads are started by the
+    // first read(), a reader used with readat() only doesn't read ahead.
+    std::mutex _chunks_lock;
+    // Notified when a chunk is filled or consumed
+    std::condition_variable _chunks_cond;
+    std::deque<std::shared_ptr<Chunk>> _chunks;
+    int _prefetch_depth;
+    size_t _prefetch_chunk_size;
+    int64_t _next_chunk_offset;
+    bool _prefetch_eof;
+    bool _stop_prefetch;
+    std::vector<std::thread> _prefetch_threads;
 };
 
 }
@@ -15,9 +15,12 @@
 
 #include "exec/broker_scan_node.h"
 
+#include <algorithm>
 #include <chrono>
 #include <sstream>
 
+#include "codegen/llvm_codegen.h"
+#include "common/config.h"
 #include "common/object_pool.h"
 #include "runtime/runtime_state.h"
 #include "runtime/row_batch.h"
@@ -27,6 +30,8 @@
 #include "util/debug_util.h"
 #include "util/runtime_profile.h"
 
+using llvm::Function;
+
 namespace palo {
 
 BrokerScanNode::BrokerScanNode(
@@ -35,9 +40,11 @@ BrokerScanNode::BrokerScanNode(
             _tuple_id(tnode.broker_scan_node.tuple_id),
             _runtime_state(nullptr),
             _tuple_desc(nullptr),
+            _next_scan_range(0),
             _num_running_scanners(0),
             _scan_finished(false),
             _max_buffered_batches(1024),
+            _eval_conjuncts_fn(nullptr),
             _wait_scanner_timer(nullptr) {
 }
 
@@ -101,6 +108,17 @@ Status BrokerScanNode::prepare(RuntimeState* state) {
         }
     }
 
+    if (state->codegen_level() > 0 && !_conjunct_ctxs.empty()) {
+        LlvmCodeGen* codegen = nullptr;
+        RETURN_IF_ERROR(state->get_codegen(&codegen));
+        Function* codegen_eval_conjuncts_fn = codegen_eval_conjuncts(state, _conjunct_ctxs);
+        if (codegen_eval_conjuncts_fn != nullptr) {
+            // The scanners evaluate clones of _conjunct_ctxs, which run the same code.
+            codegen->add_function_to_jit(codegen_eval_conjuncts_fn,
+                                         reinterpret_cast<void**>(&_eval_conjuncts_fn));
+        }
+    }
+
     // Profile
     _wait_scanner_timer = ADD_TIMER(runtime_profile(), "WaitScannerTime");
 
@@ -109,6 +127,7 @@ Status BrokerScanNode::prepare(RuntimeState* state) {
 
 Status BrokerScanNode::open(RuntimeState* state) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(ExecNode::open(state));
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::OPEN));
     RETURN_IF_CANCELLED(state);
@@ -127,16 +146,22 @@ Status BrokerScanNode::open(RuntimeState* state) {
 }
 
 Status BrokerScanNode::start_scanners() {
+    int num_scanners = std::min<int>(
+        std::max(config::broker_scanner_num_threads, 1), _scan_ranges.size());
+    num_scanners = std::max(num_scanners, 1);
     {
         std::unique_lock<std::mutex> l(_batch_queue_lock);
-        _num_running_scanners = 1;
+        _num_running_scanners = num_scanners;
+    }
+    for (int i = 0; i < num_scanners; ++i) {
+        _scanner_threads.emplace_back(&BrokerScanNode::scanner_worker, this);
     }
-    _scanner_threads.emplace_back(&BrokerScanNode::scanner_worker, this, 0, _scan_ranges.size());
     return Status::OK;
 }
 
 Status BrokerScanNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     // check if CANCELLED.
     if (state->is_cancelled()) {
         std::unique_lock<std::mutex> l(_batch_queue_lock);
@@ -224,6 +249,7 @@ Status BrokerScanNode::close(RuntimeState* state) {
     }
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::CLOSE));
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     _scan_finished.store(true);
     _queue_writer_cond.notify_all();
     _queue_reader_cond.notify_all();
@@ -248,6 +274,7 @@ Status BrokerScanNode::close(RuntimeState* state) {
 // This function is called after plan node has been prepared.
 Status BrokerScanNode::set_scan_ranges(const std::vector<TScanRangeParams>& scan_ranges) {
     _scan_ranges = scan_ranges;
+    split_scan_ranges(config::broker_scan_range_split_mb * 1024 * 1024, &_scan_ranges);
 
     // Now we initialize partition information
     if (_partition_expr_ctxs.size() > 0)  {
@@ -262,6 +289,45 @@ Status BrokerScanNode::set_scan_ranges(const std::vector<TScanRangeParams>& scan
     return Status::OK;
 }
 
+void BrokerScanNode::split_scan_ranges(
+        int64_t split_size, std::vector<TScanRangeParams>* scan_ranges) {
+    if (split_size <= 0) {
+        return;
+    }
+    std::vector<TScanRangeParams> result;
+    for (auto& scan_range : *scan_ranges) {
+        const TBrokerScanRange& broker_scan_range = scan_range.scan_range.broker_scan_range;
+        // The ranges of one scan range are read one after another, the large ones are
+        // moved to scan ranges of their own so that several scanners read them.
+        std::vector<TBrokerRangeDesc> kept_ranges;
+        for (auto& range : broker_scan_range.ranges) {
+            // BrokerScanner realigns a range that doesn't start at the beginning of
+            // the file to the next line, which only works for uncompressed text, and
+            // reads the parquet row groups that start within a range.
+            if ((range.format_type != TFileFormatType::FORMAT_CSV_PLAIN
+                        && range.format_type != TFileFormatType::FORMAT_PARQUET)
+                    || range.size <= split_size) {
+                kept_ranges.push_back(range);
+                continue;
+            }
+            int64_t end_offset = range.start_offset + range.size;
+            for (int64_t offset = range.start_offset; offset < end_offset;
+                    offset += split_size) {
+                TBrokerRangeDesc split_range = range;
+                split_range.start_offset = offset;
+                split_range.size = std::min(split_size, end_offset - offset);
+                result.push_back(scan_range);
+                result.back().scan_range.broker_scan_range.ranges.assign(1, split_range);
+            }
+        }
+        if (!kept_ranges.empty()) {
+            result.push_back(scan_range);
+            result.back().scan_range.broker_scan_range.ranges = kept_ranges;
+        }
+    }
+    scan_ranges->swap(result);
+}
+
 void BrokerScanNode::debug_string(int ident_level, std::stringstream* out) const {
     (*out) << "BrokerScanNode";
 }
@@ -336,7 +402,10 @@ Status BrokerScanNode::scanner_scan(
             }
 
             // eval conjuncts of this row.
-            if (eval_conjuncts(&conjunct_ctxs[0], conjunct_ctxs.size(), row)) {
+            bool passed = (_eval_conjuncts_fn != nullptr)
+                ? _eval_conjuncts_fn(&conjunct_ctxs[0], conjunct_ctxs.size(), row)
+                : eval_conjuncts(&conjunct_ctxs[0], conjunct_ctxs.size(), row);
+            if (passed) {
                 row_batch->commit_last_row();
                 char* new_tuple = reinterpret_cast<char*>(tuple);
                 new_tuple += _tuple_desc->byte_size();
@@ -379,7 +448,7 @@ Status BrokerScanNode::scanner_scan(
     return Status::OK;
 }
 
-void BrokerScanNode::scanner_worker(int start_idx, int length) {
+void BrokerScanNode::scanner_worker() {
     // Clone expr context
     std::vector<ExprContext*> scanner_expr_ctxs;
     auto status = Expr::clone_if_not_exists(_conjunct_ctxs, _runtime_state, &scanner_expr_ctxs);
@@ -395,12 +464,15 @@ void BrokerScanNode::scanner_worker(int start_idx, int length) {
         }
     }
     BrokerScanCounter counter;
-    for (int i = 0; i < length && status.ok(); ++i) {
-        const TBrokerScanRange& scan_range = 
-            _scan_ranges[start_idx + i].scan_range.broker_scan_range;
+    while (status.ok() && !_scan_finished.load()) {
+        int idx = _next_scan_range.fetch_add(1);
+        if (idx >= _scan_ranges.size()) {
+            break;
+        }
+        const TBrokerScanRange& scan_range = _scan_ranges[idx].scan_range.broker_scan_range;
         status = scanner_scan(scan_range, scanner_expr_ctxs, partition_expr_ctxs, &counter);
         if (!status.ok()) {
-            LOG(WARNING) << "Scanner[" << start_idx + i << "] prcess failed. status="
+            LOG(WARNING) << "Scanner[" << idx << "] prcess failed. status="
                 << status.get_error_msg();
         }
     }
@@ -65,6 +65,11 @@ public:
     int64_t get_partition_id(
         const std::vector<ExprContext*>& partition_exprs, TupleRow* row) const;
 
+    // Splits the large uncompressed text and parquet files of 'scan_ranges' into ranges
+    // of at most 'split_size' bytes, each in a scan range of its own.
+    static void split_scan_ranges(int64_t split_size,
+                                  std::vector<TScanRangeParams>* scan_ranges);
+
 protected:
     // Write debug string of this into out.
     virtual void debug_string(int indentation_level, std::stringstream* out) const override;
@@ -83,8 +88,8 @@ private:
     // Create scanners to do scan job
     Status start_scanners();
 
-    // One scanner worker, This scanner will hanle 'length' ranges start from start_idx
-    void scanner_worker(int start_idx, int length);
+    // One scanner worker, scans the ranges that no other worker took yet
+    void scanner_worker();
 
     // Scan one range
     Status scanner_scan(const TBrokerScanRange& scan_range,
@@ -101,6 +106,8 @@ private:
     TupleDescriptor* _tuple_desc;
     std::map<std::string, SlotDescriptor*> _slots_map;
     std::vector<TScanRangeParams> _scan_ranges;
+    // Index of the next scan range a scanner worker takes
+    std::atomic<int> _next_scan_range;
 
     std::mutex _batch_queue_lock;
     std::condition_variable _queue_reader_cond;
@@ -123,6 +130,9 @@ private:
     std::vector<ExprContext*> _partition_expr_ctxs;
     std::vector<PartitionInfo*> _partition_infos;
 
+    // Codegen'd version of eval_conjuncts() for the conjuncts of this node, or nullptr
+    EvalConjunctsFn _eval_conjuncts_fn;
+
     // Profile information
     //
     RuntimeProfile::Counter* _wait_scanner_timer;
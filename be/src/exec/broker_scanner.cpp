@@ -29,6 +29,8 @@
 #include "exec/local_file_reader.h"
 #include "exec/broker_reader.h"
 #include "exec/decompressor.h"
+#include "exec/parquet_reader.h"
+#include "util/sse_util.hpp"
 
 namespace palo {
 
@@ -80,6 +82,7 @@ BrokerScanner::BrokerScanner(RuntimeState* state,
         _line_delimiter(params.line_delimiter),
         _cur_file_reader(nullptr),
         _cur_line_reader(nullptr),
+        _cur_parquet_reader(nullptr),
         _cur_decompressor(nullptr),
         _next_range(0),
         _cur_line_reader_eof(false),
@@ -178,13 +181,27 @@ Status BrokerScanner::get_next(Tuple* tuple, MemPool* tuple_pool, bool* eof) {
     SCOPED_TIMER(_read_timer);
     // Get one line 
     while (!_scanner_eof) {
-        if (_cur_line_reader == nullptr || _cur_line_reader_eof) {
+        if ((_cur_line_reader == nullptr && _cur_parquet_reader == nullptr)
+                || _cur_line_reader_eof) {
             RETURN_IF_ERROR(open_next_reader());
             // If there isn't any more reader, break this
             if (_scanner_eof) {
                 continue;
             }
         }
+        if (_cur_parquet_reader != nullptr) {
+            RETURN_IF_ERROR(_cur_parquet_reader->read_row(&_cur_line_reader_eof));
+            if (_cur_line_reader_eof) {
+                continue;
+            }
+            COUNTER_UPDATE(_rows_read_counter, 1);
+            SCOPED_TIMER(_materialize_timer);
+            if (parquet_row_to_src_tuple()
+                    && fill_dest_tuple(Slice(nullptr, 0), tuple, tuple_pool)) {
+                break;
+            }
+            continue;
+        }
         const uint8_t* ptr = nullptr;
         size_t size = 0;
         RETURN_IF_ERROR(_cur_line_reader->read_line(
@@ -220,7 +237,11 @@ Status BrokerScanner::open_next_reader() {
     }
 
     RETURN_IF_ERROR(open_file_reader());
-    RETURN_IF_ERROR(open_line_reader());
+    if (_ranges[_next_range].format_type == TFileFormatType::FORMAT_PARQUET) {
+        RETURN_IF_ERROR(open_parquet_reader());
+    } else {
+        RETURN_IF_ERROR(open_line_reader());
+    }
     _next_range++;
     
     return Status::OK;
@@ -283,6 +304,9 @@ Status BrokerScanner::create_decompressor(TFileFormatType::type type) {
     case TFileFormatType::FORMAT_CSV_LZOP:
         compress_type = CompressType::LZOP;
         break;
+    case TFileFormatType::FORMAT_CSV_ZSTD:
+        compress_type = CompressType::ZSTD;
+        break;
     default: {
         std::stringstream ss;
         ss << "Unknown format type, type=" << type;
@@ -306,6 +330,11 @@ Status BrokerScanner::open_line_reader() {
         _cur_line_reader = nullptr;
     }
 
+    if (_cur_parquet_reader != nullptr) {
+        delete _cur_parquet_reader;
+        _cur_parquet_reader = nullptr;
+    }
+
     const TBrokerRangeDesc& range = _ranges[_next_range];
     int64_t size = range.size;
     if (range.start_offset != 0) {
@@ -331,6 +360,7 @@ Status BrokerScanner::open_line_reader() {
     case TFileFormatType::FORMAT_CSV_BZ2:
     case TFileFormatType::FORMAT_CSV_LZ4FRAME:
     case TFileFormatType::FORMAT_CSV_LZOP:
+    case TFileFormatType::FORMAT_CSV_ZSTD:
         _cur_line_reader = new PlainTextLineReader(
                 _profile,
                 _cur_file_reader, _cur_decompressor,
@@ -348,6 +378,31 @@ Status BrokerScanner::open_line_reader() {
     return Status::OK;
 }
 
+Status BrokerScanner::open_parquet_reader() {
+    if (_cur_line_reader != nullptr) {
+        delete _cur_line_reader;
+        _cur_line_reader = nullptr;
+    }
+
+    if (_cur_parquet_reader != nullptr) {
+        delete _cur_parquet_reader;
+        _cur_parquet_reader = nullptr;
+    }
+
+    // The source slots are the columns of the file
+    std::vector<std::string> column_names;
+    for (auto slot_desc : _src_slot_descs) {
+        column_names.push_back(slot_desc->col_name());
+    }
+    const TBrokerRangeDesc& range = _ranges[_next_range];
+    _cur_parquet_reader = new ParquetReader(_cur_file_reader, range.start_offset, range.size);
+    RETURN_IF_ERROR(_cur_parquet_reader->open(column_names));
+    _skip_next_line = false;
+    _cur_line_reader_eof = false;
+
+    return Status::OK;
+}
+
 void BrokerScanner::close() {
     if (_cur_decompressor != nullptr) {
         delete _cur_decompressor;
@@ -359,6 +414,11 @@ void BrokerScanner::close() {
         _cur_line_reader = nullptr;
     }
 
+    if (_cur_parquet_reader != nullptr) {
+        delete _cur_parquet_reader;
+        _cur_parquet_reader = nullptr;
+    }
+
     if (_cur_file_reader != nullptr) {
         delete _cur_file_reader;
         _cur_file_reader = nullptr;
@@ -370,14 +430,14 @@ void BrokerScanner::split_line(
         const Slice& line, std::vector<Slice>* values) {
     // line-begin char and line-end char are considered to be 'delimeter'
     const uint8_t* value = line.data();
-    const uint8_t* ptr = line.data();
-    for (size_t i = 0; i < line.size(); ++i, ++ptr) {
-        if (*ptr == _value_separator) {
+    sse_util::for_each_char(
+        (const char*)line.data(), line.size(), _value_separator,
+        [&line, &value, values](size_t pos) {
+            const uint8_t* ptr = line.data() + pos;
             values->emplace_back(value, ptr - value);
             value = ptr + 1;
-        }
-    }
-    values->emplace_back(value, ptr - value);
+        });
+    values->emplace_back(value, line.end() - value);
 }
 
 void BrokerScanner::fill_fix_length_string(
@@ -539,6 +599,7 @@ bool BrokerScanner::convert_one_row(
 // Convert one row to this tuple
 bool BrokerScanner::line_to_src_tuple(const Slice& line) {
     std::vector<Slice> values;
+    values.reserve(_src_slot_descs.size());
     {
         split_line(line, &values);
     }
@@ -580,6 +641,31 @@ bool BrokerScanner::line_to_src_tuple(const Slice& line) {
     return true;
 }
 
+bool BrokerScanner::parquet_row_to_src_tuple() {
+    for (int i = 0; i < _src_slot_descs.size(); ++i) {
+        auto slot_desc = _src_slot_descs[i];
+        if (_cur_parquet_reader->is_null(i)) {
+            if (!slot_desc->is_nullable()) {
+                std::stringstream error_msg;
+                error_msg << "column(" << slot_desc->col_name() << ") value is null";
+                _state->append_error_msg_to_file(_cur_parquet_reader->debug_row(),
+                                                 error_msg.str());
+                _counter->num_rows_filtered++;
+                return false;
+            }
+            _src_tuple->set_null(slot_desc->null_indicator_offset());
+            continue;
+        }
+        const std::string& value = _cur_parquet_reader->value(i);
+        _src_tuple->set_not_null(slot_desc->null_indicator_offset());
+        void* slot = _src_tuple->get_slot(slot_desc->tuple_offset());
+        StringValue* str_slot = reinterpret_cast<StringValue*>(slot);
+        str_slot->ptr = const_cast<char*>(value.data());
+        str_slot->len = value.size();
+    }
+    return true;
+}
+
 bool BrokerScanner::fill_dest_tuple(const Slice& line, Tuple* dest_tuple, MemPool* mem_pool) {
     int ctx_idx = 0;
     for (auto slot_desc : _dest_tuple_desc->slots()) {
@@ -596,7 +682,10 @@ bool BrokerScanner::fill_dest_tuple(const Slice& line, Tuple* dest_tuple, MemPoo
                 std::stringstream error_msg;
                 error_msg << "column(" << slot_desc->col_name() << ") value is null";
                 _state->append_error_msg_to_file(
-                    std::string((const char*)line.data(), line.size()), error_msg.str());
+                    _cur_parquet_reader != nullptr
+                        ? _cur_parquet_reader->debug_row()
+                        : std::string((const char*)line.data(), line.size()),
+                    error_msg.str());
                 _counter->num_rows_filtered++;
                 return false;
             }
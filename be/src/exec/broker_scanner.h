@@ -35,6 +35,7 @@ class Slice;
 class TextConverter;
 class FileReader;
 class LineReader;
+class ParquetReader;
 class Decompressor;
 class RuntimeState;
 class ExprContext;
@@ -77,6 +78,7 @@ private:
     Status open_file_reader();
     Status create_decompressor(TFileFormatType::type type);
     Status open_line_reader();
+    Status open_parquet_reader();
     // Read next buffer from reader
     Status open_next_reader();
 
@@ -108,6 +110,8 @@ private:
 
     Status line_to_src_tuple();
     bool line_to_src_tuple(const Slice& line);
+    // Fills the source tuple with the current row of the parquet reader
+    bool parquet_row_to_src_tuple();
     bool fill_dest_tuple(const Slice& line, Tuple* dest_tuple, MemPool* mem_pool);
 private:
     RuntimeState* _state;
@@ -124,6 +128,8 @@ private:
     // Reader
     FileReader* _cur_file_reader;
     LineReader* _cur_line_reader;
+    // Reads the current range instead of the line reader if it is a parquet file
+    ParquetReader* _cur_parquet_reader;
     Decompressor* _cur_decompressor;
     int _next_range;
     bool _cur_line_reader_eof;
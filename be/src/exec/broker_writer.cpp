@@ -58,12 +58,17 @@ inline const std::string& client_id(RuntimeState* state, const TNetworkAddress&
     return s_client_id;
 }
 #else
+// state is NULL when used outside of a query, e.g. by backup tasks
+inline ExecEnv* exec_env(RuntimeState* state) {
+    return state != NULL ? state->exec_env() : ExecEnv::GetInstance();
+}
+
 inline BrokerServiceClientCache* client_cache(RuntimeState* state) {
-    return state->exec_env()->broker_client_cache();
+    return exec_env(state)->broker_client_cache();
 }
 
 inline const std::string& client_id(RuntimeState* state, const TNetworkAddress& addr) {
-    return state->exec_env()->broker_mgr()->get_client_id(addr);
+    return exec_env(state)->broker_mgr()->get_client_id(addr);
 }
 #endif
 
@@ -36,6 +36,7 @@ class RuntimeState;
 // Reader of broker file
 class BrokerWriter : public FileWriter {
 public:
+    // state may be NULL out of a query, the global ExecEnv is used then
     BrokerWriter(RuntimeState* state,
                   const std::vector<TNetworkAddress>& broker_addresses,
                   const std::map<std::string, std::string>& properties,
@@ -22,24 +22,38 @@
 
 #include <sstream>
 
+#include "common/config.h"
 #include "exprs/expr.h"
 #include "gen_cpp/PlanNodes_types.h"
 #include "runtime/row_batch.h"
 #include "runtime/runtime_state.h"
+#include "runtime/thread_resource_mgr.h"
 #include "util/debug_util.h"
 #include "util/runtime_profile.h"
 
 namespace palo {
 
+// Left batches with fewer pairs than this are not evaluated in parallel.
+static const int64_t PARALLEL_MATCH_MIN_PAIRS = 65536;
+
 CrossJoinNode::CrossJoinNode(
     ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs)
-    : BlockingJoinNode("CrossJoinNode", TJoinOp::CROSS_JOIN, pool, tnode, descs) {
+    : BlockingJoinNode("CrossJoinNode", TJoinOp::CROSS_JOIN, pool, tnode, descs),
+      _tile_rows(1),
+      _tile_start(0),
+      _tile_left_idx(0),
+      _tile_build_idx(0),
+      _left_batch_matched(false),
+      _match_pos(0),
+      _parallel_batches_counter(NULL) {
 }
 
 Status CrossJoinNode::prepare(RuntimeState* state) {
     DCHECK(_join_op == TJoinOp::CROSS_JOIN);
     RETURN_IF_ERROR(BlockingJoinNode::prepare(state));
     _build_batch_pool.reset(new ObjectPool());
+    _parallel_batches_counter =
+        ADD_COUNTER(runtime_profile(), "ParallelProbeBatches", TUnit::UNIT);
     return Status::OK;
 }
 
@@ -48,6 +62,12 @@ Status CrossJoinNode::close(RuntimeState* state) {
     if (is_closed()) {
         return Status::OK;
     }
+    for (int i = 0; i < _helper_conjunct_ctxs.size(); ++i) {
+        Expr::close(_helper_conjunct_ctxs[i], state);
+    }
+    _helper_conjunct_ctxs.clear();
+    _build_rows.clear();
+    _matches.clear();
     _build_batches.reset();
     _build_batch_pool.reset();
     BlockingJoinNode::close(state);
@@ -82,11 +102,33 @@ Status CrossJoinNode::construct_build_side(RuntimeState* state) {
         }
     }
 
+    _build_rows.reserve(_build_batches.total_num_rows());
+    for (RowBatchList::TupleRowIterator it = _build_batches.iterator(); !it.at_end();
+            it.next()) {
+        _build_rows.push_back(it.get_row());
+    }
+
+    int build_row_bytes = _build_tuple_row_size;
+    const std::vector<TupleDescriptor*>& build_tuple_descs =
+        child(1)->row_desc().tuple_descriptors();
+    for (int i = 0; i < build_tuple_descs.size(); ++i) {
+        build_row_bytes += build_tuple_descs[i]->byte_size();
+    }
+    _tile_rows = std::max(1, config::cross_join_tile_bytes / std::max(1, build_row_bytes));
     return Status::OK;
 }
 
 void CrossJoinNode::init_get_next(TupleRow* first_left_row) {
-    _current_build_row = _build_batches.iterator();
+    reset_left_batch_position();
+}
+
+void CrossJoinNode::reset_left_batch_position() {
+    _tile_start = 0;
+    _tile_left_idx = 0;
+    _tile_build_idx = 0;
+    _left_batch_matched = false;
+    _matches.clear();
+    _match_pos = 0;
 }
 
 Status CrossJoinNode::get_next(RuntimeState* state, RowBatch* output_batch, bool* eos) {
@@ -95,6 +137,7 @@ Status CrossJoinNode::get_next(RuntimeState* state, RowBatch* output_batch, bool
     // TOOD(zhaochun)
     // RETURN_IF_ERROR(state->check_query_state());
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
 
     if (reached_limit() || _eos) {
         *eos = true;
@@ -111,9 +154,20 @@ Status CrossJoinNode::get_next(RuntimeState* state, RowBatch* output_batch, bool
             max_added_rows = std::min(max_added_rows, limit() - rows_returned());
         }
 
+        // Evaluate the conjuncts of a new left batch up front if it is worth it
+        if (!_left_batch_matched && _tile_start == 0 && _tile_left_idx == 0
+                && _tile_build_idx == 0) {
+            RETURN_IF_ERROR(match_left_batch_in_parallel(state));
+        }
+
         // Continue processing this row batch
-        _num_rows_returned +=
-            process_left_child_batch(output_batch, _left_batch.get(), max_added_rows);
+        if (_left_batch_matched) {
+            _num_rows_returned +=
+                output_matches(output_batch, _left_batch.get(), max_added_rows);
+        } else {
+            _num_rows_returned +=
+                process_left_child_batch(output_batch, _left_batch.get(), max_added_rows);
+        }
         COUNTER_SET(_rows_returned_counter, _num_rows_returned);
 
         if (reached_limit() || output_batch->is_full()) {
@@ -122,9 +176,10 @@ Status CrossJoinNode::get_next(RuntimeState* state, RowBatch* output_batch, bool
         }
 
         // Check to see if we're done processing the current left child batch
-        if (_current_build_row.at_end() && _left_batch_pos == _left_batch->num_rows()) {
+        if (left_batch_done()) {
             _left_batch->transfer_resource_ownership(output_batch);
             _left_batch_pos = 0;
+            reset_left_batch_position();
 
             if (output_batch->is_full()) {
                 break;
@@ -164,42 +219,154 @@ int CrossJoinNode::process_left_child_batch(RowBatch* output_batch, RowBatch* ba
     int rows_returned = 0;
     ExprContext* const* ctxs = &_conjunct_ctxs[0];
     int ctx_size = _conjunct_ctxs.size();
+    int64_t num_build_rows = _build_rows.size();
+    int num_left_rows = batch->num_rows();
 
-    while (true) {
-        while (!_current_build_row.at_end()) {
-            create_output_row(output_row, _current_left_child_row, _current_build_row.get_row());
-            _current_build_row.next();
+    while (_tile_start < num_build_rows) {
+        int64_t tile_end = std::min(_tile_start + _tile_rows, num_build_rows);
 
-            if (!eval_conjuncts(ctxs, ctx_size, output_row)) {
-                continue;
-            }
+        while (_tile_left_idx < num_left_rows) {
+            TupleRow* left_row = batch->get_row(_tile_left_idx);
 
-            ++rows_returned;
+            while (_tile_build_idx < tile_end) {
+                create_output_row(output_row, left_row, _build_rows[_tile_build_idx]);
+                ++_tile_build_idx;
 
-            // Filled up out batch or hit limit
-            if (UNLIKELY(rows_returned == max_added_rows)) {
-                output_batch->commit_rows(rows_returned);
-                return rows_returned;
-            }
+                if (!eval_conjuncts(ctxs, ctx_size, output_row)) {
+                    continue;
+                }
 
-            // Advance to next out row
-            output_row_mem += output_batch->row_byte_size();
-            output_row = reinterpret_cast<TupleRow*>(output_row_mem);
-        }
+                ++rows_returned;
+
+                // Filled up out batch or hit limit
+                if (UNLIKELY(rows_returned == max_added_rows)) {
+                    output_batch->commit_rows(rows_returned);
+                    return rows_returned;
+                }
 
-        DCHECK(_current_build_row.at_end());
+                // Advance to next out row
+                output_row_mem += output_batch->row_byte_size();
+                output_row = reinterpret_cast<TupleRow*>(output_row_mem);
+            }
 
-        // Advance to the next row in the left child batch
-        if (UNLIKELY(_left_batch_pos == batch->num_rows())) {
-            output_batch->commit_rows(rows_returned);
-            return rows_returned;
+            // Pair the next left row with the same tile
+            ++_tile_left_idx;
+            _tile_build_idx = _tile_start;
         }
 
-        _current_left_child_row = batch->get_row(_left_batch_pos++);
-        _current_build_row = _build_batches.iterator();
+        // Advance to the next tile
+        _tile_start = tile_end;
+        _tile_left_idx = 0;
+        _tile_build_idx = _tile_start;
     }
 
     output_batch->commit_rows(rows_returned);
     return rows_returned;
 }
+
+int CrossJoinNode::output_matches(RowBatch* output_batch, RowBatch* batch,
+        int max_added_rows) {
+    int num_rows = std::min(static_cast<int64_t>(max_added_rows),
+                            static_cast<int64_t>(_matches.size()) - _match_pos);
+    if (num_rows == 0) {
+        return 0;
+    }
+    int row_idx = output_batch->add_rows(num_rows);
+    DCHECK(row_idx != RowBatch::INVALID_ROW_INDEX);
+    uint8_t* output_row_mem = reinterpret_cast<uint8_t*>(output_batch->get_row(row_idx));
+
+    for (int i = 0; i < num_rows; ++i, ++_match_pos) {
+        const std::pair<int, int>& match = _matches[_match_pos];
+        create_output_row(reinterpret_cast<TupleRow*>(output_row_mem),
+                          batch->get_row(match.first), _build_rows[match.second]);
+        output_row_mem += output_batch->row_byte_size();
+    }
+
+    output_batch->commit_rows(num_rows);
+    return num_rows;
+}
+
+Status CrossJoinNode::match_left_batch_in_parallel(RuntimeState* state) {
+    int num_left_rows = _left_batch->num_rows();
+    if (_conjunct_ctxs.empty()
+            || static_cast<int64_t>(_build_rows.size())
+                > config::cross_join_parallel_max_build_rows
+            || num_left_rows * static_cast<int64_t>(_build_rows.size())
+                < PARALLEL_MATCH_MIN_PAIRS) {
+        return Status::OK;
+    }
+
+    ThreadResourceMgr::ResourcePool* pool = state->resource_pool();
+    int num_helpers = 0;
+    while (pool != NULL && num_helpers + 1 < config::cross_join_max_threads
+            && num_helpers + 1 < num_left_rows && pool->try_acquire_thread_token()) {
+        ++num_helpers;
+    }
+    if (num_helpers == 0) {
+        return Status::OK;
+    }
+
+    Status status = Status::OK;
+    while (status.ok() && _helper_conjunct_ctxs.size() < num_helpers) {
+        _helper_conjunct_ctxs.push_back(std::vector<ExprContext*>());
+        status = Expr::clone_if_not_exists(
+                _conjunct_ctxs, state, &_helper_conjunct_ctxs.back());
+    }
+    if (!status.ok()) {
+        for (int i = 0; i < num_helpers; ++i) {
+            pool->release_thread_token(false);
+        }
+        return status;
+    }
+
+    // Every thread matches a contiguous range of left rows, the matches are then
+    // appended in the order of the ranges.
+    int num_threads = num_helpers + 1;
+    std::vector<std::vector<std::pair<int, int> > > thread_matches(num_threads);
+    boost::thread_group helper_threads;
+    for (int i = 1; i < num_threads; ++i) {
+        helper_threads.add_thread(new boost::thread(&CrossJoinNode::match_left_rows, this,
+                    &_helper_conjunct_ctxs[i - 1], _left_batch.get(),
+                    num_left_rows * i / num_threads, num_left_rows * (i + 1) / num_threads,
+                    &thread_matches[i]));
+    }
+    match_left_rows(&_conjunct_ctxs, _left_batch.get(), 0, num_left_rows / num_threads,
+                    &thread_matches[0]);
+    helper_threads.join_all();
+    for (int i = 0; i < num_helpers; ++i) {
+        pool->release_thread_token(false);
+    }
+
+    _matches.clear();
+    for (int i = 0; i < num_threads; ++i) {
+        _matches.insert(_matches.end(), thread_matches[i].begin(), thread_matches[i].end());
+    }
+    _match_pos = 0;
+    _left_batch_matched = true;
+    COUNTER_UPDATE(_parallel_batches_counter, 1);
+    return Status::OK;
+}
+
+void CrossJoinNode::match_left_rows(const std::vector<ExprContext*>* ctxs, RowBatch* batch,
+        int begin, int end, std::vector<std::pair<int, int> >* matches) {
+    std::vector<uint8_t> row_buffer(_result_tuple_row_size);
+    TupleRow* output_row = reinterpret_cast<TupleRow*>(&row_buffer[0]);
+    ExprContext* const* conjunct_ctxs = &(*ctxs)[0];
+    int ctx_size = ctxs->size();
+    int num_build_rows = _build_rows.size();
+
+    for (int tile_start = 0; tile_start < num_build_rows; tile_start += _tile_rows) {
+        int tile_end = std::min(static_cast<int64_t>(tile_start) + _tile_rows,
+                                static_cast<int64_t>(num_build_rows));
+        for (int left_idx = begin; left_idx < end; ++left_idx) {
+            TupleRow* left_row = batch->get_row(left_idx);
+            for (int build_idx = tile_start; build_idx < tile_end; ++build_idx) {
+                create_output_row(output_row, left_row, _build_rows[build_idx]);
+                if (eval_conjuncts(conjunct_ctxs, ctx_size, output_row)) {
+                    matches->push_back(std::pair<int, int>(left_idx, build_idx));
+                }
+            }
+        }
+    }
+}
 }
@@ -25,6 +25,8 @@
 #include <boost/unordered_set.hpp>
 #include <boost/thread.hpp>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "exec/exec_node.h"
 #include "exec/blocking_join_node.h"
@@ -44,6 +46,12 @@ class TupleRow;
 // build batches are kept in a list that is fully constructed from the right child in
 // construct_build_side() (called by BlockingJoinNode::open()) while rows are fetched from
 // the left child as necessary in get_next().
+// The build rows are split into tiles of about config::cross_join_tile_bytes. All rows
+// of a left batch are paired with one tile before moving on to the next one, so that
+// the build tuples stay in the cache while the conjuncts are evaluated.
+// If there are conjuncts and the build side is small, the conjuncts of a left batch may
+// be evaluated by several threads up front, which then only leaves the matching pairs
+// to be copied into the output batches.
 class CrossJoinNode : public BlockingJoinNode {
 public:
     CrossJoinNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs);
@@ -61,7 +69,37 @@ private:
     boost::scoped_ptr<ObjectPool> _build_batch_pool;
     // List of build batches, constructed in prepare()
     RowBatchList _build_batches;
-    RowBatchList::TupleRowIterator _current_build_row;
+    // All rows of _build_batches, so that tiles are ranges of this vector.
+    std::vector<TupleRow*> _build_rows;
+    // Number of build rows in a tile.
+    int64_t _tile_rows;
+
+    // Position of the join in the current left batch: the first build row of the current
+    // tile, the left row that is paired with it and the next build row for that left row.
+    // The left batch is done once _tile_start is past the last build row.
+    int64_t _tile_start;
+    int _tile_left_idx;
+    int64_t _tile_build_idx;
+
+    // Pairs of (left row index, build row index) that passed the conjuncts, if the
+    // current left batch was evaluated in parallel, and the next pair to output.
+    bool _left_batch_matched;
+    std::vector<std::pair<int, int> > _matches;
+    int64_t _match_pos;
+
+    // Copies of the conjuncts used by the helper threads, one vector per thread.
+    std::vector<std::vector<ExprContext*> > _helper_conjunct_ctxs;
+
+    RuntimeProfile::Counter* _parallel_batches_counter;
+
+    // Returns true if the current left batch is done.
+    bool left_batch_done() const {
+        return _left_batch_matched ? _match_pos == static_cast<int64_t>(_matches.size())
+            : _tile_start >= static_cast<int64_t>(_build_rows.size());
+    }
+
+    // Resets the position of the join to the start of a new left batch.
+    void reset_left_batch_position();
 
     // Processes a batch from the left child.
     //  output_batch: the batch for resulting tuple rows
@@ -71,6 +109,19 @@ private:
     // return the number of rows added to output_batch
     int process_left_child_batch(RowBatch* output_batch, RowBatch* batch, int max_added_rows);
 
+    // Outputs the pairs in _matches, like process_left_child_batch().
+    int output_matches(RowBatch* output_batch, RowBatch* batch, int max_added_rows);
+
+    // Evaluates the conjuncts of the current left batch with the fragment thread and the
+    // helper threads that can get a thread token, filling _matches. Does nothing and
+    // returns OK if the batch is too small or no other thread is available.
+    Status match_left_batch_in_parallel(RuntimeState* state);
+
+    // Adds the pairs of the left rows [begin, end) of 'batch' with all build rows that
+    // pass 'ctxs' to 'matches'. Called by several threads at once.
+    void match_left_rows(const std::vector<ExprContext*>* ctxs, RowBatch* batch,
+                         int begin, int end, std::vector<std::pair<int, int> >* matches);
+
     // Returns a debug string for _build_rows. This is used for debugging during the
     // build list construction and before doing the join.
     std::string build_list_debug_string();
@@ -26,6 +26,7 @@
 
 #include "exec/text_converter.hpp"
 #include "gen_cpp/PlanNodes_types.h"
+#include "runtime/exec_env.h"
 #include "runtime/runtime_state.h"
 #include "runtime/row_batch.h"
 #include "runtime/string_value.h"
@@ -34,6 +35,7 @@
 #include "util/runtime_profile.h"
 #include "util/debug_util.h"
 #include "util/hash_util.hpp"
+#include "util/sse_util.hpp"
 #include "olap/olap_common.h"
 #include "olap/utils.h"
 
@@ -74,30 +76,15 @@ private:
 };
 
 void split_line(const std::string& str, char delimiter, std::vector<StringRef>& result) {
-    enum State {
-        IN_DELIM = 1,
-        IN_TOKEN = 0
-    };
-
     // line-begin char and line-end char are considered to be 'delimeter'
-    State state = IN_DELIM;
-    char const* p_begin = str.c_str();    // Begin of either a token or a delimiter
-    for (string::const_iterator it = str.begin(); it != str.end(); ++it) {
-        State const new_state = (*it == delimiter? IN_DELIM : IN_TOKEN);
-        if (new_state != state) {
-            if (new_state == IN_DELIM) {
-                result.push_back(StringRef(p_begin, &*it - p_begin));
-            }
-            p_begin = &*it;
-        } else if (new_state == IN_DELIM) {
-            result.push_back(StringRef(&*p_begin, 0));
-            p_begin = &*it;
-        }
-
-        state = new_state;
-    }
-
-    result.push_back(StringRef(p_begin, (&*str.end() - p_begin) - state));
+    const char* begin = str.data();
+    const char* token = begin;
+    sse_util::for_each_char(begin, str.size(), delimiter,
+        [begin, &token, &result](size_t pos) {
+            result.push_back(StringRef(token, begin + pos - token));
+            token = begin + pos + 1;
+        });
+    result.push_back(StringRef(token, begin + str.size() - token));
 }
 
 CsvScanNode::CsvScanNode(
@@ -206,7 +193,9 @@ Status CsvScanNode::prepare(RuntimeState* state) {
     }
 
     // new one scanner
-    _csv_scanner.reset(new(std::nothrow) CsvScanner(_file_paths));
+    StreamLoadPipeMgr* pipe_mgr = state->exec_env() != nullptr
+            ? state->exec_env()->stream_load_pipe_mgr() : nullptr;
+    _csv_scanner.reset(new(std::nothrow) CsvScanner(_file_paths, pipe_mgr));
     if (_csv_scanner.get() == nullptr) {
         return Status("new a csv scanner failed.");
     }
@@ -242,6 +231,7 @@ Status CsvScanNode::open(RuntimeState* state) {
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::OPEN));
     RETURN_IF_CANCELLED(state);
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(_csv_scanner->open());
 
     return Status::OK;
@@ -260,6 +250,7 @@ Status CsvScanNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
     RETURN_IF_CANCELLED(state);
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     SCOPED_TIMER(materialize_tuple_timer());
 
     if (reached_limit()) {
@@ -342,6 +333,7 @@ Status CsvScanNode::close(RuntimeState* state) {
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::CLOSE));
 
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
 
     if (memory_used_counter() != nullptr &&  _tuple_pool.get() != nullptr) {
         COUNTER_UPDATE(memory_used_counter(), _tuple_pool->peak_allocated_bytes());
@@ -537,6 +529,7 @@ bool CsvScanNode::split_check_fill(const std::string& line, RuntimeState* state)
     std::stringstream error_msg;
     // std::vector<std::string> fields;
     std::vector<StringRef> fields;
+    fields.reserve(_columns.size());
     {
         SCOPED_TIMER(_split_line_timer);
         // boost::split(fields, line, boost::is_any_of(_column_separator));
@@ -17,10 +17,14 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include "runtime/stream_load_pipe.h"
+
 namespace palo {
-    CsvScanner::CsvScanner(const std::vector<std::string>& csv_file_paths) :
+    CsvScanner::CsvScanner(const std::vector<std::string>& csv_file_paths,
+                           StreamLoadPipeMgr* pipe_mgr) :
             _is_open(false),
             _file_paths(csv_file_paths),
+            _pipe_mgr(pipe_mgr),
             _current_file(nullptr),
             _current_file_idx(0){
         // do nothing
@@ -35,6 +39,10 @@ namespace palo {
             delete _current_file;
             _current_file = nullptr;
         }
+        if (_current_pipe != nullptr) {
+            // let the sender of the load stop
+            _current_pipe->cancel("the etl job of the load stopped reading");
+        }
     }
 
     Status CsvScanner::open() {
@@ -55,6 +63,9 @@ namespace palo {
 
     // TODO(lingbin): read more than one line at a time to reduce IO comsumption
     Status CsvScanner::get_next_row(std::string* line_str, bool* eos) {
+        if (_current_pipe != nullptr) {
+            return get_next_pipe_row(line_str, eos);
+        }
         if (_current_file == nullptr && _current_file_idx == _file_paths.size()) {
             *eos = true;
             return Status::OK;
@@ -63,6 +74,16 @@ namespace palo {
         if (_current_file == nullptr && _current_file_idx < _file_paths.size()) {
             std::string& file_path = _file_paths[_current_file_idx];
             LOG(INFO) << "open csv file: [" << _current_file_idx << "] " << file_path;
+            if (StreamLoadPipeMgr::is_pipe_path(file_path)) {
+                if (_pipe_mgr != nullptr) {
+                    _current_pipe = _pipe_mgr->open_pipe(file_path);
+                }
+                if (_current_pipe == nullptr) {
+                    return Status("Fail to read csv stream: " + file_path);
+                }
+                ++_current_file_idx;
+                return get_next_pipe_row(line_str, eos);
+            }
 
             _current_file = new std::ifstream(file_path, std::ifstream::in);
             if (!_current_file->is_open()) {
@@ -86,5 +107,15 @@ namespace palo {
         *eos = false;
         return Status::OK;
     }
+
+    Status CsvScanner::get_next_pipe_row(std::string* line_str, bool* eos) {
+        bool pipe_eos = false;
+        RETURN_IF_ERROR(_current_pipe->read_line(line_str, &pipe_eos));
+        if (pipe_eos) {
+            _current_pipe.reset();
+        }
+        *eos = pipe_eos && _current_file_idx == _file_paths.size();
+        return Status::OK;
+    }
 } // end namespace palo
 
@@ -17,6 +17,7 @@
 #define BDG_PALO_BE_SRC_QUERY_EXEC_CSV_SCANNER_H
 
 #include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -24,18 +25,29 @@
 
 namespace palo {
 
+class StreamLoadPipe;
+class StreamLoadPipeMgr;
+
+// Reads the lines of csv files. Paths of streaming mini loads are read from their
+// pipes in 'pipe_mgr'.
 class CsvScanner {
 public:
-    CsvScanner(const std::vector<std::string>& csv_file_paths);
+    CsvScanner(const std::vector<std::string>& csv_file_paths,
+               StreamLoadPipeMgr* pipe_mgr = nullptr);
     ~CsvScanner();
 
     Status open();
     Status get_next_row(std::string* line_str, bool* eos);
 private:
+    Status get_next_pipe_row(std::string* line_str, bool* eos);
+
     bool _is_open;
     std::vector<std::string> _file_paths;
+    StreamLoadPipeMgr* _pipe_mgr;
     // the current opened file
     std::ifstream* _current_file;
+    // the current opened pipe, instead of _current_file
+    std::shared_ptr<StreamLoadPipe> _current_pipe;
     int32_t _current_file_idx;
 };
 
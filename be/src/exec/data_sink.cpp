@@ -24,6 +24,7 @@
 #include <map>
 #include <memory>
 
+#include "common/config.h"
 #include "exec/exec_node.h"
 #include "exprs/expr.h"
 #include "gen_cpp/PaloInternalService_types.h"
@@ -65,8 +66,9 @@ Status DataSink::create_data_sink(
             return Status("Missing data buffer sink.");
         }
 
-        // TODO: figure out good buffer size based on size of output row
-        tmp_sink = new ResultSink(row_desc, output_exprs, thrift_sink.result_sink, 1024);
+        // the buffer is also bounded in bytes, see BufferControlBlock
+        tmp_sink = new ResultSink(row_desc, output_exprs, thrift_sink.result_sink,
+                                  config::result_buffer_max_rows);
         sink->reset(tmp_sink);
         break;
 
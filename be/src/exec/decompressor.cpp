@@ -20,6 +20,10 @@
 
 #include "exec/decompressor.h"
 
+#include <lz4/lz4.h>
+
+#include "common/config.h"
+
 namespace palo {
 
 Status Decompressor::create_decompressor(CompressType type,
@@ -43,6 +47,9 @@ Status Decompressor::create_decompressor(CompressType type,
     case CompressType::LZOP:
         *decompressor = new LzopDecompressor();
         break;
+    case CompressType::ZSTD:
+        *decompressor = new ZstdDecompressor();
+        break;
     default:
         std::stringstream ss;
         ss << "Unknown compress type: " << type;
@@ -53,7 +60,13 @@ Status Decompressor::create_decompressor(CompressType type,
     if (*decompressor != nullptr) {
         st = (*decompressor)->init();
     }
-    
+    if (st.ok() && config::load_decompress_threads > 1
+            && (type == CompressType::GZIP || type == CompressType::LZ4FRAME)) {
+        *decompressor = new ParallelBlockDecompressor(
+            type, *decompressor, config::load_decompress_threads);
+        st = (*decompressor)->init();
+    }
+
     return st;
 }
 
@@ -66,7 +79,7 @@ std::string Decompressor::debug_info() {
 
 // Gzip
 GzipDecompressor::GzipDecompressor(bool is_deflate):
-    Decompressor(_is_deflate ? CompressType::DEFLATE : CompressType::GZIP),
+    Decompressor(is_deflate ? CompressType::DEFLATE : CompressType::GZIP),
     _is_deflate(is_deflate) {
 }
 
@@ -116,7 +129,7 @@ Status GzipDecompressor::decompress(
         *input_bytes_read = input_len - _z_strm.avail_in;
         *decompressed_len = output_max_len - _z_strm.avail_out;
 
-        LOG(INFO) << "gzip dec ret: " << ret
+        VLOG(3) << "gzip dec ret: " << ret
                   << " input_bytes_read: " << *input_bytes_read
                   << " decompressed_len: " << *decompressed_len;
 
@@ -723,4 +736,417 @@ std::string LzopDecompressor::debug_info() {
     return ss.str();
 }
 
+// Zstd
+ZstdDecompressor::~ZstdDecompressor() {
+    if (_dstream != nullptr) {
+        ZSTD_freeDStream(_dstream);
+    }
+}
+
+Status ZstdDecompressor::init() {
+    _dstream = ZSTD_createDStream();
+    if (_dstream == nullptr) {
+        return Status("Failed to create zstd decompression stream");
+    }
+    size_t ret = ZSTD_initDStream(_dstream);
+    if (ZSTD_isError(ret)) {
+        std::stringstream ss;
+        ss << "Failed to init zstd decompression stream: " << ZSTD_getErrorName(ret);
+        return Status(ss.str());
+    }
+    return Status::OK;
+}
+
+Status ZstdDecompressor::decompress(
+        uint8_t* input, size_t input_len, size_t* input_bytes_read,
+        uint8_t* output, size_t output_max_len,
+        size_t* decompressed_len, bool* stream_end,
+        size_t* more_input_bytes, size_t* more_output_bytes) {
+    ZSTD_inBuffer in = { input, input_len, 0 };
+    ZSTD_outBuffer out = { output, output_max_len, 0 };
+    while (in.pos < in.size && out.pos < out.size) {
+        size_t ret = ZSTD_decompressStream(_dstream, &out, &in);
+        *input_bytes_read = in.pos;
+        *decompressed_len = out.pos;
+        if (ZSTD_isError(ret)) {
+            std::stringstream ss;
+            ss << "Failed to zstd decompress: " << ZSTD_getErrorName(ret);
+            return Status(ss.str());
+        }
+        *stream_end = ret == 0;
+        if (ret == 0) {
+            // reset the stream to continue decoding a subsequent frame
+            ret = ZSTD_initDStream(_dstream);
+            if (ZSTD_isError(ret)) {
+                std::stringstream ss;
+                ss << "Failed to reset zstd decompression stream: " << ZSTD_getErrorName(ret);
+                return Status(ss.str());
+            }
+        }
+    }
+
+    return Status::OK;
+}
+
+std::string ZstdDecompressor::debug_info() {
+    std::stringstream ss;
+    ss << "ZstdDecompressor.";
+    return ss.str();
+}
+
+// ParallelBlock
+// bgzip blocks hold at most 64KB of data
+const static size_t BGZF_MAX_BLOCK_SIZE = 1 << 16;
+const static uint32_t LZ4_FRAME_MAGIC = 0x184D2204;
+const static uint32_t LZ4_SKIPPABLE_MAGIC = 0x184D2A50;
+
+static inline uint32_t get_le_uint32(const uint8_t* ptr) {
+    return ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((uint32_t) ptr[3] << 24);
+}
+
+ParallelBlockDecompressor::ParallelBlockDecompressor(
+        CompressType ctype, Decompressor* sequential, int num_threads) :
+    Decompressor(ctype),
+    _sequential(sequential),
+    _num_threads(num_threads),
+    _mode(UNKNOWN),
+    _in_lz4_frame(false),
+    _lz4_block_checksum(false),
+    _lz4_content_checksum(false),
+    _lz4_max_block_size(0),
+    _dispatched_len(0),
+    _stop(false) {
+}
+
+ParallelBlockDecompressor::~ParallelBlockDecompressor() {
+    {
+        boost::lock_guard<boost::mutex> l(_lock);
+        _stop = true;
+    }
+    _work_cond.notify_all();
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+}
+
+Status ParallelBlockDecompressor::init() {
+    return Status::OK;
+}
+
+Status ParallelBlockDecompressor::decompress(
+        uint8_t* input, size_t input_len, size_t* input_bytes_read,
+        uint8_t* output, size_t output_max_len,
+        size_t* decompressed_len, bool* stream_end,
+        size_t* more_input_bytes, size_t* more_output_bytes) {
+    if (_mode == SEQUENTIAL) {
+        return _sequential->decompress(input, input_len, input_bytes_read,
+                                       output, output_max_len, decompressed_len,
+                                       stream_end, more_input_bytes, more_output_bytes);
+    }
+    *input_bytes_read = 0;
+    *decompressed_len = 0;
+    *more_input_bytes = 0;
+    *more_output_bytes = 0;
+
+    // 1. cut the next blocks out of the input and queue them for decoding
+    while (_blocks.size() < 2 * (size_t) _num_threads && _dispatched_len < input_len) {
+        std::unique_ptr<Block> block(new Block());
+        const uint8_t* data = input + _dispatched_len;
+        size_t avail = input_len - _dispatched_len;
+        size_t len = 0;
+        if (_ctype == CompressType::GZIP) {
+            RETURN_IF_ERROR(next_bgzf_block(data, avail, &len, block.get()));
+        } else {
+            RETURN_IF_ERROR(next_lz4_block(data, avail, &len, block.get()));
+        }
+        if (_mode == SEQUENTIAL) {
+            DCHECK(_blocks.empty());
+            LOG(INFO) << "file is not splittable, decompress it sequentially. "
+                      << _sequential->debug_info();
+            return _sequential->decompress(input, input_len, input_bytes_read,
+                                           output, output_max_len, decompressed_len,
+                                           stream_end, more_input_bytes, more_output_bytes);
+        }
+        if (len > avail) {
+            *more_input_bytes = len - avail;
+            break;
+        }
+        _dispatched_len += len;
+        Block* queued = block.get();
+        _blocks.push_back(std::move(block));
+        if (!queued->done) {
+            if (_threads.empty()) {
+                for (int i = 0; i < _num_threads; ++i) {
+                    _threads.emplace_back(&ParallelBlockDecompressor::worker, this);
+                }
+            }
+            {
+                boost::lock_guard<boost::mutex> l(_lock);
+                _work.push_back(queued);
+            }
+            _work_cond.notify_one();
+        }
+    }
+
+    // 2. return the output of the decoded blocks in order, waiting for the first one
+    while (!_blocks.empty()) {
+        Block* block = _blocks.front().get();
+        {
+            boost::unique_lock<boost::mutex> l(_lock);
+            if (!block->done && *decompressed_len > 0) {
+                break;
+            }
+            while (!block->done) {
+                _done_cond.wait(l);
+            }
+        }
+        RETURN_IF_ERROR(block->status);
+        size_t len = block->output.size();
+        if (len > output_max_len - *decompressed_len) {
+            if (*decompressed_len == 0) {
+                *more_output_bytes = len - output_max_len;
+            }
+            break;
+        }
+        memcpy(output + *decompressed_len, block->output.data(), len);
+        *decompressed_len += len;
+        *input_bytes_read += block->input_len;
+        _dispatched_len -= block->input_len;
+        _blocks.pop_front();
+    }
+
+    *stream_end = _blocks.empty() && *input_bytes_read == input_len && !_in_lz4_frame;
+    return Status::OK;
+}
+
+// A bgzip block is a gzip member that records its size in the extra subfield 'BC'.
+Status ParallelBlockDecompressor::next_bgzf_block(
+        const uint8_t* data, size_t avail, size_t* len, Block* block) {
+    // magic(2) + method(1) + flags(1) + mtime(4) + xfl(1) + os(1) + xlen(2)
+    const size_t fixed_header_len = 12;
+    if (avail < fixed_header_len) {
+        *len = fixed_header_len;
+        return Status::OK;
+    }
+    size_t block_size = 0;
+    if (data[0] == 0x1f && data[1] == 0x8b && data[2] == 8 && (data[3] & 0x04)) {
+        size_t xlen = data[10] | (data[11] << 8);
+        if (avail < fixed_header_len + xlen) {
+            *len = fixed_header_len + xlen;
+            return Status::OK;
+        }
+        const uint8_t* field = data + fixed_header_len;
+        const uint8_t* end = field + xlen;
+        while (field + 4 <= end) {
+            size_t field_len = field[2] | (field[3] << 8);
+            if (field[0] == 'B' && field[1] == 'C' && field_len == 2 && field + 6 <= end) {
+                block_size = (field[4] | (field[5] << 8)) + 1;
+                break;
+            }
+            field += 4 + field_len;
+        }
+        // the member ends with crc32(4) + isize(4)
+        if (block_size < fixed_header_len + xlen + 8) {
+            block_size = 0;
+        }
+    }
+    if (block_size == 0) {
+        if (_mode == UNKNOWN) {
+            _mode = SEQUENTIAL;
+            return Status::OK;
+        }
+        return Status("Gzip member without block size in a bgzip file");
+    }
+    _mode = PARALLEL;
+
+    *len = block_size;
+    if (avail < block_size) {
+        return Status::OK;
+    }
+    block->input.assign((const char*) data, block_size);
+    block->input_len = block_size;
+    block->output_capacity = get_le_uint32(data + block_size - 4);
+    if (block->output_capacity > BGZF_MAX_BLOCK_SIZE) {
+        std::stringstream ss;
+        ss << "Invalid uncompressed size of bgzip block: " << block->output_capacity;
+        return Status(ss.str());
+    }
+    block->done = false;
+    return Status::OK;
+}
+
+// The checksums of LZ4 frames are not verified, they need xxhash which lz4 doesn't
+// export.
+Status ParallelBlockDecompressor::next_lz4_block(
+        const uint8_t* data, size_t avail, size_t* len, Block* block) {
+    if (!_in_lz4_frame) {
+        if (avail < 4) {
+            *len = 4;
+            return Status::OK;
+        }
+        uint32_t magic = get_le_uint32(data);
+        if ((magic & 0xFFFFFFF0) == LZ4_SKIPPABLE_MAGIC && _mode == PARALLEL) {
+            // magic(4) + size(4) + user data
+            if (avail < 8) {
+                *len = 8;
+                return Status::OK;
+            }
+            *len = 8 + get_le_uint32(data + 4);
+            block->input_len = *len;
+            return Status::OK;
+        }
+        if (magic != LZ4_FRAME_MAGIC) {
+            if (_mode == UNKNOWN) {
+                _mode = SEQUENTIAL;
+                return Status::OK;
+            }
+            std::stringstream ss;
+            ss << "Invalid lz4 frame magic: " << magic;
+            return Status(ss.str());
+        }
+        // magic(4) + flg(1) + bd(1) + [content size(8)] + [dict id(4)] + hc(1)
+        if (avail < 7) {
+            *len = 7;
+            return Status::OK;
+        }
+        uint8_t flg = data[4];
+        uint8_t bd = data[5];
+        bool independent_blocks = flg & 0x20;
+        bool has_dict_id = flg & 0x01;
+        if ((flg >> 6) != 1 || !independent_blocks || has_dict_id) {
+            if (_mode == UNKNOWN) {
+                _mode = SEQUENTIAL;
+                return Status::OK;
+            }
+            return Status("Lz4 frame with linked blocks after frames with independent blocks");
+        }
+        int block_size_id = (bd >> 4) & 0x07;
+        if (block_size_id < 4) {
+            std::stringstream ss;
+            ss << "Invalid lz4 block size id: " << block_size_id;
+            return Status(ss.str());
+        }
+        _mode = PARALLEL;
+
+        *len = 7 + ((flg & 0x08) ? 8 : 0);
+        if (avail < *len) {
+            return Status::OK;
+        }
+        _in_lz4_frame = true;
+        _lz4_block_checksum = flg & 0x10;
+        _lz4_content_checksum = flg & 0x04;
+        // 64KB, 256KB, 1MB or 4MB
+        _lz4_max_block_size = 1 << (8 + 2 * block_size_id);
+        block->input_len = *len;
+        return Status::OK;
+    }
+
+    if (avail < 4) {
+        *len = 4;
+        return Status::OK;
+    }
+    uint32_t block_size = get_le_uint32(data);
+    if (block_size == 0) {
+        // end mark + [content checksum(4)]
+        *len = 4 + (_lz4_content_checksum ? 4 : 0);
+        if (avail < *len) {
+            return Status::OK;
+        }
+        _in_lz4_frame = false;
+        block->input_len = *len;
+        return Status::OK;
+    }
+    size_t data_len = block_size & 0x7FFFFFFF;
+    if (data_len > _lz4_max_block_size) {
+        std::stringstream ss;
+        ss << "lz4 block size " << data_len << " exceeds the max block size "
+           << _lz4_max_block_size;
+        return Status(ss.str());
+    }
+    *len = 4 + data_len + (_lz4_block_checksum ? 4 : 0);
+    if (avail < *len) {
+        return Status::OK;
+    }
+    block->input.assign((const char*) data + 4, data_len);
+    block->input_len = *len;
+    block->output_capacity = _lz4_max_block_size;
+    block->raw = block_size >> 31;
+    block->done = false;
+    return Status::OK;
+}
+
+void ParallelBlockDecompressor::decode(Block* block) {
+    block->output.resize(block->output_capacity);
+    if (_ctype == CompressType::GZIP) {
+        z_stream strm;
+        memset(&strm, 0, sizeof(strm));
+        // gzip header only
+        int ret = inflateInit2(&strm, MAX_WBITS + 16);
+        if (ret != Z_OK) {
+            std::stringstream ss;
+            ss << "Failed to init inflate. status code: " << ret;
+            block->status = Status(ss.str());
+            return;
+        }
+        strm.next_in = (Bytef*) block->input.data();
+        strm.avail_in = block->input.size();
+        strm.next_out = (Bytef*) &block->output[0];
+        strm.avail_out = block->output.size();
+        ret = inflate(&strm, Z_FINISH);
+        size_t output_len = strm.total_out;
+        inflateEnd(&strm);
+        if (ret != Z_STREAM_END || output_len != block->output_capacity) {
+            std::stringstream ss;
+            ss << "Failed to inflate bgzip block. return code: " << ret
+               << " decompressed len: " << output_len
+               << " expected: " << block->output_capacity;
+            block->status = Status(ss.str());
+        }
+    } else if (block->raw) {
+        block->output.assign(block->input);
+    } else {
+        int ret = LZ4_decompress_safe(block->input.data(), &block->output[0],
+                                      block->input.size(), block->output.size());
+        if (ret < 0) {
+            std::stringstream ss;
+            ss << "Failed to decompress lz4 block. return code: " << ret;
+            block->status = Status(ss.str());
+            return;
+        }
+        block->output.resize(ret);
+    }
+}
+
+void ParallelBlockDecompressor::worker() {
+    while (true) {
+        Block* block = nullptr;
+        {
+            boost::unique_lock<boost::mutex> l(_lock);
+            while (!_stop && _work.empty()) {
+                _work_cond.wait(l);
+            }
+            if (_stop) {
+                return;
+            }
+            block = _work.front();
+            _work.pop_front();
+        }
+        decode(block);
+        {
+            boost::lock_guard<boost::mutex> l(_lock);
+            block->done = true;
+        }
+        _done_cond.notify_all();
+    }
+}
+
+std::string ParallelBlockDecompressor::debug_info() {
+    std::stringstream ss;
+    ss << "ParallelBlockDecompressor."
+       << " threads: " << _num_threads
+       << " mode: " << _mode
+       << " sequential: " << _sequential->debug_info();
+    return ss.str();
+}
+
 } // namespace
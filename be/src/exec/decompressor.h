@@ -25,6 +25,16 @@
 #include <lz4/lz4frame.h>
 #include <lzo/lzoconf.h>
 #include <lzo/lzo1x.h>
+#include <zstd/zstd.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include "common/status.h"
 
@@ -36,7 +46,8 @@ enum CompressType {
     DEFLATE,
     BZIP2,
     LZ4FRAME,
-    LZOP
+    LZOP,
+    ZSTD
 };
 
 class Decompressor {
@@ -259,4 +270,109 @@ private:
     const static uint64_t F_ADLER32_D;
 };
 
+class ZstdDecompressor : public Decompressor {
+public:
+    virtual ~ZstdDecompressor();
+
+    virtual Status decompress(
+            uint8_t* input, size_t input_len, size_t* input_bytes_read,
+            uint8_t* output, size_t output_max_len,
+            size_t* decompressed_len, bool* stream_end,
+            size_t* more_input_bytes, size_t* more_output_bytes) override;
+
+    virtual std::string debug_info() override;
+
+private:
+    friend class Decompressor;
+    ZstdDecompressor() : Decompressor(CompressType::ZSTD), _dstream(nullptr) {}
+    virtual Status init() override;
+
+private:
+    ZSTD_DStream* _dstream;
+};
+
+// Decodes the blocks of bgzip files and of LZ4 frames with independent blocks on
+// 'num_threads' threads, up to two blocks per thread ahead of the caller. Both formats
+// record the size of every block in front of it, so the blocks can be cut out of the
+// input without decoding it. Other gzip and LZ4 files are handed to 'sequential'.
+//
+// The input of a block counts as read only once its output is returned, so the line
+// reader doesn't reach the end of the file while blocks are still being decoded.
+// The output of a block is returned as a whole.
+class ParallelBlockDecompressor : public Decompressor {
+public:
+    virtual ~ParallelBlockDecompressor();
+
+    virtual Status decompress(
+            uint8_t* input, size_t input_len, size_t* input_bytes_read,
+            uint8_t* output, size_t output_max_len,
+            size_t* decompressed_len, bool* stream_end,
+            size_t* more_input_bytes, size_t* more_output_bytes) override;
+
+    virtual std::string debug_info() override;
+
+private:
+    friend class Decompressor;
+    // Takes the ownership of 'sequential'.
+    ParallelBlockDecompressor(CompressType ctype, Decompressor* sequential, int num_threads);
+    virtual Status init() override;
+
+    enum Mode {
+        UNKNOWN,
+        SEQUENTIAL,
+        PARALLEL
+    };
+
+    struct Block {
+        // Compressed bytes, empty for the headers and trailers of LZ4 frames
+        std::string input;
+        // Number of bytes of the input of decompress() the block covers
+        size_t input_len;
+        // Upper bound of the decompressed size
+        size_t output_capacity;
+        // The LZ4 block is stored uncompressed
+        bool raw;
+
+        std::string output;
+        Status status;
+        bool done;
+
+        Block() : input_len(0), output_capacity(0), raw(false), done(true) { }
+    };
+
+    // Sets 'len' to the length of the next block at 'data' if 'avail' bytes hold
+    // its header, otherwise to the number of bytes needed to parse the header.
+    // Switches to SEQUENTIAL mode if the first block isn't splittable.
+    Status next_bgzf_block(const uint8_t* data, size_t avail, size_t* len, Block* block);
+    Status next_lz4_block(const uint8_t* data, size_t avail, size_t* len, Block* block);
+
+    void decode(Block* block);
+    void worker();
+
+    std::unique_ptr<Decompressor> _sequential;
+    int _num_threads;
+    Mode _mode;
+
+    // LZ4 frame state
+    bool _in_lz4_frame;
+    bool _lz4_block_checksum;
+    bool _lz4_content_checksum;
+    size_t _lz4_max_block_size;
+
+    // Number of input bytes, counted from the 'input' passed to decompress(), that
+    // belong to the blocks in '_blocks'
+    size_t _dispatched_len;
+    // Blocks whose output isn't returned yet, in input order
+    std::deque<std::unique_ptr<Block>> _blocks;
+
+    boost::mutex _lock;
+    // Signaled when a block is queued for decoding or '_stop' is set
+    boost::condition_variable _work_cond;
+    // Signaled when a block is decoded
+    boost::condition_variable _done_cond;
+    std::deque<Block*> _work;
+    bool _stop;
+    std::vector<std::thread> _threads;
+};
+
 } // namespace
@@ -84,6 +84,7 @@ Status ExchangeNode::prepare(RuntimeState* state) {
 
 Status ExchangeNode::open(RuntimeState* state) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(ExecNode::open(state));
     if (_is_merging) {
         RETURN_IF_ERROR(_sort_exec_exprs.open(state));
@@ -116,6 +117,7 @@ Status ExchangeNode::fill_input_row_batch(RuntimeState* state) {
     Status ret_status;
     {
         // SCOPED_TIMER(state->total_network_receive_timer());
+        ThreadResourceMgr::ScopedBlockedThread blocked(state->resource_pool());
         ret_status = _stream_recvr->get_batch(&_input_batch);
     }
     VLOG_FILE << "exch: has batch=" << (_input_batch == NULL ? "false" : "true")
@@ -128,6 +130,7 @@ Status ExchangeNode::fill_input_row_batch(RuntimeState* state) {
 Status ExchangeNode::get_next(RuntimeState* state, RowBatch* output_batch, bool* eos) {
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
 
     if (reached_limit()) {
         _stream_recvr->transfer_all_resources(output_batch);
@@ -26,14 +26,17 @@
 
 #include "codegen/llvm_codegen.h"
 #include "codegen/codegen_anyval.h"
+#include "common/config.h"
 #include "common/object_pool.h"
 #include "common/status.h"
 #include "exprs/expr_context.h"
+#include "exprs/subexpr_cache.h"
 #include "exec/aggregation_node.h"
 #include "exec/partitioned_aggregation_node.h"
 #include "exec/csv_scan_node.h"
 #include "exec/pre_aggregation_node.h"
 #include "exec/hash_join_node.h"
+#include "exec/partitioned_hash_join_node.h"
 #include "exec/broker_scan_node.h"
 #include "exec/cross_join_node.h"
 #include "exec/empty_set_node.h"
@@ -45,6 +48,7 @@
 #include "exec/olap_rewrite_node.h"
 #include "exec/olap_scan_node.h"
 #include "exec/topn_node.h"
+#include "exec/partition_topn_node.h"
 #include "exec/sort_node.h"
 #include "exec/spill_sort_node.h"
 #include "exec/analytic_eval_node.h"
@@ -57,6 +61,7 @@
 #include "runtime/runtime_state.h"
 #include "util/debug_util.h"
 #include "util/runtime_profile.h"
+#include "util/stopwatch.hpp"
 
 using llvm::Function;
 using llvm::PointerType;
@@ -132,6 +137,7 @@ ExecNode::ExecNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl
         _rows_returned_counter(NULL),
         _rows_returned_rate(NULL),
         _memory_used_counter(NULL),
+        _cpu_time_counter(NULL),
         _is_closed(false){
     init_runtime_profile(print_plan_node_type(tnode.node_type));
 }
@@ -176,6 +182,7 @@ Status ExecNode::prepare(RuntimeState* state) {
         ADD_COUNTER(_runtime_profile, "RowsReturned", TUnit::UNIT);
     _memory_used_counter =
         ADD_COUNTER(_runtime_profile, "MemoryUsed", TUnit::BYTES);
+    _cpu_time_counter = ADD_TIMER(_runtime_profile, "CPUTime");
     _rows_returned_rate = runtime_profile()->add_derived_counter(
                               ROW_THROUGHPUT_COUNTER, TUnit::UNIT_PER_SECOND,
                               boost::bind<int64_t>(&RuntimeProfile::units_per_second,
@@ -186,6 +193,7 @@ Status ExecNode::prepare(RuntimeState* state) {
     _expr_mem_tracker.reset(new MemTracker(-1, "Exprs", _mem_tracker.get()));
 
     RETURN_IF_ERROR(Expr::prepare(_conjunct_ctxs, state, row_desc(), expr_mem_tracker()));
+    SubExprCache::create(_pool, _conjunct_ctxs);
     // TODO(zc):
     // AddExprCtxsToFree(_conjunct_ctxs);
 
@@ -237,13 +245,20 @@ void ExecNode::add_runtime_exec_option(const std::string& str) {
 
 Status ExecNode::create_tree(ObjectPool* pool, const TPlan& plan,
                             const DescriptorTbl& descs, ExecNode** root) {
+    return create_tree(pool, plan, descs, false, root);
+}
+
+Status ExecNode::create_tree(ObjectPool* pool, const TPlan& plan,
+                            const DescriptorTbl& descs, bool prefer_spilling,
+                            ExecNode** root) {
     if (plan.nodes.size() == 0) {
         *root = NULL;
         return Status::OK;
     }
 
     int node_idx = 0;
-    RETURN_IF_ERROR(create_tree_helper(pool, plan.nodes, descs, NULL, &node_idx, root));
+    RETURN_IF_ERROR(create_tree_helper(
+            pool, plan.nodes, descs, prefer_spilling, NULL, &node_idx, root));
 
     if (node_idx + 1 != plan.nodes.size()) {
         // TODO: print thrift msg for diagnostic purposes.
@@ -258,6 +273,7 @@ Status ExecNode::create_tree_helper(
     ObjectPool* pool,
     const vector<TPlanNode>& tnodes,
     const DescriptorTbl& descs,
+    bool prefer_spilling,
     ExecNode* parent,
     int* node_idx,
     ExecNode** root) {
@@ -270,7 +286,7 @@ Status ExecNode::create_tree_helper(
 
     int num_children = tnodes[*node_idx].num_children;
     ExecNode* node = NULL;
-    RETURN_IF_ERROR(create_node(pool, tnodes[*node_idx], descs, &node));
+    RETURN_IF_ERROR(create_node(pool, tnodes[*node_idx], descs, prefer_spilling, &node));
 
     // assert(parent != NULL || (node_idx == 0 && root_expr != NULL));
     if (parent != NULL) {
@@ -281,7 +297,8 @@ Status ExecNode::create_tree_helper(
 
     for (int i = 0; i < num_children; i++) {
         ++*node_idx;
-        RETURN_IF_ERROR(create_tree_helper(pool, tnodes, descs, node, node_idx, NULL));
+        RETURN_IF_ERROR(create_tree_helper(
+                pool, tnodes, descs, prefer_spilling, node, node_idx, NULL));
 
         // we are expecting a child, but have used all nodes
         // this means we have been given a bad tree and must fail
@@ -306,8 +323,23 @@ Status ExecNode::create_tree_helper(
     return Status::OK;
 }
 
+// COUNT_DISTINCT and SUM_DISTINCT remember the values of a group by the address of its
+// tuple, which PartitionedAggregationNode moves when it spills or repartitions, so
+// aggregations using them stay on AggregationNode. The FE rewrites most of them to the
+// serializable multi_distinct_count() and multi_distinct_sum().
+static bool has_unspillable_agg_fn(const TPlanNode& tnode) {
+    for (const TExpr& agg_expr : tnode.agg_node.aggregate_functions) {
+        const std::string& fn_name = agg_expr.nodes[0].fn.name.function_name;
+        if (fn_name == "count_distinct" || fn_name == "sum_distinct") {
+            return true;
+        }
+    }
+    return false;
+}
+
 Status ExecNode::create_node(ObjectPool* pool, const TPlanNode& tnode,
-                            const DescriptorTbl& descs, ExecNode** node) {
+                            const DescriptorTbl& descs, bool prefer_spilling,
+                            ExecNode** node) {
     std::stringstream error_msg;
 
     switch (tnode.node_type) {
@@ -330,7 +362,8 @@ Status ExecNode::create_node(ObjectPool* pool, const TPlanNode& tnode,
         return Status::OK;
 
     case TPlanNodeType::AGGREGATION_NODE:
-        if (config::enable_partitioned_aggregation) {
+        if ((config::enable_partitioned_aggregation || prefer_spilling)
+                && !has_unspillable_agg_fn(tnode)) {
             *node = pool->add(new PartitionedAggregationNode(pool, tnode, descs));
         } else {
             *node = pool->add(new AggregationNode(pool, tnode, descs));
@@ -341,7 +374,13 @@ Status ExecNode::create_node(ObjectPool* pool, const TPlanNode& tnode,
           *node = pool->add(new PreAggregationNode(pool, tnode, descs));
           return Status::OK;*/
     case TPlanNodeType::HASH_JOIN_NODE:
-        *node = pool->add(new HashJoinNode(pool, tnode, descs));
+        // null aware left anti join is only supported by HashJoinNode
+        if ((config::enable_partitioned_hash_join || prefer_spilling)
+                && tnode.hash_join_node.join_op != TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN) {
+            *node = pool->add(new PartitionedHashJoinNode(pool, tnode, descs));
+        } else {
+            *node = pool->add(new HashJoinNode(pool, tnode, descs));
+        }
         return Status::OK;
 
     case TPlanNodeType::CROSS_JOIN_NODE:
@@ -376,6 +415,10 @@ Status ExecNode::create_node(ObjectPool* pool, const TPlanNode& tnode,
         }
 
         return Status::OK;
+    case TPlanNodeType::PARTITION_TOPN_NODE:
+        *node = pool->add(new PartitionTopNNode(pool, tnode, descs));
+        return Status::OK;
+
     case TPlanNodeType::ANALYTIC_EVAL_NODE:
         *node = pool->add(new AnalyticEvalNode(pool, tnode, descs));
         break;
@@ -445,6 +488,10 @@ void ExecNode::debug_string(int indentation_level, std::stringstream* out) const
 }
 
 bool ExecNode::eval_conjuncts(ExprContext* const* ctxs, int num_ctxs, TupleRow* row) {
+    if (num_ctxs == 0) {
+        return true;
+    }
+    SubExprCache::RowScope scope(ctxs[0]->subexpr_cache(), row);
     for (int i = 0; i < num_ctxs; ++i) {
         BooleanVal v = ctxs[i]->get_boolean_val(row);
         if (v.is_null || !v.val) {
@@ -454,6 +501,50 @@ bool ExecNode::eval_conjuncts(ExprContext* const* ctxs, int num_ctxs, TupleRow*
     return true;
 }
 
+bool ExecNode::eval_conjuncts_with_stats(
+        ExprContext* const* ctxs, int num_ctxs, TupleRow* row) {
+    if (num_ctxs == 0) {
+        return true;
+    }
+    SubExprCache::RowScope scope(ctxs[0]->subexpr_cache(), row);
+    MonotonicStopWatch watch;
+    watch.start();
+    for (int i = 0; i < num_ctxs; ++i) {
+        BooleanVal v = ctxs[i]->get_boolean_val(row);
+        bool passed = !v.is_null && v.val;
+        ExprContext::ConjunctStats* stats = ctxs[i]->conjunct_stats();
+        ++stats->rows_in;
+        stats->rows_passed += passed;
+        stats->time_ns += watch.reset();
+        if (!passed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int ExecNode::eval_conjuncts(std::vector<ExprContext*>* ctxs, RowBatch* batch,
+                             std::vector<int>* sel) {
+    int num_rows = batch->num_rows();
+    sel->resize(num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+        (*sel)[i] = i;
+    }
+    if (num_rows == 0 || ctxs->empty()) {
+        return num_rows;
+    }
+    int num_selected = ExprContext::filter_batch(*ctxs, batch, &(*sel)[0], num_rows);
+    ExprContext::free_local_allocations(*ctxs);
+    sel->resize(num_selected);
+    // the first conjunct filters every batch
+    if (config::conjunct_reorder_interval_batches > 0 && ctxs->size() > 1
+            && (*ctxs)[0]->conjunct_stats()->num_batches
+                >= config::conjunct_reorder_interval_batches) {
+        ExprContext::reorder_conjuncts(&(*ctxs)[0], ctxs->size());
+    }
+    return num_selected;
+}
+
 void ExecNode::collect_nodes(TPlanNodeType::type node_type, vector<ExecNode*>* nodes) {
     if (_type == node_type) {
         nodes->push_back(this);
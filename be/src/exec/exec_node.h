@@ -47,6 +47,7 @@ class RuntimeState;
 class TPlan;
 class TupleRow;
 class DataSink;
+class TopNRuntimeBound;
 class MemTracker;
 
 using std::string;
@@ -127,6 +128,13 @@ public:
     static Status create_tree(ObjectPool* pool, const TPlan& plan,
                              const DescriptorTbl& descs, ExecNode** root);
 
+    // Same as above. If 'prefer_spilling', aggregations and hash joins use their
+    // partitioned implementations, which can spill, regardless of the config, unless
+    // an aggregation uses COUNT_DISTINCT or SUM_DISTINCT, which can't spill.
+    static Status create_tree(ObjectPool* pool, const TPlan& plan,
+                             const DescriptorTbl& descs, bool prefer_spilling,
+                             ExecNode** root);
+
     // Set debug action for node with given id in 'tree'
     static void set_debug_options(int node_id, TExecNodePhase::type phase,
                                 TDebugAction::type action, ExecNode* tree);
@@ -144,11 +152,30 @@ public:
     // out how to deal with declaring a templated std:vector type in IR
     static bool eval_conjuncts(ExprContext* const* ctxs, int num_ctxs, TupleRow* row);
 
+    // Same as eval_conjuncts(), also measuring each expr for
+    // ExprContext::reorder_conjuncts(). Used on a sample of the rows.
+    static bool eval_conjuncts_with_stats(
+        ExprContext* const* ctxs, int num_ctxs, TupleRow* row);
+
+    // Evaluate exprs over all rows of batch at once. Sets sel to the indices of the rows
+    // for which all exprs return true, in ascending order, and returns their number.
+    // Every config::conjunct_reorder_interval_batches batches the exprs are reordered
+    // by their measured cost and pass rate, see ExprContext::reorder_conjuncts().
+    static int eval_conjuncts(std::vector<ExprContext*>* ctxs, RowBatch* batch,
+                              std::vector<int>* sel);
+
     // Returns a string representation in DFS order of the plan rooted at this.
     std::string debug_string() const;
 
     virtual void push_down_predicate(RuntimeState* state, std::list<ExprContext*>* expr_ctxs);
 
+    // Offers the runtime bound of a TopNNode on one of this node's output slots, see
+    // TopNRuntimeBound. Returns true if this node drops the rows that fail it; the
+    // caller keeps owning 'bound' and must outlive this node's scanning.
+    virtual bool push_down_topn_bound(TopNRuntimeBound* bound) {
+        return false;
+    }
+
     // recursive helper method for generating a string for Debug_string().
     // implementations should call debug_string(int, std::stringstream) on their children.
     // Input parameters:
@@ -276,6 +303,10 @@ protected:
     RuntimeProfile::Counter* _rows_returned_rate;
     // Account for peak memory used by this node
     RuntimeProfile::Counter* _memory_used_counter;
+    // Cpu time of the thread calling prepare(), open() and get_next(), like TotalTime
+    // it includes the children called from there. The rest of TotalTime was spent
+    // blocked, e.g. waiting for scanners or senders.
+    RuntimeProfile::Counter* _cpu_time_counter;
 
     // Execution options that are determined at runtime.  This is added to the
     // runtime profile at close().  Examples for options logged here would be
@@ -302,10 +333,12 @@ protected:
 
     // Create a single exec node derived from thrift node; place exec node in 'pool'.
     static Status create_node(ObjectPool* pool, const TPlanNode& tnode,
-                             const DescriptorTbl& descs, ExecNode** node);
+                             const DescriptorTbl& descs, bool prefer_spilling,
+                             ExecNode** node);
 
     static Status create_tree_helper(ObjectPool* pool, const std::vector<TPlanNode>& tnodes,
-                                   const DescriptorTbl& descs, ExecNode* parent, int* node_idx, ExecNode** root);
+                                   const DescriptorTbl& descs, bool prefer_spilling,
+                                   ExecNode* parent, int* node_idx, ExecNode** root);
 
     virtual bool is_scan_node() const {
         return false;
@@ -37,6 +37,15 @@ public:
     // is set to zero.
     virtual Status read(uint8_t* buf, size_t* buf_len, bool* eof) = 0;
 
+    // Reads 'nbytes' bytes at 'position' into 'out' without moving the position of
+    // read(). 'bytes_read' is set to the number of bytes read, which is less than
+    // 'nbytes' only at the end of the file. Used by the readers of columnar formats.
+    virtual Status readat(int64_t position, int64_t nbytes, int64_t* bytes_read,
+                          void* out) = 0;
+
+    // Sets 'size' to the size of the file.
+    virtual Status size(int64_t* size) = 0;
+
     virtual void close() = 0;
 };
 
@@ -23,12 +23,17 @@
 #include <sstream>
 
 #include "codegen/llvm_codegen.h"
+#include "common/config.h"
 #include "exec/hash_table.hpp"
 #include "exprs/expr.h"
 #include "exprs/in_predicate.h"
 #include "exprs/slot_ref.h"
+#include "runtime/exec_env.h"
+#include "runtime/mem_tracker.h"
 #include "runtime/row_batch.h"
 #include "runtime/runtime_state.h"
+#include "runtime/shared_hash_table_mgr.h"
+#include "util/blocking_aware_thread_pool.h"
 #include "util/debug_util.h"
 #include "util/runtime_profile.h"
 #include "gen_cpp/PlanNodes_types.h"
@@ -45,6 +50,7 @@ const char* HashJoinNode::_s_llvm_class_name = "class.palo::HashJoinNode";
 HashJoinNode::HashJoinNode(
         ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs) :
             ExecNode(pool, tnode, descs),
+            _is_shared_builder(false),
             _join_op(tnode.hash_join_node.join_op),
             _codegen_process_build_batch_fn(NULL),
             _process_build_batch_fn(NULL),
@@ -53,9 +59,17 @@ HashJoinNode::HashJoinNode(
     _match_all_probe =
         (_join_op == TJoinOp::LEFT_OUTER_JOIN || _join_op == TJoinOp::FULL_OUTER_JOIN);
     _match_one_build = (_join_op == TJoinOp::LEFT_SEMI_JOIN);
+    _is_left_semi_anti = (_join_op == TJoinOp::LEFT_SEMI_JOIN
+        || _join_op == TJoinOp::LEFT_ANTI_JOIN
+        || _join_op == TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN);
     _match_all_build =
         (_join_op == TJoinOp::RIGHT_OUTER_JOIN || _join_op == TJoinOp::FULL_OUTER_JOIN);
     _is_push_down = tnode.hash_join_node.is_push_down;
+    _is_broadcast = tnode.hash_join_node.__isset.is_broadcast
+        && tnode.hash_join_node.is_broadcast;
+    _is_colocate = tnode.hash_join_node.__isset.is_colocate
+        && tnode.hash_join_node.is_colocate;
+    _probe_prefetch_end = 0;
 }
 
 HashJoinNode::~HashJoinNode() {
@@ -67,6 +81,9 @@ Status HashJoinNode::init(const TPlanNode& tnode) {
     RETURN_IF_ERROR(ExecNode::init(tnode));
     DCHECK(tnode.__isset.hash_join_node);
     const vector<TEqJoinCondition>& eq_join_conjuncts = tnode.hash_join_node.eq_join_conjuncts;
+    if (_join_op == TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN && eq_join_conjuncts.size() != 1) {
+        return Status("null aware left anti join needs exactly one eq join conjunct");
+    }
 
     for (int i = 0; i < eq_join_conjuncts.size(); ++i) {
         ExprContext* ctx = NULL;
@@ -86,7 +103,22 @@ Status HashJoinNode::init(const TPlanNode& tnode) {
 Status HashJoinNode::prepare(RuntimeState* state) {
     RETURN_IF_ERROR(ExecNode::prepare(state));
 
-    _build_pool.reset(new MemPool(mem_tracker()));
+    // Every instance of a broadcast join receives the same build rows, so the instances
+    // on this backend only need one hash table. Joins that mark matched build rows
+    // write to it while probing and keep their own.
+    if (config::enable_shared_broadcast_hash_table && _is_broadcast
+            && child(1)->type() == TPlanNodeType::EXCHANGE_NODE
+            && !_match_all_build
+            && _join_op != TJoinOp::RIGHT_SEMI_JOIN
+            && _join_op != TJoinOp::RIGHT_ANTI_JOIN) {
+        _shared_hash_tbl = state->exec_env()->shared_hash_table_mgr()->register_instance(
+                state->query_id(), id(), state->shared_query_mem_tracker(),
+                &_is_shared_builder);
+    }
+    MemTracker* build_mem_tracker = _is_shared_builder
+        ? _shared_hash_tbl->mem_tracker() : mem_tracker();
+
+    _build_pool.reset(new MemPool(build_mem_tracker));
     _build_timer =
         ADD_TIMER(runtime_profile(), "BuildTime");
     _push_down_timer =
@@ -117,6 +149,10 @@ Status HashJoinNode::prepare(RuntimeState* state) {
 
     _result_tuple_row_size = _row_descriptor.tuple_descriptors().size() * sizeof(Tuple*);
 
+    if (_is_colocate) {
+        add_runtime_exec_option("Colocate Join");
+    }
+
     int num_left_tuples = child(0)->row_desc().tuple_descriptors().size();
     int num_build_tuples = child(1)->row_desc().tuple_descriptors().size();
     _probe_tuple_row_size = num_left_tuples * sizeof(Tuple*);
@@ -137,15 +173,26 @@ Status HashJoinNode::prepare(RuntimeState* state) {
     const bool stores_nulls = _join_op == TJoinOp::RIGHT_OUTER_JOIN
         || _join_op == TJoinOp::FULL_OUTER_JOIN
         || _join_op == TJoinOp::RIGHT_ANTI_JOIN
-        || _join_op == TJoinOp::RIGHT_SEMI_JOIN;
+        || _join_op == TJoinOp::RIGHT_SEMI_JOIN
+        || _join_op == TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN;
+    _probe_batch.reset(new RowBatch(child(0)->row_desc(), state->batch_size(), mem_tracker()));
+
+    if (_shared_hash_tbl != NULL && !_is_shared_builder) {
+        // _hash_tbl is created in open() once the builder is done, codegen would have
+        // to be done for it in prepare().
+        add_runtime_exec_option("Shared Hash Table Probed");
+        return Status::OK;
+    }
     _hash_tbl.reset(new HashTable(
             _build_expr_ctxs, _probe_expr_ctxs, _build_tuple_size,
-            stores_nulls, id(), mem_tracker(), 1024));
-
-    _probe_batch.reset(new RowBatch(child(0)->row_desc(), state->batch_size(), mem_tracker()));
+            stores_nulls, id(), build_mem_tracker, 1024));
+    if (_is_shared_builder) {
+        add_runtime_exec_option("Shared Hash Table Built");
+    }
 
     if (state->codegen_level() > 0) {
-        if (_join_op == TJoinOp::LEFT_ANTI_JOIN) {
+        if (_join_op == TJoinOp::LEFT_ANTI_JOIN
+                || _join_op == TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN) {
             return Status::OK;
         }
         LlvmCodeGen* codegen = NULL;
@@ -193,12 +240,23 @@ Status HashJoinNode::close(RuntimeState* state) {
         COUNTER_UPDATE(_memory_used_counter, _build_pool->peak_allocated_bytes());
         COUNTER_UPDATE(_memory_used_counter, _hash_tbl->byte_size());
     }
+    if (_shared_hash_tbl != NULL && _is_shared_builder) {
+        // The other instances may still be probing, they get an error if the build did
+        // not finish.
+        _shared_hash_tbl->publish(NULL, Status::CANCELLED);
+        _shared_hash_tbl->adopt(_hash_tbl.release(), _build_pool.release());
+    }
     if (_hash_tbl.get() != NULL) {
         _hash_tbl->close();
     }
     if (_build_pool.get() != NULL) {
         _build_pool->free_all();
     }
+    if (_shared_hash_tbl != NULL) {
+        state->exec_env()->shared_hash_table_mgr()->unregister_instance(
+                state->query_id(), id());
+        _shared_hash_tbl.reset();
+    }
 
     Expr::close(_build_expr_ctxs, state);
     Expr::close(_probe_expr_ctxs, state);
@@ -221,6 +279,29 @@ void HashJoinNode::build_side_thread(RuntimeState* state, boost::promise<Status>
 }
 
 Status HashJoinNode::construct_hash_table(RuntimeState* state) {
+    if (_shared_hash_tbl != NULL && !_is_shared_builder) {
+        // The build input is the same for all instances, so it is dropped here and
+        // the table built by another instance on this backend is probed instead.
+        RETURN_IF_ERROR(child(1)->close(state));
+        SCOPED_TIMER(_build_timer);
+        HashTable* hash_tbl = NULL;
+        RETURN_IF_ERROR(_shared_hash_tbl->wait_for_table(
+                state, _build_expr_ctxs, _probe_expr_ctxs, mem_tracker(), &hash_tbl));
+        _hash_tbl.reset(hash_tbl);
+        COUNTER_SET(_build_row_counter, _hash_tbl->size());
+        COUNTER_SET(_build_buckets_counter, _hash_tbl->num_buckets());
+        COUNTER_SET(_hash_tbl_load_factor_counter, _hash_tbl->load_factor());
+        return Status::OK;
+    }
+
+    Status status = build_hash_table(state);
+    if (_shared_hash_tbl != NULL) {
+        _shared_hash_tbl->publish(_hash_tbl.get(), status);
+    }
+    return status;
+}
+
+Status HashJoinNode::build_hash_table(RuntimeState* state) {
     // Do a full scan of child(1) and store everything in _hash_tbl
     // The hash join node needs to keep in memory all build tuples, including the tuple
     // row ptrs.  The row ptrs are copied into the hash table's internal structure so they
@@ -263,6 +344,7 @@ Status HashJoinNode::open(RuntimeState* state) {
     RETURN_IF_ERROR(ExecNode::open(state));
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::OPEN));
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_CANCELLED(state);
     RETURN_IF_ERROR(Expr::open(_build_expr_ctxs, state));
     RETURN_IF_ERROR(Expr::open(_probe_expr_ctxs, state));
@@ -293,19 +375,25 @@ Status HashJoinNode::open(RuntimeState* state) {
         // Blocks until ConstructHashTable has returned, after which
         // the hash table is fully constructed and we can start the probe
         // phase.
-        RETURN_IF_ERROR(thread_status.get_future().get());
+        boost::unique_future<Status> thread_status_future = thread_status.get_future();
+        {
+            BlockingAwareThreadPool::ScopedBlocking blocking;
+            thread_status_future.wait();
+        }
+        RETURN_IF_ERROR(thread_status_future.get());
 
         if (_hash_tbl->size() == 0 && _join_op == TJoinOp::INNER_JOIN) {
             // Hash table size is zero
             LOG(INFO) << "No element need to push down, no need to read probe table";
             RETURN_IF_ERROR(child(0)->open(state));
             _probe_batch_pos = 0;
+            _probe_prefetch_end = 0;
             _hash_tbl_iterator = _hash_tbl->begin();
             _eos = true;
             return Status::OK;
         }
 
-        if (_hash_tbl->size() > 500 * 1024) {
+        if (_hash_tbl->size() > config::runtime_filter_max_in_num) {
             _is_push_down = false;
         }
 
@@ -372,7 +460,12 @@ Status HashJoinNode::open(RuntimeState* state) {
         // Blocks until ConstructHashTable has returned, after which
         // the hash table is fully constructed and we can start the probe
         // phase.
-        RETURN_IF_ERROR(thread_status.get_future().get());
+        boost::unique_future<Status> thread_status_future = thread_status.get_future();
+        {
+            BlockingAwareThreadPool::ScopedBlocking blocking;
+            thread_status_future.wait();
+        }
+        RETURN_IF_ERROR(thread_status_future.get());
 
         // ISSUE-1247, check open_status after buildThread execute.
         // If this return first, build thread will use 'thread_status'
@@ -380,11 +473,16 @@ Status HashJoinNode::open(RuntimeState* state) {
         RETURN_IF_ERROR(open_status);
     }
 
+    if (_join_op == TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN) {
+        collect_null_aware_build_rows();
+    }
+
     // seed probe batch and _current_probe_row, etc.
     while (true) {
         RETURN_IF_ERROR(child(0)->get_next(state, _probe_batch.get(), &_probe_eos));
         COUNTER_UPDATE(_probe_row_counter, _probe_batch->num_rows());
         _probe_batch_pos = 0;
+        _probe_prefetch_end = 0;
 
         if (_probe_batch->num_rows() == 0) {
             if (_probe_eos) {
@@ -411,6 +509,7 @@ Status HashJoinNode::get_next(RuntimeState* state, RowBatch* out_batch, bool* eo
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
     RETURN_IF_CANCELLED(state);
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
 
     if (reached_limit()) {
         *eos = true;
@@ -456,6 +555,14 @@ Status HashJoinNode::get_next(RuntimeState* state, RowBatch* out_batch, bool* eo
                 continue;
             }
 
+            // right anti join without other join conjuncts: every build row with equal
+            // key is matched, there is no need to build the output row
+            if (num_other_conjunct_ctxs == 0 && _join_op == TJoinOp::RIGHT_ANTI_JOIN) {
+                _hash_tbl_iterator.set_matched();
+                _hash_tbl_iterator.next<true>();
+                continue;
+            }
+
             int row_idx = out_batch->add_row();
             TupleRow* out_row = out_batch->get_row(row_idx);
 
@@ -502,8 +609,8 @@ Status HashJoinNode::get_next(RuntimeState* state, RowBatch* out_batch, bool* eo
             _matched_probe = true;
 
             if (_match_all_build) {
-                // remember that we matched this build row
-                _joined_build_rows.insert(matched_build_row);
+                // remember that we matched this build row, in its node of the hash table
+                _hash_tbl_iterator.set_matched();
                 VLOG_ROW << "joined build row: " << matched_build_row;
             }
 
@@ -546,6 +653,7 @@ Status HashJoinNode::get_next(RuntimeState* state, RowBatch* out_batch, bool* eo
             // pass on resources, out_batch might still need them
             _probe_batch->transfer_resource_ownership(out_batch);
             _probe_batch_pos = 0;
+            _probe_prefetch_end = 0;
 
             if (out_batch->is_full() || out_batch->at_resource_limit()) {
                 return Status::OK;
@@ -613,12 +721,7 @@ Status HashJoinNode::get_next(RuntimeState* state, RowBatch* out_batch, bool* eo
         while (!out_batch->is_full() && _hash_tbl_iterator.has_next()) {
             build_row = _hash_tbl_iterator.get_row();
 
-            if (_match_all_build) {
-                if (_joined_build_rows.find(build_row) != _joined_build_rows.end()) {
-                    _hash_tbl_iterator.next<false>();
-                    continue;
-                }
-            } else if (_join_op == TJoinOp::RIGHT_ANTI_JOIN) {
+            if (_match_all_build || _join_op == TJoinOp::RIGHT_ANTI_JOIN) {
                 if (_hash_tbl_iterator.matched()) {
                     _hash_tbl_iterator.next<false>();
                     continue;
@@ -666,7 +769,11 @@ Status HashJoinNode::left_join_get_next(RuntimeState* state,
         }
 
         // Continue processing this row batch
-        if (_process_probe_batch_fn == NULL) {
+        if (_is_left_semi_anti) {
+            _num_rows_returned += process_left_semi_anti_probe_batch(
+                out_batch, _probe_batch.get(), max_added_rows);
+            COUNTER_SET(_rows_returned_counter, _num_rows_returned);
+        } else if (_process_probe_batch_fn == NULL) {
             _num_rows_returned +=
                 process_probe_batch(out_batch, _probe_batch.get(), max_added_rows);
             COUNTER_SET(_rows_returned_counter, _num_rows_returned);
@@ -686,6 +793,7 @@ Status HashJoinNode::left_join_get_next(RuntimeState* state,
         if (!_hash_tbl_iterator.has_next() && _probe_batch_pos == _probe_batch->num_rows()) {
             _probe_batch->transfer_resource_ownership(out_batch);
             _probe_batch_pos = 0;
+            _probe_prefetch_end = 0;
 
             if (out_batch->is_full() || out_batch->at_resource_limit()) {
                 break;
@@ -706,6 +814,123 @@ Status HashJoinNode::left_join_get_next(RuntimeState* state,
     return Status::OK;
 }
 
+int HashJoinNode::process_left_semi_anti_probe_batch(
+        RowBatch* out_batch, RowBatch* probe_batch, int max_added_rows) {
+    int row_idx = out_batch->add_rows(max_added_rows);
+    DCHECK(row_idx != RowBatch::INVALID_ROW_INDEX);
+    uint8_t* out_row_mem = reinterpret_cast<uint8_t*>(out_batch->get_row(row_idx));
+    TupleRow* out_row = reinterpret_cast<TupleRow*>(out_row_mem);
+
+    int rows_returned = 0;
+    int probe_rows = probe_batch->num_rows();
+
+    ExprContext* const* conjunct_ctxs = &_conjunct_ctxs[0];
+    int num_conjunct_ctxs = _conjunct_ctxs.size();
+
+    while (true) {
+        // _matched_probe is set once the current probe row is decided
+        if (!_matched_probe) {
+            TupleRow* matched_build_row = find_first_match(out_row);
+            bool output = false;
+            if (_join_op == TJoinOp::LEFT_SEMI_JOIN) {
+                output = (matched_build_row != NULL);
+            } else if (_join_op == TJoinOp::LEFT_ANTI_JOIN) {
+                output = (matched_build_row == NULL);
+            } else {
+                output = (matched_build_row == NULL && !null_aware_unknown(out_row));
+            }
+            _matched_probe = true;
+            _hash_tbl_iterator = _hash_tbl->end();
+
+            if (output) {
+                create_output_row(out_row, _current_probe_row, matched_build_row);
+                if (eval_conjuncts(conjunct_ctxs, num_conjunct_ctxs, out_row)) {
+                    ++rows_returned;
+                    if (UNLIKELY(rows_returned == max_added_rows)) {
+                        break;
+                    }
+                    out_row_mem += out_batch->row_byte_size();
+                    out_row = reinterpret_cast<TupleRow*>(out_row_mem);
+                }
+            }
+        }
+
+        // Advance to the next probe row
+        if (UNLIKELY(_probe_batch_pos == probe_rows)) {
+            break;
+        }
+        if (_probe_batch_pos >= _probe_prefetch_end) {
+            int num_rows = std::min(HashTable::PROBE_BATCH_SIZE, probe_rows - _probe_batch_pos);
+            _hash_tbl->prefetch_probe_rows(probe_batch, _probe_batch_pos, num_rows);
+            _probe_prefetch_end = _probe_batch_pos + num_rows;
+        }
+        _current_probe_row = probe_batch->get_row(_probe_batch_pos);
+        _hash_tbl_iterator = _hash_tbl->find_prefetched(_probe_batch_pos);
+        ++_probe_batch_pos;
+        _matched_probe = false;
+    }
+
+    out_batch->commit_rows(rows_returned);
+    return rows_returned;
+}
+
+TupleRow* HashJoinNode::find_first_match(TupleRow* out_row) {
+    ExprContext* const* other_conjunct_ctxs = &_other_join_conjunct_ctxs[0];
+    int num_other_conjunct_ctxs = _other_join_conjunct_ctxs.size();
+    while (_hash_tbl_iterator.has_next()) {
+        TupleRow* build_row = _hash_tbl_iterator.get_row();
+        if (num_other_conjunct_ctxs == 0) {
+            return build_row;
+        }
+        create_output_row(out_row, _current_probe_row, build_row);
+        if (eval_conjuncts(other_conjunct_ctxs, num_other_conjunct_ctxs, out_row)) {
+            return build_row;
+        }
+        _hash_tbl_iterator.next<true>();
+    }
+    return NULL;
+}
+
+bool HashJoinNode::null_aware_unknown(TupleRow* out_row) {
+    ExprContext* const* other_conjunct_ctxs = &_other_join_conjunct_ctxs[0];
+    int num_other_conjunct_ctxs = _other_join_conjunct_ctxs.size();
+
+    if (_probe_expr_ctxs[0]->get_value(_current_probe_row) != NULL) {
+        // 'x NOT IN (..., NULL, ...)' is NULL if x isn't in the list
+        for (TupleRow* build_row : _null_aware_build_rows) {
+            if (num_other_conjunct_ctxs == 0) {
+                return true;
+            }
+            create_output_row(out_row, _current_probe_row, build_row);
+            if (eval_conjuncts(other_conjunct_ctxs, num_other_conjunct_ctxs, out_row)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 'NULL NOT IN (...)' is NULL unless the list is empty
+    if (num_other_conjunct_ctxs == 0) {
+        return _hash_tbl->size() > 0;
+    }
+    for (HashTable::Iterator iter = _hash_tbl->begin(); iter.has_next(); iter.next<false>()) {
+        create_output_row(out_row, _current_probe_row, iter.get_row());
+        if (eval_conjuncts(other_conjunct_ctxs, num_other_conjunct_ctxs, out_row)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void HashJoinNode::collect_null_aware_build_rows() {
+    _null_aware_build_rows.clear();
+    for (HashTable::Iterator iter = _hash_tbl->begin(); iter.has_next(); iter.next<false>()) {
+        if (_build_expr_ctxs[0]->get_value(iter.get_row()) == NULL) {
+            _null_aware_build_rows.push_back(iter.get_row());
+        }
+    }
+}
+
 string HashJoinNode::get_probe_row_output_string(TupleRow* probe_row) {
     std::stringstream out;
     out << "[";
@@ -22,7 +22,6 @@
 #define BDG_PALO_BE_SRC_QUERY_EXEC_HASH_JOIN_NODE_H
 
 #include <boost/scoped_ptr.hpp>
-#include <boost/unordered_set.hpp>
 #include <boost/thread.hpp>
 #include <string>
 
@@ -34,6 +33,7 @@ namespace palo {
 
 class MemPool;
 class RowBatch;
+class SharedHashTable;
 class TupleRow;
 
 // Node for in-memory hash joins:
@@ -70,10 +70,20 @@ private:
     boost::scoped_ptr<HashTable> _hash_tbl;
     HashTable::Iterator _hash_tbl_iterator;
     bool _is_push_down;
+    // true if the build input is broadcast to all instances of this join
+    bool _is_broadcast;
+    // true if both children scan the tablets of the same buckets of colocated tables
+    bool _is_colocate;
 
-    // for right outer joins, keep track of what's been joined
-    typedef boost::unordered_set<TupleRow*> BuildTupleRowSet;
-    BuildTupleRowSet _joined_build_rows;
+    // Set if the instances of this join on this backend share one hash table. The
+    // builder fills _hash_tbl and hands it over in close(), the other instances
+    // don't read their build input and probe a read-only copy of it.
+    boost::shared_ptr<SharedHashTable> _shared_hash_tbl;
+    bool _is_shared_builder;
+
+    // For NULL_AWARE_LEFT_ANTI_JOIN, the build rows whose join key is NULL. They are
+    // in _hash_tbl too, which stores NULLs for this join.
+    std::vector<TupleRow*> _null_aware_build_rows;
 
     TJoinOp::type _join_op;
 
@@ -90,6 +100,8 @@ private:
     bool _match_all_probe;  // output all rows coming from the probe input
     bool _match_one_build;  // match at most one build row to each probe row
     bool _match_all_build;  // output all rows coming from the build input
+    // LEFT SEMI/ANTI join, the first build row matched decides each probe row
+    bool _is_left_semi_anti;
 
     bool _matched_probe;  // if true, we have matched the current probe row
     bool _eos;  // if true, nothing left to return in get_next()
@@ -106,6 +118,8 @@ private:
     // is responsible for.
     boost::scoped_ptr<RowBatch> _probe_batch;
     int _probe_batch_pos;  // current scan pos in _probe_batch
+    // the rows of _probe_batch before this pos are prefetched in _hash_tbl
+    int _probe_prefetch_end;
     bool _probe_eos;  // if true, probe child has no more rows to process
     TupleRow* _current_probe_row;
 
@@ -152,6 +166,10 @@ private:
     // same time.
     Status construct_hash_table(RuntimeState* state);
 
+    // Reads child(1) into _hash_tbl, called by construct_hash_table() unless this
+    // instance probes the hash table of another one.
+    Status build_hash_table(RuntimeState* state);
+
     // GetNext helper function for the common join cases: Inner join, left semi and left
     // outer
     Status left_join_get_next(RuntimeState* state, RowBatch* row_batch, bool* eos);
@@ -164,6 +182,26 @@ private:
     // return the number of rows added to out_batch
     int process_probe_batch(RowBatch* out_batch, RowBatch* probe_batch, int max_added_rows);
 
+    // Processes a probe batch of LEFT SEMI/ANTI joins and NULL_AWARE_LEFT_ANTI_JOIN,
+    // which only walk the bucket chain of a probe row up to its first match. Same
+    // arguments as process_probe_batch().
+    int process_left_semi_anti_probe_batch(
+            RowBatch* out_batch, RowBatch* probe_batch, int max_added_rows);
+
+    // Returns the first build row with equal key to _current_probe_row, from
+    // _hash_tbl_iterator on, which satisfies the other join conjuncts, NULL if none.
+    // 'out_row' is scratch space to evaluate the conjuncts.
+    TupleRow* find_first_match(TupleRow* out_row);
+
+    // Returns true if 'NOT IN' of _current_probe_row is unknown, so the probe row is
+    // not returned by NULL_AWARE_LEFT_ANTI_JOIN even though it has no equal build row:
+    // its key is NULL and there is any build row, or there is a build row with
+    // NULL key. Build rows have to satisfy the other join conjuncts.
+    bool null_aware_unknown(TupleRow* out_row);
+
+    // Collects _null_aware_build_rows from the built _hash_tbl.
+    void collect_null_aware_build_rows();
+
     // Construct the build hash table, adding all the rows in 'build_batch'
     void process_build_batch(RowBatch* build_batch);
 
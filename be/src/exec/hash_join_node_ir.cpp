@@ -124,8 +124,17 @@ int HashJoinNode::process_probe_batch(RowBatch* out_batch, RowBatch* probe_batch
                 goto end;
             }
 
-            _current_probe_row = probe_batch->get_row(_probe_batch_pos++);
-            _hash_tbl_iterator = _hash_tbl->find(_current_probe_row);
+            if (_probe_batch_pos >= _probe_prefetch_end) {
+                // Evaluates and hashes the next rows together, so that the cache misses
+                // of their lookups overlap.
+                int num_rows = std::min(HashTable::PROBE_BATCH_SIZE, probe_rows - _probe_batch_pos);
+                _hash_tbl->prefetch_probe_rows(probe_batch, _probe_batch_pos, num_rows);
+                _probe_prefetch_end = _probe_batch_pos + num_rows;
+            }
+
+            _current_probe_row = probe_batch->get_row(_probe_batch_pos);
+            _hash_tbl_iterator = _hash_tbl->find_prefetched(_probe_batch_pos);
+            ++_probe_batch_pos;
             _matched_probe = false;
         }
     }
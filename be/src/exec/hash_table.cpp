@@ -22,6 +22,7 @@
 
 #include "codegen/codegen_anyval.h"
 #include "codegen/llvm_codegen.h"
+#include "common/config.h"
 
 #include "exprs/expr.h"
 #include "runtime/raw_value.h"
@@ -29,6 +30,7 @@
 #include "runtime/mem_tracker.h"
 #include "runtime/runtime_state.h"
 #include "util/debug_util.h"
+#include "util/huge_page_allocator.h"
 #include "util/palo_metrics.h"
 
 using llvm::BasicBlock;
@@ -42,8 +44,18 @@ using llvm::PHINode;
 namespace palo {
 
 const float HashTable::MAX_BUCKET_OCCUPANCY_FRACTION = 0.75f;
+const int HashTable::PROBE_BATCH_SIZE;
 const char* HashTable::_s_llvm_class_name = "class.palo::HashTable";
 
+static int first_string_expr_idx(const vector<ExprContext*>& expr_ctxs) {
+    for (int i = 0; i < expr_ctxs.size(); ++i) {
+        if (expr_ctxs[i]->root()->type().is_string_type()) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 HashTable::HashTable(const vector<ExprContext*>& build_expr_ctxs,
                      const vector<ExprContext*>& probe_expr_ctxs,
                      int num_build_tuples, bool stores_nulls, int32_t initial_seed,
@@ -53,31 +65,37 @@ HashTable::HashTable(const vector<ExprContext*>& build_expr_ctxs,
         _num_build_tuples(num_build_tuples),
         _stores_nulls(stores_nulls),
         _initial_seed(initial_seed),
-        _node_byte_size(sizeof(Node) + sizeof(Tuple*) * _num_build_tuples),
+        _string_key_idx(config::enable_string_key_prefix
+                ? first_string_expr_idx(build_expr_ctxs) : -1),
+        _node_byte_size(sizeof(Node) + sizeof(Tuple*) * _num_build_tuples
+                + (_string_key_idx != -1 ? sizeof(StringValuePrefix) : 0)),
         _num_filled_buckets(0),
         _nodes(NULL),
         _num_nodes(0),
         _exceeded_limit(false),
         _mem_tracker(mem_tracker),
-        _mem_limit_exceeded(false) {
+        _mem_limit_exceeded(false),
+        _owns_nodes(true),
+        _string_key_equal(false) {
     DCHECK(mem_tracker != NULL);
     DCHECK_EQ(_build_expr_ctxs.size(), _probe_expr_ctxs.size());
 
     DCHECK_EQ((num_buckets & (num_buckets - 1)), 0) << "num_buckets must be a power of 2";
-    _buckets.resize(num_buckets);
     _num_buckets = num_buckets;
+    _buckets = reinterpret_cast<Bucket*>(
+            HugePageAllocator::allocate(_num_buckets * sizeof(Bucket)));
+    // all bits set is node index -1 of an empty bucket
+    memset(_buckets, 0xff, _num_buckets * sizeof(Bucket));
+    _old_bucket_mask = _num_buckets - 1;
+    _num_split_buckets = _num_buckets;
     _num_buckets_till_resize = MAX_BUCKET_OCCUPANCY_FRACTION * _num_buckets;
-    _mem_tracker->consume(_buckets.capacity() * sizeof(Bucket));
+    _mem_tracker->consume(_num_buckets * sizeof(Bucket));
 
-    // Compute the layout and buffer size to store the evaluated expr results
-    _results_buffer_size = Expr::compute_results_layout(_build_expr_ctxs,
-                           &_expr_values_buffer_offsets, &_var_result_begin);
-    _expr_values_buffer = new uint8_t[_results_buffer_size];
-    memset(_expr_values_buffer, 0, sizeof(uint8_t) * _results_buffer_size);
-    _expr_value_null_bits = new uint8_t[_build_expr_ctxs.size()];
+    init_expr_values_buffer();
 
     _nodes_capacity = 1024;
-    _nodes = reinterpret_cast<uint8_t*>(malloc(_nodes_capacity * _node_byte_size));
+    _nodes = reinterpret_cast<uint8_t*>(
+            HugePageAllocator::allocate(_nodes_capacity * _node_byte_size));
     memset(_nodes, 0, _nodes_capacity * _node_byte_size);
 
     if (PaloMetrics::hash_table_total_bytes() != NULL) {
@@ -90,20 +108,71 @@ HashTable::HashTable(const vector<ExprContext*>& build_expr_ctxs,
     }
 }
 
+HashTable::HashTable(const HashTable& shared,
+                     const vector<ExprContext*>& build_expr_ctxs,
+                     const vector<ExprContext*>& probe_expr_ctxs,
+                     MemTracker* mem_tracker) :
+        _build_expr_ctxs(build_expr_ctxs),
+        _probe_expr_ctxs(probe_expr_ctxs),
+        _num_build_tuples(shared._num_build_tuples),
+        _stores_nulls(shared._stores_nulls),
+        _initial_seed(shared._initial_seed),
+        _string_key_idx(shared._string_key_idx),
+        _node_byte_size(shared._node_byte_size),
+        _num_filled_buckets(shared._num_filled_buckets),
+        _nodes(shared._nodes),
+        _num_nodes(shared._num_nodes),
+        _nodes_capacity(shared._nodes_capacity),
+        _exceeded_limit(false),
+        _mem_tracker(mem_tracker),
+        _mem_limit_exceeded(false),
+        _num_buckets(shared._num_buckets),
+        _old_bucket_mask(shared._old_bucket_mask),
+        _num_split_buckets(shared._num_split_buckets),
+        _num_buckets_till_resize(shared._num_buckets_till_resize),
+        _owns_nodes(false),
+        _string_key_equal(false) {
+    DCHECK(mem_tracker != NULL);
+    DCHECK_EQ(_build_expr_ctxs.size(), _probe_expr_ctxs.size());
+    // A resize in progress is copied as well, 'shared' doesn't split any bucket anymore.
+    _buckets = reinterpret_cast<Bucket*>(
+            HugePageAllocator::allocate(_num_buckets * sizeof(Bucket)));
+    memcpy(_buckets, shared._buckets, _num_buckets * sizeof(Bucket));
+    _mem_tracker->consume(_num_buckets * sizeof(Bucket));
+    init_expr_values_buffer();
+}
+
 HashTable::~HashTable() {
 }
 
+void HashTable::init_expr_values_buffer() {
+    // Compute the layout and buffer size to store the evaluated expr results
+    _results_buffer_size = Expr::compute_results_layout(_build_expr_ctxs,
+                           &_expr_values_buffer_offsets, &_var_result_begin);
+    _expr_values_buffer = new uint8_t[_results_buffer_size];
+    memset(_expr_values_buffer, 0, sizeof(uint8_t) * _results_buffer_size);
+    _expr_value_null_bits = new uint8_t[_build_expr_ctxs.size()];
+    _probe_values_cache =
+        new uint8_t[PROBE_BATCH_SIZE * (_results_buffer_size + _build_expr_ctxs.size())];
+    _probe_prefetch_start = 0;
+}
+
 void HashTable::close() {
     // TODO: use tr1::array?
     delete[] _expr_values_buffer;
     delete[] _expr_value_null_bits;
-    free(_nodes);
+    delete[] _probe_values_cache;
+    HugePageAllocator::free(_buckets, _num_buckets * sizeof(Bucket));
+    _mem_tracker->release(_num_buckets * sizeof(Bucket));
+    if (!_owns_nodes) {
+        return;
+    }
+    HugePageAllocator::free(_nodes, _nodes_capacity * _node_byte_size);
 
     if (PaloMetrics::hash_table_total_bytes() != NULL) {
         PaloMetrics::hash_table_total_bytes()->increment(-_nodes_capacity * _node_byte_size);
     }
     _mem_tracker->release(_nodes_capacity * _node_byte_size);
-    _mem_tracker->release(_buckets.size() * sizeof(Bucket));
 }
 
 bool HashTable::eval_row(TupleRow* row, const vector<ExprContext*>& ctxs) {
@@ -144,7 +213,7 @@ uint32_t HashTable::hash_variable_len_row() {
     uint32_t hash = _initial_seed;
     // Hash the non-var length portions (if there are any)
     if (_var_result_begin != 0) {
-        hash = HashUtil::hash(_expr_values_buffer, _var_result_begin, hash);
+        hash = HashUtil::fast_hash(_expr_values_buffer, _var_result_begin, hash);
     }
 
     for (int i = 0; i < _build_expr_ctxs.size(); ++i) {
@@ -154,20 +223,21 @@ uint32_t HashTable::hash_variable_len_row() {
 
             if (_expr_value_null_bits[i]) {
                 // Hash the null random seed values at 'loc'
-                hash = HashUtil::hash(loc, sizeof(StringValue), hash);
+                hash = HashUtil::fast_hash(loc, sizeof(StringValue), hash);
             } else {
                 // Hash the string
                 StringValue* str = reinterpret_cast<StringValue*>(loc);
-                hash = HashUtil::hash(str->ptr, str->len, hash);
+                hash = HashUtil::fast_hash(str->ptr, str->len, hash);
             }
         } else if (_build_expr_ctxs[i]->root()->type().is_decimal_type()) {
             void* loc = _expr_values_buffer + _expr_values_buffer_offsets[i];
             if (_expr_value_null_bits[i]) {
                 // Hash the null random seed values at 'loc'
-                hash = HashUtil::hash(loc, sizeof(StringValue), hash);
+                hash = HashUtil::fast_hash(loc, sizeof(StringValue), hash);
             } else {
                 DecimalValue* decimal = reinterpret_cast<DecimalValue*>(loc);
-                hash = decimal->hash(hash);
+                uint64_t decimal_hash = decimal->fast_hash64(hash);
+                hash = (uint32_t)(decimal_hash ^ (decimal_hash >> 32));
             }
         }
 
@@ -178,6 +248,9 @@ uint32_t HashTable::hash_variable_len_row() {
 
 bool HashTable::equals(TupleRow* build_row) {
     for (int i = 0; i < _build_expr_ctxs.size(); ++i) {
+        if (i == _string_key_idx && _string_key_equal) {
+            continue;
+        }
         void* val = _build_expr_ctxs[i]->get_value(build_row);
 
         if (val == NULL) {
@@ -206,6 +279,9 @@ bool HashTable::equals(TupleRow* build_row) {
 void HashTable::resize_buckets(int64_t num_buckets) {
     DCHECK_EQ((num_buckets & (num_buckets - 1)), 0) << "num_buckets must be a power of 2";
 
+    // Finish a resize still in progress first.
+    split_buckets(_old_bucket_mask + 1 - _num_split_buckets);
+
     int64_t old_num_buckets = _num_buckets;
     int64_t delta_bytes = (num_buckets - old_num_buckets) * sizeof(Bucket);
     if (!_mem_tracker->try_consume(delta_bytes)) {
@@ -213,39 +289,66 @@ void HashTable::resize_buckets(int64_t num_buckets) {
         return;
     }
 
-    _buckets.resize(num_buckets);
-
     // If we're doubling the number of buckets, all nodes in a particular bucket
     // either remain there, or move down to an analogous bucket in the other half.
     // In order to efficiently check which of the two buckets a node belongs in, the number
-    // of buckets must be a power of 2.
-    bool doubled_buckets = (num_buckets == old_num_buckets * 2);
+    // of buckets must be a power of 2. This is done one old bucket after another,
+    // bucket_idx() finds the nodes of the ones not split yet in the old half.
+    if (num_buckets == old_num_buckets * 2) {
+        // The old buckets are not copied if the array is mapped.
+        _buckets = reinterpret_cast<Bucket*>(HugePageAllocator::reallocate(
+                _buckets, old_num_buckets * sizeof(Bucket), num_buckets * sizeof(Bucket)));
+        memset(_buckets + old_num_buckets, 0xff, delta_bytes);
+        _num_buckets = num_buckets;
+        _num_buckets_till_resize = MAX_BUCKET_OCCUPANCY_FRACTION * _num_buckets;
+        _old_bucket_mask = old_num_buckets - 1;
+        _num_split_buckets = 0;
+        if (!config::enable_incremental_hash_table_resize) {
+            split_buckets(old_num_buckets);
+        }
+        return;
+    }
+
+    // Otherwise chain all nodes into a new bucket array.
+    Bucket* old_buckets = _buckets;
+    _buckets = reinterpret_cast<Bucket*>(
+            HugePageAllocator::allocate(num_buckets * sizeof(Bucket)));
+    memset(_buckets, 0xff, num_buckets * sizeof(Bucket));
+    _num_filled_buckets = 0;
+    for (int64_t i = 0; i < old_num_buckets; ++i) {
+        int64_t node_idx = old_buckets[i]._node_idx;
+
+        while (node_idx != -1) {
+            Node* node = get_node(node_idx);
+            int64_t next_idx = node->_next_idx;
+            add_to_bucket(&_buckets[node->_hash & (num_buckets - 1)], node_idx, node);
+            node_idx = next_idx;
+        }
+    }
+    HugePageAllocator::free(old_buckets, old_num_buckets * sizeof(Bucket));
+
+    _num_buckets = num_buckets;
+    _num_buckets_till_resize = MAX_BUCKET_OCCUPANCY_FRACTION * _num_buckets;
+    _old_bucket_mask = _num_buckets - 1;
+    _num_split_buckets = _num_buckets;
+}
+
+void HashTable::split_buckets(int64_t num_buckets) {
+    int64_t old_num_buckets = _old_bucket_mask + 1;
+    int64_t end = std::min(_num_split_buckets + num_buckets, old_num_buckets);
 
-    for (int i = 0; i < _num_buckets; ++i) {
+    for (int64_t i = _num_split_buckets; i < end; ++i) {
         Bucket* bucket = &_buckets[i];
         Bucket* sister_bucket = &_buckets[i + old_num_buckets];
         Node* last_node = NULL;
-        int node_idx = bucket->_node_idx;
+        int64_t node_idx = bucket->_node_idx;
 
         while (node_idx != -1) {
             Node* node = get_node(node_idx);
             int64_t next_idx = node->_next_idx;
-            uint32_t hash = node->_hash;
 
-            bool node_must_move = true;
-            Bucket* move_to = NULL;
-
-            if (doubled_buckets) {
-                node_must_move = ((hash & old_num_buckets) != 0);
-                move_to = sister_bucket;
-            } else {
-                int64_t bucket_idx = hash & (num_buckets - 1);
-                node_must_move = (bucket_idx != i);
-                move_to = &_buckets[bucket_idx];
-            }
-
-            if (node_must_move) {
-                move_node(bucket, move_to, node_idx, node, last_node);
+            if ((node->_hash & old_num_buckets) != 0) {
+                move_node(bucket, sister_bucket, node_idx, node, last_node);
             } else {
                 last_node = node;
             }
@@ -254,8 +357,11 @@ void HashTable::resize_buckets(int64_t num_buckets) {
         }
     }
 
-    _num_buckets = num_buckets;
-    _num_buckets_till_resize = MAX_BUCKET_OCCUPANCY_FRACTION * _num_buckets;
+    _num_split_buckets = end;
+    if (_num_split_buckets == old_num_buckets) {
+        _old_bucket_mask = _num_buckets - 1;
+        _num_split_buckets = _num_buckets;
+    }
 }
 
 void HashTable::grow_node_array() {
@@ -263,11 +369,9 @@ void HashTable::grow_node_array() {
     _nodes_capacity = _nodes_capacity + _nodes_capacity / 2;
     int64_t new_size = _nodes_capacity * _node_byte_size;
 
-    uint8_t* new_nodes = reinterpret_cast<uint8_t*>(malloc(new_size));
-    memset(new_nodes, 0, new_size);
-    memcpy(new_nodes, _nodes, old_size);
-    free(_nodes);
-    _nodes = new_nodes; 
+    _nodes = reinterpret_cast<uint8_t*>(
+            HugePageAllocator::reallocate(_nodes, old_size, new_size));
+    memset(_nodes + old_size, 0, new_size - old_size);
 
     if (PaloMetrics::hash_table_total_bytes() != NULL) {
         PaloMetrics::hash_table_total_bytes()->increment(new_size - old_size);
@@ -291,7 +395,7 @@ std::string HashTable::debug_string(bool skip_empty, const RowDescriptor* desc)
     std::stringstream ss;
     ss << std::endl;
 
-    for (int i = 0; i < _buckets.size(); ++i) {
+    for (int64_t i = 0; i < _num_buckets; ++i) {
         int64_t node_idx = _buckets[i]._node_idx;
         bool first = true;
 
@@ -515,13 +619,13 @@ Function* HashTable::codegen_eval_tuple_row(RuntimeState* state, bool build) {
 // (group by int_col, string_col), the IR looks like:
 // define i32 @hash_current_row(%"class.impala::HashTable"* %this_ptr) {
 // entry:
-//   %0 = call i32 @IrCrcHash(i8* inttoptr (i64 51107808 to i8*), i32 16, i32 0)
+//   %0 = call i32 @ir_fast_hash(i8* inttoptr (i64 51107808 to i8*), i32 16, i32 0)
 //   %1 = load i8* inttoptr (i64 29500112 to i8*)
 //   %2 = icmp ne i8 %1, 0
 //   br i1 %2, label %null, label %not_null
 //
 // null:                                             ; preds = %entry
-//   %3 = call i32 @IrCrcHash(i8* inttoptr (i64 51107824 to i8*), i32 16, i32 %0)
+//   %3 = call i32 @ir_fast_hash(i8* inttoptr (i64 51107824 to i8*), i32 16, i32 %0)
 //   br label %continue
 //
 // not_null:                                         ; preds = %entry
@@ -531,7 +635,7 @@ Function* HashTable::codegen_eval_tuple_row(RuntimeState* state, bool build) {
 //   %5 = load i32* getelementptr inbounds (
 //        %"struct.impala::StringValue"* inttoptr
 //          (i64 51107824 to %"struct.impala::StringValue"*), i32 0, i32 1)
-//   %6 = call i32 @IrCrcHash(i8* %4, i32 %5, i32 %0)
+//   %6 = call i32 @ir_fast_hash(i8* %4, i32 %5, i32 %0)
 //   br label %continue
 //
 // continue:                                         ; preds = %not_null, %null
@@ -570,13 +674,13 @@ Function* HashTable::codegen_hash_current_row(RuntimeState* state) {
     if (_var_result_begin == -1) {
         // No variable length slots, just hash what is in '_expr_values_buffer'
         if (_results_buffer_size > 0) {
-            Function* hash_fn = codegen->get_hash_function(_results_buffer_size);
+            Function* hash_fn = codegen->get_function(IRFunction::HASH_FAST);
             Value* len = codegen->get_int_constant(TYPE_INT, _results_buffer_size);
             hash_result = builder.CreateCall3(hash_fn, data, len, hash_result);
         }
     } else {
         if (_var_result_begin > 0) {
-            Function* hash_fn = codegen->get_hash_function(_var_result_begin);
+            Function* hash_fn = codegen->get_function(IRFunction::HASH_FAST);
             Value* len = codegen->get_int_constant(TYPE_INT, _var_result_begin);
             hash_result = builder.CreateCall3(hash_fn, data, len, hash_result);
         }
@@ -613,7 +717,7 @@ Function* HashTable::codegen_hash_current_row(RuntimeState* state) {
                 // For null, we just want to call the hash function on the portion of
                 // the data
                 builder.SetInsertPoint(null_block);
-                Function* null_hash_fn = codegen->get_hash_function(sizeof(StringValue));
+                Function* null_hash_fn = codegen->get_function(IRFunction::HASH_FAST);
                 Value* llvm_loc = codegen->cast_ptr_to_llvm_ptr(codegen->ptr_type(), loc);
                 Value* len = codegen->get_int_constant(TYPE_INT, sizeof(StringValue));
                 str_null_result = builder.CreateCall3(null_hash_fn, llvm_loc, len, hash_result);
@@ -632,7 +736,7 @@ Function* HashTable::codegen_hash_current_row(RuntimeState* state) {
             len = builder.CreateLoad(len);
 
             // Call hash(ptr, len, hash_result);
-            Function* general_hash_fn = codegen->get_hash_function();
+            Function* general_hash_fn = codegen->get_function(IRFunction::HASH_FAST);
             Value* string_hash_result =
                 builder.CreateCall3(general_hash_fn, ptr, len, hash_result);
 
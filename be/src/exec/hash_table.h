@@ -25,7 +25,9 @@
 #include <boost/cstdint.hpp>
 
 #include "codegen/palo_ir.h"
+#include "common/config.h"
 #include "common/logging.h"
+#include "runtime/string_value.h"
 #include "util/hash_util.hpp"
 
 namespace llvm {
@@ -39,6 +41,7 @@ namespace palo {
 class Expr;
 class ExprContext;
 class LlvmCodeGen;
+class RowBatch;
 class RowDescriptor;
 class Tuple;
 class TupleRow;
@@ -105,6 +108,18 @@ public:
         MemTracker* mem_tracker,
         int64_t num_buckets);
 
+    // Create a read-only copy of 'shared' that is probed with 'probe_exprs', so that
+    // several fragment instances can probe the same build rows. Only the buckets are
+    // copied, the nodes and the build rows they point to stay owned by 'shared', which
+    // must not be modified anymore and must not be closed while the copy is in use
+    // (see SharedHashTable).
+    // insert() and Iterator::set_matched() must not be called on the copy.
+    HashTable(
+        const HashTable& shared,
+        const std::vector<ExprContext*>& build_exprs,
+        const std::vector<ExprContext*>& probe_exprs,
+        MemTracker* mem_tracker);
+
     ~HashTable();
 
     // Call to cleanup any resources. Must be called once.
@@ -113,6 +128,10 @@ public:
     // Insert row into the hash table.  Row will be evaluated over _build_expr_ctxs
     // This will grow the hash table if necessary
     void IR_ALWAYS_INLINE insert(TupleRow* row) {
+        DCHECK(_owns_nodes);
+        if (_num_split_buckets <= _old_bucket_mask) {
+            split_buckets(config::hash_table_split_buckets_per_insert);
+        }
         if (_num_filled_buckets > _num_buckets_till_resize) {
             // TODO: next prime instead of double?
             resize_buckets(_num_buckets * 2);
@@ -132,6 +151,21 @@ public:
     // Returns HashTable::end() if there is no match.
     Iterator IR_ALWAYS_INLINE find(TupleRow* probe_row);
 
+    // Max number of probe rows prefetch_probe_rows() handles at one time.
+    static const int PROBE_BATCH_SIZE = 64;
+
+    // Batched version of find(). Evaluates the probe exprs over rows
+    // [start_idx, start_idx + num_rows) of 'batch', caches the results and the hashes,
+    // and then prefetches the buckets and the first node of each bucket, so the cache
+    // misses of the lookups overlap instead of being paid one after the other.
+    // num_rows must not be larger than PROBE_BATCH_SIZE.
+    void IR_ALWAYS_INLINE prefetch_probe_rows(RowBatch* batch, int start_idx, int num_rows);
+
+    // Same as find() for the row at 'row_idx' of the batch passed to the last
+    // prefetch_probe_rows(), which must be in the prefetched range. The probe exprs
+    // are not evaluated again.
+    Iterator IR_ALWAYS_INLINE find_prefetched(int row_idx);
+
     // Returns number of elements in the hash table
     int64_t size() {
         return _num_nodes;
@@ -139,7 +173,7 @@ public:
 
     // Returns the number of buckets
     int64_t num_buckets() {
-        return _buckets.size();
+        return _num_buckets;
     }
 
     // true if any of the MemTrackers was exceeded
@@ -149,12 +183,12 @@ public:
 
     // Returns the load factor (the number of non-empty buckets)
     float load_factor() {
-        return _num_filled_buckets / static_cast<float>(_buckets.size());
+        return _num_filled_buckets / static_cast<float>(_num_buckets);
     }
 
     // Returns the number of bytes allocated to the hash table
     int64_t byte_size() const {
-        return _node_byte_size * _nodes_capacity + sizeof(Bucket) * _buckets.size();
+        return _node_byte_size * _nodes_capacity + sizeof(Bucket) * _num_buckets;
     }
 
     // Returns the results of the exprs at 'expr_idx' evaluated over the last row
@@ -313,12 +347,30 @@ private:
         return reinterpret_cast<Node*>(_nodes + _node_byte_size * idx);
     }
 
-    // Resize the hash table to 'num_buckets'
+    // Returns the index of the bucket of 'hash', which is in the old half of the buckets
+    // if it hasn't been split yet.
+    int64_t bucket_idx(uint32_t hash) const {
+        int64_t idx = hash & _old_bucket_mask;
+        if (idx < _num_split_buckets) {
+            idx = hash & (_num_buckets - 1);
+        }
+        return idx;
+    }
+
+    // Resize the hash table to 'num_buckets'. If it doubles the buckets and
+    // config::enable_incremental_hash_table_resize is set, the old buckets are only
+    // split into their sister bucket by the following calls to split_buckets().
     void resize_buckets(int64_t num_buckets);
 
+    // Splits up to 'num_buckets' more of the old buckets of a resize in progress.
+    void split_buckets(int64_t num_buckets);
+
     // Insert row into the hash table
     void IR_ALWAYS_INLINE insert_impl(TupleRow* row);
 
+    // Returns the first node matching the values in '_expr_values_buffer' with 'hash'
+    Iterator IR_ALWAYS_INLINE find_with_hash(uint32_t hash);
+
     // Chains the node at 'node_idx' to 'bucket'.  Nodes in a bucket are chained
     // as a linked list; this places the new node at the beginning of the list.
     void add_to_bucket(Bucket* bucket, int64_t node_idx, Node* node);
@@ -355,7 +407,8 @@ private:
         if (_var_result_begin == -1) {
             // This handles NULLs implicitly since a constant seed value was put
             // into results buffer for nulls.
-            return HashUtil::hash(_expr_values_buffer, _results_buffer_size, _initial_seed);
+            return HashUtil::fast_hash(
+                _expr_values_buffer, _results_buffer_size, _initial_seed);
         } else {
             return hash_variable_len_row();
         }
@@ -370,9 +423,41 @@ private:
     // This will be replaced by codegen.
     bool equals(TupleRow* build_row);
 
+    // Returns the prefix of the string key of the build row of 'node', which follows
+    // the row's Tuple*'s. Only valid if _string_key_idx != -1.
+    StringValuePrefix* string_key_prefix(Node* node) {
+        return reinterpret_cast<StringValuePrefix*>(
+                reinterpret_cast<uint8_t*>(node) + sizeof(Node)
+                + sizeof(Tuple*) * _num_build_tuples);
+    }
+
+    // Compares the string key prefix of 'node' with the one of the probe row in
+    // _expr_values_buffer. Returns false if the keys differ. If the prefixes hold both
+    // keys completely and they are equal, sets _string_key_equal so that equals()
+    // doesn't compare the string data again.
+    bool IR_ALWAYS_INLINE string_key_may_eq(Node* node);
+
+    // Returns true if 'node' matches the probe row in _expr_values_buffer with 'hash'.
+    // Not named like equals(), whose call sites codegen replaces by name.
+    bool IR_ALWAYS_INLINE node_matches(Node* node, uint32_t hash) {
+        return node->_hash == hash && string_key_may_eq(node) && equals(node->data());
+    }
+
+    // The prefix of the value of the string key in _expr_values_buffer.
+    StringValuePrefix current_string_key_prefix() {
+        if (_expr_value_null_bits[_string_key_idx]) {
+            return StringValuePrefix();
+        }
+        return StringValuePrefix(*reinterpret_cast<StringValue*>(
+                _expr_values_buffer + _expr_values_buffer_offsets[_string_key_idx]));
+    }
+
     // Grow the node array.
     void grow_node_array();
 
+    // Allocates the buffers for evaluated expr results of _build_expr_ctxs.
+    void init_expr_values_buffer();
+
     // Sets _mem_tracker_exceeded to true and MEM_LIMIT_EXCEEDED for the query.
     // allocation_size is the attempted size of the allocation that would have
     // brought us over the mem limit.
@@ -391,6 +476,11 @@ private:
 
     const int32_t _initial_seed;
 
+    // Index of the first build expr of a string type, -1 if there is none or
+    // config::enable_string_key_prefix is off. Each node keeps the StringValuePrefix of
+    // its value after the Tuple*'s.
+    const int _string_key_idx;
+
     // Size of hash table nodes.  This includes a fixed size header and the Tuple*'s that
     // follow.
     const int _node_byte_size;
@@ -412,11 +502,18 @@ private:
     // subsequent calls to Insert() will be ignored.
     bool _mem_limit_exceeded;
 
-    std::vector<Bucket> _buckets;
+    // Allocated by HugePageAllocator
+    Bucket* _buckets;
 
-    // equal to _buckets.size() but more efficient than the size function
     int64_t _num_buckets;
 
+    // While the buckets are doubled from n to 2n, only the first _num_split_buckets of
+    // the old n buckets are split, the others still hold the nodes of their sister
+    // bucket. _old_bucket_mask is n - 1 then. Otherwise _old_bucket_mask is
+    // _num_buckets - 1 and _num_split_buckets is _num_buckets.
+    int64_t _old_bucket_mask;
+    int64_t _num_split_buckets;
+
     // The number of filled buckets to trigger a resize.  This is cached for efficiency
     int64_t _num_buckets_till_resize;
 
@@ -437,6 +534,21 @@ private:
     // Use bytes instead of bools to be compatible with llvm.  This address must
     // not change once allocated.
     uint8_t* _expr_value_null_bits;
+
+    // The expr results and null bits of the rows evaluated by prefetch_probe_rows(),
+    // PROBE_BATCH_SIZE rows of '_results_buffer_size + num exprs' bytes.
+    uint8_t* _probe_values_cache;
+    uint32_t _probe_hashes[PROBE_BATCH_SIZE];
+    bool _probe_has_nulls[PROBE_BATCH_SIZE];
+    // Index in the batch of the first prefetched row
+    int _probe_prefetch_start;
+
+    // False if '_nodes' belongs to the table this one is a read-only copy of
+    bool _owns_nodes;
+
+    // Set by string_key_may_eq() for the following equals() if the string keys are known
+    // to be equal.
+    bool _string_key_equal;
 };
 
 }
@@ -22,6 +22,7 @@
 #define BDG_PALO_BE_SRC_QUERY_EXEC_HASH_TABLE_HPP
 
 #include "exec/hash_table.h"
+#include "runtime/row_batch.h"
 
 namespace palo {
 
@@ -32,17 +33,67 @@ inline HashTable::Iterator HashTable::find(TupleRow* probe_row) {
         return end();
     }
 
-    uint32_t hash = hash_current_row();
-    int64_t bucket_idx = hash & (_num_buckets - 1);
+    return find_with_hash(hash_current_row());
+}
+
+inline void HashTable::prefetch_probe_rows(RowBatch* batch, int start_idx, int num_rows) {
+    DCHECK_LE(num_rows, PROBE_BATCH_SIZE);
+    const int num_exprs = _probe_expr_ctxs.size();
+    const int row_cache_size = _results_buffer_size + num_exprs;
+
+    uint8_t* cache = _probe_values_cache;
+    for (int i = 0; i < num_rows; ++i, cache += row_cache_size) {
+        _probe_has_nulls[i] = eval_probe_row(batch->get_row(start_idx + i));
+        if (!_stores_nulls && _probe_has_nulls[i]) {
+            continue;
+        }
+        uint32_t hash = hash_current_row();
+        _probe_hashes[i] = hash;
+        memcpy(cache, _expr_values_buffer, _results_buffer_size);
+        memcpy(cache + _results_buffer_size, _expr_value_null_bits, num_exprs);
+        __builtin_prefetch(&_buckets[bucket_idx(hash)], 0, 1);
+    }
 
-    Bucket* bucket = &_buckets[bucket_idx];
+    // The buckets are arriving in cache now, prefetch the first node of the buckets.
+    for (int i = 0; i < num_rows; ++i) {
+        if (!_stores_nulls && _probe_has_nulls[i]) {
+            continue;
+        }
+        int64_t node_idx = _buckets[bucket_idx(_probe_hashes[i])]._node_idx;
+        if (node_idx != -1) {
+            __builtin_prefetch(get_node(node_idx), 0, 1);
+        }
+    }
+    _probe_prefetch_start = start_idx;
+}
+
+inline HashTable::Iterator HashTable::find_prefetched(int row_idx) {
+    int i = row_idx - _probe_prefetch_start;
+    DCHECK_GE(i, 0);
+    DCHECK_LT(i, PROBE_BATCH_SIZE);
+    if (!_stores_nulls && _probe_has_nulls[i]) {
+        return end();
+    }
+
+    // Restore the results of this row, equals() and Iterator::next() compare with them.
+    const int num_exprs = _probe_expr_ctxs.size();
+    const uint8_t* cache = _probe_values_cache + i * (_results_buffer_size + num_exprs);
+    memcpy(_expr_values_buffer, cache, _results_buffer_size);
+    memcpy(_expr_value_null_bits, cache + _results_buffer_size, num_exprs);
+    return find_with_hash(_probe_hashes[i]);
+}
+
+inline HashTable::Iterator HashTable::find_with_hash(uint32_t hash) {
+    int64_t idx = bucket_idx(hash);
+
+    Bucket* bucket = &_buckets[idx];
     int64_t node_idx = bucket->_node_idx;
 
     while (node_idx != -1) {
         Node* node = get_node(node_idx);
 
-        if (node->_hash == hash && equals(node->data())) {
-            return Iterator(this, bucket_idx, node_idx, hash);
+        if (node_matches(node, hash)) {
+            return Iterator(this, idx, node_idx, hash);
         }
 
         node_idx = node->_next_idx;
@@ -51,6 +102,24 @@ inline HashTable::Iterator HashTable::find(TupleRow* probe_row) {
     return end();
 }
 
+inline bool HashTable::string_key_may_eq(Node* node) {
+    _string_key_equal = false;
+    if (_string_key_idx == -1) {
+        return true;
+    }
+    const StringValuePrefix* build_key = string_key_prefix(node);
+    // NULL keys are left to equals()
+    if (build_key->is_null() || _expr_value_null_bits[_string_key_idx]) {
+        return true;
+    }
+    StringValuePrefix probe_key = current_string_key_prefix();
+    if (!probe_key.may_eq(*build_key)) {
+        return false;
+    }
+    _string_key_equal = probe_key.is_complete();
+    return true;
+}
+
 inline HashTable::Iterator HashTable::begin() {
     int64_t bucket_idx = -1;
     Bucket* bucket = next_bucket(&bucket_idx);
@@ -83,7 +152,7 @@ inline void HashTable::insert_impl(TupleRow* row) {
     }
 
     uint32_t hash = hash_current_row();
-    int64_t bucket_idx = hash & (_num_buckets - 1);
+    int64_t idx = bucket_idx(hash);
 
     if (_num_nodes == _nodes_capacity) {
         grow_node_array();
@@ -93,7 +162,10 @@ inline void HashTable::insert_impl(TupleRow* row) {
     TupleRow* data = node->data();
     node->_hash = hash;
     memcpy(data, row, sizeof(Tuple*) * _num_build_tuples);
-    add_to_bucket(&_buckets[bucket_idx], _num_nodes, node);
+    if (_string_key_idx != -1) {
+        *string_key_prefix(node) = current_string_key_prefix();
+    }
+    add_to_bucket(&_buckets[idx], _num_nodes, node);
     ++_num_nodes;
 }
 
@@ -143,7 +215,7 @@ inline void HashTable::Iterator::next() {
         while (next_idx != -1) {
             node = _table->get_node(next_idx);
 
-            if (node->_hash == _scan_hash && _table->equals(node->data())) {
+            if (_table->node_matches(node, _scan_hash)) {
                 _node_idx = next_idx;
                 return;
             }
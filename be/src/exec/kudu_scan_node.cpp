@@ -30,6 +30,8 @@
 #include "exec/kudu_scanner.h"
 #include "exec/kudu_util.h"
 #include "exprs/expr.h"
+#include "exprs/expr_context.h"
+#include "runtime/exec_env.h"
 // #include "gutil/gscoped_ptr.h"
 // #include "gutil/strings/substitute.h"
 // #include "gutil/stl_util.h"
@@ -38,6 +40,7 @@
 #include "runtime/row_batch.h"
 #include "runtime/string_value.h"
 #include "runtime/tuple_row.h"
+#include "util/priority_thread_pool.hpp"
 // #include "util/disk-info.h"
 // #include "util/jni-util.h"
 // #include "util/periodic-counter-updater.h"
@@ -66,23 +69,23 @@ KuduScanNode::KuduScanNode(ObjectPool* pool, const TPlanNode& tnode,
       _tuple_id(tnode.kudu_scan_node.tuple_id),
       _next_scan_token_idx(0),
       _num_active_scanners(0),
-      _done(false),
-      _thread_avail_cb_id(-1) {
+      _done(false) {
   DCHECK(KuduIsAvailable());
 
   int max_row_batches = config::kudu_max_row_batches;
-  // if (max_row_batches <= 0) {
-    // TODO: See comment on hdfs-scan-node.
-    // This value is built the same way as it assumes that the scan node runs co-located
-    // with a Kudu tablet server and that the tablet server is using disks similarly as
-    // a datanode would.
-  //   max_row_batches = 10 * (DiskInfo::num_disks() + DiskIoMgr::REMOTE_NUM_DISKS);
-  //}
+  if (max_row_batches <= 0) {
+    // Bound the batches like the queue of an olap scan node, which holds
+    // palo_scanner_queue_size batches for all of its scanner threads.
+    max_row_batches = std::max(1, config::palo_scanner_queue_size / 32);
+  }
   _materialized_row_batches.reset(new RowBatchQueue(max_row_batches));
 }
 
 KuduScanNode::~KuduScanNode() {
   DCHECK(is_closed());
+  for (KuduPredicate* predicate : _kudu_predicates) {
+    delete predicate;
+  }
 }
 
 Status KuduScanNode::prepare(RuntimeState* state) {
@@ -118,6 +121,7 @@ Status KuduScanNode::open(RuntimeState* state) {
   RETURN_IF_CANCELLED(state);
   // RETURN_IF_ERROR(query_maintenance(state));
   SCOPED_TIMER(_runtime_profile->total_time_counter());
+  SCOPED_CPU_TIMER(_cpu_time_counter);
 
   const KuduTableDescriptor* table_desc =
       static_cast<const KuduTableDescriptor*>(_tuple_desc->table_desc());
@@ -132,19 +136,35 @@ Status KuduScanNode::open(RuntimeState* state) {
   KUDU_RETURN_IF_ERROR(_client->OpenTable(table_desc->table_name(), &_table),
       "Unable to open Kudu table");
 
+  RETURN_IF_ERROR(build_kudu_predicates());
+
   _num_scanner_threads_started_counter =
       ADD_COUNTER(runtime_profile(), _s_num_scanner_threads_started, TUnit::UNIT);
 
-  // Reserve one thread.
-  // state->resource_pool()->ReserveOptionalTokens(1);
-  // if (state->query_options().num_scanner_threads > 0) {
-  //   state->resource_pool()->set_max_quota(
-  //       state->query_options().num_scanner_threads);
-  // }
-
-  // thread_avail_cb_id_ = state->resource_pool()->AddThreadAvailableCb(
-  //    bind<void>(mem_fn(&KuduScanNode::thread_available_cb), this, _1));
-  thread_available_cb(state->resource_pool());
+  // The tokens are processed by at most kudu_scanner_thread_num scanners at a time,
+  // each one running as a task of the shared scanner thread pool.
+  int num_scanners = std::min<int>(_scan_tokens.size(),
+                                   std::max(1, config::kudu_scanner_thread_num));
+  for (int i = 0; i < num_scanners; ++i) {
+    KuduScanner* scanner = _pool->add(new KuduScanner(this, state));
+    _scanners.push_back(scanner);
+    RETURN_IF_ERROR(scanner->open());
+  }
+  for (KuduScanner* scanner : _scanners) {
+    {
+      boost::lock_guard<boost::mutex> l(_lock);
+      ++_num_active_scanners;
+    }
+    COUNTER_UPDATE(_num_scanner_threads_started_counter, 1);
+    if (!offer_scanner_task(scanner)) {
+      boost::lock_guard<boost::mutex> l(_lock);
+      --_num_active_scanners;
+      _done = true;
+      _materialized_row_batches->shutdown();
+      _scanners_done_cv.notify_all();
+      return Status("Failed to assign kudu scanner task to thread pool");
+    }
+  }
   return Status::OK;
 }
 
@@ -154,6 +174,7 @@ Status KuduScanNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eo
   RETURN_IF_CANCELLED(state);
   // RETURN_IF_ERROR(QueryMaintenance(state));
   SCOPED_TIMER(_runtime_profile->total_time_counter());
+  SCOPED_CPU_TIMER(_cpu_time_counter);
   SCOPED_TIMER(materialize_tuple_timer());
 
   if (reached_limit() || _scan_tokens.empty()) {
@@ -197,22 +218,27 @@ Status KuduScanNode::close(RuntimeState* state) {
     return Status::OK;
   }
   SCOPED_TIMER(_runtime_profile->total_time_counter());
+  SCOPED_CPU_TIMER(_cpu_time_counter);
   // PeriodicCounterUpdater::StopRateCounter(total_throughput_counter());
   // PeriodicCounterUpdater::StopTimeSeriesCounter(bytes_read_timeseries_counter_);
   // if (thread_avail_cb_id_ != -1) {
   //  state->resource_pool()->RemoveThreadAvailableCb(thread_avail_cb_id_);
   // }
 
-  if (!_done) {
-    std::unique_lock<mutex> l(_lock);
+  {
+    boost::unique_lock<boost::mutex> l(_lock);
     _done = true;
     _materialized_row_batches->shutdown();
+    while (_num_active_scanners > 0) {
+      _scanners_done_cv.wait(l);
+    }
   }
 
-  _scanner_threads.join_all();
-  // scanner_threads_.JoinAll();
-  DCHECK_EQ(_num_active_scanners, 0);
+  for (KuduScanner* scanner : _scanners) {
+    scanner->close();
+  }
   _materialized_row_batches->Cleanup();
+  Expr::close(_scanner_conjunct_ctxs, state);
   ExecNode::close(state);
 
   return Status::OK;
@@ -231,43 +257,186 @@ const string* KuduScanNode::get_next_scan_token() {
 }
 
 Status KuduScanNode::get_conjunct_ctxs(vector<ExprContext*>* ctxs) {
-  return Expr::clone_if_not_exists(_conjunct_ctxs, _runtime_state, ctxs);
+  return Expr::clone_if_not_exists(_scanner_conjunct_ctxs, _runtime_state, ctxs);
 }
 
-void KuduScanNode::thread_available_cb(ThreadResourceMgr::ResourcePool* pool) {
-  while (true) {
-    std::unique_lock<mutex> lock(_lock);
-    // All done or all tokens are assigned.
-    if (_done || _next_scan_token_idx >= _scan_tokens.size()) {
-        break;
+Status KuduScanNode::build_kudu_predicates() {
+  for (ExprContext* ctx : _conjunct_ctxs) {
+    KuduPredicate* predicate = to_kudu_predicate(ctx);
+    if (predicate != NULL) {
+      _kudu_predicates.push_back(predicate);
+    } else {
+      _scanner_conjunct_ctxs.push_back(ctx);
     }
+  }
+  VLOG(1) << "KuduScanNode " << id() << " pushed " << _kudu_predicates.size()
+          << " of " << _conjunct_ctxs.size() << " conjuncts to Kudu";
+  return Status::OK;
+}
 
-    // Check if we can get a token.
-    // if (!pool->TryAcquireThreadToken()) break;
+KuduPredicate* KuduScanNode::to_kudu_predicate(ExprContext* ctx) {
+  Expr* pred = ctx->root();
+  if (pred->node_type() != TExprNodeType::BINARY_PRED) {
+    return NULL;
+  }
+  DCHECK_EQ(pred->get_num_children(), 2);
 
-    ++_num_active_scanners;
-    COUNTER_UPDATE(_num_scanner_threads_started_counter, 1);
+  // The slot may be on either side, the comparison is flipped if it is on the right.
+  int slot_idx = 0;
+  if (pred->get_child(0)->node_type() != TExprNodeType::SLOT_REF) {
+    slot_idx = 1;
+  }
+  Expr* slot_expr = pred->get_child(slot_idx);
+  Expr* value_expr = pred->get_child(1 - slot_idx);
+  if (slot_expr->node_type() != TExprNodeType::SLOT_REF || !value_expr->is_constant()) {
+    return NULL;
+  }
+
+  KuduPredicate::ComparisonOp op;
+  switch (pred->op()) {
+  case TExprOpcode::EQ:
+    op = KuduPredicate::EQUAL;
+    break;
+  case TExprOpcode::LT:
+    op = slot_idx == 0 ? KuduPredicate::LESS : KuduPredicate::GREATER;
+    break;
+  case TExprOpcode::LE:
+    op = slot_idx == 0 ? KuduPredicate::LESS_EQUAL : KuduPredicate::GREATER_EQUAL;
+    break;
+  case TExprOpcode::GT:
+    op = slot_idx == 0 ? KuduPredicate::GREATER : KuduPredicate::LESS;
+    break;
+  case TExprOpcode::GE:
+    op = slot_idx == 0 ? KuduPredicate::GREATER_EQUAL : KuduPredicate::LESS_EQUAL;
+    break;
+  default:
+    return NULL;
+  }
+
+  std::vector<SlotId> slot_ids;
+  if (slot_expr->get_slot_ids(&slot_ids) != 1) {
+    return NULL;
+  }
+  const SlotDescriptor* slot = NULL;
+  for (const SlotDescriptor* desc : _tuple_desc->slots()) {
+    if (desc->id() == slot_ids[0]) {
+      slot = desc;
+      break;
+    }
+  }
+  if (slot == NULL || slot->type() != value_expr->type()) {
+    return NULL;
+  }
+
+  // col > NULL is never true, leave it to the conjunct
+  void* value = ctx->get_value(value_expr, NULL);
+  if (value == NULL) {
+    return NULL;
+  }
+
+  const KuduSchema& schema = _table->schema();
+  int col_idx = -1;
+  for (int i = 0; i < schema.num_columns(); ++i) {
+    if (to_lower_copy(schema.Column(i).name()) == to_lower_copy(slot->col_name())) {
+      col_idx = i;
+      break;
+    }
+  }
+  if (col_idx == -1) {
+    return NULL;
+  }
+
+  // Only push values whose type Kudu compares the same way as we do.
+  KuduValue* kudu_value = NULL;
+  KuduColumnSchema::DataType kudu_type = schema.Column(col_idx).type();
+  switch (slot->type().type) {
+  case TYPE_TINYINT:
+    if (kudu_type == KuduColumnSchema::INT8) {
+      kudu_value = KuduValue::FromInt(*reinterpret_cast<int8_t*>(value));
+    }
+    break;
+  case TYPE_SMALLINT:
+    if (kudu_type == KuduColumnSchema::INT16) {
+      kudu_value = KuduValue::FromInt(*reinterpret_cast<int16_t*>(value));
+    }
+    break;
+  case TYPE_INT:
+    if (kudu_type == KuduColumnSchema::INT32) {
+      kudu_value = KuduValue::FromInt(*reinterpret_cast<int32_t*>(value));
+    }
+    break;
+  case TYPE_BIGINT:
+    if (kudu_type == KuduColumnSchema::INT64) {
+      kudu_value = KuduValue::FromInt(*reinterpret_cast<int64_t*>(value));
+    }
+    break;
+  case TYPE_FLOAT:
+    if (kudu_type == KuduColumnSchema::FLOAT) {
+      kudu_value = KuduValue::FromFloat(*reinterpret_cast<float*>(value));
+    }
+    break;
+  case TYPE_DOUBLE:
+    if (kudu_type == KuduColumnSchema::DOUBLE) {
+      kudu_value = KuduValue::FromDouble(*reinterpret_cast<double*>(value));
+    }
+    break;
+  case TYPE_VARCHAR:
+    if (kudu_type == KuduColumnSchema::STRING) {
+      const StringValue* str = reinterpret_cast<StringValue*>(value);
+      kudu_value = KuduValue::CopyString(Slice(str->ptr, str->len));
+    }
+    break;
+  default:
+    break;
+  }
+  if (kudu_value == NULL) {
+    return NULL;
+  }
+  return _table->NewComparisonPredicate(schema.Column(col_idx).name(), op, kudu_value);
+}
+
+bool KuduScanNode::offer_scanner_task(KuduScanner* scanner) {
+  PriorityThreadPool::Task task;
+  task.work_function = boost::bind(&KuduScanNode::scanner_task, this, scanner);
+  task.query_key = hash_value(_runtime_state->query_id());
+  return _runtime_state->exec_env()->thread_pool()->offer(task);
+}
+
+void KuduScanNode::scanner_task(KuduScanner* scanner) {
+  Status status = Status::OK;
+  const string* scan_token = _done ? NULL : get_next_scan_token();
+  if (scan_token != NULL) {
+    status = process_scan_token(scanner, *scan_token);
+  }
 
-    // Reserve the first token so no other thread picks it up.
-    const string* token = &_scan_tokens[_next_scan_token_idx++];
-    // string name = Substitute("scanner-thread($0)",
-    //    _num_scanner_threads_started_counter->value());
-    std::stringstream ss;
-    ss << "scanner-thread(" << _num_scanner_threads_started_counter->value() << ")";
-    std::string name = ss.str();
-
-    VLOG_RPC << "Thread started: " << name;
-    _scanner_threads.create_thread(
-            boost::bind(&KuduScanNode::run_scanner_thread, this, name, token));
-    // _scanner_threads.AddThread(new Thread("kudu-scan-node", name,
-    //   &KuduScanNode::RunScannerThread, this, name, token));
+  bool has_more_tokens = false;
+  {
+    boost::lock_guard<boost::mutex> l(_lock);
+    if (!status.ok() && _status.ok()) {
+      _status = status;
+      _done = true;
+      _materialized_row_batches->shutdown();
+    }
+    has_more_tokens = !_done && _next_scan_token_idx < _scan_tokens.size();
+  }
+  // The task is queued again outside of _lock: offer() blocks while the pool is full,
+  // and the tasks it waits for need _lock to finish.
+  if (has_more_tokens && offer_scanner_task(scanner)) {
+    return;
+  }
+
+  boost::lock_guard<boost::mutex> l(_lock);
+  if (--_num_active_scanners == 0) {
+    _done = true;
+    _materialized_row_batches->shutdown();
+    _scanners_done_cv.notify_all();
   }
 }
 
 Status KuduScanNode::process_scan_token(KuduScanner* scanner, const string& scan_token) {
   RETURN_IF_ERROR(scanner->open_next_scan_token(scan_token));
   bool eos = false;
-  while (!eos) {
+  while (!eos && !_done) {
     std::auto_ptr<RowBatch> row_batch(new RowBatch(
         row_desc(), _runtime_state->batch_size(), mem_tracker()));
     RETURN_IF_ERROR(scanner->get_next(row_batch.get(), &eos));
@@ -283,65 +452,4 @@ Status KuduScanNode::process_scan_token(KuduScanner* scanner, const string& scan
   return Status::OK;
 }
 
-void KuduScanNode::run_scanner_thread(KuduScanNode *scanNode, const string& name, const string* initial_token)  {
-    scanNode->run_scanner(name, initial_token);
-}
-
-void KuduScanNode::run_scanner(const string& name, const string* initial_token) {
-  DCHECK(initial_token != NULL);
-  // SCOPED_THREAD_COUNTER_MEASUREMENT(scanner_thread_counters());
-  // SCOPED_THREAD_COUNTER_MEASUREMENT(runtime_state_->total_thread_statistics());
-  // Set to true if this thread observes that the number of optional threads has been
-  // exceeded and is exiting early.
-  bool optional_thread_exiting = false;
-  KuduScanner scanner(this, _runtime_state);
-
-  const string* scan_token = initial_token;
-  Status status = scanner.open();
-  if (status.ok()) {
-    while (!_done && scan_token != NULL) {
-      status = process_scan_token(&scanner, *scan_token);
-      if (!status.ok()) break;
-
-      /*
-      // Check if the number of optional threads has been exceeded.
-      if (_runtime_state->resource_pool()->optional_exceeded()) {
-        std::unique_lock<mutex> l(_lock);
-        // Don't exit if this is the last thread. Otherwise, the scan will indicate it's
-        // done before all scan tokens have been processed.
-        if (_num_active_scanners > 1) {
-          --_num_active_scanners;
-          optional_thread_exiting = true;
-          break;
-        }
-      }
-      */
-      scan_token = get_next_scan_token();
-    }
-  }
-  scanner.close();
-
-  {
-    std::unique_lock<mutex> l(_lock);
-    if (!status.ok()) {
-      if (_status.ok()) {
-        _status = status;
-        _done = true;
-      }
-    }
-    // Decrement num_active_scanners_ unless handling the case of an early exit when
-    // optional threads have been exceeded, in which case it already was decremented.
-    if (!optional_thread_exiting) --_num_active_scanners;
-    if (_num_active_scanners == 0) {
-      _done = true;
-      _materialized_row_batches->shutdown();
-    }
-  }
-
-  // lock_ is released before calling ThreadResourceMgr::ReleaseThreadToken() which
-  // invokes ThreadAvailableCb() which attempts to take the same lock.
-  VLOG_RPC << "Thread done: " << name;
-  // runtime_state_->resource_pool()->release_thread_token(false);
-}
-
 }  // namespace impala
@@ -80,6 +80,13 @@ class KuduScanNode : public ScanNode {
   /// Set of scan tokens to be deserialized into Kudu scanners.
   std::vector<std::string> _scan_tokens;
 
+  /// Conjuncts pushed to Kudu as predicates, set in open(). Owned, every scanner adds
+  /// a clone of them.
+  std::vector<kudu::client::KuduPredicate*> _kudu_predicates;
+
+  /// Conjuncts that could not be pushed to Kudu, evaluated by the scanners.
+  std::vector<ExprContext*> _scanner_conjunct_ctxs;
+
   /// The next index in 'scan_tokens_' to be assigned. Protected by lock_.
   int _next_scan_token_idx;
 
@@ -96,43 +103,40 @@ class KuduScanNode : public ScanNode {
   /// Protected by lock_
   Status _status;
 
-  /// Number of active running scanner threads.
+  /// Number of scanner tasks queued or running in the scanner thread pool.
   /// Protected by lock_
   int _num_active_scanners;
 
+  /// Signaled when _num_active_scanners drops to 0. Tied to _lock.
+  boost::condition_variable _scanners_done_cv;
+
   /// Set to true when the scan is complete (either because all scan tokens have been
   /// processed, the limit was reached or some error occurred).
   /// Protected by lock_
   volatile bool _done;
 
-  /// Thread group for all scanner worker threads
-  // TODO(dhc): change boost::thread_group to impala::thread_group
-  // ThreadGroup scanner_threads_;
-  boost::thread_group _scanner_threads;
+  /// The scanners, each processes one scan token at a time. Live in _pool.
+  std::vector<KuduScanner*> _scanners;
 
   RuntimeProfile::Counter* _kudu_round_trips;
   RuntimeProfile::Counter* _kudu_remote_tokens;
   static const std::string KUDU_ROUND_TRIPS;
   static const std::string KUDU_REMOTE_TOKENS;
 
-  /// The id of the callback added to the thread resource manager when a thread
-  /// is available. Used to remove the callback before this scan node is destroyed.
-  /// -1 if no callback is registered.
-  int _thread_avail_cb_id;
+  /// Converts the conjuncts comparing a slot with a constant into Kudu predicates, the
+  /// others are left in _scanner_conjunct_ctxs.
+  Status build_kudu_predicates();
 
-  /// Called when scanner threads are available for this scan node. This will
-  /// try to spin up as many scanner threads as the quota allows.
-  void thread_available_cb(ThreadResourceMgr::ResourcePool* pool);
+  /// Returns the Kudu predicate for 'ctx', NULL if it can't be pushed to Kudu.
+  kudu::client::KuduPredicate* to_kudu_predicate(ExprContext* ctx);
 
-  /// Main function for scanner thread which executes a KuduScanner. Begins by processing
-  /// 'initial_token', and continues processing scan tokens returned by
-  /// 'GetNextScanToken()' until there are none left, an error occurs, or the limit is
-  /// reached.
-  static void run_scanner_thread(
-        KuduScanNode *scanNode, const string& name, const string* initial_token);
+  /// Queues a task running 'scanner' in the scanner thread pool of the backend.
+  bool offer_scanner_task(KuduScanner* scanner);
 
-  void run_scanner(const string& name, const string* initial_token);
-  // void run_scanner_thread(const std::string& name, const std::string* initial_token);
+  /// Task of the scanner thread pool, processes one scan token with 'scanner' and
+  /// queues the next task of it if there are tokens left, so that the scanners of other
+  /// queries get the threads in between.
+  void scanner_task(KuduScanner* scanner);
 
   /// Processes a single scan token. Row batches are fetched using 'scanner' and enqueued
   /// in 'materialized_row_batches_' until the scanner reports eos, an error occurs, or
@@ -145,10 +149,14 @@ class KuduScanNode : public ScanNode {
 
   const TupleDescriptor* tuple_desc() const { return _tuple_desc; }
 
-  // Returns a cloned copy of the scan node's conjuncts. Requires that the expressions
-  // have been open previously.
+  // Returns a cloned copy of the scan node's conjuncts that are not evaluated by Kudu.
+  // Requires that the expressions have been open previously.
   Status get_conjunct_ctxs(vector<ExprContext*>* ctxs);
 
+  const std::vector<kudu::client::KuduPredicate*>& kudu_predicates() const {
+    return _kudu_predicates;
+  }
+
   RuntimeProfile::Counter* kudu_round_trips() const { return _kudu_round_trips; }
 };
 
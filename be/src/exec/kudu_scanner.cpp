@@ -66,8 +66,8 @@ Status KuduScanner::open() {
 void KuduScanner::keep_kudu_scanner_alive() {
   if (_scanner == NULL) return;
   // int64_t now = MonotonicMicros();
-  int64_t now = std::chrono::duration_cast< std::chrono::milliseconds >(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+  int64_t now = std::chrono::duration_cast< std::chrono::microseconds >(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
 
   int64_t keepalive_us = config::kudu_scanner_keep_alive_period_sec * 1e6;
   if (now < _last_alive_time_micros + keepalive_us) {
@@ -141,6 +141,11 @@ Status KuduScanner::open_next_scan_token(const string& scan_token)  {
   KUDU_RETURN_IF_ERROR(_scanner->SetReadMode(mode), "Could not set scanner ReadMode");
   KUDU_RETURN_IF_ERROR(_scanner->SetTimeoutMillis(config::kudu_operation_timeout_ms),
       "Could not set scanner timeout");
+  // Kudu owns the predicates added to a scanner, so each one gets a copy
+  for (kudu::client::KuduPredicate* predicate : _scan_node->kudu_predicates()) {
+    KUDU_RETURN_IF_ERROR(_scanner->AddConjunctPredicate(predicate->Clone()),
+        "Could not add predicate to scanner");
+  }
   VLOG_ROW << "Starting KuduScanner with ReadMode=" << mode << " timeout=" <<
       config::kudu_operation_timeout_ms;
 
@@ -182,6 +187,12 @@ Status KuduScanner::decode_rows_into_row_batch(RowBatch* row_batch, Tuple** tupl
   // Iterate through the Kudu rows, evaluate conjuncts and deep-copy survivors into
   // 'row_batch'.
   bool has_conjuncts = !_conjunct_ctxs.empty();
+  if (!has_conjuncts && _scan_node->tuple_desc()->string_slots().empty()) {
+    const kudu::Slice& direct_data = _cur_kudu_batch.direct_data();
+    if (direct_data.size() == _cur_kudu_batch.NumRows() * _scan_node->tuple_desc()->byte_size()) {
+      return copy_rows_into_row_batch(row_batch, tuple_mem, batch_done);
+    }
+  }
   int num_rows = _cur_kudu_batch.NumRows();
   for (int krow_idx = _cur_kudu_batch_num_read; krow_idx < num_rows; ++krow_idx) {
     // Evaluate the conjuncts that haven't been pushed down to Kudu. Conjunct evaluation
@@ -215,11 +226,33 @@ Status KuduScanner::decode_rows_into_row_batch(RowBatch* row_batch, Tuple** tupl
   return Status::OK;
 }
 
+Status KuduScanner::copy_rows_into_row_batch(RowBatch* row_batch, Tuple** tuple_mem,
+    bool* batch_done) {
+  int tuple_size = _scan_node->tuple_desc()->byte_size();
+  int num_rows = std::min(row_batch->capacity() - row_batch->num_rows(),
+      _cur_kudu_batch.NumRows() - _cur_kudu_batch_num_read);
+  const uint8_t* src = _cur_kudu_batch.direct_data().data()
+      + _cur_kudu_batch_num_read * tuple_size;
+  memcpy(*tuple_mem, src, num_rows * tuple_size);
+  _cur_kudu_batch_num_read += num_rows;
+
+  int row_idx = row_batch->add_rows(num_rows);
+  for (int i = 0; i < num_rows; ++i) {
+    row_batch->get_row(row_idx + i)->set_tuple(0, *tuple_mem);
+    *tuple_mem = next_tuple(*tuple_mem);
+  }
+  row_batch->commit_rows(num_rows);
+  if (row_batch->at_capacity() || _scan_node->reached_limit()) {
+    *batch_done = true;
+  }
+  return Status::OK;
+}
+
 Status KuduScanner::get_next_scanner_batch() {
   // SCOPED_TIMER(_state->total_storage_wait_timer());
   // int64_t now = MonotonicMicros();
-  int64_t now = std::chrono::duration_cast< std::chrono::milliseconds >(
-        std::chrono::system_clock::now().time_since_epoch()).count();
+  int64_t now = std::chrono::duration_cast< std::chrono::microseconds >(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
   KUDU_RETURN_IF_ERROR(_scanner->NextBatch(&_cur_kudu_batch), "Unable to advance iterator");
   COUNTER_UPDATE(_scan_node->kudu_round_trips(), 1);
   _cur_kudu_batch_num_read = 0;
@@ -73,6 +73,11 @@ class KuduScanner {
   ///    the limit was reached.
   Status decode_rows_into_row_batch(RowBatch* batch, Tuple** tuple_mem, bool* batch_done);
 
+  /// Copies rows of 'cur_kudu_batch_' into 'batch' as a whole, which is possible if
+  /// there are no conjuncts to evaluate and no strings pointing outside of the rows.
+  /// Parameters like in decode_rows_into_row_batch().
+  Status copy_rows_into_row_batch(RowBatch* batch, Tuple** tuple_mem, bool* batch_done);
+
   /// Fetches the next batch of rows from the current kudu::client::KuduScanner.
   Status get_next_scanner_batch();
 
@@ -15,6 +15,9 @@
 
 #include "exec/local_file_reader.h"
 
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace palo {
 
 LocalFileReader::LocalFileReader(const std::string& path, int64_t start_offset) 
@@ -76,6 +79,43 @@ Status LocalFileReader::read(uint8_t* buf, size_t* buf_len, bool* eof) {
     return Status::OK;
 }
 
+Status LocalFileReader::readat(int64_t position, int64_t nbytes, int64_t* bytes_read,
+                               void* out) {
+    *bytes_read = 0;
+    while (*bytes_read < nbytes) {
+        ssize_t res = pread(fileno(_fp), (char*)out + *bytes_read, nbytes - *bytes_read,
+                            position + *bytes_read);
+        if (res < 0 && errno == EINTR) {
+            continue;
+        }
+        if (res < 0) {
+            char err_buf[64];
+            std::stringstream ss;
+            ss << "Read file failed. path=" << _path 
+                << ", error=" << strerror_r(errno, err_buf, 64);
+            return Status(ss.str());
+        }
+        if (res == 0) {
+            break;
+        }
+        *bytes_read += res;
+    }
+    return Status::OK;
+}
+
+Status LocalFileReader::size(int64_t* size) {
+    struct stat st;
+    if (fstat(fileno(_fp), &st) != 0) {
+        char err_buf[64];
+        std::stringstream ss;
+        ss << "Stat file failed. path=" << _path 
+            << ", error=" << strerror_r(errno, err_buf, 64);
+        return Status(ss.str());
+    }
+    *size = st.st_size;
+    return Status::OK;
+}
+
 void LocalFileReader::close() {
     if (_fp != nullptr) {
         fclose(_fp);
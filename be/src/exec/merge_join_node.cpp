@@ -25,6 +25,9 @@
 #include "exprs/expr.h"
 #include "exprs/in_predicate.h"
 #include "gen_cpp/PlanNodes_types.h"
+#include "runtime/datetime_value.h"
+#include "runtime/decimal_value.h"
+#include "runtime/mem_pool.h"
 #include "runtime/row_batch.h"
 #include "runtime/runtime_state.h"
 #include "util/debug_util.h"
@@ -51,6 +54,10 @@ int compare_value(const StringValue* left_value,  const StringValue* right_value
 MergeJoinNode::MergeJoinNode(
         ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs) :
             ExecNode(pool, tnode, descs),
+            _is_join(false),
+            _join_op(TJoinOp::INNER_JOIN),
+            _right_group_idx(0),
+            _left_matched(false),
             _out_batch(NULL) {
 }
 
@@ -74,6 +81,19 @@ Status MergeJoinNode::init(const TPlanNode& tnode) {
     RETURN_IF_ERROR(Expr::create_expr_trees(
             _pool, tnode.merge_join_node.other_join_conjuncts,
             &_other_join_conjunct_ctxs));
+
+    if (tnode.merge_join_node.__isset.join_op) {
+        _join_op = tnode.merge_join_node.join_op;
+        if (_join_op != TJoinOp::INNER_JOIN && _join_op != TJoinOp::LEFT_OUTER_JOIN) {
+            std::stringstream ss;
+            ss << "merge join node unsupport join op " << _join_op;
+            return Status(ss.str());
+        }
+        if (cmp_conjuncts.empty()) {
+            return Status("merge join node needs at least one equi-join predicate.");
+        }
+        _is_join = true;
+    }
     return Status::OK;
 }
 
@@ -114,6 +134,15 @@ Status MergeJoinNode::prepare(RuntimeState* state) {
             _cmp_func.push_back(compare_value<StringValue>);
             break;
 
+        case TYPE_DATE:
+        case TYPE_DATETIME:
+            _cmp_func.push_back(compare_value<DateTimeValue>);
+            break;
+
+        case TYPE_DECIMAL:
+            _cmp_func.push_back(compare_value<DecimalValue>);
+            break;
+
         default:
             return Status("unspport compare type.");
             break;
@@ -141,6 +170,10 @@ Status MergeJoinNode::prepare(RuntimeState* state) {
     _right_child_ctx.reset(
             new ChildReaderContext(row_desc(), state->batch_size(), state->instance_mem_tracker()));
 
+    if (_is_join) {
+        _right_group_pool.reset(new MemPool(mem_tracker()));
+    }
+
     return Status::OK;
 }
 
@@ -152,11 +185,16 @@ Status MergeJoinNode::close(RuntimeState* state) {
     Expr::close(_left_expr_ctxs, state);
     Expr::close(_right_expr_ctxs, state);
     Expr::close(_other_join_conjunct_ctxs, state);
+    _right_group.clear();
+    if (_right_group_pool.get() != NULL) {
+        _right_group_pool->free_all();
+    }
     return ExecNode::close(state);
 }
 
 Status MergeJoinNode::open(RuntimeState* state) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_CANCELLED(state);
     RETURN_IF_ERROR(ExecNode::open(state));
     RETURN_IF_ERROR(Expr::open(_left_expr_ctxs, state));
@@ -180,12 +218,17 @@ Status MergeJoinNode::get_next(RuntimeState* state, RowBatch* out_batch, bool* e
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
     RETURN_IF_CANCELLED(state);
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
 
     if (reached_limit() || _eos) {
         *eos = true;
         return Status::OK;
     }
 
+    if (_is_join) {
+        return get_next_join(state, out_batch, eos);
+    }
+
     while (true) {
         int row_idx = out_batch->add_row();
         DCHECK(row_idx != RowBatch::INVALID_ROW_INDEX);
@@ -215,9 +258,9 @@ Status MergeJoinNode::get_next(RuntimeState* state, RowBatch* out_batch, bool* e
 
 void MergeJoinNode::create_output_row(TupleRow* out, TupleRow* left, TupleRow* right) {
     if (left == NULL) {
-        memset(out, 0, _left_tuple_size);
+        memset(out, 0, _left_tuple_size * sizeof(Tuple*));
     } else {
-        memcpy(out, left, _left_tuple_size);
+        memcpy(out, left, _left_tuple_size * sizeof(Tuple*));
     }
 
     if (right != NULL) {
@@ -329,6 +372,162 @@ Status MergeJoinNode::get_input_row(RuntimeState* state, int child_idx) {
     return Status::OK;
 }
 
+Status MergeJoinNode::get_next_join(RuntimeState* state, RowBatch* out_batch, bool* eos) {
+    _out_batch = out_batch;
+
+    while (!out_batch->is_full() && !out_batch->at_resource_limit() && !reached_limit()) {
+        RETURN_IF_CANCELLED(state);
+        TupleRow* left_row = _left_child_ctx->current_row;
+        if (left_row == NULL) {
+            _eos = true;
+            break;
+        }
+
+        // 1. join current left row with the buffered right rows of the same key
+        if (!_right_group.empty()) {
+            int cmp = compare_join_key(left_row, _right_group[0]);
+            if (cmp == 0) {
+                if (_right_group_idx < static_cast<int>(_right_group.size())) {
+                    int row_idx = out_batch->add_row();
+                    DCHECK(row_idx != RowBatch::INVALID_ROW_INDEX);
+                    TupleRow* out_row = out_batch->get_row(row_idx);
+                    create_output_row(out_row, left_row, _right_group[_right_group_idx++]);
+                    if (eval_conjuncts(&_other_join_conjunct_ctxs[0],
+                                       _other_join_conjunct_ctxs.size(), out_row)) {
+                        _left_matched = true;
+                        commit_join_row(out_batch, row_idx);
+                    }
+                } else {
+                    RETURN_IF_ERROR(advance_left_row(state, out_batch));
+                }
+                continue;
+            } else if (cmp < 0) {
+                RETURN_IF_ERROR(advance_left_row(state, out_batch));
+                continue;
+            }
+            // left rows have passed the key of the group, it is no longer needed
+            release_right_group(out_batch);
+        }
+
+        // 2. find the right rows with the same key as current left row
+        TupleRow* right_row = _right_child_ctx->current_row;
+        if (right_row == NULL) {
+            if (_join_op == TJoinOp::INNER_JOIN) {
+                _eos = true;
+                break;
+            }
+            RETURN_IF_ERROR(advance_left_row(state, out_batch));
+            continue;
+        }
+        if (has_null_join_key(_right_expr_ctxs, right_row)) {
+            RETURN_IF_ERROR(get_input_row(state, 1));
+            continue;
+        }
+
+        int cmp = compare_join_key(left_row, right_row);
+        if (cmp < 0) {
+            RETURN_IF_ERROR(advance_left_row(state, out_batch));
+        } else if (cmp > 0) {
+            RETURN_IF_ERROR(get_input_row(state, 1));
+        } else {
+            RETURN_IF_ERROR(load_right_group(state));
+        }
+    }
+
+    if (_eos) {
+        release_right_group(out_batch);
+    }
+    *eos = _eos && out_batch->num_rows() == 0;
+    return Status::OK;
+}
+
+int MergeJoinNode::compare_join_key(TupleRow* left_row, TupleRow* right_row) {
+    for (int i = 0; i < _left_expr_ctxs.size(); ++i) {
+        void* left_value = _left_expr_ctxs[i]->get_value(left_row);
+        if (left_value == NULL) {
+            return -1;
+        }
+        void* right_value = _right_expr_ctxs[i]->get_value(right_row);
+        int cmp_val = _cmp_func[i](left_value, right_value);
+        if (cmp_val != 0) {
+            return cmp_val;
+        }
+    }
+    return 0;
+}
+
+bool MergeJoinNode::has_null_join_key(const std::vector<ExprContext*>& ctxs, TupleRow* row) {
+    for (int i = 0; i < ctxs.size(); ++i) {
+        if (ctxs[i]->get_value(row) == NULL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+Status MergeJoinNode::advance_left_row(RuntimeState* state, RowBatch* out_batch) {
+    if (_join_op == TJoinOp::LEFT_OUTER_JOIN && !_left_matched) {
+        int row_idx = out_batch->add_row();
+        DCHECK(row_idx != RowBatch::INVALID_ROW_INDEX);
+        create_output_row(out_batch->get_row(row_idx), _left_child_ctx->current_row, NULL);
+        commit_join_row(out_batch, row_idx);
+    }
+    _left_matched = false;
+    _right_group_idx = 0;
+    return get_input_row(state, 0);
+}
+
+Status MergeJoinNode::load_right_group(RuntimeState* state) {
+    DCHECK(_right_group.empty());
+    const std::vector<TupleDescriptor*>& tuple_descs = child(1)->row_desc().tuple_descriptors();
+    TupleRow* first_row = NULL;
+    while (_right_child_ctx->current_row != NULL) {
+        TupleRow* right_row = _right_child_ctx->current_row;
+        if (first_row != NULL) {
+            // compare by right exprs on both sides, the key of first_row is not NULL
+            bool is_same_key = true;
+            for (int i = 0; i < _right_expr_ctxs.size() && is_same_key; ++i) {
+                void* right_value = _right_expr_ctxs[i]->get_value(right_row);
+                is_same_key = right_value != NULL
+                        && _cmp_func[i](_right_expr_ctxs[i]->get_value(first_row), right_value) == 0;
+            }
+            if (!is_same_key) {
+                break;
+            }
+        }
+
+        TupleRow* row_copy = reinterpret_cast<TupleRow*>(
+                _right_group_pool->allocate(_right_tuple_size * sizeof(Tuple*)));
+        for (int i = 0; i < _right_tuple_size; ++i) {
+            Tuple* tuple = right_row->get_tuple(i);
+            row_copy->set_tuple(i, tuple == NULL
+                    ? NULL : tuple->deep_copy(*tuple_descs[i], _right_group_pool.get()));
+        }
+        _right_group.push_back(row_copy);
+        if (first_row == NULL) {
+            first_row = row_copy;
+        }
+
+        RETURN_IF_ERROR(get_input_row(state, 1));
+    }
+    _right_group_idx = 0;
+    return Status::OK;
+}
+
+void MergeJoinNode::release_right_group(RowBatch* out_batch) {
+    // rows output before may still reference the copies
+    _right_group.clear();
+    out_batch->tuple_data_pool()->acquire_data(_right_group_pool.get(), false);
+}
+
+void MergeJoinNode::commit_join_row(RowBatch* out_batch, int row_idx) {
+    if (eval_conjuncts(&_conjunct_ctxs[0], _conjunct_ctxs.size(), out_batch->get_row(row_idx))) {
+        out_batch->commit_last_row();
+        ++_num_rows_returned;
+        COUNTER_SET(_rows_returned_counter, _num_rows_returned);
+    }
+}
+
 void MergeJoinNode::debug_string(int indentation_level, stringstream* out) const {
     *out << string(indentation_level * 2, ' ');
     *out << "MergeJoin(eos=" << (_eos ? "true" : "false")
@@ -37,6 +37,11 @@ class TupleRow;
 
 // Node for in-memory merge joins:
 // find the minimal tuple and output
+//
+// If a join op is given, both children must return rows ordered by the join exprs,
+// e.g. scans of tablets in key order, and the node does a sort-merge equi-join of them.
+// Only the right rows sharing the current join key are buffered, so the memory does not
+// grow with the size of the inputs. Rows with NULL join keys never match.
 class MergeJoinNode : public ExecNode {
 public:
     MergeJoinNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs);
@@ -66,6 +71,19 @@ private:
 
     bool _eos;            // if true, nothing left to return in get_next()
 
+    // true if joining the children, false if only merging them
+    bool _is_join;
+    TJoinOp::type _join_op;
+
+    // copies of the right rows whose join key equals to the last matched left row,
+    // allocated from _right_group_pool
+    std::vector<TupleRow*> _right_group;
+    boost::scoped_ptr<MemPool> _right_group_pool;
+    // next row of _right_group to join with current left row
+    int _right_group_idx;
+    // if current left row has been output with any right row
+    bool _left_matched;
+
     struct ChildReaderContext {
         RowBatch batch;
         int row_idx;
@@ -98,6 +116,22 @@ private:
     Status compare_row(TupleRow* left_row, TupleRow* right_row, bool* is_lt);
     Status get_next_row(RuntimeState* state, TupleRow* out_row, bool* eos);
     Status get_input_row(RuntimeState* state, int child_idx);
+
+    // sort-merge join used if _is_join
+    Status get_next_join(RuntimeState* state, RowBatch* out_batch, bool* eos);
+    // returns <0, 0, >0 as the join key of left_row is less than, equal to or greater than
+    // the one of right_row. A left row with NULL key is less than any right row.
+    int compare_join_key(TupleRow* left_row, TupleRow* right_row);
+    bool has_null_join_key(const std::vector<ExprContext*>& ctxs, TupleRow* row);
+    // moves to next left row, outputs current one with NULLs first if it is unmatched
+    // in left outer join
+    Status advance_left_row(RuntimeState* state, RowBatch* out_batch);
+    // copies all the right rows with the same join key as current right row into
+    // _right_group
+    Status load_right_group(RuntimeState* state);
+    void release_right_group(RowBatch* out_batch);
+    // evaluates the conjuncts of this node on the output row and commits it if passed
+    void commit_join_row(RowBatch* out_batch, int row_idx);
 };
 
 }
@@ -20,6 +20,10 @@
 
 #include "exec/merge_node.h"
 
+#include <boost/bind.hpp>
+
+#include "common/config.h"
+#include "exec/parallel_child_reader.h"
 #include "exprs/expr.h"
 #include "gen_cpp/PlanNodes_types.h"
 #include "runtime/row_batch.h"
@@ -41,6 +45,9 @@ MergeNode::MergeNode(ObjectPool* pool, const TPlanNode& tnode,
         _child_row_idx(0) {
 }
 
+MergeNode::~MergeNode() {
+}
+
 Status MergeNode::init(const TPlanNode& tnode) {
     RETURN_IF_ERROR(ExecNode::init(tnode));
     DCHECK(tnode.__isset.merge_node);
@@ -105,6 +112,18 @@ Status MergeNode::open(RuntimeState* state) {
         RETURN_IF_ERROR(Expr::open(_result_expr_ctx_lists[i], state));
     }
 
+    if (config::union_max_parallel_children > 1 && _children.size() > 1) {
+        _parallel_reader.reset(new ParallelChildReader(
+                _children, row_desc(), mem_tracker(),
+                boost::bind(&MergeNode::convert_child_batch, this, _1, _2, _3)));
+        if (_parallel_reader->start(state, config::union_max_parallel_children)) {
+            COUNTER_SET(ADD_COUNTER(runtime_profile(), "ParallelChildThreads", TUnit::UNIT),
+                        static_cast<int64_t>(_parallel_reader->num_threads()));
+        } else {
+            _parallel_reader.reset();
+        }
+    }
+
     return Status::OK;
 }
 
@@ -112,6 +131,11 @@ Status MergeNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos)
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
     RETURN_IF_CANCELLED(state);
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
+    if (_parallel_reader != NULL
+            && _const_result_expr_idx == _const_result_expr_ctx_lists.size()) {
+        return get_next_parallel(state, row_batch, eos);
+    }
     // Create new tuple buffer for row_batch.
     int tuple_buffer_size = row_batch->capacity() * _tuple_desc->byte_size();
     void* tuple_buffer = row_batch->tuple_data_pool()->allocate(tuple_buffer_size);
@@ -131,6 +155,12 @@ Status MergeNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos)
         }
     }
 
+    if (_parallel_reader != NULL) {
+        // The batches of the reader can only be moved into an empty row batch.
+        *eos = false;
+        return Status::OK;
+    }
+
     if (_child_idx == INVALID_CHILD_IDX) {
         _child_idx = 0;
     }
@@ -185,10 +215,59 @@ Status MergeNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos)
     return Status::OK;
 }
 
+Status MergeNode::get_next_parallel(RuntimeState* state, RowBatch* row_batch, bool* eos) {
+    DCHECK_EQ(row_batch->num_rows(), 0);
+    RETURN_IF_ERROR(_parallel_reader->get_next(row_batch, eos));
+    if (*eos) {
+        return Status::OK;
+    }
+
+    int num_selected = eval_conjuncts(&_conjunct_ctxs, row_batch, &_sel);
+    if (_limit != -1 && num_selected > _limit - _num_rows_returned) {
+        num_selected = _limit - _num_rows_returned;
+    }
+    row_batch->keep_rows(_sel.empty() ? NULL : &_sel[0], num_selected);
+    _num_rows_returned += num_selected;
+    COUNTER_SET(_rows_returned_counter, _num_rows_returned);
+    *eos = reached_limit();
+    return Status::OK;
+}
+
+Status MergeNode::convert_child_batch(
+        int child_idx, RowBatch* child_batch, RowBatch* dst_batch) {
+    int tuple_buffer_size = dst_batch->capacity() * _tuple_desc->byte_size();
+    void* tuple_buffer = dst_batch->tuple_data_pool()->allocate(tuple_buffer_size);
+    bzero(tuple_buffer, tuple_buffer_size);
+    Tuple* tuple = reinterpret_cast<Tuple*>(tuple_buffer);
+
+    const vector<ExprContext*>& ctxs = _result_expr_ctx_lists[child_idx];
+    for (int i = 0; i < child_batch->num_rows(); ++i) {
+        TupleRow* child_row = child_batch->get_row(i);
+        int row_idx = dst_batch->add_row();
+        DCHECK(row_idx != RowBatch::INVALID_ROW_INDEX);
+        TupleRow* row = dst_batch->get_row(row_idx);
+        row->set_tuple(0, tuple);
+        for (int j = 0; j < ctxs.size(); ++j) {
+            SlotDescriptor* slot_desc = _tuple_desc->slots()[j];
+            RawValue::write(ctxs[j]->get_value(child_row), tuple, slot_desc,
+                            dst_batch->tuple_data_pool());
+        }
+        dst_batch->commit_last_row();
+        char* new_tuple = reinterpret_cast<char*>(tuple);
+        new_tuple += _tuple_desc->byte_size();
+        tuple = reinterpret_cast<Tuple*>(new_tuple);
+    }
+    return Status::OK;
+}
+
 Status MergeNode::close(RuntimeState* state) {
     if (is_closed()) {
         return Status::OK;
     }
+    // Stop the reader threads before the children are closed.
+    if (_parallel_reader != NULL) {
+        _parallel_reader->close();
+    }
     // don't call ExecNode::close(), it always closes all children
     _child_row_batch.reset(NULL);
     for (int i = 0; i < _const_result_expr_ctx_lists.size(); ++i) {
@@ -29,17 +29,19 @@
 
 namespace palo {
 
+class ParallelChildReader;
 class Tuple;
 class TupleRow;
 
 // Node that merges the results of its children by materializing their
 // evaluated expressions into row batches. The MergeNode pulls row batches sequentially
 // from its children sequentially, i.e., it exhausts one child completely before moving
-// on to the next one.
+// on to the next one, unless config::union_max_parallel_children allows to read several
+// children at the same time (see ParallelChildReader).
 class MergeNode : public ExecNode {
 public:
     MergeNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs);
-    virtual ~MergeNode() { }
+    virtual ~MergeNode();
 
     // Create const exprs, child exprs and conjuncts from corresponding thrift exprs.
     virtual Status init(const TPlanNode& tnode);
@@ -82,6 +84,21 @@ private:
     // Index of current row in _child_row_batch.
     int _child_row_idx;
 
+    // Reads all children on threads of their own if set in open(). The child state
+    // above is unused then.
+    boost::scoped_ptr<ParallelChildReader> _parallel_reader;
+
+    // Rows of a batch from _parallel_reader that passed the conjuncts.
+    std::vector<int> _sel;
+
+    // get_next() for the children when they are read by _parallel_reader. The
+    // conjuncts are evaluated here, on the fragment thread.
+    Status get_next_parallel(RuntimeState* state, RowBatch* row_batch, bool* eos);
+
+    // Materializes the result exprs of child 'child_idx' over 'child_batch' into
+    // 'dst_batch', on a thread of _parallel_reader.
+    Status convert_child_batch(int child_idx, RowBatch* child_batch, RowBatch* dst_batch);
+
     // Evaluates exprs on all rows in _child_row_batch starting from _child_row_idx,
     // and materializes their results into *tuple.
     // Adds *tuple into row_batch, and increments *tuple.
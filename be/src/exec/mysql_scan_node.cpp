@@ -15,8 +15,10 @@
 
 #include "mysql_scan_node.h"
 
+#include <stdlib.h>
 #include <sstream>
 
+#include "common/config.h"
 #include "exec/text_converter.hpp"
 #include "gen_cpp/PlanNodes_types.h"
 #include "runtime/runtime_state.h"
@@ -35,7 +37,13 @@ MysqlScanNode::MysqlScanNode(ObjectPool* pool, const TPlanNode& tnode,
       _tuple_id(tnode.mysql_scan_node.tuple_id),
       _columns(tnode.mysql_scan_node.columns),
       _filters(tnode.mysql_scan_node.filters),
-      _tuple_desc(nullptr) {
+      _tuple_desc(nullptr),
+      _runtime_state(nullptr),
+      _num_running_splits(0),
+      _split_done(false) {
+    if (tnode.mysql_scan_node.__isset.split_column) {
+        _split_column = tnode.mysql_scan_node.split_column;
+    }
 }
 
 MysqlScanNode::~MysqlScanNode() {
@@ -53,6 +61,7 @@ Status MysqlScanNode::prepare(RuntimeState* state) {
     }
 
     RETURN_IF_ERROR(ScanNode::prepare(state));
+    _runtime_state = state;
     // get tuple desc
     _tuple_desc = state->desc_tbl().get_tuple_descriptor(_tuple_id);
 
@@ -81,12 +90,6 @@ Status MysqlScanNode::prepare(RuntimeState* state) {
         return Status("new a mysql scanner failed.");
     }
 
-    _tuple_pool.reset(new(std::nothrow) MemPool(mem_tracker()));
-
-    if (_tuple_pool.get() == NULL) {
-        return Status("new a mem pool failed.");
-    }
-
     _text_converter.reset(new(std::nothrow) TextConverter('\\'));
 
     if (_text_converter.get() == NULL) {
@@ -113,96 +116,123 @@ Status MysqlScanNode::open(RuntimeState* state) {
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::OPEN));
     RETURN_IF_CANCELLED(state);
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(_mysql_scanner->open());
-    RETURN_IF_ERROR(_mysql_scanner->query(_table_name, _columns, _filters));
-    // check materialize slot num
-    int materialize_num = 0;
+    RETURN_IF_ERROR(init_splits());
 
-    for (int i = 0; i < _tuple_desc->slots().size(); ++i) {
-        if (_tuple_desc->slots()[i]->is_materialized()) {
-            materialize_num++;
-        }
+    if (_split_filters.empty()) {
+        // MySQL applies all conjuncts, so the limit can be applied by MySQL too
+        RETURN_IF_ERROR(_mysql_scanner->query(_table_name, _columns, _filters, _limit));
+        return check_field_num(*_mysql_scanner);
     }
 
-    if (_mysql_scanner->field_num() != materialize_num) {
-        return Status("input and output not equal.");
+    _split_batches.reset(new RowBatchQueue(_split_filters.size() * 2));
+    _num_running_splits = _split_filters.size();
+    for (int i = 0; i < _split_filters.size(); ++i) {
+        _split_threads.create_thread(boost::bind(&MysqlScanNode::scan_split, this, i));
     }
-
     return Status::OK;
 }
 
-Status MysqlScanNode::write_text_slot(char* value, int value_length,
-                                    SlotDescriptor* slot, RuntimeState* state) {
-    if (!_text_converter->write_slot(slot, _tuple, value, value_length,
-                                     true, false, _tuple_pool.get())) {
-        std::stringstream ss;
-        ss << "fail to convert mysql value '" << value << "' TO " << slot->type();
-        return Status(ss.str());
+Status MysqlScanNode::init_splits() {
+    // a limited scan is cheaper in one query which stops at the limit
+    if (_split_column.empty() || _limit != -1 || config::mysql_scan_split_num <= 1) {
+        return Status::OK;
     }
 
+    std::vector<std::string> fields;
+    fields.push_back("MIN(" + _split_column + ")");
+    fields.push_back("MAX(" + _split_column + ")");
+    RETURN_IF_ERROR(_mysql_scanner->query(_table_name, fields, _filters));
+    char** data = NULL;
+    unsigned long* length = NULL;
+    bool eos = false;
+    RETURN_IF_ERROR(_mysql_scanner->get_next_row(&data, &length, &eos));
+    if (eos || data[0] == nullptr || data[1] == nullptr) {
+        // no rows, or only NULLs in the column
+        return Status::OK;
+    }
+    int64_t min_value = strtoll(data[0], NULL, 10);
+    int64_t max_value = strtoll(data[1], NULL, 10);
+    while (!eos) {
+        RETURN_IF_ERROR(_mysql_scanner->get_next_row(&data, &length, &eos));
+    }
+
+    // offsets from min_value are unsigned to cover the whole int64 range
+    uint64_t span = static_cast<uint64_t>(max_value) - static_cast<uint64_t>(min_value);
+    uint64_t num_splits = config::mysql_scan_split_num;
+    uint64_t step = span / num_splits + 1;
+    for (uint64_t offset = 0; offset <= span; offset += step) {
+        int64_t lower = static_cast<int64_t>(static_cast<uint64_t>(min_value) + offset);
+        std::stringstream filter;
+        filter << _split_column << " >= " << lower;
+        if (span - offset >= step) {
+            filter << " AND " << _split_column << " < " << lower + static_cast<int64_t>(step);
+        }
+        if (offset == 0) {
+            // rows with NULL in the column are read with the first range
+            filter << " OR " << _split_column << " IS NULL";
+        }
+        _split_filters.push_back(_filters);
+        _split_filters.back().push_back(filter.str());
+        if (span - offset < step) {
+            break;
+        }
+    }
+    if (_split_filters.size() == 1) {
+        _split_filters.clear();
+    }
+    VLOG(1) << "MysqlScanNode splits " << _table_name << " into " << _split_filters.size()
+            << " ranges of " << _split_column;
     return Status::OK;
 }
 
-Status MysqlScanNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos) {
-    VLOG(1) << "MysqlScanNode::GetNext";
+Status MysqlScanNode::check_field_num(const MysqlScanner& scanner) {
+    // check materialize slot num
+    int materialize_num = 0;
 
-    if (NULL == state || NULL == row_batch || NULL == eos) {
-        return Status("input is NULL pointer");
+    for (int i = 0; i < _tuple_desc->slots().size(); ++i) {
+        if (_tuple_desc->slots()[i]->is_materialized()) {
+            materialize_num++;
+        }
     }
 
-    if (!_is_init) {
-        return Status("used before initialize.");
+    if (scanner.field_num() != materialize_num) {
+        return Status("input and output not equal.");
     }
 
-    RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
-    RETURN_IF_CANCELLED(state);
-    SCOPED_TIMER(_runtime_profile->total_time_counter());
-    SCOPED_TIMER(materialize_tuple_timer());
+    return Status::OK;
+}
 
-    if (reached_limit()) {
-        *eos = true;
-        return Status::OK;
+Status MysqlScanNode::fill_batch(MysqlScanner* scanner, TextConverter* converter,
+                                 RowBatch* row_batch, int64_t max_rows, bool* eos) {
+    int num_rows = row_batch->capacity() - row_batch->num_rows();
+    if (max_rows != -1 && max_rows < num_rows) {
+        num_rows = max_rows;
     }
-
-    // create new tuple buffer for row_batch
-    int tuple_buffer_size = row_batch->capacity() * _tuple_desc->byte_size();
-    void* tuple_buffer = _tuple_pool->allocate(tuple_buffer_size);
+    // allocate the tuples of all rows of the batch at once
+    int tuple_size = _tuple_desc->byte_size();
+    uint8_t* tuple_buffer = row_batch->tuple_data_pool()->allocate(num_rows * tuple_size);
 
     if (NULL == tuple_buffer) {
         return Status("Allocate memory failed.");
     }
 
-    _tuple = reinterpret_cast<Tuple*>(tuple_buffer);
-    // Indicates whether there are more rows to process. Set in _hbase_scanner.next().
-    bool mysql_eos = false;
-
-    while (true) {
-        RETURN_IF_CANCELLED(state);
+    int row_idx = row_batch->add_rows(num_rows);
+    int num_added = 0;
+    *eos = false;
 
-        if (reached_limit() || row_batch->is_full()) {
-            // hang on to last allocated chunk in pool, we'll keep writing into it in the
-            // next get_next() call
-            row_batch->tuple_data_pool()->acquire_data(_tuple_pool.get(), !reached_limit());
-            *eos = reached_limit();
-            return Status::OK;
-        }
-
-        // read mysql
+    while (num_added < num_rows) {
         char** data = NULL;
         unsigned long* length = NULL;
-        RETURN_IF_ERROR(_mysql_scanner->get_next_row(&data, &length, &mysql_eos));
+        RETURN_IF_ERROR(scanner->get_next_row(&data, &length, eos));
 
-        if (mysql_eos) {
-            row_batch->tuple_data_pool()->acquire_data(_tuple_pool.get(), false);
-            *eos = true;
-            return Status::OK;
+        if (*eos) {
+            break;
         }
 
-        int row_idx = row_batch->add_row();
-        TupleRow* row = row_batch->get_row(row_idx);
-        // scan node is the first tuple of tuple row
-        row->set_tuple(0, _tuple);
-        memset(_tuple, 0, _tuple_desc->num_null_bytes());
+        Tuple* tuple = reinterpret_cast<Tuple*>(tuple_buffer + num_added * tuple_size);
+        memset(tuple, 0, _tuple_desc->num_null_bytes());
         int j = 0;
 
         for (int i = 0; i < _slot_num; ++i) {
@@ -214,31 +244,126 @@ Status MysqlScanNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* e
 
             if (data[j] == nullptr) {
                 if (slot_desc->is_nullable()) {
-                    _tuple->set_null(slot_desc->null_indicator_offset());
+                    tuple->set_null(slot_desc->null_indicator_offset());
                 } else {
                     std::stringstream ss;
                     ss << "nonnull column contains NULL. table=" << _table_name
                         << ", column=" << slot_desc->col_name();
                     return Status(ss.str());
                 }
-            } else {
-                RETURN_IF_ERROR(write_text_slot(data[j], length[j], slot_desc, state));
+            } else if (!converter->write_slot(slot_desc, tuple, data[j], length[j],
+                                              true, false, row_batch->tuple_data_pool())) {
+                std::stringstream ss;
+                ss << "fail to convert mysql value '" << data[j] << "' TO "
+                    << slot_desc->type();
+                return Status(ss.str());
             }
 
             j++;
         }
 
-        // MySQL has filter all rows, no need check.
-        {
-            row_batch->commit_last_row();
-            ++_num_rows_returned;
-            COUNTER_SET(_rows_returned_counter, _num_rows_returned);
-            char* new_tuple = reinterpret_cast<char*>(_tuple);
-            new_tuple += _tuple_desc->byte_size();
-            _tuple = reinterpret_cast<Tuple*>(new_tuple);
+        // scan node is the first tuple of tuple row
+        row_batch->get_row(row_idx + num_added)->set_tuple(0, tuple);
+        ++num_added;
+    }
+
+    // MySQL has filter all rows, no need check.
+    row_batch->commit_rows(num_added);
+    return Status::OK;
+}
+
+void MysqlScanNode::scan_split(int split_idx) {
+    MysqlScanner scanner(_my_param);
+    TextConverter converter('\\');
+    Status status = scanner.open();
+
+    if (status.ok()) {
+        status = scanner.query(_table_name, _columns, _split_filters[split_idx]);
+    }
+
+    if (status.ok()) {
+        status = check_field_num(scanner);
+    }
+
+    bool eos = false;
+
+    while (status.ok() && !eos && !_split_done) {
+        std::unique_ptr<RowBatch> row_batch(
+            new RowBatch(row_desc(), _runtime_state->batch_size(), mem_tracker()));
+        status = fill_batch(&scanner, &converter, row_batch.get(), -1, &eos);
+
+        if (!status.ok() || row_batch->num_rows() == 0) {
+            break;
+        }
+
+        while (!_split_done) {
+            if (_split_batches->AddBatchWithTimeout(row_batch.get(), 1000000)) {
+                row_batch.release();
+                break;
+            }
+        }
+    }
+
+    boost::lock_guard<boost::mutex> l(_split_lock);
+
+    if (!status.ok() && _split_status.ok()) {
+        _split_status = status;
+        _split_done = true;
+        _split_batches->shutdown();
+    }
+
+    if (--_num_running_splits == 0) {
+        _split_batches->shutdown();
+    }
+}
+
+Status MysqlScanNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos) {
+    VLOG(1) << "MysqlScanNode::GetNext";
+
+    if (NULL == state || NULL == row_batch || NULL == eos) {
+        return Status("input is NULL pointer");
+    }
+
+    if (!_is_init) {
+        return Status("used before initialize.");
+    }
+
+    RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
+    RETURN_IF_CANCELLED(state);
+    SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
+    SCOPED_TIMER(materialize_tuple_timer());
+
+    if (reached_limit()) {
+        *eos = true;
+        return Status::OK;
+    }
+
+    if (!_split_filters.empty()) {
+        RowBatch* split_batch = _split_batches->GetBatch();
+
+        if (split_batch == NULL) {
+            *eos = true;
+            boost::lock_guard<boost::mutex> l(_split_lock);
+            return _split_status;
         }
+
+        row_batch->acquire_state(split_batch);
+        delete split_batch;
+        _num_rows_returned += row_batch->num_rows();
+        COUNTER_SET(_rows_returned_counter, _num_rows_returned);
+        *eos = false;
+        return Status::OK;
     }
 
+    // Indicates whether there are more rows to process. Set in _mysql_scanner.next().
+    bool mysql_eos = false;
+    int num_rows = row_batch->num_rows();
+    RETURN_IF_ERROR(fill_batch(_mysql_scanner.get(), _text_converter.get(), row_batch,
+                               _limit == -1 ? -1 : _limit - _num_rows_returned, &mysql_eos));
+    _num_rows_returned += row_batch->num_rows() - num_rows;
+    COUNTER_SET(_rows_returned_counter, _num_rows_returned);
+    *eos = mysql_eos || reached_limit();
     return Status::OK;
 }
 
@@ -248,11 +373,23 @@ Status MysqlScanNode::close(RuntimeState* state) {
     }
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::CLOSE));
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
+
+    if (_split_batches != NULL) {
+        {
+            boost::lock_guard<boost::mutex> l(_split_lock);
+            _split_done = true;
+            _split_batches->shutdown();
+        }
+        _split_threads.join_all();
+        RowBatch* batch = NULL;
+
+        while ((batch = _split_batches->GetBatch()) != NULL) {
+            delete batch;
+        }
 
-    if (memory_used_counter() != NULL) {
-        COUNTER_UPDATE(memory_used_counter(), _tuple_pool->peak_allocated_bytes());
+        _split_batches->Cleanup();
     }
-    _tuple_pool.reset();
 
     return ExecNode::close(state);
 }
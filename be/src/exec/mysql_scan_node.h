@@ -18,6 +18,9 @@
 
 #include <memory>
 
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+
 #include "runtime/descriptors.h"
 #include "exec/mysql_scanner.h"
 #include "exec/scan_node.h"
@@ -42,8 +45,8 @@ public:
     // Start MySQL scan using _mysql_scanner.
     virtual Status open(RuntimeState* state);
 
-    // Fill the next row batch by calling next() on the _mysql_scanner,
-    // converting text data in MySQL cells to binary data.
+    // Fill the next row batch by calling next() on the _mysql_scanner, or with a batch
+    // of the split scans, converting text data in MySQL cells to binary data.
     virtual Status get_next(RuntimeState* state, RowBatch* row_batch, bool* eos);
 
     // Close the _mysql_scanner, and report errors.
@@ -57,10 +60,21 @@ protected:
     virtual void debug_string(int indentation_level, std::stringstream* out) const;
 
 private:
-    // Writes a slot in _tuple from an MySQL value containing text data.
-    // The Mysql value is converted into the appropriate target type.
-    Status write_text_slot(char* value, int value_length, SlotDescriptor* slot,
-                         RuntimeState* state);
+    // Sets _split_filters if the scan can be split on _split_column: it reads the
+    // range of the column and divides it into config::mysql_scan_split_num ranges.
+    Status init_splits();
+
+    // Returns an error if the query of 'scanner' doesn't return the materialized slots.
+    Status check_field_num(const MysqlScanner& scanner);
+
+    // Appends the rows read from 'scanner' to 'row_batch' until it is full or holds
+    // 'max_rows' more rows, -1 for no bound. The rows are converted by 'converter'
+    // into tuples allocated from the pool of 'row_batch' together.
+    Status fill_batch(MysqlScanner* scanner, TextConverter* converter, RowBatch* row_batch,
+                      int64_t max_rows, bool* eos);
+
+    // Thread scanning the range of _split_filters[split_idx] into _split_batches.
+    void scan_split(int split_idx);
 
     bool _is_init;
     MysqlScannerParam _my_param;
@@ -75,18 +89,32 @@ private:
     // where clause
     std::vector<std::string> _filters;
 
+    // integer column the scan may be split on, empty if none
+    std::string _split_column;
+
     // Descriptor of tuples read from MySQL table.
     const TupleDescriptor* _tuple_desc;
     // Tuple index in tuple row.
     int _slot_num;
-    // Pool for allocating tuple data, including all varying-length slots.
-    std::unique_ptr<MemPool> _tuple_pool;
+    RuntimeState* _runtime_state;
     // Jni helper for scanning an HBase table.
     std::unique_ptr<MysqlScanner> _mysql_scanner;
     // Helper class for converting text to other types;
     std::unique_ptr<TextConverter> _text_converter;
-    // Current tuple.
-    Tuple* _tuple = nullptr;
+
+    // The where clauses of the ranges scanned in parallel, empty if the scan is not
+    // split and _mysql_scanner reads all rows in get_next().
+    std::vector<std::vector<std::string> > _split_filters;
+    boost::thread_group _split_threads;
+    // batches read by the split threads
+    boost::scoped_ptr<RowBatchQueue> _split_batches;
+    // protects the fields below
+    boost::mutex _split_lock;
+    // the first error of a split thread
+    Status _split_status;
+    int _num_running_splits;
+    // set to stop the split threads
+    volatile bool _split_done;
 };
 
 }
@@ -92,11 +92,12 @@ Status MysqlScanner::query(const std::string& query) {
         mysql_free_result(_my_result);
     }
 
-    // use store result because mysql table is small, can load in memory avoid of many RPC
-    _my_result = mysql_store_result(_my_conn);
+    // stream the rows instead of storing them all in memory first, the network transfer
+    // then overlaps with the conversion of the rows already received
+    _my_result = mysql_use_result(_my_conn);
 
     if (NULL == _my_result) {
-        return _error_status("mysql store result failed.");
+        return _error_status("mysql use result failed.");
     }
 
     _field_num = mysql_num_fields(_my_result);
@@ -105,7 +106,7 @@ Status MysqlScanner::query(const std::string& query) {
 }
 
 Status MysqlScanner::query(const std::string& table, const std::vector<std::string>& fields,
-                           const std::vector<std::string>& filters) {
+                           const std::vector<std::string>& filters, int64_t limit) {
     if (!_is_open) {
         return Status("Query before open.");
     }
@@ -134,6 +135,10 @@ Status MysqlScanner::query(const std::string& table, const std::vector<std::stri
         }
     }
 
+    if (limit >= 0) {
+        _sql_str += " LIMIT " + std::to_string(limit);
+    }
+
     return query(_sql_str);
 }
 
@@ -153,6 +158,10 @@ Status MysqlScanner::get_next_row(char** *buf, unsigned long** lengths, bool* eo
     *buf = mysql_fetch_row(_my_result);
 
     if (NULL == *buf) {
+        // a streamed result also ends on a lost connection
+        if (0 != mysql_errno(_my_conn)) {
+            return _error_status("mysql fetch row failed.");
+        }
         *eos = true;
         return Status::OK;
     }
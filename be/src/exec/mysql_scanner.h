@@ -44,9 +44,11 @@ public:
     Status open();
     Status query(const std::string& query);
 
-    // query for PALO
+    // query for PALO, returns at most limit rows unless it is -1
     Status query(const std::string& table, const std::vector<std::string>& fields,
-                 const std::vector<std::string>& filters);
+                 const std::vector<std::string>& filters, int64_t limit = -1);
+    // The rows are streamed from the server while they are read, a new query can only
+    // be sent after all rows were read or the result is discarded by the next query().
     Status get_next_row(char** *buf, unsigned long** lengths, bool* eos);
 
     int field_num() const {
@@ -170,7 +170,9 @@ public:
         _has_range_value(false),
         _begin_include(true),
         _end_include(true),
-        _is_convertible(true) {}
+        _is_convertible(true),
+        _is_skip_scan_enabled(false),
+        _is_skip_scan(false) {}
 
     template<class T>
     Status extend_scan_key(ColumnValueRange<T>& range);
@@ -185,6 +187,8 @@ public:
         _has_range_value = false;
         _begin_scan_keys.clear();
         _end_scan_keys.clear();
+        _is_skip_scan = false;
+        _fixed_column_values.clear();
     }
 
     void debug() {
@@ -224,6 +228,23 @@ public:
         _is_convertible = is_convertible;
     }
 
+    // Instead of giving up beyond palo_max_scan_key_num scan keys, scan the range
+    // from the smallest to the largest combination of the fixed values by skip scan.
+    void set_is_skip_scan_enabled(bool is_skip_scan_enabled) {
+        _is_skip_scan_enabled = is_skip_scan_enabled;
+    }
+
+    // If true, there is only one scan key, which is to be skip-scanned with
+    // skip_scan_values().
+    bool is_skip_scan() const {
+        return _is_skip_scan;
+    }
+
+    // The fixed values of each leading key column
+    const std::vector<std::vector<std::string>>& skip_scan_values() const {
+        return _fixed_column_values;
+    }
+
     static std::string to_print_key(const std::vector<std::string>& key_vec) {
         std::string print_key;
 
@@ -245,6 +266,13 @@ private:
     bool _begin_include;
     bool _end_include;
     bool _is_convertible;
+    bool _is_skip_scan_enabled;
+    bool _is_skip_scan;
+    // fixed values of each column extended, in the order of the key columns
+    std::vector<std::vector<std::string>> _fixed_column_values;
+
+    template<class T>
+    void extend_skip_scan_key(const std::set<T>& fixed_value_set);
 };
 
 typedef boost::variant <
@@ -260,7 +288,7 @@ typedef boost::variant <
 class PaloScanRange {
 public:
     PaloScanRange(const TPaloScanRange& palo_scan_range)
-        : _scan_range(palo_scan_range)  {
+        : _scan_range(palo_scan_range), _start_version(0)  {
     }
 
     Status init();
@@ -269,6 +297,16 @@ public:
         return _scan_range;
     }
 
+    // First version of the tablet to read, 0 reads all versions up to the version of
+    // the scan range.
+    int64_t start_version() const {
+        return _start_version;
+    }
+
+    void set_start_version(int64_t start_version) {
+        _start_version = start_version;
+    }
+
     /**
      * @brief return -1 if column is not partition column
      *        return 0 if column's value range has NO intersection with partition column
@@ -297,6 +335,7 @@ public:
     };
 private:
     const TPaloScanRange _scan_range;
+    int64_t _start_version;
     std::map<std::string, ColumnValueRangeType > _partition_column_range;
 };
 
@@ -660,6 +699,8 @@ Status OlapScanKeys::extend_scan_key(ColumnValueRange<T>& range) {
     if (range.is_empty_value_range()) {
         _begin_scan_keys.clear();
         _end_scan_keys.clear();
+        _is_skip_scan = false;
+        _fixed_column_values.clear();
         return Status::OK;
     }
 
@@ -668,10 +709,31 @@ Status OlapScanKeys::extend_scan_key(ColumnValueRange<T>& range) {
         return Status::OK;
     }
 
+    // 2.1 skip scan takes the fixed values of each column instead of their
+    //     Cartesian product, a range value ends it
+    if (_is_skip_scan) {
+        if (!range.is_fixed_value_range() && range.is_fixed_value_convertible()
+                && _is_convertible
+                && range.get_convertible_fixed_value_size() <= config::palo_max_scan_key_num) {
+            range.convert_to_fixed_value();
+        }
+        if (range.is_fixed_value_range()
+                && range.get_fixed_value_size() <= config::palo_max_scan_key_num) {
+            extend_skip_scan_key(range.get_fixed_value_set());
+        } else {
+            _has_range_value = true;
+        }
+        return Status::OK;
+    }
+
     if (range.is_fixed_value_range()) {
         if ((_begin_scan_keys.empty() && range.get_fixed_value_size() > config::palo_max_scan_key_num)
                 || range.get_fixed_value_size() * _begin_scan_keys.size() > config::palo_max_scan_key_num) {
-            if (range.is_range_value_convertible()) {
+            if (_is_skip_scan_enabled
+                    && range.get_fixed_value_size() <= config::palo_max_scan_key_num) {
+                extend_skip_scan_key(range.get_fixed_value_set());
+                return Status::OK;
+            } else if (range.is_range_value_convertible()) {
                 range.convert_to_range_value();
             } else {
                 return Status::OK;
@@ -732,6 +794,11 @@ Status OlapScanKeys::extend_scan_key(ColumnValueRange<T>& range) {
             }
         }
 
+        _fixed_column_values.emplace_back();
+        for (const T& value : range.get_fixed_value_set()) {
+            _fixed_column_values.back().push_back(cast_to_string(value));
+        }
+
         _begin_include = true;
         _end_include = true;
     } // Extend ScanKey with range value
@@ -764,6 +831,25 @@ Status OlapScanKeys::extend_scan_key(ColumnValueRange<T>& range) {
     return Status::OK;
 }
 
+template<class T>
+void OlapScanKeys::extend_skip_scan_key(const std::set<T>& fixed_value_set) {
+    _is_skip_scan = true;
+    _fixed_column_values.emplace_back();
+    for (const T& value : fixed_value_set) {
+        _fixed_column_values.back().push_back(cast_to_string(value));
+    }
+
+    // the only scan key is from the smallest combination to the largest one
+    _begin_scan_keys.assign(1, std::vector<std::string>());
+    _end_scan_keys.assign(1, std::vector<std::string>());
+    for (const std::vector<std::string>& values : _fixed_column_values) {
+        _begin_scan_keys[0].push_back(values.front());
+        _end_scan_keys[0].push_back(values.back());
+    }
+    _begin_include = true;
+    _end_include = true;
+}
+
 }  // namespace palo
 
 #endif
@@ -27,14 +27,21 @@
 #include "exprs/expr.h"
 #include "exprs/binary_predicate.h"
 #include "exprs/in_predicate.h"
+#include "exec/topn_runtime_bound.h"
 #include "gen_cpp/PlanNodes_types.h"
 #include "runtime/exec_env.h"
+#include "runtime/decimal_value.h"
+#include "runtime/mem_arbitrator.h"
+#include "runtime/raw_value.h"
 #include "runtime/runtime_state.h"
 #include "runtime/row_batch.h"
 #include "runtime/string_value.h"
 #include "runtime/tuple_row.h"
 #include "util/runtime_profile.h"
+#include "util/blocking_aware_thread_pool.h"
+#include "util/cpu_profiler.h"
 #include "util/thread_pool.hpp"
+#include "util/uid_util.h"
 #include "util/debug_util.h"
 #include "agent/cgroups_mgr.h"
 #include "common/resource_tls.h"
@@ -66,7 +73,23 @@ OlapScanNode::OlapScanNode(ObjectPool* pool, const TPlanNode& tnode, const Descr
         _resource_info(nullptr),
         _buffered_bytes(0),
         _running_thread(0),
-        _eval_conjuncts_fn(nullptr) {
+        _scanner_concurrency(0),
+        _concurrency_window_batches(0),
+        _last_consumer_wait_num(0),
+        _last_producer_wait_num(0),
+        _consumer_wait_num(0),
+        _producer_wait_num(0),
+        _peak_scanner_concurrency_counter(NULL),
+        _split_scanner_counter(NULL),
+        _is_limit_pushdown(false),
+        _remaining_limit(0),
+        _eval_conjuncts_fn(nullptr),
+        _topn_bound(NULL),
+        _topn_bound_on_key_column(false),
+        _topn_filtered_counter(NULL),
+        _is_streaming_agg(false),
+        _streaming_agg_dict_slot(NULL),
+        _streaming_agg_merged_counter(NULL) {
 }
 
 OlapScanNode::~OlapScanNode() {
@@ -97,12 +120,22 @@ Status OlapScanNode::prepare(RuntimeState* state) {
     _olap_thread_scan_timer = ADD_TIMER(_runtime_profile, "OlapScanTime");
     _eval_timer = ADD_TIMER(_runtime_profile, "EvalTime");
     _merge_timer = ADD_TIMER(_runtime_profile, "SortMergeTime");
+    _scanner_cpu_time_counter = ADD_TIMER(_runtime_profile, "ScannerCpuTime");
+    _wait_scanner_timer = ADD_TIMER(_runtime_profile, "WaitScannerTime");
     _pushdown_return_counter =
         ADD_COUNTER(runtime_profile(), "PushDownFilterReturnCount ", TUnit::UNIT);
     _direct_return_counter =
         ADD_COUNTER(runtime_profile(), "DirectFilterReturnCount ", TUnit::UNIT);
     _tablet_counter =
         ADD_COUNTER(runtime_profile(), "TabletCount ", TUnit::UNIT);
+    _topn_filtered_counter =
+        ADD_COUNTER(runtime_profile(), "TopNBoundFilteredRows", TUnit::UNIT);
+    _streaming_agg_merged_counter =
+        ADD_COUNTER(runtime_profile(), "StreamingAggMergedRows", TUnit::UNIT);
+    _peak_scanner_concurrency_counter =
+        ADD_COUNTER(runtime_profile(), "PeakScannerConcurrency", TUnit::UNIT);
+    _split_scanner_counter =
+        ADD_COUNTER(runtime_profile(), "SplitScannerCount", TUnit::UNIT);
 
     _tuple_desc = state->desc_tbl().get_tuple_descriptor(_tuple_id);
     if (_tuple_desc == NULL) {
@@ -124,6 +157,8 @@ Status OlapScanNode::prepare(RuntimeState* state) {
         _string_slots.push_back(slots[i]);
     }
 
+    RETURN_IF_ERROR(init_streaming_agg(state));
+
     if (state->codegen_level() > 0) {
         LlvmCodeGen* codegen = NULL;
         RETURN_IF_ERROR(state->get_codegen(&codegen));
@@ -136,12 +171,18 @@ Status OlapScanNode::prepare(RuntimeState* state) {
     }
 
     _runtime_state = state;
+    _row_batch_pool.reset(new RowBatchPool(
+            row_desc(), state->fragment_mem_tracker(),
+            config::row_batch_pool_max_free_batches));
+    state->mem_arbitrator()->add_reclaimer(
+            this, boost::bind<int64_t>(&OlapScanNode::reclaim_memory, this, _1));
     return Status::OK;
 }
 
 Status OlapScanNode::open(RuntimeState* state) {
     VLOG(1) << "OlapScanNode::Open";
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_CANCELLED(state);
     RETURN_IF_ERROR(ExecNode::open(state));
 
@@ -156,6 +197,9 @@ Status OlapScanNode::open(RuntimeState* state) {
     }
 
     _resource_info = ResourceTls::get_resource_tls();
+    if (_resource_info != nullptr) {
+        _scanner_group = _resource_info->group;
+    }
 
     return Status::OK;
 }
@@ -163,6 +207,7 @@ Status OlapScanNode::open(RuntimeState* state) {
 Status OlapScanNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos) {
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
 
     // check if Canceled.
     if (state->is_cancelled()) {
@@ -196,11 +241,17 @@ Status OlapScanNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eo
     {
         boost::unique_lock<boost::mutex> l(_row_batches_lock);
 
+        if (_materialized_row_batches.empty() && !_transfer_done) {
+            ++_consumer_wait_num;
+        }
         while (_materialized_row_batches.empty() && !_transfer_done) {
             if (state->is_cancelled()) {
                 _transfer_done = true;
             }
 
+            SCOPED_TIMER(_wait_scanner_timer);
+            BlockingAwareThreadPool::ScopedBlocking blocking(&l);
+            ThreadResourceMgr::ScopedBlockedThread blocked(state->resource_pool());
             _row_batch_added_cv.timed_wait(l, _wait_duration);
         }
 
@@ -215,6 +266,9 @@ Status OlapScanNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eo
     if (NULL != materialized_batch) {
         // notify scanner
         _row_batch_consumed_cv.notify_one();
+        // the scanner accounted the chunks of its batch, which may include chunks that
+        // the batch kept from its previous use
+        int64_t batch_bytes = materialized_batch->tuple_data_pool()->total_reserved_bytes();
         // get scanner's batch memory
         row_batch->acquire_state(materialized_batch);
         _num_rows_returned += row_batch->num_rows();
@@ -246,10 +300,9 @@ Status OlapScanNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eo
                     << print_tuple(row->get_tuple(0), *_tuple_desc);
             }
         }
-        __sync_fetch_and_sub(&_buffered_bytes,
-                             row_batch->tuple_data_pool()->total_reserved_bytes());
+        __sync_fetch_and_sub(&_buffered_bytes, batch_bytes);
 
-        delete materialized_batch;
+        _row_batch_pool->put(materialized_batch);
         return Status::OK;
     }
 
@@ -290,6 +343,8 @@ Status OlapScanNode::close(RuntimeState* state) {
     }
 
     _scan_row_batches.clear();
+    state->mem_arbitrator()->remove_reclaimers(this);
+    _row_batch_pool.reset();
 
     if (_is_result_order) {
         for (int i = 0; i < _merge_rowbatches.size(); ++i) {
@@ -318,12 +373,39 @@ Status OlapScanNode::close(RuntimeState* state) {
     return ExecNode::close(state);
 }
 
+bool OlapScanNode::push_down_topn_bound(TopNRuntimeBound* bound) {
+    if (_tuple_desc == NULL || bound->slot_desc()->parent() != _tuple_id) {
+        return false;
+    }
+    _topn_bound = bound;
+    const std::vector<std::string>& key_columns = _olap_scan_node.key_column_name;
+    _topn_bound_on_key_column = std::find(key_columns.begin(), key_columns.end(),
+            bound->slot_desc()->col_name()) != key_columns.end();
+    VLOG(1) << "Push down topn bound to olap scan node " << id()
+            << ", column=" << bound->slot_desc()->col_name()
+            << ", is_key=" << _topn_bound_on_key_column;
+    return true;
+}
+
 Status OlapScanNode::set_scan_ranges(const std::vector<TScanRangeParams>& scan_ranges) {
     BOOST_FOREACH(const TScanRangeParams & scan_range, scan_ranges) {
         DCHECK(scan_range.scan_range.__isset.palo_scan_range);
-        boost::shared_ptr<PaloScanRange> palo_scan_range(
-            new PaloScanRange(scan_range.scan_range.palo_scan_range));
+        const TPaloScanRange& t_scan_range = scan_range.scan_range.palo_scan_range;
+        std::map<int64_t, int64_t>::const_iterator start_it =
+            _start_versions.find(t_scan_range.tablet_id);
+
+        if (start_it != _start_versions.end()
+                && start_it->second > strtoll(t_scan_range.version.c_str(), NULL, 10)) {
+            // nothing new to read
+            continue;
+        }
+
+        boost::shared_ptr<PaloScanRange> palo_scan_range(new PaloScanRange(t_scan_range));
         RETURN_IF_ERROR(palo_scan_range->init());
+
+        if (start_it != _start_versions.end()) {
+            palo_scan_range->set_start_version(start_it->second);
+        }
         VLOG(1) << "palo_scan_range table=" << scan_range.scan_range.palo_scan_range.table_name <<
                 " version" << scan_range.scan_range.palo_scan_range.version;
         _palo_scan_ranges.push_back(palo_scan_range);
@@ -518,6 +600,8 @@ Status OlapScanNode::build_scan_key() {
     int order_column_index = -1;
     int column_index = 0;
     _scan_keys.set_is_convertible(limit() == -1);
+    // 有序扫描需要按scan key的顺序逐个读取, 不能跳跃扫描
+    _scan_keys.set_is_skip_scan_enabled(config::enable_olap_skip_scan && !_is_result_order);
 
     for (; column_index < column_names.size() && !_scan_keys.has_range_value(); ++column_index) {
         if (_is_result_order && _sort_column == column_names[column_index]) {
@@ -584,6 +668,13 @@ Status OlapScanNode::start_scan_thread(RuntimeState* state) {
         key_range_num_per_scanner = 1;
     }
 
+    // 没有任何过滤条件时, COUNT(*)和MIN/MAX可以交给存储层从元数据得到
+    TPushAggOp::type push_agg_op = TPushAggOp::NONE;
+    if (_olap_scan_node.__isset.push_agg_op && _conjunct_ctxs.empty()
+            && _olap_filter.empty() && _is_null_vector.empty()) {
+        push_agg_op = _olap_scan_node.push_agg_op;
+    }
+
     // scan range per therad
     for (int i = 0; i < key_range_size;) {
         boost::shared_ptr<PaloScanRange> scan_range = _query_scan_ranges[i];
@@ -611,12 +702,27 @@ Status OlapScanNode::start_scan_thread(RuntimeState* state) {
             _scanner_profile,
             _is_null_vector);
         scanner->set_aggregation(_olap_scan_node.is_preaggregation);
+        // rows of a scan in result order have to come in key order
+        scanner->set_adaptive_aggregation(!_is_result_order);
+        scanner->set_push_agg_op(push_agg_op);
+        if (_topn_bound_on_key_column) {
+            scanner->set_topn_bound(_topn_bound);
+        }
+        if (_scan_keys.is_skip_scan()) {
+            scanner->set_skip_scan_values(&_scan_keys.skip_scan_values());
+        }
 
         _scanner_pool->add(scanner);
         _olap_scanners.push_back(scanner);
         _all_olap_scanners = _olap_scanners;
     }
 
+    // 有序扫描需要每个scanner的前limit行做归并, 不能共享行数
+    if (_limit != -1 && !_is_result_order) {
+        _is_limit_pushdown = true;
+        _remaining_limit = _limit;
+    }
+
     // init progress
     std::stringstream ss;
     ss << "ScanThread complete (node=" << id() << "):";
@@ -714,6 +820,69 @@ static bool ignore_cast(SlotDescriptor* slot, Expr* expr) {
     return false;
 }
 
+template<class T>
+void OlapScanNode::normalize_in_predicate_bound(SlotDescriptor* slot,
+                                                InPredicate* pred,
+                                                ColumnValueRange<T>* range) {
+    bool has_value = false;
+    T min_value = T();
+    T max_value = T();
+
+    HybirdSetBase::IteratorBase* iter = pred->hybird_set()->begin();
+    while (iter->has_next()) {
+        // NULL never equals to any value, so it doesn't affect the bound
+        const void* value = iter->get_value();
+        if (NULL == value) {
+            iter->next();
+            continue;
+        }
+
+        T v;
+        switch (slot->type().type) {
+        case TYPE_TINYINT: {
+            int32_t tinyint_value = *reinterpret_cast<const int8_t*>(value);
+            v = *reinterpret_cast<T*>(&tinyint_value);
+            break;
+        }
+        case TYPE_DATE: {
+            DateTimeValue date_value = *reinterpret_cast<const DateTimeValue*>(value);
+            date_value.cast_to_date();
+            v = *reinterpret_cast<T*>(&date_value);
+            break;
+        }
+        case TYPE_DECIMAL:
+        case TYPE_LARGEINT:
+        case TYPE_CHAR:
+        case TYPE_VARCHAR:
+        case TYPE_HLL:
+        case TYPE_SMALLINT:
+        case TYPE_INT:
+        case TYPE_BIGINT:
+        case TYPE_DATETIME: {
+            v = *reinterpret_cast<const T*>(value);
+            break;
+        }
+        default: {
+            return;
+        }
+        }
+
+        if (!has_value || v < min_value) {
+            min_value = v;
+        }
+        if (!has_value || max_value < v) {
+            max_value = v;
+        }
+        has_value = true;
+        iter->next();
+    }
+
+    if (has_value) {
+        range->add_range(FILTER_LARGER_OR_EQUAL, min_value);
+        range->add_range(FILTER_LESS_OR_EQUAL, max_value);
+    }
+}
+
 template<class T>
 Status OlapScanNode::normalize_in_predicate(SlotDescriptor* slot, ColumnValueRange<T>* range) {
     for (int conj_idx = 0; conj_idx < _conjunct_ctxs.size(); ++conj_idx) {
@@ -748,10 +917,14 @@ Status OlapScanNode::normalize_in_predicate(SlotDescriptor* slot, ColumnValueRan
                 VLOG(1) << slot->col_name() << " fixed_values add num: "
                         << pred->hybird_set()->size();
 
-                // 1.2 Skip if InPredicate value size larger then max_scan_key_num
+                // 1.2 InPredicate value size larger then max_scan_key_num can't be pushed
+                // as fixed values, push its min and max value instead, so that OlapEngine
+                // can still skip the blocks out of range, e.g. runtime filter of hash join
                 if (pred->hybird_set()->size() > config::palo_max_scan_key_num) {
-                    LOG(WARNING) << "Predicate value num " << pred->hybird_set()->size()
-                                 << " excede limit " << config::palo_max_scan_key_num;
+                    VLOG(1) << "Predicate value num " << pred->hybird_set()->size()
+                            << " excede limit " << config::palo_max_scan_key_num
+                            << ", push down its min and max value";
+                    normalize_in_predicate_bound(slot, pred, range);
                     continue;
                 }
 
@@ -1012,8 +1185,13 @@ Status OlapScanNode::get_sub_scan_range(
     std::vector<OlapScanRange> scan_key_range;
     RETURN_IF_ERROR(_scan_keys.get_key_range(&scan_key_range));
 
+    // 从元数据得到聚合结果时每个tablet只能有一个scanner
+    bool is_push_agg = _olap_scan_node.__isset.push_agg_op
+            && _olap_scan_node.push_agg_op != TPushAggOp::NONE;
     if (_is_result_order ||
             limit() != -1 ||
+            is_push_agg ||
+            _scan_keys.is_skip_scan() ||
             scan_key_range.size() > 64) {
         if (scan_key_range.size() != 0) {
             *sub_range = scan_key_range;
@@ -1126,6 +1304,9 @@ TransferStatus OlapScanNode::read_row_batch(RuntimeState* state) {
                     PriorityThreadPool::Task task;
                     task.work_function = boost::bind(&OlapScanNode::scanner_thread, this, *iter);
                     task.priority = _nice;
+                    task.group = _scanner_group;
+                    task.query_key = hash_value(state->query_id());
+                    task.numa_node = (*iter)->numa_node();
                     if (state->exec_env()->thread_pool()->offer(task)) {
                         _olap_scanners.erase(iter++);
                     } else {
@@ -1377,7 +1558,8 @@ void OlapScanNode::transfer_thread(RuntimeState* state) {
      *    读取的数据越多，越倾向于认定为大查询，nice值越小
      * 3. 通过nice值来判断查询的优先级
      *    nice值越大的，越优先获得的查询资源
-     * 4. 定期提高队列内残留任务的优先级，避免大查询完全饿死
+     * 4. 不同资源组、不同查询之间按加权公平排队共享线程池，nice值越小的查询
+     *    权重越低，避免大查询独占线程池或完全饿死（见PriorityThreadPool）
      *********************************/
     PriorityThreadPool* thread_pool = state->exec_env()->thread_pool();
     _total_assign_num = 0;
@@ -1395,6 +1577,13 @@ void OlapScanNode::transfer_thread(RuntimeState* state) {
     if (config::palo_scanner_row_num > state->batch_size()) {
         max_thread /= config::palo_scanner_row_num / state->batch_size();
     }
+    max_thread = std::max(1, max_thread);
+    // Start with a quarter of the scanners and let the consumer pull in more, so that
+    // a scan under a limit or a slow sink doesn't occupy max_thread scanner threads
+    // and their row batches.
+    _scanner_concurrency = config::enable_adaptive_scanner_concurrency
+            ? std::max(1, max_thread / 4) : max_thread;
+    COUNTER_SET(_peak_scanner_concurrency_counter, (int64_t)_scanner_concurrency);
     // read from scanner
     while (LIKELY(status.ok())) {
         int assigned_thread_num = 0;
@@ -1410,7 +1599,7 @@ void OlapScanNode::transfer_thread(RuntimeState* state) {
                 mem_consume = state->fragment_mem_tracker()->consumption();
             }
             if (mem_consume < (mem_limit * 6) / 10) {
-                thread_slot_num = max_thread - assigned_thread_num;
+                thread_slot_num = std::max(0, _scanner_concurrency - assigned_thread_num);
             } else {
                 // Memory already exceed
                 if (_scan_row_batches.empty()) {
@@ -1427,6 +1616,29 @@ void OlapScanNode::transfer_thread(RuntimeState* state) {
                     }
                 }
             }
+            // limit已经满足, 没有启动或者读了一部分的scanner都不需要再读了
+            if (UNLIKELY(_reached_pushdown_limit()) && !_olap_scanners.empty()) {
+                VLOG(1) << "skip " << _olap_scanners.size()
+                    << " scanners, cause pushdown limit reached";
+                _progress.update(_olap_scanners.size());
+                _olap_scanners.clear();
+                if (_progress.done()) {
+                    _scanner_done = true;
+                }
+            }
+            // 有空闲的线程但没有等待的scanner时, 把正在读的scanner还没有开始读的
+            // key range分给新的scanner, 避免个别scanner拖长整个扫描
+            if (config::enable_scanner_key_range_split
+                    && thread_slot_num > _olap_scanners.size()
+                    && !_scanner_done && !_reached_pushdown_limit()) {
+                status = split_running_scanners(
+                        state, thread_slot_num - _olap_scanners.size());
+                if (!status.ok()) {
+                    boost::lock_guard<boost::mutex> guard(_status_mutex);
+                    _status = status;
+                    break;
+                }
+            }
             thread_slot_num = std::min(thread_slot_num, _olap_scanners.size());
             for (int i = 0; i < thread_slot_num; ++i) {
                 olap_scanners.push_back(_olap_scanners.front());
@@ -1439,8 +1651,16 @@ void OlapScanNode::transfer_thread(RuntimeState* state) {
         iter = olap_scanners.begin();
         while (iter != olap_scanners.end()) {
             PriorityThreadPool::Task task;
-            task.work_function = boost::bind(&OlapScanNode::scanner_thread, this, *iter);
+            if (config::enable_vectorized_olap_scan) {
+                task.work_function = boost::bind(
+                        &OlapScanNode::vectorized_scanner_thread, this, *iter);
+            } else {
+                task.work_function = boost::bind(&OlapScanNode::scanner_thread, this, *iter);
+            }
             task.priority = _nice;
+            task.group = _scanner_group;
+            task.query_key = hash_value(state->query_id());
+            task.numa_node = (*iter)->numa_node();
             if (thread_pool->offer(task)) {
                 olap_scanners.erase(iter++);
             } else {
@@ -1489,6 +1709,7 @@ void OlapScanNode::transfer_thread(RuntimeState* state) {
 
         if (NULL != scan_batch) {
             add_one_batch(scan_batch);
+            update_scanner_concurrency(max_thread);
         }
     }
 
@@ -1498,11 +1719,158 @@ void OlapScanNode::transfer_thread(RuntimeState* state) {
     _row_batch_added_cv.notify_all();
 }
 
+Status OlapScanNode::init_streaming_agg(RuntimeState* state) {
+    if (!_olap_scan_node.__isset.streaming_agg_group_slots
+            || !_olap_scan_node.__isset.streaming_agg_slots
+            || _olap_scan_node.streaming_agg_slots.empty()) {
+        return Status::OK;
+    }
+    // merged rows would be counted as one by the limit
+    if (_limit != -1) {
+        return Status::OK;
+    }
+
+    for (TSlotId slot_id : _olap_scan_node.streaming_agg_group_slots) {
+        const SlotDescriptor* slot = state->desc_tbl().get_slot_descriptor(slot_id);
+        if (slot == NULL) {
+            return Status("Failed to get slot descriptor of streaming aggregation.");
+        }
+        _streaming_agg_group_slots.push_back(slot);
+    }
+
+    for (const TOlapScanAggSlot& agg_slot : _olap_scan_node.streaming_agg_slots) {
+        const SlotDescriptor* slot = state->desc_tbl().get_slot_descriptor(agg_slot.slot_id);
+        if (slot == NULL) {
+            return Status("Failed to get slot descriptor of streaming aggregation.");
+        }
+
+        // a partial sum is kept in the slot, so its type must be the type of the sum
+        bool supported = false;
+        switch (slot->type().type) {
+        case TYPE_BIGINT:
+        case TYPE_LARGEINT:
+        case TYPE_DOUBLE:
+        case TYPE_DECIMAL:
+            supported = agg_slot.op == TAggregationOp::SUM
+                || agg_slot.op == TAggregationOp::MIN || agg_slot.op == TAggregationOp::MAX;
+            break;
+        case TYPE_TINYINT:
+        case TYPE_SMALLINT:
+        case TYPE_INT:
+        case TYPE_FLOAT:
+        case TYPE_DATE:
+        case TYPE_DATETIME:
+            supported = agg_slot.op == TAggregationOp::MIN || agg_slot.op == TAggregationOp::MAX;
+            break;
+        default:
+            break;
+        }
+        if (!supported) {
+            LOG(WARNING) << "streaming aggregation is off, unsupported op " << agg_slot.op
+                << " on slot " << slot->debug_string();
+            _streaming_agg_group_slots.clear();
+            _streaming_agg_slots.clear();
+            return Status::OK;
+        }
+        _streaming_agg_slots.push_back({slot, agg_slot.op});
+    }
+
+    if (_streaming_agg_group_slots.size() == 1
+            && _streaming_agg_group_slots[0]->type().is_string_type()) {
+        _streaming_agg_dict_slot = _streaming_agg_group_slots[0];
+    }
+    _is_streaming_agg = true;
+    return Status::OK;
+}
+
+bool OlapScanNode::merge_streaming_agg_row(Tuple* dst, const Tuple* src) {
+    for (const SlotDescriptor* slot : _streaming_agg_group_slots) {
+        bool is_null = dst->is_null(slot->null_indicator_offset());
+        if (is_null != src->is_null(slot->null_indicator_offset())) {
+            return false;
+        }
+        if (!is_null && !RawValue::eq(dst->get_slot(slot->tuple_offset()),
+                                      src->get_slot(slot->tuple_offset()), slot->type())) {
+            return false;
+        }
+    }
+
+    merge_streaming_agg_values(dst, src);
+    return true;
+}
+
+void OlapScanNode::merge_streaming_agg_values(Tuple* dst, const Tuple* src) {
+    for (const StreamingAggSlot& agg_slot : _streaming_agg_slots) {
+        const SlotDescriptor* slot = agg_slot.slot;
+        if (src->is_null(slot->null_indicator_offset())) {
+            continue;
+        }
+        const void* src_value = src->get_slot(slot->tuple_offset());
+        void* dst_value = dst->get_slot(slot->tuple_offset());
+        if (dst->is_null(slot->null_indicator_offset())) {
+            dst->set_not_null(slot->null_indicator_offset());
+            RawValue::write(src_value, dst_value, slot->type(), NULL);
+            continue;
+        }
+
+        switch (agg_slot.op) {
+        case TAggregationOp::SUM:
+            switch (slot->type().type) {
+            case TYPE_BIGINT:
+                *reinterpret_cast<int64_t*>(dst_value) +=
+                    *reinterpret_cast<const int64_t*>(src_value);
+                break;
+            case TYPE_LARGEINT:
+                *reinterpret_cast<__int128*>(dst_value) +=
+                    *reinterpret_cast<const __int128*>(src_value);
+                break;
+            case TYPE_DOUBLE:
+                *reinterpret_cast<double*>(dst_value) +=
+                    *reinterpret_cast<const double*>(src_value);
+                break;
+            case TYPE_DECIMAL:
+                *reinterpret_cast<DecimalValue*>(dst_value) +=
+                    *reinterpret_cast<const DecimalValue*>(src_value);
+                break;
+            default:
+                DCHECK(false) << "unsupported type of streaming sum " << slot->type();
+                break;
+            }
+            break;
+        case TAggregationOp::MIN:
+            if (RawValue::compare(src_value, dst_value, slot->type()) < 0) {
+                RawValue::write(src_value, dst_value, slot->type(), NULL);
+            }
+            break;
+        case TAggregationOp::MAX:
+            if (RawValue::compare(src_value, dst_value, slot->type()) > 0) {
+                RawValue::write(src_value, dst_value, slot->type(), NULL);
+            }
+            break;
+        default:
+            DCHECK(false) << "unsupported streaming aggregation " << agg_slot.op;
+            break;
+        }
+    }
+}
+
+void OlapScanNode::reorder_scan_conjuncts(std::vector<ExprContext*>* row_conjunct_ctxs) {
+    if (_eval_conjuncts_fn == NULL && _direct_row_conjunct_size > 1) {
+        ExprContext::reorder_conjuncts(&(*row_conjunct_ctxs)[0], _direct_row_conjunct_size);
+    }
+    if (row_conjunct_ctxs->size() > _direct_conjunct_size + 1) {
+        ExprContext::reorder_conjuncts(&(*row_conjunct_ctxs)[_direct_conjunct_size],
+                                       row_conjunct_ctxs->size() - _direct_conjunct_size);
+    }
+}
+
 void OlapScanNode::scanner_thread(OlapScanner* scanner) {
+    SCOPED_CPU_TIMER(_scanner_cpu_time_counter);
     Status status = Status::OK;
     bool eos = false;
     RuntimeState* state = scanner->runtime_state();
     DCHECK(NULL != state);
+    CpuProfiler::ScopedQueryTag query_tag(state->query_id());
     if (!scanner->is_open()) {
         status = scanner->open();
         if (!status.ok()) {
@@ -1524,11 +1892,25 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
 
     bool _use_pushdown_conjuncts = true;
     int64_t total_rows_reader_counter = 0;
+    TopNRuntimeBound::Snapshot topn_bound;
+    bool reorder_conjuncts = config::conjunct_reorder_interval_batches > 0;
+    int num_scanned_batches = 0;
     while (!eos && total_rows_reader_counter < config::palo_scanner_row_num) {
+        // 0. Stop reading if enough rows are returned by all scanners
+        int64_t remaining_limit = -1;
+        if (_is_limit_pushdown) {
+            remaining_limit = __sync_fetch_and_add(&_remaining_limit, 0);
+            if (remaining_limit <= 0) {
+                eos = true;
+                break;
+            }
+        }
+        if (_topn_bound != NULL) {
+            _topn_bound->refresh(&topn_bound);
+        }
         // 1. Allocate one row batch
         // RowBatch *row_batch = new RowBatch(this->row_desc(), state->batch_size(), mem_tracker());
-        RowBatch *row_batch = new RowBatch(
-                this->row_desc(), state->batch_size(), _runtime_state->fragment_mem_tracker());
+        RowBatch *row_batch = _row_batch_pool->get(state->batch_size());
         row_batch->set_scanner_id(scanner->id());
         // 2. Allocate Row's Tuple buf
         uint8_t *tuple_buf = row_batch->tuple_data_pool()->allocate(
@@ -1539,6 +1921,8 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
         int direct_return_counter = 0;
         int pushdown_return_counter = 0;
         int rows_read_counter = 0;
+        int topn_filtered_counter = 0;
+        int streaming_agg_merged_counter = 0;
         // 3. Read data to each tuple
         while (true) {
             // 3.1 Break if RowBatch is Full, Try to read new RowBatch
@@ -1572,6 +1956,8 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
             int row_idx = row_batch->add_row();
             TupleRow* row = row_batch->get_row(row_idx);
             row->set_tuple(_tuple_idx, tuple);
+            bool sample_conjuncts = reorder_conjuncts
+                && rows_read_counter % CONJUNCT_SAMPLE_ROWS == 0;
 
             do {
                 // SCOPED_TIMER(_eval_timer);
@@ -1586,7 +1972,8 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
                         break;
                     }
                 } else {
-                    if (!eval_conjuncts(&((*row_conjunct_ctxs)[0]), _direct_row_conjunct_size, row)) {
+                    if (!eval_scan_conjuncts(&((*row_conjunct_ctxs)[0]),
+                                             _direct_row_conjunct_size, row, sample_conjuncts)) {
                         // check direct conjuncts fail then clear tuple for reuse
                         // make sure to reset null indicators since we're overwriting
                         // the tuple assembled for the previous row
@@ -1601,8 +1988,9 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
                 // 3.5.2 Using pushdown conjuncts to filter data
                 if (_use_pushdown_conjuncts
                         && row_conjunct_ctxs->size() > _direct_conjunct_size) {
-                    if (!eval_conjuncts(&((*row_conjunct_ctxs)[_direct_conjunct_size]),
-                                        row_conjunct_ctxs->size() - _direct_conjunct_size, row)) {
+                    if (!eval_scan_conjuncts(&((*row_conjunct_ctxs)[_direct_conjunct_size]),
+                                             row_conjunct_ctxs->size() - _direct_conjunct_size,
+                                             row, sample_conjuncts)) {
                         // check pushdown conjuncts fail then clear tuple for reuse
                         // make sure to reset null indicators since we're overwriting
                         // the tuple assembled for the previous row
@@ -1612,6 +2000,23 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
                     }
                 }
 
+                // 3.5.3 Drop rows that cannot get into the TopNNode above
+                if (_topn_bound != NULL && !_topn_bound->may_qualify(topn_bound, tuple)) {
+                    tuple->init(_tuple_desc->byte_size());
+                    ++topn_filtered_counter;
+                    break;
+                }
+
+                // 3.5.4 Aggregate into the last row returned if they are in the same group
+                if (_is_streaming_agg && row_batch->num_rows() > 0
+                        && merge_streaming_agg_row(reinterpret_cast<Tuple*>(
+                                reinterpret_cast<char*>(tuple) - _tuple_desc->byte_size()),
+                                tuple)) {
+                    tuple->init(_tuple_desc->byte_size());
+                    ++streaming_agg_merged_counter;
+                    break;
+                }
+
                 int string_slots_size = _string_slots.size();
                 for (int i = 0; i < string_slots_size; ++i) {
                     StringValue* slot = tuple->get_string_slot(_string_slots[i]->tuple_offset());
@@ -1639,17 +2044,26 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
             if (total_rows_reader_counter >= config::palo_scanner_row_num) {
                 break;
             }
+            if (remaining_limit != -1 && row_batch->num_rows() >= remaining_limit) {
+                break;
+            }
         }
 
 
         COUNTER_UPDATE(_pushdown_return_counter, pushdown_return_counter);
         COUNTER_UPDATE(_direct_return_counter, direct_return_counter);
         COUNTER_UPDATE(this->rows_read_counter(), rows_read_counter);
+        COUNTER_UPDATE(_topn_filtered_counter, topn_filtered_counter);
+        COUNTER_UPDATE(_streaming_agg_merged_counter, streaming_agg_merged_counter);
+        if (reorder_conjuncts
+                && ++num_scanned_batches % config::conjunct_reorder_interval_batches == 0) {
+            reorder_scan_conjuncts(row_conjunct_ctxs);
+        }
 
         // 4. if status not ok, change status_.
         if (UNLIKELY(0 == row_batch->num_rows())) {
             // may be failed, push already, scan node delete this batch.
-            delete row_batch;
+            _row_batch_pool->put(row_batch);
             row_batch = NULL;
         } else {
             // compute pushdown conjuncts filter rate
@@ -1669,6 +2083,9 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
             row_batchs.push_back(row_batch);
             __sync_fetch_and_add(&_buffered_bytes,
                                  row_batch->tuple_data_pool()->total_reserved_bytes());
+            if (_is_limit_pushdown) {
+                __sync_fetch_and_sub(&_remaining_limit, row_batch->num_rows());
+            }
         }
     }
 
@@ -1719,52 +2136,123 @@ void OlapScanNode::scanner_thread(OlapScanner* scanner) {
     _scan_batch_added_cv.notify_one();
 }
 
-#if 0
 void OlapScanNode::vectorized_scanner_thread(OlapScanner* scanner) {
+    SCOPED_CPU_TIMER(_scanner_cpu_time_counter);
     Status status = Status::OK;
-    std::vector<RowBatch*> row_batchs;
-    std::vector<ExprContext*>* row_conjunct_ctxs = scanner->row_conjunct_ctxs();
-    std::vector<ExprContext*>* vec_conjunct_ctxs = scanner->vec_conjunct_ctxs();
+    bool eos = false;
     RuntimeState* state = scanner->runtime_state();
     DCHECK(NULL != state);
+    CpuProfiler::ScopedQueryTag query_tag(state->query_id());
+    if (!scanner->is_open()) {
+        status = scanner->open();
+        if (!status.ok()) {
+            boost::lock_guard<boost::mutex> guard(_status_mutex);
+            _status = status;
+            eos = true;
+        }
+        scanner->set_opened();
+    }
 
-    // read from scanner
-    int total_rows_reader_counter = 0;
-    bool eos = false;
-    bool _use_pushdown_conjuncts = true;
-    DCHECK_GE(row_desc().tuple_descriptors().size(), 1);
-    std::shared_ptr<VectorizedRowBatch> vectorized_row_batch(
-        new VectorizedRowBatch(*(row_desc().tuple_descriptors()[0]), 1024));
-    //vectorized_row_batch->mem_pool()->set_limits(*state->mem_trackers());
+    // only DUP_KEYS table can be read in batch, others fall back to row based scan
+    if (status.ok() && !scanner->is_vectorized()) {
+        scanner_thread(scanner);
+        return;
+    }
+    if (status.ok()) {
+        scanner->init_vec_conjuncts();
+    }
+
+    // apply to cgroup
+    if (_resource_info != nullptr) {
+        CgroupsMgr::apply_cgroup(_resource_info->user, _resource_info->group);
+    }
 
-    do {
+    std::vector<RowBatch*> row_batchs;
+    // The conjuncts the scanner evaluates on the columns of a batch are moved out of
+    // row_conjunct_ctxs, the codegened function and the split of _conjunct_ctxs into
+    // direct and pushdown conjuncts only apply if none was moved.
+    std::vector<ExprContext*>* row_conjunct_ctxs = scanner->row_conjunct_ctxs();
+    bool has_vec_conjuncts = !scanner->vec_conjunct_ctxs()->empty();
+    VectorizedRowBatch* vectorized_row_batch = scanner->vectorized_row_batch();
+    Tuple* batch_tuples = NULL;
+
+    // Group rows by the dictionary codes of the string group slot. The storage
+    // fills the codes for batches read from one dictionary, the output tuple of
+    // each code is kept until the RowBatch is full, so a group string is copied
+    // into the RowBatch only once.
+    ColumnVector* dict_column = NULL;
+    std::vector<Tuple*> dict_groups;
+    Tuple* dict_null_group = NULL;
+    uint64_t dict_groups_version = 0;
+    if (_streaming_agg_dict_slot != NULL) {
+        int column_index = scanner->batch_column_index(_streaming_agg_dict_slot->id());
+        if (column_index >= 0) {
+            dict_column = vectorized_row_batch->column(column_index);
+            dict_column->enable_dict_codes(vectorized_row_batch->capacity());
+        }
+    }
+    // used to evaluate conjuncts on tuples of vectorized_row_batch
+    std::vector<Tuple*> eval_tuples(row_desc().tuple_descriptors().size(), NULL);
+    TupleRow* eval_row = reinterpret_cast<TupleRow*>(&eval_tuples[0]);
+
+    bool _use_pushdown_conjuncts = true;
+    int64_t total_rows_reader_counter = 0;
+    TopNRuntimeBound::Snapshot topn_bound;
+    bool reorder_conjuncts = config::conjunct_reorder_interval_batches > 0;
+    int num_scanned_batches = 0;
+    while (!eos && (total_rows_reader_counter < config::palo_scanner_row_num
+                || !vectorized_row_batch->is_iterator_end())) {
+        // 0. Stop reading if enough rows are returned by all scanners
+        int64_t remaining_limit = -1;
+        if (_is_limit_pushdown) {
+            remaining_limit = __sync_fetch_and_add(&_remaining_limit, 0);
+            if (remaining_limit <= 0) {
+                eos = true;
+                break;
+            }
+        }
+        if (_topn_bound != NULL) {
+            _topn_bound->refresh(&topn_bound);
+        }
         // 1. Allocate one row batch
-        RowBatch* row_batch = new RowBatch(row_desc(), state->batch_size());
-        row_batch->tuple_data_pool()->set_limits(*state->mem_trackers());
+        RowBatch *row_batch = _row_batch_pool->get(state->batch_size());
         row_batch->set_scanner_id(scanner->id());
+        // 2. Allocate Row's Tuple buf
+        uint8_t *tuple_buf = row_batch->tuple_data_pool()->allocate(
+                state->batch_size() * _tuple_desc->byte_size());
+        Tuple *tuple = reinterpret_cast<Tuple*>(tuple_buf);
+        dict_groups_version = 0;
+        dict_null_group = NULL;
 
+        int direct_return_counter = 0;
+        int pushdown_return_counter = 0;
+        int rows_read_counter = 0;
+        int topn_filtered_counter = 0;
+        int streaming_agg_merged_counter = 0;
         // 3. Read data to each tuple
         while (true) {
             // 3.1 Break if RowBatch is Full, Try to read new RowBatch
             if (row_batch->is_full()) {
                 break;
             }
-
             // 3.2 Stoped if Scanner has been cancelled
             if (UNLIKELY(_transfer_done)) {
                 eos = true;
                 status = Status::CANCELLED;
                 LOG(INFO) << "Scan thread cancelled, "
-                          "cause query done, maybe reach limit.";
+                    "cause query done, maybe reach limit.";
                 break;
             }
-
-            // 3.3 Read vectorized_row_batch from OlapEngine
+            // 3.3 Read vectorized_row_batch from OlapEngine, which evaluates the
+            // vectorized conjuncts on its columns and converts the selected rows to
+            // tuples. Evaluate the other conjuncts on them and keep the selected rows
             if (vectorized_row_batch->is_iterator_end()) {
                 if (total_rows_reader_counter >= config::palo_scanner_row_num) {
                     break;
                 }
-                status = scanner->get_next(vectorized_row_batch.get(), &eos);
+                int num_rows_read = 0;
+                status = scanner->get_next(vectorized_row_batch, &batch_tuples, &num_rows_read,
+                                           &total_rows_reader_counter, &eos);
                 if (UNLIKELY(!status.ok())) {
                     LOG(ERROR) << "Scan thread read OlapScanner failed!";
                     eos = true;
@@ -1772,62 +2260,203 @@ void OlapScanNode::vectorized_scanner_thread(OlapScanner* scanner) {
                 }
                 if (UNLIKELY(eos)) {
                     // this scanner read all data, break;
-                    LOG(INFO) << "Scan thread read OlapScanner finish.";
                     break;
                 }
-                COUNTER_UPDATE(rows_read_counter(), vectorized_row_batch->num_rows());
-                total_rows_reader_counter += vectorized_row_batch->num_rows();
 
-                eval_vectorized_conjuncts(vectorized_row_batch, vec_conjunct_ctxs);
+                int num_rows = vectorized_row_batch->num_rows();
+                int* selected = vectorized_row_batch->selected();
+                bool selected_in_use = vectorized_row_batch->selected_in_use();
+                int num_selected = 0;
+                for (int i = 0; i < num_rows; ++i) {
+                    int batch_row = selected_in_use ? selected[i] : i;
+                    Tuple* batch_tuple = reinterpret_cast<Tuple*>(
+                            reinterpret_cast<uint8_t*>(batch_tuples)
+                            + batch_row * _tuple_desc->byte_size());
+                    eval_row->set_tuple(_tuple_idx, batch_tuple);
+                    bool sample_conjuncts = reorder_conjuncts && i % CONJUNCT_SAMPLE_ROWS == 0;
+
+                    if (VLOG_ROW_IS_ON) {
+                        VLOG_ROW << "OlapScanner input row: "
+                            << print_tuple(batch_tuple, *_tuple_desc);
+                    }
+
+                    // 3.3.1 Using direct conjuncts to filter data
+                    if (has_vec_conjuncts) {
+                        if (!eval_scan_conjuncts(row_conjunct_ctxs->data(),
+                                                 row_conjunct_ctxs->size(), eval_row,
+                                                 sample_conjuncts)) {
+                            continue;
+                        }
+                    } else if (_eval_conjuncts_fn != NULL) {
+                        if (!_eval_conjuncts_fn(&((*row_conjunct_ctxs)[0]),
+                                                _direct_row_conjunct_size, eval_row)) {
+                            continue;
+                        }
+                    } else {
+                        if (!eval_scan_conjuncts(&((*row_conjunct_ctxs)[0]),
+                                                 _direct_row_conjunct_size, eval_row,
+                                                 sample_conjuncts)) {
+                            continue;
+                        }
+                    }
+
+                    ++direct_return_counter;
+
+                    // 3.3.2 Using pushdown conjuncts to filter data
+                    if (_use_pushdown_conjuncts && !has_vec_conjuncts
+                            && row_conjunct_ctxs->size() > _direct_conjunct_size) {
+                        if (!eval_scan_conjuncts(
+                                    &((*row_conjunct_ctxs)[_direct_conjunct_size]),
+                                    row_conjunct_ctxs->size() - _direct_conjunct_size,
+                                    eval_row, sample_conjuncts)) {
+                            continue;
+                        }
+                    }
+
+                    // 3.3.3 Drop rows that cannot get into the TopNNode above
+                    if (_topn_bound != NULL
+                            && !_topn_bound->may_qualify(topn_bound, batch_tuple)) {
+                        ++topn_filtered_counter;
+                        continue;
+                    }
+
+                    selected[num_selected++] = batch_row;
+                    ++pushdown_return_counter;
+                }
+
+                rows_read_counter += num_rows_read;
+                vectorized_row_batch->set_selected_in_use(true);
+                vectorized_row_batch->set_size(num_selected);
+                vectorized_row_batch->reset_row_iterator();
+                continue;
             }
 
-            if (row_conjunct_ctxs->size() > 0) {
-                eval_row_based_conjuncts(vectorized_row_batch, row_batch, row_conjunct_ctxs);
-            } else {
-                vectorized_row_batch->to_row_batch(row_batch);
+            // 3.4 Materialize selected row to RowBatch
+            int batch_row = vectorized_row_batch->next_row_index();
+            Tuple** dict_group = NULL;
+            if (dict_column != NULL && dict_column->has_dict_codes()) {
+                if (dict_groups_version != dict_column->dict_version()) {
+                    // groups of another dictionary can only be merged by values
+                    dict_groups.assign(dict_column->dict_size(), NULL);
+                    dict_null_group = NULL;
+                    dict_groups_version = dict_column->dict_version();
+                }
+                int32_t code = dict_column->dict_codes()[batch_row];
+                dict_group = code < 0 ? &dict_null_group : &dict_groups[code];
+                if (*dict_group != NULL) {
+                    merge_streaming_agg_values(*dict_group, reinterpret_cast<Tuple*>(
+                            reinterpret_cast<uint8_t*>(batch_tuples)
+                            + batch_row * _tuple_desc->byte_size()));
+                    ++streaming_agg_merged_counter;
+                    continue;
+                }
+            } else if (_is_streaming_agg && row_batch->num_rows() > 0
+                    && merge_streaming_agg_row(
+                            reinterpret_cast<Tuple*>(
+                                    reinterpret_cast<char*>(tuple) - _tuple_desc->byte_size()),
+                            reinterpret_cast<Tuple*>(
+                                    reinterpret_cast<uint8_t*>(batch_tuples)
+                                    + batch_row * _tuple_desc->byte_size()))) {
+                ++streaming_agg_merged_counter;
+                continue;
             }
+            memory_copy(tuple,
+                        reinterpret_cast<uint8_t*>(batch_tuples)
+                        + batch_row * _tuple_desc->byte_size(),
+                        _tuple_desc->byte_size());
 
-            if (VLOG_ROW_IS_ON) {
-                for (int i = 0; i < row_batch->num_rows(); ++i) {
-                    TupleRow* row = row_batch->get_row(i);
-                    VLOG_ROW << "VectorizedScannerThread ouput row: " << print_row(row, row_desc());
+            int string_slots_size = _string_slots.size();
+            for (int i = 0; i < string_slots_size; ++i) {
+                StringValue* slot = tuple->get_string_slot(_string_slots[i]->tuple_offset());
+                if (0 != slot->len) {
+                    uint8_t* v = row_batch->tuple_data_pool()->allocate(slot->len);
+                    memory_copy(v, slot->ptr, slot->len);
+                    slot->ptr = reinterpret_cast<char*>(v);
                 }
             }
+
+            if (VLOG_ROW_IS_ON) {
+                VLOG_ROW << "OlapScanner output row: " << print_tuple(tuple, *_tuple_desc);
+            }
+
+            int row_idx = row_batch->add_row();
+            TupleRow* row = row_batch->get_row(row_idx);
+            row->set_tuple(_tuple_idx, tuple);
+            row_batch->commit_last_row();
+            if (dict_group != NULL) {
+                *dict_group = tuple;
+            }
+            char* new_tuple = reinterpret_cast<char*>(tuple);
+            new_tuple += _tuple_desc->byte_size();
+            tuple = reinterpret_cast<Tuple*>(new_tuple);
+
+            if (remaining_limit != -1 && row_batch->num_rows() >= remaining_limit) {
+                break;
+            }
         }
 
-        // 4. if status not ok, change _status.
+        COUNTER_UPDATE(_pushdown_return_counter, pushdown_return_counter);
+        COUNTER_UPDATE(_direct_return_counter, direct_return_counter);
+        COUNTER_UPDATE(this->rows_read_counter(), rows_read_counter);
+        COUNTER_UPDATE(_topn_filtered_counter, topn_filtered_counter);
+        COUNTER_UPDATE(_streaming_agg_merged_counter, streaming_agg_merged_counter);
+        if (reorder_conjuncts
+                && ++num_scanned_batches % config::conjunct_reorder_interval_batches == 0) {
+            if (!has_vec_conjuncts) {
+                reorder_scan_conjuncts(row_conjunct_ctxs);
+            } else if (row_conjunct_ctxs->size() > 1) {
+                ExprContext::reorder_conjuncts(row_conjunct_ctxs->data(),
+                                               row_conjunct_ctxs->size());
+            }
+        }
+
+        // 4. if status not ok, change status_.
         if (UNLIKELY(0 == row_batch->num_rows())) {
             // may be failed, push already, scan node delete this batch.
-            delete row_batch;
+            _row_batch_pool->put(row_batch);
             row_batch = NULL;
         } else {
             // compute pushdown conjuncts filter rate
-            if (_use_pushdown_conjuncts) {
+            if (_use_pushdown_conjuncts && _direct_return_counter->value() > 0) {
                 int32_t pushdown_return_rate
                     = _pushdown_return_counter->value() * 100 / _direct_return_counter->value();
                 if (pushdown_return_rate > config::palo_max_pushdown_conjuncts_return_rate) {
                     _use_pushdown_conjuncts = false;
                     VLOG(2) << "Stop Using PushDown Conjuncts. "
-                            << "PushDownReturnRate: " << pushdown_return_rate << "%"
-                            << " MaxPushDownReturnRate: "
-                            << config::palo_max_pushdown_conjuncts_return_rate << "%";
-                } else {
-                    VLOG(2) << "PushDownReturnRate: " << pushdown_return_rate << "%";
+                        << "PushDownReturnRate: " << pushdown_return_rate << "%"
+                        << " MaxPushDownReturnRate: "
+                        << config::palo_max_pushdown_conjuncts_return_rate << "%";
                 }
             }
             row_batchs.push_back(row_batch);
+            __sync_fetch_and_add(&_buffered_bytes,
+                                 row_batch->tuple_data_pool()->total_reserved_bytes());
+            if (_is_limit_pushdown) {
+                __sync_fetch_and_sub(&_remaining_limit, row_batch->num_rows());
+            }
         }
-    } while ((total_rows_reader_counter < config::palo_scanner_row_num
-                 || !vectorized_row_batch->is_iterator_end())
-                 && !eos);
+    }
+
+    // update raw rows number readed from tablet
+    RuntimeProfile::Counter* raw_rows_counter = _scanner_profile->get_counter("RawRowsRead");
+    if (raw_rows_counter != NULL) {
+        COUNTER_UPDATE(raw_rows_counter, total_rows_reader_counter);
+    }
 
     boost::unique_lock<boost::mutex> l(_scan_batches_lock);
     // if we failed, check status.
     if (UNLIKELY(!status.ok())) {
         _transfer_done = true;
+        boost::lock_guard<boost::mutex> guard(_status_mutex);
         _status = status;
     }
-    if (UNLIKELY(!_status.ok())) {
+
+    bool global_status_ok = false;
+    {
+        boost::lock_guard<boost::mutex> guard(_status_mutex);
+        global_status_ok = _status.ok();
+    }
+    if (UNLIKELY(!global_status_ok)) {
         eos = true;
         BOOST_FOREACH(RowBatch* rb, row_batchs) {
             delete rb;
@@ -1850,97 +2479,18 @@ void OlapScanNode::vectorized_scanner_thread(OlapScanner* scanner) {
     } else {
         _olap_scanners.push_front(scanner);
     }
+    _running_thread--;
     _scan_batch_added_cv.notify_one();
 }
 
-void OlapScanNode::eval_vectorized_conjuncts(
-        std::shared_ptr<VectorizedRowBatch> vectorized_row_batch,
-        std::vector<ExprContext*>* vec_conjunct_ctxs) {
-    for (int i = 0; i < _direct_vec_conjunct_size; ++i) {
-        (*vec_conjunct_ctxs)[i]->evaluate(vectorized_row_batch.get());
-    }
-    COUNTER_UPDATE(_direct_return_counter, vectorized_row_batch->num_rows());
-
-    if (_use_pushdown_conjuncts) {
-        for (int i = _direct_vec_conjunct_size; i < vec_conjunct_ctxs->size(); ++i) {
-            (*vec_conjunct_ctxs)[i]->evaluate(vectorized_row_batch.get());
-        }
-    }
-    COUNTER_UPDATE(_pushdown_return_counter, vectorized_row_batch->num_rows());
-}
-
-
-void OlapScanNode::eval_row_based_conjuncts(
-        std::shared_ptr<VectorizedRowBatch> vectorized_row_batch,
-        RowBatch* row_batch,
-        std::vector<ExprContext*>* row_conjunct_ctxs) {
-    int row_remain = row_batch->capacity() - row_batch->num_rows();
-    uint8_t* tuple_buf = row_batch->tuple_data_pool()->allocate(
-            row_remain * _tuple_desc->byte_size());
-    bzero(tuple_buf, row_remain * _tuple_desc->byte_size());
-    Tuple* tuple = reinterpret_cast<Tuple*>(tuple_buf);
-
-    while (vectorized_row_batch->get_next_tuple(tuple)) {
-        int row_idx = row_batch->add_row();
-        TupleRow* row = row_batch->get_row(row_idx);
-        row->set_tuple(_tuple_idx, tuple);
-
-        do {
-            // 3.5.1 Using direct conjuncts to filter data
-            if (!eval_conjuncts(&((*row_conjunct_ctxs)[0]),
-                               _direct_row_conjunct_size,
-                               row)) {
-                // check direct conjuncts fail then clear tuple for reuse
-                // make sure to reset null indicators since we're overwriting
-                // the tuple assembled for the previous row
-                tuple->init(_tuple_desc->byte_size());
-                break;
-            }
-
-            COUNTER_UPDATE(_direct_return_counter, 1);
-
-            // 3.5.2 Using pushdown conjuncts to filter data
-            if (_use_pushdown_conjuncts
-                    && row_conjunct_ctxs->size() > _direct_conjunct_size) {
-                if (!eval_conjuncts(&((*row_conjunct_ctxs)[_direct_conjunct_size]),
-                                   row_conjunct_ctxs->size() - _direct_conjunct_size, row)) {
-                    // check pushdown conjuncts fail then clear tuple for reuse
-                    // make sure to reset null indicators since we're overwriting
-                    // the tuple assembled for the previous row
-                    tuple->init(_tuple_desc->byte_size());
-                    break;
-                }
-            }
-
-            int string_slots_size = _string_slots.size();
-            for (int i = 0; i < string_slots_size; ++i) {
-                StringValue* slot
-                    = tuple->get_string_slot(_string_slots[i]->tuple_offset());
-                uint8_t* v = row_batch->tuple_data_pool()->allocate(slot->len);
-                memcpy(v, slot->ptr, slot->len);
-                slot->ptr = reinterpret_cast<char*>(v);
-            }
-
-            // check direct && pushdown conjuncts success then commit tuple
-            row_batch->commit_last_row();
-            char* new_tuple = reinterpret_cast<char*>(tuple);
-            new_tuple += _tuple_desc->byte_size();
-            tuple = reinterpret_cast<Tuple*>(new_tuple);
-
-            COUNTER_UPDATE(_pushdown_return_counter, 1);
-        } while (0);
-
-        if (row_batch->is_full()) {
-            break;
-        }
-    }
-}
-#endif
-
 Status OlapScanNode::add_one_batch(RowBatchInterface* row_batch) {
     {
         boost::unique_lock<boost::mutex> l(_row_batches_lock);
 
+        if (_materialized_row_batches.size() >= _max_materialized_row_batches
+                && !_transfer_done) {
+            ++_producer_wait_num;
+        }
         while (UNLIKELY(_materialized_row_batches.size()
                         >= _max_materialized_row_batches
                         && !_transfer_done)) {
@@ -1955,6 +2505,82 @@ Status OlapScanNode::add_one_batch(RowBatchInterface* row_batch) {
     return Status::OK;
 }
 
+int64_t OlapScanNode::reclaim_memory(int64_t bytes_to_free) {
+    int64_t freed_bytes = _row_batch_pool->release_free_batches();
+    boost::lock_guard<boost::mutex> l(_row_batches_lock);
+    if (_max_materialized_row_batches > 1) {
+        _max_materialized_row_batches /= 2;
+        VLOG(1) << "OlapScanNode(id=" << id() << ") shrinks its queue to "
+                << _max_materialized_row_batches << " row batches";
+    }
+    return freed_bytes;
+}
+
+void OlapScanNode::update_scanner_concurrency(int max_thread) {
+    if (!config::enable_adaptive_scanner_concurrency) {
+        return;
+    }
+    // Decide once per window of as many batches as there are scanners running, so that
+    // every scanner contributed to the numbers.
+    if (++_concurrency_window_batches < _scanner_concurrency) {
+        return;
+    }
+    _concurrency_window_batches = 0;
+
+    int64_t consumer_wait_num = 0;
+    int64_t producer_wait_num = 0;
+    size_t queued_batches = 0;
+    {
+        boost::lock_guard<boost::mutex> l(_row_batches_lock);
+        consumer_wait_num = _consumer_wait_num;
+        producer_wait_num = _producer_wait_num;
+        queued_batches = _materialized_row_batches.size();
+    }
+
+    // The consumer falls behind if the queue filled up or holds a backlog of more than
+    // a quarter of its capacity. It keeps up if it had to wait for data in this window.
+    if (producer_wait_num > _last_producer_wait_num
+            || queued_batches > _max_materialized_row_batches / 4) {
+        _scanner_concurrency = std::max(1, _scanner_concurrency / 2);
+    } else if (consumer_wait_num > _last_consumer_wait_num) {
+        _scanner_concurrency = std::min(max_thread, _scanner_concurrency * 2);
+        if (_scanner_concurrency > _peak_scanner_concurrency_counter->value()) {
+            COUNTER_SET(_peak_scanner_concurrency_counter, (int64_t)_scanner_concurrency);
+        }
+    }
+    _last_consumer_wait_num = consumer_wait_num;
+    _last_producer_wait_num = producer_wait_num;
+}
+
+Status OlapScanNode::split_running_scanners(RuntimeState* state, int num) {
+    std::list<OlapScanner*> new_scanners;
+    for (auto scanner : _all_olap_scanners) {
+        if (num <= 0) {
+            break;
+        }
+        OlapScanner* new_scanner = scanner->split(_scanner_pool.get());
+        if (new_scanner == NULL) {
+            continue;
+        }
+        RETURN_IF_ERROR(create_conjunct_ctxs(
+                state, new_scanner->row_conjunct_ctxs(), new_scanner->vec_conjunct_ctxs(), true));
+        new_scanners.push_back(new_scanner);
+        --num;
+    }
+    if (new_scanners.empty()) {
+        return Status::OK;
+    }
+
+    VLOG(1) << "split " << new_scanners.size() << " scanners from running scanners"
+        << " (node=" << id() << ")";
+    COUNTER_UPDATE(_split_scanner_counter, new_scanners.size());
+    _progress.add_total(new_scanners.size());
+    _all_olap_scanners.insert(_all_olap_scanners.end(),
+                              new_scanners.begin(), new_scanners.end());
+    _olap_scanners.splice(_olap_scanners.end(), new_scanners);
+    return Status::OK;
+}
+
 void OlapScanNode::debug_string(
     int /* indentation_level */,
     std::stringstream* /* out */) const {
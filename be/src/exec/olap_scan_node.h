@@ -31,6 +31,7 @@
 #include "exec/scan_node.h"
 #include "runtime/descriptors.h"
 #include "runtime/row_batch_interface.hpp"
+#include "runtime/row_batch_pool.h"
 #include "runtime/vectorized_row_batch.h"
 #include "util/progress_updater.h"
 #include "util/debug_util.h"
@@ -57,6 +58,14 @@ public:
     virtual Status get_next(RuntimeState* state, RowBatch* row_batch, bool* eos);
     virtual Status close(RuntimeState* state);
     virtual Status set_scan_ranges(const std::vector<TScanRangeParams>& scan_ranges);
+    virtual bool push_down_topn_bound(TopNRuntimeBound* bound);
+
+    // Makes the scan read the tablets in 'start_versions', by tablet id, only from the
+    // given version on. A tablet whose start version is beyond the version of its scan
+    // range is not read at all. Must be called before set_scan_ranges().
+    void set_start_versions(const std::map<int64_t, int64_t>& start_versions) {
+        _start_versions = start_versions;
+    }
 
 protected:
     typedef struct {
@@ -150,6 +159,13 @@ protected:
     template<class T>
     Status normalize_in_predicate(SlotDescriptor* slot, ColumnValueRange<T>* range);
 
+    // Add the min and max value of an InPredicate to range, used when there are too many
+    // values to be pushed down as fixed values.
+    template<class T>
+    void normalize_in_predicate_bound(SlotDescriptor* slot,
+                                      InPredicate* pred,
+                                      ColumnValueRange<T>* range);
+
     template<class T>
     Status normalize_binary_predicate(SlotDescriptor* slot, ColumnValueRange<T>* range);
 
@@ -158,10 +174,35 @@ protected:
         boost::shared_ptr<PaloScanRange> scan_range,
         std::vector<OlapScanRange>* sub_range);
     void transfer_thread(RuntimeState* state);
-    //void vectorized_scanner_thread(OlapScanner* scanner);
+    void vectorized_scanner_thread(OlapScanner* scanner);
     void scanner_thread(OlapScanner* scanner);
 
+    // eval_conjuncts(), also measuring the conjuncts if 'sample' is true. The scanner
+    // threads sample one in every CONJUNCT_SAMPLE_ROWS rows.
+    static bool eval_scan_conjuncts(
+            ExprContext* const* ctxs, int num_ctxs, TupleRow* row, bool sample) {
+        return sample ? eval_conjuncts_with_stats(ctxs, num_ctxs, row)
+            : eval_conjuncts(ctxs, num_ctxs, row);
+    }
+    static const int CONJUNCT_SAMPLE_ROWS = 64;
+    // Reorders the direct and the pushdown conjuncts of a scanner by the measured
+    // samples, each among themselves. The codegened direct conjuncts keep their order.
+    void reorder_scan_conjuncts(std::vector<ExprContext*>* row_conjunct_ctxs);
+
     Status add_one_batch(RowBatchInterface* row_batch);
+    // Called by transfer_thread after every transferred batch: halves
+    // _scanner_concurrency when the consumer falls behind and doubles it, up to
+    // 'max_thread', when the consumer had to wait for data.
+    void update_scanner_concurrency(int max_thread);
+    // Called by transfer_thread with _scan_batches_lock held when it has more scanner
+    // slots than waiting scanners: splits the key ranges which running scanners
+    // haven't started yet into at most 'num' new scanners, so that a few scanners
+    // with lots of data left don't keep the scan running while the others are idle.
+    Status split_running_scanners(RuntimeState* state, int num);
+    // Reclaimer of the memory arbitrator: drops the row batches kept for reuse and
+    // halves the queue of materialized batches, so that the scanners hold less memory
+    // from now on.
+    int64_t reclaim_memory(int64_t bytes_to_free);
     Status transfer_open_scanners(RuntimeState* state);
 
     TransferStatus init_merge_heap(Heap& heap);
@@ -177,6 +218,21 @@ protected:
 private:
     void construct_is_null_pred_in_where_pred(Expr* expr, SlotDescriptor* slot, std::string is_null_str);
 
+    // 非有序扫描时limit下推给scanner线程, 所有scanner共享剩余的行数
+    bool _reached_pushdown_limit() {
+        return _is_limit_pushdown && __sync_fetch_and_add(&_remaining_limit, 0) <= 0;
+    }
+
+    // Resolves the slots of streaming aggregation in prepare(), leaves it off if the
+    // plan asks for something the scanners can not aggregate in place.
+    Status init_streaming_agg(RuntimeState* state);
+    // If src has the same group slots as dst, aggregates the value slots of src into
+    // dst and returns true, then src needs not to be returned.
+    bool merge_streaming_agg_row(Tuple* dst, const Tuple* src);
+    // Aggregates the value slots of src into dst, the caller knows they are in
+    // the same group.
+    void merge_streaming_agg_values(Tuple* dst, const Tuple* src);
+
     std::vector<TCondition> _is_null_vector;
     boost::scoped_ptr<TPlanNode> _thrift_plan_node;
     // Tuple id resolved in prepare() to set _tuple_desc;
@@ -198,6 +254,7 @@ private:
     OlapScanKeys _scan_keys;
 
     std::list<boost::shared_ptr<PaloScanRange> > _palo_scan_ranges;
+    std::map<int64_t, int64_t> _start_versions;
 
     std::vector<boost::shared_ptr<PaloScanRange> > _query_scan_ranges;
     std::vector<OlapScanRange> _query_key_ranges;
@@ -237,6 +294,9 @@ private:
 
     std::list<RowBatchInterface*> _scan_row_batches;
 
+    // Batches consumed by get_next(), reused by the scanner threads.
+    boost::scoped_ptr<RowBatchPool> _row_batch_pool;
+
     std::list<OlapScanner*> _all_olap_scanners;
     std::list<OlapScanner*> _olap_scanners;
     std::vector<OlapScanner*> _fin_olap_scanners;
@@ -281,6 +341,15 @@ private:
     int _total_assign_num;
     int _nice;
 
+    // 自适应的scanner并发数以及当前调整窗口内已传输的batch数, 只在transfer_thread中使用
+    int _scanner_concurrency;
+    int _concurrency_window_batches;
+    int64_t _last_consumer_wait_num;
+    int64_t _last_producer_wait_num;
+    // get_next()等待数据的次数, add_one_batch()因队列满而等待的次数, 由_row_batches_lock保护
+    int64_t _consumer_wait_num;
+    int64_t _producer_wait_num;
+
     // protect _status, for many thread may change _status
     boost::mutex _status_mutex;
     Status _status;
@@ -288,17 +357,48 @@ private:
     RuntimeProfile::Counter* _olap_thread_scan_timer;
     RuntimeProfile::Counter* _eval_timer;
     RuntimeProfile::Counter* _merge_timer;
+    // Cpu time of all scanner threads, not included in CPUTime of the node
+    RuntimeProfile::Counter* _scanner_cpu_time_counter;
+    // Time get_next() waited for the scanners to queue a batch
+    RuntimeProfile::Counter* _wait_scanner_timer;
     RuntimeProfile::Counter* _pushdown_return_counter;
     RuntimeProfile::Counter* _direct_return_counter;
     RuntimeProfile::Counter* _tablet_counter;
+    RuntimeProfile::Counter* _peak_scanner_concurrency_counter;
+    RuntimeProfile::Counter* _split_scanner_counter;
 
     RuntimeProfile* _scanner_profile;
 
     TResourceInfo* _resource_info;
+    // Resource group the scanner tasks are accounted to in the scanner thread pool
+    std::string _scanner_group;
 
     int64_t _buffered_bytes;
     int64_t _running_thread;
+    bool _is_limit_pushdown;
+    // 还需要scanner返回的行数, 只在_is_limit_pushdown时有效
+    int64_t _remaining_limit;
     EvalConjunctsFn _eval_conjuncts_fn;
+    // 上层TopNNode当前第n行的排序列取值, scanner线程过滤掉不可能进入前n行的数据.
+    // 排序列是key列时, 之后open的scanner还把它作为存储层条件, 按block的min/max跳过数据
+    TopNRuntimeBound* _topn_bound;
+    bool _topn_bound_on_key_column;
+    RuntimeProfile::Counter* _topn_filtered_counter;
+
+    // Partial aggregation in scanner threads over consecutive rows, see
+    // TOlapScanNode.streaming_agg_slots. Rows come in key order, so grouping by a
+    // key prefix reduces them as much as a hash table without its memory.
+    struct StreamingAggSlot {
+        const SlotDescriptor* slot;
+        TAggregationOp::type op;
+    };
+    bool _is_streaming_agg;
+    std::vector<const SlotDescriptor*> _streaming_agg_group_slots;
+    std::vector<StreamingAggSlot> _streaming_agg_slots;
+    // The only group slot if it is a string, vectorized scanners then group the rows
+    // of a batch by the dictionary codes of its column instead of consecutive rows.
+    const SlotDescriptor* _streaming_agg_dict_slot;
+    RuntimeProfile::Counter* _streaming_agg_merged_counter;
 };
 
 } // namespace palo
@@ -16,11 +16,17 @@
 #include <cstring>
 #include <string>
 
+#include "common/config.h"
+#include "common/object_pool.h"
 #include "gen_cpp/PaloInternalService_types.h"
 #include "olap_scanner.h"
 #include "olap_scan_node.h"
 #include "olap_utils.h"
+#include "exec/topn_runtime_bound.h"
+#include "olap/olap_engine.h"
 #include "olap/olap_reader.h"
+#include "olap/olap_rootpath.h"
+#include "olap/tablet_access_stats.h"
 #include "service/backend_options.h"
 #include "runtime/descriptors.h"
 #include "runtime/runtime_state.h"
@@ -28,6 +34,9 @@
 #include "runtime/mem_tracker.h"
 #include "util/mem_util.hpp"
 #include "util/network_util.h"
+#include "util/numa_info.h"
+#include "util/palo_metrics.h"
+#include "util/query_trace.h"
 
 namespace palo {
 
@@ -50,10 +59,29 @@ OlapScanner::OlapScanner(
     _key_ranges(key_ranges),
     _olap_filter(olap_filter),
     _profile(profile),
+    _adaptive_aggregation(false),
+    _push_agg_op(TPushAggOp::NONE),
+    _topn_bound(NULL),
+    _skip_scan_values(NULL),
+    _is_vec_conjuncts_inited(false),
     _is_open(false),
-    _is_null_vector(is_null_vector) {
+    _is_null_vector(is_null_vector),
+    _numa_node(-1),
+    _open_time_us(0),
+    _raw_rows_read(0),
+    _read_bytes(0),
+    _splittable(false) {
     _reader.reset(OLAPReader::create(tuple_desc, runtime_state));
     DCHECK(_reader.get() != NULL);
+    if (NumaInfo::enabled()) {
+        SmartOLAPTable table = OLAPEngine::get_instance()->get_table(
+                _scan_range->scan_range().tablet_id,
+                strtoul(_scan_range->scan_range().schema_hash.c_str(), NULL, 10));
+        if (table.get() != NULL) {
+            _numa_node = OLAPRootPath::get_instance()->get_root_path_numa_node(
+                    table->storage_root_path_name());
+        }
+    }
 }
 
 OlapScanner::~OlapScanner() {
@@ -67,6 +95,10 @@ void OlapScanner::set_opened() {
 }
 
 Status OlapScanner::open() {
+    _watch.start();
+    if (_runtime_state->query_trace() != NULL) {
+        _open_time_us = QueryTrace::now_us();
+    }
     TFetchRequest fetch_request;
     fetch_request.__set_use_compression(false);
     fetch_request.__set_num_rows(256);
@@ -77,6 +109,9 @@ Status OlapScanner::open() {
     fetch_request.__set_version_hash(
         strtoul(_scan_range->scan_range().version_hash.c_str(), NULL, 10));
     fetch_request.__set_tablet_id(_scan_range->scan_range().tablet_id);
+    if (_scan_range->start_version() > 0) {
+        fetch_request.__set_start_version(_scan_range->start_version());
+    }
 
     // fields
     const std::vector<SlotDescriptor*>& slots = _tuple_desc.slots();
@@ -120,6 +155,10 @@ Status OlapScanner::open() {
         }
 
         fetch_request.end_key.push_back(end_key);
+        _reader_key_ranges.push_back(key_range);
+    }
+    if (_skip_scan_values != NULL) {
+        fetch_request.__set_skip_scan_values(*_skip_scan_values);
     }
 
 
@@ -130,10 +169,18 @@ Status OlapScanner::open() {
     for (auto is_null_str : _is_null_vector) {
         fetch_request.where.push_back(is_null_str);
     }
+    TCondition topn_condition;
+    if (_topn_bound != NULL && _topn_bound->to_olap_condition(&topn_condition)) {
+        fetch_request.where.push_back(topn_condition);
+    }
 
     // output
     fetch_request.__set_output("palo2");
     fetch_request.__set_aggregation(_aggregation);
+    fetch_request.__set_adaptive_aggregation(_aggregation && _adaptive_aggregation);
+    if (_push_agg_op != TPushAggOp::NONE) {
+        fetch_request.__set_push_agg_op(_push_agg_op);
+    }
 
     if (!_reader->init(fetch_request, &_vec_conjunct_ctxs, _profile).ok()) {
         std::string local_ip = BackendOptions::get_localhost();
@@ -146,11 +193,46 @@ Status OlapScanner::open() {
         return Status(ss.str());
     }
 
+    if (config::enable_vectorized_olap_scan && _reader->is_vectorized_supported()) {
+        _vectorized_row_batch.reset(
+                _reader->create_vectorized_row_batch(_runtime_state->batch_size()));
+        if (_vectorized_row_batch.get() == NULL) {
+            return Status("Internal Error: fail to allocate vectorized row batch.");
+        }
+    }
+
+    _splittable.store(!_reader_key_ranges.empty(), std::memory_order_release);
     return Status::OK;
 }
 
+OlapScanner* OlapScanner::split(ObjectPool* pool) {
+    if (!_splittable.load(std::memory_order_acquire)) {
+        return NULL;
+    }
+    int32_t index = _reader->split_key_ranges();
+    if (index < 0) {
+        return NULL;
+    }
+
+    std::vector<OlapScanRange> key_ranges(
+            _reader_key_ranges.begin() + index, _reader_key_ranges.end());
+    OlapScanner* scanner = pool->add(new OlapScanner(
+            _runtime_state, _scan_range, key_ranges, _olap_filter,
+            _tuple_desc, _profile, _is_null_vector));
+    scanner->set_aggregation(_aggregation);
+    scanner->set_adaptive_aggregation(_adaptive_aggregation);
+    scanner->set_push_agg_op(_push_agg_op);
+    scanner->set_topn_bound(_topn_bound);
+    scanner->set_skip_scan_values(_skip_scan_values);
+    return scanner;
+}
+
 Status OlapScanner::get_next(Tuple* tuple, int64_t* raw_rows_read, bool* eof) {
-	if (!_reader->next_tuple(tuple, raw_rows_read, eof).ok()) {
+    TabletAccessStats::ScopedReadBytes read_bytes(_reader->access_stats(), &_read_bytes);
+    int64_t prev_raw_rows_read = *raw_rows_read;
+    Status status = _reader->next_tuple(tuple, raw_rows_read, eof);
+    _raw_rows_read += *raw_rows_read - prev_raw_rows_read;
+	if (!status.ok()) {
 		if (MemTracker::limit_exceeded(*_runtime_state->mem_trackers())) {
             LOG(ERROR) << "Memory limit exceeded.";
             return Status("Internal Error: Memory limit exceeded.");       
@@ -161,7 +243,63 @@ Status OlapScanner::get_next(Tuple* tuple, int64_t* raw_rows_read, bool* eof) {
     return Status::OK;
 }
 
+void OlapScanner::init_vec_conjuncts() {
+    if (_is_vec_conjuncts_inited) {
+        return;
+    }
+    _reader->init_batch_filter(&_row_conjunct_ctxs, &_vec_conjunct_ctxs);
+    _is_vec_conjuncts_inited = true;
+}
+
+Status OlapScanner::get_next(VectorizedRowBatch* batch, Tuple** tuples, int* num_rows_read,
+                             int64_t* raw_rows_read, bool* eof) {
+    TabletAccessStats::ScopedReadBytes read_bytes(_reader->access_stats(), &_read_bytes);
+    int64_t prev_raw_rows_read = *raw_rows_read;
+    Status status = _reader->next_batch(batch, raw_rows_read, eof);
+    _raw_rows_read += *raw_rows_read - prev_raw_rows_read;
+    if (!status.ok()) {
+        if (MemTracker::limit_exceeded(*_runtime_state->mem_trackers())) {
+            LOG(ERROR) << "Memory limit exceeded.";
+            return Status("Internal Error: Memory limit exceeded.");
+        }
+        LOG(ERROR) << "read storage fail.";
+        return Status("Internal Error: read storage fail.");
+    }
+
+    if (*eof) {
+        return Status::OK;
+    }
+
+    *num_rows_read = batch->size();
+    int tuples_size = batch->size() * _tuple_desc.byte_size();
+    uint8_t* tuple_buf = batch->mem_pool()->allocate(tuples_size);
+    bzero(tuple_buf, tuples_size);
+    *tuples = reinterpret_cast<Tuple*>(tuple_buf);
+
+    _reader->filter_batch(batch);
+    return _reader->convert_batch_to_tuples(batch, *tuples);
+}
+
+int OlapScanner::batch_column_index(SlotId slot_id) const {
+    return _reader->batch_column_index(slot_id);
+}
+
 Status OlapScanner::close(RuntimeState* state) {
+    if (_is_open && _reader.get() != NULL && _reader->access_stats() != NULL) {
+        _reader->access_stats()->add_scan(_raw_rows_read, _watch.elapsed_time());
+    }
+    if (_is_open && PaloMetrics::tablet_scan_latency() != NULL) {
+        std::string tablet_id = std::to_string(_scan_range->scan_range().tablet_id);
+        PaloMetrics::tablet_scan_latency()->get(tablet_id)->update(_watch.elapsed_time());
+        PaloMetrics::tablet_scan_rows()->get(tablet_id)->increment(_raw_rows_read);
+        PaloMetrics::tablet_read_bytes()->get(tablet_id)->increment(_read_bytes);
+    }
+    if (_is_open && state->query_trace() != NULL) {
+        state->query_trace()->add_span(
+                "scan", "scan_tablet", _open_time_us, QueryTrace::now_us(),
+                "tablet_id=" + std::to_string(_scan_range->scan_range().tablet_id));
+    }
+    _vectorized_row_batch.reset();
     _reader.reset();
     Expr::close(_row_conjunct_ctxs, state);
     Expr::close(_vec_conjunct_ctxs, state);
@@ -18,6 +18,7 @@
 
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <atomic>
 #include <list>
 #include <vector>
 #include <string>
@@ -31,12 +32,15 @@
 #include "runtime/descriptors.h"
 #include "runtime/tuple.h"
 #include "runtime/vectorized_row_batch.h"
+#include "util/stopwatch.hpp"
 
 namespace palo {
 
+class ObjectPool;
 class OlapScanNode;
 class OLAPReader;
 class RuntimeProfile;
+class TopNRuntimeBound;
 
 /**
  * @brief   engine_readerȡolap
@@ -65,6 +69,20 @@ public:
 
     Status get_next(Tuple* tuple, int64_t* raw_rows_read, bool* eof);
 
+    /**
+     * @brief   ȡ, дʽȡһ, ִvec_conjunct_ctxs()
+     *          ֻѡеаתΪtuple.
+     *          *tuplesָ*num_rows_readtuple, jӦbatchĵj,
+     *          batchһ; batchѡsize()Ϊѡе.
+     *          ûжκʱeof
+     */
+    Status get_next(VectorizedRowBatch* batch, Tuple** tuples, int* num_rows_read,
+                    int64_t* raw_rows_read, bool* eof);
+
+    // open֮, ȡʱ. row_conjunct_ctxs()batchֵ
+    // conjunctƵvec_conjunct_ctxs(), ֻڵһεʱЧ
+    void init_vec_conjuncts();
+
     Status close(RuntimeState* state);
 
     RuntimeState* runtime_state() {
@@ -83,6 +101,29 @@ public:
         _aggregation = aggregation;
     }
 
+    // With aggregation, the storage may return rows with equal key unmerged and out of
+    // key order when merging them reduces few rows
+    void set_adaptive_aggregation(bool adaptive_aggregation) {
+        _adaptive_aggregation = adaptive_aggregation;
+    }
+
+    // COUNT(*) or MIN/MAX which the storage may answer from its meta
+    void set_push_agg_op(TPushAggOp::type push_agg_op) {
+        _push_agg_op = push_agg_op;
+    }
+
+    // The bound of a TopNNode above on a key column, turned into a storage
+    // condition when the scanner is opened
+    void set_topn_bound(const TopNRuntimeBound* topn_bound) {
+        _topn_bound = topn_bound;
+    }
+
+    // Fixed values of the leading key columns to skip-scan the only key range with,
+    // owned by the scan node
+    void set_skip_scan_values(const std::vector<std::vector<std::string>>* skip_scan_values) {
+        _skip_scan_values = skip_scan_values;
+    }
+
     void set_id(int id) {
         _id = id;
     }
@@ -93,6 +134,30 @@ public:
     bool is_open();
     void set_opened();
 
+    // The NUMA node of the storage root path of the tablet, -1 if NUMA affinity is
+    // disabled or the tablet is not found.
+    int numa_node() const {
+        return _numa_node;
+    }
+
+    // open֮Ч, Ϊtrueʱʹvectorized_row_batch()ȡ
+    bool is_vectorized() {
+        return _vectorized_row_batch.get() != NULL;
+    }
+
+    VectorizedRowBatch* vectorized_row_batch() {
+        return _vectorized_row_batch.get();
+    }
+
+    // The column of slot in vectorized_row_batch(), -1 if the slot is not read
+    int batch_column_index(SlotId slot_id) const;
+
+    // Takes over the second half of the key ranges this scanner hasn't started yet,
+    // in a new scanner of the same tablet which is added to 'pool'. Returns NULL if
+    // the scanner isn't opened or has no key range left to give up. It is called
+    // by the transfer thread while the scanner is reading.
+    OlapScanner* split(ObjectPool* pool);
+
 private:
     RuntimeState* _runtime_state;
     const TupleDescriptor& _tuple_desc;      /**< tuple descripter */
@@ -107,10 +172,30 @@ private:
 
     std::shared_ptr<OLAPReader> _reader;
 
+    std::unique_ptr<VectorizedRowBatch> _vectorized_row_batch;
+
     bool _aggregation;
+    bool _adaptive_aggregation;
+    TPushAggOp::type _push_agg_op;
+    const TopNRuntimeBound* _topn_bound;
+    const std::vector<std::vector<std::string>>* _skip_scan_values;
+    bool _is_vec_conjuncts_inited;
     int _id;
     bool _is_open;
     std::vector<TCondition> _is_null_vector;
+    int _numa_node;
+    // runs from open(), for the scan latency of the tablet
+    MonotonicStopWatch _watch;
+    // wall clock time of open(), for the span of the tablet in the query trace
+    int64_t _open_time_us;
+    // rows read from storage and bytes read from files so far, for the access stats
+    // of the tablet
+    int64_t _raw_rows_read;
+    int64_t _read_bytes;
+    // the key ranges passed to the reader, in the order of its key range index
+    std::vector<OlapScanRange> _reader_key_ranges;
+    // set when the reader is ready for split()
+    std::atomic<bool> _splittable;
 };
 
 } // namespace palo
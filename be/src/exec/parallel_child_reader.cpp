@@ -0,0 +1,196 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/parallel_child_reader.h"
+
+#include <memory>
+
+#include <boost/thread/locks.hpp>
+
+#include "exec/exec_node.h"
+#include "runtime/row_batch.h"
+#include "runtime/runtime_state.h"
+#include "runtime/thread_resource_mgr.h"
+#include "util/blocking_aware_thread_pool.h"
+
+namespace palo {
+
+using boost::lock_guard;
+using boost::mutex;
+using boost::unique_lock;
+
+ParallelChildReader::ParallelChildReader(const std::vector<ExecNode*>& children,
+        const RowDescriptor& output_row_desc, MemTracker* mem_tracker,
+        const ConvertFn& convert_fn) :
+        _children(children),
+        _output_row_desc(output_row_desc),
+        _mem_tracker(mem_tracker),
+        _convert_fn(convert_fn),
+        _state(NULL),
+        _num_threads(0),
+        _next_child_idx(0),
+        _num_running_threads(0),
+        _closed(false) {
+}
+
+ParallelChildReader::~ParallelChildReader() {
+    close();
+}
+
+bool ParallelChildReader::start(RuntimeState* state, int max_threads) {
+    DCHECK_EQ(_num_threads, 0);
+    ThreadResourceMgr::ResourcePool* pool = state->resource_pool();
+    int num_helpers = 0;
+    while (pool != NULL && num_helpers + 1 < max_threads
+            && num_helpers + 1 < _children.size() && pool->try_acquire_thread_token()) {
+        ++num_helpers;
+    }
+    if (num_helpers == 0) {
+        return false;
+    }
+
+    _state = state;
+    _num_threads = num_helpers + 1;
+    _num_running_threads = _num_threads;
+    for (int i = 0; i < _num_threads; ++i) {
+        _threads.add_thread(new boost::thread(&ParallelChildReader::read_children, this, i));
+    }
+    return true;
+}
+
+Status ParallelChildReader::get_next(RowBatch* row_batch, bool* eos) {
+    DCHECK_GT(_num_threads, 0);
+    DCHECK_EQ(row_batch->num_rows(), 0);
+    RowBatch* batch = NULL;
+    {
+        unique_lock<mutex> l(_lock);
+        while (_status.ok() && _batch_queue.empty() && _num_running_threads > 0) {
+            BlockingAwareThreadPool::ScopedBlocking blocking(&l);
+            _batch_ready_cv.wait(l);
+        }
+        RETURN_IF_ERROR(_status);
+        if (!_batch_queue.empty()) {
+            batch = _batch_queue.front();
+            _batch_queue.pop_front();
+        }
+    }
+    if (batch == NULL) {
+        *eos = true;
+        return Status::OK;
+    }
+    _queue_not_full_cv.notify_one();
+
+    row_batch->acquire_state(batch);
+    delete batch;
+    *eos = false;
+    return Status::OK;
+}
+
+void ParallelChildReader::close() {
+    {
+        lock_guard<mutex> l(_lock);
+        if (_closed) {
+            return;
+        }
+        _closed = true;
+    }
+    _batch_ready_cv.notify_all();
+    _queue_not_full_cv.notify_all();
+    _threads.join_all();
+
+    for (std::deque<RowBatch*>::iterator it = _batch_queue.begin();
+            it != _batch_queue.end(); ++it) {
+        delete *it;
+    }
+    _batch_queue.clear();
+}
+
+void ParallelChildReader::read_children(int thread_idx) {
+    while (true) {
+        int child_idx = 0;
+        {
+            lock_guard<mutex> l(_lock);
+            if (_closed || !_status.ok() || _next_child_idx >= _children.size()) {
+                break;
+            }
+            child_idx = _next_child_idx++;
+        }
+        Status status = read_child(child_idx);
+        if (!status.ok()) {
+            {
+                lock_guard<mutex> l(_lock);
+                if (_status.ok()) {
+                    _status = status;
+                }
+            }
+            // Wake up the threads waiting for room in the queue, they stop as well.
+            _queue_not_full_cv.notify_all();
+            break;
+        }
+    }
+
+    {
+        lock_guard<mutex> l(_lock);
+        --_num_running_threads;
+    }
+    _batch_ready_cv.notify_all();
+    // The first thread stands in for the fragment thread and holds no token of its own.
+    if (thread_idx > 0) {
+        _state->resource_pool()->release_thread_token(false);
+    }
+}
+
+Status ParallelChildReader::read_child(int child_idx) {
+    ExecNode* child = _children[child_idx];
+    RETURN_IF_ERROR(child->open(_state));
+    RowBatch child_batch(child->row_desc(), _state->batch_size(), _mem_tracker);
+    bool eos = false;
+    while (!eos) {
+        RETURN_IF_CANCELLED(_state);
+        RETURN_IF_ERROR(child->get_next(_state, &child_batch, &eos));
+        if (child_batch.num_rows() > 0) {
+            // Same capacity as the batches of the fragment thread, so that
+            // RowBatch::acquire_state() can take it over.
+            std::unique_ptr<RowBatch> output(
+                    new RowBatch(_output_row_desc, _state->batch_size(), _mem_tracker));
+            RETURN_IF_ERROR(_convert_fn(child_idx, &child_batch, output.get()));
+            if (output->num_rows() > 0 && !put_batch(output.release())) {
+                return Status::OK;
+            }
+        }
+        child_batch.reset();
+    }
+    // The converted batches don't depend on the child, so it can go right away.
+    return child->close(_state);
+}
+
+bool ParallelChildReader::put_batch(RowBatch* batch) {
+    unique_lock<mutex> l(_lock);
+    size_t max_queued = _num_threads * QUEUED_BATCHES_PER_THREAD;
+    while (!_closed && _status.ok() && _batch_queue.size() >= max_queued) {
+        _queue_not_full_cv.wait(l);
+    }
+    if (_closed || !_status.ok()) {
+        l.unlock();
+        delete batch;
+        return false;
+    }
+    _batch_queue.push_back(batch);
+    l.unlock();
+    _batch_ready_cv.notify_one();
+    return true;
+}
+
+}
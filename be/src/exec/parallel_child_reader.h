@@ -0,0 +1,119 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_EXEC_PARALLEL_CHILD_READER_H
+#define BDG_PALO_BE_SRC_EXEC_PARALLEL_CHILD_READER_H
+
+#include <deque>
+#include <vector>
+
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "common/status.h"
+
+namespace palo {
+
+class ExecNode;
+class MemTracker;
+class RowBatch;
+class RowDescriptor;
+class RuntimeState;
+
+// Drains several children of a node (e.g. the inputs of a UNION ALL) on threads of
+// their own instead of one after another on the fragment thread. Every child is opened,
+// read to the end and closed by a single thread; up to 'max_threads' children are in
+// flight at the same time. The batches of a child are converted into batches of the
+// node on its thread and queued for the fragment thread, so the output interleaves
+// the children in no particular order.
+//
+// Threads beyond the first are only started if the query has thread tokens left; the
+// first one stands in for the fragment thread, which just waits for batches meanwhile.
+class ParallelChildReader {
+public:
+    // Converts the rows of 'child_batch' of child 'child_idx' into rows of 'output',
+    // which is empty and has at least the capacity of 'child_batch'. The rows of
+    // 'output' must not reference memory of 'child_batch' or of the child. Calls for
+    // different children run at the same time.
+    typedef boost::function<Status (int child_idx, RowBatch* child_batch,
+                                    RowBatch* output)> ConvertFn;
+
+    //  -- children: the children to drain; 'child_idx' of ConvertFn is an index into it
+    //  -- output_row_desc: row descriptor of the batches returned by get_next()
+    ParallelChildReader(const std::vector<ExecNode*>& children,
+                        const RowDescriptor& output_row_desc, MemTracker* mem_tracker,
+                        const ConvertFn& convert_fn);
+
+    ~ParallelChildReader();
+
+    // Starts the threads if at least two of them can be used. Returns false, and
+    // starts nothing, if the children should be read on the fragment thread instead.
+    bool start(RuntimeState* state, int max_threads);
+
+    // Moves the next converted batch into 'row_batch', which must be empty, and waits
+    // for one if none is ready yet. Sets '*eos' once all children were drained.
+    // Returns the first error of any child.
+    Status get_next(RowBatch* row_batch, bool* eos);
+
+    // Stops the threads and waits for them to finish. Children that were not drained
+    // yet are left for the owning node to close.
+    void close();
+
+    int num_threads() const {
+        return _num_threads;
+    }
+
+private:
+    // Max number of converted batches that are queued per thread.
+    static const int QUEUED_BATCHES_PER_THREAD = 2;
+
+    // Body of a thread: drains children until there are none left.
+    void read_children(int thread_idx);
+
+    // Opens, drains and closes the child 'child_idx'.
+    Status read_child(int child_idx);
+
+    // Queues 'batch' and takes over its ownership. Returns false if the reader was
+    // closed or failed meanwhile.
+    bool put_batch(RowBatch* batch);
+
+    const std::vector<ExecNode*> _children;
+    const RowDescriptor& _output_row_desc;
+    MemTracker* _mem_tracker;
+    ConvertFn _convert_fn;
+
+    RuntimeState* _state;
+    int _num_threads;
+    boost::thread_group _threads;
+
+    // Protects all fields below.
+    boost::mutex _lock;
+    // Signalled when a batch was queued, a thread finished or an error occurred.
+    boost::condition_variable _batch_ready_cv;
+    // Signalled when a batch was taken from the queue or the reader is closed.
+    boost::condition_variable _queue_not_full_cv;
+    std::deque<RowBatch*> _batch_queue;
+    // Index of the next child to be read by a thread.
+    int _next_child_idx;
+    int _num_running_threads;
+    bool _closed;
+    Status _status;
+};
+
+}
+
+#endif // BDG_PALO_BE_SRC_EXEC_PARALLEL_CHILD_READER_H
@@ -0,0 +1,1218 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "exec/parquet_reader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+
+#include <boost/algorithm/string.hpp>
+#include <snappy/snappy.h>
+
+#include "common/logging.h"
+#include "exec/file_reader.h"
+
+namespace palo {
+
+namespace parquet {
+
+// Enum values of parquet.thrift
+enum Type {
+    BOOLEAN = 0,
+    INT32 = 1,
+    INT64 = 2,
+    INT96 = 3,
+    FLOAT = 4,
+    DOUBLE = 5,
+    BYTE_ARRAY = 6,
+    FIXED_LEN_BYTE_ARRAY = 7
+};
+
+enum ConvertedType {
+    UTF8 = 0,
+    DECIMAL = 5,
+    DATE = 6,
+    TIMESTAMP_MILLIS = 9,
+    TIMESTAMP_MICROS = 10,
+    UINT_8 = 11,
+    UINT_16 = 12,
+    UINT_32 = 13,
+    UINT_64 = 14
+};
+
+enum FieldRepetitionType {
+    REQUIRED = 0,
+    OPTIONAL = 1,
+    REPEATED = 2
+};
+
+enum PageType {
+    DATA_PAGE = 0,
+    INDEX_PAGE = 1,
+    DICTIONARY_PAGE = 2,
+    DATA_PAGE_V2 = 3
+};
+
+enum Encoding {
+    PLAIN = 0,
+    PLAIN_DICTIONARY = 2,
+    RLE = 3,
+    RLE_DICTIONARY = 8
+};
+
+enum CompressionCodec {
+    UNCOMPRESSED = 0,
+    SNAPPY = 1,
+    GZIP = 2
+};
+
+struct PageHeader {
+    int type;
+    int uncompressed_page_size;
+    int compressed_page_size;
+    int num_values;
+    int encoding;
+    int definition_level_encoding;
+    // data page v2 only
+    int definition_levels_byte_length;
+    int repetition_levels_byte_length;
+    bool is_compressed;
+
+    PageHeader() : type(-1), uncompressed_page_size(0), compressed_page_size(0),
+        num_values(0), encoding(PLAIN), definition_level_encoding(RLE),
+        definition_levels_byte_length(0), repetition_levels_byte_length(0),
+        is_compressed(true) { }
+};
+
+// Decodes the thrift compact protocol, which the metadata of Parquet files is
+// written with. Marks itself failed instead of reading past the end of its data.
+class CompactReader {
+public:
+    // Types of the compact protocol
+    enum {
+        CT_STOP = 0,
+        CT_BOOLEAN_TRUE = 1,
+        CT_BOOLEAN_FALSE = 2,
+        CT_BYTE = 3,
+        CT_I16 = 4,
+        CT_I32 = 5,
+        CT_I64 = 6,
+        CT_DOUBLE = 7,
+        CT_BINARY = 8,
+        CT_LIST = 9,
+        CT_SET = 10,
+        CT_MAP = 11,
+        CT_STRUCT = 12
+    };
+
+    CompactReader(const uint8_t* data, size_t len) :
+        _begin(data), _ptr(data), _end(data + len), _ok(true), _last_field_id(0),
+        _depth(0) { }
+
+    bool ok() const {
+        return _ok;
+    }
+
+    size_t bytes_read() const {
+        return _ptr - _begin;
+    }
+
+    uint8_t read_byte() {
+        if (_ptr >= _end) {
+            _ok = false;
+            return 0;
+        }
+        return *_ptr++;
+    }
+
+    uint64_t read_varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64 && _ptr < _end; shift += 7) {
+            uint8_t b = *_ptr++;
+            value |= (uint64_t)(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) {
+                return value;
+            }
+        }
+        _ok = false;
+        return 0;
+    }
+
+    int64_t read_i64() {
+        uint64_t value = read_varint();
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+
+    void read_binary(std::string* value) {
+        uint64_t len = read_varint();
+        if (!_ok || len > (uint64_t)(_end - _ptr)) {
+            _ok = false;
+            return;
+        }
+        if (value != nullptr) {
+            value->assign((const char*)_ptr, len);
+        }
+        _ptr += len;
+    }
+
+    void struct_begin() {
+        _field_ids.push_back(_last_field_id);
+        _last_field_id = 0;
+    }
+
+    void struct_end() {
+        _last_field_id = _field_ids.back();
+        _field_ids.pop_back();
+    }
+
+    // Reads the header of the next field of the current struct, returns false at its
+    // end. The value of a bool field is in its type.
+    bool read_field(int* type, int* id) {
+        uint8_t b = read_byte();
+        if (!_ok || b == CT_STOP) {
+            return false;
+        }
+        *type = b & 0x0f;
+        int delta = b >> 4;
+        *id = delta != 0 ? _last_field_id + delta : (int16_t)read_i64();
+        _last_field_id = *id;
+        return _ok;
+    }
+
+    void read_list(int* elem_type, int64_t* size) {
+        uint8_t b = read_byte();
+        *elem_type = b & 0x0f;
+        *size = b >> 4;
+        if (*size == 15) {
+            *size = read_varint();
+        }
+        if (*size > _end - _ptr) {
+            // every element takes a byte at least
+            _ok = false;
+            *size = 0;
+        }
+    }
+
+    // Reads an i32 or i64 field into 'value' if it has the expected type
+    template <typename T>
+    void read_int(int type, T* value) {
+        if (type == CT_I32 || type == CT_I64 || type == CT_I16 || type == CT_BYTE) {
+            *value = type == CT_BYTE ? (int8_t)read_byte() : read_i64();
+        } else {
+            skip(type);
+        }
+    }
+
+    void skip(int type) {
+        switch (type) {
+        case CT_BOOLEAN_TRUE:
+        case CT_BOOLEAN_FALSE:
+            break;
+        case CT_BYTE:
+            read_byte();
+            break;
+        case CT_I16:
+        case CT_I32:
+        case CT_I64:
+            read_varint();
+            break;
+        case CT_DOUBLE:
+            if (_end - _ptr < 8) {
+                _ok = false;
+            } else {
+                _ptr += 8;
+            }
+            break;
+        case CT_BINARY:
+            read_binary(nullptr);
+            break;
+        case CT_LIST:
+        case CT_SET: {
+            int elem_type = 0;
+            int64_t size = 0;
+            read_list(&elem_type, &size);
+            for (int64_t i = 0; i < size && _ok; ++i) {
+                skip_element(elem_type);
+            }
+            break;
+        }
+        case CT_MAP: {
+            uint64_t size = read_varint();
+            if (size > 0) {
+                uint8_t types = read_byte();
+                for (uint64_t i = 0; i < size && _ok; ++i) {
+                    skip_element(types >> 4);
+                    skip_element(types & 0x0f);
+                }
+            }
+            break;
+        }
+        case CT_STRUCT: {
+            if (++_depth > MAX_DEPTH) {
+                _ok = false;
+                break;
+            }
+            struct_begin();
+            int field_type = 0;
+            int id = 0;
+            while (read_field(&field_type, &id)) {
+                skip(field_type);
+            }
+            struct_end();
+            --_depth;
+            break;
+        }
+        default:
+            _ok = false;
+            break;
+        }
+    }
+
+    // Skips an element of a list or map, where a bool takes a byte
+    void skip_element(int type) {
+        if (type == CT_BOOLEAN_TRUE || type == CT_BOOLEAN_FALSE) {
+            read_byte();
+        } else {
+            skip(type);
+        }
+    }
+
+private:
+    static const int MAX_DEPTH = 64;
+
+    const uint8_t* _begin;
+    const uint8_t* _ptr;
+    const uint8_t* _end;
+    bool _ok;
+    int _last_field_id;
+    std::vector<int> _field_ids;
+    int _depth;
+};
+
+static void parse_schema_element(CompactReader* reader, SchemaElement* element) {
+    reader->struct_begin();
+    int type = 0;
+    int id = 0;
+    while (reader->read_field(&type, &id)) {
+        switch (id) {
+        case 1:
+            reader->read_int(type, &element->type);
+            break;
+        case 2:
+            reader->read_int(type, &element->type_length);
+            break;
+        case 3:
+            reader->read_int(type, &element->repetition_type);
+            break;
+        case 4:
+            if (type == CompactReader::CT_BINARY) {
+                reader->read_binary(&element->name);
+            } else {
+                reader->skip(type);
+            }
+            break;
+        case 5:
+            reader->read_int(type, &element->num_children);
+            break;
+        case 6:
+            reader->read_int(type, &element->converted_type);
+            break;
+        case 7:
+            reader->read_int(type, &element->scale);
+            break;
+        case 8:
+            reader->read_int(type, &element->precision);
+            break;
+        default:
+            reader->skip(type);
+            break;
+        }
+    }
+    reader->struct_end();
+}
+
+static void parse_column_metadata(CompactReader* reader, ColumnChunk* column) {
+    reader->struct_begin();
+    int type = 0;
+    int id = 0;
+    while (reader->read_field(&type, &id)) {
+        switch (id) {
+        case 1:
+            reader->read_int(type, &column->type);
+            break;
+        case 3: {
+            if (type != CompactReader::CT_LIST) {
+                reader->skip(type);
+                break;
+            }
+            int elem_type = 0;
+            int64_t size = 0;
+            reader->read_list(&elem_type, &size);
+            column->path_in_schema.resize(size);
+            for (int64_t i = 0; i < size; ++i) {
+                reader->read_binary(&column->path_in_schema[i]);
+            }
+            break;
+        }
+        case 4:
+            reader->read_int(type, &column->codec);
+            break;
+        case 5:
+            reader->read_int(type, &column->num_values);
+            break;
+        case 7:
+            reader->read_int(type, &column->total_compressed_size);
+            break;
+        case 9:
+            reader->read_int(type, &column->data_page_offset);
+            break;
+        case 11:
+            reader->read_int(type, &column->dictionary_page_offset);
+            break;
+        default:
+            reader->skip(type);
+            break;
+        }
+    }
+    reader->struct_end();
+}
+
+static Status parse_column_chunk(CompactReader* reader, ColumnChunk* column) {
+    Status status = Status::OK;
+    reader->struct_begin();
+    int type = 0;
+    int id = 0;
+    while (reader->read_field(&type, &id)) {
+        if (id == 1) {
+            // the chunk is in another file
+            status = Status("Parquet column chunks in other files are not supported");
+            reader->skip(type);
+        } else if (id == 3 && type == CompactReader::CT_STRUCT) {
+            parse_column_metadata(reader, column);
+        } else {
+            reader->skip(type);
+        }
+    }
+    reader->struct_end();
+    return status;
+}
+
+static Status parse_row_group(CompactReader* reader, RowGroup* row_group) {
+    reader->struct_begin();
+    int type = 0;
+    int id = 0;
+    while (reader->read_field(&type, &id)) {
+        if (id == 1 && type == CompactReader::CT_LIST) {
+            int elem_type = 0;
+            int64_t size = 0;
+            reader->read_list(&elem_type, &size);
+            row_group->columns.resize(size);
+            for (int64_t i = 0; i < size; ++i) {
+                RETURN_IF_ERROR(parse_column_chunk(reader, &row_group->columns[i]));
+            }
+        } else if (id == 3) {
+            reader->read_int(type, &row_group->num_rows);
+        } else {
+            reader->skip(type);
+        }
+    }
+    reader->struct_end();
+    return Status::OK;
+}
+
+Status parse_file_metadata(const uint8_t* data, size_t len, FileMetaData* meta) {
+    CompactReader reader(data, len);
+    reader.struct_begin();
+    int type = 0;
+    int id = 0;
+    while (reader.read_field(&type, &id)) {
+        if (id == 2 && type == CompactReader::CT_LIST) {
+            int elem_type = 0;
+            int64_t size = 0;
+            reader.read_list(&elem_type, &size);
+            meta->schema.resize(size);
+            for (int64_t i = 0; i < size; ++i) {
+                parse_schema_element(&reader, &meta->schema[i]);
+            }
+        } else if (id == 3) {
+            reader.read_int(type, &meta->num_rows);
+        } else if (id == 4 && type == CompactReader::CT_LIST) {
+            int elem_type = 0;
+            int64_t size = 0;
+            reader.read_list(&elem_type, &size);
+            meta->row_groups.resize(size);
+            for (int64_t i = 0; i < size; ++i) {
+                RETURN_IF_ERROR(parse_row_group(&reader, &meta->row_groups[i]));
+            }
+        } else {
+            reader.skip(type);
+        }
+    }
+    reader.struct_end();
+    if (!reader.ok()) {
+        return Status("Corrupt parquet file metadata");
+    }
+    return Status::OK;
+}
+
+// Parses the page header at 'data', sets 'header_len' to its size.
+static Status parse_page_header(
+        const uint8_t* data, size_t len, PageHeader* header, size_t* header_len) {
+    CompactReader reader(data, len);
+    reader.struct_begin();
+    int type = 0;
+    int id = 0;
+    while (reader.read_field(&type, &id)) {
+        switch (id) {
+        case 1:
+            reader.read_int(type, &header->type);
+            break;
+        case 2:
+            reader.read_int(type, &header->uncompressed_page_size);
+            break;
+        case 3:
+            reader.read_int(type, &header->compressed_page_size);
+            break;
+        case 5:
+        case 7:
+        case 8: {
+            // data_page_header, dictionary_page_header and data_page_header_v2
+            if (type != CompactReader::CT_STRUCT) {
+                reader.skip(type);
+                break;
+            }
+            int page_type = id;
+            reader.struct_begin();
+            while (reader.read_field(&type, &id)) {
+                if (id == 1) {
+                    reader.read_int(type, &header->num_values);
+                } else if (page_type == 5 && id == 2) {
+                    reader.read_int(type, &header->encoding);
+                } else if (page_type == 5 && id == 3) {
+                    reader.read_int(type, &header->definition_level_encoding);
+                } else if (page_type == 7 && id == 2) {
+                    reader.read_int(type, &header->encoding);
+                } else if (page_type == 8 && id == 4) {
+                    reader.read_int(type, &header->encoding);
+                } else if (page_type == 8 && id == 5) {
+                    reader.read_int(type, &header->definition_levels_byte_length);
+                } else if (page_type == 8 && id == 6) {
+                    reader.read_int(type, &header->repetition_levels_byte_length);
+                } else if (page_type == 8 && id == 7) {
+                    header->is_compressed = type != CompactReader::CT_BOOLEAN_FALSE;
+                } else {
+                    reader.skip(type);
+                }
+            }
+            reader.struct_end();
+            break;
+        }
+        default:
+            reader.skip(type);
+            break;
+        }
+    }
+    reader.struct_end();
+    if (!reader.ok() || header->compressed_page_size < 0
+            || header->uncompressed_page_size < 0 || header->num_values < 0) {
+        return Status("Corrupt parquet page header");
+    }
+    *header_len = reader.bytes_read();
+    return Status::OK;
+}
+
+// Decodes the RLE/bit-packed hybrid encoding of levels and dictionary indexes.
+class RleBitPackedDecoder {
+public:
+    RleBitPackedDecoder() : _ptr(nullptr), _end(nullptr), _bit_width(0),
+        _repeat_count(0), _current(0), _literal_ptr(nullptr), _literal_end(nullptr),
+        _literal_count(0), _literal_bit(0) { }
+
+    void init(const uint8_t* data, size_t len, int bit_width) {
+        _ptr = data;
+        _end = data + len;
+        _bit_width = bit_width;
+        _repeat_count = 0;
+        _literal_count = 0;
+    }
+
+    bool get(uint32_t* value) {
+        while (_repeat_count == 0 && _literal_count == 0) {
+            if (!next_run()) {
+                return false;
+            }
+        }
+        if (_repeat_count > 0) {
+            --_repeat_count;
+            *value = _current;
+            return true;
+        }
+        // bit-packed values, least significant bit first
+        const uint8_t* ptr = _literal_ptr + (_literal_bit >> 3);
+        if (ptr >= _literal_end && _bit_width > 0) {
+            return false;
+        }
+        uint64_t word = 0;
+        memcpy(&word, ptr, std::min<size_t>(sizeof(word), _literal_end - ptr));
+        *value = (word >> (_literal_bit & 7)) & ((1ULL << _bit_width) - 1);
+        _literal_bit += _bit_width;
+        --_literal_count;
+        return true;
+    }
+
+private:
+    bool next_run() {
+        uint64_t header = 0;
+        for (int shift = 0; ; shift += 7) {
+            if (_ptr >= _end || shift >= 64) {
+                return false;
+            }
+            uint8_t b = *_ptr++;
+            header |= (uint64_t)(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) {
+                break;
+            }
+        }
+        if (header & 1) {
+            // groups of 8 values, the last group may be cut short at the end of the data
+            uint64_t groups = header >> 1;
+            size_t len = std::min<uint64_t>(groups * _bit_width, _end - _ptr);
+            _literal_ptr = _ptr;
+            _literal_end = _ptr + len;
+            _literal_count = groups * 8;
+            _literal_bit = 0;
+            _ptr += len;
+        } else {
+            int num_bytes = (_bit_width + 7) / 8;
+            if (_end - _ptr < num_bytes) {
+                return false;
+            }
+            _current = 0;
+            memcpy(&_current, _ptr, num_bytes);
+            _ptr += num_bytes;
+            _repeat_count = header >> 1;
+        }
+        return true;
+    }
+
+    const uint8_t* _ptr;
+    const uint8_t* _end;
+    int _bit_width;
+
+    uint64_t _repeat_count;
+    uint32_t _current;
+
+    const uint8_t* _literal_ptr;
+    const uint8_t* _literal_end;
+    uint64_t _literal_count;
+    uint64_t _literal_bit;
+};
+
+}
+
+using namespace parquet;
+
+// Number of days from 0000-03-01 to 1970-01-01
+static const int64_t DAYS_TO_EPOCH = 719468;
+// Julian day of 1970-01-01
+static const int64_t JULIAN_DAY_OF_EPOCH = 2440588;
+static const int64_t SECONDS_PER_DAY = 24 * 3600;
+
+// Formats the date 'days' after 1970-01-01 as YYYY-MM-DD.
+static void append_date(int64_t days, std::string* out) {
+    // civil_from_days of http://howardhinnant.github.io/date_algorithms.html
+    int64_t z = days + DAYS_TO_EPOCH;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    int64_t day = doy - (153 * mp + 2) / 5 + 1;
+    int64_t month = mp < 10 ? mp + 3 : mp - 9;
+    int64_t year = yoe + era * 400 + (month <= 2);
+    char buf[32];
+    int len = snprintf(buf, sizeof(buf), "%04ld-%02ld-%02ld", year, month, day);
+    out->append(buf, len);
+}
+
+// Formats the time 'seconds' after 1970-01-01 00:00:00 as YYYY-MM-DD HH:MM:SS.
+static void append_datetime(int64_t seconds, std::string* out) {
+    int64_t days = seconds / SECONDS_PER_DAY;
+    int64_t second_of_day = seconds % SECONDS_PER_DAY;
+    if (second_of_day < 0) {
+        --days;
+        second_of_day += SECONDS_PER_DAY;
+    }
+    append_date(days, out);
+    char buf[32];
+    int len = snprintf(buf, sizeof(buf), " %02ld:%02ld:%02ld", second_of_day / 3600,
+                       second_of_day / 60 % 60, second_of_day % 60);
+    out->append(buf, len);
+}
+
+static void append_decimal(__int128 value, int scale, std::string* out) {
+    bool negative = value < 0;
+    unsigned __int128 abs_value = negative ? -(unsigned __int128)value : value;
+    char digits[64];
+    int len = 0;
+    do {
+        digits[len++] = '0' + (int)(abs_value % 10);
+        abs_value /= 10;
+    } while (abs_value != 0);
+    while (len <= scale) {
+        digits[len++] = '0';
+    }
+    if (negative) {
+        out->push_back('-');
+    }
+    for (int i = len - 1; i >= 0; --i) {
+        out->push_back(digits[i]);
+        if (i == scale && scale > 0) {
+            out->push_back('.');
+        }
+    }
+}
+
+// Formats a floating point value with as few digits as read back to the same value.
+template <typename T>
+static void append_floating(T value, int precision, int max_precision, std::string* out) {
+    char buf[64];
+    int len = snprintf(buf, sizeof(buf), "%.*g", precision, (double)value);
+    if ((T)strtod(buf, nullptr) != value) {
+        len = snprintf(buf, sizeof(buf), "%.*g", max_precision, (double)value);
+    }
+    out->append(buf, len);
+}
+
+// Reads the values of one column chunk as text.
+class ParquetColumnReader {
+public:
+    ParquetColumnReader(const SchemaElement& element, int max_def_level) :
+        _element(element), _max_def_level(max_def_level), _codec(UNCOMPRESSED),
+        _chunk_pos(0), _page_values_left(0), _dict_encoded(false),
+        _values_ptr(nullptr), _values_end(nullptr), _bool_bit(0) { }
+
+    // Reads the whole chunk.
+    Status init(FileReader* file_reader, const ColumnChunk& chunk) {
+        if (chunk.type != _element.type) {
+            return Status("Type of parquet column chunk doesn't match its schema");
+        }
+        _codec = chunk.codec;
+        if (_codec != UNCOMPRESSED && _codec != SNAPPY && _codec != GZIP) {
+            std::stringstream ss;
+            ss << "Unsupported parquet compression codec " << _codec << " of column "
+                << _element.name;
+            return Status(ss.str());
+        }
+        int64_t offset = chunk.start_offset();
+        if (offset < 0 || chunk.total_compressed_size < 0
+                || chunk.total_compressed_size > std::numeric_limits<int32_t>::max()) {
+            return Status("Corrupt parquet column chunk metadata");
+        }
+        _chunk.resize(chunk.total_compressed_size);
+        int64_t bytes_read = 0;
+        RETURN_IF_ERROR(file_reader->readat(
+                offset, _chunk.size(), &bytes_read, &_chunk[0]));
+        if (bytes_read != _chunk.size()) {
+            return Status("Parquet column chunk is beyond the end of the file");
+        }
+        return Status::OK;
+    }
+
+    Status next(std::string* value, bool* is_null) {
+        while (_page_values_left == 0) {
+            RETURN_IF_ERROR(read_page());
+        }
+        --_page_values_left;
+        if (_max_def_level > 0) {
+            uint32_t level = 0;
+            if (!_def_levels.get(&level)) {
+                return corrupt("definition levels");
+            }
+            if (level < _max_def_level) {
+                *is_null = true;
+                return Status::OK;
+            }
+        }
+        *is_null = false;
+        value->clear();
+        if (_dict_encoded) {
+            uint32_t idx = 0;
+            if (!_dict_indexes.get(&idx) || idx >= _dict.size()) {
+                return corrupt("dictionary indexes");
+            }
+            value->assign(_dict[idx]);
+            return Status::OK;
+        }
+        return decode_plain(value);
+    }
+
+private:
+    Status corrupt(const char* what) {
+        std::stringstream ss;
+        ss << "Corrupt " << what << " in parquet column " << _element.name;
+        return Status(ss.str());
+    }
+
+    Status read_page() {
+        while (true) {
+            if (_chunk_pos >= _chunk.size()) {
+                return corrupt("column chunk, values are missing,");
+            }
+            const uint8_t* data = (const uint8_t*)_chunk.data() + _chunk_pos;
+            size_t len = _chunk.size() - _chunk_pos;
+            PageHeader header;
+            size_t header_len = 0;
+            RETURN_IF_ERROR(parse_page_header(data, len, &header, &header_len));
+            if (header.compressed_page_size > len - header_len) {
+                return corrupt("page size");
+            }
+            const uint8_t* page = data + header_len;
+            _chunk_pos += header_len + header.compressed_page_size;
+
+            switch (header.type) {
+            case DICTIONARY_PAGE: {
+                const uint8_t* values = nullptr;
+                RETURN_IF_ERROR(decompress(page, header.compressed_page_size,
+                                           header.uncompressed_page_size, &values));
+                _values_ptr = values;
+                _values_end = values + header.uncompressed_page_size;
+                _bool_bit = 0;
+                _dict.resize(header.num_values);
+                for (int i = 0; i < header.num_values; ++i) {
+                    _dict[i].clear();
+                    RETURN_IF_ERROR(decode_plain(&_dict[i]));
+                }
+                break;
+            }
+            case DATA_PAGE: {
+                const uint8_t* values = nullptr;
+                RETURN_IF_ERROR(decompress(page, header.compressed_page_size,
+                                           header.uncompressed_page_size, &values));
+                const uint8_t* end = values + header.uncompressed_page_size;
+                if (_max_def_level > 0) {
+                    if (header.definition_level_encoding != RLE || end - values < 4) {
+                        return corrupt("definition level encoding");
+                    }
+                    uint32_t levels_len = 0;
+                    memcpy(&levels_len, values, sizeof(levels_len));
+                    values += sizeof(levels_len);
+                    if (levels_len > end - values) {
+                        return corrupt("definition levels");
+                    }
+                    _def_levels.init(values, levels_len, bit_width(_max_def_level));
+                    values += levels_len;
+                }
+                RETURN_IF_ERROR(init_values(header, values, end));
+                return Status::OK;
+            }
+            case DATA_PAGE_V2: {
+                int levels_len = header.repetition_levels_byte_length
+                    + header.definition_levels_byte_length;
+                if (header.repetition_levels_byte_length < 0
+                        || header.definition_levels_byte_length < 0
+                        || levels_len > header.compressed_page_size
+                        || levels_len > header.uncompressed_page_size) {
+                    return corrupt("page levels");
+                }
+                if (_max_def_level > 0) {
+                    _def_levels.init(page + header.repetition_levels_byte_length,
+                                     header.definition_levels_byte_length,
+                                     bit_width(_max_def_level));
+                }
+                const uint8_t* values = page + levels_len;
+                int compressed_len = header.compressed_page_size - levels_len;
+                int uncompressed_len = header.uncompressed_page_size - levels_len;
+                if (header.is_compressed) {
+                    RETURN_IF_ERROR(decompress(values, compressed_len, uncompressed_len,
+                                               &values));
+                } else {
+                    uncompressed_len = compressed_len;
+                }
+                RETURN_IF_ERROR(init_values(header, values, values + uncompressed_len));
+                return Status::OK;
+            }
+            default:
+                // index pages
+                break;
+            }
+        }
+    }
+
+    Status init_values(const PageHeader& header, const uint8_t* values, const uint8_t* end) {
+        _page_values_left = header.num_values;
+        if (header.encoding == PLAIN) {
+            _dict_encoded = false;
+            _values_ptr = values;
+            _values_end = end;
+            _bool_bit = 0;
+            return Status::OK;
+        }
+        if (header.encoding == PLAIN_DICTIONARY || header.encoding == RLE_DICTIONARY) {
+            if (values >= end || *values > 32) {
+                return corrupt("dictionary page");
+            }
+            _dict_encoded = true;
+            _dict_indexes.init(values + 1, end - values - 1, *values);
+            return Status::OK;
+        }
+        std::stringstream ss;
+        ss << "Unsupported parquet encoding " << header.encoding << " of column "
+            << _element.name;
+        return Status(ss.str());
+    }
+
+    static int bit_width(uint32_t max_value) {
+        int width = 0;
+        while (max_value != 0) {
+            ++width;
+            max_value >>= 1;
+        }
+        return width;
+    }
+
+    Status decompress(const uint8_t* data, int len, int uncompressed_len,
+                      const uint8_t** out) {
+        if (_codec == UNCOMPRESSED) {
+            if (len < uncompressed_len) {
+                return corrupt("page size");
+            }
+            *out = data;
+            return Status::OK;
+        }
+        if (uncompressed_len < 0) {
+            return corrupt("page size");
+        }
+        _decompressed.resize(std::max(uncompressed_len, 1));
+        if (_codec == SNAPPY) {
+            size_t snappy_len = 0;
+            if (!snappy::GetUncompressedLength((const char*)data, len, &snappy_len)
+                    || snappy_len != uncompressed_len
+                    || !snappy::RawUncompress((const char*)data, len, &_decompressed[0])) {
+                return corrupt("snappy page");
+            }
+        } else {
+            z_stream stream;
+            memset(&stream, 0, sizeof(stream));
+            // detects gzip and zlib headers
+            if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+                return Status("Failed to init zlib to decompress a parquet page");
+            }
+            stream.next_in = const_cast<Bytef*>(data);
+            stream.avail_in = len;
+            stream.next_out = (Bytef*)&_decompressed[0];
+            stream.avail_out = uncompressed_len;
+            int ret = inflate(&stream, Z_FINISH);
+            inflateEnd(&stream);
+            if (ret != Z_STREAM_END || stream.total_out != uncompressed_len) {
+                return corrupt("gzip page");
+            }
+        }
+        *out = (const uint8_t*)_decompressed.data();
+        return Status::OK;
+    }
+
+    // Decodes the next PLAIN encoded value of the page or the dictionary
+    Status decode_plain(std::string* value) {
+        size_t left = _values_end - _values_ptr;
+        switch (_element.type) {
+        case BOOLEAN: {
+            if (_bool_bit >= left * 8) {
+                return corrupt("values");
+            }
+            // boolean columns are mostly loaded into integer columns
+            bool b = (_values_ptr[_bool_bit >> 3] >> (_bool_bit & 7)) & 1;
+            value->push_back(b ? '1' : '0');
+            ++_bool_bit;
+            return Status::OK;
+        }
+        case INT32: {
+            int32_t v = 0;
+            RETURN_IF_ERROR(read_fixed(&v, sizeof(v)));
+            append_int(v, _element.converted_type == UINT_32 ? (uint32_t)v : v, value);
+            return Status::OK;
+        }
+        case INT64: {
+            int64_t v = 0;
+            RETURN_IF_ERROR(read_fixed(&v, sizeof(v)));
+            if (_element.converted_type == UINT_64) {
+                value->append(std::to_string((uint64_t)v));
+            } else {
+                append_int(v, v, value);
+            }
+            return Status::OK;
+        }
+        case INT96: {
+            // nanoseconds of the day followed by the julian day
+            uint8_t buf[12];
+            RETURN_IF_ERROR(read_fixed(buf, sizeof(buf)));
+            int64_t nanos = 0;
+            int32_t julian_day = 0;
+            memcpy(&nanos, buf, sizeof(nanos));
+            memcpy(&julian_day, buf + sizeof(nanos), sizeof(julian_day));
+            append_datetime((julian_day - JULIAN_DAY_OF_EPOCH) * SECONDS_PER_DAY
+                            + nanos / 1000000000, value);
+            return Status::OK;
+        }
+        case FLOAT: {
+            float v = 0;
+            RETURN_IF_ERROR(read_fixed(&v, sizeof(v)));
+            append_floating(v, 7, 9, value);
+            return Status::OK;
+        }
+        case DOUBLE: {
+            double v = 0;
+            RETURN_IF_ERROR(read_fixed(&v, sizeof(v)));
+            append_floating(v, 15, 17, value);
+            return Status::OK;
+        }
+        case BYTE_ARRAY: {
+            uint32_t len = 0;
+            RETURN_IF_ERROR(read_fixed(&len, sizeof(len)));
+            if (len > _values_end - _values_ptr) {
+                return corrupt("values");
+            }
+            append_bytes(_values_ptr, len, value);
+            _values_ptr += len;
+            return Status::OK;
+        }
+        case FIXED_LEN_BYTE_ARRAY: {
+            if (_element.type_length < 0 || _element.type_length > left) {
+                return corrupt("values");
+            }
+            append_bytes(_values_ptr, _element.type_length, value);
+            _values_ptr += _element.type_length;
+            return Status::OK;
+        }
+        default:
+            std::stringstream ss;
+            ss << "Unsupported parquet type " << _element.type << " of column "
+                << _element.name;
+            return Status(ss.str());
+        }
+    }
+
+    Status read_fixed(void* out, size_t len) {
+        if (_values_end - _values_ptr < len) {
+            return corrupt("values");
+        }
+        memcpy(out, _values_ptr, len);
+        _values_ptr += len;
+        return Status::OK;
+    }
+
+    // Appends an INT32 or INT64 value, 'unsigned_value' is used for unsigned types
+    void append_int(int64_t v, int64_t unsigned_value, std::string* value) {
+        switch (_element.converted_type) {
+        case DATE:
+            append_date(v, value);
+            break;
+        case DECIMAL:
+            append_decimal(v, _element.scale, value);
+            break;
+        case TIMESTAMP_MILLIS:
+            append_datetime(floor_div(v, 1000), value);
+            break;
+        case TIMESTAMP_MICROS:
+            append_datetime(floor_div(v, 1000000), value);
+            break;
+        case UINT_8:
+        case UINT_16:
+        case UINT_32:
+            value->append(std::to_string(unsigned_value));
+            break;
+        default:
+            value->append(std::to_string(v));
+            break;
+        }
+    }
+
+    static int64_t floor_div(int64_t v, int64_t divisor) {
+        return v / divisor - (v % divisor < 0 ? 1 : 0);
+    }
+
+    void append_bytes(const uint8_t* data, size_t len, std::string* value) {
+        if (_element.converted_type != DECIMAL) {
+            value->append((const char*)data, len);
+            return;
+        }
+        // big endian two's complement
+        __int128 v = len > 0 && (data[0] & 0x80) ? -1 : 0;
+        for (size_t i = 0; i < len && i < 16; ++i) {
+            v = (v << 8) | data[len > 16 ? len - 16 + i : i];
+        }
+        append_decimal(v, _element.scale, value);
+    }
+
+    const SchemaElement& _element;
+    const int _max_def_level;
+    int _codec;
+
+    std::string _chunk;
+    size_t _chunk_pos;
+    std::string _decompressed;
+
+    int _page_values_left;
+    RleBitPackedDecoder _def_levels;
+
+    // Text of the dictionary values
+    std::vector<std::string> _dict;
+    bool _dict_encoded;
+    RleBitPackedDecoder _dict_indexes;
+
+    // PLAIN encoded values of the page or the dictionary
+    const uint8_t* _values_ptr;
+    const uint8_t* _values_end;
+    size_t _bool_bit;
+};
+
+ParquetReader::ParquetReader(FileReader* file_reader, int64_t start_offset, int64_t size) :
+        _file_reader(file_reader),
+        _start_offset(start_offset),
+        _end_offset(size < 0 ? std::numeric_limits<int64_t>::max() : start_offset + size),
+        _next_row_group(0),
+        _rows_left_in_group(0) {
+}
+
+ParquetReader::~ParquetReader() {
+}
+
+Status ParquetReader::open(const std::vector<std::string>& column_names) {
+    static const char MAGIC[] = "PAR1";
+    static const int MAGIC_LEN = 4;
+    static const int FOOTER_LEN = MAGIC_LEN + sizeof(uint32_t);
+
+    int64_t file_size = 0;
+    RETURN_IF_ERROR(_file_reader->size(&file_size));
+    if (file_size < MAGIC_LEN + FOOTER_LEN) {
+        return Status("Parquet file is too short");
+    }
+    uint8_t footer[FOOTER_LEN];
+    int64_t bytes_read = 0;
+    RETURN_IF_ERROR(_file_reader->readat(
+            file_size - FOOTER_LEN, FOOTER_LEN, &bytes_read, footer));
+    if (bytes_read != FOOTER_LEN || memcmp(footer + sizeof(uint32_t), MAGIC, MAGIC_LEN) != 0) {
+        return Status("Not a parquet file");
+    }
+    uint32_t meta_len = 0;
+    memcpy(&meta_len, footer, sizeof(meta_len));
+    if (meta_len > file_size - MAGIC_LEN - FOOTER_LEN) {
+        return Status("Corrupt parquet file metadata length");
+    }
+    std::string meta(meta_len, '\0');
+    RETURN_IF_ERROR(_file_reader->readat(
+            file_size - FOOTER_LEN - meta_len, meta_len, &bytes_read, &meta[0]));
+    if (bytes_read != meta_len) {
+        return Status("Failed to read parquet file metadata");
+    }
+    RETURN_IF_ERROR(parse_file_metadata(
+            (const uint8_t*)meta.data(), meta.size(), &_meta));
+
+    // The root is followed by the leaf columns in a flat schema
+    const std::vector<SchemaElement>& schema = _meta.schema;
+    if (schema.empty() || schema[0].num_children != schema.size() - 1) {
+        return Status("Nested parquet schemas are not supported");
+    }
+    std::unordered_map<std::string, int> leaf_indexes;
+    for (int i = 1; i < schema.size(); ++i) {
+        if (schema[i].num_children > 0 || schema[i].repetition_type == REPEATED) {
+            std::stringstream ss;
+            ss << "Nested parquet column " << schema[i].name << " is not supported";
+            return Status(ss.str());
+        }
+        leaf_indexes.emplace(boost::algorithm::to_lower_copy(schema[i].name), i - 1);
+    }
+    for (auto& name : column_names) {
+        auto it = leaf_indexes.find(boost::algorithm::to_lower_copy(name));
+        if (it == leaf_indexes.end()) {
+            std::stringstream ss;
+            ss << "Column " << name << " is not in the parquet file";
+            return Status(ss.str());
+        }
+        _column_indexes.push_back(it->second);
+    }
+    _column_readers.resize(_column_indexes.size());
+    _values.resize(_column_indexes.size());
+    _nulls.resize(_column_indexes.size());
+    return Status::OK;
+}
+
+Status ParquetReader::open_next_row_group(bool* eof) {
+    while (_next_row_group < _meta.row_groups.size()) {
+        const RowGroup& row_group = _meta.row_groups[_next_row_group++];
+        if (row_group.columns.size() != _meta.schema.size() - 1) {
+            return Status("Number of parquet column chunks doesn't match the schema");
+        }
+        // A row group is read by the range it starts in
+        int64_t start = std::numeric_limits<int64_t>::max();
+        for (auto& column : row_group.columns) {
+            start = std::min(start, column.start_offset());
+        }
+        if (start < _start_offset || start >= _end_offset || row_group.num_rows <= 0) {
+            continue;
+        }
+        for (int i = 0; i < _column_indexes.size(); ++i) {
+            int idx = _column_indexes[i];
+            const SchemaElement& element = _meta.schema[idx + 1];
+            _column_readers[i].reset(new ParquetColumnReader(
+                    element, element.repetition_type == OPTIONAL ? 1 : 0));
+            RETURN_IF_ERROR(_column_readers[i]->init(_file_reader, row_group.columns[idx]));
+        }
+        _rows_left_in_group = row_group.num_rows;
+        *eof = false;
+        return Status::OK;
+    }
+    *eof = true;
+    return Status::OK;
+}
+
+Status ParquetReader::read_row(bool* eof) {
+    while (_rows_left_in_group == 0) {
+        RETURN_IF_ERROR(open_next_row_group(eof));
+        if (*eof) {
+            return Status::OK;
+        }
+    }
+    for (int i = 0; i < _column_readers.size(); ++i) {
+        bool is_null = false;
+        RETURN_IF_ERROR(_column_readers[i]->next(&_values[i], &is_null));
+        _nulls[i] = is_null;
+    }
+    --_rows_left_in_group;
+    *eof = false;
+    return Status::OK;
+}
+
+std::string ParquetReader::debug_row() const {
+    std::stringstream ss;
+    for (int i = 0; i < _values.size(); ++i) {
+        if (i > 0) {
+            ss << ", ";
+        }
+        ss << _meta.schema[_column_indexes[i] + 1].name << "="
+            << (_nulls[i] ? "NULL" : _values[i]);
+    }
+    return ss.str();
+}
+
+}
@@ -0,0 +1,141 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/status.h"
+
+namespace palo {
+
+class FileReader;
+class ParquetColumnReader;
+
+namespace parquet {
+
+// The parts of the Parquet file metadata the reader uses, field names follow
+// parquet.thrift.
+struct SchemaElement {
+    int type;
+    int type_length;
+    int repetition_type;
+    std::string name;
+    int num_children;
+    int converted_type;
+    int scale;
+    int precision;
+
+    SchemaElement() : type(-1), type_length(0), repetition_type(0), num_children(0),
+        converted_type(-1), scale(0), precision(0) { }
+};
+
+struct ColumnChunk {
+    std::vector<std::string> path_in_schema;
+    int type;
+    int codec;
+    int64_t num_values;
+    int64_t total_compressed_size;
+    int64_t data_page_offset;
+    int64_t dictionary_page_offset;
+
+    ColumnChunk() : type(-1), codec(0), num_values(0), total_compressed_size(0),
+        data_page_offset(0), dictionary_page_offset(-1) { }
+
+    // Offset of the first page of the chunk
+    int64_t start_offset() const {
+        return dictionary_page_offset > 0 && dictionary_page_offset < data_page_offset
+            ? dictionary_page_offset : data_page_offset;
+    }
+};
+
+struct RowGroup {
+    std::vector<ColumnChunk> columns;
+    int64_t num_rows;
+
+    RowGroup() : num_rows(0) { }
+};
+
+struct FileMetaData {
+    std::vector<SchemaElement> schema;
+    int64_t num_rows;
+    std::vector<RowGroup> row_groups;
+
+    FileMetaData() : num_rows(0) { }
+};
+
+// Parses the thrift compact encoded footer of a Parquet file.
+Status parse_file_metadata(const uint8_t* data, size_t len, FileMetaData* meta);
+
+}
+
+// Reads the rows of a Parquet file as text, so that broker load converts them with
+// the same expressions as the columns of a csv file.
+//
+// Only flat schemas are supported. Just the requested columns are read, a column
+// chunk at a time with ranged reads, and only the row groups that start within the
+// scan range, so that the ranges of one file may be scanned by different scanners.
+// Supported are the PLAIN and dictionary encodings, data pages of version 1 and 2 and
+// the UNCOMPRESSED, SNAPPY and GZIP codecs.
+class ParquetReader {
+public:
+    // 'file_reader' is owned by the caller. A 'size' of -1 reads to the end of the file.
+    ParquetReader(FileReader* file_reader, int64_t start_offset, int64_t size);
+    ~ParquetReader();
+
+    // Reads the footer and looks up the columns named 'column_names', case insensitive.
+    Status open(const std::vector<std::string>& column_names);
+
+    // Reads the next row. Its values stay valid until the next call.
+    Status read_row(bool* eof);
+
+    // Returns true if the column at 'idx' of 'column_names' is null in the current row.
+    bool is_null(int idx) const {
+        return _nulls[idx];
+    }
+
+    // Returns the text of the column at 'idx' of 'column_names' in the current row.
+    const std::string& value(int idx) const {
+        return _values[idx];
+    }
+
+    // The current row for error messages
+    std::string debug_row() const;
+
+private:
+    Status open_next_row_group(bool* eof);
+
+    FileReader* _file_reader;
+    int64_t _start_offset;
+    int64_t _end_offset;
+
+    parquet::FileMetaData _meta;
+    // Index of the leaf column of each requested column in the schema and the row groups
+    std::vector<int> _column_indexes;
+    std::vector<std::unique_ptr<ParquetColumnReader>> _column_readers;
+
+    int _next_row_group;
+    int64_t _rows_left_in_group;
+
+    std::vector<std::string> _values;
+    std::vector<bool> _nulls;
+};
+
+}
@@ -0,0 +1,270 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/partition_topn_node.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include "common/config.h"
+#include "exprs/expr.h"
+#include "gen_cpp/PlanNodes_types.h"
+#include "runtime/mem_pool.h"
+#include "runtime/raw_value.h"
+#include "runtime/row_batch.h"
+#include "runtime/runtime_state.h"
+#include "runtime/tuple_row.h"
+#include "util/debug_util.h"
+#include "util/runtime_profile.h"
+
+namespace palo {
+
+PartitionTopNNode::PartitionTopNNode(
+        ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs) :
+            ExecNode(pool, tnode, descs),
+            _partition_limit(tnode.partition_topn_node.partition_limit),
+            _keep_ties(tnode.partition_topn_node.__isset.keep_ties
+                       && tnode.partition_topn_node.keep_ties),
+            _output_idx(0),
+            _child_eos(false),
+            _num_partitions_counter(NULL),
+            _num_flushes_counter(NULL) {
+}
+
+PartitionTopNNode::~PartitionTopNNode() {
+}
+
+Status PartitionTopNNode::init(const TPlanNode& tnode) {
+    RETURN_IF_ERROR(ExecNode::init(tnode));
+    const TPartitionTopNNode& topn_node = tnode.partition_topn_node;
+    RETURN_IF_ERROR(Expr::create_expr_trees(
+            _pool, topn_node.partition_exprs, &_lhs_partition_expr_ctxs));
+    RETURN_IF_ERROR(Expr::create_expr_trees(
+            _pool, topn_node.partition_exprs, &_rhs_partition_expr_ctxs));
+    RETURN_IF_ERROR(Expr::create_expr_trees(
+            _pool, topn_node.ordering_exprs, &_lhs_ordering_expr_ctxs));
+    RETURN_IF_ERROR(Expr::create_expr_trees(
+            _pool, topn_node.ordering_exprs, &_rhs_ordering_expr_ctxs));
+    _is_asc_order = topn_node.is_asc_order;
+    _nulls_first = topn_node.nulls_first;
+    if (_partition_limit <= 0) {
+        return Status("partition top-n needs a positive limit.");
+    }
+    DCHECK_EQ(_conjuncts.size(), 0) << "PartitionTopNNode should never have predicates.";
+    return Status::OK;
+}
+
+Status PartitionTopNNode::prepare(RuntimeState* state) {
+    SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
+    RETURN_IF_ERROR(ExecNode::prepare(state));
+    const RowDescriptor& child_desc = child(0)->row_desc();
+    RETURN_IF_ERROR(Expr::prepare(
+            _lhs_partition_expr_ctxs, state, child_desc, expr_mem_tracker()));
+    RETURN_IF_ERROR(Expr::prepare(
+            _rhs_partition_expr_ctxs, state, child_desc, expr_mem_tracker()));
+    RETURN_IF_ERROR(Expr::prepare(
+            _lhs_ordering_expr_ctxs, state, child_desc, expr_mem_tracker()));
+    RETURN_IF_ERROR(Expr::prepare(
+            _rhs_ordering_expr_ctxs, state, child_desc, expr_mem_tracker()));
+
+    _partition_equal.reset(new TupleRowComparator(
+            _lhs_partition_expr_ctxs, _rhs_partition_expr_ctxs, true, false));
+    _row_less_than.reset(new TupleRowComparator(
+            _lhs_ordering_expr_ctxs, _rhs_ordering_expr_ctxs, _is_asc_order, _nulls_first));
+
+    _tuple_descs = child_desc.tuple_descriptors();
+    _tuple_pool.reset(new MemPool(mem_tracker()));
+    _child_batch.reset(new RowBatch(child_desc, state->batch_size(), mem_tracker()));
+
+    _num_partitions_counter = ADD_COUNTER(runtime_profile(), "NumPartitions", TUnit::UNIT);
+    _num_flushes_counter = ADD_COUNTER(runtime_profile(), "NumFlushes", TUnit::UNIT);
+    return Status::OK;
+}
+
+Status PartitionTopNNode::open(RuntimeState* state) {
+    SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
+    RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::OPEN));
+    RETURN_IF_ERROR(ExecNode::open(state));
+    RETURN_IF_CANCELLED(state);
+    RETURN_IF_ERROR(Expr::open(_lhs_partition_expr_ctxs, state));
+    RETURN_IF_ERROR(Expr::open(_rhs_partition_expr_ctxs, state));
+    RETURN_IF_ERROR(Expr::open(_lhs_ordering_expr_ctxs, state));
+    RETURN_IF_ERROR(Expr::open(_rhs_ordering_expr_ctxs, state));
+    RETURN_IF_ERROR(child(0)->open(state));
+    return Status::OK;
+}
+
+Status PartitionTopNNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos) {
+    SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
+    RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
+    RETURN_IF_CANCELLED(state);
+    RETURN_IF_ERROR(state->check_query_state());
+
+    while (!row_batch->at_capacity()) {
+        if (_output_idx < _output_rows.size()) {
+            int row_idx = row_batch->add_row();
+            row_batch->copy_row(_output_rows[_output_idx++], row_batch->get_row(row_idx));
+            row_batch->commit_last_row();
+            ++_num_rows_returned;
+            continue;
+        }
+        if (!_output_rows.empty()) {
+            // All kept rows are in this or earlier batches now, hand over their memory
+            // and start over
+            row_batch->tuple_data_pool()->acquire_data(_tuple_pool.get(), false);
+            _output_rows.clear();
+            _output_idx = 0;
+            break;
+        }
+        if (_child_eos) {
+            break;
+        }
+        RETURN_IF_ERROR(fill_output(state));
+    }
+    COUNTER_SET(_rows_returned_counter, _num_rows_returned);
+
+    *eos = _child_eos && _output_rows.empty();
+    return Status::OK;
+}
+
+Status PartitionTopNNode::fill_output(RuntimeState* state) {
+    while (!_child_eos) {
+        RETURN_IF_CANCELLED(state);
+        _child_batch->reset();
+        RETURN_IF_ERROR(child(0)->get_next(state, _child_batch.get(), &_child_eos));
+        for (int i = 0; i < _child_batch->num_rows(); ++i) {
+            insert_row(_child_batch->get_row(i));
+        }
+        if (_tuple_pool->total_allocated_bytes() > config::partition_topn_max_memory_bytes) {
+            COUNTER_UPDATE(_num_flushes_counter, 1);
+            break;
+        }
+    }
+    prepare_for_output();
+    return Status::OK;
+}
+
+PartitionTopNNode::Partition* PartitionTopNNode::get_partition(TupleRow* row) {
+    uint64_t hash = 0;
+    for (int i = 0; i < _lhs_partition_expr_ctxs.size(); ++i) {
+        ExprContext* ctx = _lhs_partition_expr_ctxs[i];
+        hash = RawValue::get_hash_value_fast64(ctx->get_value(row), ctx->root()->type(), hash);
+    }
+    std::vector<Partition*>& partitions = _partition_map[hash];
+    for (int i = 0; i < partitions.size(); ++i) {
+        if (_partition_equal->compare(row, partitions[i]->heap[0]) == 0) {
+            return partitions[i];
+        }
+    }
+    _partitions.emplace_back(new Partition());
+    partitions.push_back(_partitions.back().get());
+    COUNTER_UPDATE(_num_partitions_counter, 1);
+    return partitions.back();
+}
+
+void PartitionTopNNode::insert_row(TupleRow* row) {
+    const TupleRowComparator& less_than = *_row_less_than;
+    Partition* partition = get_partition(row);
+    std::vector<TupleRow*>& heap = partition->heap;
+    if (static_cast<int64_t>(heap.size()) < _partition_limit) {
+        heap.push_back(copy_row(row, NULL));
+        std::push_heap(heap.begin(), heap.end(), less_than);
+        return;
+    }
+
+    int cmp = less_than.compare(row, heap.front());
+    if (cmp > 0) {
+        return;
+    }
+    if (cmp == 0) {
+        // ROW_NUMBER() numbers equal rows in any order
+        if (_keep_ties) {
+            partition->ties.push_back(copy_row(row, NULL));
+        }
+        return;
+    }
+
+    // 'row' replaces the last kept row, which is still kept as a tie if the last row
+    // after the replacement is equal to it. Otherwise its ties are gone with it.
+    std::pop_heap(heap.begin(), heap.end(), less_than);
+    TupleRow* last_row = heap.back();
+    if (_keep_ties && heap.size() > 1 && less_than.compare(last_row, heap.front()) == 0) {
+        partition->ties.push_back(last_row);
+        heap.back() = copy_row(row, NULL);
+    } else {
+        partition->ties.clear();
+        heap.back() = copy_row(row, last_row);
+    }
+    std::push_heap(heap.begin(), heap.end(), less_than);
+}
+
+TupleRow* PartitionTopNNode::copy_row(TupleRow* row, TupleRow* dst) {
+    if (dst == NULL) {
+        return row->deep_copy(_tuple_descs, _tuple_pool.get());
+    }
+    row->deep_copy(dst, _tuple_descs, _tuple_pool.get(), true);
+    return dst;
+}
+
+void PartitionTopNNode::prepare_for_output() {
+    DCHECK(_output_rows.empty());
+    for (int i = 0; i < _partitions.size(); ++i) {
+        const Partition& partition = *_partitions[i];
+        _output_rows.insert(_output_rows.end(), partition.heap.begin(), partition.heap.end());
+        _output_rows.insert(_output_rows.end(), partition.ties.begin(), partition.ties.end());
+    }
+    _output_idx = 0;
+    _partition_map.clear();
+    _partitions.clear();
+}
+
+Status PartitionTopNNode::close(RuntimeState* state) {
+    if (is_closed()) {
+        return Status::OK;
+    }
+    _partition_map.clear();
+    _partitions.clear();
+    _child_batch.reset();
+    if (_tuple_pool.get() != NULL) {
+        _tuple_pool->free_all();
+    }
+    Expr::close(_lhs_partition_expr_ctxs, state);
+    Expr::close(_rhs_partition_expr_ctxs, state);
+    Expr::close(_lhs_ordering_expr_ctxs, state);
+    Expr::close(_rhs_ordering_expr_ctxs, state);
+    return ExecNode::close(state);
+}
+
+void PartitionTopNNode::debug_string(int indentation_level, std::stringstream* out) const {
+    *out << std::string(indentation_level * 2, ' ');
+    *out << "PartitionTopNNode(partition_exprs="
+        << Expr::debug_string(_lhs_partition_expr_ctxs)
+        << " ordering_exprs=" << Expr::debug_string(_lhs_ordering_expr_ctxs)
+        << " sort_order=[";
+    for (int i = 0; i < _is_asc_order.size(); ++i) {
+        *out << (i > 0 ? " " : "")
+            << (_is_asc_order[i] ? "asc" : "desc")
+            << " nulls " << (_nulls_first[i] ? "first" : "last");
+    }
+    *out << "] partition_limit=" << _partition_limit
+        << " keep_ties=" << _keep_ties;
+    ExecNode::debug_string(indentation_level, out);
+    *out << ")";
+}
+
+}
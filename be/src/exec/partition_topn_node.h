@@ -0,0 +1,119 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_QUERY_EXEC_PARTITION_TOPN_NODE_H
+#define BDG_PALO_BE_SRC_QUERY_EXEC_PARTITION_TOPN_NODE_H
+
+#include <boost/scoped_ptr.hpp>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "exec/exec_node.h"
+#include "util/tuple_row_compare.h"
+
+namespace palo {
+
+class MemPool;
+class RuntimeState;
+class TupleRow;
+
+// Node that keeps the first 'partition_limit' rows of each partition of its input in
+// the order of the ordering exprs, which is all a ROW_NUMBER() or RANK() filtered on
+// the rank needs. It is placed below the exchange and the sort of the analytic
+// functions, so only the rows that can pass the filter are shuffled and sorted.
+// The rows of a partition are deep copied into a bounded heap found in a hash map on
+// the partition exprs. Once the kept rows take more than
+// config::partition_topn_max_memory_bytes, e.g. for very many partitions, they are
+// passed on and the node starts over with the rest of the input; the sort and the
+// filter above are exact, so that only costs some reduction.
+// The rows are passed on unchanged and in no particular order.
+class PartitionTopNNode : public ExecNode {
+public:
+    PartitionTopNNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs);
+    virtual ~PartitionTopNNode();
+
+    virtual Status init(const TPlanNode& tnode);
+    virtual Status prepare(RuntimeState* state);
+    virtual Status open(RuntimeState* state);
+    virtual Status get_next(RuntimeState* state, RowBatch* row_batch, bool* eos);
+    virtual Status close(RuntimeState* state);
+
+protected:
+    virtual void debug_string(int indentation_level, std::stringstream* out) const;
+
+private:
+    // The kept rows of one partition
+    struct Partition {
+        // Max-heap on the ordering exprs of at most _partition_limit rows, its top is
+        // the last kept row
+        std::vector<TupleRow*> heap;
+        // With _keep_ties, the rows beyond the heap equal to its top
+        std::vector<TupleRow*> ties;
+    };
+
+    // Pulls child batches into the partitions until the input is exhausted or the kept
+    // rows take too much memory, then collects them into _output_rows
+    Status fill_output(RuntimeState* state);
+
+    // Finds or creates the partition of 'row'
+    Partition* get_partition(TupleRow* row);
+
+    // Keeps 'row' in its partition if it is in the top-n of it
+    void insert_row(TupleRow* row);
+
+    // Copies 'row' into _tuple_pool, reusing the memory of 'dst' if it isn't NULL
+    TupleRow* copy_row(TupleRow* row, TupleRow* dst);
+
+    // Collects the kept rows into _output_rows and forgets the partitions
+    void prepare_for_output();
+
+    // Evaluated over the row looked up (and hashed) and the first row of a partition
+    std::vector<ExprContext*> _lhs_partition_expr_ctxs;
+    std::vector<ExprContext*> _rhs_partition_expr_ctxs;
+    std::vector<ExprContext*> _lhs_ordering_expr_ctxs;
+    std::vector<ExprContext*> _rhs_ordering_expr_ctxs;
+    std::vector<bool> _is_asc_order;
+    std::vector<bool> _nulls_first;
+    int64_t _partition_limit;
+    bool _keep_ties;
+
+    boost::scoped_ptr<TupleRowComparator> _partition_equal;
+    boost::scoped_ptr<TupleRowComparator> _row_less_than;
+
+    // Tuple descriptors of the child row, for deep copies
+    std::vector<TupleDescriptor*> _tuple_descs;
+
+    // Stores the kept rows, handed over to the output batches after they are passed on
+    boost::scoped_ptr<MemPool> _tuple_pool;
+
+    // The partitions by the hash of their partition exprs
+    std::unordered_map<uint64_t, std::vector<Partition*>> _partition_map;
+    std::vector<std::unique_ptr<Partition>> _partitions;
+
+    // Kept rows being passed on, and the next one to pass on
+    std::vector<TupleRow*> _output_rows;
+    int _output_idx;
+
+    boost::scoped_ptr<RowBatch> _child_batch;
+    bool _child_eos;
+
+    RuntimeProfile::Counter* _num_partitions_counter;
+    RuntimeProfile::Counter* _num_flushes_counter;
+};
+
+}
+
+#endif
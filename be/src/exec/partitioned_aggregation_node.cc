@@ -26,6 +26,7 @@
 
 #include "codegen/codegen_anyval.h"
 #include "codegen/llvm_codegen.h"
+#include "common/config.h"
 #include "exec/partitioned_hash_table.inline.h"
 #include "exprs/agg_fn_evaluator.h"
 #include "exprs/expr.h"
@@ -36,11 +37,13 @@
 #include "runtime/mem_pool.h"
 #include "runtime/raw_value.h"
 #include "runtime/row_batch.h"
+#include "runtime/mem_arbitrator.h"
 #include "runtime/runtime_state.h"
 #include "runtime/tuple.h"
 #include "runtime/tuple_row.h"
 #include "udf/udf_internal.h"
 #include "util/debug_util.h"
+#include "util/query_trace.h"
 #include "util/runtime_profile.h"
 
 #include "gen_cpp/Exprs_types.h"
@@ -63,7 +66,9 @@ PartitionedAggregationNode::PartitionedAggregationNode(
         _output_tuple_desc(NULL),
         _needs_finalize(tnode.agg_node.need_finalize),
         _needs_serialize(false),
+        _is_streaming_preagg(false),
         _block_mgr_client(NULL),
+        _spill_request_generation(-1),
         _output_partition(NULL),
         _process_row_batch_fn(NULL),
         _build_timer(NULL),
@@ -74,9 +79,14 @@ PartitionedAggregationNode::PartitionedAggregationNode(
         // _max_partition_level(NULL),
         _num_row_repartitioned(NULL),
         _num_repartitions(NULL),
+        _num_passthrough_rows(NULL),
+        _preagg_reduction(NULL),
         _singleton_output_tuple(NULL),
         _singleton_output_tuple_returned(true),
-        _partition_pool(new ObjectPool()) {
+        _partition_pool(new ObjectPool()),
+        _child_eos(false),
+        _streaming_passthrough(false),
+        _num_preagg_input_rows(0) {
     DCHECK_EQ(PARTITION_FANOUT, 1 << NUM_PARTITIONING_BITS);
 }
 
@@ -90,11 +100,18 @@ Status PartitionedAggregationNode::init(const TPlanNode& tnode) {
                     _pool, tnode.agg_node.aggregate_functions[i], &evaluator));
         _aggregate_evaluators.push_back(evaluator);
     }
+    // Passing rows through is only correct if the parent merges the groups again, so
+    // the node must produce intermediate tuples and must not filter or limit them.
+    _is_streaming_preagg = tnode.agg_node.__isset.use_streaming_preaggregation
+            && tnode.agg_node.use_streaming_preaggregation
+            && !_probe_expr_ctxs.empty() && !_needs_finalize
+            && _conjunct_ctxs.empty() && _limit == -1;
     return Status::OK;
 }
 
 Status PartitionedAggregationNode::prepare(RuntimeState* state) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
 
     // Create the codegen object before preparing _conjunct_ctxs and _children, so that any
     // ScalarFnCalls will use codegen.
@@ -124,6 +141,13 @@ Status PartitionedAggregationNode::prepare(RuntimeState* state) {
             runtime_profile(), "SpilledPartitions", TUnit::UNIT);
     // _largest_partition_percent = runtime_profile()->AddHighWaterMarkCounter(
     //         "LargestPartitionPercent", TUnit::UNIT);
+    if (_is_streaming_preagg) {
+        _num_passthrough_rows = ADD_COUNTER(
+                runtime_profile(), "RowsPassedThrough", TUnit::UNIT);
+        _preagg_reduction = ADD_COUNTER(
+                runtime_profile(), "PreaggReductionPercent", TUnit::UNIT);
+        add_runtime_exec_option("Streaming Preaggregation");
+    }
 
     _intermediate_tuple_desc =
         state->desc_tbl().get_tuple_descriptor(_intermediate_tuple_id);
@@ -192,6 +216,7 @@ Status PartitionedAggregationNode::prepare(RuntimeState* state) {
         RETURN_IF_ERROR(_state->block_mgr2()->register_client(
                     min_required_buffers(), mem_tracker(), state, &_block_mgr_client));
         RETURN_IF_ERROR(create_hash_partitions(0));
+        _spill_request_generation = state->mem_arbitrator()->register_spiller();
     }
 
     // TODO: Is there a need to create the stream here? If memory reservations work we may
@@ -219,6 +244,7 @@ Status PartitionedAggregationNode::prepare(RuntimeState* state) {
 
 Status PartitionedAggregationNode::open(RuntimeState* state) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(ExecNode::open(state));
 
     RETURN_IF_ERROR(Expr::open(_probe_expr_ctxs, state));
@@ -231,12 +257,21 @@ Status PartitionedAggregationNode::open(RuntimeState* state) {
 
     // Read all the rows from the child and process them.
     RETURN_IF_ERROR(_children[0]->open(state));
+    if (_is_streaming_preagg) {
+        // The input is consumed in get_next(), so that rows can be passed through.
+        if (_child_batch.get() == NULL) {
+            _child_batch.reset(
+                    new RowBatch(_children[0]->row_desc(), state->batch_size(), mem_tracker()));
+        }
+        return Status::OK;
+    }
     RowBatch batch(_children[0]->row_desc(), state->batch_size(), mem_tracker());
     bool eos = false;
     do {
         RETURN_IF_CANCELLED(state);
         // RETURN_IF_ERROR(QueryMaintenance(state));
         RETURN_IF_ERROR(state->check_query_state());
+        RETURN_IF_ERROR(spill_if_requested());
         RETURN_IF_ERROR(_children[0]->get_next(state, &batch, &eos));
 
         if (UNLIKELY(VLOG_ROW_IS_ON)) {
@@ -278,6 +313,7 @@ Status PartitionedAggregationNode::open(RuntimeState* state) {
 
 Status PartitionedAggregationNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
     RETURN_IF_CANCELLED(state);
     // RETURN_IF_ERROR(QueryMaintenance(state));
@@ -313,6 +349,16 @@ Status PartitionedAggregationNode::get_next(RuntimeState* state, RowBatch* row_b
         return Status::OK;
     }
 
+    if (_is_streaming_preagg && !_child_eos) {
+        RETURN_IF_ERROR(get_rows_streaming(state, row_batch));
+        if (row_batch->num_rows() > 0) {
+            COUNTER_SET(_rows_returned_counter, _num_rows_returned);
+            *eos = false;
+            return Status::OK;
+        }
+        DCHECK(_child_eos);
+    }
+
     if (_output_iterator.at_end()) {
         // Done with this partition, move onto the next one.
         if (_output_partition != NULL) {
@@ -365,6 +411,94 @@ Status PartitionedAggregationNode::get_next(RuntimeState* state, RowBatch* row_b
     return Status::OK;
 }
 
+Status PartitionedAggregationNode::get_rows_streaming(RuntimeState* state, RowBatch* out_batch) {
+    DCHECK(_is_streaming_preagg);
+    DCHECK(_child_batch.get() != NULL);
+    while (out_batch->num_rows() == 0 && !_child_eos) {
+        RETURN_IF_CANCELLED(state);
+        RETURN_IF_ERROR(state->check_query_state());
+        RETURN_IF_ERROR(_children[0]->get_next(state, _child_batch.get(), &_child_eos));
+
+        if (_streaming_passthrough) {
+            SCOPED_TIMER(_get_results_timer);
+            RETURN_IF_ERROR(add_passthrough_rows(_child_batch.get(), out_batch));
+        } else {
+            SCOPED_TIMER(_build_timer);
+            if (_process_row_batch_fn != NULL) {
+                RETURN_IF_ERROR(_process_row_batch_fn(this, _child_batch.get(), _ht_ctx.get()));
+            } else {
+                RETURN_IF_ERROR(process_batch<false>(_child_batch.get(), _ht_ctx.get()));
+            }
+            _num_preagg_input_rows += _child_batch->num_rows();
+
+            double reduction = 0;
+            if (should_stop_preaggregation(&reduction)) {
+                VLOG_QUERY << "Streaming preaggregation of node " << _id
+                        << " stops aggregating after " << _num_preagg_input_rows
+                        << " rows, reduction=" << reduction;
+                COUNTER_SET(_preagg_reduction, static_cast<int64_t>(reduction * 100));
+                add_runtime_exec_option("Passthrough");
+                _streaming_passthrough = true;
+            }
+        }
+        _child_batch->reset();
+    }
+
+    if (_child_eos) {
+        child(0)->close(state);
+        RETURN_IF_ERROR(move_hash_partitions(_num_preagg_input_rows));
+    }
+    return Status::OK;
+}
+
+bool PartitionedAggregationNode::should_stop_preaggregation(double* reduction) const {
+    int64_t ht_bytes = 0;
+    int64_t num_groups = 0;
+    for (int i = 0; i < _hash_partitions.size(); ++i) {
+        const Partition* partition = _hash_partitions[i];
+        if (partition->is_spilled()) {
+            // Spilling the input of a pre-aggregation costs more than letting the
+            // merge aggregation see the rows twice.
+            *reduction = 0;
+            return true;
+        }
+        ht_bytes += partition->hash_tbl->current_mem_size()
+                + partition->aggregated_row_stream->byte_size();
+        num_groups += partition->hash_tbl->size();
+    }
+    if (num_groups == 0) {
+        *reduction = 0;
+        return false;
+    }
+    *reduction = static_cast<double>(_num_preagg_input_rows) / num_groups;
+    return ht_bytes > config::streaming_preagg_max_hash_table_bytes
+            && *reduction < config::streaming_preagg_min_reduction;
+}
+
+Status PartitionedAggregationNode::add_passthrough_rows(RowBatch* in_batch, RowBatch* out_batch) {
+    DCHECK_LE(in_batch->num_rows(), out_batch->capacity() - out_batch->num_rows());
+    MemPool* pool = out_batch->tuple_data_pool();
+    for (int i = 0; i < in_batch->num_rows(); ++i) {
+        TupleRow* in_row = in_batch->get_row(i);
+        // Evaluates the grouping exprs into _ht_ctx, which construct_intermediate_tuple()
+        // copies the grouping values from. The streaming hash table ctx stores nulls, so
+        // every row is valid.
+        uint32_t hash = 0;
+        _ht_ctx->eval_and_hash_probe(in_row, &hash);
+        Tuple* intermediate_tuple = construct_intermediate_tuple(_agg_fn_ctxs, pool, NULL, NULL);
+        update_tuple(&_agg_fn_ctxs[0], intermediate_tuple, in_row);
+        int row_idx = out_batch->add_row();
+        TupleRow* out_row = out_batch->get_row(row_idx);
+        out_row->set_tuple(0, get_output_tuple(_agg_fn_ctxs, intermediate_tuple, pool));
+        out_batch->commit_last_row();
+        ++_num_rows_returned;
+    }
+    COUNTER_UPDATE(_num_passthrough_rows, in_batch->num_rows());
+    // The aggregate functions may keep pointers into the input rows.
+    in_batch->transfer_resource_ownership(out_batch);
+    return Status::OK;
+}
+
 void PartitionedAggregationNode::cleanup_hash_tbl(
         const vector<FunctionContext*>& agg_fn_ctxs, PartitionedHashTable::Iterator it) {
     if (!_needs_finalize && !_needs_serialize) {
@@ -405,6 +539,9 @@ Status PartitionedAggregationNode::reset(RuntimeState* state) {
         _ht_ctx->set_level(0);
         close_partitions();
         create_hash_partitions(0);
+        _child_eos = false;
+        _streaming_passthrough = false;
+        _num_preagg_input_rows = 0;
     }
     // return ExecNode::reset(state);
     return Status::OK;
@@ -428,6 +565,10 @@ Status PartitionedAggregationNode::close(RuntimeState* state) {
     }
 
     close_partitions();
+    if (_spill_request_generation >= 0) {
+        state->mem_arbitrator()->unregister_spiller();
+        _spill_request_generation = -1;
+    }
 
     for (int i = 0; i < _aggregate_evaluators.size(); ++i) {
         _aggregate_evaluators[i]->close(state);
@@ -447,6 +588,7 @@ Status PartitionedAggregationNode::close(RuntimeState* state) {
     if (_serialize_stream.get() != NULL) {
         _serialize_stream->close();
     }
+    _child_batch.reset();
 
     if (_block_mgr_client != NULL) {
         state->block_mgr2()->clear_reservations(_block_mgr_client);
@@ -1042,9 +1184,28 @@ Status PartitionedAggregationNode::spill_partition() {
         return _state->block_mgr2()->mem_limit_too_low_error(_block_mgr_client, id());
     }
 
+    ScopedTraceSpan span(_state->query_trace(), "spill", "spill_agg_partition");
+    if (span.enabled()) {
+        span.set_detail("node_id=" + std::to_string(id())
+                + " partition=" + std::to_string(partition_idx)
+                + " bytes=" + std::to_string(max_freed_mem));
+    }
     return _hash_partitions[partition_idx]->spill();
 }
 
+Status PartitionedAggregationNode::spill_if_requested() {
+    if (_spill_request_generation < 0
+            || !_state->mem_arbitrator()->spill_requested(&_spill_request_generation)) {
+        return Status::OK;
+    }
+    for (int i = 0; i < _hash_partitions.size(); ++i) {
+        if (!_hash_partitions[i]->is_closed && !_hash_partitions[i]->is_spilled()) {
+            return spill_partition();
+        }
+    }
+    return Status::OK;
+}
+
 Status PartitionedAggregationNode::move_hash_partitions(int64_t num_input_rows) {
     DCHECK(!_hash_partitions.empty());
     stringstream ss;
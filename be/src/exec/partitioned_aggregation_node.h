@@ -30,6 +30,7 @@
 #include "runtime/buffered_tuple_stream2.h"
 #include "runtime/descriptors.h"  // for TupleId
 #include "runtime/mem_pool.h"
+#include "runtime/row_batch.h"
 #include "runtime/string_value.h"
 
 namespace llvm {
@@ -82,6 +83,15 @@ class SlotDescriptor;
 // tables of each partition start using small (less than IO-sized) buffers, regardless
 // of the level.
 //
+// Streaming pre-aggregation: when the planner marks this node as the first phase of a
+// multi-phase aggregation (use_streaming_preaggregation), child(0) is consumed in
+// get_next() instead of open(). As long as the hash tables fit in
+// config::streaming_preagg_max_hash_table_bytes, or they reduce the input by at least
+// config::streaming_preagg_min_reduction, rows are aggregated as usual. Otherwise the
+// node stops aggregating: each remaining input row is converted into a serialized
+// intermediate tuple of its own and passed straight to the parent, which has to merge
+// the groups anyway. The groups already in the hash tables are returned at the end.
+//
 // TODO: Buffer rows before probing into the hash table?
 // TODO: After spilling, we can still maintain a very small hash table just to remove
 // some number of rows (from likely going to disk).
@@ -169,6 +179,10 @@ private:
     // Contains any evaluators that require the serialize step.
     bool _needs_serialize;
 
+    // True if this is a first phase aggregation that may stop aggregating and pass
+    // rows through to the parent. See the class comment.
+    bool _is_streaming_preagg;
+
     std::vector<AggFnEvaluator*> _aggregate_evaluators;
 
     // FunctionContext for each aggregate function and backing MemPool. String data
@@ -194,6 +208,10 @@ private:
     RuntimeState* _state;
     BufferedBlockMgr2::Client* _block_mgr_client;
 
+    // The last spill request of the memory arbitrator that was served, -1 if this node
+    // isn't registered as a spiller.
+    int64_t _spill_request_generation;
+
     // MemPool used to allocate memory for when we don't have grouping and don't initialize
     // the partitioning structures, or during close() when creating new output tuples.
     // For non-grouping aggregations, the ownership of the pool's memory is transferred
@@ -238,6 +256,13 @@ private:
     // Number of partitions that have been spilled.
     RuntimeProfile::Counter* _num_spilled_partitions;
 
+    // Number of input rows that were passed through without aggregation.
+    RuntimeProfile::Counter* _num_passthrough_rows;
+
+    // Reduction ratio of the hash tables when the streaming pre-aggregation stopped
+    // aggregating, times 100. Zero if it never did.
+    RuntimeProfile::Counter* _preagg_reduction;
+
     // The largest fraction after repartitioning. This is expected to be
     // 1 / PARTITION_FANOUT. A value much larger indicates skew.
     // RuntimeProfile::HighWaterMarkCounter* _largest_partition_percent;
@@ -270,6 +295,16 @@ private:
     // and _aggregated_partitions, depending on if it was spilled or not.
     std::list<Partition*> _aggregated_partitions;
 
+    // Only used in streaming pre-aggregation. Batch that child(0) is read into, true once
+    // child(0) has returned eos, and true once the node stopped aggregating.
+    boost::scoped_ptr<RowBatch> _child_batch;
+    bool _child_eos;
+    bool _streaming_passthrough;
+
+    // Number of rows of child(0) that were aggregated into _hash_partitions, used to
+    // compute the reduction of the streaming pre-aggregation.
+    int64_t _num_preagg_input_rows;
+
     // END: Members that must be Reset()
     ////////////////////////////
 
@@ -389,10 +424,12 @@ private:
     template<bool AGGREGATED_ROWS>
     Status IR_ALWAYS_INLINE process_batch(RowBatch* batch, PartitionedHashTableCtx* ht_ctx);
 
-    // This function processes each individual row in process_batch(). Must be inlined
-    // into process_batch for codegen to substitute function calls with codegen'd versions.
+    // This function processes each individual row in process_batch(), whose exprs are
+    // evaluated into ht_ctx with the hash 'hash'. Must be inlined into process_batch for
+    // codegen to substitute function calls with codegen'd versions.
     template<bool AGGREGATED_ROWS>
-    Status IR_ALWAYS_INLINE process_row(TupleRow* row, PartitionedHashTableCtx* ht_ctx);
+    Status IR_ALWAYS_INLINE process_row(TupleRow* row, uint32_t hash,
+            PartitionedHashTableCtx* ht_ctx);
 
     // Create a new intermediate tuple in partition, initialized with row. ht_ctx is
     // the context for the partition's hash table and hash is the precomputed hash of
@@ -438,9 +475,29 @@ private:
     // partition from _aggregated_partitions and repartitions it.
     Status next_partition();
 
+    // Streaming pre-aggregation part of get_next(). Pulls batches from child(0) and either
+    // aggregates them or, after deciding to stop aggregating, passes them through into
+    // 'out_batch'. Returns once 'out_batch' has rows or child(0) is exhausted, in which
+    // case _hash_partitions are moved and the aggregated groups are returned as usual.
+    Status get_rows_streaming(RuntimeState* state, RowBatch* out_batch);
+
+    // Returns true if the hash tables of _hash_partitions outgrew the budget of the
+    // streaming pre-aggregation without reducing the input enough. Sets '*reduction'
+    // to the number of rows aggregated per group.
+    bool should_stop_preaggregation(double* reduction) const;
+
+    // Converts every row in 'in_batch' into a serialized intermediate tuple in
+    // 'out_batch', without aggregating across rows. 'out_batch' must have room for all
+    // the rows and takes over the resources of 'in_batch'.
+    Status add_passthrough_rows(RowBatch* in_batch, RowBatch* out_batch);
+
     // Picks a partition from _hash_partitions to spill.
     Status spill_partition();
 
+    // Spills a partition if the memory arbitrator of the query requested it since the
+    // last call and not all partitions are spilled already.
+    Status spill_if_requested();
+
     // Moves the partitions in _hash_partitions to _aggregated_partitions or
     // _spilled_partitions. Partitions moved to _spilled_partitions are unpinned.
     // input_rows is the number of input rows that have been repartitioned.
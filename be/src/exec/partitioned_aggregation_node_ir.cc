@@ -47,26 +47,47 @@ Status PartitionedAggregationNode::process_batch(RowBatch* batch, PartitionedHas
     int num_rows = batch->num_rows();
     RETURN_IF_ERROR(check_and_resize_hash_partitions(num_rows, ht_ctx));
 
-    for (int i = 0; i < num_rows; ++i) {
-        RETURN_IF_ERROR(process_row<AGGREGATED_ROWS>(batch->get_row(i), ht_ctx));
+    // Evaluates and hashes a group of rows first and prefetches their buckets, then
+    // aggregates them, so that the cache misses of the lookups overlap.
+    const int group_size = PartitionedHashTableCtx::ROW_CACHE_SIZE;
+    uint32_t hashes[group_size];
+    bool is_valid[group_size];
+    for (int group_start = 0; group_start < num_rows; group_start += group_size) {
+        const int group_end = std::min(num_rows, group_start + group_size);
+        for (int i = group_start; i < group_end; ++i) {
+            TupleRow* row = batch->get_row(i);
+            uint32_t* hash = &hashes[i - group_start];
+            if (AGGREGATED_ROWS) {
+                is_valid[i - group_start] = ht_ctx->eval_and_hash_build(row, hash);
+            } else {
+                is_valid[i - group_start] = ht_ctx->eval_and_hash_probe(row, hash);
+            }
+            if (!is_valid[i - group_start]) {
+                continue;
+            }
+            ht_ctx->cache_last_row(i - group_start);
+            Partition* dst_partition = _hash_partitions[*hash >> (32 - NUM_PARTITIONING_BITS)];
+            if (!dst_partition->is_spilled()) {
+                dst_partition->hash_tbl->prefetch_bucket(*hash);
+            }
+        }
+
+        for (int i = group_start; i < group_end; ++i) {
+            if (!is_valid[i - group_start]) {
+                continue;
+            }
+            ht_ctx->load_cached_row(i - group_start);
+            RETURN_IF_ERROR(process_row<AGGREGATED_ROWS>(
+                    batch->get_row(i), hashes[i - group_start], ht_ctx));
+        }
     }
 
     return Status::OK;
 }
 
 template<bool AGGREGATED_ROWS>
-Status PartitionedAggregationNode::process_row(TupleRow* row, PartitionedHashTableCtx* ht_ctx) {
-    uint32_t hash = 0;
-    if (AGGREGATED_ROWS) {
-        if (!ht_ctx->eval_and_hash_build(row, &hash)) {
-            return Status::OK;
-        }
-    } else {
-        if (!ht_ctx->eval_and_hash_probe(row, &hash)) {
-            return Status::OK;
-        }
-    }
-
+Status PartitionedAggregationNode::process_row(
+        TupleRow* row, uint32_t hash, PartitionedHashTableCtx* ht_ctx) {
     // To process this row, we first see if it can be aggregated or inserted into this
     // partition's hash table. If we need to insert it and that fails, due to OOM, we
     // spill the partition. The partition to spill is not necessarily dst_partition,
@@ -0,0 +1,1077 @@
+// Modifications copyright (C) 2017, Baidu.com, Inc.
+// Copyright 2017 The Apache Software Foundation
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/partitioned_hash_join_node.h"
+
+#include <sstream>
+
+#include "exec/partitioned_hash_table.inline.h"
+#include "exprs/expr.h"
+#include "exprs/expr_context.h"
+#include "runtime/buffered_tuple_stream2.inline.h"
+#include "runtime/mem_arbitrator.h"
+#include "runtime/mem_tracker.h"
+#include "runtime/row_batch.h"
+#include "runtime/runtime_state.h"
+#include "util/debug_util.h"
+#include "util/query_trace.h"
+#include "util/runtime_profile.h"
+
+#include "gen_cpp/PlanNodes_types.h"
+
+using std::list;
+using std::string;
+using std::stringstream;
+using std::vector;
+
+namespace palo {
+
+PartitionedHashJoinNode::PartitionedHashJoinNode(
+        ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs) :
+        BlockingJoinNode("PartitionedHashJoinNode", tnode.hash_join_node.join_op,
+                pool, tnode, descs),
+        _state(NULL),
+        _block_mgr_client(NULL),
+        _spill_request_generation(-1),
+        _partition_build_timer(NULL),
+        _num_hash_buckets(NULL),
+        _partitions_created(NULL),
+        _num_build_rows_partitioned(NULL),
+        _num_probe_rows_partitioned(NULL),
+        _num_repartitions(NULL),
+        _num_spilled_partitions(NULL),
+        _build_hash_table_timer(NULL),
+        _probe_timer(NULL),
+        _hash_join_state(PARTITIONING_BUILD),
+        _partition_pool(new ObjectPool()),
+        _input_partition(NULL),
+        _matched_probe(true) {
+    memset(_hash_tbls, 0, sizeof(_hash_tbls));
+}
+
+PartitionedHashJoinNode::~PartitionedHashJoinNode() {
+    // Check that we didn't leak any memory.
+    DCHECK(_input_partition == NULL);
+    DCHECK(_hash_partitions.empty());
+}
+
+Status PartitionedHashJoinNode::init(const TPlanNode& tnode) {
+    RETURN_IF_ERROR(BlockingJoinNode::init(tnode));
+    DCHECK(tnode.__isset.hash_join_node);
+    DCHECK_NE(_join_op, TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN);
+    const vector<TEqJoinCondition>& eq_join_conjuncts = tnode.hash_join_node.eq_join_conjuncts;
+    for (int i = 0; i < eq_join_conjuncts.size(); ++i) {
+        ExprContext* ctx = NULL;
+        RETURN_IF_ERROR(Expr::create_expr_tree(_pool, eq_join_conjuncts[i].left, &ctx));
+        _probe_expr_ctxs.push_back(ctx);
+        RETURN_IF_ERROR(Expr::create_expr_tree(_pool, eq_join_conjuncts[i].right, &ctx));
+        _build_expr_ctxs.push_back(ctx);
+    }
+    RETURN_IF_ERROR(
+        Expr::create_expr_trees(_pool, tnode.hash_join_node.other_join_conjuncts,
+                                &_other_join_conjunct_ctxs));
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::prepare(RuntimeState* state) {
+    SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
+    RETURN_IF_ERROR(BlockingJoinNode::prepare(state));
+    _state = state;
+
+    // build and probe exprs are evaluated in the context of the rows produced by our
+    // right and left children, respectively
+    RETURN_IF_ERROR(Expr::prepare(
+            _build_expr_ctxs, state, child(1)->row_desc(), expr_mem_tracker()));
+    RETURN_IF_ERROR(Expr::prepare(
+            _probe_expr_ctxs, state, child(0)->row_desc(), expr_mem_tracker()));
+    // _other_join_conjuncts are evaluated in the context of the rows produced by this node
+    RETURN_IF_ERROR(Expr::prepare(
+            _other_join_conjunct_ctxs, state, _row_descriptor, expr_mem_tracker()));
+
+    // We need one output buffer per partition and one additional buffer either for the
+    // input (while repartitioning) or to contain the hash table.
+    RETURN_IF_ERROR(state->block_mgr2()->register_client(
+            min_required_buffers(), mem_tracker(), state, &_block_mgr_client));
+    _spill_request_generation = state->mem_arbitrator()->register_spiller();
+
+    // The build rows with NULL keys are kept only when the unmatched build rows are
+    // output, the probe rows with NULL keys never find a match.
+    const bool stores_nulls = need_to_process_unmatched_build_rows();
+    _ht_ctx.reset(new PartitionedHashTableCtx(_build_expr_ctxs, _probe_expr_ctxs,
+            stores_nulls, false, state->fragment_hash_seed(), MAX_PARTITION_DEPTH,
+            child(1)->row_desc().tuple_descriptors().size()));
+
+    _partition_build_timer = ADD_TIMER(runtime_profile(), "BuildPartitionTime");
+    _num_hash_buckets = ADD_COUNTER(runtime_profile(), "HashBuckets", TUnit::UNIT);
+    _partitions_created = ADD_COUNTER(runtime_profile(), "PartitionsCreated", TUnit::UNIT);
+    _num_build_rows_partitioned = ADD_COUNTER(
+            runtime_profile(), "BuildRowsPartitioned", TUnit::UNIT);
+    _num_probe_rows_partitioned = ADD_COUNTER(
+            runtime_profile(), "ProbeRowsPartitioned", TUnit::UNIT);
+    _num_repartitions = ADD_COUNTER(runtime_profile(), "NumRepartitions", TUnit::UNIT);
+    _num_spilled_partitions = ADD_COUNTER(
+            runtime_profile(), "SpilledPartitions", TUnit::UNIT);
+    _build_hash_table_timer = ADD_TIMER(runtime_profile(), "HashTablesBuildTime");
+    _probe_timer = ADD_TIMER(runtime_profile(), "ProbeTime");
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::open(RuntimeState* state) {
+    SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
+    RETURN_IF_ERROR(Expr::open(_build_expr_ctxs, state));
+    RETURN_IF_ERROR(Expr::open(_probe_expr_ctxs, state));
+    RETURN_IF_ERROR(Expr::open(_other_join_conjunct_ctxs, state));
+
+    // Partitions the build side (in another thread if possible), opens child(0) and
+    // fetches its first batch.
+    RETURN_IF_ERROR(BlockingJoinNode::open(state));
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::close(RuntimeState* state) {
+    if (is_closed()) {
+        return Status::OK;
+    }
+    close_partitions();
+    if (_spill_request_generation >= 0) {
+        state->mem_arbitrator()->unregister_spiller();
+        _spill_request_generation = -1;
+    }
+    if (_ht_ctx.get() != NULL) {
+        _ht_ctx->close();
+    }
+    if (_block_mgr_client != NULL) {
+        state->block_mgr2()->clear_reservations(_block_mgr_client);
+    }
+    Expr::close(_build_expr_ctxs, state);
+    Expr::close(_probe_expr_ctxs, state);
+    Expr::close(_other_join_conjunct_ctxs, state);
+    return BlockingJoinNode::close(state);
+}
+
+void PartitionedHashJoinNode::close_partitions() {
+    for (int i = 0; i < _hash_partitions.size(); ++i) {
+        _hash_partitions[i]->close(NULL);
+    }
+    _hash_partitions.clear();
+    for (list<Partition*>::iterator it = _spilled_partitions.begin();
+            it != _spilled_partitions.end(); ++it) {
+        (*it)->close(NULL);
+    }
+    _spilled_partitions.clear();
+    for (list<Partition*>::iterator it = _output_build_partitions.begin();
+            it != _output_build_partitions.end(); ++it) {
+        (*it)->close(NULL);
+    }
+    _output_build_partitions.clear();
+    if (_input_partition != NULL) {
+        _input_partition->close(NULL);
+        _input_partition = NULL;
+    }
+    memset(_hash_tbls, 0, sizeof(_hash_tbls));
+}
+
+PartitionedHashJoinNode::Partition::Partition(
+        RuntimeState* state, PartitionedHashJoinNode* parent, int level) :
+        _parent(parent),
+        _is_closed(false),
+        _is_spilled(false),
+        _level(level) {
+    _build_rows = new BufferedTupleStream2(state, parent->child(1)->row_desc(),
+            state->block_mgr2(), parent->_block_mgr_client,
+            true /* use_initial_small_buffers */, false /* read_write */);
+    _probe_rows = new BufferedTupleStream2(state, parent->child(0)->row_desc(),
+            state->block_mgr2(), parent->_block_mgr_client,
+            true /* use_initial_small_buffers */, false /* read_write */);
+}
+
+PartitionedHashJoinNode::Partition::~Partition() {
+    DCHECK(is_closed());
+}
+
+int64_t PartitionedHashJoinNode::Partition::estimated_in_mem_size() const {
+    return _build_rows->byte_size()
+        + PartitionedHashTable::EstimateSize(_build_rows->num_rows());
+}
+
+void PartitionedHashJoinNode::Partition::close(RowBatch* batch) {
+    if (is_closed()) {
+        return;
+    }
+    _is_closed = true;
+    if (_hash_tbl.get() != NULL) {
+        _hash_tbl->close();
+        _hash_tbl.reset();
+    }
+
+    // The output rows may point to the build rows, so the build stream is released
+    // together with the batch.
+    if (_build_rows != NULL) {
+        if (batch == NULL) {
+            _build_rows->close();
+            delete _build_rows;
+        } else {
+            batch->add_tuple_stream(_build_rows);
+        }
+        _build_rows = NULL;
+    }
+    if (_probe_rows != NULL) {
+        _probe_rows->close();
+        delete _probe_rows;
+        _probe_rows = NULL;
+    }
+}
+
+Status PartitionedHashJoinNode::Partition::build_hash_table(RuntimeState* state, bool* built) {
+    DCHECK(_build_rows != NULL);
+    *built = false;
+    // First pin the entire build stream in memory.
+    RETURN_IF_ERROR(_build_rows->pin_stream(false, built));
+    if (!*built) {
+        return Status::OK;
+    }
+    RETURN_IF_ERROR(_build_rows->prepare_for_read(false));
+
+    SCOPED_TIMER(_parent->_build_hash_table_timer);
+    PartitionedHashTableCtx* ctx = _parent->_ht_ctx.get();
+    RowBatch batch(_parent->child(1)->row_desc(), state->batch_size(),
+            _parent->mem_tracker());
+    vector<BufferedTupleStream2::RowIdx> indices;
+
+    // The number of the build rows is known here, assuming there are no duplicates.
+    const int64_t max_num_buckets = 1L << (32 - NUM_PARTITIONING_BITS);
+    const int64_t estimated_num_buckets = std::min(max_num_buckets,
+            PartitionedHashTable::EstimateNumBuckets(_build_rows->num_rows()));
+    _hash_tbl.reset(PartitionedHashTable::create(state, _parent->_block_mgr_client,
+            _parent->child(1)->row_desc().tuple_descriptors().size(), _build_rows,
+            max_num_buckets, estimated_num_buckets));
+
+    bool eos = false;
+    *built = _hash_tbl->init();
+    while (*built && !eos) {
+        RETURN_IF_ERROR(_build_rows->get_next(&batch, &eos, &indices));
+        DCHECK_EQ(batch.num_rows(), indices.size());
+        if (!_hash_tbl->check_and_resize(batch.num_rows(), ctx)) {
+            *built = false;
+            break;
+        }
+        for (int i = 0; i < batch.num_rows(); ++i) {
+            TupleRow* row = batch.get_row(i);
+            uint32_t hash = 0;
+            if (!ctx->eval_and_hash_build(row, &hash)) {
+                continue;
+            }
+            if (UNLIKELY(!_hash_tbl->insert(ctx, indices[i], row, hash))) {
+                *built = false;
+                break;
+            }
+        }
+        RETURN_IF_ERROR(state->query_status());
+        batch.reset();
+    }
+
+    if (!*built) {
+        _hash_tbl->close();
+        _hash_tbl.reset();
+        return Status::OK;
+    }
+    // The hash table fits in memory and is built.
+    _is_spilled = false;
+    COUNTER_UPDATE(_parent->_num_hash_buckets, _hash_tbl->num_buckets());
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::Partition::spill(bool unpin_all_build) {
+    DCHECK(!is_closed());
+    // Close the hash table as soon as possible to release memory.
+    if (_hash_tbl.get() != NULL) {
+        _hash_tbl->close();
+        _hash_tbl.reset();
+    }
+
+    bool got_buffer = true;
+    if (_build_rows->using_small_buffers()) {
+        RETURN_IF_ERROR(_build_rows->switch_to_io_buffers(&got_buffer));
+    }
+    // Unpin the stream as soon as possible to increase the chances that the
+    // switch_to_io_buffers() call below will succeed.
+    RETURN_IF_ERROR(_build_rows->unpin_stream(unpin_all_build));
+
+    if (got_buffer && _probe_rows->using_small_buffers()) {
+        RETURN_IF_ERROR(_probe_rows->switch_to_io_buffers(&got_buffer));
+    }
+    if (!got_buffer) {
+        // We'll try again to get the buffers when the stream fills up the small buffers.
+        VLOG_QUERY << "Not enough memory to switch to IO-sized buffer for partition "
+                << this << " of join=" << _parent->id() << " build small buffers="
+                << _build_rows->using_small_buffers() << " probe small buffers="
+                << _probe_rows->using_small_buffers();
+    }
+
+    if (!_is_spilled) {
+        COUNTER_UPDATE(_parent->_num_spilled_partitions, 1);
+        if (_parent->_num_spilled_partitions->value() == 1) {
+            _parent->add_runtime_exec_option("Spilled");
+        }
+    }
+    _is_spilled = true;
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::construct_build_side(RuntimeState* state) {
+    RETURN_IF_ERROR(child(1)->open(state));
+    SCOPED_TIMER(_build_timer);
+    update_state(PARTITIONING_BUILD);
+    RETURN_IF_ERROR(process_build_input(state, 0));
+    update_state(PROCESSING_PROBE);
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::process_build_input(RuntimeState* state, int level) {
+    if (level >= MAX_PARTITION_DEPTH) {
+        stringstream error_msg;
+        error_msg << "Cannot perform hash join at node with id " << _id << '.'
+                << " The input data was partitioned the maximum number of "
+                << MAX_PARTITION_DEPTH << " times."
+                << " This could mean there is significant skew in the data or the memory limit is"
+                << " set too low.";
+        return _state->set_mem_limit_exceeded(error_msg.str());
+    }
+
+    DCHECK(_hash_partitions.empty());
+    if (_input_partition != NULL) {
+        DCHECK(_input_partition->build_rows() != NULL);
+        bool got_read_buffer = true;
+        RETURN_IF_ERROR(_input_partition->build_rows()->prepare_for_read(
+                true, &got_read_buffer));
+        if (!got_read_buffer) {
+            return state->block_mgr2()->mem_limit_too_low_error(_block_mgr_client, id());
+        }
+    }
+
+    for (int i = 0; i < PARTITION_FANOUT; ++i) {
+        Partition* new_partition = new Partition(state, this, level);
+        _hash_partitions.push_back(_partition_pool->add(new_partition));
+        RETURN_IF_ERROR(new_partition->build_rows()->init(id(), runtime_profile(), true));
+        // Initialize a buffer for the probe here to make sure we have it if we need it.
+        RETURN_IF_ERROR(new_partition->probe_rows()->init(id(), runtime_profile(), false));
+    }
+    COUNTER_UPDATE(_partitions_created, PARTITION_FANOUT);
+    _ht_ctx->set_level(level);
+
+    RowBatch build_batch(child(1)->row_desc(), state->batch_size(), mem_tracker());
+    bool eos = false;
+    while (!eos) {
+        RETURN_IF_CANCELLED(state);
+        RETURN_IF_ERROR(state->check_query_state());
+        RETURN_IF_ERROR(spill_if_requested());
+        if (_input_partition == NULL) {
+            RETURN_IF_ERROR(child(1)->get_next(state, &build_batch, &eos));
+            COUNTER_UPDATE(_build_row_counter, build_batch.num_rows());
+        } else {
+            RETURN_IF_ERROR(_input_partition->build_rows()->get_next(&build_batch, &eos));
+        }
+        SCOPED_TIMER(_partition_build_timer);
+        RETURN_IF_ERROR(process_build_batch(&build_batch));
+        COUNTER_UPDATE(_num_build_rows_partitioned, build_batch.num_rows());
+        build_batch.reset();
+    }
+
+    RETURN_IF_ERROR(build_hash_tables(state));
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::process_build_batch(RowBatch* build_batch) {
+    for (int i = 0; i < build_batch->num_rows(); ++i) {
+        TupleRow* build_row = build_batch->get_row(i);
+        uint32_t hash = 0;
+        if (!_ht_ctx->eval_and_hash_build(build_row, &hash)) {
+            // NULL的连接键永远不会匹配, 而且不需要输出
+            continue;
+        }
+        const uint32_t partition_idx = hash >> (32 - NUM_PARTITIONING_BITS);
+        RETURN_IF_ERROR(append_build_row(
+                _hash_partitions[partition_idx]->build_rows(), build_row));
+    }
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::append_build_row(BufferedTupleStream2* stream, TupleRow* row) {
+    Status status = Status::OK;
+    if (LIKELY(stream->add_row(row, &status))) {
+        return Status::OK;
+    }
+    RETURN_IF_ERROR(status);
+    while (true) {
+        // Check if the stream is still using small buffers and try to switch to
+        // IO-buffers.
+        if (stream->using_small_buffers()) {
+            bool got_buffer = false;
+            RETURN_IF_ERROR(stream->switch_to_io_buffers(&got_buffer));
+            if (got_buffer) {
+                if (LIKELY(stream->add_row(row, &status))) {
+                    return Status::OK;
+                }
+                RETURN_IF_ERROR(status);
+            }
+        }
+        // We ran out of memory. Pick a partition to spill. If we ran out of unspilled
+        // partitions, spill_partition() will return an error status.
+        RETURN_IF_ERROR(spill_partition());
+        if (stream->add_row(row, &status)) {
+            return Status::OK;
+        }
+        RETURN_IF_ERROR(status);
+    }
+}
+
+Status PartitionedHashJoinNode::append_probe_row(BufferedTupleStream2* stream, TupleRow* row) {
+    DCHECK(!stream->is_pinned());
+    Status status = Status::OK;
+    if (LIKELY(stream->add_row(row, &status))) {
+        return Status::OK;
+    }
+    RETURN_IF_ERROR(status);
+    if (stream->using_small_buffers()) {
+        bool got_buffer = false;
+        RETURN_IF_ERROR(stream->switch_to_io_buffers(&got_buffer));
+        if (got_buffer) {
+            if (LIKELY(stream->add_row(row, &status))) {
+                return Status::OK;
+            }
+            RETURN_IF_ERROR(status);
+        }
+    }
+    // The hash tables are being probed and can't be spilled any more.
+    return _state->block_mgr2()->mem_limit_too_low_error(_block_mgr_client, id());
+}
+
+Status PartitionedHashJoinNode::spill_partition() {
+    int64_t max_freed_mem = 0;
+    int partition_idx = -1;
+
+    // Iterate over the partitions and pick the largest partition to spill.
+    for (int i = 0; i < _hash_partitions.size(); ++i) {
+        Partition* candidate = _hash_partitions[i];
+        if (candidate->is_closed() || candidate->is_spilled()) {
+            continue;
+        }
+        int64_t mem = candidate->build_rows()->bytes_in_mem(false);
+        if (candidate->hash_tbl() != NULL) {
+            mem += candidate->hash_tbl()->byte_size();
+        }
+        if (mem > max_freed_mem) {
+            max_freed_mem = mem;
+            partition_idx = i;
+        }
+    }
+
+    if (partition_idx == -1) {
+        // Could not find a partition to spill. This means the mem limit was just too low.
+        return _state->block_mgr2()->mem_limit_too_low_error(_block_mgr_client, id());
+    }
+
+    VLOG(2) << "Spilling partition: " << partition_idx << std::endl << node_debug_string();
+    ScopedTraceSpan span(_state->query_trace(), "spill", "spill_join_partition");
+    if (span.enabled()) {
+        span.set_detail("node_id=" + std::to_string(id())
+                + " partition=" + std::to_string(partition_idx)
+                + " bytes=" + std::to_string(max_freed_mem));
+    }
+    RETURN_IF_ERROR(_hash_partitions[partition_idx]->spill(false));
+    _hash_tbls[partition_idx] = NULL;
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::spill_if_requested() {
+    if (_spill_request_generation < 0
+            || !_state->mem_arbitrator()->spill_requested(&_spill_request_generation)) {
+        return Status::OK;
+    }
+    for (int i = 0; i < _hash_partitions.size(); ++i) {
+        if (!_hash_partitions[i]->is_closed() && !_hash_partitions[i]->is_spilled()) {
+            return spill_partition();
+        }
+    }
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::build_hash_tables(RuntimeState* state) {
+    DCHECK_EQ(_hash_partitions.size(), PARTITION_FANOUT);
+
+    // First loop over the partitions and close or unpin the ones that won't build a
+    // hash table, to release the memory for the others.
+    for (int i = 0; i < _hash_partitions.size(); ++i) {
+        Partition* partition = _hash_partitions[i];
+        if (partition->build_rows()->num_rows() == 0) {
+            // This partition is empty, no need to do anything else.
+            partition->close(NULL);
+            continue;
+        }
+        if (partition->is_spilled()) {
+            // We don't need any build-side data for spilled partitions in memory.
+            RETURN_IF_ERROR(partition->build_rows()->unpin_stream(true));
+        }
+    }
+
+    for (int i = 0; i < _hash_partitions.size(); ++i) {
+        Partition* partition = _hash_partitions[i];
+        if (partition->is_closed() || partition->is_spilled()) {
+            continue;
+        }
+        bool built = false;
+        RETURN_IF_ERROR(partition->build_hash_table(state, &built));
+        if (!built) {
+            RETURN_IF_ERROR(partition->spill(true));
+        }
+    }
+
+    // Closed and spilled partitions have no hash table.
+    for (int i = 0; i < _hash_partitions.size(); ++i) {
+        _hash_tbls[i] = _hash_partitions[i]->hash_tbl();
+    }
+    return Status::OK;
+}
+
+void PartitionedHashJoinNode::init_get_next(TupleRow* first_left_child_row) {
+    // BlockingJoinNode::open() has consumed the first row of _left_batch, start the
+    // probe from the beginning of the batch.
+    reset_for_probe();
+    if (first_left_child_row == NULL) {
+        // The probe side is empty, but the unmatched build rows may still be output.
+        _left_batch_pos = -1;
+    }
+}
+
+void PartitionedHashJoinNode::reset_for_probe() {
+    _left_batch_pos = 0;
+    _current_left_child_row = NULL;
+    _matched_probe = true;
+    _hash_tbl_iterator.set_at_end();
+}
+
+Status PartitionedHashJoinNode::process_probe_batch(RowBatch* out_batch) {
+    SCOPED_TIMER(_probe_timer);
+    ExprContext* const* other_conjunct_ctxs = &_other_join_conjunct_ctxs[0];
+    const int num_other_conjunct_ctxs = _other_join_conjunct_ctxs.size();
+    ExprContext* const* conjunct_ctxs = &_conjunct_ctxs[0];
+    const int num_conjunct_ctxs = _conjunct_ctxs.size();
+
+    while (!out_batch->at_capacity() && !reached_limit()) {
+        if (_current_left_child_row == NULL) {
+            if (_left_batch_pos >= _left_batch->num_rows()) {
+                // The probe batch is consumed.
+                return Status::OK;
+            }
+            _current_left_child_row = _left_batch->get_row(_left_batch_pos++);
+            _matched_probe = false;
+
+            uint32_t hash = 0;
+            if (!_ht_ctx->eval_and_hash_probe(_current_left_child_row, &hash)) {
+                // NULL的连接键不会有匹配
+                _hash_tbl_iterator.set_at_end();
+            } else {
+                const uint32_t partition_idx = hash >> (32 - NUM_PARTITIONING_BITS);
+                PartitionedHashTable* hash_tbl = _hash_tbls[partition_idx];
+                if (hash_tbl != NULL) {
+                    _hash_tbl_iterator = hash_tbl->find(_ht_ctx.get(), hash);
+                } else {
+                    _hash_tbl_iterator.set_at_end();
+                    if (_hash_join_state != PROBING_SPILLED_PARTITION
+                            && !_hash_partitions[partition_idx]->is_closed()) {
+                        // The build rows of this partition are spilled, keep the probe
+                        // row to join it later.
+                        Partition* partition = _hash_partitions[partition_idx];
+                        DCHECK(partition->is_spilled());
+                        RETURN_IF_ERROR(append_probe_row(
+                                partition->probe_rows(), _current_left_child_row));
+                        _current_left_child_row = NULL;
+                        continue;
+                    }
+                    // Otherwise the build side of this partition is empty.
+                }
+            }
+        }
+
+        TupleRow* out_row = out_batch->get_row(out_batch->add_row());
+        while (!_hash_tbl_iterator.at_end()) {
+            TupleRow* matched_build_row = _hash_tbl_iterator.get_row();
+            create_output_row(out_row, _current_left_child_row, matched_build_row);
+            if (!eval_conjuncts(other_conjunct_ctxs, num_other_conjunct_ctxs, out_row)) {
+                _hash_tbl_iterator.next();
+                continue;
+            }
+            _matched_probe = true;
+
+            if (_join_op == TJoinOp::LEFT_ANTI_JOIN) {
+                // Only whether there is a match matters.
+                _hash_tbl_iterator.set_at_end();
+                break;
+            }
+            if (_join_op == TJoinOp::RIGHT_SEMI_JOIN || _join_op == TJoinOp::RIGHT_ANTI_JOIN) {
+                // Each build row is output at most once.
+                const bool matched_before = _hash_tbl_iterator.is_matched();
+                _hash_tbl_iterator.set_matched();
+                if (matched_before || _join_op == TJoinOp::RIGHT_ANTI_JOIN) {
+                    _hash_tbl_iterator.next();
+                    continue;
+                }
+            } else if (need_to_process_unmatched_build_rows()) {
+                _hash_tbl_iterator.set_matched();
+            }
+
+            if (_join_op == TJoinOp::LEFT_SEMI_JOIN) {
+                _hash_tbl_iterator.set_at_end();
+            } else {
+                _hash_tbl_iterator.next();
+            }
+            if (eval_conjuncts(conjunct_ctxs, num_conjunct_ctxs, out_row)) {
+                out_batch->commit_last_row();
+                ++_num_rows_returned;
+                if (out_batch->at_capacity() || reached_limit()) {
+                    // Continue with the remaining matches in the next call.
+                    return Status::OK;
+                }
+                out_row = out_batch->get_row(out_batch->add_row());
+            }
+        }
+
+        if (!_matched_probe && need_to_output_unmatched_probe_rows()) {
+            create_output_row(out_row, _current_left_child_row, NULL);
+            if (eval_conjuncts(conjunct_ctxs, num_conjunct_ctxs, out_row)) {
+                out_batch->commit_last_row();
+                ++_num_rows_returned;
+            }
+        }
+        _matched_probe = true;
+        _current_left_child_row = NULL;
+    }
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::next_probe_row_batch(RuntimeState* state, RowBatch* out_batch) {
+    while (true) {
+        // Loop until we find a non-empty row batch.
+        _left_batch->transfer_resource_ownership(out_batch);
+        if (out_batch->at_capacity()) {
+            // This out batch is full. Need to return it before getting the next batch.
+            _left_batch_pos = -1;
+            return Status::OK;
+        }
+        if (_left_side_eos) {
+            _current_left_child_row = NULL;
+            _left_batch_pos = -1;
+            return Status::OK;
+        }
+        SCOPED_TIMER(_left_child_timer);
+        RETURN_IF_ERROR(child(0)->get_next(state, _left_batch.get(), &_left_side_eos));
+        COUNTER_UPDATE(_left_child_row_counter, _left_batch->num_rows());
+        if (_left_batch->num_rows() > 0) {
+            break;
+        }
+    }
+    reset_for_probe();
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::next_spilled_probe_row_batch(
+        RuntimeState* state, RowBatch* out_batch) {
+    DCHECK(_input_partition != NULL);
+    _left_batch->transfer_resource_ownership(out_batch);
+    if (out_batch->at_capacity()) {
+        // The out_batch has resources associated with it that will be recycled on the
+        // next call to get_next() on the out_batch.
+        _left_batch_pos = -1;
+        return Status::OK;
+    }
+
+    BufferedTupleStream2* probe_rows = _input_partition->probe_rows();
+    if (LIKELY(probe_rows->rows_returned() < probe_rows->num_rows())) {
+        // Common case
+        bool eos = false;
+        RETURN_IF_ERROR(probe_rows->get_next(_left_batch.get(), &eos));
+        DCHECK_GT(_left_batch->num_rows(), 0);
+        reset_for_probe();
+        return Status::OK;
+    }
+
+    // Done with this partition.
+    if (_hash_join_state == PROBING_SPILLED_PARTITION
+            && need_to_process_unmatched_build_rows()) {
+        // The unmatched build rows of this partition are output before moving on to the
+        // next partition.
+        DCHECK(_output_build_partitions.empty());
+        DCHECK(_input_partition->hash_tbl() != NULL);
+        _hash_tbl_iterator = first_unmatched_build(_input_partition);
+        _output_build_partitions.push_back(_input_partition);
+    } else {
+        // In any other case, just close the input partition.
+        _input_partition->close(out_batch);
+    }
+    _input_partition = NULL;
+    _current_left_child_row = NULL;
+    _left_batch_pos = -1;
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::clean_up_hash_partitions(RowBatch* batch) {
+    DCHECK_EQ(_left_batch_pos, -1);
+    // At this point all the rows have been read from the probe side for all partitions in
+    // _hash_partitions.
+    VLOG(2) << "Probe Side Consumed" << std::endl << node_debug_string();
+
+    // Walk the partitions that had hash tables built for the probe phase and close them.
+    // In the case of right outer and full outer joins, instead of closing those
+    // partitions, add them to the list of partitions that need to output any unmatched
+    // build rows. Any partition that did not have a hash table built is spilled and
+    // still needs processing.
+    for (int i = 0; i < _hash_partitions.size(); ++i) {
+        Partition* partition = _hash_partitions[i];
+        if (partition->is_closed()) {
+            continue;
+        }
+        if (partition->is_spilled()) {
+            DCHECK(partition->hash_tbl() == NULL) << node_debug_string();
+            if (partition->probe_rows()->num_rows() == 0
+                    && !need_to_process_unmatched_build_rows()) {
+                // No probe row can match the spilled build rows.
+                partition->close(NULL);
+                continue;
+            }
+            // Unpin the build and probe stream to free up more memory. We need to free all
+            // memory so we can recurse the algorithm and create new hash partitions from
+            // spilled partitions.
+            RETURN_IF_ERROR(partition->build_rows()->unpin_stream(true));
+            RETURN_IF_ERROR(partition->probe_rows()->unpin_stream(true));
+
+            // Push new created partitions at the front. This means a depth first walk
+            // (more finely partitioned partitions are processed first). This allows us
+            // to delete blocks earlier and bottom out the recursion earlier.
+            _spilled_partitions.push_front(partition);
+        } else {
+            DCHECK_EQ(partition->probe_rows()->num_rows(), 0)
+                << "No probe rows should have been spilled for this partition.";
+            if (need_to_process_unmatched_build_rows()) {
+                if (_output_build_partitions.empty()) {
+                    _hash_tbl_iterator = first_unmatched_build(partition);
+                }
+                _output_build_partitions.push_back(partition);
+            } else {
+                partition->close(batch);
+            }
+        }
+    }
+    _hash_partitions.clear();
+    memset(_hash_tbls, 0, sizeof(_hash_tbls));
+    _input_partition = NULL;
+    return Status::OK;
+}
+
+Status PartitionedHashJoinNode::prepare_next_partition(RuntimeState* state) {
+    DCHECK(_input_partition == NULL);
+    if (_spilled_partitions.empty()) {
+        return Status::OK;
+    }
+    VLOG(2) << "prepare_next_partition" << std::endl << node_debug_string();
+
+    _input_partition = _spilled_partitions.front();
+    _spilled_partitions.pop_front();
+    DCHECK(_input_partition->is_spilled());
+
+    // Reserve one buffer to read the probe side.
+    bool got_read_buffer = true;
+    RETURN_IF_ERROR(_input_partition->probe_rows()->prepare_for_read(true, &got_read_buffer));
+    if (!got_read_buffer) {
+        return state->block_mgr2()->mem_limit_too_low_error(_block_mgr_client, id());
+    }
+    _ht_ctx->set_level(_input_partition->level());
+
+    // Try to build a hash table on top the spilled build rows.
+    bool built = false;
+    const int64_t mem_limit = mem_tracker()->spare_capacity();
+    const int64_t estimated_memory = _input_partition->estimated_in_mem_size();
+    if (estimated_memory < mem_limit) {
+        RETURN_IF_ERROR(_input_partition->build_hash_table(state, &built));
+    } else {
+        VLOG_QUERY << "In hash join id=" << _id << " the estimated needed memory ("
+                << estimated_memory << ") for partition " << _input_partition << " with "
+                << _input_partition->build_rows()->num_rows() << " build rows is larger "
+                << " than the mem_limit (" << mem_limit << ").";
+    }
+
+    if (!built) {
+        // This partition did not fit in memory. Repartition the build rows, and then
+        // the probe rows while probing the new partitions.
+        update_state(REPARTITIONING);
+        const int64_t num_input_rows = _input_partition->build_rows()->num_rows();
+        // The probe stream is being read, only the build stream may be pinned here.
+        RETURN_IF_ERROR(_input_partition->build_rows()->unpin_stream(true));
+        RETURN_IF_ERROR(process_build_input(state, _input_partition->level() + 1));
+        COUNTER_UPDATE(_num_repartitions, 1);
+
+        // Check if there was any reduction in the size of partitions after repartitioning.
+        const int64_t largest_partition = largest_spilled_partition();
+        DCHECK_GE(num_input_rows, largest_partition) << "Cannot have a partition with "
+            "more rows than the input";
+        if (num_input_rows == largest_partition) {
+            Status status = Status::MEM_LIMIT_EXCEEDED;
+            stringstream error_msg;
+            error_msg << "Cannot perform hash join at node with id " << _id << ". "
+                    << "Repartitioning did not reduce the size of a spilled partition. "
+                    << "Repartitioning level " << _input_partition->level() + 1
+                    << ". Number of rows " << num_input_rows << " .";
+            status.add_error_msg(error_msg.str());
+            return status;
+        }
+    } else {
+        DCHECK(_hash_partitions.empty());
+        DCHECK(!_input_partition->is_spilled());
+        DCHECK(_input_partition->hash_tbl() != NULL);
+        // In this case, we did not have to partition the build again, we just built
+        // a hash table. This means the probe does not have to be partitioned either.
+        for (int i = 0; i < PARTITION_FANOUT; ++i) {
+            _hash_tbls[i] = _input_partition->hash_tbl();
+        }
+        update_state(PROBING_SPILLED_PARTITION);
+    }
+
+    COUNTER_UPDATE(_num_probe_rows_partitioned, _input_partition->probe_rows()->num_rows());
+    return Status::OK;
+}
+
+int64_t PartitionedHashJoinNode::largest_spilled_partition() const {
+    int64_t max_rows = 0;
+    for (int i = 0; i < _hash_partitions.size(); ++i) {
+        Partition* partition = _hash_partitions[i];
+        if (partition->is_closed() || !partition->is_spilled()) {
+            continue;
+        }
+        int64_t rows = partition->build_rows()->num_rows();
+        rows += partition->probe_rows()->num_rows();
+        if (rows > max_rows) {
+            max_rows = rows;
+        }
+    }
+    return max_rows;
+}
+
+PartitionedHashTable::Iterator PartitionedHashJoinNode::first_unmatched_build(
+        Partition* partition) {
+    PartitionedHashTable::Iterator iterator;
+    // first_unmatched() can't be used on an empty hash table.
+    if (partition->hash_tbl()->size() > 0) {
+        iterator = partition->hash_tbl()->first_unmatched(_ht_ctx.get());
+    }
+    return iterator;
+}
+
+void PartitionedHashJoinNode::output_unmatched_build(RowBatch* out_batch) {
+    SCOPED_TIMER(_probe_timer);
+    ExprContext* const* conjunct_ctxs = &_conjunct_ctxs[0];
+    const int num_conjunct_ctxs = _conjunct_ctxs.size();
+
+    while (!out_batch->at_capacity() && !reached_limit() && !_hash_tbl_iterator.at_end()) {
+        // Output remaining unmatched build rows.
+        if (!_hash_tbl_iterator.is_matched()) {
+            TupleRow* build_row = _hash_tbl_iterator.get_row();
+            DCHECK(build_row != NULL);
+            TupleRow* out_row = out_batch->get_row(out_batch->add_row());
+            create_output_row(out_row, NULL, build_row);
+            if (eval_conjuncts(conjunct_ctxs, num_conjunct_ctxs, out_row)) {
+                out_batch->commit_last_row();
+                ++_num_rows_returned;
+            }
+            _hash_tbl_iterator.set_matched();
+        }
+        // Move to the next unmatched entry.
+        _hash_tbl_iterator.next_unmatched();
+    }
+
+    if (_hash_tbl_iterator.at_end()) {
+        // Move to the next partition to output unmatched rows.
+        _output_build_partitions.front()->close(out_batch);
+        _output_build_partitions.pop_front();
+        if (!_output_build_partitions.empty()) {
+            _hash_tbl_iterator = first_unmatched_build(_output_build_partitions.front());
+        }
+    }
+}
+
+Status PartitionedHashJoinNode::get_next(RuntimeState* state, RowBatch* out_batch, bool* eos) {
+    SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
+    RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
+    if (reached_limit()) {
+        *eos = true;
+        return Status::OK;
+    }
+    *eos = false;
+
+    while (true) {
+        DCHECK_NE(_hash_join_state, PARTITIONING_BUILD) << "Should not be in get_next()";
+        RETURN_IF_CANCELLED(state);
+        RETURN_IF_ERROR(state->check_query_state());
+
+        if (!_output_build_partitions.empty()) {
+            // In case of right-outer, right-anti and full-outer joins, flush the remaining
+            // unmatched build rows of any partition we are done processing, before
+            // processing the next batch.
+            output_unmatched_build(out_batch);
+            if (!_output_build_partitions.empty() || reached_limit()) {
+                break;
+            }
+
+            // Finished to output unmatched build rows, move to next partition.
+            DCHECK(_hash_partitions.empty());
+            RETURN_IF_ERROR(prepare_next_partition(state));
+            if (_input_partition == NULL) {
+                *eos = true;
+                break;
+            }
+            if (out_batch->at_capacity()) {
+                break;
+            }
+        }
+
+        // Finish up the current batch.
+        if (_left_batch_pos != -1) {
+            RETURN_IF_ERROR(process_probe_batch(out_batch));
+            if (out_batch->at_capacity() || reached_limit()) {
+                break;
+            }
+            DCHECK(_current_left_child_row == NULL);
+        }
+
+        // Try to continue from the current probe side input.
+        if (_input_partition == NULL) {
+            RETURN_IF_ERROR(next_probe_row_batch(state, out_batch));
+        } else {
+            // The probe stream recycles the rows of its last batch in the next read, so
+            // the output rows pointing to them are returned first.
+            if (out_batch->num_rows() > 0) {
+                break;
+            }
+            RETURN_IF_ERROR(next_spilled_probe_row_batch(state, out_batch));
+        }
+
+        // We want to return as soon as we have attached a tuple stream to the out_batch
+        // (before preparing a new partition). The attached tuple stream will be recycled
+        // by the caller, freeing up more memory when we prepare the next partition.
+        if (out_batch->at_capacity()) {
+            break;
+        }
+
+        // Got a batch, just keep going.
+        if (_left_batch_pos == 0) {
+            continue;
+        }
+        DCHECK_EQ(_left_batch_pos, -1);
+
+        // The unmatched build rows of the spilled partition are output first.
+        if (!_output_build_partitions.empty()) {
+            continue;
+        }
+
+        // Finished up all probe rows for _hash_partitions.
+        RETURN_IF_ERROR(clean_up_hash_partitions(out_batch));
+        if (out_batch->at_capacity()) {
+            break;
+        }
+
+        // Move onto the next partition.
+        RETURN_IF_ERROR(prepare_next_partition(state));
+        if (_input_partition == NULL) {
+            if (_output_build_partitions.empty()) {
+                *eos = true;
+                break;
+            }
+            // The unmatched build rows of the last partitions are output at the top of
+            // the loop.
+            continue;
+        }
+    }
+
+    COUNTER_SET(_rows_returned_counter, _num_rows_returned);
+    return Status::OK;
+}
+
+void PartitionedHashJoinNode::add_to_debug_string(
+        int indentation_level, stringstream* out) const {
+    *out << " hash_join_state=" << print_state();
+    *out << " hash_partitions=" << _hash_partitions.size();
+    *out << " spilled_partitions=" << _spilled_partitions.size();
+    *out << " output_build_partitions=" << _output_build_partitions.size();
+}
+
+string PartitionedHashJoinNode::print_state() const {
+    switch (_hash_join_state) {
+    case PARTITIONING_BUILD:
+        return "PartitioningBuild";
+    case PROCESSING_PROBE:
+        return "ProcessingProbe";
+    case PROBING_SPILLED_PARTITION:
+        return "ProbingSpilledPartitions";
+    case REPARTITIONING:
+        return "Repartitioning";
+    default:
+        DCHECK(false);
+    }
+    return "";
+}
+
+void PartitionedHashJoinNode::update_state(HashJoinState s) {
+    _hash_join_state = s;
+    VLOG(2) << "Transitioned State:" << std::endl << node_debug_string();
+}
+
+string PartitionedHashJoinNode::node_debug_string() const {
+    stringstream ss;
+    ss << "PartitionedHashJoinNode (id=" << id() << " op=" << _join_op
+        << " state=" << print_state()
+        << " #partitions=" << _hash_partitions.size()
+        << " #spilled_partitions=" << _spilled_partitions.size()
+        << ")" << std::endl;
+
+    for (int i = 0; i < _hash_partitions.size(); ++i) {
+        Partition* partition = _hash_partitions[i];
+        ss << i << ": ptr=" << partition;
+        if (partition->is_closed()) {
+            ss << " Closed" << std::endl;
+            continue;
+        }
+        if (partition->is_spilled()) {
+            ss << " Spilled" << std::endl;
+        }
+        ss << "    Build Rows: " << partition->build_rows()->num_rows()
+            << " (Blocks pinned: " << partition->build_rows()->is_pinned() << ")"
+            << std::endl;
+        ss << "    Probe Rows: " << partition->probe_rows()->num_rows()
+            << " (Blocks pinned: " << partition->probe_rows()->is_pinned() << ")"
+            << std::endl;
+        if (partition->hash_tbl() != NULL) {
+            ss << "    Hash Table Rows: " << partition->hash_tbl()->size() << std::endl;
+        }
+    }
+    return ss.str();
+}
+
+} // namespace palo
@@ -0,0 +1,393 @@
+// Modifications copyright (C) 2017, Baidu.com, Inc.
+// Copyright 2017 The Apache Software Foundation
+
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_EXEC_PARTITIONED_HASH_JOIN_NODE_H
+#define BDG_PALO_BE_SRC_EXEC_PARTITIONED_HASH_JOIN_NODE_H
+
+#include <list>
+#include <boost/scoped_ptr.hpp>
+
+#include "exec/blocking_join_node.h"
+#include "exec/partitioned_hash_table.inline.h"
+#include "runtime/buffered_block_mgr2.h"
+#include "runtime/buffered_tuple_stream2.h"
+#include "gen_cpp/PlanNodes_types.h"
+
+namespace palo {
+
+class ExprContext;
+class RowBatch;
+class RuntimeState;
+class TupleRow;
+
+// Operator to perform partitioned hash join, spilling to disk as necessary.
+// A spilled partition is one that is not fully pinned.
+// The operator runs in these distinct phases:
+//  1. Consume all build input and partition them. No hash tables are maintained.
+//  2. Construct hash tables from as many partitions as possible.
+//  3. Consume all the probe rows. Rows belonging to partitions that are spilled
+//     must be spilled as well.
+//  4. Iterate over the spilled partitions, construct the hash table from the spilled
+//     build rows and process the spilled probe rows. If the partition is still too
+//     big, repeat steps 1-4, using this spilled partitions build and probe rows as
+//     input.
+//
+// The build and probe rows are kept in BufferedTupleStream2s which are backed by
+// the BufferedBlockMgr2 of the query, so the unpinned blocks are written to the
+// query_scratch_dirs under memory pressure.
+//
+// NULL_AWARE_LEFT_ANTI_JOIN is not supported, HashJoinNode is used for it.
+// TODO: codegen the build and probe loops.
+class PartitionedHashJoinNode : public BlockingJoinNode {
+public:
+    PartitionedHashJoinNode(ObjectPool* pool, const TPlanNode& tnode,
+            const DescriptorTbl& descs);
+    virtual ~PartitionedHashJoinNode();
+
+    virtual Status init(const TPlanNode& tnode);
+    virtual Status prepare(RuntimeState* state);
+    virtual Status open(RuntimeState* state);
+    virtual Status get_next(RuntimeState* state, RowBatch* out_batch, bool* eos);
+    virtual Status close(RuntimeState* state);
+
+private:
+    class Partition;
+
+    // Number of initial partitions to create. Must be a power of two.
+    static const int PARTITION_FANOUT = 16;
+
+    // Needs to be the log(PARTITION_FANOUT)
+    static const int NUM_PARTITIONING_BITS = 4;
+
+    // Maximum number of times we will repartition. The maximum build table we
+    // can process is:
+    // MEM_LIMIT * (PARTITION_FANOUT ^ MAX_PARTITION_DEPTH). With a (low) 1GB
+    // limit and 16 fanout, the build table can be as large as 2^64 bytes in the case where
+    // there is no skew.
+    // In the case where there is skew, repartitioning is unlikely to help (assuming a
+    // reasonable hash function).
+    // Note that we need to have at least as many SEED_PRIMES in PartitionedHashTableCtx.
+    static const int MAX_PARTITION_DEPTH = 16;
+
+    // State of the algorithm. Used just for debugging.
+    enum HashJoinState {
+        // Partitioning the build (right) child's input. Corresponds to mode 1 above but
+        // only when consuming from child(1).
+        PARTITIONING_BUILD,
+
+        // Processing the probe (left) child's input. Corresponds to mode 3 above but
+        // only when consuming from child(0).
+        PROCESSING_PROBE,
+
+        // Probing a spilled partition. The hash table for this partition fits in memory.
+        // Corresponds to mode 4.
+        PROBING_SPILLED_PARTITION,
+
+        // Repartitioning a spilled partition's input that did not fit in memory.
+        // Corresponds to mode 1 above but only when consuming from a spilled partition.
+        REPARTITIONING,
+    };
+
+    // Implementation details:
+    // Logically, the algorithm runs in three modes.
+    //   1. [PARTITIONING_BUILD or REPARTITIONING] Read the build side rows and partition
+    //      them into _hash_partitions. This is a fixed fan out of the input. The input
+    //      can either come from child(1) OR from the build tuple stream of partition
+    //      that needs to be repartitioned.
+    //   2. [PROCESSING_PROBE or REPARTITIONING] Read the probe side rows, partition them
+    //      and either perform the join or spill them into _hash_partitions. If the
+    //      partition has the hash table in memory, we perform the join, otherwise we
+    //      spill the probe row. Similar to step one, the rows can come from child(0) or
+    //      a spilled partition.
+    //   3. [PROBING_SPILLED_PARTITION] Read and construct a single spilled partition.
+    //      In this case we are walking a spilled partition and the hash table fits in
+    //      memory. Neither the build nor probe side need to be partitioned and we just
+    //      perform the join.
+    //
+    // States 1 and 2 are similar and consist of processing rows from either child(0) or
+    // a spilled partition. The spilled partition must contain all the rows that would
+    // go into the current level. To make the distinction clear, the
+    // build/probe_row_stream of the spilled partition is the input partition.
+    //
+    // In state 3 we do not repartition and the build and probe rows of the partition
+    // chosen are enough to produce the join output.
+    virtual Status construct_build_side(RuntimeState* state);
+
+    // Starts probing with the first batch of the left child, which is read by
+    // BlockingJoinNode::open().
+    virtual void init_get_next(TupleRow* first_left_child_row);
+
+    virtual void add_to_debug_string(int indentation_level, std::stringstream* out) const;
+
+    // Reads the build input, either from child(1) or from the build stream of
+    // _input_partition, partitions it into PARTITION_FANOUT new partitions of 'level'
+    // and builds the hash tables of the partitions which fit in memory.
+    Status process_build_input(RuntimeState* state, int level);
+
+    // Partitions a batch of build rows into _hash_partitions.
+    Status process_build_batch(RowBatch* build_batch);
+
+    // Builds the hash tables of the partitions in _hash_partitions, spilling the
+    // partitions whose hash table can not be built in memory.
+    Status build_hash_tables(RuntimeState* state);
+
+    // Appends 'row' to the build stream 'stream', switching it to IO-sized buffers or
+    // spilling partitions to get the memory.
+    Status append_build_row(BufferedTupleStream2* stream, TupleRow* row);
+
+    // Appends 'row' to the probe stream of a spilled partition. The probe streams
+    // own a reserved buffer so it won't spill any more partitions.
+    Status append_probe_row(BufferedTupleStream2* stream, TupleRow* row);
+
+    // Picks the largest partition which is in memory and spills it. Returns an error
+    // if all the partitions are spilled already.
+    Status spill_partition();
+
+    // Spills a partition while the build side is partitioned, if the memory arbitrator
+    // of the query requested it since the last call and not all partitions are spilled
+    // already.
+    Status spill_if_requested();
+
+    // Probes the rows of _left_batch from _left_batch_pos and adds the result rows to
+    // 'out_batch'. Probe rows of spilled partitions are appended to their probe
+    // streams. Returns when out_batch is full, the limit is reached or _left_batch is
+    // consumed.
+    Status process_probe_batch(RowBatch* out_batch);
+
+    // Reads the next non-empty batch of child(0) into _left_batch. _left_batch_pos is
+    // -1 if the probe side is exhausted.
+    Status next_probe_row_batch(RuntimeState* state, RowBatch* out_batch);
+
+    // Reads the next batch of the probe stream of _input_partition into _left_batch.
+    // _left_batch_pos is -1 if the probe stream is exhausted.
+    Status next_spilled_probe_row_batch(RuntimeState* state, RowBatch* out_batch);
+
+    // After all the probe rows of _hash_partitions are processed, moves the spilled
+    // partitions to _spilled_partitions and closes (or moves to
+    // _output_build_partitions) the in memory partitions.
+    Status clean_up_hash_partitions(RowBatch* batch);
+
+    // Moves to the next spilled partition, builds its hash table or repartitions it when
+    // it still does not fit in memory. _input_partition is NULL if there is no more
+    // spilled partition.
+    Status prepare_next_partition(RuntimeState* state);
+
+    // Outputs the unmatched build rows of the partitions in _output_build_partitions.
+    void output_unmatched_build(RowBatch* out_batch);
+
+    // Returns the iterator of the first unmatched build row of 'partition'.
+    PartitionedHashTable::Iterator first_unmatched_build(Partition* partition);
+
+    // Number of rows of the largest spilled partition in _hash_partitions.
+    int64_t largest_spilled_partition() const;
+
+    void reset_for_probe();
+
+    // Closes all the partitions. Used in close().
+    void close_partitions();
+
+    // Right outer, right anti and full outer joins output the unmatched build rows
+    // after the probe side is consumed.
+    bool need_to_process_unmatched_build_rows() const {
+        return _join_op == TJoinOp::RIGHT_ANTI_JOIN
+            || _join_op == TJoinOp::RIGHT_OUTER_JOIN
+            || _join_op == TJoinOp::FULL_OUTER_JOIN;
+    }
+
+    // Left outer, full outer and left anti joins output the unmatched probe rows.
+    bool need_to_output_unmatched_probe_rows() const {
+        return _join_op == TJoinOp::LEFT_OUTER_JOIN
+            || _join_op == TJoinOp::FULL_OUTER_JOIN
+            || _join_op == TJoinOp::LEFT_ANTI_JOIN;
+    }
+
+    int min_required_buffers() const {
+        // One build and one probe stream for each partition, and one more buffer to read
+        // the spilled partition.
+        return 2 * PARTITION_FANOUT + 1;
+    }
+
+    std::string print_state() const;
+
+    void update_state(HashJoinState s);
+
+    std::string node_debug_string() const;
+
+    RuntimeState* _state;
+
+    // our equi-join predicates "<lhs> = <rhs>" are separated into
+    // _build_expr_ctxs (over child(1)) and _probe_expr_ctxs (over child(0))
+    std::vector<ExprContext*> _build_expr_ctxs;
+    std::vector<ExprContext*> _probe_expr_ctxs;
+
+    // non-equi-join conjuncts from the JOIN clause
+    std::vector<ExprContext*> _other_join_conjunct_ctxs;
+
+    // Client to the buffered block mgr.
+    BufferedBlockMgr2::Client* _block_mgr_client;
+
+    // The last spill request of the memory arbitrator that was served, -1 if this node
+    // isn't registered as a spiller.
+    int64_t _spill_request_generation;
+
+    // Used for hash-related functionality, such as evaluating rows and calculating hashes.
+    boost::scoped_ptr<PartitionedHashTableCtx> _ht_ctx;
+
+    // The iterator that corresponds to the look up of _current_left_child_row.
+    PartitionedHashTable::Iterator _hash_tbl_iterator;
+
+    // Total time spent partitioning build.
+    RuntimeProfile::Counter* _partition_build_timer;
+
+    // Total number of hash buckets across all partitions.
+    RuntimeProfile::Counter* _num_hash_buckets;
+
+    // Total number of partitions created.
+    RuntimeProfile::Counter* _partitions_created;
+
+    // Number of build/probe rows that have been partitioned.
+    RuntimeProfile::Counter* _num_build_rows_partitioned;
+    RuntimeProfile::Counter* _num_probe_rows_partitioned;
+
+    // Number of partitions that have been repartitioned.
+    RuntimeProfile::Counter* _num_repartitions;
+
+    // Number of partitions that have been spilled.
+    RuntimeProfile::Counter* _num_spilled_partitions;
+
+    // Time spent building hash tables.
+    RuntimeProfile::Counter* _build_hash_table_timer;
+
+    // Time spent probing.
+    RuntimeProfile::Counter* _probe_timer;
+
+    HashJoinState _hash_join_state;
+
+    // Object pool that holds the Partition objects in _hash_partitions.
+    boost::scoped_ptr<ObjectPool> _partition_pool;
+
+    // The current set of partitions that are being built. This is only used in
+    // mode 1 and 2 when we need to partition the build and probe inputs.
+    // This is not used when processing a single partition.
+    std::vector<Partition*> _hash_partitions;
+
+    // Cache of the per partition hash table to speed up ProcessProbeBatch.
+    // In the case where we need to partition the probe:
+    //  _hash_tbls[i] = _hash_partitions[i]->hash_tbl();
+    // In the case where we don't need to partition the probe:
+    //  _hash_tbls[i] = _input_partition->hash_tbl();
+    PartitionedHashTable* _hash_tbls[PARTITION_FANOUT];
+
+    // The list of partitions that have been spilled on both sides and still need more
+    // processing. These partitions could need repartitioning, in which case more
+    // partitions will be added to this list after repartitioning.
+    // This list is populated at clean_up_hash_partitions().
+    std::list<Partition*> _spilled_partitions;
+
+    // The current input partition to be processed (not in _spilled_partitions).
+    // This partition can either serve as the source for a repartitioning step, or
+    // if the hash table fits in memory, the source of the probe rows.
+    Partition* _input_partition;
+
+    // In the case of right-outer and full-outer joins, this is the list of the partitions
+    // that we need to output their unmatched build rows. We always flush the unmatched
+    // rows of the partitions that are in the front.
+    std::list<Partition*> _output_build_partitions;
+
+    // if true, the current probe row has matched a build row (with the other join
+    // conjuncts)
+    bool _matched_probe;
+
+    class Partition {
+    public:
+        Partition(RuntimeState* state, PartitionedHashJoinNode* parent, int level);
+        ~Partition();
+
+        BufferedTupleStream2* build_rows() {
+            return _build_rows;
+        }
+        BufferedTupleStream2* probe_rows() {
+            return _probe_rows;
+        }
+        PartitionedHashTable* hash_tbl() const {
+            return _hash_tbl.get();
+        }
+
+        bool is_closed() const {
+            return _is_closed;
+        }
+        bool is_spilled() const {
+            return _is_spilled;
+        }
+        int level() const {
+            return _level;
+        }
+
+        // Must be called once per partition to release any resources. This should be
+        // called as soon as possible to release memory.
+        // If batch is non-null, the build stream is attached to the batch, transferring
+        // ownership to it, since the output rows may point to the build rows.
+        void close(RowBatch* batch);
+
+        // Returns the estimated size of the in memory size for the build side of this
+        // partition. This includes the entire build side and the hash table.
+        int64_t estimated_in_mem_size() const;
+
+        // Pins the build tuples for this partition and constructs the _hash_tbl from it.
+        // Build rows cannot be added after calling this.
+        // If the partition could not be built due to memory pressure, *built is set
+        // to false and the caller is responsible for spilling this partition.
+        Status build_hash_table(RuntimeState* state, bool* built);
+
+        // Spills this partition, cleaning up and unpinning blocks.
+        // If 'unpin_all_build' is true, the build stream is completely unpinned, otherwise,
+        // it is unpinned with one buffer remaining.
+        Status spill(bool unpin_all_build);
+
+    private:
+        PartitionedHashJoinNode* _parent;
+
+        // This partition is completely processed and nothing needs to be done for it
+        // again. All resources associated with this partition are returned.
+        bool _is_closed;
+
+        // True if this partition is spilled.
+        bool _is_spilled;
+
+        // How many times rows in this partition have been repartitioned. Partitions
+        // created from the node's children's input is level 0, 1 after the first
+        // repartitionining, etc.
+        int _level;
+
+        // The hash table for this partition.
+        boost::scoped_ptr<PartitionedHashTable> _hash_tbl;
+
+        // Stream of build/probe tuples in this partition. Initially owned by this
+        // object (meaning it has to call close() on it) but the build stream is
+        // transferred to the output row batch when the partition is complete.
+        // If NULL, ownership has been transfered.
+        BufferedTupleStream2* _build_rows;
+        BufferedTupleStream2* _probe_rows;
+    };
+};
+
+} // end namespace palo
+
+#endif // BDG_PALO_BE_SRC_EXEC_PARTITIONED_HASH_JOIN_NODE_H
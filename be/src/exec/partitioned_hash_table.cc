@@ -31,6 +31,7 @@
 #include "runtime/runtime_state.h"
 #include "runtime/string_value.hpp"
 #include "util/debug_util.h"
+#include "util/huge_page_allocator.h"
 #include "util/palo_metrics.h"
 
 // using namespace llvm;
@@ -55,6 +56,7 @@ using llvm::APFloat;
 namespace palo {
 
 const char* PartitionedHashTableCtx::_s_llvm_class_name = "class.palo::PartitionedHashTableCtx";
+const int PartitionedHashTableCtx::ROW_CACHE_SIZE;
 
 // Random primes to multiply the seed with.
 static uint32_t SEED_PRIMES[] = {
@@ -115,6 +117,7 @@ PartitionedHashTableCtx::PartitionedHashTableCtx(
     _expr_values_buffer = new uint8_t[_results_buffer_size];
     memset(_expr_values_buffer, 0, sizeof(uint8_t) * _results_buffer_size);
     _expr_value_null_bits = new uint8_t[build_expr_ctxs.size()];
+    _row_cache = new uint8_t[ROW_CACHE_SIZE * row_cache_bytes()];
 
     // Populate the seeds to use for all the levels. TODO: revisit how we generate these.
     DCHECK_GE(max_levels, 0);
@@ -135,6 +138,8 @@ void PartitionedHashTableCtx::close() {
     DCHECK(_expr_value_null_bits != NULL);
     delete[] _expr_value_null_bits;
     _expr_value_null_bits = NULL;
+    delete[] _row_cache;
+    _row_cache = NULL;
     free(_row);
     _row = NULL;
 }
@@ -264,7 +269,7 @@ bool PartitionedHashTable::init() {
         _num_buckets = 0;
         return false;
     }
-    _buckets = reinterpret_cast<Bucket*>(malloc(buckets_byte_size));
+    _buckets = reinterpret_cast<Bucket*>(HugePageAllocator::allocate(buckets_byte_size));
     memset(_buckets, 0, buckets_byte_size);
     return true;
 }
@@ -286,7 +291,7 @@ void PartitionedHashTable::close() {
     }
     _data_pages.clear();
     if (_buckets != NULL) {
-        free(_buckets);
+        HugePageAllocator::free(_buckets, _num_buckets * sizeof(Bucket));
     }
     _state->block_mgr2()->release_memory(_block_mgr_client, _num_buckets * sizeof(Bucket));
 }
@@ -331,7 +336,7 @@ bool PartitionedHashTable::resize_buckets(int64_t num_buckets, PartitionedHashTa
     if (!_state->block_mgr2()->consume_memory(_block_mgr_client, new_size)) {
         return false;
     }
-    Bucket* new_buckets = reinterpret_cast<Bucket*>(malloc(new_size));
+    Bucket* new_buckets = reinterpret_cast<Bucket*>(HugePageAllocator::allocate(new_size));
     DCHECK(new_buckets != NULL);
     memset(new_buckets, 0, new_size);
 
@@ -350,8 +355,8 @@ bool PartitionedHashTable::resize_buckets(int64_t num_buckets, PartitionedHashTa
         *dst_bucket = *bucket_to_copy;
     }
 
+    HugePageAllocator::free(_buckets, old_size);
     _num_buckets = num_buckets;
-    free(_buckets);
     _buckets = new_buckets;
     _state->block_mgr2()->release_memory(_block_mgr_client, old_size);
     return true;
@@ -159,6 +159,26 @@ public:
 
     int results_buffer_size() const { return _results_buffer_size; }
 
+    // Max number of rows whose evaluated values can be cached at the same time.
+    static const int ROW_CACHE_SIZE = 64;
+
+    // Batched lookups: the caller evaluates and hashes a group of rows first, saving
+    // the results of each row with cache_last_row(), and prefetches their buckets.
+    // Then it restores the results of each row with load_cached_row() before looking
+    // it up, so the cache misses of the lookups overlap.
+    void cache_last_row(int cache_idx) {
+        DCHECK_LT(cache_idx, ROW_CACHE_SIZE);
+        uint8_t* cache = _row_cache + cache_idx * row_cache_bytes();
+        memcpy(cache, _expr_values_buffer, _results_buffer_size);
+        memcpy(cache + _results_buffer_size, _expr_value_null_bits, _build_expr_ctxs.size());
+    }
+    void load_cached_row(int cache_idx) {
+        DCHECK_LT(cache_idx, ROW_CACHE_SIZE);
+        const uint8_t* cache = _row_cache + cache_idx * row_cache_bytes();
+        memcpy(_expr_values_buffer, cache, _results_buffer_size);
+        memcpy(_expr_value_null_bits, cache + _results_buffer_size, _build_expr_ctxs.size());
+    }
+
     // Codegen for evaluating a tuple row.  Codegen'd function matches the signature
     // for EvalBuildRow and EvalTupleRow.
     // If build_row is true, the codegen uses the build_exprs, otherwise the probe_exprs.
@@ -181,6 +201,10 @@ private:
     friend class PartitionedHashTable;
     friend class PartitionedHashTableTest_HashEmpty_Test;
 
+    int row_cache_bytes() const {
+        return _results_buffer_size + _build_expr_ctxs.size();
+    }
+
     // Compute the hash of the values in _expr_values_buffer.
     // This will be replaced by codegen.  We don't want this inlined for replacing
     // with codegen'd functions so the function name does not change.
@@ -200,12 +224,9 @@ private:
 
     // Wrapper function for calling correct HashUtil function in non-codegen'd case.
     uint32_t inline hash_help(const void* input, int len, int32_t hash) {
-        // Use CRC hash at first level for better performance. Switch to murmur hash at
-        // subsequent levels since CRC doesn't randomize well with different seed inputs.
-        if (_level == 0) {
-            return HashUtil::hash(input, len, hash);
-        }
-        return HashUtil::murmur_hash2_64(input, len, hash);
+        // fast_hash() gives unrelated hashes with the different seeds of the levels, so
+        // unlike CRC hash it can be used at every level.
+        return HashUtil::fast_hash(input, len, hash);
     }
 
     // Evaluate 'row' over build exprs caching the results in '_expr_values_buffer' This
@@ -275,6 +296,10 @@ private:
     // not change once allocated.
     uint8_t* _expr_value_null_bits;
 
+    // ROW_CACHE_SIZE saved copies of '_expr_values_buffer' and '_expr_value_null_bits',
+    // see cache_last_row().
+    uint8_t* _row_cache;
+
     // Scratch buffer to generate rows on the fly.
     TupleRow* _row;
 
@@ -435,6 +460,11 @@ public:
     // inserted without need to resize.
     bool check_and_resize(uint64_t buckets_to_fill, PartitionedHashTableCtx* ht_ctx);
 
+    // Prefetches the bucket where the lookup of 'hash' starts.
+    void prefetch_bucket(uint32_t hash) const {
+        __builtin_prefetch(&_buckets[hash & (_num_buckets - 1)], 1, 1);
+    }
+
     // Returns the number of bytes allocated to the hash table
     int64_t byte_size() const { return _total_data_page_size; }
 
@@ -98,7 +98,7 @@ inline bool PlainTextLineReader::update_eof() {
 uint8_t* PlainTextLineReader::update_field_pos_and_find_line_delimiter(
         const uint8_t* start, size_t len) {
     // TODO: meanwhile find and save field pos
-    return (uint8_t*) memmem(start, len, &_line_delimiter, 1);
+    return (uint8_t*) memchr(start, _line_delimiter, len);
 }
 
 // extend input buf if necessary only when _more_input_bytes > 0
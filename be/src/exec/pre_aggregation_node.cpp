@@ -136,6 +136,7 @@ Status PreAggregationNode::prepare(RuntimeState* state) {
     }
 
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
 
     // prepare _probe_exprs and _aggregate_exprs
     RETURN_IF_ERROR(Expr::prepare(_probe_exprs, state, _children[0]->row_desc(), false));
@@ -212,6 +213,7 @@ Status PreAggregationNode::prepare(RuntimeState* state) {
 Status PreAggregationNode::open(RuntimeState* state) {
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::OPEN));
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
 
     // open child ready to read data, only open, do nothing.
     RETURN_IF_ERROR(_children[0]->open(state));
@@ -224,6 +226,7 @@ Status PreAggregationNode::get_next(RuntimeState* state, RowBatch* row_batch, bo
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
     RETURN_IF_CANCELLED(state);
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     SCOPED_TIMER(_get_results_timer);
     int read_time = 0;
 
@@ -192,6 +192,7 @@ Status SchemaScanNode::open(RuntimeState* state) {
     }
 
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::OPEN));
     RETURN_IF_CANCELLED(state);
     RETURN_IF_ERROR(ExecNode::open(state));
@@ -239,6 +240,7 @@ Status SchemaScanNode::get_next(RuntimeState* state, RowBatch* row_batch,
 
     RETURN_IF_CANCELLED(state);
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     SCOPED_TIMER(materialize_tuple_timer());
 
     if (reached_limit()) {
@@ -305,6 +307,7 @@ Status SchemaScanNode::close(RuntimeState* state) {
     }
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::CLOSE));
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
 
     if (memory_used_counter() != NULL) {
         COUNTER_UPDATE(memory_used_counter(), _tuple_pool->peak_allocated_bytes());
@@ -19,6 +19,7 @@
 // under the License.
 
 #include "exec/select_node.h"
+
 #include "exprs/expr.h"
 #include "gen_cpp/PlanNodes_types.h"
 #include "runtime/row_batch.h"
@@ -31,15 +32,11 @@ namespace palo {
 SelectNode::SelectNode(
     ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs)
     : ExecNode(pool, tnode, descs),
-      _child_row_batch(NULL),
-      _child_row_idx(0),
       _child_eos(false) {
 }
 
 Status SelectNode::prepare(RuntimeState* state) {
     RETURN_IF_ERROR(ExecNode::prepare(state));
-    _child_row_batch.reset(
-        new RowBatch(child(0)->row_desc(), state->batch_size(), mem_tracker()));
     return Status::OK;
 }
 
@@ -54,84 +51,51 @@ Status SelectNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos)
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
     RETURN_IF_CANCELLED(state);
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
 
-    if (reached_limit() || (_child_row_idx == _child_row_batch->num_rows() && _child_eos)) {
-        // we're already done or we exhausted the last child batch and there won't be any
-        // new ones
+    if (reached_limit() || _child_eos) {
+        // we're already done or the child won't return any new rows
         *eos = true;
         return Status::OK;
     }
-    *eos = false;
+    DCHECK_EQ(row_batch->num_rows(), 0);
 
-    // start (or continue) consuming row batches from child
+    // let the child fill row_batch and keep the rows passing the conjuncts, skipping
+    // batches without any unless they carry resources that must be passed on
     while (true) {
-        if (_child_row_idx == _child_row_batch->num_rows()) {
-            // fetch next batch
-            RETURN_IF_CANCELLED(state);
-            row_batch->tuple_data_pool()->acquire_data(_child_row_batch->tuple_data_pool(), false);
-            _child_row_batch->reset();
-            RETURN_IF_ERROR(child(0)->get_next(state, _child_row_batch.get(), &_child_eos));
-            _child_row_idx = 0;
-        }
+        RETURN_IF_CANCELLED(state);
+        RETURN_IF_ERROR(child(0)->get_next(state, row_batch, &_child_eos));
 
-        if (copy_rows(row_batch)) {
-            *eos = reached_limit()
-                   || (_child_row_idx == _child_row_batch->num_rows() && _child_eos);
-            return Status::OK;
+        int num_selected = eval_conjuncts(&_conjunct_ctxs, row_batch, &_sel);
+        if (_limit != -1 && num_selected > _limit - _num_rows_returned) {
+            num_selected = _limit - _num_rows_returned;
         }
+        row_batch->keep_rows(_sel.empty() ? NULL : &_sel[0], num_selected);
+        _num_rows_returned += num_selected;
+        COUNTER_SET(_rows_returned_counter, _num_rows_returned);
 
-        if (_child_eos) {
-            // finished w/ last child row batch, and child eos is true
-            *eos = true;
-            return Status::OK;
-        }
-    }
-
-    return Status::OK;
-}
-
-bool SelectNode::copy_rows(RowBatch* output_batch) {
-    ExprContext** ctxs = &_conjunct_ctxs[0];
-    int num_ctxs = _conjunct_ctxs.size();
-
-    for (; _child_row_idx < _child_row_batch->num_rows(); ++_child_row_idx) {
-        // Add a new row to output_batch
-        int dst_row_idx = output_batch->add_row();
-
-        if (dst_row_idx == RowBatch::INVALID_ROW_INDEX) {
-            return true;
-        }
-
-        TupleRow* dst_row = output_batch->get_row(dst_row_idx);
-        TupleRow* src_row = _child_row_batch->get_row(_child_row_idx);
-
-        if (ExecNode::eval_conjuncts(ctxs, num_ctxs, src_row)) {
-            output_batch->copy_row(src_row, dst_row);
-            output_batch->commit_last_row();
-            ++_num_rows_returned;
-            COUNTER_SET(_rows_returned_counter, _num_rows_returned);
-
-            if (reached_limit()) {
-                return true;
-            }
+        if (num_selected > 0 || _child_eos
+                || row_batch->need_to_return() || row_batch->at_resource_limit()) {
+            break;
         }
+        row_batch->reset();
     }
 
     if (VLOG_ROW_IS_ON) {
-        for (int i = 0; i < output_batch->num_rows(); ++i) {
-            TupleRow* row = output_batch->get_row(i);
+        for (int i = 0; i < row_batch->num_rows(); ++i) {
+            TupleRow* row = row_batch->get_row(i);
             VLOG_ROW << "SelectNode input row: " << print_row(row, row_desc());
         }
     }
 
-    return output_batch->is_full() || output_batch->at_resource_limit();
+    *eos = reached_limit() || _child_eos;
+    return Status::OK;
 }
 
 Status SelectNode::close(RuntimeState* state) {
     if (is_closed()) {
         return Status::OK;
     }
-    _child_row_batch.reset();
     return ExecNode::close(state);
 }
 
@@ -21,7 +21,7 @@
 #ifndef BDG_PALO_BE_SRC_QUERY_EXEC_SELECT_NODE_H
 #define BDG_PALO_BE_SRC_QUERY_EXEC_SELECT_NODE_H
 
-#include <boost/scoped_ptr.hpp>
+#include <vector>
 
 #include "exec/exec_node.h"
 #include "runtime/mem_pool.h"
@@ -32,7 +32,8 @@ class Tuple;
 class TupleRow;
 
 // Node that evaluates conjuncts and enforces a limit but otherwise passes along
-// the rows pulled from its child unchanged.
+// the rows pulled from its child unchanged. The child fills the output batch directly,
+// which is then filtered in place.
 class SelectNode : public ExecNode {
 public:
     SelectNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs);
@@ -43,19 +44,11 @@ public:
     virtual Status close(RuntimeState* state);
 
 private:
-    // current row batch of child
-    boost::scoped_ptr<RowBatch> _child_row_batch;
-
-    // index of current row in _child_row_batch
-    int _child_row_idx;
-
     // true if last get_next() call on child signalled eos
     bool _child_eos;
 
-    // Copy rows from _child_row_batch for which _conjuncts evaluate to true to
-    // output_batch, up to _limit.
-    // Return true if limit was hit or output_batch should be returned, otherwise false.
-    bool copy_rows(RowBatch* output_batch);
+    // indices of the rows of the current batch passing the conjuncts
+    std::vector<int> _sel;
 };
 
 }
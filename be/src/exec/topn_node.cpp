@@ -22,7 +22,10 @@
 
 #include <sstream>
 
+#include "common/config.h"
+#include "exec/topn_runtime_bound.h"
 #include "exprs/expr.h"
+#include "exprs/slot_ref.h"
 #include "gen_cpp/Exprs_types.h"
 #include "gen_cpp/PlanNodes_types.h"
 #include "runtime/descriptors.h"
@@ -45,6 +48,7 @@ TopNNode::TopNNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl
         _materialized_tuple_desc(NULL),
         _tuple_row_less_than(NULL),
         _tuple_pool(NULL),
+        _runtime_bound_slot(NULL),
         _num_rows_skipped(0),
         _priority_queue(NULL) {
 }
@@ -65,6 +69,7 @@ Status TopNNode::init(const TPlanNode& tnode) {
 
 Status TopNNode::prepare(RuntimeState* state) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(ExecNode::prepare(state));
     _tuple_pool.reset(new MemPool(mem_tracker()));
     RETURN_IF_ERROR(_sort_exec_exprs.prepare(
@@ -89,6 +94,7 @@ Status TopNNode::prepare(RuntimeState* state) {
 
 Status TopNNode::open(RuntimeState* state) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(ExecNode::open(state));
     RETURN_IF_CANCELLED(state);
     // RETURN_IF_ERROR(QueryMaintenance(state));
@@ -107,6 +113,9 @@ Status TopNNode::open(RuntimeState* state) {
     // Allocate memory for a temporary tuple.
     _tmp_tuple = reinterpret_cast<Tuple*>(
             _tuple_pool->allocate(_materialized_tuple_desc->byte_size()));
+    if (config::enable_topn_runtime_bound && _limit > 0 && _runtime_bound.get() == NULL) {
+        push_down_runtime_bound(state);
+    }
     RETURN_IF_ERROR(child(0)->open(state));
 
     // Limit of 0, no need to fetch anything from children.
@@ -125,6 +134,9 @@ Status TopNNode::open(RuntimeState* state) {
             for (int i = 0; i < batch.num_rows(); ++i) {
                 insert_tuple_row(batch.get_row(i));
             }
+            if (_runtime_bound.get() != NULL) {
+                update_runtime_bound();
+            }
             RETURN_IF_CANCELLED(state);
             // RETURN_IF_LIMIT_EXCEEDED(state);
             RETURN_IF_ERROR(state->check_query_state());
@@ -144,6 +156,7 @@ Status TopNNode::open(RuntimeState* state) {
 
 Status TopNNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
     RETURN_IF_CANCELLED(state);
     // RETURN_IF_ERROR(QueryMaintenance(state));
@@ -225,6 +238,56 @@ void TopNNode::insert_tuple_row(TupleRow* input_row) {
     }
 }
 
+void TopNNode::push_down_runtime_bound(RuntimeState* state) {
+    // The queue is ordered by the materialized tuple, find the child slot that the
+    // first ORDER BY slot is copied from.
+    const Expr* ordering_expr = _sort_exec_exprs.lhs_ordering_expr_ctxs()[0]->root();
+    if (!ordering_expr->is_slotref()) {
+        return;
+    }
+    SlotId ordering_slot_id = static_cast<const SlotRef*>(ordering_expr)->slot_id();
+    const std::vector<ExprContext*>& slot_expr_ctxs =
+        _sort_exec_exprs.sort_tuple_slot_expr_ctxs();
+    int mat_expr_index = 0;
+    for (int i = 0; i < _materialized_tuple_desc->slots().size(); ++i) {
+        const SlotDescriptor* slot_desc = _materialized_tuple_desc->slots()[i];
+        if (!slot_desc->is_materialized()) {
+            continue;
+        }
+        if (slot_desc->id() == ordering_slot_id) {
+            const Expr* slot_expr = slot_expr_ctxs[mat_expr_index]->root();
+            if (!slot_expr->is_slotref()) {
+                return;
+            }
+            const SlotDescriptor* child_slot = state->desc_tbl().get_slot_descriptor(
+                    static_cast<const SlotRef*>(slot_expr)->slot_id());
+            if (child_slot == NULL || child_slot->type() != slot_desc->type()) {
+                return;
+            }
+            _runtime_bound.reset(
+                new TopNRuntimeBound(child_slot, _is_asc_order[0], _nulls_first[0]));
+            _runtime_bound_slot = slot_desc;
+            break;
+        }
+        ++mat_expr_index;
+    }
+    if (_runtime_bound.get() != NULL && !child(0)->push_down_topn_bound(_runtime_bound.get())) {
+        _runtime_bound.reset();
+        _runtime_bound_slot = NULL;
+    }
+}
+
+void TopNNode::update_runtime_bound() {
+    if (_priority_queue->size() < _offset + _limit) {
+        return;
+    }
+    const Tuple* top_tuple = _priority_queue->top();
+    if (top_tuple->is_null(_runtime_bound_slot->null_indicator_offset())) {
+        return;
+    }
+    _runtime_bound->set(top_tuple->get_slot(_runtime_bound_slot->tuple_offset()));
+}
+
 // Reverse the order of the tuples in the priority queue
 void TopNNode::prepare_for_output() {
     _sorted_top_n.resize(_priority_queue->size());
@@ -32,6 +32,8 @@ namespace palo {
 
 class MemPool;
 class RuntimeState;
+class SlotDescriptor;
+class TopNRuntimeBound;
 class Tuple;
 
 // Node for in-memory TopN (ORDER BY ... LIMIT)
@@ -65,6 +67,13 @@ private:
     // Flatten and reverse the priority queue.
     void prepare_for_output();
 
+    // Offers _runtime_bound to the child if the first ORDER BY expr is a plain slot of
+    // the child's output. Must be called before the child is opened.
+    void push_down_runtime_bound(RuntimeState* state);
+
+    // Publishes the first ORDER BY value of the queue top once the queue is full.
+    void update_runtime_bound();
+
     // number rows to skipped
     int64_t _offset;
 
@@ -91,6 +100,13 @@ private:
     // Stores everything referenced in _priority_queue
     boost::scoped_ptr<MemPool> _tuple_pool;
 
+    // Bound on the first ORDER BY value that the child uses to drop rows which cannot
+    // get into the queue. NULL if the child did not accept it.
+    boost::scoped_ptr<TopNRuntimeBound> _runtime_bound;
+
+    // Slot of the first ORDER BY value in _materialized_tuple_desc.
+    const SlotDescriptor* _runtime_bound_slot;
+
     // Iterator over elements in _sorted_top_n.
     std::vector<Tuple*>::iterator _get_next_iter;
     // std::vector<TupleRow*>::iterator _get_next_iter;
@@ -0,0 +1,129 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/topn_runtime_bound.h"
+
+#include <string.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include "runtime/datetime_value.h"
+#include "runtime/descriptors.h"
+#include "runtime/large_int_value.h"
+#include "runtime/raw_value.h"
+#include "runtime/tuple.h"
+
+namespace palo {
+
+TopNRuntimeBound::TopNRuntimeBound(
+        const SlotDescriptor* slot_desc, bool is_asc, bool nulls_first) :
+        _slot_desc(slot_desc),
+        _is_asc(is_asc),
+        _nulls_first(nulls_first),
+        _version(0) {
+}
+
+void TopNRuntimeBound::set(const void* value) {
+    DCHECK(value != NULL);
+    boost::lock_guard<boost::mutex> l(_lock);
+    if (_slot_desc->type().is_string_type()) {
+        const StringValue* sv = reinterpret_cast<const StringValue*>(value);
+        _data.assign(sv->ptr, sv->len);
+    } else {
+        _data.assign(reinterpret_cast<const char*>(value), _slot_desc->type().get_slot_size());
+    }
+    ++_version;
+}
+
+void TopNRuntimeBound::refresh(Snapshot* snapshot) const {
+    if (snapshot->version == _version.load()) {
+        return;
+    }
+    boost::lock_guard<boost::mutex> l(_lock);
+    snapshot->version = _version.load();
+    snapshot->data = _data;
+    if (_slot_desc->type().is_string_type()) {
+        snapshot->string_value = StringValue(
+                const_cast<char*>(snapshot->data.data()), snapshot->data.size());
+        snapshot->value = &snapshot->string_value;
+    } else {
+        snapshot->value = snapshot->data.data();
+    }
+}
+
+bool TopNRuntimeBound::may_qualify(const Snapshot& snapshot, const Tuple* tuple) const {
+    if (snapshot.value == NULL) {
+        return true;
+    }
+    if (tuple->is_null(_slot_desc->null_indicator_offset())) {
+        // The bound is not NULL, so a NULL is only in front of it if NULLs sort first.
+        return _nulls_first;
+    }
+    int cmp = RawValue::compare(
+            tuple->get_slot(_slot_desc->tuple_offset()), snapshot.value, _slot_desc->type());
+    return _is_asc ? cmp <= 0 : cmp >= 0;
+}
+
+bool TopNRuntimeBound::to_olap_condition(TCondition* condition) const {
+    if (_nulls_first && _slot_desc->is_nullable()) {
+        return false;
+    }
+    Snapshot snapshot;
+    refresh(&snapshot);
+    if (snapshot.value == NULL) {
+        return false;
+    }
+
+    std::string value;
+    switch (_slot_desc->type().type) {
+    case TYPE_TINYINT:
+        value = boost::lexical_cast<std::string>(
+                static_cast<int32_t>(*reinterpret_cast<const int8_t*>(snapshot.value)));
+        break;
+    case TYPE_SMALLINT:
+        value = boost::lexical_cast<std::string>(
+                *reinterpret_cast<const int16_t*>(snapshot.value));
+        break;
+    case TYPE_INT:
+        value = boost::lexical_cast<std::string>(
+                *reinterpret_cast<const int32_t*>(snapshot.value));
+        break;
+    case TYPE_BIGINT:
+        value = boost::lexical_cast<std::string>(
+                *reinterpret_cast<const int64_t*>(snapshot.value));
+        break;
+    case TYPE_LARGEINT: {
+        __int128 large_int = 0;
+        memcpy(&large_int, snapshot.value, sizeof(large_int));
+        value = boost::lexical_cast<std::string>(large_int);
+        break;
+    }
+    case TYPE_DATE:
+    case TYPE_DATETIME:
+        value = boost::lexical_cast<std::string>(
+                *reinterpret_cast<const DateTimeValue*>(snapshot.value));
+        break;
+    default:
+        return false;
+    }
+
+    condition->__set_column_name(_slot_desc->col_name());
+    condition->__set_condition_op(_is_asc ? "<=" : ">=");
+    condition->condition_values.clear();
+    condition->condition_values.push_back(value);
+    return true;
+}
+
+} // namespace palo
@@ -0,0 +1,94 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_EXEC_TOPN_RUNTIME_BOUND_H
+#define BDG_PALO_BE_SRC_EXEC_TOPN_RUNTIME_BOUND_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+
+#include <boost/thread/mutex.hpp>
+
+#include "gen_cpp/PaloInternalService_types.h"
+#include "runtime/string_value.h"
+
+namespace palo {
+
+class SlotDescriptor;
+class Tuple;
+
+// The first ORDER BY value of the current n-th row of a TopNNode, which a scan node
+// below it uses to drop rows that cannot make it into the top n anymore.
+// The TopNNode applies it to a child slot that is a plain column of the scan. Once
+// its heap is full, a row can only enter if its first ORDER BY value is not behind
+// the one of the heap top, i.e. value <= bound for ASC and value >= bound for DESC.
+// Rows equal to the bound are kept since later ORDER BY exprs may still let them in.
+//
+// set() is called by the fragment thread of the TopNNode, the scanner threads read
+// the bound through a Snapshot that is only copied again when the bound changed.
+class TopNRuntimeBound {
+public:
+    // A copy of the bound owned by one reader thread.
+    struct Snapshot {
+        Snapshot() : version(0), value(NULL) {}
+
+        int64_t version;
+        // Raw bytes of a fixed length value or the characters of a string value.
+        std::string data;
+        StringValue string_value;
+        // Points into 'data' or at 'string_value', NULL if there is no bound yet.
+        const void* value;
+    };
+
+    TopNRuntimeBound(const SlotDescriptor* slot_desc, bool is_asc, bool nulls_first);
+
+    const SlotDescriptor* slot_desc() const {
+        return _slot_desc;
+    }
+
+    // Publishes the ORDER BY value of the current n-th row. 'value' must not be NULL:
+    // a NULL bound does not rule out any row.
+    void set(const void* value);
+
+    // Updates 'snapshot' if the bound changed since it was taken.
+    void refresh(Snapshot* snapshot) const;
+
+    // Returns false if the row with 'tuple' cannot be among the top n rows.
+    bool may_qualify(const Snapshot& snapshot, const Tuple* tuple) const;
+
+    // Sets '*condition' to an OLAP storage condition on the column of the bound, so that
+    // a scanner that is opened later can skip whole blocks by their min/max. Returns
+    // false if there is no bound yet, the slot type cannot be expressed in a condition,
+    // or NULLs may still qualify (the storage conditions never accept NULL).
+    bool to_olap_condition(TCondition* condition) const;
+
+private:
+    const SlotDescriptor* _slot_desc;
+    const bool _is_asc;
+    const bool _nulls_first;
+
+    // Protects _data.
+    mutable boost::mutex _lock;
+    std::string _data;
+
+    // Incremented by every set(). Read without the lock.
+    std::atomic<int64_t> _version;
+};
+
+} // namespace palo
+
+#endif // BDG_PALO_BE_SRC_EXEC_TOPN_RUNTIME_BOUND_H
@@ -20,7 +20,11 @@
 
 #include "exec/union_node.h"
 
+#include <boost/bind.hpp>
+
 #include "codegen/llvm_codegen.h"
+#include "common/config.h"
+#include "exec/parallel_child_reader.h"
 #include "exprs/expr.h"
 #include "exprs/expr_context.h"
 #include "runtime/row_batch.h"
@@ -48,7 +52,11 @@ UnionNode::UnionNode(ObjectPool* pool, const TPlanNode& tnode,
       _child_row_idx(0),
       _child_eos(false),
       _const_expr_list_idx(0),
-      _to_close_child_idx(-1) { 
+      _to_close_child_idx(-1),
+      _parallel_eos(false) { 
+}
+
+UnionNode::~UnionNode() {
 }
 
 Status UnionNode::init(const TPlanNode& tnode) {
@@ -76,6 +84,7 @@ Status UnionNode::init(const TPlanNode& tnode) {
 
 Status UnionNode::prepare(RuntimeState* state) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(ExecNode::prepare(state));
     _tuple_desc = state->desc_tbl().get_tuple_descriptor(_tuple_id);
     DCHECK(_tuple_desc != nullptr);
@@ -148,6 +157,7 @@ void UnionNode::codegen(RuntimeState* state) {
 
 Status UnionNode::open(RuntimeState* state) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(ExecNode::open(state));
     // open const expr lists.
     for (const vector<ExprContext*>& exprs : _const_expr_lists) {
@@ -158,6 +168,21 @@ Status UnionNode::open(RuntimeState* state) {
         RETURN_IF_ERROR(Expr::open(exprs, state));
     }
 
+    if (config::union_max_parallel_children > 1 && _children.size() > 1
+            && !is_in_subplan()) {
+        _parallel_reader.reset(new ParallelChildReader(
+                _children, row_desc(), mem_tracker(),
+                boost::bind(&UnionNode::convert_child_batch, this, state, _1, _2, _3)));
+        if (_parallel_reader->start(state, config::union_max_parallel_children)) {
+            // The children are opened and read by the reader from now on.
+            _child_idx = _children.size();
+            COUNTER_SET(ADD_COUNTER(runtime_profile(), "ParallelChildThreads", TUnit::UNIT),
+                        static_cast<int64_t>(_parallel_reader->num_threads()));
+            return Status::OK;
+        }
+        _parallel_reader.reset();
+    }
+
     // Ensures that rows are available for clients to fetch after this open() has
     // succeeded.
     if (!_children.empty()) RETURN_IF_ERROR(child(_child_idx)->open(state));
@@ -259,6 +284,32 @@ Status UnionNode::get_next_materialized(RuntimeState* state, RowBatch* row_batch
     return Status::OK;
 }
 
+Status UnionNode::get_next_parallel(RuntimeState* state, RowBatch* row_batch) {
+    DCHECK(!reached_limit());
+    DCHECK_EQ(row_batch->num_rows(), 0);
+    return _parallel_reader->get_next(row_batch, &_parallel_eos);
+}
+
+Status UnionNode::convert_child_batch(RuntimeState* state, int child_idx,
+                                      RowBatch* child_batch, RowBatch* dst_batch) {
+    if (is_child_passthrough(child_idx)) {
+        child_batch->deep_copy_to(dst_batch);
+        return Status::OK;
+    }
+    int64_t tuple_buf_size;
+    uint8_t* tuple_buf;
+    RETURN_IF_ERROR(
+        dst_batch->resize_and_allocate_tuple_buffer(state, &tuple_buf_size, &tuple_buf));
+    memset(tuple_buf, 0, tuple_buf_size);
+    const std::vector<ExprContext*>& child_exprs = _child_expr_lists[child_idx];
+    int tuple_byte_size = _tuple_desc->byte_size();
+    for (int i = 0; i < child_batch->num_rows(); ++i) {
+        materialize_exprs(child_exprs, child_batch->get_row(i), tuple_buf, dst_batch);
+        tuple_buf += tuple_byte_size;
+    }
+    return Status::OK;
+}
+
 Status UnionNode::get_next_const(RuntimeState* state, RowBatch* row_batch) {
     DCHECK_EQ(state->per_fragment_instance_idx(), 0);
     DCHECK_LT(_const_expr_list_idx, _const_expr_lists.size());
@@ -281,6 +332,7 @@ Status UnionNode::get_next_const(RuntimeState* state, RowBatch* row_batch) {
 
 Status UnionNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos) {
     SCOPED_TIMER(_runtime_profile->total_time_counter());
+    SCOPED_CPU_TIMER(_cpu_time_counter);
     RETURN_IF_ERROR(exec_debug_action(TExecNodePhase::GETNEXT));
     RETURN_IF_CANCELLED(state);
     // TODO(zc)
@@ -299,7 +351,9 @@ Status UnionNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos)
     // happen in a subplan.
     int num_rows_before = row_batch->num_rows();
 
-    if (has_more_passthrough()) {
+    if (has_more_parallel()) {
+        RETURN_IF_ERROR(get_next_parallel(state, row_batch));
+    } else if (has_more_passthrough()) {
         RETURN_IF_ERROR(get_next_pass_through(state, row_batch));
     } else if (has_more_materialized()) {
         RETURN_IF_ERROR(get_next_materialized(state, row_batch));
@@ -317,8 +371,8 @@ Status UnionNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos)
     }
     _num_rows_returned += num_rows_added;
 
-    *eos = reached_limit() ||
-        (!has_more_passthrough() && !has_more_materialized() && !has_more_const(state));
+    *eos = reached_limit() || (!has_more_parallel() && !has_more_passthrough()
+            && !has_more_materialized() && !has_more_const(state));
 
     COUNTER_SET(_rows_returned_counter, _num_rows_returned);
     return Status::OK;
@@ -340,6 +394,8 @@ Status UnionNode::reset(RuntimeState* state) {
 
 Status UnionNode::close(RuntimeState* state) {
     if (is_closed()) return Status::OK;
+    // Stop the reader threads before the children are closed below.
+    if (_parallel_reader != nullptr) _parallel_reader->close();
     _child_batch.reset();
     for (auto& exprs : _const_expr_lists) {
         Expr::close(exprs, state);
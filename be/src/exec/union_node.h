@@ -31,6 +31,7 @@ namespace palo {
 
 class DescriptorTbl;
 class ExprContext;
+class ParallelChildReader;
 class Tuple;
 class TupleRow;
 class TPlanNode;
@@ -41,10 +42,13 @@ class TPlanNode;
 /// and expressions don't need to be evaluated. The children should be ordered
 /// such that all passthrough children come before the children that need
 /// materialization. The union node pulls from its children sequentially, i.e.
-/// it exhausts one child completely before moving on to the next one.
+/// it exhausts one child completely before moving on to the next one, unless
+/// config::union_max_parallel_children allows to read several children at the same
+/// time (see ParallelChildReader). Then the rows of the children are interleaved.
 class UnionNode : public ExecNode {
 public:
     UnionNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs);
+    virtual ~UnionNode();
 
     virtual Status init(const TPlanNode& tnode);
     virtual Status prepare(RuntimeState* state);
@@ -103,6 +107,13 @@ private:
     /// to -1 if no child needs to be closed.
     int _to_close_child_idx;
 
+    /// Reads all children on threads of their own if set in open(). The sequential child
+    /// state above is unused then.
+    boost::scoped_ptr<ParallelChildReader> _parallel_reader;
+
+    /// Saved from the last get_next() on '_parallel_reader'.
+    bool _parallel_eos;
+
     /// END: Members that must be Reset()
     /////////////////////////////////////////
 
@@ -120,6 +131,14 @@ private:
     /// GetNext() for the constant expression case.
     Status get_next_const(RuntimeState* state, RowBatch* row_batch);
 
+    /// GetNext() for the children when they are read by '_parallel_reader'.
+    Status get_next_parallel(RuntimeState* state, RowBatch* row_batch);
+
+    /// Converts 'child_batch' of child 'child_idx' into 'dst_batch' on a thread of
+    /// '_parallel_reader': passthrough batches are deep copied, the others materialized.
+    Status convert_child_batch(RuntimeState* state, int child_idx, RowBatch* child_batch,
+                               RowBatch* dst_batch);
+
     /// Evaluates exprs for the current child and materializes the results into 'tuple_buf',
     /// which is attached to 'dst_batch'. Runs until 'dst_batch' is at capacity, or all rows
     /// have been consumed from the current child batch. Updates '_child_row_idx'.
@@ -136,6 +155,12 @@ private:
         return child_idx < _first_materialized_child_idx;
     }
 
+    /// Returns true if there are still rows to be returned from children read by
+    /// '_parallel_reader'.
+    bool has_more_parallel() const {
+        return _parallel_reader != nullptr && !_parallel_eos;
+    }
+
     /// Returns true if there are still rows to be returned from passthrough children.
     bool has_more_passthrough() const {
         return _child_idx < _first_materialized_child_idx;
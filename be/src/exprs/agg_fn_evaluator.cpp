@@ -215,8 +215,9 @@ Status AggFnEvaluator::prepare(
     RETURN_IF_ERROR(LibCache::instance()->get_so_function_ptr(
             _hdfs_location, _fn.aggregate_fn.update_fn_symbol, &_update_fn, NULL, true));
 
-    // Merge() is not loaded if evaluating the agg fn as an analytic function.
-    if (!_is_analytic_fn) {
+    // Merge() is optional if evaluating the agg fn as an analytic function, it is only
+    // used for functions that cannot remove() rows from sliding windows.
+    if (!_is_analytic_fn || !_fn.aggregate_fn.merge_fn_symbol.empty()) {
     RETURN_IF_ERROR(LibCache::instance()->get_so_function_ptr(
             _hdfs_location, _fn.aggregate_fn.merge_fn_symbol, &_merge_fn, NULL, true));
     }
@@ -114,6 +114,13 @@ public:
     bool supports_serialize() const {
         return _serialize_fn != NULL;
     }
+    // Only valid after prepare().
+    bool supports_remove() const {
+        return _remove_fn != NULL;
+    }
+    bool supports_merge() const {
+        return _merge_fn != NULL;
+    }
 
     static std::string debug_string(const std::vector<AggFnEvaluator*>& exprs);
     std::string debug_string() const;
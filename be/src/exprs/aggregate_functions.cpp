@@ -21,13 +21,19 @@
 #include "exprs/aggregate_functions.h"
 
 #include <math.h>
+#include <limits>
 #include <sstream>
+#include <string>
+#include <unordered_set>
 
 #include "common/logging.h"
 #include "runtime/string_value.h"
 #include "runtime/datetime_value.h"
+#include "runtime/decimal_value.h"
 #include "exprs/anyval_util.h"
+#include "util/bitmap_value.h"
 #include "util/debug_util.h"
+#include "util/tdigest.h"
 
 // TODO: this file should be cross compiled and then all of the builtin
 // aggregate functions will have a codegen enabled path. Then we can remove
@@ -54,6 +60,17 @@ static const StringVal DEFAULT_STRING_CONCAT_DELIM((uint8_t*)", ", 2);
 // much when between [6,12]
 const int HLL_PRECISION = 14;
 const int HLL_SETS_BYTES_NUM = 16384;
+
+// 2^-i for every possible register value, used by hll_algorithm()
+struct HllInversePowers {
+    HllInversePowers() {
+        for (int i = 0; i < 256; ++i) {
+            values[i] = powf(2.0f, -i);
+        }
+    }
+    float values[256];
+};
+static const HllInversePowers HLL_INVERSE_POWERS;
     
 void AggregateFunctions::init_null(FunctionContext*, AnyVal* dst) {
     dst->is_null = true;
@@ -159,8 +176,9 @@ struct AvgState {
     int64_t count;
 };
 
+// Also the intermediate value of sum() for decimals
 struct DecimalAvgState {
-    DecimalVal sum;
+    DecimalSum sum;
     int64_t count;
 };
 
@@ -178,7 +196,7 @@ void AggregateFunctions::decimal_avg_init(FunctionContext* ctx, StringVal* dst)
     // memset(dst->ptr, 0, sizeof(DecimalAvgState));
     DecimalAvgState* avg = reinterpret_cast<DecimalAvgState*>(dst->ptr);
     avg->count = 0;
-    avg->sum.set_to_zero();
+    avg->sum.init();
 }
 
 template <typename T>
@@ -202,12 +220,7 @@ void AggregateFunctions::decimal_avg_update(FunctionContext* ctx,
     DCHECK(dst->ptr != NULL);
     DCHECK_EQ(sizeof(DecimalAvgState), dst->len);
     DecimalAvgState* avg = reinterpret_cast<DecimalAvgState*>(dst->ptr);
-
-    DecimalValue v1 = DecimalValue::from_decimal_val(avg->sum);
-    DecimalValue v2 = DecimalValue::from_decimal_val(src);
-    DecimalValue v = v1 + v2;
-    v.to_decimal_val(&avg->sum);
-
+    avg->sum.add(src);
     ++avg->count;
 }
 
@@ -237,12 +250,7 @@ void AggregateFunctions::decimal_avg_remove(palo_udf::FunctionContext* ctx,
     DCHECK(dst->ptr != NULL);
     DCHECK_EQ(sizeof(DecimalAvgState), dst->len);
     DecimalAvgState* avg = reinterpret_cast<DecimalAvgState*>(dst->ptr);
-
-    DecimalValue v1 = DecimalValue::from_decimal_val(avg->sum);
-    DecimalValue v2 = DecimalValue::from_decimal_val(src);
-    DecimalValue v = v1 - v2;
-    v.to_decimal_val(&avg->sum);
-
+    avg->sum.subtract(src);
     --avg->count;
     DCHECK_GE(avg->count, 0);
 }
@@ -263,11 +271,7 @@ void AggregateFunctions::decimal_avg_merge(FunctionContext* ctx, const StringVal
     DCHECK(dst->ptr != NULL);
     DCHECK_EQ(sizeof(DecimalAvgState), dst->len);
     DecimalAvgState* dst_struct = reinterpret_cast<DecimalAvgState*>(dst->ptr);
-
-    DecimalValue v1 = DecimalValue::from_decimal_val(dst_struct->sum);
-    DecimalValue v2 = DecimalValue::from_decimal_val(src_struct->sum);
-    DecimalValue v = v1 + v2;
-    v.to_decimal_val(&dst_struct->sum);
+    dst_struct->sum.merge(src_struct->sum);
     dst_struct->count += src_struct->count;
 }
 
@@ -284,14 +288,24 @@ DecimalVal AggregateFunctions::decimal_avg_get_value(FunctionContext* ctx, const
     if (val_struct->count == 0) {
         return DecimalVal::null();
     }
-    DecimalValue v1 = DecimalValue::from_decimal_val(val_struct->sum);
-    DecimalValue v = v1 / DecimalValue(val_struct->count);
+    DecimalValue v = val_struct->sum.value() / DecimalValue(val_struct->count);
     DecimalVal res;
     v.to_decimal_val(&res);
 
     return res;
 }
 
+DecimalVal AggregateFunctions::decimal_sum_get_value(FunctionContext* ctx,
+        const StringVal& src) {
+    DecimalAvgState* val_struct = reinterpret_cast<DecimalAvgState*>(src.ptr);
+    if (val_struct->count == 0) {
+        return DecimalVal::null();
+    }
+    DecimalVal res;
+    val_struct->sum.value().to_decimal_val(&res);
+    return res;
+}
+
 DoubleVal AggregateFunctions::avg_finalize(FunctionContext* ctx, const StringVal& src) {
     if (src.is_null) {
         return DoubleVal::null();
@@ -310,6 +324,16 @@ DecimalVal AggregateFunctions::decimal_avg_finalize(FunctionContext* ctx, const
     return result;
 }
 
+DecimalVal AggregateFunctions::decimal_sum_finalize(FunctionContext* ctx,
+        const StringVal& src) {
+    if (src.is_null) {
+        return DecimalVal::null();
+    }
+    DecimalVal result = decimal_sum_get_value(ctx, src);
+    ctx->free(src.ptr);
+    return result;
+}
+
 void AggregateFunctions::timestamp_avg_update(FunctionContext* ctx,
         const DateTimeVal& src, StringVal* dst) {
     if (src.is_null) {
@@ -925,9 +949,7 @@ void AggregateFunctions::hll_merge(FunctionContext* ctx, const StringVal& src,
     DCHECK_EQ(dst->len, std::pow(2, HLL_PRECISION));
     DCHECK_EQ(src.len, std::pow(2, HLL_PRECISION));
 
-    for (int i = 0; i < src.len; ++i) {
-        dst->ptr[i] = std::max(dst->ptr[i], src.ptr[i]);
-    }
+    HllSetHelper::merge_registers((char*)dst->ptr, (const char*)src.ptr, src.len);
 }
 
 StringVal AggregateFunctions::hll_finalize(FunctionContext* ctx, const StringVal& src) {
@@ -951,32 +973,8 @@ void AggregateFunctions::hll_union_agg_init(FunctionContext* ctx, StringVal* dst
 }
 
 void AggregateFunctions::hll_union_parse_and_cal(HllSetResolver& resolver, StringVal* dst) {
-    
-    if (resolver.get_hll_data_type() == HLL_DATA_EMPTY) {    
-        return;
-    }    
-    if (resolver.get_hll_data_type() == HLL_DATA_EXPLICIT) {
-        for (int i = 0; i < resolver.get_expliclit_count(); i++) {
-            uint64_t hash_value = resolver.get_expliclit_value(i);
-            int idx = hash_value % dst->len;
-            uint8_t first_one_bit = __builtin_ctzl(hash_value >> HLL_PRECISION) + 1; 
-            dst->ptr[idx] = std::max(dst->ptr[idx], first_one_bit);
-        }    
-    } else if (resolver.get_hll_data_type() == HLL_DATA_SPRASE) {
-        std::map<HllSetResolver::SparseIndexType, HllSetResolver::SparseValueType>& 
-                                            sparse_map = resolver.get_sparse_map();
-        for (std::map<HllSetResolver::SparseIndexType, 
-             HllSetResolver::SparseValueType>::iterator iter = sparse_map.begin(); 
-                                    iter != sparse_map.end(); iter++) {
-            dst->ptr[iter->first] = std::max(dst->ptr[iter->first], (uint8_t)iter->second);
-        }  
-    } else if (resolver.get_hll_data_type() == HLL_DATA_FULL) {
-        char* full_value = resolver.get_full_value();
-        for (int i = 0; i < HLL_SETS_BYTES_NUM; i++) {
-            dst->ptr[i] = std::max(dst->ptr[i], (uint8_t)full_value[i]);
-        }
-    }
-    return ;
+    // sparse sets are merged straight from the serialized pairs, full sets with SIMD
+    resolver.fill_registers((char*)dst->ptr, dst->len);
 }
 
 void AggregateFunctions::hll_union_agg_update(FunctionContext* ctx, 
@@ -1001,9 +999,7 @@ void AggregateFunctions::hll_union_agg_merge(FunctionContext* ctx, const StringV
     DCHECK_EQ(dst->len, HLL_SETS_BYTES_NUM);
     DCHECK_EQ(src.len, HLL_SETS_BYTES_NUM);
      
-    for (int i = 0; i < src.len; ++i) {
-        dst->ptr[i] = std::max(dst->ptr[i], src.ptr[i]);
-    }
+    HllSetHelper::merge_registers((char*)dst->ptr, (const char*)src.ptr, src.len);
 }
 
 palo_udf::StringVal AggregateFunctions::hll_union_agg_finalize(palo_udf::FunctionContext* ctx, 
@@ -1039,11 +1035,8 @@ int64_t AggregateFunctions::hll_algorithm(const palo_udf::StringVal& src) {
     int num_zero_registers = 0;
     
     for (int i = 0; i < src.len; ++i) {
-        harmonic_mean += powf(2.0f, -src.ptr[i]);
-        
-        if (src.ptr[i] == 0) {
-            ++num_zero_registers;
-        }
+        harmonic_mean += HLL_INVERSE_POWERS.values[src.ptr[i]];
+        num_zero_registers += (src.ptr[i] == 0);
     }
     
     harmonic_mean = 1.0f / harmonic_mean;
@@ -1073,6 +1066,500 @@ int64_t AggregateFunctions::hll_algorithm(const palo_udf::StringVal& src) {
     return (int64_t)(estimate + 0.5);
 }
 
+void AggregateFunctions::bitmap_init(FunctionContext* ctx, StringVal* dst) {
+    dst->is_null = false;
+    dst->len = sizeof(BitmapValue);
+    dst->ptr = ctx->allocate(dst->len);
+    if (dst->ptr == NULL) {
+        dst->is_null = true;
+        return;
+    }
+    new (dst->ptr) BitmapValue();
+}
+
+template <typename T>
+void AggregateFunctions::bitmap_update_int(FunctionContext* ctx, const T& src, StringVal* dst) {
+    if (src.is_null || dst->is_null) {
+        return;
+    }
+    DCHECK_EQ(dst->len, sizeof(BitmapValue));
+    int64_t value = src.val;
+    if (value < 0 || value > std::numeric_limits<uint32_t>::max()) {
+        return;
+    }
+    reinterpret_cast<BitmapValue*>(dst->ptr)->add(value);
+}
+
+void AggregateFunctions::bitmap_update(FunctionContext* ctx, const StringVal& src,
+                                       StringVal* dst) {
+    if (src.is_null || dst->is_null) {
+        return;
+    }
+    DCHECK_EQ(dst->len, sizeof(BitmapValue));
+    BitmapValue* bitmap = reinterpret_cast<BitmapValue*>(dst->ptr);
+    if (!bitmap->merge_serialized(reinterpret_cast<const char*>(src.ptr), src.len)) {
+        ctx->set_error("bitmap_union/bitmap_count: invalid bitmap");
+    }
+}
+
+void AggregateFunctions::bitmap_merge(FunctionContext* ctx, const StringVal& src,
+                                      StringVal* dst) {
+    bitmap_update(ctx, src, dst);
+}
+
+StringVal AggregateFunctions::bitmap_serialize(FunctionContext* ctx, const StringVal& src) {
+    if (src.is_null) {
+        return StringVal::null();
+    }
+    DCHECK_EQ(src.len, sizeof(BitmapValue));
+    BitmapValue* bitmap = reinterpret_cast<BitmapValue*>(src.ptr);
+    StringVal result(ctx, bitmap->serialized_size());
+    if (!result.is_null) {
+        bitmap->serialize(reinterpret_cast<char*>(result.ptr));
+    }
+    bitmap->~BitmapValue();
+    ctx->free(src.ptr);
+    return result;
+}
+
+BigIntVal AggregateFunctions::bitmap_count_finalize(FunctionContext* ctx, const StringVal& src) {
+    if (src.is_null) {
+        return BigIntVal::null();
+    }
+    DCHECK_EQ(src.len, sizeof(BitmapValue));
+    BitmapValue* bitmap = reinterpret_cast<BitmapValue*>(src.ptr);
+    BigIntVal result(bitmap->cardinality());
+    bitmap->~BitmapValue();
+    ctx->free(src.ptr);
+    return result;
+}
+
+// The values seen by multi_distinct_count(). A column only fills 'bitmap' and 'ints' or
+// 'strings', integers go to 'bitmap' if they fit and to 'ints' otherwise.
+struct MultiDistinctCountState {
+    BitmapValue bitmap;
+    std::unordered_set<int64_t> ints;
+    std::unordered_set<std::string> strings;
+
+    void add(int64_t value) {
+        if (value >= 0 && value <= std::numeric_limits<uint32_t>::max()) {
+            bitmap.add(value);
+        } else {
+            ints.insert(value);
+        }
+    }
+
+    int64_t count() const {
+        return bitmap.cardinality() + ints.size() + strings.size();
+    }
+};
+
+void AggregateFunctions::multi_distinct_count_init(FunctionContext* ctx, StringVal* dst) {
+    dst->is_null = false;
+    dst->len = sizeof(MultiDistinctCountState);
+    dst->ptr = ctx->allocate(dst->len);
+    if (dst->ptr == NULL) {
+        dst->is_null = true;
+        return;
+    }
+    new (dst->ptr) MultiDistinctCountState();
+}
+
+template <typename T>
+void AggregateFunctions::multi_distinct_count_update_int(FunctionContext* ctx, const T& src,
+                                                         StringVal* dst) {
+    if (src.is_null || dst->is_null) {
+        return;
+    }
+    DCHECK_EQ(dst->len, sizeof(MultiDistinctCountState));
+    reinterpret_cast<MultiDistinctCountState*>(dst->ptr)->add(src.val);
+}
+
+void AggregateFunctions::multi_distinct_count_update_datetime(
+        FunctionContext* ctx, const DateTimeVal& src, StringVal* dst) {
+    if (src.is_null || dst->is_null) {
+        return;
+    }
+    DCHECK_EQ(dst->len, sizeof(MultiDistinctCountState));
+    reinterpret_cast<MultiDistinctCountState*>(dst->ptr)->ints.insert(src.packed_time);
+}
+
+void AggregateFunctions::multi_distinct_count_update_string(
+        FunctionContext* ctx, const StringVal& src, StringVal* dst) {
+    if (src.is_null || dst->is_null) {
+        return;
+    }
+    DCHECK_EQ(dst->len, sizeof(MultiDistinctCountState));
+    reinterpret_cast<MultiDistinctCountState*>(dst->ptr)->strings.emplace(
+        reinterpret_cast<const char*>(src.ptr), src.len);
+}
+
+// The serialized set is the bitmap, the integers and the strings, each preceded by its
+// size, and each string preceded by its length.
+void AggregateFunctions::multi_distinct_count_merge(
+        FunctionContext* ctx, const StringVal& src, StringVal* dst) {
+    if (src.is_null || dst->is_null) {
+        return;
+    }
+    DCHECK_EQ(dst->len, sizeof(MultiDistinctCountState));
+    MultiDistinctCountState* state = reinterpret_cast<MultiDistinctCountState*>(dst->ptr);
+    const char* data = reinterpret_cast<const char*>(src.ptr);
+    const char* end = data + src.len;
+    uint32_t size = 0;
+    if (end - data < sizeof(size)) {
+        ctx->set_error("multi_distinct_count: invalid set");
+        return;
+    }
+    memcpy(&size, data, sizeof(size));
+    data += sizeof(size);
+    if (end - data < size || !state->bitmap.merge_serialized(data, size)) {
+        ctx->set_error("multi_distinct_count: invalid set");
+        return;
+    }
+    data += size;
+    if (end - data < sizeof(size)) {
+        ctx->set_error("multi_distinct_count: invalid set");
+        return;
+    }
+    memcpy(&size, data, sizeof(size));
+    data += sizeof(size);
+    if ((end - data) / sizeof(int64_t) < size) {
+        ctx->set_error("multi_distinct_count: invalid set");
+        return;
+    }
+    for (uint32_t i = 0; i < size; ++i) {
+        int64_t value = 0;
+        memcpy(&value, data, sizeof(value));
+        data += sizeof(value);
+        state->ints.insert(value);
+    }
+    if (end - data < sizeof(size)) {
+        ctx->set_error("multi_distinct_count: invalid set");
+        return;
+    }
+    memcpy(&size, data, sizeof(size));
+    data += sizeof(size);
+    for (uint32_t i = 0; i < size; ++i) {
+        uint32_t len = 0;
+        if (end - data < sizeof(len)) {
+            ctx->set_error("multi_distinct_count: invalid set");
+            return;
+        }
+        memcpy(&len, data, sizeof(len));
+        data += sizeof(len);
+        if (end - data < len) {
+            ctx->set_error("multi_distinct_count: invalid set");
+            return;
+        }
+        state->strings.emplace(data, len);
+        data += len;
+    }
+}
+
+StringVal AggregateFunctions::multi_distinct_count_serialize(
+        FunctionContext* ctx, const StringVal& src) {
+    if (src.is_null) {
+        return StringVal::null();
+    }
+    DCHECK_EQ(src.len, sizeof(MultiDistinctCountState));
+    MultiDistinctCountState* state = reinterpret_cast<MultiDistinctCountState*>(src.ptr);
+    uint32_t bitmap_size = state->bitmap.serialized_size();
+    size_t len = sizeof(uint32_t) * 3 + bitmap_size + state->ints.size() * sizeof(int64_t);
+    for (const std::string& value : state->strings) {
+        len += sizeof(uint32_t) + value.size();
+    }
+    StringVal result(ctx, len);
+    if (!result.is_null) {
+        char* data = reinterpret_cast<char*>(result.ptr);
+        memcpy(data, &bitmap_size, sizeof(bitmap_size));
+        data += sizeof(bitmap_size);
+        state->bitmap.serialize(data);
+        data += bitmap_size;
+        uint32_t size = state->ints.size();
+        memcpy(data, &size, sizeof(size));
+        data += sizeof(size);
+        for (int64_t value : state->ints) {
+            memcpy(data, &value, sizeof(value));
+            data += sizeof(value);
+        }
+        size = state->strings.size();
+        memcpy(data, &size, sizeof(size));
+        data += sizeof(size);
+        for (const std::string& value : state->strings) {
+            uint32_t value_len = value.size();
+            memcpy(data, &value_len, sizeof(value_len));
+            data += sizeof(value_len);
+            memcpy(data, value.data(), value_len);
+            data += value_len;
+        }
+        DCHECK_EQ(data, reinterpret_cast<char*>(result.ptr) + len);
+    }
+    state->~MultiDistinctCountState();
+    ctx->free(src.ptr);
+    return result;
+}
+
+BigIntVal AggregateFunctions::multi_distinct_count_finalize(
+        FunctionContext* ctx, const StringVal& src) {
+    if (src.is_null) {
+        return BigIntVal::null();
+    }
+    DCHECK_EQ(src.len, sizeof(MultiDistinctCountState));
+    MultiDistinctCountState* state = reinterpret_cast<MultiDistinctCountState*>(src.ptr);
+    BigIntVal result(state->count());
+    state->~MultiDistinctCountState();
+    ctx->free(src.ptr);
+    return result;
+}
+
+// How multi_distinct_sum() keeps the values of T: 'Value' is the type in the set, and
+// each value is serialized into SERIALIZED_SIZE bytes.
+template <typename T>
+struct MultiDistinctSumTraits {
+    typedef decltype(T::val) Value;
+    static const size_t SERIALIZED_SIZE = sizeof(Value);
+
+    static Value get(const T& src) {
+        return src.val;
+    }
+
+    static void serialize(const Value& value, char* data) {
+        memcpy(data, &value, sizeof(value));
+    }
+
+    static Value deserialize(const char* data) {
+        Value value;
+        memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    static T to_val(const Value& sum) {
+        return T(sum);
+    }
+};
+
+// Decimals are serialized as DecimalVal, which has a fixed size.
+template <>
+struct MultiDistinctSumTraits<DecimalVal> {
+    typedef DecimalValue Value;
+    static const size_t SERIALIZED_SIZE = sizeof(DecimalVal);
+
+    static Value get(const DecimalVal& src) {
+        return DecimalValue::from_decimal_val(src);
+    }
+
+    static void serialize(const Value& value, char* data) {
+        DecimalVal val;
+        value.to_decimal_val(&val);
+        memcpy(data, &val, sizeof(val));
+    }
+
+    static Value deserialize(const char* data) {
+        DecimalVal val;
+        memcpy(&val, data, sizeof(val));
+        return DecimalValue::from_decimal_val(val);
+    }
+
+    static DecimalVal to_val(const Value& sum) {
+        DecimalVal result;
+        sum.to_decimal_val(&result);
+        return result;
+    }
+};
+
+template <typename T>
+struct MultiDistinctSumState {
+    std::unordered_set<typename MultiDistinctSumTraits<T>::Value> values;
+};
+
+template <typename T>
+void AggregateFunctions::multi_distinct_sum_init(FunctionContext* ctx, StringVal* dst) {
+    dst->is_null = false;
+    dst->len = sizeof(MultiDistinctSumState<T>);
+    dst->ptr = ctx->allocate(dst->len);
+    if (dst->ptr == NULL) {
+        dst->is_null = true;
+        return;
+    }
+    new (dst->ptr) MultiDistinctSumState<T>();
+}
+
+template <typename T>
+void AggregateFunctions::multi_distinct_sum_update(FunctionContext* ctx, const T& src,
+                                                   StringVal* dst) {
+    if (src.is_null || dst->is_null) {
+        return;
+    }
+    DCHECK_EQ(dst->len, sizeof(MultiDistinctSumState<T>));
+    reinterpret_cast<MultiDistinctSumState<T>*>(dst->ptr)->values.insert(
+        MultiDistinctSumTraits<T>::get(src));
+}
+
+// The serialized set is the number of values followed by the values.
+template <typename T>
+void AggregateFunctions::multi_distinct_sum_merge(FunctionContext* ctx, const StringVal& src,
+                                                  StringVal* dst) {
+    if (src.is_null || dst->is_null) {
+        return;
+    }
+    DCHECK_EQ(dst->len, sizeof(MultiDistinctSumState<T>));
+    MultiDistinctSumState<T>* state = reinterpret_cast<MultiDistinctSumState<T>*>(dst->ptr);
+    const char* data = reinterpret_cast<const char*>(src.ptr);
+    uint32_t size = 0;
+    if (src.len < sizeof(size)) {
+        ctx->set_error("multi_distinct_sum: invalid set");
+        return;
+    }
+    memcpy(&size, data, sizeof(size));
+    data += sizeof(size);
+    if ((src.len - sizeof(size)) / MultiDistinctSumTraits<T>::SERIALIZED_SIZE < size) {
+        ctx->set_error("multi_distinct_sum: invalid set");
+        return;
+    }
+    for (uint32_t i = 0; i < size; ++i) {
+        state->values.insert(MultiDistinctSumTraits<T>::deserialize(data));
+        data += MultiDistinctSumTraits<T>::SERIALIZED_SIZE;
+    }
+}
+
+template <typename T>
+StringVal AggregateFunctions::multi_distinct_sum_serialize(FunctionContext* ctx,
+                                                           const StringVal& src) {
+    if (src.is_null) {
+        return StringVal::null();
+    }
+    DCHECK_EQ(src.len, sizeof(MultiDistinctSumState<T>));
+    MultiDistinctSumState<T>* state = reinterpret_cast<MultiDistinctSumState<T>*>(src.ptr);
+    uint32_t size = state->values.size();
+    StringVal result(ctx, sizeof(size) + size * MultiDistinctSumTraits<T>::SERIALIZED_SIZE);
+    if (!result.is_null) {
+        char* data = reinterpret_cast<char*>(result.ptr);
+        memcpy(data, &size, sizeof(size));
+        data += sizeof(size);
+        for (const auto& value : state->values) {
+            MultiDistinctSumTraits<T>::serialize(value, data);
+            data += MultiDistinctSumTraits<T>::SERIALIZED_SIZE;
+        }
+    }
+    state->~MultiDistinctSumState<T>();
+    ctx->free(src.ptr);
+    return result;
+}
+
+// Like SUM(DISTINCT), the sum of no values is NULL.
+template <typename T>
+T AggregateFunctions::multi_distinct_sum_finalize(FunctionContext* ctx, const StringVal& src) {
+    if (src.is_null) {
+        return T::null();
+    }
+    DCHECK_EQ(src.len, sizeof(MultiDistinctSumState<T>));
+    MultiDistinctSumState<T>* state = reinterpret_cast<MultiDistinctSumState<T>*>(src.ptr);
+    typedef typename MultiDistinctSumTraits<T>::Value Value;
+    T result = T::null();
+    if (!state->values.empty()) {
+        Value sum = Value();
+        for (const auto& value : state->values) {
+            sum += value;
+        }
+        result = MultiDistinctSumTraits<T>::to_val(sum);
+    }
+    state->~MultiDistinctSumState<T>();
+    ctx->free(src.ptr);
+    return result;
+}
+
+struct PercentileApproxState {
+    PercentileApproxState() : quantile(-1) { }
+
+    TDigest digest;
+    // -1 until the first row was seen
+    double quantile;
+};
+
+void AggregateFunctions::percentile_approx_init(FunctionContext* ctx, StringVal* dst) {
+    dst->is_null = false;
+    dst->len = sizeof(PercentileApproxState);
+    dst->ptr = ctx->allocate(dst->len);
+    if (dst->ptr == NULL) {
+        dst->is_null = true;
+        return;
+    }
+    new (dst->ptr) PercentileApproxState();
+}
+
+void AggregateFunctions::percentile_approx_update(FunctionContext* ctx, const DoubleVal& src,
+        const DoubleVal& quantile, StringVal* dst) {
+    if (src.is_null || dst->is_null) {
+        return;
+    }
+    DCHECK_EQ(dst->len, sizeof(PercentileApproxState));
+    PercentileApproxState* state = reinterpret_cast<PercentileApproxState*>(dst->ptr);
+    if (state->quantile < 0) {
+        if (quantile.is_null || quantile.val < 0 || quantile.val > 1) {
+            ctx->set_error("percentile_approx: quantile must be between 0 and 1");
+            return;
+        }
+        state->quantile = quantile.val;
+    }
+    state->digest.add(src.val);
+}
+
+void AggregateFunctions::percentile_approx_merge(FunctionContext* ctx, const StringVal& src,
+                                                 StringVal* dst) {
+    if (src.is_null || dst->is_null) {
+        return;
+    }
+    DCHECK_EQ(dst->len, sizeof(PercentileApproxState));
+    PercentileApproxState* state = reinterpret_cast<PercentileApproxState*>(dst->ptr);
+    double quantile = -1;
+    if (src.len < sizeof(quantile)) {
+        ctx->set_error("percentile_approx: invalid intermediate value");
+        return;
+    }
+    memcpy(&quantile, src.ptr, sizeof(quantile));
+    if (!state->digest.merge_serialized(reinterpret_cast<const char*>(src.ptr) + sizeof(quantile),
+                                        src.len - sizeof(quantile))) {
+        ctx->set_error("percentile_approx: invalid intermediate value");
+        return;
+    }
+    if (state->quantile < 0) {
+        state->quantile = quantile;
+    }
+}
+
+StringVal AggregateFunctions::percentile_approx_serialize(FunctionContext* ctx,
+                                                          const StringVal& src) {
+    if (src.is_null) {
+        return StringVal::null();
+    }
+    DCHECK_EQ(src.len, sizeof(PercentileApproxState));
+    PercentileApproxState* state = reinterpret_cast<PercentileApproxState*>(src.ptr);
+    StringVal result(ctx, sizeof(state->quantile) + state->digest.serialized_size());
+    if (!result.is_null) {
+        memcpy(result.ptr, &state->quantile, sizeof(state->quantile));
+        state->digest.serialize(reinterpret_cast<char*>(result.ptr) + sizeof(state->quantile));
+    }
+    state->~PercentileApproxState();
+    ctx->free(src.ptr);
+    return result;
+}
+
+DoubleVal AggregateFunctions::percentile_approx_finalize(FunctionContext* ctx,
+                                                         const StringVal& src) {
+    if (src.is_null) {
+        return DoubleVal::null();
+    }
+    DCHECK_EQ(src.len, sizeof(PercentileApproxState));
+    PercentileApproxState* state = reinterpret_cast<PercentileApproxState*>(src.ptr);
+    DoubleVal result = DoubleVal::null();
+    if (!state->digest.empty() && state->quantile >= 0) {
+        result = DoubleVal(state->digest.quantile(state->quantile));
+    }
+    state->~PercentileApproxState();
+    ctx->free(src.ptr);
+    return result;
+}
+
 // An implementation of a simple single pass variance algorithm. A standard UDA must
 // be single pass (i.e. does not scan the table more than once), so the most canonical
 // two pass approach is not practical.
@@ -1520,6 +2007,65 @@ template void AggregateFunctions::hll_update(
 template void AggregateFunctions::hll_update(
     FunctionContext*, const DecimalVal&, StringVal*);
 
+template void AggregateFunctions::bitmap_update_int(
+    FunctionContext*, const TinyIntVal&, StringVal*);
+template void AggregateFunctions::bitmap_update_int(
+    FunctionContext*, const SmallIntVal&, StringVal*);
+template void AggregateFunctions::bitmap_update_int(
+    FunctionContext*, const IntVal&, StringVal*);
+template void AggregateFunctions::bitmap_update_int(
+    FunctionContext*, const BigIntVal&, StringVal*);
+
+template void AggregateFunctions::multi_distinct_count_update_int(
+    FunctionContext*, const TinyIntVal&, StringVal*);
+template void AggregateFunctions::multi_distinct_count_update_int(
+    FunctionContext*, const SmallIntVal&, StringVal*);
+template void AggregateFunctions::multi_distinct_count_update_int(
+    FunctionContext*, const IntVal&, StringVal*);
+template void AggregateFunctions::multi_distinct_count_update_int(
+    FunctionContext*, const BigIntVal&, StringVal*);
+
+template void AggregateFunctions::multi_distinct_sum_init<BigIntVal>(
+    FunctionContext*, StringVal*);
+template void AggregateFunctions::multi_distinct_sum_update(
+    FunctionContext*, const BigIntVal&, StringVal*);
+template void AggregateFunctions::multi_distinct_sum_merge<BigIntVal>(
+    FunctionContext*, const StringVal&, StringVal*);
+template StringVal AggregateFunctions::multi_distinct_sum_serialize<BigIntVal>(
+    FunctionContext*, const StringVal&);
+template BigIntVal AggregateFunctions::multi_distinct_sum_finalize<BigIntVal>(
+    FunctionContext*, const StringVal&);
+template void AggregateFunctions::multi_distinct_sum_init<LargeIntVal>(
+    FunctionContext*, StringVal*);
+template void AggregateFunctions::multi_distinct_sum_update(
+    FunctionContext*, const LargeIntVal&, StringVal*);
+template void AggregateFunctions::multi_distinct_sum_merge<LargeIntVal>(
+    FunctionContext*, const StringVal&, StringVal*);
+template StringVal AggregateFunctions::multi_distinct_sum_serialize<LargeIntVal>(
+    FunctionContext*, const StringVal&);
+template LargeIntVal AggregateFunctions::multi_distinct_sum_finalize<LargeIntVal>(
+    FunctionContext*, const StringVal&);
+template void AggregateFunctions::multi_distinct_sum_init<DoubleVal>(
+    FunctionContext*, StringVal*);
+template void AggregateFunctions::multi_distinct_sum_update(
+    FunctionContext*, const DoubleVal&, StringVal*);
+template void AggregateFunctions::multi_distinct_sum_merge<DoubleVal>(
+    FunctionContext*, const StringVal&, StringVal*);
+template StringVal AggregateFunctions::multi_distinct_sum_serialize<DoubleVal>(
+    FunctionContext*, const StringVal&);
+template DoubleVal AggregateFunctions::multi_distinct_sum_finalize<DoubleVal>(
+    FunctionContext*, const StringVal&);
+template void AggregateFunctions::multi_distinct_sum_init<DecimalVal>(
+    FunctionContext*, StringVal*);
+template void AggregateFunctions::multi_distinct_sum_update(
+    FunctionContext*, const DecimalVal&, StringVal*);
+template void AggregateFunctions::multi_distinct_sum_merge<DecimalVal>(
+    FunctionContext*, const StringVal&, StringVal*);
+template StringVal AggregateFunctions::multi_distinct_sum_serialize<DecimalVal>(
+    FunctionContext*, const StringVal&);
+template DecimalVal AggregateFunctions::multi_distinct_sum_finalize<DecimalVal>(
+    FunctionContext*, const StringVal&);
+
 template void AggregateFunctions::knuth_var_update(
         FunctionContext*, const TinyIntVal&, StringVal*);
 template void AggregateFunctions::knuth_var_update(
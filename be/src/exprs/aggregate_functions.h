@@ -118,6 +118,13 @@ dst);
     static palo_udf::DecimalVal decimal_avg_finalize(palo_udf::FunctionContext* ctx,
          const palo_udf::StringVal& val);
 
+    // Sum for decimals. Uses the intermediate value of avg, see the decimal_avg_*()
+    // functions above, so that the sum is kept as a DecimalSum.
+    static palo_udf::DecimalVal decimal_sum_get_value(palo_udf::FunctionContext* ctx,
+         const palo_udf::StringVal& val);
+    static palo_udf::DecimalVal decimal_sum_finalize(palo_udf::FunctionContext* ctx,
+         const palo_udf::StringVal& val);
+
     // SumUpdate, SumMerge
     template <typename SRC_VAL, typename DST_VAL>
     static void sum(palo_udf::FunctionContext*, const SRC_VAL& src, DST_VAL* dst);
@@ -283,6 +290,86 @@ dst);
     // calculate result
     static int64_t hll_algorithm(const palo_udf::StringVal& src);
     static void hll_union_parse_and_cal(HllSetResolver& resolver, StringVal* dst);
+
+    // Exact distinct count with a BitmapValue, e.g. bitmap_count(user_id), or a union of
+    // bitmaps serialized by bitmap_union() and stored as strings. The intermediate
+    // value holds the BitmapValue object until it is serialized.
+    static void bitmap_init(palo_udf::FunctionContext*, palo_udf::StringVal* dst);
+    // adds an integer in [0, 2^32), other values are ignored
+    template <typename T>
+    static void bitmap_update_int(palo_udf::FunctionContext*, const T& src,
+                                  palo_udf::StringVal* dst);
+    // merges a serialized bitmap
+    static void bitmap_update(palo_udf::FunctionContext*, const palo_udf::StringVal& src,
+                              palo_udf::StringVal* dst);
+    static void bitmap_merge(palo_udf::FunctionContext*, const palo_udf::StringVal& src,
+                             palo_udf::StringVal* dst);
+    // serializes and frees the bitmap, also the finalize function of bitmap_union()
+    static palo_udf::StringVal bitmap_serialize(palo_udf::FunctionContext*,
+                                                const palo_udf::StringVal& src);
+    static palo_udf::BigIntVal bitmap_count_finalize(palo_udf::FunctionContext*,
+                                                     const palo_udf::StringVal& src);
+
+    // multi_distinct_count(col) counts the distinct values of 'col' per group like
+    // COUNT(DISTINCT col), but as an ordinary aggregate whose intermediate value is the
+    // set of values. The FE rewrites queries with several COUNT(DISTINCT) over different
+    // columns to it, so that they need no grouping by the distinct columns. Integers in
+    // [0, 2^32) are kept in a BitmapValue, other values in hash sets.
+    static void multi_distinct_count_init(palo_udf::FunctionContext*,
+                                          palo_udf::StringVal* dst);
+    template <typename T>
+    static void multi_distinct_count_update_int(palo_udf::FunctionContext*, const T& src,
+                                                palo_udf::StringVal* dst);
+    static void multi_distinct_count_update_datetime(palo_udf::FunctionContext*,
+                                                     const palo_udf::DateTimeVal& src,
+                                                     palo_udf::StringVal* dst);
+    static void multi_distinct_count_update_string(palo_udf::FunctionContext*,
+                                                   const palo_udf::StringVal& src,
+                                                   palo_udf::StringVal* dst);
+    // merges a set serialized by multi_distinct_count_serialize()
+    static void multi_distinct_count_merge(palo_udf::FunctionContext*,
+                                           const palo_udf::StringVal& src,
+                                           palo_udf::StringVal* dst);
+    // serializes and frees the set
+    static palo_udf::StringVal multi_distinct_count_serialize(palo_udf::FunctionContext*,
+                                                              const palo_udf::StringVal& src);
+    static palo_udf::BigIntVal multi_distinct_count_finalize(palo_udf::FunctionContext*,
+                                                             const palo_udf::StringVal& src);
+
+    // multi_distinct_sum(col) is the SUM(DISTINCT col) counterpart of
+    // multi_distinct_count(): the intermediate value is the set of values, so unlike
+    // sum_distinct() it can be serialized and merged. T is BigIntVal, LargeIntVal,
+    // DoubleVal or DecimalVal.
+    template <typename T>
+    static void multi_distinct_sum_init(palo_udf::FunctionContext*, palo_udf::StringVal* dst);
+    template <typename T>
+    static void multi_distinct_sum_update(palo_udf::FunctionContext*, const T& src,
+                                          palo_udf::StringVal* dst);
+    template <typename T>
+    static void multi_distinct_sum_merge(palo_udf::FunctionContext*,
+                                         const palo_udf::StringVal& src,
+                                         palo_udf::StringVal* dst);
+    template <typename T>
+    static palo_udf::StringVal multi_distinct_sum_serialize(palo_udf::FunctionContext*,
+                                                            const palo_udf::StringVal& src);
+    template <typename T>
+    static T multi_distinct_sum_finalize(palo_udf::FunctionContext*,
+                                         const palo_udf::StringVal& src);
+
+    // percentile_approx(value, quantile) with a TDigest. Like the bitmap functions, the
+    // intermediate value holds the digest object until it is serialized.
+    static void percentile_approx_init(palo_udf::FunctionContext*, palo_udf::StringVal* dst);
+    static void percentile_approx_update(palo_udf::FunctionContext*,
+                                         const palo_udf::DoubleVal& src,
+                                         const palo_udf::DoubleVal& quantile,
+                                         palo_udf::StringVal* dst);
+    static void percentile_approx_merge(palo_udf::FunctionContext*,
+                                        const palo_udf::StringVal& src,
+                                        palo_udf::StringVal* dst);
+    static palo_udf::StringVal percentile_approx_serialize(palo_udf::FunctionContext*,
+                                                           const palo_udf::StringVal& src);
+    static palo_udf::DoubleVal percentile_approx_finalize(palo_udf::FunctionContext*,
+                                                          const palo_udf::StringVal& src);
 };
 
 }
@@ -22,6 +22,7 @@
 
 #include "codegen/llvm_codegen.h"
 #include "codegen/codegen_anyval.h"
+#include "exprs/expr_column.h"
 #include "runtime/runtime_state.h"
 
 using llvm::BasicBlock;
@@ -174,6 +175,187 @@ BINARY_BIT_FNS(BitXorExpr, ^)
 
 BITNOT_FNS()
 
+struct AddOp {
+    template <typename T> static T apply(T a, T b) { return a + b; }
+};
+
+struct SubOp {
+    template <typename T> static T apply(T a, T b) { return a - b; }
+};
+
+struct MulOp {
+    template <typename T> static T apply(T a, T b) { return a * b; }
+};
+
+struct DivOp {
+    template <typename T> static T apply(T a, T b) { return a / b; }
+};
+
+struct ModOp {
+    template <typename T> static T apply(T a, T b) { return a % b; }
+    static float apply(float a, float b) { return fmod(a, b); }
+    static double apply(double a, double b) { return fmod(a, b); }
+};
+
+struct BitAndOp {
+    template <typename T> static T apply(T a, T b) { return a & b; }
+};
+
+struct BitOrOp {
+    template <typename T> static T apply(T a, T b) { return a | b; }
+};
+
+struct BitXorOp {
+    template <typename T> static T apply(T a, T b) { return a ^ b; }
+};
+
+// Batch versions of BINARY_OP_FN and BINARY_OP_CHECK_ZERO_FN: a row is null if an
+// operand is null or, if CHECK_ZERO, the right one is zero.
+template <typename T, typename OP, bool CHECK_ZERO>
+static void binary_op_batch(Expr* expr, ExprContext* context, RowBatch* batch,
+                            const int* sel, int num_rows, ExprColumn* result) {
+    ExprColumn lhs;
+    ExprColumn rhs;
+    expr->get_child(0)->evaluate_batch(context, batch, sel, num_rows, &lhs);
+    expr->get_child(1)->evaluate_batch(context, batch, sel, num_rows, &rhs);
+    result->reset(expr->type(), num_rows);
+    const T* v1 = lhs.values<T>();
+    const T* v2 = rhs.values<T>();
+    const uint8_t* nulls1 = lhs.nulls();
+    const uint8_t* nulls2 = rhs.nulls();
+    T* values = result->values<T>();
+    uint8_t* nulls = result->nulls();
+    for (int i = 0; i < num_rows; ++i) {
+        nulls[i] = nulls1[i] | nulls2[i] | (CHECK_ZERO && v2[i] == 0);
+        if (!nulls[i]) {
+            values[i] = OP::apply(v1[i], v2[i]);
+        }
+    }
+}
+
+// The batch functions are only used if the children have the type of 'expr', which the
+// Get*Val() functions take for granted.
+static bool children_have_expr_type(Expr* expr) {
+    for (int i = 0; i < expr->get_num_children(); ++i) {
+        if (expr->get_child(i)->type().type != expr->type().type) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Runs binary_op_batch() for the integer types or, if WITH_FLOAT, also for the floating
+// point types. Returns false if the type of 'expr' is none of them.
+template <typename OP, bool CHECK_ZERO, bool WITH_FLOAT>
+static bool dispatch_binary_op_batch(Expr* expr, ExprContext* context, RowBatch* batch,
+                                     const int* sel, int num_rows, ExprColumn* result) {
+    if (!children_have_expr_type(expr)) {
+        return false;
+    }
+    switch (expr->type().type) {
+    case TYPE_TINYINT:
+        binary_op_batch<int8_t, OP, CHECK_ZERO>(expr, context, batch, sel, num_rows, result);
+        return true;
+    case TYPE_SMALLINT:
+        binary_op_batch<int16_t, OP, CHECK_ZERO>(expr, context, batch, sel, num_rows, result);
+        return true;
+    case TYPE_INT:
+        binary_op_batch<int32_t, OP, CHECK_ZERO>(expr, context, batch, sel, num_rows, result);
+        return true;
+    case TYPE_BIGINT:
+        binary_op_batch<int64_t, OP, CHECK_ZERO>(expr, context, batch, sel, num_rows, result);
+        return true;
+    case TYPE_LARGEINT:
+        binary_op_batch<__int128, OP, CHECK_ZERO>(expr, context, batch, sel, num_rows, result);
+        return true;
+    default:
+        break;
+    }
+    if (!WITH_FLOAT) {
+        return false;
+    }
+    switch (expr->type().type) {
+    case TYPE_FLOAT:
+        binary_op_batch<float, OP, CHECK_ZERO>(expr, context, batch, sel, num_rows, result);
+        return true;
+    case TYPE_DOUBLE:
+        binary_op_batch<double, OP, CHECK_ZERO>(expr, context, batch, sel, num_rows, result);
+        return true;
+    default:
+        return false;
+    }
+}
+
+#define BINARY_OP_BATCH_FN(CLASS, OP, CHECK_ZERO, WITH_FLOAT) \
+    void CLASS::evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel, \
+                               int num_rows, ExprColumn* result) { \
+        if (!dispatch_binary_op_batch<OP, CHECK_ZERO, WITH_FLOAT>( \
+                this, context, batch, sel, num_rows, result)) { \
+            Expr::evaluate_batch(context, batch, sel, num_rows, result); \
+        } \
+    }
+
+BINARY_OP_BATCH_FN(AddExpr, AddOp, false, true)
+BINARY_OP_BATCH_FN(SubExpr, SubOp, false, true)
+BINARY_OP_BATCH_FN(MulExpr, MulOp, false, true)
+BINARY_OP_BATCH_FN(DivExpr, DivOp, true, true)
+BINARY_OP_BATCH_FN(BitAndExpr, BitAndOp, false, false)
+BINARY_OP_BATCH_FN(BitOrExpr, BitOrOp, false, false)
+BINARY_OP_BATCH_FN(BitXorExpr, BitXorOp, false, false)
+
+void ModExpr::evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                             int num_rows, ExprColumn* result) {
+    // Like get_float_val() and get_double_val(), fmod() doesn't check for zero.
+    if (_type.type == TYPE_FLOAT && children_have_expr_type(this)) {
+        binary_op_batch<float, ModOp, false>(this, context, batch, sel, num_rows, result);
+    } else if (_type.type == TYPE_DOUBLE && children_have_expr_type(this)) {
+        binary_op_batch<double, ModOp, false>(this, context, batch, sel, num_rows, result);
+    } else if (!dispatch_binary_op_batch<ModOp, true, false>(
+            this, context, batch, sel, num_rows, result)) {
+        Expr::evaluate_batch(context, batch, sel, num_rows, result);
+    }
+}
+
+template <typename T>
+static void bit_not_batch(Expr* expr, ExprContext* context, RowBatch* batch,
+                          const int* sel, int num_rows, ExprColumn* result) {
+    ExprColumn child;
+    expr->get_child(0)->evaluate_batch(context, batch, sel, num_rows, &child);
+    result->reset(expr->type(), num_rows);
+    const T* v = child.values<T>();
+    T* values = result->values<T>();
+    memcpy(result->nulls(), child.nulls(), num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+        values[i] = ~v[i];
+    }
+}
+
+void BitNotExpr::evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result) {
+    if (children_have_expr_type(this)) {
+        switch (_type.type) {
+        case TYPE_TINYINT:
+            bit_not_batch<int8_t>(this, context, batch, sel, num_rows, result);
+            return;
+        case TYPE_SMALLINT:
+            bit_not_batch<int16_t>(this, context, batch, sel, num_rows, result);
+            return;
+        case TYPE_INT:
+            bit_not_batch<int32_t>(this, context, batch, sel, num_rows, result);
+            return;
+        case TYPE_BIGINT:
+            bit_not_batch<int64_t>(this, context, batch, sel, num_rows, result);
+            return;
+        case TYPE_LARGEINT:
+            bit_not_batch<__int128>(this, context, batch, sel, num_rows, result);
+            return;
+        default:
+            break;
+        }
+    }
+    Expr::evaluate_batch(context, batch, sel, num_rows, result);
+}
+
 // IR codegen for compound add predicates.  Compound predicate has non trivial 
 // null handling as well as many branches so this is pretty complicated.  The IR 
 // for x && y is:
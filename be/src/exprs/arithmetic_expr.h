@@ -63,6 +63,8 @@ public:
     virtual LargeIntVal get_large_int_val(ExprContext* context, TupleRow*);
     virtual FloatVal get_float_val(ExprContext* context, TupleRow*);
     virtual DoubleVal get_double_val(ExprContext* context, TupleRow*);
+    virtual void evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result);
 };
 
 class SubExpr : public ArithmeticExpr {
@@ -80,6 +82,8 @@ public:
     virtual LargeIntVal get_large_int_val(ExprContext* context, TupleRow*);
     virtual FloatVal get_float_val(ExprContext* context, TupleRow*);
     virtual DoubleVal get_double_val(ExprContext* context, TupleRow*);
+    virtual void evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result);
 };
 
 class MulExpr : public ArithmeticExpr {
@@ -97,6 +101,8 @@ public:
     virtual LargeIntVal get_large_int_val(ExprContext* context, TupleRow*);
     virtual FloatVal get_float_val(ExprContext* context, TupleRow*);
     virtual DoubleVal get_double_val(ExprContext* context, TupleRow*);
+    virtual void evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result);
 };
 
 class DivExpr : public ArithmeticExpr {
@@ -114,6 +120,8 @@ public:
     virtual LargeIntVal get_large_int_val(ExprContext* context, TupleRow*);
     virtual FloatVal get_float_val(ExprContext* context, TupleRow*);
     virtual DoubleVal get_double_val(ExprContext* context, TupleRow*);
+    virtual void evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result);
 };
 
 class ModExpr : public ArithmeticExpr {
@@ -131,6 +139,8 @@ public:
     virtual LargeIntVal get_large_int_val(ExprContext* context, TupleRow*);
     virtual FloatVal get_float_val(ExprContext* context, TupleRow*);
     virtual DoubleVal get_double_val(ExprContext* context, TupleRow*);
+    virtual void evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result);
 };
 
 class BitAndExpr : public ArithmeticExpr {
@@ -146,6 +156,8 @@ public:
     virtual IntVal get_int_val(ExprContext* context, TupleRow*);
     virtual BigIntVal get_big_int_val(ExprContext* context, TupleRow*);
     virtual LargeIntVal get_large_int_val(ExprContext* context, TupleRow*);
+    virtual void evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result);
 };
 
 class BitOrExpr : public ArithmeticExpr {
@@ -161,6 +173,8 @@ public:
     virtual IntVal get_int_val(ExprContext* context, TupleRow*);
     virtual BigIntVal get_big_int_val(ExprContext* context, TupleRow*);
     virtual LargeIntVal get_large_int_val(ExprContext* context, TupleRow*);
+    virtual void evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result);
 };
 
 class BitXorExpr : public ArithmeticExpr {
@@ -176,6 +190,8 @@ public:
     virtual IntVal get_int_val(ExprContext* context, TupleRow*);
     virtual BigIntVal get_big_int_val(ExprContext* context, TupleRow*);
     virtual LargeIntVal get_large_int_val(ExprContext* context, TupleRow*);
+    virtual void evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result);
 };
 
 class BitNotExpr : public ArithmeticExpr {
@@ -191,6 +207,8 @@ public:
     virtual IntVal get_int_val(ExprContext* context, TupleRow*);
     virtual BigIntVal get_big_int_val(ExprContext* context, TupleRow*);
     virtual LargeIntVal get_large_int_val(ExprContext* context, TupleRow*);
+    virtual void evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result);
 };
 
 }
@@ -22,6 +22,9 @@
 #include <math.h>
 #include <stdint.h>
 #include <string>
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
 
 static char s_encoding_table[] = {
     'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H',
@@ -59,6 +62,63 @@ static int s_mod_table[] = {0, 2, 1};
 
 namespace palo {
 
+#ifdef __SSSE3__
+// Encode 12 input bytes (loaded as 16) into 16 output characters.
+// Bytes are spread into 4 lanes of 6 bits with a shuffle and two multiplies,
+// then turned into ASCII by adding a per-range offset picked with pshufb.
+static inline __m128i encode_block(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(
+                10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    const __m128i indices = _mm_or_si128(t1, t3);
+
+    const __m128i offsets = _mm_setr_epi8(
+            65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+    __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    range = _mm_sub_epi8(range, _mm_cmpgt_epi8(indices, _mm_set1_epi8(25)));
+    return _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range));
+}
+
+// Decode 16 input characters into 12 bytes (stored as 16). Returns false
+// without writing anything if the block holds a character outside of the
+// base64 alphabet, including padding and separators.
+static inline bool decode_block(const char* data, char* out) {
+    const __m128i lut_lo = _mm_setr_epi8(
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+            0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lut_hi = _mm_setr_epi8(
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask_2f = _mm_set1_epi8(0x2f);
+
+    __m128i str = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    const __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2f);
+    const __m128i lo_nibbles = _mm_and_si128(str, mask_2f);
+    const __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+    const __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+    const __m128i invalid = _mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128());
+    if (_mm_movemask_epi8(invalid) != 0xFFFF) {
+        return false;
+    }
+
+    const __m128i eq_2f = _mm_cmpeq_epi8(str, mask_2f);
+    const __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+    str = _mm_add_epi8(str, roll);
+
+    const __m128i merged = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+    __m128i packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    packed = _mm_shuffle_epi8(packed, _mm_setr_epi8(
+                2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), packed);
+    return true;
+}
+#endif
+
 size_t base64_encode2(const unsigned char *data,
                      size_t length,
                      unsigned char *encoded_data) {
@@ -68,7 +128,17 @@ size_t base64_encode2(const unsigned char *data,
         return 0;
     }
 
-    for (uint32_t i = 0, j = 0; i < length;) {
+    uint32_t i = 0;
+    uint32_t j = 0;
+#ifdef __SSSE3__
+    // each block reads 16 bytes but only consumes 12
+    for (; i + 16 <= length; i += 12, j += 16) {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(encoded_data + j), encode_block(in));
+    }
+#endif
+
+    for (; i < length;) {
         uint32_t octet_a = i < length ? data[i++] : 0;
         uint32_t octet_b = i < length ? data[i++] : 0;
         uint32_t octet_c = i < length ? data[i++] : 0;
@@ -97,8 +167,21 @@ int64_t base64_decode2(
     int j = 0;
     int k = 0;
 
+#ifdef __SSSE3__
+    // Decode plain alphabet runs 16 characters at a time. The first block with
+    // padding, separators or invalid characters hands over to the loop below,
+    // which starts on a quantum boundary because 16 is a multiple of 4.
+    // The output buffer holds at least 'length' bytes, so the 16 byte store of
+    // a 12 byte block never runs past it.
+    while (length >= 16 && decode_block(current, decoded_data + j)) {
+        current += 16;
+        length -= 16;
+        j += 12;
+    }
+#endif
+
     // run through the whole string, converting as we go
-    while ((ch = *current++) != '\0' && length-- > 0) {
+    while (length-- > 0 && (ch = (unsigned char)*current++) != '\0') {
         if (ch == base64_pad) {
             if (*current != '=' && (i % 4) == 1) {
                 return -1;
@@ -24,6 +24,7 @@
 
 #include "codegen/llvm_codegen.h"
 #include "codegen/codegen_anyval.h"
+#include "exprs/expr_column.h"
 #include "util/debug_util.h"
 #include "gen_cpp/Exprs_types.h"
 #include "runtime/runtime_state.h"
@@ -594,4 +595,52 @@ Status EqStringValPred::get_codegend_compute_fn(RuntimeState* state, llvm::Funct
 
 #endif
 
+// Batch versions of the functions above, comparing the slot representations of the
+// operands. Falls back to the per-row functions if an operand isn't in the expected
+// representation.
+#define BINARY_PRED_BATCH_FN(CLASS, NATIVE_TYPE, OP) \
+    void CLASS::evaluate_batch(ExprContext* ctx, RowBatch* batch, const int* sel, \
+                               int num_rows, ExprColumn* result) { \
+        if (_children[0]->type().get_slot_size() != sizeof(NATIVE_TYPE) \
+                || _children[1]->type().get_slot_size() != sizeof(NATIVE_TYPE)) { \
+            Expr::evaluate_batch(ctx, batch, sel, num_rows, result); \
+            return; \
+        } \
+        ExprColumn lhs; \
+        ExprColumn rhs; \
+        _children[0]->evaluate_batch(ctx, batch, sel, num_rows, &lhs); \
+        _children[1]->evaluate_batch(ctx, batch, sel, num_rows, &rhs); \
+        result->reset(_type, num_rows); \
+        const NATIVE_TYPE* v1 = lhs.values<NATIVE_TYPE>(); \
+        const NATIVE_TYPE* v2 = rhs.values<NATIVE_TYPE>(); \
+        const uint8_t* nulls1 = lhs.nulls(); \
+        const uint8_t* nulls2 = rhs.nulls(); \
+        bool* values = result->values<bool>(); \
+        uint8_t* nulls = result->nulls(); \
+        for (int i = 0; i < num_rows; ++i) { \
+            nulls[i] = nulls1[i] | nulls2[i]; \
+            values[i] = !nulls[i] && (v1[i] OP v2[i]); \
+        } \
+    }
+
+#define BINARY_PRED_BATCH_FNS(TYPE, NATIVE_TYPE) \
+    BINARY_PRED_BATCH_FN(Eq##TYPE##Pred, NATIVE_TYPE, ==) \
+    BINARY_PRED_BATCH_FN(Ne##TYPE##Pred, NATIVE_TYPE, !=) \
+    BINARY_PRED_BATCH_FN(Lt##TYPE##Pred, NATIVE_TYPE, <) \
+    BINARY_PRED_BATCH_FN(Le##TYPE##Pred, NATIVE_TYPE, <=) \
+    BINARY_PRED_BATCH_FN(Gt##TYPE##Pred, NATIVE_TYPE, >) \
+    BINARY_PRED_BATCH_FN(Ge##TYPE##Pred, NATIVE_TYPE, >=)
+
+BINARY_PRED_BATCH_FNS(BooleanVal, bool)
+BINARY_PRED_BATCH_FNS(TinyIntVal, int8_t)
+BINARY_PRED_BATCH_FNS(SmallIntVal, int16_t)
+BINARY_PRED_BATCH_FNS(IntVal, int32_t)
+BINARY_PRED_BATCH_FNS(BigIntVal, int64_t)
+BINARY_PRED_BATCH_FNS(LargeIntVal, __int128)
+BINARY_PRED_BATCH_FNS(FloatVal, float)
+BINARY_PRED_BATCH_FNS(DoubleVal, double)
+BINARY_PRED_BATCH_FNS(StringVal, StringValue)
+BINARY_PRED_BATCH_FNS(DateTimeVal, DateTimeValue)
+BINARY_PRED_BATCH_FNS(DecimalVal, DecimalValue)
+
 }
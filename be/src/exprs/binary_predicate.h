@@ -55,6 +55,8 @@ protected:
         \
         virtual Status get_codegend_compute_fn(RuntimeState* state, llvm::Function** fn); \
         virtual BooleanVal get_boolean_val(ExprContext* context, TupleRow*); \
+        virtual void evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel, \
+                                    int num_rows, ExprColumn* result); \
     };
 
 #define BIN_PRED_CLASSES_DEFINE(TYPE) \
@@ -20,9 +20,14 @@
 
 #include "exprs/case_expr.h"
 
+#include <algorithm>
+
 #include "codegen/llvm_codegen.h"
 #include "codegen/codegen_anyval.h"
 #include "exprs/anyval_util.h"
+#include "exprs/expr_column.h"
+#include "runtime/raw_value.h"
+#include "runtime/row_batch.h"
 #include "runtime/runtime_state.h"
 #include "gen_cpp/Exprs_types.h"
 
@@ -43,8 +48,18 @@ struct CaseExprState {
     // pool in Prepare().
     AnyVal* case_val;
     AnyVal* when_val;
+
+    // Used by evaluate_batch() if not NULL: the child to return for the case value
+    // lookup_min + i is lookup[i], -1 meaning NULL. Case values outside the table go to
+    // the ELSE expr (or NULL) too. Allocated from the function context in open().
+    int* lookup;
+    int64_t lookup_min;
+    int64_t lookup_size;
 };
 
+// The maximal number of entries of CaseExprState::lookup
+static const int64_t MAX_LOOKUP_SIZE = 4096;
+
 CaseExpr::CaseExpr(const TExprNode& node) : 
         Expr(node),
         _has_case_expr(node.case_expr.has_case_expr),
@@ -69,9 +84,11 @@ Status CaseExpr::open(
     CaseExprState* case_state =
         reinterpret_cast<CaseExprState*>(fn_ctx->allocate(sizeof(CaseExprState)));
     fn_ctx->set_function_state(FunctionContext::THREAD_LOCAL, case_state);
+    case_state->lookup = NULL;
     if (_has_case_expr) {
         case_state->case_val = create_any_val(state->obj_pool(), _children[0]->type());
         case_state->when_val = create_any_val(state->obj_pool(), _children[1]->type());
+        build_lookup(ctx, fn_ctx, case_state);
     } else {
         case_state->case_val = create_any_val(state->obj_pool(), TypeDescriptor(TYPE_BOOLEAN));
         case_state->when_val = create_any_val(state->obj_pool(), _children[0]->type());
@@ -84,7 +101,11 @@ void CaseExpr::close(
         FunctionContext::FunctionStateScope scope) {
     if (_fn_context_index != -1) {
         FunctionContext* fn_ctx = ctx->fn_context(_fn_context_index);
-        void* case_state = fn_ctx->get_function_state(FunctionContext::THREAD_LOCAL);
+        CaseExprState* case_state = reinterpret_cast<CaseExprState*>(
+            fn_ctx->get_function_state(FunctionContext::THREAD_LOCAL));
+        if (case_state != NULL && case_state->lookup != NULL) {
+            fn_ctx->free(reinterpret_cast<uint8_t*>(case_state->lookup));
+        }
         fn_ctx->free(reinterpret_cast<uint8_t*>(case_state));
     }
     Expr::close(state, ctx, scope);
@@ -442,5 +463,169 @@ CASE_COMPUTE_FN_WAPPER(StringVal, string_val)
 CASE_COMPUTE_FN_WAPPER(DateTimeVal, datetime_val)
 CASE_COMPUTE_FN_WAPPER(DecimalVal, decimal_val)
 
+// Sets branches[i] to the child that CaseExprState::lookup gives for row i of 'case_col'.
+template <typename T>
+static void lookup_branches(const ExprColumn& case_col, const CaseExprState* state,
+                            int else_branch, int* branches) {
+    const T* values = case_col.values<T>();
+    const uint8_t* nulls = case_col.nulls();
+    for (int i = 0; i < case_col.num_rows(); ++i) {
+        uint64_t offset = static_cast<uint64_t>(static_cast<int64_t>(values[i]))
+                - static_cast<uint64_t>(state->lookup_min);
+        bool hit = !nulls[i] & (offset < static_cast<uint64_t>(state->lookup_size));
+        int branch = state->lookup[hit ? offset : 0];
+        branches[i] = hit ? branch : else_branch;
+    }
+}
+
+void CaseExpr::evaluate_batch(ExprContext* ctx, RowBatch* batch, const int* sel,
+                              int num_rows, ExprColumn* result) {
+    int num_children = _children.size();
+    int loop_start = has_case_expr() ? 1 : 0;
+    int loop_end = has_else_expr() ? num_children - 1 : num_children;
+    bool batchable = true;
+    for (int i = loop_start; batchable && i < loop_end; i += 2) {
+        batchable = _children[i + 1]->type().get_slot_size() == _type.get_slot_size()
+            && (!has_case_expr() || _children[i]->type() == _children[0]->type());
+    }
+    if (has_else_expr()) {
+        batchable = batchable
+            && _children[num_children - 1]->type().get_slot_size() == _type.get_slot_size();
+    }
+    if (!batchable || num_rows == 0) {
+        Expr::evaluate_batch(ctx, batch, sel, num_rows, result);
+        return;
+    }
+
+    // The child whose value every row gets
+    int else_branch = has_else_expr() ? num_children - 1 : -1;
+    std::vector<int> branches(num_rows, else_branch);
+    ExprColumn case_col;
+    if (has_case_expr()) {
+        _children[0]->evaluate_batch(ctx, batch, sel, num_rows, &case_col);
+        FunctionContext* fn_ctx = ctx->fn_context(_fn_context_index);
+        CaseExprState* state = reinterpret_cast<CaseExprState*>(
+            fn_ctx->get_function_state(FunctionContext::THREAD_LOCAL));
+        if (state->lookup != NULL) {
+            switch (_children[0]->type().type) {
+            case TYPE_TINYINT:
+                lookup_branches<int8_t>(case_col, state, else_branch, &branches[0]);
+                break;
+            case TYPE_SMALLINT:
+                lookup_branches<int16_t>(case_col, state, else_branch, &branches[0]);
+                break;
+            case TYPE_INT:
+                lookup_branches<int32_t>(case_col, state, else_branch, &branches[0]);
+                break;
+            default:
+                lookup_branches<int64_t>(case_col, state, else_branch, &branches[0]);
+                break;
+            }
+            evaluate_branches(ctx, batch, sel, num_rows, &branches[0], result);
+            return;
+        }
+    }
+
+    // The rows without a matching WHEN so far, by their index in 'batch' and in 'result'
+    std::vector<int> rows(num_rows);
+    std::vector<int> positions(num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+        rows[i] = (sel != NULL) ? sel[i] : i;
+        positions[i] = i;
+    }
+    int num_remaining = num_rows;
+    if (has_case_expr()) {
+        // a NULL case value matches no WHEN
+        num_remaining = compact_rows(case_col.nulls(), num_remaining, &rows[0], &positions[0]);
+    }
+    std::vector<uint8_t> matched(num_rows);
+    ExprColumn when_col;
+    for (int i = loop_start; i < loop_end && num_remaining > 0; i += 2) {
+        _children[i]->evaluate_batch(ctx, batch, &rows[0], num_remaining, &when_col);
+        const uint8_t* when_nulls = when_col.nulls();
+        if (has_case_expr()) {
+            for (int j = 0; j < num_remaining; ++j) {
+                matched[j] = !when_nulls[j] && RawValue::eq(
+                    case_col.get_value(positions[j]), when_col.get_value(j),
+                    _children[0]->type());
+            }
+        } else {
+            const uint8_t* when_values = when_col.values<uint8_t>();
+            for (int j = 0; j < num_remaining; ++j) {
+                matched[j] = !when_nulls[j] & when_values[j];
+            }
+        }
+        for (int j = 0; j < num_remaining; ++j) {
+            int position = positions[j];
+            branches[position] = matched[j] ? i + 1 : branches[position];
+        }
+        num_remaining = compact_rows(&matched[0], num_remaining, &rows[0], &positions[0]);
+    }
+    evaluate_branches(ctx, batch, sel, num_rows, &branches[0], result);
+}
+
+// Returns the value of an integer slot of 'type'
+static int64_t get_int_value(const void* value, PrimitiveType type) {
+    switch (type) {
+    case TYPE_TINYINT:
+        return *reinterpret_cast<const int8_t*>(value);
+    case TYPE_SMALLINT:
+        return *reinterpret_cast<const int16_t*>(value);
+    case TYPE_INT:
+        return *reinterpret_cast<const int32_t*>(value);
+    default:
+        return *reinterpret_cast<const int64_t*>(value);
+    }
+}
+
+void CaseExpr::build_lookup(
+        ExprContext* ctx, FunctionContext* fn_ctx, CaseExprState* state) {
+    PrimitiveType case_type = _children[0]->type().type;
+    if (case_type != TYPE_TINYINT && case_type != TYPE_SMALLINT
+            && case_type != TYPE_INT && case_type != TYPE_BIGINT) {
+        return;
+    }
+    int num_children = _children.size();
+    int loop_end = has_else_expr() ? num_children - 1 : num_children;
+    // The WHEN values and their THEN children
+    std::vector<std::pair<int64_t, int> > entries;
+    for (int i = 1; i < loop_end; i += 2) {
+        if (!_children[i]->is_constant() || _children[i]->type().type != case_type) {
+            return;
+        }
+        void* value = ctx->get_value(_children[i], NULL);
+        if (value != NULL) {
+            // a NULL WHEN value matches nothing
+            entries.push_back(std::make_pair(get_int_value(value, case_type), i + 1));
+        }
+    }
+    if (entries.empty()) {
+        return;
+    }
+    int64_t min_value = entries[0].first;
+    int64_t max_value = entries[0].first;
+    for (int i = 1; i < entries.size(); ++i) {
+        min_value = std::min(min_value, entries[i].first);
+        max_value = std::max(max_value, entries[i].first);
+    }
+    uint64_t range = static_cast<uint64_t>(max_value) - static_cast<uint64_t>(min_value);
+    if (range >= MAX_LOOKUP_SIZE) {
+        return;
+    }
+    int64_t size = range + 1;
+    int* lookup = reinterpret_cast<int*>(fn_ctx->allocate(size * sizeof(int)));
+    if (lookup == NULL) {
+        return;
+    }
+    std::fill(lookup, lookup + size, has_else_expr() ? num_children - 1 : -1);
+    // fill in reverse so that the first WHEN of duplicate values wins
+    for (int i = entries.size() - 1; i >= 0; --i) {
+        lookup[entries[i].first - min_value] = entries[i].second;
+    }
+    state->lookup = lookup;
+    state->lookup_min = min_value;
+    state->lookup_size = size;
+}
+
 
 }
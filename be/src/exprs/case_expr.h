@@ -31,6 +31,7 @@ class Function;
 namespace palo {
 
 class TExprNode;
+struct CaseExprState;
 
 class CaseExpr: public Expr {
 public:
@@ -50,6 +51,13 @@ public:
     virtual DateTimeVal get_datetime_val(ExprContext* ctx, TupleRow* row);
     virtual DecimalVal get_decimal_val(ExprContext* ctx, TupleRow* row);
 
+    /// Evaluates every WHEN only for the rows no earlier WHEN matched and every THEN only
+    /// for the rows its WHEN matched, like the per-row functions. A CASE over an integer
+    /// expr with constant WHEN values picks the THEN of every row from a lookup table
+    /// instead of evaluating the WHEN exprs.
+    virtual void evaluate_batch(ExprContext* ctx, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result);
+
 protected:
     friend class Expr;
     friend class ComputeFunctions;
@@ -84,6 +92,10 @@ private:
 
     /// Return true iff *v1 == *v2. v1 and v2 should both be of the specified type.
     bool any_val_eq(const TypeDescriptor& type, const AnyVal* v1, const AnyVal* v2);
+
+    /// Sets up state->lookup if the case expr is an integer and all WHEN exprs are
+    /// constants within a small range.
+    void build_lookup(ExprContext* ctx, FunctionContext* fn_ctx, CaseExprState* state);
 };
 
 }
@@ -23,6 +23,7 @@
 #include "exprs/expr.h"
 #include "exprs/anyval_util.h"
 #include "exprs/case_expr.h"
+#include "exprs/expr_column.h"
 #include "runtime/tuple_row.h"
 #include "udf/udf.h"
 
@@ -51,4 +52,82 @@ CTOR_DCTOR_FUN(IfNullExpr);
 CTOR_DCTOR_FUN(NullIfExpr);
 CTOR_DCTOR_FUN(IfExpr);
 CTOR_DCTOR_FUN(CoalesceExpr);
+
+// The batch functions are only used if the children have the slot size of 'expr', like
+// CaseExpr::evaluate_batch().
+static bool children_have_slot_size(Expr* expr, int first_child) {
+    for (int i = first_child; i < expr->get_num_children(); ++i) {
+        if (expr->get_child(i)->type().get_slot_size() != expr->type().get_slot_size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Sets every row to the value of the first child that is not NULL for it. Every child is
+// evaluated over the rows left NULL by the earlier ones and its values are copied to all
+// of them, the NULLs included: a later child overwrites them or they stay NULL.
+static void coalesce_batch(Expr* expr, ExprContext* context, RowBatch* batch,
+                           const int* sel, int num_rows, ExprColumn* result) {
+    result->reset(expr->type(), num_rows);
+    // The rows left, by their index in 'batch' and in 'result'
+    std::vector<int> rows(num_rows);
+    std::vector<int> positions(num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+        rows[i] = (sel != NULL) ? sel[i] : i;
+        positions[i] = i;
+    }
+    int num_remaining = num_rows;
+    std::vector<uint8_t> not_null(num_rows);
+    ExprColumn child_col;
+    for (int i = 0; i < expr->get_num_children() && num_remaining > 0; ++i) {
+        expr->get_child(i)->evaluate_batch(context, batch, &rows[0], num_remaining, &child_col);
+        result->scatter(child_col, &positions[0], num_remaining);
+        const uint8_t* nulls = child_col.nulls();
+        for (int j = 0; j < num_remaining; ++j) {
+            not_null[j] = nulls[j] ^ 1;
+        }
+        num_remaining = compact_rows(&not_null[0], num_remaining, &rows[0], &positions[0]);
+    }
+    for (int j = 0; j < num_remaining; ++j) {
+        result->set_value(positions[j], NULL);
+    }
+}
+
+void IfNullExpr::evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result) {
+    if (!children_have_slot_size(this, 0)) {
+        Expr::evaluate_batch(context, batch, sel, num_rows, result);
+        return;
+    }
+    coalesce_batch(this, context, batch, sel, num_rows, result);
+}
+
+void CoalesceExpr::evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                  int num_rows, ExprColumn* result) {
+    if (!children_have_slot_size(this, 0)) {
+        Expr::evaluate_batch(context, batch, sel, num_rows, result);
+        return;
+    }
+    coalesce_batch(this, context, batch, sel, num_rows, result);
+}
+
+void IfExpr::evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                            int num_rows, ExprColumn* result) {
+    if (!children_have_slot_size(this, 1) || num_rows == 0) {
+        Expr::evaluate_batch(context, batch, sel, num_rows, result);
+        return;
+    }
+    ExprColumn cond_col;
+    _children[0]->evaluate_batch(context, batch, sel, num_rows, &cond_col);
+    const uint8_t* cond_values = cond_col.values<uint8_t>();
+    const uint8_t* cond_nulls = cond_col.nulls();
+    // child 1 if the condition is true, child 2 if it is false or NULL
+    std::vector<int> branches(num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+        branches[i] = 2 - (!cond_nulls[i] & cond_values[i]);
+    }
+    evaluate_branches(context, batch, sel, num_rows, &branches[0], result);
+}
+
 }
@@ -58,6 +58,10 @@ public:
     virtual DecimalVal get_decimal_val(ExprContext* context, TupleRow* row);
     virtual LargeIntVal get_large_int_val(ExprContext* context, TupleRow* row);
 
+    /// Evaluates the second child only for the rows the first is NULL for.
+    virtual void evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result);
+
     virtual Status get_codegend_compute_fn(RuntimeState* state, llvm::Function** fn);
 
     virtual std::string debug_string() const { 
@@ -115,6 +119,11 @@ public:
     virtual DecimalVal get_decimal_val(ExprContext* context, TupleRow* row);
     virtual LargeIntVal get_large_int_val(ExprContext* context, TupleRow* row);
 
+    /// Evaluates the condition over all rows and each branch only over the rows that
+    /// take it.
+    virtual void evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result);
+
     virtual Status get_codegend_compute_fn(RuntimeState* state, llvm::Function** fn);
     virtual std::string debug_string() const { 
         return Expr::debug_string("IfExpr"); 
@@ -144,6 +153,10 @@ public:
     virtual DecimalVal get_decimal_val(ExprContext* context, TupleRow* row);
     virtual LargeIntVal get_large_int_val(ExprContext* context, TupleRow* row);
 
+    /// Evaluates every child only for the rows all earlier children are NULL for.
+    virtual void evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result);
+
     virtual Status get_codegend_compute_fn(RuntimeState* state, llvm::Function** fn);
     virtual std::string debug_string() const { return Expr::debug_string("CoalesceExpr"); }
 
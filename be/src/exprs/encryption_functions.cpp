@@ -27,13 +27,32 @@
 #include "util/debug_util.h"
 #include "runtime/tuple_row.h"
 #include "exprs/base64.h"
-#include <boost/smart_ptr.hpp>
 #include "runtime/string_value.h"
 
 namespace palo {
 void EncryptionFunctions::init() {
 }
 
+void EncryptionFunctions::aes_prepare(
+        FunctionContext* ctx, FunctionContext::FunctionStateScope scope) {
+    if (scope != FunctionContext::THREAD_LOCAL) {
+        return;
+    }
+    ctx->set_function_state(scope, my_aes_ctx_create());
+}
+
+void EncryptionFunctions::aes_close(
+        FunctionContext* ctx, FunctionContext::FunctionStateScope scope) {
+    if (scope != FunctionContext::THREAD_LOCAL) {
+        return;
+    }
+    my_aes_ctx_destroy(reinterpret_cast<MyAesCtx*>(ctx->get_function_state(scope)));
+    ctx->set_function_state(scope, NULL);
+}
+
+// The results below are written straight into the temp result buffer of the
+// function context, which is reused from row to row, and then truncated to
+// the real length.
 StringVal EncryptionFunctions::aes_encrypt(FunctionContext* ctx,
         const StringVal &src, const StringVal &key) {
     if (src.len == 0) {
@@ -42,15 +61,23 @@ StringVal EncryptionFunctions::aes_encrypt(FunctionContext* ctx,
 
     // cipher_len = (clearLen/16 + 1) * 16;
     int cipher_len = src.len + 16;
-    boost::scoped_array<char> p;
-    p.reset(new char[cipher_len]);
-
-    int ret_code = my_aes_encrypt((unsigned char *)src.ptr, src.len,
-            (unsigned char*)p.get(), (unsigned char *)key.ptr, key.len, my_aes_128_ecb, NULL);
+    StringVal result = StringVal::create_temp_string_val(ctx, cipher_len);
+
+    MyAesCtx* aes_ctx = reinterpret_cast<MyAesCtx*>(
+        ctx->get_function_state(FunctionContext::THREAD_LOCAL));
+    int ret_code = 0;
+    if (aes_ctx != NULL) {
+        ret_code = my_aes_encrypt(aes_ctx, (unsigned char *)src.ptr, src.len,
+                result.ptr, (unsigned char *)key.ptr, key.len, my_aes_128_ecb, NULL);
+    } else {
+        ret_code = my_aes_encrypt((unsigned char *)src.ptr, src.len,
+                result.ptr, (unsigned char *)key.ptr, key.len, my_aes_128_ecb, NULL);
+    }
     if (ret_code < 0) {
         return StringVal::null();
     }
-    return AnyValUtil::from_buffer_temp(ctx, p.get(), ret_code);
+    result.len = ret_code;
+    return result;
 }
 
 StringVal EncryptionFunctions::aes_decrypt(FunctionContext* ctx,
@@ -59,16 +86,26 @@ StringVal EncryptionFunctions::aes_decrypt(FunctionContext* ctx,
         return StringVal::null();
     }
 
-    int cipher_len = src.len;
-    boost::scoped_array<char> p;
-    p.reset(new char[cipher_len]);
-
-    int ret_code = my_aes_decrypt((unsigned char *)src.ptr, src.len, (unsigned char*)p.get(),
-            (unsigned char *)key.ptr, key.len, my_aes_128_ecb, NULL);
+    // the final block may be decrypted into a full block before the padding
+    // is stripped
+    int cipher_len = src.len + 16;
+    StringVal result = StringVal::create_temp_string_val(ctx, cipher_len);
+
+    MyAesCtx* aes_ctx = reinterpret_cast<MyAesCtx*>(
+        ctx->get_function_state(FunctionContext::THREAD_LOCAL));
+    int ret_code = 0;
+    if (aes_ctx != NULL) {
+        ret_code = my_aes_decrypt(aes_ctx, (unsigned char *)src.ptr, src.len,
+                result.ptr, (unsigned char *)key.ptr, key.len, my_aes_128_ecb, NULL);
+    } else {
+        ret_code = my_aes_decrypt((unsigned char *)src.ptr, src.len,
+                result.ptr, (unsigned char *)key.ptr, key.len, my_aes_128_ecb, NULL);
+    }
     if (ret_code < 0) {
         return StringVal::null();
     }
-    return AnyValUtil::from_buffer_temp(ctx, p.get(), ret_code);
+    result.len = ret_code;
+    return result;
 }
 
 StringVal EncryptionFunctions::from_base64(FunctionContext* ctx, const StringVal &src) {
@@ -76,15 +113,17 @@ StringVal EncryptionFunctions::from_base64(FunctionContext* ctx, const StringVal
         return StringVal::null();
     }
 
-    int cipher_len = src.len;
-    boost::scoped_array<char> p;
-    p.reset(new char[cipher_len]);
+    // base64_decode2() terminates its output, which needs one byte more than
+    // the decoded data when the input has no padding
+    int cipher_len = src.len + 1;
+    StringVal result = StringVal::create_temp_string_val(ctx, cipher_len);
 
-    int ret_code = base64_decode2((const char *)src.ptr, src.len, p.get());
+    int ret_code = base64_decode2((const char *)src.ptr, src.len, (char *)result.ptr);
     if (ret_code < 0) {
         return StringVal::null();
     }
-    return AnyValUtil::from_buffer_temp(ctx, p.get(), ret_code);
+    result.len = ret_code;
+    return result;
 }
 
 StringVal EncryptionFunctions::to_base64(FunctionContext* ctx, const StringVal &src) {
@@ -92,15 +131,15 @@ StringVal EncryptionFunctions::to_base64(FunctionContext* ctx, const StringVal &
         return StringVal::null();
     }
 
-    int cipher_len = src.len * 4 / 3 + 1;
-    boost::scoped_array<char> p;
-    p.reset(new char[cipher_len]);
+    int cipher_len = (src.len + 2) / 3 * 4;
+    StringVal result = StringVal::create_temp_string_val(ctx, cipher_len);
 
-    int ret_code = base64_encode2((unsigned char *)src.ptr, src.len, (unsigned char *)p.get());
+    int ret_code = base64_encode2((unsigned char *)src.ptr, src.len, result.ptr);
     if (ret_code < 0) {
         return StringVal::null();
     }
-    return AnyValUtil::from_buffer_temp(ctx, p.get(), ret_code);
+    result.len = ret_code;
+    return result;
 }
 
 StringVal EncryptionFunctions::md5sum(
@@ -34,6 +34,12 @@ class TupleRow;
 class EncryptionFunctions {
 public:
     static void init();
+    // Keeps an AES cipher context per thread so the key schedule is built once
+    // instead of once per row.
+    static void aes_prepare(palo_udf::FunctionContext* context,
+            palo_udf::FunctionContext::FunctionStateScope scope);
+    static void aes_close(palo_udf::FunctionContext* context,
+            palo_udf::FunctionContext::FunctionStateScope scope);
     static palo_udf::StringVal aes_encrypt(palo_udf::FunctionContext* context,
             const palo_udf::StringVal& val1, const palo_udf::StringVal& val2);
     static palo_udf::StringVal aes_decrypt(palo_udf::FunctionContext* context,
@@ -35,6 +35,7 @@
 #include "exprs/cast_expr.h"
 #include "exprs/compound_predicate.h"
 #include "exprs/conditional_functions.h"
+#include "exprs/expr_column.h"
 #include "exprs/in_predicate.h"
 #include "exprs/arithmetic_expr.h"
 #include "exprs/is_null_predicate.h"
@@ -50,6 +51,7 @@
 #include "gen_cpp/Data_types.h"
 #include "runtime/runtime_state.h"
 #include "runtime/raw_value.h"
+#include "runtime/row_batch.h"
 #include "util/debug_util.h"
 
 #include "gen_cpp/Exprs_types.h"
@@ -831,6 +833,126 @@ DecimalVal Expr::get_decimal_val(ExprContext* context, TupleRow* row) {
     return val;
 }
 
+void Expr::evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                          int num_rows, ExprColumn* result) {
+    result->reset(_type, num_rows);
+    if (is_constant()) {
+        void* value = context->get_value(this, NULL);
+        for (int i = 0; i < num_rows; ++i) {
+            result->set_value(i, value);
+        }
+        return;
+    }
+    for (int i = 0; i < num_rows; ++i) {
+        TupleRow* row = batch->get_row(sel != NULL ? sel[i] : i);
+        result->set_value(i, context->get_value(this, row));
+    }
+}
+
+// Sets values[i] to the entry 'indexes[i]' of 'table', which has one value per entry.
+template <typename T>
+static void gather_values(const uint8_t* table, const int* indexes, int num_rows,
+                          uint8_t* values) {
+    const T* src = reinterpret_cast<const T*>(table);
+    T* dst = reinterpret_cast<T*>(values);
+    for (int i = 0; i < num_rows; ++i) {
+        dst[i] = src[indexes[i]];
+    }
+}
+
+void Expr::evaluate_branches(ExprContext* context, RowBatch* batch, const int* sel,
+                             int num_rows, const int* branches, ExprColumn* result) {
+    result->reset(_type, num_rows);
+    if (num_rows == 0) {
+        return;
+    }
+    int num_children = _children.size();
+    int value_size = result->value_size();
+    // Entry 0 is for the null branch and entry c + 1 for child c
+    std::vector<int> indexes(num_rows);
+    std::vector<int> counts(num_children + 1, 0);
+    for (int i = 0; i < num_rows; ++i) {
+        indexes[i] = branches[i] + 1;
+        ++counts[indexes[i]];
+    }
+
+    // Evaluate the constant children once. The rows of the other children get a null from
+    // the table and are filled in below.
+    std::vector<uint8_t> const_values((num_children + 1) * value_size, 0);
+    std::vector<uint8_t> const_nulls(num_children + 1, 1);
+    bool all_constant = true;
+    for (int c = 0; c < num_children; ++c) {
+        if (counts[c + 1] == 0) {
+            continue;
+        }
+        if (!_children[c]->is_constant()) {
+            all_constant = false;
+            continue;
+        }
+        DCHECK_EQ(_children[c]->type().get_slot_size(), value_size);
+        void* value = context->get_value(_children[c], NULL);
+        if (value != NULL) {
+            memcpy(&const_values[(c + 1) * value_size], value, value_size);
+            const_nulls[c + 1] = 0;
+        }
+    }
+    uint8_t* nulls = result->nulls();
+    for (int i = 0; i < num_rows; ++i) {
+        nulls[i] = const_nulls[indexes[i]];
+    }
+    switch (value_size) {
+    case 1:
+        gather_values<uint8_t>(&const_values[0], &indexes[0], num_rows, result->raw_values());
+        break;
+    case 2:
+        gather_values<uint16_t>(&const_values[0], &indexes[0], num_rows, result->raw_values());
+        break;
+    case 4:
+        gather_values<uint32_t>(&const_values[0], &indexes[0], num_rows, result->raw_values());
+        break;
+    case 8:
+        gather_values<uint64_t>(&const_values[0], &indexes[0], num_rows, result->raw_values());
+        break;
+    default: {
+        uint8_t* values = result->raw_values();
+        for (int i = 0; i < num_rows; ++i) {
+            memcpy(values + i * value_size, &const_values[indexes[i] * value_size],
+                   value_size);
+        }
+        break;
+    }
+    }
+    if (all_constant) {
+        return;
+    }
+
+    // Group the positions of the rows by branch and evaluate every other child over its
+    // rows
+    std::vector<int> offsets(num_children + 2, 0);
+    for (int b = 0; b <= num_children; ++b) {
+        offsets[b + 1] = offsets[b] + counts[b];
+    }
+    std::vector<int> positions(num_rows);
+    std::vector<int> next(offsets.begin(), offsets.end() - 1);
+    for (int i = 0; i < num_rows; ++i) {
+        positions[next[indexes[i]]++] = i;
+    }
+    std::vector<int> rows(num_rows);
+    ExprColumn child_col;
+    for (int c = 0; c < num_children; ++c) {
+        int count = counts[c + 1];
+        if (count == 0 || _children[c]->is_constant()) {
+            continue;
+        }
+        const int* child_positions = &positions[offsets[c + 1]];
+        for (int j = 0; j < count; ++j) {
+            rows[j] = (sel != NULL) ? sel[child_positions[j]] : child_positions[j];
+        }
+        _children[c]->evaluate_batch(context, batch, &rows[0], count, &child_col);
+        result->scatter(child_col, child_positions, count);
+    }
+}
+
 Status Expr::get_fn_context_error(ExprContext* ctx) {
     if (_fn_context_index != -1) {
         FunctionContext* fn_ctx = ctx->fn_context(_fn_context_index);
@@ -56,8 +56,10 @@ class Value;
 namespace palo {
 
 class Expr;
+class ExprColumn;
 class LlvmCodeGen;
 class ObjectPool;
+class RowBatch;
 class RowDescriptor;
 class RuntimeState;
 class TColumnValue;
@@ -125,6 +127,19 @@ public:
     virtual DateTimeVal get_datetime_val(ExprContext* context, TupleRow*);
     virtual DecimalVal get_decimal_val(ExprContext* context, TupleRow*);
 
+    /// Evaluates this expr over 'num_rows' rows of 'batch': the rows sel[0], ...,
+    /// sel[num_rows - 1] if 'sel' is non-NULL, the first 'num_rows' rows otherwise.
+    /// 'result' is reset to this expr's type and receives the value of the i-th
+    /// evaluated row at index i.
+    ///
+    /// The default implementation evaluates constant exprs once and calls the Get*Val()
+    /// function for every row otherwise. Subclasses override it to evaluate their
+    /// children into columns and compute over those in a tight loop, without per-row
+    /// virtual calls and AnyVal packing. Overrides must return the same values as the
+    /// Get*Val() functions.
+    virtual void evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result);
+
     // Get the number of digits after the decimal that should be displayed for this
     // value. Returns -1 if no scale has been specified (currently the scale is only set for
     // doubles set by RoundUpTo). get_value() must have already been called.
@@ -297,6 +312,7 @@ protected:
     friend class CompoundPredicate;
     friend class ScalarFnCall;
     friend class HllHashFunction;
+    friend class SubExprCache;
 
     Expr(const TypeDescriptor& type);
     Expr(const TypeDescriptor& type, bool is_slotref);
@@ -314,6 +330,15 @@ protected:
                            const RowDescriptor& row_desc,
                            ExprContext* context);
 
+    /// Helper for evaluate_batch() of conditional exprs: sets row i of 'result' to the
+    /// value of child 'branches[i]' for the i-th evaluated row of 'batch' (see
+    /// evaluate_batch()), or to null if 'branches[i]' is -1. Every child is evaluated only
+    /// over the rows that select it; constant children are evaluated once and gathered
+    /// into the result without branches. The children must have the slot size of this
+    /// expr's type.
+    void evaluate_branches(ExprContext* context, RowBatch* batch, const int* sel,
+                           int num_rows, const int* branches, ExprColumn* result);
+
     /// Initializes 'context' for execution. If scope if FRAGMENT_LOCAL, both fragment- and
     /// thread-local state should be initialized. Otherwise, if scope is THREAD_LOCAL, only
     /// thread-local state should be initialized.
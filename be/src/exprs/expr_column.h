@@ -0,0 +1,192 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_QUERY_EXPRS_EXPR_COLUMN_H
+#define BDG_PALO_BE_SRC_QUERY_EXPRS_EXPR_COLUMN_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "common/logging.h"
+#include "runtime/raw_value.h"
+#include "runtime/types.h"
+#include "util/hash_util.hpp"
+
+namespace palo {
+
+// Result of evaluating an expr over a batch of rows (see Expr::evaluate_batch()): one
+// value per row in the slot representation of the expr's type (e.g. int32_t for INT,
+// StringValue for VARCHAR, DateTimeValue for DATETIME), plus a null map with one byte
+// per row. The value of a null row is undefined.
+//
+// Like the results of get_value(), string values point to data owned by the input rows
+// or the expr's FunctionContext and are valid until either is freed.
+class ExprColumn {
+public:
+    ExprColumn() : _num_rows(0), _value_size(0) { }
+
+    // Resizes the column to 'num_rows' values of 'type' and marks all of them non-null.
+    void reset(const TypeDescriptor& type, int num_rows) {
+        _type = type;
+        _num_rows = num_rows;
+        _value_size = type.get_slot_size();
+        _values.resize(num_rows * _value_size);
+        _nulls.assign(num_rows, 0);
+    }
+
+    const TypeDescriptor& type() const {
+        return _type;
+    }
+
+    int num_rows() const {
+        return _num_rows;
+    }
+
+    int value_size() const {
+        return _value_size;
+    }
+
+    template <typename T>
+    T* values() {
+        DCHECK_EQ(sizeof(T), _value_size);
+        return reinterpret_cast<T*>(raw_values());
+    }
+
+    template <typename T>
+    const T* values() const {
+        DCHECK_EQ(sizeof(T), _value_size);
+        return reinterpret_cast<const T*>(raw_values());
+    }
+
+    uint8_t* raw_values() {
+        return _values.empty() ? NULL : &_values[0];
+    }
+
+    const uint8_t* raw_values() const {
+        return _values.empty() ? NULL : &_values[0];
+    }
+
+    uint8_t* nulls() {
+        return _nulls.empty() ? NULL : &_nulls[0];
+    }
+
+    const uint8_t* nulls() const {
+        return _nulls.empty() ? NULL : &_nulls[0];
+    }
+
+    bool is_null(int i) const {
+        return _nulls[i] != 0;
+    }
+
+    // Returns a pointer to the value of row 'i', or NULL if it is null, like
+    // ExprContext::get_value().
+    void* get_value(int i) {
+        return _nulls[i] ? NULL : &_values[i * _value_size];
+    }
+
+    // Sets row 'i' to 'value', which is in the slot representation of the type of this
+    // column, or to null if 'value' is NULL.
+    void set_value(int i, const void* value) {
+        if (value == NULL) {
+            _nulls[i] = 1;
+        } else {
+            _nulls[i] = 0;
+            memcpy(&_values[i * _value_size], value, _value_size);
+        }
+    }
+
+    // Sets row 'i' to row 'src_idx' of 'src', which must have the same type.
+    void copy_value(int i, const ExprColumn& src, int src_idx) {
+        DCHECK_EQ(_value_size, src._value_size);
+        _nulls[i] = src._nulls[src_idx];
+        if (!_nulls[i]) {
+            memcpy(&_values[i * _value_size], &src._values[src_idx * _value_size],
+                   _value_size);
+        }
+    }
+
+    // Sets row positions[j] to row j of 'src', which must have the same type, for the
+    // first 'num_rows' rows of 'src'.
+    void scatter(const ExprColumn& src, const int* positions, int num_rows) {
+        DCHECK_EQ(_value_size, src._value_size);
+        for (int j = 0; j < num_rows; ++j) {
+            _nulls[positions[j]] = src._nulls[j];
+            // the value of a null row is undefined, copy it anyway
+            memcpy(&_values[positions[j] * _value_size], &src._values[j * _value_size],
+                   _value_size);
+        }
+    }
+
+    // Combines the values of the column into 'hashes', one per row, with
+    // RawValue::get_hash_value_fast64(), i.e. hashes[i] becomes the hash of row i seeded
+    // with hashes[i]. Hashing the columns of a key one after the other gives the hash of
+    // the key of every row.
+    void hash(uint64_t* hashes) const {
+        switch (_type.type) {
+        case TYPE_BOOLEAN:
+        case TYPE_TINYINT:
+        case TYPE_SMALLINT:
+        case TYPE_INT:
+        case TYPE_BIGINT:
+        case TYPE_LARGEINT:
+        case TYPE_FLOAT:
+        case TYPE_DOUBLE:
+            // the slot is the whole value, hash it without dispatching on the type
+            for (int i = 0; i < _num_rows; ++i) {
+                hashes[i] = _nulls[i]
+                        ? RawValue::get_null_hash_value_fast64(hashes[i])
+                        : HashUtil::fast_hash64(&_values[i * _value_size], _value_size,
+                                                hashes[i]);
+            }
+            break;
+        default:
+            for (int i = 0; i < _num_rows; ++i) {
+                hashes[i] = RawValue::get_hash_value_fast64(
+                    _nulls[i] ? NULL : &_values[i * _value_size], _type, hashes[i]);
+            }
+            break;
+        }
+    }
+
+private:
+    TypeDescriptor _type;
+    int _num_rows;
+    int _value_size;
+    std::vector<uint8_t> _values;
+    std::vector<uint8_t> _nulls;
+};
+
+// Removes the rows with a non-zero 'mask' from 'rows', rows of a batch to evaluate, and
+// from 'positions', the indexes of the same rows in a result column, keeping the order of
+// the others. Returns the number of rows left. Conditional exprs narrow the rows their
+// next child is evaluated over with it.
+inline int compact_rows(const uint8_t* mask, int num_rows, int* rows, int* positions) {
+    int num_left = 0;
+    for (int j = 0; j < num_rows; ++j) {
+        // always store, advance only for the rows that stay
+        int row = rows[j];
+        int position = positions[j];
+        rows[num_left] = row;
+        positions[num_left] = position;
+        num_left += (mask[j] == 0);
+    }
+    return num_left;
+}
+
+}
+
+#endif
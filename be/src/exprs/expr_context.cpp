@@ -20,16 +20,19 @@
 
 #include "exprs/expr_context.h"
 
+#include <algorithm>
 #include <sstream>
 #include <gperftools/profiler.h>
 
 #include "exprs/expr.h"
+#include "exprs/expr_column.h"
 #include "exprs/slot_ref.h"
 #include "runtime/mem_pool.h"
 #include "runtime/runtime_state.h"
 #include "runtime/raw_value.h"
 #include "udf/udf_internal.h"
 #include "util/debug_util.h"
+#include "util/stopwatch.hpp"
 
 namespace palo {
 
@@ -41,7 +44,8 @@ ExprContext::ExprContext(Expr* root) :
         _is_clone(false),
         _prepared(false),
         _opened(false),
-        _closed(false) {
+        _closed(false),
+        _subexpr_cache(NULL) {
 }
 
 ExprContext::~ExprContext() {
@@ -444,4 +448,60 @@ DecimalVal ExprContext::get_decimal_val(TupleRow* row) {
     return _root->get_decimal_val(this, row);
 }
 
+void ExprContext::evaluate_batch(
+        RowBatch* batch, const int* sel, int num_rows, ExprColumn* result) {
+    _root->evaluate_batch(this, batch, sel, num_rows, result);
+}
+
+int ExprContext::filter_batch(const std::vector<ExprContext*>& ctxs, RowBatch* batch,
+                              int* sel, int num_rows) {
+    ExprColumn result;
+    MonotonicStopWatch watch;
+    watch.start();
+    for (int i = 0; i < ctxs.size() && num_rows > 0; ++i) {
+        ctxs[i]->evaluate_batch(batch, sel, num_rows, &result);
+        const bool* values = result.values<bool>();
+        const uint8_t* nulls = result.nulls();
+        int num_passed = 0;
+        for (int j = 0; j < num_rows; ++j) {
+            if (!nulls[j] && values[j]) {
+                sel[num_passed++] = sel[j];
+            }
+        }
+        ConjunctStats* stats = ctxs[i]->conjunct_stats();
+        stats->rows_in += num_rows;
+        stats->rows_passed += num_passed;
+        stats->time_ns += watch.reset();
+        ++stats->num_batches;
+        num_rows = num_passed;
+    }
+    return num_rows;
+}
+
+void ExprContext::reorder_conjuncts(ExprContext** ctxs, int num_ctxs) {
+    std::vector<std::pair<double, ExprContext*>> ranked_ctxs;
+    for (int i = 0; i < num_ctxs; ++i) {
+        ConjunctStats* stats = ctxs[i]->conjunct_stats();
+        double rank = 0;
+        if (stats->rows_in > 0) {
+            double cost = static_cast<double>(stats->time_ns) / stats->rows_in;
+            double drop_rate = 1 - static_cast<double>(stats->rows_passed) / stats->rows_in;
+            rank = cost / std::max(drop_rate, 0.001);
+        }
+        ranked_ctxs.push_back(std::make_pair(rank, ctxs[i]));
+        stats->rows_in /= 2;
+        stats->rows_passed /= 2;
+        stats->time_ns /= 2;
+        stats->num_batches = 0;
+    }
+    std::stable_sort(ranked_ctxs.begin(), ranked_ctxs.end(),
+            [](const std::pair<double, ExprContext*>& lhs,
+               const std::pair<double, ExprContext*>& rhs) {
+        return lhs.first < rhs.first;
+    });
+    for (int i = 0; i < num_ctxs; ++i) {
+        ctxs[i] = ranked_ctxs[i].second;
+    }
+}
+
 }
@@ -36,10 +36,13 @@ USING_PALO_UDF;
 namespace palo {
 
 class Expr;
+class ExprColumn;
 class MemPool;
+class RowBatch;
 class MemTracker;
 class RuntimeState;
 class RowDescriptor;
+class SubExprCache;
 class TColumnValue;
 class TupleRow;
 
@@ -129,6 +132,12 @@ public:
 
     bool is_nullable();
 
+    /// Cache of common subexpressions shared with the other exprs of the same exec node,
+    /// see SubExprCache. NULL if there is none; clones don't share the cache.
+    SubExprCache* subexpr_cache() {
+        return _subexpr_cache;
+    }
+
     /// Calls Get*Val on _root
     BooleanVal get_boolean_val(TupleRow* row);
     TinyIntVal get_tiny_int_val(TupleRow* row);
@@ -143,6 +152,39 @@ public:
     DateTimeVal get_datetime_val(TupleRow* row);
     DecimalVal get_decimal_val(TupleRow* row);
 
+    /// Evaluates the expr tree over rows of 'batch', see Expr::evaluate_batch().
+    void evaluate_batch(RowBatch* batch, const int* sel, int num_rows, ExprColumn* result);
+
+    /// Evaluates the conjuncts 'ctxs' over the rows sel[0], ..., sel[num_rows - 1] of
+    /// 'batch' and compacts 'sel' to the rows for which all of them are true, keeping
+    /// their order. Returns the number of those rows. Like ExecNode::eval_conjuncts(),
+    /// a conjunct is only evaluated for the rows that passed the previous ones.
+    static int filter_batch(const std::vector<ExprContext*>& ctxs, RowBatch* batch,
+                            int* sel, int num_rows);
+
+    /// How a conjunct did over the rows it was measured on since the last
+    /// reorder_conjuncts(), collected by filter_batch() for all of them and by
+    /// ExecNode::eval_conjuncts_with_stats() for a sample.
+    struct ConjunctStats {
+        int64_t rows_in;
+        int64_t rows_passed;
+        int64_t time_ns;
+        // batches filtered by filter_batch()
+        int64_t num_batches;
+
+        ConjunctStats() : rows_in(0), rows_passed(0), time_ns(0), num_batches(0) { }
+    };
+
+    ConjunctStats* conjunct_stats() {
+        return &_conjunct_stats;
+    }
+
+    /// Orders the AND-connected conjuncts ctxs[0], ..., ctxs[num_ctxs - 1] by ascending
+    /// cost per row / (1 - pass rate), which evaluates the least work per dropped row
+    /// first, and ages their statistics so that the next reorder follows changes in the
+    /// input. A conjunct not measured yet goes first to be measured.
+    static void reorder_conjuncts(ExprContext** ctxs, int num_ctxs);
+
     /// Frees all local allocations made by fn_contexts_. This can be called when result
     /// data from this context is no longer needed.
     void free_local_allocations();
@@ -156,6 +198,7 @@ private:
     friend class ScalarFnCall;
     friend class InPredicate;
     friend class OlapScanNode;
+    friend class SubExprCache;
 
     /// FunctionContexts for each registered expression. The FunctionContexts are created
     /// and owned by this ExprContext.
@@ -184,6 +227,11 @@ private:
     bool _opened;
     bool _closed;
 
+    /// Set by SubExprCache::create(), owned by the exec node's pool.
+    SubExprCache* _subexpr_cache;
+
+    ConjunctStats _conjunct_stats;
+
     /// Calls the appropriate Get*Val() function on 'e' and stores the result in result_.
     /// This is used by Exprs to call GetValue() on a child expr, rather than root_.
     void* get_value(Expr* e, TupleRow* row);
@@ -28,16 +28,16 @@ HybirdSetBase* HybirdSetBase::create_set(PrimitiveType type) {
         return new(std::nothrow) HybirdSet<bool>();
 
     case TYPE_TINYINT:
-        return new(std::nothrow) HybirdSet<int8_t>();
+        return new(std::nothrow) FlatHybirdSet<int8_t>();
 
     case TYPE_SMALLINT:
-        return new(std::nothrow) HybirdSet<int16_t>();
+        return new(std::nothrow) FlatHybirdSet<int16_t>();
 
     case TYPE_INT:
-        return new(std::nothrow) HybirdSet<int32_t>();
+        return new(std::nothrow) FlatHybirdSet<int32_t>();
 
     case TYPE_BIGINT:
-        return new(std::nothrow) HybirdSet<int64_t>();
+        return new(std::nothrow) FlatHybirdSet<int64_t>();
 
     case TYPE_FLOAT:
         return new(std::nothrow) HybirdSet<float>();
@@ -53,7 +53,7 @@ HybirdSetBase* HybirdSetBase::create_set(PrimitiveType type) {
         return new(std::nothrow) HybirdSet<DecimalValue>();
 
     case TYPE_LARGEINT:
-        return new(std::nothrow) HybirdSet<__int128>();
+        return new(std::nothrow) FlatHybirdSet<__int128>();
 
     case TYPE_CHAR:
     case TYPE_VARCHAR:
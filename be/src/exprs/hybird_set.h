@@ -21,13 +21,19 @@
 #ifndef BDG_PALO_BE_SRC_QUERY_EXPRS_HYBIRD_SET_H
 #define BDG_PALO_BE_SRC_QUERY_EXPRS_HYBIRD_SET_H
 
+#include <string.h>
+
+#include <string>
 #include <unordered_set>
+#include <vector>
+
 #include "common/status.h"
 #include "common/object_pool.h"
 #include "runtime/primitive_type.h"
 #include "runtime/string_value.h"
 #include "runtime/datetime_value.h"
 #include "runtime/decimal_value.h"
+#include "util/hash_util.hpp"
 
 namespace palo {
 
@@ -119,9 +125,152 @@ private:
     ObjectPool _pool;
 };
 
+// Number of values up to which the flat sets below are searched linearly instead of
+// building a hash table. Most IN lists are that short.
+static const size_t HYBIRD_SET_TINY_SIZE = 16;
+
+// Set of integer values. The values are kept in insertion order in one vector; sets of at
+// most HYBIRD_SET_TINY_SIZE values are searched with a linear scan without branches
+// (which the compiler vectorizes), larger ones get an open addressing hash table with
+// linear probing that stores the values themselves, with 0 marking an empty slot.
+template<class T>
+class FlatHybirdSet : public HybirdSetBase {
+public:
+    FlatHybirdSet() : _has_zero(false), _shift(64) {
+    }
+
+    virtual ~FlatHybirdSet() {
+    }
+
+    virtual void insert(void* data) {
+        T value = *reinterpret_cast<T*>(data);
+        if (find_value(value)) {
+            return;
+        }
+        _values.push_back(value);
+        if (_values.size() <= HYBIRD_SET_TINY_SIZE) {
+            return;
+        }
+        // keep the load factor at most 1/2
+        if (_values.size() * 2 > _slots.size()) {
+            rebuild(_values.size() * 4);
+        } else {
+            insert_slot(value);
+        }
+    }
+
+    virtual int size() {
+        return _values.size();
+    }
+
+    virtual bool find(void* data) {
+        return find_value(*reinterpret_cast<T*>(data));
+    }
+
+    class Iterator : public IteratorBase {
+    public:
+        Iterator(const std::vector<T>& values) : _values(values), _idx(0) {
+        }
+        virtual ~Iterator() {
+        }
+        virtual bool has_next() const {
+            return _idx < _values.size();
+        }
+        virtual const void* get_value() {
+            return &_values[_idx];
+        }
+        virtual void next() {
+            ++_idx;
+        }
+    private:
+        const std::vector<T>& _values;
+        size_t _idx;
+    };
+
+    IteratorBase* begin() {
+        return _pool.add(new(std::nothrow) Iterator(_values));
+    }
+
+private:
+    template <class V>
+    static uint64_t hash_key(V value) {
+        return static_cast<uint64_t>(value);
+    }
+
+    static uint64_t hash_key(__int128 value) {
+        return static_cast<uint64_t>(value) ^ (static_cast<uint64_t>(value >> 64) * 31);
+    }
+
+    // Fibonacci hashing: the high bits of the product are well mixed.
+    size_t slot_of(T value) const {
+        return (hash_key(value) * 0x9E3779B97F4A7C15ULL) >> _shift;
+    }
+
+    bool find_value(T value) const {
+        if (_slots.empty()) {
+            bool found = false;
+            for (size_t i = 0; i < _values.size(); ++i) {
+                found |= (_values[i] == value);
+            }
+            return found;
+        }
+        if (value == 0) {
+            return _has_zero;
+        }
+        const size_t mask = _slots.size() - 1;
+        for (size_t i = slot_of(value); ; i = (i + 1) & mask) {
+            if (_slots[i] == value) {
+                return true;
+            }
+            if (_slots[i] == 0) {
+                return false;
+            }
+        }
+    }
+
+    void insert_slot(T value) {
+        if (value == 0) {
+            _has_zero = true;
+            return;
+        }
+        const size_t mask = _slots.size() - 1;
+        size_t i = slot_of(value);
+        while (_slots[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        _slots[i] = value;
+    }
+
+    void rebuild(size_t min_capacity) {
+        size_t capacity = 1;
+        _shift = 64;
+        while (capacity < min_capacity) {
+            capacity <<= 1;
+            --_shift;
+        }
+        _slots.assign(capacity, 0);
+        _has_zero = false;
+        for (size_t i = 0; i < _values.size(); ++i) {
+            insert_slot(_values[i]);
+        }
+    }
+
+    std::vector<T> _values;
+    // Hash table, empty while the set is tiny
+    std::vector<T> _slots;
+    bool _has_zero;
+    // 64 - log2(_slots.size())
+    int _shift;
+    ObjectPool _pool;
+};
+
+// Set of strings, which are copied into the set. Like FlatHybirdSet, tiny sets are
+// searched linearly, larger ones through an open addressing table of indexes into the
+// values. The table keeps the hash of every string next to its index, so that probing
+// only compares strings whose hashes are equal.
 class StringValueSet : public HybirdSetBase {
 public:
-    StringValueSet() {
+    StringValueSet() : _mask(0) {
     }
 
     virtual ~StringValueSet() {
@@ -129,58 +278,123 @@ public:
 
     virtual void insert(void* data) {
         StringValue* value = reinterpret_cast<StringValue*>(data);
-        std::string str_value(value->ptr, value->len);
-        _set.insert(str_value);
+        uint32_t hash = hash_string(value->ptr, value->len);
+        if (find_value(value->ptr, value->len, hash)) {
+            return;
+        }
+        _values.push_back(std::string(value->ptr, value->len));
+        _hashes.push_back(hash);
+        if (_values.size() <= HYBIRD_SET_TINY_SIZE) {
+            return;
+        }
+        if (_values.size() * 2 > _slots.size()) {
+            rebuild(_values.size() * 4);
+        } else {
+            insert_slot(_values.size() - 1);
+        }
     }
 
     virtual int size() {
-        return _set.size();
+        return _values.size();
     }
+
     virtual bool find(void* data) {
         StringValue* value = reinterpret_cast<StringValue*>(data);
-        std::string str_value(value->ptr, value->len);
-        typename std::unordered_set<std::string>::iterator it = _set.find(str_value);
-
-        if (it == _set.end()) {
-            return false;
-        } else {
-            return true;
+        if (_slots.empty()) {
+            return find_value(value->ptr, value->len, 0);
         }
-
-        return false;
+        return find_value(value->ptr, value->len, hash_string(value->ptr, value->len));
     }
 
     class Iterator : public IteratorBase {
     public:
-        Iterator(std::unordered_set<std::string>::iterator begin,
-                 std::unordered_set<std::string>::iterator end)
-            : _begin(begin),
-              _end(end) {
+        Iterator(const std::vector<std::string>& values) : _values(values), _idx(0) {
         }
         virtual ~Iterator() {
         }
         virtual bool has_next() const {
-            return !(_begin == _end);
+            return _idx < _values.size();
         }
         virtual const void* get_value() {
-            _value.ptr = const_cast<char*>(_begin->data());
-            _value.len = _begin->length();
+            _value.ptr = const_cast<char*>(_values[_idx].data());
+            _value.len = _values[_idx].length();
             return &_value;
         }
         virtual void next() {
-            ++_begin;
+            ++_idx;
         }
     private:
-        typename std::unordered_set<std::string>::iterator _begin;
-        typename std::unordered_set<std::string>::iterator _end;
+        const std::vector<std::string>& _values;
+        size_t _idx;
         StringValue _value;
     };
 
     IteratorBase* begin() {
-        return _pool.add(new(std::nothrow) Iterator(_set.begin(), _set.end()));
+        return _pool.add(new(std::nothrow) Iterator(_values));
     }
+
 private:
-    std::unordered_set<std::string> _set;
+    struct Slot {
+        // index of the value plus one, 0 for an empty slot
+        uint32_t idx;
+        uint32_t hash;
+    };
+
+    static uint32_t hash_string(const char* ptr, int len) {
+        return HashUtil::hash(ptr, len, 0);
+    }
+
+    bool equals(size_t idx, const char* ptr, int len) const {
+        const std::string& value = _values[idx];
+        return value.size() == static_cast<size_t>(len)
+            && memcmp(value.data(), ptr, len) == 0;
+    }
+
+    // 'hash' is only used if there is a hash table.
+    bool find_value(const char* ptr, int len, uint32_t hash) const {
+        if (_slots.empty()) {
+            for (size_t i = 0; i < _values.size(); ++i) {
+                if (equals(i, ptr, len)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        for (size_t i = hash & _mask; _slots[i].idx != 0; i = (i + 1) & _mask) {
+            if (_slots[i].hash == hash && equals(_slots[i].idx - 1, ptr, len)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void insert_slot(size_t idx) {
+        size_t i = _hashes[idx] & _mask;
+        while (_slots[i].idx != 0) {
+            i = (i + 1) & _mask;
+        }
+        _slots[i].idx = idx + 1;
+        _slots[i].hash = _hashes[idx];
+    }
+
+    void rebuild(size_t min_capacity) {
+        size_t capacity = 1;
+        while (capacity < min_capacity) {
+            capacity <<= 1;
+        }
+        Slot empty = {0, 0};
+        _slots.assign(capacity, empty);
+        _mask = capacity - 1;
+        for (size_t i = 0; i < _values.size(); ++i) {
+            insert_slot(i);
+        }
+    }
+
+    std::vector<std::string> _values;
+    std::vector<uint32_t> _hashes;
+    // Hash table, empty while the set is tiny
+    std::vector<Slot> _slots;
+    size_t _mask;
     ObjectPool _pool;
 };
 
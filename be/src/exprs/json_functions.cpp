@@ -16,6 +16,7 @@
 #include "exprs/json_functions.h"
 
 #include <stdlib.h>
+#include <string.h>
 #include <sys/time.h>
 
 #include <sstream>
@@ -23,6 +24,7 @@
 #include <vector>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/thread/tss.hpp>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/document.h>
 #include <rapidjson/writer.h>
@@ -40,20 +42,115 @@ namespace palo {
 
 static const re2::RE2 JSON_PATTERN("^([a-zA-Z0-9_\\-\\:\\s]*)(?:\\[([0-9]+)\\])?");
 
+// The document parsed last by a json function in this thread. Several json functions
+// called on the same string, e.g. get_json_int(col, '$.a') and
+// get_json_string(col, '$.b') in one select list, parse it only once.
+struct ParsedJson {
+    ParsedJson() : is_parsed(false) { }
+
+    std::string json;
+    bool is_parsed;
+    rapidjson::Document document;
+    // Holds the values built by match_value() for the current call only
+    rapidjson::Document::AllocatorType scratch;
+};
+
+static boost::thread_specific_ptr<ParsedJson> s_parsed_json;
+
+// Returns the parsed 'json_str', or a null value if it's not valid json. The document is
+// valid until the next call in this thread.
+static rapidjson::Value* get_parsed_json(const StringVal& json_str,
+                                         rapidjson::Document::AllocatorType** scratch) {
+    ParsedJson* parsed = s_parsed_json.get();
+    if (parsed == NULL) {
+        parsed = new ParsedJson();
+        s_parsed_json.reset(parsed);
+    }
+    parsed->scratch.Clear();
+    *scratch = &parsed->scratch;
+    if (parsed->is_parsed && parsed->json.size() == json_str.len
+            && memcmp(parsed->json.data(), json_str.ptr, json_str.len) == 0) {
+        return &parsed->document;
+    }
+
+    parsed->json.assign(reinterpret_cast<const char*>(json_str.ptr), json_str.len);
+    parsed->document.SetNull();
+    parsed->document.GetAllocator().Clear();
+    parsed->document.Parse(parsed->json.c_str());
+    if (UNLIKELY(parsed->document.HasParseError())) {
+        LOG(ERROR) << "Error at offset " << parsed->document.GetErrorOffset()
+            << ": " << GetParseError_En(parsed->document.GetParseError());
+        parsed->document.SetNull();
+    }
+    parsed->is_parsed = true;
+    return &parsed->document;
+}
+
+// Returns the parsed constant path prepared by json_path_prepare(), or parses 'path'
+// into 'row_paths' if it's not constant.
+static const std::vector<JsonPath>* get_json_paths(
+        FunctionContext* context, const StringVal& path, std::vector<JsonPath>* row_paths) {
+    std::vector<JsonPath>* parsed_paths = reinterpret_cast<std::vector<JsonPath>*>(
+        context->get_function_state(FunctionContext::FRAGMENT_LOCAL));
+    if (parsed_paths != NULL) {
+        return parsed_paths;
+    }
+    JsonFunctions::parse_json_paths(
+        std::string(reinterpret_cast<const char*>(path.ptr), path.len), row_paths);
+    return row_paths;
+}
+
+// Returns the value 'parsed_paths' selects in 'json_str', or NULL if there is none.
+static rapidjson::Value* get_json_value(
+        const StringVal& json_str, const std::vector<JsonPath>* parsed_paths) {
+    // A path of "$" only selects the whole string, see get_json_string()
+    if (!(*parsed_paths)[0].is_valid || UNLIKELY(parsed_paths->size() == 1)) {
+        return NULL;
+    }
+    rapidjson::Document::AllocatorType* scratch = NULL;
+    rapidjson::Value* document = get_parsed_json(json_str, &scratch);
+    rapidjson::Value* value = JsonFunctions::match_value(*parsed_paths, document, *scratch);
+    return value->IsNull() ? NULL : value;
+}
+
 void JsonFunctions::init() {
 }
 
+void JsonFunctions::json_path_prepare(
+        FunctionContext* context, FunctionContext::FunctionStateScope scope) {
+    if (scope != FunctionContext::FRAGMENT_LOCAL) {
+        return;
+    }
+    if (!context->is_arg_constant(1)) {
+        return;
+    }
+    StringVal* path = reinterpret_cast<StringVal*>(context->get_constant_arg(1));
+    if (path->is_null) {
+        return;
+    }
+    std::vector<JsonPath>* parsed_paths = new std::vector<JsonPath>();
+    parse_json_paths(std::string(reinterpret_cast<const char*>(path->ptr), path->len),
+                     parsed_paths);
+    context->set_function_state(scope, parsed_paths);
+}
+
+void JsonFunctions::json_path_close(
+        FunctionContext* context, FunctionContext::FunctionStateScope scope) {
+    if (scope != FunctionContext::FRAGMENT_LOCAL) {
+        return;
+    }
+    delete reinterpret_cast<std::vector<JsonPath>*>(context->get_function_state(scope));
+}
+
 IntVal JsonFunctions::get_json_int(
         FunctionContext* context, const StringVal& json_str, const StringVal& path) {
     if (json_str.is_null || path.is_null) {
         return IntVal::null();
     }
-    std::string json_string((char*)json_str.ptr, json_str.len);
-    std::string path_string((char*)path.ptr, path.len);
-    rapidjson::Document document;
-    rapidjson::Value* root =
-        get_json_object(json_string, path_string, JSON_FUN_INT, &document);
-    if (root->IsInt()) {
+    std::vector<JsonPath> row_paths;
+    rapidjson::Value* root = get_json_value(
+        json_str, get_json_paths(context, path, &row_paths));
+    if (root != NULL && root->IsInt()) {
         return IntVal(root->GetInt());
     } else {
         return IntVal::null();
@@ -65,20 +162,22 @@ StringVal JsonFunctions::get_json_string(
     if (json_str.is_null || path.is_null) {
         return StringVal::null();
     }
-    std::string json_string((char*)json_str.ptr, json_str.len);
-    std::string path_string((char*)path.ptr, path.len);
-    rapidjson::Document document;
-    rapidjson::Value* root =
-        get_json_object(json_string, path_string, JSON_FUN_STRING, &document);
-    if (root->IsNull()) {
+    std::vector<JsonPath> row_paths;
+    const std::vector<JsonPath>* parsed_paths = get_json_paths(context, path, &row_paths);
+    if (UNLIKELY(parsed_paths->size() == 1) && (*parsed_paths)[0].is_valid) {
+        return json_str;
+    }
+    rapidjson::Value* root = get_json_value(json_str, parsed_paths);
+    if (root == NULL) {
         return StringVal::null();
     } else if (root->IsString()) {
-        return AnyValUtil::from_string_temp(context, root->GetString());
+        return AnyValUtil::from_buffer_temp(
+            context, root->GetString(), root->GetStringLength());
     } else {
         rapidjson::StringBuffer buf;
         rapidjson::Writer<rapidjson::StringBuffer> writer(buf);
         root->Accept(writer);
-        return AnyValUtil::from_string_temp(context, std::string(buf.GetString()));
+        return AnyValUtil::from_buffer_temp(context, buf.GetString(), buf.GetSize());
     }
 }
 
@@ -87,12 +186,12 @@ DoubleVal JsonFunctions::get_json_double(
     if (json_str.is_null || path.is_null) {
         return DoubleVal::null();
     }
-    std::string json_string((char*)json_str.ptr, json_str.len);
-    std::string path_string((char*)path.ptr, path.len);
-    rapidjson::Document document;
-    rapidjson::Value* root =
-        get_json_object(json_string, path_string, JSON_FUN_DOUBLE, &document);
-    if (root->IsInt()) {
+    std::vector<JsonPath> row_paths;
+    rapidjson::Value* root = get_json_value(
+        json_str, get_json_paths(context, path, &row_paths));
+    if (root == NULL) {
+        return DoubleVal::null();
+    } else if (root->IsInt()) {
         return DoubleVal(static_cast<double>(root->GetInt()));
     } else if (root->IsDouble()) {
         return DoubleVal(root->GetDouble());
@@ -106,22 +205,20 @@ rapidjson::Value* JsonFunctions::get_json_object(
         const std::string& path_string,
         const JsonFunctionType& fntype,
         rapidjson::Document* document) {
-    std::vector<std::string> path_exprs;
-    boost::split(path_exprs, path_string, boost::is_any_of("."));
+    std::vector<JsonPath> parsed_paths;
+    parse_json_paths(path_string, &parsed_paths);
 
-    if (path_exprs[0] != "$") {
+    if (!parsed_paths[0].is_valid) {
         return document;
     }
 
-    if (UNLIKELY(path_exprs.size() == 1)) {
+    if (UNLIKELY(parsed_paths.size() == 1)) {
         if (fntype == JSON_FUN_STRING) {
             document->SetString(json_string.c_str(), document->GetAllocator());
-        } else {
-            return document;
         }
+        return document;
     }
 
-    //rapidjson::Document document;
     document->Parse(json_string.c_str());
     if (UNLIKELY(document->HasParseError())) {
         LOG(ERROR) << "Error at offset " << document->GetErrorOffset()
@@ -130,82 +227,111 @@ rapidjson::Value* JsonFunctions::get_json_object(
         return document;
     }
 
-    rapidjson::Value* root = document;
-    rapidjson::Value* array_obj = NULL;
+    return match_value(parsed_paths, document, document->GetAllocator());
+}
+
+void JsonFunctions::parse_json_paths(
+        const std::string& path_string, std::vector<JsonPath>* parsed_paths) {
+    std::vector<std::string> path_exprs;
+    boost::split(path_exprs, path_string, boost::is_any_of("."));
+    parsed_paths->clear();
+    parsed_paths->push_back(JsonPath(path_exprs[0], -1, path_exprs[0] == "$"));
+
     // eg: list[0],use regex parse path_string's result is 'list'
     std::string col;
     std::string index;
     for (int i = 1; i < path_exprs.size(); i++) {
+        col.clear();
+        index.clear();
+        if (UNLIKELY(!RE2::FullMatch(path_exprs[i], JSON_PATTERN, &col, &index))) {
+            parsed_paths->push_back(JsonPath("", -1, false));
+        } else {
+            parsed_paths->push_back(
+                JsonPath(col, index.empty() ? -1 : atoi(index.c_str()), true));
+        }
+    }
+}
+
+static rapidjson::Value* new_null_value(rapidjson::Document::AllocatorType& allocator) {
+    void* buf = allocator.Malloc(sizeof(rapidjson::Value));
+    return new (buf) rapidjson::Value();
+}
+
+rapidjson::Value* JsonFunctions::match_value(
+        const std::vector<JsonPath>& parsed_paths,
+        rapidjson::Value* document,
+        rapidjson::Document::AllocatorType& allocator) {
+    rapidjson::Value* root = document;
+    for (int i = 1; i < parsed_paths.size(); i++) {
         if (root->IsNull()) {
             break;
         }
 
-        if (UNLIKELY(!RE2::FullMatch(path_exprs[i], JSON_PATTERN, &col, &index))) {
-            root->SetNull();
+        const JsonPath& path = parsed_paths[i];
+        if (UNLIKELY(!path.is_valid)) {
+            return new_null_value(allocator);
         }
 
+        const std::string& col = path.key;
         if (LIKELY(!col.empty())) {
             if (root->IsArray()) {
-                array_obj = static_cast<rapidjson::Value*>(
-                        document->GetAllocator().Malloc(sizeof(rapidjson::Value)));
-                array_obj->SetArray();
+                rapidjson::Value* array_obj = new (allocator.Malloc(sizeof(rapidjson::Value)))
+                    rapidjson::Value(rapidjson::kArrayType);
                 bool is_null = true;
 
-                // if array ,loop the array,find out all Objects,then find the results from the objects
-                for (int j = 0; j < root->Size(); j++) {
-                    rapidjson::Value* json_elem = &((*root)[j]);
-
-                    if (json_elem->IsArray() || json_elem->IsNull()) {
+                // if array ,loop the array,find out all Objects,then find the results from
+                // the objects. The values are copied, the document stays unchanged.
+                for (rapidjson::SizeType j = 0; j < root->Size(); j++) {
+                    const rapidjson::Value& json_elem = (*root)[j];
+                    if (!json_elem.IsObject()) {
                         continue;
-                    } else {
-                        if (!json_elem->IsObject() || !json_elem->HasMember(col.c_str())) {
-                            continue;
-                        }
-                        rapidjson::Value* obj = &((*json_elem)[col.c_str()]);
-
-                        if (obj->IsArray()) {
-                            is_null = false;
-                            for (int k = 0; k < obj->Size(); k++) {
-                                array_obj->PushBack((*obj)[k], document->GetAllocator());
-                            }
-                        } else if (!obj->IsNull()) {
-                            is_null = false;
-                            array_obj->PushBack(*obj, document->GetAllocator());
+                    }
+                    rapidjson::Value::ConstMemberIterator it = json_elem.FindMember(col.c_str());
+                    if (it == json_elem.MemberEnd()) {
+                        continue;
+                    }
+                    const rapidjson::Value& obj = it->value;
+
+                    if (obj.IsArray()) {
+                        is_null = false;
+                        for (rapidjson::SizeType k = 0; k < obj.Size(); k++) {
+                            rapidjson::Value copy(obj[k], allocator);
+                            array_obj->PushBack(copy, allocator);
                         }
+                    } else if (!obj.IsNull()) {
+                        is_null = false;
+                        rapidjson::Value copy(obj, allocator);
+                        array_obj->PushBack(copy, allocator);
                     }
                 }
 
-                root = is_null ? &(array_obj->SetNull()) : array_obj;
-            } else if (root->IsObject()){
-                if (!root->HasMember(col.c_str())) {
-                    root->SetNull();
-                } else {
-                    root = &((*root)[col.c_str()]);
+                if (is_null) {
+                    return new_null_value(allocator);
+                }
+                root = array_obj;
+            } else if (root->IsObject()) {
+                rapidjson::Value::MemberIterator it = root->FindMember(col.c_str());
+                if (it == root->MemberEnd()) {
+                    return new_null_value(allocator);
                 }
+                root = &it->value;
             } else {
                 // root is not a nested type, return NULL
-                root->SetNull();
+                return new_null_value(allocator);
             }
         }
 
-        if (UNLIKELY(!index.empty())) {
+        if (UNLIKELY(path.index >= 0)) {
             // judge the rapidjson:Value, which base the top's result,
             // if not array return NULL;else get the index value from the array
-            if (root->IsArray()) {
-                int index_match = atoi(index.c_str());
-                if (root->IsNull() || index_match >= root->Size()) {
-                    root->SetNull();
-                } else {
-                    root = &((*root)[index_match]);
-                }
-            } else {
-                root->SetNull();
+            if (!root->IsArray() || path.index >= root->Size()) {
+                return new_null_value(allocator);
             }
+            root = &((*root)[path.index]);
         }
-     }
+    }
 
-     return root;
+    return root;
 }
 
 }
-
@@ -16,6 +16,9 @@
 #ifndef BDG_PALO_BE_SRC_QUERY_EXPRS_JSON_FUNCTIONS_H
 #define BDG_PALO_BE_SRC_QUERY_EXPRS_JSON_FUNCTIONS_H
 
+#include <string>
+#include <vector>
+
 #include <rapidjson/document.h>
 #include "runtime/string_value.h"
 
@@ -29,6 +32,19 @@ class Expr;
 class OpcodeRegistry;
 class TupleRow;
 
+// One component of a json path, e.g. "list[0]" of "$.list[0].id". The first component
+// of a valid path is always "$".
+struct JsonPath {
+    JsonPath(const std::string& key_, int index_, bool is_valid_) :
+        key(key_), index(index_), is_valid(is_valid_) { }
+
+    // Member to select, empty if the component is only an array index
+    std::string key;
+    // Array index to select, -1 if none
+    int index;
+    bool is_valid;
+};
+
 class JsonFunctions {
 public:
     static void init();
@@ -42,9 +58,28 @@ public:
         palo_udf::FunctionContext* context, const palo_udf::StringVal& json_str,
         const palo_udf::StringVal& path);
 
+    // Parses a constant path once for all rows.
+    static void json_path_prepare(
+        palo_udf::FunctionContext* context,
+        palo_udf::FunctionContext::FunctionStateScope scope);
+
+    static void json_path_close(
+        palo_udf::FunctionContext* context,
+        palo_udf::FunctionContext::FunctionStateScope scope);
+
     static rapidjson::Value* get_json_object(
             const std::string& json_string, const std::string& path_string,
             const JsonFunctionType& fntype, rapidjson::Document* document);
+
+    static void parse_json_paths(
+            const std::string& path_string, std::vector<JsonPath>* parsed_paths);
+
+    // Returns the value 'parsed_paths' selects in 'document', without modifying the
+    // document. Values that have to be built, e.g. the array of a member collected from
+    // all objects of an array, are allocated from 'allocator'.
+    static rapidjson::Value* match_value(
+            const std::vector<JsonPath>& parsed_paths, rapidjson::Value* document,
+            rapidjson::Document::AllocatorType& allocator);
 };
 }
 #endif
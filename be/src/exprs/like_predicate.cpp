@@ -240,8 +240,10 @@ BooleanVal LikePredicate::regexp_like(
             context->set_error(error_str.c_str());
             return BooleanVal(false);
         }
-        std::string re_pattern(reinterpret_cast<const char*>(pattern.ptr), pattern.len);
-        re2::RE2 re(re_pattern, opts);
+        LikePredicateState* state = reinterpret_cast<LikePredicateState*>(
+            context->get_function_state(FunctionContext::THREAD_LOCAL));
+        const re2::RE2& re = *state->regex_cache.get(
+            re2::StringPiece(reinterpret_cast<const char*>(pattern.ptr), pattern.len), opts);
         if (re.ok()) {
             return RE2::PartialMatch(re2::StringPiece(
                     reinterpret_cast<const char*>(val.ptr), val.len), re);
@@ -381,7 +383,9 @@ BooleanVal LikePredicate::regex_match(
             re_pattern =
                 std::string(reinterpret_cast<const char*>(pattern_value.ptr), pattern_value.len);
         }
-        re2::RE2 re(re_pattern, opts);
+        LikePredicateState* state = reinterpret_cast<LikePredicateState*>(
+            context->get_function_state(FunctionContext::THREAD_LOCAL));
+        const re2::RE2& re = *state->regex_cache.get(re_pattern, opts);
         if (re.ok()) {
             if (is_like_pattern) {
                 return RE2::FullMatch(re2::StringPiece(
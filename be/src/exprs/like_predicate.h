@@ -26,6 +26,7 @@
 #include <re2/re2.h>
 
 #include "exprs/predicate.h"
+#include "exprs/regex_cache.h"
 #include "gen_cpp/Exprs_types.h"
 #include "runtime/string_search.hpp"
 
@@ -69,6 +70,10 @@ private:
         /// Used for RLIKE and REGEXP predicates if the pattern is a constant argument.
         std::unique_ptr<re2::RE2> regex;
 
+        /// Used if the pattern is not a constant argument, to compile the pattern of
+        /// each row only if it wasn't used recently.
+        RegexCache regex_cache;
+
         LikePredicateState() : escape_char('\\') {
         }
 
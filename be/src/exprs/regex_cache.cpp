@@ -0,0 +1,64 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exprs/regex_cache.h"
+
+namespace palo {
+
+const int RegexCache::DEFAULT_CAPACITY;
+
+RegexCache::~RegexCache() {
+    for (EntryList::iterator it = _entries.begin(); it != _entries.end(); ++it) {
+        delete it->second;
+    }
+}
+
+// The options distinguishing regexes with the same pattern.
+static void append_options(const re2::RE2::Options& options, std::string* key) {
+    key->push_back(static_cast<char>(options.encoding()));
+    key->push_back(options.posix_syntax());
+    key->push_back(options.longest_match());
+    key->push_back(options.literal());
+    key->push_back(options.never_nl());
+    key->push_back(options.dot_nl());
+    key->push_back(options.never_capture());
+    key->push_back(options.case_sensitive());
+    key->push_back(options.perl_classes());
+    key->push_back(options.word_boundary());
+    key->push_back(options.one_line());
+    int64_t max_mem = options.max_mem();
+    key->append(reinterpret_cast<const char*>(&max_mem), sizeof(max_mem));
+}
+
+re2::RE2* RegexCache::get(const re2::StringPiece& pattern, const re2::RE2::Options& options) {
+    std::string key;
+    append_options(options, &key);
+    key.append(pattern.data(), pattern.size());
+    for (EntryList::iterator it = _entries.begin(); it != _entries.end(); ++it) {
+        if (it->first == key) {
+            _entries.splice(_entries.begin(), _entries, it);
+            return it->second;
+        }
+    }
+    re2::RE2* re = new re2::RE2(pattern, options);
+    _entries.push_front(std::make_pair(key, re));
+    while (_entries.size() > _capacity) {
+        delete _entries.back().second;
+        _entries.pop_back();
+    }
+    return re;
+}
+
+}
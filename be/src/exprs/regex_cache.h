@@ -0,0 +1,56 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_QUERY_EXPRS_REGEX_CACHE_H
+#define BDG_PALO_BE_SRC_QUERY_EXPRS_REGEX_CACHE_H
+
+#include <list>
+#include <string>
+#include <utility>
+
+#include <re2/re2.h>
+
+namespace palo {
+
+// LRU cache of compiled regexes for functions whose pattern is not a constant, keyed by
+// the pattern and the options. Rows of the same column tend to use few distinct
+// patterns, so most rows don't compile their regex anymore. RE2 matches in linear time,
+// a pathological pattern only costs its compilation, which is bounded by
+// RE2::Options::max_mem.
+//
+// Not thread safe, kept in the THREAD_LOCAL state of a FunctionContext.
+class RegexCache {
+public:
+    static const int DEFAULT_CAPACITY = 16;
+
+    RegexCache(int capacity = DEFAULT_CAPACITY) : _capacity(capacity) { }
+    ~RegexCache();
+
+    // Returns the regex for 'pattern' compiled with 'options'. It's owned by the cache
+    // and valid until the next call. May return a regex that failed to compile, the
+    // caller has to check ok().
+    re2::RE2* get(const re2::StringPiece& pattern, const re2::RE2::Options& options);
+
+private:
+    typedef std::list<std::pair<std::string, re2::RE2*> > EntryList;
+
+    const int _capacity;
+    // Most recently used first.
+    EntryList _entries;
+};
+
+}
+
+#endif
@@ -27,9 +27,12 @@
 #include "codegen/codegen_anyval.h"
 #include "codegen/llvm_codegen.h"
 #include "exprs/anyval_util.h"
+#include "exprs/expr_column.h"
 #include "exprs/expr_context.h"
+#include "exprs/subexpr_cache.h"
 #include "runtime/lib_cache.h"
 #include "runtime/runtime_state.h"
+#include "runtime/string_value.h"
 #include "udf/udf_internal.h"
 #include "util/debug_util.h"
 #include "util/symbols_util.h"
@@ -47,7 +50,9 @@ ScalarFnCall::ScalarFnCall(const TExprNode& node) :
         _scalar_fn_wrapper(NULL),
         _prepare_fn(NULL),
         _close_fn(NULL),
-        _scalar_fn(NULL) {
+        _scalar_fn(NULL),
+        _batch_fn(NULL),
+        _subexpr_cache_slot(-1) {
     DCHECK_NE(_fn.binary_type, TFunctionBinaryType::HIVE);
 }
 
@@ -166,6 +171,9 @@ Status ScalarFnCall::prepare(
         RETURN_IF_ERROR(get_function(state, _fn.scalar_fn.close_fn_symbol,
                                     reinterpret_cast<void**>(&_close_fn)));
     }
+    if (status.ok()) {
+        RETURN_IF_ERROR(get_batch_function(state));
+    }
 
     return status;
 }
@@ -565,6 +573,85 @@ Status ScalarFnCall::get_function(RuntimeState* state, const std::string& symbol
     return Status::OK;
 }
 
+static_assert(sizeof(palo_udf::BatchStringVal) == sizeof(StringValue)
+              && offsetof(palo_udf::BatchStringVal, ptr) == offsetof(StringValue, ptr)
+              && offsetof(palo_udf::BatchStringVal, len) == offsetof(StringValue, len),
+              "BatchStringVal must be laid out like StringValue");
+
+// Returns true if values of 'type' are laid out in ExprColumn the way UdfBatchFn
+// takes them.
+static bool is_batch_fn_type(const TypeDescriptor& type) {
+    switch (type.type) {
+    case TYPE_BOOLEAN:
+    case TYPE_TINYINT:
+    case TYPE_SMALLINT:
+    case TYPE_INT:
+    case TYPE_BIGINT:
+    case TYPE_LARGEINT:
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+    case TYPE_CHAR:
+    case TYPE_VARCHAR:
+    case TYPE_HLL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+Status ScalarFnCall::get_batch_function(RuntimeState* state) {
+    if (_fn.binary_type != TFunctionBinaryType::NATIVE
+            && _fn.binary_type != TFunctionBinaryType::BUILTIN) {
+        return Status::OK;
+    }
+    if (!is_batch_fn_type(_type)) {
+        return Status::OK;
+    }
+    for (int i = 0; i < _children.size(); ++i) {
+        if (!is_batch_fn_type(_children[i]->type())) {
+            return Status::OK;
+        }
+    }
+    void* fn = NULL;
+    if (_fn.scalar_fn.__isset.batch_fn_symbol) {
+        RETURN_IF_ERROR(get_function(state, _fn.scalar_fn.batch_fn_symbol, &fn));
+    } else if (_fn.binary_type == TFunctionBinaryType::NATIVE
+            && !SymbolsUtil::is_mangled(_fn.scalar_fn.symbol)) {
+        // The batch function of a UDF with an unmangled symbol is optional
+        Status status = LibCache::instance()->get_so_function_ptr(
+            _fn.hdfs_location, _fn.scalar_fn.symbol + "_batch", &fn, &_cache_entry, true);
+        if (!status.ok()) {
+            fn = NULL;
+        }
+    }
+    _batch_fn = reinterpret_cast<palo_udf::UdfBatchFn>(fn);
+    return Status::OK;
+}
+
+void ScalarFnCall::evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                  int num_rows, ExprColumn* result) {
+    if (_batch_fn == NULL || is_constant()) {
+        Expr::evaluate_batch(context, batch, sel, num_rows, result);
+        return;
+    }
+    std::vector<ExprColumn> args(_children.size());
+    std::vector<const void*> arg_values(_children.size());
+    std::vector<const uint8_t*> arg_nulls(_children.size());
+    for (int i = 0; i < _children.size(); ++i) {
+        _children[i]->evaluate_batch(context, batch, sel, num_rows, &args[i]);
+        arg_values[i] = args[i].raw_values();
+        arg_nulls[i] = args[i].nulls();
+    }
+    result->reset(_type, num_rows);
+    if (num_rows == 0) {
+        return;
+    }
+    FunctionContext* fn_ctx = context->fn_context(_fn_context_index);
+    _batch_fn(fn_ctx, num_rows, arg_values.empty() ? NULL : &arg_values[0],
+              arg_nulls.empty() ? NULL : &arg_nulls[0],
+              result->raw_values(), result->nulls());
+}
+
 void ScalarFnCall::evaluate_children(
         ExprContext* context, TupleRow* row, std::vector<AnyVal*>* input_vals) {
     DCHECK_EQ(input_vals->size(), num_fixed_args());
@@ -585,6 +672,20 @@ void ScalarFnCall::evaluate_children(
 
 template<typename RETURN_TYPE>
 RETURN_TYPE ScalarFnCall::interpret_eval(ExprContext* context, TupleRow* row) {
+    SubExprCache* cache = context->_subexpr_cache;
+    if (_subexpr_cache_slot < 0 || cache == NULL || !cache->in_row(row)) {
+        return call_scalar_fn<RETURN_TYPE>(context, row);
+    }
+    RETURN_TYPE result;
+    if (!cache->lookup(_subexpr_cache_slot, &result)) {
+        result = call_scalar_fn<RETURN_TYPE>(context, row);
+        cache->store(_subexpr_cache_slot, result);
+    }
+    return result;
+}
+
+template<typename RETURN_TYPE>
+RETURN_TYPE ScalarFnCall::call_scalar_fn(ExprContext* context, TupleRow* row) {
     DCHECK(_scalar_fn != NULL);
     FunctionContext* fn_ctx = context->fn_context(_fn_context_index);
     std::vector<AnyVal*>* input_vals = fn_ctx->impl()->staging_input_vals();
@@ -58,6 +58,7 @@ public:
 
 protected:
     friend class Expr;
+    friend class SubExprCache;
 
     ScalarFnCall(const TExprNode& node);
     virtual Status prepare(
@@ -83,6 +84,10 @@ protected:
     virtual palo_udf::DecimalVal get_decimal_val(ExprContext* context, TupleRow*);
     // virtual palo_udf::ArrayVal GetArrayVal(ExprContext* context, TupleRow*);
 
+    /// Calls the UDF's batch function on the columns of the children if it has one.
+    virtual void evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result) override;
+
 private:
     /// If this function has var args, children()[_vararg_start_idx] is the first vararg
     /// argument.
@@ -107,6 +112,14 @@ private:
     /// scalar function.
     void* _scalar_fn;
 
+    /// The UDF's batch function, if it has one and all the argument and return types
+    /// can be passed to it. Initialized in Prepare().
+    palo_udf::UdfBatchFn _batch_fn;
+
+    /// Slot of the result of this call in the SubExprCache of the evaluating context if
+    /// the call is shared with other exprs, -1 otherwise.
+    int _subexpr_cache_slot;
+
     /// Returns the number of non-vararg arguments
     int num_fixed_args() const {
         return _vararg_start_idx >= 0 ? _vararg_start_idx : _children.size();
@@ -120,14 +133,22 @@ private:
     /// has been JIT'd (i.e. after Prepare() has completed).
     Status get_function(RuntimeState* state, const std::string& symbol, void** fn);
 
+    /// Looks up the batch function of the UDF, leaving _batch_fn NULL if there is none.
+    Status get_batch_function(RuntimeState* state);
+
     /// Evaluates the children exprs and stores the results in input_vals. Used in the
     /// interpreted path.
     void evaluate_children(ExprContext* context, TupleRow* row,
                           std::vector<palo_udf::AnyVal*>* input_vals);
 
-    /// Function to call _scalar_fn. Used in the interpreted path.
+    /// Function to call _scalar_fn, or to return its cached result for 'row'. Used in
+    /// the interpreted path.
     template<typename RETURN_TYPE>
     RETURN_TYPE interpret_eval(ExprContext* context, TupleRow* row);
+
+    /// Evaluates the children and calls _scalar_fn on them.
+    template<typename RETURN_TYPE>
+    RETURN_TYPE call_scalar_fn(ExprContext* context, TupleRow* row);
 };
 
 }
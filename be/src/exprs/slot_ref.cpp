@@ -24,7 +24,9 @@
 
 #include "codegen/codegen_anyval.h"
 #include "codegen/llvm_codegen.h"
+#include "exprs/expr_column.h"
 #include "gen_cpp/Exprs_types.h"
+#include "runtime/row_batch.h"
 #include "runtime/runtime_state.h"
 
 using llvm::BasicBlock;
@@ -102,6 +104,7 @@ Status SlotRef::prepare(
     _slot_offset = slot_desc->tuple_offset();
     _null_indicator_offset = slot_desc->null_indicator_offset();
     _is_nullable = slot_desc->is_nullable();
+    _col_name = slot_desc->col_name();
     return Status::OK;
 }
 
@@ -523,4 +526,52 @@ DecimalVal SlotRef::get_decimal_val(ExprContext* context, TupleRow* row) {
     return dec_val;
 }
 
+template <int SIZE>
+void SlotRef::copy_slots(RowBatch* batch, const int* sel, int num_rows,
+                         uint8_t* values, uint8_t* nulls) {
+    for (int i = 0; i < num_rows; ++i) {
+        Tuple* t = batch->get_row(sel != NULL ? sel[i] : i)->get_tuple(_tuple_idx);
+        if (t == NULL || t->is_null(_null_indicator_offset)) {
+            nulls[i] = 1;
+        } else {
+            // constant SIZE lets the compiler turn this into a plain load and store
+            memcpy(values + i * SIZE, t->get_slot(_slot_offset), SIZE);
+        }
+    }
+}
+
+void SlotRef::evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                             int num_rows, ExprColumn* result) {
+    result->reset(_type, num_rows);
+    uint8_t* values = result->raw_values();
+    uint8_t* nulls = result->nulls();
+    switch (result->value_size()) {
+    case 1:
+        copy_slots<1>(batch, sel, num_rows, values, nulls);
+        break;
+    case 2:
+        copy_slots<2>(batch, sel, num_rows, values, nulls);
+        break;
+    case 4:
+        copy_slots<4>(batch, sel, num_rows, values, nulls);
+        break;
+    case 8:
+        copy_slots<8>(batch, sel, num_rows, values, nulls);
+        break;
+    case 16:
+        copy_slots<16>(batch, sel, num_rows, values, nulls);
+        break;
+    default:
+        for (int i = 0; i < num_rows; ++i) {
+            Tuple* t = batch->get_row(sel != NULL ? sel[i] : i)->get_tuple(_tuple_idx);
+            if (t == NULL || t->is_null(_null_indicator_offset)) {
+                nulls[i] = 1;
+            } else {
+                result->set_value(i, t->get_slot(_slot_offset));
+            }
+        }
+        break;
+    }
+}
+
 }
@@ -64,6 +64,10 @@ public:
     SlotId slot_id() const {
         return _slot_id;
     }
+    // name of the table column this slot reads, set in prepare()
+    const std::string& col_name() const {
+        return _col_name;
+    }
     inline NullIndicatorOffset null_indicator_offset() const {
         return _null_indicator_offset;
     }
@@ -82,7 +86,15 @@ public:
     virtual palo_udf::DecimalVal get_decimal_val(ExprContext* context, TupleRow*);
     // virtual palo_udf::ArrayVal GetArrayVal(ExprContext* context, TupleRow*);
 
+    virtual void evaluate_batch(ExprContext* context, RowBatch* batch, const int* sel,
+                                int num_rows, ExprColumn* result);
+
 private:
+    // Copies the slot of every row into 'values', 'SIZE' bytes each.
+    template <int SIZE>
+    void copy_slots(RowBatch* batch, const int* sel, int num_rows,
+                    uint8_t* values, uint8_t* nulls);
+
     int _tuple_idx;  // within row
     int _slot_offset;  // within tuple
     NullIndicatorOffset _null_indicator_offset;  // within tuple
@@ -90,6 +102,7 @@ private:
     bool _tuple_is_nullable; // true if the tuple is nullable.
     TupleId _tuple_id; // used for desc this slot from
     bool _is_nullable;
+    std::string _col_name;
 };
 
 inline bool SlotRef::vector_compute_fn(Expr* expr, VectorizedRowBatch* /* batch */) {
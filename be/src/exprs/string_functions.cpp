@@ -24,8 +24,10 @@
 
 #include "exprs/expr.h"
 #include "exprs/anyval_util.h"
+#include "exprs/regex_cache.h"
 #include "runtime/string_value.hpp"
 #include "runtime/tuple_row.h"
+#include "udf/udf_internal.h"
 #include "util/url_parser.h"
 
 // NOTE: be careful not to use string::append.  It is not performant.
@@ -356,6 +358,22 @@ bool StringFunctions::set_re2_options(
     return true;
 }
 
+static void set_regex_options(re2::RE2::Options* options) {
+    // Disable error logging in case e.g. every row causes an error
+    options->set_log_errors(false);
+    // Return the leftmost longest match (rather than the first match).
+    options->set_longest_match(true);
+    options->set_dot_nl(true);
+}
+
+static void set_compile_error(const StringVal& pattern, const re2::RE2& re,
+                              std::string* error_str) {
+    std::stringstream ss;
+    ss << "Could not compile regexp pattern: " << AnyValUtil::to_string(pattern)
+        << std::endl << "Error: " << re.error();
+    *error_str = ss.str();
+}
+
 // The caller owns the returned regex. Returns NULL if the pattern could not be compiled.
 static re2::RE2* compile_regex(
         const StringVal& pattern, 
@@ -363,30 +381,46 @@ static re2::RE2* compile_regex(
         const StringVal& match_parameter) {
     re2::StringPiece pattern_sp(reinterpret_cast<char*>(pattern.ptr), pattern.len);
     re2::RE2::Options options;
-    // Disable error logging in case e.g. every row causes an error
-    options.set_log_errors(false);
-    // Return the leftmost longest match (rather than the first match).
-    options.set_longest_match(true);
-    options.set_dot_nl(true);
+    set_regex_options(&options);
     if (!match_parameter.is_null
             && !StringFunctions::set_re2_options(match_parameter, error_str, &options)) {
         return NULL;
     }
     re2::RE2* re = new re2::RE2(pattern_sp, options);
     if (!re->ok()) {
-        std::stringstream ss;
-        ss << "Could not compile regexp pattern: " << AnyValUtil::to_string(pattern) 
-            << std::endl << "Error: " << re->error();
-        *error_str = ss.str();
+        set_compile_error(pattern, *re, error_str);
         delete re;
         return NULL;
     }
     return re;
 }
 
+// Returns the regex for the non-constant 'pattern' of the current row from the
+// RegexCache of 'context', or NULL if the pattern could not be compiled. The cache owns
+// the regex.
+static re2::RE2* get_cached_regex(
+        FunctionContext* context, const StringVal& pattern, std::string* error_str) {
+    RegexCache* cache = reinterpret_cast<RegexCache*>(
+        context->get_function_state(FunctionContext::THREAD_LOCAL));
+    DCHECK(cache != NULL);
+    re2::RE2::Options options;
+    set_regex_options(&options);
+    re2::RE2* re = cache->get(
+        re2::StringPiece(reinterpret_cast<char*>(pattern.ptr), pattern.len), options);
+    if (!re->ok()) {
+        set_compile_error(pattern, *re, error_str);
+        return NULL;
+    }
+    return re;
+}
+
 void StringFunctions::regexp_prepare(
         FunctionContext* context, FunctionContext::FunctionStateScope scope) {
-    if (scope != FunctionContext::FRAGMENT_LOCAL) {
+    if (scope == FunctionContext::THREAD_LOCAL) {
+        // Patterns that differ per row are compiled at most once per cache entry.
+        if (!context->is_arg_constant(1)) {
+            context->set_function_state(scope, new RegexCache());
+        }
         return;
     }
 
@@ -408,7 +442,8 @@ void StringFunctions::regexp_prepare(
 
 void StringFunctions::regexp_close(
         FunctionContext* context, FunctionContext::FunctionStateScope scope) {
-    if (scope != FunctionContext::FRAGMENT_LOCAL) {
+    if (scope == FunctionContext::THREAD_LOCAL) {
+        delete reinterpret_cast<RegexCache*>(context->get_function_state(scope));
         return;
     }
     re2::RE2* re = reinterpret_cast<re2::RE2*>(context->get_function_state(scope));
@@ -427,16 +462,14 @@ StringVal StringFunctions::regexp_extract(
 
     re2::RE2* re = reinterpret_cast<re2::RE2*>(
         context->get_function_state(FunctionContext::FRAGMENT_LOCAL));
-    std::unique_ptr<re2::RE2> scoped_re; // destroys re if we have to locally compile it
     if (re == NULL) {
         DCHECK(!context->is_arg_constant(1));
         std::string error_str;
-        re = compile_regex(pattern, &error_str, StringVal::null());
+        re = get_cached_regex(context, pattern, &error_str);
         if (re == NULL) {
             context->add_warning(error_str.c_str());
             return StringVal::null();
         }
-        scoped_re.reset(re);
     }
 
     re2::StringPiece str_sp(reinterpret_cast<char*>(str.ptr), str.len);
@@ -453,8 +486,9 @@ StringVal StringFunctions::regexp_extract(
         return StringVal();
     }
     // matches[0] is the whole string, matches[1] the first group, etc.
+    // The match points into str, so it is returned without a copy like substring().
     const re2::StringPiece& match = matches[index.val];
-    return AnyValUtil::from_buffer_temp(context, match.data(), match.size());
+    return StringVal(reinterpret_cast<uint8_t*>(const_cast<char*>(match.data())), match.size());
 }
 
 StringVal StringFunctions::regexp_replace(
@@ -466,23 +500,27 @@ StringVal StringFunctions::regexp_replace(
 
     re2::RE2* re = reinterpret_cast<re2::RE2*>(
         context->get_function_state(FunctionContext::FRAGMENT_LOCAL));
-    std::unique_ptr<re2::RE2> scoped_re; // destroys re if state->re is NULL
     if (re == NULL) {
         DCHECK(!context->is_arg_constant(1));
         std::string error_str;
-        re = compile_regex(pattern, &error_str, StringVal::null());
+        re = get_cached_regex(context, pattern, &error_str);
         if (re == NULL) {
             context->add_warning(error_str.c_str());
             return StringVal::null();
         }
-        scoped_re.reset(re);
     }
 
     re2::StringPiece replace_str =
         re2::StringPiece(reinterpret_cast<char*>(replace.ptr), replace.len);
-    std::string result_str = AnyValUtil::to_string(str);
-    re2::RE2::GlobalReplace(&result_str, *re, replace_str);
-    return AnyValUtil::from_string_temp(context, result_str);
+    // Replace in the context's scratch string, which is what a temp result
+    // would be copied into anyway.
+    std::string& result_str = context->impl()->string_result();
+    result_str.assign(reinterpret_cast<const char*>(str.ptr), str.len);
+    if (re2::RE2::GlobalReplace(&result_str, *re, replace_str) == 0) {
+        // nothing matched, the input is the result
+        return str;
+    }
+    return StringVal(reinterpret_cast<uint8_t*>(&result_str[0]), result_str.size());
 }
 
 StringVal StringFunctions::concat(
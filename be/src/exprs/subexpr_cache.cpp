@@ -0,0 +1,148 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exprs/subexpr_cache.h"
+
+#include <sstream>
+
+#include <boost/unordered_map.hpp>
+
+#include "common/object_pool.h"
+#include "exprs/expr.h"
+#include "exprs/expr_context.h"
+#include "exprs/scalar_fn_call.h"
+#include "exprs/slot_ref.h"
+#include "runtime/raw_value.h"
+
+namespace palo {
+
+bool SubExprCache::is_nondeterministic(const Expr* e) {
+    const std::string& name = e->_fn.name.function_name;
+    return name == "rand" || name == "random" || name == "uuid" || name == "sleep";
+}
+
+bool SubExprCache::build_key(ExprContext* ctx, Expr* e, std::string* key) {
+    std::stringstream ss;
+    ss << e->node_type() << ":" << e->type().debug_string();
+    switch (e->node_type()) {
+    case TExprNodeType::BOOL_LITERAL:
+    case TExprNodeType::INT_LITERAL:
+    case TExprNodeType::LARGE_INT_LITERAL:
+    case TExprNodeType::FLOAT_LITERAL:
+    case TExprNodeType::DECIMAL_LITERAL:
+    case TExprNodeType::DATE_LITERAL:
+    case TExprNodeType::STRING_LITERAL: {
+        // Literals don't depend on the row and can be evaluated before open().
+        std::stringstream value;
+        RawValue::print_value_as_bytes(ctx->get_value(e, NULL), e->type(), &value);
+        const std::string& bytes = value.str();
+        ss << "(" << bytes.size() << ":";
+        ss.write(bytes.data(), bytes.size());
+        ss << ")";
+        key->append(ss.str());
+        return true;
+    }
+    case TExprNodeType::NULL_LITERAL:
+        key->append(ss.str());
+        return true;
+    case TExprNodeType::SLOT_REF:
+        ss << "(" << static_cast<SlotRef*>(e)->slot_id() << ")";
+        key->append(ss.str());
+        return true;
+    case TExprNodeType::ARITHMETIC_EXPR:
+    case TExprNodeType::CAST_EXPR:
+    case TExprNodeType::FUNCTION_CALL:
+    case TExprNodeType::COMPUTE_FUNCTION_CALL:
+        if (is_nondeterministic(e)) {
+            return false;
+        }
+        ss << ":" << e->op() << ":" << e->_fn.scalar_fn.symbol;
+        break;
+    default:
+        return false;
+    }
+    key->append(ss.str());
+    key->append("(");
+    for (int i = 0; i < e->get_num_children(); ++i) {
+        if (!build_key(ctx, e->get_child(i), key)) {
+            return false;
+        }
+        key->append(",");
+    }
+    key->append(")");
+    return true;
+}
+
+namespace {
+
+void collect_calls(Expr* e, std::vector<ScalarFnCall*>* calls) {
+    ScalarFnCall* call = dynamic_cast<ScalarFnCall*>(e);
+    if (call != NULL && !call->is_constant()) {
+        calls->push_back(call);
+    }
+    for (int i = 0; i < e->get_num_children(); ++i) {
+        collect_calls(e->get_child(i), calls);
+    }
+}
+
+}
+
+SubExprCache* SubExprCache::create(ObjectPool* pool, const std::vector<ExprContext*>& ctxs) {
+    typedef boost::unordered_map<std::string, std::vector<ScalarFnCall*> > OccurrenceMap;
+    OccurrenceMap occurrences;
+    for (int i = 0; i < ctxs.size(); ++i) {
+        std::vector<ScalarFnCall*> calls;
+        collect_calls(ctxs[i]->root(), &calls);
+        for (int j = 0; j < calls.size(); ++j) {
+            // A call already shared through another cache keeps it.
+            if (calls[j]->_subexpr_cache_slot >= 0) {
+                continue;
+            }
+            std::string key;
+            if (build_key(ctxs[i], calls[j], &key)) {
+                occurrences[key].push_back(calls[j]);
+            }
+        }
+    }
+
+    int num_slots = 0;
+    for (OccurrenceMap::iterator it = occurrences.begin(); it != occurrences.end(); ++it) {
+        if (it->second.size() > 1) {
+            ++num_slots;
+        }
+    }
+    if (num_slots == 0) {
+        return NULL;
+    }
+
+    SubExprCache* cache = pool->add(new SubExprCache(num_slots));
+    int slot = 0;
+    for (OccurrenceMap::iterator it = occurrences.begin(); it != occurrences.end(); ++it) {
+        const std::vector<ScalarFnCall*>& calls = it->second;
+        if (calls.size() < 2) {
+            continue;
+        }
+        for (int i = 0; i < calls.size(); ++i) {
+            calls[i]->_subexpr_cache_slot = slot;
+        }
+        ++slot;
+    }
+    for (int i = 0; i < ctxs.size(); ++i) {
+        ctxs[i]->_subexpr_cache = cache;
+    }
+    return cache;
+}
+
+}
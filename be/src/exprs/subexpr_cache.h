@@ -0,0 +1,155 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_QUERY_EXPRS_SUBEXPR_CACHE_H
+#define BDG_PALO_BE_SRC_QUERY_EXPRS_SUBEXPR_CACHE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "common/logging.h"
+#include "udf/udf.h"
+
+namespace palo {
+
+class Expr;
+class ExprContext;
+class ObjectPool;
+class TupleRow;
+
+// Per-row cache of the results of function calls that occur more than once in a set of
+// expr trees evaluated over the same row, e.g. 'substr(k1, 1, 3)' in
+//   WHERE substr(k1, 1, 3) = 'abc' OR substr(k1, 1, 3) = 'xyz'
+// or in both the grouping exprs and the inputs of the aggregate functions. The first
+// evaluation of such a call for a row stores its result, the other occurrences return
+// it without evaluating their arguments again.
+//
+// Two calls are the same if they call the same function with the same result type on
+// the same arguments, where arguments are compared structurally down to slot refs and
+// literals. Calls that are not deterministic (rand(), uuid(), ...) are never shared.
+//
+// Results are only reused while the row is in scope, i.e. between begin_row() and
+// end_row() for the same TupleRow (see RowScope), so evaluations outside of a scope
+// are not affected. Only the interpreted path of ScalarFnCall uses the cache; calls
+// with a codegen'd compute function are evaluated as before.
+//
+// Like ExprContext, a cache is not thread-safe. It is shared by the contexts it was
+// created for but not by their clones.
+class SubExprCache {
+public:
+    // Marks 'row' as the row the cache is valid for during its lifetime. 'cache' may be
+    // NULL, in which case this does nothing.
+    class RowScope {
+    public:
+        RowScope(SubExprCache* cache, TupleRow* row) : _cache(cache), _prev_row(NULL) {
+            if (_cache != NULL) {
+                _prev_row = _cache->_row;
+                _cache->begin_row(row);
+            }
+        }
+
+        ~RowScope() {
+            if (_cache != NULL) {
+                // A nested scope may have overwritten results of the outer row, so
+                // the outer row starts over.
+                _cache->begin_row(_prev_row);
+            }
+        }
+
+    private:
+        SubExprCache* _cache;
+        TupleRow* _prev_row;
+    };
+
+    // Finds the function calls occurring more than once in the prepared expr trees of
+    // 'ctxs' and attaches a cache for them to all of 'ctxs'. Returns NULL, and changes
+    // nothing, if there are none. The cache is owned by 'pool'.
+    static SubExprCache* create(ObjectPool* pool, const std::vector<ExprContext*>& ctxs);
+
+    // Invalidates all results and makes 'row' the current row. NULL disables the cache.
+    void begin_row(TupleRow* row) {
+        ++_epoch;
+        _row = row;
+    }
+
+    void end_row() {
+        begin_row(NULL);
+    }
+
+    // True if results computed for 'row' may be cached.
+    bool in_row(const TupleRow* row) const {
+        return _row != NULL && row == _row;
+    }
+
+    int num_slots() const {
+        return _entries.size();
+    }
+
+    // Copies the result of slot 'slot' into '*val' and returns true if it was computed
+    // for the current row.
+    template <typename T>
+    bool lookup(int slot, T* val) const {
+        DCHECK_GE(slot, 0);
+        DCHECK_LT(slot, _entries.size());
+        const Entry& entry = _entries[slot];
+        if (entry.epoch != _epoch) {
+            return false;
+        }
+        memcpy(val, entry.value, sizeof(T));
+        return true;
+    }
+
+    // Stores 'val' as the result of slot 'slot' for the current row.
+    template <typename T>
+    void store(int slot, const T& val) {
+        DCHECK_GE(slot, 0);
+        DCHECK_LT(slot, _entries.size());
+        static_assert(sizeof(T) <= sizeof(palo_udf::DecimalVal), "AnyVal too large");
+        Entry& entry = _entries[slot];
+        memcpy(entry.value, &val, sizeof(T));
+        entry.epoch = _epoch;
+    }
+
+private:
+    struct Entry {
+        Entry() : epoch(0) { }
+
+        // Epoch of the row 'value' was computed for.
+        int64_t epoch;
+        // Large enough for any AnyVal; DecimalVal is the largest one.
+        char value[sizeof(palo_udf::DecimalVal)] __attribute__((aligned(16)));
+    };
+
+    SubExprCache(int num_slots) : _entries(num_slots), _epoch(1), _row(NULL) { }
+
+    // Appends a key identifying the value of 'e' to 'key'. Returns false if 'e' cannot
+    // be compared structurally.
+    static bool build_key(ExprContext* ctx, Expr* e, std::string* key);
+
+    // Returns true if the function called by 'e' may return different results for the
+    // same arguments.
+    static bool is_nondeterministic(const Expr* e);
+
+    std::vector<Entry> _entries;
+    int64_t _epoch;
+    TupleRow* _row;
+};
+
+}
+
+#endif
@@ -40,6 +40,8 @@ namespace palo {
 
 boost::local_time::tz_database TimezoneDatabase::_s_tz_database;
 std::vector<std::string> TimezoneDatabase::_s_tz_region_list;
+boost::mutex TimezoneDatabase::_s_tz_cache_lock;
+TimezoneDatabase::TimezoneCache TimezoneDatabase::_s_tz_cache;
 
 void TimestampFunctions::init() {
 }
@@ -577,6 +579,18 @@ TimezoneDatabase::TimezoneDatabase() {
 TimezoneDatabase::~TimezoneDatabase() { }
 
 boost::local_time::time_zone_ptr TimezoneDatabase::find_timezone(const std::string& tz) {
+    boost::lock_guard<boost::mutex> l(_s_tz_cache_lock);
+    TimezoneCache::const_iterator it = _s_tz_cache.find(tz);
+    if (it != _s_tz_cache.end()) {
+        return it->second;
+    }
+    boost::local_time::time_zone_ptr tzp = find_timezone_uncached(tz);
+    _s_tz_cache.insert(std::make_pair(tz, tzp));
+    return tzp;
+}
+
+boost::local_time::time_zone_ptr TimezoneDatabase::find_timezone_uncached(
+        const std::string& tz) {
     // See if they specified a zone id
     if (tz.find_first_of('/') != std::string::npos) {
         return  _s_tz_database.time_zone_from_region(tz);
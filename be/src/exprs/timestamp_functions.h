@@ -25,7 +25,9 @@
 #include <boost/date_time/gregorian/gregorian.hpp>
 #include <boost/date_time/time_zone_base.hpp>
 #include <boost/date_time/local_time/local_time.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/thread/thread.hpp>
+#include <boost/unordered_map.hpp>
 #include "runtime/string_value.h"
 #include "runtime/datetime_value.h"
 
@@ -180,9 +182,19 @@ public:
     TimezoneDatabase();
     ~TimezoneDatabase();
 
+    // Returns the timezone with the region id, abbreviation or name 'tz', or an empty
+    // pointer if there is none. Lookups are cached, so that converting every row of a
+    // query doesn't scan all regions again.
     static boost::local_time::time_zone_ptr find_timezone(const std::string& tz);
 
 private:
+    static boost::local_time::time_zone_ptr find_timezone_uncached(const std::string& tz);
+
+    typedef boost::unordered_map<std::string, boost::local_time::time_zone_ptr> TimezoneCache;
+
+    static boost::mutex _s_tz_cache_lock;
+    static TimezoneCache _s_tz_cache;
+
     static const char* _s_timezone_database_str;
     static boost::local_time::tz_database _s_tz_database;
     static std::vector<std::string> _s_tz_region_list;
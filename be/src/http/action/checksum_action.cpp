@@ -35,6 +35,8 @@ const std::string TABLET_ID = "tablet_id";
 const std::string TABLET_VERSION = "version";
 const std::string VERSION_HASH = "version_hash";
 const std::string SCHEMA_HASH = "schema_hash";
+// "force=true" recomputes checksum from data instead of the cached one
+const std::string FORCE = "force";
 
 ChecksumAction::ChecksumAction(ExecEnv* exec_env) :
         _exec_env(exec_env) {
@@ -128,8 +130,9 @@ int64_t ChecksumAction::do_checksum(int64_t tablet_id, int64_t version, int64_t
 
     OLAPStatus res = OLAPStatus::OLAP_SUCCESS;
     uint32_t checksum;
+    bool force = req->param(FORCE) == "true";
     res = _command_executor->compute_checksum(
-            tablet_id, schema_hash, version, version_hash, &checksum);
+            tablet_id, schema_hash, version, version_hash, force, &checksum);
     if (res != OLAPStatus::OLAP_SUCCESS) {
         LOG(WARNING) << "checksum failed. status: " << res
                      << ", signature: " << tablet_id;
@@ -0,0 +1,196 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "http/action/lookup_action.h"
+
+#include <string>
+#include <vector>
+
+#include <boost/lexical_cast.hpp>
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include "common/config.h"
+#include "http/http_channel.h"
+#include "http/http_headers.h"
+#include "http/http_request.h"
+#include "http/http_response.h"
+#include "http/http_status.h"
+
+namespace palo {
+
+static const std::string TABLET_ID = "tablet_id";
+// do not use name "VERSION",
+// or will be conflict with "VERSION" in thrift/config.h
+static const std::string TABLET_VERSION = "version";
+static const std::string VERSION_HASH = "version_hash";
+static const std::string SCHEMA_HASH = "schema_hash";
+static const std::string HEADER_JSON = "application/json";
+// max size of request body
+static const int64_t MAX_BODY_LENGTH = 64 * 1024 * 1024;
+
+LookupAction::LookupAction(ExecEnv* exec_env) :
+        _exec_env(exec_env) {
+    _command_executor = new CommandExecutor();
+}
+
+LookupAction::~LookupAction() {
+    if (_command_executor != NULL) {
+        delete _command_executor;
+    }
+}
+
+void LookupAction::handle(HttpRequest *req, HttpChannel *channel) {
+    const std::string& tablet_id_str = req->param(TABLET_ID);
+    const std::string& version_str = req->param(TABLET_VERSION);
+    const std::string& version_hash_str = req->param(VERSION_HASH);
+    const std::string& schema_hash_str = req->param(SCHEMA_HASH);
+    if (tablet_id_str.empty() || version_str.empty()
+            || version_hash_str.empty() || schema_hash_str.empty()) {
+        std::string error_msg = std::string("parameter " + TABLET_ID + ", " + TABLET_VERSION
+                + ", " + VERSION_HASH + " and " + SCHEMA_HASH + " must be specified in url.");
+        HttpResponse response(HttpStatus::BAD_REQUEST, &error_msg);
+        channel->send_response(response);
+        return;
+    }
+
+    int64_t tablet_id;
+    int64_t version;
+    int64_t version_hash;
+    int32_t schema_hash;
+    try {
+        tablet_id = boost::lexical_cast<int64_t>(tablet_id_str);
+        version = boost::lexical_cast<int64_t>(version_str);
+        version_hash = boost::lexical_cast<int64_t>(version_hash_str);
+        schema_hash = boost::lexical_cast<int32_t>(schema_hash_str);
+    } catch (boost::bad_lexical_cast& e) {
+        std::string error_msg = std::string("param format is invalid: ") + std::string(e.what());
+        HttpResponse response(HttpStatus::BAD_REQUEST, &error_msg);
+        channel->send_response(response);
+        return;
+    }
+
+    std::vector<std::vector<std::string> > keys;
+    std::string error_msg;
+    if (!_parse_keys(req, channel, &keys, &error_msg)) {
+        HttpResponse response(HttpStatus::BAD_REQUEST, &error_msg);
+        channel->send_response(response);
+        return;
+    }
+
+    std::vector<std::vector<std::string> > rows;
+    OLAPStatus res = _command_executor->lookup_rows(
+            tablet_id, schema_hash, version, version_hash, keys, &rows);
+    if (res != OLAP_SUCCESS) {
+        LOG(WARNING) << "lookup failed. status: " << res << ", tablet id: " << tablet_id;
+        std::string error_msg = std::string("lookup failed");
+        HttpResponse response(HttpStatus::INTERNAL_SERVER_ERROR, &error_msg);
+        channel->send_response(response);
+        return;
+    }
+
+    rapidjson::Document document;
+    document.SetObject();
+    rapidjson::Document::AllocatorType& allocator = document.GetAllocator();
+    rapidjson::Value rows_value(rapidjson::kArrayType);
+    for (const std::vector<std::string>& row : rows) {
+        rapidjson::Value row_value;
+        if (!row.empty()) {
+            row_value.SetArray();
+            for (const std::string& column : row) {
+                rapidjson::Value column_value;
+                column_value.SetString(column.c_str(), column.size(), allocator);
+                row_value.PushBack(column_value, allocator);
+            }
+        }
+        rows_value.PushBack(row_value, allocator);
+    }
+    document.AddMember("status", "OK", allocator);
+    document.AddMember("rows", rows_value, allocator);
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    document.Accept(writer);
+    std::string result = buffer.GetString();
+
+    HttpResponse response(HttpStatus::OK, HEADER_JSON, &result);
+    channel->send_response(response);
+}
+
+bool LookupAction::_parse_keys(HttpRequest* req,
+                               HttpChannel* channel,
+                               std::vector<std::vector<std::string> >* keys,
+                               std::string* error_msg) {
+    const std::string& length_str = req->header(HttpHeaders::CONTENT_LENGTH);
+    int64_t length = 0;
+    try {
+        length = boost::lexical_cast<int64_t>(length_str);
+    } catch (boost::bad_lexical_cast& e) {
+        *error_msg = "invalid " + std::string(HttpHeaders::CONTENT_LENGTH) + " in request headers";
+        return false;
+    }
+
+    if (length <= 0 || length > MAX_BODY_LENGTH) {
+        *error_msg = "invalid length of request body";
+        return false;
+    }
+
+    std::string body(length, '\0');
+    int64_t read_length = 0;
+    while (read_length < length) {
+        int len = channel->read(&body[read_length], length - read_length);
+        if (len <= 0) {
+            *error_msg = "failed when receiving http packet";
+            return false;
+        }
+        read_length += len;
+    }
+
+    rapidjson::Document document;
+    document.Parse(body.c_str());
+    if (document.HasParseError() || !document.IsObject()
+            || !document.HasMember("keys") || !document["keys"].IsArray()) {
+        *error_msg = "request body should be like {\"keys\": [[\"k1\", \"k2\"], ...]}";
+        return false;
+    }
+
+    const rapidjson::Value& keys_value = document["keys"];
+    if (keys_value.Size() > static_cast<rapidjson::SizeType>(
+                config::lookup_max_keys_per_request)) {
+        *error_msg = "too many keys in one request";
+        return false;
+    }
+
+    keys->resize(keys_value.Size());
+    for (rapidjson::SizeType i = 0; i < keys_value.Size(); ++i) {
+        if (!keys_value[i].IsArray()) {
+            *error_msg = "each key should be an array of column values";
+            return false;
+        }
+
+        for (rapidjson::SizeType j = 0; j < keys_value[i].Size(); ++j) {
+            if (!keys_value[i][j].IsString()) {
+                *error_msg = "column values of key should be strings";
+                return false;
+            }
+            (*keys)[i].push_back(keys_value[i][j].GetString());
+        }
+    }
+
+    return true;
+}
+
+} // end namespace palo
@@ -0,0 +1,54 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_HTTP_ACTION_LOOKUP_ACTION_H
+#define BDG_PALO_BE_SRC_HTTP_ACTION_LOOKUP_ACTION_H
+
+#include <string>
+#include <vector>
+
+#include "http/http_handler.h"
+#include "olap/command_executor.h"
+
+namespace palo {
+
+class ExecEnv;
+
+// Look up rows of a UNIQUE/AGG tablet by full keys, without planning a scan fragment.
+// POST /api/lookup?tablet_id=xx&schema_hash=xx&version=xx&version_hash=xx
+// with body {"keys": [["k1", "k2"], ...]}, returns {"status": "OK", "rows": [[...], null, ...]}
+// where null means the key is not found.
+class LookupAction : public HttpHandler {
+public:
+    explicit LookupAction(ExecEnv* exec_env);
+
+    virtual ~LookupAction();
+
+    virtual void handle(HttpRequest *req, HttpChannel *channel);
+
+private:
+    // read body of request and parse the keys in it, return false if failed
+    bool _parse_keys(HttpRequest* req,
+                     HttpChannel* channel,
+                     std::vector<std::vector<std::string> >* keys,
+                     std::string* error_msg);
+
+    ExecEnv* _exec_env;
+    CommandExecutor* _command_executor;
+}; // end class LookupAction
+
+} // end namespace palo
+
+#endif // BDG_PALO_BE_SRC_HTTP_ACTION_LOOKUP_ACTION_H
@@ -0,0 +1,44 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "http/action/metrics_action.h"
+
+#include <sstream>
+#include <string>
+
+#include "http/http_channel.h"
+#include "http/http_request.h"
+#include "http/http_response.h"
+#include "http/http_status.h"
+#include "util/metrics.h"
+
+namespace palo {
+
+const static std::string HEADER_PROMETHEUS = "text/plain; version=0.0.4";
+
+MetricsAction::MetricsAction(MetricGroup* metrics) :
+        _metrics(metrics) {
+}
+
+void MetricsAction::handle(HttpRequest *req, HttpChannel *channel) {
+    std::stringstream ss;
+    _metrics->print_prometheus(&ss);
+    std::string result = ss.str();
+
+    HttpResponse response(HttpStatus::OK, HEADER_PROMETHEUS, &result);
+    channel->send_response(response);
+}
+
+} // end namespace palo
@@ -45,6 +45,7 @@
 #include "runtime/exec_env.h"
 #include "runtime/fragment_mgr.h"
 #include "runtime/load_path_mgr.h"
+#include "runtime/stream_load_pipe.h"
 #include "gen_cpp/MasterService_types.h"
 #include "gen_cpp/HeartbeatService_types.h"
 #include "gen_cpp/FrontendService.h"
@@ -110,11 +111,27 @@ static Status check_request(HttpRequest* req) {
     return Status::OK;
 }
 
+// Consumes 'size' bytes of the received body at 'data'.
+typedef std::function<Status(const uint8_t* data, int64_t size)> BodyConsumer;
+
+static Status write_to_file(FileHandler* file_handler, const uint8_t* data, int64_t size) {
+    OLAPStatus wr_status = file_handler->write(data, size);
+    if (wr_status != OLAP_SUCCESS) {
+        char errmsg[64];
+        LOG(WARNING) << "Write to file("
+                << FileUtils::path_of_fd(file_handler->fd()) << ") failed. "
+                << "need=" << size
+                << ",syserr=" << strerror_r(errno, errmsg, 64);
+        return Status("Failed when saving uploaded data");
+    }
+    return Status::OK;
+}
+
 // Receive 'Transfer-Encoding: chunked' data from client
 // Params:
-//  file_handler file descriptor and operation for output file
+//  consumer     consumes the received data
 //  channel      used to receive client data
-static Status save_chunked_data(FileHandler* file_handler, HttpChannel *channel) {
+static Status receive_chunked_data(const BodyConsumer& consumer, HttpChannel *channel) {
     const int64_t BUF_SIZE = 4096;
     char *buf = new char[BUF_SIZE];
     DeferOp free_buf(std::bind<void>(std::default_delete<char[]>(), buf));
@@ -151,15 +168,7 @@ static Status save_chunked_data(FileHandler* file_handler, HttpChannel *channel)
         case HttpParser::PARSE_OK: {
             // data received
             int64_t size = std::min(ctx.size, end - pos);
-            OLAPStatus wr_status = file_handler->write(pos, size);
-            if (wr_status != OLAP_SUCCESS) {
-                char errmsg[64];
-                LOG(WARNING) << "Write to file("
-                        << FileUtils::path_of_fd(file_handler->fd()) << ") failed. "
-                        << "need=" << size
-                        << ",syserr=" << strerror_r(errno, errmsg, 64);
-                return Status("Failed when saving uploaded data");
-            }
+            RETURN_IF_ERROR(consumer(pos, size));
             ctx.size -= size;
             ctx.length -= size;
             pos += size;
@@ -179,15 +188,14 @@ static Status save_chunked_data(FileHandler* file_handler, HttpChannel *channel)
     }
 
     if (state == HttpParser::PARSE_DONE) {
-        LOG(INFO) << "Save file to path "
-            << FileUtils::path_of_fd(file_handler->fd()) << " success.";
         return Status::OK;
     } else {
         return Status("Error happend when palo parse your http packet.");
     }
 }
 
-static Status save_to_file(FileHandler* file_handler, int64_t len, HttpChannel* channel) {
+static Status receive_sized_data(const BodyConsumer& consumer, int64_t len,
+                                 HttpChannel* channel) {
     const int64_t BUF_SIZE = 4096;
     char *buf = new char[BUF_SIZE];
     DeferOp free_buf(std::bind<void>(std::default_delete<char[]>(), buf));
@@ -203,22 +211,45 @@ static Status save_to_file(FileHandler* file_handler, int64_t len, HttpChannel*
                 << ",syserr=" << strerror_r(errno, errmsg, 64);
             return Status("Failed when receiving http packet.");
         }
-        OLAPStatus wr_status = file_handler->write(buf, read_this_time);
-        if (wr_status != OLAP_SUCCESS) {
-            char errmsg[64];
-            LOG(WARNING) << "Write to file("
-                    << FileUtils::path_of_fd(file_handler->fd()) << ") failed. "
-                    << "need=" << read_this_time
-                    << ",syserr=" << strerror_r(errno, errmsg, 64);
-            return Status("Failed when saving uploaded data");
-        }
-        // write will write all buf into file, so that write_len == read_this_time
+        RETURN_IF_ERROR(consumer((const uint8_t*)buf, read_this_time));
+        // consumer takes all buf, so that consumed len == read_this_time
         to_read -= read_this_time;
     }
-    LOG(INFO) << "Save file to path " << FileUtils::path_of_fd(file_handler->fd()) << " success.";
     return Status::OK;
 }
 
+// Receives the body of 'req' and passes it to 'consumer'.
+static Status receive_body(HttpRequest* req, HttpChannel* channel,
+                           const BodyConsumer& consumer) {
+    // After all thing prepare thing, then send '100-continue' to client
+    if (strcasecmp(req->header(HttpHeaders::EXPECT).c_str(), k_100_continue) == 0) {
+        // send 100 continue;
+        send_100_continue(channel);
+    }
+
+    // Check if chunk first according rfc2616
+    if (!req->header(HttpHeaders::TRANSFER_ENCODING).empty()) {
+        if (req->header(HttpHeaders::TRANSFER_ENCODING) != "chunked") {
+            std::stringstream ss;
+            ss << "Unknown " << HttpHeaders::TRANSFER_ENCODING << ": "
+                << req->header(HttpHeaders::TRANSFER_ENCODING);
+            return Status(ss.str());
+        }
+        return receive_chunked_data(consumer, channel);
+    } else if (!req->header(HttpHeaders::CONTENT_LENGTH).empty()) {
+        int64_t len = std::stol(req->header(HttpHeaders::CONTENT_LENGTH));
+        if (len > config::mini_load_max_mb * 1024 * 1024) {
+            return Status("File size exceed max size we can support.");
+        }
+        return receive_sized_data(consumer, len, channel);
+    } else {
+        std::stringstream ss;
+        ss << "There is no " << HttpHeaders::TRANSFER_ENCODING << " nor "
+            << HttpHeaders::CONTENT_LENGTH << " in request headers, you need pass me one";
+        return Status(ss.str());
+    }
+}
+
 Status MiniLoadAction::data_saved_dir(const LoadHandle& desc,
                                       const std::string& table,
                                       std::string* file_path) {
@@ -261,34 +292,35 @@ Status MiniLoadAction::receive_data(const LoadHandle& desc, HttpRequest* req,
         return Status("Internal Error");
     }
 
-    // After all thing prepare thing, then send '100-continue' to client
-    if (strcasecmp(req->header(HttpHeaders::EXPECT).c_str(), k_100_continue) == 0) {
-        // send 100 continue;
-        send_100_continue(channel);
-    }
+    RETURN_IF_ERROR(receive_body(req, channel, std::bind(
+            write_to_file, &file_handler, std::placeholders::_1, std::placeholders::_2)));
+    LOG(INFO) << "Save file to path " << *file_path << " success.";
+    return Status::OK;
+}
 
-    // Check if chunk first according rfc2616
-    if (!req->header(HttpHeaders::TRANSFER_ENCODING).empty()) {
-        if (req->header(HttpHeaders::TRANSFER_ENCODING) != "chunked") {
-            std::stringstream ss;
-            ss << "Unknown " << HttpHeaders::TRANSFER_ENCODING << ": "
-                << req->header(HttpHeaders::TRANSFER_ENCODING);
-            return Status(ss.str());
-        }
-        return save_chunked_data(&file_handler, channel);
-    } else if (!req->header(HttpHeaders::CONTENT_LENGTH).empty()) {
-        int64_t len = std::stol(req->header(HttpHeaders::CONTENT_LENGTH));
-        if (len > config::mini_load_max_mb * 1024 * 1024) {
-            return Status("File size exceed max size we can support.");
-        }
-        return save_to_file(&file_handler, len, channel);
-    } else {
-        std::stringstream ss;
-        ss << "There is no " << HttpHeaders::TRANSFER_ENCODING << " nor "
-            << HttpHeaders::CONTENT_LENGTH << " in request headers, you need pass me one";
-        return Status(ss.str());
-    }
+Status MiniLoadAction::stream_data(HttpRequest* req, HttpChannel* channel) {
+    // add tid to cgroup
+    CgroupsMgr::apply_system_cgroup();
+    std::shared_ptr<StreamLoadPipe> pipe(
+            new StreamLoadPipe(config::streaming_mini_load_buffer_mb * 1024 * 1024));
+    StreamLoadPipeMgr* pipe_mgr = _exec_env->stream_load_pipe_mgr();
+    std::string pipe_path = pipe_mgr->register_pipe(req->param(TABLE_KEY), pipe);
 
+    // The etl job is requested first, so that it parses the data as it arrives
+    Status status = load(req, pipe_path);
+    if (!status.ok()) {
+        pipe_mgr->unregister_pipe(pipe_path);
+        return status;
+    }
+    status = receive_body(req, channel, [&pipe] (const uint8_t* data, int64_t size) {
+        return pipe->append((const char*)data, size);
+    });
+    if (!status.ok()) {
+        pipe->cancel(status.get_error_msg());
+        return status;
+    }
+    pipe->finish();
+    LOG(INFO) << "Stream data to " << pipe_path << " success.";
     return Status::OK;
 }
 
@@ -510,6 +542,12 @@ void MiniLoadAction::handle(HttpRequest *req, HttpChannel *channel) {
         return;
     }
 
+    if (config::enable_streaming_mini_load && desc.sub_label.empty()) {
+        status = stream_data(req, channel);
+        send_response(status, channel);
+        return;
+    }
+
     // Receive data first, keep things easy.
     std::string file_path;
     status = receive_data(desc, req, channel, &file_path);
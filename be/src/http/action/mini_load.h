@@ -64,6 +64,10 @@ private:
     Status receive_data(const LoadHandle& desc, HttpRequest* req, 
                     HttpChannel *channel, std::string* file_path);
 
+    // Streams the body of the load to its etl job through memory and requests the
+    // job before the body arrives.
+    Status stream_data(HttpRequest* req, HttpChannel* channel);
+
     Status check_auth(HttpRequest* http_req);
 
     void erase_handle(const LoadHandle& handle);
@@ -18,6 +18,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <map>
 #include <mutex>
 
 #include <gperftools/profiler.h>
@@ -33,6 +34,8 @@
 #include "http/webserver.h"
 #include "runtime/exec_env.h"
 #include "util/bfd_parser.h"
+#include "util/cpu_profiler.h"
+#include "util/debug_util.h"
 
 namespace palo {
 
@@ -153,6 +156,80 @@ void ProfileAction::handle(HttpRequest *req, HttpChannel *channel) {
 #endif
 }
 
+// Samples the CPU and returns the stacks symbolized in process, as a flame graph SVG
+// or in the collapsed format with format=collapsed. Parameters:
+//   seconds: how long to sample, 10 by default
+//   hz: samples per second of CPU time, 99 by default
+//   query_id: only sample the threads working for the query
+//   thread: only sample the threads whose name starts with it, e.g. scanner, fragment
+class FlameGraphAction : public HttpHandler {
+public:
+    FlameGraphAction(BfdParser* parser) : _parser(parser) { }
+    virtual ~FlameGraphAction() { }
+
+    virtual void handle(HttpRequest *req, HttpChannel *channel) override;
+
+private:
+    BfdParser* _parser;
+};
+
+void FlameGraphAction::handle(HttpRequest *req, HttpChannel *channel) {
+#ifdef ADDRESS_SANITIZER
+    std::string str = "CPU profiling is not available with address sanitizer builds.";
+    HttpResponse response(HttpStatus::OK, &str);
+    channel->send_response(response);
+#else
+    CpuProfiler::Options options;
+    const std::string& seconds_str = req->param(SECOND_KEY);
+    if (!seconds_str.empty()) {
+        options.seconds = std::atoi(seconds_str.c_str());
+    }
+    const std::string& hz_str = req->param("hz");
+    if (!hz_str.empty()) {
+        options.frequency = std::atoi(hz_str.c_str());
+    }
+    std::string query_id_str = req->param("query_id");
+    if (!query_id_str.empty()) {
+        if (!parse_id(query_id_str, &options.query_id)) {
+            std::string str = "Invalid query_id " + query_id_str;
+            HttpResponse response(HttpStatus::BAD_REQUEST, &str);
+            channel->send_response(response);
+            return;
+        }
+        options.filter_query = true;
+    }
+    options.thread_name = req->param("thread");
+
+    // the gperftools profiler uses SIGPROF as well
+    std::lock_guard<std::mutex> lock(kPprofActionMutex);
+    std::map<std::string, int64_t> stacks;
+    Status status = CpuProfiler::profile(options, _parser, &stacks);
+    if (!status.ok()) {
+        std::string str = status.get_error_msg();
+        HttpResponse response(HttpStatus::SERVICE_UNAVAILABLE, &str);
+        channel->send_response(response);
+        return;
+    }
+    if (req->param("format") == "collapsed") {
+        std::string str = CpuProfiler::to_collapsed(stacks);
+        HttpResponse response(HttpStatus::OK, &str);
+        channel->send_response(response);
+        return;
+    }
+    std::stringstream title;
+    title << "CPU " << options.seconds << "s";
+    if (options.filter_query) {
+        title << " query_id=" << query_id_str;
+    }
+    if (!options.thread_name.empty()) {
+        title << " thread=" << options.thread_name << "*";
+    }
+    std::string str = CpuProfiler::to_flame_graph_svg(stacks, title.str());
+    HttpResponse response(HttpStatus::OK, "image/svg+xml", &str);
+    channel->send_response(response);
+#endif
+}
+
 class PmuProfileAction : public HttpHandler {
 public:
     PmuProfileAction() { }
@@ -304,6 +381,8 @@ Status PprofActions::setup(ExecEnv* exec_env, Webserver* http_server) {
                                   new GrowthAction());
     http_server->register_handler(HttpMethod::GET, "/pprof/profile",
                                   new ProfileAction());
+    http_server->register_handler(HttpMethod::GET, "/pprof/flamegraph",
+                                  new FlameGraphAction(exec_env->bfd_parser()));
     http_server->register_handler(HttpMethod::GET, "/pprof/pmuprofile",
                                   new PmuProfileAction());
     http_server->register_handler(HttpMethod::GET, "/pprof/contention",
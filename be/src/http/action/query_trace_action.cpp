@@ -0,0 +1,57 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "http/action/query_trace_action.h"
+
+#include <string>
+
+#include "http/http_channel.h"
+#include "http/http_request.h"
+#include "http/http_response.h"
+#include "http/http_status.h"
+#include "service/backend_options.h"
+#include "util/debug_util.h"
+#include "util/query_trace.h"
+
+namespace palo {
+
+const static std::string HEADER_JSON = "application/json";
+const static std::string QUERY_ID = "query_id";
+
+void QueryTraceAction::handle(HttpRequest *req, HttpChannel *channel) {
+    std::string query_id_str = req->param(QUERY_ID);
+    TUniqueId query_id;
+    if (query_id_str.empty() || !parse_id(query_id_str, &query_id)) {
+        std::string error_msg = "parameter " + QUERY_ID + " not specified or invalid in url.";
+        HttpResponse response(HttpStatus::BAD_REQUEST, &error_msg);
+        channel->send_response(response);
+        return;
+    }
+
+    std::shared_ptr<QueryTrace> trace = QueryTraceMgr::instance()->find(query_id);
+    if (trace == nullptr) {
+        std::string error_msg = "no trace of query " + query_id_str
+            + ", the query doesn't set enable_query_trace or its trace was evicted.";
+        HttpResponse response(HttpStatus::NOT_FOUND, &error_msg);
+        channel->send_response(response);
+        return;
+    }
+
+    std::string result = trace->to_json("be " + BackendOptions::get_localhost());
+    HttpResponse response(HttpStatus::OK, HEADER_JSON, &result);
+    channel->send_response(response);
+}
+
+} // end namespace palo
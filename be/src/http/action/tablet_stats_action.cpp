@@ -0,0 +1,66 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "http/action/tablet_stats_action.h"
+
+#include <cstdlib>
+#include <string>
+
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include "http/http_channel.h"
+#include "http/http_request.h"
+#include "http/http_response.h"
+#include "http/http_status.h"
+#include "olap/olap_engine.h"
+
+namespace palo {
+
+const static std::string HEADER_JSON = "application/json";
+const static std::string LIMIT = "limit";
+const static int DEFAULT_LIMIT = 100;
+
+TabletStatsAction::TabletStatsAction(ExecEnv* exec_env) :
+        _exec_env(exec_env) {
+}
+
+void TabletStatsAction::handle(HttpRequest *req, HttpChannel *channel) {
+    int limit = DEFAULT_LIMIT;
+    const std::string& limit_str = req->param(LIMIT);
+    if (!limit_str.empty()) {
+        limit = std::atoi(limit_str.c_str());
+        if (limit <= 0) {
+            std::string error_msg = "parameter " + LIMIT + " is invalid in url.";
+            HttpResponse response(HttpStatus::BAD_REQUEST, &error_msg);
+            channel->send_response(response);
+            return;
+        }
+    }
+
+    rapidjson::Document document;
+    OLAPEngine::get_instance()->get_tablet_access_stats(limit, &document);
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    document.Accept(writer);
+    std::string result = buffer.GetString();
+
+    HttpResponse response(HttpStatus::OK, HEADER_JSON, &result);
+    channel->send_response(response);
+}
+
+} // end namespace palo
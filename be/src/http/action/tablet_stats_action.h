@@ -0,0 +1,42 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_HTTP_ACTION_TABLET_STATS_ACTION_H
+#define BDG_PALO_BE_SRC_HTTP_ACTION_TABLET_STATS_ACTION_H
+
+#include "http/http_handler.h"
+
+namespace palo {
+
+class ExecEnv;
+
+// Get the access stats of the most read tablets and the recent read load of each
+// root path from http API. The optional parameter "limit" is the number of tablets,
+// 100 by default.
+class TabletStatsAction : public HttpHandler {
+public:
+    TabletStatsAction(ExecEnv* exec_env);
+
+    virtual ~TabletStatsAction() {};
+
+    virtual void handle(HttpRequest *req, HttpChannel *channel);
+
+private:
+    ExecEnv* _exec_env;
+};
+
+} // end namespace palo
+
+#endif // BDG_PALO_BE_SRC_HTTP_ACTION_TABLET_STATS_ACTION_H
@@ -15,6 +15,11 @@
 
 #include "http/download_action.h"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
 #include <string>
 #include <sstream>
 
@@ -157,76 +162,118 @@ void DownloadAction::do_dir_response(
 
 void DownloadAction::do_file_response(
         const std::string& file_path, HttpRequest *req, HttpChannel *channel) {
-    // read file content and send response
-    FILE* fp = fopen(file_path.c_str(), "rb");
-    if (fp == nullptr) {
+    int fd = ::open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) {
         LOG(WARNING) << "Failed to open file: " << file_path;
         HttpResponse response(HttpStatus::NOT_FOUND);
         channel->send_response(response);
         return;
     }
-    DeferOp close_file(std::bind(&fclose, fp));
-    int64_t file_size = get_file_size(fp);
+    DeferOp close_file(std::bind(&::close, fd));
+
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0) {
+        LOG(WARNING) << "Failed to stat file: " << file_path;
+        HttpResponse response(HttpStatus::INTERNAL_SERVER_ERROR);
+        channel->send_response(response);
+        return;
+    }
+    int64_t file_size = file_stat.st_size;
 
     // TODO(lingbin): process "IF_MODIFIED_SINCE" header
-    // TODO(lingbin): process "RANGE" header
-    const std::string& range_header = req->header(HttpHeaders::RANGE);
-    if (!range_header.empty()) {
-        // analyse range header
+    bool has_range = false;
+    int64_t offset = 0;
+    int64_t length = file_size;
+    Status status = parse_range(
+            req->header(HttpHeaders::RANGE), file_size, &has_range, &offset, &length);
+    if (!status.ok()) {
+        HttpResponse response(HttpStatus::REQUESTED_RANGE_NOT_SATISFIED);
+        response.add_header(
+                std::string(HttpHeaders::CONTENT_RANGE),
+                "bytes */" + boost::lexical_cast<std::string>(file_size));
+        channel->send_response(response);
+        return;
     }
 
-    HttpResponse response(HttpStatus::OK);
+    HttpResponse response(has_range ? HttpStatus::PARTIAL_CONTENT : HttpStatus::OK);
+    response.add_header(std::string(HttpHeaders::ACCEPT_RANGES), "bytes");
     response.add_header(
             std::string(HttpHeaders::CONTENT_LENGTH),
-            boost::lexical_cast<std::string>(file_size));
+            boost::lexical_cast<std::string>(length));
+    if (has_range) {
+        std::stringstream content_range;
+        content_range << "bytes " << offset << "-" << offset + length - 1 << "/" << file_size;
+        response.add_header(std::string(HttpHeaders::CONTENT_RANGE), content_range.str());
+    }
     response.add_header(
             std::string(HttpHeaders::CONTENT_TYPE),
             get_content_type(file_path));
 
+    channel->send_response_header(response);
     if (req->method() == HttpMethod::HEAD) {
-        channel->send_response_header(response);
         return;
     }
 
-    channel->send_response_header(response);
-    const int BUFFER_SIZE = 4096;
-    char *buffer = new char[BUFFER_SIZE];
-    int32_t readed_size = 0;
-    bool eos = false;
-    do {
-        Status status = get_file_content(fp, buffer, BUFFER_SIZE, &readed_size, &eos);
-        if (!status.ok()) {
-            LOG(ERROR) << "Something is wrong when read file: " << file_path;
-            break;
-        }
-        channel->append_response_content(response, buffer, readed_size);
-    } while (!eos);
-
-    delete[] buffer;
+    int64_t sent_size = channel->send_file(fd, offset, length);
+    if (sent_size != length) {
+        LOG(WARNING) << "Something is wrong when send file: " << file_path
+                << ", offset=" << offset << ", length=" << length << ", sent=" << sent_size;
+    }
 }
 
-Status DownloadAction::get_file_content(
-        FILE* fp, char* buffer, int32_t buffer_size,
-        int32_t* readed_size, bool* eos) {
-    *readed_size = fread(buffer, sizeof(char), buffer_size, fp);
-    if (*readed_size != buffer_size) {
-        if (::ferror(fp)) {
-            return Status("something wrong when read file");
-        } else if (::feof(fp)) {
-            *eos = true;
-            return Status::OK;
+Status DownloadAction::parse_range(
+        const std::string& range_header, int64_t file_size,
+        bool* has_range, int64_t* offset, int64_t* length) {
+    *has_range = false;
+    *offset = 0;
+    *length = file_size;
+
+    const std::string BYTES_UNIT = "bytes=";
+    if (range_header.compare(0, BYTES_UNIT.size(), BYTES_UNIT) != 0
+            || range_header.find(',') != std::string::npos) {
+        return Status::OK;
+    }
+
+    std::string spec = range_header.substr(BYTES_UNIT.size());
+    size_t dash = spec.find('-');
+    if (dash == std::string::npos) {
+        return Status::OK;
+    }
+    std::string first = spec.substr(0, dash);
+    std::string last = spec.substr(dash + 1);
+
+    int64_t start = 0;
+    int64_t end = file_size - 1;
+    try {
+        if (first.empty()) {
+            // suffix range, "bytes=-N" is the last N bytes
+            if (last.empty()) {
+                return Status::OK;
+            }
+            int64_t suffix_length = boost::lexical_cast<int64_t>(last);
+            if (suffix_length <= 0 || file_size == 0) {
+                return Status("range not satisfiable");
+            }
+            start = std::max<int64_t>(file_size - suffix_length, 0);
+        } else {
+            start = boost::lexical_cast<int64_t>(first);
+            if (!last.empty()) {
+                end = std::min(boost::lexical_cast<int64_t>(last), file_size - 1);
+            }
         }
+    } catch (boost::bad_lexical_cast& e) {
+        // invalid range is ignored, as RFC 7233 says
+        return Status::OK;
     }
-    *eos = false;
-    return Status::OK;
-}
 
-int64_t DownloadAction::get_file_size(FILE* fp) {
-    int64_t current_pos = ::ftell(fp);
-    ::fseek(fp, 0, SEEK_END);
-    int64_t file_size = ftell(fp);
-    ::fseek(fp, current_pos, SEEK_SET);
-    return file_size;
+    if (start < 0 || start >= file_size || start > end) {
+        return Status("range not satisfiable");
+    }
+
+    *has_range = true;
+    *offset = start;
+    *length = end - start + 1;
+    return Status::OK;
 }
 
 // If 'file_name' contains a dot but does not consist solely of one or to two dots,
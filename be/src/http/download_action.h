@@ -26,8 +26,9 @@ class ExecEnv;
 
 // A simple handler that serves incoming HTTP requests of file-download to send their respective HTTP responses.
 //
-// TODO(lingbin): implements two useful header ('If-Modified-Since' and 'RANGE') to reduce
-// transmission consumption.
+// A single 'Range' of bytes is supported, so that an interrupted download could be
+// resumed and a large file could be fetched by several requests in parallel.
+// TODO(lingbin): implements 'If-Modified-Since' header to reduce transmission consumption.
 // We use parameter named 'file' to specify the static resource path, it is an absolute path.
 class DownloadAction : public HttpHandler {
 public:
@@ -59,11 +60,12 @@ private:
     void do_file_response(const std::string& dir_path, HttpRequest *req, HttpChannel *channel);
     void do_dir_response(const std::string& dir_path, HttpRequest *req, HttpChannel *channel);
 
-    Status get_file_content(
-            FILE* fp, char* buffer, int32_t buffer_size,
-            int32_t* readed_size, bool* eos);
-
-    int64_t get_file_size(FILE* fp);
+    // Parse 'Range' header against file_size. has_range is false if the header is
+    // absent, malformed or has multiple ranges, then the whole file is sent.
+    // Return error if the range is not satisfiable.
+    Status parse_range(
+            const std::string& range_header, int64_t file_size,
+            bool* has_range, int64_t* offset, int64_t* length);
 
     std::string get_file_extension(const std::string& file_name);
 
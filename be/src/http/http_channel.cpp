@@ -115,6 +115,10 @@ void HttpChannel::append_response_content(
     mg_write(_mg_conn, content, content_size);
 }
 
+int64_t HttpChannel::send_file(int fd, int64_t offset, int64_t size) {
+    return mg_write_file(_mg_conn, fd, offset, size);
+}
+
 int HttpChannel::read(char* buf, int len) {
     return mg_read(_mg_conn, buf, len);
 }
@@ -41,6 +41,11 @@ public:
             int32_t content_size);
     void send_status_line();
 
+    // Send size bytes of file fd from offset as response content, the file
+    // is sent by sendfile(2) if possible.
+    // Return number of bytes sent.
+    int64_t send_file(int fd, int64_t offset, int64_t size);
+
     const HttpRequest& request() const {
         return _request;
     }
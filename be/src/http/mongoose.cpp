@@ -176,6 +176,9 @@ typedef struct DIR {
 #else    // UNIX  specific
 #include <sys/wait.h>
 #include <sys/socket.h>
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
 #include <sys/select.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -1605,6 +1608,49 @@ int mg_write(struct mg_connection *conn, const void *buf, size_t len) {
   return (int) total;
 }
 
+int64_t mg_write_file(struct mg_connection *conn, int fd, int64_t offset,
+                      int64_t len) {
+  char buf[MG_BUF_LEN];
+  int64_t total = 0;
+  int to_read, num_read;
+
+#if defined(__linux__)
+  if (conn->ssl == NULL && conn->throttle <= 0) {
+    off_t off = (off_t) offset;
+    while (total < len && conn->ctx->stop_flag == 0) {
+      size_t k = len - total > INT_MAX ? INT_MAX : (size_t) (len - total);
+      ssize_t n = sendfile(conn->client.sock, fd, &off, k);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        break;
+      }
+      total += n;
+    }
+    conn->num_bytes_sent += total;
+    return total;
+  }
+#endif
+
+  while (total < len) {
+    to_read = sizeof(buf);
+    if ((int64_t) to_read > len - total) {
+      to_read = (int) (len - total);
+    }
+    if ((num_read = (int) pread(fd, buf, (size_t) to_read,
+                                (off_t) (offset + total))) <= 0) {
+      break;
+    }
+    if (mg_write(conn, buf, (size_t) num_read) != num_read) {
+      break;
+    }
+    total += num_read;
+  }
+  conn->num_bytes_sent += total;
+  return total;
+}
+
 int mg_printf(struct mg_connection *conn, const char *fmt, ...) {
   char mem[MG_BUF_LEN], *buf = mem;
   int len;
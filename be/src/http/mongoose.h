@@ -18,6 +18,7 @@
 
 #include <stdio.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -198,6 +199,13 @@ int mg_printf(struct mg_connection *,
 void mg_send_file(struct mg_connection *conn, const char *path);
 
 
+// Send len bytes of the opened file starting at offset, without headers.
+// sendfile(2) is used when the connection is neither SSL nor throttled,
+// file position of fd is not changed.
+// Return number of bytes written.
+int64_t mg_write_file(struct mg_connection *, int fd, int64_t offset, int64_t len);
+
+
 // Read data from the remote end, return number of bytes read.
 int mg_read(struct mg_connection *, void *buf, size_t len);
 
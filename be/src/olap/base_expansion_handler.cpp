@@ -90,6 +90,8 @@ OLAPStatus BaseExpansionHandler::run() {
 
     OLAPStatus res = OLAP_SUCCESS;
     OlapStopWatch stage_watch;
+    ScopedLatencyRecorder latency_recorder(PaloMetrics::compaction_latency() != NULL
+            ? PaloMetrics::compaction_latency()->get("base") : NULL);
 
     _table->set_base_expansion_status(BASE_EXPANSION_RUNNING, _new_base_version.second);
 
@@ -150,6 +152,11 @@ OLAPStatus BaseExpansionHandler::run() {
     OLAP_LOG_TRACE("elapsed time of doing base version", "%ldus",
                    stage_watch.get_elapse_time_us());
 
+    // 热点tablet在新base生效之前预热cache, 避免之后的查询读盘
+    for (OLAPIndex* new_index : _new_olap_indices) {
+        _table->warm_up_cache(new_index);
+    }
+
     // 4. 使新生成的base生效，并删除不再需要版本对应的文件
     _obtain_header_wrlock();
     vector<OLAPIndex*> unused_olap_indices;
@@ -163,6 +170,7 @@ OLAPStatus BaseExpansionHandler::run() {
         return res;
     }
     _release_header_lock();
+    _table->evict_cache(unused_olap_indices);
     _delete_old_files(&unused_olap_indices);
 
     //  validate that delete action is right
@@ -0,0 +1,261 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/cache_manager.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <boost/bind.hpp>
+
+#include "common/config.h"
+#include "common/logging.h"
+#include "runtime/mem_tracker.h"
+#include "util/pretty_printer.h"
+
+namespace palo {
+
+// The slice of the budget that moves from one cache to another per rebalance
+static const int REBALANCE_STEP_PERCENT = 5;
+// No memory cache shrinks below this share of the budget
+static const int MIN_CAPACITY_PERCENT = 5;
+// A cache using this much of its capacity would use more
+static const double FULL_USAGE_RATIO = 0.9;
+// Bound of the caches the metrics tell apart
+static const int MAX_CACHES = 32;
+
+CacheManager::CacheManager() :
+        _process_mem_tracker(NULL),
+        _lookups_metric(NULL),
+        _hits_metric(NULL),
+        _evictions_metric(NULL),
+        _usage_metric(NULL),
+        _capacity_metric(NULL) {
+}
+
+void CacheManager::register_cache(const std::string& name, Cache* cache, bool is_memory) {
+    boost::lock_guard<boost::mutex> l(_lock);
+    CacheInfo info;
+    info.name = name;
+    info.cache = cache;
+    info.is_memory = is_memory;
+    cache->get_stats(&info.stats);
+    info.last_hit_count = info.stats.hit_count;
+    _caches.push_back(info);
+}
+
+void CacheManager::unregister_cache(Cache* cache) {
+    boost::lock_guard<boost::mutex> l(_lock);
+    for (auto it = _caches.begin(); it != _caches.end(); ++it) {
+        if (it->cache == cache) {
+            _caches.erase(it);
+            return;
+        }
+    }
+}
+
+void CacheManager::start(MetricGroup* metrics, MemTracker* process_mem_tracker) {
+    {
+        boost::lock_guard<boost::mutex> l(_lock);
+        if (metrics != NULL) {
+            _lookups_metric = metrics->register_metric(new MetricFamily<IntCounter>(
+                        MetricDefs::Get("palo_be.cache.lookups"), "cache", MAX_CACHES));
+            _hits_metric = metrics->register_metric(new MetricFamily<IntCounter>(
+                        MetricDefs::Get("palo_be.cache.hits"), "cache", MAX_CACHES));
+            _evictions_metric = metrics->register_metric(new MetricFamily<IntCounter>(
+                        MetricDefs::Get("palo_be.cache.evictions"), "cache", MAX_CACHES));
+            _usage_metric = metrics->register_metric(new MetricFamily<IntGauge>(
+                        MetricDefs::Get("palo_be.cache.usage"), "cache", MAX_CACHES));
+            _capacity_metric = metrics->register_metric(new MetricFamily<IntGauge>(
+                        MetricDefs::Get("palo_be.cache.capacity"), "cache", MAX_CACHES));
+        }
+        _process_mem_tracker = process_mem_tracker;
+    }
+    if (process_mem_tracker != NULL) {
+        process_mem_tracker->AddGcFunction([this] (int64_t bytes_to_free) {
+            free_memory(bytes_to_free);
+        });
+    }
+    if (config::cache_manager_interval_sec > 0) {
+        _update_thread.reset(new boost::thread(
+                boost::bind(&CacheManager::update_thread, this)));
+    }
+}
+
+void CacheManager::update_thread() {
+    while (true) {
+        sleep(std::max(config::cache_manager_interval_sec, 1));
+        update();
+    }
+}
+
+void CacheManager::update() {
+    boost::lock_guard<boost::mutex> l(_lock);
+    int64_t memory_usage = 0;
+    for (CacheInfo& info : _caches) {
+        info.stats = CacheStats();
+        info.cache->get_stats(&info.stats);
+        double hits_per_byte = (info.stats.hit_count - info.last_hit_count) * 1.0
+                / std::max<size_t>(info.stats.usage, 1);
+        info.hits_per_byte = (info.hits_per_byte + hits_per_byte) / 2;
+        info.last_hit_count = info.stats.hit_count;
+        if (info.is_memory) {
+            memory_usage += info.stats.usage;
+        }
+    }
+
+    if (_process_mem_tracker != NULL && _process_mem_tracker->has_limit()) {
+        int64_t over = _process_mem_tracker->consumption() + memory_usage
+                - _process_mem_tracker->limit();
+        if (over > 0) {
+            int64_t freed = free_memory_locked(over);
+            LOG(INFO) << "Evicted " << PrettyPrinter::print(freed, TUnit::BYTES)
+                      << " from caches, the process was over its memory limit by "
+                      << PrettyPrinter::print(over, TUnit::BYTES);
+        }
+    }
+
+    if (config::cache_memory_budget_bytes > 0) {
+        rebalance_locked(config::cache_memory_budget_bytes);
+    }
+
+    for (CacheInfo& info : _caches) {
+        update_metrics_locked(&info);
+    }
+}
+
+void CacheManager::update_metrics_locked(CacheInfo* info) {
+    if (_lookups_metric == NULL) {
+        return;
+    }
+    if (info->lookups == NULL) {
+        info->lookups = _lookups_metric->get(info->name);
+        info->hits = _hits_metric->get(info->name);
+        info->evictions = _evictions_metric->get(info->name);
+        info->usage = _usage_metric->get(info->name);
+        info->capacity = _capacity_metric->get(info->name);
+    }
+    info->lookups->set_value(info->stats.lookup_count);
+    info->hits->set_value(info->stats.hit_count);
+    info->evictions->set_value(info->stats.evict_count);
+    info->usage->set_value(info->stats.usage);
+    info->capacity->set_value(info->stats.capacity);
+}
+
+int64_t CacheManager::free_memory(int64_t bytes) {
+    boost::lock_guard<boost::mutex> l(_lock);
+    return free_memory_locked(bytes);
+}
+
+int64_t CacheManager::free_memory_locked(int64_t bytes) {
+    std::vector<CacheInfo*> caches;
+    for (CacheInfo& info : _caches) {
+        if (info.is_memory) {
+            caches.push_back(&info);
+        }
+    }
+    std::sort(caches.begin(), caches.end(), [] (CacheInfo* a, CacheInfo* b) {
+        return a->hits_per_byte < b->hits_per_byte;
+    });
+    int64_t freed = 0;
+    for (CacheInfo* info : caches) {
+        if (freed >= bytes) {
+            break;
+        }
+        freed += info->cache->evict(bytes - freed);
+    }
+    return freed;
+}
+
+void CacheManager::rebalance_locked(int64_t budget) {
+    std::vector<CacheInfo*> caches;
+    int64_t total_capacity = 0;
+    for (CacheInfo& info : _caches) {
+        if (info.is_memory) {
+            caches.push_back(&info);
+            total_capacity += info.stats.capacity;
+        }
+    }
+    if (caches.empty()) {
+        return;
+    }
+
+    // The capacities were configured or a cache was added, scale them to the budget.
+    // A cache rounds its capacity up a bit, which is tolerated.
+    if (std::abs(total_capacity - budget) > budget / 100) {
+        for (CacheInfo* info : caches) {
+            size_t capacity = total_capacity > 0
+                    ? budget * 1.0 * info->stats.capacity / total_capacity
+                    : budget / caches.size();
+            info->cache->set_capacity(capacity);
+            info->stats.capacity = capacity;
+        }
+        return;
+    }
+
+    int64_t step = budget * REBALANCE_STEP_PERCENT / 100;
+    int64_t min_capacity = budget * MIN_CAPACITY_PERCENT / 100;
+    CacheInfo* receiver = NULL;
+    CacheInfo* donor = NULL;
+    for (CacheInfo* info : caches) {
+        if (info->stats.usage >= info->stats.capacity * FULL_USAGE_RATIO
+                && (receiver == NULL || info->hits_per_byte > receiver->hits_per_byte)) {
+            receiver = info;
+        }
+    }
+    if (receiver == NULL) {
+        return;
+    }
+    for (CacheInfo* info : caches) {
+        if (info != receiver && (int64_t)info->stats.capacity - step >= min_capacity
+                && info->hits_per_byte < receiver->hits_per_byte
+                && (donor == NULL || info->hits_per_byte < donor->hits_per_byte)) {
+            donor = info;
+        }
+    }
+    if (donor == NULL) {
+        return;
+    }
+    VLOG(1) << "Move " << PrettyPrinter::print(step, TUnit::BYTES) << " of capacity from cache "
+            << donor->name << " to " << receiver->name;
+    donor->stats.capacity -= step;
+    donor->cache->set_capacity(donor->stats.capacity);
+    receiver->stats.capacity += step;
+    receiver->cache->set_capacity(receiver->stats.capacity);
+}
+
+void CacheManager::debug(std::stringstream& ss) {
+    boost::lock_guard<boost::mutex> l(_lock);
+    ss << "cache\tmemory\tcapacity\tusage\tlookups\thit_ratio\tevictions\thits_per_mb\n";
+    for (CacheInfo& info : _caches) {
+        info.stats = CacheStats();
+        info.cache->get_stats(&info.stats);
+        double hit_ratio = info.stats.lookup_count > 0
+                ? info.stats.hit_count * 1.0 / info.stats.lookup_count : 0;
+        ss << info.name
+            << "\t" << (info.is_memory ? "true" : "false")
+            << "\t" << info.stats.capacity
+            << "\t" << info.stats.usage
+            << "\t" << info.stats.lookup_count
+            << "\t" << hit_ratio
+            << "\t" << info.stats.evict_count
+            << "\t" << info.hits_per_byte * 1024 * 1024
+            << "\n";
+    }
+}
+
+}
@@ -0,0 +1,125 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_CACHE_MANAGER_H
+#define BDG_PALO_BE_SRC_OLAP_CACHE_MANAGER_H
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "http/rest_monitor_iface.h"
+#include "olap/lru_cache.h"
+#include "util/metrics.h"
+
+namespace palo {
+
+class MemTracker;
+
+// Keeps track of the LRU caches of the backend, e.g. the index stream and data page
+// caches of the storage engine. Their hits, misses, evictions, usage and capacity are
+// exported as metrics labeled by cache and shown on /_monitor/cache_mgr.
+//
+// The caches whose charge is in bytes are memory caches. They are evicted from, those
+// with the fewest hits per byte first:
+// - when the process memory limit is reached, through a GC function of the process
+//   memory tracker;
+// - when the process memory tracker and the memory caches together use more than the
+//   process memory limit, checked every cache_manager_interval_sec.
+// If config::cache_memory_budget_bytes is set, the memory caches share that budget
+// instead of their configured capacities. Every cache_manager_interval_sec a slice of
+// it moves from the cache with the fewest recent hits per byte to the full cache with
+// the most.
+class CacheManager : public RestMonitorIface {
+public:
+    // Never destroyed, so that caches may be unregistered while the process exits.
+    static CacheManager* get_instance() {
+        static CacheManager* instance = new CacheManager();
+        return instance;
+    }
+
+    // Registers 'cache' under 'name'. 'is_memory' tells that the charge of its entries
+    // is their size in bytes.
+    void register_cache(const std::string& name, Cache* cache, bool is_memory);
+
+    // Must be called before 'cache' is destroyed.
+    void unregister_cache(Cache* cache);
+
+    // Registers the metrics of the caches in 'metrics' and, if 'process_mem_tracker'
+    // isn't NULL, a GC function with it. Starts the thread that updates the metrics
+    // and rebalances the caches. Called once at most.
+    void start(MetricGroup* metrics, MemTracker* process_mem_tracker);
+
+    // Evicts unpinned entries of the memory caches, least valuable cache first, until
+    // 'bytes' are freed. Returns the bytes freed.
+    int64_t free_memory(int64_t bytes);
+
+    // Refreshes the statistics and the metrics, relieves memory pressure and
+    // rebalances the capacities. Called by the thread, exposed for tests.
+    void update();
+
+    // A line per cache
+    virtual void debug(std::stringstream& ss);
+
+private:
+    struct CacheInfo {
+        CacheInfo() : cache(NULL), is_memory(false), last_hit_count(0),
+                hits_per_byte(0), lookups(NULL), hits(NULL), evictions(NULL),
+                usage(NULL), capacity(NULL) { }
+
+        std::string name;
+        Cache* cache;
+        bool is_memory;
+        CacheStats stats;
+        uint64_t last_hit_count;
+        // hits per byte of usage since the last update, smoothed
+        double hits_per_byte;
+
+        IntCounter* lookups;
+        IntCounter* hits;
+        IntCounter* evictions;
+        IntGauge* usage;
+        IntGauge* capacity;
+    };
+
+    CacheManager();
+
+    // Requires _lock held.
+    int64_t free_memory_locked(int64_t bytes);
+    void rebalance_locked(int64_t budget);
+    void update_metrics_locked(CacheInfo* info);
+
+    void update_thread();
+
+    boost::mutex _lock;
+    std::vector<CacheInfo> _caches;
+
+    MemTracker* _process_mem_tracker;
+    MetricFamily<IntCounter>* _lookups_metric;
+    MetricFamily<IntCounter>* _hits_metric;
+    MetricFamily<IntCounter>* _evictions_metric;
+    MetricFamily<IntGauge>* _usage_metric;
+    MetricFamily<IntGauge>* _capacity_metric;
+
+    boost::scoped_ptr<boost::thread> _update_thread;
+};
+
+}
+
+#endif // BDG_PALO_BE_SRC_OLAP_CACHE_MANAGER_H
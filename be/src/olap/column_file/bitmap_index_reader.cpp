@@ -0,0 +1,147 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/column_file/bitmap_index_reader.h"
+
+namespace palo {
+namespace column_file {
+
+BitmapIndexReader::~BitmapIndexReader() {
+    if (!_is_using_cache) {
+        SAFE_DELETE_ARRAY(_buffer);
+    }
+}
+
+OLAPStatus BitmapIndexReader::init(char* buffer, size_t buffer_size, bool is_using_cache) {
+    _buffer = buffer;
+    _buffer_size = buffer_size;
+    _is_using_cache = is_using_cache;
+
+    if (NULL == _buffer || _buffer_size < sizeof(BitmapIndexHeader)) {
+        OLAP_LOG_WARNING("invalid bitmap index buffer. [buffer_size=%lu]", buffer_size);
+        return OLAP_ERR_INPUT_PARAMETER_ERROR;
+    }
+
+    BitmapIndexHeader header;
+    memcpy(&header, _buffer, sizeof(header));
+    _row_count = header.row_count;
+
+    size_t offset = sizeof(header);
+    OLAPStatus res = _parse_row_id_list(&offset, &_null_rows);
+    if (OLAP_SUCCESS != res) {
+        return res;
+    }
+
+    for (uint32_t i = 0; i < header.value_count; ++i) {
+        uint32_t value_size = 0;
+        if (offset + sizeof(value_size) > _buffer_size) {
+            OLAP_LOG_WARNING("invalid bitmap index value. [offset=%lu buffer_size=%lu]",
+                             offset, _buffer_size);
+            return OLAP_ERR_FILE_FORMAT_ERROR;
+        }
+        memcpy(&value_size, _buffer + offset, sizeof(value_size));
+        offset += sizeof(value_size);
+
+        if (offset + value_size > _buffer_size) {
+            OLAP_LOG_WARNING("invalid bitmap index value. [offset=%lu value_size=%u]",
+                             offset, value_size);
+            return OLAP_ERR_FILE_FORMAT_ERROR;
+        }
+        std::string value(_buffer + offset, value_size);
+        offset += value_size;
+
+        RowIdList rows;
+        res = _parse_row_id_list(&offset, &rows);
+        if (OLAP_SUCCESS != res) {
+            return res;
+        }
+        _value_rows[value] = rows;
+    }
+
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus BitmapIndexReader::_parse_row_id_list(size_t* offset, RowIdList* rows) {
+    if (*offset + sizeof(uint32_t) * 2 > _buffer_size) {
+        OLAP_LOG_WARNING("invalid bitmap index row list. [offset=%lu buffer_size=%lu]",
+                         *offset, _buffer_size);
+        return OLAP_ERR_FILE_FORMAT_ERROR;
+    }
+
+    memcpy(&rows->row_count, _buffer + *offset, sizeof(uint32_t));
+    memcpy(&rows->data_length, _buffer + *offset + sizeof(uint32_t), sizeof(uint32_t));
+    *offset += sizeof(uint32_t) * 2;
+
+    if (*offset + rows->data_length > _buffer_size) {
+        OLAP_LOG_WARNING("invalid bitmap index row list. [offset=%lu data_length=%u]",
+                         *offset, rows->data_length);
+        return OLAP_ERR_FILE_FORMAT_ERROR;
+    }
+
+    rows->data = _buffer + *offset;
+    *offset += rows->data_length;
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus BitmapIndexReader::_add_rows(const RowIdList& list, RowBitmap* rows) const {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(list.data);
+    const uint8_t* end = data + list.data_length;
+    uint64_t row_id = 0;
+
+    for (uint32_t i = 0; i < list.row_count; ++i) {
+        uint64_t delta = 0;
+        int shift = 0;
+        while (true) {
+            if (data >= end || shift > 28) {
+                OLAP_LOG_WARNING("corrupted row list in bitmap index.");
+                return OLAP_ERR_FILE_FORMAT_ERROR;
+            }
+
+            uint8_t byte = *data++;
+            delta |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (0 == (byte & 0x80)) {
+                break;
+            }
+            shift += 7;
+        }
+
+        row_id += delta;
+        if (row_id >= rows->row_count()) {
+            OLAP_LOG_WARNING("row id out of range in bitmap index. [row_id=%lu row_count=%lu]",
+                             row_id, rows->row_count());
+            return OLAP_ERR_FILE_FORMAT_ERROR;
+        }
+        rows->set(row_id);
+    }
+
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus BitmapIndexReader::add_rows(const Field* field, RowBitmap* rows) const {
+    if (field->is_null()) {
+        return _add_rows(_null_rows, rows);
+    }
+
+    std::unordered_map<std::string, RowIdList>::const_iterator it
+            = _value_rows.find(bitmap_index_key(field));
+    if (_value_rows.end() == it) {
+        return OLAP_SUCCESS;
+    }
+
+    return _add_rows(it->second, rows);
+}
+
+}  // namespace column_file
+}  // namespace palo
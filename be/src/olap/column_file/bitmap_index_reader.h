@@ -0,0 +1,150 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_BITMAP_INDEX_READER_H
+#define BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_BITMAP_INDEX_READER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "olap/column_file/bitmap_index_writer.h"
+#include "olap/field.h"
+#include "olap/olap_define.h"
+
+namespace palo {
+namespace column_file {
+
+// One bit for each row of a segment
+class RowBitmap {
+public:
+    RowBitmap() : _row_count(0) {}
+
+    void init(uint64_t row_count, bool value) {
+        _row_count = row_count;
+        _data.assign((row_count + 63) / 64, value ? ~0UL : 0UL);
+        _clear_tail();
+    }
+
+    uint64_t row_count() const {
+        return _row_count;
+    }
+
+    inline void set(uint64_t row) {
+        _data[row >> 6] |= (1UL << (row & 63));
+    }
+
+    inline void reset(uint64_t row) {
+        _data[row >> 6] &= ~(1UL << (row & 63));
+    }
+
+    inline bool test(uint64_t row) const {
+        return 0 != (_data[row >> 6] & (1UL << (row & 63)));
+    }
+
+    void intersect(const RowBitmap& other) {
+        for (size_t i = 0; i < _data.size() && i < other._data.size(); ++i) {
+            _data[i] &= other._data[i];
+        }
+    }
+
+    void flip() {
+        for (size_t i = 0; i < _data.size(); ++i) {
+            _data[i] = ~_data[i];
+        }
+        _clear_tail();
+    }
+
+    // whether any row in [begin, end) is set
+    bool any(uint64_t begin, uint64_t end) const {
+        for (uint64_t row = begin; row < end; ++row) {
+            if (0 == (row & 63) && row + 64 <= end) {
+                if (0 != _data[row >> 6]) {
+                    return true;
+                }
+                row += 63;
+            } else if (test(row)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    void _clear_tail() {
+        if (0 != (_row_count & 63)) {
+            _data.back() &= (1UL << (_row_count & 63)) - 1;
+        }
+    }
+
+    uint64_t _row_count;
+    std::vector<uint64_t> _data;
+};
+
+// BitmapIndexReader parses a bitmap index stream written by BitmapIndexWriter,
+//     and answers which rows of the segment hold a given value.
+class BitmapIndexReader {
+public:
+    BitmapIndexReader() :
+            _buffer(NULL),
+            _buffer_size(0),
+            _row_count(0),
+            _is_using_cache(false) {}
+    ~BitmapIndexReader();
+
+    // Init BitmapIndexReader with given bitmap index buffer
+    OLAPStatus init(char* buffer, size_t buffer_size, bool is_using_cache);
+
+    uint64_t row_count() const {
+        return _row_count;
+    }
+
+    // Set the rows whose value equals to field in rows, a null field means null rows
+    OLAPStatus add_rows(const Field* field, RowBitmap* rows) const;
+
+    // Set the rows whose value is null in rows
+    OLAPStatus add_null_rows(RowBitmap* rows) const {
+        return _add_rows(_null_rows, rows);
+    }
+
+private:
+    struct RowIdList {
+        RowIdList() : row_count(0), data(NULL), data_length(0) {}
+
+        uint32_t row_count;
+        const char* data;
+        uint32_t data_length;
+    };
+
+    OLAPStatus _parse_row_id_list(size_t* offset, RowIdList* rows);
+    OLAPStatus _add_rows(const RowIdList& list, RowBitmap* rows) const;
+
+    char* _buffer;
+    size_t _buffer_size;
+    uint64_t _row_count;
+
+    // BitmapIndexReader will not release bitmap index buffer in destructor
+    // when it is cached in memory
+    bool _is_using_cache;
+
+    RowIdList _null_rows;
+    std::unordered_map<std::string, RowIdList> _value_rows;
+
+    DISALLOW_COPY_AND_ASSIGN(BitmapIndexReader);
+};
+
+}  // namespace column_file
+}  // namespace palo
+#endif // BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_BITMAP_INDEX_READER_H
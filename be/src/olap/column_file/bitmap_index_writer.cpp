@@ -0,0 +1,136 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/column_file/bitmap_index_writer.h"
+
+namespace palo {
+namespace column_file {
+
+void BitmapIndexWriter::RowIdList::add(uint32_t row_id) {
+    uint32_t delta = row_id - last_row_id;
+    while (delta >= 0x80) {
+        data.push_back(static_cast<char>((delta & 0x7f) | 0x80));
+        delta >>= 7;
+    }
+    data.push_back(static_cast<char>(delta));
+
+    last_row_id = row_id;
+    ++row_count;
+}
+
+BitmapIndexWriter::BitmapIndexWriter(uint32_t max_cardinality) :
+        _max_cardinality(max_cardinality),
+        _next_row_id(0),
+        _is_abandoned(false),
+        _buffered_memory(sizeof(BitmapIndexHeader)) {}
+
+void BitmapIndexWriter::add(const Field* field) {
+    uint32_t row_id = _next_row_id++;
+    if (_is_abandoned) {
+        return;
+    }
+
+    size_t data_size = 0;
+    if (field->is_null()) {
+        data_size = _null_rows.data.size();
+        _null_rows.add(row_id);
+        _buffered_memory += _null_rows.data.size() - data_size;
+        return;
+    }
+
+    std::string key = bitmap_index_key(field);
+    std::map<std::string, RowIdList>::iterator it = _value_rows.find(key);
+    if (_value_rows.end() == it) {
+        if (_value_rows.size() >= _max_cardinality) {
+            // too many distinct values, bitmap index is useless for this column
+            _is_abandoned = true;
+            _value_rows.clear();
+            _null_rows = RowIdList();
+            _buffered_memory = 0;
+            return;
+        }
+
+        it = _value_rows.insert(std::make_pair(key, RowIdList())).first;
+        _buffered_memory += key.size() + sizeof(uint32_t) * 3;
+    }
+
+    data_size = it->second.data.size();
+    it->second.add(row_id);
+    _buffered_memory += it->second.data.size() - data_size;
+}
+
+OLAPStatus BitmapIndexWriter::_write_row_id_list(
+        const RowIdList& rows, OutStream* out_stream) {
+    uint32_t data_length = rows.data.size();
+    OLAPStatus res = out_stream->write(
+            reinterpret_cast<const char*>(&rows.row_count), sizeof(rows.row_count));
+    if (OLAP_SUCCESS == res) {
+        res = out_stream->write(reinterpret_cast<const char*>(&data_length), sizeof(data_length));
+    }
+    if (OLAP_SUCCESS == res && data_length > 0) {
+        res = out_stream->write(rows.data.data(), data_length);
+    }
+
+    return res;
+}
+
+OLAPStatus BitmapIndexWriter::write_to_buffer(OutStream* out_stream) {
+    if (NULL == out_stream) {
+        OLAP_LOG_WARNING("out stream is NULL");
+        return OLAP_ERR_INPUT_PARAMETER_ERROR;
+    }
+
+    if (_is_abandoned) {
+        OLAP_LOG_WARNING("bitmap index has been abandoned");
+        return OLAP_ERR_INPUT_PARAMETER_ERROR;
+    }
+
+    BitmapIndexHeader header;
+    header.value_count = _value_rows.size();
+    header.row_count = _next_row_id;
+    OLAPStatus res = out_stream->write(reinterpret_cast<char*>(&header), sizeof(header));
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("write bitmap index header fail");
+        return res;
+    }
+
+    res = _write_row_id_list(_null_rows, out_stream);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("write null rows of bitmap index fail");
+        return res;
+    }
+
+    for (std::map<std::string, RowIdList>::const_iterator it = _value_rows.begin();
+            it != _value_rows.end(); ++it) {
+        uint32_t value_size = it->first.size();
+        res = out_stream->write(reinterpret_cast<const char*>(&value_size), sizeof(value_size));
+        if (OLAP_SUCCESS == res) {
+            res = out_stream->write(it->first.data(), value_size);
+        }
+        if (OLAP_SUCCESS == res) {
+            res = _write_row_id_list(it->second, out_stream);
+        }
+
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("write value of bitmap index fail");
+            return res;
+        }
+    }
+
+    return res;
+}
+
+}  // namespace column_file
+}  // namespace palo
@@ -0,0 +1,99 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_BITMAP_INDEX_WRITER_H
+#define BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_BITMAP_INDEX_WRITER_H
+
+#include <string.h>
+
+#include <map>
+#include <string>
+
+#include "olap/column_file/out_stream.h"
+#include "olap/field.h"
+#include "olap/olap_define.h"
+
+namespace palo {
+namespace column_file {
+
+// Bitmap index stream layout:
+//     BitmapIndexHeader
+//     row id list of null rows
+//     value_count * (uint32_t value_size, value, row id list)
+// Each row id list is stored as (uint32_t row_count, uint32_t data_length, data),
+//     data is the delta of consecutive row ids encoded as varint.
+struct BitmapIndexHeader {
+    uint32_t value_count;   // number of distinct non-null values
+    uint64_t row_count;     // number of rows in the segment
+    BitmapIndexHeader() : value_count(0), row_count(0) {}
+} __attribute__((packed));
+
+// The key used to look up a value in bitmap index. CHAR is compared without
+// trailing zeros, so that the operand of condition matches the stored value.
+inline std::string bitmap_index_key(const Field* field) {
+    if (OLAP_FIELD_TYPE_CHAR == field->type()) {
+        return std::string(field->buf(), strnlen(field->buf(), field->size()));
+    }
+
+    return std::string(field->buf(), field->size());
+}
+
+// BitmapIndexWriter records the rows of every distinct value of a column in
+// one segment. Once the number of distinct values exceeds max_cardinality,
+// the index is abandoned and nothing will be written.
+class BitmapIndexWriter {
+public:
+    explicit BitmapIndexWriter(uint32_t max_cardinality);
+    ~BitmapIndexWriter() {}
+
+    // Add the value of next row
+    void add(const Field* field);
+
+    bool is_abandoned() const {
+        return _is_abandoned;
+    }
+
+    uint64_t estimate_buffered_memory() const {
+        return _buffered_memory;
+    }
+
+    OLAPStatus write_to_buffer(OutStream* out_stream);
+
+private:
+    struct RowIdList {
+        RowIdList() : row_count(0), last_row_id(0) {}
+
+        void add(uint32_t row_id);
+
+        uint32_t row_count;
+        uint32_t last_row_id;
+        std::string data;
+    };
+
+    OLAPStatus _write_row_id_list(const RowIdList& rows, OutStream* out_stream);
+
+    uint32_t _max_cardinality;
+    uint32_t _next_row_id;
+    bool _is_abandoned;
+    uint64_t _buffered_memory;
+    RowIdList _null_rows;
+    std::map<std::string, RowIdList> _value_rows;
+
+    DISALLOW_COPY_AND_ASSIGN(BitmapIndexWriter);
+};
+
+}  // namespace column_file
+}  // namespace palo
+#endif // BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_BITMAP_INDEX_WRITER_H
@@ -23,6 +23,7 @@
 
 #include "olap/olap_define.h"
 #include "olap/utils.h"
+#include "util/block_bloom_filter.hpp"
 #include "util/hash_util.hpp"
 
 namespace palo {
@@ -132,13 +133,22 @@ private:
     uint32_t  _data_len;
 };
 
+// BloomFilter has two layouts with the same size and hash function num:
+//     standard: each hash function sets one bit in the whole bit set
+//     blocked: see BlockBloomFilter, each key only touches one 256-bit block. The tail bits
+//         which can not make up a block are unused, and it falls back to the standard
+//         layout if the bit set is smaller than a block.
 class BloomFilter {
 public:
-    BloomFilter() : _bit_num(0), _hash_function_num(0) {}
+    BloomFilter() : _bit_num(0), _hash_function_num(0), _block_num(0) {}
     ~BloomFilter() {}
 
     // Create BloomFilter with given entry num and fpp, which is used for loading data
     bool init(int64_t expected_entries, double fpp) {
+        return init(expected_entries, fpp, false);
+    }
+
+    bool init(int64_t expected_entries, double fpp, bool is_blocked) {
         uint32_t bit_num = _optimal_bit_num(expected_entries, fpp);
         if (!_bit_set.init(bit_num)) {
             return false;
@@ -146,6 +156,7 @@ public:
 
         _bit_num = _bit_set.bit_num();
         _hash_function_num = _optimal_hash_function_num(expected_entries, _bit_num);
+        _block_num = is_blocked ? _bit_num / BlockBloomFilter::BLOCK_BITS : 0;
         return true;
     }
 
@@ -156,8 +167,13 @@ public:
 
     // Init BloomFilter with given buffer, which is used for query
     bool init(uint64_t* data, uint32_t len, uint32_t hash_function_num) {
+        return init(data, len, hash_function_num, false);
+    }
+
+    bool init(uint64_t* data, uint32_t len, uint32_t hash_function_num, bool is_blocked) {
         _bit_num = sizeof(uint64_t) * 8 * len;
         _hash_function_num = hash_function_num;
+        _block_num = is_blocked ? _bit_num / BlockBloomFilter::BLOCK_BITS : 0;
         return _bit_set.init(data, len);
     }
 
@@ -171,6 +187,11 @@ public:
     // Generate mutiple hash value according to following rule:
     //     new_hash_value = hash_high_part + (i * hash_low_part)
     void add_hash(uint64_t hash) {
+        if (_block_num > 0) {
+            BlockBloomFilter::insert(_bit_set.data(), _block_num, hash);
+            return;
+        }
+
         uint32_t hash1 = (uint32_t) hash;
         uint32_t hash2 = (uint32_t) (hash >> 32);
 
@@ -190,6 +211,10 @@ public:
 
     // Verify whether hash value in BloomFilter
     bool test_hash(uint64_t hash) const {
+        if (_block_num > 0) {
+            return BlockBloomFilter::find(_bit_set.data(), _block_num, hash);
+        }
+
         uint32_t hash1 = (uint32_t) hash;
         uint32_t hash2 = (uint32_t) (hash >> 32);
 
@@ -208,7 +233,8 @@ public:
     //     and hash function number is not equal
     bool merge(const BloomFilter& that) {
         if (_bit_num == that.bit_num()
-                && _hash_function_num == that.hash_function_num()) {
+                && _hash_function_num == that.hash_function_num()
+                && _block_num == that._block_num) {
             _bit_set.merge(that.bit_set());
             return true;
         }
@@ -223,9 +249,14 @@ public:
     void reset() {
         _bit_num = 0;
         _hash_function_num = 0;
+        _block_num = 0;
         _bit_set.reset();
     }
 
+    bool is_blocked() const {
+        return _block_num > 0;
+    }
+
     uint32_t bit_num() const {
         return _bit_num;
     }
@@ -293,6 +324,8 @@ private:
     BitSet _bit_set;
     uint32_t _bit_num;
     uint32_t _hash_function_num;
+    // number of 256-bit blocks of blocked layout, 0 means standard layout
+    uint32_t _block_num;
 };
 
 }  // namespace column_file
@@ -33,13 +33,15 @@ public:
     BloomFilterIndexReader() {}
     ~BloomFilterIndexReader();
 
-    // Init BloomFilterIndexReader with given bloom filter index buffer
+    // Init BloomFilterIndexReader with given bloom filter index buffer,
+    // is_blocked means the entries are written in blocked layout
     OLAPStatus init(
             char* buffer,
             size_t buffer_size,
             bool is_using_cache,
             uint32_t hash_function_num,
-            uint32_t bit_num);
+            uint32_t bit_num,
+            bool is_blocked = false);
 
     // Get specified bloom filter entry
     const BloomFilter& entry(uint64_t entry_id);
@@ -60,6 +62,7 @@ private:
     // Bloom filter param
     uint32_t _bit_num;
     uint32_t _hash_function_num;
+    bool _is_blocked;
 
     // BloomFilterIndexReader will not release bloom filter index buffer in destructor
     // when it is cached in memory
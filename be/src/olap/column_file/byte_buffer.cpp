@@ -131,7 +131,8 @@ ByteBuffer* ByteBuffer::mmap(FileHandler* handler, uint64_t offset, int prot, in
 
     size_t length = handler->length();
     int fd = handler->fd();
-    char* memory = (char*)::mmap(NULL, length, prot, flags, fd, offset);
+    // 打包文件中的一段从页边界开始, 可以单独映射
+    char* memory = (char*)::mmap(NULL, length, prot, flags, fd, handler->region_offset() + offset);
 
     if (MAP_FAILED == memory) {
         OLAP_LOG_WARNING("fail to mmap. [errno='%d' errno_str='%s']", Errno::no(), Errno::str());
@@ -94,6 +94,16 @@ const RowCursor* ColumnData::get_next_row() {
     return _get_next_row(false);
 }
 
+OLAPStatus ColumnData::get_current_row_position(uint32_t* segment, uint64_t* row_id) {
+    if (NULL == _segment_reader || NULL == _segment_reader->get_current_row()) {
+        return OLAP_ERR_NOT_INITED;
+    }
+
+    *segment = _current_segment;
+    *row_id = _segment_reader->current_row_id();
+    return OLAP_SUCCESS;
+}
+
 const RowCursor* ColumnData::_get_next_row(bool without_filter) {
     const RowCursor* cursor = _segment_reader->get_next_row(without_filter);
 
@@ -158,6 +168,24 @@ const RowCursor* ColumnData::_get_next_row(bool without_filter) {
     return NULL;
 }
 
+OLAPStatus ColumnData::get_next_block(VectorizedRowBatch* batch, uint32_t* rows_read) {
+    *rows_read = 0;
+    if (NULL == _segment_reader || eof()) {
+        return OLAP_SUCCESS;
+    }
+
+    // 与_get_next_row一致, end key所在的block需要逐行和end key比较
+    if (NULL != _end_key
+            && (_current_segment > _end_key_block_position.segment
+                || (_current_segment == _end_key_block_position.segment
+                    && _segment_reader->current_block()
+                        >= _end_key_block_position.data_offset))) {
+        return OLAP_SUCCESS;
+    }
+
+    return _segment_reader->get_next_block(batch, rows_read);
+}
+
 OLAPStatus ColumnData::_find_row_block(
         const RowCursor& key,
         bool find_last_key,
@@ -206,6 +234,11 @@ OLAPStatus ColumnData::_seek_to_block(const RowBlockPosition& block_pos, bool wi
         }
 
         _current_segment = block_pos.segment;
+        DeleteBitmap::DeletedRows::const_iterator deleted_it
+                = _deleted_rows.find(block_pos.segment);
+        if (deleted_it != _deleted_rows.end()) {
+            _segment_reader->set_deleted_rows(&deleted_it->second);
+        }
         res = _segment_reader->init(_is_using_cache);
         if (OLAP_SUCCESS != res) {
             OLAP_LOG_WARNING("fail to init segment reader. [res=%d]", res);
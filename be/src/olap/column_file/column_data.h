@@ -46,6 +46,14 @@ public:
 
     virtual OLAPStatus set_end_key(const RowCursor* end_key, bool find_last_end_key);
 
+    virtual void set_deleted_rows(const DeleteBitmap::DeletedRows& deleted_rows) {
+        _deleted_rows = deleted_rows;
+    }
+
+    virtual OLAPStatus get_current_row_position(uint32_t* segment, uint64_t* row_id);
+
+    virtual OLAPStatus get_next_block(VectorizedRowBatch* batch, uint32_t* rows_read);
+
     virtual void set_read_params(
             const std::vector<uint32_t>& return_columns,
             const std::set<uint32_t>& load_bf_columns,
@@ -102,6 +110,7 @@ private:
     SegmentReader* _segment_reader;
     uint64_t _filted_rows;
     uint32_t _current_segment;
+    DeleteBitmap::DeletedRows _deleted_rows;
     // 下面两个成员只用于block接口
     RowBlock* _row_block;                 // 用于get_first_row_block缓存数据
     RowBlockPosition _row_block_pos;      // 与_row_block对应的pos
@@ -13,6 +13,7 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <atomic>
 #include <cstring>
 
 #include "olap/column_file/bit_field_reader.h"
@@ -73,6 +74,10 @@ OLAPStatus IntegerColumnReader::next(int64_t* value) {
     return _data_reader->next(value);
 }
 
+OLAPStatus IntegerColumnReader::next(int64_t* values, uint64_t count) {
+    return _data_reader->next(values, count);
+}
+
 StringColumnDirectReader::StringColumnDirectReader(
         uint32_t column_unique_id,
         uint32_t dictionary_size) : 
@@ -173,6 +178,9 @@ OLAPStatus StringColumnDirectReader::next(char* buffer, uint32_t* length) {
     return res;
 }
 
+// 字典reader的编号, 从1开始, 0表示没有字典
+static std::atomic<uint64_t> s_dictionary_version(0);
+
 StringColumnDictionaryReader::StringColumnDictionaryReader(
         uint32_t column_unique_id,
         uint32_t dictionary_size) : 
@@ -183,7 +191,8 @@ StringColumnDictionaryReader::StringColumnDictionaryReader(
         //_offset_dictionary(NULL),
         //_dictionary_data_buffer(NULL),
         _read_buffer(NULL),
-        _data_reader(NULL) {
+        _data_reader(NULL),
+        _dictionary_version(++s_dictionary_version) {
 
 }
 
@@ -417,9 +426,8 @@ OLAPStatus StringColumnDictionaryReader::skip(uint64_t row_count) {
     return _data_reader->skip(row_count);
 }
 
-OLAPStatus StringColumnDictionaryReader::next(char* buffer, uint32_t* length) {
-    int64_t value;
-    OLAPStatus res = _data_reader->next(&value);
+OLAPStatus StringColumnDictionaryReader::next_code(int64_t* code) {
+    OLAPStatus res = _data_reader->next(code);
     // 错误或是EOF
     if (OLAP_SUCCESS != res) {
         if (OLAP_ERR_DATA_EOF == res) {
@@ -429,19 +437,33 @@ OLAPStatus StringColumnDictionaryReader::next(char* buffer, uint32_t* length) {
         return res;
     }
 
-    if (value >= static_cast<int64_t>(_dictionary.size())) {
+    if (*code < 0 || *code >= static_cast<int64_t>(_dictionary.size())) {
         OLAP_LOG_WARNING("value may indicated an invalid dictionary entry. "
-                "[value = %lu, dictionary_size = %lu]",
-                value, _dictionary.size());
+                "[value = %ld, dictionary_size = %lu]",
+                *code, _dictionary.size());
         return OLAP_ERR_BUFFER_OVERFLOW;
     }
 
-    memcpy(buffer, _dictionary[value].c_str(), _dictionary[value].size());
-    *length = _dictionary[value].size();
+    return OLAP_SUCCESS;
+}
 
+OLAPStatus StringColumnDictionaryReader::get_dictionary_entry(
+        int64_t code, char* buffer, uint32_t* length) const {
+    memcpy(buffer, _dictionary[code].c_str(), _dictionary[code].size());
+    *length = _dictionary[code].size();
     return OLAP_SUCCESS;
 }
 
+OLAPStatus StringColumnDictionaryReader::next(char* buffer, uint32_t* length) {
+    int64_t value = 0;
+    OLAPStatus res = next_code(&value);
+    if (OLAP_SUCCESS != res) {
+        return res;
+    }
+
+    return get_dictionary_entry(value, buffer, length);
+}
+
 ColumnReader::ColumnReader(uint32_t column_id, uint32_t column_unique_id) : 
         _value_present(false),
         _column_id(column_id),
@@ -23,8 +23,11 @@
 #include "olap/column_file/stream_name.h"
 #include "olap/field.h"
 #include "olap/olap_common.h"
+#include "olap/olap_cond.h"
 #include "olap/olap_define.h"
 #include "olap/row_cursor.h"
+#include "runtime/mem_pool.h"
+#include "runtime/vectorized_row_batch.h"
 
 namespace palo {
 namespace column_file {
@@ -84,6 +87,8 @@ public:
     OLAPStatus skip(uint64_t row_count);
     // 返回当前行的数据，通过将内部指针移向下一行
     OLAPStatus next(int64_t* value);
+    // 批量返回count行的数据
+    OLAPStatus next(int64_t* values, uint64_t count);
     bool eof() {
         return _eof;
     }
@@ -108,6 +113,27 @@ public:
     // length - 输入时作为缓存区大小，返回时给出字符串的大小
     OLAPStatus next(char* buffer, uint32_t* length);
 
+    // 直接编码的列没有字典, 不支持按字典编码过滤
+    bool is_dictionary() const {
+        return false;
+    }
+    uint32_t dictionary_size() const {
+        return 0;
+    }
+    OLAPStatus get_dictionary_entry(int64_t code, char* buffer, uint32_t* length) const {
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+    OLAPStatus next_code(int64_t* code) {
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+    uint64_t dictionary_version() const {
+        return 0;
+    }
+    const std::string& dictionary_entry(int64_t code) const {
+        static const std::string empty;
+        return empty;
+    }
+
     size_t get_buffer_size() {
         return sizeof(RunLengthByteReader);
     }
@@ -136,6 +162,24 @@ public:
     OLAPStatus skip(uint64_t row_count);
     OLAPStatus next(char* buffer, uint32_t* length);
 
+    bool is_dictionary() const {
+        return true;
+    }
+    uint32_t dictionary_size() const {
+        return _dictionary.size();
+    }
+    // 将第code个字典项拷贝到buffer中, length返回字符串的大小
+    OLAPStatus get_dictionary_entry(int64_t code, char* buffer, uint32_t* length) const;
+    // 只读取下一行的字典编码, 不拷贝字符串
+    OLAPStatus next_code(int64_t* code);
+    // 进程内每个字典reader唯一的编号, 用于区分batch中的行来自哪个字典
+    uint64_t dictionary_version() const {
+        return _dictionary_version;
+    }
+    const std::string& dictionary_entry(int64_t code) const {
+        return _dictionary[code];
+    }
+
     size_t get_buffer_size() {
         return sizeof(RunLengthByteReader) + _dictionary_size;
     }
@@ -150,6 +194,7 @@ private:
     //ByteBuffer* _dictionary_data_buffer;   // 保存dict数据
     std::vector<std::string> _dictionary;
     RunLengthIntegerReader* _data_reader;   // 用来读实际的数据（用一个integer表示）
+    uint64_t _dictionary_version;
 };
 
 // ColumnReader用于读取一个列, 是其他XXXColumnReader的基类
@@ -212,6 +257,30 @@ public:
         return OLAP_SUCCESS;
     }
 
+    // 批量读取size行数据, 以存储格式写入column_vector中从start开始的位置,
+    // 同时填充null标记; 字符串类型写入StringValue, 数据拷贝到mem_pool中.
+    // 不支持批量读取的reader返回OLAP_ERR_FUNC_NOT_IMPLEMENTED, 且不消耗任何数据
+    virtual OLAPStatus next_batch(
+            ColumnVector* column_vector,
+            uint32_t start,
+            uint32_t size,
+            MemPool* mem_pool) {
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+
+    // 字典编码的字符串列: 用cond对每个字典项(以及NULL)求值一次并记录结果,
+    // 之后用next_selected按行只读取字典编码即可判断是否满足条件.
+    // cursor用于attach字典项来求值, 调用后其中本列的值无意义.
+    // 不支持的reader返回OLAP_ERR_FUNC_NOT_IMPLEMENTED
+    virtual OLAPStatus init_code_filter(const CondColumn& cond, RowCursor* cursor) {
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+
+    // 读取下一行, 返回该行是否满足init_code_filter给出的条件, 不解码字符串
+    virtual OLAPStatus next_selected(bool* selected) {
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+
     uint32_t column_unique_id() {
         return _column_unique_id;
     }
@@ -230,13 +299,92 @@ protected:
     // 但实际上对于
     uint64_t _count_none_nulls(uint64_t rows);
 
+    // 按字典编码批量读取字符串列: 每个字典项在一个batch中只拷贝一次到mem_pool,
+    // 各行的StringValue共用这份拷贝. column_vector要求时同时输出每行的字典编码.
+    // trim_padding为true时去掉定长字符串末尾补的0
+    template <class DictionaryReader>
+    OLAPStatus _next_dictionary_batch(DictionaryReader* reader,
+                                      bool trim_padding,
+                                      ColumnVector* column_vector,
+                                      uint32_t start,
+                                      uint32_t size,
+                                      MemPool* mem_pool);
+
     bool _value_present;
     uint32_t _column_id;        // column在schema内的id
     uint32_t _column_unique_id; // column的唯一id
     BitFieldReader* _present_reader;   // NULLable的字段的NULL值
     std::vector<ColumnReader*> _sub_readers;
+
+    // 字典项在当前batch的mem_pool中的拷贝, 由_next_dictionary_batch使用
+    std::vector<StringValue> _dictionary_values;
+    std::vector<uint8_t> _dictionary_value_copied;
 };
 
+template <class DictionaryReader>
+OLAPStatus ColumnReader::_next_dictionary_batch(DictionaryReader* reader,
+                                                bool trim_padding,
+                                                ColumnVector* column_vector,
+                                                uint32_t start,
+                                                uint32_t size,
+                                                MemPool* mem_pool) {
+    uint64_t dictionary_version = reader->dictionary_version();
+    uint32_t dictionary_size = reader->dictionary_size();
+    // 本batch中第一次读这个字典, mem_pool中还没有字典项的拷贝
+    if (column_vector->dict_version() != dictionary_version) {
+        _dictionary_values.resize(dictionary_size);
+        _dictionary_value_copied.assign(dictionary_size, 0);
+    }
+
+    StringValue* values = reinterpret_cast<StringValue*>(column_vector->col_data()) + start;
+    bool* is_null = column_vector->is_null() + start;
+    int32_t* codes = column_vector->is_dict_codes_enabled()
+            ? column_vector->dict_codes() + start : NULL;
+
+    for (uint32_t i = 0; i < size; ++i) {
+        OLAPStatus res = ColumnReader::next();
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to read next. [res=%d column_unique_id=%u]",
+                    res, _column_unique_id);
+            return res;
+        }
+
+        is_null[i] = _value_present;
+        if (true == _value_present) {
+            values[i].ptr = NULL;
+            values[i].len = 0;
+            if (NULL != codes) {
+                codes[i] = -1;
+            }
+            continue;
+        }
+
+        int64_t code = 0;
+        res = reader->next_code(&code);
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to read next code. [res=%d column_unique_id=%u]",
+                    res, _column_unique_id);
+            return res;
+        }
+
+        if (0 == _dictionary_value_copied[code]) {
+            const std::string& entry = reader->dictionary_entry(code);
+            size_t len = trim_padding ? strnlen(entry.data(), entry.size()) : entry.size();
+            char* ptr = reinterpret_cast<char*>(mem_pool->allocate(len));
+            memcpy(ptr, entry.data(), len);
+            _dictionary_values[code] = StringValue(ptr, len);
+            _dictionary_value_copied[code] = 1;
+        }
+        values[i] = _dictionary_values[code];
+        if (NULL != codes) {
+            codes[i] = code;
+        }
+    }
+
+    column_vector->add_dict_rows(dictionary_version, dictionary_size, size);
+    return OLAP_SUCCESS;
+}
+
 class DefaultValueReader : public ColumnReader {
 public:
     DefaultValueReader(uint32_t column_id, uint32_t column_unique_id, std::string default_value) :
@@ -285,6 +433,15 @@ public:
         _value_present = true;
         return OLAP_SUCCESS;
     }
+    virtual OLAPStatus next_batch(
+            ColumnVector* column_vector,
+            uint32_t start,
+            uint32_t size,
+            MemPool* mem_pool) {
+        _value_present = true;
+        memset(column_vector->is_null() + start, true, size * sizeof(bool));
+        return OLAP_SUCCESS;
+    }
 };
 
 // 对于Tiny类型, 使用Byte作为存储
@@ -336,6 +493,29 @@ public:
         return OLAP_SUCCESS;
     }
 
+    virtual OLAPStatus next_batch(
+            ColumnVector* column_vector,
+            uint32_t start,
+            uint32_t size,
+            MemPool* mem_pool) {
+        char* values = reinterpret_cast<char*>(column_vector->col_data()) + start;
+        bool* is_null = column_vector->is_null() + start;
+
+        for (uint32_t i = 0; i < size; ++i) {
+            OLAPStatus res = TinyColumnReader::next();
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to read next. [res=%d column_unique_id=%u]",
+                        res, _column_unique_id);
+                return res;
+            }
+
+            values[i] = _value;
+            is_null[i] = _value_present;
+        }
+
+        return OLAP_SUCCESS;
+    }
+
     virtual size_t get_buffer_size() {
         return sizeof(RunLengthByteReader);
     }
@@ -453,11 +633,60 @@ public:
         return OLAP_SUCCESS;
     }
 
+    virtual OLAPStatus next_batch(
+            ColumnVector* column_vector,
+            uint32_t start,
+            uint32_t size,
+            MemPool* mem_pool) {
+        T* values = reinterpret_cast<T*>(column_vector->col_data()) + start;
+        bool* is_null = column_vector->is_null() + start;
+
+        // 没有NULL值时直接批量解码整数
+        if (NULL == _present_reader) {
+            int64_t buffer[BATCH_SIZE];
+            memset(is_null, false, size * sizeof(bool));
+            for (uint32_t i = 0; i < size; i += BATCH_SIZE) {
+                uint32_t count = size - i < BATCH_SIZE ? size - i : BATCH_SIZE;
+                OLAPStatus res = _reader.next(buffer, count);
+                if (OLAP_SUCCESS != res) {
+                    if (OLAP_ERR_DATA_EOF == res) {
+                        _eof = true;
+                    }
+                    OLAP_LOG_WARNING("fail to read batch. [res=%d column_unique_id=%u]",
+                            res, _column_unique_id);
+                    return res;
+                }
+
+                for (uint32_t j = 0; j < count; ++j) {
+                    values[i + j] = static_cast<T>(buffer[j]);
+                }
+            }
+
+            return OLAP_SUCCESS;
+        }
+
+        for (uint32_t i = 0; i < size; ++i) {
+            OLAPStatus res = IntegerColumnReaderWrapper::next();
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to read next. [res=%d column_unique_id=%u]",
+                        res, _column_unique_id);
+                return res;
+            }
+
+            values[i] = _value;
+            is_null[i] = _value_present;
+        }
+
+        return OLAP_SUCCESS;
+    }
+
     virtual size_t get_buffer_size() {
         return sizeof(RunLengthIntegerReader);
     }
 
 private:
+    static const uint32_t BATCH_SIZE = 256;
+
     IntegerColumnReader _reader;  // 被包裹的真实读取器
     T _value;                     // 当前行读出的值
     bool _eof;
@@ -476,7 +705,8 @@ public:
             ColumnReader(column_id, column_unique_id),
             _buf(NULL),
             _reader(column_unique_id, dictionary_size),
-            _string_length(string_length) {
+            _string_length(string_length),
+            _null_selected(false) {
     }
     virtual ~FixLengthStringColumnReader() {
         SAFE_DELETE_ARRAY(_buf);
@@ -579,6 +809,90 @@ public:
         return OLAP_SUCCESS;
     }
 
+    virtual OLAPStatus next_batch(
+            ColumnVector* column_vector,
+            uint32_t start,
+            uint32_t size,
+            MemPool* mem_pool) {
+        if (_reader.is_dictionary()) {
+            return _next_dictionary_batch(&_reader, true, column_vector, start, size, mem_pool);
+        }
+
+        StringValue* values = reinterpret_cast<StringValue*>(column_vector->col_data()) + start;
+        bool* is_null = column_vector->is_null() + start;
+
+        for (uint32_t i = 0; i < size; ++i) {
+            OLAPStatus res = FixLengthStringColumnReader::next();
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to read next. [res=%d column_unique_id=%u]",
+                        res, _column_unique_id);
+                return res;
+            }
+
+            is_null[i] = _value_present;
+            if (true == _value_present) {
+                values[i].ptr = NULL;
+                values[i].len = 0;
+                continue;
+            }
+
+            // 定长字符串不足长度的部分补0, 返回时去掉
+            size_t len = strnlen(_buf, _string_length);
+            values[i].ptr = reinterpret_cast<char*>(mem_pool->allocate(len));
+            memcpy(values[i].ptr, _buf, len);
+            values[i].len = len;
+        }
+
+        return OLAP_SUCCESS;
+    }
+
+    virtual OLAPStatus init_code_filter(const CondColumn& cond, RowCursor* cursor) {
+        if (!_reader.is_dictionary()) {
+            return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+        }
+
+        uint32_t dictionary_size = _reader.dictionary_size();
+        _code_selected.assign(dictionary_size, 0);
+        cursor->set_not_null(_column_id);
+        for (uint32_t code = 0; code < dictionary_size; ++code) {
+            uint32_t buf_size = _string_length;
+            OLAPStatus res = _reader.get_dictionary_entry(code, _buf, &buf_size);
+            if (OLAP_SUCCESS != res) {
+                return res;
+            }
+
+            memset(&_buf[buf_size], 0, _string_length - buf_size);
+            cursor->attach_by_index(_column_id, _buf, false);
+            _code_selected[code] = cond.eval(*cursor) ? 1 : 0;
+        }
+
+        cursor->set_null(_column_id);
+        _null_selected = cond.eval(*cursor);
+        cursor->set_not_null(_column_id);
+
+        return OLAP_SUCCESS;
+    }
+
+    virtual OLAPStatus next_selected(bool* selected) {
+        OLAPStatus res = ColumnReader::next();
+        if (OLAP_SUCCESS != res) {
+            return res;
+        }
+
+        if (true == _value_present) {
+            *selected = _null_selected;
+            return OLAP_SUCCESS;
+        }
+
+        int64_t code = 0;
+        res = _reader.next_code(&code);
+        if (OLAP_SUCCESS == res) {
+            *selected = 0 != _code_selected[code];
+        }
+
+        return res;
+    }
+
     virtual size_t get_buffer_size() {
         return _reader.get_buffer_size() + _string_length;
     }
@@ -587,6 +901,8 @@ private:
     char* _buf;
     ReaderClass _reader;
     uint32_t _string_length;
+    std::vector<uint8_t> _code_selected;  // 每个字典项是否满足条件
+    bool _null_selected;                  // NULL是否满足条件
 };
 
 // VarStringColumnReader 处理变长长字符串，特点是在数据头部使用uint16表示长度
@@ -602,7 +918,8 @@ public:
             _buf(NULL),
             _reader(column_unique_id, dictionary_size),
             _max_length(max_length),
-            _real_length(NULL) {
+            _real_length(NULL),
+            _null_selected(false) {
     }
     virtual ~VarStringColumnReader() {
         SAFE_DELETE_ARRAY(_buf);
@@ -706,6 +1023,89 @@ public:
         return OLAP_SUCCESS;
     }
 
+    virtual OLAPStatus next_batch(
+            ColumnVector* column_vector,
+            uint32_t start,
+            uint32_t size,
+            MemPool* mem_pool) {
+        if (_reader.is_dictionary()) {
+            return _next_dictionary_batch(&_reader, false, column_vector, start, size, mem_pool);
+        }
+
+        StringValue* values = reinterpret_cast<StringValue*>(column_vector->col_data()) + start;
+        bool* is_null = column_vector->is_null() + start;
+
+        for (uint32_t i = 0; i < size; ++i) {
+            OLAPStatus res = VarStringColumnReader::next();
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to read next. [res=%d column_unique_id=%u]",
+                        res, _column_unique_id);
+                return res;
+            }
+
+            is_null[i] = _value_present;
+            if (true == _value_present) {
+                values[i].ptr = NULL;
+                values[i].len = 0;
+                continue;
+            }
+
+            values[i].ptr = reinterpret_cast<char*>(mem_pool->allocate(*_real_length));
+            memcpy(values[i].ptr, _buf + sizeof(VarCharField::LengthValueType), *_real_length);
+            values[i].len = *_real_length;
+        }
+
+        return OLAP_SUCCESS;
+    }
+
+    virtual OLAPStatus init_code_filter(const CondColumn& cond, RowCursor* cursor) {
+        if (!_reader.is_dictionary()) {
+            return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+        }
+
+        uint32_t dictionary_size = _reader.dictionary_size();
+        _code_selected.assign(dictionary_size, 0);
+        cursor->set_not_null(_column_id);
+        for (uint32_t code = 0; code < dictionary_size; ++code) {
+            uint32_t buf_size = 0;
+            OLAPStatus res = _reader.get_dictionary_entry(
+                    code, _buf + sizeof(VarCharField::LengthValueType), &buf_size);
+            if (OLAP_SUCCESS != res) {
+                return res;
+            }
+
+            *_real_length = static_cast<uint16_t>(buf_size);
+            cursor->attach_by_index(_column_id, _buf, false);
+            _code_selected[code] = cond.eval(*cursor) ? 1 : 0;
+        }
+
+        cursor->set_null(_column_id);
+        _null_selected = cond.eval(*cursor);
+        cursor->set_not_null(_column_id);
+
+        return OLAP_SUCCESS;
+    }
+
+    virtual OLAPStatus next_selected(bool* selected) {
+        OLAPStatus res = ColumnReader::next();
+        if (OLAP_SUCCESS != res) {
+            return res;
+        }
+
+        if (true == _value_present) {
+            *selected = _null_selected;
+            return OLAP_SUCCESS;
+        }
+
+        int64_t code = 0;
+        res = _reader.next_code(&code);
+        if (OLAP_SUCCESS == res) {
+            *selected = 0 != _code_selected[code];
+        }
+
+        return res;
+    }
+
     virtual size_t get_buffer_size() {
         return _reader.get_buffer_size() + _max_length;
     }
@@ -715,6 +1115,8 @@ private:
     ReaderClass _reader;
     uint32_t _max_length;
     VarCharField::LengthValueType* _real_length;
+    std::vector<uint8_t> _code_selected;  // 每个字典项是否满足条件
+    bool _null_selected;                  // NULL是否满足条件
 };
 
 template <typename FLOAT_TYPE>
@@ -853,6 +1255,29 @@ public:
         return OLAP_SUCCESS;
     }
 
+    virtual OLAPStatus next_batch(
+            ColumnVector* column_vector,
+            uint32_t start,
+            uint32_t size,
+            MemPool* mem_pool) {
+        FLOAT_TYPE* values = reinterpret_cast<FLOAT_TYPE*>(column_vector->col_data()) + start;
+        bool* is_null = column_vector->is_null() + start;
+
+        for (uint32_t i = 0; i < size; ++i) {
+            OLAPStatus res = FloatintPointColumnReader::next();
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to read next. [res=%d column_unique_id=%u]",
+                        res, _column_unique_id);
+                return res;
+            }
+
+            values[i] = _value;
+            is_null[i] = _value_present;
+        }
+
+        return OLAP_SUCCESS;
+    }
+
 protected:
     bool _eof;
     ReadOnlyFileStream* _data_stream;
@@ -893,6 +1318,29 @@ public:
         return OLAP_SUCCESS;
     }
 
+    virtual OLAPStatus next_batch(
+            ColumnVector* column_vector,
+            uint32_t start,
+            uint32_t size,
+            MemPool* mem_pool) {
+        DecimalBuf* values = reinterpret_cast<DecimalBuf*>(column_vector->col_data()) + start;
+        bool* is_null = column_vector->is_null() + start;
+
+        for (uint32_t i = 0; i < size; ++i) {
+            OLAPStatus res = DecimalColumnReader::next();
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to read next. [res=%d column_unique_id=%u]",
+                        res, _column_unique_id);
+                return res;
+            }
+
+            values[i] = _value;
+            is_null[i] = _value_present;
+        }
+
+        return OLAP_SUCCESS;
+    }
+
     virtual size_t get_buffer_size() {
         return sizeof(RunLengthByteReader) * 2;
     }
@@ -941,6 +1389,31 @@ public:
         return OLAP_SUCCESS;
     }
 
+    virtual OLAPStatus next_batch(
+            ColumnVector* column_vector,
+            uint32_t start,
+            uint32_t size,
+            MemPool* mem_pool) {
+        // mem_pool分配的内存不保证16字节对齐, 使用memcpy写入
+        char* values = reinterpret_cast<char*>(column_vector->col_data())
+                + start * sizeof(int128_t);
+        bool* is_null = column_vector->is_null() + start;
+
+        for (uint32_t i = 0; i < size; ++i) {
+            OLAPStatus res = LargeIntColumnReader::next();
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to read next. [res=%d column_unique_id=%u]",
+                        res, _column_unique_id);
+                return res;
+            }
+
+            memcpy(values + i * sizeof(int128_t), &_value, sizeof(int128_t));
+            is_null[i] = _value_present;
+        }
+
+        return OLAP_SUCCESS;
+    }
+
     virtual size_t get_buffer_size() {
         return sizeof(RunLengthByteReader) * 2;
     }
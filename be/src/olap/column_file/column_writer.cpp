@@ -164,12 +164,16 @@ ColumnWriter::ColumnWriter(
         _index_stream(NULL),
         _is_found_nulls(false),
         _bf(NULL),
+        _bitmap_index(NULL),
+        _sketch(NULL),
         _num_rows_per_row_block(num_rows_per_row_block),
         _bf_fpp(bf_fpp) {}
 
 ColumnWriter::~ColumnWriter() {
     SAFE_DELETE(_is_present);
     SAFE_DELETE(_bf);
+    SAFE_DELETE(_bitmap_index);
+    SAFE_DELETE(_sketch);
 
     for (std::vector<ColumnWriter*>::iterator it = _sub_writers.begin();
             it != _sub_writers.end(); ++it) {
@@ -200,14 +204,16 @@ OLAPStatus ColumnWriter::init() {
         }
     }
 
-    OLAPStatus res = _block_statistics.init(_field_info.type, true);
+    OLAPStatus res = _block_statistics.init(
+            _field_info.type, true, config::column_index_with_null_count);
 
     if (OLAP_SUCCESS != res) {
         OLAP_LOG_WARNING("init block statistic failed");
         return res;
     }
 
-    res = _segment_statistics.init(_field_info.type, true);
+    res = _segment_statistics.init(
+            _field_info.type, true, config::column_index_with_null_count);
 
     if (OLAP_SUCCESS != res) {
         OLAP_LOG_WARNING("init segment statistic failed");
@@ -237,16 +243,55 @@ OLAPStatus ColumnWriter::init() {
             return OLAP_ERR_MALLOC_ERROR;
         }
 
-        if (!_bf->init(_num_rows_per_row_block, _bf_fpp)) {
+        if (!_bf->init(_num_rows_per_row_block, _bf_fpp, _field_info.is_blocked_bf)) {
             OLAP_LOG_WARNING("fail to init bloom filter. num rows: %u, fpp: %g", 
                              _num_rows_per_row_block, _bf_fpp);
             return OLAP_ERR_INIT_FAILED;
         }
     }
 
+    // bitmap index
+    if (_is_bitmap_index_supported()) {
+        _bitmap_index = new(std::nothrow) BitmapIndexWriter(
+                config::bitmap_index_max_cardinality);
+        if (NULL == _bitmap_index) {
+            OLAP_LOG_WARNING("fail to allocate bitmap index writer");
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+    }
+
+    if (config::enable_column_sketch && ColumnSketch::is_supported(_field_info)) {
+        _sketch = new(std::nothrow) ColumnSketch(_field_info);
+        if (NULL == _sketch) {
+            OLAP_LOG_WARNING("fail to allocate column sketch");
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+    }
+
     return OLAP_SUCCESS;
 }
 
+bool ColumnWriter::_is_bitmap_index_supported() const {
+    if (config::bitmap_index_max_cardinality <= 0) {
+        return false;
+    }
+
+    switch (_field_info.type) {
+    case OLAP_FIELD_TYPE_FLOAT:
+    case OLAP_FIELD_TYPE_DOUBLE:
+    case OLAP_FIELD_TYPE_DISCRETE_DOUBLE:
+    case OLAP_FIELD_TYPE_HLL:
+    case OLAP_FIELD_TYPE_STRUCT:
+    case OLAP_FIELD_TYPE_LIST:
+    case OLAP_FIELD_TYPE_MAP:
+    case OLAP_FIELD_TYPE_UNKNOWN:
+    case OLAP_FIELD_TYPE_NONE:
+        return false;
+    default:
+        return true;
+    }
+}
+
 OLAPStatus ColumnWriter::write(RowCursor* row_cursor) {
     OLAPStatus res = OLAP_SUCCESS;
 
@@ -268,6 +313,14 @@ OLAPStatus ColumnWriter::write(RowCursor* row_cursor) {
         }
     }
 
+    if (NULL != _bitmap_index) {
+        _bitmap_index->add(field);
+    }
+
+    if (NULL != _sketch) {
+        _sketch->add(field);
+    }
+
     return res;
 }
 
@@ -293,7 +346,7 @@ OLAPStatus ColumnWriter::create_row_index_entry() {
             return OLAP_ERR_MALLOC_ERROR;
         }
 
-        if (!_bf->init(_num_rows_per_row_block, _bf_fpp)) {
+        if (!_bf->init(_num_rows_per_row_block, _bf_fpp, _field_info.is_blocked_bf)) {
             OLAP_LOG_WARNING("fail to init bloom filter. num rows: %u, fpp: %g", 
                              _num_rows_per_row_block, _bf_fpp);
             return OLAP_ERR_INIT_FAILED;
@@ -319,6 +372,10 @@ uint64_t ColumnWriter::estimate_buffered_memory() {
         result += _bf_index.estimate_buffered_memory();
     }
 
+    if (NULL != _bitmap_index) {
+        result += _bitmap_index->estimate_buffered_memory();
+    }
+
     for (std::vector<ColumnWriter*>::iterator it = _sub_writers.begin();
             it != _sub_writers.end(); ++it) {
         result += (*it)->estimate_buffered_memory();
@@ -395,6 +452,29 @@ OLAPStatus ColumnWriter::finalize(ColumnDataHeaderMessage* header) {
         }
     }
 
+    // write bitmap index, 基数过高时不输出
+    if (NULL != _bitmap_index && !_bitmap_index->is_abandoned()) {
+        OutStream* bitmap_index_stream = _stream_factory->create_stream(
+                unique_column_id(), StreamInfoMessage::BITMAP_INDEX);
+        if (NULL == bitmap_index_stream) {
+            OLAP_LOG_WARNING("fail to allocate bitmap index stream");
+            res = OLAP_ERR_MALLOC_ERROR;
+            OLAP_GOTO(FINALIZE_EXIT);
+        }
+
+        res = _bitmap_index->write_to_buffer(bitmap_index_stream);
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to write bitmap index stream");
+            OLAP_GOTO(FINALIZE_EXIT);
+        }
+
+        res = bitmap_index_stream->flush();
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to flush bitmap index stream");
+            OLAP_GOTO(FINALIZE_EXIT);
+        }
+    }
+
     // 在Segment头中记录一份Schema信息
     // 这样使得修改表的Schema后不影响对已存在的Segment中的数据读取
     column = header->add_column();
@@ -408,8 +488,17 @@ OLAPStatus ColumnWriter::finalize(ColumnDataHeaderMessage* header) {
     column->set_frac(_field_info.frac);
     column->set_unique_id(_field_info.unique_id);
     column->set_is_bf_column(is_bf_column());
+    column->set_is_blocked_bf(is_bf_column() && _field_info.is_blocked_bf);
 
     save_encoding(header->add_column_encoding());
+
+    if (NULL != _sketch) {
+        res = _sketch->to_pb(header->add_column_sketch());
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to save column sketch");
+            OLAP_GOTO(FINALIZE_EXIT);
+        }
+    }
     //segment_statistics()->save(header->add_column_statistics());
 
 FINALIZE_EXIT:
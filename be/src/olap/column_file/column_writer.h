@@ -20,10 +20,12 @@
 
 #include <map>
 
+#include "olap/column_file/bitmap_index_writer.h"
 #include "olap/column_file/bloom_filter.hpp"
 #include "olap/column_file/bloom_filter_writer.h"
 #include "olap/column_file/out_stream.h"
 #include "olap/column_file/stream_index_writer.h"
+#include "olap/column_sketch.h"
 #include "olap/field.h"
 #include "olap/olap_common.h"
 #include "olap/olap_define.h"
@@ -66,6 +68,7 @@ public:
     //   * column_type
     //   * column_encoding
     //   * column_statistics
+    //   * column_sketch
     virtual OLAPStatus finalize(ColumnDataHeaderMessage* header);
     virtual void save_encoding(ColumnEncodingMessage* encoding);
     // 子类返回统计信息的接口
@@ -112,6 +115,9 @@ private:
         return _field_info.is_bf_column;
     }
 
+    // 低基数的列可以建立bitmap索引, 浮点数和HLL不支持等值查询, 不建立
+    bool _is_bitmap_index_supported() const;
+
     uint32_t _column_id;
     const FieldInfo& _field_info;
     OutStreamFactory* _stream_factory; // 该对象由外部调用者所有
@@ -125,6 +131,8 @@ private:
     BloomFilter* _bf;
     BloomFilterIndexWriter _bf_index;
     OutStream* _bf_index_stream;
+    BitmapIndexWriter* _bitmap_index;  // 基数超过阈值后放弃, 不输出
+    ColumnSketch* _sketch;             // 列的NDV和直方图, 记录在Segment头中
     size_t _num_rows_per_row_block;
     double _bf_fpp;
 
@@ -15,6 +15,12 @@
 
 #include "compress.h"
 
+#include <algorithm>
+
+#include <zstd/zstd.h>
+#include <zstd/zstd_errors.h>
+
+#include "common/config.h"
 #include "olap/column_file/byte_buffer.h"
 #include "olap/utils.h"
 
@@ -97,5 +103,127 @@ OLAPStatus lz4_decompress(ByteBuffer* in, ByteBuffer* out) {
     return res;
 }
 
+OLAPStatus zstd_compress(ByteBuffer* in, ByteBuffer* out, int level, bool* smaller) {
+    *smaller = false;
+    size_t zstd_res = ZSTD_compress(&(out->array()[out->position()]),
+            out->remaining(),
+            &(in->array()[in->position()]),
+            in->remaining(),
+            level);
+
+    if (ZSTD_isError(zstd_res)) {
+        // 输出空间不足说明数据不可压缩, 与lzo/lz4一样按不变小处理
+        if (ZSTD_error_dstSize_tooSmall == ZSTD_getErrorCode(zstd_res)) {
+            return OLAP_SUCCESS;
+        }
+
+        OLAP_LOG_WARNING("compress failed. [src_len=%lu dest_len=%lu err='%s']",
+                in->remaining(),
+                out->remaining(),
+                ZSTD_getErrorName(zstd_res));
+        return OLAP_ERR_COMPRESS_ERROR;
+    }
+
+    if (zstd_res < in->remaining()) {
+        *smaller = true;
+        out->set_position(out->position() + zstd_res);
+    }
+
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus zstd_decompress(ByteBuffer* in, ByteBuffer* out) {
+    size_t zstd_res = ZSTD_decompress(&(out->array()[out->position()]),
+            out->remaining(),
+            &(in->array()[in->position()]),
+            in->remaining());
+
+    if (ZSTD_isError(zstd_res)) {
+        OLAP_LOG_WARNING("decompress failed. [src_len=%lu dest_len=%lu err='%s']",
+                in->remaining(),
+                out->remaining(),
+                ZSTD_getErrorName(zstd_res));
+        return OLAP_ERR_DECOMPRESS_ERROR;
+    }
+
+    out->set_limit(zstd_res);
+    return OLAP_SUCCESS;
+}
+
+// Compressor不能携带压缩级别, 每个级别实例化一个压缩函数
+template <int LEVEL>
+static OLAPStatus zstd_compress_with_level(ByteBuffer* in, ByteBuffer* out, bool* smaller) {
+    return zstd_compress(in, out, LEVEL, smaller);
+}
+
+static const Compressor ZSTD_COMPRESSORS[] = {
+    zstd_compress_with_level<1>, zstd_compress_with_level<2>,
+    zstd_compress_with_level<3>, zstd_compress_with_level<4>,
+    zstd_compress_with_level<5>, zstd_compress_with_level<6>,
+    zstd_compress_with_level<7>, zstd_compress_with_level<8>,
+    zstd_compress_with_level<9>, zstd_compress_with_level<10>,
+    zstd_compress_with_level<11>, zstd_compress_with_level<12>,
+    zstd_compress_with_level<13>, zstd_compress_with_level<14>,
+    zstd_compress_with_level<15>, zstd_compress_with_level<16>,
+    zstd_compress_with_level<17>, zstd_compress_with_level<18>,
+    zstd_compress_with_level<19>
+};
+
+OLAPStatus get_compressor(CompressKind kind, int level, Compressor* compressor) {
+    switch (kind) {
+    case COMPRESS_NONE:
+        *compressor = NULL;
+        break;
+
+    case COMPRESS_LZO:
+        *compressor = lzo_compress;
+        break;
+
+    case COMPRESS_LZ4:
+        *compressor = lz4_compress;
+        break;
+
+    case COMPRESS_ZSTD:
+        if (0 == level) {
+            level = config::zstd_compress_level;
+        }
+        level = std::max(ZSTD_MIN_COMPRESS_LEVEL, std::min(level, ZSTD_MAX_COMPRESS_LEVEL));
+        *compressor = ZSTD_COMPRESSORS[level - ZSTD_MIN_COMPRESS_LEVEL];
+        break;
+
+    default:
+        OLAP_LOG_WARNING("unknown compress kind. [kind=%d]", kind);
+        return OLAP_ERR_INPUT_PARAMETER_ERROR;
+    }
+
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus get_decompressor(CompressKind kind, Decompressor* decompressor) {
+    switch (kind) {
+    case COMPRESS_NONE:
+        *decompressor = NULL;
+        break;
+
+    case COMPRESS_LZO:
+        *decompressor = lzo_decompress;
+        break;
+
+    case COMPRESS_LZ4:
+        *decompressor = lz4_decompress;
+        break;
+
+    case COMPRESS_ZSTD:
+        *decompressor = zstd_decompress;
+        break;
+
+    default:
+        OLAP_LOG_WARNING("unknown decompress kind. [kind=%d]", kind);
+        return OLAP_ERR_INPUT_PARAMETER_ERROR;
+    }
+
+    return OLAP_SUCCESS;
+}
+
 }  // namespace column_file
 }  // namespace palo
@@ -16,6 +16,7 @@
 #ifndef BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_COMPRESS_H
 #define BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_COMPRESS_H
 
+#include "gen_cpp/olap_common.pb.h"
 #include "olap/olap_define.h"
 
 namespace palo {
@@ -48,6 +49,19 @@ OLAPStatus lzo_decompress(ByteBuffer* in, ByteBuffer* out);
 OLAPStatus lz4_compress(ByteBuffer* in, ByteBuffer* out, bool* smaller);
 OLAPStatus lz4_decompress(ByteBuffer* in, ByteBuffer* out);
 
+// zstd的压缩级别, 超出范围的级别按最近的合法值处理
+static const int ZSTD_MIN_COMPRESS_LEVEL = 1;
+static const int ZSTD_MAX_COMPRESS_LEVEL = 19;
+
+OLAPStatus zstd_compress(ByteBuffer* in, ByteBuffer* out, int level, bool* smaller);
+OLAPStatus zstd_decompress(ByteBuffer* in, ByteBuffer* out);
+
+// 获取压缩类型对应的压缩函数, COMPRESS_NONE时为NULL。
+// level只对COMPRESS_ZSTD有效, 0表示使用config::zstd_compress_level
+OLAPStatus get_compressor(CompressKind kind, int level, Compressor* compressor);
+// 获取压缩类型对应的解压函数, COMPRESS_NONE时为NULL
+OLAPStatus get_decompressor(CompressKind kind, Decompressor* decompressor);
+
 }  // namespace column_file
 }  // namespace palo
 #endif // BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_COMPRESS_H
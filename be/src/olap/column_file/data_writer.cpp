@@ -33,11 +33,17 @@ ColumnDataWriter::ColumnDataWriter(SmartOLAPTable table, OLAPIndex* index, bool
         _num_rows(0),
         _block_id(0),
         _max_segment_size(OLAP_MAX_SEGMENT_FILE_SIZE),
-        _segment(0) {}
+        _segment(0),
+        _data_size(0) {}
 
 ColumnDataWriter::~ColumnDataWriter() {
     SAFE_DELETE(_row_block);
     SAFE_DELETE(_segment_writer);
+
+    for (std::map<uint32_t, ColumnSketch*>::iterator it = _column_sketches.begin();
+            it != _column_sketches.end(); ++it) {
+        SAFE_DELETE(it->second);
+    }
 }
 
 OLAPStatus ColumnDataWriter::init() {
@@ -52,6 +58,11 @@ OLAPStatus ColumnDataWriter::init() {
     double size = static_cast<double>(_table->segment_size());
     size *= OLAP_COLUMN_FILE_SEGMENT_SIZE_SCALE;
     _max_segment_size = (uint32_t)lround(size);
+    // push的数据量较小, 只有非push写入(合并, schema change)才需要限制缓存的segment大小
+    if (!_is_push_write && config::compaction_max_buffered_segment_size > 0
+            && _max_segment_size > config::compaction_max_buffered_segment_size) {
+        _max_segment_size = config::compaction_max_buffered_segment_size;
+    }
 
     _row_block = new(std::nothrow) RowBlock(_table->tablet_schema());
 
@@ -61,12 +72,6 @@ OLAPStatus ColumnDataWriter::init() {
         return OLAP_ERR_MALLOC_ERROR;
     }
 
-    res = _cursor.init(_table->tablet_schema());
-    if (OLAP_SUCCESS != res) {
-        OLAP_LOG_WARNING("fail to initiate row cursor. [res=%d]", res);
-        return res;
-    }
-
     OLAP_LOG_DEBUG("init ColumnData writer. [table='%s' block_row_size=%lu]",
             _table->full_name().c_str(), _table->num_rows_per_row_block());
     RowBlockInfo block_info(0U, _table->num_rows_per_row_block(), 0);
@@ -79,6 +84,22 @@ OLAPStatus ColumnDataWriter::init() {
         return res;
     }
 
+    if (config::enable_column_sketch) {
+        const std::vector<FieldInfo>& tablet_schema = _table->tablet_schema();
+        for (size_t i = 0; i < tablet_schema.size(); ++i) {
+            if (!ColumnSketch::is_supported(tablet_schema[i])) {
+                continue;
+            }
+
+            ColumnSketch* sketch = new(std::nothrow) ColumnSketch(tablet_schema[i]);
+            if (NULL == sketch) {
+                OLAP_LOG_WARNING("fail to allocate column sketch.");
+                return OLAP_ERR_MALLOC_ERROR;
+            }
+            _column_sketches[tablet_schema[i].unique_id] = sketch;
+        }
+    }
+
     res = _add_segment();
     if (OLAP_SUCCESS != res) {
         OLAP_LOG_WARNING("fail to add segment. [res=%d]", res);
@@ -131,6 +152,32 @@ OLAPStatus ColumnDataWriter::finalize() {
         return res;
     }
 
+    if (!_column_sketches.empty()) {
+        std::vector<ColumnSketchMessage> column_sketches(_column_sketches.size());
+        size_t i = 0;
+        for (std::map<uint32_t, ColumnSketch*>::iterator it = _column_sketches.begin();
+                it != _column_sketches.end(); ++it, ++i) {
+            res = it->second->to_pb(&column_sketches[i]);
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to save column sketch. [res=%d]", res);
+                return res;
+            }
+        }
+        _index->set_column_sketches(column_sketches);
+    }
+
+    // 小版本的所有文件打包成一个文件, 减少文件数和打开文件的开销.
+    // 打包失败不影响写入, 版本保留原来的文件
+    if (config::packed_version_max_size > 0
+            && _data_size < static_cast<uint64_t>(config::packed_version_max_size)) {
+        res = _index->pack_files();
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to pack files of version, keep them unpacked. "
+                             "[version='%d-%d' res=%d]",
+                             _index->version().first, _index->version().second, res);
+        }
+    }
+
     return OLAP_SUCCESS;
 }
 
@@ -181,33 +228,50 @@ OLAPStatus ColumnDataWriter::_finalize_segment() {
         return OLAP_ERR_WRITER_DATA_WRITE_ERROR;
     }
 
+    if (OLAP_SUCCESS != _merge_column_sketches()) {
+        OLAP_LOG_WARNING("fail to merge column sketches of segment.");
+        return OLAP_ERR_WRITER_DATA_WRITE_ERROR;
+    }
+
     if (OLAP_SUCCESS != _index->finalize_segment(data_segment_size, _num_rows)) {
         OLAP_LOG_WARNING("fail to finish segment from olap_index.");
         return OLAP_ERR_WRITER_INDEX_WRITE_ERROR;
     }
+    _data_size += data_segment_size;
 
     SAFE_DELETE(_segment_writer);
     return res;
 }
 
-OLAPStatus ColumnDataWriter::_flush_row_block(RowBlock* row_block, bool is_finalized) {
-    OLAPStatus res;
-
-    // 目标是将自己的block按条写入目标block中。
-    for (uint32_t i = 0; i < row_block->row_block_info().row_num; i++) {
-        res = row_block->get_row_to_read(i, &_cursor);
-        if (OLAP_SUCCESS != res) {
-            OLAP_LOG_WARNING("fail to get row from row block. [res=%d]", res);
-            return OLAP_ERR_WRITER_DATA_WRITE_ERROR;
+OLAPStatus ColumnDataWriter::_merge_column_sketches() {
+    const std::vector<ColumnSketchMessage>& segment_sketches =
+            _segment_writer->column_sketches();
+    for (size_t i = 0; i < segment_sketches.size(); ++i) {
+        std::map<uint32_t, ColumnSketch*>::iterator it =
+                _column_sketches.find(segment_sketches[i].unique_id());
+        if (_column_sketches.end() == it) {
+            continue;
         }
 
-        res = _segment_writer->write(&_cursor);
+        OLAPStatus res = it->second->merge(segment_sketches[i]);
         if (OLAP_SUCCESS != res) {
-            OLAP_LOG_WARNING("fail to write row to segment. [res=%d]", res);
-            return OLAP_ERR_WRITER_DATA_WRITE_ERROR;
+            return res;
         }
     }
 
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus ColumnDataWriter::_flush_row_block(RowBlock* row_block, bool is_finalized) {
+    OLAPStatus res;
+
+    // 目标是将自己的block按条写入目标block中。
+    res = _segment_writer->write_row_block(*row_block);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to write row block to segment. [res=%d]", res);
+        return OLAP_ERR_WRITER_DATA_WRITE_ERROR;
+    }
+
     /*
     if (OLAP_SUCCESS != (res = _segment_writer->create_row_index_entry())) {
         OLAP_LOG_WARNING("fail to record block position. [res=%d]", res);
@@ -291,6 +355,66 @@ OLAPStatus ColumnDataWriter::write_row_block(RowBlock* row_block) {
     return _flush_row_block(row_block, false);
 }
 
+OLAPStatus ColumnDataWriter::write_key_columns(RowCursor* key_row) {
+    OLAPStatus res = OLAP_SUCCESS;
+
+    // 与_flush_row_block相同, 每个block的第一行记录到OLAPIndex中
+    if (0 == _num_rows % _table->num_rows_per_row_block()) {
+        res = _index->add_short_key(*key_row, _block_id++);
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to update index. [res=%d]", res);
+            return OLAP_ERR_WRITER_INDEX_WRITE_ERROR;
+        }
+    }
+
+    res = _segment_writer->write_columns(0, _table->num_key_fields(), _num_rows, key_row);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to write key columns to segment. [res=%d]", res);
+        return OLAP_ERR_WRITER_DATA_WRITE_ERROR;
+    }
+
+    _update_column_statistics(*key_row);
+    ++_num_rows;
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus ColumnDataWriter::write_value_columns(uint32_t begin,
+                                                 uint32_t end,
+                                                 uint64_t row_id,
+                                                 RowCursor* row) {
+    OLAPStatus res = _segment_writer->write_columns(begin, end, row_id, row);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to write value columns to segment. [begin=%u end=%u res=%d]",
+                         begin, end, res);
+        return OLAP_ERR_WRITER_DATA_WRITE_ERROR;
+    }
+
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus ColumnDataWriter::next_segment() {
+    OLAPStatus res = _finalize_segment();
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to finalize segment. [res=%d]", res);
+        return OLAP_ERR_WRITER_DATA_WRITE_ERROR;
+    }
+
+    res = _add_segment();
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to add segment. [res=%d]", res);
+        return OLAP_ERR_WRITER_DATA_WRITE_ERROR;
+    }
+
+    res = _index->add_segment();
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to add index segment. [res=%d]", res);
+        return res;
+    }
+
+    _num_rows = 0;
+    return OLAP_SUCCESS;
+}
+
 uint64_t ColumnDataWriter::written_bytes() {
     uint64_t size = _segment * _max_segment_size + _segment_writer->estimate_segment_size();
     return size;
@@ -16,6 +16,9 @@
 #ifndef BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_DATA_WRITER_H
 #define BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_DATA_WRITER_H
 
+#include <map>
+
+#include "olap/column_sketch.h"
 #include "olap/row_block.h"
 #include "olap/writer.h"
 
@@ -34,20 +37,36 @@ public:
     virtual OLAPStatus finalize();
     virtual OLAPStatus write_row_block(RowBlock* row_block);
     virtual uint64_t written_bytes();
+
+    // 纵向合并(见Merger)按列组写入当前Segment: 先用write_key_columns按顺序写入所有行
+    // 的key列, 再用write_value_columns依次写入每组value列的所有行, row_id为行在Segment
+    // 中的行号. 然后调用next_segment开始下一个Segment, 或者调用finalize结束写入
+    OLAPStatus write_key_columns(RowCursor* key_row);
+    OLAPStatus write_value_columns(uint32_t begin, uint32_t end, uint64_t row_id,
+                                   RowCursor* row);
+    OLAPStatus next_segment();
+
+    uint32_t max_segment_size() const {
+        return _max_segment_size;
+    }
 private:
     OLAPStatus _add_segment();
     OLAPStatus _finalize_segment();
+    // 合并当前Segment的列统计草图
+    OLAPStatus _merge_column_sketches();
     OLAPStatus _flush_row_block(RowBlock* row_block, bool is_finalized);
     OLAPStatus _flush_row_block(bool is_finalized);
 
     OLAPIndex* _index;
     RowBlock* _row_block;      // 使用RowBlcok缓存要写入的数据
-    RowCursor _cursor;
     SegmentWriter* _segment_writer;
     int64_t _num_rows;
     uint32_t _block_id;        // 当前Segment内的block编号
     uint32_t _max_segment_size;
     uint32_t _segment;
+    uint64_t _data_size;       // 已完成的Segment的数据文件大小之和
+    // column unique id -> 所有Segment合并后的统计草图
+    std::map<uint32_t, ColumnSketch*> _column_sketches;
 
     DISALLOW_COPY_AND_ASSIGN(ColumnDataWriter);
 };
@@ -18,6 +18,10 @@
 #include "olap/column_file/byte_buffer.h"
 #include "olap/column_file/out_stream.h"
 
+#include "common/config.h"
+#include "olap/olap_define.h"
+#include "util/palo_metrics.h"
+
 namespace palo {
 namespace column_file {
 
@@ -32,7 +36,8 @@ ReadOnlyFileStream::ReadOnlyFileStream(
         _shared_buffer(shared_buffer),
         _decompressor(decompressor),
         _compress_buffer_size(compress_buffer_size + sizeof(StreamHead)),
-        _current_compress_position(std::numeric_limits<uint64_t>::max()) {
+        _current_compress_position(std::numeric_limits<uint64_t>::max()),
+        _page_cache(NULL) {
 }
 
 ReadOnlyFileStream::ReadOnlyFileStream(
@@ -48,7 +53,8 @@ ReadOnlyFileStream::ReadOnlyFileStream(
         _shared_buffer(shared_buffer),
         _decompressor(decompressor),
         _compress_buffer_size(compress_buffer_size + sizeof(StreamHead)),
-        _current_compress_position(std::numeric_limits<uint64_t>::max()) {
+        _current_compress_position(std::numeric_limits<uint64_t>::max()),
+        _page_cache(NULL) {
 }
 
 OLAPStatus ReadOnlyFileStream::_assure_data() {
@@ -61,8 +67,23 @@ OLAPStatus ReadOnlyFileStream::_assure_data() {
         return OLAP_ERR_COLUMN_STREAM_EOF;
     }
 
-    StreamHead header;
+    _file_cursor.read_ahead(config::column_file_read_ahead_bytes);
+
     size_t file_cursor_used = _file_cursor.position();
+    char key_buf[OLAP_LRU_CACHE_MAX_KEY_LENTH];
+    CacheKey key;
+    if (NULL != _page_cache) {
+        // the segments of a packed version share the file, so the key takes the offset
+        // in the whole file
+        key = _construct_page_key(
+                key_buf, sizeof(key_buf), _file_cursor.file_name(),
+                _file_cursor.region_offset() + _file_cursor.file_offset());
+        if (!key.empty() && _load_from_page_cache(key, file_cursor_used)) {
+            return OLAP_SUCCESS;
+        }
+    }
+
+    StreamHead header;
     OLAPStatus res = _file_cursor.read(reinterpret_cast<char*>(&header), sizeof(header));
 
     if (OLAP_UNLIKELY(OLAP_SUCCESS != res)) {
@@ -91,6 +112,10 @@ OLAPStatus ReadOnlyFileStream::_assure_data() {
             OLAP_LOG_WARNING("fail to decompress err=%d", res);
             return res;
         }
+
+        if (!key.empty()) {
+            _insert_page_cache(key, _file_cursor.position() - file_cursor_used);
+        }
     }
 
     _uncompressed = _compressed_helper;
@@ -184,6 +209,76 @@ OLAPStatus ReadOnlyFileStream::_fill_compressed(size_t length) {
     return res;
 }
 
+bool ReadOnlyFileStream::_load_from_page_cache(const CacheKey& key, size_t file_cursor_used) {
+    if (PaloMetrics::olap_data_page_cache_lookup_count() != NULL) {
+        PaloMetrics::olap_data_page_cache_lookup_count()->increment(1);
+    }
+
+    Cache::Handle* handle = _page_cache->lookup(key);
+    if (NULL == handle) {
+        return false;
+    }
+
+    bool hit = false;
+    const CachedPage* page = reinterpret_cast<const CachedPage*>(_page_cache->value(handle));
+    if (page->size <= _compressed_helper->capacity()
+            && OLAP_SUCCESS == _file_cursor.seek(file_cursor_used + page->chunk_length)) {
+        memcpy(_compressed_helper->array(),
+               reinterpret_cast<const char*>(page) + sizeof(CachedPage),
+               page->size);
+        _compressed_helper->set_limit(page->size);
+        _compressed_helper->set_position(0);
+        _uncompressed = _compressed_helper;
+        _current_compress_position = file_cursor_used;
+        hit = true;
+    }
+    _page_cache->release(handle);
+
+    if (hit && PaloMetrics::olap_data_page_cache_hit_count() != NULL) {
+        PaloMetrics::olap_data_page_cache_hit_count()->increment(1);
+    }
+
+    return hit;
+}
+
+void ReadOnlyFileStream::_insert_page_cache(const CacheKey& key, uint64_t chunk_length) {
+    uint64_t size = _compressed_helper->limit();
+    char* buffer = new(std::nothrow) char[sizeof(CachedPage) + size];
+    if (NULL == buffer) {
+        // cache只是优化, 分配失败时不影响读取
+        return;
+    }
+
+    CachedPage* page = reinterpret_cast<CachedPage*>(buffer);
+    page->chunk_length = chunk_length;
+    page->size = size;
+    memcpy(buffer + sizeof(CachedPage), _compressed_helper->array(), size);
+
+    Cache::Handle* handle = _page_cache->insert(
+            key, buffer, sizeof(CachedPage) + size, &_delete_cached_page);
+    if (NULL != handle) {
+        _page_cache->release(handle);
+    }
+}
+
+CacheKey ReadOnlyFileStream::_construct_page_key(
+        char* buf,
+        size_t len,
+        const std::string& file_name,
+        uint64_t offset) {
+    char* current = buf;
+    size_t remain_len = len;
+    OLAP_CACHE_STRING_TO_BUF(current, file_name, remain_len);
+    OLAP_CACHE_NUMERIC_TO_BUF(current, offset, remain_len);
+
+    return CacheKey(buf, len - remain_len);
+}
+
+void ReadOnlyFileStream::_delete_cached_page(const CacheKey& key, void* value) {
+    char* buffer = reinterpret_cast<char*>(value);
+    SAFE_DELETE_ARRAY(buffer);
+}
+
 uint64_t ReadOnlyFileStream::available() {
     return _file_cursor.remain();
 }
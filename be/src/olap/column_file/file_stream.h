@@ -27,6 +27,7 @@
 #include "olap/column_file/compress.h"
 #include "olap/column_file/stream_index_reader.h"
 #include "olap/file_helper.h"
+#include "olap/lru_cache.h"
 #include "olap/olap_common.h"
 
 namespace palo {
@@ -81,6 +82,12 @@ public:
         _file_cursor.reset(offset, length);
     }
 
+    // 设置缓存解压后数据块的cache, 为NULL时不使用cache。
+    // 只缓存压缩过的数据块, 未压缩的数据块直接由page cache服务
+    void set_page_cache(Cache* page_cache) {
+        _page_cache = page_cache;
+    }
+
     // 从数据流中读取一个字节,内部指针后移
     // 如果数据流结束, 返回OLAP_ERR_COLUMN_STREAM_EOF
     inline OLAPStatus read(char* byte);
@@ -129,7 +136,8 @@ private:
                 _file_handler(file_handler),
                 _offset(offset),
                 _length(length),
-                _used(0) {
+                _used(0),
+                _read_ahead_end(0) {
         }
 
         ~FileCursor() {}
@@ -138,6 +146,29 @@ private:
             _offset = offset;
             _length = length;
             _used = 0;
+            _read_ahead_end = 0;
+        }
+
+        // 当剩余的已预读数据不足window的一半时，预读当前位置之后的window字节。
+        // 预读失败不影响正常的读取
+        void read_ahead(size_t window) {
+            if (0 == window || _used + window / 2 < _read_ahead_end) {
+                return;
+            }
+
+            // seek之后_used可能不在已预读的范围内
+            size_t start = _used;
+            if (_read_ahead_end > _used && _read_ahead_end <= _used + window) {
+                start = _read_ahead_end;
+            }
+
+            size_t end = std::min(_used + window, _length);
+            if (start >= end) {
+                return;
+            }
+
+            _file_handler->read_ahead(end - start, start + _offset);
+            _read_ahead_end = end;
         }
 
         OLAPStatus read(char* out_buffer, size_t length) {
@@ -177,6 +208,21 @@ private:
             return _length;
         }
 
+        // offset of the current position in the file, for a region of a packed file
+        // opened with FileHandler::open_region_with_cache() it's relative to the region
+        size_t file_offset() {
+            return _offset + _used;
+        }
+
+        // offset of the region in the packed file, 0 for a file of its own
+        size_t region_offset() {
+            return _file_handler->region_offset();
+        }
+
+        const std::string& file_name() {
+            return _file_handler->file_name();
+        }
+
         inline bool eof() {
             return _used == _length;
         }
@@ -194,11 +240,28 @@ private:
         size_t _offset; // start from where
         size_t _length; // length limit
         size_t _used;
+        size_t _read_ahead_end; // end of the range already prefetched
+    };
+
+    // cache中的一个数据块, 解压后的数据紧跟在结构体之后
+    struct CachedPage {
+        uint64_t chunk_length; // length of the chunk in file, including StreamHead
+        uint64_t size;         // length of the uncompressed data
     };
 
     OLAPStatus _assure_data();
     OLAPStatus _fill_compressed(size_t length);
 
+    // 从cache中读取当前位置的数据块, 命中时返回true, 并把file cursor移到下一个数据块
+    bool _load_from_page_cache(const CacheKey& key, size_t file_cursor_used);
+    void _insert_page_cache(const CacheKey& key, uint64_t chunk_length);
+
+    static CacheKey _construct_page_key(char* buf,
+            size_t len,
+            const std::string& file_name,
+            uint64_t offset);
+    static void _delete_cached_page(const CacheKey& key, void* value);
+
     FileCursor _file_cursor;
     ByteBuffer* _compressed_helper;
     ByteBuffer* _uncompressed;
@@ -207,6 +270,7 @@ private:
     Decompressor _decompressor;
     size_t _compress_buffer_size;
     size_t _current_compress_position;
+    Cache* _page_cache;
 
     DISALLOW_COPY_AND_ASSIGN(ReadOnlyFileStream);
 };
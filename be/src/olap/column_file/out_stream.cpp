@@ -15,6 +15,9 @@
 
 #include "olap/column_file/out_stream.h"
 
+#include <algorithm>
+
+#include "common/config.h"
 #include "olap/column_file/byte_buffer.h"
 #include "olap/file_helper.h"
 #include "olap/utils.h"
@@ -23,25 +26,68 @@
 namespace palo {
 namespace column_file {
 
+// 缓存释放的流缓冲区, 避免每个数据块都重新分配内存.
+// 只缓存与capacity大小相同的缓冲区, 总大小不超过config::column_stream_buffer_pool_mb
+static MutexLock s_stream_buffer_pool_lock;
+static std::vector<ByteBuffer*> s_stream_buffer_pool;
+
+static ByteBuffer* acquire_stream_buffer(uint64_t capacity) {
+    {
+        AutoMutexLock auto_lock(&s_stream_buffer_pool_lock);
+        if (!s_stream_buffer_pool.empty()
+                && s_stream_buffer_pool.back()->capacity() == capacity) {
+            ByteBuffer* buf = s_stream_buffer_pool.back();
+            s_stream_buffer_pool.pop_back();
+            buf->set_limit(capacity);
+            buf->set_position(0);
+            return buf;
+        }
+    }
+
+    return ByteBuffer::create(capacity);
+}
+
+static void release_stream_buffer(ByteBuffer* buf) {
+    if (NULL == buf) {
+        return;
+    }
+
+    {
+        AutoMutexLock auto_lock(&s_stream_buffer_pool_lock);
+        uint64_t max_pool_size = config::column_stream_buffer_pool_mb * 1024L * 1024L;
+        if ((s_stream_buffer_pool.empty()
+                    || s_stream_buffer_pool.back()->capacity() == buf->capacity())
+                && (s_stream_buffer_pool.size() + 1) * buf->capacity() <= max_pool_size) {
+            s_stream_buffer_pool.push_back(buf);
+            return;
+        }
+    }
+
+    delete buf;
+}
+
 OutStreamFactory::OutStreamFactory(CompressKind compress_kind, uint32_t stream_buffer_size) : 
         _compress_kind(compress_kind),
         _stream_buffer_size(stream_buffer_size) {
-    switch (compress_kind) {
-    case COMPRESS_NONE:
+    if (OLAP_SUCCESS != get_compressor(compress_kind, 0, &_compressor)) {
+        OLAP_LOG_FATAL("unknown compress kind. [kind=%d]", compress_kind);
         _compressor = NULL;
-        break;
-
-    case COMPRESS_LZO:
-        _compressor = lzo_compress;
-        break;
-
-    case COMPRESS_LZ4:
-        _compressor = lz4_compress;
-        break;
+    }
+}
 
-    default:
-        OLAP_LOG_FATAL("unknown compress kind. [kind=%d]", compress_kind);
+OLAPStatus OutStreamFactory::set_column_compress_kind(uint32_t column_unique_id,
+                                                      CompressKind compress_kind,
+                                                      int compress_level) {
+    Compressor compressor = NULL;
+    OLAPStatus res = get_compressor(compress_kind, compress_level, &compressor);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to get compressor of column. [column_unique_id=%u kind=%d]",
+                         column_unique_id, compress_kind);
+        return res;
     }
+
+    _column_compressors[column_unique_id] = std::make_pair(compress_kind, compressor);
+    return OLAP_SUCCESS;
 }
 
 OutStreamFactory::~OutStreamFactory() {
@@ -55,8 +101,16 @@ OutStream* OutStreamFactory::create_stream(
         uint32_t column_unique_id, StreamInfoMessage::Kind kind) {
     OutStream* stream = NULL;
 
-    if (StreamInfoMessage::ROW_INDEX == kind || StreamInfoMessage::BLOOM_FILTER == kind) {
+    bool is_index = StreamInfoMessage::ROW_INDEX == kind
+            || StreamInfoMessage::BLOOM_FILTER == kind
+            || StreamInfoMessage::BITMAP_INDEX == kind;
+    std::map<uint32_t, std::pair<CompressKind, Compressor> >::const_iterator column_it =
+            _column_compressors.find(column_unique_id);
+
+    if (is_index) {
         stream = new(std::nothrow) OutStream(_stream_buffer_size, NULL);
+    } else if (column_it != _column_compressors.end()) {
+        stream = new(std::nothrow) OutStream(_stream_buffer_size, column_it->second.second);
     } else {
         stream = new(std::nothrow) OutStream(_stream_buffer_size, _compressor);
     }
@@ -66,6 +120,16 @@ OutStream* OutStreamFactory::create_stream(
         return NULL;
     }
 
+    // 索引流的数据块都不压缩, 读取时与压缩类型无关
+    if (!is_index && column_it != _column_compressors.end()) {
+        stream->set_compress_kind(column_it->second.first);
+    } else {
+        stream->set_compress_kind(_compress_kind);
+        if (!is_index && NULL != _compressor && config::enable_adaptive_compress) {
+            stream->set_adaptive_compress();
+        }
+    }
+
     StreamName stream_name(column_unique_id, kind);
     _streams[stream_name] = stream;
     return stream;
@@ -74,6 +138,8 @@ OutStream* OutStreamFactory::create_stream(
 OutStream::OutStream(uint32_t buffer_size, Compressor compressor) : 
         _buffer_size(buffer_size),
         _compressor(compressor),
+        _compress_kind(COMPRESS_NONE),
+        _is_adaptive_compress(false),
         _is_suppressed(false),
         _current(NULL),
         _compressed(NULL),
@@ -81,19 +147,19 @@ OutStream::OutStream(uint32_t buffer_size, Compressor compressor) :
         _spilled_bytes(0) {}
 
 OutStream::~OutStream() {
-    SAFE_DELETE(_current);
-    SAFE_DELETE(_compressed);
-    SAFE_DELETE(_overflow);
+    release_stream_buffer(_current);
+    release_stream_buffer(_compressed);
+    release_stream_buffer(_overflow);
 
     for (std::vector<ByteBuffer*>::iterator it = _output_buffers.begin();
             it != _output_buffers.end(); ++it) {
-        SAFE_DELETE(*it);
+        release_stream_buffer(*it);
     }
 }
 
 OLAPStatus OutStream::_create_new_input_buffer() {
-    SAFE_DELETE(_current);
-    _current = ByteBuffer::create(_buffer_size + sizeof(StreamHead));
+    release_stream_buffer(_current);
+    _current = acquire_stream_buffer(_buffer_size + sizeof(StreamHead));
 
     if (NULL != _current) {
         _current->set_position(sizeof(StreamHead));
@@ -164,7 +230,7 @@ void OutStream::_output_compressed() {
 
 OLAPStatus OutStream::_make_sure_output_buffer() {
     if (NULL == _compressed) {
-        _compressed = ByteBuffer::create(_buffer_size + sizeof(StreamHead));
+        _compressed = acquire_stream_buffer(_buffer_size + sizeof(StreamHead));
 
         if (NULL == _compressed) {
             return OLAP_ERR_MALLOC_ERROR;
@@ -172,7 +238,7 @@ OLAPStatus OutStream::_make_sure_output_buffer() {
     }
 
     if (NULL == _overflow) {
-        _overflow = ByteBuffer::create(_buffer_size + sizeof(StreamHead));
+        _overflow = acquire_stream_buffer(_buffer_size + sizeof(StreamHead));
 
         if (NULL == _overflow) {
             return OLAP_ERR_MALLOC_ERROR;
@@ -189,6 +255,11 @@ OLAPStatus OutStream::_spill() {
         return OLAP_SUCCESS;
     }
 
+    if (_is_adaptive_compress) {
+        _is_adaptive_compress = false;
+        _choose_compressor();
+    }
+
     // 如果不压缩，直接读取current，注意output之后 current会被清空并设置为NULL
     if (_compressor == NULL) {
         _current->flip();
@@ -250,6 +321,72 @@ OLAPStatus OutStream::_spill() {
     return OLAP_SUCCESS;
 }
 
+// 用第一个数据块采样, 选出解压速度满足要求的压缩方式中压缩率最高的一个。
+// 都不满足时保持原来的压缩方式
+void OutStream::_choose_compressor() {
+    static const CompressKind CANDIDATES[] = {COMPRESS_LZ4, COMPRESS_LZO, COMPRESS_ZSTD};
+    // 数据块较小, 多次解压以减少计时误差
+    static const int DECOMPRESS_TIMES = 4;
+
+    ByteBuffer* compressed = ByteBuffer::create(_buffer_size + sizeof(StreamHead));
+    ByteBuffer* uncompressed = ByteBuffer::create(_buffer_size + sizeof(StreamHead));
+    if (NULL == compressed || NULL == uncompressed) {
+        SAFE_DELETE(compressed);
+        SAFE_DELETE(uncompressed);
+        return;
+    }
+
+    uint64_t position = _current->position();
+    uint64_t input_length = position - sizeof(StreamHead);
+    uint64_t best_length = input_length;
+
+    for (size_t i = 0; i < sizeof(CANDIDATES) / sizeof(CANDIDATES[0]); ++i) {
+        Compressor compressor = NULL;
+        Decompressor decompressor = NULL;
+        if (OLAP_SUCCESS != get_compressor(CANDIDATES[i], 0, &compressor)
+                || OLAP_SUCCESS != get_decompressor(CANDIDATES[i], &decompressor)) {
+            continue;
+        }
+
+        _current->set_limit(position);
+        _current->set_position(sizeof(StreamHead));
+        compressed->set_limit(compressed->capacity());
+        compressed->set_position(0);
+        bool smaller = false;
+        if (OLAP_SUCCESS != compressor(_current, compressed, &smaller) || !smaller) {
+            continue;
+        }
+        uint64_t compressed_length = compressed->position();
+        compressed->flip();
+
+        OlapStopWatch watch;
+        bool is_decompressed = true;
+        for (int j = 0; j < DECOMPRESS_TIMES && is_decompressed; ++j) {
+            compressed->set_position(0);
+            uncompressed->set_limit(uncompressed->capacity());
+            uncompressed->set_position(0);
+            is_decompressed = (OLAP_SUCCESS == decompressor(compressed, uncompressed));
+        }
+        // 每微秒解压的字节数即MB/s
+        uint64_t elapse_us = std::max(watch.get_elapse_time_us(), static_cast<uint64_t>(1));
+        uint64_t mb_per_sec = input_length * DECOMPRESS_TIMES / elapse_us;
+
+        if (is_decompressed
+                && mb_per_sec >= static_cast<uint64_t>(
+                        config::adaptive_compress_min_decompress_mb_per_sec)
+                && compressed_length < best_length) {
+            best_length = compressed_length;
+            _compressor = compressor;
+            _compress_kind = CANDIDATES[i];
+        }
+    }
+
+    _current->set_limit(_current->capacity());
+    _current->set_position(position);
+    SAFE_DELETE(compressed);
+    SAFE_DELETE(uncompressed);
+}
+
 OLAPStatus OutStream::write(char byte) {
     OLAPStatus res = OLAP_SUCCESS;
 
@@ -421,11 +558,14 @@ OLAPStatus OutStream::flush() {
 
     if (NULL != _compressed && 0 != _compressed->position()) {
         _output_compressed();
-        SAFE_DELETE(_compressed);
+        release_stream_buffer(_compressed);
+        _compressed = NULL;
     }
 
-    SAFE_DELETE(_current);
-    SAFE_DELETE(_overflow);
+    release_stream_buffer(_current);
+    _current = NULL;
+    release_stream_buffer(_overflow);
+    _overflow = NULL;
 
     return res;
 }
@@ -78,6 +78,19 @@ public:
     OLAPStatus flush();
     // 计算输出数据的crc32值
     uint32_t crc32(uint32_t checksum) const;
+
+    // 压缩类型, 与segment的压缩类型不同时写入StreamInfoMessage
+    CompressKind compress_kind() const {
+        return _compress_kind;
+    }
+    void set_compress_kind(CompressKind compress_kind) {
+        _compress_kind = compress_kind;
+    }
+
+    // 输出第一个数据块时, 用它采样选择压缩方式, 见config::enable_adaptive_compress
+    void set_adaptive_compress() {
+        _is_adaptive_compress = true;
+    }
     const std::vector<ByteBuffer*>& output_buffers() {
         return _output_buffers;
     }
@@ -104,9 +117,12 @@ private:
     void _output_uncompress();
     void _output_compressed();
     OLAPStatus _make_sure_output_buffer();
+    void _choose_compressor();
 
     uint32_t _buffer_size;                   // 压缩块大小
     Compressor _compressor;                  // 压缩函数,如果为NULL表示不压缩
+    CompressKind _compress_kind;             // _compressor对应的压缩类型
+    bool _is_adaptive_compress;              // 是否还需要采样选择压缩方式
     std::vector<ByteBuffer*> _output_buffers;// 缓冲所有的输出
     bool _is_suppressed;                     // 流是否被终止
     ByteBuffer* _current;                    // 缓存未压缩的数据
@@ -128,6 +144,11 @@ public:
     // 创建后的stream的生命期依旧由OutStreamFactory管理
     OutStream* create_stream(uint32_t column_unique_id, StreamInfoMessage::Kind kind);
 
+    // 指定列的数据流使用的压缩方式, 需要在创建该列的流之前调用
+    OLAPStatus set_column_compress_kind(uint32_t column_unique_id,
+                                        CompressKind compress_kind,
+                                        int compress_level);
+
     const std::map<StreamName, OutStream*>& streams() const {
         return _streams;
     }
@@ -135,6 +156,8 @@ private:
     std::map<StreamName, OutStream*> _streams; // 所有创建过的流
     CompressKind _compress_kind;
     Compressor _compressor;
+    // 单独指定了压缩方式的列
+    std::map<uint32_t, std::pair<CompressKind, Compressor> > _column_compressors;
     uint32_t _stream_buffer_size;
 
     DISALLOW_COPY_AND_ASSIGN(OutStreamFactory);
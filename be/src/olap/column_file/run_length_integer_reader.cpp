@@ -408,6 +408,30 @@ OLAPStatus RunLengthIntegerReader::seek(PositionProvider* position) {
     return res;
 }
 
+OLAPStatus RunLengthIntegerReader::next(int64_t* values, uint64_t count) {
+    OLAPStatus res = OLAP_SUCCESS;
+
+    while (count > 0) {
+        if (_used == _num_literals) {
+            _num_literals = 0;
+            _used = 0;
+
+            res = _read_values();
+            if (OLAP_SUCCESS != res) {
+                return res;
+            }
+        }
+
+        uint64_t consume = std::min(count, static_cast<uint64_t>(_num_literals - _used));
+        memcpy(values, &_literals[_used], consume * sizeof(int64_t));
+        _used += consume;
+        values += consume;
+        count -= consume;
+    }
+
+    return res;
+}
+
 OLAPStatus RunLengthIntegerReader::skip(uint64_t num_values) {
     OLAPStatus res = OLAP_SUCCESS;
 
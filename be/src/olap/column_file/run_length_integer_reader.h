@@ -51,6 +51,8 @@ public:
         *value = _literals[_used++];
         return res;
     }
+    // 批量获取count条数据, 供向量化读取使用; 数据不足时返回读取失败的错误码
+    OLAPStatus next(int64_t* values, uint64_t count);
     OLAPStatus seek(PositionProvider* position);
     OLAPStatus skip(uint64_t num_values);
 
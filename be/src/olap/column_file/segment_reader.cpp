@@ -17,8 +17,10 @@
 
 #include <sys/mman.h>
 
+#include <algorithm>
 #include <istream>
 
+#include "common/config.h"
 #include "olap/column_file/file_stream.h"
 #include "olap/column_file/in_stream.h"
 #include "olap/column_file/out_stream.h"
@@ -64,6 +66,11 @@ SegmentReader::SegmentReader(
         _buffer_size(0),
         _lru_cache(NULL),
         _cache_handle(NULL),
+        _data_page_cache(NULL),
+        _block_selection_active(false),
+        _pending_skip_rows(0),
+        _has_bitmap_selection(false),
+        _deleted_rows(NULL),
         _vectorized_info_inited(false),
         _runtime_state(runtime_state),
         _shared_buffer(NULL) {
@@ -84,6 +91,11 @@ SegmentReader::~SegmentReader() {
         SAFE_DELETE(bf_it->second);
     }
 
+    std::map<ColumnId, BitmapIndexReader*>::iterator bitmap_it = _bitmap_indices.begin();
+    for (; bitmap_it != _bitmap_indices.end(); ++bitmap_it) {
+        SAFE_DELETE(bitmap_it->second);
+    }
+
     for (int32_t i = 0; i < _get_included_row_index_stream_num(); i++) {
         if (NULL != _cache_handle[i]) {
             _lru_cache->release(_cache_handle[i]);
@@ -133,7 +145,8 @@ OLAPStatus SegmentReader::_check_file_version() {
 OLAPStatus SegmentReader::_load_segment_file() {
     OLAPStatus res = OLAP_SUCCESS;
 
-    res = _file_handler.open_with_cache(_file_name, O_RDONLY);
+    // 打包的版本从打包文件中对应的一段读取
+    res = _olap_index->open_segment_file(_segment_id, false, &_file_handler);
     if (OLAP_SUCCESS != res) {
         OLAP_LOG_WARNING("fail to open segment file. [file='%s']", _file_name.c_str());
         return res;
@@ -165,27 +178,10 @@ OLAPStatus SegmentReader::_load_segment_file() {
 }
 
 OLAPStatus SegmentReader::_set_decompressor() {
-    switch (_header_message().compress_kind()) {
-    case COMPRESS_NONE: {
-        _decompressor = NULL;
-        break;
-    }
-
-    case COMPRESS_LZO: {
-        _decompressor = lzo_decompress;
-        break;
-    }
-
-    case COMPRESS_LZ4: {
-        _decompressor = lz4_decompress;
-        break;
-    }
-
-    default: {
+    if (OLAP_SUCCESS != get_decompressor(_header_message().compress_kind(), &_decompressor)) {
         OLAP_LOG_WARNING("unknown decompressor");
         return OLAP_ERR_PARSE_PROTOBUF_ERROR;
     }
-    }
 
     return OLAP_SUCCESS;
 }
@@ -286,6 +282,13 @@ OLAPStatus SegmentReader::init(bool is_using_cache) {
         return res;
     }
 
+    // 查询可以通过disable_data_page_cache避免大范围扫描把热数据换出cache
+    if (is_using_cache
+            && (NULL == _runtime_state
+                || !_runtime_state->query_options().disable_data_page_cache)) {
+        _data_page_cache = OLAPEngine::get_instance()->data_page_lru_cache();
+    }
+
     timer.reset();
     res = _load_index(is_using_cache);
     if (OLAP_SUCCESS != res) {
@@ -294,6 +297,9 @@ OLAPStatus SegmentReader::init(bool is_using_cache) {
     }
 
     uint64_t load_index_stream_time_us = timer.get_elapse_time_us();
+
+    // 依赖_load_index加载的bitmap索引, 能由bitmap索引求值的条件不再延迟物化
+    _init_late_materialization();
     // record segment init step time when more than 100ms
     if (load_segment_time_us > 100000 || load_index_stream_time_us > 100000) {
         OLAP_LOG_WARNING("segment init cost too much time. "
@@ -323,6 +329,8 @@ OLAPStatus SegmentReader::seek_to_block(
             return res;
         }
 
+        _init_code_filters();
+
         if (_runtime_state != NULL) {
             MemTracker::update_limits(_buffer_size, _runtime_state->mem_trackers());
             if (MemTracker::limit_exceeded(*_runtime_state->mem_trackers())) {
@@ -346,6 +354,8 @@ OLAPStatus SegmentReader::seek_to_block(
     }
 
     _current_row = first_block * _num_rows_in_block;
+    _block_selection_active = false;
+    _pending_skip_rows = 0;
     OLAP_LOG_DEBUG("first %u end %u; tol %u",
         first_block, last_block,
         _block_count);
@@ -383,8 +393,10 @@ const RowCursor* SegmentReader::get_next_row(bool without_filter) {
             break;
         }
 
+        uint64_t condition_mask = _partial_delete_conditions.empty()
+                ? ~0UL : _partial_delete_conditions[_current_block];
         bool row_del_filter = _delete_handler.is_filter_data(
-                                    _olap_index->version().second, _cursor);
+                                    _olap_index->version().second, _cursor, condition_mask);
         if (false == row_del_filter) {
             ret = &_cursor;
             break;
@@ -395,6 +407,66 @@ const RowCursor* SegmentReader::get_next_row(bool without_filter) {
     return ret;
 }
 
+OLAPStatus SegmentReader::get_next_block(VectorizedRowBatch* batch, uint32_t* rows_read) {
+    *rows_read = 0;
+
+    uint64_t num_rows = _header_message().number_of_rows();
+    if (_eof || _current_row >= num_rows || _current_row % _num_rows_in_block == 0) {
+        return OLAP_SUCCESS;
+    }
+
+    if (NULL != _include_blocks && DEL_NOT_SATISFIED != _include_blocks[_current_block]) {
+        return OLAP_SUCCESS;
+    }
+
+    // block中有被条件过滤的行时, 由get_next_row逐行跳过
+    if (_block_selection_active) {
+        return OLAP_SUCCESS;
+    }
+
+    uint64_t size = _num_rows_in_block - _current_row % _num_rows_in_block;
+    size = std::min(size, num_rows - _current_row);
+    size = std::min(size, static_cast<uint64_t>(batch->capacity() - batch->size()));
+    if (0 == size) {
+        return OLAP_SUCCESS;
+    }
+
+    uint32_t start = batch->size();
+    for (size_t i = 0; i < _column_readers.size(); ++i) {
+        ColumnVector* column_vector = batch->column(i);
+        OLAPStatus res = _column_readers[i]->next_batch(
+                column_vector, start, size, batch->mem_pool());
+        if (OLAP_ERR_FUNC_NOT_IMPLEMENTED == res) {
+            // 例如DefaultValueReader, 逐行attach到cursor后再写入
+            for (uint32_t j = 0; j < size; ++j) {
+                res = _column_readers[i]->next();
+                if (OLAP_SUCCESS == res) {
+                    res = _column_readers[i]->attach(&_cursor);
+                }
+                if (OLAP_SUCCESS == res) {
+                    res = _cursor.write_to_vector(_return_columns[i], column_vector,
+                                                  start + j, batch->mem_pool());
+                }
+                if (OLAP_SUCCESS != res) {
+                    break;
+                }
+            }
+        }
+
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to read column batch. [res=%d column_unique_id=%u]",
+                    res, _column_readers[i]->column_unique_id());
+            return res;
+        }
+    }
+
+    _current_row += size;
+    batch->set_size(start + size);
+    *rows_read = size;
+
+    return OLAP_SUCCESS;
+}
+
 void SegmentReader::_set_column_map() {
     _encodings_map.clear();
     _table_id_to_unique_id_map.clear();
@@ -440,6 +512,7 @@ OLAPStatus SegmentReader::_pick_columns() {
 
     _include_columns.clear();
     _include_bf_columns.clear();
+    _include_bitmap_columns.clear();
 
     for (uint32_t i : _return_columns) {
         ColumnId unique_column_id = _table_id_to_unique_id_map[i];
@@ -451,9 +524,39 @@ OLAPStatus SegmentReader::_pick_columns() {
         _include_bf_columns.insert(unique_column_id);
     }
 
+    if (config::bitmap_index_max_cardinality > 0 && NULL != _conditions) {
+        for (auto& it : _conditions->columns()) {
+            if (!_is_row_filter_allowed(it.second) || !_is_bitmap_answerable(it.second)) {
+                continue;
+            }
+
+            ColumnId unique_column_id = _table_id_to_unique_id_map[it.first];
+            _include_bitmap_columns.insert(unique_column_id);
+        }
+    }
+
     return OLAP_SUCCESS;
 }
 
+bool SegmentReader::_is_row_filter_allowed(const CondColumn& cond_column) const {
+    // 非DUP_KEYS的表在合并前不能按value列过滤, 否则会丢掉需要被合并的行
+    return _table->keys_type() == KeysType::DUP_KEYS || cond_column.is_key();
+}
+
+bool SegmentReader::_is_bitmap_answerable(const CondColumn& cond_column) const {
+    if (cond_column.conds().empty()) {
+        return false;
+    }
+
+    for (const Cond& cond : cond_column.conds()) {
+        if (OP_EQ != cond.op && OP_IN != cond.op && OP_IS != cond.op) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 OLAPStatus SegmentReader::_pick_delete_row_groups(uint32_t first_block, uint32_t last_block) {
     OLAP_LOG_DEBUG("pick for %u to %u for delete_condition", first_block, last_block);
 
@@ -466,7 +569,12 @@ OLAPStatus SegmentReader::_pick_delete_row_groups(uint32_t first_block, uint32_t
         return OLAP_SUCCESS;
     }
 
-    for (auto& delete_condition : _delete_handler.get_delete_conditions()) {
+    _partial_delete_conditions.assign(_block_count, 0);
+
+    const std::vector<DeleteConditions>& delete_conditions =
+            _delete_handler.get_delete_conditions();
+    for (size_t k = 0; k < delete_conditions.size(); ++k) {
+        const DeleteConditions& delete_condition = delete_conditions[k];
         if (delete_condition.filter_version <= _olap_index->version().first) {
             continue;
         }
@@ -507,6 +615,9 @@ OLAPStatus SegmentReader::_pick_delete_row_groups(uint32_t first_block, uint32_t
                 }
             } else if (true == del_partial_satisfied) {
                 _include_blocks[j] = DEL_PARTIAL_SATISFIED;
+                if (k < DeleteHandler::MAX_MASKED_CONDITIONS) {
+                    _partial_delete_conditions[j] |= (1UL << k);
+                }
                 OLAP_LOG_DEBUG("filter block partially: %d", j);
             } else {
                 _include_blocks[j] = DEL_SATISFIED;
@@ -557,7 +668,9 @@ OLAPStatus SegmentReader::_pick_row_groups(uint32_t first_block, uint32_t last_b
 
     _pick_delete_row_groups(first_block, last_block);
 
+    _has_bitmap_selection = false;
     if (NULL == _conditions || _conditions->columns().size() == 0) {
+        _pick_undeleted_rows(first_block, last_block);
         return OLAP_SUCCESS;
     }
 
@@ -587,15 +700,22 @@ OLAPStatus SegmentReader::_pick_row_groups(uint32_t first_block, uint32_t last_b
             if (!i.second.eval(index_reader->entry(j).column_statistic())) {
                 _include_blocks[j] = DEL_SATISFIED;
                 --_remain_block;
-            }
-            if (j < _block_count - 1) {
-                _filted_rows += _num_rows_in_block; 
-            } else {
-                _filted_rows += _header_message().number_of_rows() - j * _num_rows_in_block;
+                if (j < _block_count - 1) {
+                    _filted_rows += _num_rows_in_block;
+                } else {
+                    _filted_rows += _header_message().number_of_rows() - j * _num_rows_in_block;
+                }
             }
         }
     }
 
+    res = _pick_bitmap_rows(first_block, last_block);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to pick rows by bitmap index. [res=%d]", res);
+        return res;
+    }
+    _pick_undeleted_rows(first_block, last_block);
+
     if (_remain_block < MIN_FILTER_BLOCK_NUM) {
         OLAP_LOG_DEBUG("bloom filter is ignored for too few block remained. "
                        "[remain_block=%u const_time=%lu]",
@@ -641,15 +761,116 @@ OLAPStatus SegmentReader::_pick_row_groups(uint32_t first_block, uint32_t last_b
     return OLAP_SUCCESS;
 }
 
+OLAPStatus SegmentReader::_pick_bitmap_rows(uint32_t first_block, uint32_t last_block) {
+    _has_bitmap_selection = false;
+    if (_bitmap_indices.empty()) {
+        return OLAP_SUCCESS;
+    }
+
+    uint64_t row_count = _header_message().number_of_rows();
+    _bitmap_selection.init(row_count, true);
+
+    RowBitmap cond_rows;
+    for (auto& it : _conditions->columns()) {
+        ColumnId unique_column_id = _table_id_to_unique_id_map[it.first];
+        std::map<ColumnId, BitmapIndexReader*>::const_iterator bitmap_it
+                = _bitmap_indices.find(unique_column_id);
+        if (_bitmap_indices.end() == bitmap_it) {
+            continue;
+        }
+
+        const BitmapIndexReader* bitmap_reader = bitmap_it->second;
+        for (const Cond& cond : it.second.conds()) {
+            OLAPStatus res = OLAP_SUCCESS;
+            cond_rows.init(row_count, false);
+            if (OP_IS == cond.op) {
+                // IS NOT NULL取null行的补集
+                res = bitmap_reader->add_null_rows(&cond_rows);
+                if (!cond.operand_field->is_null()) {
+                    cond_rows.flip();
+                }
+            } else if (OP_IN == cond.op) {
+                for (const Field* operand : cond.operand_set) {
+                    // 任何值和NULL比较都不满足条件
+                    if (operand->is_null()) {
+                        continue;
+                    }
+
+                    res = bitmap_reader->add_rows(operand, &cond_rows);
+                    if (OLAP_SUCCESS != res) {
+                        break;
+                    }
+                }
+            } else if (!cond.operand_field->is_null()) {
+                res = bitmap_reader->add_rows(cond.operand_field, &cond_rows);
+            }
+
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to read bitmap index. [res=%d column_unique_id=%u]",
+                                 res, unique_column_id);
+                return res;
+            }
+
+            _bitmap_selection.intersect(cond_rows);
+        }
+        _has_bitmap_selection = true;
+    }
+
+    if (_has_bitmap_selection) {
+        _exclude_unselected_blocks(first_block, last_block);
+    }
+
+    return OLAP_SUCCESS;
+}
+
+void SegmentReader::_pick_undeleted_rows(uint32_t first_block, uint32_t last_block) {
+    if (NULL == _deleted_rows || _deleted_rows->empty()) {
+        return;
+    }
+
+    uint64_t row_count = _header_message().number_of_rows();
+    if (!_has_bitmap_selection) {
+        _bitmap_selection.init(row_count, true);
+        _has_bitmap_selection = true;
+    }
+
+    for (uint64_t row : *_deleted_rows) {
+        if (row < row_count) {
+            _bitmap_selection.reset(row);
+        }
+    }
+
+    _exclude_unselected_blocks(first_block, last_block);
+}
+
+void SegmentReader::_exclude_unselected_blocks(uint32_t first_block, uint32_t last_block) {
+    uint64_t row_count = _header_message().number_of_rows();
+    for (int64_t j = first_block; j <= last_block; ++j) {
+        if (_include_blocks[j] == DEL_SATISFIED) {
+            continue;
+        }
+
+        uint64_t block_start = j * _num_rows_in_block;
+        uint64_t block_end = std::min(block_start + _num_rows_in_block, row_count);
+        if (!_bitmap_selection.any(block_start, block_end)) {
+            _include_blocks[j] = DEL_SATISFIED;
+            --_remain_block;
+            _filted_rows += block_end - block_start;
+        }
+    }
+}
+
 CacheKey SegmentReader::_construct_index_stream_key(
         char* buf,
         size_t len,
         const std::string& file_name,
+        uint64_t region_offset,
         ColumnId unique_column_id,
         StreamInfoMessage::Kind kind) {
     char* current = buf;
     size_t remain_len = len;
     OLAP_CACHE_STRING_TO_BUF(current, file_name, remain_len);
+    OLAP_CACHE_NUMERIC_TO_BUF(current, region_offset, remain_len);
     OLAP_CACHE_NUMERIC_TO_BUF(current, unique_column_id, remain_len);
     OLAP_CACHE_NUMERIC_TO_BUF(current, kind, remain_len);
 
@@ -661,6 +882,28 @@ void SegmentReader::_delete_cached_index_stream(const CacheKey& key, void* value
     SAFE_DELETE_ARRAY(buffer);
 }
 
+void SegmentReader::evict_index_streams(const std::string& file_name,
+                                        uint64_t region_offset,
+                                        const std::vector<ColumnId>& unique_column_ids) {
+    Cache* lru_cache = OLAPEngine::get_instance()->index_stream_lru_cache();
+    if (NULL == lru_cache) {
+        return;
+    }
+
+    const StreamInfoMessage::Kind kinds[] = {
+        StreamInfoMessage::ROW_INDEX,
+        StreamInfoMessage::BLOOM_FILTER,
+        StreamInfoMessage::BITMAP_INDEX
+    };
+    char key_buf[OLAP_LRU_CACHE_MAX_KEY_LENTH];
+    for (ColumnId unique_column_id : unique_column_ids) {
+        for (StreamInfoMessage::Kind kind : kinds) {
+            lru_cache->erase(_construct_index_stream_key(
+                    key_buf, sizeof(key_buf), file_name, region_offset, unique_column_id, kind));
+        }
+    }
+}
+
 OLAPStatus SegmentReader::_load_index(bool is_using_cache) {
     OLAPStatus res = OLAP_SUCCESS;
 
@@ -683,6 +926,7 @@ OLAPStatus SegmentReader::_load_index(bool is_using_cache) {
 
     _indices.clear();
     _bloom_filters.clear();
+    _bitmap_indices.clear();
     uint64_t stream_length = 0;
     int32_t cache_handle_index = 0;
     uint64_t stream_offset = _header_length;
@@ -701,11 +945,7 @@ OLAPStatus SegmentReader::_load_index(bool is_using_cache) {
             continue;
         }
 
-        if ((_is_column_included(unique_column_id)
-                && message.kind() == StreamInfoMessage::ROW_INDEX)
-                || (_is_bf_column_included(unique_column_id)
-                && message.kind() == StreamInfoMessage::BLOOM_FILTER)) {
-        } else {
+        if (!_is_index_stream_included(unique_column_id, message.kind())) {
             continue;
         }
 
@@ -717,6 +957,7 @@ OLAPStatus SegmentReader::_load_index(bool is_using_cache) {
         CacheKey key = _construct_index_stream_key(key_buf,
                        sizeof(key_buf),
                        _file_handler.file_name(),
+                       _file_handler.region_offset(),
                        unique_column_id,
                        message.kind());
         _cache_handle[cache_handle_index] = _lru_cache->lookup(key);
@@ -773,6 +1014,31 @@ OLAPStatus SegmentReader::_load_index(bool is_using_cache) {
 
             // 每个index的entry数量应该一致, 也就是block的数量
             _block_count = index_message->entry_count();
+        } else if (message.kind() == StreamInfoMessage::BITMAP_INDEX) {
+            BitmapIndexReader* bitmap_message = new(std::nothrow) BitmapIndexReader;
+            if (bitmap_message == NULL) {
+                OLAP_LOG_WARNING("fail to malloc memory. [size=%lu]",
+                                 sizeof(BitmapIndexReader));
+                return OLAP_ERR_MALLOC_ERROR;
+            }
+
+            res = bitmap_message->init(stream_buffer, stream_length, is_using_cache);
+            if (res != OLAP_SUCCESS) {
+                OLAP_LOG_WARNING("fail to init bitmap index reader. [res=%d]", res);
+                SAFE_DELETE(bitmap_message);
+                return res;
+            }
+
+            _bitmap_indices[unique_column_id] = bitmap_message;
+
+            // bitmap索引没有block级的entry, 只需要校验行数
+            if (bitmap_message->row_count() != _header_message().number_of_rows()) {
+                OLAP_LOG_WARNING("something wrong while reading bitmap index, "
+                        "expected=%lu, actual=%lu",
+                        _header_message().number_of_rows(), bitmap_message->row_count());
+                return OLAP_ERR_FILE_FORMAT_ERROR;
+            }
+            continue;
         } else {
             BloomFilterIndexReader* bf_message = new(std::nothrow) BloomFilterIndexReader;
             if (bf_message == NULL) {
@@ -781,8 +1047,17 @@ OLAPStatus SegmentReader::_load_index(bool is_using_cache) {
                 return OLAP_ERR_MALLOC_ERROR;
             }
 
+            bool is_blocked_bf = false;
+            for (int i = 0; i < _header_message().column_size(); ++i) {
+                if (_header_message().column(i).unique_id() == unique_column_id) {
+                    is_blocked_bf = _header_message().column(i).is_blocked_bf();
+                    break;
+                }
+            }
+
             res = bf_message->init(stream_buffer, stream_length, is_using_cache,
-                    _header_message().bf_hash_function_num(), _header_message().bf_bit_num());
+                    _header_message().bf_hash_function_num(), _header_message().bf_bit_num(),
+                    is_blocked_bf);
             if (res != OLAP_SUCCESS) {
                 OLAP_LOG_WARNING("fail to init bloom filter reader. [res=%d]", res);
                 return res;
@@ -875,19 +1150,26 @@ OLAPStatus SegmentReader::_read_all_data_streams(size_t* buffer_size) {
             continue;
         }
 
-        if ((_is_column_included(unique_column_id)
-                && message.kind() == StreamInfoMessage::ROW_INDEX)
-                || (_is_bf_column_included(unique_column_id)
-                && message.kind() == StreamInfoMessage::BLOOM_FILTER)) {
+        if (_is_index_stream_included(unique_column_id, message.kind())
+                || message.kind() == StreamInfoMessage::BITMAP_INDEX) {
             continue;
         } else {
+            // 流可以使用与segment不同的压缩方式
+            Decompressor decompressor = _decompressor;
+            if (message.has_compress_kind()
+                    && OLAP_SUCCESS != get_decompressor(message.compress_kind(), &decompressor)) {
+                OLAP_LOG_WARNING("unknown decompressor of stream. [kind=%d]",
+                                 message.compress_kind());
+                return OLAP_ERR_PARSE_PROTOBUF_ERROR;
+            }
+
             StreamName name(unique_column_id, message.kind());
             ReadOnlyFileStream* stream = new(std::nothrow) ReadOnlyFileStream(
                     &_file_handler,
                     &_shared_buffer,
                     stream_offset,
                     stream_length,
-                    _decompressor,
+                    decompressor,
                     _header_message().stream_buffer_size());
             if (NULL == stream) {
                 OLAP_LOG_WARNING("fail to create stream");
@@ -900,6 +1182,7 @@ OLAPStatus SegmentReader::_read_all_data_streams(size_t* buffer_size) {
                 return res;
             }
 
+            stream->set_page_cache(_data_page_cache);
             _streams[name] = stream;
             *buffer_size += stream->get_buffer_size();
         }
@@ -962,56 +1245,214 @@ OLAPStatus SegmentReader::_create_reader(size_t* buffer_size) {
     return OLAP_SUCCESS;
 }
 
-OLAPStatus SegmentReader::_move_to_next_row(bool without_filter) {
-    if (_current_row >= _header_message().number_of_rows()) {
-        _eof = true;
-        return OLAP_ERR_DATA_EOF;
+void SegmentReader::_init_late_materialization() {
+    _late_conditions.clear();
+    _cond_reader_index.clear();
+
+    if (!config::enable_segment_late_materialization
+            || NULL == _conditions || _conditions->columns().size() == 0) {
+        return;
+    }
+
+    for (auto& it : _conditions->columns()) {
+        if (!_is_row_filter_allowed(it.second)) {
+            continue;
+        }
+
+        // 已经由bitmap索引精确求值的条件不需要再解码条件列
+        if (0 != _bitmap_indices.count(_table_id_to_unique_id_map[it.first])) {
+            continue;
+        }
+
+        std::vector<uint32_t>::const_iterator column_it = std::find(
+                _return_columns.begin(), _return_columns.end(),
+                static_cast<uint32_t>(it.first));
+        if (_return_columns.end() == column_it) {
+            continue;
+        }
+
+        _late_conditions.push_back(&it.second);
+        _cond_reader_index.push_back(column_it - _return_columns.begin());
+    }
+
+    // 所有列都是条件列时, 先读条件列没有收益
+    if (_cond_reader_index.size() >= _return_columns.size()) {
+        _late_conditions.clear();
+        _cond_reader_index.clear();
+    }
+}
+
+void SegmentReader::_init_code_filters() {
+    _cond_use_code.assign(_cond_reader_index.size(), 0);
+    for (size_t i = 0; i < _cond_reader_index.size(); ++i) {
+        ColumnReader* reader = _column_readers[_cond_reader_index[i]];
+        // 只有字典编码的字符串列支持, 其他reader返回OLAP_ERR_FUNC_NOT_IMPLEMENTED
+        OLAPStatus res = reader->init_code_filter(*_late_conditions[i], &_cursor);
+        if (OLAP_SUCCESS == res) {
+            _cond_use_code[i] = 1;
+        } else if (OLAP_ERR_FUNC_NOT_IMPLEMENTED != res) {
+            OLAP_LOG_WARNING("fail to init code filter, evaluate on values instead. "
+                    "[res=%d column=%u]", res, reader->column_unique_id());
+        }
+    }
+    _cursor.reset_buf();
+}
+
+OLAPStatus SegmentReader::_eval_block_conditions(int64_t block_id, bool* has_selected) {
+    OLAPStatus res = OLAP_SUCCESS;
+    uint64_t block_start = block_id * _num_rows_in_block;
+    uint64_t block_rows = std::min(_num_rows_in_block,
+                                   _header_message().number_of_rows() - block_start);
+
+    _row_selection.resize(_num_rows_in_block);
+    uint64_t selected_rows = 0;
+    for (uint64_t row = 0; row < block_rows; ++row) {
+        bool selected = !_has_bitmap_selection || _bitmap_selection.test(block_start + row);
+        if (_cond_reader_index.empty()) {
+            _row_selection[row] = selected ? 1 : 0;
+            selected_rows += selected ? 1 : 0;
+            continue;
+        }
+
+        _cursor.reset_buf();
+        for (size_t i = 0; i < _cond_reader_index.size(); ++i) {
+            ColumnReader* reader = _column_readers[_cond_reader_index[i]];
+            if (0 != _cond_use_code[i]) {
+                bool code_selected = false;
+                res = reader->next_selected(&code_selected);
+                selected = selected && code_selected;
+            } else {
+                res = reader->next();
+                if (OLAP_SUCCESS == res) {
+                    res = reader->attach(&_cursor);
+                }
+            }
+
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to read condition column. [res=%d column=%u]",
+                        res, reader->column_unique_id());
+                return res;
+            }
+        }
+
+        for (size_t i = 0; selected && i < _late_conditions.size(); ++i) {
+            if (0 == _cond_use_code[i] && !_late_conditions[i]->eval(_cursor)) {
+                selected = false;
+                break;
+            }
+        }
+
+        _row_selection[row] = selected ? 1 : 0;
+        selected_rows += selected ? 1 : 0;
     }
 
-    if (_current_row % _num_rows_in_block != 0) {
-        ++_current_row;
+    *has_selected = selected_rows > 0;
+    _block_selection_active = selected_rows < block_rows;
+    if (selected_rows == 0) {
         return OLAP_SUCCESS;
     }
 
-    int64_t next_block = int64_t(_current_row / _num_rows_in_block);
-    if (!without_filter && NULL != _include_blocks && DEL_SATISFIED == _include_blocks[next_block]) {
-        while (next_block < _block_count && DEL_SATISFIED == _include_blocks[next_block]) {
-            ++next_block;
+    // 条件列已经读完整个block, 重新seek到block起始位置, 与其他列保持一致
+    for (size_t i = 0; i < _cond_reader_index.size(); ++i) {
+        size_t index = _cond_reader_index[i];
+        if (NULL == _column_indices[index]) {
+            continue;
+        }
+
+        PositionProvider position(&_column_indices[index]->entry(block_id));
+        res = _column_readers[index]->seek(&position);
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to seek condition column. [res=%d column=%u block_id=%ld]",
+                    res, _column_readers[index]->column_unique_id(), block_id);
+            return OLAP_ERR_COLUMN_SEEK_ERROR;
         }
+    }
+
+    return OLAP_SUCCESS;
+}
 
-        if (next_block >= _block_count) {
+OLAPStatus SegmentReader::_move_to_next_row(bool without_filter) {
+    while (true) {
+        if (_current_row >= _header_message().number_of_rows()) {
             _eof = true;
             return OLAP_ERR_DATA_EOF;
         }
 
-        _current_row = next_block * _num_rows_in_block;
-    } else if (next_block > _end_block) {
-        _eof = true;
-        return OLAP_ERR_DATA_EOF;
-    }
+        if (_current_row % _num_rows_in_block != 0) {
+            if (!_is_row_selected(_current_row)) {
+                ++_pending_skip_rows;
+                ++_current_row;
+                continue;
+            }
+
+            ++_current_row;
+            return OLAP_SUCCESS;
+        }
 
-    if (OLAP_UNLIKELY(next_block != _current_block || 0 == _current_row)) {
-        if (next_block > _current_block) {
-            OLAPStatus res = _seek_to_row_entry(next_block);
-            if (res == OLAP_SUCCESS) {
-                // seek to next_block will be successful in most case
-            } else if (res == OLAP_ERR_DATA_EOF) {
+        int64_t next_block = int64_t(_current_row / _num_rows_in_block);
+        if (!without_filter && NULL != _include_blocks
+                && DEL_SATISFIED == _include_blocks[next_block]) {
+            while (next_block < _block_count && DEL_SATISFIED == _include_blocks[next_block]) {
+                ++next_block;
+            }
+
+            if (next_block >= _block_count) {
                 _eof = true;
+                return OLAP_ERR_DATA_EOF;
+            }
+
+            _current_row = next_block * _num_rows_in_block;
+        } else if (next_block > _end_block) {
+            _eof = true;
+            return OLAP_ERR_DATA_EOF;
+        }
+
+        if (OLAP_UNLIKELY(next_block != _current_block || 0 == _current_row)) {
+            if (next_block > _current_block) {
+                OLAPStatus res = _seek_to_row_entry(next_block);
+                if (res == OLAP_SUCCESS) {
+                    // seek to next_block will be successful in most case
+                } else if (res == OLAP_ERR_DATA_EOF) {
+                    _eof = true;
+                    return res;
+                } else {
+                    OLAP_LOG_WARNING("fail to seek to next block. [res=%d]", res);
+                    return res;
+                }
+            }
+
+            _current_block = next_block;
+        }
+
+        _block_selection_active = false;
+        if (!without_filter && _need_row_selection()) {
+            bool has_selected = false;
+            OLAPStatus res = _eval_block_conditions(next_block, &has_selected);
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to eval conditions of block. [res=%d]", res);
                 return res;
-            } else {
-                OLAP_LOG_WARNING("fail to seek to next block. [res=%d]", res);
-                return res;
+            }
+
+            if (!has_selected) {
+                // 整个block都不满足条件, 非条件列不需要再解码
+                _current_row = (next_block + 1) * _num_rows_in_block;
+                continue;
+            }
+
+            if (!_is_row_selected(_current_row)) {
+                ++_pending_skip_rows;
+                ++_current_row;
+                continue;
             }
         }
 
-        _current_block = next_block;
+        _current_row++;
+        return OLAP_SUCCESS;
     }
-
-    _current_row++;
-    return OLAP_SUCCESS;
 }
 
 OLAPStatus SegmentReader::_seek_to_row_entry(int64_t block_id) {
+    _pending_skip_rows = 0;
 
     for (size_t i = 0; i < _column_readers.size(); ++i) {
         if (block_id >= _block_count) {
@@ -23,6 +23,7 @@
 #include <map>
 #include <string>
 
+#include "olap/column_file/bitmap_index_reader.h"
 #include "olap/column_file/bloom_filter_reader.h"
 #include "olap/column_file/column_reader.h"
 #include "olap/column_file/compress.h"
@@ -69,6 +70,13 @@ public:
     // @return [description]
     OLAPStatus init(bool is_using_cache);
 
+    // 把segment文件中这些列的index stream移出cache, 在文件所属的版本被合并后调用,
+    // 不必等它们被lru淘汰. 打包的版本中file_name是打包文件, region_offset是segment
+    // 数据文件在其中的位置, 否则region_offset为0
+    static void evict_index_streams(const std::string& file_name,
+                                    uint64_t region_offset,
+                                    const std::vector<ColumnId>& unique_column_ids);
+
     // 指定读取的第一个block和最后一个block，并初始化column reader
     // seek_to_block支持被多次调用
     // Inputs:
@@ -85,6 +93,12 @@ public:
     // @return 绑定数据的RowCursor，失败或无数据可读则返回NULL
     const RowCursor* get_next_row(bool without_filter);
 
+    // 批量读取当前block中剩余的行, 直接填充batch的ColumnVector, 不经过RowCursor.
+    // 列的顺序与return_columns一致, 数据追加在batch已有的行之后.
+    // 只读取已经开始读取的block的剩余部分, 跨block的seek和过滤仍由get_next_row完成;
+    // 需要逐行判断删除条件或者有行被查询条件过滤的block不做批量读取, 此时rows_read为0
+    OLAPStatus get_next_block(VectorizedRowBatch* batch, uint32_t* rows_read);
+
     // 返回最后一行数据
     // @return 绑定数据的RowCursor，失败或无数据可读则返回NULL
     const RowCursor* get_current_row() const {
@@ -95,6 +109,17 @@ public:
         return _eof;
     }
 
+    // 当前行(最后一次get_next_row返回的行)在segment中的行号
+    uint64_t current_row_id() const {
+        return _current_row - 1;
+    }
+
+    // 设置segment中被更新版本中key相同的行替换的行号(升序), 这些行在读取时被跳过,
+    // 不做合并. 需要在seek_to_block之前设置, deleted_rows在读取期间需要一直有效
+    void set_deleted_rows(const std::vector<uint64_t>* deleted_rows) {
+        _deleted_rows = deleted_rows;
+    }
+
     // 返回当前segment中block的数目
     uint32_t block_count() const {
         return _block_count;
@@ -155,10 +180,12 @@ private:
         uint32_t offset_position;
     };
 
+    // 打包版本的所有segment共用一个文件, 需要用region_offset区分
     static  CacheKey _construct_index_stream_key(
             char* buf,
             size_t len,
             const std::string& file_name,
+            uint64_t region_offset,
             ColumnId unique_column_id,
             StreamInfoMessage::Kind kind);
 
@@ -174,6 +201,21 @@ private:
         return _include_bf_columns.count(column_unique_id) != 0;
     }
 
+    inline bool _is_bitmap_column_included(ColumnId column_unique_id) {
+        return _include_bitmap_columns.count(column_unique_id) != 0;
+    }
+
+    // 判断索引流(row index, bloom filter, bitmap index)是否需要加载
+    inline bool _is_index_stream_included(ColumnId column_unique_id,
+                                          StreamInfoMessage::Kind kind) {
+        return (_is_column_included(column_unique_id)
+                    && kind == StreamInfoMessage::ROW_INDEX)
+                || (_is_bf_column_included(column_unique_id)
+                    && kind == StreamInfoMessage::BLOOM_FILTER)
+                || (_is_bitmap_column_included(column_unique_id)
+                    && kind == StreamInfoMessage::BITMAP_INDEX);
+    }
+
     // 加载文件和必要的文件信息
     OLAPStatus _load_segment_file();
 
@@ -206,6 +248,22 @@ private:
     OLAPStatus _pick_row_groups(uint32_t first_block, uint32_t last_block);
     OLAPStatus _pick_delete_row_groups(uint32_t first_block, uint32_t last_block);
 
+    // 用bitmap索引计算满足等值/IN/IS NULL条件的行, 结果保存在_bitmap_selection中,
+    // 并过滤掉没有满足条件的行的block
+    OLAPStatus _pick_bitmap_rows(uint32_t first_block, uint32_t last_block);
+
+    // 从_bitmap_selection中去掉被更新版本替换的行, 见set_deleted_rows
+    void _pick_undeleted_rows(uint32_t first_block, uint32_t last_block);
+
+    // 过滤掉_bitmap_selection中没有任何行的block
+    void _exclude_unselected_blocks(uint32_t first_block, uint32_t last_block);
+
+    // 条件能否在合并之前按行过滤: DUP_KEYS的表或者key列上的条件
+    bool _is_row_filter_allowed(const CondColumn& cond_column) const;
+
+    // 条件列上的所有条件是否都能通过bitmap索引求值
+    bool _is_bitmap_answerable(const CondColumn& cond_column) const;
+
     // 加载索引，将需要的列的索引读入内存
     OLAPStatus _load_index(bool is_using_cache);
 
@@ -256,6 +314,26 @@ private:
 
     OLAPStatus _reset_readers();
 
+    // 延迟物化: 找出return_columns中带有查询条件的列, 其余列在过滤后再读取
+    void _init_late_materialization();
+
+    // 对字典编码的条件列, 在字典上预先求值条件, 之后按行只比较字典编码.
+    // 需要在_create_reader之后调用
+    void _init_code_filters();
+
+    // 只解码条件列, 对block中的每一行求值条件, 并与bitmap索引的结果合并, 结果保存在_row_selection中.
+    // 若block中有满足条件的行, 条件列会被重新seek到block的起始位置
+    OLAPStatus _eval_block_conditions(int64_t block_id, bool* has_selected);
+
+    inline bool _is_row_selected(uint64_t row) const {
+        return !_block_selection_active || 0 != _row_selection[row % _num_rows_in_block];
+    }
+
+    // 是否需要在读非条件列之前逐block计算行的选择结果
+    inline bool _need_row_selection() const {
+        return !_late_conditions.empty() || _has_bitmap_selection;
+    }
+
     // 获取当前的table级schema。
     inline const std::vector<FieldInfo>& tablet_schema() {
         return _table->tablet_schema();
@@ -278,10 +356,7 @@ private:
                 continue;
             }
 
-            if ((_is_column_included(unique_column_id)
-                    && message.kind() == StreamInfoMessage::ROW_INDEX)
-                    || (_is_bf_column_included(unique_column_id)
-                    && message.kind() == StreamInfoMessage::BLOOM_FILTER)) {
+            if (_is_index_stream_included(unique_column_id, message.kind())) {
                 ++included_row_index_stream_num;
             }
         }
@@ -330,6 +405,7 @@ private:
     UniqueIdSet _include_columns;           // 用于判断该列是不是被包含
     UniqueIdSet _load_bf_columns;
     UniqueIdSet _include_bf_columns;
+    UniqueIdSet _include_bitmap_columns;
     UniqueIdToColumnIdMap _table_id_to_unique_id_map; // table id到unique id的映射
     UniqueIdToColumnIdMap _unique_id_to_table_id_map; // unique id到table id的映射
     UniqueIdToColumnIdMap _unique_id_to_segment_id_map; // uniqid到segment id的映射
@@ -339,6 +415,7 @@ private:
     std::map<StreamName, ReadOnlyFileStream*> _streams;      //需要读取的流
     UniqueIdEncodingMap _encodings_map;            // 保存encoding
     std::map<ColumnId, BloomFilterIndexReader*> _bloom_filters;
+    std::map<ColumnId, BitmapIndexReader*> _bitmap_indices;
     Decompressor _decompressor;                    //根据压缩格式，设置的解压器
     ByteBuffer* _mmap_buffer;
 
@@ -352,6 +429,9 @@ private:
      * DEL_PARTIAL_SATISFIED is for block can't be filtered by the delete condition in block level.
     */
     uint8_t* _include_blocks;
+    // 每个DEL_PARTIAL_SATISFIED的block上仍需逐行判定的删除条件，第k位对应第k个删除条件，
+    // 其余删除条件在block级别已经确定不满足，逐行判定时跳过
+    std::vector<uint64_t> _partial_delete_conditions;
     uint32_t _remain_block;
     uint64_t _filted_rows;
     bool _need_block_filter;   //与include blocks组合使用，如果全不中，就不再读
@@ -361,8 +441,20 @@ private:
 
     Cache* _lru_cache;
     Cache::Handle** _cache_handle;
+    Cache* _data_page_cache;                 // 数据流解压后数据块的cache, NULL表示不使用
     FileHeader<ColumnDataHeaderMessage> _file_header;
 
+    // 延迟物化使用的条件列, 与_cond_reader_index一一对应
+    std::vector<const CondColumn*> _late_conditions;
+    std::vector<size_t> _cond_reader_index;   // 条件列在_column_readers中的下标
+    std::vector<uint8_t> _cond_use_code;       // 条件列是否按字典编码求值
+    std::vector<uint8_t> _row_selection;       // 当前block中每一行是否满足条件
+    bool _block_selection_active;              // 当前block中是否有行被条件过滤
+    uint64_t _pending_skip_rows;               // 在读取下一行之前需要跳过的行数
+    RowBitmap _bitmap_selection;               // bitmap索引计算出的满足条件的行
+    bool _has_bitmap_selection;                // _bitmap_selection是否有效
+    const std::vector<uint64_t>* _deleted_rows; // 被更新版本替换的行, 读取时跳过
+
     bool _vectorized_info_inited;
     std::vector<VectorizedPositionInfo> _vectorized_position;
 
@@ -375,6 +467,16 @@ private:
 inline OLAPStatus SegmentReader::_read_next_and_attach() {
     OLAPStatus res = OLAP_SUCCESS;
 
+    // 跳过被条件过滤掉的行, 这些行的非条件列不会被解码
+    if (_pending_skip_rows > 0) {
+        res = _reader_skip(_pending_skip_rows);
+        _pending_skip_rows = 0;
+        if (OLAP_SUCCESS != res && OLAP_ERR_COLUMN_STREAM_EOF != res) {
+            OLAP_LOG_WARNING("fail to skip filtered rows. [res=%d]", res);
+            return res;
+        }
+    }
+
     for (std::vector<ColumnReader*>::iterator it = _column_readers.begin();
             it != _column_readers.end(); ++it) {
         res = (*it)->next();
@@ -15,15 +15,27 @@
 
 #include "olap/column_file/segment_writer.h"
 
+#include <boost/bind.hpp>
+
 #include "olap/column_file/column_writer.h"
 #include "olap/column_file/out_stream.h"
 #include "olap/file_helper.h"
+#include "olap/row_block.h"
+#include "olap/row_cursor.h"
 #include "olap/utils.h"
+#include "util/thread_pool.hpp"
 
 
 namespace palo {
 namespace column_file {
 
+// 所有SegmentWriter共享的列编码线程池
+static ThreadPool* encode_thread_pool() {
+    static ThreadPool pool(config::segment_write_encode_thread_num,
+                           config::segment_write_encode_thread_num * 4);
+    return &pool;
+}
+
 SegmentWriter::SegmentWriter(
         const std::string& file_name,
         SmartOLAPTable table,
@@ -43,6 +55,11 @@ SegmentWriter::~SegmentWriter() {
             it != _root_writers.end(); ++it) {
         SAFE_DELETE(*it);
     }
+
+    for (std::vector<RowCursor*>::iterator it = _group_cursors.begin();
+            it != _group_cursors.end(); ++it) {
+        SAFE_DELETE(*it);
+    }
 }
 
 OLAPStatus SegmentWriter::init(uint32_t write_mbytes_per_sec) {
@@ -56,6 +73,19 @@ OLAPStatus SegmentWriter::init(uint32_t write_mbytes_per_sec) {
         return OLAP_ERR_MALLOC_ERROR;
     }
 
+    for (uint32_t i = 0; i < _table->tablet_schema().size(); i++) {
+        CompressKind compress_kind = COMPRESS_NONE;
+        int32_t compress_level = 0;
+        if (_table->column_compress_kind(i, &compress_kind, &compress_level)) {
+            res = _stream_factory->set_column_compress_kind(
+                    _table->tablet_schema()[i].unique_id, compress_kind, compress_level);
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to set compress kind of column. [column=%u]", i);
+                return res;
+            }
+        }
+    }
+
     // 创建writer
     for (uint32_t i = 0; i < _table->tablet_schema().size(); i++) {
         if (_table->tablet_schema()[i].is_root_column) {
@@ -81,9 +111,166 @@ OLAPStatus SegmentWriter::init(uint32_t write_mbytes_per_sec) {
 
     _write_mbytes_per_sec = write_mbytes_per_sec;
 
+    // 根列按顺序轮流分到各组, 每组在一个编码线程中写入, 组内的列共享一次读行
+    uint32_t group_num = std::min<uint32_t>(
+            std::max(config::segment_write_encode_thread_num, 0), _root_writers.size());
+    if (group_num > 1) {
+        _writer_groups.resize(group_num);
+        for (uint32_t i = 0; i < _root_writers.size(); ++i) {
+            _writer_groups[i % group_num].push_back(_root_writers[i]);
+        }
+    } else {
+        _writer_groups.resize(1);
+        _writer_groups[0] = _root_writers;
+    }
+
+    for (uint32_t i = 0; i < _writer_groups.size(); ++i) {
+        RowCursor* cursor = new(std::nothrow) RowCursor();
+        if (NULL == cursor) {
+            OLAP_LOG_WARNING("fail to allocate RowCursor");
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+        _group_cursors.push_back(cursor);
+
+        res = cursor->init(_table->tablet_schema());
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to init row cursor. [res=%d]", res);
+            return res;
+        }
+    }
+
     return OLAP_SUCCESS;
 }
 
+OLAPStatus SegmentWriter::write_row_block(const RowBlock& row_block) {
+    OLAPStatus res = OLAP_SUCCESS;
+    uint32_t row_num = row_block.row_block_info().row_num;
+
+    if (_writer_groups.size() <= 1) {
+        for (uint32_t i = 0; i < row_num; ++i) {
+            res = row_block.get_row_to_read(i, _group_cursors[0]);
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to get row from row block. [res=%d]", res);
+                return res;
+            }
+
+            res = write(_group_cursors[0]);
+            if (OLAP_SUCCESS != res) {
+                return res;
+            }
+        }
+        return res;
+    }
+
+    std::vector<OLAPStatus> group_res(_writer_groups.size(), OLAP_SUCCESS);
+    CountDownLatch latch(_writer_groups.size());
+    for (uint32_t i = 0; i < _writer_groups.size(); ++i) {
+        if (!encode_thread_pool()->offer(boost::bind(
+                &SegmentWriter::_write_column_group, this,
+                &row_block, i, &group_res[i], &latch))) {
+            _write_column_group(&row_block, i, &group_res[i], &latch);
+        }
+    }
+    latch.await();
+
+    for (uint32_t i = 0; i < group_res.size(); ++i) {
+        if (OLAP_SUCCESS != group_res[i]) {
+            OLAP_LOG_WARNING("fail to write column group. [group=%u res=%d]", i, group_res[i]);
+            return group_res[i];
+        }
+    }
+
+    // 与逐行写入时相同的方式维护行数和block数, 各列的索引项已经在编码线程中创建
+    for (uint32_t i = 0; i < row_num; ++i) {
+        if (_row_in_block == _table->num_rows_per_row_block()) {
+            ++_block_count;
+            _row_in_block = 0;
+        }
+        ++_row_count;
+        ++_row_in_block;
+    }
+
+    return res;
+}
+
+void SegmentWriter::_write_column_group(const RowBlock* row_block,
+                                        uint32_t group,
+                                        OLAPStatus* res,
+                                        CountDownLatch* latch) {
+    const std::vector<ColumnWriter*>& writers = _writer_groups[group];
+    RowCursor* cursor = _group_cursors[group];
+    uint64_t row_in_block = _row_in_block;
+    uint32_t row_num = row_block->row_block_info().row_num;
+
+    for (uint32_t i = 0; i < row_num && OLAP_SUCCESS == *res; ++i) {
+        if (row_in_block == _table->num_rows_per_row_block()) {
+            for (std::vector<ColumnWriter*>::const_iterator it = writers.begin();
+                    it != writers.end(); ++it) {
+                if (OLAP_SUCCESS != (*it)->create_row_index_entry()) {
+                    OLAP_LOG_WARNING("fail to create row index entry");
+                }
+            }
+            row_in_block = 0;
+        }
+
+        *res = row_block->get_row_to_read(i, cursor);
+        if (OLAP_SUCCESS != *res) {
+            OLAP_LOG_WARNING("fail to get row from row block. [res=%d]", *res);
+            break;
+        }
+
+        for (std::vector<ColumnWriter*>::const_iterator it = writers.begin();
+                it != writers.end(); ++it) {
+            *res = (*it)->write(cursor);
+            if (OLAP_UNLIKELY(OLAP_SUCCESS != *res)) {
+                OLAP_LOG_WARNING("fail to write row. [res=%d]", *res);
+                break;
+            }
+        }
+        ++row_in_block;
+    }
+
+    latch->count_down();
+}
+
+OLAPStatus SegmentWriter::write_columns(uint32_t begin,
+                                        uint32_t end,
+                                        uint64_t row_id,
+                                        RowCursor* row_cursor) {
+    OLAPStatus res = OLAP_SUCCESS;
+    uint64_t num_rows_per_block = _table->num_rows_per_row_block();
+
+    // 每组在自己的block边界上创建索引项, 最后一个block的索引项在finalize时创建
+    if (row_id > 0 && 0 == row_id % num_rows_per_block) {
+        for (uint32_t i = begin; i < end; ++i) {
+            res = _root_writers[i]->create_row_index_entry();
+            if (OLAP_UNLIKELY(OLAP_SUCCESS != res)) {
+                OLAP_LOG_WARNING("fail to create row index. [res=%d]", res);
+                return res;
+            }
+        }
+    }
+
+    for (uint32_t i = begin; i < end; ++i) {
+        res = _root_writers[i]->write(row_cursor);
+        if (OLAP_UNLIKELY(OLAP_SUCCESS != res)) {
+            OLAP_LOG_WARNING("fail to write row. [res=%d]", res);
+            return res;
+        }
+    }
+
+    if (0 == begin) {
+        if (_row_in_block == num_rows_per_block) {
+            ++_block_count;
+            _row_in_block = 0;
+        }
+        ++_row_count;
+        ++_row_in_block;
+    }
+
+    return res;
+}
+
 OLAPStatus SegmentWriter::write(RowCursor* row_cursor) {
     OLAPStatus res = OLAP_SUCCESS;
 
@@ -159,6 +346,7 @@ OLAPStatus SegmentWriter::_make_file_header(ColumnDataHeaderMessage* file_header
         //   * column_type
         //   * column_encoding
         //   * column_statistics
+        //   * column_sketch
         res = (*it)->finalize(file_header);
 
         if (OLAP_UNLIKELY(OLAP_SUCCESS != res)) {
@@ -167,6 +355,9 @@ OLAPStatus SegmentWriter::_make_file_header(ColumnDataHeaderMessage* file_header
         }
     }
 
+    _column_sketches.assign(file_header->column_sketch().begin(),
+                            file_header->column_sketch().end());
+
     uint64_t index_length = 0;
     uint64_t data_length = 0;
 
@@ -189,9 +380,13 @@ OLAPStatus SegmentWriter::_make_file_header(ColumnDataHeaderMessage* file_header
         stream_info->set_length(stream->get_stream_length());
         stream_info->set_column_unique_id(it->first.unique_column_id());
         stream_info->set_kind(it->first.kind());
+        if (stream->compress_kind() != _table->compress_kind()) {
+            stream_info->set_compress_kind(stream->compress_kind());
+        }
 
         if (it->first.kind() == StreamInfoMessage::ROW_INDEX || 
-                it->first.kind() == StreamInfoMessage::BLOOM_FILTER) {
+                it->first.kind() == StreamInfoMessage::BLOOM_FILTER ||
+                it->first.kind() == StreamInfoMessage::BITMAP_INDEX) {
             index_length += stream->get_stream_length();
         } else {
             data_length += stream->get_stream_length();
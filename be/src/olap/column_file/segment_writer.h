@@ -16,10 +16,15 @@
 #ifndef BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_SEGMENT_WRITER_H
 #define BDG_PALO_BE_SRC_OLAP_COLUMN_FILE_SEGMENT_WRITER_H
 
+#include "gen_cpp/olap_common.pb.h"
 #include "olap/olap_define.h"
 #include "olap/writer.h"
+#include "util/count_down_latch.hpp"
 
 namespace palo {
+
+class RowBlock;
+
 namespace column_file {
 
 class ColumnWriter;
@@ -36,12 +41,23 @@ public:
     OLAPStatus init(uint32_t write_mbytes_per_sec);
     // 写入一行数据, 使用row_cursor读取每个列
     OLAPStatus write(RowCursor* row_cursor);
+    // 写入row_block中的所有行, 根列分组后在线程池中并行编码和压缩,
+    // 见config::segment_write_encode_thread_num
+    OLAPStatus write_row_block(const RowBlock& row_block);
+    // 纵向合并时按列组写入: 写入第row_id行的第begin到end-1个根列, 各组分别按顺序写入
+    // Segment的所有行. 第一组(从第0列开始)维护行数和block数, 与write()相同
+    OLAPStatus write_columns(uint32_t begin, uint32_t end, uint64_t row_id,
+                             RowCursor* row_cursor);
     // 记录index信息
     OLAPStatus create_row_index_entry();
     // 通过对缓存的使用,预估最终segment的大小
     uint64_t estimate_segment_size();
     // 生成文件并写入缓存的数据
     OLAPStatus finalize(uint32_t* segment_file_size);
+    // finalize之后有效, 各列记录在Segment头中的统计草图
+    const std::vector<ColumnSketchMessage>& column_sketches() const {
+        return _column_sketches;
+    }
 
     bool is_row_block_full() {
         return (_row_in_block >= _table->num_rows_per_row_block()) ? true : false;
@@ -50,14 +66,24 @@ private:
     // Helper: 生成最终的PB文件头
     OLAPStatus _make_file_header(ColumnDataHeaderMessage* file_header);
 
+    // 在编码线程中写入一组根列的所有行
+    void _write_column_group(const RowBlock* row_block,
+                             uint32_t group,
+                             OLAPStatus* res,
+                             CountDownLatch* latch);
+
     std::string _file_name;
     SmartOLAPTable _table;
     uint32_t _stream_buffer_size; // 输出缓冲区大小
     std::vector<ColumnWriter*> _root_writers;
+    // 并行编码时每组根列的writer及读取行使用的cursor
+    std::vector<std::vector<ColumnWriter*> > _writer_groups;
+    std::vector<RowCursor*> _group_cursors;
     OutStreamFactory* _stream_factory;
     uint64_t _row_count;    // 已经写入的行总数
     uint64_t _row_in_block; // 当前block中的数据
     uint64_t _block_count;  // 已经写入的block个数
+    std::vector<ColumnSketchMessage> _column_sketches;
 
     // write limit
     uint32_t _write_mbytes_per_sec;
@@ -15,8 +15,17 @@
 
 #include "olap/column_file/serialize.h"
 
+#ifdef __SSE4_1__
+#include <smmintrin.h>
+#endif
+
+#include <string.h>
+
+#include <algorithm>
+
 #include "olap/column_file/file_stream.h"
 #include "olap/column_file/out_stream.h"
+#include "util/cpu_info.h"
 
 namespace palo {
 namespace column_file {
@@ -248,39 +257,136 @@ OLAPStatus write_ints(OutStream* output, int64_t* data, uint32_t count, uint32_t
     return OLAP_SUCCESS;
 }
 
-OLAPStatus read_ints(ReadOnlyFileStream* input, int64_t* data, uint32_t count, uint32_t bit_width) {
-    OLAPStatus res = OLAP_SUCCESS;
-    uint32_t bits_left = 0;
-    char current = '\0';
+// read_ints每次解包的最大个数, 与RunLengthIntegerWriter::MAX_SCOPE一致.
+// UNPACK_BATCH_SIZE * bit_width总是8的倍数, 因此分批解包时每批都从字节边界开始
+static const uint32_t UNPACK_BATCH_SIZE = 512;
 
-    for (uint32_t i = 0; i < count; i++) {
-        int64_t result = 0;
-        uint32_t bits_left_to_read = bit_width;
+inline uint64_t load_big_endian_64(const uint8_t* p) {
+    uint64_t value = 0;
+    memcpy(&value, p, sizeof(value));
+    return __builtin_bswap64(value);
+}
 
-        while (bits_left_to_read > bits_left) {
-            result <<= bits_left;
-            result |= current & ((1 << bits_left) - 1);
-            bits_left_to_read -= bits_left;
-            res = input->read(&current);
+// 通用实现: 每个值从所在位置读入64位再移位, bit_width不超过56时一次读取即可覆盖
+static void unpack_ints_generic(const uint8_t* input, int64_t* data,
+                                uint32_t count, uint32_t bit_width) {
+    uint64_t bit_pos = 0;
+    for (uint32_t i = 0; i < count; ++i, bit_pos += bit_width) {
+        uint64_t word = load_big_endian_64(input + (bit_pos >> 3));
+        data[i] = (word << (bit_pos & 7)) >> (64 - bit_width);
+    }
+}
 
-            if (OLAP_UNLIKELY(OLAP_SUCCESS != res)) {
-                OLAP_LOG_WARNING("fail to write byte to stream.[res=%d]", res);
-                return res;
-            }
+// 按字节对齐的位长(8, 16, ..., 64): 每个值是bytes个字节的大端整数
+static void unpack_ints_aligned(const uint8_t* input, int64_t* data,
+                                uint32_t count, uint32_t bytes) {
+    if (8 == bytes) {
+        for (uint32_t i = 0; i < count; ++i) {
+            data[i] = load_big_endian_64(input + i * 8);
+        }
+        return;
+    }
 
-            bits_left = 8;
+    uint32_t shift = 64 - bytes * 8;
+    for (uint32_t i = 0; i < count; ++i) {
+        data[i] = load_big_endian_64(input + i * bytes) >> shift;
+    }
+}
+
+#ifdef __SSE4_1__
+// SSE4.1实现, 每次处理16个字节: pshufb完成大端到小端的转换, pmovzx扩展到64位
+static uint32_t unpack_ints_sse4(const uint8_t* input, int64_t* data,
+                                 uint32_t count, uint32_t bit_width) {
+    uint32_t i = 0;
+    __m128i* out = reinterpret_cast<__m128i*>(data);
+
+    if (8 == bit_width) {
+        for (; i + 16 <= count; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+            _mm_storeu_si128(out++, _mm_cvtepu8_epi64(v));
+            _mm_storeu_si128(out++, _mm_cvtepu8_epi64(_mm_srli_si128(v, 2)));
+            _mm_storeu_si128(out++, _mm_cvtepu8_epi64(_mm_srli_si128(v, 4)));
+            _mm_storeu_si128(out++, _mm_cvtepu8_epi64(_mm_srli_si128(v, 6)));
+            _mm_storeu_si128(out++, _mm_cvtepu8_epi64(_mm_srli_si128(v, 8)));
+            _mm_storeu_si128(out++, _mm_cvtepu8_epi64(_mm_srli_si128(v, 10)));
+            _mm_storeu_si128(out++, _mm_cvtepu8_epi64(_mm_srli_si128(v, 12)));
+            _mm_storeu_si128(out++, _mm_cvtepu8_epi64(_mm_srli_si128(v, 14)));
+        }
+    } else if (16 == bit_width) {
+        const __m128i mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6,
+                                           9, 8, 11, 10, 13, 12, 15, 14);
+        for (; i + 8 <= count; i += 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 2));
+            v = _mm_shuffle_epi8(v, mask);
+            _mm_storeu_si128(out++, _mm_cvtepu16_epi64(v));
+            _mm_storeu_si128(out++, _mm_cvtepu16_epi64(_mm_srli_si128(v, 4)));
+            _mm_storeu_si128(out++, _mm_cvtepu16_epi64(_mm_srli_si128(v, 8)));
+            _mm_storeu_si128(out++, _mm_cvtepu16_epi64(_mm_srli_si128(v, 12)));
         }
+    } else if (32 == bit_width) {
+        const __m128i mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+                                           11, 10, 9, 8, 15, 14, 13, 12);
+        for (; i + 4 <= count; i += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 4));
+            v = _mm_shuffle_epi8(v, mask);
+            _mm_storeu_si128(out++, _mm_cvtepu32_epi64(v));
+            _mm_storeu_si128(out++, _mm_cvtepu32_epi64(_mm_srli_si128(v, 8)));
+        }
+    }
+
+    return i;
+}
+#endif
+
+void unpack_ints(const char* input, int64_t* data, uint32_t count, uint32_t bit_width) {
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(input);
 
-        // handle the left over bits
-        if (bits_left_to_read > 0) {
-            result <<= bits_left_to_read;
-            bits_left -= bits_left_to_read;
-            result |= (current >> bits_left) & ((1 << bits_left_to_read) - 1);
+    if (0 != (bit_width & 7)) {
+        unpack_ints_generic(in, data, count, bit_width);
+        return;
+    }
+
+#ifdef __SSE4_1__
+    if ((8 == bit_width || 16 == bit_width || 32 == bit_width)
+            && CpuInfo::is_supported(CpuInfo::SSE4_1)) {
+        uint32_t done = unpack_ints_sse4(in, data, count, bit_width);
+        in += done * (bit_width >> 3);
+        data += done;
+        count -= done;
+    }
+#endif
+
+    unpack_ints_aligned(in, data, count, bit_width >> 3);
+}
+
+OLAPStatus read_ints(ReadOnlyFileStream* input, int64_t* data, uint32_t count, uint32_t bit_width) {
+    OLAPStatus res = OLAP_SUCCESS;
+    // 整批读入再解包, 避免逐字节读取; 多留8字节供按64位读取
+    char buffer[UNPACK_BATCH_SIZE * sizeof(int64_t) + sizeof(uint64_t)];
+
+    while (count > 0) {
+        uint32_t batch = std::min(count, UNPACK_BATCH_SIZE);
+        uint64_t length = (static_cast<uint64_t>(batch) * bit_width + 7) / 8;
+        uint64_t read_length = length;
+
+        res = input->read(buffer, &read_length);
+        if (OLAP_UNLIKELY(OLAP_SUCCESS != res)) {
+            OLAP_LOG_WARNING("fail to read ints from stream.[res=%d]", res);
+            return res;
+        }
+
+        if (OLAP_UNLIKELY(read_length != length)) {
+            OLAP_LOG_WARNING("fail to read ints from stream. [expect=%lu actual=%lu]",
+                             length, read_length);
+            return OLAP_ERR_COLUMN_STREAM_EOF;
         }
 
-        data[i] = result;
+        memset(buffer + length, 0, sizeof(uint64_t));
+        unpack_ints(buffer, data, batch, bit_width);
+        data += batch;
+        count -= batch;
     }
-    
+
     return res;
 }
 
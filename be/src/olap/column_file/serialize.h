@@ -102,6 +102,10 @@ OLAPStatus write_ints(OutStream* output, int64_t* data, uint32_t count, uint32_t
 // 读取write_ints输出的数据
 OLAPStatus read_ints(ReadOnlyFileStream* input, int64_t* data, uint32_t count, uint32_t bit_width);
 
+// 将write_ints输出的count个位长为bit_width的整数从input中解包到data.
+// input的长度至少为(count * bit_width + 7) / 8 + 8, 多出的8字节用于按64位读取, 内容无要求
+void unpack_ints(const char* input, int64_t* data, uint32_t count, uint32_t bit_width);
+
 // Do not want to use Guava LongMath.checkedSubtract() here as it will throw
 // ArithmeticException in case of overflow
 inline bool is_safe_subtract(int64_t left, int64_t right) {
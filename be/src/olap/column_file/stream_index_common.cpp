@@ -15,7 +15,6 @@
 
 #include "olap/column_file/stream_index_common.h"
 
-#include "olap/column_file/stream_index_common.h"
 #include "olap/field.h"
 
 namespace palo {
@@ -25,7 +24,9 @@ ColumnStatistics::ColumnStatistics() :
         _minimum(NULL),
         _maximum(NULL),
          _ignored(true),
-        _null_supported(false) {
+        _null_supported(false),
+        _with_null_count(false),
+        _null_count(0) {
 }
 
 ColumnStatistics::~ColumnStatistics() {
@@ -33,7 +34,8 @@ ColumnStatistics::~ColumnStatistics() {
     SAFE_DELETE(_maximum);
 }
 
-OLAPStatus ColumnStatistics::init(const FieldType& type, bool null_supported) {
+OLAPStatus ColumnStatistics::init(
+        const FieldType& type, bool null_supported, bool with_null_count) {
     SAFE_DELETE(_minimum);
     SAFE_DELETE(_maximum);
     // 当数据类型为 String和varchar或是未知类型时，实际上不会有统计信息。
@@ -41,10 +43,12 @@ OLAPStatus ColumnStatistics::init(const FieldType& type, bool null_supported) {
     _maximum = Field::create_by_type(type);
 
     _null_supported = null_supported;
+    _with_null_count = false;
     if (NULL == _minimum || NULL == _maximum) {
         _ignored = true;
     } else {
         _ignored = false;
+        _with_null_count = null_supported && with_null_count;
         memset(_buf, 0, MAX_STATISTIC_LENGTH);
         _minimum->attach_field(_buf);
         _maximum->attach_field(_buf + _minimum->field_size());
@@ -55,8 +59,13 @@ OLAPStatus ColumnStatistics::init(const FieldType& type, bool null_supported) {
 }
 
 void ColumnStatistics::reset() {
+    _null_count = 0;
     if (!_ignored) {
+        // set_to_max不会清除null标记, 否则出现过null之后的所有block最小值都是null
         _minimum->set_to_max();
+        if (true == _null_supported) {
+            _minimum->set_not_null();
+        }
         _maximum->set_to_min();
         if (true == _null_supported) {
             _maximum->set_null();
@@ -69,6 +78,11 @@ void ColumnStatistics::add(const Field* field) {
         return;
     }
 
+    if (_with_null_count && field->is_null()) {
+        ++_null_count;
+        return;
+    }
+
     if (field->cmp(_maximum) > 0) {
         _maximum->copy(field);
     }
@@ -79,10 +93,19 @@ void ColumnStatistics::add(const Field* field) {
 }
 
 void ColumnStatistics::merge(ColumnStatistics* other) {
+    if (_with_null_count) {
+        _null_count += other->null_count();
+    }
+
     if (_ignored || other->ignored()) {
         return;
     }
 
+    // 全部为null时最大最小值没有意义
+    if (other->has_null_count() && other->maximum()->is_null()) {
+        return;
+    }
+
     if (other->maximum()->cmp(_maximum) > 0) {
         _maximum->copy(other->maximum());
     }
@@ -99,8 +122,10 @@ size_t ColumnStatistics::size() const {
 
     if (false == _null_supported) {
         return _minimum->size() + _maximum->size();
-    } else {
+    } else if (false == _with_null_count) {
         return _minimum->field_size() + _maximum->field_size();
+    } else {
+        return _minimum->field_size() + _maximum->field_size() + sizeof(_null_count);
     }
 }
 
@@ -115,6 +140,10 @@ void ColumnStatistics::attach(char* buffer) {
     } else {
         _minimum->attach_field(buffer);
         _maximum->attach_field(buffer + _minimum->field_size());
+        if (_with_null_count) {
+            memcpy(&_null_count, buffer + _minimum->field_size() + _maximum->field_size(),
+                   sizeof(_null_count));
+        }
     }
 }
 
@@ -127,6 +156,15 @@ OLAPStatus ColumnStatistics::write_to_buffer(char* buffer, size_t size) {
         return OLAP_ERR_BUFFER_OVERFLOW;
     }
 
+    if (_with_null_count) {
+        // 没有非null的值, 最小值也置为null, 与全部为null的判断保持一致
+        if (_maximum->is_null()) {
+            _minimum->set_null();
+        }
+        memcpy(_buf + _minimum->field_size() + _maximum->field_size(),
+               &_null_count, sizeof(_null_count));
+    }
+
     memcpy(buffer, _buf, this->size());
     return OLAP_SUCCESS;
 }
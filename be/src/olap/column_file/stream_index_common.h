@@ -22,6 +22,10 @@
 namespace palo {
 namespace column_file {
 
+// statistic_format的最高位置位时, 每个entry的统计信息之后带有uint32_t的null_count,
+// 并且最大最小值只统计非null的值, 最小值和最大值同时为null表示block中全部为null
+static const uint32_t STATISTIC_FORMAT_WITH_NULL_COUNT = 1U << 31;
+
 // 描述streamindex的格式
 struct StreamIndexHeader {
     uint64_t block_count;           // 本index中block的个数
@@ -42,7 +46,8 @@ public:
 
     // 初始化，需要给FieldType，用来初始化最大最小值
     // 使用前必须首先初始化，否则无效
-    OLAPStatus init(const FieldType& type, bool null_supported);
+    // with_null_count只在null_supported时生效, 为true时额外统计null的个数
+    OLAPStatus init(const FieldType& type, bool null_supported, bool with_null_count = false);
     // 只是reset最大和最小值，将最小值设置为MAX，将最大值设置为MIN。
     void reset();
     // 增加一个值，根据传入值调整最大最小值
@@ -67,6 +72,12 @@ public:
     bool ignored() const {
         return _ignored;
     }
+    bool has_null_count() const {
+        return _with_null_count;
+    }
+    uint32_t null_count() const {
+        return _null_count;
+    }
 protected:
     Field* _minimum;
     Field* _maximum;
@@ -75,6 +86,8 @@ protected:
     // 也可以每次都分配
     bool _ignored;
     bool _null_supported;
+    bool _with_null_count;
+    uint32_t _null_count;
 };
 
 }  // namespace column_file
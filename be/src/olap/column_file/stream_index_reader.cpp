@@ -34,7 +34,8 @@ OLAPStatus PositionEntryReader::init(
 
     set_positions_count(header->position_format);
 
-    if (OLAP_SUCCESS != _statistics.init(type, null_supported)) {
+    bool with_null_count = 0 != (header->statistic_format & STATISTIC_FORMAT_WITH_NULL_COUNT);
+    if (OLAP_SUCCESS != _statistics.init(type, null_supported, with_null_count)) {
         return OLAP_ERR_INIT_FAILED;
     }
 
@@ -20,7 +20,10 @@
 namespace palo {
 namespace column_file {
 
-PositionEntryWriter::PositionEntryWriter() : _positions_count(0), _statistics_size(0) {
+PositionEntryWriter::PositionEntryWriter() :
+        _positions_count(0),
+        _statistics_size(0),
+        _has_null_count(false) {
     memset(_statistics_buffer, 0, sizeof(_statistics_buffer));
 }
 
@@ -34,6 +37,7 @@ int64_t PositionEntryWriter::positions(size_t index) const {
 
 OLAPStatus PositionEntryWriter::set_statistic(ColumnStatistics* statistic) {
     _statistics_size = statistic->size();
+    _has_null_count = statistic->has_null_count();
     return statistic->write_to_buffer(_statistics_buffer, MAX_STATISTIC_LENGTH);
 }
 
@@ -41,6 +45,10 @@ bool PositionEntryWriter::has_statistic() const {
     return _statistics_size != 0;
 }
 
+bool PositionEntryWriter::has_null_count() const {
+    return _has_null_count;
+}
+
 int32_t PositionEntryWriter::positions_count() const {
     return _positions_count;
 }
@@ -159,6 +167,9 @@ OLAPStatus StreamIndexWriter::write_to_buffer(char* buffer, size_t buffer_size)
 
         if (_index_to_write[0].has_statistic()) {
             _header.statistic_format = _field_type;
+            if (_index_to_write[0].has_null_count()) {
+                _header.statistic_format |= STATISTIC_FORMAT_WITH_NULL_COUNT;
+            }
         }
     }
 
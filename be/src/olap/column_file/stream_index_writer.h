@@ -37,6 +37,8 @@ public:
     OLAPStatus set_statistic(ColumnStatistics* statistic);
     // 判断当前entry是否写入了统计信息
     bool has_statistic() const;
+    // 判断写入的统计信息是否带有null_count
+    bool has_null_count() const;
     // 输出到buffer的大小，用来预先分配内存用
     int32_t output_size() const;
     // 增加一个position, 目前给出的上限是16
@@ -53,6 +55,7 @@ private:
     size_t _positions_count;
     char _statistics_buffer[MAX_STATISTIC_LENGTH];
     size_t _statistics_size;
+    bool _has_null_count;
 };
 
 class StreamIndexWriter {
@@ -0,0 +1,274 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/column_sketch.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "util/hash_util.hpp"
+
+namespace palo {
+
+namespace {
+
+const uint32_t HLL_HASH_SEED = 0x9747b28c;
+
+int64_t hll_estimate(const uint8_t* registers, uint32_t num_registers) {
+    double sum = 0;
+    uint32_t num_zero_registers = 0;
+    for (uint32_t i = 0; i < num_registers; ++i) {
+        sum += ldexp(1.0, -registers[i]);
+        if (0 == registers[i]) {
+            ++num_zero_registers;
+        }
+    }
+
+    double m = num_registers;
+    double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+    // 基数较小时HLL偏差较大, 改用线性计数
+    if (estimate <= 2.5 * m && num_zero_registers != 0) {
+        estimate = m * log(m / num_zero_registers);
+    }
+
+    return llround(estimate);
+}
+
+struct WeightedValueLess {
+    bool operator()(const std::pair<Field*, double>& left,
+                    const std::pair<Field*, double>& right) const {
+        return left.first->cmp(right.first) < 0;
+    }
+};
+
+}  // namespace
+
+const uint32_t ColumnSketch::HLL_PRECISION;
+const uint32_t ColumnSketch::HLL_REGISTERS;
+const uint32_t ColumnSketch::MAX_SAMPLES;
+const uint32_t ColumnSketch::NUM_BUCKETS;
+
+ColumnSketch::ColumnSketch(const FieldInfo& field_info) :
+        _field_info(field_info),
+        _num_rows(0),
+        _num_nulls(0),
+        _registers(HLL_REGISTERS, 0),
+        _num_sampled(0),
+        _random_state(field_info.unique_id + 1) {}
+
+ColumnSketch::~ColumnSketch() {
+    for (size_t i = 0; i < _samples.size(); ++i) {
+        SAFE_DELETE(_samples[i]);
+    }
+
+    for (size_t i = 0; i < _bounds.size(); ++i) {
+        SAFE_DELETE(_bounds[i].first);
+    }
+}
+
+Field* ColumnSketch::_new_field() {
+    Field* field = Field::create(_field_info);
+    if (NULL == field) {
+        OLAP_LOG_WARNING("fail to create field. [type=%d]", _field_info.type);
+        return NULL;
+    }
+
+    if (!field->allocate()) {
+        OLAP_LOG_WARNING("fail to allocate field.");
+        SAFE_DELETE(field);
+        return NULL;
+    }
+
+    return field;
+}
+
+// xorshift64*, 只用于采样, 不需要很好的随机性
+uint64_t ColumnSketch::_next_random() {
+    _random_state ^= _random_state >> 12;
+    _random_state ^= _random_state << 25;
+    _random_state ^= _random_state >> 27;
+    return _random_state * 2685821657736338717ULL;
+}
+
+void ColumnSketch::add(const Field* field) {
+    ++_num_rows;
+    if (field->is_null()) {
+        ++_num_nulls;
+        return;
+    }
+
+    uint64_t hash = HashUtil::murmur_hash64A(field->buf(), field->size(), HLL_HASH_SEED);
+    uint32_t index = hash & (HLL_REGISTERS - 1);
+    hash >>= HLL_PRECISION;
+    uint8_t rank = 0 == hash ? 64 - HLL_PRECISION + 1 : __builtin_ctzll(hash) + 1;
+    if (rank > _registers[index]) {
+        _registers[index] = rank;
+    }
+
+    ++_num_sampled;
+    Field* sample = NULL;
+    if (_samples.size() < MAX_SAMPLES) {
+        sample = _new_field();
+        if (NULL == sample) {
+            return;
+        }
+        _samples.push_back(sample);
+    } else {
+        uint64_t pos = _next_random() % _num_sampled;
+        if (pos >= MAX_SAMPLES) {
+            return;
+        }
+        sample = _samples[pos];
+    }
+
+    sample->copy(field);
+}
+
+OLAPStatus ColumnSketch::merge(const ColumnSketchMessage& message) {
+    if (message.unique_id() != _field_info.unique_id) {
+        OLAP_LOG_WARNING("column of sketch does not match. [expect=%u actual=%u]",
+                         _field_info.unique_id, message.unique_id());
+        return OLAP_ERR_INPUT_PARAMETER_ERROR;
+    }
+
+    if (message.has_hll_registers()) {
+        const std::string& registers = message.hll_registers();
+        if (registers.size() != HLL_REGISTERS) {
+            OLAP_LOG_WARNING("invalid hll registers of sketch. [size=%lu]", registers.size());
+            return OLAP_ERR_INPUT_PARAMETER_ERROR;
+        }
+
+        for (uint32_t i = 0; i < HLL_REGISTERS; ++i) {
+            _registers[i] = std::max(_registers[i], static_cast<uint8_t>(registers[i]));
+        }
+    }
+
+    _num_rows += message.num_rows();
+    _num_nulls += message.num_nulls();
+
+    if (message.histogram_bound_size() == 0) {
+        return OLAP_SUCCESS;
+    }
+
+    double weight = static_cast<double>(message.num_rows() - message.num_nulls())
+                    / message.histogram_bound_size();
+    for (int i = 0; i < message.histogram_bound_size(); ++i) {
+        Field* bound = _new_field();
+        if (NULL == bound) {
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+
+        OLAPStatus res = bound->from_string(message.histogram_bound(i));
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to parse histogram bound. [bound='%s']",
+                             message.histogram_bound(i).c_str());
+            SAFE_DELETE(bound);
+            return res;
+        }
+
+        _bounds.push_back(WeightedValue(bound, weight));
+    }
+
+    if (_bounds.size() > MAX_SAMPLES) {
+        return _compact();
+    }
+
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus ColumnSketch::_compact() {
+    std::vector<WeightedValue> points;
+    points.swap(_bounds);
+    for (size_t i = 0; i < _samples.size(); ++i) {
+        points.push_back(WeightedValue(
+                _samples[i], static_cast<double>(_num_sampled) / _samples.size()));
+    }
+    _samples.clear();
+    _num_sampled = 0;
+
+    if (points.empty()) {
+        return OLAP_SUCCESS;
+    }
+
+    std::sort(points.begin(), points.end(), WeightedValueLess());
+    double total_weight = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        total_weight += points[i].second;
+    }
+
+    // 第i个边界是累计权重达到总权重i/NUM_BUCKETS的第一个值
+    OLAPStatus res = OLAP_SUCCESS;
+    double cumulative_weight = points[0].second;
+    size_t pos = 0;
+    for (uint32_t i = 0; i <= NUM_BUCKETS; ++i) {
+        double target = total_weight * i / NUM_BUCKETS;
+        while (cumulative_weight < target && pos + 1 < points.size()) {
+            ++pos;
+            cumulative_weight += points[pos].second;
+        }
+
+        Field* bound = _new_field();
+        if (NULL == bound) {
+            res = OLAP_ERR_MALLOC_ERROR;
+            break;
+        }
+        bound->copy(points[pos].first);
+        _bounds.push_back(WeightedValue(bound, total_weight / (NUM_BUCKETS + 1)));
+    }
+
+    for (size_t i = 0; i < points.size(); ++i) {
+        SAFE_DELETE(points[i].first);
+    }
+
+    return res;
+}
+
+OLAPStatus ColumnSketch::to_pb(ColumnSketchMessage* message) {
+    OLAPStatus res = OLAP_SUCCESS;
+    if (!_samples.empty() || _bounds.size() > NUM_BUCKETS + 1) {
+        res = _compact();
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to build histogram. [res=%d]", res);
+            return res;
+        }
+    }
+
+    message->set_unique_id(_field_info.unique_id);
+    message->set_num_rows(_num_rows);
+    message->set_num_nulls(_num_nulls);
+    message->set_hll_registers(reinterpret_cast<const char*>(&_registers[0]), HLL_REGISTERS);
+    message->clear_histogram_bound();
+    for (size_t i = 0; i < _bounds.size(); ++i) {
+        message->add_histogram_bound(_bounds[i].first->to_string());
+    }
+
+    return res;
+}
+
+int64_t ColumnSketch::estimate_cardinality() const {
+    return hll_estimate(&_registers[0], HLL_REGISTERS);
+}
+
+int64_t ColumnSketch::estimate_cardinality(const ColumnSketchMessage& message) {
+    if (message.hll_registers().size() != HLL_REGISTERS) {
+        return -1;
+    }
+
+    return hll_estimate(reinterpret_cast<const uint8_t*>(message.hll_registers().data()),
+                        HLL_REGISTERS);
+}
+
+}  // namespace palo
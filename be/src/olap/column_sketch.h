@@ -0,0 +1,100 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_COLUMN_SKETCH_H
+#define BDG_PALO_BE_SRC_OLAP_COLUMN_SKETCH_H
+
+#include <stdint.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gen_cpp/olap_common.pb.h"
+#include "olap/field.h"
+#include "olap/olap_define.h"
+
+namespace palo {
+
+// 列的数据分布统计, 包括:
+//   * HyperLogLog, 估算非NULL值的基数(NDV)
+//   * 等深直方图, 每个桶中的行数大致相同, 用于估算范围条件的选择率和发现数据倾斜
+// 写Segment时逐行调用add(), 直方图由蓄水池采样得到; 多个Segment或版本的统计
+// 通过merge()合并, HLL按寄存器取最大值, 直方图的边界值按其代表的行数加权后重新分桶.
+class ColumnSketch {
+public:
+    static const uint32_t HLL_PRECISION = 10;
+    static const uint32_t HLL_REGISTERS = 1 << HLL_PRECISION;
+    // 蓄水池采样的最大样本数
+    static const uint32_t MAX_SAMPLES = 512;
+    static const uint32_t NUM_BUCKETS = 32;
+
+    explicit ColumnSketch(const FieldInfo& field_info);
+    ~ColumnSketch();
+
+    // HLL列的值不可比较, 不做统计
+    static bool is_supported(const FieldInfo& field_info) {
+        return OLAP_FIELD_TYPE_HLL != field_info.type;
+    }
+
+    // 增加一行的值
+    void add(const Field* field);
+
+    // 合并另一份统计, message的unique_id需要和当前列一致
+    OLAPStatus merge(const ColumnSketchMessage& message);
+
+    OLAPStatus to_pb(ColumnSketchMessage* message);
+
+    uint64_t num_rows() const {
+        return _num_rows;
+    }
+
+    uint64_t num_nulls() const {
+        return _num_nulls;
+    }
+
+    // 非NULL值的基数估计
+    int64_t estimate_cardinality() const;
+
+    // 直接从序列化的统计估算基数, 寄存器个数不匹配时返回-1
+    static int64_t estimate_cardinality(const ColumnSketchMessage& message);
+
+private:
+    typedef std::pair<Field*, double> WeightedValue;
+
+    Field* _new_field();
+    uint64_t _next_random();
+
+    // 将样本和合并进来的边界值按权重重新分为NUM_BUCKETS个桶, 结果保存在_bounds中,
+    // 样本清空
+    OLAPStatus _compact();
+
+    FieldInfo _field_info;
+    uint64_t _num_rows;
+    uint64_t _num_nulls;
+    std::vector<uint8_t> _registers;
+    // add()的非NULL值的蓄水池采样, _num_sampled是参与采样的行数
+    std::vector<Field*> _samples;
+    uint64_t _num_sampled;
+    // 合并得到的直方图边界值及其代表的行数
+    std::vector<WeightedValue> _bounds;
+    uint64_t _random_state;
+
+    DISALLOW_COPY_AND_ASSIGN(ColumnSketch);
+};
+
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_OLAP_COLUMN_SKETCH_H
@@ -18,6 +18,7 @@
 #include <dirent.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cstring>
 #include <iomanip>
 #include <list>
@@ -36,6 +37,8 @@
 #include "olap/olap_common.h"
 #include "olap/olap_define.h"
 #include "olap/olap_engine.h"
+#include "olap/olap_header.h"
+#include "olap/olap_index.h"
 #include "olap/olap_server.h"
 #include "olap/olap_table.h"
 #include "olap/push_handler.h"
@@ -63,9 +66,19 @@ OLAPStatus CommandExecutor::compute_checksum(
         TVersion version,
         TVersionHash version_hash,
         uint32_t* checksum) {
+    return compute_checksum(tablet_id, schema_hash, version, version_hash, false, checksum);
+}
+
+OLAPStatus CommandExecutor::compute_checksum(
+        TTabletId tablet_id,
+        TSchemaHash schema_hash,
+        TVersion version,
+        TVersionHash version_hash,
+        bool force,
+        uint32_t* checksum) {
     OLAP_LOG_INFO("begin to process compute checksum. "
-                  "[tablet_id=%ld schema_hash=%d version=%ld]",
-                  tablet_id, schema_hash, version);
+                  "[tablet_id=%ld schema_hash=%d version=%ld force=%d]",
+                  tablet_id, schema_hash, version, force);
     OLAPStatus res = OLAP_SUCCESS;
 
     if (checksum == NULL) {
@@ -96,6 +109,12 @@ OLAPStatus CommandExecutor::compute_checksum(
                              res, tablet_id, message->version_hash(), version_hash);
             return OLAP_ERR_CE_CMD_PARAMS_ERROR;
         }
+
+        // 版本的数据不会再改变, 已经计算过的checksum可以直接使用
+        if (!force && tablet->get_cached_checksum(version, version_hash, checksum)) {
+            OLAP_LOG_INFO("success to get cached checksum. [checksum=%u]", *checksum);
+            return OLAP_SUCCESS;
+        }
     }
 
     Reader reader;
@@ -155,6 +174,202 @@ OLAPStatus CommandExecutor::compute_checksum(
     
     OLAP_LOG_INFO("success to finish compute checksum. [checksum=%u]", tmp_checksum);
     *checksum = tmp_checksum;
+
+    // Failing to cache checksum only makes next check recompute it
+    {
+        AutoRWLock auto_lock(tablet->get_header_lock_ptr(), false);
+        tablet->cache_checksum(version, version_hash, tmp_checksum);
+        res = tablet->save_header();
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to save header after cache checksum. [res=%d tablet='%s']",
+                             res, tablet->full_name().c_str());
+        }
+    }
+    return OLAP_SUCCESS;
+}
+
+static void delete_cached_row(const CacheKey& key, void* value) {
+    delete reinterpret_cast<vector<string>*>(value);
+}
+
+// row cache的key由tablet、版本和所有key列的值组成
+static string row_cache_key(TTabletId tablet_id,
+                            TSchemaHash schema_hash,
+                            TVersion version,
+                            TVersionHash version_hash,
+                            const vector<string>& key) {
+    string cache_key;
+    cache_key.append(reinterpret_cast<const char*>(&tablet_id), sizeof(tablet_id));
+    cache_key.append(reinterpret_cast<const char*>(&schema_hash), sizeof(schema_hash));
+    cache_key.append(reinterpret_cast<const char*>(&version), sizeof(version));
+    cache_key.append(reinterpret_cast<const char*>(&version_hash), sizeof(version_hash));
+    for (const string& value : key) {
+        cache_key.append(value);
+        cache_key.push_back('\0');
+    }
+    return cache_key;
+}
+
+OLAPStatus CommandExecutor::lookup_rows(
+        TTabletId tablet_id,
+        TSchemaHash schema_hash,
+        TVersion version,
+        TVersionHash version_hash,
+        const vector<vector<string> >& keys,
+        vector<vector<string> >* rows) {
+    if (rows == NULL) {
+        OLAP_LOG_WARNING("invalid output parameter which is null pointer.");
+        return OLAP_ERR_CE_CMD_PARAMS_ERROR;
+    }
+
+    SmartOLAPTable tablet =
+            OLAPEngine::get_instance()->get_table(tablet_id, schema_hash);
+    if (NULL == tablet.get()) {
+        OLAP_LOG_WARNING("can't find tablet. [tablet_id=%ld schema_hash=%d]",
+                         tablet_id, schema_hash);
+        return OLAP_ERR_TABLE_NOT_FOUND;
+    }
+
+    if (tablet->keys_type() == KeysType::DUP_KEYS) {
+        OLAP_LOG_WARNING("lookup is not supported for duplicate keys tablet. [tablet='%s']",
+                         tablet->full_name().c_str());
+        return OLAP_ERR_CE_CMD_PARAMS_ERROR;
+    }
+
+    for (const vector<string>& key : keys) {
+        if (key.size() != tablet->num_key_fields()) {
+            OLAP_LOG_WARNING("lookup key must contain all key columns. "
+                             "[tablet='%s' key_size=%lu num_key_fields=%lu]",
+                             tablet->full_name().c_str(), key.size(), tablet->num_key_fields());
+            return OLAP_ERR_CE_CMD_PARAMS_ERROR;
+        }
+    }
+
+    {
+        AutoRWLock auto_lock(tablet->get_header_lock_ptr(), true);
+        const FileVersionMessage* message = tablet->latest_version();
+        if (message == NULL) {
+            OLAP_LOG_WARNING("fail to get latest version. [tablet_id=%ld]", tablet_id);
+            return OLAP_ERR_VERSION_NOT_EXIST;
+        }
+
+        if (message->end_version() == version
+                && message->version_hash() != version_hash) {
+            OLAP_LOG_WARNING("fail to check latest version hash. "
+                             "[tablet_id=%ld version_hash=%ld request_version_hash=%ld]",
+                             tablet_id, message->version_hash(), version_hash);
+            return OLAP_ERR_CE_CMD_PARAMS_ERROR;
+        }
+    }
+
+    rows->assign(keys.size(), vector<string>());
+
+    // 先查row cache，未命中的key再通过Reader合并各个版本的数据
+    Cache* row_cache = OLAPEngine::get_instance()->row_lru_cache();
+    vector<size_t> missed_keys;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (NULL != row_cache) {
+            string cache_key = row_cache_key(
+                    tablet_id, schema_hash, version, version_hash, keys[i]);
+            Cache::Handle* handle = row_cache->lookup(cache_key);
+            if (NULL != handle) {
+                (*rows)[i] = *reinterpret_cast<vector<string>*>(row_cache->value(handle));
+                row_cache->release(handle);
+                continue;
+            }
+        }
+        missed_keys.push_back(i);
+    }
+
+    if (missed_keys.empty()) {
+        return OLAP_SUCCESS;
+    }
+
+    Reader reader;
+    ReaderParams reader_params;
+    reader_params.olap_table = tablet;
+    reader_params.reader_type = READER_FETCH;
+    reader_params.version = Version(0, version);
+    reader_params.range = "eq";
+    for (size_t i = 0; i < tablet->tablet_schema().size(); ++i) {
+        reader_params.return_columns.push_back(i);
+    }
+    for (size_t i : missed_keys) {
+        TFetchStartKey start_key;
+        start_key.key = keys[i];
+        reader_params.start_key.push_back(start_key);
+    }
+
+    OLAPStatus res = reader.init(reader_params);
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("initiate reader fail. [res=%d]", res);
+        return res;
+    }
+
+    RowCursor row;
+    res = row.init(tablet->tablet_schema(), reader_params.return_columns);
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("failed to init row cursor. [res=%d]", res);
+        return res;
+    }
+
+    // Reader按key的顺序返回数据，每个key至多一行，没有读到数据的key跳过
+    size_t next_key = 0;
+    bool eof = false;
+    int64_t raw_rows_read = 0;
+    while (next_key < missed_keys.size()) {
+        res = reader.next_row_with_aggregation(&row, &raw_rows_read, &eof);
+        if (res == OLAP_SUCCESS && eof) {
+            break;
+        } else if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to read in reader. [res=%d]", res);
+            return res;
+        }
+
+        for (; next_key < missed_keys.size(); ++next_key) {
+            // varchar的长度与key的取值有关，每个key单独初始化cursor
+            RowCursor key_cursor;
+            const vector<string>& key = keys[missed_keys[next_key]];
+            res = key_cursor.init_keys(tablet->tablet_schema(), key);
+            if (res == OLAP_SUCCESS) {
+                res = key_cursor.from_string(key);
+            }
+            if (res != OLAP_SUCCESS) {
+                OLAP_LOG_WARNING("fail to parse lookup key. [res=%d]", res);
+                return res;
+            }
+
+            if (0 == key_cursor.cmp(row)) {
+                break;
+            }
+        }
+
+        if (next_key == missed_keys.size()) {
+            break;
+        }
+
+        size_t key_index = missed_keys[next_key];
+        (*rows)[key_index] = row.to_string_vector();
+        ++next_key;
+
+        if (NULL != row_cache) {
+            vector<string>* cached_row = new(std::nothrow) vector<string>((*rows)[key_index]);
+            if (NULL == cached_row) {
+                continue;
+            }
+
+            size_t charge = 0;
+            for (const string& value : *cached_row) {
+                charge += value.size();
+            }
+            string cache_key = row_cache_key(
+                    tablet_id, schema_hash, version, version_hash, keys[key_index]);
+            Cache::Handle* handle = row_cache->insert(
+                    cache_key, cached_row, charge, &delete_cached_row);
+            row_cache->release(handle);
+        }
+    }
+
     return OLAP_SUCCESS;
 }
 
@@ -166,6 +381,7 @@ OLAPStatus CommandExecutor::push(
                   request.tablet_id, request.version);
 
     time_t start = time(NULL);
+    ScopedLatencyRecorder latency_recorder(PaloMetrics::push_latency());
     if (PaloMetrics::palo_push_count() != NULL) {
         PaloMetrics::palo_push_count()->increment(1);
     }
@@ -203,6 +419,45 @@ OLAPStatus CommandExecutor::push(
     return res;
 }
 
+OLAPStatus CommandExecutor::push_batch(
+        const vector<TPushReq>& requests,
+        vector<vector<TTabletInfo>>* tablet_info_vecs) {
+    if (requests.empty() || tablet_info_vecs == NULL) {
+        OLAP_LOG_WARNING("invalid push batch parameters.");
+        return OLAP_ERR_CE_CMD_PARAMS_ERROR;
+    }
+    OLAP_LOG_INFO("begin to process push batch. [tablet_id=%ld version=%ld-%ld]",
+                  requests.front().tablet_id, requests.front().version,
+                  requests.back().version);
+
+    time_t start = time(NULL);
+    ScopedLatencyRecorder latency_recorder(PaloMetrics::push_latency());
+    SmartOLAPTable olap_table = OLAPEngine::get_instance()->get_table(
+            requests.front().tablet_id, requests.front().schema_hash);
+    if (NULL == olap_table.get()) {
+        OLAP_LOG_WARNING("false to find table. [table=%ld schema_hash=%d]",
+                         requests.front().tablet_id, requests.front().schema_hash);
+        return OLAP_ERR_TABLE_NOT_FOUND;
+    }
+
+    PushHandler push_handler;
+    OLAPStatus res = push_handler.process_batch(olap_table, requests, tablet_info_vecs);
+
+    time_t cost = time(NULL) - start;
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to process push batch. cost: %ld [res=%d table=%s]",
+                         cost, res, olap_table->full_name().c_str());
+        return res;
+    }
+
+    if (PaloMetrics::palo_push_count() != NULL) {
+        PaloMetrics::palo_push_count()->increment(requests.size());
+    }
+    OLAP_LOG_INFO("success to finish push batch. cost: %ld. [table=%s pushes=%lu]",
+            cost, olap_table->full_name().c_str(), requests.size());
+    return res;
+}
+
 OLAPStatus CommandExecutor::base_expansion(
         TTabletId tablet_id,
         TSchemaHash schema_hash,
@@ -600,6 +855,163 @@ OLAPStatus CommandExecutor::load_header(
     return res;
 }
 
+OLAPStatus CommandExecutor::clone_incremental_data(
+        const string& clone_dir,
+        TTabletId tablet_id,
+        TSchemaHash schema_hash,
+        const vector<Version>& missing_versions) {
+    OLAP_LOG_INFO("begin to process clone incremental data. "
+                  "[tablet_id=%ld schema_hash=%d clone_dir=%s missing_versions=%lu]",
+                  tablet_id, schema_hash, clone_dir.c_str(), missing_versions.size());
+
+    SmartOLAPTable tablet = OLAPEngine::get_instance()->get_table(tablet_id, schema_hash);
+    if (tablet.get() == NULL) {
+        OLAP_LOG_WARNING("can't find tablet. [tablet_id=%ld schema_hash=%d]",
+                         tablet_id, schema_hash);
+        return OLAP_ERR_TABLE_NOT_FOUND;
+    }
+
+    stringstream header_path_stream;
+    header_path_stream << clone_dir << "/" << tablet_id << ".hdr";
+    string clone_header_path = header_path_stream.str();
+    OLAPHeader clone_header(clone_header_path);
+    OLAPStatus res = clone_header.load();
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to load clone header. [res=%d header_file=%s]",
+                         res, clone_header_path.c_str());
+        return res;
+    }
+
+    set<Version> missing_version_set(missing_versions.begin(), missing_versions.end());
+    vector<Version> added_versions;
+
+    tablet->obtain_push_lock();
+    tablet->obtain_header_wrlock();
+    for (int i = 0; i < clone_header.file_version_size(); ++i) {
+        const FileVersionMessage& file_version = clone_header.file_version(i);
+        Version version(file_version.start_version(), file_version.end_version());
+        if (missing_version_set.find(version) == missing_version_set.end()) {
+            OLAP_LOG_WARNING("clone header has unexpected version. [version='%d-%d']",
+                             version.first, version.second);
+            res = OLAP_ERR_VERSION_NOT_EXIST;
+            break;
+        }
+
+        // 在下载期间本地已经导入的版本直接跳过
+        if (tablet->has_version(version)) {
+            OLAP_LOG_INFO("skip version which tablet has got. [version='%d-%d']",
+                          version.first, version.second);
+            continue;
+        }
+
+        vector<string> from_paths;
+        vector<string> to_paths;
+        OLAPTable::construct_version_file_paths(
+                clone_header_path, version, file_version.version_hash(),
+                file_version.num_segments(), file_version.packed(), &from_paths);
+        OLAPTable::construct_version_file_paths(
+                tablet->header_file_name(), version, file_version.version_hash(),
+                file_version.num_segments(), file_version.packed(), &to_paths);
+        for (size_t j = 0; j < from_paths.size(); ++j) {
+            if (link(from_paths[j].c_str(), to_paths[j].c_str()) != 0) {
+                OLAP_LOG_WARNING("fail to create hard link. [from=%s to=%s errno=%d]",
+                                 from_paths[j].c_str(), to_paths[j].c_str(), Errno::no());
+                res = OLAP_ERR_OS_ERROR;
+                break;
+            }
+        }
+
+        OLAPIndex* index = NULL;
+        if (res == OLAP_SUCCESS) {
+            index = new(std::nothrow) OLAPIndex(tablet.get(),
+                                                version,
+                                                file_version.version_hash(),
+                                                false,
+                                                file_version.num_segments(),
+                                                file_version.creation_time());
+            if (index == NULL) {
+                OLAP_LOG_WARNING("fail to malloc OLAPIndex. [size=%ld]", sizeof(OLAPIndex));
+                res = OLAP_ERR_MALLOC_ERROR;
+            } else {
+                index->set_packed(file_version.packed());
+            }
+        }
+
+        if (res == OLAP_SUCCESS && (res = index->load()) != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to load index. [res=%d version='%d-%d']",
+                             res, version.first, version.second);
+        }
+
+        if (res == OLAP_SUCCESS && file_version.has_delta_pruning()) {
+            const DeltaPruning& pruning = file_version.delta_pruning();
+            vector<pair<string, string> > column_statistics_string(pruning.column_pruning_size());
+            vector<bool> null_flags(pruning.column_pruning_size());
+            for (int j = 0; j < pruning.column_pruning_size(); ++j) {
+                column_statistics_string[j].first = pruning.column_pruning(j).min();
+                column_statistics_string[j].second = pruning.column_pruning(j).max();
+                null_flags[j] = pruning.column_pruning(j).has_null_flag()
+                        && pruning.column_pruning(j).null_flag();
+            }
+            res = index->set_column_statistics_from_string(column_statistics_string, null_flags);
+            if (res != OLAP_SUCCESS) {
+                OLAP_LOG_WARNING("fail to set column statistics. [res=%d]", res);
+            }
+        }
+
+        if (res == OLAP_SUCCESS && (res = tablet->register_data_source(index)) != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to register data source. [res=%d version='%d-%d']",
+                             res, version.first, version.second);
+        }
+
+        if (res != OLAP_SUCCESS) {
+            if (index != NULL) {
+                index->delete_all_files();
+                SAFE_DELETE(index);
+            }
+            break;
+        }
+        added_versions.push_back(version);
+    }
+
+    // 删除版本的数据是空的delta, 删除条件需要随版本一起拷贝
+    if (res == OLAP_SUCCESS) {
+        for (const DeleteDataConditionMessage& condition : clone_header.delete_data_conditions()) {
+            Version version(condition.version(), condition.version());
+            if (std::find(added_versions.begin(), added_versions.end(), version)
+                    != added_versions.end()) {
+                tablet->add_delete_data_conditions()->CopyFrom(condition);
+            }
+        }
+        res = tablet->save_header();
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to save header. [res=%d tablet='%s']",
+                             res, tablet->full_name().c_str());
+        }
+    }
+
+    if (res != OLAP_SUCCESS) {
+        // 回滚已经注册的版本, 保证失败时tablet维持原状
+        for (const Version& version : added_versions) {
+            OLAPIndex* index = NULL;
+            if (tablet->unregister_data_source(version, &index) == OLAP_SUCCESS) {
+                index->delete_all_files();
+                SAFE_DELETE(index);
+            }
+        }
+    }
+    tablet->release_header_lock();
+    tablet->release_push_lock();
+
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to process clone incremental data. [res=%d]", res);
+        return res;
+    }
+
+    OLAP_LOG_INFO("success to process clone incremental data. [added_versions=%lu]",
+                  added_versions.size());
+    return res;
+}
+
 OLAPStatus CommandExecutor::storage_medium_migrate(const TStorageMediumMigrateReq& request) {
     OLAP_LOG_INFO("begin to process storage media migrate. "
                   "[tablet_id=%ld schema_hash=%d dest_storage_medium=%d]",
@@ -63,6 +63,17 @@ public:
     // @return error code
     virtual OLAPStatus push(const TPushReq& request, std::vector<TTabletInfo>* tablet_info_vec);
 
+    // Push the local data files of several loads of consecutive versions into the
+    // same tablet at once.
+    //
+    // @param [in] requests the push requests ordered by version
+    // @param [out] tablet_info_vecs return tablet infos for each request
+    // @return error code, OLAP_ERR_PUSH_BATCH_NOT_APPLICABLE if the requests
+    //         must be pushed one by one
+    virtual OLAPStatus push_batch(
+            const std::vector<TPushReq>& requests,
+            std::vector<std::vector<TTabletInfo>>* tablet_info_vecs);
+
     // Report tablet detail information including
     // version info, row count, data size, etc.
     //
@@ -146,6 +157,21 @@ public:
             TTabletId tablet_id,
             TSchemaHash schema_hash);
 
+    // Add missing single deltas of an existing tablet from an incremental
+    // snapshot which has been downloaded to clone_dir. Data files are hard
+    // linked into tablet path, versions which the tablet has got meanwhile
+    // are skipped.
+    //
+    // @param [in] clone_dir dir contains header and files of incremental snapshot
+    // @param [in] tablet_id & schema_hash specify the local tablet
+    // @param [in] missing_versions versions requested in incremental snapshot
+    // @return OLAP_SUCCESS if all missing deltas are registered
+    virtual OLAPStatus clone_incremental_data(
+            const std::string& clone_dir,
+            TTabletId tablet_id,
+            TSchemaHash schema_hash,
+            const std::vector<Version>& missing_versions);
+
     // Release snapshot of base tablet after clone finished.
     //
     // @param [in] snapshot_path
@@ -188,6 +214,7 @@ public:
             TVersion version);
 
     // Compute checksum of Version(0,version) to diff between 3 copies.
+    // The checksum cached in header is returned if there is one.
     //
     // @param [in] tablet_id & schema_hash specify tablet
     // @param [in] version
@@ -200,6 +227,32 @@ public:
             TVersionHash version_hash,
             uint32_t* checksum);
 
+    // @param [in] force read all rows of version to compute checksum,
+    //             even if the checksum is cached in header
+    virtual OLAPStatus compute_checksum(
+            TTabletId tablet_id,
+            TSchemaHash schema_hash,
+            TVersion version,
+            TVersionHash version_hash,
+            bool force,
+            uint32_t* checksum);
+
+    // Look up rows of UNIQUE/AGG tablet by full keys at Version(0,version), rows of
+    // all deltas with the same key are merged. Rows found are cached in row cache
+    // if it is enabled.
+    //
+    // @param [in] tablet_id & schema_hash specify tablet
+    // @param [in] keys values of all key columns of each row to look up
+    // @param [out] rows values of all columns of each key, empty if not found
+    // @return error code
+    virtual OLAPStatus lookup_rows(
+            TTabletId tablet_id,
+            TSchemaHash schema_hash,
+            TVersion version,
+            TVersionHash version_hash,
+            const std::vector<std::vector<std::string> >& keys,
+            std::vector<std::vector<std::string> >* rows);
+
     // Reload multiple root paths split by ';'.
     //
     // @param root_paths for example: "/home/disk1/data;/home/disk2/data"
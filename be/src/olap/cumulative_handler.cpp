@@ -66,16 +66,23 @@ OLAPStatus CumulativeHandler::init(SmartOLAPTable table) {
     }
 
     OLAPStatus res = OLAP_SUCCESS;
-    _obtain_header_rdlock();
-    res = _check_whether_satisfy_policy();
-    _release_header_lock();
-    if (res != OLAP_SUCCESS) {
-        _table->release_cumulative_lock();
-        return res;
+    bool is_size_tiered = config::cumulative_compaction_policy == "size_tiered";
+    if (!is_size_tiered) {
+        _obtain_header_rdlock();
+        res = _check_whether_satisfy_policy();
+        _release_header_lock();
+        if (res != OLAP_SUCCESS) {
+            _table->release_cumulative_lock();
+            return res;
+        }
     }
 
     _obtain_header_wrlock();
-    res = _calculate_need_merged_versions();
+    if (is_size_tiered) {
+        res = _calculate_size_tiered_versions();
+    } else {
+        res = _calculate_need_merged_versions();
+    }
     _release_header_lock();
     if (res != OLAP_SUCCESS) {
         _table->release_cumulative_lock();
@@ -102,6 +109,8 @@ OLAPStatus CumulativeHandler::run() {
         OLAP_LOG_WARNING("cumulative handler is not inited.");
         return OLAP_ERR_NOT_INITED;
     }
+    ScopedLatencyRecorder latency_recorder(PaloMetrics::compaction_latency() != NULL
+            ? PaloMetrics::compaction_latency()->get("cumulative") : NULL);
 
     // 0. 准备工作
     OLAP_LOG_INFO("start cumulative expansion [table=%s; cumulative_version=%d-%d]",
@@ -321,6 +330,96 @@ static bool version_comparator(const Version& lhs, const Version& rhs) {
     return lhs.second < rhs.second;
 }
 
+// 大小为size的版本所在的层, 第i层的版本小于base_size * fan_in ^ i
+static int32_t size_tier(size_t size, size_t base_size, size_t fan_in) {
+    int32_t tier = 0;
+    for (size_t bound = base_size; size >= bound; bound *= fan_in) {
+        ++tier;
+    }
+    return tier;
+}
+
+OLAPStatus CumulativeHandler::_calculate_size_tiered_versions() {
+    const FileVersionMessage* latest_version = _table->latest_version();
+    if (latest_version == NULL) {
+        return OLAP_ERR_CUMULATIVE_NO_SUITABLE_VERSIONS;
+    }
+
+    Versions path_versions;
+    if (OLAP_SUCCESS != _table->select_versions_to_span(
+            Version(0, latest_version->end_version()), &path_versions)) {
+        OLAP_LOG_WARNING("fail to select shortest version path. [start=%d; end=%d]",
+                         0, latest_version->end_version());
+        return OLAP_ERR_CUMULATIVE_NO_SUITABLE_VERSIONS;
+    }
+    sort(path_versions.begin(), path_versions.end(), version_comparator);
+    // push可能会重复导入最新版本的delta, 不合并最新的delta
+    if (!path_versions.empty()
+            && path_versions.back().first == path_versions.back().second) {
+        path_versions.pop_back();
+    }
+
+    size_t fan_in = std::max(2, config::ce_tier_fan_in);
+    size_t base_size = std::max(1L, config::ce_tier_base_size);
+    size_t max_tiny_size = _max_delta_file_size * config::cumulative_source_overflow_ratio;
+    Versions best_versions;
+    int32_t best_tier = -1;
+
+    Versions run;
+    int32_t run_tier = -1;
+    size_t run_size = 0;
+    // 结束当前区间, 区间内的版本足够多且层更低时选择它
+    auto finish_run = [&]() {
+        if (run.size() >= fan_in && (best_tier < 0 || run_tier < best_tier)) {
+            best_versions = run;
+            best_tier = run_tier;
+        }
+        run.clear();
+        run_tier = -1;
+        run_size = 0;
+    };
+
+    for (const Version& version : path_versions) {
+        if (version.first == 0) {
+            continue;
+        }
+
+        size_t data_size = _table->get_version_entity_by_version(version).data_size;
+        if (data_size >= _max_delta_file_size
+                || _table->is_delete_data_version(version)
+                || _table->is_load_delete_version(version)) {
+            finish_run();
+            continue;
+        }
+
+        int32_t tier = size_tier(data_size, base_size, fan_in);
+        if (tier != run_tier) {
+            finish_run();
+            run_tier = tier;
+        }
+        run.push_back(version);
+        run_size += data_size;
+        // 较高的层每次合并fan_in个版本, 最低层合并所有相邻的小版本
+        if ((tier > 0 && run.size() == fan_in) || run_size >= max_tiny_size) {
+            finish_run();
+        }
+    }
+    finish_run();
+
+    if (best_versions.empty()) {
+        OLAP_LOG_TRACE("no versions of a size tier to merge. [table=%s]",
+                       _table->full_name().c_str());
+        return OLAP_ERR_CUMULATIVE_NO_SUITABLE_VERSIONS;
+    }
+
+    OLAP_LOG_INFO("satisfy size tiered cumulative policy. [table=%s tier=%d version_num=%lu]",
+                  _table->full_name().c_str(), best_tier, best_versions.size());
+    _need_merged_versions.swap(best_versions);
+    _new_cumulative_layer_point = std::max(_old_cumulative_layer_point,
+                                           _need_merged_versions.back().second + 1);
+    return OLAP_SUCCESS;
+}
+
 OLAPStatus CumulativeHandler::_get_delta_versions(Versions* delta_versions) {
     delta_versions->clear();
     
@@ -435,6 +534,9 @@ OLAPStatus CumulativeHandler::_do_cumulative_expansion() {
                       source_rows, merged_rows, filted_rows, _new_cumulative_index->num_rows());
     }
 
+    // warm up the caches of a hot table before the new cumulative file is visible
+    _table->warm_up_cache(_new_cumulative_index);
+
     // 3. add new cumulative file into table
     vector<OLAPIndex*> unused_indices;
     _obtain_header_wrlock();
@@ -472,6 +574,7 @@ OLAPStatus CumulativeHandler::_do_cumulative_expansion() {
     _release_header_lock();
 
     // 6. delete delta files which have been merged into new cumulative file
+    _table->evict_cache(unused_indices);
     _delete_unused_delta_files(&unused_indices);
 
     OLAP_LOG_INFO("succeed to do cumulative expansion. [table=%s; cumulative_version=%d-%d]",
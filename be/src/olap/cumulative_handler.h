@@ -74,6 +74,16 @@ private:
     // - 如果不成功，返回相应错误码
     OLAPStatus _calculate_need_merged_versions();
 
+    // 按size tiered策略计算可以合并的版本: 在base之后的版本路径上, 不含最新的delta,
+    // 被delete版本和不小于_max_delta_file_size的版本分隔的区间内, 找出大小属于同一层的
+    // 相邻版本, 选择层最低的一组合并. 最低层的相邻版本全部合并, 其他层每次合并
+    // ce_tier_fan_in个
+    //
+    // 返回值：
+    // - 如果成功，返回OLAP_SUCCESS
+    // - 如果没有可以合并的版本，返回OLAP_ERR_CUMULATIVE_NO_SUITABLE_VERSIONS
+    OLAPStatus _calculate_size_tiered_versions();
+
     // 获取table现有的delta文件
     //
     // 输出参数：
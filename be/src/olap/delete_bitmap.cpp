@@ -0,0 +1,233 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/delete_bitmap.h"
+
+#include <stdio.h>
+
+#include "gen_cpp/olap_file.pb.h"
+#include "olap/file_helper.h"
+#include "olap/utils.h"
+
+namespace palo {
+
+void DeleteBitmap::add(const Version& version, uint32_t segment, uint64_t row,
+                       int32_t deleted_by) {
+    RowMap& rows = _rows[version][segment];
+    RowMap::iterator it = rows.find(row);
+    if (it == rows.end()) {
+        rows[row] = deleted_by;
+    } else if (deleted_by < it->second) {
+        it->second = deleted_by;
+    }
+}
+
+bool DeleteBitmap::is_deleted(const Version& version, uint32_t segment, uint64_t row,
+                              int32_t max_version) const {
+    auto version_it = _rows.find(version);
+    if (version_it == _rows.end()) {
+        return false;
+    }
+    auto segment_it = version_it->second.find(segment);
+    if (segment_it == version_it->second.end()) {
+        return false;
+    }
+    RowMap::const_iterator it = segment_it->second.find(row);
+    return it != segment_it->second.end() && it->second <= max_version;
+}
+
+void DeleteBitmap::get_deleted_rows(const Version& version, int32_t max_version,
+                                    DeletedRows* rows) const {
+    rows->clear();
+    auto version_it = _rows.find(version);
+    if (version_it == _rows.end()) {
+        return;
+    }
+
+    for (auto& segment_it : version_it->second) {
+        std::vector<uint64_t>* segment_rows = NULL;
+        for (auto& it : segment_it.second) {
+            if (it.second > max_version) {
+                continue;
+            }
+            if (segment_rows == NULL) {
+                segment_rows = &(*rows)[segment_it.first];
+            }
+            segment_rows->push_back(it.first);
+        }
+    }
+}
+
+void DeleteBitmap::remove_version(const Version& version) {
+    _rows.erase(version);
+    _marked_versions.erase(version);
+}
+
+void DeleteBitmap::remove_deleted_by(const Version& version) {
+    for (auto& version_it : _rows) {
+        for (auto& segment_it : version_it.second) {
+            RowMap& rows = segment_it.second;
+            for (RowMap::iterator it = rows.begin(); it != rows.end();) {
+                if (it->second >= version.first && it->second <= version.second) {
+                    it = rows.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+}
+
+void DeleteBitmap::prune(const std::vector<Version>& versions) {
+    std::set<Version> existing(versions.begin(), versions.end());
+    auto is_covered = [&versions](int32_t deleted_by) {
+        for (const Version& version : versions) {
+            if (deleted_by >= version.first && deleted_by <= version.second) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    for (auto version_it = _rows.begin(); version_it != _rows.end();) {
+        if (existing.count(version_it->first) == 0) {
+            version_it = _rows.erase(version_it);
+            continue;
+        }
+        for (auto& segment_it : version_it->second) {
+            RowMap& rows = segment_it.second;
+            for (RowMap::iterator it = rows.begin(); it != rows.end();) {
+                if (!is_covered(it->second)) {
+                    it = rows.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        ++version_it;
+    }
+
+    for (auto it = _marked_versions.begin(); it != _marked_versions.end();) {
+        if (existing.count(*it) == 0) {
+            it = _marked_versions.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+size_t DeleteBitmap::num_deleted_rows() const {
+    size_t num_rows = 0;
+    for (auto& version_it : _rows) {
+        for (auto& segment_it : version_it.second) {
+            num_rows += segment_it.second.size();
+        }
+    }
+    return num_rows;
+}
+
+OLAPStatus DeleteBitmap::save(const std::string& file_name) const {
+    FileHeader<DeleteBitmapMessage> file_header;
+    DeleteBitmapMessage* message = file_header.mutable_message();
+    for (auto& version_it : _rows) {
+        for (auto& segment_it : version_it.second) {
+            if (segment_it.second.empty()) {
+                continue;
+            }
+            DeletedRowsMessage* deleted_rows = message->add_deleted_rows();
+            deleted_rows->set_start_version(version_it.first.first);
+            deleted_rows->set_end_version(version_it.first.second);
+            deleted_rows->set_segment(segment_it.first);
+            for (auto& it : segment_it.second) {
+                deleted_rows->add_row(it.first);
+                deleted_rows->add_deleted_by(it.second);
+            }
+        }
+    }
+    for (const Version& version : _marked_versions) {
+        MarkedVersionMessage* marked_version = message->add_marked_version();
+        marked_version->set_start_version(version.first);
+        marked_version->set_end_version(version.second);
+    }
+
+    // written aside and renamed, so that a crash never leaves a partial bitmap
+    std::string tmp_file_name = file_name + ".tmp";
+    FileHandler file_handler;
+    if (file_handler.open_with_mode(tmp_file_name.c_str(),
+            O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to open delete bitmap file. [file='%s']", tmp_file_name.c_str());
+        return OLAP_ERR_IO_ERROR;
+    }
+
+    if (file_header.prepare(&file_handler) != OLAP_SUCCESS
+            || file_header.serialize(&file_handler) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to serialize delete bitmap. [file='%s']", tmp_file_name.c_str());
+        return OLAP_ERR_SERIALIZE_PROTOBUF_ERROR;
+    }
+
+    if (file_handler.close() != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to close delete bitmap file. [file='%s']", tmp_file_name.c_str());
+        return OLAP_ERR_IO_ERROR;
+    }
+
+    if (rename(tmp_file_name.c_str(), file_name.c_str()) != 0) {
+        OLAP_LOG_WARNING("fail to rename delete bitmap file. [file='%s' err=%m]",
+                         file_name.c_str());
+        return OLAP_ERR_IO_ERROR;
+    }
+
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus DeleteBitmap::load(const std::string& file_name) {
+    clear();
+    if (!check_dir_existed(file_name)) {
+        return OLAP_ERR_FILE_NOT_EXIST;
+    }
+
+    FileHeader<DeleteBitmapMessage> file_header;
+    FileHandler file_handler;
+    if (file_handler.open(file_name.c_str(), O_RDONLY) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to open delete bitmap file. [file='%s']", file_name.c_str());
+        return OLAP_ERR_IO_ERROR;
+    }
+
+    if (file_header.unserialize(&file_handler) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to unserialize delete bitmap. [file='%s']", file_name.c_str());
+        return OLAP_ERR_PARSE_PROTOBUF_ERROR;
+    }
+
+    const DeleteBitmapMessage& message = file_header.message();
+    for (const DeletedRowsMessage& deleted_rows : message.deleted_rows()) {
+        if (deleted_rows.row_size() != deleted_rows.deleted_by_size()) {
+            OLAP_LOG_WARNING("invalid delete bitmap. [file='%s']", file_name.c_str());
+            clear();
+            return OLAP_ERR_PARSE_PROTOBUF_ERROR;
+        }
+        Version version(deleted_rows.start_version(), deleted_rows.end_version());
+        RowMap& rows = _rows[version][deleted_rows.segment()];
+        for (int i = 0; i < deleted_rows.row_size(); ++i) {
+            rows[deleted_rows.row(i)] = deleted_rows.deleted_by(i);
+        }
+    }
+    for (const MarkedVersionMessage& marked_version : message.marked_version()) {
+        _marked_versions.insert(
+                Version(marked_version.start_version(), marked_version.end_version()));
+    }
+
+    return OLAP_SUCCESS;
+}
+
+}  // namespace palo
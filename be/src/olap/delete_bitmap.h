@@ -0,0 +1,100 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_DELETE_BITMAP_H
+#define BDG_PALO_BE_SRC_OLAP_DELETE_BITMAP_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "olap/olap_common.h"
+#include "olap/olap_define.h"
+
+namespace palo {
+
+// DeleteBitmap records the rows of a merge-on-write UNIQUE_KEYS table which are
+// replaced by a row with equal key in a newer version, so that the versions can be
+// read one by one skipping the replaced rows instead of merging them.
+//
+// A version is marked once the keys of all its rows are looked up in the older
+// versions. Readers skip the merge only if every version they read is marked except
+// the base version, which has no older version to look up. Versions which are not
+// marked, e.g. too large to look up or added by a clone, are merged as before.
+class DeleteBitmap {
+public:
+    // segment -> ids of its replaced rows, in ascending order
+    typedef std::map<uint32_t, std::vector<uint64_t>> DeletedRows;
+
+    DeleteBitmap() {}
+
+    // Records that 'row' of 'segment' in 'version' is replaced by the version ending at
+    // 'deleted_by'. The oldest one is kept if the row is replaced more than once.
+    void add(const Version& version, uint32_t segment, uint64_t row, int32_t deleted_by);
+
+    // Whether the row is replaced by a version not newer than 'max_version'
+    bool is_deleted(const Version& version, uint32_t segment, uint64_t row,
+                    int32_t max_version) const;
+
+    // The rows of 'version' replaced by versions not newer than 'max_version'
+    void get_deleted_rows(const Version& version, int32_t max_version,
+                          DeletedRows* rows) const;
+
+    void set_marked(const Version& version) {
+        _marked_versions.insert(version);
+    }
+
+    void clear_marked(const Version& version) {
+        _marked_versions.erase(version);
+    }
+
+    bool is_marked(const Version& version) const {
+        return _marked_versions.count(version) > 0;
+    }
+
+    // Forgets the rows of 'version' and its mark.
+    void remove_version(const Version& version);
+
+    // Forgets the rows replaced by the versions ending in 'version'.
+    void remove_deleted_by(const Version& version);
+
+    // Drops what refers to a version which is not covered by any of 'versions',
+    // e.g. the versions added or removed after the bitmap was saved.
+    void prune(const std::vector<Version>& versions);
+
+    size_t num_deleted_rows() const;
+
+    void clear() {
+        _rows.clear();
+        _marked_versions.clear();
+    }
+
+    OLAPStatus save(const std::string& file_name) const;
+
+    // Returns OLAP_ERR_FILE_NOT_EXIST if the bitmap has never been saved.
+    OLAPStatus load(const std::string& file_name);
+
+private:
+    // row id -> end version of the version which replaces the row
+    typedef std::map<uint64_t, int32_t> RowMap;
+
+    std::map<Version, std::map<uint32_t, RowMap>> _rows;
+    std::set<Version> _marked_versions;
+};
+
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_OLAP_DELETE_BITMAP_H
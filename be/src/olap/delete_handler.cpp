@@ -409,6 +409,23 @@ bool DeleteHandler::is_filter_data(const int32_t data_version,
     return false;
 }
 
+bool DeleteHandler::is_filter_data(const int32_t data_version,
+                                   const RowCursor& row,
+                                   uint64_t condition_mask) const {
+    for (size_t i = 0; i < _del_conds.size(); ++i) {
+        if (i < MAX_MASKED_CONDITIONS && 0 == (condition_mask & (1UL << i))) {
+            continue;
+        }
+
+        if (data_version <= _del_conds[i].filter_version
+                && _del_conds[i].del_cond->delete_conditions_eval(row)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 vector<int32_t> DeleteHandler::get_conds_version() {
     vector<int32_t> conds_version;
     vector<DeleteConditions>::const_iterator cond_iter = _del_conds.begin();
@@ -131,6 +131,8 @@ public:
     typedef std::vector<DeleteConditions>::size_type cond_num_t;
     typedef google::protobuf::RepeatedPtrField<DeleteDataConditionMessage> del_cond_array;
 
+    static const size_t MAX_MASKED_CONDITIONS = 64;
+
     DeleteHandler() : _is_inited(false) {}
     ~DeleteHandler() {}
 
@@ -160,6 +162,13 @@ public:
     //     * false: 数据不符合删除条件
     bool is_filter_data(const int32_t data_version, const RowCursor& row) const;
 
+    // 同上，但只用condition_mask中置位的删除条件判定。第k位对应第k个删除条件，
+    // 下标不小于MAX_MASKED_CONDITIONS的删除条件总是参与判定。
+    // 用于block级别已经排除了部分删除条件的场景(见SegmentReader::_pick_delete_row_groups)
+    bool is_filter_data(const int32_t data_version,
+                        const RowCursor& row,
+                        uint64_t condition_mask) const;
+
     // 返回handler中有存有多少条删除条件
     cond_num_t conditions_num() const{
         return _del_conds.size();
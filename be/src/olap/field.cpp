@@ -17,6 +17,10 @@
 #include <map>
 #include <sstream>
 #include <string>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "olap/field.h"
 #include "exprs/aggregate_functions.h"
 
@@ -235,6 +239,64 @@ uint32_t FieldInfo::get_field_length_by_type(TPrimitiveType::type type, uint32_t
     }
 }
 
+template <typename FieldClass>
+static int typed_field_cmp(const Field* left, const Field* right) {
+    bool left_null = left->is_null();
+    bool right_null = right->is_null();
+    if (OLAP_UNLIKELY(left_null || right_null)) {
+        return left_null == right_null ? 0 : (left_null ? -1 : 1);
+    }
+
+    return static_cast<const FieldClass*>(left)->FieldClass::real_cmp(right);
+}
+
+static int generic_field_cmp(const Field* left, const Field* right) {
+    return left->cmp(right);
+}
+
+FieldCmpFunc get_field_cmp_func(FieldType type) {
+    switch (type) {
+    case OLAP_FIELD_TYPE_TINYINT:
+        return &typed_field_cmp<BaseField<int8_t> >;
+    case OLAP_FIELD_TYPE_SMALLINT:
+        return &typed_field_cmp<BaseField<int16_t> >;
+    case OLAP_FIELD_TYPE_INT:
+        return &typed_field_cmp<BaseField<int32_t> >;
+    case OLAP_FIELD_TYPE_BIGINT:
+        return &typed_field_cmp<BaseField<int64_t> >;
+    case OLAP_FIELD_TYPE_LARGEINT:
+        return &typed_field_cmp<BaseField<int128_t> >;
+    case OLAP_FIELD_TYPE_UNSIGNED_TINYINT:
+        return &typed_field_cmp<BaseField<uint8_t> >;
+    case OLAP_FIELD_TYPE_UNSIGNED_SMALLINT:
+        return &typed_field_cmp<BaseField<uint16_t> >;
+    case OLAP_FIELD_TYPE_UNSIGNED_INT:
+        return &typed_field_cmp<BaseField<uint32_t> >;
+    case OLAP_FIELD_TYPE_UNSIGNED_BIGINT:
+        return &typed_field_cmp<BaseField<uint64_t> >;
+    case OLAP_FIELD_TYPE_FLOAT:
+        return &typed_field_cmp<BaseField<float> >;
+    case OLAP_FIELD_TYPE_DOUBLE:
+        return &typed_field_cmp<BaseField<double> >;
+    case OLAP_FIELD_TYPE_DISCRETE_DOUBLE:
+        return &typed_field_cmp<DiscreteDoubleField>;
+    case OLAP_FIELD_TYPE_CHAR:
+        return &typed_field_cmp<CharField>;
+    case OLAP_FIELD_TYPE_DATE:
+        return &typed_field_cmp<DateField>;
+    case OLAP_FIELD_TYPE_DATETIME:
+        return &typed_field_cmp<DateTimeField>;
+    case OLAP_FIELD_TYPE_DECIMAL:
+        return &typed_field_cmp<DecimalField>;
+    case OLAP_FIELD_TYPE_VARCHAR:
+        return &typed_field_cmp<VarCharField>;
+    case OLAP_FIELD_TYPE_HLL:
+        return &typed_field_cmp<HllField>;
+    default:
+        return &generic_field_cmp;
+    }
+}
+
 Field* Field::create(const FieldInfo& field_info) {
     Field* field = NULL;
 
@@ -876,7 +938,6 @@ void HllSetResolver::parse() {
     // skip LengthValueType
     char*  pdata = _buf_ref;
     _set_type = (HllDataType)pdata[0];
-    char* sparse_data = NULL;
     switch (_set_type) {
         case HLL_DATA_EXPLICIT:
             // first byte : type
@@ -890,15 +951,11 @@ void HllSetResolver::parse() {
             // first byte : type
             // second ～（2^HLL_COLUMN_PRECISION)/8 byte : bitmap mark which is not zero
             // 2^HLL_COLUMN_PRECISION)/8 ＋ 1以后value
+            // the (index, value) pairs are only read into a map by get_sparse_map()
             _sparse_count = (SparseLengthValueType*)(pdata + sizeof (SetTypeValueType));
-            sparse_data = pdata + sizeof(SetTypeValueType) + sizeof(SparseLengthValueType);
-            for (int i = 0; i < *_sparse_count; i++) {
-                SparseIndexType* index = (SparseIndexType*)sparse_data;
-                sparse_data += sizeof(SparseIndexType);
-                SparseValueType* value = (SparseValueType*)sparse_data;
-                _sparse_map[*index] = *value;
-                sparse_data += sizeof(SetTypeValueType);
-            }
+            _sparse_data = pdata + sizeof(SetTypeValueType) + sizeof(SparseLengthValueType);
+            _sparse_map.clear();
+            _sparse_map_filled = false;
             break;
         case HLL_DATA_FULL:
             // first byte : type
@@ -911,6 +968,22 @@ void HllSetResolver::parse() {
     }
 }
 
+std::map<HllSetResolver::SparseIndexType, HllSetResolver::SparseValueType>&
+        HllSetResolver::get_sparse_map() {
+    if (!_sparse_map_filled && _set_type == HLL_DATA_SPRASE) {
+        char* sparse_data = _sparse_data;
+        for (int i = 0; i < *_sparse_count; i++) {
+            SparseIndexType* index = (SparseIndexType*)sparse_data;
+            sparse_data += sizeof(SparseIndexType);
+            SparseValueType* value = (SparseValueType*)sparse_data;
+            _sparse_map[*index] = *value;
+            sparse_data += sizeof(SparseValueType);
+        }
+        _sparse_map_filled = true;
+    }
+    return _sparse_map;
+}
+
 void HllSetResolver::fill_registers(char* registers, int len) {
 
     if (_set_type == HLL_DATA_EXPLICIT) {
@@ -921,17 +994,16 @@ void HllSetResolver::fill_registers(char* registers, int len) {
             registers[idx] = std::max((uint8_t)registers[idx], first_one_bit);
         }
     } else if (_set_type == HLL_DATA_SPRASE) {
-        std::map<SparseIndexType, SparseValueType>& sparse_map = get_sparse_map();
-        for (std::map<SparseIndexType, SparseValueType>::iterator iter = sparse_map.begin();
-                                                 iter != sparse_map.end(); iter++) {
-            registers[iter->first] = std::max((uint8_t)registers[iter->first], (uint8_t)iter->second);
+        // read the pairs in place, without building the map
+        const char* sparse_data = _sparse_data;
+        for (int i = 0; i < *_sparse_count; i++) {
+            SparseIndexType index = *(const SparseIndexType*)sparse_data;
+            SparseValueType value = *(const SparseValueType*)(sparse_data + sizeof(SparseIndexType));
+            registers[index] = std::max((uint8_t)registers[index], (uint8_t)value);
+            sparse_data += sizeof(SparseIndexType) + sizeof(SparseValueType);
         }
     } else if (_set_type == HLL_DATA_FULL) {
-        char* full_value = get_full_value();
-        for (int i = 0; i < len; i++) {
-            registers[i] = std::max((uint8_t)registers[i], (uint8_t)full_value[i]);
-        }
-        
+        HllSetHelper::merge_registers(registers, get_full_value(), len);
     } else {
       // HLL_DATA_EMPTY
     }
@@ -1001,6 +1073,25 @@ void HllSetHelper::set_sparse(char *result, const std::map<int, uint8_t>& index_
     *(int*)(result + 1) = registers_count;
 }
 
+void HllSetHelper::set_sparse(char* result, const char* registers, int registers_len, int& len) {
+    result[0] = HLL_DATA_SPRASE;
+    len = sizeof(HllSetResolver::SetTypeValueType) + sizeof(HllSetResolver::SparseLengthValueType);
+    char* write_value_pos = result + len;
+    int registers_count = 0;
+    for (int i = 0; i < registers_len; i++) {
+        if (registers[i] == 0) {
+            continue;
+        }
+        write_value_pos[0] = (char)(i & 0xff);
+        write_value_pos[1] = (char)(i >> 8 & 0xff);
+        write_value_pos[2] = registers[i];
+        write_value_pos += 3;
+        registers_count++;
+    }
+    len += registers_count * (sizeof(HllSetResolver::SparseIndexType) + sizeof(HllSetResolver::SparseValueType));
+    *(int*)(result + 1) = registers_count;
+}
+
 void HllSetHelper::set_expliclit(char* result, const std::set<uint64_t>& hash_value_set, int& len) {
     result[0] = HLL_DATA_EXPLICIT;
     result[1] = (HllSetResolver::ExpliclitLengthValueType)hash_value_set.size();
@@ -1043,24 +1134,52 @@ void HllSetHelper::set_max_register(char* registers, int registers_len,
     }    
 }
 
+void HllSetHelper::merge_registers(char* registers, const char* other, int registers_len) {
+    int i = 0;
+#ifdef __SSE2__
+    for (; i + 16 <= registers_len; i += 16) {
+        __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(registers + i));
+        __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(other + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(registers + i), _mm_max_epu8(left, right));
+    }
+#endif
+    for (; i < registers_len; i++) {
+        registers[i] = std::max((uint8_t)registers[i], (uint8_t)other[i]);
+    }
+}
+
+int HllSetHelper::count_non_zero_registers(const char* registers, int registers_len) {
+    int count = 0;
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= registers_len; i += 16) {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(registers + i));
+        int zero_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(value, zero));
+        count += 16 - __builtin_popcount(zero_mask);
+    }
+#endif
+    for (; i < registers_len; i++) {
+        count += (registers[i] != 0);
+    }
+    return count;
+}
+
 template <typename T>
 void FieldHllUnionAggreator<T>::finalize_one_merge(T t) {
     char* buf = (char*)t;
     if (!_has_value) {
         return;
     }
-    std::map<int, uint8_t> index_to_value;
+    int non_zero_count = 0;
     if (_hash64_set.size() > HLL_EXPLICLIT_INT64_NUM 
               || _has_sparse_or_full) {
+        _registers_used = true;
         HllSetHelper::set_max_register(_registers, HLL_REGISTERS_COUNT, _hash64_set);
-        for (int i = 0; i < HLL_REGISTERS_COUNT; i++) {
-            if (_registers[i] != 0) { 
-                index_to_value[i] = _registers[i];
-            }    
-        } 
+        non_zero_count = HllSetHelper::count_non_zero_registers(_registers, HLL_REGISTERS_COUNT);
     }    
     int length_value_type_len = sizeof(VarCharField::LengthValueType);
-    int sparse_set_len = index_to_value.size() *
+    int sparse_set_len = non_zero_count *
                          (sizeof(HllSetResolver::SparseIndexType) 
                          + sizeof(HllSetResolver::SparseValueType))
                          + sizeof(HllSetResolver::SparseLengthValueType); 
@@ -1070,10 +1189,10 @@ void FieldHllUnionAggreator<T>::finalize_one_merge(T t) {
         // full set
         HllSetHelper::set_full(buf + length_value_type_len, _registers, 
                                HLL_REGISTERS_COUNT, result_len);
-    } else if (index_to_value.size() > 0) {
+    } else if (non_zero_count > 0) {
         // sparse set
-        HllSetHelper::set_sparse(buf + length_value_type_len, 
-                                 index_to_value, result_len); 
+        HllSetHelper::set_sparse(buf + length_value_type_len, _registers,
+                                 HLL_REGISTERS_COUNT, result_len); 
     } else if (_hash64_set.size() > 0) {
         // expliclit set
         HllSetHelper::set_expliclit(buf + length_value_type_len,
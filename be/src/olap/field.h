@@ -314,6 +314,8 @@ public:
 
     // is bloom filter column
     bool is_bf_column;
+    // 使用按cache line分块的bloom filter, 只在is_bf_column时有效
+    bool is_blocked_bf;
 public:
     static std::string get_string_by_field_type(FieldType type);
     static std::string get_string_by_aggregation_type(FieldAggregationMethod aggregation_type);
@@ -871,7 +873,10 @@ public:
                        _set_type(HLL_DATA_EMPTY),
                        _full_value_position(nullptr),
                        _expliclit_value(nullptr),
-                       _expliclit_num(0) {
+                       _expliclit_num(0),
+                       _sparse_data(nullptr),
+                       _sparse_count(nullptr),
+                       _sparse_map_filled(false) {
     }
 
     typedef uint8_t SetTypeValueType;
@@ -919,10 +924,8 @@ public:
         return (int)*_sparse_count; 
     };
 
-    // get (index, value) map
-    std::map<SparseIndexType, SparseValueType>& get_sparse_map() { 
-        return _sparse_map; 
-    };
+    // get (index, value) map, built on first use
+    std::map<SparseIndexType, SparseValueType>& get_sparse_map();
     
     // parse set , call after copy() or init()
     void parse();
@@ -944,8 +947,11 @@ private :
     char* _full_value_position;
     uint64_t* _expliclit_value;
     ExpliclitLengthValueType _expliclit_num;
-    std::map<SparseIndexType, SparseValueType> _sparse_map;
+    // (index, value) pairs of a sparse set
+    char* _sparse_data;
     SparseLengthValueType* _sparse_count;
+    std::map<SparseIndexType, SparseValueType> _sparse_map;
+    bool _sparse_map_filled;
 };
 
 class HllSetHelper {
@@ -954,6 +960,9 @@ public:
 
     static void set_sparse(char *result,const std::map<int, uint8_t>& index_to_value, int& len);
 
+    // sparse set of the non-zero registers
+    static void set_sparse(char* result, const char* registers, int registers_len, int& len);
+
     static void set_expliclit(char* result, const std::set<uint64_t>& hash_value_set, int& len);
 
     static void set_full(char* result, const char* registers, const int set_len, int& len);
@@ -964,6 +973,11 @@ public:
     static void set_max_register(char *registers,
                                  int registers_len, 
                                  const std::set<uint64_t>& hash_set);
+
+    // registers[i] = max(registers[i], other[i]), 16 registers at a time
+    static void merge_registers(char* registers, const char* other, int registers_len);
+
+    static int count_non_zero_registers(const char* registers, int registers_len);
 };
 
 // 通过varchar的变长编码方式实现hll集合
@@ -1026,7 +1040,7 @@ class FieldHllUnionAggreator : public FieldAggregator<T> {
 
 public: 
 
-    FieldHllUnionAggreator() {
+    FieldHllUnionAggreator() : _registers_used(true) {
         reset();
     } 
     
@@ -1053,6 +1067,7 @@ public:
         } else if (resolver.get_hll_data_type() != HLL_DATA_EMPTY) {
             // full or sparse
             _has_sparse_or_full = true;
+            _registers_used = true;
             resolver.fill_registers(_registers, HLL_REGISTERS_COUNT);
         } else {
             // empty
@@ -1062,7 +1077,11 @@ public:
     virtual void finalize_one_merge(T t);
 
     void reset() {
-        memset(_registers, 0, HLL_REGISTERS_COUNT);
+        // merges of explicit sets only don't touch the registers
+        if (_registers_used) {
+            memset(_registers, 0, HLL_REGISTERS_COUNT);
+            _registers_used = false;
+        }
         _hash64_set.clear();
         _has_value = false;
         _has_sparse_or_full = false;
@@ -1072,6 +1091,7 @@ private:
 
     bool _has_value;
     bool _has_sparse_or_full;
+    bool _registers_used;
     char _registers[HLL_REGISTERS_COUNT];
     std::set<uint64_t> _hash64_set;
 };
@@ -1552,6 +1572,13 @@ bool Field::equal(const Field* field) {
     return memcmp_sse(_buf, field->buf(), size()) == 0;
 }
 
+// 比较同一类型的两个field, NULL小于任何值. 按列的类型选定一次后逐值调用,
+// 代替cmp()中每次对类型的switch和对real_cmp()的虚函数调用
+typedef int (*FieldCmpFunc)(const Field* left, const Field* right);
+
+// 返回type类型的比较函数, 未知类型返回调用Field::cmp()的函数
+FieldCmpFunc get_field_cmp_func(FieldType type);
+
 void Field::to_mysql() {
     if (OLAP_UNLIKELY(_field_type == OLAP_FIELD_TYPE_DISCRETE_DOUBLE)) {
         reinterpret_cast<DiscreteDoubleField*>(this)->DiscreteDoubleField::to_mysql(_buf);
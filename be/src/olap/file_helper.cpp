@@ -23,22 +23,35 @@
 
 #include <errno.h>
 
+#include <boost/algorithm/string.hpp>
+
+#include "common/config.h"
 #include "olap/olap_common.h"
 #include "olap/olap_define.h"
 #include "olap/olap_engine.h"
+#include "olap/tablet_access_stats.h"
+#include "olap/sync_coordinator.h"
 #include "olap/utils.h"
 #include "util/debug_util.h"
+#include "util/disk_io_stats.h"
+#include "util/io_throttle.h"
+#include "util/stopwatch.hpp"
 
 using std::string;
+using std::vector;
 
 namespace palo {
 
 FileHandler::FileHandler() :
         _fd(-1),
         _wr_length(0),
+        _written(false),
         _file_name(""),
         _is_using_cache(false),
-        _cache_handle(NULL) {
+        _cache_handle(NULL),
+        _io_stats(NULL),
+        _region_offset(0),
+        _region_length(-1) {
     _fd_cache = OLAPEngine::get_instance()->file_descriptor_lru_cache();
 }
 
@@ -47,7 +60,7 @@ FileHandler::~FileHandler() {
 }
 
 OLAPStatus FileHandler::open(const string& file_name, int flag) {
-    if (_fd != -1 && _file_name == file_name) {
+    if (_fd != -1 && _file_name == file_name && _region_length < 0) {
         return OLAP_SUCCESS;
     }
 
@@ -67,11 +80,12 @@ OLAPStatus FileHandler::open(const string& file_name, int flag) {
                    file_name.c_str(), flag, _fd);
     _is_using_cache = false;
     _file_name = file_name;
+    _io_stats = DiskIoStats::find(file_name);
     return OLAP_SUCCESS;
 }
 
 OLAPStatus FileHandler::open_with_cache(const string& file_name, int flag) {
-    if (_fd != -1 && _file_name == file_name) {
+    if (_fd != -1 && _file_name == file_name && _region_length < 0) {
         return OLAP_SUCCESS;
     }
 
@@ -79,6 +93,7 @@ OLAPStatus FileHandler::open_with_cache(const string& file_name, int flag) {
         return OLAP_ERR_IO_ERROR;
     }
 
+    _fd_cache = OLAPEngine::get_instance()->file_descriptor_lru_cache(file_name);
     CacheKey key(file_name.c_str(), file_name.size());
     _cache_handle = _fd_cache->lookup(key);
     if (NULL != _cache_handle) {
@@ -103,11 +118,12 @@ OLAPStatus FileHandler::open_with_cache(const string& file_name, int flag) {
     }
     _is_using_cache = true;
     _file_name = file_name;
+    _io_stats = DiskIoStats::find(file_name);
     return OLAP_SUCCESS;
 }
 
 OLAPStatus FileHandler::open_with_mode(const string& file_name, int flag, int mode) {
-    if (_fd != -1 && _file_name == file_name) {
+    if (_fd != -1 && _file_name == file_name && _region_length < 0) {
         return OLAP_SUCCESS;
     }
 
@@ -126,6 +142,27 @@ OLAPStatus FileHandler::open_with_mode(const string& file_name, int flag, int mo
     OLAP_LOG_DEBUG("success to open file. [file_name='%s' flag=%d mode=%d fd=%d]",
                    file_name.c_str(), flag, mode, _fd);
     _file_name = file_name;
+    _io_stats = DiskIoStats::find(file_name);
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus FileHandler::open_region_with_cache(
+        const string& file_name, off_t offset, off_t length) {
+    if (_fd != -1 && _file_name == file_name
+            && _region_offset == offset && _region_length == length) {
+        return OLAP_SUCCESS;
+    }
+
+    if (OLAP_SUCCESS != this->close()) {
+        return OLAP_ERR_IO_ERROR;
+    }
+
+    OLAPStatus res = open_with_cache(file_name, O_RDONLY);
+    if (OLAP_SUCCESS != res) {
+        return res;
+    }
+    _region_offset = offset;
+    _region_length = length;
     return OLAP_SUCCESS;
 }
 
@@ -141,16 +178,28 @@ OLAPStatus FileHandler::close() {
         return OLAP_SUCCESS;
     }
 
+    OLAPStatus res = OLAP_SUCCESS;
     if (_is_using_cache) {
         release();
     } else {
-        // try to sync page cache if have written some bytes
-        if (_wr_length > 0) {
+        SyncCoordinator* sync_coordinator = NULL;
+        if (_written && config::enable_group_sync) {
+            sync_coordinator = SyncCoordinator::find(_file_name);
+        }
+        if (sync_coordinator != NULL) {
+            // The file is on disk before it's closed, along with the files closed at
+            // the same time under the root path
+            res = sync_coordinator->sync(_fd, _file_name);
+            posix_fadvise(_fd, 0, 0, POSIX_FADV_DONTNEED);
+            _wr_length = 0;
+        } else if (_wr_length > 0) {
+            // try to sync page cache if have written some bytes
             posix_fadvise(_fd, 0, 0, POSIX_FADV_DONTNEED);
             // Clean dirty pages and wait for io queue empty and return
             sync_file_range(_fd, 0, 0, SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
             _wr_length = 0;
         }
+        _written = false;
 
         // 在一些极端情况下(fd可用,但fsync失败)可能造成句柄泄漏
         if (::close(_fd) < 0) {
@@ -163,14 +212,22 @@ OLAPStatus FileHandler::close() {
     _fd = -1;
     _file_name = "";
     _wr_length = 0;
-    return OLAP_SUCCESS;
+    _io_stats = NULL;
+    _region_offset = 0;
+    _region_length = -1;
+    return res;
 }
 
 OLAPStatus FileHandler::pread(void* buf, size_t size, size_t offset) {
+    IoThrottle::acquire(current_io_class(), size);
     char* ptr = reinterpret_cast<char*>(buf);
+    size_t org_size = size;
+    size_t org_offset = offset;
+    MonotonicStopWatch watch;
+    watch.start();
 
     while (size > 0) {
-        ssize_t rd_size = ::pread(_fd, ptr, size, offset);
+        ssize_t rd_size = ::pread(_fd, ptr, size, _region_offset + offset);
 
         if (rd_size < 0) {
             OLAP_LOG_WARNING("failed to pread from file. "
@@ -189,13 +246,30 @@ OLAPStatus FileHandler::pread(void* buf, size_t size, size_t offset) {
         ptr += rd_size;
     }
 
+    _record_io("pread", true, org_size, org_offset, watch.elapsed_time());
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus FileHandler::read_ahead(size_t size, size_t offset) {
+    int err = posix_fadvise(_fd, _region_offset + offset, size, POSIX_FADV_WILLNEED);
+
+    if (0 != err) {
+        OLAP_LOG_WARNING("failed to read ahead file. "
+                         "[err=%d file_name='%s' fd=%d size=%ld offset=%ld]",
+                         err, _file_name.c_str(), _fd, size, offset);
+        return OLAP_ERR_IO_ERROR;
+    }
+
     return OLAP_SUCCESS;
 }
 
 OLAPStatus FileHandler::write(const void* buf, size_t buf_size) {
+    IoThrottle::acquire(current_io_class(), buf_size);
 
     size_t org_buf_size = buf_size;
     const char* ptr = reinterpret_cast<const char*>(buf);
+    MonotonicStopWatch watch;
+    watch.start();
     while (buf_size > 0) {
         ssize_t wr_size = ::write(_fd, ptr, buf_size);
 
@@ -214,6 +288,7 @@ OLAPStatus FileHandler::write(const void* buf, size_t buf_size) {
         ptr += wr_size;
     }
     _wr_length += org_buf_size;
+    _written = true;
     // try to sync page cache if cache size is bigger than threshold
     if (_wr_length >= _cache_threshold) {
         posix_fadvise(_fd, 0, 0, POSIX_FADV_DONTNEED);
@@ -221,11 +296,18 @@ OLAPStatus FileHandler::write(const void* buf, size_t buf_size) {
         sync_file_range(_fd, 0, 0, SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
         _wr_length = 0;
     }
+    // the flush of the page cache is part of the write, that's where a slow disk shows
+    _record_io("write", false, org_buf_size, -1, watch.elapsed_time());
     return OLAP_SUCCESS;
 }
 
 OLAPStatus FileHandler::pwrite(const void* buf, size_t buf_size, size_t offset) {
+    IoThrottle::acquire(current_io_class(), buf_size);
     const char* ptr = reinterpret_cast<const char*>(buf);
+    size_t org_buf_size = buf_size;
+    size_t org_offset = offset;
+    MonotonicStopWatch watch;
+    watch.start();
 
     while (buf_size > 0) {
         ssize_t wr_size = ::pwrite(_fd, ptr, buf_size, offset);
@@ -246,11 +328,53 @@ OLAPStatus FileHandler::pwrite(const void* buf, size_t buf_size, size_t offset)
         ptr += wr_size;
         offset += wr_size;
     }
+    _written = true;
 
+    _record_io("pwrite", false, org_buf_size, org_offset, watch.elapsed_time());
     return OLAP_SUCCESS;
 }
 
+// The tablet of a file under 'root_path', laid out as
+// root_path/data/shard/tablet_id/schema_hash/file, "unknown" for other files
+static string tablet_of_file(const string& file_name, const string& root_path) {
+    vector<string> parts;
+    boost::split(parts, file_name.substr(root_path.size()), boost::is_any_of("/"));
+    // parts[0] is empty, the rest of the name starts with '/'
+    if (parts.size() > 4 && "/" + parts[1] == DATA_PREFIX) {
+        return parts[3];
+    }
+    return "unknown";
+}
+
+void FileHandler::_record_io(
+        const char* op, bool is_read, size_t size, int64_t offset, int64_t latency_ns) {
+    if (_io_stats != NULL) {
+        if (is_read) {
+            _io_stats->record_read(size, latency_ns);
+        } else {
+            _io_stats->record_write(size, latency_ns);
+        }
+    }
+    if (is_read) {
+        // 计入当前线程正在扫描的tablet
+        TabletAccessStats::record_read_bytes(size);
+    }
+    if (config::slow_io_threshold_ms > 0
+            && latency_ns >= config::slow_io_threshold_ms * 1000000L) {
+        string tablet = _io_stats != NULL
+                ? tablet_of_file(_file_name, _io_stats->path()) : "unknown";
+        OLAP_LOG_WARNING("slow disk IO. [op=%s tablet=%s io_class=%s file_name='%s' "
+                         "size=%ld offset=%ld cost_ms=%ld]",
+                         op, tablet.c_str(), io_class_name(current_io_class()),
+                         _file_name.c_str(), size, offset, latency_ns / 1000000);
+    }
+}
+
 off_t FileHandler::length() const {
+    if (_region_length >= 0) {
+        return _region_length;
+    }
+
     struct stat stat_data;
 
     if (fstat(_fd, &stat_data) < 0) {
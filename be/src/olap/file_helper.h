@@ -30,6 +30,8 @@
 
 namespace palo {
 
+class DiskIoStats;
+
 typedef struct FileDescriptor {
     int fd;
     FileDescriptor(int fd) : fd(fd) {}
@@ -47,10 +49,15 @@ public:
     OLAPStatus open_with_cache(const std::string& file_name, int flag);
     // The argument mode specifies the permissions to use in case a new file is created.
     OLAPStatus open_with_mode(const std::string& file_name, int flag, int mode);
+    // 只读打开打包文件(见packed_file.h)中从offset开始长length的一段, 之后pread、read_ahead、
+    // length和mmap都针对这一段, 如同独立的文件; 同一打包文件的各段共用缓存中的一个句柄
+    OLAPStatus open_region_with_cache(const std::string& file_name, off_t offset, off_t length);
     OLAPStatus close();
     OLAPStatus release();
 
     OLAPStatus pread(void* buf, size_t size, size_t offset);
+    // 提示内核异步预读[offset, offset + size)，不等待IO完成
+    OLAPStatus read_ahead(size_t size, size_t offset);
     OLAPStatus write(const void* buf, size_t buf_size);
     OLAPStatus pwrite(const void* buf, size_t buf_size, size_t offset);
 
@@ -91,19 +98,34 @@ public:
         return _fd;
     }
 
+    // 打开的一段在文件中的起始位置, 不是打开一段时为0
+    off_t region_offset() const {
+        return _region_offset;
+    }
+
     static void _delete_cache_file_descriptor(const CacheKey& key, void* value) {
         FileDescriptor* file_desc = reinterpret_cast<FileDescriptor*>(value);
         SAFE_DELETE(file_desc);
     }
 
 private:
+    // 记录IO的延迟和大小到所在root path的统计中，超过slow_io_threshold_ms时打印日志；
+    // offset为-1表示追加写
+    void _record_io(const char* op, bool is_read, size_t size, int64_t offset,
+                    int64_t latency_ns);
+
     int _fd;
     off_t _wr_length;
+    // whether anything was written since the file was opened, which close() syncs
+    bool _written;
     const int64_t _cache_threshold = 1<<19;
     std::string _file_name;
     bool _is_using_cache;
     Cache::Handle* _cache_handle;
     Cache* _fd_cache;
+    DiskIoStats* _io_stats;            // 文件所在root path的IO统计，不在root path下时为NULL
+    off_t _region_offset;              // open_region_with_cache()打开的一段, 否则为0和-1
+    off_t _region_length;
 };
 
 class FileHandlerWithBuf {
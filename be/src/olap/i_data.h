@@ -21,6 +21,7 @@
 
 #include "exprs/expr.h"
 #include "gen_cpp/olap_file.pb.h"
+#include "olap/delete_bitmap.h"
 #include "olap/delete_handler.h"
 #include "olap/olap_common.h"
 #include "olap/olap_cond.h"
@@ -34,6 +35,7 @@ class OLAPIndex;
 class RowBlock;
 class RowCursor;
 class Conditions;
+class VectorizedRowBatch;
 
 // 抽象数据访问接口
 // 提供对不同数据文件类型的统一访问接口
@@ -82,6 +84,15 @@ public:
 
     virtual OLAPStatus set_end_key(const RowCursor* end_key, bool find_last_end_key) = 0;
 
+    // 批量读取接口, 将当前行之后的数据以列存格式直接追加到batch中, 列的顺序
+    // 与set_read_params中的return_columns一致. 读取后get_current_row不再有效,
+    // 需要调用get_next_row继续读取. 不支持批量读取时rows_read为0,
+    // 调用者应退回到get_next_row逐行读取
+    virtual OLAPStatus get_next_block(VectorizedRowBatch* batch, uint32_t* rows_read) {
+        *rows_read = 0;
+        return OLAP_SUCCESS;
+    }
+
     // 下面两个接口用于schema_change.cpp, 我们需要改功能继续做roll up,
     // 所以继续暴露该接口
     virtual OLAPStatus get_first_row_block(RowBlock** row_block) = 0;
@@ -114,6 +125,15 @@ public:
         _delete_status = delete_status;
     }
 
+    // 设置各segment中被更新版本中key相同的行替换的行, 读取时跳过这些行而不做合并.
+    // 只有ColumnData支持, 需要在读取第一行之前设置
+    virtual void set_deleted_rows(const DeleteBitmap::DeletedRows& deleted_rows) {}
+
+    // 最后一次读取的行所在的segment和在segment中的行号, 只有ColumnData支持
+    virtual OLAPStatus get_current_row_position(uint32_t* segment, uint64_t* row_id) {
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+
     void set_profile(RuntimeProfile* profile) {
         _profile = profile;
     }
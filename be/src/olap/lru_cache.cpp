@@ -172,8 +172,8 @@ bool HandleTable::_resize() {
     return true;
 }
 
-LRUCache::LRUCache() : _usage(0), _last_id(0), _lookup_count(0),
-    _hit_count(0) {
+LRUCache::LRUCache() : _capacity(0), _usage(0), _last_id(0), _lookup_count(0),
+    _hit_count(0), _evict_count(0) {
         // Make empty circular linked list
         _lru.next = &_lru;
         _lru.prev = &_lru;
@@ -283,6 +283,12 @@ Cache::Handle* LRUCache::insert(
         _finish_erase(_table.insert(e));
     } // else don't cache.  (Tests use capacity_==0 to turn off caching.)
 
+    _evict_to_capacity();
+
+    return reinterpret_cast<Cache::Handle*>(e);
+}
+
+void LRUCache::_evict_to_capacity() {
     while (_usage > _capacity && _lru.next != &_lru) {
         LRUHandle* old = _lru.next;
         assert(old->refs == 1);
@@ -290,9 +296,30 @@ Cache::Handle* LRUCache::insert(
         if (!erased) {  // to avoid unused variable when compiled NDEBUG
             assert(erased);
         }
+        ++_evict_count;
     }
+}
 
-    return reinterpret_cast<Cache::Handle*>(e);
+void LRUCache::set_capacity(size_t capacity) {
+    AutoMutexLock l(&_mutex);
+    _capacity = capacity;
+    _evict_to_capacity();
+}
+
+size_t LRUCache::evict(size_t charge) {
+    AutoMutexLock l(&_mutex);
+    size_t freed = 0;
+    while (freed < charge && _lru.next != &_lru) {
+        LRUHandle* e = _lru.next;
+        assert(e->refs == 1);
+        freed += e->charge;
+        bool erased = _finish_erase(_table.remove(e->key(), e->hash));
+        if (!erased) {  // to avoid unused variable when compiled NDEBUG
+            assert(erased);
+        }
+        ++_evict_count;
+    }
+    return freed;
 }
 
 // If e != NULL, finish removing *e from the cache; it has already been removed
@@ -429,6 +456,33 @@ void ShardedLRUCache::get_cache_status(rapidjson::Document* document) {
 
 }
 
+void ShardedLRUCache::get_stats(CacheStats* stats) {
+    for (int s = 0; s < kNumShards; s++) {
+        stats->lookup_count += _shards[s].get_lookup_count();
+        stats->hit_count += _shards[s].get_hit_count();
+        stats->evict_count += _shards[s].get_evict_count();
+        stats->usage += _shards[s].get_usage();
+        stats->capacity += _shards[s].get_capacity();
+    }
+}
+
+void ShardedLRUCache::set_capacity(size_t capacity) {
+    const size_t per_shard = (capacity + (kNumShards - 1)) / kNumShards;
+    for (int s = 0; s < kNumShards; s++) {
+        _shards[s].set_capacity(per_shard);
+    }
+}
+
+size_t ShardedLRUCache::evict(size_t charge) {
+    // 各分片平均分担
+    const size_t per_shard = (charge + (kNumShards - 1)) / kNumShards;
+    size_t freed = 0;
+    for (int s = 0; s < kNumShards; s++) {
+        freed += _shards[s].evict(per_shard);
+    }
+    return freed;
+}
+
 Cache* new_lru_cache(size_t capacity) {
     return new ShardedLRUCache(capacity);
 }
@@ -157,6 +157,17 @@ namespace palo {
             size_t _size;
     };
 
+    // 累计的运行统计，以及当前的占用和容量
+    struct CacheStats {
+        CacheStats() : lookup_count(0), hit_count(0), evict_count(0), usage(0), capacity(0) {}
+
+        uint64_t lookup_count;
+        uint64_t hit_count;
+        uint64_t evict_count;      // 因容量不足被淘汰的条目数
+        size_t usage;
+        size_t capacity;
+    };
+
     class Cache {
         public:
             Cache() {}
@@ -223,6 +234,12 @@ namespace palo {
             virtual size_t get_memory_usage() = 0;
             // cache命中率统计
             virtual void get_cache_status(rapidjson::Document* document) = 0;
+            virtual void get_stats(CacheStats* stats) = 0;
+
+            // 调整容量，超出新容量的部分从最久未使用的条目开始淘汰
+            virtual void set_capacity(size_t capacity) = 0;
+            // 从最久未使用的条目开始淘汰未被使用的条目，直到释放charge，返回实际释放的charge
+            virtual size_t evict(size_t charge) = 0;
 
         private:
             void _lru_remove(Handle* e);
@@ -300,10 +317,9 @@ namespace palo {
             LRUCache();
             ~LRUCache();
 
-            // Separate from constructor so caller can easily make an array of LRUCache
-            void set_capacity(size_t capacity) {
-                _capacity = capacity;
-            }
+            // Separate from constructor so caller can easily make an array of LRUCache.
+            // Entries beyond a smaller capacity are evicted.
+            void set_capacity(size_t capacity);
 
             // Like Cache methods, but with an extra "hash" parameter.
             Cache::Handle* insert(
@@ -316,6 +332,9 @@ namespace palo {
             void release(Cache::Handle* handle);
             void erase(const CacheKey& key, uint32_t hash);
             int prune();
+            // Evicts unpinned entries, least recently used first, until 'charge' is freed.
+            // Returns the charge freed.
+            size_t evict(size_t charge);
 
             uint64_t get_lookup_count() {
                 return _lookup_count;
@@ -323,6 +342,9 @@ namespace palo {
             uint64_t get_hit_count() {
                 return _hit_count;
             }
+            uint64_t get_evict_count() {
+                return _evict_count;
+            }
             size_t get_usage() {
                 return _usage;
             }
@@ -336,6 +358,9 @@ namespace palo {
             void _ref(LRUHandle* e);
             void _unref(LRUHandle* e);
             bool _finish_erase(LRUHandle* e);
+            // Evicts least recently used entries until the usage fits the capacity.
+            // Requires _mutex held.
+            void _evict_to_capacity();
 
             // Initialized before use.
             size_t _capacity;
@@ -358,6 +383,7 @@ namespace palo {
 
             uint64_t _lookup_count;    // cache查找总次数
             uint64_t _hit_count;       // 命中cache的总次数
+            uint64_t _evict_count;     // 因容量不足淘汰的总次数
     };
 
     static const int kNumShardBits = 4;
@@ -381,6 +407,9 @@ namespace palo {
             virtual void prune();
             virtual size_t get_memory_usage();
             virtual void get_cache_status(rapidjson::Document* document);
+            virtual void get_stats(CacheStats* stats);
+            virtual void set_capacity(size_t capacity);
+            virtual size_t evict(size_t charge);
 
         private:
             static inline uint32_t _hash_slice(const CacheKey& s);
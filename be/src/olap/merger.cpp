@@ -15,9 +15,12 @@
 
 #include "olap/merger.h"
 
+#include <algorithm>
 #include <memory>
+#include <set>
 #include <vector>
 
+#include "olap/column_file/data_writer.h"
 #include "olap/i_data.h"
 #include "olap/olap_define.h"
 #include "olap/olap_index.h"
@@ -27,6 +30,7 @@
 #include "olap/writer.h"
 
 using std::list;
+using std::set;
 using std::string;
 using std::unique_ptr;
 using std::vector;
@@ -40,7 +44,8 @@ Merger::Merger(SmartOLAPTable table, OLAPIndex* index, ReaderType type) :
         _reader_type(type),
         _row_count(0),
         _uniq_keys(table->num_key_fields(), 1),
-        _selectivities(table->num_key_fields(), 1) {}
+        _selectivities(table->num_key_fields(), 1),
+        _column_group_size(0) {}
 
 OLAPStatus Merger::merge(
         const vector<IData*>& olap_data_arr,
@@ -51,11 +56,51 @@ OLAPStatus Merger::merge(
         *merged_rows = 0;
         *filted_rows = 0;
         return _create_hard_link();
+    } else if (_check_vertical_merge(olap_data_arr)) {
+        return _vertical_merge(olap_data_arr, merged_rows, filted_rows);
     } else {
         return _merge(olap_data_arr, merged_rows, filted_rows);
     }
 }
 
+bool Merger::_check_vertical_merge(const vector<IData*>& olap_data_arr) {
+    int32_t column_group_size = config::vertical_compaction_column_group_size;
+    const vector<FieldInfo>& tablet_schema = _table->tablet_schema();
+    if (column_group_size <= 0
+            || _table->data_file_type() != COLUMN_ORIENTED_FILE
+            || tablet_schema.size() - _table->num_key_fields()
+                <= static_cast<size_t>(column_group_size)
+            || olap_data_arr.size() >= ROW_SOURCE_AGG_FLAG) {
+        return false;
+    }
+
+    // 按列组写入的列与SegmentWriter的根列一一对应
+    for (const FieldInfo& field_info : tablet_schema) {
+        if (!field_info.is_root_column) {
+            return false;
+        }
+    }
+
+    for (IData* i_data : olap_data_arr) {
+        if (i_data->data_file_type() != COLUMN_ORIENTED_FILE || i_data->delete_flag()) {
+            return false;
+        }
+    }
+
+    // 只有base expansion按删除条件过滤行, 见Reader::_init_delete_condition
+    if (_reader_type == READER_BASE_EXPANSION) {
+        _table->obtain_header_rdlock();
+        bool has_delete_conditions = _table->delete_data_conditions_size() > 0;
+        _table->release_header_lock();
+        if (has_delete_conditions) {
+            return false;
+        }
+    }
+
+    _column_group_size = column_group_size;
+    return true;
+}
+
 bool Merger::_check_simple_merge(const vector<IData*>& olap_data_arr) {
     bool res = false;
     vector<Version> versions;
@@ -96,41 +141,35 @@ OLAPStatus Merger::_create_hard_link() {
     _table->release_header_lock();
     list<string> new_files;
 
-    for (uint32_t i = 0; i < version_entity.num_segments; i++) {
-        string new_index_path = _table->construct_index_file_path(
-                                     _index->version(), _index->version_hash(), i);
-
-        string old_index_path = _table->construct_index_file_path(
-                                     version_entity.version, version_entity.version_hash, i);
-
-        if (0 != link(old_index_path.c_str(), new_index_path.c_str())) {
-            OLAP_LOG_WARNING("fail to create hard link. [old_path=%s] to [new_path=%s] [%m]",
-                    old_index_path.c_str(),
-                    new_index_path.c_str());
-            res = OLAP_ERR_OS_ERROR;
-            goto EXIT;
-        }
-
-        new_files.push_back(new_index_path);
-
-        string new_data_path = _table->construct_data_file_path(
-                                    _index->version(), _index->version_hash(), i);
-
-        string old_data_path = _table->construct_data_file_path(
-                                    version_entity.version, version_entity.version_hash, i);
-
-        if (0 != link(old_data_path.c_str(), new_data_path.c_str())) {
+    vector<string> old_paths;
+    vector<string> new_paths;
+    OLAPTable::construct_version_file_paths(_table->header_file_name(),
+                                            version_entity.version,
+                                            version_entity.version_hash,
+                                            version_entity.num_segments,
+                                            version_entity.packed,
+                                            &old_paths);
+    OLAPTable::construct_version_file_paths(_table->header_file_name(),
+                                            _index->version(),
+                                            _index->version_hash(),
+                                            version_entity.num_segments,
+                                            version_entity.packed,
+                                            &new_paths);
+
+    for (size_t i = 0; i < old_paths.size(); ++i) {
+        if (0 != link(old_paths[i].c_str(), new_paths[i].c_str())) {
             OLAP_LOG_WARNING("fail to create hard link. from [path=%s] to [path=%s] [%m]",
-                    old_data_path.c_str(),
-                    new_data_path.c_str());
+                    old_paths[i].c_str(),
+                    new_paths[i].c_str());
             res = OLAP_ERR_OS_ERROR;
             goto EXIT;
         }
 
-        new_files.push_back(new_data_path);
+        new_files.push_back(new_paths[i]);
     }
 
     _index->set_num_segments(version_entity.num_segments);
+    _index->set_packed(version_entity.packed);
 
     if (version_entity.column_statistics.size() != 0) {
         _index->set_column_statistics(version_entity.column_statistics);
@@ -196,9 +235,10 @@ OLAPStatus Merger::_merge(
         has_error = true;
     }
 
+    // selectivities只与key列有关, 只保存上一行的key
     RowCursor last_row;
 
-    if (OLAP_SUCCESS != last_row.init(_table->tablet_schema())) {
+    if (OLAP_SUCCESS != last_row.init(_table->tablet_schema(), _table->num_key_fields())) {
         OLAP_LOG_WARNING("fail to init row cursor.");
         has_error = true;
     }
@@ -235,18 +275,7 @@ OLAPStatus Merger::_merge(
         if (need_calculate_selectivities) {
             // Calculate statistics while base expansion
             if (0 != _row_count) {
-                size_t first_diff_id = 0;
-
-                if (OLAP_SUCCESS != last_row.get_first_different_column_id(
-                        row_cursor, &first_diff_id)) {
-                    OLAP_LOG_WARNING("fail to get_first_different_column_id.");
-                    has_error = true;
-                    break;
-                }
-
-                for (size_t i = first_diff_id; i < _uniq_keys.size(); ++i) {
-                    ++_uniq_keys[i];
-                }
+                _update_uniq_keys(row_cursor, last_row);
             }
 
             // set last row for next comapration.
@@ -281,5 +310,292 @@ OLAPStatus Merger::_merge(
     return has_error ? OLAP_ERR_OTHER_ERROR : OLAP_SUCCESS;
 }
 
+void Merger::_update_uniq_keys(const RowCursor& row, const RowCursor& last_row) {
+    size_t first_diff_id = 0;
+    while (first_diff_id < _uniq_keys.size()
+            && 0 == row.get_field_by_index(first_diff_id)->cmp(
+                    last_row.get_field_by_index(first_diff_id))) {
+        ++first_diff_id;
+    }
+
+    for (size_t i = first_diff_id; i < _uniq_keys.size(); ++i) {
+        ++_uniq_keys[i];
+    }
+}
+
+OLAPStatus Merger::_vertical_merge(
+        const vector<IData*>& olap_data_arr,
+        uint64_t* merged_rows,
+        uint64_t* filted_rows) {
+    size_t num_key_fields = _table->num_key_fields();
+    vector<uint32_t> key_columns;
+    for (uint32_t i = 0; i < num_key_fields; ++i) {
+        key_columns.push_back(i);
+    }
+
+    // reader只合并key列, 并把每一行的来源追加到row_sources中.
+    // 每个Segment的value列合并后清除这个Segment的合并顺序
+    vector<RowSource> row_sources;
+    Reader reader;
+    ReaderParams reader_params;
+    reader_params.olap_table = _table;
+    reader_params.reader_type = _reader_type;
+    reader_params.olap_data_arr = olap_data_arr;
+    reader_params.return_columns = key_columns;
+    reader_params.row_sources = &row_sources;
+
+    if (_reader_type == READER_BASE_EXPANSION) {
+        reader_params.version = _index->version();
+    }
+
+    if (OLAP_SUCCESS != reader.init(reader_params)) {
+        OLAP_LOG_WARNING("fail to initiate reader. [table='%s']",
+                _table->full_name().c_str());
+        return OLAP_ERR_INIT_FAILED;
+    }
+
+    unique_ptr<column_file::ColumnDataWriter> writer(
+            new(std::nothrow) column_file::ColumnDataWriter(_table, _index, false));
+
+    if (NULL == writer) {
+        OLAP_LOG_WARNING("fail to allocate writer.");
+        return OLAP_ERR_MALLOC_ERROR;
+    }
+
+    if (OLAP_SUCCESS != writer->init()) {
+        OLAP_LOG_WARNING("fail to initiate writer. [table='%s']",
+                _table->full_name().c_str());
+        return OLAP_ERR_INIT_FAILED;
+    }
+
+    // 按源数据每行的平均大小估计每个Segment的行数, 至少写满一个block
+    uint64_t segment_target_rows = _table->num_rows_per_row_block();
+    uint64_t source_data_size = 0;
+    uint64_t source_num_rows = 0;
+    for (IData* i_data : olap_data_arr) {
+        source_data_size += i_data->olap_index()->data_size();
+        source_num_rows += i_data->num_rows();
+    }
+    if (source_data_size > 0) {
+        segment_target_rows = std::max(segment_target_rows, static_cast<uint64_t>(
+                static_cast<double>(writer->max_segment_size()) * source_num_rows
+                / source_data_size));
+    }
+
+    // We calculate selectivities only when base expansioning.
+    bool need_calculate_selectivities = (_index->version().first == 0);
+    RowCursor key_row;
+    RowCursor last_row;
+    RowCursor start_key;
+    OLAPStatus res = OLAP_SUCCESS;
+    if (OLAP_SUCCESS != (res = key_row.init(_table->tablet_schema(), num_key_fields))
+            || OLAP_SUCCESS != (res = last_row.init(_table->tablet_schema(), num_key_fields))
+            || OLAP_SUCCESS != (res = start_key.init(_table->tablet_schema(), num_key_fields))) {
+        OLAP_LOG_WARNING("fail to init row cursor. [res=%d]", res);
+        return res;
+    }
+
+    bool eof = false;
+    int64_t raw_rows_read = 0;
+    bool is_first_segment = true;
+    res = reader.next_row_with_aggregation(&key_row, &raw_rows_read, &eof);
+
+    // The following procedure would last for long time, half of one day, etc.
+    while (OLAP_SUCCESS == res && !eof) {
+        // key_row是这个Segment的第一行, Segment只在key变化的行切分, 所以各源数据中
+        // 小于这个key的行都已经合并到之前的Segment中
+        res = start_key.copy(key_row);
+        uint64_t segment_rows = 0;
+        size_t num_row_sources = 0;
+        while (OLAP_SUCCESS == res) {
+            res = writer->write_key_columns(&key_row);
+            if (OLAP_SUCCESS != res) {
+                break;
+            }
+
+            if (need_calculate_selectivities && 0 != _row_count) {
+                _update_uniq_keys(key_row, last_row);
+            }
+            ++_row_count;
+            ++segment_rows;
+
+            res = last_row.copy(key_row);
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("fail to copy last row.");
+                break;
+            }
+
+            // 读取下一行之前, row_sources中是这个Segment已经写入的行的合并顺序
+            num_row_sources = row_sources.size();
+            res = reader.next_row_with_aggregation(&key_row, &raw_rows_read, &eof);
+            if (OLAP_SUCCESS != res || eof
+                    || (segment_rows >= segment_target_rows && !key_row.equal(last_row))) {
+                break;
+            }
+        }
+
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to merge key columns. [table='%s' res=%d]",
+                             _table->full_name().c_str(), res);
+            break;
+        }
+
+        for (uint32_t begin = num_key_fields;
+                begin < _table->tablet_schema().size() && OLAP_SUCCESS == res;
+                begin += _column_group_size) {
+            uint32_t end = std::min<uint32_t>(begin + _column_group_size,
+                                              _table->tablet_schema().size());
+            res = _merge_column_group(olap_data_arr,
+                                      is_first_segment ? NULL : &start_key,
+                                      row_sources,
+                                      num_row_sources,
+                                      begin,
+                                      end,
+                                      writer.get());
+        }
+
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to merge value columns. [table='%s' res=%d]",
+                             _table->full_name().c_str(), res);
+            break;
+        }
+
+        row_sources.erase(row_sources.begin(), row_sources.begin() + num_row_sources);
+        is_first_segment = false;
+        if (!eof) {
+            res = writer->next_segment();
+        }
+    }
+
+    if (OLAP_SUCCESS == res) {
+        res = writer->finalize();
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to finalize writer. [table='%s']",
+                    _table->full_name().c_str());
+        }
+    }
+
+    if (OLAP_SUCCESS != res) {
+        return OLAP_ERR_OTHER_ERROR;
+    }
+
+    if (need_calculate_selectivities) {
+        for (size_t i = 0; i < _uniq_keys.size(); ++i) {
+            _selectivities[i]
+                = static_cast<uint32_t>(_row_count / _uniq_keys[i]);
+        }
+    }
+
+    *merged_rows = reader.merged_rows();
+    *filted_rows = reader.filted_rows();
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus Merger::_merge_column_group(
+        const vector<IData*>& olap_data_arr,
+        const RowCursor* start_key,
+        const vector<RowSource>& row_sources,
+        size_t num_row_sources,
+        uint32_t begin,
+        uint32_t end,
+        column_file::ColumnDataWriter* writer) {
+    // 定位源数据需要key列
+    vector<uint32_t> return_columns;
+    vector<uint32_t> group_columns;
+    for (uint32_t i = 0; i < _table->num_key_fields(); ++i) {
+        return_columns.push_back(i);
+    }
+    for (uint32_t i = begin; i < end; ++i) {
+        return_columns.push_back(i);
+        group_columns.push_back(i);
+    }
+    set<uint32_t> load_bf_columns;
+    Conditions conditions;
+    vector<RowCursor*> no_keys;
+
+    RowCursor row;
+    OLAPStatus res = row.init(_table->tablet_schema(), group_columns);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to init row cursor. [res=%d]", res);
+        return res;
+    }
+
+    // 每一组使用新的IData读取源数据, 只缓存这一组的列
+    vector<IData*> sources(olap_data_arr.size(), NULL);
+    vector<const RowCursor*> source_rows(olap_data_arr.size(), NULL);
+    for (size_t i = 0; i < olap_data_arr.size(); ++i) {
+        if (olap_data_arr[i]->empty()) {
+            continue;
+        }
+
+        sources[i] = IData::create(olap_data_arr[i]->olap_index());
+        if (NULL == sources[i]) {
+            OLAP_LOG_WARNING("fail to create IData.");
+            res = OLAP_ERR_MALLOC_ERROR;
+            break;
+        }
+
+        res = sources[i]->init();
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to init IData. [res=%d]", res);
+            break;
+        }
+
+        sources[i]->set_read_params(return_columns, load_bf_columns, conditions,
+                                    no_keys, no_keys, false, NULL);
+        if (NULL == start_key) {
+            source_rows[i] = sources[i]->get_first_row();
+        } else {
+            source_rows[i] = sources[i]->find_row(*start_key, false, false);
+        }
+
+        if (NULL == source_rows[i] && !sources[i]->eof()) {
+            OLAP_LOG_WARNING("fail to find start row of IData. [version=%d-%d]",
+                             olap_data_arr[i]->version().first,
+                             olap_data_arr[i]->version().second);
+            res = OLAP_ERR_READER_READING_ERROR;
+            break;
+        }
+    }
+
+    // 按key列的合并顺序逐行读取源数据, 开始新的一行或者聚合到上一行
+    uint64_t row_id = 0;
+    for (size_t i = 0; i < num_row_sources && OLAP_SUCCESS == res; ++i) {
+        RowSource source = static_cast<RowSource>(row_sources[i] & ~ROW_SOURCE_AGG_FLAG);
+        if (source >= sources.size() || NULL == source_rows[source]) {
+            OLAP_LOG_WARNING("source reaches end before its rows are merged. [source=%u]",
+                             source);
+            res = OLAP_ERR_READER_READING_ERROR;
+            break;
+        }
+
+        if (0 != (row_sources[i] & ROW_SOURCE_AGG_FLAG)) {
+            res = row.aggregate(*source_rows[source]);
+        } else {
+            if (i > 0) {
+                row.finalize_one_merge();
+                res = writer->write_value_columns(begin, end, row_id++, &row);
+                if (OLAP_SUCCESS != res) {
+                    break;
+                }
+            }
+            res = row.copy(*source_rows[source]);
+        }
+
+        source_rows[source] = sources[source]->get_next_row();
+    }
+
+    if (OLAP_SUCCESS == res && num_row_sources > 0) {
+        row.finalize_one_merge();
+        res = writer->write_value_columns(begin, end, row_id, &row);
+    }
+
+    for (size_t i = 0; i < sources.size(); ++i) {
+        SAFE_DELETE(sources[i]);
+    }
+
+    return res;
+}
+
 
 }  // namespace palo
@@ -18,11 +18,17 @@
 
 #include "olap/olap_define.h"
 #include "olap/olap_table.h"
+#include "olap/reader.h"
 
 namespace palo {
 
 class OLAPIndex;
 class IData;
+class RowCursor;
+
+namespace column_file {
+class ColumnDataWriter;
+}
 
 class Merger {
 public:
@@ -56,6 +62,30 @@ private:
             uint64_t* merged_rows,
             uint64_t* filted_rows);
 
+    // 纵向合并: 先合并所有源数据的key列并记录合并顺序, 再按这个顺序逐组合并value列,
+    // 读取时只需要缓存key列和一组value列, 见config::vertical_compaction_column_group_size
+    OLAPStatus _vertical_merge(
+            const std::vector<IData*>& olap_data_arr,
+            uint64_t* merged_rows,
+            uint64_t* filted_rows);
+
+    // 是否可以纵向合并, 按删除条件过滤行和删除版本需要读取value列, 只能整行合并
+    bool _check_vertical_merge(const std::vector<IData*>& olap_data_arr);
+
+    // 按row_sources的前num_row_sources个合并顺序合并第begin到end-1列, 写入当前Segment.
+    // 各源数据从start_key开始读取, start_key为NULL时从第一行开始读取
+    OLAPStatus _merge_column_group(
+            const std::vector<IData*>& olap_data_arr,
+            const RowCursor* start_key,
+            const std::vector<RowSource>& row_sources,
+            size_t num_row_sources,
+            uint32_t begin,
+            uint32_t end,
+            column_file::ColumnDataWriter* writer);
+
+    // 用写入的行和上一行统计每一种前缀组合的独特值个数
+    void _update_uniq_keys(const RowCursor& row, const RowCursor& last_row);
+
     bool _check_simple_merge(const std::vector<IData*>& olap_data_arr);
 
     OLAPStatus _create_hard_link();
@@ -67,6 +97,7 @@ private:
     std::vector<uint64_t> _uniq_keys;      // 存储每一种前缀组合的独特值个数
     std::vector<uint32_t> _selectivities;  // 保存每一种前缀组合的selectivity
     Version _simple_merge_version;
+    uint32_t _column_group_size;           // 纵向合并时每组value列的个数
 
     DISALLOW_COPY_AND_ASSIGN(Merger);
 };
@@ -188,6 +188,7 @@ struct VersionEntity {
             data_size(data_size),
             index_size(index_size),
             empty(empty),
+            packed(false),
             column_statistics(0) {}
 
     VersionEntity(Version v,
@@ -207,6 +208,7 @@ struct VersionEntity {
             data_size(data_size),
             index_size(index_size),
             empty(empty),
+            packed(false),
             column_statistics(column_statistics) {}
 
     Version version;
@@ -217,6 +219,8 @@ struct VersionEntity {
     size_t data_size;
     size_t index_size;
     bool empty;
+    // all files of the version are in one pack file
+    bool packed;
     std::vector<std::pair<Field *, Field *> > column_statistics;
 };
 
@@ -15,6 +15,7 @@
 
 #include "olap/olap_cond.h"
 
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <utility>
@@ -52,6 +53,9 @@ using palo::column_file::ColumnStatistics;
 
 namespace palo {
 
+// IN集合使用bitset时的最大值域, 即最多占用128KB内存. Cond会随Conditions拷贝, 不宜过大
+static const uint64_t MAX_IN_BITSET_SIZE = 1024 * 1024;
+
 static CondOp parse_op_type(const string& op) {
     if (op.size() > 2) {
         return OP_NULL;
@@ -119,6 +123,116 @@ Cond::Cond(const TCondition& condition)
     operands = condition.condition_values;
 
     operand_field = NULL;
+    in_filter_type = IN_HASH_SET;
+    in_bitset_min = 0;
+}
+
+// 读取可以无损表示为int64_t的类型的值, 值的大小关系与Field::cmp一致
+static bool get_int_value(const Field* field, int64_t* value) {
+    const char* buf = field->buf();
+    switch (field->type()) {
+    case OLAP_FIELD_TYPE_TINYINT:
+        *value = *reinterpret_cast<const int8_t*>(buf);
+        return true;
+    case OLAP_FIELD_TYPE_UNSIGNED_TINYINT:
+        *value = *reinterpret_cast<const uint8_t*>(buf);
+        return true;
+    case OLAP_FIELD_TYPE_SMALLINT:
+        *value = *reinterpret_cast<const int16_t*>(buf);
+        return true;
+    case OLAP_FIELD_TYPE_UNSIGNED_SMALLINT:
+        *value = *reinterpret_cast<const uint16_t*>(buf);
+        return true;
+    case OLAP_FIELD_TYPE_INT:
+        *value = *reinterpret_cast<const int32_t*>(buf);
+        return true;
+    case OLAP_FIELD_TYPE_UNSIGNED_INT:
+        *value = *reinterpret_cast<const uint32_t*>(buf);
+        return true;
+    case OLAP_FIELD_TYPE_BIGINT:
+    case OLAP_FIELD_TYPE_DATETIME:
+        *value = *reinterpret_cast<const int64_t*>(buf);
+        return true;
+    case OLAP_FIELD_TYPE_DATE: {
+        uint32_t date = 0;
+        memcpy(&date, buf, 3);
+        *value = date;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+void Cond::build_in_filter() {
+    sorted_operands.assign(operand_set.begin(), operand_set.end());
+    std::sort(sorted_operands.begin(), sorted_operands.end(), FieldLess());
+
+    in_filter_type = IN_HASH_SET;
+    int_operands.clear();
+    in_bitset.clear();
+    for (const Field* operand : sorted_operands) {
+        int64_t value = 0;
+        if (!get_int_value(operand, &value)) {
+            return;
+        }
+        int_operands.push_back(value);
+    }
+    if (int_operands.empty()) {
+        return;
+    }
+
+    // 值域不超过集合大小的64倍时使用bitset, 每个值最多占用一个int64_t的空间
+    in_filter_type = IN_SORTED_ARRAY;
+    uint64_t range = (uint64_t)int_operands.back() - (uint64_t)int_operands.front() + 1;
+    if (range > 0 && range <= std::max<uint64_t>(int_operands.size() * 64, 4096)
+            && range <= MAX_IN_BITSET_SIZE) {
+        in_filter_type = IN_BITSET;
+        in_bitset_min = int_operands.front();
+        in_bitset.assign((range + 63) / 64, 0);
+        for (int64_t value : int_operands) {
+            uint64_t offset = value - in_bitset_min;
+            in_bitset[offset >> 6] |= 1UL << (offset & 63);
+        }
+    }
+}
+
+bool Cond::_in_eval(const Field* field) const {
+    int64_t value = 0;
+    switch (in_filter_type) {
+    case IN_BITSET: {
+        get_int_value(field, &value);
+        uint64_t offset = value - in_bitset_min;
+        return offset < in_bitset.size() * 64
+               && (in_bitset[offset >> 6] & (1UL << (offset & 63))) != 0;
+    }
+    case IN_SORTED_ARRAY: {
+        // 无分支的二分查找, 循环次数只与集合大小有关
+        get_int_value(field, &value);
+        const int64_t* base = int_operands.data();
+        size_t n = int_operands.size();
+        while (n > 1) {
+            size_t half = n / 2;
+            base = (base[half] <= value) ? base + half : base;
+            n -= half;
+        }
+        return *base == value;
+    }
+    default:
+        return operand_set.find(field) != operand_set.end();
+    }
+}
+
+bool Cond::_in_range(const Field* min, const Field* max) const {
+    if (sorted_operands.empty()
+            || sorted_operands.back()->cmp(min) < 0
+            || sorted_operands.front()->cmp(max) > 0) {
+        return false;
+    }
+
+    std::vector<const Field*>::const_iterator it = std::lower_bound(
+            sorted_operands.begin(), sorted_operands.end(), min, FieldLess());
+    return it != sorted_operands.end() && (*it)->cmp(max) <= 0;
 }
 
 bool Cond::validation() {
@@ -174,7 +288,7 @@ bool Cond::eval(const Field* field) const {
     case OP_GE:
         return field->cmp(operand_field) >= 0;
     case OP_IN:
-        return operand_set.find(field) != operand_set.end();
+        return _in_eval(field);
     case OP_IS: {
         if (operand_field->is_null() == field->is_null()) {
             return true;
@@ -195,7 +309,16 @@ bool Cond::eval(const ColumnStatistics& statistic) const {
     }
 
     if (OP_IS != op && statistic.minimum()->is_null()) {
-        return true;
+        // 带有null_count时, 最小值为null说明block中全部为null, 任何比较都不成立
+        return !statistic.has_null_count();
+    }
+
+    if (OP_IS == op && statistic.has_null_count()) {
+        if (operand_field->is_null()) {
+            return statistic.null_count() > 0;
+        } else {
+            return !statistic.maximum()->is_null();
+        }
     }
 
     switch (op) {
@@ -220,14 +343,7 @@ bool Cond::eval(const ColumnStatistics& statistic) const {
         return operand_field->cmp(statistic.maximum()) <= 0;
     }
     case OP_IN: {
-        FieldSet::const_iterator it = operand_set.begin();
-        for (; it != operand_set.end(); ++it) {
-            if ((*it)->cmp(statistic.minimum()) >= 0 
-                    && (*it)->cmp(statistic.maximum()) <= 0) {
-                return true;
-            }
-        }
-        break;
+        return _in_range(statistic.minimum(), statistic.maximum());
     }
     case OP_IS: {
         if (operand_field->is_null()) {
@@ -259,6 +375,11 @@ int Cond::del_eval(const ColumnStatistics& stat) const {
         return DEL_PARTIAL_SATISFIED;
     }
 
+    // 带有null_count时最大最小值不包含null, 部分为null的block只能部分过滤
+    if (stat.has_null_count() && stat.null_count() > 0 && !stat.maximum()->is_null()) {
+        return DEL_PARTIAL_SATISFIED;
+    }
+
     if (OP_IS != op) {
         if (stat.minimum()->is_null() && stat.maximum()->is_null()) {
             return DEL_NOT_SATISFIED;
@@ -336,19 +457,13 @@ int Cond::del_eval(const ColumnStatistics& stat) const {
     case OP_IN: {
         //IN和OR等价，只要有一个操作数满足删除条件就可以全部过滤；
         //有一个部分满足删除条件，就可以部分过滤
-        FieldSet::const_iterator it = operand_set.begin();
-        for (; it != operand_set.end(); ++it) {
-            if ((*it)->cmp(stat.minimum()) >= 0
-                && (*it)->cmp(stat.maximum()) <= 0) {
-                if (stat.minimum()->cmp(stat.maximum()) == 0) {
-                    ret = DEL_SATISFIED;
-                } else {
-                    ret = DEL_PARTIAL_SATISFIED;
-                }
-                break;
+        if (_in_range(stat.minimum(), stat.maximum())) {
+            if (stat.minimum()->cmp(stat.maximum()) == 0) {
+                ret = DEL_SATISFIED;
+            } else {
+                ret = DEL_PARTIAL_SATISFIED;
             }
-        }
-        if (it == operand_set.end()) {
+        } else {
             ret = DEL_NOT_SATISFIED;
         }
         return ret;
@@ -407,14 +522,7 @@ bool Cond::eval(const std::pair<Field *, Field *>& statistic) const {
         return operand_field->cmp(statistic.second) <= 0;
     }
     case OP_IN: {
-        FieldSet::const_iterator it = operand_set.begin();
-        for (; it != operand_set.end(); ++it) {
-            if ((*it)->cmp(statistic.first) >= 0 
-                    && (*it)->cmp(statistic.second) <= 0) {
-                return true;
-            }
-        }
-        break;
+        return _in_range(statistic.first, statistic.second);
     }
     case OP_IS: {
         if (operand_field->is_null()) {
@@ -515,19 +623,13 @@ int Cond::del_eval(const std::pair<Field *, Field *>& stat) const {
         return ret;
     }
     case OP_IN: {
-        FieldSet::const_iterator it = operand_set.begin();
-        for (; it != operand_set.end(); ++it) {
-            if ((*it)->cmp(stat.first) >= 0
-                && (*it)->cmp(stat.second) <= 0) {
-                if (stat.first->cmp(stat.second) == 0) {
-                    ret = DEL_SATISFIED;
-                } else {
-                    ret = DEL_PARTIAL_SATISFIED;
-                }
-                break;
+        if (_in_range(stat.first, stat.second)) {
+            if (stat.first->cmp(stat.second) == 0) {
+                ret = DEL_SATISFIED;
+            } else {
+                ret = DEL_PARTIAL_SATISFIED;
             }
-        }
-        if (it == operand_set.end()) {
+        } else {
             ret = DEL_SATISFIED;
         }
         return ret;
@@ -691,6 +793,7 @@ bool CondColumn::add_condition(Cond* condition) {
                 SAFE_DELETE(f);
             }
         }
+        condition->build_in_filter();
     }
 
     _conds.push_back(*condition);
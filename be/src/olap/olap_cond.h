@@ -28,6 +28,7 @@
 #include "olap/field.h"
 #include "olap/olap_table.h"
 #include "olap/row_cursor.h"
+#include "util/hash_util.hpp"
 
 namespace palo {
 enum CondOp {
@@ -45,10 +46,24 @@ enum CondOp {
 // Hash functor for IN set
 struct FieldHash {
     size_t operator()(const Field* field) const {
-        return std::hash<std::string>()(std::string(field->buf(), field->size()));
+        return HashUtil::hash(field->buf(), field->size(), 0);
     }
 };
 
+// Less function for sorted IN operands
+struct FieldLess {
+    bool operator()(const Field* left, const Field* right) const {
+        return left->cmp(right) < 0;
+    }
+};
+
+// IN集合编译后的查找方式
+enum InFilterType {
+    IN_HASH_SET = 0,        // 通用类型, 使用operand_set
+    IN_SORTED_ARRAY = 1,    // 整数类型, 在排好序的int_operands上二分查找
+    IN_BITSET = 2           // 值域较小的整数类型, 使用in_bitset
+};
+
 // Equal function for IN set
 struct FieldEqual {
     bool operator()(const Field* left, const Field* right) const {
@@ -81,6 +96,9 @@ public:
     int del_eval(const std::pair<Field *, Field *>& stat) const;
 
     bool eval(const column_file::BloomFilter& bf) const;
+
+    // IN集合填充完后按类型生成查找结构
+    void build_in_filter();
     
     // 封装Field::create以及分配attach使用的buffer
     Field* create_field(const FieldInfo& fi);
@@ -93,8 +111,19 @@ public:
     std::vector<std::string>    operands;         // 所有操作数的字符表示
     Field*                      operand_field;    // 如果不是OP_IN, 此处保存唯一操作数
     FieldSet                    operand_set;      // 如果是OP_IN，此处为IN的集合
+    // 以下只对OP_IN有效, 由build_in_filter生成
+    InFilterType                in_filter_type;
+    std::vector<const Field*>   sorted_operands;  // 排好序的IN集合, 用于按min/max过滤
+    std::vector<int64_t>        int_operands;     // 整数类型IN集合排序后的值
+    int64_t                     in_bitset_min;    // in_bitset第0位对应的值
+    std::vector<uint64_t>       in_bitset;
 
 private:
+    bool _in_eval(const Field* field) const;
+
+    // 是否有IN的操作数落在[min, max]内
+    bool _in_range(const Field* min, const Field* max) const;
+
     std::vector<char*>         operand_field_buf;  // buff for field.attach
 };
 
@@ -871,6 +871,21 @@ OLAPData::RowBlockBroker::~RowBlockBroker() {
     SAFE_DELETE_ARRAY(_read_buffer);
 }
 
+void OLAPData::RowBlockBroker::set_conjuncts(std::vector<ExprContext*>* query_conjunct_ctxs,
+                                             std::vector<ExprContext*>* delete_conjunct_ctxs) {
+    _query_conjunct_ctxs = query_conjunct_ctxs;
+    _delete_conjunct_ctxs = delete_conjunct_ctxs;
+
+    _query_filter.clear();
+    if (_query_conjunct_ctxs != NULL) {
+        _query_filter.init(*_query_conjunct_ctxs, _olap_table->tablet_schema());
+    }
+    _delete_filter.clear();
+    if (_delete_conjunct_ctxs != NULL) {
+        _delete_filter.init(*_delete_conjunct_ctxs, _olap_table->tablet_schema());
+    }
+}
+
 OLAPStatus OLAPData::RowBlockBroker::init() {
     OLAPStatus res = OLAP_SUCCESS;
 
@@ -1181,7 +1196,7 @@ OLAPStatus OLAPData::RowBlockBroker::_get_row_block(const RowBlockPosition& row_
 
     // 过滤删除条件
     if (_delete_conjunct_ctxs != NULL) {
-        res = _row_block->eval_conjuncts(*_delete_conjunct_ctxs);
+        res = _row_block->eval_conjuncts(_delete_filter);
         if (res != OLAP_SUCCESS) {
             OLAP_LOG_WARNING("fail to eval delete conjuncts for row block. [res=%d]", res);
             goto GET_ROW_BLOCK_ERROR;
@@ -1192,7 +1207,7 @@ OLAPStatus OLAPData::RowBlockBroker::_get_row_block(const RowBlockPosition& row_
 
     // 过滤查询条件
     if (_query_conjunct_ctxs != NULL) {
-        res = _row_block->eval_conjuncts(*_query_conjunct_ctxs);
+        res = _row_block->eval_conjuncts(_query_filter);
         if (res != OLAP_SUCCESS) {
             OLAP_LOG_WARNING("fail to eval query conjuncts for row block. [res=%d]", res);
             goto GET_ROW_BLOCK_ERROR;
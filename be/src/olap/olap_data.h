@@ -173,11 +173,9 @@ private:
         const RowCursor* next(bool* end_of_row_block);
         const RowCursor* find_row(const RowCursor& key, bool find_last_key, bool* end_of_row_block);
 
+        // conjunct在这里编译一次, 之后每个row_block直接使用
         void set_conjuncts(std::vector<ExprContext*>* query_conjunct_ctxs, 
-                           std::vector<ExprContext*>* delete_conjunct_ctxs) {
-            _query_conjunct_ctxs = query_conjunct_ctxs;
-            _delete_conjunct_ctxs = delete_conjunct_ctxs;
-        }
+                           std::vector<ExprContext*>* delete_conjunct_ctxs);
 
         void set_end_row(const RowBlockPosition& end_block_position, uint32_t end_row_index) {
             _end_block_position = end_block_position;
@@ -250,6 +248,8 @@ private:
 
         std::vector<ExprContext*>* _query_conjunct_ctxs;
         std::vector<ExprContext*>* _delete_conjunct_ctxs;
+        VectorizedFilter _query_filter;
+        VectorizedFilter _delete_filter;
 
         uint64_t _data_read_buf_size;
         bool _is_end_block;
@@ -60,6 +60,7 @@ static const std::string CLUSTER_ID_PREFIX = "/cluster_id";
 static const std::string DATA_PREFIX = "/data";
 static const std::string DPP_PREFIX = "/dpp_download";
 static const std::string SNAPSHOT_PREFIX = "/snapshot";
+static const std::string CLONE_PREFIX = "/clone";
 static const std::string TRASH_PREFIX = "/trash";
 static const std::string UNUSED_PREFIX = "/unused";
 static const std::string ERROR_LOG_PREFIX = "/error_log";
@@ -71,7 +72,7 @@ static const float OLAP_COLUMN_FILE_SEGMENT_SIZE_SCALE = 0.9f;
 
 static const uint32_t MAX_POSITION_SIZE = 16;
 
-static const uint32_t MAX_STATISTIC_LENGTH = 34;
+static const uint32_t MAX_STATISTIC_LENGTH = 38;
 
 static const uint32_t MAX_OP_IN_FIELD_NUM = 100;
 
@@ -218,6 +219,7 @@ enum OLAPStatus {
     OLAP_ERR_PUSH_VERSION_ALREADY_EXIST = -908,
     OLAP_ERR_PUSH_TABLE_NOT_EXIST = -909,
     OLAP_ERR_PUSH_INPUT_DATA_ERROR = -910,
+    OLAP_ERR_PUSH_BATCH_NOT_APPLICABLE = -911,
 
     // OLAPIndex
     // [-1000, -1100)
@@ -16,8 +16,10 @@
 #include "olap/olap_engine.h"
 
 #include <signal.h>
+#include <sys/stat.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <new>
 #include <queue>
@@ -25,10 +27,14 @@
 
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
 #include <rapidjson/document.h>
 
 #include "olap/base_expansion_handler.h"
+#include "olap/cache_manager.h"
+#include "olap/column_sketch.h"
 #include "olap/cumulative_handler.h"
 #include "olap/lru_cache.h"
 #include "olap/olap_header.h"
@@ -38,10 +44,13 @@
 #include "olap/schema_change.h"
 #include "olap/utils.h"
 #include "olap/writer.h"
+#include "util/palo_metrics.h"
 
 using boost::filesystem::canonical;
 using boost::filesystem::directory_iterator;
+using boost::filesystem::is_directory;
 using boost::filesystem::path;
+using boost::filesystem::recursive_directory_iterator;
 using std::back_inserter;
 using std::copy;
 using std::inserter;
@@ -70,7 +79,9 @@ bool _sort_table_by_create_time(const SmartOLAPTable& a, const SmartOLAPTable& b
 OLAPEngine::OLAPEngine() :
         _global_table_id(0),
         _file_descriptor_lru_cache(NULL),
-        _index_stream_lru_cache(NULL) {}
+        _index_stream_lru_cache(NULL),
+        _data_page_lru_cache(NULL),
+        _row_lru_cache(NULL) {}
 
 OLAPEngine::~OLAPEngine() {
     clear();
@@ -78,16 +89,52 @@ OLAPEngine::~OLAPEngine() {
 
 OLAPStatus OLAPEngine::_load_tables(const string& tablet_root_path) {
     // 遍历跟目录寻找所有的shard
-    set<string> shards;
-    if (dir_walk(tablet_root_path + DATA_PREFIX, &shards, NULL) != OLAP_SUCCESS) {
+    set<string> shard_set;
+    if (dir_walk(tablet_root_path + DATA_PREFIX, &shard_set, NULL) != OLAP_SUCCESS) {
         OLAP_LOG_WARNING("fail to walk dir. [root=%s]", tablet_root_path.c_str());
         return OLAP_ERR_INIT_FAILED;
     }
 
-    for (const auto& shard : shards) {
+    // shard之间互不依赖, 每个root_path下用有限个线程并发加载各个shard,
+    // 每个table加载完成后立即加入_tablet_map对外可见, 不必等整个root_path加载完
+    vector<string> shards(shard_set.begin(), shard_set.end());
+    std::atomic<size_t> next_shard_index(0);
+    std::atomic<uint64_t> loaded_table_num(0);
+    size_t thread_num = std::min<size_t>(
+            std::max(config::load_tablet_thread_num_per_root_path, 1), shards.size());
+    OlapStopWatch watch;
+    if (thread_num <= 1) {
+        _load_shards_worker(tablet_root_path, &shards, &next_shard_index, &loaded_table_num);
+    } else {
+        boost::thread_group load_threads;
+        for (size_t i = 0; i < thread_num; ++i) {
+            load_threads.create_thread(boost::bind(
+                    &OLAPEngine::_load_shards_worker, this, boost::cref(tablet_root_path),
+                    &shards, &next_shard_index, &loaded_table_num));
+        }
+        load_threads.join_all();
+    }
+
+    OLAP_LOG_INFO("finish to load tables. [root=%s shard_num=%lu table_num=%lu thread_num=%lu "
+                  "cost=%luus]",
+                  tablet_root_path.c_str(), shards.size(), loaded_table_num.load(), thread_num,
+                  watch.get_elapse_time_us());
+    return OLAP_SUCCESS;
+}
+
+void OLAPEngine::_load_shards_worker(const string& tablet_root_path,
+                                     const vector<string>* shards,
+                                     std::atomic<size_t>* next_shard_index,
+                                     std::atomic<uint64_t>* loaded_table_num) {
+    while (true) {
+        size_t index = next_shard_index->fetch_add(1);
+        if (index >= shards->size()) {
+            break;
+        }
+
         // 遍历shard目录寻找此shard的所有tablet
         set<string> tablets;
-        string one_shard_path = tablet_root_path + DATA_PREFIX +  '/' + shard;
+        string one_shard_path = tablet_root_path + DATA_PREFIX +  '/' + (*shards)[index];
         if (dir_walk(one_shard_path, &tablets, NULL) != OLAP_SUCCESS) {
             OLAP_LOG_WARNING("fail to walk dir. [root=%s]", one_shard_path.c_str());
             continue;
@@ -108,18 +155,19 @@ OLAPStatus OLAPEngine::_load_tables(const string& tablet_root_path) {
 
                 // 遍历schema_hash目录寻找此index的所有schema
                 // 加载失败依然加载下一个Table
+                // 这里只解析header, 索引在table第一次被访问时才加载
                 if (load_one_tablet(
                         tablet_id,
                         tablet_schema_hash,
                         one_tablet_path + '/' + schema_hash) != OLAP_SUCCESS) {
                     OLAP_LOG_WARNING("fail to load one table, but continue. [path='%s']",
                                      (one_tablet_path + '/' + schema_hash).c_str());
+                } else {
+                    ++*loaded_table_num;
                 }
             }
         }
     }
-
-    return OLAP_SUCCESS;
 }
 
 OLAPStatus OLAPEngine::load_one_tablet(
@@ -250,6 +298,32 @@ OLAPStatus OLAPEngine::init() {
         return OLAP_ERR_INIT_FAILED;
     }
 
+    // 每个root path一个句柄cache，容量默认由各root path平分
+    vector<OLAPRootPathStat> fd_root_paths_stat;
+    OLAPRootPath::get_instance()->get_all_disk_stat(&fd_root_paths_stat);
+    if (!fd_root_paths_stat.empty()) {
+        int32_t per_path_capacity = config::file_descriptor_cache_capacity_per_root_path;
+        if (per_path_capacity <= 0) {
+            per_path_capacity = std::max(
+                    1, config::file_descriptor_cache_capacity
+                            / static_cast<int32_t>(fd_root_paths_stat.size()));
+        }
+        for (const OLAPRootPathStat& stat : fd_root_paths_stat) {
+            string root_path = stat.root_path;
+            while (root_path.size() > 1 && root_path[root_path.size() - 1] == '/') {
+                root_path.resize(root_path.size() - 1);
+            }
+            Cache* cache = new_lru_cache(per_path_capacity);
+            if (cache == NULL) {
+                OLAP_LOG_WARNING("failed to init file descriptor LRUCache. [root_path=%s]",
+                                 root_path.c_str());
+                _tablet_map.clear();
+                return OLAP_ERR_INIT_FAILED;
+            }
+            _root_path_fd_caches.push_back(std::make_pair(root_path, cache));
+        }
+    }
+
     // 初始化LRUCache
     // cache大小可通过配置文件配置
     _index_stream_lru_cache = new_lru_cache(config::index_stream_cache_capacity);
@@ -259,6 +333,39 @@ OLAPStatus OLAPEngine::init() {
         return OLAP_ERR_INIT_FAILED;
     }
 
+    if (config::data_page_cache_capacity > 0) {
+        _data_page_lru_cache = new_lru_cache(config::data_page_cache_capacity);
+        if (_data_page_lru_cache == NULL) {
+            OLAP_LOG_WARNING("failed to init data page LRUCache");
+            _tablet_map.clear();
+            return OLAP_ERR_INIT_FAILED;
+        }
+    }
+
+    if (config::row_cache_capacity > 0) {
+        _row_lru_cache = new_lru_cache(config::row_cache_capacity);
+        if (_row_lru_cache == NULL) {
+            OLAP_LOG_WARNING("failed to init row LRUCache");
+            _tablet_map.clear();
+            return OLAP_ERR_INIT_FAILED;
+        }
+    }
+
+    // 文件句柄cache的charge是句柄数，不参与内存的调配
+    CacheManager* cache_manager = CacheManager::get_instance();
+    cache_manager->register_cache("file_descriptor", _file_descriptor_lru_cache, false);
+    for (auto& path_cache : _root_path_fd_caches) {
+        cache_manager->register_cache("file_descriptor:" + path_cache.first,
+                                      path_cache.second, false);
+    }
+    cache_manager->register_cache("index_stream", _index_stream_lru_cache, true);
+    if (_data_page_lru_cache != NULL) {
+        cache_manager->register_cache("data_page", _data_page_lru_cache, true);
+    }
+    if (_row_lru_cache != NULL) {
+        cache_manager->register_cache("row", _row_lru_cache, true);
+    }
+
     // 初始化CE调度器
     vector<OLAPRootPathStat> all_root_paths_stat;
     OLAPRootPath::get_instance()->get_all_disk_stat(&all_root_paths_stat);
@@ -286,8 +393,22 @@ OLAPStatus OLAPEngine::init() {
 
 OLAPStatus OLAPEngine::clear() {
     // 删除lru中所有内容,其实进程退出这么做本身意义不大,但对单测和更容易发现问题还是有很大意义的
+    CacheManager* cache_manager = CacheManager::get_instance();
+    for (Cache* cache : {_file_descriptor_lru_cache, _index_stream_lru_cache,
+                         _data_page_lru_cache, _row_lru_cache}) {
+        if (cache != NULL) {
+            cache_manager->unregister_cache(cache);
+        }
+    }
+    for (auto& path_cache : _root_path_fd_caches) {
+        cache_manager->unregister_cache(path_cache.second);
+        SAFE_DELETE(path_cache.second);
+    }
+    _root_path_fd_caches.clear();
     SAFE_DELETE(_file_descriptor_lru_cache);
     SAFE_DELETE(_index_stream_lru_cache);
+    SAFE_DELETE(_data_page_lru_cache);
+    SAFE_DELETE(_row_lru_cache);
 
     _tablet_map.clear();
     _global_table_id = 0;
@@ -811,6 +932,35 @@ OLAPStatus OLAPEngine::report_tablet_info(TTabletInfo* tablet_info) {
     return res;
 }
 
+// 将tablet各列的统计草图转换为汇报给FE的格式, 调用方需持有header锁
+static void build_column_sketches(SmartOLAPTable olap_table, TTabletInfo* tablet_info) {
+    vector<ColumnSketchMessage> sketch_messages;
+    if (olap_table->merge_column_sketches(&sketch_messages) != OLAP_SUCCESS
+            || sketch_messages.empty()) {
+        return;
+    }
+
+    map<uint32_t, string> column_names;
+    for (const FieldInfo& field_info : olap_table->tablet_schema()) {
+        column_names[field_info.unique_id] = field_info.name;
+    }
+
+    vector<TColumnSketch> column_sketches;
+    for (const ColumnSketchMessage& message : sketch_messages) {
+        TColumnSketch column_sketch;
+        column_sketch.column_name = column_names[message.unique_id()];
+        column_sketch.num_rows = message.num_rows();
+        column_sketch.num_nulls = message.num_nulls();
+        column_sketch.ndv = ColumnSketch::estimate_cardinality(message);
+        if (message.histogram_bound_size() > 0) {
+            column_sketch.__set_histogram_bounds(vector<string>(
+                    message.histogram_bound().begin(), message.histogram_bound().end()));
+        }
+        column_sketches.push_back(column_sketch);
+    }
+    tablet_info->__set_column_sketches(column_sketches);
+}
+
 OLAPStatus OLAPEngine::report_all_tablets_info(
         map<TTabletId, TTablet>* tablets_info) {
     OLAP_LOG_DEBUG("begin to get all tablet info.");
@@ -849,6 +999,9 @@ OLAPStatus OLAPEngine::report_all_tablets_info(
                 tablet_info.version = last_file_version->end_version();
                 tablet_info.version_hash = last_file_version->version_hash();
             }
+            if (config::enable_column_sketch) {
+                build_column_sketches(olap_table, &tablet_info);
+            }
             olap_table->release_header_lock();
 
             if (available_storage_medium_type_count > 1) {
@@ -899,10 +1052,30 @@ bool OLAPEngine::_can_do_be_ce(SmartOLAPTable table) {
 void OLAPEngine::start_clean_fd_cache() {
     OLAP_LOG_TRACE("start clean file descritpor cache");
     _file_descriptor_lru_cache->prune();
+    for (auto& path_cache : _root_path_fd_caches) {
+        path_cache.second->prune();
+    }
     OLAP_LOG_TRACE("end clean file descritpor cache");
 }
 
-void OLAPEngine::start_base_expansion(string* last_be_fs, TTabletId* last_be_tablet_id) {
+Cache* OLAPEngine::file_descriptor_lru_cache(const string& file_name) {
+    // root path很少，直接找最长的前缀
+    Cache* found = _file_descriptor_lru_cache;
+    size_t found_len = 0;
+    for (const auto& path_cache : _root_path_fd_caches) {
+        const string& root_path = path_cache.first;
+        if (root_path.size() > found_len
+                && file_name.compare(0, root_path.size(), root_path) == 0
+                && (file_name.size() == root_path.size()
+                        || file_name[root_path.size()] == '/')) {
+            found = path_cache.second;
+            found_len = root_path.size();
+        }
+    }
+    return found;
+}
+
+void OLAPEngine::start_base_expansion(string* last_be_fs) {
     uint64_t allow_be_excute_start_time = config::be_policy_start_time;
     uint64_t allow_be_excute_end_time = config::be_policy_end_time;
     time_t current_time = time(NULL);
@@ -943,39 +1116,44 @@ void OLAPEngine::start_base_expansion(string* last_be_fs, TTabletId* last_be_tab
         last_be_fs->clear();
     }
 
+    // 版本数越多, 查询越频繁的tablet越优先做be
+    vector<pair<double, SmartOLAPTable> > candidates;
     for (const auto& i : _tablet_map) {
         for (SmartOLAPTable j : i.second.table_arr) {
-            // 保证从上一次被选中进行BE的表开始轮询
-            if (i.first <= *last_be_tablet_id) {
-                continue;
-            }
+            j->obtain_header_rdlock();
+            const double score = _compaction_score(j, j->file_version_size());
+            j->release_header_lock();
+            candidates.emplace_back(score, j);
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const pair<double, SmartOLAPTable>& a,
+                        const pair<double, SmartOLAPTable>& b) {
+                         return a.first > b.first;
+                     });
 
-            if (_fs_be_task_num_map[j->storage_root_path_name()] >= _max_be_task_per_disk) {
-                continue;
-            }
+    for (const auto& candidate : candidates) {
+        SmartOLAPTable j = candidate.second;
+        if (_fs_be_task_num_map[j->storage_root_path_name()] >= _max_be_task_per_disk) {
+            continue;
+        }
 
-            // 跳过正在做schema change的tablet
-            if (!_can_do_be_ce(j)) {
-                OLAP_LOG_DEBUG("skip tablet, it is schema changing. [tablet=%s]",
-                               j->full_name().c_str());
-                continue;
-            }
+        // 跳过正在做schema change的tablet
+        if (!_can_do_be_ce(j)) {
+            OLAP_LOG_DEBUG("skip tablet, it is schema changing. [tablet=%s]",
+                           j->full_name().c_str());
+            continue;
+        }
 
-            if (base_expansion_handler.init(j, false) == OLAP_SUCCESS) {
-                tablet = j;
-                do_base_expansion = true;
-                _fs_be_task_num_map[tablet->storage_root_path_name()] += 1;
-                *last_be_fs = tablet->storage_root_path_name();
-                *last_be_tablet_id = i.first;
-                goto TRY_START_BE_OK;
-            }
+        if (base_expansion_handler.init(j, false) == OLAP_SUCCESS) {
+            tablet = j;
+            do_base_expansion = true;
+            _fs_be_task_num_map[tablet->storage_root_path_name()] += 1;
+            *last_be_fs = tablet->storage_root_path_name();
+            break;
         }
     }
 
-    // when the loop comes the end, restart from begin
-    *last_be_tablet_id = -1;
-
-TRY_START_BE_OK:
     _fs_task_mutex.unlock();
     _tablet_map_lock.unlock();
     OLAP_LOG_TRACE("start_base_expansion end.");
@@ -991,30 +1169,32 @@ TRY_START_BE_OK:
 }
 
 void OLAPEngine::_select_candidate() {
-    // 这是一个小根堆，用于记录nice最大的top k个candidate tablet
+    // 这是一个小根堆，用于记录score最大的top k个candidate tablet
     SmartOLAPTable tablet;
     typedef priority_queue<ExpansionCandidate, vector<ExpansionCandidate>,
             ExpansionCandidateComparator> candidate_heap_t;
     vector<candidate_heap_t> candidate_heap_vec(_ce_disk_stat.size());
     for (const auto& i : _tablet_map) {
-        uint32_t nice = 0;
-        // calc nice
+        double score = 0;
+        // calc score
         for (SmartOLAPTable j : i.second.table_arr) {
             if (!j->is_loaded()) {
                 continue;
             }
 
             j->obtain_header_rdlock();
-            const uint32_t curr_nice = j->get_expansion_nice_estimate();
+            const double curr_score = _compaction_score(j, j->get_expansion_nice_estimate());
             j->release_header_lock();
-            nice = curr_nice > nice ? curr_nice : nice;
-            tablet = j;
+            if (curr_score > score) {
+                score = curr_score;
+                tablet = j;
+            }
         }
 
         // save
-        if (nice > 0) {
+        if (score > 0) {
             uint32_t disk_id = _disk_id_map[tablet->storage_root_path_name()];
-            candidate_heap_vec[disk_id].emplace(nice, i.first, disk_id);
+            candidate_heap_vec[disk_id].emplace(score, i.first, disk_id);
             if (candidate_heap_vec[disk_id].size() > OLAP_EXPANSION_DEFAULT_CANDIDATE_SIZE) {
                 candidate_heap_vec[disk_id].pop();
             }
@@ -1038,6 +1218,74 @@ void OLAPEngine::_select_candidate() {
     sort(_ce_candidate.rbegin(), _ce_candidate.rend(), ExpansionCandidateComparator());
 }
 
+void OLAPEngine::start_column_file_convert() {
+    int64_t legacy_tablet_num = 0;
+    int64_t min_data_size = -1;
+    SmartOLAPTable candidate;
+    _tablet_map_lock.rdlock();
+    for (const auto& i : _tablet_map) {
+        for (SmartOLAPTable j : i.second.table_arr) {
+            if (j->data_file_type() != OLAP_DATA_FILE) {
+                continue;
+            }
+
+            ++legacy_tablet_num;
+            j->obtain_header_rdlock();
+            int64_t data_size = j->get_data_size();
+            j->release_header_lock();
+            if (min_data_size < 0 || data_size < min_data_size) {
+                min_data_size = data_size;
+                candidate = j;
+            }
+        }
+    }
+    _tablet_map_lock.unlock();
+
+    if (PaloMetrics::legacy_tablet_num() != NULL) {
+        PaloMetrics::legacy_tablet_num()->set_value(legacy_tablet_num);
+    }
+    if (candidate.get() == NULL) {
+        return;
+    }
+
+    OLAP_LOG_INFO("start to convert table to column file. "
+                  "[table='%s' data_size=%ld legacy_tablet_num=%ld]",
+                  candidate->full_name().c_str(), min_data_size, legacy_tablet_num);
+    SchemaChangeHandler schema_change_handler;
+    OLAPStatus res = schema_change_handler.convert_to_column_file(candidate);
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to convert table to column file. [table='%s' res=%d]",
+                         candidate->full_name().c_str(), res);
+    }
+}
+
+void OLAPEngine::start_unload_cold_indices() {
+    int64_t cold_time = time(NULL) - config::cold_tablet_index_unload_sec;
+    vector<SmartOLAPTable> cold_tables;
+    _tablet_map_lock.rdlock();
+    for (const auto& i : _tablet_map) {
+        for (SmartOLAPTable j : i.second.table_arr) {
+            if (j->last_query_time() <= cold_time) {
+                cold_tables.push_back(j);
+            }
+        }
+    }
+    _tablet_map_lock.unlock();
+
+    size_t num_unloaded = 0;
+    for (SmartOLAPTable table : cold_tables) {
+        table->obtain_header_wrlock();
+        num_unloaded += table->unload_indices();
+        table->release_header_lock();
+    }
+
+    if (num_unloaded > 0) {
+        OLAP_LOG_INFO("unload indices of cold tablets. "
+                      "[cold_tablet_num=%lu unloaded_version_num=%lu]",
+                      cold_tables.size(), num_unloaded);
+    }
+}
+
 void OLAPEngine::start_cumulative_priority() {
     _tablet_map_lock.rdlock();
     _fs_task_mutex.lock();
@@ -1098,6 +1346,9 @@ void OLAPEngine::start_cumulative_priority() {
                 if (cumulative_handler.run() != OLAP_SUCCESS) {
                     OLAP_LOG_WARNING("failed to do cumulative. [tablet='%s']",
                                      j->full_name().c_str());
+                } else {
+                    // query count is recounted for the new cumulative layer
+                    j->reset_query_count();
                 }
 
                 _fs_task_mutex.lock();
@@ -1119,13 +1370,143 @@ void OLAPEngine::get_cache_status(rapidjson::Document* document) const {
     return _index_stream_lru_cache->get_cache_status(document);
 }
 
+double OLAPEngine::_compaction_score(SmartOLAPTable table, uint32_t nice) const {
+    if (0 == nice) {
+        return 0;
+    }
+
+    // hotness is in [0, 1), the more the tablet is queried since last compaction,
+    // the more queries benefit from compacting it
+    double query_count = table->query_count();
+    double query_count_base = std::max<int64_t>(config::compaction_score_query_count_base, 1);
+    double hotness = query_count / (query_count + query_count_base);
+
+    double delta_size = table->get_cumulative_delta_size();
+    double delta_size_unit = std::max<int64_t>(config::ce_policy_max_delta_file_size, 1);
+
+    return nice * (1.0 + hotness) + delta_size / delta_size_unit;
+}
+
+void OLAPEngine::get_compaction_status(rapidjson::Document* document) {
+    rapidjson::Document::AllocatorType& allocator = document->GetAllocator();
+    document->SetObject();
+
+    _fs_task_mutex.lock();
+    rapidjson::Value disks(rapidjson::kArrayType);
+    for (const ExpansionDiskStat& stat : _ce_disk_stat) {
+        rapidjson::Value disk(rapidjson::kObjectType);
+        disk.AddMember("path", rapidjson::Value(stat.storage_path.c_str(), allocator), allocator);
+        disk.AddMember("is_used", stat.is_used, allocator);
+        disk.AddMember("cumulative_running", stat.task_running, allocator);
+        disk.AddMember("cumulative_remaining", stat.task_remaining, allocator);
+        disk.AddMember("base_expansion_running",
+                       _fs_be_task_num_map[stat.storage_path], allocator);
+        disks.PushBack(disk, allocator);
+    }
+
+    // _ce_candidate is sorted from small to big, and started from the back
+    rapidjson::Value candidates(rapidjson::kArrayType);
+    for (auto it = _ce_candidate.rbegin(); it != _ce_candidate.rend(); ++it) {
+        rapidjson::Value candidate(rapidjson::kObjectType);
+        candidate.AddMember("tablet_id", it->tablet_id, allocator);
+        candidate.AddMember("score", it->score, allocator);
+        candidate.AddMember("path",
+                            rapidjson::Value(_ce_disk_stat[it->disk_index].storage_path.c_str(),
+                                             allocator),
+                            allocator);
+        candidates.PushBack(candidate, allocator);
+    }
+    _fs_task_mutex.unlock();
+
+    document->AddMember("max_cumulative_task_per_disk", _max_ce_task_per_disk, allocator);
+    document->AddMember("max_base_expansion_task_per_disk", _max_be_task_per_disk, allocator);
+    document->AddMember("disks", disks, allocator);
+    document->AddMember("cumulative_candidates", candidates, allocator);
+}
+
+void OLAPEngine::decay_tablet_access_stats(double factor) {
+    _tablet_map_lock.rdlock();
+    for (const auto& i : _tablet_map) {
+        for (SmartOLAPTable j : i.second.table_arr) {
+            j->access_stats()->decay(factor);
+        }
+    }
+    _tablet_map_lock.unlock();
+}
+
+void OLAPEngine::get_tablet_access_stats(size_t limit, rapidjson::Document* document) {
+    vector<SmartOLAPTable> tables;
+    _tablet_map_lock.rdlock();
+    for (const auto& i : _tablet_map) {
+        for (SmartOLAPTable j : i.second.table_arr) {
+            tables.push_back(j);
+        }
+    }
+    _tablet_map_lock.unlock();
+
+    // 各root path的近期读盘量, 用来找出压在热盘上的tablet
+    map<string, double> root_path_read_bytes_rate;
+    for (const SmartOLAPTable& table : tables) {
+        root_path_read_bytes_rate[table->storage_root_path_name()] +=
+                table->access_stats()->read_bytes_rate();
+    }
+
+    auto hotter = [](const SmartOLAPTable& a, const SmartOLAPTable& b) {
+        const TabletAccessStats* sa = a->access_stats();
+        const TabletAccessStats* sb = b->access_stats();
+        if (sa->read_bytes_rate() != sb->read_bytes_rate()) {
+            return sa->read_bytes_rate() > sb->read_bytes_rate();
+        }
+        return sa->row_rate() > sb->row_rate();
+    };
+    if (tables.size() > limit) {
+        std::partial_sort(tables.begin(), tables.begin() + limit, tables.end(), hotter);
+        tables.resize(limit);
+    } else {
+        std::sort(tables.begin(), tables.end(), hotter);
+    }
+
+    rapidjson::Document::AllocatorType& allocator = document->GetAllocator();
+    document->SetObject();
+
+    rapidjson::Value root_paths(rapidjson::kArrayType);
+    for (const auto& it : root_path_read_bytes_rate) {
+        rapidjson::Value root_path(rapidjson::kObjectType);
+        root_path.AddMember("path", rapidjson::Value(it.first.c_str(), allocator), allocator);
+        root_path.AddMember("read_bytes_rate", it.second, allocator);
+        root_paths.PushBack(root_path, allocator);
+    }
+
+    rapidjson::Value tablets(rapidjson::kArrayType);
+    for (const SmartOLAPTable& table : tables) {
+        TabletAccessStats* stats = table->access_stats();
+        rapidjson::Value tablet(rapidjson::kObjectType);
+        tablet.AddMember("tablet_id", table->tablet_id(), allocator);
+        tablet.AddMember("schema_hash", table->schema_hash(), allocator);
+        tablet.AddMember("path",
+                         rapidjson::Value(table->storage_root_path_name().c_str(), allocator),
+                         allocator);
+        tablet.AddMember("scans", stats->scans(), allocator);
+        tablet.AddMember("rows", stats->rows(), allocator);
+        tablet.AddMember("read_bytes", stats->read_bytes(), allocator);
+        tablet.AddMember("scan_time_ns", stats->scan_time_ns(), allocator);
+        tablet.AddMember("scan_rate", stats->scan_rate(), allocator);
+        tablet.AddMember("row_rate", stats->row_rate(), allocator);
+        tablet.AddMember("read_bytes_rate", stats->read_bytes_rate(), allocator);
+        tablets.PushBack(tablet, allocator);
+    }
+
+    document->AddMember("decay_interval_sec",
+                        config::tablet_access_stats_decay_interval_sec, allocator);
+    document->AddMember("half_life_sec", config::tablet_access_stats_half_life_sec, allocator);
+    document->AddMember("root_paths", root_paths, allocator);
+    document->AddMember("tablets", tablets, allocator);
+}
+
 OLAPStatus OLAPEngine::start_trash_sweep(double* usage) {
     OLAPStatus res = OLAP_SUCCESS;
     OLAP_LOG_INFO("start trash and snapshot sweep.");
 
-    const uint32_t snapshot_expire = config::snapshot_expire_time_sec;
-    const uint32_t trash_expire = config::trash_file_expire_time_sec;
-    const double guard_space = config::disk_capacity_insufficient_percentage / 100.0;
     std::vector<OLAPRootPathStat> disks_stat;
     res = OLAPRootPath::get_instance()->get_all_disk_stat(&disks_stat);
     if (res != OLAP_SUCCESS) {
@@ -1141,77 +1522,174 @@ OLAPStatus OLAPEngine::start_trash_sweep(double* usage) {
     }
     const time_t local_now = mktime(&local_tm_now); //得到当地日历时间
 
-    for (OLAPRootPathStat& stat : disks_stat) {
-        if (!stat.is_used) {
+    vector<double> usages(disks_stat.size(), 0);
+    vector<OLAPStatus> results(disks_stat.size(), OLAP_SUCCESS);
+    boost::thread_group sweep_threads;
+    for (size_t i = 0; i < disks_stat.size(); ++i) {
+        if (!disks_stat[i].is_used) {
             continue;
         }
+        sweep_threads.create_thread(boost::bind(
+                &OLAPEngine::_sweep_root_path, this,
+                boost::cref(disks_stat[i]), boost::cref(local_now), &usages[i], &results[i]));
+    }
+    sweep_threads.join_all();
 
-        double curr_usage = (stat.disk_total_capacity - stat.disk_available_capacity)
-                / (double) stat.disk_total_capacity;
-        *usage = *usage > curr_usage ? *usage : curr_usage;
-
-        OLAPStatus curr_res = OLAP_SUCCESS;
-        string snapshot_path = stat.root_path + SNAPSHOT_PREFIX;
-        curr_res = _do_sweep(snapshot_path, local_now, snapshot_expire);
-        if (curr_res != OLAP_SUCCESS) {
-            OLAP_LOG_WARNING("failed to sweep snapshot. [path=%s, err_code=%d]",
-                    snapshot_path.c_str(), curr_res);
-            res = curr_res;
-        }
-
-        string trash_path = stat.root_path + TRASH_PREFIX;
-        curr_res = _do_sweep(trash_path, local_now,
-                curr_usage > guard_space ? 0 : trash_expire);
-        if (curr_res != OLAP_SUCCESS) {
-            OLAP_LOG_WARNING("failed to sweep trash. [path=%s, err_code=%d]",
-                    trash_path.c_str(), curr_res);
-            res = curr_res;
+    for (size_t i = 0; i < disks_stat.size(); ++i) {
+        *usage = *usage > usages[i] ? *usage : usages[i];
+        if (results[i] != OLAP_SUCCESS) {
+            res = results[i];
         }
     }
 
     return res;
 }
 
+void OLAPEngine::_sweep_root_path(const OLAPRootPathStat& stat, const time_t& local_now,
+                                  double* usage, OLAPStatus* res) {
+    const uint32_t snapshot_expire = config::snapshot_expire_time_sec;
+    const uint32_t trash_expire = config::trash_file_expire_time_sec;
+    const double guard_space = config::disk_capacity_insufficient_percentage / 100.0;
+
+    double curr_usage = (stat.disk_total_capacity - stat.disk_available_capacity)
+            / (double) stat.disk_total_capacity;
+    *usage = curr_usage;
+
+    OLAPStatus curr_res = OLAP_SUCCESS;
+    string snapshot_path = stat.root_path + SNAPSHOT_PREFIX;
+    curr_res = _do_sweep(snapshot_path, local_now, snapshot_expire);
+    if (curr_res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("failed to sweep snapshot. [path=%s, err_code=%d]",
+                snapshot_path.c_str(), curr_res);
+        *res = curr_res;
+    }
+
+    // 增量clone的临时目录与snapshot同样以时间戳命名, 按snapshot的过期时间清理
+    string clone_path = stat.root_path + CLONE_PREFIX;
+    curr_res = _do_sweep(clone_path, local_now, snapshot_expire);
+    if (curr_res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("failed to sweep clone. [path=%s, err_code=%d]",
+                clone_path.c_str(), curr_res);
+        *res = curr_res;
+    }
+
+    string trash_path = stat.root_path + TRASH_PREFIX;
+    curr_res = _do_sweep(trash_path, local_now,
+            curr_usage > guard_space ? 0 : trash_expire);
+    if (curr_res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("failed to sweep trash. [path=%s, err_code=%d]",
+                trash_path.c_str(), curr_res);
+        *res = curr_res;
+    }
+}
+
 OLAPStatus OLAPEngine::_do_sweep(
         const string& scan_root, const time_t& local_now, const uint32_t expire) {
     OLAPStatus res = OLAP_SUCCESS;
-    if (!check_dir_existed(scan_root)) {
+    SweepIndex* index = NULL;
+    {
+        AutoMutexLock auto_lock(&_sweep_index_lock);
+        index = &_sweep_indexes[scan_root];
+    }
+
+    struct stat scan_root_stat;
+    if (stat(scan_root.c_str(), &scan_root_stat) != 0) {
         // dir not existed. no need to sweep trash.
+        index->dir_mtime_ns = -1;
+        index->create_time_to_path.clear();
         return res;
     }
 
-    try {
-        path boost_scan_root(scan_root);
-        directory_iterator item(boost_scan_root);
-        directory_iterator item_end;
-        for (; item != item_end; ++item) {
-            string path_name = item->path().string();
-            string dir_name = item->path().filename().string();
-            string str_time = dir_name.substr(0, dir_name.find('.'));
-            tm local_tm_create;
-            if (strptime(str_time.c_str(), "%Y%m%d%H%M%S", &local_tm_create) == nullptr) {
-                OLAP_LOG_WARNING("fail to strptime time. [time=%lu]", str_time.c_str());
-                res = OLAP_ERR_OS_ERROR;
-                continue;
-            }
-            if (difftime(local_now, mktime(&local_tm_create)) >= expire) {
-                if (remove_all_dir(path_name) != OLAP_SUCCESS) {
-                    OLAP_LOG_WARNING("fail to remove file or directory. [path=%s]",
-                            path_name.c_str());
+    // 目录下新增或删除子目录都会改变mtime, 只在mtime变化时重新扫描建立索引.
+    // 本轮删除的目录也会改变mtime, 下一轮会重新扫描一次
+    int64_t dir_mtime_ns = scan_root_stat.st_mtim.tv_sec * 1000000000L
+            + scan_root_stat.st_mtim.tv_nsec;
+    if (dir_mtime_ns != index->dir_mtime_ns) {
+        index->create_time_to_path.clear();
+        try {
+            path boost_scan_root(scan_root);
+            directory_iterator item(boost_scan_root);
+            directory_iterator item_end;
+            for (; item != item_end; ++item) {
+                string path_name = item->path().string();
+                string dir_name = item->path().filename().string();
+                string str_time = dir_name.substr(0, dir_name.find('.'));
+                tm local_tm_create;
+                if (strptime(str_time.c_str(), "%Y%m%d%H%M%S", &local_tm_create) == nullptr) {
+                    OLAP_LOG_WARNING("fail to strptime time. [time=%lu]", str_time.c_str());
                     res = OLAP_ERR_OS_ERROR;
                     continue;
                 }
+                index->create_time_to_path.insert(
+                        std::make_pair(mktime(&local_tm_create), path_name));
             }
+        } catch (...) {
+            OLAP_LOG_WARNING("Exception occur when scan directory. [path=%s]",
+                    scan_root.c_str());
+            index->create_time_to_path.clear();
+            return OLAP_ERR_IO_ERROR;
         }
-    } catch (...) {
-        OLAP_LOG_WARNING("Exception occur when scan directory. [path=%s]",
-                scan_root.c_str());
-        res = OLAP_ERR_IO_ERROR;
+        index->dir_mtime_ns = dir_mtime_ns;
+    }
+
+    std::multimap<time_t, string>::iterator it = index->create_time_to_path.begin();
+    while (it != index->create_time_to_path.end()
+            && difftime(local_now, it->first) >= expire) {
+        if (_remove_dir_with_limit(it->second) != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to remove file or directory. [path=%s]",
+                    it->second.c_str());
+            res = OLAP_ERR_OS_ERROR;
+            ++it;
+            continue;
+        }
+        index->create_time_to_path.erase(it++);
     }
 
     return res;
 }
 
+OLAPStatus OLAPEngine::_remove_dir_with_limit(const string& dir_path) {
+    int32_t max_unlink_per_sec = config::trash_sweep_max_unlink_per_sec_per_path;
+    if (max_unlink_per_sec <= 0) {
+        return remove_all_dir(dir_path);
+    }
+
+    vector<string> paths;
+    try {
+        paths.push_back(dir_path);
+        if (is_directory(dir_path)) {
+            recursive_directory_iterator item(dir_path);
+            recursive_directory_iterator item_end;
+            for (; item != item_end; ++item) {
+                paths.push_back(item->path().string());
+            }
+        }
+    } catch (...) {
+        OLAP_LOG_WARNING("Exception occur when scan directory. [path=%s]", dir_path.c_str());
+        return OLAP_ERR_IO_ERROR;
+    }
+
+    // 子项总是在其父目录之后遍历到, 倒序删除即可先删除子项
+    OlapStopWatch watch;
+    int64_t removed_num = 0;
+    for (vector<string>::reverse_iterator it = paths.rbegin(); it != paths.rend(); ++it) {
+        if (::remove(it->c_str()) != 0 && errno != ENOENT) {
+            OLAP_LOG_WARNING("fail to remove file. [path=%s errno=%d]", it->c_str(), errno);
+            return OLAP_ERR_OS_ERROR;
+        }
+
+        ++removed_num;
+        int64_t expect_time_us = removed_num * 1000000L / max_unlink_per_sec;
+        int64_t elapse_time_us = watch.get_elapse_time_us();
+        // 至少积累10ms再sleep, 避免频繁的小睡眠
+        if (expect_time_us - elapse_time_us >= 10000) {
+            usleep(expect_time_us - elapse_time_us);
+        }
+    }
+
+    return OLAP_SUCCESS;
+}
+
 OLAPStatus OLAPEngine::_create_new_table_header_file(
         const TCreateTabletReq& request, const string& root_path, string* header_path,
         const bool is_schema_change_table, const SmartOLAPTable ref_olap_table) {
@@ -1374,6 +1852,36 @@ OLAPStatus OLAPEngine::_create_new_table_header_file(
             has_bf_columns = true;
         }
 
+        if (column.__isset.is_blocked_bloom_filter) {
+            header.mutable_column(i)->set_is_blocked_bf(column.is_blocked_bloom_filter);
+        }
+
+        if (column.__isset.compress_kind) {
+            switch (column.compress_kind) {
+            case TCompressKind::NONE:
+                header.mutable_column(i)->set_compress_kind(COMPRESS_NONE);
+                break;
+            case TCompressKind::LZO:
+                header.mutable_column(i)->set_compress_kind(COMPRESS_LZO);
+                break;
+            case TCompressKind::LZ4:
+                header.mutable_column(i)->set_compress_kind(COMPRESS_LZ4);
+                break;
+            case TCompressKind::ZSTD:
+                header.mutable_column(i)->set_compress_kind(COMPRESS_ZSTD);
+                break;
+            default:
+                OLAP_LOG_WARNING("unknown compress kind of column. [column=%s kind=%d]",
+                                 column.column_name.c_str(), column.compress_kind);
+                remove_dir(header_dir);
+                return OLAP_ERR_INPUT_PARAMETER_ERROR;
+            }
+
+            if (column.__isset.compress_level) {
+                header.mutable_column(i)->set_compress_level(column.compress_level);
+            }
+        }
+
         ++i;
     }
     if (true == is_schema_change_table){
@@ -16,6 +16,7 @@
 #ifndef BDG_PALO_BE_SRC_OLAP_OLAP_ENGINE_H
 #define BDG_PALO_BE_SRC_OLAP_OLAP_ENGINE_H
 
+#include <atomic>
 #include <ctime>
 #include <list>
 #include <map>
@@ -110,14 +111,30 @@ public:
     OLAPStatus clear();
 
     void start_clean_fd_cache();
-    void start_base_expansion(std::string* last_be_fs, TTabletId* last_be_tablet_id);
+    // 按compaction score从高到低选择tablet做be
+    void start_base_expansion(std::string* last_be_fs);
 
     // 调度ce，优先级调度
     void start_cumulative_priority();
 
+    // 选择数据量最小的行存tablet转换为列存, 每次只转换一个tablet
+    void start_column_file_convert();
+
+    // 释放超过cold_tablet_index_unload_sec没有被查询的tablet的short key索引
+    void start_unload_cold_indices();
+
     // 获取cache的使用情况信息
     void get_cache_status(rapidjson::Document* document) const;
 
+    // 获取各磁盘上的compaction任务数和ce候选队列
+    void get_compaction_status(rapidjson::Document* document);
+
+    // 衰减所有tablet的访问统计, 由一个线程定期调用
+    void decay_tablet_access_stats(double factor);
+
+    // 获取按近期读盘量排序的前limit个tablet的访问统计, 以及各root path的合计
+    void get_tablet_access_stats(size_t limit, rapidjson::Document* document);
+
     // Note: 这里只能reload原先已经存在的root path，即re-load启动时就登记的root path
     // 是允许的，但re-load全新的path是不允许的，因为此处没有彻底更新ce调度器信息
     void load_root_paths(const OLAPRootPath::RootPathVec& root_paths);
@@ -130,10 +147,24 @@ public:
         return _index_stream_lru_cache;
     }
 
+    // NULL if data_page_cache_capacity is 0
+    Cache* data_page_lru_cache() {
+        return _data_page_lru_cache;
+    }
+
     Cache* file_descriptor_lru_cache() {
         return _file_descriptor_lru_cache;
     }
 
+    // 文件所在root path的句柄cache，各root path按各自的容量独立淘汰，一块盘上的大量打开
+    // 不会挤掉其他盘上的句柄。不在启动时的root path下的文件使用全局的句柄cache
+    Cache* file_descriptor_lru_cache(const std::string& file_name);
+
+    // NULL if row_cache_capacity is 0
+    Cache* row_lru_cache() {
+        return _row_lru_cache;
+    }
+
     // 清理trash和snapshot文件，返回清理后的磁盘使用量
     OLAPStatus start_trash_sweep(double *usage);
 
@@ -144,16 +175,16 @@ private:
     };
 
     struct ExpansionCandidate {
-        ExpansionCandidate(uint32_t nice_, int64_t tablet_id_, uint32_t index_) :
-                nice(nice_), tablet_id(tablet_id_), disk_index(index_) {}
-        uint32_t nice; // 优先度
+        ExpansionCandidate(double score_, int64_t tablet_id_, uint32_t index_) :
+                score(score_), tablet_id(tablet_id_), disk_index(index_) {}
+        double score; // 优先度
         int64_t tablet_id;
         uint32_t disk_index = -1;
     };
 
     struct ExpansionCandidateComparator {
         bool operator()(const ExpansionCandidate& a, const ExpansionCandidate& b) {
-            return a.nice > b.nice;
+            return a.score > b.score;
         }
     };
 
@@ -184,6 +215,12 @@ private:
     // 扫描目录, 加载表
     OLAPStatus _load_tables(const std::string& tables_root_path);
 
+    // 依次领取shards中未加载的shard并加载其中所有的table, 由_load_tables的多个线程并发执行
+    void _load_shards_worker(const std::string& tables_root_path,
+                             const std::vector<std::string>* shards,
+                             std::atomic<size_t>* next_shard_index,
+                             std::atomic<uint64_t>* loaded_table_num);
+
     OLAPStatus _create_new_table_header_file(const TCreateTabletReq& request,
                                              const std::string& root_path,
                                              std::string* header_path,
@@ -196,18 +233,42 @@ private:
 
     void _select_candidate();
 
+    // 根据需要合并的版本数nice, 查询频率和cumulative数据量计算compaction score,
+    // nice为0时返回0. 调用前需要对table的header加锁
+    double _compaction_score(SmartOLAPTable table, uint32_t nice) const;
+
     void _cancel_unfinished_schema_change();
 
     static OLAPStatus _spawn_load_root_path_thread(pthread_t* thread, const std::string& root_path);
 
+    // 清理一个root_path下过期的snapshot, clone和trash, 每个root_path在单独的线程中执行
+    void _sweep_root_path(const OLAPRootPathStat& stat, const time_t& local_now,
+                          double* usage, OLAPStatus* res);
+
     OLAPStatus _do_sweep(
             const std::string& scan_root, const time_t& local_tm_now, const uint32_t expire);
 
+    // 按trash_sweep_max_unlink_per_sec_per_path限速删除目录, 避免集中unlink造成IO尖峰
+    OLAPStatus _remove_dir_with_limit(const std::string& dir_path);
+
+    // 以时间戳命名的目录的过期索引, 扫描目录的mtime未变化时直接使用索引,
+    // 每轮清理只访问已过期的目录
+    struct SweepIndex {
+        SweepIndex() : dir_mtime_ns(-1) {}
+
+        int64_t dir_mtime_ns;
+        std::multimap<time_t, std::string> create_time_to_path;
+    };
+
     RWLock _tablet_map_lock;
     tablet_map_t _tablet_map;
     size_t _global_table_id;
     Cache* _file_descriptor_lru_cache;
+    // (root path, 句柄cache)，init后不再变化
+    std::vector<std::pair<std::string, Cache*> > _root_path_fd_caches;
     Cache* _index_stream_lru_cache;
+    Cache* _data_page_lru_cache;
+    Cache* _row_lru_cache;
     uint32_t _max_be_task_per_disk;
     uint32_t _max_ce_task_per_disk;
 
@@ -217,6 +278,9 @@ private:
     std::vector<ExpansionDiskStat> _ce_disk_stat;
     std::map<std::string, uint32_t> _disk_id_map;
 
+    MutexLock _sweep_index_lock;
+    std::map<std::string, SweepIndex> _sweep_indexes;
+
     DISALLOW_COPY_AND_ASSIGN(OLAPEngine);
 };
 
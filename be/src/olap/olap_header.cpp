@@ -15,6 +15,9 @@
 
 #include "olap/olap_header.h"
 
+#include <stdio.h>
+#include <string.h>
+
 #include <algorithm>
 #include <fstream>
 #include <queue>
@@ -23,6 +26,8 @@
 #include <utility>
 #include <vector>
 
+#include "common/config.h"
+#include "olap/column_sketch.h"
 #include "olap/field.h"
 #include "olap/file_helper.h"
 #include "olap/utils.h"
@@ -41,6 +46,9 @@ using std::unordered_map;
 using std::vector;
 
 namespace palo {
+
+// upper bound of the paths cached in a header
+static const size_t MAX_CACHED_VERSION_PATHS = 16;
 // related static functions of version graph
 
 // Construct version graph(using adjacency list) from header's information.
@@ -98,7 +106,22 @@ OLAPStatus OLAPHeader::load() {
         return OLAP_ERR_PARSE_PROTOBUF_ERROR;
     }
 
+    int32_t num_log_records = 0;
+    bool is_log_complete = true;
+    if (header_log_id() != 0) {
+        OLAPStatus res = _replay_log(&num_log_records, &is_log_complete);
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to replay header log. [path='%s']", _file_name.c_str());
+            return res;
+        }
+    }
+
+    _reset_saved_state();
+    // 日志尾部不完整时追加的记录无法回放, 下次保存时重写整个header
+    _num_log_records = is_log_complete ? num_log_records : std::numeric_limits<int32_t>::max();
+
     clear_version_graph(&_version_graph, &_vertex_helper_map);
+    _clear_version_path_cache();
 
     if (construct_version_graph(file_version(),
                                 &_version_graph,
@@ -111,10 +134,40 @@ OLAPStatus OLAPHeader::load() {
 }
 
 OLAPStatus OLAPHeader::save() {
-    return save(_file_name);
+    bool is_logged = false;
+    OLAPStatus res = _append_log(&is_logged);
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to append header log, rewrite the header. [res=%d path='%s']",
+                         res, _file_name.c_str());
+    } else if (is_logged) {
+        return OLAP_SUCCESS;
+    }
+
+    // 新的header_log_id使之前的日志失效, 即使删除日志文件之前失败也不会被回放
+    set_header_log_id(config::header_log_max_records > 0 ? header_log_id() + 1 : 0);
+    res = _write_header_file(_file_name, false);
+    if (res != OLAP_SUCCESS) {
+        return res;
+    }
+
+    string log_file_name = _log_file_name();
+    if (check_dir_existed(log_file_name) && remove(log_file_name.c_str()) != 0) {
+        OLAP_LOG_WARNING("fail to remove header log. [file='%s' err=%m]", log_file_name.c_str());
+    }
+
+    _reset_saved_state();
+    return OLAP_SUCCESS;
 }
 
 OLAPStatus OLAPHeader::save(const string& file_path) {
+    if (file_path == _file_name) {
+        return save();
+    }
+
+    return _write_header_file(file_path, true);
+}
+
+OLAPStatus OLAPHeader::_write_header_file(const string& file_path, bool clear_log_id) {
     FileHeader<OLAPHeaderMessage> file_header;
     FileHandler file_handler;
 
@@ -131,6 +184,10 @@ OLAPStatus OLAPHeader::save(const string& file_path) {
         return OLAP_ERR_OTHER_ERROR;
     }
 
+    if (clear_log_id) {
+        file_header.mutable_message()->clear_header_log_id();
+    }
+
     if (file_header.prepare(&file_handler) != OLAP_SUCCESS
             || file_header.serialize(&file_handler) != OLAP_SUCCESS) {
         OLAP_LOG_WARNING("fail to serialize to file header. [path='%s']", file_path.c_str());
@@ -140,6 +197,200 @@ OLAPStatus OLAPHeader::save(const string& file_path) {
     return OLAP_SUCCESS;
 }
 
+// 增量日志中每条记录的头, 其后是序列化的OLAPHeaderDeltaMessage
+struct HeaderLogRecordHead {
+    uint32_t length;
+    uint32_t checksum;
+};
+
+OLAPStatus OLAPHeader::_append_log(bool* is_logged) {
+    *is_logged = false;
+    if (config::header_log_max_records <= 0
+            || header_log_id() == 0
+            || _num_log_records >= config::header_log_max_records) {
+        return OLAP_SUCCESS;
+    }
+
+    // version之外的字段变化时重写整个header
+    string meta;
+    _serialize_meta(&meta);
+    if (meta != _saved_meta) {
+        return OLAP_SUCCESS;
+    }
+
+    OLAPHeaderDeltaMessage delta;
+    delta.set_header_log_id(header_log_id());
+    std::map<Version, string> versions;
+    for (const FileVersionMessage& version_message : file_version()) {
+        Version version(version_message.start_version(), version_message.end_version());
+        string value = version_message.SerializeAsString();
+        std::map<Version, string>::const_iterator it = _saved_versions.find(version);
+        if (it == _saved_versions.end() || it->second != value) {
+            delta.add_add_version()->CopyFrom(version_message);
+        }
+        versions[version].swap(value);
+    }
+
+    for (std::map<Version, string>::const_iterator it = _saved_versions.begin();
+            it != _saved_versions.end(); ++it) {
+        std::map<Version, string>::const_iterator cur = versions.find(it->first);
+        if (cur == versions.end() || cur->second != it->second) {
+            if (!delta.add_delete_version()->ParseFromString(it->second)) {
+                OLAP_LOG_WARNING("fail to parse saved version. [version='%d-%d']",
+                                 it->first.first, it->first.second);
+                return OLAP_ERR_PARSE_PROTOBUF_ERROR;
+            }
+        }
+    }
+
+    if (delta.add_version_size() == 0 && delta.delete_version_size() == 0) {
+        *is_logged = true;
+        return OLAP_SUCCESS;
+    }
+
+    string payload;
+    if (!delta.SerializeToString(&payload)) {
+        OLAP_LOG_WARNING("fail to serialize header delta. [path='%s']", _file_name.c_str());
+        return OLAP_ERR_SERIALIZE_PROTOBUF_ERROR;
+    }
+
+    HeaderLogRecordHead head;
+    head.length = payload.size();
+    head.checksum = olap_adler32(ADLER32_INIT, payload.data(), payload.size());
+    // 记录头和内容一次写入, 减少记录被部分写入的可能
+    string record(reinterpret_cast<const char*>(&head), sizeof(head));
+    record.append(payload);
+
+    string log_file_name = _log_file_name();
+    FileHandler file_handler;
+    if (file_handler.open_with_mode(log_file_name,
+            O_CREAT | O_WRONLY | O_APPEND, S_IRUSR | S_IWUSR) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to open header log. [file='%s']", log_file_name.c_str());
+        return OLAP_ERR_IO_ERROR;
+    }
+
+    if (file_handler.write(record.data(), record.size()) != OLAP_SUCCESS
+            || file_handler.close() != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to write header log. [file='%s']", log_file_name.c_str());
+        return OLAP_ERR_IO_ERROR;
+    }
+
+    _saved_versions.swap(versions);
+    ++_num_log_records;
+    *is_logged = true;
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus OLAPHeader::_replay_log(int32_t* num_records, bool* is_complete) {
+    *num_records = 0;
+    *is_complete = true;
+
+    string log_file_name = _log_file_name();
+    if (!check_dir_existed(log_file_name)) {
+        return OLAP_SUCCESS;
+    }
+
+    FileHandler file_handler;
+    if (file_handler.open(log_file_name, O_RDONLY) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to open header log. [file='%s']", log_file_name.c_str());
+        return OLAP_ERR_IO_ERROR;
+    }
+
+    off_t length = file_handler.length();
+    if (length < 0) {
+        OLAP_LOG_WARNING("fail to get length of header log. [file='%s']",
+                         log_file_name.c_str());
+        return OLAP_ERR_IO_ERROR;
+    }
+
+    // 日志记录数有上限, 一次读入
+    string buf(length, '\0');
+    if (length > 0 && file_handler.pread(&buf[0], length, 0) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to read header log. [file='%s']", log_file_name.c_str());
+        return OLAP_ERR_IO_ERROR;
+    }
+    file_handler.close();
+
+    RepeatedPtrField<FileVersionMessage>* versions = mutable_file_version();
+    size_t offset = 0;
+    while (offset + sizeof(HeaderLogRecordHead) <= buf.size()) {
+        HeaderLogRecordHead head;
+        memcpy(&head, buf.data() + offset, sizeof(head));
+        const char* payload = buf.data() + offset + sizeof(head);
+        if (offset + sizeof(head) + head.length > buf.size()
+                || olap_adler32(ADLER32_INIT, payload, head.length) != head.checksum) {
+            break;
+        }
+
+        OLAPHeaderDeltaMessage delta;
+        if (!delta.ParseFromArray(payload, head.length)) {
+            break;
+        }
+        offset += sizeof(head) + head.length;
+
+        // 重写header之前残留的日志
+        if (delta.header_log_id() != header_log_id()) {
+            continue;
+        }
+
+        for (const FileVersionMessage& deleted : delta.delete_version()) {
+            for (int i = 0; i < versions->size(); ++i) {
+                if (versions->Get(i).start_version() == deleted.start_version()
+                        && versions->Get(i).end_version() == deleted.end_version()) {
+                    for (int j = i; j < versions->size() - 1; ++j) {
+                        versions->SwapElements(j, j + 1);
+                    }
+                    versions->RemoveLast();
+                    break;
+                }
+            }
+        }
+
+        for (const FileVersionMessage& added : delta.add_version()) {
+            FileVersionMessage* target = NULL;
+            for (int i = 0; i < versions->size(); ++i) {
+                if (versions->Get(i).start_version() == added.start_version()
+                        && versions->Get(i).end_version() == added.end_version()) {
+                    target = versions->Mutable(i);
+                    break;
+                }
+            }
+            if (target == NULL) {
+                target = versions->Add();
+            }
+            target->CopyFrom(added);
+        }
+
+        ++(*num_records);
+    }
+
+    if (offset != buf.size()) {
+        OLAP_LOG_WARNING("header log is not complete, ignore the tail. "
+                         "[file='%s' offset=%lu length=%ld]",
+                         log_file_name.c_str(), offset, length);
+        *is_complete = false;
+    }
+
+    return OLAP_SUCCESS;
+}
+
+void OLAPHeader::_serialize_meta(string* meta) const {
+    OLAPHeaderMessage message;
+    message.CopyFrom(*this);
+    message.clear_file_version();
+    message.SerializePartialToString(meta);
+}
+
+void OLAPHeader::_reset_saved_state() {
+    _serialize_meta(&_saved_meta);
+    _saved_versions.clear();
+    for (const FileVersionMessage& version_message : file_version()) {
+        _saved_versions[Version(version_message.start_version(), version_message.end_version())]
+                = version_message.SerializeAsString();
+    }
+    _num_log_records = 0;
+}
+
 OLAPStatus OLAPHeader::add_version(
         Version version,
         VersionHash version_hash,
@@ -194,6 +445,7 @@ OLAPStatus OLAPHeader::add_version(
         return OLAP_ERR_HEADER_ADD_VERSION;
     }
 
+    _clear_version_path_cache();
     if (add_version_to_graph(version, &_version_graph, &_vertex_helper_map) != OLAP_SUCCESS) {
         OLAP_LOG_WARNING("fail to add version to graph. [version='%d-%d']",
                          version.first,
@@ -216,6 +468,108 @@ OLAPStatus OLAPHeader::add_version(
             max_timestamp, index_size, data_size, num_rows, NULL);
 }
 
+OLAPStatus OLAPHeader::set_column_sketches(
+        const Version& version, const std::vector<ColumnSketchMessage>& column_sketches) {
+    for (int i = 0; i < file_version_size(); ++i) {
+        FileVersionMessage* file_version_message = mutable_file_version(i);
+        if (file_version_message->start_version() != version.first
+                || file_version_message->end_version() != version.second) {
+            continue;
+        }
+
+        file_version_message->clear_column_sketch();
+        for (size_t j = 0; j < column_sketches.size(); ++j) {
+            file_version_message->add_column_sketch()->CopyFrom(column_sketches[j]);
+        }
+        return OLAP_SUCCESS;
+    }
+
+    OLAP_LOG_WARNING("version does not exist. [version='%d-%d']", version.first, version.second);
+    return OLAP_ERR_VERSION_NOT_EXIST;
+}
+
+OLAPStatus OLAPHeader::set_packed(const Version& version) {
+    for (int i = 0; i < file_version_size(); ++i) {
+        FileVersionMessage* file_version_message = mutable_file_version(i);
+        if (file_version_message->start_version() == version.first
+                && file_version_message->end_version() == version.second) {
+            file_version_message->set_packed(true);
+            return OLAP_SUCCESS;
+        }
+    }
+
+    OLAP_LOG_WARNING("version does not exist. [version='%d-%d']", version.first, version.second);
+    return OLAP_ERR_VERSION_NOT_EXIST;
+}
+
+OLAPStatus OLAPHeader::merge_column_sketches(
+        const std::vector<FieldInfo>& tablet_schema,
+        std::vector<ColumnSketchMessage>* column_sketches) {
+    column_sketches->clear();
+    const FileVersionMessage* latest_version = get_latest_version();
+    if (NULL == latest_version) {
+        return OLAP_SUCCESS;
+    }
+
+    std::vector<Version> span_versions;
+    OLAPStatus res = select_versions_to_span(
+            Version(0, latest_version->end_version()), &span_versions);
+    if (OLAP_SUCCESS != res) {
+        return res;
+    }
+
+    std::vector<const FileVersionMessage*> version_messages;
+    for (const Version& version : span_versions) {
+        for (int i = 0; i < file_version_size(); ++i) {
+            const FileVersionMessage& message = file_version(i);
+            if (message.start_version() != version.first
+                    || message.end_version() != version.second) {
+                continue;
+            }
+
+            // 缺少部分版本的统计时宁可不报告, 以免误导planner
+            if (message.column_sketch_size() == 0 && message.num_rows() > 0) {
+                return OLAP_SUCCESS;
+            }
+            version_messages.push_back(&message);
+            break;
+        }
+    }
+
+    for (const FieldInfo& field_info : tablet_schema) {
+        if (!ColumnSketch::is_supported(field_info)) {
+            continue;
+        }
+
+        ColumnSketch sketch(field_info);
+        for (const FileVersionMessage* message : version_messages) {
+            for (const ColumnSketchMessage& column_sketch : message->column_sketch()) {
+                if (column_sketch.unique_id() != field_info.unique_id) {
+                    continue;
+                }
+
+                res = sketch.merge(column_sketch);
+                if (OLAP_SUCCESS != res) {
+                    OLAP_LOG_WARNING("fail to merge column sketch. [column='%s' res=%d]",
+                                     field_info.name.c_str(), res);
+                    column_sketches->clear();
+                    return res;
+                }
+                break;
+            }
+        }
+
+        column_sketches->push_back(ColumnSketchMessage());
+        res = sketch.to_pb(&column_sketches->back());
+        if (OLAP_SUCCESS != res) {
+            column_sketches->clear();
+            return res;
+        }
+    }
+
+    return OLAP_SUCCESS;
+}
+
 OLAPStatus OLAPHeader::delete_version(Version version) {
     // Find the version that need to be deleted.
     int index = -1;
@@ -238,6 +592,7 @@ OLAPStatus OLAPHeader::delete_version(Version version) {
     }
 
     // Atomic delete is not supported now.
+    _clear_version_path_cache();
     if (delete_version_from_graph(file_version(),
                                   version,
                                   &_version_graph,
@@ -254,6 +609,7 @@ OLAPStatus OLAPHeader::delete_version(Version version) {
 OLAPStatus OLAPHeader::delete_all_versions() {
     clear_file_version();
     clear_version_graph(&_version_graph, &_vertex_helper_map);
+    _clear_version_path_cache();
 
     if (construct_version_graph(file_version(),
                                 &_version_graph,
@@ -266,9 +622,43 @@ OLAPStatus OLAPHeader::delete_all_versions() {
 }
 
 // This function is called when base-expansion, cumulative-expansion, quering.
-// we use BFS algorithm to get the shortest version path.
 OLAPStatus OLAPHeader::select_versions_to_span(const Version& target_version,
                                            vector<Version>* span_versions) {
+    if (span_versions == NULL) {
+        OLAP_LOG_WARNING("param span_versions is NULL.");
+        return OLAP_ERR_INPUT_PARAMETER_ERROR;
+    }
+
+    {
+        AutoMutexLock lock(&_version_path_lock);
+        auto it = _version_path_cache.find(target_version);
+        if (it != _version_path_cache.end()) {
+            span_versions->insert(span_versions->end(), it->second.begin(), it->second.end());
+            return OLAP_SUCCESS;
+        }
+    }
+
+    vector<Version> path;
+    OLAPStatus res = _compute_versions_to_span(target_version, &path);
+    if (res != OLAP_SUCCESS) {
+        return res;
+    }
+
+    {
+        AutoMutexLock lock(&_version_path_lock);
+        // queries mostly ask for the latest few versions, so a small cache is enough
+        if (_version_path_cache.size() >= MAX_CACHED_VERSION_PATHS) {
+            _version_path_cache.clear();
+        }
+        _version_path_cache[target_version] = path;
+    }
+    span_versions->insert(span_versions->end(), path.begin(), path.end());
+    return OLAP_SUCCESS;
+}
+
+// we use BFS algorithm to get the shortest version path.
+OLAPStatus OLAPHeader::_compute_versions_to_span(const Version& target_version,
+                                                 vector<Version>* span_versions) {
     if (target_version.first > target_version.second) {
         OLAP_LOG_WARNING("invalid param target_version. [start_version_id=%d end_version_id=%d]",
                          target_version.first,
@@ -456,6 +846,18 @@ const uint32_t OLAPHeader::get_expansion_nice_estimate() const{
     return base_version_exists ? nice : 0;
 }
 
+const int64_t OLAPHeader::get_cumulative_delta_size() const {
+    int64_t size = 0;
+    const int32_t point = cumulative_layer_point();
+    for (int i = file_version_size() - 1; i >= 0; --i) {
+        if (file_version(i).start_version() >= point) {
+            size += file_version(i).data_size() + file_version(i).index_size();
+        }
+    }
+
+    return size;
+}
+
 const OLAPStatus OLAPHeader::version_creation_time(const Version& version,
                                                    int64_t* creation_time) const {
     if (0 == file_version_size()) {
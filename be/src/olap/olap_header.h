@@ -17,6 +17,7 @@
 #define BDG_PALO_BE_SRC_OLAP_OLAP_HEADER_H
 
 #include <list>
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -24,6 +25,7 @@
 #include "gen_cpp/olap_file.pb.h"
 #include "olap/olap_common.h"
 #include "olap/olap_define.h"
+#include "olap/utils.h"
 
 namespace palo {
 // Class for managing olap table header.
@@ -31,17 +33,22 @@ class OLAPHeader : public OLAPHeaderMessage {
 public:
     explicit OLAPHeader(const std::string& file_name) :
             _file_name(file_name),
-            _support_reverse_version(false) {}
+            _support_reverse_version(false),
+            _num_log_records(0) {}
 
     virtual ~OLAPHeader();
 
     // Loads the header from disk, returning true on success.
     // In load(), we will validate olap header file, which mainly include
-    // tablet schema, delta version and so on.
+    // tablet schema, delta version and so on. Records of the delta log
+    // are replayed after the header file is read.
     OLAPStatus load();
 
     // Saves the header to disk, returning true on success.
+    // If only versions changed since the last save, the changes are appended
+    // to the delta log instead of rewriting the whole header file.
     OLAPStatus save();
+    // Saves a whole copy of the header to file_path, which has no delta log.
     OLAPStatus save(const std::string& file_path);
 
     // Return the file name of the heade.
@@ -69,6 +76,19 @@ public:
         int64_t num_rows,
         std::vector<std::pair<Field *, Field *> > *column_statistics);
 
+    // Records the column sketches of an existing version.
+    OLAPStatus set_column_sketches(const Version& version,
+                                   const std::vector<ColumnSketchMessage>& column_sketches);
+
+    // Marks an existing version as packed into one file.
+    OLAPStatus set_packed(const Version& version);
+
+    // Merges the column sketches of the versions spanning the latest version
+    // into one sketch per column of the tablet. column_sketches is left empty
+    // if any of these versions has no sketch, e.g. written by an older release.
+    OLAPStatus merge_column_sketches(const std::vector<FieldInfo>& tablet_schema,
+                                     std::vector<ColumnSketchMessage>* column_sketches);
+
     // Deletes a version from the header.
     OLAPStatus delete_version(Version version);
     OLAPStatus delete_all_versions();
@@ -84,24 +104,54 @@ public:
     // support reverse version in the path.
     void set_reverse_version(bool support_reverse_version) {
         _support_reverse_version = support_reverse_version;
+        _clear_version_path_cache();
     }
 
     // Try to select the least number of data files that can span the
     // target_version and append these data versions to the span_versions.
     // Return false if the target_version cannot be spanned.
+    // Paths are cached per target_version until a version is added or deleted,
+    // so concurrent queries under the header read lock share the computed path.
     virtual OLAPStatus select_versions_to_span(const Version& target_version,
                                            std::vector<Version>* span_versions);
 
     const FileVersionMessage* get_lastest_delta_version() const;
     const FileVersionMessage* get_latest_version() const;
     const uint32_t get_expansion_nice_estimate() const;
+    // 返回cumulative层之上所有delta的数据量(data+index), 用于compaction调度打分
+    const int64_t get_cumulative_delta_size() const;
     const OLAPStatus version_creation_time(const Version& version, int64_t* creation_time) const;
 
 private:
+    // BFS over the version graph for the shortest path spanning target_version.
+    OLAPStatus _compute_versions_to_span(const Version& target_version,
+                                         std::vector<Version>* span_versions);
+
+    // Called whenever the version graph changes.
+    void _clear_version_path_cache() {
+        AutoMutexLock lock(&_version_path_lock);
+        _version_path_cache.clear();
+    }
+
     // Compute schema hash(all fields name and type, index name and its field
     // names) using lzo_adler32 function.
     OLAPStatus _compute_schema_hash(SchemaHash* schema_hash);
 
+    std::string _log_file_name() const {
+        return _file_name + ".log";
+    }
+
+    // 序列化整个header写入file_path
+    OLAPStatus _write_header_file(const std::string& file_path, bool clear_log_id);
+    // 只有version变化时追加到增量日志, is_logged为false表示需要重写整个header
+    OLAPStatus _append_log(bool* is_logged);
+    // 回放增量日志, is_complete为false表示日志尾部不完整
+    OLAPStatus _replay_log(int32_t* num_records, bool* is_complete);
+    // 序列化除version之外的header
+    void _serialize_meta(std::string* meta) const;
+    // 记录当前header为最后一次保存的状态
+    void _reset_saved_state();
+
     // full path of olap header file
     std::string _file_name;
 
@@ -123,6 +173,17 @@ private:
     // It is easy to find vertex index according to vertex value.
     std::unordered_map<int, int> _vertex_helper_map;
 
+    // target version --> shortest version path, guarded by _version_path_lock
+    // because select_versions_to_span is called under the header read lock.
+    std::map<Version, std::vector<Version>> _version_path_cache;
+    MutexLock _version_path_lock;
+
+    // state of the header when it was saved last time (header file and delta log),
+    // the next save appends the differences of versions to the delta log.
+    std::string _saved_meta;
+    std::map<Version, std::string> _saved_versions;
+    int32_t _num_log_records;
+
     DISALLOW_COPY_AND_ASSIGN(OLAPHeader);
 };
 
@@ -15,11 +15,14 @@
 
 #include "olap/olap_index.h"
 
+#include <sys/mman.h>
+
 #include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <fstream>
 
+#include "olap/column_file/byte_buffer.h"
 #include "olap/olap_data.h"
 #include "olap/olap_table.h"
 #include "olap/row_block.h"
@@ -71,6 +74,7 @@ OLAPIndex::OLAPIndex(OLAPTable* table,
         _version_hash(version_hash),
         _current_num_rows_per_row_block(0),
         _inited_column_statistics(false),
+        _packed(false),
         _column_statistics(_table->num_key_fields(), std::pair<Field *, Field *>(NULL, NULL)) {
     const RowFields& tablet_schema = _table->tablet_schema();
     _short_key_length = 0;
@@ -83,8 +87,11 @@ OLAPIndex::OLAPIndex(OLAPTable* table,
     }
 
     _index_loaded = false;
+    _has_header_statistics = false;
+    _header_index_size = 0;
+    _header_data_size = 0;
+    _header_num_rows = 0;
     _ref_count = 0;
-    _header_file_name = _table->header_file_name();
 }
 
 OLAPIndex::~OLAPIndex() {
@@ -119,6 +126,14 @@ bool OLAPIndex::is_in_use() {
 
 // you can not use OLAPIndex after delete_all_files(), or else unknown behavior occurs.
 void OLAPIndex::delete_all_files() {
+    if (_packed) {
+        string pack_path = _construct_pack_file_path();
+        if (remove(pack_path.c_str()) != 0) {
+            OLAP_LOG_WARNING("fail to delete pack file. [err='%m' path='%s']", pack_path.c_str());
+        }
+        return;
+    }
+
     for (uint32_t seg_id = 0; seg_id < _num_segments; ++seg_id) {
         // get full path for one segment
         string index_path = _construct_index_file_path(_version, _version_hash, seg_id);
@@ -262,19 +277,23 @@ OLAPStatus OLAPIndex::load() {
     // for each segment
     for (uint32_t seg_id = 0; seg_id < _num_segments; ++seg_id) {
         if (COLUMN_ORIENTED_FILE == _table->data_file_type()) {
-            string seg_path = _table->construct_data_file_path(_version, _version_hash, seg_id);
-            if (OLAP_SUCCESS != (res = load_pb(seg_path.c_str(), seg_id))) {
-                OLAP_LOG_WARNING("faile to load pb structures. [seg_path='%s']", seg_path.c_str());
+            if (OLAP_SUCCESS != (res = load_pb(seg_id))) {
+                OLAP_LOG_WARNING("faile to load pb structures. [seg_id=%u]", seg_id);
                 _check_io_error(res);
                 return res;
             }
         }
 
-        // get full path for one segment
-        string path = _table->construct_index_file_path(_version, _version_hash, seg_id);
-        if ((res = _index.load_segment(path.c_str(), &_current_num_rows_per_row_block))
-                != OLAP_SUCCESS) {
-            OLAP_LOG_WARNING("fail to load segment. [path='%s']", path.c_str());
+        FileHandler file_handler;
+        if ((res = open_segment_file(seg_id, true, &file_handler)) != OLAP_SUCCESS) {
+            _check_io_error(res);
+            return res;
+        }
+
+        res = _index.load_segment(&file_handler, &_current_num_rows_per_row_block);
+        file_handler.close();
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to load segment. [seg_id=%u]", seg_id);
             _check_io_error(res);
             return res;
         }
@@ -285,21 +304,21 @@ OLAPStatus OLAPIndex::load() {
     return OLAP_SUCCESS;
 }
 
-OLAPStatus OLAPIndex::load_pb(const char* file, uint32_t seg_id) {
+OLAPStatus OLAPIndex::load_pb(uint32_t seg_id) {
     OLAPStatus res = OLAP_SUCCESS;
 
     FileHeader<column_file::ColumnDataHeaderMessage> seg_file_header;
     FileHandler seg_file_handler;
-    res = seg_file_handler.open_with_cache(file, O_RDONLY);
+    res = open_segment_file(seg_id, false, &seg_file_handler);
     if (OLAP_SUCCESS != res) {
-        OLAP_LOG_WARNING("failed to open segment file. [err=%d, file=%s]", res, file);
         return res;
     }
 
     res = seg_file_header.unserialize(&seg_file_handler);
     if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to unserialize header. [err=%d, path='%s']",
+                         res, seg_file_handler.file_name().c_str());
         seg_file_handler.close();
-        OLAP_LOG_WARNING("fail to unserialize header. [err=%d, path='%s']", res, file);
         return res;
     }
 
@@ -312,32 +331,153 @@ bool OLAPIndex::index_loaded() {
     return _index_loaded;
 }
 
+bool OLAPIndex::unload() {
+    boost::lock_guard<boost::mutex> guard(_index_load_lock);
+    if (!_index_loaded || is_in_use()) {
+        return false;
+    }
+
+    set_header_statistics(_index.index_size(), _index.data_size(), _index.num_rows());
+    _delete_flag = _index.segment_count() > 0 && _index.delete_flag();
+    _index_loaded = false;
+    _index.clear();
+    _seg_pb_map.clear();
+    return true;
+}
+
+void OLAPIndex::set_header_statistics(size_t index_size, size_t data_size, int64_t num_rows) {
+    _header_index_size = index_size;
+    _header_data_size = data_size;
+    _header_num_rows = num_rows;
+    _has_header_statistics = true;
+}
+
 OLAPStatus OLAPIndex::validate() {
     OLAPStatus res = OLAP_SUCCESS;
 
     for (uint32_t seg_id = 0; seg_id < _num_segments; ++seg_id) {
         FileHeader<OLAPIndexHeaderMessage, OLAPIndexFixedHeader> index_file_header;
         FileHeader<OLAPDataHeaderMessage> data_file_header;
-
-        // get full path for one segment
-        string index_path = _table->construct_index_file_path(_version, _version_hash, seg_id);
-        string data_path = _table->construct_data_file_path(_version, _version_hash, seg_id);
+        FileHandler file_handler;
 
         // 检查index文件头
-        if ((res = index_file_header.validate(index_path)) != OLAP_SUCCESS) {
-            OLAP_LOG_WARNING("validate index file error. [file='%s']", index_path.c_str());
+        if ((res = open_segment_file(seg_id, true, &file_handler)) != OLAP_SUCCESS
+                || (res = index_file_header.unserialize(&file_handler)) != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("validate index file error. [file='%s' seg_id=%u]",
+                             file_handler.file_name().c_str(), seg_id);
             _check_io_error(res);
             return res;
         }
+        file_handler.close();
 
         // 检查data文件头
-        if ((res = data_file_header.validate(data_path)) != OLAP_SUCCESS) {
-            OLAP_LOG_WARNING("validate data file error. [file='%s']", data_path.c_str());
+        if ((res = open_segment_file(seg_id, false, &file_handler)) != OLAP_SUCCESS
+                || (res = data_file_header.unserialize(&file_handler)) != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("validate data file error. [file='%s' seg_id=%u]",
+                             file_handler.file_name().c_str(), seg_id);
             _check_io_error(res);
             return res;
         }
+        file_handler.close();
+    }
+
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus OLAPIndex::open_segment_file(uint32_t seg_id,
+                                        bool is_index,
+                                        FileHandler* file_handler) {
+    OLAPStatus res = OLAP_SUCCESS;
+    if (!_packed) {
+        string path = is_index
+                ? _table->construct_index_file_path(_version, _version_hash, seg_id)
+                : _table->construct_data_file_path(_version, _version_hash, seg_id);
+        if ((res = file_handler->open_with_cache(path, O_RDONLY)) != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to open segment file. [file='%s']", path.c_str());
+        }
+        return res;
+    }
+
+    if ((res = _load_packed_directory()) != OLAP_SUCCESS) {
+        return res;
+    }
+
+    if (seg_id >= _packed_segments.size()) {
+        OLAP_LOG_WARNING("segment is not in pack file. [seg_id=%u num_packed=%lu]",
+                         seg_id, _packed_segments.size());
+        return OLAP_ERR_FILE_FORMAT_ERROR;
+    }
+
+    const PackedRegion& region = is_index
+            ? _packed_segments[seg_id].index : _packed_segments[seg_id].data;
+    string pack_path = _construct_pack_file_path();
+    res = file_handler->open_region_with_cache(pack_path, region.offset, region.length);
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to open segment in pack file. [file='%s' seg_id=%u]",
+                         pack_path.c_str(), seg_id);
+    }
+    return res;
+}
+
+OLAPStatus OLAPIndex::get_segment_data_file_location(uint32_t seg_id,
+                                                     string* file_name,
+                                                     uint64_t* region_offset) {
+    if (!_packed) {
+        *file_name = _table->construct_data_file_path(_version, _version_hash, seg_id);
+        *region_offset = 0;
+        return OLAP_SUCCESS;
+    }
+
+    OLAPStatus res = _load_packed_directory();
+    if (res != OLAP_SUCCESS) {
+        return res;
+    }
+
+    if (seg_id >= _packed_segments.size()) {
+        OLAP_LOG_WARNING("segment is not in pack file. [seg_id=%u num_packed=%lu]",
+                         seg_id, _packed_segments.size());
+        return OLAP_ERR_FILE_FORMAT_ERROR;
+    }
+
+    *file_name = _construct_pack_file_path();
+    *region_offset = _packed_segments[seg_id].data.offset;
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus OLAPIndex::_load_packed_directory() {
+    boost::lock_guard<boost::mutex> guard(_packed_directory_lock);
+    if (!_packed_segments.empty()) {
+        return OLAP_SUCCESS;
+    }
+
+    std::vector<PackedSegment> segments;
+    OLAPStatus res = read_packed_directory(_construct_pack_file_path(), &segments);
+    if (res != OLAP_SUCCESS) {
+        return res;
     }
 
+    _packed_segments.swap(segments);
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus OLAPIndex::pack_files() {
+    if (_packed || _num_segments == 0) {
+        return OLAP_SUCCESS;
+    }
+
+    std::vector<string> index_paths;
+    std::vector<string> data_paths;
+    for (uint32_t seg_id = 0; seg_id < _num_segments; ++seg_id) {
+        index_paths.push_back(_table->construct_index_file_path(_version, _version_hash, seg_id));
+        data_paths.push_back(_table->construct_data_file_path(_version, _version_hash, seg_id));
+    }
+
+    OLAPStatus res = pack_segment_files(index_paths, data_paths, _construct_pack_file_path());
+    if (res != OLAP_SUCCESS) {
+        return res;
+    }
+
+    _packed = true;
     return OLAP_SUCCESS;
 }
 
@@ -634,16 +774,179 @@ uint64_t OLAPIndex::num_index_entries() const {
     return _index.count();
 }
 
+// 释放segment的索引内容, mmap的索引解除映射, 否则释放拷贝的内存
+static void release_segment_buffer(SegmentMetaInfo* meta) {
+    if (NULL != meta->mmap_buffer) {
+        SAFE_DELETE(meta->mmap_buffer);
+    } else {
+        free(meta->buffer.data);
+    }
+    meta->buffer.data = NULL;
+    meta->buffer.length = 0;
+}
+
+// 把short key第一列编码为保序的uint64: null为0, 非null值转为无符号的保序表示后
+// 右移一位再加1. 编码只需要单调不减, 前缀相同的索引项仍然用完整的short key比较
+static bool encode_key_prefix(FieldType type, bool is_null, const char* value, uint64_t* prefix) {
+    const uint64_t sign_bit = 1UL << 63;
+    uint64_t ordered = 0;
+    switch (type) {
+    case OLAP_FIELD_TYPE_TINYINT: {
+        int8_t v = 0;
+        memcpy(&v, value, sizeof(v));
+        ordered = static_cast<uint64_t>(static_cast<int64_t>(v)) ^ sign_bit;
+        break;
+    }
+    case OLAP_FIELD_TYPE_SMALLINT: {
+        int16_t v = 0;
+        memcpy(&v, value, sizeof(v));
+        ordered = static_cast<uint64_t>(static_cast<int64_t>(v)) ^ sign_bit;
+        break;
+    }
+    case OLAP_FIELD_TYPE_INT: {
+        int32_t v = 0;
+        memcpy(&v, value, sizeof(v));
+        ordered = static_cast<uint64_t>(static_cast<int64_t>(v)) ^ sign_bit;
+        break;
+    }
+    case OLAP_FIELD_TYPE_BIGINT:
+    case OLAP_FIELD_TYPE_DATETIME: {
+        int64_t v = 0;
+        memcpy(&v, value, sizeof(v));
+        ordered = static_cast<uint64_t>(v) ^ sign_bit;
+        break;
+    }
+    case OLAP_FIELD_TYPE_UNSIGNED_TINYINT: {
+        uint8_t v = 0;
+        memcpy(&v, value, sizeof(v));
+        ordered = v;
+        break;
+    }
+    case OLAP_FIELD_TYPE_UNSIGNED_SMALLINT: {
+        uint16_t v = 0;
+        memcpy(&v, value, sizeof(v));
+        ordered = v;
+        break;
+    }
+    case OLAP_FIELD_TYPE_UNSIGNED_INT: {
+        uint32_t v = 0;
+        memcpy(&v, value, sizeof(v));
+        ordered = v;
+        break;
+    }
+    case OLAP_FIELD_TYPE_UNSIGNED_BIGINT: {
+        memcpy(&ordered, value, sizeof(ordered));
+        break;
+    }
+    case OLAP_FIELD_TYPE_DATE: {
+        const uint8_t* v = reinterpret_cast<const uint8_t*>(value);
+        ordered = v[0] | (static_cast<uint64_t>(v[1]) << 8) | (static_cast<uint64_t>(v[2]) << 16);
+        break;
+    }
+    default:
+        return false;
+    }
+
+    *prefix = is_null ? 0 : (ordered >> 1) + 1;
+    return true;
+}
+
+// 按中序遍历把有序的前缀填入Eytzinger数组, 返回下一个待填入的有序下标
+static uint32_t fill_eytzinger(const std::vector<uint64_t>& sorted,
+                               uint32_t i,
+                               size_t k,
+                               SegmentMetaInfo* meta) {
+    if (k < meta->key_prefixes.size()) {
+        i = fill_eytzinger(sorted, i, 2 * k, meta);
+        meta->key_prefixes[k] = sorted[i];
+        meta->key_prefix_ranks[k] = i;
+        ++i;
+        i = fill_eytzinger(sorted, i, 2 * k + 1, meta);
+    }
+
+    return i;
+}
+
+// 在Eytzinger数组上查找第一个前缀不小于(upper为true时大于)prefix的索引项序号
+static iterator_offset_t search_eytzinger(const SegmentMetaInfo& meta,
+                                          uint64_t prefix,
+                                          bool upper) {
+    const size_t n = meta.key_prefixes.size() - 1;
+    size_t k = 1;
+    while (k <= n) {
+        __builtin_prefetch(meta.key_prefixes.data() + 16 * k);
+        bool go_right = upper ? meta.key_prefixes[k] <= prefix : meta.key_prefixes[k] < prefix;
+        k = 2 * k + go_right;
+    }
+
+    // 去掉最后一段连续向右走的路径, 剩下的就是结果节点
+    k >>= __builtin_ffsll(~k);
+    return 0 == k ? n : meta.key_prefix_ranks[k];
+}
+
+void MemIndex::_build_key_prefixes(SegmentMetaInfo* meta) {
+    meta->key_prefixes.clear();
+    meta->key_prefix_ranks.clear();
+
+    size_t num_entries = meta->count();
+    if (0 == num_entries || _fields->empty()) {
+        return;
+    }
+
+    FieldType type = (*_fields)[0].type;
+    std::vector<uint64_t> sorted(num_entries);
+    for (size_t i = 0; i < num_entries; ++i) {
+        // 每个short key field由1字节的null标记和内容组成
+        const char* entry = meta->buffer.data + i * entry_length();
+        if (!encode_key_prefix(type, *entry != 0, entry + 1, &sorted[i])) {
+            return;
+        }
+    }
+
+    meta->key_prefixes.resize(num_entries + 1, 0);
+    meta->key_prefix_ranks.resize(num_entries + 1, 0);
+    fill_eytzinger(sorted, 0, 1, meta);
+}
+
+void MemIndex::_find_key_prefix_range(const SegmentMetaInfo& meta,
+                                      const RowCursor& key,
+                                      iterator_offset_t* first,
+                                      iterator_offset_t* last) const {
+    *first = 0;
+    *last = meta.count();
+
+    const Field* field = key.get_field_by_index(0);
+    uint64_t prefix = 0;
+    if (meta.key_prefixes.empty() || 0 == key.field_count() || NULL == field
+            || !encode_key_prefix(field->type(), field->is_null(), field->buf(), &prefix)) {
+        return;
+    }
+
+    // 前缀单调不减, 前缀小于key的索引项一定小于key, 前缀大于key的一定大于key
+    *first = search_eytzinger(meta, prefix, false);
+    *last = search_eytzinger(meta, prefix, true);
+}
+
+void MemIndex::clear() {
+    for (vector<SegmentMetaInfo>::iterator it = _meta.begin(); it != _meta.end(); ++it) {
+        release_segment_buffer(&(*it));
+    }
+    _meta.clear();
+    _num_entries = 0;
+    _index_size = 0;
+    _data_size = 0;
+    _num_rows = 0;
+}
+
 MemIndex::~MemIndex() {
     _num_entries = 0;
     for (vector<SegmentMetaInfo>::iterator it = _meta.begin(); it != _meta.end(); ++it) {
-        free(it->buffer.data);
-        it->buffer.data = NULL;
-        it->buffer.length = 0;
+        release_segment_buffer(&(*it));
     }
 }
 
-OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per_row_block) {
+OLAPStatus MemIndex::load_segment(FileHandler* file_handler,
+                                  size_t *current_num_rows_per_row_block) {
     OLAPStatus res = OLAP_SUCCESS;
 
     SegmentMetaInfo meta;
@@ -651,23 +954,16 @@ OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per
     uint32_t adler_checksum = 0;
     uint32_t num_entries = 0;
 
-    if (file == NULL) {
+    if (file_handler == NULL) {
         res = OLAP_ERR_INPUT_PARAMETER_ERROR;
-        OLAP_LOG_WARNING("load segment for loading index error. [file=%s; res=%d]", file, res);
-        return res;
-    }
-
-    FileHandler file_handler;
-    if ((res = file_handler.open_with_cache(file, O_RDONLY)) != OLAP_SUCCESS) {
-        OLAP_LOG_WARNING("fail to open index file. [file='%s']", file);
-        OLAP_LOG_WARNING("load segment for loading index error. [file=%s; res=%d]", file, res);
+        OLAP_LOG_WARNING("load segment for loading index error. [res=%d]", res);
         return res;
     }
+    const char* file = file_handler->file_name().c_str();
 
-    if ((res = meta.file_header.unserialize(&file_handler)) != OLAP_SUCCESS) {
+    if ((res = meta.file_header.unserialize(file_handler)) != OLAP_SUCCESS) {
         OLAP_LOG_WARNING("fail to read index file header. [file='%s']", file);
         OLAP_LOG_WARNING("load segment for loading index error. [file=%s; res=%d]", file, res);
-        file_handler.close();
         return res;
     }
 
@@ -694,7 +990,6 @@ OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per
         res = OLAP_ERR_INDEX_LOAD_ERROR;
         OLAP_LOG_WARNING("fail to load_segment, buffer length is not correct.");
         OLAP_LOG_WARNING("load segment for loading index error. [file=%s; res=%d]", file, res);
-        file_handler.close();
         return res;
     }
     if (false == null_supported) {
@@ -703,25 +998,33 @@ OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per
                 calloc(meta.buffer.length + num_entries * num_short_key_fields, 1));
     } else {
         num_entries = meta.buffer.length / entry_length();
-        meta.buffer.data = reinterpret_cast<char*>(calloc(meta.buffer.length, 1));
+        // 新格式的索引不需要补齐NULL标志位, 直接映射整个文件, 避免启动时拷贝索引
+        if (config::enable_index_mmap) {
+            meta.mmap_buffer = column_file::ByteBuffer::mmap(
+                    file_handler, 0, PROT_READ, MAP_PRIVATE);
+            if (NULL != meta.mmap_buffer) {
+                meta.buffer.data = meta.mmap_buffer->array() + meta.file_header.size();
+            }
+        }
+        if (NULL == meta.mmap_buffer) {
+            meta.buffer.data = reinterpret_cast<char*>(calloc(meta.buffer.length, 1));
+        }
     }
 
     if (meta.buffer.data == NULL) {
         res = OLAP_ERR_MALLOC_ERROR;
         OLAP_LOG_WARNING("load segment for loading index error. [file=%s; res=%d]", file, res);
-        file_handler.close();
         return res;
     }
 
-    // 读取索引内容
-    // 为了启动加速，此处可使用mmap方式。
-    if (file_handler.pread(meta.buffer.data,
-                           meta.buffer.length,
-                           meta.file_header.size()) != OLAP_SUCCESS) {
+    // 读取索引内容, mmap方式加载时不需要拷贝
+    if (NULL == meta.mmap_buffer
+            && file_handler->pread(meta.buffer.data,
+                                  meta.buffer.length,
+                                  meta.file_header.size()) != OLAP_SUCCESS) {
         res = OLAP_ERR_IO_ERROR;
         OLAP_LOG_WARNING("load segment for loading index error. [file=%s; res=%d]", file, res);
-        file_handler.close();
-        free(meta.buffer.data);
+        release_segment_buffer(&meta);
         return res;
     }
 
@@ -740,8 +1043,7 @@ OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per
         res = OLAP_ERR_INDEX_CHECKSUM_ERROR;
         OLAP_LOG_WARNING("checksum validation error.");
         OLAP_LOG_WARNING("load segment for loading index error. [file=%s; res=%d]", file, res);
-        file_handler.close();
-        free(meta.buffer.data);
+        release_segment_buffer(&meta);
         return res;
     }
 
@@ -771,11 +1073,11 @@ OLAPStatus MemIndex::load_segment(const char* file, size_t *current_num_rows_per
     meta.range.last = meta.range.first + num_entries;
     _num_entries = meta.range.last;
     _meta.push_back(meta);
+    _build_key_prefixes(&_meta.back());
 
     (current_num_rows_per_row_block == NULL
          || (*current_num_rows_per_row_block = meta.file_header.message().num_rows_per_block())); 
 
-    file_handler.close();
 
     return OLAP_SUCCESS;
 }
@@ -837,9 +1139,13 @@ const OLAPIndexOffset MemIndex::find(const RowCursor& k,
         // set segment id
         offset.segment = off;
         IndexComparator index_comparator(this, helper_cursor);
-        // second step, binary search index item in given segment
-        BinarySearchIterator index_beg(0);
-        BinarySearchIterator index_fin(_meta[off].count());
+        // second step, binary search index item in given segment,
+        // the range is narrowed by the prefix of the first short key field before
+        iterator_offset_t prefix_first = 0;
+        iterator_offset_t prefix_last = 0;
+        _find_key_prefix_range(_meta[off], k, &prefix_first, &prefix_last);
+        BinarySearchIterator index_beg(prefix_first);
+        BinarySearchIterator index_fin(prefix_last);
 
         if (index_comparator.set_segment_id(off) != OLAP_SUCCESS) {
             throw "index of of range";
@@ -32,6 +32,7 @@
 #include "olap/olap_common.h"
 #include "olap/olap_define.h"
 #include "olap/olap_table.h"
+#include "olap/packed_file.h"
 #include "olap/row_cursor.h"
 #include "olap/utils.h"
 
@@ -42,6 +43,9 @@ class OLAPTable;
 class RowBlock;
 class RowCursor;
 class SegmentComparator;
+namespace column_file {
+class ByteBuffer;
+}
 
 typedef uint32_t data_file_offset_t;
 typedef std::vector<FieldInfo> RowFields;
@@ -149,6 +153,7 @@ struct SegmentMetaInfo {
         range.first = range.last = 0;
         buffer.length = 0;
         buffer.data = NULL;
+        mmap_buffer = NULL;
     }
 
     const size_t count() const {
@@ -157,6 +162,12 @@ struct SegmentMetaInfo {
 
     IDRange     range;
     Slice       buffer;
+    // 索引文件以mmap方式加载时持有映射, buffer指向其中的索引内容, 否则为NULL
+    column_file::ByteBuffer* mmap_buffer;
+    // short key第一列的保序前缀, 按Eytzinger顺序存放(下标从1开始), key_prefix_ranks
+    // 为对应索引项在segment内的序号. 查找时先用前缀缩小范围再做完整比较, 第一列类型不支持时为空
+    std::vector<uint64_t> key_prefixes;
+    std::vector<uint32_t> key_prefix_ranks;
     FileHeader<OLAPIndexHeaderMessage, OLAPIndexFixedHeader>  file_header;
 };
 
@@ -178,8 +189,11 @@ public:
     // 初始化MemIndex, 传入short_key的总长度和对应的Field数组
     OLAPStatus init(size_t short_key_len, size_t short_key_num, RowFields* fields);
 
-    // 加载一个segment到内存
-    OLAPStatus load_segment(const char* file, size_t *current_num_rows_per_row_block);
+    // 从打开的索引文件加载一个segment到内存
+    OLAPStatus load_segment(FileHandler* file_handler, size_t *current_num_rows_per_row_block);
+
+    // 释放所有已加载的segment, 之后可以重新load_segment
+    void clear();
 
     // Return the IndexOffset of the first element, physically, it's (0, 0)
     const OLAPIndexOffset begin() const {
@@ -317,6 +331,15 @@ public:
     }
 
 private:
+    // 生成segment内索引项的short key前缀
+    void _build_key_prefixes(SegmentMetaInfo* meta);
+
+    // 用short key前缀确定segment内与key前缀相同的索引项范围[*first, *last)
+    void _find_key_prefix_range(const SegmentMetaInfo& meta,
+                                const RowCursor& key,
+                                iterator_offset_t* first,
+                                iterator_offset_t* last) const;
+
     std::vector<SegmentMetaInfo> _meta;
     size_t _key_length;
     size_t _key_num;
@@ -442,7 +465,19 @@ public:
     // Load the index into memory.
     OLAPStatus load();
     bool index_loaded();
-    OLAPStatus load_pb(const char* file, uint32_t seg_id);
+
+    // Releases the short key index and the segment headers, which the next load()
+    // reads again. Statistics of the index stay available. Returns false if the index
+    // isn't loaded or is in use. Get the header write lock of the table before calling it.
+    bool unload();
+
+    // Set index_size, data_size and num_rows recorded in table header, so that they
+    // can be reported before the index is loaded lazily.
+    void set_header_statistics(size_t index_size, size_t data_size, int64_t num_rows);
+    bool has_header_statistics() const {
+        return _has_header_statistics;
+    }
+    OLAPStatus load_pb(uint32_t seg_id);
 
     bool has_column_statistics() {
         return _inited_column_statistics;
@@ -458,9 +493,39 @@ public:
             std::vector<std::pair<std::string, std::string>> &column_statistics_string,
             std::vector<bool> &has_null_flags);
 
+    // 写入时各列合并后的统计草图, 注册版本时记录到header中
+    void set_column_sketches(const std::vector<ColumnSketchMessage>& column_sketches) {
+        _column_sketches = column_sketches;
+    }
+
+    const std::vector<ColumnSketchMessage>& column_sketches() const {
+        return _column_sketches;
+    }
+
     // 检查index文件和data文件的有效性
     OLAPStatus validate();
 
+    // 版本的所有segment文件是否打包在一个文件中(见packed_file.h)
+    bool packed() const {
+        return _packed;
+    }
+
+    void set_packed(bool packed) {
+        _packed = packed;
+    }
+
+    // 写完所有segment后把它们的索引和数据文件打包到一个文件中
+    OLAPStatus pack_files();
+
+    // 只读打开segment的索引或数据文件, 打包的版本打开打包文件中对应的一段
+    OLAPStatus open_segment_file(uint32_t seg_id, bool is_index, FileHandler* file_handler);
+
+    // segment的数据文件所在的文件和在其中的起始位置, 不是打包的版本时region_offset为0,
+    // 与读取时FileHandler的file_name()和region_offset()相同
+    OLAPStatus get_segment_data_file_location(uint32_t seg_id,
+                                              std::string* file_name,
+                                              uint64_t* region_offset);
+
     // Finds position of the first (or last if find_last is set) row
     // block that may contain the smallest key equal to or greater than
     // 'key'. Returns true on success. If find_last is set, note that
@@ -527,7 +592,7 @@ public:
     bool is_in_use();
     int64_t ref_count();
 
-    // delete all files (*.idx; *.dat)
+    // delete all files (*.idx; *.dat; *.pack)
     void delete_all_files();
 
     // getters and setters.
@@ -547,7 +612,7 @@ public:
     VersionHash version_hash() const;
 
     bool delete_flag() const {
-        return _index.delete_flag();
+        return _index_loaded ? _index.delete_flag() : _delete_flag;
     }
 
     uint32_t num_segments() const {
@@ -563,15 +628,15 @@ public:
     }
     
     size_t index_size() const {
-        return _index.index_size();
+        return _index_loaded ? _index.index_size() : _header_index_size;
     }
     
     size_t data_size() const {
-        return _index.data_size();
+        return _index_loaded ? _index.data_size() : _header_data_size;
     }
 
     int64_t num_rows() const {
-        return _index.num_rows();
+        return _index_loaded ? _index.num_rows() : _header_num_rows;
     }
     
     const size_t short_key_length() const {
@@ -583,7 +648,7 @@ public:
     }
     
     bool empty() const {
-        return _index.empty();
+        return _index_loaded ? _index.empty() : _header_num_rows == 0;
     }
     
     // return count of entries in MemIndex
@@ -611,7 +676,7 @@ private:
     std::string _construct_index_file_path(const Version& version,
                                            VersionHash version_hash,
                                            uint32_t segment) const {
-        return OLAPTable::construct_file_path(_header_file_name,
+        return OLAPTable::construct_file_path(_table->header_file_name(),
                                               version,
                                               version_hash,
                                               segment,
@@ -621,24 +686,36 @@ private:
     std::string _construct_data_file_path(const Version& version,
                                           VersionHash version_hash,
                                           uint32_t segment) const {
-        return OLAPTable::construct_file_path(_header_file_name,
+        return OLAPTable::construct_file_path(_table->header_file_name(),
                                               version,
                                               version_hash,
                                               segment,
                                               "dat");
     }
 
+    std::string _construct_pack_file_path() const {
+        return OLAPTable::construct_pack_file_path(_table->header_file_name(),
+                                                   _version,
+                                                   _version_hash);
+    }
+
+    // 读出打包文件的目录, 已读过时直接返回
+    OLAPStatus _load_packed_directory();
+
     OLAPTable* _table;                 // table definition for this index
     Version _version;                  // version of associated data file
-    bool _delete_flag;
+    bool _delete_flag;                 // only valid while the index isn't loaded
     time_t _max_timestamp;             // max pusher delta timestamp
     uint32_t _num_segments;            // number of segments in this index
     VersionHash _version_hash;      // version hash for this index
     bool _index_loaded;                // whether the index has been read
+    bool _has_header_statistics;       // whether statistics below are set from header
+    size_t _header_index_size;
+    size_t _header_data_size;
+    int64_t _header_num_rows;
     atomic_t _ref_count;               // reference count
     MemIndex _index;
 
-    std::string _header_file_name;     // the name of the related header file
     // short key对应的field_info数组
     RowFields _short_key_info_list;
     // short key对应的总长度
@@ -665,8 +742,14 @@ private:
 
     std::vector<std::pair<Field *, Field *> > _column_statistics;
     std::vector<bool> _has_null_flags;
+    std::vector<ColumnSketchMessage> _column_sketches;
     std::unordered_map<uint32_t, FileHeader<column_file::ColumnDataHeaderMessage> > _seg_pb_map;
 
+    bool _packed;
+    // 打包文件的目录, 第一次打开segment文件时读出
+    std::vector<PackedSegment> _packed_segments;
+    boost::mutex _packed_directory_lock;
+
     DISALLOW_COPY_AND_ASSIGN(OLAPIndex);
 };
 
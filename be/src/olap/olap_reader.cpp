@@ -15,9 +15,11 @@
 
 #include "olap/olap_reader.h"
 
+#include <algorithm>
 #include <sstream>
 
 #include "runtime/datetime_value.h"
+#include "runtime/vectorized_row_batch.h"
 #include "util/palo_metrics.h"
 
 using std::exception;
@@ -159,6 +161,16 @@ Status OLAPReader::init(TFetchRequest& fetch_request,
         }
     }
 
+    if (fetch_request.__isset.push_agg_op && fetch_request.push_agg_op != TPushAggOp::NONE) {
+        SCOPED_TIMER(_init_reader_timer);
+        _is_meta_read = _init_meta_read(fetch_request);
+        if (_is_meta_read) {
+            _is_inited = true;
+            _read_data_watch.reset();
+            return Status::OK;
+        }
+    }
+
     {
         SCOPED_TIMER(_init_reader_timer);
         res = _init_params(fetch_request, profile);
@@ -179,14 +191,29 @@ Status OLAPReader::close() {
 
 Status OLAPReader::next_tuple(Tuple* tuple, int64_t* raw_rows_read, bool* eof) {
     OLAPStatus res = OLAP_SUCCESS;
-    res = _reader.next_row_with_aggregation(&_read_row_cursor, raw_rows_read, eof);
+    if (_is_meta_read) {
+        res = _next_meta_tuple(tuple, raw_rows_read, eof);
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to get meta row.[res=%d]", res);
+            return Status("fail to get meta row");
+        }
+        return Status::OK;
+    }
+
+    // 不需要聚合时直接转换数据源中的行, 避免拷贝到_read_row_cursor
+    const RowCursor* row_cursor = &_read_row_cursor;
+    if (_reader.is_aggregation_free()) {
+        res = _reader.next_row(&row_cursor, raw_rows_read, eof);
+    } else {
+        res = _reader.next_row_with_aggregation(&_read_row_cursor, raw_rows_read, eof);
+    }
     if (res != OLAP_SUCCESS) {
         OLAP_LOG_WARNING("fail to get new row.[res=%d]", res);
         return Status("fail to get new row");
     }
 
     if (!*eof) {
-        res = _convert_row_to_tuple(tuple);
+        res = _convert_row_to_tuple(*row_cursor, tuple);
         if (res != OLAP_SUCCESS) {
             OLAP_LOG_WARNING("fail to convert row to tuple.[res=%d]", res);
             return Status("fail to convert row to tuple");
@@ -196,62 +223,241 @@ Status OLAPReader::next_tuple(Tuple* tuple, int64_t* raw_rows_read, bool* eof) {
     return Status::OK;
 }
 
-OLAPStatus OLAPReader::_convert_row_to_tuple(Tuple* tuple) {
-    RowCursor *row_cursor = NULL;
-    if (_aggregation) {
-        row_cursor = &_read_row_cursor;
+bool OLAPReader::is_vectorized_supported() const {
+    return _is_inited && !_is_meta_read
+            && (_reader.is_merge_free() || _reader.is_block_aggregation_supported());
+}
+
+VectorizedRowBatch* OLAPReader::create_vectorized_row_batch(int capacity) const {
+    std::vector<FieldInfo> schema;
+    for (uint32_t column_id : _reader.return_columns()) {
+        schema.push_back(_olap_table->tablet_schema()[column_id]);
+    }
+
+    return new (std::nothrow) VectorizedRowBatch(schema, capacity);
+}
+
+Status OLAPReader::next_batch(VectorizedRowBatch* batch, int64_t* raw_rows_read, bool* eof) {
+    batch->reset();
+    batch->prepare_storage_columns();
+
+    OLAPStatus res = OLAP_SUCCESS;
+    if (_reader.is_merge_free()) {
+        res = _reader.next_block(batch, raw_rows_read, eof);
     } else {
-        _return_row_cursor.copy(_read_row_cursor);
-        row_cursor = &_return_row_cursor;
+        res = _reader.next_block_with_aggregation(batch, raw_rows_read, eof);
+    }
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to get next block.[res=%d]", res);
+        return Status("fail to get next block");
+    }
+    batch->finish_storage_columns();
+
+    return Status::OK;
+}
+
+int OLAPReader::batch_column_index(SlotId slot_id) const {
+    for (int i = 0; i < _query_slots.size(); ++i) {
+        if (_query_slots[i]->id() == slot_id) {
+            return _batch_column_index[i];
+        }
+    }
+    return -1;
+}
+
+void OLAPReader::init_batch_filter(std::vector<ExprContext*>* conjunct_ctxs,
+                                   std::vector<ExprContext*>* vec_conjunct_ctxs) {
+    conjunct_ctxs->insert(conjunct_ctxs->end(),
+                          vec_conjunct_ctxs->begin(), vec_conjunct_ctxs->end());
+    vec_conjunct_ctxs->clear();
+
+    // 只编译next_batch读出的列上的conjunct, 其他列在filter_batch中没有数据
+    std::vector<FieldInfo> batch_schema = _olap_table->tablet_schema();
+    const std::vector<uint32_t>& read_columns = _reader.return_columns();
+    for (size_t i = 0; i < batch_schema.size(); ++i) {
+        if (std::find(read_columns.begin(), read_columns.end(), i) == read_columns.end()) {
+            batch_schema[i].name.clear();
+        }
+    }
+    _batch_filter.init(*conjunct_ctxs, batch_schema);
+
+    const std::vector<ExprContext*>& fallback_ctxs = _batch_filter.fallback_conjunct_ctxs();
+    for (ExprContext* ctx : *conjunct_ctxs) {
+        if (std::find(fallback_ctxs.begin(), fallback_ctxs.end(), ctx) == fallback_ctxs.end()) {
+            vec_conjunct_ctxs->push_back(ctx);
+        }
+    }
+    *conjunct_ctxs = fallback_ctxs;
+}
+
+void OLAPReader::filter_batch(VectorizedRowBatch* batch) {
+    if (_batch_filter.empty()) {
+        return;
+    }
+
+    // batch的列在每次next_batch时重新分配, 每次都需要更新列的位置
+    const std::vector<uint32_t>& read_columns = _reader.return_columns();
+    _batch_filter_columns.resize(_olap_table->tablet_schema().size());
+    for (size_t i = 0; i < read_columns.size(); ++i) {
+        ColumnVector* column_vector = batch->column(i);
+        FilterColumn& column = _batch_filter_columns[read_columns[i]];
+        column.data = reinterpret_cast<const char*>(column_vector->col_data());
+        column.stride = batch->schema()[i].length;
+        column.is_nullable = true;
+        column.null_flags = reinterpret_cast<const char*>(column_vector->is_null());
+        column.null_stride = sizeof(bool);
+    }
+
+    int* selected = batch->selected();
+    int size = batch->size();
+    if (!batch->selected_in_use()) {
+        for (int i = 0; i < size; ++i) {
+            selected[i] = i;
+        }
+    }
+    batch->set_size(_batch_filter.evaluate(_batch_filter_columns, selected, size));
+    batch->set_selected_in_use(true);
+}
+
+Status OLAPReader::convert_batch_to_tuples(VectorizedRowBatch* batch, Tuple* tuples) {
+    int num_rows = batch->size();
+    int tuple_size = _tuple_desc.byte_size();
+    uint8_t* tuple_buf = reinterpret_cast<uint8_t*>(tuples);
+    // 只转换选中的行
+    int* rows = batch->selected();
+    if (!batch->selected_in_use()) {
+        for (int j = 0; j < num_rows; ++j) {
+            rows[j] = j;
+        }
     }
 
-    int offset = 0;
+    // 按列转换, 每列只做一次类型判断
+    for (int i = 0; i < _query_slots.size(); ++i) {
+        const SlotDescriptor* slot_desc = _query_slots[i];
+        ColumnVector* column_vector = batch->column(_batch_column_index[i]);
+        const bool* is_null = column_vector->is_null();
+        const char* col_data = reinterpret_cast<const char*>(column_vector->col_data());
+        int tuple_offset = slot_desc->tuple_offset();
+        const NullIndicatorOffset& null_offset = slot_desc->null_indicator_offset();
+        size_t column_size = _request_columns_size[i];
+
+        switch (slot_desc->type().type) {
+        case TYPE_CHAR:
+        case TYPE_VARCHAR:
+        case TYPE_HLL: {
+            const StringValue* values = reinterpret_cast<const StringValue*>(col_data);
+            for (int k = 0; k < num_rows; ++k) {
+                int j = rows[k];
+                Tuple* tuple = reinterpret_cast<Tuple*>(tuple_buf + j * tuple_size);
+                if (is_null[j]) {
+                    tuple->set_null(null_offset);
+                    continue;
+                }
+                *tuple->get_string_slot(tuple_offset) = values[j];
+            }
+            break;
+        }
+        case TYPE_DECIMAL: {
+            for (int k = 0; k < num_rows; ++k) {
+                int j = rows[k];
+                Tuple* tuple = reinterpret_cast<Tuple*>(tuple_buf + j * tuple_size);
+                if (is_null[j]) {
+                    tuple->set_null(null_offset);
+                    continue;
+                }
+                const char* value = col_data + j * column_size;
+                int64_t int_value = *reinterpret_cast<const int64_t*>(value);
+                int32_t frac_value = *reinterpret_cast<const int32_t*>(value + sizeof(int64_t));
+                *tuple->get_decimal_slot(tuple_offset) = DecimalValue(int_value, frac_value);
+            }
+            break;
+        }
+        case TYPE_DATETIME: {
+            for (int k = 0; k < num_rows; ++k) {
+                int j = rows[k];
+                Tuple* tuple = reinterpret_cast<Tuple*>(tuple_buf + j * tuple_size);
+                if (is_null[j]) {
+                    tuple->set_null(null_offset);
+                    continue;
+                }
+                uint64_t value = *reinterpret_cast<const uint64_t*>(col_data + j * column_size);
+                if (!tuple->get_datetime_slot(tuple_offset)->from_olap_datetime(value)) {
+                    tuple->set_null(null_offset);
+                }
+            }
+            break;
+        }
+        case TYPE_DATE: {
+            for (int k = 0; k < num_rows; ++k) {
+                int j = rows[k];
+                Tuple* tuple = reinterpret_cast<Tuple*>(tuple_buf + j * tuple_size);
+                if (is_null[j]) {
+                    tuple->set_null(null_offset);
+                    continue;
+                }
+                const unsigned char* date = reinterpret_cast<const unsigned char*>(
+                        col_data + j * column_size);
+                uint64_t value = date[2];
+                value <<= 8;
+                value |= date[1];
+                value <<= 8;
+                value |= date[0];
+                if (!tuple->get_datetime_slot(tuple_offset)->from_olap_date(value)) {
+                    tuple->set_null(null_offset);
+                }
+            }
+            break;
+        }
+        default: {
+            for (int k = 0; k < num_rows; ++k) {
+                int j = rows[k];
+                Tuple* tuple = reinterpret_cast<Tuple*>(tuple_buf + j * tuple_size);
+                if (is_null[j]) {
+                    tuple->set_null(null_offset);
+                    continue;
+                }
+                memory_copy(tuple->get_slot(tuple_offset), col_data + j * column_size,
+                            column_size);
+            }
+            break;
+        }
+        }
+    }
+
+    return Status::OK;
+}
+
+OLAPStatus OLAPReader::_convert_row_to_tuple(const RowCursor& row_cursor, Tuple* tuple) {
     size_t slots_size = _query_slots.size();
-    //offset += row_cursor->get_num_null_byte();
-    for (int i = 0; i < slots_size; ++i)
-    {
-        offset += sizeof(char);
-        if (true == row_cursor->is_null_converted(i)) {
+    for (int i = 0; i < slots_size; ++i) {
+        // 按列读取, row_cursor可以是包含更多列的存储层的行
+        const Field* field = row_cursor.get_field_by_index(_return_columns[i]);
+        if (field->is_null()) {
             tuple->set_null(_query_slots[i]->null_indicator_offset());
-            offset += _request_columns_size[i];
-            if (TYPE_VARCHAR == _query_slots[i]->type().type || TYPE_HLL == _query_slots[i]->type().type) {
-                offset += 2; //row_cursor has an uint16_t storage space for NULL varchar
-            }
             continue;
         }
 
+        const char* buf = field->buf();
         switch (_query_slots[i]->type().type) {
         case TYPE_CHAR: {
             StringValue *slot = tuple->get_string_slot(_query_slots[i]->tuple_offset());
-            slot->ptr = reinterpret_cast<char*>(
-                    const_cast<char*>(row_cursor->get_buf() + offset));
+            slot->ptr = const_cast<char*>(buf);
             slot->len = strnlen(slot->ptr, _request_columns_size[i]);
-            offset += _request_columns_size[i];
             break;
         }
         case TYPE_VARCHAR:
         case TYPE_HLL: {
             StringValue *slot = tuple->get_string_slot(_query_slots[i]->tuple_offset());
-            size_t size = *reinterpret_cast<uint16_t*>
-                    (const_cast<char*>(row_cursor->get_buf() + offset));
-            offset += 2;
-            slot->ptr = reinterpret_cast<char*>
-                    (const_cast<char*>(row_cursor->get_buf() + offset));
-            slot->len = size;
-            offset += _request_columns_size[i];
+            slot->len = *reinterpret_cast<const uint16_t*>(buf);
+            slot->ptr = const_cast<char*>(buf + sizeof(uint16_t));
             break;
         }
         case TYPE_DECIMAL: {
-            // DecimalValue *slot = tuple->get_decimal_slot(_tuple_desc.slots()[i]->tuple_offset());
             DecimalValue *slot = tuple->get_decimal_slot(_query_slots[i]->tuple_offset());
 
             // TODO(lingbin): should remove this assign, use set member function
-            int64_t int_value = *reinterpret_cast<int64_t*>(
-                    const_cast<char*>(row_cursor->get_buf() + offset));
-            offset += sizeof(int64_t);
-            int32_t frac_value = *reinterpret_cast<int32_t*>(
-                    const_cast<char*>(row_cursor->get_buf() + offset));
-            offset += sizeof(int32_t);
+            int64_t int_value = *reinterpret_cast<const int64_t*>(buf);
+            int32_t frac_value = *reinterpret_cast<const int32_t*>(buf + sizeof(int64_t));
             *slot = DecimalValue(int_value, frac_value);
             break;
         }
@@ -259,33 +465,29 @@ OLAPStatus OLAPReader::_convert_row_to_tuple(Tuple* tuple) {
         case TYPE_DATETIME: {
             DateTimeValue *slot = tuple->get_datetime_slot(
                     _query_slots[i]->tuple_offset());
-            uint64_t value = *reinterpret_cast<uint64_t*>(
-                    const_cast<char*>(row_cursor->get_buf() + offset));
+            uint64_t value = *reinterpret_cast<const uint64_t*>(buf);
             if (!slot->from_olap_datetime(value)) {
                 tuple->set_null(_query_slots[i]->null_indicator_offset());
             }
-            offset += 8;
             break;
         }
         case TYPE_DATE: {
             DateTimeValue *slot = tuple->get_datetime_slot(
                     _query_slots[i]->tuple_offset());
             uint64_t value = 0;
-            value = *(unsigned char*)(row_cursor->get_buf() + offset + 2);
+            value = *(const unsigned char*)(buf + 2);
             value <<= 8;
-            value |= *(unsigned char*)(row_cursor->get_buf() + offset + 1);
+            value |= *(const unsigned char*)(buf + 1);
             value <<= 8;
-            value |= *(unsigned char*)(row_cursor->get_buf() + offset);
+            value |= *(const unsigned char*)(buf);
             if (!slot->from_olap_date(value)) {
                 tuple->set_null(_query_slots[i]->null_indicator_offset());
             }
-            offset += 3;
             break;
         }
         default: {
             void *slot = tuple->get_slot(_query_slots[i]->tuple_offset());
-            memory_copy(slot, row_cursor->get_buf() + offset, _request_columns_size[i]);
-            offset += _request_columns_size[i];
+            memory_copy(slot, buf, _request_columns_size[i]);
             break;
         }
         }
@@ -307,12 +509,19 @@ OLAPStatus OLAPReader::_init_params(TFetchRequest& fetch_request, RuntimeProfile
     reader_params.olap_table = _olap_table;
     reader_params.reader_type = READER_FETCH;
     reader_params.aggregation = fetch_request.aggregation;
-    reader_params.version = Version(0, fetch_request.version);
+    reader_params.adaptive_aggregation = fetch_request.__isset.adaptive_aggregation
+            && fetch_request.adaptive_aggregation;
+    reader_params.version = Version(
+            fetch_request.__isset.start_version ? fetch_request.start_version : 0,
+            fetch_request.version);
     reader_params.conditions = fetch_request.where;
     reader_params.range = fetch_request.range;
     reader_params.end_range = fetch_request.end_range;
     reader_params.start_key = fetch_request.start_key;
     reader_params.end_key = fetch_request.end_key;
+    if (fetch_request.__isset.skip_scan_values) {
+        reader_params.skip_scan_values = fetch_request.skip_scan_values;
+    }
     reader_params.conjunct_ctxs = _conjunct_ctxs;
     reader_params.profile = profile;
     reader_params.runtime_state = _runtime_state;
@@ -350,9 +559,151 @@ OLAPStatus OLAPReader::_init_params(TFetchRequest& fetch_request, RuntimeProfile
         _query_slots.push_back(_tuple_desc.slots()[i]);
     }
 
+    const std::vector<uint32_t>& read_columns = _reader.return_columns();
+    for (uint32_t column_id : _return_columns) {
+        _batch_column_index.push_back(
+                std::find(read_columns.begin(), read_columns.end(), column_id)
+                - read_columns.begin());
+    }
+
     return res;
 }
 
+bool OLAPReader::_init_meta_read(const TFetchRequest& fetch_request) {
+    if (!fetch_request.where.empty() || !fetch_request.start_key.empty()
+            || (_conjunct_ctxs != NULL && !_conjunct_ctxs->empty())) {
+        return false;
+    }
+
+    bool is_count = (fetch_request.push_agg_op == TPushAggOp::COUNT);
+    std::vector<uint32_t> columns;
+    for (const std::string& field : fetch_request.field) {
+        int32_t index = _olap_table->get_field_index(field);
+        // 只有key列有统计信息
+        if (index < 0
+                || (!is_count && static_cast<size_t>(index) >= _olap_table->num_key_fields())) {
+            return false;
+        }
+        columns.push_back(index);
+    }
+
+    std::vector<IData*> data_sources;
+    bool supported = true;
+    _olap_table->obtain_header_rdlock();
+    _olap_table->acquire_data_sources(Version(0, fetch_request.version), &data_sources);
+    // base版本合并时已经处理了之前的删除条件, 之后的删除条件只能通过读数据处理
+    int32_t base_version = -1;
+    for (IData* data : data_sources) {
+        if (data->version().first == 0) {
+            base_version = data->version().second;
+        }
+    }
+    for (const DeleteDataConditionMessage& cond : _olap_table->delete_data_conditions()) {
+        if (cond.version() > base_version && cond.version() <= fetch_request.version) {
+            supported = false;
+        }
+    }
+    _olap_table->release_header_lock();
+    if (data_sources.empty()) {
+        return false;
+    }
+
+    // 非DUP_KEYS表的多个版本之间可能有相同的key, 只有一个版本时行数才是准确的.
+    // MIN/MAX只取自key列, 和合并无关
+    if (is_count) {
+        if (_olap_table->keys_type() != KeysType::DUP_KEYS && data_sources.size() != 1) {
+            supported = false;
+        }
+        _meta_row_num = 0;
+        for (IData* data : data_sources) {
+            _meta_row_num += data->num_rows();
+        }
+    } else {
+        _meta_rows.clear();
+        for (size_t i = 0; supported && i < data_sources.size(); ++i) {
+            if (data_sources[i]->num_rows() == 0) {
+                continue;
+            }
+            OLAPIndex* index = data_sources[i]->olap_index();
+            if (!index->has_column_statistics()) {
+                supported = false;
+                break;
+            }
+            std::vector<std::pair<Field*, Field*> >& statistics = index->get_column_statistics();
+            std::vector<std::string> min_row;
+            std::vector<std::string> max_row;
+            for (uint32_t column_id : columns) {
+                // 有null值时统计信息中的最小值是null, 无法得到非null的最小值
+                if (column_id >= statistics.size()
+                        || statistics[column_id].first == NULL
+                        || statistics[column_id].second == NULL
+                        || statistics[column_id].first->is_null()
+                        || statistics[column_id].second->is_null()) {
+                    supported = false;
+                    break;
+                }
+                min_row.push_back(statistics[column_id].first->to_string());
+                max_row.push_back(statistics[column_id].second->to_string());
+            }
+            _meta_rows.push_back(min_row);
+            _meta_rows.push_back(max_row);
+        }
+    }
+    _olap_table->release_data_sources(&data_sources);
+
+    if (!supported) {
+        _meta_rows.clear();
+        _meta_row_num = 0;
+        return false;
+    }
+
+    if (_init_return_columns(const_cast<TFetchRequest&>(fetch_request)) != OLAP_SUCCESS
+            || _read_row_cursor.init(_olap_table->tablet_schema(), _return_columns) != OLAP_SUCCESS) {
+        return false;
+    }
+    for (int i = 0; i < _tuple_desc.slots().size(); ++i) {
+        if (_tuple_desc.slots()[i]->is_materialized()) {
+            _query_slots.push_back(_tuple_desc.slots()[i]);
+        }
+    }
+    _aggregation = true;
+    _meta_row_index = 0;
+
+    OLAP_LOG_DEBUG("read from meta. [tablet=%s push_agg_op=%d rows=%ld]",
+                   _olap_table->full_name().c_str(), fetch_request.push_agg_op,
+                   is_count ? _meta_row_num : static_cast<int64_t>(_meta_rows.size()));
+    return true;
+}
+
+OLAPStatus OLAPReader::_next_meta_tuple(Tuple* tuple, int64_t* raw_rows_read, bool* eof) {
+    *eof = false;
+    if (_meta_rows.empty()) {
+        // COUNT(*)不关心tuple的内容
+        if (_meta_row_num <= 0) {
+            *eof = true;
+            return OLAP_SUCCESS;
+        }
+        --_meta_row_num;
+        ++(*raw_rows_read);
+        return OLAP_SUCCESS;
+    }
+
+    if (_meta_row_index >= _meta_rows.size()) {
+        *eof = true;
+        return OLAP_SUCCESS;
+    }
+    OLAPStatus res = _read_row_cursor.from_string(_meta_rows[_meta_row_index++]);
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to convert statistics to row. [res=%d]", res);
+        return res;
+    }
+    for (uint32_t column_id : _return_columns) {
+        _read_row_cursor.set_not_null(column_id);
+    }
+    ++(*raw_rows_read);
+    return _convert_row_to_tuple(_read_row_cursor, tuple);
+}
+
 OLAPStatus OLAPReader::_init_return_columns(TFetchRequest& fetch_request) {
     for (int32_t i = 0, len = fetch_request.field.size(); i < len; i++) {
         int32_t index = _olap_table->get_field_index(fetch_request.field[i]);
@@ -372,8 +723,6 @@ OLAPStatus OLAPReader::_init_return_columns(TFetchRequest& fetch_request) {
         }
     }
 
-    _return_row_cursor.init(_olap_table->tablet_schema(), _return_columns);
-
     return OLAP_SUCCESS;
 }
 
@@ -26,6 +26,7 @@
 #include "olap/olap_engine.h"
 #include "util/palo_metrics.h"
 #include "olap/reader.h"
+#include "olap/vectorized_filter.h"
 
 namespace palo {
 
@@ -48,6 +49,9 @@ public:
             _is_inited(false),
             _request_version(-1),
             _aggregation(false),
+            _is_meta_read(false),
+            _meta_row_num(0),
+            _meta_row_index(0),
             _get_tablet_timer(nullptr),
             _init_reader_timer(nullptr),
             _read_data_timer(nullptr),
@@ -59,6 +63,9 @@ public:
             _is_inited(false),
             _request_version(-1),
             _aggregation(false),
+            _is_meta_read(false),
+            _meta_row_num(0),
+            _meta_row_index(0),
             _get_tablet_timer(nullptr),
             _init_reader_timer(nullptr),
             _read_data_timer(nullptr),
@@ -75,13 +82,60 @@ public:
     Status close();
 
     Status next_tuple(Tuple *tuple, int64_t* raw_rows_read, bool* eof);
+
+    // 是否支持向量化读取, DUP_KEYS表或者各版本key范围不相交的预聚合读取不需要合并,
+    // 可以批量读取; 其他表的value列聚合方式都支持按列聚合时, 也可以批量读取
+    bool is_vectorized_supported() const;
+
+    // 创建用于next_batch的VectorizedRowBatch, 调用者负责释放
+    VectorizedRowBatch* create_vectorized_row_batch(int capacity) const;
+
+    // 以列存格式读取下一批数据到batch中, 没有读到任何数据时设置eof
+    Status next_batch(VectorizedRowBatch* batch, int64_t* raw_rows_read, bool* eof);
+
+    // slot在next_batch读出的batch中的列下标, 不是查询的slot时返回-1
+    int batch_column_index(SlotId slot_id) const;
+
+    // 把conjunct_ctxs中能直接在next_batch读出的列上求值的conjunct移到vec_conjunct_ctxs中,
+    // 由filter_batch求值, 其余的留在conjunct_ctxs中. 可以重复调用
+    void init_batch_filter(std::vector<ExprContext*>* conjunct_ctxs,
+                           std::vector<ExprContext*>* vec_conjunct_ctxs);
+
+    // 在batch的列上执行init_batch_filter移出的conjunct, 满足条件的行号写入batch的选择向量
+    void filter_batch(VectorizedRowBatch* batch);
+
+    // 将batch中选中的行按列转换为tuple, 第j行写入从tuples开始的第j个tuple中,
+    // 没有选中的行不转换. tuple需要预先清零, 字符串slot直接指向batch中的数据
+    Status convert_batch_to_tuples(VectorizedRowBatch* batch, Tuple* tuples);
+
+    // 把还没有开始读的key range的后一半让给其他reader, 返回让出的第一个key range
+    // 的下标, 没有可以让出的key range时返回-1. 可以在读取的同时由其他线程调用
+    // init之后有效, 读取的tablet的访问统计
+    TabletAccessStats* access_stats() {
+        return _olap_table.get() != NULL ? _olap_table->access_stats() : NULL;
+    }
+
+    int32_t split_key_ranges() {
+        if (!_is_inited || _is_meta_read) {
+            return -1;
+        }
+        return _reader.split_key_ranges();
+    }
     
 private: 
     OLAPStatus _init_params(TFetchRequest& fetch_request, RuntimeProfile* profile);
 
     OLAPStatus _init_return_columns(TFetchRequest& fetch_request);
 
-    OLAPStatus _convert_row_to_tuple(Tuple* tuple);
+    // 把row_cursor中的_return_columns转换为tuple, 字符串指向row_cursor的内存
+    OLAPStatus _convert_row_to_tuple(const RowCursor& row_cursor, Tuple* tuple);
+
+    // 没有过滤条件的COUNT(*)和key列上的MIN/MAX可以直接从元数据得到结果:
+    // COUNT返回总行数个空tuple, MINMAX对每个版本返回由各列最小值和最大值组成的两行.
+    // 元数据不足以得到正确结果时返回false, 按正常方式读取数据
+    bool _init_meta_read(const TFetchRequest& fetch_request);
+
+    OLAPStatus _next_meta_tuple(Tuple* tuple, int64_t* raw_rows_read, bool* eof);
 
     Reader _reader;
 
@@ -101,12 +155,25 @@ private:
 
     RowCursor _read_row_cursor;
 
-    RowCursor _return_row_cursor;
-
     std::vector<uint32_t> _request_columns_size;
 
     std::vector<SlotDescriptor*> _query_slots;
 
+    // _query_slots中每个slot在_reader.return_columns()中的位置, 用于向量化读取
+    std::vector<uint32_t> _batch_column_index;
+
+    // 在next_batch读出的列上求值的conjunct, 以及按tablet_schema下标访问的列位置
+    VectorizedFilter _batch_filter;
+    std::vector<FilterColumn> _batch_filter_columns;
+
+    // 是否从元数据中读取结果
+    bool _is_meta_read;
+    // COUNT: 还需要返回的行数
+    int64_t _meta_row_num;
+    // MINMAX: 需要返回的行, 每行是各个返回列的字符串值
+    std::vector<std::vector<std::string> > _meta_rows;
+    size_t _meta_row_index;
+
     // time costed and row returned statistics
     RuntimeProfile::Counter* _get_tablet_timer;
     RuntimeProfile::Counter* _init_reader_timer;
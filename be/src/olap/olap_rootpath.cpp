@@ -22,6 +22,7 @@
 #include <sys/file.h>
 #include <sys/statfs.h>
 #include <sys/statfs.h>
+#include <sys/time.h>
 #include <utime.h>
 
 #include <algorithm>
@@ -42,6 +43,9 @@
 
 #include "olap/file_helper.h"
 #include "olap/olap_engine.h"
+#include "olap/sync_coordinator.h"
+#include "util/disk_io_stats.h"
+#include "util/numa_info.h"
 
 using boost::filesystem::canonical;
 using boost::filesystem::file_size;
@@ -52,6 +56,7 @@ using boost::interprocess::file_lock;
 using std::find;
 using std::fstream;
 using std::make_pair;
+using std::map;
 using std::nothrow;
 using std::pair;
 using std::random_device;
@@ -166,6 +171,8 @@ OLAPStatus OLAPRootPath::init() {
         }
 
         _root_paths.insert(pair<string, RootPathInfo>(root_path_vec[i], root_path_info));
+        DiskIoStats::add_path(root_path_vec[i]);
+        SyncCoordinator::add_path(root_path_vec[i]);
     }
 
     _update_storage_medium_type_count();
@@ -300,6 +307,25 @@ OLAPStatus OLAPRootPath::get_all_root_path_stat(vector<OLAPRootPathStat>* root_p
     return res;
 }
 
+void OLAPRootPath::get_all_root_path_load(vector<OLAPRootPathLoad>* root_paths_load) {
+    root_paths_load->clear();
+
+    AutoMutexLock auto_lock(&_mutex);
+    for (RootPathMap::iterator it = _root_paths.begin(); it != _root_paths.end(); ++it) {
+        const RootPathInfo& info = it->second;
+        if (!info.is_used || info.last_disk_stats_time_ms == 0) {
+            continue;
+        }
+
+        OLAPRootPathLoad load;
+        load.root_path = it->first;
+        load.io_util = info.io_util;
+        load.read_latency_ms = info.read_latency_ms;
+        load.load_score = info.load_score;
+        root_paths_load->push_back(load);
+    }
+}
+
 OLAPStatus OLAPRootPath::reload_root_paths(const char* root_paths) {
     OLAPStatus res = OLAP_SUCCESS;
 
@@ -353,6 +379,8 @@ OLAPStatus OLAPRootPath::reload_root_paths(const char* root_paths) {
             }
 
             _root_paths.insert(pair<string, RootPathInfo>(root_path_vec[i], root_path_info));
+            DiskIoStats::add_path(root_path_vec[i]);
+            SyncCoordinator::add_path(root_path_vec[i]);
         } else {
             if (!iter_root_path->second.is_used) {
                 iter_root_path->second.is_used = true;
@@ -436,6 +464,7 @@ OLAPStatus OLAPRootPath::unregister_table_from_root_path(OLAPTable* olap_table)
 
 void OLAPRootPath::start_disk_stat_monitor() {
     _start_check_disks();
+    _update_root_path_load();
     _detect_unused_flag();
     _delete_tables_on_unused_root_path();
     
@@ -474,6 +503,58 @@ void OLAPRootPath::_start_check_disks() {
     }
 }
 
+void OLAPRootPath::_update_root_path_load() {
+    std::map<int, DiskInfo::DiskStats> disk_stats;
+    if (!DiskInfo::get_disk_stats(&disk_stats)) {
+        return;
+    }
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    int64_t now_ms = now.tv_sec * 1000L + now.tv_usec / 1000;
+    AutoMutexLock auto_lock(&_mutex);
+    for (RootPathMap::iterator it = _root_paths.begin(); it != _root_paths.end(); ++it) {
+        RootPathInfo& info = it->second;
+        std::map<int, DiskInfo::DiskStats>::iterator stats_it = disk_stats.find(info.disk_id);
+        if (!info.is_used || stats_it == disk_stats.end()) {
+            continue;
+        }
+
+        const DiskInfo::DiskStats& stats = stats_it->second;
+        int64_t interval_ms = now_ms - info.last_disk_stats_time_ms;
+        if (info.last_disk_stats_time_ms > 0 && interval_ms > 0) {
+            double io_util = (stats.io_time_ms - info.last_disk_stats.io_time_ms)
+                    * 100.0 / interval_ms;
+            double avg_queue_size = (stats.weighted_io_time_ms
+                    - info.last_disk_stats.weighted_io_time_ms) * 1.0 / interval_ms;
+            int64_t reads = stats.reads_completed - info.last_disk_stats.reads_completed;
+            double read_await_ms = reads > 0
+                    ? (stats.read_time_ms - info.last_disk_stats.read_time_ms) * 1.0 / reads : 0;
+            // 内核的平均读延迟掩盖了长尾，取其与存储引擎自己测得的p99读延迟中较大者
+            DiskIoStats* io_stats = DiskIoStats::find(it->first);
+            double read_p99_ms = io_stats != NULL
+                    ? io_stats->read_latency_since_last(0.99) / 1000000.0 : 0;
+            read_await_ms = std::max(read_await_ms, read_p99_ms);
+
+            // IO利用率[0, 100]，队列长度和读延迟各最多贡献50分，与上一次的分数平滑
+            double score = std::min(std::max(io_util, 0.0), 100.0)
+                    + std::min(std::max(avg_queue_size, 0.0), 10.0) * 5
+                    + std::min(std::max(read_await_ms, 0.0), 100.0) / 2;
+            info.load_score = (info.load_score + score) / 2;
+            info.io_util = std::min(std::max(io_util, 0.0), 100.0);
+            info.read_latency_ms = read_await_ms;
+            OLAP_LOG_DEBUG("update root path load. [root_path='%s' io_util=%.1f "
+                           "avg_queue_size=%.2f read_await_ms=%.2f read_p99_ms=%.2f "
+                           "load_score=%.1f]",
+                           it->first.c_str(), io_util, avg_queue_size,
+                           read_await_ms, read_p99_ms, info.load_score);
+        }
+
+        info.last_disk_stats = stats;
+        info.last_disk_stats_time_ms = now_ms;
+    }
+}
+
 bool OLAPRootPath::_used_disk_not_enough(uint32_t unused_num, uint32_t total_num) {
     return ((total_num == 0) || (unused_num * 100 / total_num > _min_percentage_of_error_disk));
 }
@@ -898,6 +979,15 @@ OLAPStatus OLAPRootPath::_update_root_path_info(
         return res;
     }
 
+    root_path_info->disk_id = DiskInfo::disk_id(root_path.c_str());
+    root_path_info->numa_node = _get_configured_numa_node(root_path);
+    if (root_path_info->numa_node < 0 && root_path_info->disk_id >= 0) {
+        root_path_info->numa_node = NumaInfo::node_of_device(
+                DiskInfo::device_name(root_path_info->disk_id));
+    }
+    root_path_info->last_disk_stats_time_ms = 0;
+    root_path_info->load_score = 0;
+
     root_path_info->storage_medium = TStorageMedium::HDD;
     if (is_ssd_disk(root_path)) {
         root_path_info->storage_medium = TStorageMedium::SSD;
@@ -1049,12 +1139,16 @@ void OLAPRootPath::get_root_path_for_create_table(
         TStorageMedium::type storage_medium, RootPathVec *root_path) {
     root_path->clear();
 
+    map<string, int32_t> load_buckets;
+    int32_t bucket_size = std::max(config::root_path_load_score_bucket, 1);
     _mutex.lock();
     for (RootPathMap::iterator it = _root_paths.begin(); it != _root_paths.end(); ++it) {
         if (it->second.is_used) {
             if (_available_storage_medium_type_count == 1
                     || it->second.storage_medium == storage_medium) {
                 root_path->push_back(it->first);
+                load_buckets[it->first] =
+                        static_cast<int32_t>(it->second.load_score) / bucket_size;
             }
         }
     }
@@ -1063,6 +1157,88 @@ void OLAPRootPath::get_root_path_for_create_table(
     random_device rd;
     srand(rd());
     random_shuffle(root_path->begin(), root_path->end());
+
+    if (config::enable_load_aware_root_path) {
+        std::stable_sort(root_path->begin(), root_path->end(),
+                [&load_buckets](const string& a, const string& b) {
+                    return load_buckets[a] < load_buckets[b];
+                });
+    }
+}
+
+bool OLAPRootPath::get_rebalance_tablet(
+        TableInfo* table_info,
+        string* dest_root_path,
+        TStorageMedium::type* storage_medium) {
+    string src_root_path;
+    vector<TableInfo> candidates;
+    {
+        AutoMutexLock auto_lock(&_mutex);
+        double max_diff = 0;
+        for (RootPathMap::iterator hot = _root_paths.begin(); hot != _root_paths.end(); ++hot) {
+            if (!hot->second.is_used || hot->second.table_set.empty()
+                    || hot->second.load_score < config::root_path_rebalance_hot_score) {
+                continue;
+            }
+
+            // 只在同一种存储介质之间迁移
+            for (RootPathMap::iterator cold = _root_paths.begin();
+                    cold != _root_paths.end(); ++cold) {
+                if (!cold->second.is_used
+                        || cold->second.storage_medium != hot->second.storage_medium) {
+                    continue;
+                }
+                double diff = hot->second.load_score - cold->second.load_score;
+                if (diff >= config::root_path_rebalance_score_diff && diff > max_diff) {
+                    max_diff = diff;
+                    src_root_path = hot->first;
+                    *dest_root_path = cold->first;
+                    *storage_medium = cold->second.storage_medium;
+                }
+            }
+        }
+
+        if (src_root_path.empty()) {
+            return false;
+        }
+
+        // 随机取几个tablet, 出锁后选其中近期读盘最多的迁走, 迁移的负载最多
+        const set<TableInfo>& table_set = _root_paths[src_root_path].table_set;
+        int32_t samples = std::max(config::root_path_rebalance_tablet_samples, 1);
+        for (int32_t i = 0; i < samples; ++i) {
+            set<TableInfo>::const_iterator table_it = table_set.begin();
+            std::advance(table_it, rand() % table_set.size());
+            candidates.push_back(*table_it);
+        }
+    }
+
+    *table_info = candidates[0];
+    double max_read_bytes_rate = -1;
+    for (const TableInfo& candidate : candidates) {
+        SmartOLAPTable table = OLAPEngine::get_instance()->get_table(
+                candidate.tablet_id, candidate.schema_hash);
+        if (table.get() != NULL
+                && table->access_stats()->read_bytes_rate() > max_read_bytes_rate) {
+            max_read_bytes_rate = table->access_stats()->read_bytes_rate();
+            *table_info = candidate;
+        }
+    }
+
+    int64_t capacity = 0;
+    int64_t available = 0;
+    if (_get_disk_capacity(*dest_root_path, &capacity, &available) != OLAP_SUCCESS
+            || capacity <= 0
+            || available * 100 / capacity < config::root_path_rebalance_min_available_percent) {
+        OLAP_LOG_INFO("cold root path has not enough capacity to rebalance. "
+                      "[root_path='%s' capacity=%ld available=%ld]",
+                      dest_root_path->c_str(), capacity, available);
+        return false;
+    }
+
+    OLAP_LOG_INFO("choose tablet to rebalance. [tablet=%s src_root_path='%s' "
+                  "dest_root_path='%s']", table_info->to_string().c_str(),
+                  src_root_path.c_str(), dest_root_path->c_str());
+    return true;
 }
 
 void OLAPRootPath::get_table_data_path(std::vector<std::string>* data_paths) {
@@ -1077,6 +1253,44 @@ void OLAPRootPath::get_table_data_path(std::vector<std::string>* data_paths) {
     _mutex.unlock();
 }
 
+int OLAPRootPath::get_root_path_numa_node(const std::string& root_path) {
+    if (!NumaInfo::enabled()) {
+        return -1;
+    }
+    AutoMutexLock auto_lock(&_mutex);
+
+    int index = 0;
+    for (RootPathMap::iterator it = _root_paths.begin(); it != _root_paths.end(); ++it) {
+        if (it->first == root_path) {
+            if (it->second.numa_node >= 0) {
+                return it->second.numa_node;
+            }
+            return index % NumaInfo::num_nodes();
+        }
+        ++index;
+    }
+    return -1;
+}
+
+int OLAPRootPath::_get_configured_numa_node(const std::string& root_path) {
+    vector<string> items;
+    boost::split(items, config::storage_root_path_numa_nodes, boost::is_any_of(";"));
+    for (const string& item : items) {
+        size_t pos = item.rfind(':');
+        if (pos == string::npos || boost::trim_copy(item.substr(0, pos)) != root_path) {
+            continue;
+        }
+        int node = -1;
+        if (!(std::istringstream(item.substr(pos + 1)) >> node)
+                || node < 0 || node >= NumaInfo::num_nodes()) {
+            OLAP_LOG_WARNING("invalid numa node of root path. [item='%s']", item.c_str());
+            return -1;
+        }
+        return node;
+    }
+    return -1;
+}
+
 OLAPStatus OLAPRootPath::get_root_path_shard(const std::string& root_path, uint64_t* shard) {
     OLAPStatus res = OLAP_SUCCESS;
     AutoMutexLock auto_lock(&_mutex);
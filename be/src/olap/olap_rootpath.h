@@ -29,6 +29,7 @@
 
 #include "olap/olap_cond.h"
 #include "olap/olap_define.h"
+#include "util/disk_info.h"
 
 namespace palo {
 
@@ -46,6 +47,19 @@ struct OLAPRootPathStat {
     bool is_used;
 };
 
+// root_path最近一次监测到的负载, 见OLAPRootPath::_update_root_path_load()
+struct OLAPRootPathLoad {
+    OLAPRootPathLoad():
+          io_util(0),
+          read_latency_ms(0),
+          load_score(0) {}
+
+    std::string root_path;
+    double io_util;             // IO利用率，单位%
+    double read_latency_ms;     // 读延迟，取p99与内核平均值中较大者
+    double load_score;
+};
+
 /*
  * 目前所谓的RootPath指的是storage_root_path，其目录组织结构如下:
  *
@@ -82,6 +96,9 @@ public:
     OLAPStatus get_all_disk_stat(std::vector<OLAPRootPathStat>* disks_stat);
     OLAPStatus get_all_root_path_stat(std::vector<OLAPRootPathStat>* root_paths_stat);
 
+    // @brief 获取所有可用root_path最近一次监测到的负载，尚未监测过的不返回
+    void get_all_root_path_load(std::vector<OLAPRootPathLoad>* root_paths_load);
+
     // @brief 重新加载root_paths信息，全量操作。
     // 对于新增的root_path，同init操作
     // 对于删除的root_path，要同时从内存中删除相关表。
@@ -102,8 +119,17 @@ public:
 
     // get root path for creating table. The returned vector of root path should be random, 
     // for avoiding that all the table would be deployed one disk.
+    // If enable_load_aware_root_path, the less loaded root paths come first, and root paths
+    // with similar load are still random.
     void get_root_path_for_create_table(
             TStorageMedium::type storage_medium, RootPathVec *root_path);
+
+    // @brief 选择一个从最繁忙的root_path迁到最空闲的root_path的tablet
+    // @return 负载差别不大或者没有可迁移的tablet时返回false
+    bool get_rebalance_tablet(
+            TableInfo* table_info,
+            std::string* dest_root_path,
+            TStorageMedium::type* storage_medium);
     void get_table_data_path(std::vector<std::string>* data_paths);
 
     uint32_t available_storage_medium_type_count() {
@@ -120,6 +146,11 @@ public:
 
     OLAPStatus get_root_path_shard(const std::string& root_path, uint64_t* shard);
 
+    // 返回root_path所在的NUMA节点，未开启NUMA亲和或root_path不存在时返回-1。
+    // 节点依次取自配置storage_root_path_numa_nodes、磁盘控制器所在节点，
+    // 都没有时按root_path的顺序轮流分配
+    int get_root_path_numa_node(const std::string& root_path);
+
     static bool is_ssd_disk(const std::string& file_path);
 
     uint32_t get_file_system_count() {
@@ -143,7 +174,13 @@ private:
                 available(0),
                 current_shard(0),
                 is_used(false),
-                to_be_deleted(false) {}
+                to_be_deleted(false),
+                disk_id(-1),
+                numa_node(-1),
+                last_disk_stats_time_ms(0),
+                io_util(0),
+                read_latency_ms(0),
+                load_score(0) {}
 
         std::string file_system;            // 目录对应的磁盘分区
         std::string unused_flag_file;       // 不可用标识对应的文件名
@@ -154,6 +191,15 @@ private:
         bool to_be_deleted;                 // 删除标识，如在reload时删除某一目录
         TStorageMedium::type storage_medium;  // 存储介质类型：SSD|HDD
         std::set<TableInfo> table_set;
+
+        int disk_id;                        // DiskInfo中的磁盘编号，-1表示未知
+        int numa_node;                      // 配置或磁盘控制器所在的NUMA节点，-1表示未知
+        DiskInfo::DiskStats last_disk_stats;  // 上一次监测时的磁盘IO计数
+        int64_t last_disk_stats_time_ms;
+        double io_util;                     // 上一监测周期的IO利用率，单位%
+        double read_latency_ms;             // 上一监测周期的读延迟
+        // 磁盘负载分数，综合IO利用率、平均队列长度和读延迟，越大越繁忙
+        double load_score;
     };
 
     typedef std::map<std::string, RootPathInfo> RootPathMap;
@@ -161,6 +207,9 @@ private:
     // 检测磁盘。主要通过周期地读写4K的测试数据
     void _start_check_disks();
 
+    // 根据/proc/diskstats更新各root_path的负载分数
+    void _update_root_path_load();
+
     bool _used_disk_not_enough(uint32_t unused_num, uint32_t total_num);
 
     OLAPStatus _check_existed_root_path(const std::string& root_path, int64_t* capacity);
@@ -188,6 +237,9 @@ private:
 
     OLAPStatus _get_root_path_current_shard(const std::string& root_path, uint64_t* shard);
 
+    // 配置storage_root_path_numa_nodes中root_path的NUMA节点，未配置时返回-1
+    int _get_configured_numa_node(const std::string& root_path);
+
     OLAPStatus _config_root_path_unused_flag_file(
             const std::string& root_path,
             std::string* unused_flag_file);
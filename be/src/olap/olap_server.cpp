@@ -18,6 +18,7 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cmath>
 #include <ctime>
 #include <string>
@@ -29,8 +30,10 @@
 #include "olap/olap_common.h"
 #include "olap/olap_define.h"
 #include "olap/olap_engine.h"
+#include "olap/olap_rootpath.h"
 #include "olap/olap_snapshot.h"
 #include "agent/cgroups_mgr.h"
+#include "util/io_throttle.h"
 
 
 using std::string;
@@ -55,6 +58,10 @@ Condition OLAPServer::_s_check_disks_cond = Condition(OLAPServer::_s_check_disks
 MutexLock OLAPServer::_s_session_timeout_mutex = MutexLock();
 Condition OLAPServer::_s_session_timeout_cond = Condition(OLAPServer::_s_session_timeout_mutex);
 
+MutexLock OLAPServer::_s_root_path_rebalance_mutex = MutexLock();
+Condition OLAPServer::_s_root_path_rebalance_cond =
+        Condition(OLAPServer::_s_root_path_rebalance_mutex);
+
 OLAPServer::OLAPServer() { }
 
 OLAPStatus OLAPServer::init(const char* config_path, const char* config_file) {
@@ -115,6 +122,42 @@ OLAPStatus OLAPServer::init(const char* config_path, const char* config_file) {
         return OLAP_ERR_INIT_FAILED;
     }
 
+    if (config::root_path_rebalance_interval_sec > 0
+            && 0 != pthread_create(&_root_path_rebalance_thread,
+                                   NULL,
+                                   _root_path_rebalance_thread_callback,
+                                   NULL)) {
+        OLAP_LOG_FATAL("failed to start root path rebalance thread.");
+        return OLAP_ERR_INIT_FAILED;
+    }
+
+    if (config::column_file_convert_interval_sec > 0
+            && 0 != pthread_create(&_column_file_convert_thread,
+                                   NULL,
+                                   _column_file_convert_thread_callback,
+                                   NULL)) {
+        OLAP_LOG_FATAL("failed to start column file convert thread.");
+        return OLAP_ERR_INIT_FAILED;
+    }
+
+    if (config::enable_lazy_index_load && config::cold_tablet_index_unload_sec > 0
+            && 0 != pthread_create(&_cold_index_unload_thread,
+                                   NULL,
+                                   _cold_index_unload_thread_callback,
+                                   NULL)) {
+        OLAP_LOG_FATAL("failed to start cold index unload thread.");
+        return OLAP_ERR_INIT_FAILED;
+    }
+
+    if (config::tablet_access_stats_decay_interval_sec > 0
+            && 0 != pthread_create(&_tablet_access_stats_thread,
+                                   NULL,
+                                   _tablet_access_stats_thread_callback,
+                                   NULL)) {
+        OLAP_LOG_FATAL("failed to start tablet access stats thread.");
+        return OLAP_ERR_INIT_FAILED;
+    }
+
     OLAP_LOG_TRACE("init finished.");
     return OLAP_SUCCESS;
 }
@@ -148,14 +191,14 @@ void* OLAPServer::_be_thread_callback(void* arg) {
         interval = 1;
     }
 
+    ScopedIoClass io_class(IO_CLASS_COMPACTION);
     string last_be_fs;
-    TTabletId last_be_tablet_id = -1;
     while (true) {
         // must be here, because this thread is start on start and
         // cgroup is not initialized at this time
         // add tid to cgroup
         CgroupsMgr::apply_system_cgroup();
-        OLAPEngine::get_instance()->start_base_expansion(&last_be_fs, &last_be_tablet_id);
+        OLAPEngine::get_instance()->start_base_expansion(&last_be_fs);
 
         usleep(interval * 1000000);
     }
@@ -253,6 +296,85 @@ void* OLAPServer::_unused_index_thread_callback(void* arg) {
     return NULL;
 }
 
+void* OLAPServer::_root_path_rebalance_thread_callback(void* arg) {
+#ifdef GOOGLE_PROFILER
+    ProfilerRegisterThread();
+#endif
+
+    uint32_t interval = config::root_path_rebalance_interval_sec;
+    AutoMutexLock l(&_s_root_path_rebalance_mutex);
+
+    while (true) {
+        _s_root_path_rebalance_cond.wait_for_seconds(interval);
+
+        TableInfo table_info(0, 0);
+        string dest_root_path;
+        TStorageMedium::type storage_medium = TStorageMedium::HDD;
+        if (!OLAPRootPath::get_instance()->get_rebalance_tablet(
+                &table_info, &dest_root_path, &storage_medium)) {
+            continue;
+        }
+
+        // 迁移过程中源tablet持续提供查询，header切换后查询转到新的root_path
+        OLAPStatus res = OLAPSnapshot::get_instance()->storage_medium_migrate(
+                table_info.tablet_id, table_info.schema_hash, storage_medium, &dest_root_path);
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to rebalance tablet. [tablet=%s dest_root_path='%s' res=%d]",
+                             table_info.to_string().c_str(), dest_root_path.c_str(), res);
+        } else {
+            OLAP_LOG_INFO("finish to rebalance tablet. [tablet=%s dest_root_path='%s']",
+                          table_info.to_string().c_str(), dest_root_path.c_str());
+        }
+    }
+
+    return NULL;
+}
+
+void* OLAPServer::_column_file_convert_thread_callback(void* arg) {
+#ifdef GOOGLE_PROFILER
+    ProfilerRegisterThread();
+#endif
+    uint32_t interval = config::column_file_convert_interval_sec;
+
+    ScopedIoClass io_class(IO_CLASS_COMPACTION);
+    while (true) {
+        sleep(interval);
+        CgroupsMgr::apply_system_cgroup();
+        OLAPEngine::get_instance()->start_column_file_convert();
+    }
+
+    return NULL;
+}
+
+void* OLAPServer::_cold_index_unload_thread_callback(void* arg) {
+#ifdef GOOGLE_PROFILER
+    ProfilerRegisterThread();
+#endif
+    // a tablet is unloaded within twice the config after its last query
+    uint32_t interval = config::cold_tablet_index_unload_sec;
+    while (true) {
+        sleep(interval);
+        OLAPEngine::get_instance()->start_unload_cold_indices();
+    }
+
+    return NULL;
+}
+
+void* OLAPServer::_tablet_access_stats_thread_callback(void* arg) {
+#ifdef GOOGLE_PROFILER
+    ProfilerRegisterThread();
+#endif
+    uint32_t interval = config::tablet_access_stats_decay_interval_sec;
+    double half_life = std::max(config::tablet_access_stats_half_life_sec, 1);
+    double factor = pow(0.5, interval / half_life);
+    while (true) {
+        sleep(interval);
+        OLAPEngine::get_instance()->decay_tablet_access_stats(factor);
+    }
+
+    return NULL;
+}
+
 void* OLAPServer::_cumulative_thread_callback(void* arg) {
 #ifdef GOOGLE_PROFILER
     ProfilerRegisterThread();
@@ -265,6 +387,7 @@ void* OLAPServer::_cumulative_thread_callback(void* arg) {
         interval = 1;
     }
 
+    ScopedIoClass io_class(IO_CLASS_COMPACTION);
     while (true) {
         // must be here, because this thread is start on start and
         // cgroup is not initialized at this time
@@ -53,6 +53,18 @@ private:
     // clean file descriptors cache
     static void* _fd_cache_clean_callback(void* arg);
 
+    // move tablets from hot root path to cold one
+    static void* _root_path_rebalance_thread_callback(void* arg);
+
+    // convert row-oriented tablets to column files
+    static void* _column_file_convert_thread_callback(void* arg);
+
+    // unload the indices of tablets not queried for a while
+    static void* _cold_index_unload_thread_callback(void* arg);
+
+    // decay the access stats of the tablets
+    static void* _tablet_access_stats_thread_callback(void* arg);
+
     // thread to monitor snapshot expiry
     pthread_t _garbage_sweeper_thread;
     static MutexLock _s_garbage_sweeper_mutex;
@@ -86,6 +98,20 @@ private:
 
     pthread_t _fd_cache_clean_thread;
 
+    // thread to rebalance load of root paths
+    pthread_t _root_path_rebalance_thread;
+    static MutexLock _s_root_path_rebalance_mutex;
+    static Condition _s_root_path_rebalance_cond;
+
+    // thread to convert row-oriented tablets
+    pthread_t _column_file_convert_thread;
+
+    // thread to unload the indices of cold tablets
+    pthread_t _cold_index_unload_thread;
+
+    // thread to decay the access stats of tablets
+    pthread_t _tablet_access_stats_thread;
+
     static atomic_t _s_request_number;
 };
 
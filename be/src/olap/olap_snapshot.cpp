@@ -17,16 +17,25 @@
 
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <iterator>
 #include <map>
 #include <set>
 
 #include <boost/date_time/gregorian/gregorian.hpp>
+#include <boost/bind.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
 
 #include "common/status.h"
 #include "olap/field.h"
@@ -45,6 +54,7 @@ using boost::filesystem::copy_option;
 using boost::filesystem::path;
 using std::map;
 using std::nothrow;
+using std::pair;
 using std::set;
 using std::string;
 using std::stringstream;
@@ -53,6 +63,9 @@ using std::list;
 
 namespace palo {
 
+// 迁移时每次拷贝并限速的数据量
+static const int64_t MIGRATE_COPY_CHUNK_SIZE = 4 * 1024 * 1024;
+
 OLAPSnapshot::OLAPSnapshot(): _base_id(0) {}
 
 OLAPSnapshot::~OLAPSnapshot() {}
@@ -159,6 +172,8 @@ void OLAPSnapshot::_update_header_file_info(
         OLAPHeader* olap_header) {
     // clear schema_change_status
     olap_header->clear_schema_change_status();
+    // cached checksums should be computed from the data of new replica
+    olap_header->clear_version_checksums();
     // remove all old version and add new version
     olap_header->delete_all_versions();
 
@@ -184,6 +199,9 @@ void OLAPSnapshot::_update_header_file_info(
                     const_cast<std::vector<std::pair<Field *, Field *> >*> \
                     (&shortest_versions[i].column_statistics));
         }
+        if (shortest_versions[i].packed) {
+            olap_header->set_packed(shortest_versions[i].version);
+        }
     }
 }
 
@@ -194,69 +212,220 @@ OLAPStatus OLAPSnapshot::_link_index_and_data_files(
     OLAPStatus res = OLAP_SUCCESS;
 
     for (const VersionEntity& entity : version_entity_vec) {
-        for (uint32_t i = 0; i < entity.num_segments; ++i) {
-            string index_path = _construct_index_file_path(
-                    header_path, entity.version, entity.version_hash, i);
-            string ref_table_index_path = ref_olap_table->construct_index_file_path(
-                    entity.version, entity.version_hash, i);
-            res = _create_hard_link(ref_table_index_path, index_path);
+        vector<string> ref_table_paths;
+        vector<string> paths;
+        OLAPTable::construct_version_file_paths(
+                ref_olap_table->header_file_name(), entity.version, entity.version_hash,
+                entity.num_segments, entity.packed, &ref_table_paths);
+        OLAPTable::construct_version_file_paths(
+                header_path, entity.version, entity.version_hash,
+                entity.num_segments, entity.packed, &paths);
+
+        for (size_t i = 0; i < paths.size(); ++i) {
+            res = _create_hard_link(ref_table_paths[i], paths[i]);
             if (res != OLAP_SUCCESS) {
                 OLAP_LOG_WARNING("fail to create hard link. [header_path=%s from_path=%s to_path=%s]",
-                        header_path.c_str(), ref_table_index_path.c_str(), index_path.c_str());
+                        header_path.c_str(), ref_table_paths[i].c_str(), paths[i].c_str());
                 return res;
             }
+        }
+    }
 
-            string data_path = _construct_data_file_path(
-                    header_path, entity.version, entity.version_hash, i);
-            string ref_table_data_path = ref_olap_table->construct_data_file_path(
-                    entity.version, entity.version_hash, i);
-            res = _create_hard_link(ref_table_data_path, data_path);
-            if (res != OLAP_SUCCESS) {
-                OLAP_LOG_WARNING("fail to create hard link. [header_path=%s from_path=%s to_path=%s]",
-                        header_path.c_str(), ref_table_data_path.c_str(), data_path.c_str());
-                return res;
+    return res;
+}
+
+// 迁移时按目标根路径限速, 同一路径上并发的拷贝共享带宽.
+// 每次拷贝前按字节数预约一段时间片, 时间片未到则等待.
+static MutexLock s_migrate_speed_limit_lock;
+static map<string, int64_t> s_migrate_next_free_time_us;
+
+static int64_t current_time_us() {
+    struct timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec * 1000000L + now.tv_usec;
+}
+
+static void acquire_migrate_bandwidth(const string& root_path, int64_t bytes) {
+    if (config::storage_medium_migrate_mbytes_per_sec <= 0) {
+        return;
+    }
+
+    int64_t cost_us = bytes / config::storage_medium_migrate_mbytes_per_sec;
+    int64_t now_us = current_time_us();
+    int64_t start_us = now_us;
+    {
+        AutoMutexLock auto_lock(&s_migrate_speed_limit_lock);
+        int64_t& next_free_time_us = s_migrate_next_free_time_us[root_path];
+        start_us = std::max(now_us, next_free_time_us);
+        next_free_time_us = start_us + cost_us;
+    }
+
+    if (start_us > now_us) {
+        usleep(start_us - now_us);
+    }
+}
+
+enum MigrateCopyMode {
+    COPY_FILE_RANGE = 0,
+    SENDFILE = 1,
+    READ_WRITE = 2
+};
+
+// 依次尝试copy_file_range, sendfile和pread/pwrite, 前两者数据不经过用户态.
+// 跨文件系统时copy_file_range可能不被支持, 此时降级到sendfile.
+static ssize_t copy_file_chunk(int src_fd, int dest_fd, int64_t offset, size_t length,
+                               MigrateCopyMode* mode, char* buf, size_t buf_size) {
+    while (true) {
+        ssize_t n = -1;
+        if (*mode == COPY_FILE_RANGE) {
+#ifdef __NR_copy_file_range
+            loff_t src_offset = offset;
+            loff_t dest_offset = offset;
+            n = syscall(__NR_copy_file_range,
+                        src_fd, &src_offset, dest_fd, &dest_offset, length, 0);
+#else
+            errno = ENOSYS;
+#endif
+        } else if (*mode == SENDFILE) {
+            off_t src_offset = offset;
+            if (lseek(dest_fd, offset, SEEK_SET) == offset) {
+                n = sendfile(dest_fd, src_fd, &src_offset, length);
+            }
+        } else {
+            n = pread(src_fd, buf, std::min(length, buf_size), offset);
+            if (n > 0) {
+                n = pwrite(dest_fd, buf, n, offset);
             }
+            return n;
+        }
+
+        if (n < 0 && errno == EINTR) {
+            continue;
         }
+        if (n <= 0 && (n == 0 || errno == ENOSYS || errno == EXDEV
+                || errno == EINVAL || errno == EOPNOTSUPP)) {
+            *mode = static_cast<MigrateCopyMode>(*mode + 1);
+            continue;
+        }
+        return n;
+    }
+}
+
+static OLAPStatus copy_file_for_migrate(const string& src_path,
+                                        const string& dest_path,
+                                        const string& dest_root_path) {
+    int src_fd = ::open(src_path.c_str(), O_RDONLY);
+    if (src_fd < 0) {
+        OLAP_LOG_WARNING("fail to open file. [file='%s' errno=%d]", src_path.c_str(), errno);
+        return OLAP_ERR_COPY_FILE_ERROR;
+    }
+    int dest_fd = ::open(dest_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, S_IRUSR | S_IWUSR);
+    if (dest_fd < 0) {
+        OLAP_LOG_WARNING("fail to open file. [file='%s' errno=%d]", dest_path.c_str(), errno);
+        ::close(src_fd);
+        return OLAP_ERR_COPY_FILE_ERROR;
+    }
+
+    OLAPStatus res = OLAP_SUCCESS;
+    struct stat src_stat;
+    if (fstat(src_fd, &src_stat) != 0) {
+        OLAP_LOG_WARNING("fail to stat file. [file='%s' errno=%d]", src_path.c_str(), errno);
+        res = OLAP_ERR_COPY_FILE_ERROR;
+    }
+
+    const size_t BUF_SIZE = 1024 * 1024;
+    std::unique_ptr<char[]> buf;
+    MigrateCopyMode mode = COPY_FILE_RANGE;
+    int64_t offset = 0;
+    while (res == OLAP_SUCCESS && offset < src_stat.st_size) {
+        size_t chunk_size = std::min<int64_t>(
+                src_stat.st_size - offset, MIGRATE_COPY_CHUNK_SIZE);
+        acquire_migrate_bandwidth(dest_root_path, chunk_size);
+
+        size_t chunk_copied = 0;
+        while (chunk_copied < chunk_size) {
+            if (mode == READ_WRITE && buf == nullptr) {
+                buf.reset(new char[BUF_SIZE]);
+            }
+            ssize_t n = copy_file_chunk(src_fd, dest_fd, offset, chunk_size - chunk_copied,
+                                        &mode, buf.get(), BUF_SIZE);
+            if (n <= 0) {
+                OLAP_LOG_WARNING("fail to copy file. [src='%s' dest='%s' offset=%ld errno=%d]",
+                                 src_path.c_str(), dest_path.c_str(), offset, errno);
+                res = OLAP_ERR_COPY_FILE_ERROR;
+                break;
+            }
+            offset += n;
+            chunk_copied += n;
+        }
+    }
+
+    // 切换header之前数据必须已经落盘
+    if (res == OLAP_SUCCESS && fdatasync(dest_fd) != 0) {
+        OLAP_LOG_WARNING("fail to sync file. [file='%s' errno=%d]", dest_path.c_str(), errno);
+        res = OLAP_ERR_COPY_FILE_ERROR;
     }
 
+    ::close(src_fd);
+    ::close(dest_fd);
     return res;
 }
 
+static void copy_files_for_migrate_worker(
+        const vector<pair<string, string> >* files,
+        const string* dest_root_path,
+        std::atomic<size_t>* next_file_index,
+        std::atomic<bool>* copy_failed) {
+    while (!*copy_failed) {
+        size_t index = next_file_index->fetch_add(1);
+        if (index >= files->size()) {
+            break;
+        }
+
+        const pair<string, string>& file = (*files)[index];
+        if (copy_file_for_migrate(file.first, file.second, *dest_root_path) != OLAP_SUCCESS) {
+            *copy_failed = true;
+        }
+    }
+}
+
 OLAPStatus OLAPSnapshot::_copy_index_and_data_files(
         const string& header_path,
         const SmartOLAPTable& ref_olap_table,
-        vector<VersionEntity>& version_entity_vec) {
+        const string& dest_root_path,
+        const vector<VersionEntity>& version_entity_vec) {
+    vector<pair<string, string> > files;
     for (const VersionEntity& entity : version_entity_vec) {
-        for (uint32_t i = 0; i < entity.num_segments; ++i) {
-            string index_path;
-            string data_path;
-            string ref_table_index_path;
-            string ref_table_data_path;
-
-            index_path = _construct_index_file_path(
-                    header_path, entity.version, entity.version_hash, i);
-            ref_table_index_path = ref_olap_table->construct_index_file_path(
-                    entity.version, entity.version_hash, i);
-            Status status = FileUtils::copy_file(ref_table_index_path, index_path);
-            if (!status.ok()) {
-                OLAP_LOG_WARNING("fail to copy file. [src='%s' dest='%s']",
-                        ref_table_index_path.c_str(), index_path.c_str());
-                return OLAP_ERR_COPY_FILE_ERROR;
-            }
-            data_path = _construct_data_file_path(
-                    header_path, entity.version, entity.version_hash, i);
-            ref_table_data_path = ref_olap_table->construct_data_file_path(
-                    entity.version, entity.version_hash, i);
-            status = FileUtils::copy_file(ref_table_data_path, data_path);
-            if (!status.ok()) {
-                OLAP_LOG_WARNING("fail to copy file. [src='%s' dest='%s']",
-                        ref_table_data_path.c_str(), data_path.c_str());
-                return OLAP_ERR_COPY_FILE_ERROR;
-            }
+        vector<string> ref_table_paths;
+        vector<string> paths;
+        OLAPTable::construct_version_file_paths(
+                ref_olap_table->header_file_name(), entity.version, entity.version_hash,
+                entity.num_segments, entity.packed, &ref_table_paths);
+        OLAPTable::construct_version_file_paths(
+                header_path, entity.version, entity.version_hash,
+                entity.num_segments, entity.packed, &paths);
+        for (size_t i = 0; i < paths.size(); ++i) {
+            files.push_back(std::make_pair(ref_table_paths[i], paths[i]));
         }
     }
 
-    return OLAP_SUCCESS;
+    std::atomic<size_t> next_file_index(0);
+    std::atomic<bool> copy_failed(false);
+    size_t thread_num = std::min<size_t>(
+            std::max(config::storage_medium_migrate_copy_thread_num, 1), files.size());
+    if (thread_num <= 1) {
+        copy_files_for_migrate_worker(&files, &dest_root_path, &next_file_index, &copy_failed);
+    } else {
+        boost::thread_group copy_threads;
+        for (size_t i = 0; i < thread_num; ++i) {
+            copy_threads.create_thread(boost::bind(
+                    &copy_files_for_migrate_worker,
+                    &files, &dest_root_path, &next_file_index, &copy_failed));
+        }
+        copy_threads.join_all();
+    }
+
+    return copy_failed ? OLAP_ERR_COPY_FILE_ERROR : OLAP_SUCCESS;
 }
 
 OLAPStatus OLAPSnapshot::_create_snapshot_files(
@@ -324,10 +493,24 @@ OLAPStatus OLAPSnapshot::_create_snapshot_files(
             version = request.version;
         }
 
-        // get shortest version path
+        // get shortest version path, or only the missing single deltas for incremental clone
         vector<Version> shortest_path;
         vector<VersionEntity> shortest_versions;
-        res = ref_olap_table->select_versions_to_span(Version(0, version), &shortest_path);
+        if (request.__isset.missing_version) {
+            for (int64_t missing_version : request.missing_version) {
+                Version delta(missing_version, missing_version);
+                if (missing_version > version || !ref_olap_table->has_version(delta)) {
+                    OLAP_LOG_WARNING("missing version is not a single delta of table. "
+                            "[table='%s' version=%ld]",
+                            ref_olap_table->full_name().c_str(), missing_version);
+                    res = OLAP_ERR_VERSION_NOT_EXIST;
+                    break;
+                }
+                shortest_path.push_back(delta);
+            }
+        } else {
+            res = ref_olap_table->select_versions_to_span(Version(0, version), &shortest_path);
+        }
         if (res != OLAP_SUCCESS) {
             OLAP_LOG_WARNING("fail to select versions to span. [res=%d]", res);
             break;
@@ -380,7 +563,7 @@ OLAPStatus OLAPSnapshot::_create_snapshot_files(
         }
 
         // append a single delta if request.version is end_version of cumulative delta
-        if (request.__isset.version) {
+        if (request.__isset.version && !request.__isset.missing_version) {
             for (const VersionEntity& entity : shortest_versions) {
                 if (entity.version.second == request.version) {
                     if (entity.version.first != request.version) {
@@ -461,22 +644,6 @@ OLAPStatus OLAPSnapshot::_append_single_delta(const TSnapshotRequest& request, c
     return res;
 }
 
-string OLAPSnapshot::_construct_index_file_path(
-        const string& header_path,
-        const Version& version,
-        VersionHash version_hash,
-        uint32_t segment) const {
-    return OLAPTable::construct_file_path(header_path, version, version_hash, segment, "idx");
-}
-
-string OLAPSnapshot::_construct_data_file_path(
-        const string& header_path,
-        const Version& version,
-        VersionHash version_hash,
-        uint32_t segment) const {
-    return OLAPTable::construct_file_path(header_path, version, version_hash, segment, "dat");
-}
-
 OLAPStatus OLAPSnapshot::_create_hard_link(const string& from_path, const string& to_path) {
     if (link(from_path.c_str(), to_path.c_str()) == 0) {
         OLAP_LOG_TRACE("success to create hard link from path=%s to path=%s]",
@@ -491,7 +658,8 @@ OLAPStatus OLAPSnapshot::_create_hard_link(const string& from_path, const string
 
 OLAPStatus OLAPSnapshot::storage_medium_migrate(
         TTabletId tablet_id, TSchemaHash schema_hash,
-        TStorageMedium::type storage_medium) {
+        TStorageMedium::type storage_medium,
+        const string* dest_root_path) {
     OLAPStatus res = OLAP_SUCCESS;
     SmartOLAPTable tablet = OLAPEngine::get_instance()->get_table(tablet_id, schema_hash);
     if (tablet.get() == NULL) {
@@ -502,7 +670,13 @@ OLAPStatus OLAPSnapshot::storage_medium_migrate(
 
     // judge case when no need to migrate
     uint32_t count = OLAPRootPath::get_instance()->available_storage_medium_type_count();
-    if (count <= 1) {
+    if (dest_root_path != NULL) {
+        if (*dest_root_path == tablet->storage_root_path_name()) {
+            OLAP_LOG_INFO("tablet is already on specified root path. [root_path='%s']",
+                          dest_root_path->c_str());
+            return OLAP_SUCCESS;
+        }
+    } else if (count <= 1) {
         OLAP_LOG_INFO("available storage medium type count is less than 1, "
                 "no need to migrate. [count=%u]", count);
         return OLAP_SUCCESS;
@@ -513,14 +687,15 @@ OLAPStatus OLAPSnapshot::storage_medium_migrate(
         src_storage_medium = TStorageMedium::SSD;
     }
 
-    if (src_storage_medium == storage_medium) {
+    if (dest_root_path == NULL && src_storage_medium == storage_medium) {
         OLAP_LOG_INFO("tablet is already on specified storage medium. "
                 "[storage_medium='%d']", storage_medium);
         return OLAP_SUCCESS;
     }
 
     vector<IData*> olap_data_sources;
-    tablet->obtain_push_lock();
+    vector<IData*> new_olap_data_sources;
+    bool push_locked = false;
 
     do {
         // get all versions to be migrate
@@ -549,7 +724,16 @@ OLAPStatus OLAPSnapshot::storage_medium_migrate(
 
         // generate schema hash path where files will be migrated
         vector<string> root_path_vec;
-        OLAPRootPath::get_instance()->get_root_path_for_create_table(storage_medium, &root_path_vec);
+        if (dest_root_path != NULL) {
+            bool is_used = false;
+            OLAPRootPath::get_instance()->get_root_path_used_stat(*dest_root_path, &is_used);
+            if (is_used) {
+                root_path_vec.push_back(*dest_root_path);
+            }
+        } else {
+            OLAPRootPath::get_instance()->get_root_path_for_create_table(
+                    storage_medium, &root_path_vec);
+        }
         if (root_path_vec.size() == 0) {
             res = OLAP_ERR_INVALID_ROOT_PATH;
             OLAP_LOG_WARNING("fail to get root path for create tablet.");
@@ -573,22 +757,93 @@ OLAPStatus OLAPSnapshot::storage_medium_migrate(
         }
         create_dirs(schema_hash_path);
 
-        // migrate all index and data files but header file
+        // migrate all index and data files but header file. The tablet keeps
+        // serving loads and queries on the source path while copying.
         string new_header_path = _get_header_full_path(tablet, schema_hash_path);
-        res = _copy_index_and_data_files(new_header_path, tablet, version_entity_vec);
+        res = _copy_index_and_data_files(
+                new_header_path, tablet, root_path_vec[0], version_entity_vec);
         if (res != OLAP_SUCCESS) {
             OLAP_LOG_WARNING("fail to copy index and data files when migrate. [res=%d]", res);
             break;
         }
 
-        // generate new header file from the old
-        res = _generate_new_header(tablet, new_header_path, version_entity_vec);
+        // 拷贝期间导入或合并产生的版本在push锁内补齐, 之后旧表不会再有新的导入
+        tablet->obtain_push_lock();
+        push_locked = true;
+
+        vector<VersionEntity> latest_entity_vec;
+        vector<VersionEntity> missing_entity_vec;
+        vector<Version> missing_versions;
+        tablet->obtain_header_rdlock();
+        tablet->list_version_entities(&latest_entity_vec);
+        for (const VersionEntity& entity : latest_entity_vec) {
+            bool copied = false;
+            for (const VersionEntity& copied_entity : version_entity_vec) {
+                if (copied_entity.version == entity.version
+                        && copied_entity.version_hash == entity.version_hash) {
+                    copied = true;
+                    break;
+                }
+            }
+            if (!copied) {
+                missing_entity_vec.push_back(entity);
+                missing_versions.push_back(entity.version);
+            }
+        }
+        if (!missing_versions.empty()) {
+            tablet->acquire_data_sources_by_versions(missing_versions, &new_olap_data_sources);
+        }
+        tablet->release_header_lock();
+
+        if (new_olap_data_sources.size() != missing_versions.size()) {
+            res = OLAP_ERR_VERSION_NOT_EXIST;
+            OLAP_LOG_WARNING("fail to acquire data souces of new versions. [tablet='%s']",
+                    tablet->full_name().c_str());
+            break;
+        }
+
+        res = _copy_index_and_data_files(
+                new_header_path, tablet, root_path_vec[0], missing_entity_vec);
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to copy new index and data files when migrate. [res=%d]",
+                             res);
+            break;
+        }
+        OLAP_LOG_INFO("copy new versions after migrate copying. [tablet='%s' new_versions=%lu]",
+                      tablet->full_name().c_str(), missing_versions.size());
+
+        // 拷贝期间被合并掉的版本不会出现在新的header中, 删除其已拷贝的文件
+        for (const VersionEntity& copied_entity : version_entity_vec) {
+            bool merged = true;
+            for (const VersionEntity& entity : latest_entity_vec) {
+                if (copied_entity.version == entity.version
+                        && copied_entity.version_hash == entity.version_hash) {
+                    merged = false;
+                    break;
+                }
+            }
+            if (!merged) {
+                continue;
+            }
+            vector<string> copied_paths;
+            OLAPTable::construct_version_file_paths(
+                    new_header_path, copied_entity.version, copied_entity.version_hash,
+                    copied_entity.num_segments, copied_entity.packed, &copied_paths);
+            for (const string& copied_path : copied_paths) {
+                remove(copied_path.c_str());
+            }
+        }
+
+        // generate new header file from the old, versions merged while copying
+        // are not in the new header, and will not be loaded
+        res = _generate_new_header(tablet, new_header_path, latest_entity_vec);
         if (res != OLAP_SUCCESS) {
             OLAP_LOG_WARNING("fail to generate new header file from the old. [res=%d]", res);
             break;
         }
 
-        // load the new tablet into OLAPEngine
+        // load the new tablet into OLAPEngine, queries are switched to the new
+        // tablet once it replaces the old one in OLAPEngine
         res = OLAPEngine::get_instance()->load_one_tablet(
                 tablet_id, schema_hash, schema_hash_path);
         if (res != OLAP_SUCCESS) {
@@ -603,7 +858,8 @@ OLAPStatus OLAPSnapshot::storage_medium_migrate(
         if (new_tablet.get() == NULL) {
             OLAP_LOG_WARNING("get null olap table. [tablet_id=%ld schema_hash=%d]",
                              tablet_id, schema_hash);
-            return OLAP_ERR_TABLE_NOT_FOUND;
+            res = OLAP_ERR_TABLE_NOT_FOUND;
+            break;
         }
         SchemaChangeStatus tablet_status = tablet->schema_change_status();
         if (tablet->schema_change_status().status == AlterTableStatus::ALTER_TABLE_DONE) {
@@ -617,8 +873,11 @@ OLAPStatus OLAPSnapshot::storage_medium_migrate(
         }
     } while (0);
 
-    tablet->release_push_lock();
+    if (push_locked) {
+        tablet->release_push_lock();
+    }
     tablet->release_data_sources(&olap_data_sources);
+    tablet->release_data_sources(&new_olap_data_sources);
 
     return res;
 }
@@ -47,10 +47,13 @@ public:
     OLAPStatus release_snapshot(const std::string& snapshot_path);
 
     // @brief 迁移数据，从一种存储介质到另一种存储介质
+    // @param dest_root_path [in] 指定迁移的目标root_path，为NULL时按存储介质选择，
+    //                            用于在同一种存储介质的磁盘之间均衡负载
     OLAPStatus storage_medium_migrate(
             TTabletId tablet_id,
             TSchemaHash schema_hash,
-            TStorageMedium::type storage_medium);
+            TStorageMedium::type storage_medium,
+            const std::string* dest_root_path = NULL);
 
 private:
 
@@ -75,10 +78,13 @@ private:
             const SmartOLAPTable& ref_olap_table,
             const std::vector<VersionEntity>& version_entity_vec);
 
+    // Copy files of versions in parallel, the copy speed to dest_root_path is
+    // limited by config::storage_medium_migrate_mbytes_per_sec.
     OLAPStatus _copy_index_and_data_files(
             const std::string& header_path,
             const SmartOLAPTable& ref_olap_table,
-            std::vector<VersionEntity>& version_entity_vec);
+            const std::string& dest_root_path,
+            const std::vector<VersionEntity>& version_entity_vec);
 
     OLAPStatus _create_snapshot_files(
             const SmartOLAPTable& ref_olap_table,
@@ -89,18 +95,6 @@ private:
             const TSnapshotRequest& request,
             const std::string& header_path);
 
-    std::string _construct_index_file_path(
-            const std::string& header_path,
-            const Version& version,
-            VersionHash version_hash,
-            uint32_t segment) const;
-
-    std::string _construct_data_file_path(
-            const std::string& header_path,
-            const Version& version,
-            VersionHash version_hash,
-            uint32_t segment) const;
-
     OLAPStatus _generate_new_header(
             const SmartOLAPTable& tablet,
             const std::string& new_header_path,
@@ -25,6 +25,7 @@
 
 #include <boost/filesystem.hpp>
 
+#include "olap/column_file/segment_reader.h"
 #include "olap/field.h"
 #include "olap/i_data.h"
 #include "olap/olap_common.h"
@@ -47,6 +48,9 @@ using boost::filesystem::path;
 
 namespace palo {
 
+// split_range时每个区间的取样次数, 取样越多区间的行数越接近请求的行数
+static const uint64_t SPLIT_SAMPLES_PER_RANGE = 4;
+
 OLAPTable* OLAPTable::create_from_header_file(
         TTabletId tablet_id, TSchemaHash schema_hash, const string& header_file) {
     OLAPHeader* olap_header = NULL;
@@ -94,7 +98,9 @@ OLAPTable::OLAPTable(OLAPHeader* header) :
         _num_null_fields(0),
         _num_key_fields(0),
         _id(0),
-        _is_loaded(false) {
+        _is_loaded(false),
+        _query_count(0),
+        _last_query_time(time(NULL)) {
     if (header == NULL) {
         return;  // for convenience of mock test.
     }
@@ -155,6 +161,7 @@ OLAPTable::OLAPTable(OLAPHeader* header) :
         }
 
         field_info.is_bf_column = header->column(i).is_bf_column();
+        field_info.is_blocked_bf = header->column(i).is_blocked_bf();
 
         _tablet_schema.push_back(field_info);
         // field name --> field position in full row.
@@ -248,6 +255,12 @@ OLAPStatus OLAPTable::load() {
         goto EXIT;
     }
 
+    if (is_merge_on_write()) {
+        obtain_header_wrlock();
+        _load_delete_bitmap();
+        release_header_lock();
+    }
+
     // delete unused files
     obtain_header_rdlock();
     list_index_files(&index_files);
@@ -297,9 +310,16 @@ OLAPStatus OLAPTable::load_indices() {
             release_header_lock();
             return OLAP_ERR_MALLOC_ERROR;
         }
+        index->set_packed(header->file_version(i).packed());
 
         // 在校验和加载索引前把index放到data-source，以防止加载索引失败造成内存泄露
         _data_sources[version] = index;
+        // 旧的header中没有记录num_rows, 这类版本的index不能延迟加载
+        if (header->file_version(i).has_num_rows()) {
+            index->set_header_statistics(header->file_version(i).index_size(),
+                                         header->file_version(i).data_size(),
+                                         header->file_version(i).num_rows());
+        }
         // 判断index是否正常, 在所有版本的都检查完成之后才加载所有版本的index
         if (index->validate() != OLAP_SUCCESS) {
             OLAP_LOG_WARNING("fail to validate index. [version='%d-%d' version_hash=%ld]",
@@ -350,6 +370,11 @@ OLAPStatus OLAPTable::load_indices() {
         Version version = it->first;
         OLAPIndex* index = it->second;
 
+        // 启动时只校验文件头, 索引在第一次访问时加载
+        if (config::enable_lazy_index_load && index->has_header_statistics()) {
+            continue;
+        }
+
         if ((res = index->load()) != OLAP_SUCCESS) {
             OLAP_LOG_WARNING("fail to load index. [version='%d-%d' version_hash=%ld]",
                              version.first,
@@ -426,6 +451,15 @@ void OLAPTable::acquire_data_sources_by_versions(const vector<Version>& version_
         }
 
         OLAPIndex* olap_index = it2->second;
+        if (olap_index->load() != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to load index. [version='%d-%d' table='%s']",
+                             it1->first,
+                             it1->second,
+                             full_name().c_str());
+            release_data_sources(sources);
+            return;
+        }
+
         IData* olap_data = IData::create(olap_index);
         if (olap_data == NULL) {
             OLAP_LOG_WARNING("fail to malloc Data. [version='%d-%d' table='%s']",
@@ -502,6 +536,20 @@ OLAPStatus OLAPTable::register_data_source(OLAPIndex* index) {
         return res;
     }
 
+    if (!index->column_sketches().empty()) {
+        res = _header->set_column_sketches(version, index->column_sketches());
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
+    }
+
+    if (index->packed()) {
+        res = _header->set_packed(version);
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
+    }
+
     // put the new index into _data_sources.
     // 由于对header的操作可能失败，因此对_data_sources要放在这里
     _data_sources[version] = index;
@@ -539,6 +587,7 @@ OLAPStatus OLAPTable::unregister_data_source(const Version& version, OLAPIndex**
 
     *index = it->second;
     _data_sources.erase(it);
+    _update_delete_bitmap(vector<Version>(1, version), vector<OLAPIndex*>());
 
     OLAP_LOG_DEBUG("unregister data source success. "
                    "[version='%d-%d' version_hash=%ld num_segments=%d table='%s']",
@@ -650,15 +699,316 @@ OLAPStatus OLAPTable::replace_data_sources(const vector<Version>* old_versions,
             return res;
         }
 
+        if (!(*it)->column_sketches().empty()) {
+            res = _header->set_column_sketches((*it)->version(), (*it)->column_sketches());
+            if (res != OLAP_SUCCESS) {
+                return res;
+            }
+        }
+
+        if ((*it)->packed()) {
+            res = _header->set_packed((*it)->version());
+            if (res != OLAP_SUCCESS) {
+                return res;
+            }
+        }
+
         OLAP_LOG_TRACE("add version to olap header.[version='%d-%d' table='%s']",
                        (*it)->version().first,
                        (*it)->version().second,
                        full_name().c_str());
     }
 
+    _update_delete_bitmap(*old_versions, *new_data_sources);
     return OLAP_SUCCESS;
 }
 
+bool OLAPTable::is_merge_on_write() const {
+    return config::enable_unique_key_merge_on_write
+            && keys_type() == KeysType::UNIQUE_KEYS
+            && data_file_type() == COLUMN_ORIENTED_FILE;
+}
+
+bool OLAPTable::apply_delete_bitmap(const Version& version,
+                                    const vector<IData*>& sources) const {
+    if (!is_merge_on_write()) {
+        return false;
+    }
+
+    // the base version has no older version whose rows it replaces
+    for (IData* source : sources) {
+        if (source->version().first != 0 && !_delete_bitmap.is_marked(source->version())) {
+            return false;
+        }
+    }
+
+    DeleteBitmap::DeletedRows deleted_rows;
+    for (IData* source : sources) {
+        _delete_bitmap.get_deleted_rows(source->version(), version.second, &deleted_rows);
+        source->set_deleted_rows(deleted_rows);
+    }
+    return true;
+}
+
+void OLAPTable::_load_delete_bitmap() {
+    OLAPStatus res = _delete_bitmap.load(_delete_bitmap_file_name());
+    if (res != OLAP_SUCCESS) {
+        if (res != OLAP_ERR_FILE_NOT_EXIST) {
+            OLAP_LOG_WARNING("fail to load delete bitmap, versions are merged when read. "
+                             "[res=%d table='%s']", res, full_name().c_str());
+        }
+        return;
+    }
+
+    vector<Version> versions;
+    list_versions(&versions);
+    _delete_bitmap.prune(versions);
+}
+
+void OLAPTable::_update_delete_bitmap(const vector<Version>& old_versions,
+                                      const vector<OLAPIndex*>& new_indices) {
+    if (!is_merge_on_write()) {
+        return;
+    }
+
+    vector<OLAPIndex*> indices(new_indices);
+    sort(indices.begin(), indices.end(), [](OLAPIndex* a, OLAPIndex* b) {
+        return a->version() < b->version();
+    });
+
+    // A new version made of old versions which are all marked is marked as well. The
+    // rows of older versions they replace are recorded already, and its own rows are
+    // merged when it is made.
+    map<Version, bool> is_compaction;
+    map<Version, bool> is_inherited;
+    for (OLAPIndex* index : indices) {
+        const Version& version = index->version();
+        bool has_input = false;
+        bool is_marked = true;
+        for (const Version& old_version : old_versions) {
+            if (old_version != version && old_version.first >= version.first
+                    && old_version.second <= version.second) {
+                has_input = true;
+                is_marked = is_marked && (old_version.first == 0
+                        || _delete_bitmap.is_marked(old_version));
+            }
+        }
+        is_compaction[version] = has_input;
+        is_inherited[version] = has_input && is_marked;
+    }
+
+    for (const Version& old_version : old_versions) {
+        bool is_compacted = false;
+        for (OLAPIndex* index : indices) {
+            const Version& version = index->version();
+            if (old_version != version && old_version.first >= version.first
+                    && old_version.second <= version.second) {
+                is_compacted = true;
+                break;
+            }
+        }
+
+        // A version removed without being compacted into a new one no longer replaces
+        // any row. The newer versions might have stopped looking up a key in it, and
+        // have to be merged until they are compacted.
+        if (!is_compacted) {
+            _delete_bitmap.remove_deleted_by(old_version);
+            for (auto& it : _data_sources) {
+                if (it.first.first > old_version.second) {
+                    _delete_bitmap.clear_marked(it.first);
+                }
+            }
+        }
+        _delete_bitmap.remove_version(old_version);
+    }
+
+    for (OLAPIndex* index : indices) {
+        const Version& version = index->version();
+        if (version.first == 0 || is_inherited[version]) {
+            _delete_bitmap.set_marked(version);
+        } else if (static_cast<int64_t>(index->num_rows())
+                <= config::merge_on_write_max_lookup_rows) {
+            vector<OLAPIndex*> targets;
+            for (auto& it : _data_sources) {
+                if (it.first.second < version.first) {
+                    targets.push_back(it.second);
+                }
+            }
+            sort(targets.begin(), targets.end(), [](OLAPIndex* a, OLAPIndex* b) {
+                return a->version() > b->version();
+            });
+
+            OLAPStatus res = _lookup_keys(index, targets);
+            if (res == OLAP_SUCCESS) {
+                _delete_bitmap.set_marked(version);
+            } else {
+                OLAP_LOG_WARNING("fail to look up keys, the version is merged when read. "
+                                 "[res=%d version='%d-%d' table='%s']",
+                                 res, version.first, version.second, full_name().c_str());
+            }
+        }
+
+        if (!is_compaction[version]) {
+            continue;
+        }
+
+        // the newer versions looked up their keys in the versions compacted into it
+        vector<OLAPIndex*> targets(1, index);
+        vector<Version> newer_versions;
+        for (auto& it : _data_sources) {
+            if (it.first.first > version.second && _delete_bitmap.is_marked(it.first)) {
+                newer_versions.push_back(it.first);
+            }
+        }
+        sort(newer_versions.begin(), newer_versions.end());
+        for (const Version& newer_version : newer_versions) {
+            OLAPStatus res = _lookup_keys(_data_sources[newer_version], targets);
+            if (res != OLAP_SUCCESS) {
+                OLAP_LOG_WARNING("fail to look up keys, the version is merged when read. "
+                                 "[res=%d version='%d-%d' table='%s']",
+                                 res, newer_version.first, newer_version.second,
+                                 full_name().c_str());
+                _delete_bitmap.clear_marked(newer_version);
+            }
+        }
+    }
+
+    // A stale bitmap might mark a version whose replaced rows are not all recorded,
+    // while no bitmap just gets the versions merged.
+    string file_name = _delete_bitmap_file_name();
+    if (_delete_bitmap.save(file_name) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to save delete bitmap. [table='%s']", full_name().c_str());
+        if (check_dir_existed(file_name) && remove(file_name.c_str()) != 0) {
+            OLAP_LOG_WARNING("fail to remove delete bitmap. [file='%s' err=%m]",
+                             file_name.c_str());
+        }
+    }
+}
+
+// whether the first key column of 'key' is in the range of the index
+static bool may_contain_key(OLAPIndex* index, const RowCursor& key) {
+    if (!index->has_column_statistics() || index->get_column_statistics().empty()) {
+        return true;
+    }
+
+    const std::pair<Field*, Field*>& range = index->get_column_statistics()[0];
+    const Field* field = key.get_field_by_index(0);
+    if (range.first == NULL || range.second == NULL || field->is_null()) {
+        return true;
+    }
+    return field->cmp(range.first) >= 0 && field->cmp(range.second) <= 0;
+}
+
+OLAPStatus OLAPTable::_lookup_keys(OLAPIndex* index, const vector<OLAPIndex*>& targets) {
+    OLAPStatus res = OLAP_SUCCESS;
+    vector<uint32_t> key_columns;
+    for (uint32_t i = 0; i < _num_key_fields; ++i) {
+        key_columns.push_back(i);
+    }
+    set<uint32_t> load_bf_columns;
+    Conditions conditions;
+    vector<RowCursor*> no_keys;
+
+    // sources[0] reads 'index', the others read the targets
+    vector<OLAPIndex*> indices(1, index);
+    for (OLAPIndex* target : targets) {
+        if (!target->empty()) {
+            indices.push_back(target);
+        }
+    }
+
+    vector<IData*> sources;
+    for (OLAPIndex* olap_index : indices) {
+        if (OLAP_SUCCESS != (res = olap_index->load())) {
+            break;
+        }
+        IData* olap_data = IData::create(olap_index);
+        if (NULL == olap_data) {
+            res = OLAP_ERR_MALLOC_ERROR;
+            break;
+        }
+        sources.push_back(olap_data);
+        if (OLAP_SUCCESS != (res = olap_data->init())) {
+            break;
+        }
+        olap_data->set_read_params(key_columns, load_bf_columns, conditions,
+                                   no_keys, no_keys, false, NULL);
+    }
+
+    RowCursor last_key;
+    if (res == OLAP_SUCCESS) {
+        res = last_key.init(_tablet_schema, _num_key_fields);
+    }
+    if (res != OLAP_SUCCESS) {
+        release_data_sources(&sources);
+        return res;
+    }
+
+    Version version = index->version();
+    IData* source = sources[0];
+    bool has_last_key = false;
+    uint32_t last_segment = 0;
+    uint64_t last_row_id = 0;
+    for (const RowCursor* row = source->get_first_row();
+            row != NULL; row = source->get_next_row()) {
+        uint32_t segment = 0;
+        uint64_t row_id = 0;
+        if (OLAP_SUCCESS != (res = source->get_current_row_position(&segment, &row_id))) {
+            break;
+        }
+
+        if (has_last_key && row->cmp(last_key) == 0) {
+            _delete_bitmap.add(version, last_segment, last_row_id, version.second);
+        } else {
+            // the newest target with the key holds its only row not replaced yet
+            for (size_t i = 1; i < sources.size(); ++i) {
+                IData* target = sources[i];
+                if (!may_contain_key(target->olap_index(), *row)) {
+                    continue;
+                }
+
+                const RowCursor* found = target->find_row(*row, false, false);
+                if (found == NULL && !target->eof()) {
+                    res = OLAP_ERR_READER_READING_ERROR;
+                    break;
+                }
+
+                bool is_found = false;
+                while (found != NULL && found->cmp(*row) == 0) {
+                    uint32_t target_segment = 0;
+                    uint64_t target_row_id = 0;
+                    res = target->get_current_row_position(&target_segment, &target_row_id);
+                    if (res != OLAP_SUCCESS) {
+                        break;
+                    }
+                    _delete_bitmap.add(target->version(), target_segment, target_row_id,
+                                       version.second);
+                    is_found = true;
+                    found = target->get_next_row();
+                }
+                if (res != OLAP_SUCCESS || is_found) {
+                    break;
+                }
+            }
+            if (res != OLAP_SUCCESS) {
+                break;
+            }
+        }
+
+        last_key.copy(*row);
+        has_last_key = true;
+        last_segment = segment;
+        last_row_id = row_id;
+    }
+
+    if (res == OLAP_SUCCESS && !source->eof()) {
+        res = OLAP_ERR_READER_READING_ERROR;
+    }
+
+    release_data_sources(&sources);
+    return res;
+}
+
 OLAPStatus OLAPTable::compute_all_versions_hash(const vector<Version>& versions,
                                                 VersionHash* version_hash) const {
     if (version_hash == NULL) {
@@ -799,6 +1149,11 @@ OLAPStatus OLAPTable::split_range(
         return OLAP_SUCCESS;
     }
 
+    if (base_index->load() != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to load index. [table='%s']", full_name().c_str());
+        return OLAP_ERR_INDEX_LOAD_ERROR;
+    }
+
     uint64_t expected_rows = request_block_row_count
             / base_index->current_num_rows_per_row_block();
     if (expected_rows == 0) {
@@ -807,6 +1162,64 @@ OLAPStatus OLAPTable::split_range(
         return OLAP_ERR_TABLE_NOT_FOUND;
     }
 
+    // 只按base index切分时, delta中的数据集中在某些key区间会导致各区间行数相差很大.
+    // 这里把当前版本路径上的其他index也纳入估计: 每个切分点在各index中定位到的
+    // row block数乘以该index平均每个block的行数, 累加得到区间在所有版本中的行数.
+    std::vector<OLAPIndex*> other_indices;
+    std::vector<double> other_rows_per_block;
+    std::vector<RowBlockPosition> other_positions;
+    std::vector<bool> other_exhausted;
+    double base_rows_per_block = 0;
+    uint64_t total_rows = 0;
+    if (_get_rows_per_block(base_index, &base_rows_per_block) == OLAP_SUCCESS) {
+        total_rows = base_index->num_rows();
+    }
+
+    const FileVersionMessage* latest = latest_version();
+    std::vector<Version> span_versions;
+    if (latest != NULL && base_rows_per_block > 0
+            && _header->select_versions_to_span(
+                    Version(0, latest->end_version()), &span_versions) == OLAP_SUCCESS) {
+        for (const Version& version : span_versions) {
+            version_olap_index_map_t::iterator it = _data_sources.find(version);
+            if (it == _data_sources.end() || it->second == base_index
+                    || it->second->empty() || it->second->load() != OLAP_SUCCESS) {
+                continue;
+            }
+
+            OLAPIndex* index = it->second;
+            double rows_per_block = 0;
+            RowBlockPosition pos;
+            if (_get_rows_per_block(index, &rows_per_block) != OLAP_SUCCESS) {
+                continue;
+            }
+            bool exhausted = false;
+            if (index->find_short_key(start_key, &helper_cursor, false, &pos) != OLAP_SUCCESS) {
+                // startkey比该版本的所有数据都大, 该版本不会贡献任何行
+                if (index->find_last_row_block(&pos) != OLAP_SUCCESS) {
+                    continue;
+                }
+                exhausted = true;
+            }
+
+            other_indices.push_back(index);
+            other_rows_per_block.push_back(rows_per_block);
+            other_positions.push_back(pos);
+            other_exhausted.push_back(exhausted);
+            total_rows += index->num_rows();
+        }
+    }
+
+    // 每个区间在base index中大约跨越的block数, 按base所占的行数比例缩小;
+    // 每个区间取样SPLIT_SAMPLES_PER_RANGE次, 使区间的实际行数接近请求的行数
+    uint64_t step_blocks = expected_rows;
+    if (total_rows > 0 && !other_indices.empty()) {
+        step_blocks = static_cast<uint64_t>(
+                static_cast<double>(request_block_row_count) / base_rows_per_block
+                * base_index->num_rows() / total_rows);
+        step_blocks = std::max<uint64_t>(1, step_blocks / SPLIT_SAMPLES_PER_RANGE);
+    }
+
     // 找到startkey对应的起始位置
     if (base_index->find_short_key(start_key, &helper_cursor, false, &start_pos) != OLAP_SUCCESS) {
         if (base_index->find_first_row_block(&start_pos) != OLAP_SUCCESS) {
@@ -849,8 +1262,10 @@ OLAPStatus OLAPTable::split_range(
     // start_key是last start_key, 但返回的实际上是查询层给出的key
     ranges->push_back(start_key.to_string_vector());
 
+    RowBlockPosition last_step_pos = step_pos;
+    double estimated_rows = 0;
     while (end_pos > step_pos) {
-        res = base_index->advance_row_block(expected_rows, &step_pos);
+        res = base_index->advance_row_block(step_blocks, &step_pos);
         if (res == OLAP_ERR_INDEX_EOF || !(end_pos > step_pos)) {
             break;
         } else if (res != OLAP_SUCCESS) {
@@ -864,10 +1279,40 @@ OLAPStatus OLAPTable::split_range(
         }
         cur_start_key.attach(entry.data, entry.length);
 
-        if (cur_start_key.cmp(last_start_key) != 0) {
+        if (other_indices.empty()) {
+            estimated_rows = request_block_row_count;
+        } else {
+            estimated_rows += base_index->compute_distance(last_step_pos, step_pos)
+                    * base_rows_per_block;
+            last_step_pos = step_pos;
+            for (size_t i = 0; i < other_indices.size(); ++i) {
+                if (other_exhausted[i]) {
+                    continue;
+                }
+                RowBlockPosition pos;
+                uint32_t num_blocks = 0;
+                if (other_indices[i]->find_short_key(
+                        cur_start_key, &helper_cursor, false, &pos) == OLAP_SUCCESS) {
+                    num_blocks = other_indices[i]->compute_distance(other_positions[i], pos);
+                } else if (other_indices[i]->find_last_row_block(&pos) == OLAP_SUCCESS) {
+                    // 切分点已经超过该版本的最后一个block
+                    num_blocks = other_indices[i]->compute_distance(other_positions[i], pos) + 1;
+                    other_exhausted[i] = true;
+                } else {
+                    other_exhausted[i] = true;
+                    continue;
+                }
+                estimated_rows += num_blocks * other_rows_per_block[i];
+                other_positions[i] = pos;
+            }
+        }
+
+        if (estimated_rows >= request_block_row_count
+                && cur_start_key.cmp(last_start_key) != 0) {
             ranges->push_back(cur_start_key.to_string_vector()); // end of last section
             ranges->push_back(cur_start_key.to_string_vector()); // start a new section
             last_start_key.copy(cur_start_key);
+            estimated_rows = 0;
         }
     }
 
@@ -876,6 +1321,24 @@ OLAPStatus OLAPTable::split_range(
     return OLAP_SUCCESS;
 }
 
+OLAPStatus OLAPTable::_get_rows_per_block(OLAPIndex* index, double* rows_per_block) {
+    RowBlockPosition first_pos;
+    RowBlockPosition last_pos;
+    if (index->find_first_row_block(&first_pos) != OLAP_SUCCESS
+            || index->find_last_row_block(&last_pos) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to find row blocks of index. [version='%d-%d' table='%s']",
+                         index->version().first,
+                         index->version().second,
+                         full_name().c_str());
+        return OLAP_ERR_TABLE_INDEX_FIND_ERROR;
+    }
+
+    // 最后一个block可能没有写满, 用真实的行数而不是每个block的行数上限
+    uint32_t num_blocks = index->compute_distance(first_pos, last_pos) + 1;
+    *rows_per_block = static_cast<double>(index->num_rows()) / num_blocks;
+    return OLAP_SUCCESS;
+}
+
 OLAPStatus OLAPTable::_get_block_pos(const vector<string>& key_strings,
                                  bool is_start_key,
                                  OLAPIndex* base_index,
@@ -928,6 +1391,7 @@ OLAPStatus OLAPTable::_get_block_pos(const vector<string>& key_strings,
     return OLAP_SUCCESS;
 }
 
+// The pack file of a packed version is listed as its data file.
 void OLAPTable::list_data_files(set<string>* file_names) const {
     _list_files_with_suffix("dat", file_names);
 }
@@ -948,6 +1412,15 @@ void OLAPTable::_list_files_with_suffix(const string& file_suffix, set<string>*
             it != _data_sources.end(); ++it) {
         // every data segment has its file name.
         OLAPIndex* index = it->second;
+        if (index->packed()) {
+            if (file_suffix == "dat") {
+                file_names->insert(basename(construct_pack_file_path(_header->file_name(),
+                                                                     index->version(),
+                                                                     index->version_hash()).c_str()));
+            }
+            continue;
+        }
+
         for (uint32_t i = 0; i < index->num_segments(); ++i) {
             file_names->insert(basename(construct_file_path(_header->file_name(),
                                                             index->version(),
@@ -1010,6 +1483,7 @@ void OLAPTable::list_version_entities(vector<VersionEntity>* version_entities) c
                     it->second->index_size(),
                     it->second->empty()));
         }
+        version_entities->back().packed = it->second->packed();
     }
 }
 
@@ -1051,6 +1525,31 @@ string OLAPTable::construct_data_file_path(const Version& version,
                                            uint32_t segment) const {
     return construct_file_path(_header->file_name(), version, version_hash, segment, "dat");
 }
+string OLAPTable::construct_pack_file_path(const string& header_path,
+                                           const Version& version,
+                                           VersionHash version_hash) {
+    return construct_file_path(header_path, version, version_hash, 0, "pack");
+}
+
+void OLAPTable::construct_version_file_paths(const string& header_path,
+                                             const Version& version,
+                                             VersionHash version_hash,
+                                             uint32_t num_segments,
+                                             bool packed,
+                                             vector<string>* file_paths) {
+    if (packed) {
+        file_paths->push_back(construct_pack_file_path(header_path, version, version_hash));
+        return;
+    }
+
+    for (uint32_t seg_id = 0; seg_id < num_segments; ++seg_id) {
+        file_paths->push_back(
+                construct_file_path(header_path, version, version_hash, seg_id, "idx"));
+        file_paths->push_back(
+                construct_file_path(header_path, version, version_hash, seg_id, "dat"));
+    }
+}
+
 string OLAPTable::construct_file_path(const string& header_path,
                                       const Version& version,
                                       VersionHash version_hash,
@@ -1173,11 +1672,146 @@ int64_t OLAPTable::get_num_rows() const {
     return num_rows;
 }
 
+size_t OLAPTable::unload_indices() {
+    size_t num_unloaded = 0;
+    for (auto& it : _data_sources) {
+        if (it.second->unload()) {
+            ++num_unloaded;
+        }
+    }
+    return num_unloaded;
+}
+
+void OLAPTable::warm_up_cache(OLAPIndex* index) {
+    if (config::compaction_cache_warm_up_sec <= 0
+            || time(NULL) - last_query_time() > config::compaction_cache_warm_up_sec
+            || data_file_type() != COLUMN_ORIENTED_FILE
+            || index->empty()
+            || index->data_size() > static_cast<size_t>(config::compaction_cache_warm_up_max_bytes)) {
+        return;
+    }
+
+    OLAPStatus res = index->load();
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to load index. [table=%s version=%d-%d res=%d]",
+                         full_name().c_str(), index->version().first,
+                         index->version().second, res);
+        return;
+    }
+
+    IData* olap_data = IData::create(index);
+    if (NULL == olap_data) {
+        OLAP_LOG_WARNING("fail to create IData. [table=%s]", full_name().c_str());
+        return;
+    }
+
+    vector<uint32_t> return_columns;
+    set<uint32_t> load_bf_columns;
+    for (uint32_t i = 0; i < _tablet_schema.size(); ++i) {
+        return_columns.push_back(i);
+        if (_tablet_schema[i].is_bf_column) {
+            load_bf_columns.insert(i);
+        }
+    }
+    Conditions conditions;
+    vector<RowCursor*> no_keys;
+
+    uint64_t num_blocks = 0;
+    res = olap_data->init();
+    if (OLAP_SUCCESS == res) {
+        olap_data->set_read_params(return_columns, load_bf_columns, conditions,
+                                   no_keys, no_keys, true, NULL);
+        // 读一遍所有数据块, segment reader在读取时把index stream和数据块放入cache
+        RowBlock* row_block = NULL;
+        for (res = olap_data->get_first_row_block(&row_block);
+                OLAP_SUCCESS == res && NULL != row_block;
+                res = olap_data->get_next_row_block(&row_block)) {
+            ++num_blocks;
+        }
+    }
+
+    if (OLAP_SUCCESS != res && !olap_data->eof()) {
+        OLAP_LOG_WARNING("fail to warm up cache. [table=%s version=%d-%d res=%d]",
+                         full_name().c_str(), index->version().first,
+                         index->version().second, res);
+    } else {
+        OLAP_LOG_INFO("warm up cache after compaction. [table=%s version=%d-%d blocks=%lu]",
+                      full_name().c_str(), index->version().first,
+                      index->version().second, num_blocks);
+    }
+    SAFE_DELETE(olap_data);
+}
+
+void OLAPTable::evict_cache(const vector<OLAPIndex*>& indices) {
+    if (config::compaction_cache_warm_up_sec <= 0 || data_file_type() != COLUMN_ORIENTED_FILE) {
+        return;
+    }
+
+    vector<ColumnId> unique_column_ids;
+    for (const FieldInfo& field_info : _tablet_schema) {
+        unique_column_ids.push_back(field_info.unique_id);
+    }
+    for (OLAPIndex* index : indices) {
+        for (uint32_t seg_id = 0; seg_id < index->num_segments(); ++seg_id) {
+            string file_name;
+            uint64_t region_offset = 0;
+            if (index->get_segment_data_file_location(seg_id, &file_name, &region_offset)
+                    != OLAP_SUCCESS) {
+                continue;
+            }
+            column_file::SegmentReader::evict_index_streams(
+                    file_name, region_offset, unique_column_ids);
+        }
+    }
+}
+
 bool OLAPTable::is_load_delete_version(Version version) {
     version_olap_index_map_t::iterator it = _data_sources.find(version);
+    // delete_flag记录在索引文件头中, 需要先加载索引
+    if (it->second->load() != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to load index. [version='%d-%d' table='%s']",
+                         version.first, version.second, full_name().c_str());
+        return false;
+    }
     return it->second->delete_flag();
 }
 
+bool OLAPTable::get_cached_checksum(int32_t version,
+                                    VersionHash version_hash,
+                                    uint32_t* checksum) const {
+    for (const VersionChecksumMessage& message : _header->version_checksums()) {
+        if (message.version() == version && message.version_hash() == version_hash) {
+            *checksum = message.checksum();
+            return true;
+        }
+    }
+    return false;
+}
+
+void OLAPTable::cache_checksum(int32_t version, VersionHash version_hash, uint32_t checksum) {
+    google::protobuf::RepeatedPtrField<VersionChecksumMessage>* checksums =
+            _header->mutable_version_checksums();
+    for (int i = 0; i < checksums->size(); ++i) {
+        if (checksums->Get(i).version() == version) {
+            checksums->DeleteSubrange(i, 1);
+            break;
+        }
+    }
+
+    if (config::max_cached_checksums_per_tablet <= 0) {
+        return;
+    }
+    // 按插入顺序淘汰最旧的记录
+    while (checksums->size() >= config::max_cached_checksums_per_tablet) {
+        checksums->DeleteSubrange(0, 1);
+    }
+
+    VersionChecksumMessage* message = checksums->Add();
+    message->set_version(version);
+    message->set_version_hash(version_hash);
+    message->set_checksum(checksum);
+}
+
 bool OLAPTable::is_schema_changing() {
     bool is_schema_changing = false;
 
@@ -1295,25 +1929,30 @@ void OLAPTable::_set_storage_root_path_name() {
 }
 
 VersionEntity OLAPTable::get_version_entity_by_version(Version version) {
-    if (_data_sources[version]->has_column_statistics()) {
-        return VersionEntity(version,
-                _data_sources[version]->version_hash(),
-                _data_sources[version]->num_segments(),
-                _data_sources[version]->ref_count(),
-                _data_sources[version]->num_rows(),
-                _data_sources[version]->data_size(),
-                _data_sources[version]->index_size(),
-                _data_sources[version]->empty(),
-                _data_sources[version]->get_column_statistics());
+    OLAPIndex* index = _data_sources[version];
+    if (index->has_column_statistics()) {
+        VersionEntity entity(version,
+                index->version_hash(),
+                index->num_segments(),
+                index->ref_count(),
+                index->num_rows(),
+                index->data_size(),
+                index->index_size(),
+                index->empty(),
+                index->get_column_statistics());
+        entity.packed = index->packed();
+        return entity;
     } else {
-        return VersionEntity(version,
-                _data_sources[version]->version_hash(),
-                _data_sources[version]->num_segments(),
-                _data_sources[version]->ref_count(),
-                _data_sources[version]->num_rows(),
-                _data_sources[version]->data_size(),
-                _data_sources[version]->index_size(),
-                _data_sources[version]->empty());
+        VersionEntity entity(version,
+                index->version_hash(),
+                index->num_segments(),
+                index->ref_count(),
+                index->num_rows(),
+                index->data_size(),
+                index->index_size(),
+                index->empty());
+        entity.packed = index->packed();
+        return entity;
     }
 }
 
@@ -16,6 +16,7 @@
 #ifndef BDG_PALO_BE_SRC_OLAP_OLAP_TABLE_H
 #define BDG_PALO_BE_SRC_OLAP_OLAP_TABLE_H
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <set>
@@ -25,10 +26,12 @@
 
 #include "gen_cpp/AgentService_types.h"
 #include "gen_cpp/olap_file.pb.h"
+#include "olap/delete_bitmap.h"
 #include "olap/field.h"
 #include "olap/olap_define.h"
 #include "olap/olap_header.h"
 #include "olap/row_cursor.h"
+#include "olap/tablet_access_stats.h"
 #include "olap/utils.h"
 
 namespace palo {
@@ -159,6 +162,16 @@ public:
                                 const std::vector<OLAPIndex*>* new_data_sources,
                                 std::vector<OLAPIndex*>* old_data_sources);
 
+    // Whether the table records the rows replaced by newer versions in its delete
+    // bitmap, see DeleteBitmap.
+    bool is_merge_on_write() const;
+
+    // Sets the rows replaced by newer versions up to 'version' on 'sources', so that
+    // they can be read one by one without merging. Returns false and sets nothing if
+    // the table isn't merge-on-write or any of the sources has to be merged. Get the
+    // header lock before calling it.
+    bool apply_delete_bitmap(const Version& version, const std::vector<IData*>& sources) const;
+
     // Computes the cumulative hash for given versions.
     // Only use Base file and Delta files to compute for simplicity and
     // accuracy. XOR operation of version_hash satisfies associative laws and
@@ -282,6 +295,21 @@ public:
                                            uint32_t segment,
                                            const std::string& suffix);
 
+    // The pack file holding all the files of a packed version, see packed_file.h.
+    // It is named like the file of segment 0 with suffix "pack".
+    static std::string construct_pack_file_path(const std::string& header_path,
+                                                const Version& version,
+                                                VersionHash version_hash);
+
+    // Appends the paths of all files of a version: the pack file if it is packed,
+    // otherwise the index and data file of every segment.
+    static void construct_version_file_paths(const std::string& header_path,
+                                             const Version& version,
+                                             VersionHash version_hash,
+                                             uint32_t num_segments,
+                                             bool packed,
+                                             std::vector<std::string>* file_paths);
+
     std::string construct_file_name(const Version& version,
                                     VersionHash version_hash,
                                     uint32_t segment,
@@ -383,6 +411,54 @@ public:
         return _header->get_expansion_nice_estimate();
     }
 
+    // 在使用之前对header加锁
+    const int64_t get_cumulative_delta_size() const {
+        return _header->get_cumulative_delta_size();
+    }
+
+    // 合并各版本的列统计草图, 用于向FE汇报. 在使用之前对header加锁
+    OLAPStatus merge_column_sketches(std::vector<ColumnSketchMessage>* column_sketches) {
+        return _header->merge_column_sketches(_tablet_schema, column_sketches);
+    }
+
+    // 记录tablet被查询的次数, 用于compaction调度时优先合并查询频繁的tablet
+    void add_query_count() {
+        _query_count.fetch_add(1, std::memory_order_relaxed);
+        _last_query_time.store(time(NULL), std::memory_order_relaxed);
+    }
+
+    // 最近一次被查询的时间, 没有被查询过时为tablet加载的时间
+    int64_t last_query_time() const {
+        return _last_query_time.load(std::memory_order_relaxed);
+    }
+
+    // 释放没有被读取的版本的short key索引, 下次访问时重新加载, 使长时间没有查询的
+    // tablet只有header常驻内存. 返回释放的版本数. 调用前需要获取header写锁
+    size_t unload_indices();
+
+    // 如果tablet在compaction_cache_warm_up_sec内被查询过, 读取compaction生成的版本,
+    // 把它的index stream和解压后的数据块放入cache, 避免替换版本之后的查询读盘和解压.
+    // 在版本加入tablet之前调用, 不需要获取header锁
+    void warm_up_cache(OLAPIndex* index);
+
+    // 把被compaction合并的版本的index stream移出cache, 为新版本腾出空间
+    void evict_cache(const std::vector<OLAPIndex*>& indices);
+
+    // 返回上一次compaction之后的查询次数
+    int64_t query_count() const {
+        return _query_count.load(std::memory_order_relaxed);
+    }
+
+    // compaction完成后清零查询次数
+    void reset_query_count() {
+        _query_count.store(0, std::memory_order_relaxed);
+    }
+
+    // 扫描次数、行数、读盘字节数和扫描时间, 由扫描线程无锁更新, 定期衰减
+    TabletAccessStats* access_stats() {
+        return &_access_stats;
+    }
+
     const OLAPStatus delete_version(const Version& version) {
         return _header->delete_version(version);
     }
@@ -399,6 +475,18 @@ public:
         return _header->compress_kind();
     }
 
+    // 返回列单独指定的压缩方式, 没有指定时返回false
+    bool column_compress_kind(size_t index, CompressKind* kind, int32_t* level) const {
+        const ColumnMessage& column = _header->column(index);
+        if (!column.has_compress_kind()) {
+            return false;
+        }
+
+        *kind = column.compress_kind();
+        *level = column.compress_level();
+        return true;
+    }
+
     int delete_data_conditions_size() const {
         return _header->delete_data_conditions_size();
     }
@@ -421,6 +509,15 @@ public:
         return _header->mutable_delete_data_conditions(index);
     }
 
+    // Get checksum of Version(0, version) cached by consistency check.
+    // Caller should hold the header lock.
+    bool get_cached_checksum(int32_t version, VersionHash version_hash, uint32_t* checksum) const;
+
+    // Cache checksum of Version(0, version) in header, the oldest one is evicted
+    // when there are more than config::max_cached_checksums_per_tablet.
+    // Caller should hold the header write lock and save header.
+    void cache_checksum(int32_t version, VersionHash version_hash, uint32_t checksum);
+
     double bloom_filter_fpp() const {
         if (_header->has_bf_fpp()) {
             return _header->bf_fpp();
@@ -642,8 +739,28 @@ private:
     // 获取最大的index（只看大小）
     OLAPIndex* _get_largest_index();
 
+    // 根据index中的block数和行数, 估计平均每个row block的行数
+    OLAPStatus _get_rows_per_block(OLAPIndex* index, double* rows_per_block);
+
     void _set_storage_root_path_name();
 
+    std::string _delete_bitmap_file_name() const {
+        return _header->file_name() + ".delete_bitmap";
+    }
+
+    // Loads the delete bitmap saved with the header, dropping what refers to versions
+    // the header doesn't have.
+    void _load_delete_bitmap();
+
+    // Updates the delete bitmap after 'old_versions' are replaced by 'new_indices', and
+    // saves it before the header is saved.
+    void _update_delete_bitmap(const std::vector<Version>& old_versions,
+                               const std::vector<OLAPIndex*>& new_indices);
+
+    // Looks up the keys of 'index' in 'targets', newest first, and records the rows of
+    // the targets they replace. Rows with equal key in 'index' replace the earlier ones.
+    OLAPStatus _lookup_keys(OLAPIndex* index, const std::vector<OLAPIndex*>& targets);
+
     TTabletId _tablet_id;
     TSchemaHash _schema_hash;
     OLAPHeader* _header;
@@ -676,6 +793,12 @@ private:
     std::string _storage_root_path;
     volatile bool _is_loaded;
     MutexLock _load_lock;
+    std::atomic<int64_t> _query_count;
+    std::atomic<int64_t> _last_query_time;
+    TabletAccessStats _access_stats;
+    // rows replaced by newer versions, only for merge-on-write tables, protected by
+    // the header lock
+    DeleteBitmap _delete_bitmap;
 
     DISALLOW_COPY_AND_ASSIGN(OLAPTable);
 };
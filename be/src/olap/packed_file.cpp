@@ -0,0 +1,200 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/packed_file.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <memory>
+
+#include "olap/file_helper.h"
+#include "olap/utils.h"
+
+namespace palo {
+
+// "PALOPACK"
+static const uint64_t PACKED_FILE_MAGIC = 0x4b4341504f4c4150ULL;
+// the files of a pack start at multiples of the page size
+static const uint64_t PACKED_FILE_ALIGNMENT = 4096;
+static const size_t PACK_COPY_BUFFER_SIZE = 1024 * 1024;
+
+struct PackedFileTail {
+    uint32_t num_segments;
+    // adler32 of the directory
+    uint32_t checksum;
+    uint64_t magic;
+};
+
+static uint64_t align_up(uint64_t offset) {
+    return (offset + PACKED_FILE_ALIGNMENT - 1) / PACKED_FILE_ALIGNMENT * PACKED_FILE_ALIGNMENT;
+}
+
+// Copies the file at 'path' to 'offset' of the packed file
+static OLAPStatus copy_into_pack(const std::string& path, uint64_t offset,
+                                 FileHandler* pack_handler, char* buf,
+                                 PackedRegion* region) {
+    FileHandler file_handler;
+    OLAPStatus res = file_handler.open(path, O_RDONLY);
+    if (OLAP_SUCCESS != res) {
+        return res;
+    }
+    off_t length = file_handler.length();
+    if (length < 0) {
+        return OLAP_ERR_IO_ERROR;
+    }
+
+    for (uint64_t copied = 0; copied < static_cast<uint64_t>(length);) {
+        size_t size = std::min<uint64_t>(PACK_COPY_BUFFER_SIZE, length - copied);
+        if (OLAP_SUCCESS != (res = file_handler.pread(buf, size, copied))
+                || OLAP_SUCCESS != (res = pack_handler->pwrite(buf, size, offset + copied))) {
+            return res;
+        }
+        copied += size;
+    }
+    region->offset = offset;
+    region->length = length;
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus pack_segment_files(const std::vector<std::string>& index_paths,
+                              const std::vector<std::string>& data_paths,
+                              const std::string& pack_path) {
+    if (index_paths.empty() || index_paths.size() != data_paths.size()) {
+        return OLAP_ERR_INPUT_PARAMETER_ERROR;
+    }
+
+    FileHandler pack_handler;
+    OLAPStatus res = pack_handler.open_with_mode(
+            pack_path, O_CREAT | O_EXCL | O_WRONLY, S_IRUSR | S_IWUSR);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to create packed file. [file='%s']", pack_path.c_str());
+        return res;
+    }
+
+    std::vector<PackedSegment> segments(index_paths.size());
+    std::unique_ptr<char[]> buf(new char[PACK_COPY_BUFFER_SIZE]);
+    uint64_t offset = 0;
+    for (size_t i = 0; i < segments.size() && OLAP_SUCCESS == res; ++i) {
+        res = copy_into_pack(index_paths[i], offset, &pack_handler, buf.get(),
+                             &segments[i].index);
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to pack index file. [file='%s']", index_paths[i].c_str());
+            break;
+        }
+        offset = align_up(offset + segments[i].index.length);
+
+        res = copy_into_pack(data_paths[i], offset, &pack_handler, buf.get(),
+                             &segments[i].data);
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("fail to pack data file. [file='%s']", data_paths[i].c_str());
+            break;
+        }
+        offset = align_up(offset + segments[i].data.length);
+    }
+
+    if (OLAP_SUCCESS == res) {
+        size_t directory_size = segments.size() * sizeof(PackedSegment);
+        PackedFileTail tail;
+        tail.num_segments = segments.size();
+        tail.checksum = olap_adler32(ADLER32_INIT,
+                                     reinterpret_cast<const char*>(&segments[0]),
+                                     directory_size);
+        tail.magic = PACKED_FILE_MAGIC;
+        res = pack_handler.pwrite(&segments[0], directory_size, offset);
+        if (OLAP_SUCCESS == res) {
+            res = pack_handler.pwrite(&tail, sizeof(tail), offset + directory_size);
+        }
+    }
+
+    // like the files it replaces, the packed file is synced when it's closed
+    if (OLAP_SUCCESS != pack_handler.close() && OLAP_SUCCESS == res) {
+        res = OLAP_ERR_IO_ERROR;
+    }
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to write packed file. [file='%s' res=%d]", pack_path.c_str(), res);
+        remove(pack_path.c_str());
+        return res;
+    }
+
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (remove(index_paths[i].c_str()) != 0) {
+            OLAP_LOG_WARNING("fail to remove packed file. [file='%s' err='%m']",
+                             index_paths[i].c_str());
+        }
+        if (remove(data_paths[i].c_str()) != 0) {
+            OLAP_LOG_WARNING("fail to remove packed file. [file='%s' err='%m']",
+                             data_paths[i].c_str());
+        }
+    }
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus read_packed_directory(const std::string& pack_path,
+                                 std::vector<PackedSegment>* segments) {
+    FileHandler file_handler;
+    OLAPStatus res = file_handler.open_with_cache(pack_path, O_RDONLY);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to open packed file. [file='%s']", pack_path.c_str());
+        return res;
+    }
+
+    off_t length = file_handler.length();
+    PackedFileTail tail;
+    if (length < static_cast<off_t>(sizeof(tail))) {
+        OLAP_LOG_WARNING("packed file is too short. [file='%s' length=%ld]",
+                         pack_path.c_str(), length);
+        return OLAP_ERR_FILE_FORMAT_ERROR;
+    }
+    uint64_t tail_offset = length - sizeof(tail);
+    if (OLAP_SUCCESS != (res = file_handler.pread(&tail, sizeof(tail), tail_offset))) {
+        return res;
+    }
+    uint64_t directory_size = static_cast<uint64_t>(tail.num_segments) * sizeof(PackedSegment);
+    if (tail.magic != PACKED_FILE_MAGIC || tail.num_segments == 0
+            || directory_size > tail_offset) {
+        OLAP_LOG_WARNING("invalid packed file tail. [file='%s' num_segments=%u]",
+                         pack_path.c_str(), tail.num_segments);
+        return OLAP_ERR_FILE_FORMAT_ERROR;
+    }
+
+    uint64_t directory_offset = tail_offset - directory_size;
+    segments->resize(tail.num_segments);
+    res = file_handler.pread(&(*segments)[0], directory_size, directory_offset);
+    if (OLAP_SUCCESS != res) {
+        return res;
+    }
+    uint32_t checksum = olap_adler32(ADLER32_INIT,
+                                     reinterpret_cast<const char*>(&(*segments)[0]),
+                                     directory_size);
+    if (checksum != tail.checksum) {
+        OLAP_LOG_WARNING("packed file directory checksum error. [file='%s']",
+                         pack_path.c_str());
+        return OLAP_ERR_CHECKSUM_ERROR;
+    }
+
+    for (const PackedSegment& segment : *segments) {
+        if (segment.index.offset + segment.index.length > directory_offset
+                || segment.data.offset + segment.data.length > directory_offset) {
+            OLAP_LOG_WARNING("packed file region out of range. [file='%s']", pack_path.c_str());
+            return OLAP_ERR_FILE_FORMAT_ERROR;
+        }
+    }
+    return OLAP_SUCCESS;
+}
+
+}  // namespace palo
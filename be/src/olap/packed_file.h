@@ -0,0 +1,64 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_PACKED_FILE_H
+#define BDG_PALO_BE_SRC_OLAP_PACKED_FILE_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "olap/olap_define.h"
+
+namespace palo {
+
+// A packed file holds the index and data files of all segments of a version, so that a
+// small version takes one file and one file descriptor instead of two per segment.
+//
+// The files are stored one after another, the index file of a segment before its data
+// file, each from a page boundary so that it can be mmapped on its own. A directory
+// with the place of every file and a fixed size tail end the packed file:
+//
+//   | index 0 | data 0 | index 1 | data 1 | ... | directory | tail |
+//
+// Readers open a file of the pack with FileHandler::open_region_with_cache(), which
+// reads it like a file of its own through the cached descriptor of the packed file.
+
+// Where a file is in a packed file
+struct PackedRegion {
+    uint64_t offset;
+    uint64_t length;
+};
+
+// The directory entry of a segment
+struct PackedSegment {
+    PackedRegion index;
+    PackedRegion data;
+};
+
+// Copies the index and data files of the segments of a version into a new packed file
+// at 'pack_path', then removes them. The files are left as they are if it fails.
+OLAPStatus pack_segment_files(const std::vector<std::string>& index_paths,
+                              const std::vector<std::string>& data_paths,
+                              const std::string& pack_path);
+
+// Reads and checks the directory of the packed file at 'pack_path'.
+OLAPStatus read_packed_directory(const std::string& pack_path,
+                                 std::vector<PackedSegment>* segments);
+
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_OLAP_PACKED_FILE_H
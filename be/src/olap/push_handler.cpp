@@ -19,11 +19,15 @@
 #include <iostream>
 #include <sstream>
 
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
 
+#include "olap/i_data.h"
 #include "olap/olap_engine.h"
 #include "olap/olap_table.h"
 #include "olap/schema_change.h"
+#include "util/blocking_queue.hpp"
 
 using std::list;
 using std::map;
@@ -299,6 +303,193 @@ EXIT:
     return res;
 }
 
+// Process a batch of load pushes, the main logical is as follows:
+//    a. only plain loads of consecutive versions into a tablet that is not altered and
+//       that doesn't need a revert can be pushed together, otherwise the caller pushes
+//       the requests one by one
+//    b. every file is converted into a delta of its own version
+//    c. the deltas of all but the last version are merged into one delta of their
+//       version range, the way cumulative expansion merges them later. The latest
+//       delta is kept as is since it may still be re-pushed
+//    d. all new deltas are added to the header at once
+OLAPStatus PushHandler::process_batch(
+        SmartOLAPTable olap_table,
+        const vector<TPushReq>& requests,
+        vector<vector<TTabletInfo>>* tablet_info_vecs) {
+    if (requests.size() < 2) {
+        return OLAP_ERR_PUSH_BATCH_NOT_APPLICABLE;
+    }
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (requests[i].push_type != TPushType::LOAD
+                || requests[i].tablet_id != requests[0].tablet_id
+                || requests[i].schema_hash != requests[0].schema_hash
+                || requests[i].version != requests[0].version + static_cast<int64_t>(i)) {
+            return OLAP_ERR_PUSH_BATCH_NOT_APPLICABLE;
+        }
+    }
+    int64_t first_version = requests.front().version;
+    int64_t last_version = requests.back().version;
+    OLAP_LOG_INFO("begin to push data in batch. [table='%s' version=%ld-%ld]",
+                  olap_table->full_name().c_str(), first_version, last_version);
+
+    OLAPStatus res = OLAP_SUCCESS;
+    _request = requests.front();
+    _olap_table_arr.clear();
+    _olap_table_arr.push_back(olap_table);
+    Indices deltas;
+    Indices published_indices;
+    Versions unused_versions;
+    Indices unused_indices;
+    vector<IData*> merged_sources;
+
+    olap_table->obtain_push_lock();
+    olap_table->set_push_status(PUSH_RUNNING, first_version);
+
+    do {
+        // 1. Check that the versions just follow the tablet's
+        _obtain_header_rdlock();
+        bool is_schema_changing = olap_table->get_schema_change_request(
+                NULL, NULL, NULL, NULL);
+        const FileVersionMessage* latest_delta = olap_table->lastest_delta();
+        const FileVersionMessage* latest_version = olap_table->latest_version();
+        bool follows = false;
+        if (NULL != latest_delta) {
+            follows = latest_delta->start_version() + 1 == first_version;
+        } else if (NULL != latest_version) {
+            follows = latest_version->end_version() + 1 == first_version;
+        } else {
+            follows = 0 == first_version;
+        }
+        _release_header_lock();
+        if (is_schema_changing || !follows) {
+            OLAP_LOG_INFO("can't push versions in batch. [table='%s' version=%ld-%ld "
+                          "schema_changing=%d]",
+                          olap_table->full_name().c_str(), first_version, last_version,
+                          is_schema_changing);
+            res = OLAP_ERR_PUSH_BATCH_NOT_APPLICABLE;
+            break;
+        }
+
+        // 2. Convert every file into the delta of its version
+        for (const TPushReq& request : requests) {
+            _request = request;
+            Indices unused_new_indices;
+            res = _convert(olap_table, SmartOLAPTable(), &deltas, &unused_new_indices,
+                           ALTER_TABLET_SCHEMA_CHANGE);
+            if (res != OLAP_SUCCESS) {
+                OLAP_LOG_WARNING("fail to convert data. [res=%d table='%s' version=%ld]",
+                                 res, olap_table->full_name().c_str(), request.version);
+                break;
+            }
+        }
+        if (res != OLAP_SUCCESS) {
+            break;
+        }
+        DCHECK_EQ(requests.size(), deltas.size());
+
+        // 3. Merge all but the latest delta into one
+        if (deltas.size() == 2) {
+            published_indices = deltas;
+            deltas.clear();
+            break;
+        }
+        VersionHash merged_version_hash = 0;
+        for (size_t i = 0; i + 1 < deltas.size(); ++i) {
+            merged_version_hash ^= deltas[i]->version_hash();
+            IData* olap_data = IData::create(deltas[i]);
+            if (NULL == olap_data) {
+                res = OLAP_ERR_MALLOC_ERROR;
+                break;
+            }
+            merged_sources.push_back(olap_data);
+            if (OLAP_SUCCESS != (res = olap_data->init())) {
+                OLAP_LOG_WARNING("fail to init olap data. [res=%d table='%s']",
+                                 res, olap_table->full_name().c_str());
+                break;
+            }
+        }
+        if (res != OLAP_SUCCESS) {
+            break;
+        }
+
+        OLAPIndex* merged_index = new(std::nothrow) OLAPIndex(
+                olap_table.get(), Version(first_version, last_version - 1),
+                merged_version_hash, false, 0, 0);
+        if (NULL == merged_index) {
+            res = OLAP_ERR_MALLOC_ERROR;
+            break;
+        }
+        published_indices.push_back(merged_index);
+
+        Merger merger(olap_table, merged_index, READER_CUMULATIVE_EXPANSION);
+        uint64_t merged_rows = 0;
+        uint64_t filted_rows = 0;
+        res = merger.merge(merged_sources, false, &merged_rows, &filted_rows);
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to merge deltas. [res=%d table='%s' version=%ld-%ld]",
+                             res, olap_table->full_name().c_str(),
+                             first_version, last_version - 1);
+            break;
+        }
+        if (OLAP_SUCCESS != (res = merged_index->load())) {
+            OLAP_LOG_WARNING("fail to load merged index. [res=%d table='%s']",
+                             res, olap_table->full_name().c_str());
+            break;
+        }
+        published_indices.push_back(deltas.back());
+        deltas.pop_back();
+    } while (0);
+
+    for (IData* olap_data : merged_sources) {
+        SAFE_DELETE(olap_data);
+    }
+
+    // 4. Add the new deltas to the header
+    if (res == OLAP_SUCCESS) {
+        _obtain_header_wrlock();
+        res = _update_header(olap_table, &unused_versions, &published_indices,
+                             &unused_indices);
+        _release_header_lock();
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to update header of new deltas. "
+                             "[res=%d table='%s' version=%ld-%ld]",
+                             res, olap_table->full_name().c_str(),
+                             first_version, last_version);
+        }
+    }
+
+    // Every request reports the version it pushed
+    if (res == OLAP_SUCCESS && tablet_info_vecs != NULL) {
+        vector<TableVars> table_infoes(1);
+        table_infoes[0].olap_table = olap_table;
+        tablet_info_vecs->assign(requests.size(), vector<TTabletInfo>());
+        for (size_t i = 0; i < requests.size(); ++i) {
+            _get_tablet_infos(table_infoes, &(*tablet_info_vecs)[i]);
+            for (TTabletInfo& tablet_info : (*tablet_info_vecs)[i]) {
+                tablet_info.version = requests[i].version;
+                tablet_info.version_hash = requests[i].version_hash;
+            }
+        }
+    }
+
+    // The converted deltas were either merged or not published
+    for (OLAPIndex* olap_index : deltas) {
+        olap_index->delete_all_files();
+        SAFE_DELETE(olap_index);
+    }
+    for (OLAPIndex* olap_index : published_indices) {
+        olap_index->delete_all_files();
+        SAFE_DELETE(olap_index);
+    }
+
+    olap_table->release_push_lock();
+    olap_table->set_push_status(PUSH_WAITING, -1);
+    _olap_table_arr.clear();
+
+    OLAP_LOG_INFO("finish to process push in batch. [res=%d]", res);
+    return res;
+}
+
 void PushHandler::_get_tablet_infos(
         const vector<TableVars>& table_infoes,
         vector<TTabletInfo>* tablet_info_vec) {
@@ -413,7 +604,22 @@ OLAPStatus PushHandler::_convert(
         }
 
         // 5. Read data from raw file and write into OLAPIndex of curr_olap_table
-        if (_request.__isset.http_file_path) {
+        if (_request.__isset.http_file_path && config::push_convert_queue_size > 0) {
+            OLAP_LOG_DEBUG("start to convert row file to delta in pipeline.");
+
+            res = _convert_rows_pipelined(curr_olap_table, reader, writer, &num_rows);
+            if (OLAP_SUCCESS != res) {
+                break;
+            }
+
+            reader->finalize();
+
+            if (false == reader->validate_checksum()) {
+                OLAP_LOG_WARNING("pushed delta file has wrong checksum.");
+                res = OLAP_ERR_PUSH_BUILD_DELTA_ERROR;
+                break;
+            }
+        } else if (_request.__isset.http_file_path) {
             // Convert from raw to delta
             OLAP_LOG_DEBUG("start to convert row file to delta.");
 
@@ -485,6 +691,125 @@ OLAPStatus PushHandler::_convert(
     return res;
 }
 
+// rows decoded by the reading thread of a pipelined push
+struct PushRowBatch {
+    PushRowBatch() : num_rows(0) {}
+    ~PushRowBatch() {
+        for (RowCursor* row : rows) {
+            SAFE_DELETE(row);
+        }
+    }
+
+    std::vector<RowCursor*> rows;
+    size_t num_rows;
+};
+
+typedef BlockingQueue<PushRowBatch*> PushRowBatchQueue;
+
+// 读线程：从空闲队列取batch，解码raw file中的行后放入待写队列，
+// 出错或读完后关闭待写队列通知写线程
+static void read_push_rows(IBinaryReader* reader,
+                           PushRowBatchQueue* free_batches,
+                           PushRowBatchQueue* filled_batches,
+                           OLAPStatus* res) {
+    PushRowBatch* batch = NULL;
+    while (!reader->eof() && free_batches->blocking_get(&batch)) {
+        batch->num_rows = 0;
+        while (batch->num_rows < batch->rows.size() && !reader->eof()) {
+            RowCursor* row = batch->rows[batch->num_rows];
+            // BinaryReader只会设置null标记，复用的行需要先清空
+            row->reset_buf();
+            *res = reader->next(row);
+            if (OLAP_SUCCESS != *res) {
+                OLAP_LOG_WARNING("read next row failed. [res=%d]", *res);
+                break;
+            }
+            ++batch->num_rows;
+        }
+
+        if (OLAP_SUCCESS != *res || !filled_batches->blocking_put(batch)) {
+            break;
+        }
+    }
+
+    filled_batches->shutdown();
+}
+
+OLAPStatus PushHandler::_convert_rows_pipelined(
+        SmartOLAPTable olap_table,
+        IBinaryReader* reader,
+        IWriter* writer,
+        uint32_t* num_rows) {
+    OLAPStatus res = OLAP_SUCCESS;
+    OLAPStatus read_res = OLAP_SUCCESS;
+    size_t queue_size = config::push_convert_queue_size;
+    size_t batch_size = olap_table->num_rows_per_row_block();
+
+    // 多一个batch给写线程正在处理的数据
+    std::vector<PushRowBatch> batches(queue_size + 1);
+    PushRowBatchQueue free_batches(batches.size());
+    PushRowBatchQueue filled_batches(batches.size());
+    for (PushRowBatch& batch : batches) {
+        batch.rows.resize(batch_size, NULL);
+        for (size_t i = 0; i < batch_size; ++i) {
+            if (NULL == (batch.rows[i] = new(std::nothrow) RowCursor())) {
+                OLAP_LOG_WARNING("fail to malloc RowCursor. [size=%ld]", sizeof(RowCursor));
+                return OLAP_ERR_MALLOC_ERROR;
+            }
+
+            if (OLAP_SUCCESS != (res = batch.rows[i]->init(olap_table->tablet_schema()))) {
+                OLAP_LOG_WARNING("fail to init rowcursor. [res=%d]", res);
+                return res;
+            }
+        }
+        free_batches.blocking_put(&batch);
+    }
+
+    boost::thread read_thread(boost::bind(&read_push_rows,
+                                          reader,
+                                          &free_batches,
+                                          &filled_batches,
+                                          &read_res));
+
+    RowCursor row;
+    if (OLAP_SUCCESS != (res = row.init(olap_table->tablet_schema()))) {
+        OLAP_LOG_WARNING("fail to init rowcursor. [res=%d]", res);
+    }
+
+    PushRowBatch* batch = NULL;
+    while (OLAP_SUCCESS == res && filled_batches.blocking_get(&batch)) {
+        for (size_t i = 0; i < batch->num_rows; ++i) {
+            if (OLAP_SUCCESS != (res = writer->attached_by(&row))) {
+                OLAP_LOG_WARNING(
+                        "fail to attach row to writer. [res=%d table='%s' read_rows=%u]",
+                        res, olap_table->full_name().c_str(), *num_rows);
+                break;
+            }
+
+            row.copy(*batch->rows[i]);
+            writer->next(row);
+            ++(*num_rows);
+        }
+
+        if (OLAP_SUCCESS == res) {
+            free_batches.blocking_put(batch);
+        }
+    }
+
+    // 写失败时唤醒可能阻塞在队列上的读线程
+    free_batches.shutdown();
+    filled_batches.shutdown();
+    read_thread.join();
+
+    if (OLAP_SUCCESS == res && OLAP_SUCCESS != read_res) {
+        OLAP_LOG_WARNING("fail to read raw file. [res=%d table='%s' read_rows=%u]",
+                         read_res, olap_table->full_name().c_str(), *num_rows);
+        res = read_res;
+    }
+
+    return res;
+}
+
 OLAPStatus PushHandler::_validate_request(
         SmartOLAPTable olap_table_for_raw,
         SmartOLAPTable olap_table_for_schema_change,
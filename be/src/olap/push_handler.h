@@ -36,6 +36,7 @@ typedef std::vector<OLAPIndex*> Indices;
 
 class BinaryFile;
 class BinaryReader;
+class IBinaryReader;
 class ColumnMapping;
 class RowCursor;
 
@@ -60,6 +61,15 @@ public:
             PushType push_type,
             std::vector<TTabletInfo>* tablet_info_vec);
 
+    // Load the local data files of several plain loads of consecutive versions into
+    // specified tablet with a single header update. Returns
+    // OLAP_ERR_PUSH_BATCH_NOT_APPLICABLE if they have to be pushed one by one.
+    // 'tablet_info_vecs' gets the tablet infos of each request.
+    OLAPStatus process_batch(
+            SmartOLAPTable olap_table,
+            const std::vector<TPushReq>& requests,
+            std::vector<std::vector<TTabletInfo>>* tablet_info_vecs);
+
 private:
     // Validate request, mainly data version check.
     OLAPStatus _validate_request(
@@ -86,6 +96,14 @@ private:
             Indices* new_olap_indices,
             AlterTabletType alter_table_type);
 
+    // Read rows from raw file on a separate thread and write them into delta
+    // with a bounded number of row blocks in flight.
+    OLAPStatus _convert_rows_pipelined(
+            SmartOLAPTable olap_table,
+            IBinaryReader* reader,
+            IWriter* writer,
+            uint32_t* num_rows);
+
     // Update header info when new version add or dirty version removed.
     OLAPStatus _update_header(
             SmartOLAPTable olap_table,
@@ -15,10 +15,14 @@
 
 #include "olap/reader.h"
 
+#include <algorithm>
+
 #include "olap/olap_data.h"
+#include "olap/olap_index.h"
 #include "olap/olap_table.h"
 #include "olap/row_block.h"
 #include "olap/row_cursor.h"
+#include "runtime/vectorized_row_batch.h"
 
 using std::nothrow;
 using std::set;
@@ -26,63 +30,224 @@ using std::vector;
 
 namespace palo {
 
+// Aggregate value of row into the row_index-th value of a fixed length column in
+// storage format, NULL is handled the same as RowCursor::aggregate. Values are
+// accessed by memcpy because the column data may not be aligned to T.
+template <typename T, FieldAggregationMethod method>
+static OLAPStatus aggregate_column(const RowCursor& row,
+                                   uint32_t column_id,
+                                   ColumnVector* column,
+                                   int row_index,
+                                   MemPool* mem_pool) {
+    const Field* field = row.get_field_by_index(column_id);
+    bool* is_null = column->is_null() + row_index;
+    char* value = reinterpret_cast<char*>(column->col_data()) + sizeof(T) * row_index;
+
+    if (field->is_null()) {
+        // NULL is the minimum value
+        if (method == OLAP_FIELD_AGGREGATION_MIN || method == OLAP_FIELD_AGGREGATION_REPLACE) {
+            *is_null = true;
+        }
+        return OLAP_SUCCESS;
+    }
+
+    if (*is_null) {
+        if (method != OLAP_FIELD_AGGREGATION_MIN) {
+            *is_null = false;
+            memcpy(value, field->buf(), sizeof(T));
+        }
+        return OLAP_SUCCESS;
+    }
+
+    T left;
+    T right;
+    memcpy(&left, value, sizeof(T));
+    memcpy(&right, field->buf(), sizeof(T));
+    switch (method) {
+    case OLAP_FIELD_AGGREGATION_MIN:
+        if (left > right) {
+            left = right;
+        }
+        break;
+    case OLAP_FIELD_AGGREGATION_MAX:
+        if (right > left) {
+            left = right;
+        }
+        break;
+    case OLAP_FIELD_AGGREGATION_SUM:
+        left += right;
+        break;
+    default:
+        left = right;
+        break;
+    }
+    memcpy(value, &left, sizeof(T));
+
+    return OLAP_SUCCESS;
+}
+
+// REPLACE of string column, whose value is a StringValue pointing to mem_pool
+static OLAPStatus replace_string_column(const RowCursor& row,
+                                        uint32_t column_id,
+                                        ColumnVector* column,
+                                        int row_index,
+                                        MemPool* mem_pool) {
+    return row.write_to_vector(column_id, column, row_index, mem_pool);
+}
+
+template <typename T>
+static Reader::ColumnAggregateFunc get_column_aggregate_func(FieldAggregationMethod method) {
+    switch (method) {
+    case OLAP_FIELD_AGGREGATION_MIN:
+        return &aggregate_column<T, OLAP_FIELD_AGGREGATION_MIN>;
+    case OLAP_FIELD_AGGREGATION_MAX:
+        return &aggregate_column<T, OLAP_FIELD_AGGREGATION_MAX>;
+    case OLAP_FIELD_AGGREGATION_SUM:
+        return &aggregate_column<T, OLAP_FIELD_AGGREGATION_SUM>;
+    case OLAP_FIELD_AGGREGATION_REPLACE:
+        return &aggregate_column<T, OLAP_FIELD_AGGREGATION_REPLACE>;
+    default:
+        return NULL;
+    }
+}
+
 Reader::MergeSet::~MergeSet() {
-    SAFE_DELETE(_heap);
+    clear();
 }
 
 OLAPStatus Reader::MergeSet::init(Reader* reader, bool reverse) {
     _reader = reader;
+    _reverse = reverse;
+    return OLAP_SUCCESS;
+}
 
-    _heap = new (nothrow) heap_t(RowCursorComparator(reverse));
-    if (_heap == NULL) {
-        OLAP_LOG_FATAL("failed to malloc. [size=%ld]", sizeof(heap_t));
-        return OLAP_ERR_MALLOC_ERROR;
+bool Reader::MergeSet::attach(const MergeElement& merge_element, const RowCursor* row,
+                              RowSource source) {
+    if (!_skip_deleted_rows(merge_element, &row)) {
+        return false;
     }
 
-    return OLAP_SUCCESS;
+    if (row != NULL) {
+        _leaves.push_back(merge_element);
+        _sources.push_back(source);
+        _is_built = false;
+    }
+
+    return true;
 }
 
-bool Reader::MergeSet::attach(const MergeElement& merge_element, const RowCursor* row) {
+bool Reader::MergeSet::_skip_deleted_rows(const MergeElement& merge_element,
+                                          const RowCursor** row) {
     // Use data file's end_version as data's version
     int32_t data_version = merge_element->version().second;
-    do {
-        if (row == NULL) {
-            if (!merge_element->eof()) {
-                // Return error if merge_element isn't reach end, but row equal NULL.
-                OLAP_LOG_WARNING("internal error with IData.");
-                return false;
-            } else {
-                _reader->_filted_rows += merge_element->get_filted_rows();
-            }
-        } else {
-            _reader->_scan_rows++;
-            if (merge_element->data_file_type() == OLAP_DATA_FILE) {
-                if (_reader->_delete_handler.is_filter_data(data_version, *row)) {
-                    _reader->_filted_rows++;
-                    row = merge_element->get_next_row();
-                    continue;
-                }
-            }
-            _heap->push(merge_element);
+    while (*row != NULL) {
+        _reader->_scan_rows++;
+        if (merge_element->data_file_type() == OLAP_DATA_FILE
+                && _reader->_delete_handler.is_filter_data(data_version, **row)) {
+            _reader->_filted_rows++;
+            *row = merge_element->get_next_row();
+            continue;
         }
 
-        break;
-    } while (true);
+        return true;
+    }
+
+    if (!merge_element->eof()) {
+        // Return error if merge_element isn't reach end, but row equal NULL.
+        OLAP_LOG_WARNING("internal error with IData.");
+        return false;
+    }
 
+    _reader->_filted_rows += merge_element->get_filted_rows();
     return true;
 }
 
+void Reader::MergeSet::_build_tree() {
+    int leaf_num = _leaves.size();
+
+    // leaf_num is used as a virtual leaf which beats all others, so that the
+    // tree can be built by replaying every leaf once.
+    _losers.assign(leaf_num, leaf_num);
+    _live_count = 0;
+    for (int i = leaf_num - 1; i >= 0; --i) {
+        if (_leaves[i] != NULL) {
+            ++_live_count;
+        }
+        _adjust(i);
+    }
+
+    _is_built = true;
+}
+
+void Reader::MergeSet::_adjust(int leaf) {
+    int winner = leaf;
+    for (int node = (leaf + _leaves.size()) / 2; node > 0; node /= 2) {
+        if (_beats(_losers[node], winner)) {
+            std::swap(_losers[node], winner);
+        }
+    }
+    _losers[0] = winner;
+}
+
+bool Reader::MergeSet::_beats(int a, int b) const {
+    int leaf_num = _leaves.size();
+    if (a == leaf_num) {
+        return true;
+    } else if (b == leaf_num) {
+        return false;
+    }
+
+    // leaf reaches end always loses
+    if (_leaves[a] == NULL) {
+        return false;
+    } else if (_leaves[b] == NULL) {
+        return true;
+    }
+
+    // First compare row cursor.
+    const RowCursor* first = _leaves[a]->get_current_row();
+    const RowCursor* second = _leaves[b]->get_current_row();
+    int cmp_res = first->full_key_cmp(*second);
+    if (cmp_res != 0) {
+        if (_reverse) {
+            return cmp_res > 0;
+        } else {
+            return cmp_res < 0;
+        }
+    }
+
+    // if row cursors equal, compare data version.
+    return _leaves[a]->version().second < _leaves[b]->version().second;
+}
+
 const RowCursor* Reader::MergeSet::curr(bool* delete_flag) {
-    if (_heap->size() > 0) {
-        *delete_flag = _heap->top()->delete_flag();
-        return _heap->top()->get_current_row();
+    MergeElement merge_element = curr_element();
+    if (merge_element != NULL) {
+        *delete_flag = merge_element->delete_flag();
+        return merge_element->get_current_row();
     } else {
         return NULL;
     }
 }
 
+Reader::MergeElement Reader::MergeSet::curr_element() {
+    if (!_is_built) {
+        _build_tree();
+    }
+
+    if (_losers.size() > 0) {
+        return _leaves[_losers[0]];
+    } else {
+        return NULL;
+    }
+}
+
+RowSource Reader::MergeSet::curr_source() {
+    return _sources[_losers[0]];
+}
+
 bool Reader::MergeSet::next(const RowCursor** element, bool* delete_flag) {
-    if (!_pop_from_heap()) {
+    if (!_pop_from_tree()) {
         return false;
     }
 
@@ -90,56 +255,53 @@ bool Reader::MergeSet::next(const RowCursor** element, bool* delete_flag) {
     return true;
 }
 
-bool Reader::MergeSet::_pop_from_heap() {
-    MergeElement merge_element = _heap->top();
+bool Reader::MergeSet::_pop_from_tree() {
+    MergeElement merge_element = curr_element();
+    if (merge_element == NULL) {
+        return true;
+    }
+
+    int winner = _losers[0];
     const RowCursor* row = merge_element->get_next_row();
 
-    // when Reader is used for fetch,
-    // Reader will read deltas one by one without merge sort in DUP_KEYS keys type,
-    // so we don't need to use pop and attach to adjust the _heap.
-    if (_reader->_reader_type == READER_FETCH
-            && _reader->_olap_table->keys_type() == KeysType::DUP_KEYS && row != NULL) {
+    // when Reader is merge free, Reader will read deltas one by one without
+    // merge sort, so we don't need to adjust the tree.
+    if (_reader->_is_merge_free && row != NULL) {
         _reader->_scan_rows++;
         if (merge_element->data_file_type() == OLAP_DATA_FILE) {
             int32_t data_version = merge_element->version().second;
             if (_reader->_delete_handler.is_filter_data(data_version, *row)) {
                 _reader->_filted_rows++;
-                return _pop_from_heap();
+                return _pop_from_tree();
             }
         }
         return true;
     }
 
-    _heap->pop();
-    return attach(merge_element, row);
-}
+    if (!_skip_deleted_rows(merge_element, &row)) {
+        return false;
+    }
 
-bool Reader::MergeSet::clear() {
-    if (_heap != NULL) {
-        while (_heap->size() > 0) {
-            _heap->pop();
-        }
+    if (row == NULL) {
+        _leaves[winner] = NULL;
+        --_live_count;
     }
-    return true;
-}
 
-bool Reader::MergeSet::RowCursorComparator::operator()(
-        const MergeElement &a,
-        const MergeElement &b) {
-    // First compare row cursor.
-    const RowCursor* first = a->get_current_row();
-    const RowCursor* second = b->get_current_row();
-    int cmp_res = first->full_key_cmp(*second);
-    if (cmp_res != 0) {
-        if (_reverse) {
-            return cmp_res < 0;
-        } else {
-            return cmp_res > 0;
-        }
+    // the only one left leaf is still the winner
+    if (row == NULL || _live_count > 1) {
+        _adjust(winner);
     }
 
-    // if row cursors equal, compare data version.
-    return a->version().second > b->version().second;
+    return true;
+}
+
+bool Reader::MergeSet::clear() {
+    _leaves.clear();
+    _sources.clear();
+    _losers.clear();
+    _live_count = 0;
+    _is_built = false;
+    return true;
 }
 
 OLAPStatus Reader::init(const ReaderParams& read_params) {
@@ -200,6 +362,9 @@ OLAPStatus Reader::next_row_with_aggregation(
                     _next_key->to_string().c_str());
             return res;
         }
+        if (NULL != _row_sources) {
+            _row_sources->push_back(_merge_set.curr_source());
+        }
         ++(*raw_rows_read);
     
         int64_t merged_count = 0;
@@ -215,11 +380,13 @@ OLAPStatus Reader::next_row_with_aggregation(
                 break;
             }
     
-            // we will not do aggregation in two case:
+            // we will not do aggregation in three case:
             //   1. DUP_KEYS keys type has no semantic to aggregate,
             //   2. to make cost of  each scan round reasonable, we will control merged_count.
+            //   3. adaptive merge found merging not worth its cost.
             if (_olap_table->keys_type() == KeysType::DUP_KEYS
-                    || (_aggregation && merged_count > config::palo_scanner_row_num)) {
+                    || (_aggregation && merged_count > config::palo_scanner_row_num)
+                    || _is_merge_free) {
                row_cursor->finalize_one_merge(); 
                break;
             }
@@ -237,6 +404,9 @@ OLAPStatus Reader::next_row_with_aggregation(
                         row_cursor->to_string().c_str(), _next_key->to_string().c_str());
                 break;
             }
+            if (NULL != _row_sources) {
+                _row_sources->push_back(_merge_set.curr_source() | ROW_SOURCE_AGG_FLAG);
+            }
     
             ++merged_count;
         }
@@ -244,6 +414,9 @@ OLAPStatus Reader::next_row_with_aggregation(
         if (res == OLAP_SUCCESS) {
             _merged_rows += merged_count;
             *raw_rows_read += merged_count;
+            if (_is_adaptive_merge) {
+                _update_merge_reduction(merged_count);
+            }
         }
     
         if (res != OLAP_SUCCESS || !cur_delete_flag) {
@@ -256,6 +429,232 @@ OLAPStatus Reader::next_row_with_aggregation(
     return res;
 }
 
+bool Reader::is_aggregation_free() const {
+    return _olap_table->keys_type() == KeysType::DUP_KEYS || _is_merge_free;
+}
+
+OLAPStatus Reader::next_row(const RowCursor** row_cursor, int64_t* raw_rows_read, bool* eof) {
+    if (!is_aggregation_free()) {
+        OLAP_LOG_WARNING("next row is only supported when reader is aggregation free.");
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+
+    OLAPStatus res = OLAP_SUCCESS;
+    *eof = false;
+
+    while (true) {
+        // the row returned last time is kept in its data source until now
+        if (_is_next_key_returned) {
+            _is_next_key_returned = false;
+            if (!_merge_set.next(&_next_key, &_next_delete_flag)) {
+                OLAP_LOG_WARNING("internal error with IData.");
+                return OLAP_ERR_READER_READING_ERROR;
+            }
+        }
+
+        if (NULL == _next_key) {
+            ++_current_key_index;
+            res = _attach_data_to_merge_set(false, eof);
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("failed to attach data to merge set.");
+                return res;
+            }
+            if (*eof) {
+                return OLAP_SUCCESS;
+            }
+        }
+
+        ++(*raw_rows_read);
+        _is_next_key_returned = true;
+        if (_next_delete_flag) {
+            ++_filted_rows;
+            continue;
+        }
+
+        *row_cursor = _next_key;
+        return OLAP_SUCCESS;
+    }
+}
+
+OLAPStatus Reader::next_block(VectorizedRowBatch* batch, int64_t* raw_rows_read, bool* eof) {
+    if (!_is_merge_free) {
+        OLAP_LOG_WARNING("next block is only supported when reader is merge free.");
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+
+    OLAPStatus res = OLAP_SUCCESS;
+    *eof = false;
+
+    while (batch->size() < batch->capacity()) {
+        if (NULL == _next_key) {
+            ++_current_key_index;
+            res = _attach_data_to_merge_set(false, eof);
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("failed to attach data to merge set.");
+                return res;
+            }
+            if (*eof) {
+                // report eof in next call if some rows have been read
+                *eof = (0 == batch->size());
+                break;
+            }
+        }
+
+        ++(*raw_rows_read);
+        if (_next_delete_flag) {
+            ++_filted_rows;
+        } else {
+            int row_index = batch->size();
+            for (size_t i = 0; i < _return_columns.size(); ++i) {
+                res = _next_key->write_to_vector(
+                        _return_columns[i], batch->column(i), row_index, batch->mem_pool());
+                if (OLAP_SUCCESS != res) {
+                    OLAP_LOG_WARNING("failed to write row to vector. [res=%d column=%u]",
+                                     res, _return_columns[i]);
+                    return res;
+                }
+            }
+            batch->set_size(row_index + 1);
+
+            // merge free reader reads data sources one by one, so the rest rows of
+            // current data source can be read in batch directly.
+            uint32_t rows_read = 0;
+            res = _merge_set.curr_element()->get_next_block(batch, &rows_read);
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("failed to read block from IData. [res=%d]", res);
+                return res;
+            }
+            _scan_rows += rows_read;
+            *raw_rows_read += rows_read;
+        }
+
+        if (!_merge_set.next(&_next_key, &_next_delete_flag)) {
+            OLAP_LOG_WARNING("internal error with IData.");
+            return OLAP_ERR_READER_READING_ERROR;
+        }
+    }
+
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus Reader::next_block_with_aggregation(VectorizedRowBatch* batch,
+                                               int64_t* raw_rows_read,
+                                               bool* eof) {
+    if (!_is_block_aggregation_supported) {
+        OLAP_LOG_WARNING("next block with aggregation is not supported.");
+        return OLAP_ERR_FUNC_NOT_IMPLEMENTED;
+    }
+
+    OLAPStatus res = OLAP_SUCCESS;
+    *eof = false;
+
+    while (batch->size() < batch->capacity()) {
+        if (NULL == _next_key) {
+            ++_current_key_index;
+            res = _attach_data_to_merge_set(false, eof);
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("failed to attach data to merge set.");
+                return res;
+            }
+            if (*eof) {
+                // report eof in next call if some rows have been read
+                *eof = (0 == batch->size());
+                break;
+            }
+        }
+
+        // write the first row of equal keys into batch, and aggregate the others on it
+        int row_index = batch->size();
+        bool cur_delete_flag = _next_delete_flag;
+        for (size_t i = 0; i < _return_columns.size(); ++i) {
+            res = _next_key->write_to_vector(
+                    _return_columns[i], batch->column(i), row_index, batch->mem_pool());
+            if (OLAP_SUCCESS != res) {
+                OLAP_LOG_WARNING("failed to write row to vector. [res=%d column=%u]",
+                                 res, _return_columns[i]);
+                return res;
+            }
+        }
+        res = _key_cursor.copy(*_next_key);
+        if (OLAP_SUCCESS != res) {
+            OLAP_LOG_WARNING("failed to copy key cursor. [res=%d]", res);
+            return res;
+        }
+        ++(*raw_rows_read);
+
+        int64_t merged_count = 0;
+        while (true) {
+            if (!_merge_set.next(&_next_key, &_next_delete_flag)) {
+                OLAP_LOG_WARNING("internal error with IData.");
+                return OLAP_ERR_READER_READING_ERROR;
+            }
+
+            // same as next_row_with_aggregation, control merged_count to make
+            // cost of each scan round reasonable
+            if (NULL == _next_key
+                    || (_aggregation && merged_count > config::palo_scanner_row_num)
+                    || _is_merge_free
+                    || !_key_cursor.equal(*_next_key)) {
+                break;
+            }
+
+            cur_delete_flag = _next_delete_flag;
+            for (size_t i = 0; i < _return_columns.size(); ++i) {
+                if (NULL == _column_aggregate_funcs[i]) {
+                    continue;
+                }
+
+                res = _column_aggregate_funcs[i](*_next_key, _return_columns[i],
+                                                 batch->column(i), row_index,
+                                                 batch->mem_pool());
+                if (OLAP_SUCCESS != res) {
+                    OLAP_LOG_WARNING("failed to aggregate column. [res=%d column=%u]",
+                                     res, _return_columns[i]);
+                    return res;
+                }
+            }
+            ++merged_count;
+        }
+
+        _merged_rows += merged_count;
+        *raw_rows_read += merged_count;
+        if (_is_adaptive_merge) {
+            _update_merge_reduction(merged_count);
+        }
+
+        // the row in batch is overwritten by next row if it's deleted
+        if (cur_delete_flag) {
+            ++_filted_rows;
+        } else {
+            batch->set_size(row_index + 1);
+        }
+    }
+
+    return OLAP_SUCCESS;
+}
+
+void Reader::_update_merge_reduction(int64_t merged_count) {
+    _merge_sample_rows += 1 + merged_count;
+    _merge_sample_merged_rows += merged_count;
+    if (_merge_sample_rows < config::storage_merge_sample_rows) {
+        return;
+    }
+
+    // rows read / rows returned of the sample
+    double reduction = static_cast<double>(_merge_sample_rows)
+            / (_merge_sample_rows - _merge_sample_merged_rows);
+    if (reduction < config::storage_merge_min_reduction) {
+        // the merge tree is not adjusted from now on, and the rest rows of a data
+        // source are returned before the next one
+        OLAP_LOG_DEBUG("stop merging rows. [table=%s reduction=%f]",
+                       _olap_table->full_name().c_str(), reduction);
+        _is_merge_free = true;
+        _is_adaptive_merge = false;
+    }
+    _merge_sample_rows = 0;
+    _merge_sample_merged_rows = 0;
+}
+
 void Reader::close() {
     OLAP_LOG_DEBUG("scan rows:%lu, filted rows:%lu, merged rows:%lu",
                    _scan_rows, _filted_rows, _merged_rows);
@@ -276,6 +675,11 @@ OLAPStatus Reader::_acquire_data_sources(const ReaderParams& read_params) {
     } else {
         _olap_table->obtain_header_rdlock();
         _olap_table->acquire_data_sources(_version, &_data_sources);
+        // the rows replaced by newer versions are skipped instead of merged
+        if (read_params.reader_type == READER_FETCH) {
+            _is_delete_bitmap_applied
+                    = _olap_table->apply_delete_bitmap(_version, _data_sources);
+        }
         _olap_table->release_header_lock();
 
         if (_data_sources.size() < 1) {
@@ -306,15 +710,81 @@ OLAPStatus Reader::_acquire_data_sources(const ReaderParams& read_params) {
                                 read_params.runtime_state);
     }
 
+    // rows of disjoint data sources never need to be merged across versions, and
+    // the rows with equal key in one data source are aggregated by upper layer
+    // when aggregation is set.
+    if (_reader_type == READER_FETCH) {
+        _is_merge_free = _olap_table->keys_type() == KeysType::DUP_KEYS
+                || _is_delete_bitmap_applied
+                || (_aggregation && _is_data_sources_disjoint());
+        // Rows with equal key in different data sources of a pre-aggregated scan
+        // may stay unmerged as well. Not for a delete data source, which removes
+        // the rows with equal key of older versions by merging.
+        _is_adaptive_merge = !_is_merge_free && _aggregation
+                && read_params.adaptive_aggregation
+                && _olap_table->keys_type() == KeysType::AGG_KEYS
+                && config::storage_merge_min_reduction > 0;
+        for (IData* i_data : _data_sources) {
+            if (i_data->delete_flag()) {
+                _is_adaptive_merge = false;
+            }
+        }
+        // frequently queried tablets are compacted first
+        _olap_table->add_query_count();
+    }
+
     return OLAP_SUCCESS;
 }
 
+bool Reader::_is_data_sources_disjoint() const {
+    // HLL value must be finalized by RowCursor, which is skipped by merge free reading
+    for (uint32_t column_id : _return_columns) {
+        if (_olap_table->tablet_schema()[column_id].type == OLAP_FIELD_TYPE_HLL) {
+            return false;
+        }
+    }
+
+    std::vector<std::pair<Field*, Field*> > ranges;
+    for (IData* i_data : _data_sources) {
+        if (i_data->empty()) {
+            continue;
+        }
+
+        OLAPIndex* olap_index = i_data->olap_index();
+        if (!olap_index->has_column_statistics()
+                || olap_index->get_column_statistics().empty()) {
+            return false;
+        }
+
+        const std::pair<Field*, Field*>& range = olap_index->get_column_statistics()[0];
+        if (range.first == NULL || range.second == NULL) {
+            return false;
+        }
+        ranges.push_back(range);
+    }
+
+    std::sort(ranges.begin(), ranges.end(),
+              [](const std::pair<Field*, Field*>& a, const std::pair<Field*, Field*>& b) {
+                  return a.first->cmp(b.first) < 0;
+              });
+
+    // rows with equal first key column may have equal full key in different sources
+    for (size_t i = 1; i < ranges.size(); ++i) {
+        if (ranges[i - 1].second->cmp(ranges[i].first) >= 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 OLAPStatus Reader::_init_params(const ReaderParams& read_params) {
     OLAPStatus res = OLAP_SUCCESS;
     _aggregation = read_params.aggregation;
     _reader_type = read_params.reader_type;
     _olap_table = read_params.olap_table;
     _version = read_params.version;
+    _row_sources = read_params.row_sources;
     
     res = _init_conditions_param(read_params);
     if (res != OLAP_SUCCESS) {
@@ -352,9 +822,110 @@ OLAPStatus Reader::_init_params(const ReaderParams& read_params) {
         return res;
     }
 
+    res = _init_block_aggregation();
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to init block aggregation. [res=%d]", res);
+        return res;
+    }
+
     return res;
 }
 
+OLAPStatus Reader::_init_block_aggregation() {
+    _is_block_aggregation_supported = false;
+    if (_reader_type != READER_FETCH || _olap_table->keys_type() == KeysType::DUP_KEYS) {
+        return OLAP_SUCCESS;
+    }
+
+    const std::vector<FieldInfo>& schema = _olap_table->tablet_schema();
+    std::vector<uint32_t> key_columns;
+    _column_aggregate_funcs.clear();
+    for (uint32_t column_id : _return_columns) {
+        const FieldInfo& field_info = schema[column_id];
+        if (field_info.is_key) {
+            key_columns.push_back(column_id);
+            _column_aggregate_funcs.push_back(NULL);
+            continue;
+        }
+
+        ColumnAggregateFunc func = NULL;
+        if (OLAP_FIELD_AGGREGATION_NONE == field_info.aggregation) {
+            _column_aggregate_funcs.push_back(NULL);
+            continue;
+        }
+
+        switch (field_info.type) {
+        case OLAP_FIELD_TYPE_TINYINT:
+            func = get_column_aggregate_func<int8_t>(field_info.aggregation);
+            break;
+        case OLAP_FIELD_TYPE_UNSIGNED_TINYINT:
+            func = get_column_aggregate_func<uint8_t>(field_info.aggregation);
+            break;
+        case OLAP_FIELD_TYPE_SMALLINT:
+            func = get_column_aggregate_func<int16_t>(field_info.aggregation);
+            break;
+        case OLAP_FIELD_TYPE_UNSIGNED_SMALLINT:
+            func = get_column_aggregate_func<uint16_t>(field_info.aggregation);
+            break;
+        case OLAP_FIELD_TYPE_INT:
+            func = get_column_aggregate_func<int32_t>(field_info.aggregation);
+            break;
+        case OLAP_FIELD_TYPE_UNSIGNED_INT:
+            func = get_column_aggregate_func<uint32_t>(field_info.aggregation);
+            break;
+        case OLAP_FIELD_TYPE_BIGINT:
+            func = get_column_aggregate_func<int64_t>(field_info.aggregation);
+            break;
+        case OLAP_FIELD_TYPE_UNSIGNED_BIGINT:
+            func = get_column_aggregate_func<uint64_t>(field_info.aggregation);
+            break;
+        case OLAP_FIELD_TYPE_LARGEINT:
+            func = get_column_aggregate_func<int128_t>(field_info.aggregation);
+            break;
+        case OLAP_FIELD_TYPE_FLOAT:
+            func = get_column_aggregate_func<float>(field_info.aggregation);
+            break;
+        case OLAP_FIELD_TYPE_DOUBLE:
+            func = get_column_aggregate_func<double>(field_info.aggregation);
+            break;
+        case OLAP_FIELD_TYPE_DATE:
+            func = get_column_aggregate_func<uint24_t>(field_info.aggregation);
+            break;
+        case OLAP_FIELD_TYPE_DATETIME:
+            func = get_column_aggregate_func<int64_t>(field_info.aggregation);
+            break;
+        case OLAP_FIELD_TYPE_DECIMAL:
+            func = get_column_aggregate_func<decimal12_t>(field_info.aggregation);
+            break;
+        case OLAP_FIELD_TYPE_CHAR:
+        case OLAP_FIELD_TYPE_VARCHAR:
+            if (OLAP_FIELD_AGGREGATION_REPLACE == field_info.aggregation) {
+                func = &replace_string_column;
+            }
+            break;
+        default:
+            break;
+        }
+
+        if (NULL == func) {
+            OLAP_LOG_DEBUG("block aggregation is not supported. [column=%s type=%d aggregation=%d]",
+                           field_info.name.c_str(), field_info.type, field_info.aggregation);
+            _column_aggregate_funcs.clear();
+            return OLAP_SUCCESS;
+        }
+        _column_aggregate_funcs.push_back(func);
+    }
+
+    OLAPStatus res = _key_cursor.init(schema, key_columns);
+    if (OLAP_SUCCESS != res) {
+        OLAP_LOG_WARNING("fail to init key cursor. [res=%d]", res);
+        return res;
+    }
+
+    _is_block_aggregation_supported = true;
+    return OLAP_SUCCESS;
+}
+
 OLAPStatus Reader::_init_return_columns(const ReaderParams& read_params) {
     if (read_params.reader_type == READER_FETCH) {
         _return_columns = read_params.return_columns;
@@ -377,6 +948,9 @@ OLAPStatus Reader::_init_return_columns(const ReaderParams& read_params) {
         OLAP_LOG_DEBUG("return column is empty, using full column as defaut.");
     } else if (read_params.reader_type == READER_CHECKSUM) {
         // do nothing
+    } else if (read_params.row_sources != NULL) {
+        // the key columns merged first by vertical merge
+        _return_columns = read_params.return_columns;
     } else {
         OLAP_LOG_WARNING("fail to init return columns. [reader_type=%d return_columns_size=%u]",
                          read_params.reader_type, read_params.return_columns.size());
@@ -387,6 +961,10 @@ OLAPStatus Reader::_init_return_columns(const ReaderParams& read_params) {
 }
 
 OLAPStatus Reader::_attach_data_to_merge_set(bool first, bool *eof) {
+    if (_skip_scan_keys != NULL) {
+        return _attach_skip_scan_key(first, eof);
+    }
+
     OLAPStatus res = OLAP_SUCCESS;
     *eof = false;
 
@@ -396,13 +974,14 @@ OLAPStatus Reader::_attach_data_to_merge_set(bool first, bool *eof) {
         bool find_last_row = false;
         bool end_key_find_last_row = false;
 
-        _merge_set.clear();
-
         if (_keys_param.start_keys.size() > 0) {
-            if (_current_key_index >= _keys_param.start_keys.size()) {
-                *eof = true;
-                OLAP_LOG_DEBUG("can NOT attach while start_key has been used.");
-                return res;
+            {
+                AutoMutexLock lock(&_key_range_lock);
+                if (_current_key_index >= _key_range_end) {
+                    *eof = true;
+                    OLAP_LOG_DEBUG("can NOT attach while start_key has been used.");
+                    return res;
+                }
             }
             start_key = _keys_param.start_keys[_current_key_index];
 
@@ -460,94 +1039,151 @@ OLAPStatus Reader::_attach_data_to_merge_set(bool first, bool *eof) {
             return res;
         }
 
-        for (std::vector<IData *>::iterator it = _data_sources.begin();
-                it != _data_sources.end(); ++it) {
-            const RowCursor *start_row_cursor = NULL;
-
-            if (OLAP_LIKELY(start_key != NULL)) {
-                if ((*it)->delta_pruning_filter()) {
-                    OLAP_LOG_DEBUG("filter delta in query in condition: %d, %d",
-                                   (*it)->version().first, (*it)->version().second);
-                    _filted_rows += (*it)->num_rows();
-                    continue;
-                }
+        res = _attach_key_range(start_key, find_last_row, end_key, end_key_find_last_row);
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
+        if (_next_key != NULL) {
+            break;
+        }
 
-                int ret = (*it)->delete_pruning_filter();
-                if (DEL_SATISFIED == ret) {
-                    OLAP_LOG_DEBUG("filter delta in query: %d, %d",
-                                   (*it)->version().first, (*it)->version().second);
-                    _filted_rows += (*it)->num_rows();
-                    continue;
-                } else if (DEL_PARTIAL_SATISFIED == ret) {
-                    OLAP_LOG_DEBUG("filter delta partially in query: %d, %d",
-                                   (*it)->version().first, (*it)->version().second);
-                    (*it)->set_delete_status(DEL_PARTIAL_SATISFIED);
-                } else {
-                    OLAP_LOG_DEBUG("not filter delta in query: %d, %d",
-                                   (*it)->version().first, (*it)->version().second);
-                    (*it)->set_delete_status(DEL_NOT_SATISFIED);
-                }
+        ++_current_key_index;
+        first = false;
+    } while (NULL == _next_key);
 
-                (*it)->set_end_key(end_key, end_key_find_last_row);
-                start_row_cursor = (*it)->find_row(*start_key, find_last_row, false);
-            } else {
-                if ((*it)->empty()) {
-                    continue;
-                }
+    return res;
+}
 
-                //BE procedure will go into this branch, which key params is empty
-                int ret = (*it)->delete_pruning_filter();
-                if (DEL_SATISFIED == ret) {
-                    OLAP_LOG_DEBUG("filter delta in query: %d, %d",
-                                   (*it)->version().first, (*it)->version().second);
-                    _filted_rows += (*it)->num_rows();
-                    continue;
-                } else if (DEL_PARTIAL_SATISFIED == ret) {
-                    OLAP_LOG_DEBUG("filter delta partially in query: %d, %d",
-                                   (*it)->version().first, (*it)->version().second);
-                    (*it)->set_delete_status(DEL_PARTIAL_SATISFIED);
-                } else {
-                    OLAP_LOG_DEBUG("not filter delta in query: %d, %d",
-                                   (*it)->version().first, (*it)->version().second);
-                    (*it)->set_delete_status(DEL_NOT_SATISFIED);
-                }
+OLAPStatus Reader::_attach_key_range(const RowCursor* start_key,
+                                     bool find_last_row,
+                                     const RowCursor* end_key,
+                                     bool end_key_find_last_row) {
+    _merge_set.clear();
+
+    for (std::vector<IData *>::iterator it = _data_sources.begin();
+            it != _data_sources.end(); ++it) {
+        const RowCursor *start_row_cursor = NULL;
+
+        if (OLAP_LIKELY(start_key != NULL)) {
+            if ((*it)->delta_pruning_filter()) {
+                OLAP_LOG_DEBUG("filter delta in query in condition: %d, %d",
+                               (*it)->version().first, (*it)->version().second);
+                _filted_rows += (*it)->num_rows();
+                continue;
+            }
 
-                start_row_cursor = (*it)->get_first_row();
+            int ret = (*it)->delete_pruning_filter();
+            if (DEL_SATISFIED == ret) {
+                OLAP_LOG_DEBUG("filter delta in query: %d, %d",
+                               (*it)->version().first, (*it)->version().second);
+                _filted_rows += (*it)->num_rows();
+                continue;
+            } else if (DEL_PARTIAL_SATISFIED == ret) {
+                OLAP_LOG_DEBUG("filter delta partially in query: %d, %d",
+                               (*it)->version().first, (*it)->version().second);
+                (*it)->set_delete_status(DEL_PARTIAL_SATISFIED);
+            } else {
+                OLAP_LOG_DEBUG("not filter delta in query: %d, %d",
+                               (*it)->version().first, (*it)->version().second);
+                (*it)->set_delete_status(DEL_NOT_SATISFIED);
             }
 
-            if ((*it)->eof()) {
-                OLAP_LOG_DEBUG("got EOF while setting start_row_cursor. "
-                               "[version=%d-%d read_params='%s']",
-                               (*it)->version().first, (*it)->version().second,
-                               _keys_param.to_string().c_str());
+            (*it)->set_end_key(end_key, end_key_find_last_row);
+            start_row_cursor = (*it)->find_row(*start_key, find_last_row, false);
+        } else {
+            if ((*it)->empty()) {
                 continue;
             }
 
-            if (!start_row_cursor) {
-                OLAP_LOG_WARNING("failed to set start_row_cursor. [read_params='%s']",
-                        _keys_param.to_string().c_str());
-                return OLAP_ERR_READER_GET_ITERATOR_ERROR;
+            //BE procedure will go into this branch, which key params is empty
+            int ret = (*it)->delete_pruning_filter();
+            if (DEL_SATISFIED == ret) {
+                OLAP_LOG_DEBUG("filter delta in query: %d, %d",
+                               (*it)->version().first, (*it)->version().second);
+                _filted_rows += (*it)->num_rows();
+                continue;
+            } else if (DEL_PARTIAL_SATISFIED == ret) {
+                OLAP_LOG_DEBUG("filter delta partially in query: %d, %d",
+                               (*it)->version().first, (*it)->version().second);
+                (*it)->set_delete_status(DEL_PARTIAL_SATISFIED);
+            } else {
+                OLAP_LOG_DEBUG("not filter delta in query: %d, %d",
+                               (*it)->version().first, (*it)->version().second);
+                (*it)->set_delete_status(DEL_NOT_SATISFIED);
             }
 
-            _merge_set.attach(*it, start_row_cursor);
+            start_row_cursor = (*it)->get_first_row();
+        }
+
+        if ((*it)->eof()) {
+            OLAP_LOG_DEBUG("got EOF while setting start_row_cursor. "
+                           "[version=%d-%d read_params='%s']",
+                           (*it)->version().first, (*it)->version().second,
+                           _keys_param.to_string().c_str());
+            continue;
+        }
+
+        if (!start_row_cursor) {
+            OLAP_LOG_WARNING("failed to set start_row_cursor. [read_params='%s']",
+                    _keys_param.to_string().c_str());
+            return OLAP_ERR_READER_GET_ITERATOR_ERROR;
         }
 
-        _next_key = _merge_set.curr(&_next_delete_flag);
+        _merge_set.attach(*it, start_row_cursor, it - _data_sources.begin());
+    }
+
+    _next_key = _merge_set.curr(&_next_delete_flag);
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus Reader::_attach_skip_scan_key(bool first, bool* eof) {
+    *eof = false;
+    // 当前组合的数据已经读完, 换到下一个组合
+    if (!first && !_skip_scan_keys->next()) {
+        _next_key = NULL;
+        *eof = true;
+        return OLAP_SUCCESS;
+    }
+
+    while (true) {
+        const RowCursor* current = _skip_scan_keys->current();
+        OLAPStatus res = _attach_key_range(current, false, current, true);
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
         if (_next_key != NULL) {
-            break;
+            return OLAP_SUCCESS;
         }
 
-        ++_current_key_index;
-        first = false;
-    } while (NULL == _next_key);
+        // 没有当前组合的数据, 找到它后面的第一行, 跳过所有比这一行的前缀小的组合
+        res = _attach_key_range(current, false, _keys_param.end_keys[0], true);
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
+        if (_next_key == NULL || !_skip_scan_keys->seek(*_next_key)) {
+            _next_key = NULL;
+            *eof = true;
+            return OLAP_SUCCESS;
+        }
+    }
+}
 
-    return res;
+int32_t Reader::split_key_ranges() {
+    AutoMutexLock lock(&_key_range_lock);
+    // the key range at _current_key_index may be being read
+    int32_t num_left = _key_range_end - _current_key_index - 1;
+    if (num_left <= 0) {
+        return -1;
+    }
+    _key_range_end -= (num_left + 1) / 2;
+    return _key_range_end;
 }
 
 OLAPStatus Reader::_init_keys_param(const ReaderParams& read_params) {
     OLAPStatus res = OLAP_SUCCESS;
 
     _current_key_index = 0;
+    _key_range_end = read_params.start_key.size();
 
     if (read_params.start_key.size() == 0) {
         return OLAP_SUCCESS;
@@ -613,9 +1249,37 @@ OLAPStatus Reader::_init_keys_param(const ReaderParams& read_params) {
 
     //TODO:check the valid of start_key and end_key.(eg. start_key <= end_key)
 
+    if (!read_params.skip_scan_values.empty()) {
+        _init_skip_scan_keys(read_params);
+    }
+
     return OLAP_SUCCESS;
 }
 
+void Reader::_init_skip_scan_keys(const ReaderParams& read_params) {
+    // 跳跃扫描只用于唯一的一个闭区间, 并且读出的行中要有参与跳跃的key列,
+    // 否则按普通的区间读取, 由查询条件过滤
+    if (_keys_param.start_keys.size() != 1 || _keys_param.end_keys.size() != 1
+            || _keys_param.range != "ge" || _keys_param.end_range != "le") {
+        return;
+    }
+    for (uint32_t i = 0; i < read_params.skip_scan_values.size(); ++i) {
+        if (std::find(_return_columns.begin(), _return_columns.end(), i)
+                == _return_columns.end()) {
+            return;
+        }
+    }
+
+    std::unique_ptr<SkipScanKeys> skip_scan_keys(new(nothrow) SkipScanKeys());
+    if (skip_scan_keys == NULL
+            || skip_scan_keys->init(_olap_table->tablet_schema(),
+                                    read_params.skip_scan_values) != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to init skip scan keys, scan the key range instead.");
+        return;
+    }
+    _skip_scan_keys = std::move(skip_scan_keys);
+}
+
 OLAPStatus Reader::_init_conditions_param(const ReaderParams& read_params) {
     OLAPStatus res = OLAP_SUCCESS;
 
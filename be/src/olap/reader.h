@@ -32,13 +32,24 @@
 #include "olap/olap_cond.h"
 #include "olap/olap_define.h"
 #include "olap/row_cursor.h"
+#include "olap/skip_scan_keys.h"
+#include "olap/utils.h"
 #include "util/runtime_profile.h"
 
 namespace palo {
 
+class ColumnVector;
+class MemPool;
 class OLAPTable;
 class RowCursor;
 class RowBlock;
+class VectorizedRowBatch;
+
+// Merge order of the rows read by vertical merge, see Merger. A raw row read is
+// recorded as the index of its data source in ReaderParams.olap_data_arr, with
+// ROW_SOURCE_AGG_FLAG set if it is aggregated into the row before it.
+typedef uint16_t RowSource;
+static const RowSource ROW_SOURCE_AGG_FLAG = 0x8000;
 
 // Params for Reader,
 // mainly include tablet, data version and fetch range.
@@ -46,23 +57,34 @@ struct ReaderParams {
     SmartOLAPTable olap_table;
     ReaderType reader_type;
     bool aggregation;
+    // Rows with equal key may be returned unmerged and out of key order when merging
+    // them reduces few rows, the caller aggregates them again.
+    bool adaptive_aggregation;
     Version version;
     std::string range;
     std::string end_range;
     std::vector<TFetchStartKey> start_key;
     std::vector<TFetchEndKey> end_key;
+    // Values of each leading key column to skip-scan [start_key, end_key] with,
+    // see SkipScanKeys.
+    std::vector<std::vector<std::string>> skip_scan_values;
     std::vector<TCondition> conditions;
     std::vector<ExprContext*>* conjunct_ctxs;
     // The IData will be set when using Merger, eg Cumulative, BE.
     std::vector<IData*> olap_data_arr;
     std::vector<uint32_t> return_columns;
+    // If set, the merge reads only return_columns and appends the source of each
+    // raw row read to it.
+    std::vector<RowSource>* row_sources;
     RuntimeProfile* profile;
     RuntimeState* runtime_state;
 
     ReaderParams() :
             reader_type(READER_FETCH),
             aggregation(true),
+            adaptive_aggregation(false),
             conjunct_ctxs(NULL),
+            row_sources(NULL),
             profile(NULL),
             runtime_state(NULL) {
         start_key.clear();
@@ -99,15 +121,31 @@ struct ReaderParams {
 
 class Reader {
 public:
+    // Aggregate the column of row into the row_index-th value of column vector.
+    typedef OLAPStatus (*ColumnAggregateFunc)(const RowCursor& row,
+                                              uint32_t column_id,
+                                              ColumnVector* column,
+                                              int row_index,
+                                              MemPool* mem_pool);
+
     Reader() :
             _is_inited(false),
             _aggregation(false),
             _version_locked(false),
             _reader_type(READER_FETCH),
             _is_set_data_sources(false),
+            _is_merge_free(false),
+            _is_delete_bitmap_applied(false),
+            _is_adaptive_merge(false),
+            _merge_sample_rows(0),
+            _merge_sample_merged_rows(0),
+            _is_block_aggregation_supported(false),
             _current_key_index(0),
+            _key_range_end(0),
             _next_key(NULL),
             _next_delete_flag(false),
+            _is_next_key_returned(false),
+            _row_sources(NULL),
             _scan_rows(0),
             _filted_rows(0),
             _merged_rows(0) {}
@@ -124,6 +162,47 @@ public:
     // Reader next row with aggregation.
     OLAPStatus next_row_with_aggregation(RowCursor *row_cursor, int64_t* raw_rows_read, bool *eof);
 
+    // Reader next row without copying it. *row_cursor points to the row held by the
+    // data source, valid until the next call. Only supported when is_aggregation_free(),
+    // next_row_with_aggregation() must not be called after it.
+    OLAPStatus next_row(const RowCursor** row_cursor, int64_t* raw_rows_read, bool* eof);
+
+    // Return true if rows with equal key are never aggregated, that is reading DUP_KEYS
+    // table or is_merge_free(). It may turn true while reading like is_merge_free().
+    bool is_aggregation_free() const;
+
+    // Reader next rows into batch in storage format without RowCursor, columns of batch
+    // are in the order of return_columns(). Only supported when is_merge_free().
+    // eof is set only when no row is read.
+    OLAPStatus next_block(VectorizedRowBatch* batch, int64_t* raw_rows_read, bool* eof);
+
+    // Return true if data sources can be read one by one without merge sort and
+    // aggregation, that is fetching DUP_KEYS table, or pre-aggregated fetching of
+    // data sources whose key ranges are disjoint. It may turn true while reading
+    // when ReaderParams.adaptive_aggregation is set.
+    bool is_merge_free() const {
+        return _is_merge_free;
+    }
+
+    // Reader next rows with aggregation into batch in storage format, columns of batch
+    // are in the order of return_columns(). Value columns of rows with equal key are
+    // aggregated in batch directly, without copying rows into RowCursor.
+    // Only supported when is_block_aggregation_supported().
+    // eof is set only when no row is read.
+    OLAPStatus next_block_with_aggregation(VectorizedRowBatch* batch,
+                                           int64_t* raw_rows_read,
+                                           bool* eof);
+
+    // Return true if all the value columns to return can be aggregated by
+    // next_block_with_aggregation, HLL_UNION and MIN/MAX/SUM of string are not supported.
+    bool is_block_aggregation_supported() const {
+        return _is_block_aggregation_supported;
+    }
+
+    const std::vector<uint32_t>& return_columns() const {
+        return _return_columns;
+    }
+
     uint64_t merged_rows() const {
         return _merged_rows;
     }
@@ -132,6 +211,12 @@ public:
         return _filted_rows;
     }
 
+    // Give up the second half of the key ranges which are not started yet, so that
+    // they can be scanned by another reader. Returns the index of the first key range
+    // given up, or -1 if there is no key range left to give up.
+    // It can be called by another thread while this reader is reading.
+    int32_t split_key_ranges();
+
 private:
     struct KeysParam {
         ~KeysParam() {
@@ -168,23 +253,32 @@ private:
 
     typedef IData* MergeElement;
 
-    // Use priority_queue as heap to merge multiple data versions.
+    // Use loser tree to merge multiple data versions. After the winner moves to
+    // its next row, only the path from its leaf to the root is replayed, which
+    // costs log(n) row comparisons per row instead of about 2*log(n) of a heap.
     class MergeSet {
     public:
-        MergeSet() : _heap(NULL) {}
+        MergeSet() : _is_built(false), _reverse(false), _live_count(0), _reader(NULL) {}
         ~MergeSet();
 
         // Hold reader point to get reader params, 
         // set reverse to true if need read in reverse order.
         OLAPStatus init(Reader* reader, bool reverse);
 
-        // Add merge element into heap.
-        bool attach(const MergeElement& merge_element, const RowCursor* row);
+        // Add merge element into tree, source is its index in the data sources.
+        bool attach(const MergeElement& merge_element, const RowCursor* row,
+                    RowSource source);
 
-        // Get top row of the heap, NULL if reach end.
+        // Get current row of the winner, NULL if reach end.
         const RowCursor* curr(bool* delete_flag);
 
-        // Pop the top element and rebuild the heap to 
+        // Get the winner element, NULL if reach end.
+        MergeElement curr_element();
+
+        // Get the source of the winner element, only valid if it is not NULL.
+        RowSource curr_source();
+
+        // Move the winner element to its next row and replay the tree to
         // get the next row cursor.
         bool next(const RowCursor** element, bool* delete_flag);
 
@@ -192,25 +286,36 @@ private:
         bool clear();
 
     private:
-        // Compare row cursors between multiple merge elements,
+        // Skip the rows filtered by delete conditions, row is set to NULL
+        // when merge_element reaches end.
+        bool _skip_deleted_rows(const MergeElement& merge_element, const RowCursor** row);
+
+        // Build the tree from all attached elements.
+        void _build_tree();
+
+        // Replay the matches from leaf to root.
+        void _adjust(int leaf);
+
+        // Return true if the current row of leaf a should be read before leaf b's,
         // if row cursors equal, compare data version.
-        class RowCursorComparator {
-        public:
-            explicit RowCursorComparator(bool reverse) : _reverse(reverse) {}
-            bool operator()(const MergeElement& a, const MergeElement& b);
+        bool _beats(int a, int b) const;
 
-        private:
-            bool _reverse;
-        };
+        bool _pop_from_tree();
 
-        typedef std::priority_queue<MergeElement, std::vector<MergeElement>, RowCursorComparator>
-            heap_t;
-        
-        bool _pop_from_heap();
+        // Merge elements as leaves of the tree, NULL if the element reaches end.
+        std::vector<MergeElement> _leaves;
+        // source of each leaf
+        std::vector<RowSource> _sources;
 
-        heap_t* _heap;
+        // _losers[0] is the winner leaf, others are the loser leaves of each match.
+        std::vector<int> _losers;
 
-        uint64_t _merge_count;
+        bool _is_built;
+        bool _reverse;
+
+        // Number of leaves not reach end, there is nothing to compare when only
+        // one leaf is left, so its rows are read directly.
+        int _live_count;
 
         // Hold reader point to access read params, such as fetch conditions.
         Reader* _reader;
@@ -232,8 +337,31 @@ private:
 
     OLAPStatus _init_load_bf_columns(const ReaderParams& read_params);
 
+    OLAPStatus _init_block_aggregation();
+
     OLAPStatus _attach_data_to_merge_set(bool first, bool *eof);
 
+    // Attach data sources positioned at [start_key, end_key] to merge set, and
+    // set _next_key to the first row, NULL if there is no row in the range.
+    OLAPStatus _attach_key_range(const RowCursor* start_key,
+                                 bool find_last_row,
+                                 const RowCursor* end_key,
+                                 bool end_key_find_last_row);
+
+    // _attach_data_to_merge_set() for skip scan: attach the rows of the next
+    // combination of key column values which has rows.
+    OLAPStatus _attach_skip_scan_key(bool first, bool* eof);
+
+    void _init_skip_scan_keys(const ReaderParams& read_params);
+
+    // Check whether key ranges of data sources are disjoint with each other
+    // according to the column statistics of the first key column.
+    bool _is_data_sources_disjoint() const;
+
+    // Count a row merged from 1 + merged_count rows into the sample of the adaptive
+    // merge, and turn merge free when the sample is reduced too little.
+    void _update_merge_reduction(int64_t merged_count);
+
     bool _is_inited;
     bool _aggregation;
     bool _version_locked;
@@ -249,9 +377,30 @@ private:
     // will not acquire data sources according to version.
     bool _is_set_data_sources;
 
+    bool _is_merge_free;
+    // Set if the rows replaced by newer versions of a merge-on-write table are
+    // skipped by the data sources, see DeleteBitmap.
+    bool _is_delete_bitmap_applied;
+    // Set if the reader measures how much merging reduces the rows, and stops
+    // merging if it doesn't pay off. Rows read and rows merged of current sample.
+    bool _is_adaptive_merge;
+    int64_t _merge_sample_rows;
+    int64_t _merge_sample_merged_rows;
+
+    bool _is_block_aggregation_supported;
+    // hold key columns of current row of next_block_with_aggregation
+    RowCursor _key_cursor;
+    // aggregate function of each return column, NULL for key column
+    std::vector<ColumnAggregateFunc> _column_aggregate_funcs;
+
     KeysParam _keys_param;
 
     int32_t _current_key_index;
+    // not NULL when skip scanning the only key range
+    std::unique_ptr<SkipScanKeys> _skip_scan_keys;
+    // key ranges from _key_range_end on are given up by split_key_ranges()
+    int32_t _key_range_end;
+    MutexLock _key_range_lock;
 
     Conditions _conditions;
 
@@ -263,6 +412,11 @@ private:
 
     const RowCursor* _next_key;
     bool _next_delete_flag;
+    // _next_key has been returned by next_row(), the merge set is advanced in the next call
+    bool _is_next_key_returned;
+
+    // ReaderParams.row_sources
+    std::vector<RowSource>* _row_sources;
 
     std::set<uint32_t> _load_bf_columns;
     std::vector<uint32_t> _return_columns;
@@ -150,6 +150,17 @@ OLAPStatus RowBlock::eval_conjuncts(std::vector<ExprContext*> conjunct_ctxs) {
 
 OLAPStatus RowBlock::eval_conjuncts(std::vector<ExprContext*> conjunct_ctxs,
                                     const std::vector<FieldInfo>& query_schema) {
+    VectorizedFilter filter;
+    filter.init(conjunct_ctxs, _tablet_schema);
+    return _eval_conjuncts(filter, query_schema);
+}
+
+OLAPStatus RowBlock::eval_conjuncts(const VectorizedFilter& filter) {
+    return _eval_conjuncts(filter, _tablet_schema);
+}
+
+OLAPStatus RowBlock::_eval_conjuncts(const VectorizedFilter& filter,
+                                     const std::vector<FieldInfo>& query_schema) {
     OLAPStatus status;
 
     status = _load_to_vectorized_row_batch(query_schema);
@@ -158,6 +169,22 @@ OLAPStatus RowBlock::eval_conjuncts(std::vector<ExprContext*> conjunct_ctxs,
         return status;
     }
 
+    if (!filter.empty()) {
+        // 直接在_buf上求值, 结果写入VectorizedRowBatch的选择向量
+        _init_filter_columns();
+        int* selected = _vectorized_row_batch->selected();
+        int size = _vectorized_row_batch->size();
+        if (!_vectorized_row_batch->selected_in_use()) {
+            for (int i = 0; i < size; ++i) {
+                selected[i] = i;
+            }
+        }
+        size = filter.evaluate(_filter_columns, selected, size);
+        _vectorized_row_batch->set_size(size);
+        _vectorized_row_batch->set_selected_in_use(true);
+    }
+
+    const std::vector<ExprContext*>& conjunct_ctxs = filter.fallback_conjunct_ctxs();
     for (int i = 0; i < conjunct_ctxs.size(); ++i) {
         if (!conjunct_ctxs[i]->root()->evaluate(_vectorized_row_batch)) {
             return OLAP_ERR_EVAL_CONJUNCTS_ERROR;
@@ -168,6 +195,28 @@ OLAPStatus RowBlock::eval_conjuncts(std::vector<ExprContext*> conjunct_ctxs,
     return OLAP_SUCCESS;
 }
 
+void RowBlock::_init_filter_columns() {
+    if (!_filter_columns.empty()) {
+        return;
+    }
+
+    bool is_nullable = (COLUMN_ORIENTED_FILE == _data_file_type || _null_supported);
+    _filter_columns.resize(_tablet_schema.size());
+    for (size_t i = 0; i < _tablet_schema.size(); ++i) {
+        if (_tablet_schema[i].type == OLAP_FIELD_TYPE_VARCHAR
+                || _tablet_schema[i].type == OLAP_FIELD_TYPE_HLL) {
+            continue;
+        }
+        FilterColumn& column = _filter_columns[i];
+        column.is_nullable = is_nullable;
+        column.stride = _grid_items[i].width;
+        column.data = _buf + _grid_items[i].offset + (is_nullable ? sizeof(char) : 0);
+        // null标记在值的前一个字节
+        column.null_flags = column.data - sizeof(char);
+        column.null_stride = column.stride;
+    }
+}
+
 OLAPStatus RowBlock::set_row(uint32_t row_index, const RowCursor& cursor) {
     CHECK_ROWBLOCK_INIT();
     if (row_index >= _info.row_num) {
@@ -591,6 +640,7 @@ void RowBlock::_set_field_offsets() {
 
         offset += _grid_items[i].width * _info.row_num;
     }
+    _filter_columns.clear();
 }
 
 inline bool RowBlock::_check_memory_limit(size_t _buf_len) const {
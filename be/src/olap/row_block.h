@@ -25,6 +25,7 @@
 #include "olap/olap_define.h"
 #include "olap/row_cursor.h"
 #include "olap/utils.h"
+#include "olap/vectorized_filter.h"
 #include "runtime/vectorized_row_batch.h"
 
 #define CHECK_ROWBLOCK_INIT() \
@@ -108,6 +109,9 @@ public:
     OLAPStatus eval_conjuncts(std::vector<ExprContext*> conjuncts,
                               const std::vector<FieldInfo>& query_schema);
 
+    // 使用预先编译好的filter执行过滤条件, 不能编译的conjunct仍然走Expr::evaluate
+    OLAPStatus eval_conjuncts(const VectorizedFilter& filter);
+
     inline OLAPStatus get_row_to_write(uint32_t row_index, 
                                       RowCursor* cursor) const;
 
@@ -224,6 +228,12 @@ private:
 
     OLAPStatus _load_to_vectorized_row_batch(const std::vector<FieldInfo>& query_schema);
 
+    OLAPStatus _eval_conjuncts(const VectorizedFilter& filter,
+                               const std::vector<FieldInfo>& query_schema);
+
+    // 生成VectorizedFilter访问定长列所需的位置信息
+    void _init_filter_columns();
+
     // rearrange string buffer
     OLAPStatus _rearrange_string_buffer(uint32_t row_num, size_t* output_size);
 
@@ -254,6 +264,7 @@ private:
     DataFileType _data_file_type;
 
     VectorizedRowBatch* _vectorized_row_batch;
+    std::vector<FilterColumn> _filter_columns;
 
     // 由于内部持有内存资源，所以这里禁止拷贝和赋值
     DISALLOW_COPY_AND_ASSIGN(RowBlock);
@@ -17,6 +17,10 @@
 
 #include <algorithm>
 
+#include "runtime/mem_pool.h"
+#include "runtime/string_value.h"
+#include "runtime/vectorized_row_batch.h"
+
 using std::min;
 using std::nothrow;
 using std::string;
@@ -33,6 +37,7 @@ RowCursor::RowCursor() :
         _length_mysql(0),
         _field_length_array(NULL),
         _field_offset(NULL),
+        _cmp_funcs(NULL),
         _is_inited(false),
         _buf(NULL),
         _is_mysql_compatible(true) {}
@@ -49,6 +54,7 @@ RowCursor::~RowCursor() {
     SAFE_DELETE_ARRAY(_field_array);
     SAFE_DELETE_ARRAY(_field_length_array);
     SAFE_DELETE_ARRAY(_field_offset);
+    SAFE_DELETE_ARRAY(_cmp_funcs);
     SAFE_DELETE_ARRAY(_columns);
     SAFE_DELETE_ARRAY(_buf);
 }
@@ -127,10 +133,12 @@ OLAPStatus RowCursor::_init(
     _columns = new (nothrow) uint32_t[columns.size()];
     _field_length_array = new (nothrow) size_t[_field_array_size];
     _field_offset = new (nothrow) size_t[_field_array_size];
+    _cmp_funcs = new (nothrow) FieldCmpFunc[_field_array_size];
     if (_field_array == NULL
             || _columns == NULL
             || _field_offset == NULL
-            || _field_length_array == NULL) {
+            || _field_length_array == NULL
+            || _cmp_funcs == NULL) {
         OLAP_LOG_WARNING("Fail to malloc internal structures."
                          "[tablet_schema_size=%lu; columns_size=%lu]",
                          tablet_schema.size(),
@@ -164,6 +172,7 @@ OLAPStatus RowCursor::_init(
         _field_array[i] = NULL;
         _field_length_array[i] = field_buf_lens[i] + sizeof(char);
         _field_offset[i] = field_buf_lens[i] + sizeof(char);
+        _cmp_funcs[i] = get_field_cmp_func(tablet_schema[i].type);
     }
 
     size_t len = 0;
@@ -237,7 +246,7 @@ int RowCursor::full_key_cmp(const RowCursor& other) const {
     // 只有key column才会参与比较
     int res = 0;
     for (size_t i = 0; i < _key_column_num; ++i) {
-        if (0 != (res = _field_array[i]->cmp(other._field_array[i]))) {
+        if (0 != (res = _cmp_funcs[i](_field_array[i], other._field_array[i]))) {
             return res;
         }
     }
@@ -260,7 +269,7 @@ int RowCursor::cmp(const RowCursor& other) const {
             continue;
         }
 
-        if (0 != (res = _field_array[i]->cmp(other._field_array[i]))) {
+        if (0 != (res = _cmp_funcs[i](_field_array[i], other._field_array[i]))) {
             return res;
         }
     }
@@ -611,6 +620,68 @@ OLAPStatus RowCursor::write_index_by_index(size_t index, char* index_buf) const
     return OLAP_SUCCESS;
 }
 
+OLAPStatus RowCursor::write_to_vector(size_t index,
+                                      ColumnVector* column_vector,
+                                      int row_index,
+                                      MemPool* mem_pool) const {
+    CHECK_ROWCURSOR_INIT();
+
+    if (index >= _field_array_size || NULL == _field_array[index]) {
+        OLAP_LOG_WARNING("index exceeds the max or field is not used. "
+                         "[index=%lu; max_index=%lu]",
+                         index,
+                         _field_array_size);
+        return OLAP_ERR_INPUT_PARAMETER_ERROR;
+    }
+
+    const Field* field = _field_array[index];
+    bool is_null = field->is_null();
+    column_vector->is_null()[row_index] = is_null;
+
+    switch (field->type()) {
+    case OLAP_FIELD_TYPE_CHAR: {
+        StringValue* value =
+                reinterpret_cast<StringValue*>(column_vector->col_data()) + row_index;
+        if (is_null) {
+            value->ptr = NULL;
+            value->len = 0;
+            break;
+        }
+
+        size_t len = strnlen(field->buf(), field->size());
+        value->ptr = reinterpret_cast<char*>(mem_pool->allocate(len));
+        memcpy(value->ptr, field->buf(), len);
+        value->len = len;
+        break;
+    }
+    case OLAP_FIELD_TYPE_VARCHAR:
+    case OLAP_FIELD_TYPE_HLL: {
+        StringValue* value =
+                reinterpret_cast<StringValue*>(column_vector->col_data()) + row_index;
+        if (is_null) {
+            value->ptr = NULL;
+            value->len = 0;
+            break;
+        }
+
+        size_t len = *reinterpret_cast<VarCharField::LengthValueType*>(field->buf());
+        value->ptr = reinterpret_cast<char*>(mem_pool->allocate(len));
+        memcpy(value->ptr, field->buf() + sizeof(VarCharField::LengthValueType), len);
+        value->len = len;
+        break;
+    }
+    default: {
+        size_t width = field->size();
+        memcpy(reinterpret_cast<char*>(column_vector->col_data()) + width * row_index,
+               field->buf(),
+               width);
+        break;
+    }
+    }
+
+    return OLAP_SUCCESS;
+}
+
 OLAPStatus RowCursor::from_string(const vector<string>& val_string_array) {
     CHECK_ROWCURSOR_INIT();
     
@@ -713,7 +784,7 @@ OLAPStatus RowCursor::get_first_different_column_id(const RowCursor& other,
             continue;
         }
             
-        if (_field_array[i]->cmp(other._field_array[i]) != 0) {
+        if (_cmp_funcs[i](_field_array[i], other._field_array[i]) != 0) {
             break;
         }
     }
@@ -30,7 +30,9 @@
     }
 
 namespace palo {
+class ColumnVector;
 class Field;
+class MemPool;
 
 // 代理一行数据的操作
 class RowCursor {
@@ -98,6 +100,13 @@ public:
     // 输出一列的index到buf
     OLAPStatus write_index_by_index(size_t index, char* buf) const;
 
+    // 将一列的值以存储格式写入column_vector的第row_index行, 格式与
+    // VectorizedRowBatch::prepare_storage_columns一致, 字符串数据拷贝到mem_pool中
+    OLAPStatus write_to_vector(size_t index,
+                               ColumnVector* column_vector,
+                               int row_index,
+                               MemPool* mem_pool) const;
+
     // 按列序号输出field的内容，传入vector，一次输出多列
     OLAPStatus write_by_indices_mysql(const std::vector<uint32_t>& indices,
                                   char* buf,
@@ -247,6 +256,7 @@ private:
     size_t _length_mysql;
     size_t* _field_length_array;       // 记录每一个field的storage格式长度
     size_t* _field_offset;
+    FieldCmpFunc* _cmp_funcs;          // 每一列按类型选定的比较函数
     bool _is_inited;                   // 初始化标记
     char* _buf;                        // Field使用的buf
     bool _is_mysql_compatible;
@@ -21,17 +21,23 @@
 #include <algorithm>
 #include <vector>
 
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
 #include "olap/field.h"
 #include "olap/i_data.h"
 #include "olap/merger.h"
 #include "olap/olap_data.h"
 #include "olap/olap_engine.h"
+#include "olap/olap_header.h"
+#include "olap/olap_rootpath.h"
 #include "olap/olap_table.h"
 #include "olap/row_block.h"
 #include "olap/row_cursor.h"
 #include "olap/writer.h"
 #include "common/resource_tls.h"
 #include "agent/cgroups_mgr.h"
+#include "util/palo_metrics.h"
 
 
 using std::deque;
@@ -446,18 +452,14 @@ RowBlockSorter::~RowBlockSorter() {
     }
 }
 
-bool RowBlockSorter::sort(RowBlock** row_block) {
-    uint32_t row_num = (*row_block)->row_block_info().row_num;
-    DataFileType data_file_type = (*row_block)->row_block_info().data_file_type;
-    bool null_supported = (*row_block)->row_block_info().null_supported;
-
-    if (_swap_row_block == NULL || _swap_row_block->allocated_row_num() < row_num) {
+bool RowBlockSorter::reserve(size_t num_rows, DataFileType data_file_type, bool null_supported) {
+    if (_swap_row_block == NULL || _swap_row_block->allocated_row_num() < num_rows) {
         if (_swap_row_block != NULL) {
             _row_block_allocator->release(_swap_row_block);
             _swap_row_block = NULL;
         }
 
-        if (_row_block_allocator->allocate(&_swap_row_block, row_num, 
+        if (_row_block_allocator->allocate(&_swap_row_block, num_rows, 
                                     data_file_type, null_supported) != OLAP_SUCCESS
                 || _swap_row_block == NULL) {
             OLAP_LOG_WARNING("fail to allocate memory.");
@@ -465,6 +467,18 @@ bool RowBlockSorter::sort(RowBlock** row_block) {
         }
     }
 
+    return true;
+}
+
+bool RowBlockSorter::sort(RowBlock** row_block) {
+    uint32_t row_num = (*row_block)->row_block_info().row_num;
+    DataFileType data_file_type = (*row_block)->row_block_info().data_file_type;
+    bool null_supported = (*row_block)->row_block_info().null_supported;
+
+    if (!reserve(row_num, data_file_type, null_supported)) {
+        return false;
+    }
+
     RowBlock* temp = NULL;
     vector<RowCursor*> row_cursor_list((*row_block)->row_block_info().row_num, NULL);
 
@@ -544,6 +558,7 @@ OLAPStatus RowBlockAllocator::allocate(RowBlock** row_block,
                                        DataFileType data_file_type,
                                        bool null_supported) {
     size_t row_block_size = _row_len * num_rows;
+    AutoMutexLock l(&_mutex);
 
     if (_memory_limitation > 0
             && _memory_allocated + row_block_size > _memory_limitation) {
@@ -588,6 +603,7 @@ void RowBlockAllocator::release(RowBlock* row_block) {
         return;
     }
 
+    AutoMutexLock l(&_mutex);
     _memory_allocated -= row_block->allocated_row_num() * _row_len;
 
     OLAP_LOG_DEBUG("RowBlockAllocator::release() "
@@ -755,35 +771,31 @@ bool SchemaChangeDirectly::_write_row_block(IWriter* writer, RowBlock* row_block
 }
 
 bool LinkedSchemaChange::process(IData* olap_data, OLAPIndex* new_olap_index) {
-    for (size_t i = 0; i < olap_data->olap_index()->num_segments(); ++i) {
-        string index_path = _new_olap_table->construct_index_file_path(
-                new_olap_index->version(), new_olap_index->version_hash(), i);
-        string base_table_index_path = _base_olap_table->construct_index_file_path(
-                new_olap_index->version(), new_olap_index->version_hash(), i);
-        if (link(base_table_index_path.c_str(), index_path.c_str()) == 0) {
-            OLAP_LOG_DEBUG("success to create hard link. [from_path=%s to_path=%s]",
-                           base_table_index_path.c_str(), index_path.c_str());
-        } else {
-            OLAP_LOG_WARNING("fail to create hard link. [from_path=%s to_path=%s]",
-                             base_table_index_path.c_str(), index_path.c_str());
-            return false;
-        }
-
-        string data_path = _new_olap_table->construct_data_file_path(
-                new_olap_index->version(), new_olap_index->version_hash(), i);
-        string base_table_data_path = _base_olap_table->construct_data_file_path(
-                new_olap_index->version(), new_olap_index->version_hash(), i);
-        if (link(base_table_data_path.c_str(), data_path.c_str()) == 0) {
+    OLAPIndex* base_index = olap_data->olap_index();
+    vector<string> base_table_paths;
+    vector<string> paths;
+    OLAPTable::construct_version_file_paths(
+            _base_olap_table->header_file_name(), new_olap_index->version(),
+            new_olap_index->version_hash(), base_index->num_segments(),
+            base_index->packed(), &base_table_paths);
+    OLAPTable::construct_version_file_paths(
+            _new_olap_table->header_file_name(), new_olap_index->version(),
+            new_olap_index->version_hash(), base_index->num_segments(),
+            base_index->packed(), &paths);
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (link(base_table_paths[i].c_str(), paths[i].c_str()) == 0) {
             OLAP_LOG_DEBUG("success to create hard link. [from_path=%s to_path=%s]",
-                           base_table_data_path.c_str(), data_path.c_str());
+                           base_table_paths[i].c_str(), paths[i].c_str());
         } else {
             OLAP_LOG_WARNING("fail to create hard link. [from_path=%s to_path=%s]",
-                             base_table_data_path.c_str(), data_path.c_str());
+                             base_table_paths[i].c_str(), paths[i].c_str());
             return false;
         }
     }
 
-    new_olap_index->set_num_segments(olap_data->olap_index()->num_segments());
+    new_olap_index->set_num_segments(base_index->num_segments());
+    new_olap_index->set_packed(base_index->packed());
 
     if (OLAP_SUCCESS != new_olap_index->load()) {
         OLAP_LOG_WARNING("fail to reload index. [table='%s' version='%d-%d']",
@@ -793,6 +805,31 @@ bool LinkedSchemaChange::process(IData* olap_data, OLAPIndex* new_olap_index) {
         return false;
     }
 
+    // 数据文件没有变化，key列的统计信息可以直接沿用，避免新表丢失delta pruning
+    OLAPIndex* base_olap_index = olap_data->olap_index();
+    if (base_olap_index->has_column_statistics()
+            && _base_olap_table->num_key_fields() == _new_olap_table->num_key_fields()) {
+        std::vector<std::pair<Field*, Field*> >& base_statistics =
+                base_olap_index->get_column_statistics();
+        std::vector<std::pair<std::string, std::string> > statistics_string(
+                base_statistics.size());
+        std::vector<bool> null_flags(base_statistics.size());
+        for (size_t i = 0; i < base_statistics.size(); ++i) {
+            statistics_string[i].first = base_statistics[i].first->to_string();
+            statistics_string[i].second = base_statistics[i].second->to_string();
+            null_flags[i] = base_statistics[i].first->is_null();
+        }
+
+        if (OLAP_SUCCESS != new_olap_index->set_column_statistics_from_string(
+                    statistics_string, null_flags)) {
+            OLAP_LOG_WARNING("fail to copy column statistics. [table='%s' version='%d-%d']",
+                             _new_olap_table->full_name().c_str(),
+                             new_olap_index->version().first,
+                             new_olap_index->version().second);
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -970,10 +1007,12 @@ DIRECTLY_PROCESS_ERR:
 
 SchemaChangeWithSorting::SchemaChangeWithSorting(SmartOLAPTable olap_table,
                                                  const RowBlockChanger& row_block_changer,
-                                                 size_t memory_limitation) :
+                                                 size_t memory_limitation,
+                                                 size_t sort_thread_num) :
         _olap_table(olap_table),
         _row_block_changer(row_block_changer),
         _memory_limitation(memory_limitation),
+        _sort_thread_num(std::max<size_t>(sort_thread_num, 1)),
         _row_block_allocator(NULL) {
     // 每次SchemaChange做外排的时候，会写一些临时版本（比如999,1000,1001），为避免Cache冲突，临时
     // 版本进行2个处理：
@@ -1027,7 +1066,28 @@ bool SchemaChangeWithSorting::process(IData* olap_data, OLAPIndex* new_olap_inde
         return result;
     }
 
-    RowBlockSorter row_block_sorter(_row_block_allocator);
+    // 多线程排序时每个线程使用一个sorter, 内排序在内存达到上限后才进行,
+    // 所以sorter的临时row block需要在读入数据之前分配
+    size_t ref_num_rows_per_block = olap_data->olap_index()->table()->num_rows_per_row_block();
+    vector<std::unique_ptr<RowBlockSorter>> sorters;
+    for (size_t i = 0; i < _sort_thread_num; ++i) {
+        std::unique_ptr<RowBlockSorter> sorter(
+                new(nothrow) RowBlockSorter(_row_block_allocator));
+        if (NULL == sorter) {
+            OLAP_LOG_FATAL("failed to malloc RowBlockSorter. [size=%ld]", sizeof(RowBlockSorter));
+            return false;
+        }
+
+        if (_sort_thread_num > 1
+                && !sorter->reserve(ref_num_rows_per_block, data_file_type, null_supported)) {
+            OLAP_LOG_WARNING("Memory limitation is too small for Schema Change. "
+                             "[memory_limitation=%ld sort_thread_num=%lu]",
+                             _memory_limitation, _sort_thread_num);
+            return false;
+        }
+
+        sorters.push_back(std::move(sorter));
+    }
 
     // for internal sorting
     RowBlock* new_row_block = NULL;
@@ -1043,8 +1103,14 @@ bool SchemaChangeWithSorting::process(IData* olap_data, OLAPIndex* new_olap_inde
     reset_filted_rows();
 
     while (NULL != ref_row_block) {
+        // 多线程排序时按整块分配, 保证sorter的临时row block总能容纳待排序的row block
+        size_t num_rows_to_allocate = ref_row_block->row_block_info().row_num;
+        if (_sort_thread_num > 1) {
+            num_rows_to_allocate = std::max(num_rows_to_allocate, ref_num_rows_per_block);
+        }
+
         if (OLAP_SUCCESS != _row_block_allocator->allocate(
-                    &new_row_block, ref_row_block->row_block_info().row_num, 
+                    &new_row_block, num_rows_to_allocate, 
                     data_file_type, null_supported)) {
             OLAP_LOG_WARNING("failed to allocate RowBlock.");
             result = false;
@@ -1060,28 +1126,18 @@ bool SchemaChangeWithSorting::process(IData* olap_data, OLAPIndex* new_olap_inde
             }
 
             // enter here while memory limitation is reached.
-            OLAPIndex* olap_index = NULL;
-
-            if (!_internal_sorting(row_block_arr,
-                                   Version(_temp_delta_versions.second,
-                                           _temp_delta_versions.second),
-                                   &olap_index)) {
+            if (!_sort_run(&row_block_arr, sorters, &olap_index_arr)) {
                 OLAP_LOG_WARNING("failed to sorting internally.");
                 result = false;
                 goto SORTING_PROCESS_ERR;
             }
 
-            olap_index_arr.push_back(olap_index);
-
             for (vector<RowBlock*>::iterator it = row_block_arr.begin();
                     it != row_block_arr.end(); ++it) {
                 _row_block_allocator->release(*it);
             }
 
             row_block_arr.clear();
-
-            // increase temp version
-            ++_temp_delta_versions.second;
             continue;
         }
 
@@ -1099,7 +1155,8 @@ bool SchemaChangeWithSorting::process(IData* olap_data, OLAPIndex* new_olap_inde
         add_filted_rows(filted_rows);
 
         if (new_row_block->row_block_info().row_num > 0) {
-            if (!row_block_sorter.sort(&new_row_block)) {
+            // 多线程排序时在内排序中并行排序
+            if (_sort_thread_num == 1 && !sorters[0]->sort(&new_row_block)) {
                 OLAP_LOG_WARNING("failed to sort row block.");
                 result = false;
                 OLAP_GOTO(SORTING_PROCESS_ERR);
@@ -1115,28 +1172,18 @@ bool SchemaChangeWithSorting::process(IData* olap_data, OLAPIndex* new_olap_inde
     }
 
     if (!row_block_arr.empty()) {
-        // enter here while memory limitation is reached.
-        OLAPIndex* olap_index = NULL;
-
-        if (!_internal_sorting(row_block_arr,
-                               Version(_temp_delta_versions.second, _temp_delta_versions.second),
-                               &olap_index)) {
+        if (!_sort_run(&row_block_arr, sorters, &olap_index_arr)) {
             OLAP_LOG_WARNING("failed to sorting internally.");
             result = false;
             goto SORTING_PROCESS_ERR;
         }
 
-        olap_index_arr.push_back(olap_index);
-
         for (vector<RowBlock*>::iterator it = row_block_arr.begin();
                 it != row_block_arr.end(); ++it) {
             _row_block_allocator->release(*it);
         }
 
         row_block_arr.clear();
-
-        // increase temp version
-        ++_temp_delta_versions.second;
     }
 
     // TODO(zyh): 如果_temp_delta_versions只有一个，不需要再外排
@@ -1184,11 +1231,89 @@ SORTING_PROCESS_ERR:
     return result;
 }
 
+bool SchemaChangeWithSorting::_sort_run(
+        vector<RowBlock*>* row_block_arr,
+        const vector<std::unique_ptr<RowBlockSorter>>& sorters,
+        vector<OLAPIndex*>* olap_index_arr) {
+    if (sorters.size() == 1) {
+        // 单线程时row block在读入时已经排好序
+        OLAPIndex* olap_index = NULL;
+        uint64_t merged_rows = 0;
+        if (!_internal_sorting(*row_block_arr,
+                               Version(_temp_delta_versions.second, _temp_delta_versions.second),
+                               &olap_index,
+                               &merged_rows)) {
+            return false;
+        }
+
+        olap_index_arr->push_back(olap_index);
+        add_merged_rows(merged_rows);
+
+        // increase temp version
+        ++_temp_delta_versions.second;
+        return true;
+    }
+
+    // 连续的row block分为一组, 每组由一个线程排序并归并, 生成一个临时版本
+    size_t task_num = std::min(sorters.size(), row_block_arr->size());
+    vector<InternalSortingTask> tasks(task_num);
+    for (size_t i = 0; i < row_block_arr->size(); ++i) {
+        tasks[i * task_num / row_block_arr->size()].row_blocks.push_back((*row_block_arr)[i]);
+    }
+
+    bool result = true;
+    boost::thread_group threads;
+    for (size_t i = 0; i < task_num; ++i) {
+        tasks[i].sorter = sorters[i].get();
+        tasks[i].version = Version(_temp_delta_versions.second, _temp_delta_versions.second);
+        tasks[i].olap_index = NULL;
+        tasks[i].merged_rows = 0;
+        tasks[i].result = false;
+        ++_temp_delta_versions.second;
+
+        try {
+            threads.create_thread(boost::bind(
+                    &SchemaChangeWithSorting::_internal_sorting_task, this, &tasks[i]));
+        } catch (...) {
+            OLAP_LOG_WARNING("failed to create internal sorting thread.");
+            result = false;
+            break;
+        }
+    }
+    threads.join_all();
+
+    // 排序会交换row block, 用排序后的row block替换原来的, 由调用者释放
+    row_block_arr->clear();
+    for (vector<InternalSortingTask>::iterator it = tasks.begin(); it != tasks.end(); ++it) {
+        row_block_arr->insert(row_block_arr->end(), it->row_blocks.begin(), it->row_blocks.end());
+        if (it->olap_index != NULL) {
+            olap_index_arr->push_back(it->olap_index);
+        }
+        add_merged_rows(it->merged_rows);
+        result = result && it->result;
+    }
+
+    return result;
+}
+
+void SchemaChangeWithSorting::_internal_sorting_task(InternalSortingTask* task) {
+    for (vector<RowBlock*>::iterator it = task->row_blocks.begin();
+            it != task->row_blocks.end(); ++it) {
+        if (!task->sorter->sort(&(*it))) {
+            OLAP_LOG_WARNING("failed to sort row block.");
+            return;
+        }
+    }
+
+    task->result = _internal_sorting(
+            task->row_blocks, task->version, &task->olap_index, &task->merged_rows);
+}
+
 bool SchemaChangeWithSorting::_internal_sorting(const vector<RowBlock*>& row_block_arr,
                                                 const Version& temp_delta_versions,
-                                                OLAPIndex** temp_olap_index) {
+                                                OLAPIndex** temp_olap_index,
+                                                uint64_t* merged_rows) {
     IWriter* writer = NULL;
-    uint64_t merged_rows = 0;
     RowBlockMerger merger(_olap_table);
 
     (*temp_olap_index) = new(nothrow) OLAPIndex(_olap_table.get(),
@@ -1217,11 +1342,10 @@ bool SchemaChangeWithSorting::_internal_sorting(const vector<RowBlock*>& row_blo
         goto INTERNAL_SORTING_ERR;
     }
 
-    if (!merger.merge(row_block_arr, writer, &merged_rows)) {
+    if (!merger.merge(row_block_arr, writer, merged_rows)) {
         OLAP_LOG_WARNING("failed to merge row blocks.");
         goto INTERNAL_SORTING_ERR;
     }
-    add_merged_rows(merged_rows);
 
     if (OLAP_SUCCESS != (*temp_olap_index)->load()) {
         OLAP_LOG_WARNING("failed to reload olap index.");
@@ -1754,7 +1878,8 @@ OLAPStatus SchemaChangeHandler::schema_version_convert(
         sc_procedure = new(nothrow) SchemaChangeWithSorting(
                                 dest_olap_table,
                                 rb_changer,
-                                memory_limitation * 1024 * 1024 * 1024);
+                                memory_limitation * 1024 * 1024 * 1024,
+                                std::max(config::schema_change_sort_thread_num, 1));
     } else if (true == sc_directly || src_olap_table->data_file_type() == OLAP_DATA_FILE) {
         OLAP_LOG_INFO("doing schema change directly.");
         sc_procedure = new(nothrow) SchemaChangeDirectly(
@@ -1830,6 +1955,297 @@ SCHEMA_VERSION_CONVERT_ERR:
     return res;
 }
 
+OLAPStatus SchemaChangeHandler::convert_to_column_file(SmartOLAPTable ref_olap_table) {
+    if (ref_olap_table->data_file_type() != OLAP_DATA_FILE) {
+        return OLAP_SUCCESS;
+    }
+
+    // 转换期间版本只会因导入而增加, 不会因合并而消失
+    if (!ref_olap_table->try_base_expansion_lock()) {
+        OLAP_LOG_INFO("base expansion is running, convert it later. [table='%s']",
+                      ref_olap_table->full_name().c_str());
+        return OLAP_ERR_BE_TRY_BE_LOCK_ERROR;
+    }
+    if (!ref_olap_table->try_cumulative_lock()) {
+        OLAP_LOG_INFO("cumulative expansion is running, convert it later. [table='%s']",
+                      ref_olap_table->full_name().c_str());
+        ref_olap_table->release_base_expansion_lock();
+        return OLAP_ERR_CE_TRY_CE_LOCK_ERROR;
+    }
+
+    OLAPStatus res = OLAP_SUCCESS;
+    bool push_locked = false;
+    SmartOLAPTable new_olap_table;
+    string schema_hash_path;
+    SchemaChange* sc_procedure = NULL;
+    RowBlockChanger rb_changer(ref_olap_table->tablet_schema(), ref_olap_table);
+    for (size_t i = 0; i < ref_olap_table->tablet_schema().size(); ++i) {
+        rb_changer.get_mutable_column_mapping(i)->ref_column = i;
+    }
+
+    do {
+        if (ref_olap_table->is_schema_changing()) {
+            OLAP_LOG_INFO("table is under schema change, skip converting. [table='%s']",
+                          ref_olap_table->full_name().c_str());
+            res = OLAP_ERR_TRY_LOCK_FAILED;
+            break;
+        }
+
+        vector<Version> versions;
+        ref_olap_table->obtain_header_rdlock();
+        ref_olap_table->list_versions(&versions);
+        ref_olap_table->release_header_lock();
+        if (versions.empty()) {
+            res = OLAP_ERR_VERSION_NOT_EXIST;
+            OLAP_LOG_WARNING("table has not any version. [table='%s']",
+                             ref_olap_table->full_name().c_str());
+            break;
+        }
+
+        res = _create_column_file_table(ref_olap_table, &schema_hash_path, &new_olap_table);
+        if (res != OLAP_SUCCESS) {
+            break;
+        }
+
+        sc_procedure = new(nothrow) SchemaChangeDirectly(new_olap_table, rb_changer);
+        if (sc_procedure == NULL) {
+            OLAP_LOG_FATAL("failed to malloc SchemaChange. [size=%ld]",
+                           sizeof(SchemaChangeDirectly));
+            res = OLAP_ERR_MALLOC_ERROR;
+            break;
+        }
+
+        res = _convert_versions_to_column_file(
+                ref_olap_table, new_olap_table, versions, sc_procedure);
+        if (res != OLAP_SUCCESS) {
+            break;
+        }
+
+        // 转换期间导入的版本在push锁内补齐, 之后旧table不会再有新的导入
+        ref_olap_table->obtain_push_lock();
+        push_locked = true;
+
+        vector<Version> latest_versions;
+        vector<Version> missing_versions;
+        ref_olap_table->obtain_header_rdlock();
+        ref_olap_table->list_versions(&latest_versions);
+        ref_olap_table->release_header_lock();
+        for (const Version& version : latest_versions) {
+            if (std::find(versions.begin(), versions.end(), version) == versions.end()) {
+                missing_versions.push_back(version);
+            }
+        }
+
+        res = _convert_versions_to_column_file(
+                ref_olap_table, new_olap_table, missing_versions, sc_procedure);
+        if (res != OLAP_SUCCESS) {
+            break;
+        }
+
+        if (ref_olap_table->is_schema_changing()) {
+            OLAP_LOG_INFO("table starts schema change while converting. [table='%s']",
+                          ref_olap_table->full_name().c_str());
+            res = OLAP_ERR_TRY_LOCK_FAILED;
+            break;
+        }
+
+        new_olap_table->obtain_header_wrlock();
+        res = new_olap_table->save_header();
+        new_olap_table->release_header_lock();
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to save header. [res=%d table='%s']",
+                             res, new_olap_table->full_name().c_str());
+            break;
+        }
+
+        // 新table的版本创建时间更新, OLAPEngine会用它替换旧table,
+        // 旧table在正在进行的查询结束后被移入trash
+        new_olap_table.reset();
+        res = OLAPEngine::get_instance()->load_one_tablet(
+                ref_olap_table->tablet_id(), ref_olap_table->schema_hash(), schema_hash_path);
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to add converted table to OLAPEngine. [res=%d path='%s']",
+                             res, schema_hash_path.c_str());
+            break;
+        }
+
+        SmartOLAPTable converted_olap_table = OLAPEngine::get_instance()->get_table(
+                ref_olap_table->tablet_id(), ref_olap_table->schema_hash());
+        if (converted_olap_table.get() != NULL) {
+            SchemaChangeStatus status = ref_olap_table->schema_change_status();
+            converted_olap_table->set_schema_change_status(
+                    status.status, status.schema_hash, status.version);
+        }
+
+        OLAP_LOG_INFO("succeed to convert table to column file. [table='%s' versions=%lu]",
+                      ref_olap_table->full_name().c_str(), latest_versions.size());
+    } while (0);
+
+    if (push_locked) {
+        ref_olap_table->release_push_lock();
+    }
+    ref_olap_table->release_cumulative_lock();
+    ref_olap_table->release_base_expansion_lock();
+
+    SAFE_DELETE(sc_procedure);
+    if (res != OLAP_SUCCESS && new_olap_table.get() != NULL) {
+        // 析构时把转换了一半的数据移入trash
+        new_olap_table->mark_dropped();
+    }
+
+    return res;
+}
+
+OLAPStatus SchemaChangeHandler::_create_column_file_table(
+        SmartOLAPTable ref_olap_table,
+        string* schema_hash_path,
+        SmartOLAPTable* new_olap_table) {
+    uint64_t shard = 0;
+    OLAPStatus res = OLAPRootPath::get_instance()->get_root_path_shard(
+            ref_olap_table->storage_root_path_name(), &shard);
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to get root path shard. [res=%d]", res);
+        return res;
+    }
+
+    stringstream path_stream;
+    path_stream << ref_olap_table->storage_root_path_name() << DATA_PREFIX << "/" << shard
+                << "/" << ref_olap_table->tablet_id() << "/" << ref_olap_table->schema_hash();
+    *schema_hash_path = path_stream.str();
+    if (check_dir_existed(*schema_hash_path)) {
+        OLAP_LOG_DEBUG("schema hash path already exist, remove it. [schema_hash_path='%s']",
+                       schema_hash_path->c_str());
+        remove_all_dir(*schema_hash_path);
+    }
+
+    res = create_dirs(*schema_hash_path);
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to create dir. [path='%s']", schema_hash_path->c_str());
+        return res;
+    }
+
+    stringstream header_path_stream;
+    header_path_stream << *schema_hash_path << "/" << ref_olap_table->tablet_id() << ".hdr";
+    string header_path = header_path_stream.str();
+
+    // schema和删除条件等沿用旧header, 版本在转换时重新注册
+    OLAPHeader header(ref_olap_table->header_file_name());
+    ref_olap_table->obtain_header_rdlock();
+    res = header.load();
+    ref_olap_table->release_header_lock();
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to load header. [res=%d header_file='%s']",
+                         res, ref_olap_table->header_file_name().c_str());
+        remove_all_dir(*schema_hash_path);
+        return res;
+    }
+
+    header.set_data_file_type(COLUMN_ORIENTED_FILE);
+    header.set_segment_size(OLAP_MAX_COLUMN_SEGMENT_FILE_SIZE);
+    header.set_num_rows_per_data_block(config::default_num_rows_per_column_file_block);
+    header.delete_all_versions();
+    res = header.save(header_path);
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to save header. [res=%d header_file='%s']",
+                         res, header_path.c_str());
+        remove_all_dir(*schema_hash_path);
+        return res;
+    }
+
+    OLAPTable* olap_table = OLAPTable::create_from_header_file(
+            ref_olap_table->tablet_id(), ref_olap_table->schema_hash(), header_path);
+    if (olap_table == NULL) {
+        OLAP_LOG_WARNING("fail to create table from header. [header_file='%s']",
+                         header_path.c_str());
+        remove_all_dir(*schema_hash_path);
+        return OLAP_ERR_INIT_FAILED;
+    }
+
+    new_olap_table->reset(olap_table);
+    return OLAP_SUCCESS;
+}
+
+OLAPStatus SchemaChangeHandler::_convert_versions_to_column_file(
+        SmartOLAPTable ref_olap_table,
+        SmartOLAPTable new_olap_table,
+        const vector<Version>& versions,
+        SchemaChange* sc_procedure) {
+    for (size_t i = 0; i < versions.size(); ++i) {
+        OlapStopWatch watch;
+        vector<Version> version_list(1, versions[i]);
+        vector<IData*> olap_data_sources;
+        ref_olap_table->obtain_header_rdlock();
+        ref_olap_table->acquire_data_sources_by_versions(version_list, &olap_data_sources);
+        ref_olap_table->release_header_lock();
+        if (olap_data_sources.size() != 1) {
+            OLAP_LOG_WARNING("fail to acquire data source. [table='%s' version='%d-%d']",
+                             ref_olap_table->full_name().c_str(),
+                             versions[i].first, versions[i].second);
+            return OLAP_ERR_VERSION_NOT_EXIST;
+        }
+
+        IData* olap_data = olap_data_sources[0];
+        size_t data_size = olap_data->olap_index()->data_size()
+                           + olap_data->olap_index()->index_size();
+        OLAPIndex* new_olap_index = new(nothrow) OLAPIndex(
+                new_olap_table.get(),
+                olap_data->version(),
+                olap_data->version_hash(),
+                olap_data->delete_flag(),
+                0,
+                olap_data->max_timestamp());
+        if (new_olap_index == NULL) {
+            OLAP_LOG_FATAL("failed to malloc OLAPIndex. [size=%ld]", sizeof(OLAPIndex));
+            ref_olap_table->release_data_sources(&olap_data_sources);
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+
+        bool converted = sc_procedure->process(olap_data, new_olap_index);
+        ref_olap_table->release_data_sources(&olap_data_sources);
+        if (!converted) {
+            OLAP_LOG_WARNING("fail to convert version. [table='%s' version='%d-%d']",
+                             ref_olap_table->full_name().c_str(),
+                             versions[i].first, versions[i].second);
+            new_olap_index->delete_all_files();
+            SAFE_DELETE(new_olap_index);
+            return OLAP_ERR_INPUT_PARAMETER_ERROR;
+        }
+
+        new_olap_table->obtain_header_wrlock();
+        OLAPStatus res = new_olap_table->register_data_source(new_olap_index);
+        new_olap_table->release_header_lock();
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to register data source. [table='%s' version='%d-%d']",
+                             new_olap_table->full_name().c_str(),
+                             versions[i].first, versions[i].second);
+            new_olap_index->delete_all_files();
+            SAFE_DELETE(new_olap_index);
+            return res;
+        }
+
+        OLAP_LOG_INFO("convert version to column file. [table='%s' version='%d-%d' "
+                      "progress=%lu/%lu size=%lu cost_us=%lu]",
+                      ref_olap_table->full_name().c_str(),
+                      versions[i].first, versions[i].second,
+                      i + 1, versions.size(), data_size, watch.get_elapse_time_us());
+        if (PaloMetrics::column_file_convert_delta_num() != NULL) {
+            PaloMetrics::column_file_convert_delta_num()->increment(1);
+            PaloMetrics::column_file_convert_size()->increment(data_size);
+        }
+
+        // 按读入的数据量限速, 避免转换影响线上导入和查询
+        if (config::column_file_convert_mbytes_per_sec > 0) {
+            uint64_t expected_us = data_size / config::column_file_convert_mbytes_per_sec;
+            uint64_t cost_us = watch.get_elapse_time_us();
+            if (expected_us > cost_us) {
+                usleep(expected_us - cost_us);
+            }
+        }
+    }
+
+    return OLAP_SUCCESS;
+}
+
 OLAPStatus SchemaChangeHandler::_get_versions_to_be_changed(
         SmartOLAPTable ref_olap_table,
         vector<Version>& versions_to_be_changed) {
@@ -1977,7 +2393,8 @@ OLAPStatus SchemaChangeHandler::_alter_table(SchemaChangeParams* sc_params) {
         sc_procedure = new(nothrow) SchemaChangeWithSorting(
                                sc_params->new_olap_table,
                                rb_changer,
-                               memory_limitation * 1024 * 1024 * 1024);
+                               memory_limitation * 1024 * 1024 * 1024,
+                               std::max(config::schema_change_sort_thread_num, 1));
     } else if (true == sc_directly
                || sc_params->ref_olap_table->data_file_type() == OLAP_DATA_FILE) {
         OLAP_LOG_INFO("doing schema change directly.");
@@ -1988,6 +2405,15 @@ OLAPStatus SchemaChangeHandler::_alter_table(SchemaChangeParams* sc_params) {
         sc_procedure = new(nothrow) LinkedSchemaChange(
                                 sc_params->ref_olap_table,
                                 sc_params->new_olap_table);
+
+        // link的数据文件中仍保留着被删除的行，需要把删除条件带到新表上
+        res = _copy_delete_conditions(sc_params->ref_olap_table,
+                                      sc_params->new_olap_table,
+                                      end_version);
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("failed to copy delete conditions. [res=%d]", res);
+            goto PROCESS_ALTER_EXIT;
+        }
     }
 
     if (NULL == sc_procedure) {
@@ -2194,6 +2620,74 @@ PROCESS_ALTER_EXIT:
     return res;
 }
 
+// @static
+// 把ref表上版本不大于end_version的删除条件拷贝到新表，新表上已有的同版本条件不重复添加
+OLAPStatus SchemaChangeHandler::_copy_delete_conditions(SmartOLAPTable ref_olap_table,
+                                                        SmartOLAPTable new_olap_table,
+                                                        int32_t end_version) {
+    if (ref_olap_table->delete_data_conditions_size() == 0) {
+        return OLAP_SUCCESS;
+    }
+
+    // 为了防止死锁的出现，一定要先锁住旧表，再锁住新表
+    ref_olap_table->obtain_header_rdlock();
+    new_olap_table->obtain_header_wrlock();
+
+    int num_copied = 0;
+    OLAPStatus res = OLAP_SUCCESS;
+    for (const DeleteDataConditionMessage& condition : ref_olap_table->delete_data_conditions()) {
+        if (condition.version() > end_version
+                || new_olap_table->is_delete_data_version(
+                        Version(condition.version(), condition.version()))) {
+            continue;
+        }
+
+        // 删除条件中的列必须仍然是新表的key列，条件串以列名开头(见DeleteConditionHandler)
+        for (const std::string& sub_condition : condition.sub_conditions()) {
+            size_t name_length = 0;
+            while (name_length < sub_condition.size()
+                    && (isalnum(sub_condition[name_length]) || sub_condition[name_length] == '_')) {
+                ++name_length;
+            }
+
+            int32_t column_index = new_olap_table->get_field_index(
+                    sub_condition.substr(0, name_length));
+            if (column_index < 0
+                    || static_cast<size_t>(column_index) >= new_olap_table->num_key_fields()) {
+                OLAP_LOG_WARNING("delete condition column is not a key of new table. "
+                                 "[table='%s' condition='%s']",
+                                 new_olap_table->full_name().c_str(),
+                                 sub_condition.c_str());
+                res = OLAP_ERR_DELETE_INVALID_CONDITION;
+                break;
+            }
+        }
+
+        if (res != OLAP_SUCCESS) {
+            break;
+        }
+
+        new_olap_table->add_delete_data_conditions()->CopyFrom(condition);
+        ++num_copied;
+    }
+
+    if (res == OLAP_SUCCESS && num_copied > 0) {
+        res = new_olap_table->save_header();
+        if (res != OLAP_SUCCESS) {
+            OLAP_LOG_WARNING("fail to save header. [res=%d table='%s']",
+                             res, new_olap_table->full_name().c_str());
+        }
+    }
+
+    new_olap_table->release_header_lock();
+    ref_olap_table->release_header_lock();
+
+    OLAP_LOG_INFO("copy delete conditions for linked schema change. "
+                  "[table='%s' num_copied=%d res=%d]",
+                  new_olap_table->full_name().c_str(), num_copied, res);
+    return res;
+}
+
 // @static
 // 分析column的mapping以及filter key的mapping
 OLAPStatus SchemaChangeHandler::_parse_request(SmartOLAPTable ref_olap_table,
@@ -2319,17 +2813,21 @@ OLAPStatus SchemaChangeHandler::_parse_request(SmartOLAPTable ref_olap_table,
                 *sc_directly = true;
                 return OLAP_SUCCESS;
 
-            } else if (new_table_schema[i].is_bf_column != ref_table_schema[i].is_bf_column) {
+            } else if (new_table_schema[i].is_bf_column
+                           != ref_table_schema[column_mapping->ref_column].is_bf_column) {
+                *sc_directly = true;
+                return OLAP_SUCCESS;
+            } else if (new_table_schema[i].is_bf_column
+                           && new_table_schema[i].is_blocked_bf
+                               != ref_table_schema[column_mapping->ref_column].is_blocked_bf) {
                 *sc_directly = true;
                 return OLAP_SUCCESS;
             }
         }
     }
 
-    if (ref_olap_table->delete_data_conditions_size() != 0){
-        //there exists delete condtion in header, can't do linked schema change
-        *sc_directly = true;
-    }
+    // NOTE 存在删除条件时仍然可以link：删除条件只按列名引用key列，
+    // process_alter_table会把删除条件一并带到新表的header中
 
     if (ref_olap_table->data_file_type() != new_olap_table->data_file_type()) {
         //if change the table from row-oriented to column-oriented, or versus 
@@ -17,6 +17,7 @@
 #define BDG_PALO_BE_SRC_OLAP_SCHEMA_CHANGE_H
 
 #include <deque>
+#include <memory>
 #include <queue>
 #include <vector>
 
@@ -90,6 +91,9 @@ public:
 
     bool sort(RowBlock** row_block);
 
+    // 预先分配排序用的临时row block, 之后排序不超过num_rows行的row block时不再申请内存
+    bool reserve(size_t num_rows, DataFileType data_file_type, bool null_supported);
+
 private:
     static bool _row_cursor_comparator(const RowCursor* a, const RowCursor* b) {
         return a->full_key_cmp(*b) < 0;
@@ -113,6 +117,8 @@ private:
     size_t _memory_allocated;
     size_t _row_len;
     size_t _memory_limitation;
+    // 并行排序时多个线程同时申请和释放row block
+    MutexLock _mutex;
 };
 
 class RowBlockMerger {
@@ -230,16 +236,37 @@ public:
     explicit SchemaChangeWithSorting(
             SmartOLAPTable olap_table,
             const RowBlockChanger& row_block_changer,
-            size_t memory_limitation);
+            size_t memory_limitation,
+            size_t sort_thread_num = 1);
     virtual ~SchemaChangeWithSorting();
 
     virtual bool process(IData* olap_data, OLAPIndex* new_olap_index);
 
 private:
+    // 并行内排序时一个线程处理的一组row block
+    struct InternalSortingTask {
+        std::vector<RowBlock*> row_blocks;
+        RowBlockSorter* sorter;
+        Version version;
+        OLAPIndex* olap_index;
+        uint64_t merged_rows;
+        bool result;
+    };
+
+    // 排序并归并内存中的一批row block, 生成的临时版本加入olap_index_arr.
+    // 多于一个sorter时row block分组由多个线程并行排序并归并, 每组生成一个临时版本
+    bool _sort_run(
+            std::vector<RowBlock*>* row_block_arr,
+            const std::vector<std::unique_ptr<RowBlockSorter>>& sorters,
+            std::vector<OLAPIndex*>* olap_index_arr);
+
+    void _internal_sorting_task(InternalSortingTask* task);
+
     bool _internal_sorting(
             const std::vector<RowBlock*>& row_block_arr,
             const Version& temp_delta_versions,
-            OLAPIndex** temp_olap_index);
+            OLAPIndex** temp_olap_index,
+            uint64_t* merged_rows);
 
     bool _external_sorting(
             std::vector<OLAPIndex*>& src_olap_index_arr,
@@ -248,6 +275,7 @@ private:
     SmartOLAPTable _olap_table;
     const RowBlockChanger& _row_block_changer;
     size_t _memory_limitation;
+    size_t _sort_thread_num;
     Version _temp_delta_versions;
     RowBlockAllocator* _row_block_allocator;
 
@@ -267,6 +295,11 @@ public:
                                       std::vector<OLAPIndex*>* ref_olap_indices,
                                       std::vector<OLAPIndex*>* new_olap_indices);
 
+    // 将行存(OLAPData)的table逐个版本转换为列存, 新table建在同一root path的新shard下.
+    // 转换期间旧table继续提供导入和查询, 但不做base/cumulative expansion,
+    // 全部版本转换完成后新table在OLAPEngine中替换旧table
+    OLAPStatus convert_to_column_file(SmartOLAPTable ref_olap_table);
+
     // 清空一个table下的schema_change信息：包括split_talbe以及其他schema_change信息
     //  这里只清理自身的out链，不考虑related的table
     // NOTE 需要外部lock header
@@ -306,6 +339,17 @@ private:
     OLAPStatus _get_versions_to_be_changed(SmartOLAPTable ref_olap_table,
                                            std::vector<Version>& versions_to_be_changed);
 
+    // 创建与ref_olap_table同schema的列存table, 不含任何版本
+    OLAPStatus _create_column_file_table(SmartOLAPTable ref_olap_table,
+                                         std::string* schema_hash_path,
+                                         SmartOLAPTable* new_olap_table);
+
+    // 按column_file_convert_mbytes_per_sec限速, 逐个转换versions并注册到new_olap_table
+    OLAPStatus _convert_versions_to_column_file(SmartOLAPTable ref_olap_table,
+                                                SmartOLAPTable new_olap_table,
+                                                const std::vector<Version>& versions,
+                                                SchemaChange* sc_procedure);
+
     OLAPStatus _do_alter_table(AlterTabletType type,
                                SmartOLAPTable ref_olap_table,
                                const TAlterTabletReq& request);
@@ -347,6 +391,11 @@ private:
                                      bool* sc_sorting, 
                                      bool* sc_directly);
 
+    // linked schema change时，把ref表的删除条件带到新表上
+    static OLAPStatus _copy_delete_conditions(SmartOLAPTable ref_olap_table,
+                                              SmartOLAPTable new_olap_table,
+                                              int32_t end_version);
+
     // 需要新建default_value时的初始化设置
     static OLAPStatus _init_column_mapping(ColumnMapping* column_mapping,
                                            const FieldInfo& column_schema,
@@ -0,0 +1,156 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/skip_scan_keys.h"
+
+#include <algorithm>
+
+namespace palo {
+
+OLAPStatus SkipScanKeys::init(const std::vector<FieldInfo>& tablet_schema,
+                              const std::vector<std::vector<std::string>>& column_values) {
+    if (column_values.empty() || column_values.size() > tablet_schema.size()) {
+        OLAP_LOG_WARNING("invalid skip scan columns. [column_num=%lu]", column_values.size());
+        return OLAP_ERR_INPUT_PARAMETER_ERROR;
+    }
+
+    OLAPStatus res = OLAP_SUCCESS;
+    std::vector<size_t> max_lengths;
+    std::vector<std::string> key;
+    for (size_t i = 0; i < column_values.size(); ++i) {
+        if (column_values[i].empty()) {
+            OLAP_LOG_WARNING("no value for skip scan column. [column=%lu]", i);
+            return OLAP_ERR_INPUT_PARAMETER_ERROR;
+        }
+
+        // 前面的列用任意取值补齐, 比较时只看第i列
+        key.push_back(column_values[i][0]);
+        std::vector<std::unique_ptr<RowCursor>> values;
+        size_t max_length = 0;
+        for (const std::string& value : column_values[i]) {
+            key[i] = value;
+            std::unique_ptr<RowCursor> cursor(new(std::nothrow) RowCursor());
+            if (cursor == NULL) {
+                OLAP_LOG_WARNING("fail to malloc RowCursor.");
+                return OLAP_ERR_MALLOC_ERROR;
+            }
+            if ((res = cursor->init_keys(tablet_schema, key)) != OLAP_SUCCESS
+                    || (res = cursor->from_string(key)) != OLAP_SUCCESS) {
+                OLAP_LOG_WARNING("fail to init skip scan key. [column=%lu value='%s']",
+                                 i, value.c_str());
+                return res;
+            }
+            values.push_back(std::move(cursor));
+            max_length = std::max(max_length, value.length());
+        }
+
+        // 按存储中的顺序排序, 与查询层的类型顺序无关
+        std::vector<size_t> order(values.size());
+        for (size_t j = 0; j < order.size(); ++j) {
+            order[j] = j;
+        }
+        std::sort(order.begin(), order.end(), [&values, i](size_t a, size_t b) {
+            return values[a]->get_field_by_index(i)->cmp(values[b]->get_field_by_index(i)) < 0;
+        });
+        std::vector<std::unique_ptr<RowCursor>> sorted_values;
+        std::vector<std::string> strings;
+        for (size_t j : order) {
+            sorted_values.push_back(std::move(values[j]));
+            strings.push_back(column_values[i][j]);
+        }
+
+        _values.push_back(std::move(sorted_values));
+        _strings.push_back(std::move(strings));
+        max_lengths.push_back(max_length);
+        key[i] = column_values[i][0];
+    }
+
+    res = _current.init_keys(tablet_schema, max_lengths);
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to init skip scan key. [res=%d]", res);
+        return res;
+    }
+    _indexes.assign(_values.size(), 0);
+    return _update_current();
+}
+
+bool SkipScanKeys::next() {
+    return _carry(_values.size());
+}
+
+bool SkipScanKeys::seek(const RowCursor& row) {
+    if (_eof) {
+        return false;
+    }
+
+    for (size_t i = 0; i < _values.size(); ++i) {
+        const Field* field = row.get_field_by_index(i);
+        const std::vector<std::unique_ptr<RowCursor>>& values = _values[i];
+        // 第i列中第一个不小于该行的取值
+        size_t low = 0;
+        size_t high = values.size();
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (values[mid]->get_field_by_index(i)->cmp(field) < 0) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+
+        if (low == values.size()) {
+            // 该列的所有取值都比这一行小, 进位到前一列
+            return _carry(i);
+        }
+        _indexes[i] = low;
+        if (values[low]->get_field_by_index(i)->cmp(field) > 0) {
+            std::fill(_indexes.begin() + i + 1, _indexes.end(), 0);
+            break;
+        }
+    }
+
+    return _update_current() == OLAP_SUCCESS;
+}
+
+bool SkipScanKeys::_carry(size_t column) {
+    if (_eof) {
+        return false;
+    }
+
+    for (size_t i = column; i > 0; --i) {
+        if (++_indexes[i - 1] < _values[i - 1].size()) {
+            std::fill(_indexes.begin() + i, _indexes.end(), 0);
+            return _update_current() == OLAP_SUCCESS;
+        }
+    }
+
+    _eof = true;
+    return false;
+}
+
+OLAPStatus SkipScanKeys::_update_current() {
+    std::vector<std::string> key(_values.size());
+    for (size_t i = 0; i < _values.size(); ++i) {
+        key[i] = _strings[i][_indexes[i]];
+    }
+    OLAPStatus res = _current.from_string(key);
+    if (res != OLAP_SUCCESS) {
+        OLAP_LOG_WARNING("fail to set skip scan key. [res=%d]", res);
+        _eof = true;
+    }
+    return res;
+}
+
+}  // namespace palo
@@ -0,0 +1,73 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_SKIP_SCAN_KEYS_H
+#define BDG_PALO_BE_SRC_OLAP_SKIP_SCAN_KEYS_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "olap/field.h"
+#include "olap/olap_define.h"
+#include "olap/row_cursor.h"
+
+namespace palo {
+
+// 跳跃扫描: 前n个key列上各有一组取值(IN或等值条件), 需要读取的是这些取值的所有组合.
+// 组合数很多时不预先生成每个组合对应的扫描区间, 而是按key的顺序逐个遍历组合;
+// 读到的行不属于当前组合时, 直接跳到不小于该行前n列的最小组合, 数据中不存在的组合
+// 不会被逐个访问.
+class SkipScanKeys {
+public:
+    SkipScanKeys() : _eof(false) {}
+
+    // column_values[i]是第i个key列的取值, 不要求有序
+    OLAPStatus init(const std::vector<FieldInfo>& tablet_schema,
+                    const std::vector<std::vector<std::string>>& column_values);
+
+    // 当前组合, 只包含前n个key列
+    const RowCursor* current() const {
+        return &_current;
+    }
+
+    // 移动到下一个组合, 没有更多组合时返回false
+    bool next();
+
+    // 移动到前n列不小于row的最小组合, 没有这样的组合时返回false
+    bool seek(const RowCursor& row);
+
+    size_t num_columns() const {
+        return _values.size();
+    }
+
+private:
+    // 把column列之前的一列加一并进位, column及之后的列回到第一个取值
+    bool _carry(size_t column);
+
+    OLAPStatus _update_current();
+
+    // _values[i]是第i列从小到大的取值, 每个取值都是前i+1列的key, 只有第i列有意义
+    std::vector<std::vector<std::unique_ptr<RowCursor>>> _values;
+    std::vector<std::vector<std::string>> _strings;
+    // 当前组合中每一列的取值下标
+    std::vector<size_t> _indexes;
+    RowCursor _current;
+    bool _eof;
+};
+
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_OLAP_SKIP_SCAN_KEYS_H
@@ -0,0 +1,124 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/sync_coordinator.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "common/logging.h"
+#include "util/stopwatch.hpp"
+
+namespace palo {
+
+static std::mutex _s_lock;
+static std::vector<SyncCoordinator*> _s_coordinators;
+
+static std::string normalize(const std::string& path) {
+    std::string normalized = path;
+    while (normalized.size() > 1 && normalized[normalized.size() - 1] == '/') {
+        normalized.resize(normalized.size() - 1);
+    }
+    return normalized;
+}
+
+void SyncCoordinator::add_path(const std::string& path) {
+    std::string normalized = normalize(path);
+    std::lock_guard<std::mutex> l(_s_lock);
+    for (SyncCoordinator* coordinator : _s_coordinators) {
+        if (coordinator->_path == normalized) {
+            return;
+        }
+    }
+    _s_coordinators.push_back(new SyncCoordinator(normalized));
+}
+
+SyncCoordinator* SyncCoordinator::find(const std::string& file_name) {
+    std::lock_guard<std::mutex> l(_s_lock);
+    SyncCoordinator* found = NULL;
+    for (SyncCoordinator* coordinator : _s_coordinators) {
+        const std::string& path = coordinator->_path;
+        if (file_name.compare(0, path.size(), path) == 0
+                && (file_name.size() == path.size() || file_name[path.size()] == '/')
+                && (found == NULL || path.size() > found->_path.size())) {
+            found = coordinator;
+        }
+    }
+    return found;
+}
+
+SyncCoordinator::SyncCoordinator(const std::string& path) :
+        _path(path),
+        _next_group(1),
+        _synced_group(0),
+        _syncing(false) {
+}
+
+OLAPStatus SyncCoordinator::sync(int fd, const std::string& file_name) {
+    std::unique_lock<std::mutex> l(_lock);
+    int64_t group = _next_group;
+    _pending_fds.push_back(fd);
+    while (_synced_group < group) {
+        if (_syncing) {
+            _synced_cv.wait(l);
+            continue;
+        }
+        // No sync is running, the group of this file is the next one. Take it and
+        // all files added to it by now.
+        DCHECK_EQ(_next_group, group);
+        _syncing = true;
+        std::vector<int> fds;
+        fds.swap(_pending_fds);
+        ++_next_group;
+        l.unlock();
+        _sync_group(fds);
+        l.lock();
+        _synced_group = group;
+        _syncing = false;
+        _synced_cv.notify_all();
+    }
+
+    if (_failed_fds.erase(fd) > 0) {
+        OLAP_LOG_WARNING("fail to sync file. [file_name='%s' fd=%d]", file_name.c_str(), fd);
+        return OLAP_ERR_IO_ERROR;
+    }
+    return OLAP_SUCCESS;
+}
+
+void SyncCoordinator::_sync_group(const std::vector<int>& fds) {
+    MonotonicStopWatch watch;
+    watch.start();
+    // Queue the writeback of all files first, the waits below overlap then.
+    for (int fd : fds) {
+        sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+    }
+    std::vector<int> failed_fds;
+    for (int fd : fds) {
+        if (fdatasync(fd) != 0) {
+            LOG(WARNING) << "fail to fdatasync. fd=" << fd << ", err=" << strerror(errno);
+            failed_fds.push_back(fd);
+        }
+    }
+    VLOG(3) << "synced " << fds.size() << " files under " << _path
+            << " in " << watch.elapsed_time() / 1000 << "us";
+    if (!failed_fds.empty()) {
+        std::lock_guard<std::mutex> l(_lock);
+        _failed_fds.insert(failed_fds.begin(), failed_fds.end());
+    }
+}
+
+}  // namespace palo
@@ -0,0 +1,83 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_SYNC_COORDINATOR_H
+#define BDG_PALO_BE_SRC_OLAP_SYNC_COORDINATOR_H
+
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "olap/olap_define.h"
+
+namespace palo {
+
+// Group commit of the files written under a root path. Instead of each writer waiting
+// for the disk to flush its own files one after another, the files closed while a
+// sync is running are synced together by the next one: the writeback of all of them
+// is started before any is waited for, so the disk merges and reorders their IO and
+// the journal commits of the file system are shared.
+//
+// sync() returns only once the group of the file has been synced, so that a header
+// saved afterwards never publishes a version whose files aren't on disk.
+class SyncCoordinator {
+public:
+    // Starts to coordinate the syncs of the files under 'path'. Paths are never dropped.
+    static void add_path(const std::string& path);
+
+    // The coordinator of the longest path added that 'file_name' is under, NULL if there
+    // is none.
+    static SyncCoordinator* find(const std::string& file_name);
+
+    // Syncs the data of the open file 'fd' along with the files other threads sync at
+    // the same time. 'file_name' is for the log only.
+    OLAPStatus sync(int fd, const std::string& file_name);
+
+    // Number of groups synced so far
+    int64_t num_groups() {
+        std::lock_guard<std::mutex> l(_lock);
+        return _synced_group;
+    }
+
+    const std::string& path() const {
+        return _path;
+    }
+
+private:
+    explicit SyncCoordinator(const std::string& path);
+
+    // Syncs 'fds', adding those that failed to _failed_fds
+    void _sync_group(const std::vector<int>& fds);
+
+    const std::string _path;
+
+    std::mutex _lock;
+    std::condition_variable _synced_cv;
+    // the files of the group _next_group, which will be synced next
+    std::vector<int> _pending_fds;
+    int64_t _next_group;
+    // groups up to this one are synced
+    int64_t _synced_group;
+    // true while a thread syncs a group
+    bool _syncing;
+    // files of the groups synced which failed to sync, until their writer saw it
+    std::set<int> _failed_fds;
+};
+
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_OLAP_SYNC_COORDINATOR_H
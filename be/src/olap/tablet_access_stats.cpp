@@ -0,0 +1,75 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/tablet_access_stats.h"
+
+namespace palo {
+
+static __thread TabletAccessStats::ScopedReadBytes* _t_read_bytes = NULL;
+
+TabletAccessStats::TabletAccessStats() :
+        _scans(0),
+        _rows(0),
+        _read_bytes(0),
+        _scan_time_ns(0),
+        _last_scans(0),
+        _last_rows(0),
+        _last_read_bytes(0),
+        _scan_rate(0),
+        _row_rate(0),
+        _read_bytes_rate(0) {
+}
+
+void TabletAccessStats::decay(double factor) {
+    int64_t scans = this->scans();
+    int64_t rows = this->rows();
+    int64_t read_bytes = this->read_bytes();
+    _scan_rate.store(scan_rate() * factor + (scans - _last_scans),
+                     std::memory_order_relaxed);
+    _row_rate.store(row_rate() * factor + (rows - _last_rows),
+                    std::memory_order_relaxed);
+    _read_bytes_rate.store(read_bytes_rate() * factor + (read_bytes - _last_read_bytes),
+                           std::memory_order_relaxed);
+    _last_scans = scans;
+    _last_rows = rows;
+    _last_read_bytes = read_bytes;
+}
+
+TabletAccessStats::ScopedReadBytes::ScopedReadBytes(TabletAccessStats* stats,
+                                                    int64_t* bytes) :
+        _stats(stats),
+        _bytes(bytes),
+        _prev(_t_read_bytes) {
+    _t_read_bytes = this;
+}
+
+TabletAccessStats::ScopedReadBytes::~ScopedReadBytes() {
+    _t_read_bytes = _prev;
+}
+
+void TabletAccessStats::record_read_bytes(int64_t bytes) {
+    ScopedReadBytes* scope = _t_read_bytes;
+    if (scope == NULL) {
+        return;
+    }
+    if (scope->_stats != NULL) {
+        scope->_stats->add_read_bytes(bytes);
+    }
+    if (scope->_bytes != NULL) {
+        *scope->_bytes += bytes;
+    }
+}
+
+} // namespace palo
@@ -0,0 +1,118 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_TABLET_ACCESS_STATS_H
+#define BDG_PALO_BE_SRC_OLAP_TABLET_ACCESS_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+namespace palo {
+
+// How much a tablet is read: scans, the rows they read from storage, the bytes read
+// from its files and the time from opening to closing the scans. Scanners update the
+// counters without locks.
+//
+// Besides the totals, decay() keeps rates that follow the recent load: each call adds
+// the counts since the previous call to the rates after multiplying them by a factor
+// below 1, so the tablets that are read now stand out from those read heavily hours
+// ago. decay() is called periodically by one thread.
+class TabletAccessStats {
+public:
+    TabletAccessStats();
+
+    // A finished scan which read 'rows' rows from storage and took 'latency_ns'.
+    void add_scan(int64_t rows, int64_t latency_ns) {
+        _scans.fetch_add(1, std::memory_order_relaxed);
+        _rows.fetch_add(rows, std::memory_order_relaxed);
+        _scan_time_ns.fetch_add(latency_ns, std::memory_order_relaxed);
+    }
+
+    void add_read_bytes(int64_t bytes) {
+        _read_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    int64_t scans() const {
+        return _scans.load(std::memory_order_relaxed);
+    }
+
+    int64_t rows() const {
+        return _rows.load(std::memory_order_relaxed);
+    }
+
+    int64_t read_bytes() const {
+        return _read_bytes.load(std::memory_order_relaxed);
+    }
+
+    int64_t scan_time_ns() const {
+        return _scan_time_ns.load(std::memory_order_relaxed);
+    }
+
+    // Folds the counts since the last call into the rates, see above. Not thread safe.
+    void decay(double factor);
+
+    // The decayed rates, in counts per decay interval.
+    double scan_rate() const {
+        return _scan_rate.load(std::memory_order_relaxed);
+    }
+
+    double row_rate() const {
+        return _row_rate.load(std::memory_order_relaxed);
+    }
+
+    double read_bytes_rate() const {
+        return _read_bytes_rate.load(std::memory_order_relaxed);
+    }
+
+    // Counts the bytes the current thread reads from files for 'stats', and adds them
+    // to '*bytes' if it isn't NULL, while the object lives. The file handlers report
+    // their reads with record_read_bytes().
+    class ScopedReadBytes {
+    public:
+        ScopedReadBytes(TabletAccessStats* stats, int64_t* bytes);
+        ~ScopedReadBytes();
+
+    private:
+        friend class TabletAccessStats;
+
+        TabletAccessStats* _stats;
+        int64_t* _bytes;
+        ScopedReadBytes* _prev;
+    };
+
+    // Adds 'bytes' to the innermost ScopedReadBytes of the current thread, if any.
+    static void record_read_bytes(int64_t bytes);
+
+private:
+    std::atomic<int64_t> _scans;
+    std::atomic<int64_t> _rows;
+    std::atomic<int64_t> _read_bytes;
+    std::atomic<int64_t> _scan_time_ns;
+
+    // the totals at the previous decay()
+    int64_t _last_scans;
+    int64_t _last_rows;
+    int64_t _last_read_bytes;
+
+    std::atomic<double> _scan_rate;
+    std::atomic<double> _row_rate;
+    std::atomic<double> _read_bytes_rate;
+};
+
+} // namespace palo
+
+#endif // BDG_PALO_BE_SRC_OLAP_TABLET_ACCESS_STATS_H
@@ -1512,12 +1512,13 @@ OLAPStatus remove_unused_files(const string& schema_hash_root,
     different_set.erase(header);
     // 遍历所有没有使用的文件
     for (set<string>::const_iterator it = different_set.begin(); it != different_set.end(); ++it) {
-        if (ENDSWITH(*it, ".hdr") || ENDSWITH(*it, ".idx") || ENDSWITH(*it, ".dat")) {
+        if (ENDSWITH(*it, ".hdr") || ENDSWITH(*it, ".idx") || ENDSWITH(*it, ".dat")
+                || ENDSWITH(*it, ".pack")) {
             OLAP_LOG_INFO("delete unused file. [file='%s']", it->c_str());
             move_to_trash(boost::filesystem::path(schema_hash_root),
                           boost::filesystem::path(schema_hash_root + "/" + *it));
         } else {
-            // 除了.hdr, .idx, .dat其他文件均忽略
+            // 除了.hdr, .idx, .dat, .pack其他文件均忽略
             continue;
         }
     }
@@ -0,0 +1,617 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/vectorized_filter.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "exprs/expr.h"
+#include "exprs/expr_context.h"
+#include "exprs/slot_ref.h"
+#include "gen_cpp/Exprs_types.h"
+#include "olap/utils.h"
+#include "runtime/datetime_value.h"
+#include "runtime/primitive_type.h"
+
+using std::string;
+using std::vector;
+
+namespace palo {
+
+namespace {
+
+// 从行数据中读出用于比较的值, S是存储类型, C是比较时使用的类型
+template<typename S, typename C>
+inline C load_value(const char* ptr) {
+    S value;
+    memcpy(&value, ptr, sizeof(S));
+    return static_cast<C>(value);
+}
+
+template<TExprOpcode::type OP> struct CompareOp;
+
+template<> struct CompareOp<TExprOpcode::EQ> {
+    template<typename T> static bool apply(const T& a, const T& b) { return a == b; }
+};
+template<> struct CompareOp<TExprOpcode::NE> {
+    template<typename T> static bool apply(const T& a, const T& b) { return a != b; }
+};
+template<> struct CompareOp<TExprOpcode::LT> {
+    template<typename T> static bool apply(const T& a, const T& b) { return a < b; }
+};
+template<> struct CompareOp<TExprOpcode::LE> {
+    template<typename T> static bool apply(const T& a, const T& b) { return a <= b; }
+};
+template<> struct CompareOp<TExprOpcode::GT> {
+    template<typename T> static bool apply(const T& a, const T& b) { return a > b; }
+};
+template<> struct CompareOp<TExprOpcode::GE> {
+    template<typename T> static bool apply(const T& a, const T& b) { return a >= b; }
+};
+
+// 无分支的比较 + 压缩: 每一行都写入out[k], 满足条件时k才前进, in-place(out == sel)也是安全的
+template<typename S, typename C, TExprOpcode::type OP>
+int compare_scalar(const FilterColumn& column, C value, const int* sel, int n, int* out) {
+    int k = 0;
+    if (column.is_nullable) {
+        for (int i = 0; i < n; ++i) {
+            int row = sel[i];
+            const char* ptr = column.data + static_cast<size_t>(row) * column.stride;
+            out[k] = row;
+            k += (column.null_flags[static_cast<size_t>(row) * column.null_stride] == 0)
+                    & CompareOp<OP>::apply(load_value<S, C>(ptr), value);
+        }
+    } else {
+        for (int i = 0; i < n; ++i) {
+            int row = sel[i];
+            const char* ptr = column.data + static_cast<size_t>(row) * column.stride;
+            out[k] = row;
+            k += CompareOp<OP>::apply(load_value<S, C>(ptr), value);
+        }
+    }
+    return k;
+}
+
+template<typename S, typename C>
+int range_scalar(const FilterColumn& column, C low, C high, const int* sel, int n, int* out) {
+    int k = 0;
+    for (int i = 0; i < n; ++i) {
+        int row = sel[i];
+        const char* ptr = column.data + static_cast<size_t>(row) * column.stride;
+        C v = load_value<S, C>(ptr);
+        out[k] = row;
+        k += (!column.is_nullable
+                || column.null_flags[static_cast<size_t>(row) * column.null_stride] == 0)
+                & (v >= low) & (v <= high);
+    }
+    return k;
+}
+
+#ifdef __AVX2__
+
+// 8位掩码到压缩排列的查找表: 第m项把m中为1的lane依次排到前面
+struct CompressTable {
+    CompressTable() {
+        for (int mask = 0; mask < 256; ++mask) {
+            int k = 0;
+            for (int lane = 0; lane < 8; ++lane) {
+                if (mask & (1 << lane)) {
+                    perm[mask][k++] = lane;
+                }
+            }
+            for (; k < 8; ++k) {
+                perm[mask][k] = 0;
+            }
+        }
+    }
+    int32_t perm[256][8];
+};
+
+static const CompressTable s_compress_table;
+
+// 对8个lane的比较结果做压缩, 返回写入的行数
+inline int compress_store(__m256i rows, int mask, int* out) {
+    __m256i perm = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(s_compress_table.perm[mask]));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                        _mm256_permutevar8x32_epi32(rows, perm));
+    return __builtin_popcount(mask);
+}
+
+template<TExprOpcode::type OP>
+inline __m256i compare_epi32(__m256i a, __m256i b) {
+    const __m256i ones = _mm256_set1_epi32(-1);
+    switch (OP) {
+    case TExprOpcode::EQ: return _mm256_cmpeq_epi32(a, b);
+    case TExprOpcode::NE: return _mm256_xor_si256(_mm256_cmpeq_epi32(a, b), ones);
+    case TExprOpcode::LT: return _mm256_cmpgt_epi32(b, a);
+    case TExprOpcode::LE: return _mm256_xor_si256(_mm256_cmpgt_epi32(a, b), ones);
+    case TExprOpcode::GT: return _mm256_cmpgt_epi32(a, b);
+    default: return _mm256_xor_si256(_mm256_cmpgt_epi32(b, a), ones);
+    }
+}
+
+template<TExprOpcode::type OP>
+inline __m256i compare_epi64(__m256i a, __m256i b) {
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    switch (OP) {
+    case TExprOpcode::EQ: return _mm256_cmpeq_epi64(a, b);
+    case TExprOpcode::NE: return _mm256_xor_si256(_mm256_cmpeq_epi64(a, b), ones);
+    case TExprOpcode::LT: return _mm256_cmpgt_epi64(b, a);
+    case TExprOpcode::LE: return _mm256_xor_si256(_mm256_cmpgt_epi64(a, b), ones);
+    case TExprOpcode::GT: return _mm256_cmpgt_epi64(a, b);
+    default: return _mm256_xor_si256(_mm256_cmpgt_epi64(b, a), ones);
+    }
+}
+
+// 非null的lane为全1. gather 4个字节后只保留null标记所在的最低字节
+inline __m256i not_null_epi32(const FilterColumn& column, __m256i rows) {
+    __m256i offsets = _mm256_mullo_epi32(rows, _mm256_set1_epi32(column.null_stride));
+    __m256i flags = _mm256_i32gather_epi32(
+            reinterpret_cast<const int*>(column.null_flags), offsets, 1);
+    flags = _mm256_and_si256(flags, _mm256_set1_epi32(0xFF));
+    return _mm256_cmpeq_epi32(flags, _mm256_setzero_si256());
+}
+
+// 4字节整数列: 一次处理8行
+template<TExprOpcode::type OP>
+int compare_simd_int32(const FilterColumn& column, int32_t value,
+                       const int* sel, int n, int* out) {
+    const __m256i stride = _mm256_set1_epi32(column.stride);
+    const __m256i target = _mm256_set1_epi32(value);
+    const int* base = reinterpret_cast<const int*>(column.data);
+    int k = 0;
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i rows = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sel + i));
+        __m256i offsets = _mm256_mullo_epi32(rows, stride);
+        __m256i result = compare_epi32<OP>(_mm256_i32gather_epi32(base, offsets, 1), target);
+        if (column.is_nullable) {
+            result = _mm256_and_si256(result, not_null_epi32(column, rows));
+        }
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(result));
+        k += compress_store(rows, mask, out + k);
+    }
+    return k + compare_scalar<int32_t, int32_t, OP>(column, value, sel + i, n - i, out + k);
+}
+
+// 8字节整数列(BIGINT/DATETIME): 一次处理8行, 分两次gather
+template<typename S, TExprOpcode::type OP>
+int compare_simd_int64(const FilterColumn& column, int64_t value,
+                       const int* sel, int n, int* out) {
+    const __m256i stride = _mm256_set1_epi32(column.stride);
+    const __m256i target = _mm256_set1_epi64x(value);
+    const long long* base = reinterpret_cast<const long long*>(column.data);
+    int k = 0;
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i rows = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sel + i));
+        __m256i offsets = _mm256_mullo_epi32(rows, stride);
+        __m256i lo = compare_epi64<OP>(
+                _mm256_i32gather_epi64(base, _mm256_castsi256_si128(offsets), 1), target);
+        __m256i hi = compare_epi64<OP>(
+                _mm256_i32gather_epi64(base, _mm256_extracti128_si256(offsets, 1), 1), target);
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(lo))
+                | (_mm256_movemask_pd(_mm256_castsi256_pd(hi)) << 4);
+        if (column.is_nullable) {
+            mask &= _mm256_movemask_ps(_mm256_castsi256_ps(not_null_epi32(column, rows)));
+        }
+        k += compress_store(rows, mask, out + k);
+    }
+    return k + compare_scalar<S, int64_t, OP>(column, value, sel + i, n - i, out + k);
+}
+
+#endif // __AVX2__
+
+template<TExprOpcode::type OP>
+int compare_typed(FieldType type, const FilterColumn& column,
+                  __int128 int_value, double real_value, const int* sel, int n, int* out) {
+    switch (type) {
+    case OLAP_FIELD_TYPE_TINYINT:
+        return compare_scalar<int8_t, int32_t, OP>(column, int_value, sel, n, out);
+    case OLAP_FIELD_TYPE_SMALLINT:
+        return compare_scalar<int16_t, int32_t, OP>(column, int_value, sel, n, out);
+    case OLAP_FIELD_TYPE_DATE:
+        return compare_scalar<uint24_t, int32_t, OP>(column, int_value, sel, n, out);
+    case OLAP_FIELD_TYPE_INT:
+#ifdef __AVX2__
+        return compare_simd_int32<OP>(column, int_value, sel, n, out);
+#else
+        return compare_scalar<int32_t, int32_t, OP>(column, int_value, sel, n, out);
+#endif
+    case OLAP_FIELD_TYPE_BIGINT:
+#ifdef __AVX2__
+        return compare_simd_int64<int64_t, OP>(column, int_value, sel, n, out);
+#else
+        return compare_scalar<int64_t, int64_t, OP>(column, int_value, sel, n, out);
+#endif
+    case OLAP_FIELD_TYPE_DATETIME:
+        // olap中的datetime是YYYYMMDDhhmmss, 不会超过int64_t的范围
+#ifdef __AVX2__
+        return compare_simd_int64<uint64_t, OP>(column, int_value, sel, n, out);
+#else
+        return compare_scalar<uint64_t, int64_t, OP>(column, int_value, sel, n, out);
+#endif
+    case OLAP_FIELD_TYPE_LARGEINT:
+        return compare_scalar<__int128, __int128, OP>(column, int_value, sel, n, out);
+    case OLAP_FIELD_TYPE_FLOAT:
+        return compare_scalar<float, float, OP>(column, real_value, sel, n, out);
+    case OLAP_FIELD_TYPE_DOUBLE:
+        return compare_scalar<double, double, OP>(column, real_value, sel, n, out);
+    default:
+        DCHECK(false) << "unsupported type: " << type;
+        return n;
+    }
+}
+
+int range_typed(FieldType type, const FilterColumn& column,
+                __int128 low_int, __int128 high_int, double low_real, double high_real,
+                const int* sel, int n, int* out) {
+    switch (type) {
+    case OLAP_FIELD_TYPE_TINYINT:
+        return range_scalar<int8_t, int32_t>(column, low_int, high_int, sel, n, out);
+    case OLAP_FIELD_TYPE_SMALLINT:
+        return range_scalar<int16_t, int32_t>(column, low_int, high_int, sel, n, out);
+    case OLAP_FIELD_TYPE_DATE:
+        return range_scalar<uint24_t, int32_t>(column, low_int, high_int, sel, n, out);
+    case OLAP_FIELD_TYPE_INT:
+        return range_scalar<int32_t, int32_t>(column, low_int, high_int, sel, n, out);
+    case OLAP_FIELD_TYPE_BIGINT:
+        return range_scalar<int64_t, int64_t>(column, low_int, high_int, sel, n, out);
+    case OLAP_FIELD_TYPE_DATETIME:
+        return range_scalar<uint64_t, int64_t>(column, low_int, high_int, sel, n, out);
+    case OLAP_FIELD_TYPE_LARGEINT:
+        return range_scalar<__int128, __int128>(column, low_int, high_int, sel, n, out);
+    case OLAP_FIELD_TYPE_FLOAT:
+        return range_scalar<float, float>(column, low_real, high_real, sel, n, out);
+    case OLAP_FIELD_TYPE_DOUBLE:
+        return range_scalar<double, double>(column, low_real, high_real, sel, n, out);
+    default:
+        DCHECK(false) << "unsupported type: " << type;
+        return n;
+    }
+}
+
+// 比较谓词支持的列类型, 以及该列在执行层对应的类型
+bool get_compare_type(FieldType field_type, PrimitiveType* type) {
+    switch (field_type) {
+    case OLAP_FIELD_TYPE_TINYINT: *type = TYPE_TINYINT; return true;
+    case OLAP_FIELD_TYPE_SMALLINT: *type = TYPE_SMALLINT; return true;
+    case OLAP_FIELD_TYPE_INT: *type = TYPE_INT; return true;
+    case OLAP_FIELD_TYPE_BIGINT: *type = TYPE_BIGINT; return true;
+    case OLAP_FIELD_TYPE_LARGEINT: *type = TYPE_LARGEINT; return true;
+    case OLAP_FIELD_TYPE_FLOAT: *type = TYPE_FLOAT; return true;
+    case OLAP_FIELD_TYPE_DOUBLE: *type = TYPE_DOUBLE; return true;
+    case OLAP_FIELD_TYPE_DATE: *type = TYPE_DATE; return true;
+    case OLAP_FIELD_TYPE_DATETIME: *type = TYPE_DATETIME; return true;
+    default: return false;
+    }
+}
+
+// 没有cast的SlotRef, 返回对应的列下标, 否则返回-1
+int get_column_index(Expr* expr, const vector<FieldInfo>& tablet_schema) {
+    if (expr->node_type() != TExprNodeType::SLOT_REF || expr->op() == TExprOpcode::CAST) {
+        return -1;
+    }
+    const string& col_name = static_cast<SlotRef*>(expr)->col_name();
+    for (size_t i = 0; i < tablet_schema.size(); ++i) {
+        if (tablet_schema[i].name == col_name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+TExprOpcode::type swap_op(TExprOpcode::type op) {
+    switch (op) {
+    case TExprOpcode::LT: return TExprOpcode::GT;
+    case TExprOpcode::LE: return TExprOpcode::GE;
+    case TExprOpcode::GT: return TExprOpcode::LT;
+    case TExprOpcode::GE: return TExprOpcode::LE;
+    default: return op;
+    }
+}
+
+}  // namespace
+
+void VectorizedFilter::init(const vector<ExprContext*>& conjunct_ctxs,
+                            const vector<FieldInfo>& tablet_schema) {
+    clear();
+    for (size_t i = 0; i < conjunct_ctxs.size(); ++i) {
+        Node node;
+        if (_compile(conjunct_ctxs[i], conjunct_ctxs[i]->root(), tablet_schema, &node)) {
+            _conjuncts.push_back(node);
+        } else {
+            _fallback_conjunct_ctxs.push_back(conjunct_ctxs[i]);
+        }
+    }
+    OLAP_LOG_DEBUG("init vectorized filter. [conjuncts=%lu vectorized=%lu]",
+                   conjunct_ctxs.size(), _conjuncts.size());
+}
+
+bool VectorizedFilter::_compile(ExprContext* ctx, Expr* expr,
+                                const vector<FieldInfo>& tablet_schema, Node* node) {
+    switch (expr->node_type()) {
+    case TExprNodeType::BINARY_PRED:
+        return _compile_compare(ctx, expr, tablet_schema, node);
+    case TExprNodeType::FUNCTION_CALL: {
+        string is_null_str;
+        if (!expr->is_null_scalar_function(is_null_str) || expr->get_num_children() != 1) {
+            return false;
+        }
+        return _compile_is_null(expr->get_child(0), is_null_str == "null", tablet_schema, node);
+    }
+    case TExprNodeType::COMPOUND_PRED: {
+        if (expr->op() == TExprOpcode::COMPOUND_AND) {
+            node->kind = Node::AND;
+        } else if (expr->op() == TExprOpcode::COMPOUND_OR) {
+            node->kind = Node::OR;
+        } else {
+            return false;
+        }
+        for (int i = 0; i < expr->get_num_children(); ++i) {
+            Node child;
+            if (!_compile(ctx, expr->get_child(i), tablet_schema, &child)) {
+                return false;
+            }
+            // 展开嵌套的同类节点, 方便合并BETWEEN
+            if (child.kind == node->kind) {
+                node->children.insert(node->children.end(),
+                                      child.children.begin(), child.children.end());
+            } else {
+                node->children.push_back(child);
+            }
+        }
+        if (node->kind == Node::AND) {
+            _merge_range(node);
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+bool VectorizedFilter::_compile_compare(ExprContext* ctx, Expr* expr,
+                                        const vector<FieldInfo>& tablet_schema, Node* node) {
+    TExprOpcode::type op = expr->op();
+    if (op != TExprOpcode::EQ && op != TExprOpcode::NE
+            && op != TExprOpcode::LT && op != TExprOpcode::LE
+            && op != TExprOpcode::GT && op != TExprOpcode::GE) {
+        return false;
+    }
+    if (expr->get_num_children() != 2) {
+        return false;
+    }
+
+    int slot_idx = 0;
+    int column = get_column_index(expr->get_child(0), tablet_schema);
+    if (column < 0) {
+        slot_idx = 1;
+        column = get_column_index(expr->get_child(1), tablet_schema);
+        op = swap_op(op);
+    }
+    if (column < 0) {
+        return false;
+    }
+
+    Expr* slot = expr->get_child(slot_idx);
+    Expr* literal = expr->get_child(1 - slot_idx);
+    PrimitiveType type;
+    if (!get_compare_type(tablet_schema[column].type, &type)
+            || slot->type().type != type
+            || literal->type().type != type
+            || !literal->is_constant()) {
+        return false;
+    }
+    // col op NULL的结果是NULL, 交给原有路径处理
+    void* value = ctx->get_value(literal, NULL);
+    if (value == NULL) {
+        return false;
+    }
+
+    node->kind = Node::COMPARE;
+    node->column = column;
+    node->type = tablet_schema[column].type;
+    node->op = op;
+    switch (type) {
+    case TYPE_TINYINT:
+        node->low_int = *reinterpret_cast<int8_t*>(value);
+        break;
+    case TYPE_SMALLINT:
+        node->low_int = *reinterpret_cast<int16_t*>(value);
+        break;
+    case TYPE_INT:
+        node->low_int = *reinterpret_cast<int32_t*>(value);
+        break;
+    case TYPE_BIGINT:
+        node->low_int = *reinterpret_cast<int64_t*>(value);
+        break;
+    case TYPE_LARGEINT:
+        memcpy(&node->low_int, value, sizeof(__int128));
+        break;
+    case TYPE_FLOAT:
+        node->low_real = *reinterpret_cast<float*>(value);
+        break;
+    case TYPE_DOUBLE:
+        node->low_real = *reinterpret_cast<double*>(value);
+        break;
+    case TYPE_DATE:
+        node->low_int = reinterpret_cast<DateTimeValue*>(value)->to_olap_date();
+        break;
+    case TYPE_DATETIME:
+        node->low_int = reinterpret_cast<DateTimeValue*>(value)->to_olap_datetime();
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+bool VectorizedFilter::_compile_is_null(Expr* expr, bool is_null,
+                                        const vector<FieldInfo>& tablet_schema, Node* node) {
+    int column = get_column_index(expr, tablet_schema);
+    // 变长列的null标记不在定长部分
+    if (column < 0
+            || tablet_schema[column].type == OLAP_FIELD_TYPE_VARCHAR
+            || tablet_schema[column].type == OLAP_FIELD_TYPE_HLL) {
+        return false;
+    }
+    node->kind = is_null ? Node::IS_NULL : Node::IS_NOT_NULL;
+    node->column = column;
+    node->type = tablet_schema[column].type;
+    return true;
+}
+
+void VectorizedFilter::_merge_range(Node* node) {
+    vector<Node>& children = node->children;
+    for (size_t i = 0; i < children.size(); ++i) {
+        if (children[i].kind != Node::COMPARE
+                || (children[i].op != TExprOpcode::GE && children[i].op != TExprOpcode::LE)) {
+            continue;
+        }
+        for (size_t j = i + 1; j < children.size(); ++j) {
+            TExprOpcode::type pair_op = children[i].op == TExprOpcode::GE
+                    ? TExprOpcode::LE : TExprOpcode::GE;
+            if (children[j].kind != Node::COMPARE
+                    || children[j].column != children[i].column
+                    || children[j].op != pair_op) {
+                continue;
+            }
+            const Node& low = children[i].op == TExprOpcode::GE ? children[i] : children[j];
+            const Node& high = children[i].op == TExprOpcode::GE ? children[j] : children[i];
+            Node range;
+            range.kind = Node::RANGE;
+            range.column = low.column;
+            range.type = low.type;
+            range.low_int = low.low_int;
+            range.high_int = high.low_int;
+            range.low_real = low.low_real;
+            range.high_real = high.low_real;
+            children[i] = range;
+            children.erase(children.begin() + j);
+            break;
+        }
+    }
+}
+
+int VectorizedFilter::evaluate(const vector<FilterColumn>& columns, int* sel, int n) const {
+    for (size_t i = 0; i < _conjuncts.size() && n > 0; ++i) {
+        n = _evaluate(_conjuncts[i], columns, sel, n, sel);
+    }
+    return n;
+}
+
+int VectorizedFilter::_evaluate(const Node& node, const vector<FilterColumn>& columns,
+                                const int* sel, int n, int* out) {
+    switch (node.kind) {
+    case Node::COMPARE: {
+        const FilterColumn& column = columns[node.column];
+        switch (node.op) {
+        case TExprOpcode::EQ:
+            return compare_typed<TExprOpcode::EQ>(
+                    node.type, column, node.low_int, node.low_real, sel, n, out);
+        case TExprOpcode::NE:
+            return compare_typed<TExprOpcode::NE>(
+                    node.type, column, node.low_int, node.low_real, sel, n, out);
+        case TExprOpcode::LT:
+            return compare_typed<TExprOpcode::LT>(
+                    node.type, column, node.low_int, node.low_real, sel, n, out);
+        case TExprOpcode::LE:
+            return compare_typed<TExprOpcode::LE>(
+                    node.type, column, node.low_int, node.low_real, sel, n, out);
+        case TExprOpcode::GT:
+            return compare_typed<TExprOpcode::GT>(
+                    node.type, column, node.low_int, node.low_real, sel, n, out);
+        default:
+            return compare_typed<TExprOpcode::GE>(
+                    node.type, column, node.low_int, node.low_real, sel, n, out);
+        }
+    }
+    case Node::RANGE:
+        return range_typed(node.type, columns[node.column],
+                           node.low_int, node.high_int, node.low_real, node.high_real,
+                           sel, n, out);
+    case Node::IS_NULL:
+    case Node::IS_NOT_NULL: {
+        const FilterColumn& column = columns[node.column];
+        if (!column.is_nullable) {
+            if (node.kind == Node::IS_NULL) {
+                return 0;
+            }
+            if (out != sel) {
+                memcpy(out, sel, sizeof(int) * n);
+            }
+            return n;
+        }
+        char expected = node.kind == Node::IS_NULL ? 1 : 0;
+        int k = 0;
+        for (int i = 0; i < n; ++i) {
+            int row = sel[i];
+            out[k] = row;
+            k += ((column.null_flags[static_cast<size_t>(row) * column.null_stride] != 0)
+                    == expected);
+        }
+        return k;
+    }
+    case Node::AND: {
+        for (size_t i = 0; i < node.children.size(); ++i) {
+            n = _evaluate(node.children[i], columns, i == 0 ? sel : out, n, out);
+            if (n == 0) {
+                break;
+            }
+        }
+        return n;
+    }
+    case Node::OR: {
+        // selected: 已满足条件的行; remaining: 还没有满足条件的行
+        vector<int> selected;
+        vector<int> remaining(sel, sel + n);
+        vector<int> passed(n);
+        vector<int> merged(n);
+        for (size_t i = 0; i < node.children.size() && !remaining.empty(); ++i) {
+            int num = _evaluate(node.children[i], columns,
+                                &remaining[0], remaining.size(), &passed[0]);
+            if (num == 0) {
+                continue;
+            }
+            merged.resize(selected.size() + num);
+            std::merge(selected.begin(), selected.end(),
+                       passed.begin(), passed.begin() + num, merged.begin());
+            selected.swap(merged);
+            // passed是remaining的子序列, 求差集
+            vector<int>::iterator end = std::set_difference(
+                    remaining.begin(), remaining.end(),
+                    passed.begin(), passed.begin() + num, remaining.begin());
+            remaining.erase(end, remaining.end());
+        }
+        if (!selected.empty()) {
+            memcpy(out, &selected[0], sizeof(int) * selected.size());
+        }
+        return selected.size();
+    }
+    default:
+        return n;
+    }
+}
+
+}  // namespace palo
@@ -0,0 +1,126 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_OLAP_VECTORIZED_FILTER_H
+#define BDG_PALO_BE_SRC_OLAP_VECTORIZED_FILTER_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "gen_cpp/Opcodes_types.h"
+#include "olap/field.h"
+#include "olap/olap_common.h"
+
+namespace palo {
+
+class Expr;
+class ExprContext;
+
+// RowBlock或VectorizedRowBatch中一列定长数据的位置
+struct FilterColumn {
+    FilterColumn() : data(NULL), stride(0), is_nullable(false),
+            null_flags(NULL), null_stride(0) {}
+
+    const char* data;       // 第0行的值
+    uint32_t stride;        // 相邻两行之间的字节数
+    bool is_nullable;
+    // is_nullable时第0行的null标记, 非0表示null. RowBlock中是值前面的一个字节,
+    // VectorizedRowBatch中是ColumnVector::is_null(). AVX2下一次读取4个字节,
+    // 最后一行的标记后面需要至少3个字节可读
+    const char* null_flags;
+    uint32_t null_stride;   // 相邻两行null标记之间的字节数
+};
+
+// 基于选择向量(selection vector)的条件过滤, 直接在RowBlock或VectorizedRowBatch的列数据上计算.
+// 支持常见的谓词形式:
+//   1. 列与常量的比较: =, !=, <, <=, >, >=, 常量在左边时交换操作符
+//   2. BETWEEN: FE改写成的同一列上的>=和<=, 合并成一次区间比较
+//   3. IS NULL / IS NOT NULL
+//   4. 以上谓词的AND/OR组合
+// 每个谓词把输入选择向量中满足条件的行号按顺序压缩到输出中, AND依次缩小选择向量,
+// OR只对还没有选中的行求值后归并. 在AVX2下, 4/8字节的整数列使用gather + 比较 + 查表压缩,
+// 其他情况使用无分支的标量循环.
+// 不支持的conjunct保留在fallback_conjunct_ctxs中, 由调用方使用原有的Expr::evaluate计算.
+class VectorizedFilter {
+public:
+    VectorizedFilter() {}
+
+    // 编译conjuncts, 可以重复调用
+    void init(const std::vector<ExprContext*>& conjunct_ctxs,
+              const std::vector<FieldInfo>& tablet_schema);
+
+    void clear() {
+        _conjuncts.clear();
+        _fallback_conjunct_ctxs.clear();
+    }
+
+    bool empty() const {
+        return _conjuncts.empty();
+    }
+
+    const std::vector<ExprContext*>& fallback_conjunct_ctxs() const {
+        return _fallback_conjunct_ctxs;
+    }
+
+    // 对sel中的n行执行所有编译过的conjunct, 结果按行号递增写回sel, 返回满足条件的行数.
+    // columns按tablet_schema的下标访问, 只需要填充被引用到的列.
+    int evaluate(const std::vector<FilterColumn>& columns, int* sel, int n) const;
+
+private:
+    struct Node {
+        enum Kind {
+            COMPARE,        // column op value
+            RANGE,          // low <= column <= high
+            IS_NULL,
+            IS_NOT_NULL,
+            AND,
+            OR
+        };
+
+        Node() : kind(AND), column(-1), type(OLAP_FIELD_TYPE_NONE), op(TExprOpcode::EQ),
+                low_int(0), high_int(0), low_real(0), high_real(0) {}
+
+        Kind kind;
+        int column;
+        FieldType type;
+        TExprOpcode::type op;
+        // 整数类型和DATE/DATETIME使用int, FLOAT/DOUBLE使用real; COMPARE只使用low
+        __int128 low_int;
+        __int128 high_int;
+        double low_real;
+        double high_real;
+        std::vector<Node> children;
+    };
+
+    static bool _compile(ExprContext* ctx, Expr* expr,
+                         const std::vector<FieldInfo>& tablet_schema, Node* node);
+    static bool _compile_compare(ExprContext* ctx, Expr* expr,
+                                 const std::vector<FieldInfo>& tablet_schema, Node* node);
+    static bool _compile_is_null(Expr* expr, bool is_null,
+                                 const std::vector<FieldInfo>& tablet_schema, Node* node);
+    // 把AND中同一列上的>=和<=合并成RANGE
+    static void _merge_range(Node* node);
+
+    static int _evaluate(const Node& node, const std::vector<FilterColumn>& columns,
+                         const int* sel, int n, int* out);
+
+    std::vector<Node> _conjuncts;
+    std::vector<ExprContext*> _fallback_conjunct_ctxs;
+};
+
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_OLAP_VECTORIZED_FILTER_H
@@ -71,6 +71,19 @@ public:
     }
     virtual OLAPStatus attached_by(RowCursor* row_cursor) = 0;
     void next(const RowCursor& row_cursor) {
+        _update_column_statistics(row_cursor);
+        ++_row_index;
+    }
+    virtual OLAPStatus finalize() = 0;
+    virtual OLAPStatus write_row_block(RowBlock* row_block) = 0;
+    virtual uint64_t written_bytes() = 0;
+    // Factory function
+    // 调用者获得新建的对象, 并负责delete释放
+    static IWriter* create(SmartOLAPTable table, OLAPIndex* index, bool is_push_write);
+
+protected:
+    // 用写入行的key列更新各key列的最小最大值, row_cursor只需要包含key列
+    void _update_column_statistics(const RowCursor& row_cursor) {
         for (size_t i = 0; i < _table->num_key_fields(); ++i) {
             /*
             if (NULL == row_cursor.get_field_by_index(i)) {
@@ -86,17 +99,8 @@ public:
                 _column_statistics[i].second->copy(row_cursor.get_field_by_index(i));
             }
         }
-
-        ++_row_index;
     }
-    virtual OLAPStatus finalize() = 0;
-    virtual OLAPStatus write_row_block(RowBlock* row_block) = 0;
-    virtual uint64_t written_bytes() = 0;
-    // Factory function
-    // 调用者获得新建的对象, 并负责delete释放
-    static IWriter* create(SmartOLAPTable table, OLAPIndex* index, bool is_push_write);
 
-protected:
     bool _is_push_write;
     SmartOLAPTable _table;
     std::vector<std::pair<Field *, Field *> > _column_statistics; // first is min, second is max
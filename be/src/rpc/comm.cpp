@@ -186,7 +186,17 @@ bool Comm::wait_for_proxy_load(Timer &timer) {
 
 int
 Comm::listen(const CommAddress &addr, ConnectionHandlerFactoryPtr &chf,
-             const DispatchHandlerPtr &default_handler) {
+             const DispatchHandlerPtr &default_handler, int num_sockets) {
+    int error = error::OK;
+    for (int i = 0; i < std::max(num_sockets, 1) && error == error::OK; ++i) {
+        error = listen_socket(addr, chf, default_handler, num_sockets > 1);
+    }
+    return error;
+}
+
+int
+Comm::listen_socket(const CommAddress &addr, ConnectionHandlerFactoryPtr &chf,
+                    const DispatchHandlerPtr &default_handler, bool reuse_port) {
     IOHandlerAccept *handler = 0;
     int one = 1;
     int sd = -1;
@@ -207,6 +217,12 @@ Comm::listen(const CommAddress &addr, ConnectionHandlerFactoryPtr &chf,
         LOG(ERROR) << "set socket SO_REUSEADDR option failed."
                    << "[socket=" << sd << ", [error=" << strerror(errno) << "]";
     }
+    if (reuse_port && setsockopt(sd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0) {
+        LOG(ERROR) << "set socket SO_REUSEPORT option failed."
+                   << "[socket=" << sd << ", error=" << strerror(errno) << "]";
+        ::close(sd);
+        return error::COMM_SOCKET_ERROR;
+    }
     int bind_attempts = 0;
     while ((::bind(sd, (const sockaddr *)&addr.inet, sizeof(sockaddr_in))) < 0) {
         if (bind_attempts == 24) {
@@ -233,15 +233,20 @@ public:
      * is registered as the default dispatch handler for the newly created
      * listen (accept) socket and Event::CONNECTION_ESTABLISHED events will be
      * delivered to the application via this handler.
+     * If <code>num_sockets</code> is greater than one, that many sockets
+     * are bound to <code>addr</code> with <code>SO_REUSEPORT</code>, so
+     * that the kernel spreads the incoming connections over them and their
+     * accept handlers, which are assigned to reactors round-robin.
      * @param addr IP address and port on which to listen for connections
      * @param chf Smart pointer to connection handler factory
      * @param default_handler Smart pointer to default dispatch handler
+     * @param num_sockets Number of listen sockets to create
      * @throws Exception Code set to error::COMM_SOCKET_ERROR,
      * error::COMM_BIND_ERROR, error::COMM_LISTEN_ERROR,
      * error::COMM_SEND_ERROR, or error::COMM_RECEIVE_ERROR
      */
     int listen(const CommAddress &addr, ConnectionHandlerFactoryPtr &chf,
-            const DispatchHandlerPtr &default_handler);
+            const DispatchHandlerPtr &default_handler, int num_sockets = 1);
 
     /** Sends a request message over a connection, expecting a response.  The
      * connection is specified by <code>addr</code> which is the remote end of
@@ -435,6 +440,12 @@ private:
     /** Destructor */
     ~Comm();
 
+    /** Creates one listen (accept) socket on <code>addr</code>, see #listen.
+     * @param reuse_port Sets <code>SO_REUSEPORT</code> on the socket
+     */
+    int listen_socket(const CommAddress &addr, ConnectionHandlerFactoryPtr &chf,
+            const DispatchHandlerPtr &default_handler, bool reuse_port);
+
     /** Sends a request message over a connection.
      * @anchor private_send_request
      * This method sets the CommHeader::FLAGS_BIT_REQUEST bit of the flags
@@ -116,6 +116,30 @@ public:
             ext_ptr = ext.base;
         }
 
+    /** Constructor.  Like the one above, but the extended buffer is
+     * <code>ext_len</code> bytes at <code>ext_data</code>, which
+     * <code>ext_owner</code> keeps alive until the message is written and the
+     * CommBuf is destroyed. This lets a message be sent from memory that is
+     * shared with others without copying it.
+     * @param hdr Comm header
+     * @param len Length of the primary buffer to allocate
+     * @param ext_data Extended buffer
+     * @param ext_len Length of extended buffer
+     * @param ext_owner Owner of the extended buffer
+     */
+    CommBuf(CommHeader &hdr, uint32_t len, const uint8_t *ext_data, uint32_t ext_len,
+            const std::shared_ptr<const void> &ext_owner) :
+        header(hdr), ext_owner(ext_owner) {
+            len += header.encoded_length();
+            data.set(new uint8_t[len], len, true);
+            data_ptr = data.base + header.encoded_length();
+            ext.base = const_cast<uint8_t *>(ext_data);
+            ext.size = ext_len;
+            ext.own = false;
+            header.set_total_length(len+ext_len);
+            ext_ptr = ext.base;
+        }
+
     ~CommBuf() { }
 
     /** Encodes the header at the beginning of the primary buffer.
@@ -287,6 +311,8 @@ protected:
     const uint8_t* ext_ptr;
     /// Smart pointer to extended buffer memory
     boost::shared_array<uint8_t> ext_shared_array;
+    /// Owner of extended buffer memory shared with others
+    std::shared_ptr<const void> ext_owner;
 };
 
 /// Smart pointer to CommBuf
@@ -68,7 +68,7 @@ bool IOHandlerAccept::handle_incoming_connection() {
             LOG(ERROR) << "set socket TCP_NODELAY option failed."
                        << "[socket=" << sd << ", error=" << strerror(errno) << "]";
         }
-        if (setsockopt(m_sd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one)) < 0) {
+        if (setsockopt(sd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one)) < 0) {
             LOG(ERROR) << "set socket SO_KEEPALIVE option failed."
                        << "[socket=" << sd << ", [error=" << strerror(errno) << "]";
         }
@@ -20,6 +20,7 @@
 #include "file_utils.h"
 #include "inet_addr.h"
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <iostream>
@@ -62,6 +63,56 @@ IOHandlerData::et_socket_read(int fd, void *vptr, size_t n, int *errnop, bool *e
     return n - nleft;
 }
 
+ssize_t
+IOHandlerData::buffered_read(void *vptr, size_t n, int *errnop, bool *eofp) {
+    size_t nleft = n;
+    uint8_t *ptr = (uint8_t *)vptr;
+    while (nleft > 0) {
+        size_t nbuffered = m_read_end - m_read_begin;
+        if (nbuffered > 0) {
+            size_t len = std::min(nbuffered, nleft);
+            memcpy(ptr, m_read_begin, len);
+            m_read_begin += len;
+            nleft -= len;
+            ptr += len;
+            continue;
+        }
+        if (nleft >= READ_BUFFER_SIZE) {
+            // large payloads are read in place
+            ssize_t nread = et_socket_read(m_sd, ptr, nleft, errnop, eofp);
+            if (nread < 0) {
+                if (nleft < n) {
+                    break;
+                }
+                return -1;
+            }
+            nleft -= nread;
+            break;
+        }
+        if (!m_read_buffer) {
+            m_read_buffer.reset(new uint8_t[READ_BUFFER_SIZE]);
+        }
+        m_read_begin = m_read_end = m_read_buffer.get();
+        ssize_t nread = ::read(m_sd, m_read_buffer.get(), READ_BUFFER_SIZE);
+        if (nread < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            *errnop = errno;
+            if (*errnop == EAGAIN || nleft < n) {
+                break;
+            }
+            return -1;
+        }
+        else if (nread == 0) {
+            *eofp = true;
+            break;
+        }
+        m_read_end += nread;
+    }
+    return n - nleft;
+}
+
 ssize_t
 IOHandlerData::et_socket_writev(int fd, const iovec *vector, int count, int *errnop) {
     ssize_t nwritten = 0;
@@ -92,8 +143,8 @@ IOHandlerData::handle_event(struct epoll_event *event,
             size_t nread = 0;
             while (true) {
                 if (!m_got_header) {
-                    nread = et_socket_read(m_sd, m_message_header_ptr,
-                                           m_message_header_remaining, &error, &eof);
+                    nread = buffered_read(m_message_header_ptr,
+                                          m_message_header_remaining, &error, &eof);
                     if (nread == (size_t)-1) {
                         if (errno != ECONNREFUSED) {
                             LOG(ERROR) << "read data from socket failed."
@@ -124,8 +175,7 @@ IOHandlerData::handle_event(struct epoll_event *event,
                     }
                 }
                 else { // got header
-                    nread = et_socket_read(m_sd, m_message_ptr, m_message_remaining,
-                                           &error, &eof);
+                    nread = buffered_read(m_message_ptr, m_message_remaining, &error, &eof);
                     if (nread == (size_t)-1) {
                         LOG(ERROR) << "read data from socket failed."
                                    << "[socket=" << m_sd << ", "
@@ -391,78 +441,67 @@ int IOHandlerData::flush_send_queue() {
     ssize_t nwritten = 0;
     ssize_t towrite = 0;
     ssize_t remaining = 0;
-    struct iovec vec[2];
+    struct iovec vec[MAX_SEND_IOVECS];
     int count = 0;
     int error = 0;
     while (!m_send_queue.empty()) {
-        CommBufPtr &cbp = m_send_queue.front();
         count = 0;
         towrite = 0;
-        remaining = cbp->data.size - (cbp->data_ptr - cbp->data.base);
-        if (remaining > 0) {
-            vec[0].iov_base = (void *)cbp->data_ptr;
-            vec[0].iov_len = remaining;
-            towrite = remaining;
-            ++count;
-        }
-        if (cbp->ext.base != 0) {
-            remaining = cbp->ext.size - (cbp->ext_ptr - cbp->ext.base);
+        for (auto it = m_send_queue.begin();
+                it != m_send_queue.end() && count + 2 <= MAX_SEND_IOVECS; ++it) {
+            CommBufPtr &cbp = *it;
+            remaining = cbp->data.size - (cbp->data_ptr - cbp->data.base);
             if (remaining > 0) {
-                vec[count].iov_base = (void *)cbp->ext_ptr;
+                vec[count].iov_base = (void *)cbp->data_ptr;
                 vec[count].iov_len = remaining;
                 towrite += remaining;
                 ++count;
             }
+            if (cbp->ext.base != 0) {
+                remaining = cbp->ext.size - (cbp->ext_ptr - cbp->ext.base);
+                if (remaining > 0) {
+                    vec[count].iov_base = (void *)cbp->ext_ptr;
+                    vec[count].iov_len = remaining;
+                    towrite += remaining;
+                    ++count;
+                }
+            }
         }
-        nwritten = et_socket_writev(m_sd, vec, count, &error);
-        if (nwritten == (ssize_t)-1) {
-            if (error == EAGAIN)
-                return error::OK;
-            LOG(ERROR) << "write socket failed."
-                       << "[socket=" << m_sd << ", "
-                       << "towrite=" << (int)towrite << ", "
-                       << "error=" << strerror(errno) << "]";
-            return error::COMM_BROKEN_CONNECTION;
-        }
-        else if (nwritten < towrite) {
-            if (nwritten == 0) {
+        if (count > 0) {
+            nwritten = et_socket_writev(m_sd, vec, count, &error);
+            if (nwritten == (ssize_t)-1) {
                 if (error == EAGAIN)
-                    break;
-                if (error) {
-                    LOG(ERROR) << "write socket failed."
-                               << "[socket=" << m_sd << ", "
-                               << "towrite=" << (int)towrite << ", "
-                               << "error=" << strerror(errno) << "]";
-                    return error::COMM_BROKEN_CONNECTION;
-                }
-                continue;
+                    return error::OK;
+                LOG(ERROR) << "write socket failed."
+                           << "[socket=" << m_sd << ", "
+                           << "towrite=" << (int)towrite << ", "
+                           << "error=" << strerror(error) << "]";
+                return error::COMM_BROKEN_CONNECTION;
             }
+        }
+        // advance the write pointers over what was written, and remove the
+        // buffers written completely from the queue (destroys them)
+        while (!m_send_queue.empty()) {
+            CommBufPtr &cbp = m_send_queue.front();
             remaining = cbp->data.size - (cbp->data_ptr - cbp->data.base);
-            if (remaining > 0) {
-                if (nwritten < remaining) {
-                    cbp->data_ptr += nwritten;
-                    if (error == EAGAIN) {
-                        break;
-                    }
-                    error = 0;
-                    continue;
-                }
-                else {
-                    nwritten -= remaining;
-                    cbp->data_ptr += remaining;
-                }
+            if (nwritten < remaining) {
+                cbp->data_ptr += nwritten;
+                break;
             }
+            cbp->data_ptr += remaining;
+            nwritten -= remaining;
             if (cbp->ext.base != 0) {
-                cbp->ext_ptr += nwritten;
-                if (error == EAGAIN) {
+                remaining = cbp->ext.size - (cbp->ext_ptr - cbp->ext.base);
+                if (nwritten < remaining) {
+                    cbp->ext_ptr += nwritten;
                     break;
                 }
-                error = 0;
-                continue;
+                cbp->ext_ptr += remaining;
+                nwritten -= remaining;
             }
+            m_send_queue.pop_front();
         }
-        // buffer written successfully, now remove from queue (destroys buffer)
-        m_send_queue.pop_front();
+        nwritten = 0;
     }
     return error::OK;
 }
@@ -21,6 +21,7 @@
 #include "error.h"
 
 #include <list>
+#include <memory>
 
 extern "C" {
 #include <netdb.h>
@@ -110,6 +111,8 @@ public:
      *   - Send queue becomes empty
      *   - A write results in EAGAIN (socket buffer is full)
      *   - An error is encountered during a write
+     * The messages at the head of the queue are written together with one
+     * <code>writev</code> of up to #MAX_SEND_IOVECS buffers.
      * The send queue holds a list of CommBuf objects that contain <i>next
      * write</i> pointers that are updated by this method and allow it to
      * pick up where it left off in the event of EAGAIN.
@@ -174,7 +177,17 @@ private:
      */
     ssize_t et_socket_read(int fd, void *vptr, size_t n, int *errnop, bool *eofp);
 
+    /**
+     * Same as #et_socket_read on #m_sd, but reads that are smaller than
+     * #READ_BUFFER_SIZE are served from #m_read_buffer, which is refilled with
+     * one <code>read</code> of up to #READ_BUFFER_SIZE bytes. This way the
+     * headers and payloads of a burst of small messages take one system call
+     * instead of two per message.
+     */
+    ssize_t buffered_read(void *vptr, size_t n, int *errnop, bool *eofp);
+
     ssize_t et_socket_writev(int fd, const iovec *vector, int count, int *errnop);
+
     /** Processes a message header.  This method is called when the fixed
      * length portion of a header has been completely received.  It first
      * checks to see if there is a variable portion of the header that has
@@ -236,6 +249,23 @@ private:
     /// Amount of message payload remaining to be read
     size_t m_message_remaining {};
 
+    /// Size of #m_read_buffer
+    static const size_t READ_BUFFER_SIZE = 64 * 1024;
+
+    /// Maximum number of buffers #flush_send_queue writes with one
+    /// <code>writev</code>, a CommBuf takes up to two
+    static const int MAX_SEND_IOVECS = 64;
+
+    /// Bytes read off the socket ahead of the message being received,
+    /// allocated on the first read
+    std::unique_ptr<uint8_t[]> m_read_buffer;
+
+    /// Next unconsumed byte in #m_read_buffer
+    uint8_t *m_read_begin {};
+
+    /// End of the bytes read into #m_read_buffer
+    uint8_t *m_read_end {};
+
     /// Send queue
     std::list<CommBufPtr> m_send_queue;
 
@@ -22,6 +22,7 @@
 
 extern "C" {
 #include <signal.h>
+#include <unistd.h>
 }
 
 namespace palo {
@@ -34,7 +35,7 @@ std::atomic<int> ReactorFactory::ms_next_reactor(0);
 bool ReactorFactory::ms_epollet = true;
 bool ReactorFactory::proxy_master = false;
 
-void ReactorFactory::initialize(uint16_t reactor_count) {
+void ReactorFactory::initialize(uint16_t reactor_count, bool pin_threads) {
     std::lock_guard<std::mutex> lock(ms_mutex);
     if (!ms_reactors.empty())
         return;
@@ -44,10 +45,12 @@ void ReactorFactory::initialize(uint16_t reactor_count) {
     signal(SIGPIPE, SIG_IGN);
     assert(reactor_count > 0);
     ms_reactors.reserve(reactor_count+2);
+    long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
     for (uint16_t i=0; i<reactor_count+2; i++) {
         reactor = std::make_shared<Reactor>();
         ms_reactors.push_back(reactor);
         rrunner.set_reactor(reactor);
+        rrunner.set_cpu(pin_threads && num_cpus > 0 ? i % num_cpus : -1);
         ms_threads.create_thread(rrunner);
     }
 }
@@ -42,8 +42,10 @@ public:
      * than 2.6.17.  It also allocates a HandlerMap and initializes
      * ReactorRunner::handler_map to point to it.
      * @param reactor_count number of reactor threads to create
+     * @param pin_threads pin the reactor threads to CPUs round-robin, so that
+     * the connections of a reactor keep the caches of one core warm
      */
-    static void initialize(uint16_t reactor_count);
+    static void initialize(uint16_t reactor_count, bool pin_threads = false);
 
     /** This method shuts down the reactors
     */
@@ -29,6 +29,8 @@
 extern "C" {
 #include <errno.h>
 #include <poll.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <sys/types.h>
@@ -52,6 +54,16 @@ void ReactorRunner::operator()() {
     std::vector<IOHandler*> handlers;
     uint32_t dispatch_delay {};
     struct epoll_event events[256];
+    if (m_cpu >= 0) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(m_cpu, &cpu_set);
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+        if (ret != 0) {
+            LOG(WARNING) << "pin reactor thread to cpu " << m_cpu << " failed."
+                         << "[error=" << strerror(ret) << "]";
+        }
+    }
     while ((n = epoll_wait(m_reactor->epoll_fd, events, 256,
                            timeout.get_millis())) >= 0 || errno == EINTR) {
         if (record_arrival_time)
@@ -43,6 +43,11 @@ public:
      */
     void set_reactor(ReactorPtr &reactor) { m_reactor = reactor; }
 
+    /** Pins the reactor thread to a CPU.
+     * @param cpu CPU to run on, or -1 to run on any
+     */
+    void set_cpu(int cpu) { m_cpu = cpu; }
+
     /// Flag indicating that reactor thread is being shut down
     static bool shutdown;
 
@@ -65,6 +70,7 @@ private:
     void cleanup_and_remove_handlers(std::set<IOHandler *> &handlers);
 
     ReactorPtr m_reactor; //!< Smart pointer to reactor state object
+    int m_cpu {-1}; //!< CPU the thread is pinned to, -1 for none
 };
 
 } //namespace palo
@@ -0,0 +1,172 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/admission_controller.h"
+
+#include <algorithm>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/locks.hpp>
+
+#include "common/config.h"
+#include "common/logging.h"
+#include "util/blocking_aware_thread_pool.h"
+#include "util/debug_util.h"
+#include "util/palo_metrics.h"
+#include "util/pretty_printer.h"
+#include "util/stopwatch.hpp"
+
+namespace palo {
+
+using boost::mutex;
+using boost::unique_lock;
+
+// A waiting fragment checks for cancellation at least this often.
+static const int64_t CANCEL_CHECK_INTERVAL_MS = 100;
+
+AdmissionController::AdmissionController(int max_fragments, int64_t mem_limit) :
+        _max_fragments(max_fragments),
+        _mem_limit(mem_limit),
+        _next_ticket(0) {
+}
+
+bool AdmissionController::has_room(const Group& group, int64_t mem_limit) const {
+    if (group.num_running == 0) {
+        return true;
+    }
+    if (_max_fragments > 0 && group.num_running >= _max_fragments) {
+        return false;
+    }
+    return _mem_limit <= 0 || group.admitted_mem + mem_limit <= _mem_limit;
+}
+
+void AdmissionController::admit_locked(
+        Group* group, const TUniqueId& query_id, int64_t mem_limit) {
+    ++group->num_running;
+    group->admitted_mem += mem_limit;
+    ++group->running_queries[query_id];
+    ++group->num_admitted;
+}
+
+Status AdmissionController::admit(
+        const std::string& group_name, const TUniqueId& query_id, int64_t mem_limit,
+        const std::function<bool()>& is_cancelled) {
+    mem_limit = std::max<int64_t>(mem_limit, 0);
+    unique_lock<mutex> l(_lock);
+    Group& group = _groups[group_name];
+    if (group.running_queries.count(query_id) > 0
+            || (group.queue.empty() && has_room(group, mem_limit))) {
+        admit_locked(&group, query_id, mem_limit);
+        return Status::OK;
+    }
+    size_t max_queued = std::max(config::admission_max_queued_fragments, 0);
+    if (group.queue.size() >= max_queued) {
+        std::stringstream ss;
+        ss << "Too many fragments queued in resource group " << group_name
+            << ", the limit is " << config::admission_max_queued_fragments;
+        return Status(ss.str());
+    }
+
+    int64_t ticket = _next_ticket++;
+    group.queue.push_back(ticket);
+    ++group.num_queued;
+    if (PaloMetrics::admission_queued_fragments() != NULL) {
+        PaloMetrics::admission_queued_fragments()->increment(1);
+    }
+    VLOG(1) << "Fragment of query " << print_id(query_id) << " queued in resource group "
+            << group_name << ", running=" << group.num_running
+            << " admitted_mem=" << group.admitted_mem;
+
+    MonotonicStopWatch watch;
+    watch.start();
+    int64_t timeout_ms = config::admission_queue_timeout_ms;
+    Status status = Status::OK;
+    while (true) {
+        if (group.running_queries.count(query_id) > 0
+                || (group.queue.front() == ticket && has_room(group, mem_limit))) {
+            break;
+        }
+        if (is_cancelled()) {
+            status = Status::CANCELLED;
+            break;
+        }
+        int64_t waited_ms = watch.elapsed_time() / 1000000;
+        if (waited_ms >= timeout_ms) {
+            ++group.num_timed_out;
+            if (PaloMetrics::admission_timed_out_fragments() != NULL) {
+                PaloMetrics::admission_timed_out_fragments()->increment(1);
+            }
+            std::stringstream ss;
+            ss << "Fragment waited " << waited_ms << "ms in the queue of resource group "
+                << group_name << " for " << group.num_running << " running fragments with "
+                << PrettyPrinter::print(group.admitted_mem, TUnit::BYTES)
+                << " of memory limits";
+            status = Status(ss.str());
+            break;
+        }
+        BlockingAwareThreadPool::ScopedBlocking blocking(&l);
+        _cv.timed_wait(l, boost::posix_time::milliseconds(
+                std::min(timeout_ms - waited_ms, CANCEL_CHECK_INTERVAL_MS)));
+    }
+
+    group.queue.erase(std::find(group.queue.begin(), group.queue.end(), ticket));
+    if (PaloMetrics::admission_queued_fragments() != NULL) {
+        PaloMetrics::admission_queued_fragments()->increment(-1);
+        PaloMetrics::admission_queue_wait_ms()->increment(watch.elapsed_time() / 1000000);
+    }
+    if (status.ok()) {
+        admit_locked(&group, query_id, mem_limit);
+    }
+    // the next fragment in line may fit as well
+    _cv.notify_all();
+    return status;
+}
+
+void AdmissionController::release(
+        const std::string& group_name, const TUniqueId& query_id, int64_t mem_limit) {
+    mem_limit = std::max<int64_t>(mem_limit, 0);
+    {
+        boost::lock_guard<mutex> l(_lock);
+        Group& group = _groups[group_name];
+        DCHECK_GT(group.num_running, 0);
+        --group.num_running;
+        group.admitted_mem -= mem_limit;
+        auto it = group.running_queries.find(query_id);
+        DCHECK(it != group.running_queries.end());
+        if (--it->second == 0) {
+            group.running_queries.erase(it);
+        }
+    }
+    _cv.notify_all();
+}
+
+void AdmissionController::debug(std::stringstream& ss) {
+    boost::lock_guard<mutex> l(_lock);
+    ss << "group\trunning\tadmitted_mem\tqueued\tadmitted_total\tqueued_total"
+        << "\ttimed_out_total\n";
+    for (auto& it : _groups) {
+        const Group& group = it.second;
+        ss << it.first
+            << "\t" << group.num_running
+            << "\t" << PrettyPrinter::print(group.admitted_mem, TUnit::BYTES)
+            << "\t" << group.queue.size()
+            << "\t" << group.num_admitted
+            << "\t" << group.num_queued
+            << "\t" << group.num_timed_out
+            << "\n";
+    }
+}
+
+}
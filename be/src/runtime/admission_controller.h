@@ -0,0 +1,96 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_RUNTIME_ADMISSION_CONTROLLER_H
+#define BDG_PALO_BE_RUNTIME_ADMISSION_CONTROLLER_H
+
+#include <stdint.h>
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "common/status.h"
+#include "gen_cpp/Types_types.h"
+#include "util/hash_util.hpp"
+
+namespace palo {
+
+// Limits the fragments that run at the same time per resource group, so that a burst
+// of queries queues up instead of making all of them thrash.
+//
+// A group runs at most 'max_fragments' fragments and admits them as long as the sum of
+// their memory limits stays within 'mem_limit', 0 disables either budget. A fragment
+// that doesn't fit waits in the FIFO queue of its group, for at most
+// config::admission_queue_timeout_ms. The fragments of a query that has a fragment
+// running in the group already are admitted right away, they may exchange data with
+// it and queuing them could deadlock the query. A fragment is always admitted into an
+// empty group, even if its memory limit exceeds the budget.
+class AdmissionController {
+public:
+    AdmissionController(int max_fragments, int64_t mem_limit);
+
+    // Waits until the fragment of 'query_id' with a memory limit of 'mem_limit' may run
+    // in 'group'. Returns an error if the queue of the group is full, if the fragment
+    // waited too long or if 'is_cancelled' returned true meanwhile.
+    Status admit(const std::string& group, const TUniqueId& query_id, int64_t mem_limit,
+                 const std::function<bool()>& is_cancelled);
+
+    // Called for every admitted fragment when it is done.
+    void release(const std::string& group, const TUniqueId& query_id, int64_t mem_limit);
+
+    // Writes the running and queued fragments per group to 'ss'.
+    void debug(std::stringstream& ss);
+
+private:
+    struct Group {
+        int num_running;
+        int64_t admitted_mem;
+        // Number of running fragments per query.
+        std::unordered_map<TUniqueId, int> running_queries;
+        // Tickets of the waiting fragments.
+        std::deque<int64_t> queue;
+        int64_t num_admitted;
+        int64_t num_queued;
+        int64_t num_timed_out;
+
+        Group() : num_running(0), admitted_mem(0), num_admitted(0), num_queued(0),
+                num_timed_out(0) { }
+    };
+
+    // Returns true if 'group' has a slot and memory left for a fragment.
+    bool has_room(const Group& group, int64_t mem_limit) const;
+
+    void admit_locked(Group* group, const TUniqueId& query_id, int64_t mem_limit);
+
+    const int _max_fragments;
+    const int64_t _mem_limit;
+
+    boost::mutex _lock;
+    // Notified when a fragment is released or leaves a queue.
+    boost::condition_variable _cv;
+    std::map<std::string, Group> _groups;
+    int64_t _next_ticket;
+};
+
+}
+
+#endif // BDG_PALO_BE_RUNTIME_ADMISSION_CONTROLLER_H
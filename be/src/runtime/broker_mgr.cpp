@@ -92,6 +92,14 @@ void BrokerMgr::ping_worker() {
             }
         }
         for (auto& addr : addresses) {
+            // keeps connections open for the next burst of loads, idle ones that timed
+            // out are replaced
+            Status status = _exec_env->broker_client_cache()->warm_up(
+                addr, config::broker_client_cache_warm_up_num);
+            if (!status.ok()) {
+                LOG(WARNING) << "Warm up broker connections failed. broker=" << addr
+                    << ", status=" << status.get_error_msg();
+            }
             ping(addr);
         }
         sleep(5);
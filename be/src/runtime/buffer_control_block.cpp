@@ -19,7 +19,10 @@
 // under the License.
 
 #include "runtime/buffer_control_block.h"
+
+#include "common/config.h"
 #include "runtime/raw_value.h"
+#include "util/blocking_aware_thread_pool.h"
 #include "gen_cpp/PaloInternalService_types.h"
 
 namespace palo {
@@ -30,6 +33,8 @@ BufferControlBlock::BufferControlBlock(const TUniqueId& id, int buffer_size)
       _is_cancelled(false),
       _buffer_rows(0),
       _buffer_limit(buffer_size),
+      _buffer_bytes(0),
+      _buffer_bytes_limit(config::result_buffer_max_bytes),
       _packet_num(0) {
 }
 
@@ -37,8 +42,8 @@ BufferControlBlock::~BufferControlBlock() {
     cancel();
 
     for (ResultQueue::iterator iter = _batch_queue.begin(); _batch_queue.end() != iter; ++iter) {
-        delete *iter;
-        *iter = NULL;
+        delete iter->result;
+        iter->result = NULL;
     }
 }
 
@@ -46,17 +51,27 @@ Status BufferControlBlock::init() {
     return Status::OK;
 }
 
-Status BufferControlBlock::add_batch(TFetchDataResult* result) {
+Status BufferControlBlock::add_batch(
+        TFetchDataResult* result, RuntimeProfile::Counter* wait_timer) {
     boost::unique_lock<boost::mutex> l(_lock);
 
     if (_is_cancelled) {
         return Status::CANCELLED;
     }
 
-    int num_rows = result->result_batch.rows.size();
+    const std::vector<std::string>& rows = result->result_batch.rows;
+    int num_rows = rows.size();
+    int64_t num_bytes = 0;
+
+    for (int i = 0; i < num_rows; ++i) {
+        num_bytes += rows[i].size();
+    }
 
-    while ((!_batch_queue.empty() && (num_rows + _buffer_rows) > _buffer_limit)
-            && !_is_cancelled) {
+    while (!_batch_queue.empty() && !_is_cancelled
+            && (num_rows + _buffer_rows > _buffer_limit
+                || num_bytes + _buffer_bytes > _buffer_bytes_limit)) {
+        SCOPED_TIMER(wait_timer);
+        BlockingAwareThreadPool::ScopedBlocking blocking(&l);
         _data_removal.wait(l);
     }
 
@@ -65,7 +80,8 @@ Status BufferControlBlock::add_batch(TFetchDataResult* result) {
     }
 
     _buffer_rows += num_rows;
-    _batch_queue.push_back(result);
+    _buffer_bytes += num_bytes;
+    _batch_queue.push_back(QueuedBatch(result, num_bytes));
     _data_arriaval.notify_one();
     return Status::OK;
 }
@@ -100,13 +116,39 @@ Status BufferControlBlock::get_batch(TFetchDataResult* result) {
             }
         }
 
-        // get result
-        item = _batch_queue.front();
-        _batch_queue.pop_front();
+        // get result, together with the batches queued behind it that fit
+        item = _batch_queue.front().result;
+        int64_t packet_bytes = _batch_queue.front().bytes;
         _buffer_rows -= item->result_batch.rows.size();
+        _buffer_bytes -= packet_bytes;
+        _batch_queue.pop_front();
+
+        while (!_batch_queue.empty()
+                && packet_bytes + _batch_queue.front().bytes <= config::result_packet_max_bytes) {
+            TFetchDataResult* next = _batch_queue.front().result;
+            std::vector<std::string>& rows = item->result_batch.rows;
+            std::vector<std::string>& next_rows = next->result_batch.rows;
+            int num_rows = rows.size();
+
+            rows.resize(num_rows + next_rows.size());
+
+            for (int i = 0; i < next_rows.size(); ++i) {
+                rows[num_rows + i].swap(next_rows[i]);
+            }
+
+            packet_bytes += _batch_queue.front().bytes;
+            _buffer_rows -= next_rows.size();
+            _buffer_bytes -= _batch_queue.front().bytes;
+            _batch_queue.pop_front();
+            delete next;
+        }
+
         _data_removal.notify_one();
     }
-    *result = *item;
+    // hand the rows over without copying them
+    result->result_batch.rows.swap(item->result_batch.rows);
+    result->result_batch.is_compressed = item->result_batch.is_compressed;
+    result->result_batch.packet_seq = item->result_batch.packet_seq;
     result->__set_packet_num(_packet_num);
     _packet_num++;
     // destruct item new from Result writer
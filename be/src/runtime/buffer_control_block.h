@@ -21,24 +21,37 @@
 #ifndef BDG_PALO_BE_RUNTIME_BUFFER_CONTROL_BLOCK_H
 #define BDG_PALO_BE_RUNTIME_BUFFER_CONTROL_BLOCK_H
 
+#include <stdint.h>
+
 #include <list>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition_variable.hpp>
 #include "common/status.h"
 #include "gen_cpp/Types_types.h"
+#include "util/runtime_profile.h"
 
 namespace palo {
 
 class TFetchDataResult;
 
 // buffer used for result customer and productor
+//
+// The buffer holds at most 'buffer_size' rows and config::result_buffer_max_bytes
+// bytes of rows, add_batch() blocks the result sink beyond that until the FE fetched
+// enough. A single batch larger than that is still accepted if the buffer is empty.
+// get_batch() hands out all batches that queued up since the last fetch in one
+// response, up to config::result_packet_max_bytes, so that a FE that falls behind
+// catches up with fewer round trips, while one that keeps up gets every batch as soon
+// as it is ready. The rows are moved into the response without being copied.
 class BufferControlBlock {
 public:
     BufferControlBlock(const TUniqueId& id, int buffer_size);
     ~BufferControlBlock();
 
     Status init();
-    Status add_batch(TFetchDataResult* result);
+    // Takes ownership of 'result'. The time spent blocked on a full buffer is added to
+    // 'wait_timer' if it is not NULL.
+    Status add_batch(TFetchDataResult* result, RuntimeProfile::Counter* wait_timer = NULL);
     // get result from batch, use timeout?
     Status get_batch(TFetchDataResult* result);
     // close buffer block, set _status to exec_status and set _is_close to true;
@@ -52,7 +65,16 @@ public:
     }
 
 private:
-    typedef std::list<TFetchDataResult*> ResultQueue;
+    struct QueuedBatch {
+        QueuedBatch(TFetchDataResult* result_, int64_t bytes_) :
+                result(result_), bytes(bytes_) { }
+
+        TFetchDataResult* result;
+        // total size of the rows of 'result'
+        int64_t bytes;
+    };
+
+    typedef std::list<QueuedBatch> ResultQueue;
 
     // result's query id
     TUniqueId _fragment_id;
@@ -61,6 +83,8 @@ private:
     Status _status;
     int _buffer_rows;
     int _buffer_limit;
+    int64_t _buffer_bytes;
+    int64_t _buffer_bytes_limit;
     int _packet_num;
 
     // blocking queue for batch
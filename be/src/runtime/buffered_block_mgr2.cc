@@ -20,6 +20,9 @@
 
 #include "runtime/buffered_block_mgr2.h"
 
+#include <lz4/lz4.h>
+
+#include "common/config.h"
 #include "runtime/runtime_state.h"
 #include "runtime/mem_tracker.h"
 #include "runtime/mem_pool.h"
@@ -133,6 +136,8 @@ BufferedBlockMgr2::Block::Block(BufferedBlockMgr2* block_mgr) :
         _write_range(NULL),
         _tmp_file(NULL),
         _valid_data_len(0),
+        _compressed_buffer_len(0),
+        _is_compressed(false),
         _num_rows(0) {
 }
 
@@ -154,6 +159,7 @@ void BufferedBlockMgr2::Block::init() {
     _in_write = false;
     _is_deleted = false;
     _valid_data_len = 0;
+    _is_compressed = false;
     _client = NULL;
     _num_rows = 0;
 }
@@ -218,6 +224,7 @@ BufferedBlockMgr2::BufferedBlockMgr2(RuntimeState* state, TmpFileMgr* tmp_file_m
     _unfullfilled_reserved_buffers(0),
     _total_pinned_buffers(0),
     _non_local_outstanding_writes(0),
+    _scratch_bytes_allocated(0),
     _io_mgr(state->io_mgr()),
     _is_cancelled(false),
     _writes_issued(0) {
@@ -689,19 +696,40 @@ Status BufferedBlockMgr2::pin_block(Block* block, bool* pinned, Block* release_b
     vector<DiskIoMgr::ScanRange*> ranges(1, scan_range);
     RETURN_IF_ERROR(_io_mgr->add_scan_ranges(_io_request_context, ranges, true));
 
-    // Read from the io mgr buffer into the block's assigned buffer.
+    // Read from the io mgr buffer into the block's assigned buffer, or into a staging
+    // buffer if the block was compressed.
+    boost::scoped_array<uint8_t> compressed;
+    uint8_t* read_buffer = block->buffer();
+    if (block->_is_compressed) {
+        compressed.reset(new uint8_t[block->_write_range->len()]);
+        read_buffer = compressed.get();
+    }
     int64_t offset = 0;
     bool buffer_eosr = false;
     do {
         DiskIoMgr::BufferDescriptor* io_mgr_buffer;
         RETURN_IF_ERROR(scan_range->get_next(&io_mgr_buffer));
-        memcpy(block->buffer() + offset, io_mgr_buffer->buffer(), io_mgr_buffer->len());
+        memcpy(read_buffer + offset, io_mgr_buffer->buffer(), io_mgr_buffer->len());
         offset += io_mgr_buffer->len();
         buffer_eosr = io_mgr_buffer->eosr();
         io_mgr_buffer->return_buffer();
     } while (!buffer_eosr);
     DCHECK_EQ(offset, block->_write_range->len());
 
+    if (block->_is_compressed) {
+        SCOPED_TIMER(_compression_timer);
+        int decompressed_len = LZ4_decompress_safe(
+                reinterpret_cast<const char*>(compressed.get()),
+                reinterpret_cast<char*>(block->buffer()), offset, block->buffer_len());
+        if (decompressed_len != block->_valid_data_len) {
+            stringstream ss;
+            ss << "Failed to decompress spilled block of query " << print_id(_query_id)
+                << ": expected " << block->_valid_data_len << " bytes, got "
+                << decompressed_len;
+            return Status(ss.str());
+        }
+    }
+
     return delete_or_unpin_block(release_block, unpin);
 }
 
@@ -783,17 +811,30 @@ Status BufferedBlockMgr2::write_unpinned_block(Block* block) {
         block->_tmp_file = tmp_file;
     }
 
-    uint8_t* outbuf = NULL;
-    outbuf = block->buffer();
+    compress_block(block);
+    uint8_t* outbuf = block->buffer();
+    int64_t write_len = block->_valid_data_len;
+    if (block->_is_compressed) {
+        outbuf = block->_compressed_buffer.get();
+        write_len = block->_compressed_buffer_len;
+    }
 
-    block->_write_range->set_data(outbuf, block->_valid_data_len);
+    block->_write_range->set_data(outbuf, write_len);
 
     // Issue write through DiskIoMgr.
-    RETURN_IF_ERROR(_io_mgr->add_write_range(_io_request_context, block->_write_range));
+    Status status = _io_mgr->add_write_range(_io_request_context, block->_write_range);
+    if (!status.ok()) {
+        _mem_tracker->release(block->_compressed_buffer_len);
+        block->_compressed_buffer.reset();
+        block->_compressed_buffer_len = 0;
+        return status;
+    }
     block->_in_write = true;
+    _tmp_file_mgr->update_pending_write_bytes(block->_tmp_file->device_id(), write_len);
     DCHECK(block->validate()) << endl << block->debug_string();
     _outstanding_writes_counter->update(1);
     _bytes_written_counter->update(block->_valid_data_len);
+    _compressed_bytes_written_counter->update(write_len);
     ++_writes_issued;
     if (_writes_issued == 1) {
         if (PaloMetrics::num_queries_spilled() != NULL) {
@@ -803,19 +844,73 @@ Status BufferedBlockMgr2::write_unpinned_block(Block* block) {
     return Status::OK;
 }
 
+void BufferedBlockMgr2::compress_block(Block* block) {
+    // Assumes block manager lock is already taken.
+    DCHECK(block->_compressed_buffer == NULL);
+    block->_is_compressed = false;
+    if (!config::compress_spilled_blocks || block->_valid_data_len == 0) {
+        return;
+    }
+    SCOPED_TIMER(_compression_timer);
+    int64_t bound = LZ4_compressBound(block->_valid_data_len);
+    _mem_tracker->consume(bound);
+    block->_compressed_buffer.reset(new uint8_t[bound]);
+    block->_compressed_buffer_len = bound;
+    int compressed_len = LZ4_compress_default(
+            reinterpret_cast<const char*>(block->buffer()),
+            reinterpret_cast<char*>(block->_compressed_buffer.get()),
+            block->_valid_data_len, bound);
+    if (compressed_len <= 0 || compressed_len >= block->_valid_data_len) {
+        // Incompressible data is written as is.
+        _mem_tracker->release(bound);
+        block->_compressed_buffer.reset();
+        block->_compressed_buffer_len = 0;
+        return;
+    }
+    block->_is_compressed = true;
+    // Only this many bytes are written, but the whole buffer stays tracked until freed.
+    _mem_tracker->release(bound - compressed_len);
+    block->_compressed_buffer_len = compressed_len;
+}
+
 Status BufferedBlockMgr2::allocate_scratch_space(int64_t block_size,
         TmpFileMgr::File** tmp_file, int64_t* file_offset) {
     // Assumes block manager lock is already taken.
+    if (config::query_scratch_limit_bytes > 0
+            && _scratch_bytes_allocated + _max_block_size > config::query_scratch_limit_bytes) {
+        stringstream ss;
+        ss << "Query " << print_id(_query_id) << " exceeded the scratch space limit of "
+            << config::query_scratch_limit_bytes << " bytes";
+        return Status(ss.str());
+    }
     vector<Status> errs;
-    // Find the next physical file in round-robin order and create a write range for it.
+    vector<bool> tried(_tmp_files.size(), false);
     for (int attempt = 0; attempt < _tmp_files.size(); ++attempt) {
-        *tmp_file = &_tmp_files[_next_block_index];
-        _next_block_index = (_next_block_index + 1) % _tmp_files.size();
-        if ((*tmp_file)->is_blacklisted()) {
-            continue;
+        // Pick the file on the device with the fewest bytes waiting to be written,
+        // starting after the last used file so that equally loaded devices take turns.
+        int file_idx = -1;
+        int64_t min_pending_bytes = 0;
+        for (int i = 0; i < _tmp_files.size(); ++i) {
+            int idx = (_next_block_index + i) % _tmp_files.size();
+            if (tried[idx] || _tmp_files[idx].is_blacklisted()) {
+                continue;
+            }
+            int64_t pending_bytes =
+                _tmp_file_mgr->pending_write_bytes(_tmp_files[idx].device_id());
+            if (file_idx < 0 || pending_bytes < min_pending_bytes) {
+                file_idx = idx;
+                min_pending_bytes = pending_bytes;
+            }
         }
+        if (file_idx < 0) {
+            break;
+        }
+        tried[file_idx] = true;
+        _next_block_index = (file_idx + 1) % _tmp_files.size();
+        *tmp_file = &_tmp_files[file_idx];
         Status status = (*tmp_file)->allocate_space(_max_block_size, file_offset);
         if (status.ok()) {
+            _scratch_bytes_allocated += _max_block_size;
             return Status::OK;
         }
         // Log error and try other files if there was a problem. Problematic files will be
@@ -836,6 +931,13 @@ void BufferedBlockMgr2::write_complete(Block* block, const Status& write_status)
     Status status = Status::OK;
     lock_guard<mutex> lock(_lock);
     _outstanding_writes_counter->update(-1);
+    _tmp_file_mgr->update_pending_write_bytes(block->_tmp_file->device_id(),
+            -block->_write_range->len());
+    if (block->_compressed_buffer != NULL) {
+        _mem_tracker->release(block->_compressed_buffer_len);
+        block->_compressed_buffer.reset();
+        block->_compressed_buffer_len = 0;
+    }
     DCHECK(validate()) << endl << debug_internal();
     DCHECK(_is_cancelled || block->_in_write) << "write_complete() for block not in write."
             << endl << block->debug_string();
@@ -1276,6 +1378,9 @@ void BufferedBlockMgr2::init(
     _created_block_counter = ADD_COUNTER(_profile.get(), "BlocksCreated", TUnit::UNIT);
     _recycled_blocks_counter = ADD_COUNTER(_profile.get(), "BlocksRecycled", TUnit::UNIT);
     _bytes_written_counter = ADD_COUNTER(_profile.get(), "BytesWritten", TUnit::BYTES);
+    _compressed_bytes_written_counter =
+        ADD_COUNTER(_profile.get(), "CompressedBytesWritten", TUnit::BYTES);
+    _compression_timer = ADD_TIMER(_profile.get(), "TotalCompressionTime");
     _outstanding_writes_counter =
         ADD_COUNTER(_profile.get(), "BlockWritesOutstanding", TUnit::UNIT);
     _buffered_pin_counter = ADD_COUNTER(_profile.get(), "BufferedPins", TUnit::UNIT);
@@ -263,6 +263,14 @@ public:
         // Length of valid (i.e. allocated) data within the block.
         int64_t _valid_data_len;
 
+        // LZ4 compressed copy of the data that is written while _in_write, if
+        // config::compress_spilled_blocks is set. Freed when the write completes.
+        boost::scoped_array<uint8_t> _compressed_buffer;
+        int64_t _compressed_buffer_len;
+
+        // True if the data on disk is LZ4 compressed, its length is _write_range->len().
+        bool _is_compressed;
+
         // Number of rows in this block.
         int _num_rows;
 
@@ -486,11 +494,18 @@ private:
     // Issues the write for this block to the DiskIoMgr.
     Status write_unpinned_block(Block* block);
 
-    // Allocate block_size bytes in a temporary file. Try multiple disks if error occurs.
-    // Returns an error only if no temporary files are usable.
+    // Allocate block_size bytes in a temporary file. The file on the device with the
+    // fewest bytes waiting to be written is used, so that consecutive blocks are striped
+    // across the devices by their load. Try multiple disks if error occurs.
+    // Returns an error if no temporary files are usable or the query would exceed
+    // config::query_scratch_limit_bytes.
     Status allocate_scratch_space(int64_t block_size, TmpFileMgr::File** tmp_file,
             int64_t* file_offset);
 
+    // Compresses the data of 'block' into its _compressed_buffer if that makes it
+    // smaller. Sets _is_compressed accordingly.
+    void compress_block(Block* block);
+
     // Callback used by DiskIoMgr to indicate a block write has completed.  write_status
     // is the status of the write. _is_cancelled is set to true if write_status is not
     // Status::OK or a re-issue of the write fails. Returns the block's buffer to the
@@ -582,9 +597,12 @@ private:
     boost::ptr_vector<TmpFileMgr::File> _tmp_files;
 
     // Index into _tmp_files denoting the file to which the next block to be persisted will
-    // be written.
+    // be written if the devices are equally loaded.
     int _next_block_index;
 
+    // Bytes of scratch space allocated by this query.
+    int64_t _scratch_bytes_allocated;
+
     // DiskIoMgr handles to read and write blocks.
     DiskIoMgr* _io_mgr;
     DiskIoMgr::RequestContext* _io_request_context;
@@ -619,6 +637,13 @@ private:
     // Number of bytes written to disk (includes writes still queued in the IO manager).
     RuntimeProfile::Counter* _bytes_written_counter;
 
+    // Number of bytes that reached the disk after compression, equal to
+    // _bytes_written_counter if compression is off.
+    RuntimeProfile::Counter* _compressed_bytes_written_counter;
+
+    // Time spent compressing blocks before writes and decompressing them after reads.
+    RuntimeProfile::Counter* _compression_timer;
+
     // Number of writes outstanding (issued but not completed).
     RuntimeProfile::Counter* _outstanding_writes_counter;
 
@@ -0,0 +1,189 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#include "runtime/chunk_allocator.h"
+
+#include <stdlib.h>
+
+#include "common/config.h"
+#include "common/logging.h"
+#include "runtime/mem_tracker.h"
+#include "util/bit_util.h"
+
+namespace palo {
+
+const int64_t ChunkAllocator::MIN_CHUNK_SIZE;
+const int64_t ChunkAllocator::MAX_CHUNK_SIZE;
+const int ChunkAllocator::NUM_SIZE_CLASSES;
+
+struct ChunkAllocator::ThreadCache {
+    ThreadCache(ChunkAllocator* allocator) : allocator(allocator), bytes(0) { }
+
+    ~ThreadCache() {
+        allocator->release_thread_cache(this);
+    }
+
+    ChunkAllocator* allocator;
+    std::vector<uint8_t*> chunks[NUM_SIZE_CLASSES];
+    // bytes of 'chunks'
+    int64_t bytes;
+};
+
+ChunkAllocator* ChunkAllocator::instance() {
+    // never deleted, threads may return their chunks during exit
+    static ChunkAllocator* s_instance = new ChunkAllocator(
+            config::mem_pool_thread_cache_bytes, config::mem_pool_reserved_bytes);
+    return s_instance;
+}
+
+ChunkAllocator::ChunkAllocator(int64_t thread_cache_bytes, int64_t reserved_bytes) :
+        _thread_cache_bytes(thread_cache_bytes),
+        _reserved_bytes(reserved_bytes),
+        _mem_tracker(new MemTracker(-1, "ChunkAllocator")),
+        _shared_bytes(0),
+        _thread_hits(0),
+        _shared_hits(0),
+        _mallocs(0) {
+}
+
+ChunkAllocator::~ChunkAllocator() {
+    _thread_cache.reset();
+    int64_t bytes = 0;
+
+    for (int i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        for (int j = 0; j < _shared_chunks[i].size(); ++j) {
+            ::free(_shared_chunks[i][j]);
+        }
+        bytes += _shared_chunks[i].size() * (MIN_CHUNK_SIZE << i);
+    }
+
+    _mem_tracker->release(bytes);
+}
+
+int ChunkAllocator::size_class(int64_t size) {
+    if (size < MIN_CHUNK_SIZE || size > MAX_CHUNK_SIZE || (size & (size - 1)) != 0) {
+        return -1;
+    }
+
+    return BitUtil::log2(size) - BitUtil::log2(MIN_CHUNK_SIZE);
+}
+
+ChunkAllocator::ThreadCache* ChunkAllocator::thread_cache() {
+    ThreadCache* cache = _thread_cache.get();
+
+    if (cache == NULL) {
+        cache = new ThreadCache(this);
+        _thread_cache.reset(cache);
+    }
+
+    return cache;
+}
+
+uint8_t* ChunkAllocator::allocate(int64_t size) {
+    int idx = size_class(size);
+
+    if (idx >= 0 && !config::disable_mem_pools) {
+        ThreadCache* cache = thread_cache();
+
+        if (!cache->chunks[idx].empty()) {
+            uint8_t* data = cache->chunks[idx].back();
+            cache->chunks[idx].pop_back();
+            cache->bytes -= size;
+            _mem_tracker->release(size);
+            ++_thread_hits;
+            return data;
+        }
+
+        uint8_t* data = NULL;
+        {
+            std::lock_guard<std::mutex> l(_shared_locks[idx]);
+
+            if (!_shared_chunks[idx].empty()) {
+                data = _shared_chunks[idx].back();
+                _shared_chunks[idx].pop_back();
+            }
+        }
+
+        if (data != NULL) {
+            _shared_bytes -= size;
+            _mem_tracker->release(size);
+            ++_shared_hits;
+            return data;
+        }
+    }
+
+    ++_mallocs;
+    return reinterpret_cast<uint8_t*>(malloc(size));
+}
+
+void ChunkAllocator::free(uint8_t* data, int64_t size) {
+    int idx = size_class(size);
+
+    if (idx < 0 || config::disable_mem_pools) {
+        ::free(data);
+        return;
+    }
+
+    ThreadCache* cache = thread_cache();
+
+    if (cache->bytes + size <= _thread_cache_bytes) {
+        cache->chunks[idx].push_back(data);
+        cache->bytes += size;
+        _mem_tracker->consume(size);
+        return;
+    }
+
+    free_to_shared(data, idx);
+}
+
+void ChunkAllocator::free_to_shared(uint8_t* data, int size_class) {
+    int64_t size = MIN_CHUNK_SIZE << size_class;
+
+    if (_shared_bytes.fetch_add(size) + size > _reserved_bytes) {
+        _shared_bytes -= size;
+        ::free(data);
+        return;
+    }
+
+    _mem_tracker->consume(size);
+    std::lock_guard<std::mutex> l(_shared_locks[size_class]);
+    _shared_chunks[size_class].push_back(data);
+}
+
+void ChunkAllocator::release_thread_cache(ThreadCache* cache) {
+    for (int i = 0; i < NUM_SIZE_CLASSES; ++i) {
+        for (int j = 0; j < cache->chunks[i].size(); ++j) {
+            // counted again by free_to_shared()
+            _mem_tracker->release(MIN_CHUNK_SIZE << i);
+            free_to_shared(cache->chunks[i][j], i);
+        }
+        cache->chunks[i].clear();
+    }
+
+    cache->bytes = 0;
+}
+
+int64_t ChunkAllocator::reserved_bytes() const {
+    return _mem_tracker->consumption();
+}
+
+ChunkAllocator::Stats ChunkAllocator::stats() const {
+    Stats stats;
+    stats.thread_hits = _thread_hits;
+    stats.shared_hits = _shared_hits;
+    stats.mallocs = _mallocs;
+    return stats;
+}
+
+}
@@ -0,0 +1,116 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef BDG_PALO_BE_RUNTIME_CHUNK_ALLOCATOR_H
+#define BDG_PALO_BE_RUNTIME_CHUNK_ALLOCATOR_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/thread/tss.hpp>
+
+namespace palo {
+
+class MemTracker;
+
+// Recycles the memory chunks of MemPools, which RowBatches, scanners and expression
+// evaluation allocate and free at high rates in the same few sizes.
+//
+// Chunks whose size is a power of two from MIN_CHUNK_SIZE to MAX_CHUNK_SIZE are kept
+// in a free list per size. A chunk freed by a thread goes to the lists of that thread,
+// up to 'thread_cache_bytes' per thread, then to the lists shared by all threads, up to
+// 'reserved_bytes', and only then back to malloc. allocate() looks in the same order.
+// A thread returns its chunks to the shared lists when it exits.
+//
+// The chunks kept are counted against mem_tracker(), not against the MemTrackers of the
+// pools that used them. Thread safe.
+class ChunkAllocator {
+public:
+    static const int64_t MIN_CHUNK_SIZE = 4 * 1024;
+    static const int64_t MAX_CHUNK_SIZE = 512 * 1024;
+
+    // Number of times a chunk came from the lists of the allocating thread, from the
+    // shared lists and from malloc.
+    struct Stats {
+        Stats() : thread_hits(0), shared_hits(0), mallocs(0) { }
+
+        int64_t thread_hits;
+        int64_t shared_hits;
+        int64_t mallocs;
+    };
+
+    // Returns the allocator of the process, sized by config::mem_pool_thread_cache_bytes
+    // and config::mem_pool_reserved_bytes.
+    static ChunkAllocator* instance();
+
+    ChunkAllocator(int64_t thread_cache_bytes, int64_t reserved_bytes);
+
+    // Frees the chunks of the shared lists and of the calling thread.
+    ~ChunkAllocator();
+
+    // Returns a chunk of 'size' bytes, NULL if malloc fails.
+    uint8_t* allocate(int64_t size);
+
+    // Frees the chunk 'data' of 'size' bytes returned by allocate().
+    void free(uint8_t* data, int64_t size);
+
+    // Bytes of all chunks kept for reuse.
+    int64_t reserved_bytes() const;
+
+    Stats stats() const;
+
+    MemTracker* mem_tracker() {
+        return _mem_tracker.get();
+    }
+
+private:
+    struct ThreadCache;
+
+    // free lists for the sizes 4K, 8K, ..., 512K
+    static const int NUM_SIZE_CLASSES = 8;
+
+    // Returns the index of the free list of 'size', -1 if chunks of that size aren't kept.
+    static int size_class(int64_t size);
+
+    ThreadCache* thread_cache();
+
+    // Moves the chunks of 'cache' to the shared lists, freeing those that don't fit.
+    void release_thread_cache(ThreadCache* cache);
+
+    void free_to_shared(uint8_t* data, int size_class);
+
+    const int64_t _thread_cache_bytes;
+    const int64_t _reserved_bytes;
+
+    std::unique_ptr<MemTracker> _mem_tracker;
+    boost::thread_specific_ptr<ThreadCache> _thread_cache;
+
+    // Protects the shared free list of the same size class.
+    std::mutex _shared_locks[NUM_SIZE_CLASSES];
+    std::vector<uint8_t*> _shared_chunks[NUM_SIZE_CLASSES];
+    // bytes of the chunks in the shared lists
+    std::atomic<int64_t> _shared_bytes;
+
+    std::atomic<int64_t> _thread_hits;
+    std::atomic<int64_t> _shared_hits;
+    std::atomic<int64_t> _mallocs;
+};
+
+}
+
+#endif // BDG_PALO_BE_RUNTIME_CHUNK_ALLOCATOR_H
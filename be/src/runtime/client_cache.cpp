@@ -27,8 +27,14 @@
 #include <thrift/transport/TTransportUtils.h>
 #include <memory>
 
+#include <time.h>
+
+#include <algorithm>
+
 #include <boost/foreach.hpp>
+#include <boost/thread/thread_time.hpp>
 
+#include "common/config.h"
 #include "common/logging.h"
 #include "util/container_util.hpp"
 #include "util/network_util.h"
@@ -37,33 +43,109 @@
 
 namespace palo {
 
+// Milliseconds on the monotonic clock, for the idle time of clients.
+static int64_t monotonic_millis() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
 ClientCacheHelper::~ClientCacheHelper() {
     for (auto& it : _client_map) {
         delete it.second;
     }
 }
 
-Status ClientCacheHelper::get_client(
-        const TNetworkAddress& hostport,
-        client_factory factory_method, void** client_key, int timeout_ms) {
-    boost::lock_guard<boost::mutex> lock(_lock);
-    //VLOG_RPC << "get_client(" << hostport << ")";
+ClientCacheHelper::HostClients* ClientCacheHelper::get_host_clients(
+        const TNetworkAddress& hostport) {
     ClientCacheMap::iterator cache_entry = _client_cache.find(hostport);
+    if (cache_entry != _client_cache.end()) {
+        return &cache_entry->second;
+    }
+    HostClients* host = &_client_cache[hostport];
+    if (_metrics_enabled) {
+        std::stringstream ss;
+        ss << _metrics_key_prefix << ".client_cache." << hostport.hostname << ":"
+            << hostport.port;
+        host->clients_in_use_metric = _metrics->AddGauge(ss.str() + ".clients_in_use", 0L);
+        host->total_clients_metric = _metrics->AddGauge(ss.str() + ".total_clients", 0L);
+    }
+    return host;
+}
 
-    if (cache_entry == _client_cache.end()) {
-        cache_entry =
-            _client_cache.insert(std::make_pair(hostport, std::list<void*>())).first;
-        DCHECK(cache_entry != _client_cache.end());
+void* ClientCacheHelper::take_idle_client(HostClients* host) {
+    int64_t max_idle_ms = config::thrift_client_cache_idle_timeout_s * 1000L;
+    int64_t now = monotonic_millis();
+    while (!host->idle_clients.empty()) {
+        IdleClient idle = host->idle_clients.front();
+        host->idle_clients.pop_front();
+        if (max_idle_ms > 0 && now - idle.release_time_ms > max_idle_ms) {
+            destroy_client(host, idle.client_key);
+            continue;
+        }
+        if (!_client_map[idle.client_key]->is_alive()) {
+            ++host->num_broken;
+            destroy_client(host, idle.client_key);
+            continue;
+        }
+        return idle.client_key;
     }
+    return NULL;
+}
 
-    std::list<void*>& info_list = cache_entry->second;
+void ClientCacheHelper::destroy_client(HostClients* host, void* client_key) {
+    ClientMap::iterator i = _client_map.find(client_key);
+    DCHECK(i != _client_map.end());
+    i->second->close();
+    delete i->second;
+    _client_map.erase(i);
+    --host->num_clients;
+    if (_metrics_enabled) {
+        _total_clients_metric->increment(-1);
+        host->total_clients_metric->increment(-1);
+    }
+    if (host->num_waiters > 0) {
+        _client_released_cv.notify_all();
+    }
+}
 
-    if (!info_list.empty()) {
-        *client_key = info_list.front();
-        VLOG_RPC << "get_client(): cached client for " << hostport;
-        info_list.pop_front();
-    } else {
-        RETURN_IF_ERROR(create_client(hostport, factory_method, client_key, timeout_ms));
+Status ClientCacheHelper::get_client(
+        const TNetworkAddress& hostport,
+        client_factory factory_method, void** client_key, int timeout_ms) {
+    boost::unique_lock<boost::mutex> lock(_lock);
+    //VLOG_RPC << "get_client(" << hostport << ")";
+    HostClients* host = get_host_clients(hostport);
+    boost::system_time deadline = boost::get_system_time()
+        + boost::posix_time::seconds(config::thrift_connect_timeout_seconds);
+    bool waited = false;
+    while (true) {
+        *client_key = take_idle_client(host);
+        if (*client_key != NULL) {
+            VLOG_RPC << "get_client(): cached client for " << hostport;
+            break;
+        }
+        int max_clients = config::thrift_client_cache_max_per_host;
+        if (max_clients <= 0 || host->num_clients < max_clients) {
+            ++host->num_clients;
+            lock.unlock();
+            Status status = create_client(hostport, factory_method, client_key);
+            lock.lock();
+            RETURN_IF_ERROR(status);
+            break;
+        }
+        if (!waited) {
+            ++host->num_waits;
+            waited = true;
+        }
+        ++host->num_waiters;
+        bool notified = _client_released_cv.timed_wait(lock, deadline);
+        --host->num_waiters;
+        if (!notified && host->idle_clients.empty() && host->num_clients >= max_clients) {
+            std::stringstream msg;
+            msg << "Timed out waiting for one of the " << host->num_clients
+                << " connections to " << hostport;
+            return Status(TStatusCode::THRIFT_RPC_ERROR, msg.str(), false);
+        }
     }
 
     _client_map[*client_key]->set_send_timeout(timeout_ms);
@@ -71,39 +153,70 @@ Status ClientCacheHelper::get_client(
 
     if (_metrics_enabled) {
         _clients_in_use_metric->increment(1);
+        host->clients_in_use_metric->increment(1);
     }
 
     return Status::OK;
 }
 
+Status ClientCacheHelper::warm_up(const TNetworkAddress& hostport,
+                                  client_factory factory_method, int num_clients) {
+    int max_clients = config::thrift_client_cache_max_per_host;
+    if (max_clients > 0) {
+        num_clients = std::min(num_clients, max_clients);
+    }
+    while (true) {
+        {
+            boost::lock_guard<boost::mutex> lock(_lock);
+            HostClients* host = get_host_clients(hostport);
+            if (host->num_clients >= num_clients) {
+                return Status::OK;
+            }
+            ++host->num_clients;
+        }
+        void* client_key = NULL;
+        RETURN_IF_ERROR(create_client(hostport, factory_method, &client_key));
+        boost::lock_guard<boost::mutex> lock(_lock);
+        HostClients* host = get_host_clients(hostport);
+        IdleClient idle = { client_key, monotonic_millis() };
+        host->idle_clients.push_front(idle);
+        if (host->num_waiters > 0) {
+            _client_released_cv.notify_all();
+        }
+    }
+}
+
 Status ClientCacheHelper::reopen_client(client_factory factory_method, void** client_key,
                                        int timeout_ms) {
-    boost::lock_guard<boost::mutex> lock(_lock);
-    ClientMap::iterator i = _client_map.find(*client_key);
-    DCHECK(i != _client_map.end());
-    ThriftClientImpl* info = i->second;
-    const std::string ipaddress = info->ipaddress();
-    int port = info->port();
-
-    // We don't expect Close() to fail. Even if it fails, we should continue on to delete
-    // the transport and remove it from the map.
-    Status status = info->close();
-    DCHECK(status.ok());
-
-    // TODO: Thrift TBufferedTransport cannot be re-opened after Close() because it does
-    // not clean up internal buffers it reopens. To work around this issue, create a new
-    // client instead.
-    _client_map.erase(*client_key);
-    delete info;
-    *client_key = NULL;
+    TNetworkAddress hostport;
+    {
+        boost::lock_guard<boost::mutex> lock(_lock);
+        ClientMap::iterator i = _client_map.find(*client_key);
+        DCHECK(i != _client_map.end());
+        ThriftClientImpl* info = i->second;
+        hostport = make_network_address(info->ipaddress(), info->port());
+
+        // We don't expect Close() to fail. Even if it fails, we should continue on to
+        // delete the transport and remove it from the map.
+        Status status = info->close();
+        DCHECK(status.ok());
+
+        // TODO: Thrift TBufferedTransport cannot be re-opened after Close() because it
+        // does not clean up internal buffers it reopens. To work around this issue,
+        // create a new client instead. It takes over the slot of the old one.
+        _client_map.erase(i);
+        delete info;
+        *client_key = NULL;
 
-    if (_metrics_enabled) {
-        _total_clients_metric->increment(-1);
+        if (_metrics_enabled) {
+            _total_clients_metric->increment(-1);
+            _client_cache[hostport].total_clients_metric->increment(-1);
+        }
     }
 
-    RETURN_IF_ERROR(create_client(make_network_address(
-        ipaddress, port), factory_method, client_key, timeout_ms));
+    RETURN_IF_ERROR(create_client(hostport, factory_method, client_key));
 
+    boost::lock_guard<boost::mutex> lock(_lock);
     _client_map[*client_key]->set_send_timeout(timeout_ms);
     _client_map[*client_key]->set_recv_timeout(timeout_ms);
     return Status::OK;
@@ -111,7 +224,7 @@ Status ClientCacheHelper::reopen_client(client_factory factory_method, void** cl
 
 Status ClientCacheHelper::create_client(
         const TNetworkAddress& hostport,
-        client_factory factory_method, void** client_key, int timeout_ms) {
+        client_factory factory_method, void** client_key) {
     std::unique_ptr<ThriftClientImpl> client_impl(factory_method(hostport, client_key));
     //VLOG_CONNECTION << "create_client(): adding new client for "
     //                << client_impl->ipaddress() << ":" << client_impl->port();
@@ -120,16 +233,24 @@ Status ClientCacheHelper::create_client(
 
     Status status = client_impl->open();
 
+    boost::lock_guard<boost::mutex> lock(_lock);
+    HostClients* host = get_host_clients(hostport);
     if (!status.ok()) {
         *client_key = NULL;
+        --host->num_clients;
+        if (host->num_waiters > 0) {
+            _client_released_cv.notify_all();
+        }
         return status;
     }
 
     // Because the client starts life 'checked out', we don't add it to the cache map
     _client_map[*client_key] = client_impl.release();
+    ++host->num_created;
 
     if (_metrics_enabled) {
         _total_clients_metric->increment(1);
+        host->total_clients_metric->increment(1);
     }
 
     return Status::OK;
@@ -146,10 +267,25 @@ void ClientCacheHelper::release_client(void** client_key) {
     ClientCacheMap::iterator j =
         _client_cache.find(make_network_address(info->ipaddress(), info->port()));
     DCHECK(j != _client_cache.end());
-    j->second.push_back(*client_key);
+    HostClients* host = &j->second;
+    int64_t now = monotonic_millis();
+    IdleClient idle = { *client_key, now };
+    host->idle_clients.push_front(idle);
+
+    // the least recently released clients are at the back
+    int64_t max_idle_ms = config::thrift_client_cache_idle_timeout_s * 1000L;
+    while (max_idle_ms > 0 && now - host->idle_clients.back().release_time_ms > max_idle_ms) {
+        void* stale_key = host->idle_clients.back().client_key;
+        host->idle_clients.pop_back();
+        destroy_client(host, stale_key);
+    }
 
     if (_metrics_enabled) {
         _clients_in_use_metric->increment(-1);
+        host->clients_in_use_metric->increment(-1);
+    }
+    if (host->num_waiters > 0) {
+        _client_released_cv.notify_all();
     }
 
     *client_key = NULL;
@@ -163,16 +299,18 @@ void ClientCacheHelper::close_connections(const TNetworkAddress& hostport) {
         return;
     }
 
-    VLOG_RPC << "Invalidating all " << cache_entry->second.size() << " clients for: "
+    HostClients* host = &cache_entry->second;
+    VLOG_RPC << "Invalidating all " << host->idle_clients.size() << " clients for: "
              << hostport;
-    BOOST_FOREACH(void * client_key, cache_entry->second) {
-        ClientMap::iterator client_map_entry = _client_map.find(client_key);
-        DCHECK(client_map_entry != _client_map.end());
-        client_map_entry->second->close();
+    while (!host->idle_clients.empty()) {
+        void* client_key = host->idle_clients.front().client_key;
+        host->idle_clients.pop_front();
+        destroy_client(host, client_key);
     }
 }
 
 std::string ClientCacheHelper::debug_string() {
+    boost::lock_guard<boost::mutex> lock(_lock);
     std::stringstream out;
     out << "ClientCacheHelper(#hosts=" << _client_cache.size()
         << " [";
@@ -182,7 +320,10 @@ std::string ClientCacheHelper::debug_string() {
             out << " ";
         }
 
-        out << i->first << ":" << i->second.size();
+        const HostClients& host = i->second;
+        out << i->first << ":" << host.idle_clients.size() << "/" << host.num_clients
+            << "(created=" << host.num_created << " broken=" << host.num_broken
+            << " waits=" << host.num_waits << ")";
     }
 
     out << "])";
@@ -209,6 +350,9 @@ void ClientCacheHelper::init_metrics(MetricGroup* metrics, const std::string& ke
     // Not strictly needed if init_metrics is called before any cache
     // usage, but ensures that _metrics_enabled is published.
     boost::lock_guard<boost::mutex> lock(_lock);
+    DCHECK(_client_cache.empty());
+    _metrics = metrics;
+    _metrics_key_prefix = key_prefix;
     std::stringstream count_ss;
     count_ss << key_prefix << ".client_cache.clients_in_use";
     _clients_in_use_metric =
@@ -25,6 +25,7 @@
 #include <list>
 #include <string>
 #include <boost/unordered_map.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/bind.hpp>
 
@@ -48,7 +49,12 @@ namespace palo {
 //
 // This class is thread-safe.
 //
-// TODO: shut down clients in the background if they don't get used for a period of time
+// Idle clients are reused most recently released first. A client that was idle for
+// longer than config::thrift_client_cache_idle_timeout_s, or whose server closed the
+// connection meanwhile, is closed instead of being handed out. Connecting happens
+// outside of the lock. At most config::thrift_client_cache_max_per_host clients are
+// kept per host, get_client() waits for a released one beyond that.
+//
 // TODO: in order to reduce locking overhead when getting/releasing clients,
 // add call to hand back pointer to list stored in ClientCache and add separate lock
 // to list (or change to lock-free list)
@@ -56,7 +62,6 @@ namespace palo {
 // own lock.
 // TODO: More graceful handling of clients that have failed (maybe better
 // handled by a smart-wrapper of the interface object).
-// TODO: limits on total number of clients, and clients per-backend
 class ClientCacheHelper {
 public:
     ~ClientCacheHelper();
@@ -70,6 +75,11 @@ public:
     Status get_client(const TNetworkAddress& hostport,
                      client_factory factory_method, void** client_key, int timeout_ms);
 
+    // Opens idle clients to 'hostport' until it has 'num_clients' clients, so that a
+    // burst of calls doesn't start with connecting. Returns the first error.
+    Status warm_up(const TNetworkAddress& hostport, client_factory factory_method,
+                   int num_clients);
+
     // Close and delete the underlying transport and remove the client from _client_map.
     // Return a new client connecting to the same host/port.
     // Return an error status and set client_key to NULL if a new client cannot
@@ -92,16 +102,39 @@ public:
 private:
     template <class T> friend class ClientCache;
     // Private constructor so that only ClientCache can instantiate this class.
-    ClientCacheHelper() : _metrics_enabled(false) { }
+    ClientCacheHelper() : _metrics(NULL), _metrics_enabled(false) { }
+
+    struct IdleClient {
+        void* client_key;
+        int64_t release_time_ms;
+    };
+
+    struct HostClients {
+        // most recently released first
+        std::list<IdleClient> idle_clients;
+        // clients in use, idle or being opened
+        int num_clients;
+        int num_waiters;
+        int64_t num_created;
+        int64_t num_broken;
+        int64_t num_waits;
+        IntGauge* clients_in_use_metric;
+        IntGauge* total_clients_metric;
+
+        HostClients() : num_clients(0), num_waiters(0), num_created(0), num_broken(0),
+                num_waits(0), clients_in_use_metric(NULL), total_clients_metric(NULL) { }
+    };
 
     // Protects all member variables
     // TODO: have more fine-grained locks or use lock-free data structures,
     // this isn't going to scale for a high request rate
     boost::mutex _lock;
 
-    // map from (host, port) to list of client keys for that address
-    typedef boost::unordered_map <
-    TNetworkAddress, std::list<void*> > ClientCacheMap;
+    // Notified when a client is released or closed.
+    boost::condition_variable _client_released_cv;
+
+    // map from (host, port) to the clients for that address
+    typedef boost::unordered_map<TNetworkAddress, HostClients> ClientCacheMap;
     ClientCacheMap _client_cache;
 
     // Map from client key back to its associated ThriftClientImpl transport
@@ -109,6 +142,8 @@ private:
     ClientMap _client_map;
 
     // MetricGroup
+    MetricGroup* _metrics;
+    std::string _metrics_key_prefix;
     bool _metrics_enabled;
 
     // Number of clients 'checked-out' from the cache
@@ -117,9 +152,21 @@ private:
     // Total clients in the cache, including those in use
     IntGauge* _total_clients_metric;
 
-    // Create a new client for specific host/port in 'client' and put it in _client_map
+    // Returns the clients of 'hostport', adding them if it's new. Needs _lock.
+    HostClients* get_host_clients(const TNetworkAddress& hostport);
+
+    // Returns the most recently released idle client of 'host' that can still be used
+    // and closes those that can't. Returns NULL if there is none. Needs _lock.
+    void* take_idle_client(HostClients* host);
+
+    // Closes and deletes the client, which is not in use. Needs _lock.
+    void destroy_client(HostClients* host, void* client_key);
+
+    // Create a new client for specific host/port in 'client' and put it in _client_map.
+    // Must be called without _lock, after a slot of the host was taken by incrementing
+    // its num_clients. The slot is given back if the client can't be opened.
     Status create_client(const TNetworkAddress& hostport, client_factory factory_method,
-                        void** client_key, int timeout_ms);
+                        void** client_key);
 };
 
 template<class T>
@@ -206,6 +253,11 @@ public:
         return _client_cache_helper.close_connections(hostport);
     }
 
+    // Opens idle clients to 'hostport' until it has 'num_clients' clients.
+    Status warm_up(const TNetworkAddress& hostport, int num_clients) {
+        return _client_cache_helper.warm_up(hostport, _client_factory, num_clients);
+    }
+
     // Helper method which returns a debug string
     std::string debug_string() {
         return _client_cache_helper.debug_string();
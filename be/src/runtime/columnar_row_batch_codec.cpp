@@ -0,0 +1,309 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/columnar_row_batch_codec.h"
+
+#include <string.h>
+
+#include <boost/unordered_map.hpp>
+#include <lz4/lz4.h>
+
+#include "common/logging.h"
+#include "gen_cpp/Data_types.h"
+#include "runtime/descriptors.h"
+#include "runtime/mem_pool.h"
+#include "runtime/row_batch.h"
+#include "runtime/string_value.h"
+#include "runtime/tuple.h"
+#include "runtime/tuple_row.h"
+
+namespace palo {
+
+// Columns with less raw data than this are not worth compressing.
+static const int MIN_COMPRESS_SIZE = 64;
+
+template <typename T>
+static inline void append_value(std::string* output, T value) {
+    output->append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static inline T read_value(const std::string& data, size_t* pos) {
+    DCHECK_LE(*pos + sizeof(T), data.size());
+    T value;
+    memcpy(&value, data.data() + *pos, sizeof(T));
+    *pos += sizeof(T);
+    return value;
+}
+
+int ColumnarRowBatchCodec::encode(RowBatch* batch, TRowBatch* output_batch) {
+    const std::vector<TupleDescriptor*>& tuple_descs = batch->row_desc().tuple_descriptors();
+    int num_rows = batch->num_rows();
+    int num_tuples = tuple_descs.size();
+    output_batch->tuple_offsets.resize(num_rows * num_tuples);
+    output_batch->tuple_data.clear();
+
+    int raw_size = 0;
+    std::vector<Tuple*> tuples;
+    for (int j = 0; j < num_tuples; ++j) {
+        tuples.clear();
+        for (int i = 0; i < num_rows; ++i) {
+            Tuple* tuple = batch->get_row(i)->get_tuple(j);
+            // NULLs are encoded as -1
+            output_batch->tuple_offsets[i * num_tuples + j] =
+                (tuple == NULL) ? -1 : static_cast<int32_t>(tuples.size());
+            if (tuple != NULL) {
+                tuples.push_back(tuple);
+            }
+        }
+
+        const std::vector<SlotDescriptor*>& slots = tuple_descs[j]->slots();
+        for (int k = 0; k < slots.size(); ++k) {
+            if (!slots[k]->is_materialized()) {
+                continue;
+            }
+            raw_size += encode_column(*slots[k], tuples, &output_batch->tuple_data);
+        }
+    }
+
+    output_batch->__set_is_columnar(true);
+    return raw_size;
+}
+
+int ColumnarRowBatchCodec::encode_column(const SlotDescriptor& slot_desc,
+        const std::vector<Tuple*>& tuples, std::string* output) {
+    int num_tuples = tuples.size();
+    const NullIndicatorOffset& null_offset = slot_desc.null_indicator_offset();
+
+    std::string null_bitmap;
+    if (slot_desc.is_nullable()) {
+        null_bitmap.assign((num_tuples + 7) / 8, '\0');
+        for (int i = 0; i < num_tuples; ++i) {
+            if (tuples[i]->is_null(null_offset)) {
+                null_bitmap[i / 8] |= (1 << (i % 8));
+            }
+        }
+    }
+    append_value<uint32_t>(output, null_bitmap.size());
+    output->append(null_bitmap);
+
+    uint8_t encoding = PLAIN;
+    std::string raw;
+    if (slot_desc.type().is_string_type()) {
+        // Build a dictionary until there are too many distinct strings for it to pay off.
+        boost::unordered_map<StringValue, int32_t> dict;
+        std::vector<StringValue> dict_values;
+        std::vector<int32_t> codes(num_tuples, 0);
+        bool use_dict = num_tuples > 1;
+        for (int i = 0; use_dict && i < num_tuples; ++i) {
+            if (tuples[i]->is_null(null_offset)) {
+                continue;
+            }
+            const StringValue* value = tuples[i]->get_string_slot(slot_desc.tuple_offset());
+            boost::unordered_map<StringValue, int32_t>::iterator it = dict.find(*value);
+            if (it == dict.end()) {
+                it = dict.insert(std::make_pair(*value, dict_values.size())).first;
+                dict_values.push_back(*value);
+                use_dict = dict_values.size() * 2 <= num_tuples;
+            }
+            codes[i] = it->second;
+        }
+
+        if (use_dict) {
+            encoding = DICTIONARY;
+            append_value<int32_t>(&raw, dict_values.size());
+            for (int i = 0; i < dict_values.size(); ++i) {
+                append_value<int32_t>(&raw, dict_values[i].len);
+            }
+            for (int i = 0; i < dict_values.size(); ++i) {
+                raw.append(dict_values[i].ptr, dict_values[i].len);
+            }
+            raw.append(reinterpret_cast<const char*>(&codes[0]), num_tuples * sizeof(int32_t));
+        } else {
+            for (int i = 0; i < num_tuples; ++i) {
+                int32_t len = tuples[i]->is_null(null_offset) ? 0
+                    : tuples[i]->get_string_slot(slot_desc.tuple_offset())->len;
+                append_value<int32_t>(&raw, len);
+            }
+            for (int i = 0; i < num_tuples; ++i) {
+                if (tuples[i]->is_null(null_offset)) {
+                    continue;
+                }
+                const StringValue* value =
+                    tuples[i]->get_string_slot(slot_desc.tuple_offset());
+                raw.append(value->ptr, value->len);
+            }
+        }
+    } else {
+        int slot_size = slot_desc.type().get_slot_size();
+        raw.assign(num_tuples * slot_size, '\0');
+        for (int i = 0; i < num_tuples; ++i) {
+            if (!tuples[i]->is_null(null_offset)) {
+                memcpy(&raw[i * slot_size], tuples[i]->get_slot(slot_desc.tuple_offset()),
+                       slot_size);
+            }
+        }
+    }
+
+    uint8_t compression = NO_COMPRESSION;
+    std::string compressed;
+    if (raw.size() >= MIN_COMPRESS_SIZE) {
+        compressed.resize(LZ4_compressBound(raw.size()));
+        int compressed_size = LZ4_compress_default(raw.data(), &compressed[0],
+                                                   raw.size(), compressed.size());
+        if (compressed_size > 0 && compressed_size < raw.size()) {
+            compressed.resize(compressed_size);
+            compression = LZ4;
+        }
+    }
+    const std::string& stored = (compression == LZ4) ? compressed : raw;
+
+    append_value<uint8_t>(output, encoding);
+    append_value<uint8_t>(output, compression);
+    append_value<uint32_t>(output, raw.size());
+    append_value<uint32_t>(output, stored.size());
+    output->append(stored);
+    return null_bitmap.size() + raw.size();
+}
+
+void ColumnarRowBatchCodec::decode(const RowDescriptor& row_desc,
+        const TRowBatch& input_batch, MemPool* pool, Tuple** tuple_ptrs) {
+    const std::vector<TupleDescriptor*>& tuple_descs = row_desc.tuple_descriptors();
+    int num_rows = input_batch.num_rows;
+    int num_tuples = tuple_descs.size();
+    DCHECK_EQ(input_batch.tuple_offsets.size(), num_rows * num_tuples);
+
+    size_t pos = 0;
+    for (int j = 0; j < num_tuples; ++j) {
+        int num_non_null = 0;
+        for (int i = 0; i < num_rows; ++i) {
+            if (input_batch.tuple_offsets[i * num_tuples + j] != -1) {
+                ++num_non_null;
+            }
+        }
+
+        int tuple_size = tuple_descs[j]->byte_size();
+        uint8_t* tuple_mem = pool->allocate(num_non_null * tuple_size);
+        memset(tuple_mem, 0, num_non_null * tuple_size);
+        for (int i = 0; i < num_rows; ++i) {
+            int32_t offset = input_batch.tuple_offsets[i * num_tuples + j];
+            tuple_ptrs[i * num_tuples + j] = (offset == -1) ? NULL
+                : reinterpret_cast<Tuple*>(tuple_mem + offset * tuple_size);
+        }
+
+        const std::vector<SlotDescriptor*>& slots = tuple_descs[j]->slots();
+        for (int k = 0; k < slots.size(); ++k) {
+            if (!slots[k]->is_materialized()) {
+                continue;
+            }
+            decode_column(*slots[k], tuple_mem, tuple_size, num_non_null,
+                          input_batch.tuple_data, &pos, pool);
+        }
+    }
+    DCHECK_EQ(pos, input_batch.tuple_data.size());
+}
+
+void ColumnarRowBatchCodec::decode_column(const SlotDescriptor& slot_desc,
+        uint8_t* tuple_mem, int tuple_size, int num_tuples, const std::string& data,
+        size_t* pos, MemPool* pool) {
+    const NullIndicatorOffset& null_offset = slot_desc.null_indicator_offset();
+    uint32_t null_bitmap_len = read_value<uint32_t>(data, pos);
+    const uint8_t* null_bitmap = reinterpret_cast<const uint8_t*>(data.data() + *pos);
+    *pos += null_bitmap_len;
+
+    uint8_t encoding = read_value<uint8_t>(data, pos);
+    uint8_t compression = read_value<uint8_t>(data, pos);
+    uint32_t raw_len = read_value<uint32_t>(data, pos);
+    uint32_t stored_len = read_value<uint32_t>(data, pos);
+    DCHECK_LE(*pos + stored_len, data.size());
+    const char* stored = data.data() + *pos;
+    *pos += stored_len;
+
+    // The characters of strings must outlive the input batch, so their column is copied
+    // into the pool. Fixed length values are copied into the tuples below.
+    bool is_string = slot_desc.type().is_string_type();
+    std::string scratch;
+    const char* raw = stored;
+    if (compression == LZ4) {
+        char* buffer = NULL;
+        if (is_string) {
+            buffer = reinterpret_cast<char*>(pool->allocate(raw_len));
+        } else {
+            scratch.resize(raw_len);
+            buffer = &scratch[0];
+        }
+        int decompressed = LZ4_decompress_safe(stored, buffer, stored_len, raw_len);
+        DCHECK_EQ(decompressed, raw_len) << "LZ4_decompress_safe failed";
+        raw = buffer;
+    } else if (is_string) {
+        char* buffer = reinterpret_cast<char*>(pool->allocate(raw_len));
+        memcpy(buffer, stored, raw_len);
+        raw = buffer;
+    }
+
+    for (int i = 0; i < num_tuples; ++i) {
+        if (null_bitmap_len > 0 && (null_bitmap[i / 8] & (1 << (i % 8)))) {
+            reinterpret_cast<Tuple*>(tuple_mem + i * tuple_size)->set_null(null_offset);
+        }
+    }
+
+    if (!is_string) {
+        int slot_size = slot_desc.type().get_slot_size();
+        DCHECK_EQ(raw_len, num_tuples * slot_size);
+        for (int i = 0; i < num_tuples; ++i) {
+            memcpy(tuple_mem + i * tuple_size + slot_desc.tuple_offset(), raw + i * slot_size,
+                   slot_size);
+        }
+        return;
+    }
+
+    if (encoding == DICTIONARY) {
+        int32_t dict_size = 0;
+        memcpy(&dict_size, raw, sizeof(int32_t));
+        const char* lens = raw + sizeof(int32_t);
+        const char* chars = lens + dict_size * sizeof(int32_t);
+        std::vector<StringValue> dict_values(dict_size);
+        for (int i = 0; i < dict_size; ++i) {
+            int32_t len = 0;
+            memcpy(&len, lens + i * sizeof(int32_t), sizeof(int32_t));
+            dict_values[i] = StringValue(const_cast<char*>(chars), len);
+            chars += len;
+        }
+        const char* codes = chars;
+        for (int i = 0; i < num_tuples; ++i) {
+            Tuple* tuple = reinterpret_cast<Tuple*>(tuple_mem + i * tuple_size);
+            if (tuple->is_null(null_offset)) {
+                continue;
+            }
+            int32_t code = 0;
+            memcpy(&code, codes + i * sizeof(int32_t), sizeof(int32_t));
+            DCHECK_LT(code, dict_size);
+            *tuple->get_string_slot(slot_desc.tuple_offset()) = dict_values[code];
+        }
+    } else {
+        DCHECK_EQ(encoding, PLAIN);
+        const char* chars = raw + num_tuples * sizeof(int32_t);
+        for (int i = 0; i < num_tuples; ++i) {
+            int32_t len = 0;
+            memcpy(&len, raw + i * sizeof(int32_t), sizeof(int32_t));
+            Tuple* tuple = reinterpret_cast<Tuple*>(tuple_mem + i * tuple_size);
+            *tuple->get_string_slot(slot_desc.tuple_offset()) =
+                StringValue(const_cast<char*>(chars), len);
+            chars += len;
+        }
+    }
+}
+
+} // namespace palo
@@ -0,0 +1,85 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_RUNTIME_COLUMNAR_ROW_BATCH_CODEC_H
+#define BDG_PALO_BE_RUNTIME_COLUMNAR_ROW_BATCH_CODEC_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace palo {
+
+class MemPool;
+class RowBatch;
+class RowDescriptor;
+class SlotDescriptor;
+class TRowBatch;
+class Tuple;
+
+// Encodes the tuples of a row batch column by column for TRowBatch.tuple_data, which
+// compresses much better than whole tuples since the values of a column are stored
+// next to each other.
+//
+// For every tuple id of the row, in row order, and every materialized slot of it, a
+// column holds the values of all non-NULL tuples of that tuple id:
+//   uint32 null bitmap length, null bitmap (one bit per tuple, set if the slot is NULL)
+//   uint8 encoding, uint8 compression, uint32 raw length, uint32 stored length, data
+// The raw data of a fixed length slot is the array of its values. The one of a string
+// slot is either the array of all lengths followed by all characters (PLAIN), or a
+// dictionary of the distinct strings followed by a code per value (DICTIONARY), which
+// is used if there are at most half as many distinct strings as values. The raw data
+// is LZ4 compressed if that makes it smaller.
+// Both sides of an exchange must run the same architecture, values are stored in
+// machine byte order just like in row oriented batches.
+class ColumnarRowBatchCodec {
+public:
+    // Sets the tuple_data, tuple_offsets and is_columnar fields of 'output_batch' for
+    // 'batch'. Returns the number of bytes of tuple_data before compression.
+    static int encode(RowBatch* batch, TRowBatch* output_batch);
+
+    // Creates the tuples of 'input_batch' in 'pool' and sets the tuple pointers of its
+    // rows in 'tuple_ptrs', which must have room for num_rows * row_tuples entries.
+    static void decode(const RowDescriptor& row_desc, const TRowBatch& input_batch,
+                       MemPool* pool, Tuple** tuple_ptrs);
+
+private:
+    enum Encoding {
+        PLAIN = 0,
+        DICTIONARY = 1
+    };
+
+    enum Compression {
+        NO_COMPRESSION = 0,
+        LZ4 = 1
+    };
+
+    // Appends the column of 'slot_desc' over 'tuples' to 'output'. Returns its size
+    // before compression.
+    static int encode_column(const SlotDescriptor& slot_desc,
+                             const std::vector<Tuple*>& tuples, std::string* output);
+
+    // Reads the column of 'slot_desc' for the 'num_tuples' tuples of 'tuple_size' bytes
+    // each at 'tuple_mem' from 'data' at '*pos' and advances '*pos' past it. String
+    // data is copied into 'pool'.
+    static void decode_column(const SlotDescriptor& slot_desc, uint8_t* tuple_mem,
+                              int tuple_size, int num_tuples, const std::string& data,
+                              size_t* pos, MemPool* pool);
+};
+
+} // namespace palo
+
+#endif // BDG_PALO_BE_RUNTIME_COLUMNAR_ROW_BATCH_CODEC_H
@@ -15,11 +15,15 @@
 
 #include "runtime/data_spliter.h"
 
+#include <algorithm>
 #include <sstream>
 
 #include <thrift/protocol/TDebugProtocol.h>
 
 #include "exprs/expr.h"
+#include "exprs/expr_column.h"
+#include "exprs/expr_context.h"
+#include "common/config.h"
 #include "common/object_pool.h"
 #include "runtime/runtime_state.h"
 #include "runtime/raw_value.h"
@@ -41,6 +45,10 @@ DataSpliter::DataSpliter(const RowDescriptor& row_desc) :
 }
 
 DataSpliter::~DataSpliter() {
+    stop_feeding();
+    for (auto& iter : _batch_map) {
+        delete iter.second;
+    }
 }
 
 // We use the ParttitionRange to compare here. It should not be a member function of PartitionInfo
@@ -120,6 +128,69 @@ Status DataSpliter::open(RuntimeState* state) {
     _split_timer = ADD_TIMER(_profile, "process batch");
     _finish_timer = ADD_TIMER(_profile, "sort time");
 
+    int num_threads = std::min<int>(config::data_spliter_threads, _dpp_sink_vec.size());
+    if (num_threads > 1) {
+        for (int i = 0; i < num_threads; ++i) {
+            _feed_queues.emplace_back(new BlockingQueue<SplitBatch>(
+                    std::max(config::data_spliter_queue_batches, 1)));
+        }
+        for (int i = 0; i < num_threads; ++i) {
+            _feed_threads.emplace_back(
+                    &DataSpliter::feed_loop, this, state, _feed_queues[i].get());
+        }
+    }
+
+    return Status::OK;
+}
+
+void DataSpliter::feed_loop(RuntimeState* state, BlockingQueue<SplitBatch>* queue) {
+    SplitBatch split_batch;
+    while (queue->blocking_get(&split_batch)) {
+        std::unique_ptr<RowBatch> batch(split_batch.batch);
+        // after an error the batches are only dropped, so that the sender doesn't block
+        if (!feed_status().ok()) {
+            continue;
+        }
+        Status status = split_batch.dpp_sink->add_batch(
+                _obj_pool.get(), state, split_batch.desc, batch.get());
+        if (!status.ok()) {
+            std::lock_guard<std::mutex> l(_feed_lock);
+            if (_feed_status.ok()) {
+                _feed_status = status;
+            }
+        }
+    }
+}
+
+Status DataSpliter::feed_status() {
+    std::lock_guard<std::mutex> l(_feed_lock);
+    return _feed_status;
+}
+
+void DataSpliter::stop_feeding() {
+    for (auto& queue : _feed_queues) {
+        queue->shutdown();
+    }
+    for (auto& thread : _feed_threads) {
+        thread.join();
+    }
+    _feed_threads.clear();
+    _feed_queues.clear();
+}
+
+Status DataSpliter::add_batch(
+        RuntimeState* state, const TabletDesc& desc, int32_t part_index, RowBatch* batch) {
+    DppSink* dpp_sink = _dpp_sink_vec[part_index];
+    if (_feed_queues.empty()) {
+        std::unique_ptr<RowBatch> batch_ptr(batch);
+        return dpp_sink->add_batch(_obj_pool.get(), state, desc, batch);
+    }
+    RETURN_IF_ERROR(feed_status());
+    SplitBatch split_batch = { desc, dpp_sink, batch };
+    if (!_feed_queues[part_index % _feed_queues.size()]->blocking_put(split_batch)) {
+        delete batch;
+        return Status("data spliter is closed");
+    }
     return Status::OK;
 }
 
@@ -143,35 +214,37 @@ int DataSpliter::binary_find_partition(const PartRangeKey& key) const {
     return -1;
 }
 
-Status DataSpliter::process_partition(
-        RuntimeState* state, TupleRow* row, PartitionInfo** info, int32_t* part_index) {
-    if (_partition_expr_ctxs.size() == 0) {
-        *part_index = 0;
-        *info = _partition_infos[0];
-        return Status::OK;
-    } else {
-        // use binary search to get the right partition.
-        ExprContext* ctx = _partition_expr_ctxs[0];
-        void* partition_val = ctx->get_value(row);
+void DataSpliter::find_partitions(RowBatch* batch, int32_t* part_indexes) {
+    int num_rows = batch->num_rows();
+    if (_partition_expr_ctxs.empty()) {
+        std::fill(part_indexes, part_indexes + num_rows, 0);
+        return;
+    }
+    ExprContext* ctx = _partition_expr_ctxs[0];
+    ExprColumn column;
+    ctx->evaluate_batch(batch, NULL, num_rows, &column);
+    PrimitiveType type = ctx->root()->type().type;
+    int32_t last_index = -1;
+    for (int i = 0; i < num_rows; ++i) {
         // construct a PartRangeKey
-        PartRangeKey tmpPartKey;
-        if (NULL != partition_val) {
-            RETURN_IF_ERROR(PartRangeKey::from_value(
-                ctx->root()->type().type, partition_val, &tmpPartKey));
+        PartRangeKey key;
+        void* partition_val = column.get_value(i);
+        if (partition_val != NULL) {
+            PartRangeKey::from_value(type, partition_val, &key);
         } else {
-            tmpPartKey = PartRangeKey::neg_infinite();
+            key = PartRangeKey::neg_infinite();
         }
-
-        *part_index = binary_find_partition(tmpPartKey);
-        if (*part_index < 0) {
-            std::stringstream error_log;
-            error_log << "there is no corresponding partition for this key: ";
-            ctx->print_value(row, &error_log);
-            return Status(error_log.str(), true);
+        // The rows of a load usually come clustered by the partition column, so try the
+        // partition of the previous row before the binary search.
+        if (last_index >= 0 && _partition_infos[last_index]->range().compare_key(key) == 0) {
+            part_indexes[i] = last_index;
+            continue;
+        }
+        part_indexes[i] = binary_find_partition(key);
+        if (part_indexes[i] >= 0) {
+            last_index = part_indexes[i];
         }
-        *info = _partition_infos[*part_index];
     }
-    return Status::OK;
 }
 
 Status DataSpliter::process_distribute(
@@ -197,12 +270,13 @@ Status DataSpliter::process_distribute(
 }
 
 Status DataSpliter::send_row(
-        RuntimeState* state, const TabletDesc& desc, TupleRow* row, DppSink* dpp_sink) {
+        RuntimeState* state, const TabletDesc& desc, TupleRow* row, int32_t part_index) {
     RowBatch* batch = nullptr;
     auto batch_iter = _batch_map.find(desc);
     if (batch_iter == _batch_map.end()) {
-        batch = _obj_pool->add(new RowBatch(_row_desc, state->batch_size(), _expr_mem_tracker.get()));
+        batch = new RowBatch(_row_desc, state->batch_size(), _expr_mem_tracker.get());
         _batch_map[desc] = batch;
+        _part_index_map[desc] = part_index;
     } else {
         batch = batch_iter->second;
     }
@@ -214,44 +288,36 @@ Status DataSpliter::send_row(
                    batch->tuple_data_pool(), false);
     batch->commit_last_row();
 
-    // If this batch is full send this to dpp_sink
+    // If this batch is full send this to dpp_sink, a new batch is filled meanwhile
     if (batch->is_full()) {
-        RETURN_IF_ERROR(dpp_sink->add_batch(_obj_pool.get(), state, desc, batch));
-        batch->reset();
+        _batch_map[desc] = new RowBatch(_row_desc, state->batch_size(), _expr_mem_tracker.get());
+        RETURN_IF_ERROR(add_batch(state, desc, part_index, batch));
     }
     return Status::OK;
 }
 
-Status DataSpliter::process_one_row(RuntimeState* state, TupleRow* row) {
-    TabletDesc desc;
-    int32_t part_index = 0;
-
-    // process partition
-    PartitionInfo* part = nullptr;
-    Status status = process_partition(state, row, &part, &part_index);
-    // TODO(lingbin): adjust 'process_partition' function's return value. It is a little inelegant
-    // to return another OK when pri-status is not OK.
+Status DataSpliter::process_one_row(RuntimeState* state, TupleRow* row, int32_t part_index) {
     // If find no partition, this row should be omitted.
-    if (!status.ok()) {
+    if (part_index < 0) {
+        std::stringstream error_log;
+        error_log << "there is no corresponding partition for this key: ";
+        _partition_expr_ctxs[0]->print_value(row, &error_log);
+
         state->set_error_row_number(state->get_error_row_number() + 1);
         state->set_normal_row_number(state->get_normal_row_number() - 1);
 
-        state->append_error_msg_to_file(
-                print_row(row, _row_desc),
-                status.get_error_msg());
+        state->append_error_msg_to_file(print_row(row, _row_desc), error_log.str());
         return Status::OK;
     }
 
+    TabletDesc desc;
+    PartitionInfo* part = _partition_infos[part_index];
     desc.partition_id = part->id();
 
     // process distribute
     RETURN_IF_ERROR(process_distribute(state, row, part, &desc.bucket_id));
 
-    // construct dpp_sink map
-    _sink_map[desc] = _dpp_sink_vec[part_index];
-
-    // process distribute
-    RETURN_IF_ERROR(send_row(state, desc, row, _dpp_sink_vec[part_index]));
+    RETURN_IF_ERROR(send_row(state, desc, row, part_index));
 
     return Status::OK;
 }
@@ -259,8 +325,10 @@ Status DataSpliter::process_one_row(RuntimeState* state, TupleRow* row) {
 Status DataSpliter::send(RuntimeState* state, RowBatch* batch) {
     SCOPED_TIMER(_split_timer);
     int num_rows = batch->num_rows();
+    _part_indexes.resize(num_rows);
+    find_partitions(batch, _part_indexes.data());
     for (int i = 0; i < num_rows; ++i) {
-        RETURN_IF_ERROR(process_one_row(state, batch->get_row(i)));
+        RETURN_IF_ERROR(process_one_row(state, batch->get_row(i), _part_indexes[i]));
     }
     return Status::OK;
 }
@@ -274,24 +342,36 @@ Status DataSpliter::close(RuntimeState* state, Status close_status) {
     if (close_status.ok()) {
         SCOPED_TIMER(_finish_timer);
         // Flush data have not been sent
-        for (const auto& iter : _batch_map) {
-            if (iter.second->num_rows() > 0) {
-                DppSink* dpp_sink = _sink_map[iter.first];
-                Status status = dpp_sink->add_batch(_obj_pool.get(), state, iter.first, iter.second);
-                if (UNLIKELY(is_ok && !status.ok())) {
-                    LOG(WARNING) << "add_batch error"
-                                << " err_msg=" << status.get_error_msg();
-                    is_ok = false;
-                    err_status = status;
-                }
-                iter.second->clear();
+        for (auto& iter : _batch_map) {
+            RowBatch* batch = iter.second;
+            iter.second = nullptr;
+            if (batch->num_rows() == 0) {
+                delete batch;
+                continue;
+            }
+            Status status = add_batch(state, iter.first, _part_index_map[iter.first], batch);
+            if (UNLIKELY(is_ok && !status.ok())) {
+                LOG(WARNING) << "add_batch error"
+                            << " err_msg=" << status.get_error_msg();
+                is_ok = false;
+                err_status = status;
             }
         }
     } else {
-        for (const auto& iter : _batch_map) {
-            iter.second->clear();
+        for (auto& iter : _batch_map) {
+            delete iter.second;
         }
     }
+    _batch_map.clear();
+    // the sinks are finished after the feeding threads added all the batches
+    stop_feeding();
+    Status feed_error = feed_status();
+    if (UNLIKELY(is_ok && !feed_error.ok())) {
+        LOG(WARNING) << "add_batch error"
+                    << " err_msg=" << feed_error.get_error_msg();
+        is_ok = false;
+        err_status = feed_error;
+    }
     // finish sink
     for (const auto& iter : _dpp_sink_vec) {
         Status status = iter->finish(state);
@@ -16,6 +16,9 @@
 #ifndef BDG_PALO_BE_RUNTIME_DATA_SPLITER_H
 #define BDG_PALO_BE_RUNTIME_DATA_SPLITER_H
 
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 #include <string>
 #include <vector>
@@ -23,6 +26,7 @@
 #include "common/status.h"
 #include "exec/data_sink.h"
 #include "runtime/dpp_sink_internal.h"
+#include "util/blocking_queue.hpp"
 #include "util/runtime_profile.h"
 
 namespace palo {
@@ -44,6 +48,11 @@ class MemTracker;
 // DataSpliter used to split data input to groups of data
 // according to partition information, distributed information
 // and rollup information.
+//
+// The partitions of the rows of a batch are looked up together on the sending thread,
+// which copies the rows to a batch per tablet. Full batches are added to the sorters of
+// the DppSink of their partition by config::data_spliter_threads feeding threads, each
+// one owning the DppSinks of a group of partitions.
 // TODO(zc): think about this to make it more reusable
 class DataSpliter : public DataSink {
 public:
@@ -70,14 +79,31 @@ public:
                               DataSpliter* spliter);
 
 private:
+    // A full batch of a tablet for a feeding thread
+    struct SplitBatch {
+        TabletDesc desc;
+        DppSink* dpp_sink;
+        RowBatch* batch;
+    };
+
     int binary_find_partition(const PartRangeKey& key) const;
-    Status process_partition(
-            RuntimeState* state, TupleRow* row, PartitionInfo** info, int32_t* part_index);
+    // Sets part_indexes[i] to the index of the partition of the i-th row of 'batch', or
+    // to -1 if it has none.
+    void find_partitions(RowBatch* batch, int32_t* part_indexes);
     Status process_distribute(RuntimeState* state, TupleRow* row,
                               const PartitionInfo* part, uint32_t* mod);
     Status send_row(
-            RuntimeState* state, const TabletDesc& desc, TupleRow* row, DppSink* dpp_sink);
-    Status process_one_row(RuntimeState* state, TupleRow* row);
+            RuntimeState* state, const TabletDesc& desc, TupleRow* row, int32_t part_index);
+    Status process_one_row(RuntimeState* state, TupleRow* row, int32_t part_index);
+
+    // Adds the full 'batch' of the tablet 'desc' to the DppSink of the partition, through
+    // the feeding thread of the partition if there are any. Takes the ownership of 'batch'.
+    Status add_batch(RuntimeState* state, const TabletDesc& desc, int32_t part_index,
+                     RowBatch* batch);
+    void feed_loop(RuntimeState* state, BlockingQueue<SplitBatch>* queue);
+    // Lets the feeding threads finish the queued batches and joins them.
+    void stop_feeding();
+    Status feed_status();
 
     boost::scoped_ptr<ObjectPool> _obj_pool;
     const RowDescriptor& _row_desc;
@@ -94,11 +120,24 @@ private:
     // from name to rollup information.
     std::map<std::string, RollupSchema*> _rollup_map;
 
+    // the batches being filled, owned by the spliter
     std::unordered_map<TabletDesc, RowBatch*> _batch_map;
-    std::unordered_map<TabletDesc, DppSink*> _sink_map;
+    // from tablet to the index of its partition
+    std::unordered_map<TabletDesc, int32_t> _part_index_map;
 
     std::vector<DppSink*> _dpp_sink_vec;
 
+    // partition index of each row of the batch being sent
+    std::vector<int32_t> _part_indexes;
+
+    // feeding threads and their queues, the partition with index i is fed by the
+    // thread i % _feed_threads.size()
+    std::vector<std::unique_ptr<BlockingQueue<SplitBatch>>> _feed_queues;
+    std::vector<std::thread> _feed_threads;
+    std::mutex _feed_lock;
+    // first error of the feeding threads, protected by _feed_lock
+    Status _feed_status;
+
     // Allocated from _pool
     RuntimeProfile* _profile;
 
@@ -64,6 +64,7 @@ shared_ptr<DataStreamRecvr> DataStreamMgr::create_recvr(RuntimeState* state,
             new DataStreamRecvr(this, state->instance_mem_tracker(), row_desc,
                 fragment_instance_id, dest_node_id, num_senders, is_merging, buffer_size,
                 profile));
+    recvr->_query_trace = state->query_trace_ptr();
     uint32_t hash_value = get_hash_value(fragment_instance_id, dest_node_id);
     lock_guard<mutex> l(_lock);
     _fragment_stream_set.insert(std::make_pair(fragment_instance_id, dest_node_id));
@@ -100,11 +101,12 @@ shared_ptr<DataStreamRecvr> DataStreamMgr::find_recvr(
 
 Status DataStreamMgr::add_data(
         const TUniqueId& fragment_instance_id, PlanNodeId dest_node_id,
-        const TRowBatch& thrift_batch, int sender_id, bool* buffer_overflow,
+        const TRowBatch& thrift_batch, const std::shared_ptr<uint8_t>& tuple_data,
+        int64_t tuple_data_size, int sender_id, bool* buffer_overflow,
         std::pair<InetAddr, CommBufPtr> response) {
     VLOG_ROW << "add_data(): fragment_instance_id=" << fragment_instance_id
             << " node=" << dest_node_id
-            << " size=" << RowBatch::get_batch_size(thrift_batch);
+            << " size=" << RowBatch::get_batch_size(thrift_batch) + tuple_data_size;
     shared_ptr<DataStreamRecvr> recvr = find_recvr(fragment_instance_id, dest_node_id);
     if (recvr == NULL) {
         // The receiver may remove itself from the receiver map via deregister_recvr()
@@ -116,10 +118,19 @@ Status DataStreamMgr::add_data(
         // errors from receiver-initiated teardowns.
         return Status::OK;
     }
-    recvr->add_batch(thrift_batch, sender_id, buffer_overflow, response);
+    recvr->add_batch(thrift_batch, tuple_data, tuple_data_size, sender_id, buffer_overflow,
+                     response);
     return Status::OK;
 }
 
+shared_ptr<DataStreamRecvr> DataStreamMgr::find_local_recvr(
+        const TUniqueId& fragment_instance_id, PlanNodeId dest_node_id) {
+    // Receivers are created in the prepare phase of their fragment instance, and the
+    // instances of a query are started from top to bottom, so the receiver of a local
+    // destination already exists when its sender is prepared.
+    return find_recvr(fragment_instance_id, dest_node_id);
+}
+
 Status DataStreamMgr::close_sender(const TUniqueId& fragment_instance_id,
                                    PlanNodeId dest_node_id,
                                    int sender_id, 
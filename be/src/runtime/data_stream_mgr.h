@@ -88,13 +88,31 @@ public:
     // TODO: enforce per-sender quotas (something like 200% of buffer_size/#senders),
     // so that a single sender can't flood the buffer and stall everybody else.
     // Returns OK if successful, error status otherwise.
+    // If 'tuple_data' is set, it holds the tuple data of the batch instead of
+    // thrift_batch.tuple_data, see RowBatch.
     Status add_data(const TUniqueId& fragment_instance_id, PlanNodeId dest_node_id,
-            const TRowBatch& thrift_batch, int sender_id, bool* buffer_overflow,
+            const TRowBatch& thrift_batch, const std::shared_ptr<uint8_t>& tuple_data,
+            int64_t tuple_data_size, int sender_id, bool* buffer_overflow,
                     std::pair<InetAddr, CommBufPtr> response);
+
+    // A transmit_data message may carry the tuple data of its row batch behind the
+    // serialized TTransmitDataParams instead of in it. It starts at the first 8 byte
+    // boundary after the params, so that the receiver can use it in place.
+    static uint32_t tuple_data_offset(uint32_t params_len) {
+        return (params_len + 7) & ~7U;
+    }
     // Status add_data(const TUniqueId& fragment_instance_id, PlanNodeId dest_node_id,
     //                 const TRowBatch& thrift_batch, bool* buffer_overflow,
     //                 std::pair<InetAddr, CommBufPtr> response);
 
+    // Returns the receiver for fragment_instance_id/dest_node_id if it was created by
+    // this DataStreamMgr, i.e. the destination fragment instance runs on this backend.
+    // Returns NULL if the destination is remote or the receiver is already closed.
+    // A sender on this backend can hand its batches to the returned receiver directly
+    // instead of sending them via rpc, see DataStreamRecvr::add_local_batch().
+    boost::shared_ptr<DataStreamRecvr> find_local_recvr(
+            const TUniqueId& fragment_instance_id, PlanNodeId dest_node_id);
+
     // Notifies the recvr associated with the fragment/node id that the specified
     // sender has closed.
     // Returns OK if successful, error status otherwise.
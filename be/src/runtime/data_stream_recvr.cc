@@ -26,12 +26,16 @@
 #include <boost/thread/locks.hpp>
 #include <boost/thread/mutex.hpp>
 
+#include "common/config.h"
 #include "runtime/data_stream_mgr.h"
 #include "runtime/row_batch.h"
+#include "runtime/row_batch_pool.h"
 #include "runtime/sorted_run_merger.h"
+#include "util/blocking_aware_thread_pool.h"
 #include "util/runtime_profile.h"
 #include "util/logging.h"
 #include "util/debug_util.h"
+#include "util/query_trace.h"
 
 using std::list;
 using std::vector;
@@ -72,9 +76,15 @@ public:
     // the queue is considered full and the call blocks until a batch is dequeued.
     void add_batch(
             const TRowBatch& batch,
+            const std::shared_ptr<uint8_t>& tuple_data,
+            int64_t tuple_data_size,
             bool* is_buf_overflow,
             std::pair<InetAddr, CommBufPtr> response);
 
+    // Adds the rows of a batch of a sender on this backend, see
+    // DataStreamRecvr::add_local_batch().
+    void add_local_batch(RowBatch* batch, bool transfer_ownership);
+
     // Decrement the number of remaining senders for this queue and signal eos ("new data")
     // if the count drops to 0. The number of senders will be 1 for a merging
     // DataStreamRecvr.
@@ -89,7 +99,7 @@ public:
 
     // Returns the current batch from this queue being processed by a consumer.
     RowBatch* current_batch() const { {
-        return _current_batch.get(); }
+        return _current_batch; }
     }
 
 private:
@@ -118,9 +128,9 @@ private:
     RowBatchQueue _batch_queue;
 
     // The batch that was most recently returned via get_batch(), i.e. the current batch
-    // from this queue being processed by a consumer. Is destroyed when the next batch
-    // is retrieved.
-    scoped_ptr<RowBatch> _current_batch;
+    // from this queue being processed by a consumer. Is put back to the receiver's
+    // batch pool when the next batch is retrieved.
+    RowBatch* _current_batch;
 
     // Set to true when the first batch has been received
     bool _received_first_batch;
@@ -138,6 +148,7 @@ DataStreamRecvr::SenderQueue::SenderQueue(
     _recvr(parent_recvr),
     _is_cancelled(false),
     _num_remaining_senders(num_senders),
+    _current_batch(NULL),
     _received_first_batch(false) {
 }
 
@@ -147,16 +158,17 @@ Status DataStreamRecvr::SenderQueue::get_batch(RowBatch** next_batch) {
     while (!_is_cancelled && _batch_queue.empty() && _num_remaining_senders > 0) {
         VLOG_ROW << "wait arrival fragment_instance_id=" << _recvr->fragment_instance_id()
             << " node=" << _recvr->dest_node_id();
-        // Don't count time spent waiting on the sender as active time.
-        // CANCEL_SAFE_SCOPED_TIMER(_recvr->_data_arrival_timer, &_is_cancelled);
-        // CANCEL_SAFE_SCOPED_TIMER(
-        //         _received_first_batch ? NULL : _recvr->_first_batch_wait_total_timer,
-        //         &_is_cancelled);
+        SCOPED_TIMER(_recvr->_data_arrival_timer);
+        SCOPED_TIMER(_received_first_batch ? NULL : _recvr->_first_batch_wait_total_timer);
+        BlockingAwareThreadPool::ScopedBlocking blocking(&l);
         _data_arrival_cv.wait(l);
     }
 
     // _cur_batch must be replaced with the returned batch.
-    _current_batch.reset();
+    if (_current_batch != NULL) {
+        _recvr->_row_batch_pool->put(_current_batch);
+        _current_batch = NULL;
+    }
     *next_batch = NULL;
     if (_is_cancelled) {
         return Status::CANCELLED;
@@ -174,9 +186,9 @@ Status DataStreamRecvr::SenderQueue::get_batch(RowBatch** next_batch) {
     _recvr->_num_buffered_bytes -= _batch_queue.front().first;
     VLOG_ROW << "fetched #rows=" << result->num_rows();
     _batch_queue.pop_front();
-    // _data_removal_cv.notify_one();
-    _current_batch.reset(result);
-    *next_batch = _current_batch.get();
+    _data_removal_cv.notify_one();
+    _current_batch = result;
+    *next_batch = _current_batch;
 
     {
         boost::unique_lock<boost::mutex> response_lock(_response_lock);
@@ -192,6 +204,8 @@ Status DataStreamRecvr::SenderQueue::get_batch(RowBatch** next_batch) {
 }
 
 void DataStreamRecvr::SenderQueue::add_batch(const TRowBatch& thrift_batch,
+                                             const std::shared_ptr<uint8_t>& tuple_data,
+                                             int64_t tuple_data_size,
                                              bool* is_buf_overflow,
                                              std::pair<InetAddr, CommBufPtr> response) {
     unique_lock<mutex> l(_lock);
@@ -211,7 +225,7 @@ void DataStreamRecvr::SenderQueue::add_batch(const TRowBatch& thrift_batch,
     }
     _packet_seq_map[thrift_batch.be_number] = thrift_batch.packet_seq;
 
-    int batch_size = RowBatch::get_batch_size(thrift_batch);
+    int batch_size = RowBatch::get_batch_size(thrift_batch) + tuple_data_size;
     COUNTER_UPDATE(_recvr->_bytes_received_counter, batch_size);
 
     // Following situation will match the following condition.
@@ -247,7 +261,7 @@ void DataStreamRecvr::SenderQueue::add_batch(const TRowBatch& thrift_batch,
         // Note: if this function makes a row batch, the batch *must* be added
         // to _batch_queue. It is not valid to create the row batch and destroy
         // it in this thread.
-        batch = new RowBatch(_recvr->row_desc(), thrift_batch, _recvr->mem_tracker());
+        batch = _recvr->_row_batch_pool->get(thrift_batch, tuple_data, tuple_data_size);
     }
     VLOG_ROW << "added #rows=" << batch->num_rows()
         << " batch_size=" << batch_size << "\n";
@@ -263,6 +277,36 @@ void DataStreamRecvr::SenderQueue::add_batch(const TRowBatch& thrift_batch,
     _data_arrival_cv.notify_one();
 }
 
+void DataStreamRecvr::SenderQueue::add_local_batch(RowBatch* batch, bool transfer_ownership) {
+    unique_lock<mutex> l(_lock);
+    // Like remote batches, a local batch is always accepted if the queue is empty,
+    // otherwise a merging receiver could stall.
+    if (!_is_cancelled && !_batch_queue.empty() && _recvr->exceeds_limit(0)) {
+        SCOPED_TIMER(_recvr->_buffer_full_total_timer);
+        while (!_is_cancelled && !_batch_queue.empty() && _recvr->exceeds_limit(0)) {
+            BlockingAwareThreadPool::ScopedBlocking blocking(&l);
+            _data_removal_cv.wait(l);
+        }
+    }
+    if (_is_cancelled || _num_remaining_senders <= 0) {
+        return;
+    }
+
+    RowBatch* local_batch = _recvr->_row_batch_pool->get(batch->capacity());
+    if (transfer_ownership) {
+        local_batch->acquire_state(batch);
+    } else {
+        batch->deep_copy_to(local_batch);
+    }
+    int batch_size = local_batch->tuple_data_pool()->total_allocated_bytes();
+    COUNTER_UPDATE(_recvr->_bytes_received_counter, batch_size);
+    VLOG_ROW << "added local #rows=" << local_batch->num_rows()
+        << " batch_size=" << batch_size << "\n";
+    _batch_queue.push_back(make_pair(batch_size, local_batch));
+    _recvr->_num_buffered_bytes += batch_size;
+    _data_arrival_cv.notify_one();
+}
+
 void DataStreamRecvr::SenderQueue::decrement_senders(int be_number) {
     lock_guard<mutex> l(_lock);
 
@@ -299,7 +343,7 @@ void DataStreamRecvr::SenderQueue::cancel() {
     // Wake up all threads waiting to produce/consume batches.  They will all
     // notice that the stream is cancelled and handle it.
     _data_arrival_cv.notify_all();
-    // _data_removal_cv.notify_all();
+    _data_removal_cv.notify_all();
     // PeriodicCounterUpdater::StopTimeSeriesCounter(
     //         _recvr->_bytes_received_time_series_counter);
 
@@ -322,13 +366,16 @@ void DataStreamRecvr::SenderQueue::close() {
         boost::lock_guard<boost::mutex> l(_lock);
         _is_cancelled = true;
     }
+    // Wake up local senders blocked on a full queue
+    _data_removal_cv.notify_all();
     // Delete any batches queued in _batch_queue
     for (RowBatchQueue::iterator it = _batch_queue.begin();
             it != _batch_queue.end(); ++it) {
         delete it->second;
     }
 
-    _current_batch.reset();
+    delete _current_batch;
+    _current_batch = NULL;
 }
 
 Status DataStreamRecvr::create_merger(const TupleRowComparator& less_than) {
@@ -369,6 +416,8 @@ DataStreamRecvr::DataStreamRecvr(
             _num_buffered_bytes(0),
             _profile(profile) {
     _mem_tracker.reset(new MemTracker(-1, "DataStreamRecvr", parent_tracker));
+    _row_batch_pool.reset(new RowBatchPool(
+            _row_desc, _mem_tracker.get(), config::row_batch_pool_max_free_batches));
 
     // Create one queue per sender if is_merging is true.
     int num_queues = is_merging ? num_senders : 1;
@@ -389,7 +438,7 @@ DataStreamRecvr::DataStreamRecvr(
         ADD_TIMER(_profile, "DeserializeRowBatchTimer");
     _buffer_full_wall_timer = ADD_TIMER(_profile, "SendersBlockedTimer");
     _buffer_full_total_timer = ADD_TIMER(_profile, "SendersBlockedTotalTimer(*)");
-    // _data_arrival_timer = _profile->inactive_timer();
+    _data_arrival_timer = ADD_TIMER(_profile, "DataArrivalWaitTime");
     _first_batch_wait_total_timer = ADD_TIMER(_profile, "FirstBatchArrivalWaitTime");
 }
 
@@ -399,11 +448,26 @@ Status DataStreamRecvr::get_next(RowBatch* output_batch, bool* eos) {
 }
 
 void DataStreamRecvr::add_batch(
-        const TRowBatch& thrift_batch, int sender_id,
+        const TRowBatch& thrift_batch, const std::shared_ptr<uint8_t>& tuple_data,
+        int64_t tuple_data_size, int sender_id,
         bool* is_buf_overflow, std::pair<InetAddr, CommBufPtr> response) {
     int use_sender_id = _is_merging ? sender_id : 0;
+    ScopedTraceSpan span(_query_trace.get(), "exchange", "receive_batch");
+    if (span.enabled()) {
+        int64_t bytes = RowBatch::get_batch_size(thrift_batch) + tuple_data_size;
+        span.set_detail("sender_id=" + std::to_string(sender_id)
+                + " be_number=" + std::to_string(thrift_batch.be_number)
+                + " bytes=" + std::to_string(bytes));
+    }
     // Add all batches to the same queue if _is_merging is false.
-    _sender_queues[use_sender_id]->add_batch(thrift_batch, is_buf_overflow, response);
+    _sender_queues[use_sender_id]->add_batch(
+            thrift_batch, tuple_data, tuple_data_size, is_buf_overflow, response);
+}
+
+void DataStreamRecvr::add_local_batch(
+        RowBatch* batch, int sender_id, bool transfer_ownership) {
+    int use_sender_id = _is_merging ? sender_id : 0;
+    _sender_queues[use_sender_id]->add_local_batch(batch, transfer_ownership);
 }
 
 void DataStreamRecvr::remove_sender(int sender_id, int be_number) {
@@ -426,6 +490,7 @@ void DataStreamRecvr::close() {
     _mgr->deregister_recvr(fragment_instance_id(), dest_node_id());
     _mgr = NULL;
     _merger.reset();
+    _row_batch_pool.reset();
     _mem_tracker->unregister_from_parent();
     _mem_tracker.reset();
 }
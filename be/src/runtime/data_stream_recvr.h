@@ -37,7 +37,9 @@ namespace palo {
 class DataStreamMgr;
 class SortedRunMerger;
 class MemTracker;
+class QueryTrace;
 class RowBatch;
+class RowBatchPool;
 class RuntimeProfile;
 
 class Comm;
@@ -96,6 +98,18 @@ public:
     // queue to the specified batch.
     void transfer_all_resources(RowBatch* transfer_batch);
 
+    // Adds the rows of 'batch' from a sender on the same backend to the appropriate
+    // sender queue without serializing them. If 'transfer_ownership' is true, the
+    // memory of 'batch' is handed over to the queue and 'batch' is reset, otherwise
+    // the rows are deep copied and the caller keeps 'batch'. Local senders don't get
+    // acks the receiver could withhold, so this blocks while the stream exceeds its
+    // buffer limit instead.
+    void add_local_batch(RowBatch* batch, int sender_id, bool transfer_ownership);
+
+    // Indicate that a particular sender is done. Delegated to the appropriate
+    // sender queue. Called from DataStreamMgr or by a local sender.
+    void remove_sender(int sender_id, int be_number);
+
     const TUniqueId& fragment_instance_id() const { return _fragment_instance_id; }
     PlanNodeId dest_node_id() const { return _dest_node_id; }
     const RowDescriptor& row_desc() const { return _row_desc; }
@@ -111,14 +125,12 @@ private:
             RuntimeProfile* profile);
 
     // Add a new batch of rows to the appropriate sender queue, blocking if the queue is
-    // full. Called from DataStreamMgr.
-    void add_batch(const TRowBatch& thrift_batch, int sender_id,
+    // full. Called from DataStreamMgr. If 'tuple_data' is set, it holds the tuple data
+    // of the batch instead of thrift_batch.tuple_data, see RowBatch.
+    void add_batch(const TRowBatch& thrift_batch, const std::shared_ptr<uint8_t>& tuple_data,
+                   int64_t tuple_data_size, int sender_id,
                    bool* is_buf_overflow, std::pair<InetAddr, CommBufPtr> response);
 
-    // Indicate that a particular sender is done. Delegated to the appropriate
-    // sender queue. Called from DataStreamMgr.
-    void remove_sender(int sender_id, int be_number);
-
     // Empties the sender queues and notifies all waiting consumers of cancellation.
     void cancel_stream();
 
@@ -153,6 +165,9 @@ private:
     // Memtracker for batches in the sender queue(s).
     boost::scoped_ptr<MemTracker> _mem_tracker;
 
+    // Batches that consumers are done with, reused for the batches of the senders.
+    boost::scoped_ptr<RowBatchPool> _row_batch_pool;
+
     // One or more queues of row batches received from senders. If _is_merging is true,
     // there is one SenderQueue for each sender. Otherwise, row batches from all senders
     // are placed in the same SenderQueue. The SenderQueue instances are owned by the
@@ -197,7 +212,11 @@ private:
     RuntimeProfile::Counter* _buffer_full_wall_timer;
 
     // Total time spent waiting for data to arrive in the recv buffer
-    // RuntimeProfile::Counter* _data_arrival_timer;
+    RuntimeProfile::Counter* _data_arrival_timer;
+
+    // Set by DataStreamMgr if the query is traced. Shared since batches may still
+    // arrive while the fragment is torn down.
+    std::shared_ptr<QueryTrace> _query_trace;
 };
 
 } // end namespace palo
@@ -25,9 +25,15 @@
 #include <boost/thread/thread.hpp>
 #include <thrift/protocol/TDebugProtocol.h>
 
+#include "common/config.h"
 #include "common/logging.h"
 #include "exprs/expr.h"
+#include "exprs/expr_column.h"
+#include "exprs/expr_context.h"
+#include "runtime/data_stream_mgr.h"
+#include "runtime/data_stream_recvr.h"
 #include "runtime/descriptors.h"
+#include "runtime/exec_env.h"
 #include "runtime/tuple_row.h"
 #include "runtime/row_batch.h"
 #include "runtime/raw_value.h"
@@ -35,8 +41,10 @@
 #include "runtime/client_cache.h"
 #include "runtime/dpp_sink_internal.h"
 #include "runtime/mem_tracker.h"
+#include "util/blocking_aware_thread_pool.h"
 #include "util/debug_util.h"
 #include "util/network_util.h"
+#include "util/query_trace.h"
 #include "util/thrift_client.h"
 #include "util/thrift_util.h"
 
@@ -59,9 +67,13 @@ namespace palo {
 // to a single destination ipaddress/node.
 // It has a fixed-capacity buffer and allows the caller either to add rows to
 // that buffer individually (AddRow()), or circumvent the buffer altogether and send
-// TRowBatches directly (SendBatch()). Either way, there can only be one in-flight RPC
-// at any one time (ie, sending will block if the most recent rpc hasn't finished,
-// which allows the receiver node to throttle the sender by withholding acks).
+// TRowBatches directly (SendBatch()). Either way, there can only be
+// config::data_stream_sender_max_in_flight_rpcs in-flight RPCs at any one time (ie,
+// sending will block if that many rpcs haven't finished, which allows the receiver node
+// to throttle the sender by withholding acks). The next batch is serialized while the
+// previous ones are in flight.
+// If the destination runs on this backend, the channel bypasses serialization and rpc
+// and hands its row batches to the DataStreamRecvr directly.
 // *Not* thread-safe.
 class DataStreamSender::Channel : public DispatchHandler {
 public:
@@ -79,9 +91,11 @@ public:
         _dest_node_id(dest_node_id),
         _num_data_bytes_sent(0),
         _packet_seq(0),
-        _rpc_in_flight(false),
+        _max_in_flight_rpcs(1),
+        _last_request_id(0),
         _is_closed(false),
-        _thrift_serializer(false, 1024) {
+        _compact(config::exchange_use_compact_protocol),
+        _thrift_serializer(_compact, 1024) {
 
         _comm = Comm::instance();
 
@@ -106,7 +120,19 @@ public:
     // Returns the status of the most recently finished transmit_data
     // rpc (or OK if there wasn't one that hasn't been reported yet).
     // if batch is nullptr, send the eof packet
-    Status send_batch(TRowBatch* batch);
+    // If 'tuple_data' is set, it was taken out of 'batch' by take_tuple_data() and is
+    // sent behind the params without being copied.
+    Status send_batch(TRowBatch* batch, const std::shared_ptr<std::string>& tuple_data);
+
+    // Hands 'batch' to the local receiver. Must only be called if is_local() is true.
+    // If 'transfer_ownership' is true, the memory of 'batch' is moved to the receiver
+    // and 'batch' is reset, otherwise its rows are copied.
+    Status send_local_batch(RowBatch* batch, bool transfer_ownership);
+
+    // Returns true if the destination runs on this backend.
+    bool is_local() const {
+        return _local_recvr != NULL;
+    }
 
     // Flush buffered rows and close channel.
     // Returns error status if any of the preceding rpcs failed, OK otherwise.
@@ -123,13 +149,23 @@ public:
         return &_thrift_batch;
     }
 
+    std::shared_ptr<std::string>* tuple_data_slot() {
+        return &_tuple_data_slot;
+    }
+
     // DispatchHandler handle, used to handle request event
     void handle(EventPtr &event_ptr) override;
 
 private:
-    // finish last send, this function may retry last sent if there is error when wait
+    // finish all sends, this function may retry last sent if there is error when wait
     // for response
-    Status _finish_last_sent();
+    Status _finish_last_sent() {
+        return _wait_in_flight_rpcs(0);
+    }
+    // wait until at most max_in_flight rpcs are in flight. A failed rpc is only sent
+    // again if it was the last one sent and the only one in flight, since the receiver
+    // must get the batches of a sender in order.
+    Status _wait_in_flight_rpcs(size_t max_in_flight);
     // Serialize _batch into _thrift_batch and send via send_batch().
     // Returns send_batch() status.
     Status send_current_batch();
@@ -151,14 +187,17 @@ private:
     // we're accumulating rows into this batch
     boost::scoped_ptr<RowBatch> _batch;
     TRowBatch _thrift_batch;
-
-    // We want to reuse the rpc thread to prevent creating a thread per rowbatch.
-    // TODO: currently we only have one batch in flight, but we should buffer more
-    // batches. This is a bit tricky since the channels share the outgoing batch
-    // pointer we need some mechanism to coordinate when the batch is all done.
-    // TODO: if the order of row batches does not matter, we can consider increasing
-    // the number of threads.
-    bool _rpc_in_flight;  // true if the rpc in sending.
+    // tuple data taken out of _thrift_batch, see take_tuple_data()
+    std::shared_ptr<std::string> _tuple_data_slot;
+
+    // Requests that have been sent but not acked yet, in the order they were sent.
+    // The receiver may ack them out of order when it withholds acks for a full queue.
+    // Every request holds its own copy of the serialized batch, so the channels can
+    // share the outgoing thrift batch as soon as send_batch() returns.
+    std::deque<CommBufPtr> _in_flight_rpcs;
+    size_t _max_in_flight_rpcs;
+    // header id of the most recently sent request, which _serialized_buf belongs to
+    uint32_t _last_request_id;
 
     Status _rpc_status;  // status of most recently finished transmit_data rpc
 
@@ -166,10 +205,11 @@ private:
     int _be_number;
 
     CommAddress _addr;
-    CommBufPtr _cbp;
     Comm* _comm;
     ConnectionManagerPtr _conn_mgr;
 
+    // whether requests are serialized with the compact protocol, flagged in their header
+    bool _compact;
     ThriftSerializer _thrift_serializer;
 
     // lock, protect variables
@@ -179,9 +219,14 @@ private:
 
     uint8_t* _serialized_buf = nullptr;
     uint32_t _serialized_buf_bytes = 0;
+    // tuple data of the most recently sent request, sent behind _serialized_buf
+    std::shared_ptr<std::string> _tuple_data;
 
     uint32_t _connect_timeout_ms = 500;
     uint32_t _rpc_timeout_ms = 1000;
+
+    // Receiver of the destination if it runs on this backend, NULL otherwise.
+    boost::shared_ptr<DataStreamRecvr> _local_recvr;
 };
 
 Status DataStreamSender::Channel::init(RuntimeState* state) {
@@ -191,6 +236,17 @@ Status DataStreamSender::Channel::init(RuntimeState* state) {
     int capacity = std::max(1, _buffer_size / std::max(_row_desc.get_row_size(), 1));
     _batch.reset(new RowBatch(_row_desc, capacity, _parent->_mem_tracker.get()));
 
+    if (config::enable_local_exchange) {
+        _local_recvr = state->exec_env()->stream_mgr()->find_local_recvr(
+                _fragment_instance_id, _dest_node_id);
+        if (_local_recvr != NULL) {
+            VLOG_QUERY << "Channel::init() local destination instance_id="
+                << _fragment_instance_id << " dest_node=" << _dest_node_id;
+            return Status::OK;
+        }
+    }
+
+    _max_in_flight_rpcs = std::max(1, config::data_stream_sender_max_in_flight_rpcs);
     _conn_mgr = state->exec_env()->get_conn_manager();
     _conn_mgr->add(_addr, _connect_timeout_ms, NULL);
     // One hour is max rpc timeout
@@ -198,11 +254,13 @@ Status DataStreamSender::Channel::init(RuntimeState* state) {
     return Status::OK;
 }
 
-Status DataStreamSender::Channel::send_batch(TRowBatch* batch) {
+Status DataStreamSender::Channel::send_batch(
+        TRowBatch* batch, const std::shared_ptr<std::string>& tuple_data) {
     VLOG_ROW << "Channel::send_batch() instance_id=" << _fragment_instance_id
              << " dest_node=" << _dest_node_id;
+    ScopedTraceSpan span(_parent->_state->query_trace(), "exchange", "send_batch");
 
-    RETURN_IF_ERROR(_finish_last_sent());
+    RETURN_IF_ERROR(_wait_in_flight_rpcs(_max_in_flight_rpcs - 1));
 
     TTransmitDataParams params;
     params.protocol_version = PaloInternalServiceVersion::V1;
@@ -214,19 +272,43 @@ Status DataStreamSender::Channel::send_batch(TRowBatch* batch) {
     if (batch != nullptr) {
         batch->be_number = _be_number;
         batch->packet_seq = _packet_seq++;
-        params.__set_row_batch(*batch);  // yet another copy
         params.__set_packet_seq(batch->packet_seq);
         params.__set_eos(false);
+        // lend the batch to the params instead of copying it, the broadcast batch is
+        // still needed by the other channels
+        params.__isset.row_batch = true;
+        std::swap(params.row_batch, *batch);
+        _thrift_serializer.serialize(&params, &_serialized_buf_bytes, &_serialized_buf);
+        std::swap(params.row_batch, *batch);
     } else {
         params.__set_packet_seq(_packet_seq++);
         params.__set_eos(true);
+        _thrift_serializer.serialize(&params, &_serialized_buf_bytes, &_serialized_buf);
+    }
+    _tuple_data = tuple_data;
+    if (span.enabled()) {
+        int64_t bytes = _serialized_buf_bytes + (tuple_data != nullptr ? tuple_data->size() : 0);
+        span.set_detail("dest_instance_id=" + print_id(_fragment_instance_id)
+                + " bytes=" + std::to_string(bytes));
     }
-
-    _thrift_serializer.serialize(&params, &_serialized_buf_bytes, &_serialized_buf);
 
     return _send_message();
 }
 
+Status DataStreamSender::Channel::send_local_batch(RowBatch* batch, bool transfer_ownership) {
+    DCHECK(is_local());
+    VLOG_ROW << "Channel::send_local_batch() instance_id=" << _fragment_instance_id
+             << " dest_node=" << _dest_node_id;
+    COUNTER_UPDATE(_parent->_local_batches_counter, 1);
+    ScopedTraceSpan span(_parent->_state->query_trace(), "exchange", "send_local_batch");
+    if (span.enabled()) {
+        span.set_detail("dest_instance_id=" + print_id(_fragment_instance_id)
+                + " rows=" + std::to_string(batch->num_rows()));
+    }
+    _local_recvr->add_local_batch(batch, _parent->_sender_id, transfer_ownership);
+    return Status::OK;
+}
+
 void DataStreamSender::Channel::handle(EventPtr& event) {
     {
         std::lock_guard<std::mutex> l(_lock);
@@ -235,14 +317,16 @@ void DataStreamSender::Channel::handle(EventPtr& event) {
     _cond.notify_one();
 }
 
-Status DataStreamSender::Channel::_finish_last_sent() {
-    if (!_rpc_in_flight) {
+Status DataStreamSender::Channel::_wait_in_flight_rpcs(size_t max_in_flight) {
+    if (!_rpc_status.ok()) {
         return _rpc_status;
     }
     int retry_times = 1;
-    while (true) {
+    while (_in_flight_rpcs.size() > max_in_flight) {
         EventPtr event;
         {
+            // Declared first, so the slot is only taken back once _lock is released.
+            BlockingAwareThreadPool::ScopedBlocking blocking;
             std::unique_lock<std::mutex> l(_lock);
             auto duration = std::chrono::milliseconds(2 * _rpc_timeout_ms);
             if (_cond.wait_for(l, duration, [this]() { return !this->_events.empty(); })) {
@@ -250,52 +334,58 @@ Status DataStreamSender::Channel::_finish_last_sent() {
                 _events.pop_front();
             }
         }
-        if (event == nullptr) {
-            LOG(WARNING) << "it's so weird, wait reponse event timeout, request="
-                << _cbp->header.id << ", addr=" << _addr.to_str();
-            _rpc_in_flight = false;
-            if (retry_times-- > 0) {
-                // timeout to receive response
-                RETURN_IF_ERROR(_send_message());
-            } else {
-                LOG(WARNING) << "fail to send batch, _add=" << _addr.to_str()
-                    << ", request_id="<< _cbp->header.id;
-                _rpc_status = Status(TStatusCode::THRIFT_RPC_ERROR, "fail to send batch");
-                break;
+        if (event != nullptr && event->type == Event::MESSAGE) {
+            auto it = _in_flight_rpcs.begin();
+            while (it != _in_flight_rpcs.end() && (*it)->header.id != event->header.id) {
+                ++it;
             }
-            continue;
-        }
-        if (event->type == Event::MESSAGE) {
-            if (event->header.id != _cbp->header.id) {
+            if (it == _in_flight_rpcs.end()) {
                 LOG(WARNING) << "receive event id not equal with in-flight request, request_id="
-                    << _cbp->header.id << ", event=" << event->to_str();
+                    << _last_request_id << ", event=" << event->to_str();
                 continue;
             }
             // response recept
-            _rpc_in_flight = false;
-            return Status::OK;
+            _in_flight_rpcs.erase(it);
+            continue;
+        }
+
+        uint32_t failed_request_id = 0;
+        if (event == nullptr) {
+            LOG(WARNING) << "it's so weird, wait reponse event timeout, request="
+                << _in_flight_rpcs.front()->header.id << ", addr=" << _addr.to_str();
+            failed_request_id = _in_flight_rpcs.front()->header.id;
         } else if (event->type == Event::DISCONNECT || event->type == Event::ERROR) {
-            if (event->header.id != 0 && event->header.id != _cbp->header.id) {
+            auto it = _in_flight_rpcs.begin();
+            while (event->header.id != 0 && it != _in_flight_rpcs.end()
+                    && (*it)->header.id != event->header.id) {
+                ++it;
+            }
+            if (it == _in_flight_rpcs.end()) {
                 LOG(WARNING) << "receive event id not equal with in-flight request, request_id="
-                    << _cbp->header.id << ", event=" << event->to_str();
+                    << _last_request_id << ", event=" << event->to_str();
                 continue;
             }
-            LOG(WARNING) << "receive response failed, request_id=" << _cbp->header.id
+            LOG(WARNING) << "receive response failed, request_id=" << (*it)->header.id
                 << ", event=" << event->to_str();
-            _rpc_in_flight = false;
-            // error happend when receving response, we need to retry last request
-            if (retry_times-- > 0) {
-                // timeout to receive response
-                RETURN_IF_ERROR(_send_message());
-            } else {
-                LOG(WARNING) << "fail to send batch, request_id="<< _cbp->header.id
-                    << ", event=" << event->to_str();
-                _rpc_status = Status(TStatusCode::THRIFT_RPC_ERROR, "fail to send batch");
-                break;
-            }
+            failed_request_id = (*it)->header.id;
         } else {
-            _rpc_in_flight = false;
             LOG(ERROR) << "recevie unexpect event, event=" << event->to_str();
+            _in_flight_rpcs.clear();
+            _rpc_status = Status(TStatusCode::THRIFT_RPC_ERROR, "fail to send batch");
+            break;
+        }
+
+        // error happend when receving response, we can retry last request if nothing
+        // else is in flight
+        if (retry_times-- > 0 && _in_flight_rpcs.size() == 1
+                && failed_request_id == _last_request_id) {
+            _in_flight_rpcs.clear();
+            RETURN_IF_ERROR(_send_message());
+        } else {
+            LOG(WARNING) << "fail to send batch, _add=" << _addr.to_str()
+                << ", request_id=" << failed_request_id
+                << ", num_in_flight=" << _in_flight_rpcs.size();
+            _in_flight_rpcs.clear();
             _rpc_status = Status(TStatusCode::THRIFT_RPC_ERROR, "fail to send batch");
             break;
         }
@@ -305,11 +395,25 @@ Status DataStreamSender::Channel::_finish_last_sent() {
 }
 
 Status DataStreamSender::Channel::_send_message() {
-    DCHECK(!_rpc_in_flight);
+    DCHECK_LT(_in_flight_rpcs.size(), _max_in_flight_rpcs);
 
     CommHeader header;
-    CommBufPtr new_comm_buf = std::make_shared<CommBuf>(header, _serialized_buf_bytes);
-    new_comm_buf->append_bytes(_serialized_buf, _serialized_buf_bytes);
+    if (_compact) {
+        header.flags |= CommHeader::FLAGS_BIT_COMPACT_PROTOCOL;
+    }
+    CommBufPtr new_comm_buf;
+    if (_tuple_data != nullptr) {
+        static const uint8_t padding[8] = { 0 };
+        uint32_t offset = DataStreamMgr::tuple_data_offset(_serialized_buf_bytes);
+        new_comm_buf = std::make_shared<CommBuf>(
+                header, offset, reinterpret_cast<const uint8_t*>(_tuple_data->data()),
+                _tuple_data->size(), _tuple_data);
+        new_comm_buf->append_bytes(_serialized_buf, _serialized_buf_bytes);
+        new_comm_buf->append_bytes(padding, offset - _serialized_buf_bytes);
+    } else {
+        new_comm_buf = std::make_shared<CommBuf>(header, _serialized_buf_bytes);
+        new_comm_buf->append_bytes(_serialized_buf, _serialized_buf_bytes);
+    }
 
     auto res = _comm->send_request(_addr, _rpc_timeout_ms, new_comm_buf, this);
     if (res != error::OK) {
@@ -333,8 +437,8 @@ Status DataStreamSender::Channel::_send_message() {
             return _rpc_status;
         }
     }
-    _cbp = new_comm_buf;
-    _rpc_in_flight = true;
+    _in_flight_rpcs.push_back(new_comm_buf);
+    _last_request_id = new_comm_buf->header.id;
     return Status::OK;
 }
 
@@ -367,6 +471,10 @@ Status DataStreamSender::Channel::add_row(TupleRow* row) {
 }
 
 Status DataStreamSender::Channel::send_current_batch() {
+    if (is_local()) {
+        // _batch only holds deep copies, so its memory can be moved to the receiver
+        return send_local_batch(_batch.get(), true);
+    }
     {
         SCOPED_TIMER(_parent->_serialize_batch_timer);
         int uncompressed_bytes = _batch->serialize(&_thrift_batch);
@@ -374,7 +482,8 @@ Status DataStreamSender::Channel::send_current_batch() {
         COUNTER_UPDATE(_parent->_uncompressed_bytes_counter, uncompressed_bytes);
     }
     _batch->reset();
-    RETURN_IF_ERROR(send_batch(&_thrift_batch));
+    RETURN_IF_ERROR(send_batch(
+            &_thrift_batch, take_tuple_data(&_thrift_batch, &_tuple_data_slot)));
     return Status::OK;
 }
 
@@ -389,7 +498,14 @@ Status DataStreamSender::Channel::close_internal() {
         RETURN_IF_ERROR(send_current_batch());
     }
 
-    RETURN_IF_ERROR(send_batch(nullptr));
+    if (is_local()) {
+        _local_recvr->remove_sender(_parent->_sender_id, _be_number);
+        _local_recvr.reset();
+        _is_closed = true;
+        return Status::OK;
+    }
+
+    RETURN_IF_ERROR(send_batch(nullptr, nullptr));
     RETURN_IF_ERROR(_finish_last_sent());
     _is_closed = true;
     return Status::OK;
@@ -416,6 +532,8 @@ DataStreamSender::DataStreamSender(
         _serialize_batch_timer(NULL),
         _thrift_transmit_timer(NULL),
         _bytes_sent_counter(NULL),
+        _local_batches_counter(NULL),
+        _num_local_channels(0),
         _dest_node_id(sink.dest_node_id) {
     DCHECK_GT(destinations.size(), 0);
     DCHECK(sink.output_partition.type == TPartitionType::UNPARTITIONED
@@ -500,6 +618,8 @@ Status DataStreamSender::prepare(RuntimeState* state) {
         ADD_COUNTER(profile(), "UncompressedRowBatchSize", TUnit::BYTES);
     _ignore_rows =
         ADD_COUNTER(profile(), "IgnoreRows", TUnit::UNIT);
+    _local_batches_counter =
+        ADD_COUNTER(profile(), "LocalRowBatchesSent", TUnit::UNIT);
     _serialize_batch_timer =
         ADD_TIMER(profile(), "SerializeBatchTime");
     _thrift_transmit_timer = ADD_TIMER(profile(), "ThriftTransmitTime(*)");
@@ -514,6 +634,9 @@ Status DataStreamSender::prepare(RuntimeState* state) {
 
     for (int i = 0; i < _channels.size(); ++i) {
         RETURN_IF_ERROR(_channels[i]->init(state));
+        if (_channels[i]->is_local()) {
+            ++_num_local_channels;
+        }
     }
 
     return Status::OK;
@@ -541,11 +664,23 @@ Status DataStreamSender::send(RuntimeState* state, RowBatch* batch) {
     if (_part_type == TPartitionType::UNPARTITIONED || _channels.size() == 1) {
         // _current_thrift_batch is *not* the one that was written by the last call
         // to Serialize()
-        RETURN_IF_ERROR(serialize_batch(batch, _current_thrift_batch, _channels.size()));
+        int num_remote_channels = _channels.size() - _num_local_channels;
+        std::shared_ptr<std::string>* tuple_data_slot =
+            (_current_thrift_batch == &_thrift_batch1 ? &_tuple_data1 : &_tuple_data2);
+        std::shared_ptr<std::string> tuple_data;
+        if (num_remote_channels > 0) {
+            RETURN_IF_ERROR(serialize_batch(batch, _current_thrift_batch, num_remote_channels));
+            tuple_data = take_tuple_data(_current_thrift_batch, tuple_data_slot);
+        }
         // SendBatch() will block if there are still in-flight rpcs (and those will
         // reference the previously written thrift batch)
         for (int i = 0; i < _channels.size(); ++i) {
-            RETURN_IF_ERROR(_channels[i]->send_batch(_current_thrift_batch));
+            if (_channels[i]->is_local()) {
+                // 'batch' still belongs to the caller, the local receiver gets a copy
+                RETURN_IF_ERROR(_channels[i]->send_local_batch(batch, false));
+            } else {
+                RETURN_IF_ERROR(_channels[i]->send_batch(_current_thrift_batch, tuple_data));
+            }
         }
         _current_thrift_batch =
             (_current_thrift_batch == &_thrift_batch1 ? &_thrift_batch2 : &_thrift_batch1);
@@ -553,27 +688,31 @@ Status DataStreamSender::send(RuntimeState* state, RowBatch* batch) {
         // Round-robin batches among channels. Wait for the current channel to finish its
         // rpc before overwriting its batch.
         Channel* current_channel = _channels[_current_channel_idx];
-        RETURN_IF_ERROR(serialize_batch(batch, current_channel->thrift_batch()));
-        RETURN_IF_ERROR(current_channel->send_batch(current_channel->thrift_batch()));
+        if (current_channel->is_local()) {
+            RETURN_IF_ERROR(current_channel->send_local_batch(batch, false));
+        } else {
+            TRowBatch* thrift_batch = current_channel->thrift_batch();
+            RETURN_IF_ERROR(serialize_batch(batch, thrift_batch));
+            RETURN_IF_ERROR(current_channel->send_batch(thrift_batch,
+                    take_tuple_data(thrift_batch, current_channel->tuple_data_slot())));
+        }
         _current_channel_idx = (_current_channel_idx + 1) % _channels.size();
     } else if (_part_type == TPartitionType::HASH_PARTITIONED) {
         // hash-partition batch's rows across channels
         int num_channels = _channels.size();
-
-        for (int i = 0; i < batch->num_rows(); ++i) {
-            TupleRow* row = batch->get_row(i);
-            size_t hash_val = 0;
-
-            for (auto ctx : _partition_expr_ctxs) {
-                void* partition_val = ctx->get_value(row);
-                // We can't use the crc hash function here because it does not result
-                // in uncorrelated hashes with different seeds.  Instead we must use
-                // fvn hash.
-                // TODO: fix crc hash/GetHashValue()
-                hash_val = RawValue::get_hash_value_fvn(
-                    partition_val, ctx->root()->type(), hash_val);
-            }
-            RETURN_IF_ERROR(_channels[hash_val % num_channels]->add_row(row));
+        int num_rows = batch->num_rows();
+
+        // Hash the partition exprs column by column. The hash must be the same on all
+        // the senders of the exchange, fast_hash64() doesn't depend on the host.
+        _partition_hashes.assign(num_rows, 0);
+        ExprColumn column;
+        for (auto ctx : _partition_expr_ctxs) {
+            ctx->evaluate_batch(batch, NULL, num_rows, &column);
+            column.hash(_partition_hashes.data());
+        }
+        for (int i = 0; i < num_rows; ++i) {
+            RETURN_IF_ERROR(_channels[_partition_hashes[i] % num_channels]->add_row(
+                    batch->get_row(i)));
         }
     } else {
         // Range partition
@@ -732,6 +871,21 @@ Status DataStreamSender::serialize_batch(RowBatch* src, TRowBatch* dest, int num
     return Status::OK;
 }
 
+std::shared_ptr<std::string> DataStreamSender::take_tuple_data(
+        TRowBatch* batch, std::shared_ptr<std::string>* slot) {
+    if (!config::enable_exchange_out_of_band_tuple_data
+            || (batch->__isset.is_columnar && batch->is_columnar)
+            || batch->tuple_data.empty()) {
+        return nullptr;
+    }
+    // reuse the string of the batch before last once no request refers to it anymore,
+    // the batch gets its buffer back to serialize into
+    if (*slot == nullptr || slot->use_count() > 1) {
+        slot->reset(new std::string());
+    }
+    (*slot)->swap(batch->tuple_data);
+    return *slot;
+}
 
 int64_t DataStreamSender::get_num_data_bytes_sent() const {
     // TODO: do we need synchronization here or are reads & writes to 8-byte ints
@@ -21,6 +21,7 @@
 #ifndef BDG_PALO_BE_RUNTIME_DATA_STREAM_SENDER_H
 #define BDG_PALO_BE_RUNTIME_DATA_STREAM_SENDER_H
 
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -95,6 +96,14 @@ public:
     /// used to maintain metrics.
     Status serialize_batch(RowBatch* src, TRowBatch* dest, int num_receivers = 1);
 
+    // Moves the tuple data of 'batch' into the string held by 'slot', so that the
+    // channels can send it behind their requests without copying it. 'slot' gets a new
+    // string if requests still refer to its current one. Returns NULL, and leaves the
+    // tuple data in 'batch', if config::enable_exchange_out_of_band_tuple_data is off
+    // or the batch is columnar.
+    static std::shared_ptr<std::string> take_tuple_data(
+            TRowBatch* batch, std::shared_ptr<std::string>* slot);
+
     // Return total number of bytes sent in TRowBatch.data. If batches are
     // broadcast to multiple receivers, they are counted once per receiver.
     int64_t get_num_data_bytes_sent() const;
@@ -141,8 +150,13 @@ private:
     TRowBatch _thrift_batch1;
     TRowBatch _thrift_batch2;
     TRowBatch* _current_thrift_batch;  // the next one to fill in send()
+    // tuple data taken out of _thrift_batch1/2, see take_tuple_data()
+    std::shared_ptr<std::string> _tuple_data1;
+    std::shared_ptr<std::string> _tuple_data2;
 
     std::vector<ExprContext*> _partition_expr_ctxs;  // compute per-row partition values
+    // per-row hashes of the partition values of the batch being hash-partitioned
+    std::vector<uint64_t> _partition_hashes;
 
     std::vector<Channel*> _channels;
     std::vector<std::shared_ptr<Channel>> _channel_shared_ptrs;
@@ -157,6 +171,8 @@ private:
     RuntimeProfile::Counter* _bytes_sent_counter;
     RuntimeProfile::Counter* _uncompressed_bytes_counter;
     RuntimeProfile::Counter* _ignore_rows;
+    // Number of row batches handed to receivers on this backend without rpc
+    RuntimeProfile::Counter* _local_batches_counter;
 
     std::unique_ptr<MemTracker> _mem_tracker;
 
@@ -166,6 +182,9 @@ private:
     // Throughput per total time spent in sender
     RuntimeProfile::Counter* _overall_throughput;
 
+    // Number of channels whose destination runs on this backend.
+    int _num_local_channels;
+
     // Identifier of the destination plan node.
     PlanNodeId _dest_node_id;
 };
@@ -99,10 +99,59 @@ bool DateTimeValue::check_date() const {
     return false;
 }
 
+// Returns the value of the two digits at 'ptr', or a value above 99 if one of them isn't
+// a digit.
+static inline uint32_t two_digits(const char* ptr) {
+    uint32_t hi = static_cast<uint8_t>(ptr[0]) - '0';
+    uint32_t lo = static_cast<uint8_t>(ptr[1]) - '0';
+    // a non digit wraps around to a large unsigned value
+    return (hi > 9 || lo > 9) ? 100 : hi * 10 + lo;
+}
+
+bool DateTimeValue::from_iso_date_str(const char* str, int len) {
+    if ((len != 10 && len != 19) || str[4] != '-' || str[7] != '-') {
+        return false;
+    }
+    uint32_t century = two_digits(str);
+    uint32_t year = two_digits(str + 2);
+    uint32_t month = two_digits(str + 5);
+    uint32_t day = two_digits(str + 8);
+    if ((century | year | month | day) > 99) {
+        return false;
+    }
+    uint32_t hour = 0;
+    uint32_t minute = 0;
+    uint32_t second = 0;
+    if (len == 19) {
+        if ((str[10] != ' ' && str[10] != 'T') || str[13] != ':' || str[16] != ':') {
+            return false;
+        }
+        hour = two_digits(str + 11);
+        minute = two_digits(str + 14);
+        second = two_digits(str + 17);
+        if ((hour | minute | second) > 99) {
+            return false;
+        }
+    }
+    _neg = false;
+    _type = (len == 10) ? TIME_DATE : TIME_DATETIME;
+    _year = century * 100 + year;
+    _month = month;
+    _day = day;
+    _hour = hour;
+    _minute = minute;
+    _second = second;
+    _microsecond = 0;
+    return true;
+}
+
 // The interval format is that with no delimiters
 // YYYY-MM-DD HH-MM-DD.FFFFFF AM in default format
 // 0    1  2  3  4  5  6      7
 bool DateTimeValue::from_date_str(const char* date_str, int len) {
+    if (from_iso_date_str(date_str, len)) {
+        return !check_range() && !check_date();
+    }
     const char* ptr = date_str;
     const char* end = date_str + len;
     // ONLY 2, 6 can follow by a sapce
@@ -462,6 +462,11 @@ private:
         _type = TIME_DATETIME;
     }
 
+    // Parses the fixed layouts 'YYYY-MM-DD' and 'YYYY-MM-DD HH:MM:SS' (or with 'T' between
+    // date and time), which are what almost all loaded data looks like. Returns false if
+    // 'str' has another layout, without checking the range of the fields.
+    bool from_iso_date_str(const char* str, int len);
+
     int64_t make_packed_time(int64_t time, int64_t second_part) const {
         return (time << 24) + second_part;
     }
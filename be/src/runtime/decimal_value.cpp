@@ -791,6 +791,121 @@ DecimalValue operator-(const DecimalValue& v) {
     return result;
 }
 
+bool DecimalValue::to_scaled_int128(const palo_udf::DecimalVal& value,
+                                    int32_t max_int_big_digits, __int128* scaled) {
+    const int32_t intg = round_up(static_cast<int32_t>(value.int_len));
+    const int32_t frac = round_up(static_cast<int32_t>(value.frac_len));
+    if (frac > 1) {
+        return false;
+    }
+    int32_t first = 0;
+    while (first < intg && value.buffer[first] == 0) {
+        ++first;
+    }
+    if (intg - first > max_int_big_digits) {
+        return false;
+    }
+    __int128 result = 0;
+    for (int32_t i = first; i < intg + frac; ++i) {
+        result = result * DIG_BASE + value.buffer[i];
+    }
+    if (frac == 0) {
+        result *= DIG_BASE;
+    }
+    *scaled = value.sign ? -result : result;
+    return true;
+}
+
+DecimalValue DecimalValue::from_scaled_int128(__int128 scaled, int32_t frac_length) {
+    DecimalValue result;
+    if (scaled == 0) {
+        return result;
+    }
+    result._sign = scaled < 0;
+    unsigned __int128 value = scaled < 0 ? -static_cast<unsigned __int128>(scaled) : scaled;
+    // least significant "big digit" first, the first one is the fraction
+    int32_t digits[DECIMAL_BUFF_LENGTH];
+    int32_t num_digits = 0;
+    while (value != 0 || num_digits < 1) {
+        digits[num_digits++] = static_cast<int32_t>(value % DIG_BASE);
+        value /= DIG_BASE;
+    }
+    for (int32_t i = 0; i < num_digits; ++i) {
+        result._buffer[i] = digits[num_digits - i - 1];
+    }
+    result._int_length = (num_digits - 1) * DIG_PER_DEC1;
+    result._frac_length = frac_length;
+    return result;
+}
+
+const int32_t DecimalSum::MAX_SCALED_INT_BIG_DIGITS;
+
+// The scaled sum is moved to the DecimalValue once it reaches this, so that adding
+// another scaled value (below 10^27) can not overflow.
+static const __int128 MAX_SCALED_SUM =
+    static_cast<__int128>(1000000000000000000LL) * 10000000000000000000ULL;  // 10^37
+
+void DecimalSum::init() {
+    _scaled[0] = 0;
+    _scaled[1] = 0;
+    _scaled_frac_length = 0;
+    _wide.set_to_zero();
+}
+
+void DecimalSum::add(const palo_udf::DecimalVal& value) {
+    __int128 scaled = 0;
+    if (DecimalValue::to_scaled_int128(value, MAX_SCALED_INT_BIG_DIGITS, &scaled)) {
+        _scaled_frac_length = std::max(_scaled_frac_length,
+                                       static_cast<int32_t>(value.frac_len));
+        add_scaled(scaled);
+    } else {
+        add_wide(DecimalValue::from_decimal_val(value));
+    }
+}
+
+void DecimalSum::subtract(const palo_udf::DecimalVal& value) {
+    __int128 scaled = 0;
+    if (DecimalValue::to_scaled_int128(value, MAX_SCALED_INT_BIG_DIGITS, &scaled)) {
+        _scaled_frac_length = std::max(_scaled_frac_length,
+                                       static_cast<int32_t>(value.frac_len));
+        add_scaled(-scaled);
+    } else {
+        add_wide(-DecimalValue::from_decimal_val(value));
+    }
+}
+
+void DecimalSum::merge(const DecimalSum& other) {
+    __int128 scaled = 0;
+    memcpy(&scaled, other._scaled, sizeof(scaled));
+    _scaled_frac_length = std::max(_scaled_frac_length, other._scaled_frac_length);
+    // the other sum may be too large to add at once
+    add_wide(DecimalValue::from_scaled_int128(scaled, other._scaled_frac_length));
+    add_wide(DecimalValue::from_decimal_val(other._wide));
+}
+
+DecimalValue DecimalSum::value() const {
+    __int128 scaled = 0;
+    memcpy(&scaled, _scaled, sizeof(scaled));
+    return DecimalValue::from_decimal_val(_wide)
+        + DecimalValue::from_scaled_int128(scaled, _scaled_frac_length);
+}
+
+void DecimalSum::add_scaled(__int128 scaled) {
+    __int128 sum = 0;
+    memcpy(&sum, _scaled, sizeof(sum));
+    if (sum >= MAX_SCALED_SUM || sum <= -MAX_SCALED_SUM) {
+        add_wide(DecimalValue::from_scaled_int128(sum, _scaled_frac_length));
+        sum = 0;
+    }
+    sum += scaled;
+    memcpy(_scaled, &sum, sizeof(sum));
+}
+
+void DecimalSum::add_wide(const DecimalValue& value) {
+    DecimalValue sum = DecimalValue::from_decimal_val(_wide) + value;
+    sum.to_decimal_val(&_wide);
+}
+
 DecimalValue& DecimalValue::operator+=(const DecimalValue& other) {
     *this = *this + other;
     return *this;
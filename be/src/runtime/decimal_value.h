@@ -429,6 +429,23 @@ public:
         return hash_uint(_sign, seed);
     }
 
+    // Same as hash() with HashUtil::fast_hash64(), which doesn't depend on the host
+    uint64_t fast_hash64(uint64_t seed) const {
+        int int_len = round_up(_int_length);
+        int frac_len = round_up(_frac_length);
+        int begin = 0;
+        while (begin < int_len && _buffer[begin] == 0) {
+            begin++;
+        }
+        int end = int_len + frac_len;
+        while (end > int_len && _buffer[end - 1] == 0) {
+            end--;
+        }
+        seed = HashUtil::fast_hash64(&_buffer[begin], (end - begin) * sizeof(_buffer[0]), seed);
+        uint8_t sign = _sign;
+        return HashUtil::fast_hash64(&sign, sizeof(sign), seed);
+    }
+
     int32_t precision() const {
         return _int_length + _frac_length;
     }
@@ -439,6 +456,16 @@ public:
 
     int round(DecimalValue *to, int scale, DecimalRoundMode mode);
 
+    // Returns the value of 'value' scaled by DIG_BASE (i.e. with nine fraction digits),
+    // or false if it has more fraction digits or more than 'max_int_big_digits'
+    // non-zero integer "big digits".
+    static bool to_scaled_int128(const palo_udf::DecimalVal& value,
+                                 int32_t max_int_big_digits, __int128* scaled);
+
+    // Reverse of to_scaled_int128(). 'frac_length' is the number of decimal digits of
+    // the fraction part, at most DIG_PER_DEC1.
+    static DecimalValue from_scaled_int128(__int128 scaled, int32_t frac_length);
+
     // For C++/IR interop, we need to be able to look up types by name.
     static const char* _s_llvm_class_name;
 
@@ -491,6 +518,43 @@ DecimalValue operator*(const DecimalValue& v1, const DecimalValue& v2);
 DecimalValue operator/(const DecimalValue& v1, const DecimalValue& v2);
 DecimalValue operator%(const DecimalValue& v1, const DecimalValue& v2);
 
+// Running sum of decimals for SUM() and AVG(). Values with at most nine fraction digits
+// and up to 10^18 in the integer part, which covers all decimals of the storage engine,
+// are added as one scaled __int128 (see DecimalValue::to_scaled_int128()) instead of
+// "big digit" by "big digit". Other values, and the scaled sum whenever it grows too
+// large for the next addition, are added to a DecimalValue.
+//
+// Plain data, so that it can be copied as the intermediate value of an aggregate.
+class DecimalSum {
+public:
+    void init();
+
+    void add(const palo_udf::DecimalVal& value);
+
+    void subtract(const palo_udf::DecimalVal& value);
+
+    void merge(const DecimalSum& other);
+
+    DecimalValue value() const;
+
+private:
+    // Max number of integer "big digits" of a value added to the scaled sum; such a
+    // value is below 10^27 when scaled.
+    static const int32_t MAX_SCALED_INT_BIG_DIGITS = 2;
+
+    // Adds 'scaled' to the scaled sum, moving the sum to _wide first if it's too large.
+    void add_scaled(__int128 scaled);
+
+    void add_wide(const DecimalValue& value);
+
+    // The scaled sum, stored as two words because the intermediate value is not aligned
+    // for __int128 loads.
+    uint64_t _scaled[2];
+    // Max fraction length of the values in the scaled sum
+    int32_t _scaled_frac_length;
+    palo_udf::DecimalVal _wide;
+};
+
 DecimalValue operator-(const DecimalValue& v);
 
 std::ostream& operator<<(std::ostream& os, DecimalValue const& decimal_value);
@@ -21,7 +21,13 @@
 #include "runtime/disk_io_mgr.h"
 #include "runtime/disk_io_mgr_internal.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <boost/algorithm/string.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "util/stopwatch.hpp"
 
 using std::string;
 using std::stringstream;
@@ -67,6 +73,10 @@ namespace palo {
 static const int THREADS_PER_ROTATIONAL_DISK = 1;
 static const int THREADS_PER_FLASH_DISK = 8;
 
+// Virtual time a request of an IO class with share 1 costs in the weighted fair queuing
+// of a disk.
+static const int64_t VTIME_STRIDE = 1 << 16;
+
 // The IoMgr is able to run with a wide range of memory usage. If a query has memory
 // remaining less than this value, the IoMgr will stop all buffering regardless of the
 // current queue size.
@@ -327,6 +337,17 @@ DiskIoMgr::~DiskIoMgr() {
     }
     _disk_thread_group.join_all();
 
+    // Nothing is submitted anymore, the completion threads exit once they finished the
+    // requests in flight.
+    for (int i = 0; i < _disk_queues.size(); ++i) {
+        if (_disk_queues[i] == NULL || _disk_queues[i]->uring == NULL) {
+            continue;
+        }
+        Status status = _disk_queues[i]->uring->submit_nop(NULL);
+        CHECK(status.ok()) << status.get_error_msg();
+    }
+    _completion_thread_group.join_all();
+
     for (int i = 0; i < _disk_queues.size(); ++i) {
         if (_disk_queues[i] == NULL) {
             continue;
@@ -380,6 +401,11 @@ Status DiskIoMgr::init(MemTracker* process_mem_tracker) {
         if (i >= num_local_disks()) {
             // remote disks, do nothing
             continue;
+        } else if (init_uring(_disk_queues[i])) {
+            // The ring provides the queue depth, one thread submits and one reaps.
+            num_threads_per_disk = 1;
+            _completion_thread_group.add_thread(new boost::thread(
+                    boost::bind(&DiskIoMgr::completion_loop, this, _disk_queues[i])));
         } else if (_num_threads_per_disk != 0) {
             num_threads_per_disk = _num_threads_per_disk;
         } else if (DiskInfo::is_rotational(i)) {
@@ -481,6 +507,10 @@ void DiskIoMgr::set_disks_access_bitmap(RequestContext* r,
     r->_disks_accessed_bitmap = c;
 }
 
+void DiskIoMgr::set_io_class(RequestContext* r, IoClass io_class) {
+    r->_io_class = io_class;
+}
+
 int64_t DiskIoMgr::queue_size(RequestContext* reader) const {
     return reader->_num_ready_buffers;
 }
@@ -812,6 +842,44 @@ void DiskIoMgr::return_free_buffer(char* buffer, int64_t buffer_size) {
 // Work is available if there is a RequestContext with
 //  - A ScanRange with a buffer available, or
 //  - A WriteRange in _unstarted_write_ranges.
+DiskIoMgr::RequestContext* DiskIoMgr::DiskQueue::dequeue_context(int64_t* wait_us) {
+    DCHECK(!request_contexts.empty());
+    *wait_us = 0;
+    int next_class = -1;
+    for (int i = 0; i < NUM_IO_CLASSES; ++i) {
+        if (num_class_contexts[i] == 0) {
+            continue;
+        }
+        int64_t class_wait_us = IoThrottle::wait_time_us(static_cast<IoClass>(i));
+        if (class_wait_us > 0) {
+            *wait_us = *wait_us == 0 ? class_wait_us : std::min(*wait_us, class_wait_us);
+            continue;
+        }
+        if (next_class < 0 || class_vtime[i] < class_vtime[next_class]) {
+            next_class = i;
+        }
+    }
+    if (next_class < 0) {
+        DCHECK_GT(*wait_us, 0);
+        return NULL;
+    }
+
+    RequestContext* context = NULL;
+    for (list<RequestContext*>::iterator it = request_contexts.begin();
+            it != request_contexts.end(); ++it) {
+        if ((*it)->_io_class == next_class) {
+            context = *it;
+            request_contexts.erase(it);
+            break;
+        }
+    }
+    DCHECK(context != NULL);
+    --num_class_contexts[next_class];
+    vtime = class_vtime[next_class];
+    class_vtime[next_class] += VTIME_STRIDE / io_class_share(static_cast<IoClass>(next_class));
+    return context;
+}
+
 bool DiskIoMgr::get_next_request_range(DiskQueue* disk_queue, RequestRange** range,
         RequestContext** request_context) {
     int disk_id = disk_queue->disk_id;
@@ -838,9 +906,14 @@ bool DiskIoMgr::get_next_request_range(DiskQueue* disk_queue, RequestRange** ran
             // so this is not a big deal (i.e. multiple disk threads can read for the
             // same reader).
             // TODO: revisit.
-            *request_context = disk_queue->request_contexts.front();
-            disk_queue->request_contexts.pop_front();
-            DCHECK(*request_context != NULL);
+            int64_t wait_us = 0;
+            *request_context = disk_queue->dequeue_context(&wait_us);
+            if (*request_context == NULL) {
+                // Everything queued is over its rate cap.
+                disk_queue->work_available.timed_wait(
+                        disk_lock, boost::posix_time::microseconds(wait_us));
+                continue;
+            }
             request_disk_state = &((*request_context)->_disk_states[disk_id]);
             request_disk_state->increment_request_thread_and_dequeue();
         }
@@ -920,6 +993,15 @@ bool DiskIoMgr::get_next_request_range(DiskQueue* disk_queue, RequestRange** ran
         *range = request_disk_state->in_flight_ranges()->dequeue();
         DCHECK(*range != NULL);
 
+        if ((*range)->request_type() == RequestType::READ) {
+            ScanRange* scan_range = static_cast<ScanRange*>(*range);
+            IoThrottle::charge((*request_context)->_io_class,
+                    std::min(static_cast<int64_t>(_max_buffer_size),
+                        scan_range->_len - scan_range->_bytes_read));
+        } else {
+            IoThrottle::charge((*request_context)->_io_class, (*range)->len());
+        }
+
         // Now that we've picked a request range, put the context back on the queue so
         // another thread can pick up another request range for this context.
         request_disk_state->schedule_context(*request_context, disk_id);
@@ -1028,6 +1110,16 @@ void DiskIoMgr::work_loop(DiskQueue* disk_queue) {
         RequestContext* worker_context = NULL;;
         RequestRange* range = NULL;
 
+        if (disk_queue->uring != NULL) {
+            // Don't take a range before the ring has room for it. Requests in flight
+            // always complete, so this doesn't block shut down.
+            unique_lock<mutex> uring_lock(disk_queue->uring_lock);
+            while (disk_queue->num_in_flight
+                    >= static_cast<int>(disk_queue->uring->queue_depth())) {
+                disk_queue->uring_slot_available.wait(uring_lock);
+            }
+        }
+
         if (!get_next_request_range(disk_queue, &range, &worker_context)) {
             DCHECK(_shut_down);
             break;
@@ -1035,6 +1127,9 @@ void DiskIoMgr::work_loop(DiskQueue* disk_queue) {
 
         if (range->request_type() == RequestType::READ) {
             read_range(disk_queue, worker_context, static_cast<ScanRange*>(range));
+        } else if (disk_queue->uring != NULL) {
+            DCHECK(range->request_type() == RequestType::WRITE);
+            submit_write(disk_queue, worker_context, static_cast<WriteRange*>(range));
         } else {
             DCHECK(range->request_type() == RequestType::WRITE);
             write(worker_context, static_cast<WriteRange*>(range));
@@ -1103,7 +1198,17 @@ void DiskIoMgr::read_range(DiskQueue* disk_queue, RequestContext* reader, ScanRa
     // No locks in this section.  Only working on local vars.  We don't want to hold a
     // lock across the read call.
     buffer_desc->_status = range->open();
-    if (buffer_desc->_status.ok()) {
+    if (buffer_desc->_status.ok() && disk_queue->uring != NULL) {
+        if (reader->_disks_accessed_bitmap) {
+            int64_t disk_bit = 1 << disk_queue->disk_id;
+            reader->_disks_accessed_bitmap->bit_or(disk_bit);
+        }
+        buffer_desc->_status = submit_read(disk_queue, reader, range, buffer_desc);
+        if (buffer_desc->_status.ok()) {
+            // The completion thread finishes the read.
+            return;
+        }
+    } else if (buffer_desc->_status.ok()) {
         // Update counters.
         if (reader->_active_read_thread_counter) {
             reader->_active_read_thread_counter->update(1L);
@@ -1154,6 +1259,232 @@ void DiskIoMgr::write(RequestContext* writer_context, WriteRange* write_range) {
     handle_write_finished(writer_context, write_range, ret_status);
 }
 
+// A read or write in flight on the io_uring of a disk.
+struct DiskIoMgr::AsyncRequest {
+    RequestContext* context;
+
+    // Set for reads.
+    ScanRange* scan_range;
+    BufferDescriptor* buffer_desc;
+
+    // Set for writes.
+    WriteRange* write_range;
+
+    // Descriptor owned by the request. Reads use a duplicate of the descriptor of the
+    // scan range, so that closing a cancelled range while its read is in flight can't
+    // hand the descriptor to another file.
+    int fd;
+    int64_t offset;
+    int64_t len;
+
+    MonotonicStopWatch watch;
+
+    AsyncRequest(RequestContext* context_, int fd_, int64_t offset_, int64_t len_) :
+            context(context_), scan_range(NULL), buffer_desc(NULL), write_range(NULL),
+            fd(fd_), offset(offset_), len(len_) {
+        watch.start();
+    }
+};
+
+bool DiskIoMgr::init_uring(DiskQueue* disk_queue) {
+    if (config::disk_io_uring_queue_depth <= 0) {
+        return false;
+    }
+    boost::scoped_ptr<IoUring> uring(new IoUring());
+    Status status = uring->init(config::disk_io_uring_queue_depth);
+    if (!status.ok()) {
+        LOG(WARNING) << "disk " << disk_queue->disk_id << " falls back to blocking IO: "
+                << status.get_error_msg();
+        return false;
+    }
+    disk_queue->uring.swap(uring);
+    return true;
+}
+
+Status DiskIoMgr::submit_read(DiskQueue* disk_queue, RequestContext* reader,
+        ScanRange* range, BufferDescriptor* buffer_desc) {
+    int fd = -1;
+    int64_t offset = 0;
+    {
+        unique_lock<mutex> hdfs_lock(range->_hdfs_lock);
+        if (range->_is_cancelled) {
+            return Status::CANCELLED;
+        }
+        DCHECK(range->_local_file != NULL);
+        fd = dup(fileno(range->_local_file));
+        offset = range->_offset + range->_bytes_read;
+    }
+    if (fd < 0) {
+        stringstream error_msg;
+        error_msg << "dup() of the descriptor of " << range->_file
+                << " failed with errno=" << errno << " description=" << get_str_err_msg();
+        return Status(error_msg.str());
+    }
+    int64_t len = std::min(static_cast<int64_t>(_max_buffer_size),
+            range->_len - range->_bytes_read);
+    DCHECK_LE(len, buffer_desc->_buffer_len);
+    AsyncRequest* request = new AsyncRequest(reader, fd, offset, len);
+    request->scan_range = range;
+    request->buffer_desc = buffer_desc;
+    {
+        lock_guard<mutex> uring_lock(disk_queue->uring_lock);
+        ++disk_queue->num_in_flight;
+    }
+    Status status = disk_queue->uring->submit_read(fd, buffer_desc->_buffer, len, offset,
+            request);
+    if (!status.ok()) {
+        {
+            lock_guard<mutex> uring_lock(disk_queue->uring_lock);
+            --disk_queue->num_in_flight;
+        }
+        close(fd);
+        delete request;
+    }
+    return status;
+}
+
+void DiskIoMgr::submit_write(DiskQueue* disk_queue, RequestContext* writer_context,
+        WriteRange* write_range) {
+    int fd = open(write_range->file(), O_WRONLY);
+    if (fd < 0) {
+        stringstream error_msg;
+        error_msg << "open(" << write_range->_file << ", O_WRONLY) failed with errno="
+                << errno << " description=" << get_str_err_msg();
+        handle_write_finished(writer_context, write_range, Status(error_msg.str()));
+        return;
+    }
+    AsyncRequest* request = new AsyncRequest(writer_context, fd, write_range->offset(),
+            write_range->_len);
+    request->write_range = write_range;
+    {
+        lock_guard<mutex> uring_lock(disk_queue->uring_lock);
+        ++disk_queue->num_in_flight;
+    }
+    Status status = disk_queue->uring->submit_write(fd, write_range->_data,
+            write_range->_len, write_range->offset(), request);
+    if (!status.ok()) {
+        {
+            lock_guard<mutex> uring_lock(disk_queue->uring_lock);
+            --disk_queue->num_in_flight;
+        }
+        close(fd);
+        delete request;
+        handle_write_finished(writer_context, write_range, status);
+    }
+}
+
+void DiskIoMgr::completion_loop(DiskQueue* disk_queue) {
+    bool shutting_down = false;
+    while (true) {
+        void* user_data = NULL;
+        int result = 0;
+        Status status = disk_queue->uring->wait_completion(&user_data, &result);
+        // The requests in flight would never finish.
+        CHECK(status.ok()) << "disk " << disk_queue->disk_id << ": "
+                << status.get_error_msg();
+
+        AsyncRequest* request = static_cast<AsyncRequest*>(user_data);
+        if (request == NULL) {
+            // Posted by the destructor after the worker threads exited.
+            shutting_down = true;
+        } else if (request->write_range != NULL) {
+            finish_async_write(request, result);
+        } else {
+            finish_async_read(disk_queue, request, result);
+        }
+        {
+            lock_guard<mutex> uring_lock(disk_queue->uring_lock);
+            if (request != NULL) {
+                --disk_queue->num_in_flight;
+                delete request;
+            }
+            if (shutting_down && disk_queue->num_in_flight == 0) {
+                break;
+            }
+        }
+        disk_queue->uring_slot_available.notify_all();
+    }
+}
+
+void DiskIoMgr::finish_async_read(DiskQueue* disk_queue, AsyncRequest* request,
+        int result) {
+    close(request->fd);
+    RequestContext* reader = request->context;
+    ScanRange* range = request->scan_range;
+    BufferDescriptor* buffer_desc = request->buffer_desc;
+
+    int64_t elapsed = request->watch.elapsed_time();
+    _read_timer.update(elapsed);
+    if (reader->_read_timer != NULL) {
+        reader->_read_timer->update(elapsed);
+    }
+
+    if (result < 0) {
+        errno = -result;
+        stringstream error_msg;
+        error_msg << "Error reading from " << range->_file << " at byte offset: "
+                << request->offset << ": " << get_str_err_msg();
+        buffer_desc->_status = Status(error_msg.str());
+    } else {
+        buffer_desc->_len = result;
+        {
+            unique_lock<mutex> hdfs_lock(range->_hdfs_lock);
+            range->_bytes_read += result;
+            DCHECK_LE(range->_bytes_read, range->_len);
+            // A short read means the file ends before the scan range.
+            buffer_desc->_eosr = result < request->len || range->_bytes_read == range->_len;
+            buffer_desc->_scan_range_offset = range->_bytes_read - result;
+        }
+        if (reader->_bytes_read_counter != NULL) {
+            COUNTER_UPDATE(reader->_bytes_read_counter, buffer_desc->_len);
+        }
+        COUNTER_UPDATE(&_total_bytes_read_counter, buffer_desc->_len);
+    }
+
+    handle_read_finished(disk_queue, reader, buffer_desc);
+}
+
+void DiskIoMgr::finish_async_write(AsyncRequest* request, int result) {
+    WriteRange* write_range = request->write_range;
+    Status status;
+    if (result < 0) {
+        errno = -result;
+        stringstream error_msg;
+        error_msg << "write(" << write_range->_file << ", " << write_range->offset()
+                << ") failed with errno=" << -result << " description=" << get_str_err_msg();
+        status = Status(error_msg.str());
+    } else {
+        // Short writes are rare, finish them here.
+        int64_t bytes_written = result;
+        while (bytes_written < write_range->_len) {
+            ssize_t ret = pwrite(request->fd, write_range->_data + bytes_written,
+                    write_range->_len - bytes_written, write_range->offset() + bytes_written);
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ret <= 0) {
+                stringstream error_msg;
+                error_msg << "pwrite(" << write_range->_file << ", "
+                        << write_range->offset() + bytes_written << ") failed with errno="
+                        << errno << " description=" << get_str_err_msg();
+                status = Status(error_msg.str());
+                break;
+            }
+            bytes_written += ret;
+        }
+        if (status.ok() && PaloMetrics::io_mgr_bytes_written() != NULL) {
+            PaloMetrics::io_mgr_bytes_written()->increment(write_range->_len);
+        }
+    }
+    if (close(request->fd) != 0 && status.ok()) {
+        stringstream error_msg;
+        error_msg << "close(" << write_range->_file << ") failed";
+        status = Status(error_msg.str());
+    }
+
+    handle_write_finished(request->context, write_range, status);
+}
+
 Status DiskIoMgr::write_range_helper(FILE* file_handle, WriteRange* write_range) {
     // Seek to the correct offset and perform the write.
     int success = fseek(file_handle, write_range->offset(), SEEK_SET);
@@ -38,6 +38,7 @@
 #include "common/status.h"
 #include "util/error_util.h"
 #include "util/internal_queue.h"
+#include "util/io_throttle.h"
 #include "util/palo_metrics.h"
 #include "util/runtime_profile.h"
 #include "runtime/mem_tracker.h"
@@ -632,6 +633,10 @@ public:
     void set_active_read_thread_counter(RequestContext*, RuntimeProfile::Counter*);
     void set_disks_access_bitmap(RequestContext*, RuntimeProfile::Counter*);
 
+    // Sets the IO class of the context, IO_CLASS_QUERY by default. Must be called
+    // before ranges are added.
+    void set_io_class(RequestContext*, IoClass);
+
     int64_t queue_size(RequestContext* reader) const;
     int64_t bytes_read_local(RequestContext* reader) const;
     int64_t bytes_read_short_circuit(RequestContext* reader) const;
@@ -724,6 +729,10 @@ private:
     // ThreadGroup _disk_thread_group;
     boost::thread_group _disk_thread_group;
 
+    // Threads reaping the completions of the disks that do IO through io_uring, one per
+    // disk. They are stopped after the worker threads.
+    boost::thread_group _completion_thread_group;
+
     // Options object for cached hdfs reads. Set on startup and never modified.
     struct hadoopRzOptions* _cached_read_options;
 
@@ -858,6 +867,33 @@ private:
     // Reads the specified scan range and calls handle_read_finished when done.
     void read_range(DiskQueue* disk_queue, RequestContext* reader,
             ScanRange* range);
+
+    // A read or write in flight on the io_uring of a disk.
+    struct AsyncRequest;
+
+    // Sets up the io_uring of a local disk if config::disk_io_uring_queue_depth is set.
+    // Returns false if the disk has to use blocking IO.
+    bool init_uring(DiskQueue* disk_queue);
+
+    // Submits the next read of 'range' into 'buffer_desc' to the io_uring of the disk.
+    // handle_read_finished() is called by the completion thread if this returns OK.
+    Status submit_read(DiskQueue* disk_queue, RequestContext* reader, ScanRange* range,
+            BufferDescriptor* buffer_desc);
+
+    // Submits 'write_range' to the io_uring of the disk. handle_write_finished() is
+    // called when the write completes or fails.
+    void submit_write(DiskQueue* disk_queue, RequestContext* writer_context,
+            WriteRange* write_range);
+
+    // Completion thread loop of a disk using io_uring. Hands the buffers of finished
+    // reads to their scan ranges and invokes the callbacks of finished writes. Exits
+    // when the IoMgr shuts down and no request is in flight anymore.
+    void completion_loop(DiskQueue* disk_queue);
+
+    // Finishes a request reaped by completion_loop(). 'result' is the number of bytes
+    // transferred or -errno.
+    void finish_async_read(DiskQueue* disk_queue, AsyncRequest* request, int result);
+    void finish_async_write(AsyncRequest* request, int result);
 };
 
 } // end namespace palo
@@ -33,6 +33,7 @@
 #include "util/debug_util.h"
 #include "util/disk_info.h"
 #include "util/filesystem_util.h"
+#include "util/io_uring.h"
 
 // This file contains internal structures to the IoMgr. Users of the IoMgr do
 // not need to include this file.
@@ -55,19 +56,46 @@ struct DiskIoMgr::DiskQueue {
     // list of all request contexts that have work queued on this disk
     std::list<RequestContext*> request_contexts;
 
+    // Number of contexts of each IO class in 'request_contexts'.
+    int num_class_contexts[NUM_IO_CLASSES];
+
+    // Weighted fair queuing of the IO classes: the class with work and the lowest
+    // virtual time is served next, and serving a request advances the virtual time of
+    // its class by VTIME_STRIDE / share. Contexts of the same class are served round
+    // robin. A class that had no work starts at 'vtime', the virtual time of the last
+    // served class, so that it can't bank credit while idle.
+    int64_t class_vtime[NUM_IO_CLASSES];
+    int64_t vtime;
+
     // Enqueue the request context to the disk queue.  The DiskQueue lock must not be taken.
-    inline void enqueue_context(RequestContext* worker) {
-        {
-            boost::unique_lock<boost::mutex> disk_lock(lock);
-            // Check that the reader is not already on the queue
-            DCHECK(find(request_contexts.begin(), request_contexts.end(), worker) ==
-                    request_contexts.end());
-            request_contexts.push_back(worker);
+    inline void enqueue_context(RequestContext* worker);
+
+    // Removes and returns the context to serve next. Returns NULL if all classes with
+    // work are held back by their rate cap, and sets 'wait_us' to the time until the
+    // first of them may issue IO again. Called with 'lock' held and 'request_contexts'
+    // not empty.
+    RequestContext* dequeue_context(int64_t* wait_us);
+
+    // Set if the disk does its IO through io_uring. The worker thread then only
+    // submits requests, up to the depth of the ring, and a completion thread finishes
+    // them. NULL if the worker threads do blocking IO.
+    boost::scoped_ptr<IoUring> uring;
+
+    // Protects 'num_in_flight'.
+    boost::mutex uring_lock;
+
+    // Signalled when a request on 'uring' completes.
+    boost::condition_variable uring_slot_available;
+
+    // Number of requests submitted to 'uring' that haven't been finished.
+    int num_in_flight;
+
+    DiskQueue(int id) : disk_id(id), vtime(0), num_in_flight(0) {
+        for (int i = 0; i < NUM_IO_CLASSES; ++i) {
+            num_class_contexts[i] = 0;
+            class_vtime[i] = 0;
         }
-        work_available.notify_all();
     }
-
-    DiskQueue(int id) : disk_id(id) { }
 };
 
 // Internal per request-context state. This object maintains a lot of state that is
@@ -216,6 +244,9 @@ private:
     // builtin atomic instruction. Probably good enough for now.
     RuntimeProfile::Counter* _disks_accessed_bitmap;
 
+    // The IO class the requests of this context are scheduled and rate capped as.
+    IoClass _io_class;
+
     // Total number of bytes read locally, updated at end of each range scan
     AtomicInt<int64_t> _bytes_read_local;
 
@@ -469,6 +500,21 @@ private:
     std::vector<PerDiskState> _disk_states;
 };
 
+inline void DiskIoMgr::DiskQueue::enqueue_context(RequestContext* worker) {
+    {
+        boost::unique_lock<boost::mutex> disk_lock(lock);
+        // Check that the reader is not already on the queue
+        DCHECK(find(request_contexts.begin(), request_contexts.end(), worker) ==
+                request_contexts.end());
+        request_contexts.push_back(worker);
+        IoClass io_class = worker->_io_class;
+        if (num_class_contexts[io_class]++ == 0) {
+            class_vtime[io_class] = std::max(class_vtime[io_class], vtime);
+        }
+    }
+    work_available.notify_all();
+}
+
 } // namespace palo
 
 #endif // BDG_PALO_BE_SRC_QUERY_RUNTIME_DISK_IO_MGR_INTERNAL_H
@@ -164,6 +164,7 @@ void DiskIoMgr::RequestContext::reset(MemTracker* tracker) {
     _read_timer = NULL;
     _active_read_thread_counter = NULL;
     _disks_accessed_bitmap = NULL;
+    _io_class = IO_CLASS_QUERY;
 
     _state = Active;
     _mem_tracker = tracker;
@@ -41,22 +41,33 @@
 #include "http/default_path_handlers.h"
 #include "util/parse_util.h"
 #include "util/mem_info.h"
+#include "util/numa_info.h"
 #include "util/debug_util.h"
 #include "http/action/mini_load.h"
 #include "http/action/checksum_action.h"
 #include "http/action/health_action.h"
+#include "http/action/lookup_action.h"
+#include "http/action/metrics_action.h"
+#include "http/action/compaction_action.h"
+#include "http/action/tablet_stats_action.h"
 #include "http/action/reload_tablet_action.h"
 #include "http/action/snapshot_action.h"
 #include "http/action/pprof_actions.h"
+#include "http/action/query_trace_action.h"
 #include "http/download_action.h"
 #include "http/monitor_action.h"
 #include "http/http_method.h"
+#include "olap/cache_manager.h"
 #include "olap/olap_rootpath.h"
 #include "util/network_util.h"
 #include "util/bfd_parser.h"
 #include "runtime/etl_job_mgr.h"
 #include "runtime/load_path_mgr.h"
 #include "runtime/pull_load_task_mgr.h"
+#include "runtime/shared_hash_table_mgr.h"
+#include "runtime/result_cache.h"
+#include "runtime/fragment_template_cache.h"
+#include "runtime/stream_load_pipe.h"
 #include "gen_cpp/BackendService.h"
 #include "gen_cpp/FrontendService.h"
 #include "gen_cpp/TPaloBrokerService.h"
@@ -80,10 +91,13 @@ ExecEnv::ExecEnv() :
         _thread_mgr(new ThreadResourceMgr),
         _thread_pool(new PriorityThreadPool(
                 config::palo_scanner_thread_pool_thread_num,
-                config::palo_scanner_thread_pool_queue_size)),
+                config::palo_scanner_thread_pool_queue_size,
+                NumaInfo::enabled() ? NumaInfo::num_nodes() : 1,
+                "scanner")),
         _etl_thread_pool(new ThreadPool(
                 config::etl_thread_pool_size,
-                config::etl_thread_pool_queue_size)),
+                config::etl_thread_pool_queue_size,
+                "etl")),
         _cgroups_mgr(new CgroupsMgr(this, config::palo_cgroups)),
         _fragment_mgr(new FragmentMgr(this)),
         _master_info(new TMasterInfo()),
@@ -94,10 +108,18 @@ ExecEnv::ExecEnv() :
         _bfd_parser(BfdParser::create()),
         _pull_load_task_mgr(new PullLoadTaskMgr(config::pull_load_task_dir)),
         _broker_mgr(new BrokerMgr(this)),
+        _shared_hash_table_mgr(new SharedHashTableMgr()),
+        _result_cache(new ResultCache(config::result_cache_capacity_bytes)),
+        _partial_agg_cache(new PartialAggCache(config::partial_agg_cache_capacity_bytes)),
+        _fragment_template_cache(
+                new FragmentTemplateCache(config::fragment_template_cache_capacity_bytes)),
+        _stream_load_pipe_mgr(new StreamLoadPipeMgr()),
         _enable_webserver(true),
         _tz_database(TimezoneDatabase()) {
     _client_cache->init_metrics(_metrics.get(), "palo.backends");
-    //_frontend_client_cache->init_metrics(_metrics.get(), "frontend-server.backends");
+    _thread_pool->set_group_weights(config::palo_scanner_thread_pool_group_weights);
+    _frontend_client_cache->init_metrics(_metrics.get(), "palo.frontends");
+    _broker_client_cache->init_metrics(_metrics.get(), "palo.brokers");
     _result_mgr->init();
     _cgroups_mgr->init_cgroups();
     _etl_job_mgr->init();
@@ -165,6 +187,7 @@ Status ExecEnv::start_services() {
 
     _metrics->init(_enable_webserver ? _web_page_handler.get() : NULL);
     RETURN_IF_ERROR(_tmp_file_mgr->init(_metrics.get()));
+    CacheManager::get_instance()->start(_metrics.get(), _mem_tracker.get());
 
     return Status::OK;
 }
@@ -201,12 +224,21 @@ Status ExecEnv::start_webserver() {
     MonitorAction* monitor_action = new MonitorAction();
     monitor_action->register_module("etl_mgr", etl_job_mgr());
     monitor_action->register_module("fragment_mgr", fragment_mgr());
+    monitor_action->register_module("cache_mgr", CacheManager::get_instance());
     _webserver->register_handler(HttpMethod::GET, "/_monitor/{module}", monitor_action);
 
     // Register BE health action
     HealthAction* health_action = new HealthAction(this);
     _webserver->register_handler(HttpMethod::GET, "/api/health", health_action);
 
+    // Register metrics in the Prometheus format
+    MetricsAction* metrics_action = new MetricsAction(_metrics.get());
+    _webserver->register_handler(HttpMethod::GET, "/metrics/prometheus", metrics_action);
+
+    // Register the timeline of traced queries
+    QueryTraceAction* query_trace_action = new QueryTraceAction();
+    _webserver->register_handler(HttpMethod::GET, "/api/query_trace", query_trace_action);
+
     // register pprof actions
     PprofActions::setup(this, _webserver.get());
 
@@ -222,6 +254,18 @@ Status ExecEnv::start_webserver() {
     // Register BE snapshot action
     SnapshotAction* snapshot_action = new SnapshotAction(this);
     _webserver->register_handler(HttpMethod::GET, "/api/snapshot", snapshot_action);
+
+    // Register BE compaction status action
+    CompactionAction* compaction_action = new CompactionAction(this);
+    _webserver->register_handler(HttpMethod::GET, "/api/compaction", compaction_action);
+
+    // Register BE tablet access stats action
+    TabletStatsAction* tablet_stats_action = new TabletStatsAction(this);
+    _webserver->register_handler(HttpMethod::GET, "/api/tablet_stats", tablet_stats_action);
+
+    // Register BE primary key lookup action
+    LookupAction* lookup_action = new LookupAction(this);
+    _webserver->register_handler(HttpMethod::POST, "/api/lookup", lookup_action);
 #endif
 
     RETURN_IF_ERROR(_webserver->start());
@@ -56,6 +56,11 @@ class TmpFileMgr;
 class BfdParser;
 class PullLoadTaskMgr;
 class BrokerMgr;
+class SharedHashTableMgr;
+class ResultCache;
+class PartialAggCache;
+class FragmentTemplateCache;
+class StreamLoadPipeMgr;
 
 // Execution environment for queries/plan fragments.
 // Contains all required global structures, and handles to
@@ -151,6 +156,26 @@ public:
         return _broker_mgr.get();
     }
 
+    SharedHashTableMgr* shared_hash_table_mgr() const {
+        return _shared_hash_table_mgr.get();
+    }
+
+    ResultCache* result_cache() const {
+        return _result_cache.get();
+    }
+
+    PartialAggCache* partial_agg_cache() const {
+        return _partial_agg_cache.get();
+    }
+
+    FragmentTemplateCache* fragment_template_cache() const {
+        return _fragment_template_cache.get();
+    }
+
+    StreamLoadPipeMgr* stream_load_pipe_mgr() const {
+        return _stream_load_pipe_mgr.get();
+    }
+
     ConnectionManagerPtr get_conn_manager() {
         return _conn_mgr;
     }
@@ -192,6 +217,11 @@ private:
     std::unique_ptr<BfdParser> _bfd_parser;
     std::unique_ptr<PullLoadTaskMgr> _pull_load_task_mgr;
     std::unique_ptr<BrokerMgr> _broker_mgr;
+    std::unique_ptr<SharedHashTableMgr> _shared_hash_table_mgr;
+    std::unique_ptr<ResultCache> _result_cache;
+    std::unique_ptr<PartialAggCache> _partial_agg_cache;
+    std::unique_ptr<FragmentTemplateCache> _fragment_template_cache;
+    std::unique_ptr<StreamLoadPipeMgr> _stream_load_pipe_mgr;
     bool _enable_webserver;
 
     /*
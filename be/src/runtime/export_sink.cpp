@@ -14,30 +14,74 @@
 // under the License.
 
 #include "runtime/export_sink.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
 #include <sstream>
 
+#include "common/config.h"
 #include "exprs/expr.h"
 #include "runtime/runtime_state.h"
 #include "runtime/mysql_table_sink.h"
 #include "runtime/mem_tracker.h"
+#include "runtime/large_int_value.h"
 #include "runtime/tuple_row.h"
 #include "util/runtime_profile.h"
 #include "util/debug_util.h"
+#include "exec/async_file_writer.h"
 #include "exec/local_file_writer.h"
 #include "exec/broker_writer.h"
 #include <thrift/protocol/TDebugProtocol.h>
 
 namespace palo {
 
+static void append_int(int64_t value, std::string* out) {
+    char buf[24];
+    char* end = buf + sizeof(buf);
+    char* d = end;
+    uint64_t tmp = value < 0 ? -static_cast<uint64_t>(value) : value;
+    do {
+        *--d = '0' + tmp % 10;
+        tmp /= 10;
+    } while (tmp != 0);
+    if (value < 0) {
+        *--d = '-';
+    }
+    out->append(d, end - d);
+}
+
+// Appends the value of 'ctx' for every row of 'batch' to 'data' and its end to 'ends',
+// 'append' formats the non-null values.
+template<typename AppendFunc>
+static void format_values(ExprContext* ctx, RowBatch* batch, AppendFunc append,
+                          std::string* data, std::vector<size_t>* ends) {
+    int num_rows = batch->num_rows();
+    for (int i = 0; i < num_rows; ++i) {
+        void* item = ctx->get_value(batch->get_row(i));
+        if (item == nullptr) {
+            data->append("NULL", 4);
+        } else {
+            append(item, data);
+        }
+        (*ends)[i] = data->size();
+    }
+}
+
 ExportSink::ExportSink(ObjectPool* pool,
                        const RowDescriptor& row_desc,
                        const std::vector<TExpr>& t_exprs) :
         _pool(pool),
         _row_desc(row_desc),
         _t_output_expr(t_exprs),
+        _next_file_writer(0),
         _bytes_written_counter(nullptr),
         _rows_written_counter(nullptr),
-        _write_timer(nullptr) {
+        _format_timer(nullptr),
+        _write_timer(nullptr),
+        _file_bytes_written_counter(nullptr),
+        _file_write_timer(nullptr) {
 }
 
 ExportSink::~ExportSink() {
@@ -68,10 +112,12 @@ Status ExportSink::prepare(RuntimeState* state) {
     // Prepare the exprs to run.
     RETURN_IF_ERROR(Expr::prepare(_output_expr_ctxs, state, _row_desc, _mem_tracker.get()));
 
-    // TODO(lingbin): add some Counter
     _bytes_written_counter = ADD_COUNTER(profile(), "BytesExported", TUnit::BYTES);
     _rows_written_counter = ADD_COUNTER(profile(), "RowsExported", TUnit::UNIT);
+    _format_timer = ADD_TIMER(profile(), "FormatTime");
     _write_timer = ADD_TIMER(profile(), "WriteTime");
+    _file_bytes_written_counter = ADD_COUNTER(profile(), "FileBytesWritten", TUnit::BYTES);
+    _file_write_timer = ADD_TIMER(profile(), "FileWriteTime");
 
     return Status::OK;
 }
@@ -80,7 +126,7 @@ Status ExportSink::open(RuntimeState* state) {
     // Prepare the exprs to run.
     RETURN_IF_ERROR(Expr::open(_output_expr_ctxs, state));
     // open broker
-    RETURN_IF_ERROR(open_file_writer());
+    RETURN_IF_ERROR(open_file_writers());
     return Status::OK;
 }
 
@@ -88,155 +134,212 @@ Status ExportSink::send(RuntimeState* state, RowBatch* batch) {
     VLOG_ROW << "debug: export_sink send batch: " << print_batch(batch);
     SCOPED_TIMER(_profile->total_time_counter());
     int num_rows = batch->num_rows();
-    // we send at most 1024 rows at a time
-    int batch_send_rows = num_rows > 1024 ? 1024 : num_rows;
-    std::stringstream ss;
-    for (int i = 0; i < num_rows;) {
-        ss.str("");
-        for (int j = 0; j < batch_send_rows && i < num_rows; ++j, ++i) {
-            RETURN_IF_ERROR(gen_row_buffer(batch->get_row(i), &ss));
-        }
-
-        VLOG_ROW << "debug: export_sink send row: " << ss.str();
-        const std::string& buf = ss.str();
-        size_t written_len = 0;
+    if (num_rows == 0) {
+        return Status::OK;
+    }
+    {
+        SCOPED_TIMER(_format_timer);
+        RETURN_IF_ERROR(format_batch(batch, &_buffer));
+    }
 
+    {
         SCOPED_TIMER(_write_timer);
-        // TODO(lingbin): for broker writer, we should not send rpc each row.
-        RETURN_IF_ERROR(_file_writer->write(reinterpret_cast<const uint8_t*>(buf.c_str()),
-                buf.size(),
-                &written_len));
-        COUNTER_UPDATE(_bytes_written_counter, buf.size());
+        size_t written_len = 0;
+        RETURN_IF_ERROR(_file_writers[_next_file_writer]->write(
+                reinterpret_cast<const uint8_t*>(_buffer.data()), _buffer.size(), &written_len));
     }
+    _next_file_writer = (_next_file_writer + 1) % _file_writers.size();
+    COUNTER_UPDATE(_bytes_written_counter, _buffer.size());
     COUNTER_UPDATE(_rows_written_counter, num_rows);
     return Status::OK;
 }
 
-Status ExportSink::gen_row_buffer(TupleRow* row, std::stringstream* ss) {
+Status ExportSink::format_batch(RowBatch* batch, std::string* buf) {
+    int num_rows = batch->num_rows();
     int num_columns = _output_expr_ctxs.size();
-    // const TupleDescriptor& desc = row_desc().TupleDescriptor;
+    _column_texts.resize(num_columns);
+    size_t total_size = 0;
     for (int i = 0; i < num_columns; ++i) {
-        void* item = _output_expr_ctxs[i]->get_value(row);
-        if (item == nullptr) {
-            (*ss) << "NULL";
-            continue;
-        }
-        switch (_output_expr_ctxs[i]->root()->type().type) {
-        case TYPE_BOOLEAN:
-        case TYPE_TINYINT:
-            (*ss) << (int)*static_cast<int8_t*>(item);
-            break;
-        case TYPE_SMALLINT:
-            (*ss) << *static_cast<int16_t*>(item);
-            break;
-        case TYPE_INT:
-            (*ss) << *static_cast<int32_t*>(item);
-            break;
-        case TYPE_BIGINT:
-            (*ss) << *static_cast<int64_t*>(item);
-            break;
-        case TYPE_LARGEINT:
-            (*ss) << *static_cast<__int128*>(item);
-            break;
-        case TYPE_FLOAT:
-            (*ss) << *static_cast<float*>(item);
-            break;
-        case TYPE_DOUBLE:
-            (*ss) << *static_cast<double*>(item);
-            break;
-        case TYPE_DATE:
-        case TYPE_DATETIME: {
-            char buf[64];
-            const DateTimeValue* time_val = (const DateTimeValue*)(item);
-            time_val->to_string(buf);
-            (*ss) << buf;
-            break;
+        RETURN_IF_ERROR(format_column(i, batch, &_column_texts[i]));
+        total_size += _column_texts[i].data.size();
+    }
+
+    const std::string& column_separator = _t_export_sink.column_separator;
+    const std::string& line_delimiter = _t_export_sink.line_delimiter;
+    buf->clear();
+    buf->reserve(total_size + num_rows
+                 * (std::max(num_columns - 1, 0) * column_separator.size()
+                    + line_delimiter.size()));
+    for (int row = 0; row < num_rows; ++row) {
+        for (int i = 0; i < num_columns; ++i) {
+            const ColumnText& text = _column_texts[i];
+            size_t begin = row == 0 ? 0 : text.ends[row - 1];
+            buf->append(text.data, begin, text.ends[row] - begin);
+            if (i < num_columns - 1) {
+                buf->append(column_separator);
+            }
         }
-        case TYPE_VARCHAR:
-        case TYPE_CHAR: {
-            const StringValue* string_val = (const StringValue*)(item);
+        buf->append(line_delimiter);
+    }
+    VLOG_ROW << "debug: export_sink send rows: " << *buf;
+    return Status::OK;
+}
 
+Status ExportSink::format_column(int column, RowBatch* batch, ColumnText* text) {
+    ExprContext* ctx = _output_expr_ctxs[column];
+    std::string* data = &text->data;
+    std::vector<size_t>* ends = &text->ends;
+    data->clear();
+    ends->resize(batch->num_rows());
+
+    switch (ctx->root()->type().type) {
+    case TYPE_BOOLEAN:
+    case TYPE_TINYINT:
+        format_values(ctx, batch, [](void* item, std::string* out) {
+            append_int(*static_cast<int8_t*>(item), out);
+        }, data, ends);
+        break;
+    case TYPE_SMALLINT:
+        format_values(ctx, batch, [](void* item, std::string* out) {
+            append_int(*static_cast<int16_t*>(item), out);
+        }, data, ends);
+        break;
+    case TYPE_INT:
+        format_values(ctx, batch, [](void* item, std::string* out) {
+            append_int(*static_cast<int32_t*>(item), out);
+        }, data, ends);
+        break;
+    case TYPE_BIGINT:
+        format_values(ctx, batch, [](void* item, std::string* out) {
+            append_int(*static_cast<int64_t*>(item), out);
+        }, data, ends);
+        break;
+    case TYPE_LARGEINT:
+        format_values(ctx, batch, [](void* item, std::string* out) {
+            char buf[48];
+            int len = sizeof(buf);
+            char* begin = LargeIntValue::to_string(*static_cast<__int128*>(item), buf, &len);
+            out->append(begin, len);
+        }, data, ends);
+        break;
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE: {
+        // "%g" is what an ostream prints by default
+        bool is_float = ctx->root()->type().type == TYPE_FLOAT;
+        format_values(ctx, batch, [is_float](void* item, std::string* out) {
+            char buf[32];
+            double value = is_float ? *static_cast<float*>(item) : *static_cast<double*>(item);
+            int len = snprintf(buf, sizeof(buf), "%g", value);
+            out->append(buf, len);
+        }, data, ends);
+        break;
+    }
+    case TYPE_DATE:
+    case TYPE_DATETIME:
+        format_values(ctx, batch, [](void* item, std::string* out) {
+            char buf[64];
+            static_cast<const DateTimeValue*>(item)->to_string(buf);
+            out->append(buf, strlen(buf));
+        }, data, ends);
+        break;
+    case TYPE_VARCHAR:
+    case TYPE_CHAR:
+        format_values(ctx, batch, [](void* item, std::string* out) {
+            const StringValue* string_val = static_cast<const StringValue*>(item);
             if (string_val->ptr == NULL) {
-                if (string_val->len == 0) {
-                } else {
-                    (*ss) << "NULL";
+                if (string_val->len != 0) {
+                    out->append("NULL", 4);
                 }
             } else {
-                (*ss) << std::string(string_val->ptr, string_val->len);
+                out->append(string_val->ptr, string_val->len);
             }
-            break;
-        }
-        case TYPE_DECIMAL: {
-            const DecimalValue* decimal_val = reinterpret_cast<const DecimalValue*>(item);
-            std::string decimal_str;
-            int output_scale = _output_expr_ctxs[i]->root()->output_scale();
-
+        }, data, ends);
+        break;
+    case TYPE_DECIMAL: {
+        int output_scale = ctx->root()->output_scale();
+        format_values(ctx, batch, [output_scale](void* item, std::string* out) {
+            const DecimalValue* decimal_val = static_cast<const DecimalValue*>(item);
             if (output_scale > 0 && output_scale <= 30) {
-                decimal_str = decimal_val->to_string(output_scale);
+                out->append(decimal_val->to_string(output_scale));
             } else {
-                decimal_str = decimal_val->to_string();
+                out->append(decimal_val->to_string());
             }
-            (*ss) << decimal_str;
-            break;
-        }
-        default: {
-            std::stringstream err_ss;
-            err_ss << "can't export this type. type = " << _output_expr_ctxs[i]->root()->type();
-            return Status(err_ss.str());
-        }
-        }
-        if (i < num_columns - 1) {
-            (*ss) << _t_export_sink.column_separator;
-        }
+        }, data, ends);
+        break;
+    }
+    default: {
+        std::stringstream err_ss;
+        err_ss << "can't export this type. type = " << ctx->root()->type();
+        return Status(err_ss.str());
+    }
     }
-    (*ss) << _t_export_sink.line_delimiter;
-
     return Status::OK;
 }
 
 Status ExportSink::close(RuntimeState* state, Status exec_status) {
     Expr::close(_output_expr_ctxs, state);
-    if (_file_writer != nullptr) {
-        _file_writer->close();
-        _file_writer = nullptr;
+    Status status = Status::OK;
+    for (auto& file_writer : _file_writers) {
+        Status write_status = file_writer->finish();
+        if (status.ok() && !write_status.ok()) {
+            status = write_status;
+        }
+        if (_file_bytes_written_counter != nullptr) {
+            COUNTER_UPDATE(_file_bytes_written_counter, file_writer->bytes_written());
+            COUNTER_UPDATE(_file_write_timer, file_writer->write_time_ns());
+        }
     }
-    return Status::OK;
+    _file_writers.clear();
+    return status;
 }
 
-Status ExportSink::open_file_writer() {
-    if (_file_writer != nullptr) {
+Status ExportSink::open_file_writers() {
+    if (!_file_writers.empty()) {
         return Status::OK;
     }
 
+    TCompressKind::type compress_kind = _t_export_sink.__isset.compress_kind
+            ? _t_export_sink.compress_kind : TCompressKind::NONE;
+    int num_files = std::max(config::export_parallel_files, 1);
     std::string file_name = gen_file_name();
+    for (int i = 0; i < num_files; ++i) {
+        std::stringstream path;
+        path << _t_export_sink.export_path << "/" << file_name;
+        if (num_files > 1) {
+            path << "_" << i;
+        }
+        path << AsyncFileWriter::file_suffix(compress_kind);
+
+        FileWriter* file_writer = nullptr;
+        RETURN_IF_ERROR(create_file_writer(path.str(), &file_writer));
+        _file_writers.emplace_back(new AsyncFileWriter(
+                file_writer, compress_kind,
+                static_cast<size_t>(std::max(config::export_write_buffer_kb, 1)) * 1024,
+                config::export_max_pending_buffers));
+        RETURN_IF_ERROR(_file_writers.back()->open());
+        _state->add_export_output_file(path.str());
+    }
+    return Status::OK;
+}
 
-    // TODO(lingbin): gen file path
+Status ExportSink::create_file_writer(const std::string& path, FileWriter** file_writer) {
     switch (_t_export_sink.file_type) {
-    case TFileType::FILE_LOCAL: {
-        LocalFileWriter* file_writer
-                = new LocalFileWriter(_t_export_sink.export_path + "/" + file_name, 0);
-        RETURN_IF_ERROR(file_writer->open());
-        _file_writer.reset(file_writer);
+    case TFileType::FILE_LOCAL:
+        *file_writer = new LocalFileWriter(path, 0);
         break;
-    }
-    case TFileType::FILE_BROKER: {
-        BrokerWriter* broker_writer = new BrokerWriter(_state,
-                                                       _t_export_sink.broker_addresses,
-                                                       _t_export_sink.properties,
-                                                       _t_export_sink.export_path + "/" + file_name,
-                                                       0 /* offset */);
-        RETURN_IF_ERROR(broker_writer->open());
-        _file_writer.reset(broker_writer);
+    case TFileType::FILE_BROKER:
+        *file_writer = new BrokerWriter(_state,
+                                        _t_export_sink.broker_addresses,
+                                        _t_export_sink.properties,
+                                        path,
+                                        0 /* offset */);
         break;
-    }
     default: {
         std::stringstream ss;
         ss << "Unknown file type, type=" << _t_export_sink.file_type;
         return Status(ss.str());
     }
     }
-
-    _state->add_export_output_file(_t_export_sink.export_path + "/" + file_name);
     return Status::OK;
 }
 
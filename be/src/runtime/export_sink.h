@@ -16,6 +16,8 @@
 #ifndef BDG_PALO_BE_SRC_RUNTIME_EXPORT_SINK_H
 #define BDG_PALO_BE_SRC_RUNTIME_EXPORT_SINK_H
 
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "common/status.h"
@@ -30,10 +32,14 @@ class RuntimeState;
 class RuntimeProfile;
 class ExprContext;
 class MemTracker;
+class AsyncFileWriter;
 class FileWriter;
-class TupleRow;
 
 // This class is a sinker, which put export data to external storage by broker.
+//
+// The rows of a batch are formatted one column at a time and handed to the file
+// writers, which write and compress them on threads of their own. With
+// config::export_parallel_files > 1 the batches go to several files round robin.
 class ExportSink : public DataSink {
 public:
     ExportSink(ObjectPool* pool,
@@ -59,8 +65,18 @@ public:
     }
 
 private:
-    Status open_file_writer();
-    Status gen_row_buffer(TupleRow* row, std::stringstream* ss);
+    // The formatted values of one output column of a row batch
+    struct ColumnText {
+        std::string data;
+        // end of the value of each row in 'data'
+        std::vector<size_t> ends;
+    };
+
+    Status open_file_writers();
+    Status create_file_writer(const std::string& path, FileWriter** file_writer);
+    // Formats the rows of 'batch' as delimited text into 'buf'.
+    Status format_batch(RowBatch* batch, std::string* buf);
+    Status format_column(int column, RowBatch* batch, ColumnText* text);
     std::string gen_file_name();
 
     RuntimeState* _state;
@@ -73,7 +89,12 @@ private:
     std::vector<ExprContext*> _output_expr_ctxs;
 
     TExportSink _t_export_sink;
-    std::unique_ptr<FileWriter> _file_writer;
+    std::vector<std::unique_ptr<AsyncFileWriter>> _file_writers;
+    // the writer the next batch goes to
+    int _next_file_writer;
+
+    std::vector<ColumnText> _column_texts;
+    std::string _buffer;
 
     RuntimeProfile* _profile;
 
@@ -81,7 +102,11 @@ private:
 
     RuntimeProfile::Counter* _bytes_written_counter;
     RuntimeProfile::Counter* _rows_written_counter;
+    RuntimeProfile::Counter* _format_timer;
+    // time send() waited for the file writers
     RuntimeProfile::Counter* _write_timer;
+    RuntimeProfile::Counter* _file_bytes_written_counter;
+    RuntimeProfile::Counter* _file_write_timer;
 };
 
 } // end namespace palo
@@ -32,6 +32,9 @@
 #include "runtime/plan_fragment_executor.h"
 #include "runtime/exec_env.h"
 #include "runtime/datetime_value.h"
+#include "util/cpu_profiler.h"
+#include "util/palo_metrics.h"
+#include "util/parse_util.h"
 #include "util/stopwatch.hpp"
 #include "util/debug_util.h"
 #include "util/thrift_util.h"
@@ -73,6 +76,13 @@ public:
 
     Status cancel();
 
+    // Reports 'status' as the final status without executing the fragment.
+    void abort(const Status& status);
+
+    const TUniqueId& query_id() const {
+        return _query_id;
+    }
+
     TUniqueId fragment_instance_id() const {
         return _fragment_instance_id;
     }
@@ -100,6 +110,19 @@ public:
         _group = info.group;
     }
 
+    // The group the fragment is admitted into.
+    std::string resource_group() const {
+        return _set_rsc_info ? _group : "default";
+    }
+
+    int64_t mem_limit() const {
+        return _mem_limit;
+    }
+
+    bool is_cancelled() {
+        return _executor.runtime_state()->is_cancelled();
+    }
+
     bool is_timeout(const DateTimeValue& now) const {
         if (_timeout_second <= 0) {
             return false;
@@ -133,6 +156,7 @@ private:
     std::string _group;
 
     int _timeout_second;
+    int64_t _mem_limit;
 
     std::unique_ptr<std::thread> _exec_thread;
 };
@@ -151,7 +175,8 @@ FragmentExecState::FragmentExecState(
             _executor(exec_env, boost::bind<void>(
                     boost::mem_fn(&FragmentExecState::coordinator_callback), this, _1, _2, _3)),
             _set_rsc_info(false),
-            _timeout_second(-1) {
+            _timeout_second(-1),
+            _mem_limit(0) {
     _start_time = DateTimeValue::local_time();
 }
 
@@ -161,6 +186,9 @@ FragmentExecState::~FragmentExecState() {
 Status FragmentExecState::prepare(const TExecPlanFragmentParams& params) {
     if (params.__isset.query_options) {
         _timeout_second = params.query_options.query_timeout;
+        if (params.query_options.__isset.mem_limit) {
+            _mem_limit = params.query_options.mem_limit;
+        }
     }
 
     if (params.__isset.resource_info) {
@@ -194,6 +222,9 @@ Status FragmentExecState::execute() {
 
     _executor.open();
     _executor.close();
+    if (PaloMetrics::fragment_latency() != NULL) {
+        PaloMetrics::fragment_latency()->update(watch.elapsed_time());
+    }
     LOG(INFO) << "execute time is " << watch.elapsed_time() / 1000000;
     return Status::OK;
 }
@@ -205,6 +236,12 @@ Status FragmentExecState::cancel() {
     return Status::OK;
 }
 
+void FragmentExecState::abort(const Status& status) {
+    update_status(status);
+    _executor.abort(status);
+    _executor.close();
+}
+
 void FragmentExecState::callback(const Status& status, RuntimeProfile* profile, bool done) {
 }
 
@@ -326,6 +363,18 @@ void FragmentExecState::coordinator_callback(
     }
 }
 
+static int64_t admission_mem_limit_per_group() {
+    bool is_percent = false;
+    int64_t bytes = ParseUtil::parse_mem_spec(config::admission_mem_limit_per_group,
+                                              &is_percent);
+    if (bytes < 0) {
+        LOG(WARNING) << "Failed to parse admission_mem_limit_per_group '"
+            << config::admission_mem_limit_per_group << "', no memory budget is applied";
+        return 0;
+    }
+    return bytes;
+}
+
 FragmentMgr::FragmentMgr(ExecEnv* exec_env) :
         _exec_env(exec_env),
         _fragment_map(),
@@ -333,7 +382,12 @@ FragmentMgr::FragmentMgr(ExecEnv* exec_env) :
         _cancel_thread(std::bind<void>(&FragmentMgr::cancel_worker, this)),
         // TODO(zc): we need a better thread-pool
         // now one user can use all the thread pool, others have no resource.
-        _thread_pool(config::fragment_pool_thread_num, config::fragment_pool_queue_size) {
+        _thread_pool(config::fragment_pool_active_thread_num,
+                     config::fragment_pool_thread_num,
+                     config::fragment_pool_queue_size,
+                     "fragment"),
+        _admission_controller(config::admission_max_fragments_per_group,
+                              admission_mem_limit_per_group()) {
 }
 
 FragmentMgr::~FragmentMgr() {
@@ -356,7 +410,19 @@ static void empty_function(PlanFragmentExecutor* exec) {
 void FragmentMgr::exec_actual(
         std::shared_ptr<FragmentExecState> exec_state,
         FinishCallback cb) {
-    exec_state->execute();
+    const std::string group = exec_state->resource_group();
+    Status status = _admission_controller.admit(
+            group, exec_state->query_id(), exec_state->mem_limit(),
+            std::bind<bool>(&FragmentExecState::is_cancelled, exec_state.get()));
+    if (status.ok()) {
+        CpuProfiler::ScopedQueryTag query_tag(exec_state->query_id());
+        exec_state->execute();
+        _admission_controller.release(group, exec_state->query_id(), exec_state->mem_limit());
+    } else {
+        LOG(WARNING) << "Fragment " << exec_state->fragment_instance_id()
+            << " was not admitted: " << status.get_error_msg();
+        exec_state->abort(status);
+    }
 
     {
         std::lock_guard<std::mutex> lock(_lock);
@@ -380,7 +446,7 @@ Status FragmentMgr::exec_plan_fragment(
 }
 
 static void* fragment_executor(void* param) {
-    ThreadPool::WorkFunction* func = (ThreadPool::WorkFunction*)param;
+    BlockingAwareThreadPool::WorkFunction* func = (BlockingAwareThreadPool::WorkFunction*)param;
     (*func)();
     delete func;
     return nullptr;
@@ -438,7 +504,7 @@ Status FragmentMgr::exec_plan_fragment(
         pthread_create(&id,
                        nullptr,
                        fragment_executor,
-                       new ThreadPool::WorkFunction(
+                       new BlockingAwareThreadPool::WorkFunction(
                            std::bind<void>(&FragmentMgr::exec_actual, this, exec_state, cb)));
         pthread_detach(id);
     }
@@ -487,6 +553,11 @@ void FragmentMgr::cancel_worker() {
     LOG(INFO) << "FragmentMgr cancel worker is going to exit.";
 }
 
+size_t FragmentMgr::num_running_fragments() {
+    std::lock_guard<std::mutex> lock(_lock);
+    return _fragment_map.size();
+}
+
 void FragmentMgr::debug(std::stringstream& ss) {
     // Keep things simple
     std::lock_guard<std::mutex> lock(_lock);
@@ -500,6 +571,8 @@ void FragmentMgr::debug(std::stringstream& ss) {
             << "\t" << now.second_diff(it.second->start_time())
             << "\n";
     }
+    ss << "\n";
+    _admission_controller.debug(ss);
 }
 
 }
@@ -29,7 +29,8 @@
 
 #include "common/status.h"
 #include "gen_cpp/Types_types.h"
-#include "util/thread_pool.hpp"
+#include "runtime/admission_controller.h"
+#include "util/blocking_aware_thread_pool.h"
 #include "util/hash_util.hpp"
 #include "http/rest_monitor_iface.h"
 
@@ -58,6 +59,9 @@ public:
 
     void cancel_worker();
 
+    // The number of fragment instances executing or waiting to.
+    size_t num_running_fragments();
+
     virtual void debug(std::stringstream& ss);
 private:
     void exec_actual(std::shared_ptr<FragmentExecState> exec_state,
@@ -75,7 +79,9 @@ private:
     bool _stop;
     std::thread _cancel_thread;
     // every job is a pool
-    ThreadPool _thread_pool;
+    BlockingAwareThreadPool _thread_pool;
+    // Queues the fragments of a resource group beyond its budgets before they execute
+    AdmissionController _admission_controller;
 
 };
 
@@ -0,0 +1,70 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/fragment_template_cache.h"
+
+#include "gen_cpp/PaloInternalService_types.h"
+#include "runtime/descriptors.h"
+#include "runtime/mem_arbitrator.h"
+#include "util/thrift_util.h"
+
+namespace palo {
+
+bool FragmentTemplateCache::is_cacheable(const TExecPlanFragmentParams& request) {
+    return request.__isset.desc_tbl && request.__isset.fragment
+        && request.query_options.disable_codegen;
+}
+
+Status FragmentTemplateCache::get_or_create(const TExecPlanFragmentParams& request,
+        boost::shared_ptr<const FragmentTemplate>* tmpl) {
+    ThriftSerializer serializer(false, 4096);
+    std::string key;
+    RETURN_IF_ERROR(serializer.serialize(
+            const_cast<TDescriptorTable*>(&request.desc_tbl), &key));
+    std::string plan_bytes;
+    RETURN_IF_ERROR(serializer.serialize(
+            const_cast<TPlan*>(&request.fragment.plan), &plan_bytes));
+    key.append(plan_bytes);
+
+    *tmpl = _lru.lookup(key);
+    if (*tmpl != NULL) {
+        return Status::OK;
+    }
+
+    boost::shared_ptr<FragmentTemplate> new_tmpl(new FragmentTemplate());
+    RETURN_IF_ERROR(init_template(request, new_tmpl.get()));
+    // the descriptor objects take a few times the space of their thrift encoding
+    new_tmpl->bytes = (key.size() - plan_bytes.size()) * 4;
+    *tmpl = new_tmpl;
+    _lru.insert(key, *tmpl);
+    return Status::OK;
+}
+
+Status FragmentTemplateCache::create(const TExecPlanFragmentParams& request,
+        boost::shared_ptr<const FragmentTemplate>* tmpl) {
+    boost::shared_ptr<FragmentTemplate> new_tmpl(new FragmentTemplate());
+    RETURN_IF_ERROR(init_template(request, new_tmpl.get()));
+    *tmpl = new_tmpl;
+    return Status::OK;
+}
+
+Status FragmentTemplateCache::init_template(const TExecPlanFragmentParams& request,
+        FragmentTemplate* tmpl) {
+    RETURN_IF_ERROR(DescriptorTbl::create(&tmpl->pool, request.desc_tbl, &tmpl->desc_tbl));
+    tmpl->plan_fingerprint = MemArbitrator::plan_fingerprint(request.fragment.plan);
+    return Status::OK;
+}
+
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_RUNTIME_FRAGMENT_TEMPLATE_CACHE_H
+#define BDG_PALO_BE_RUNTIME_FRAGMENT_TEMPLATE_CACHE_H
+
+#include <stdint.h>
+
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
+#include "common/object_pool.h"
+#include "common/status.h"
+#include "runtime/result_cache.h"
+
+namespace palo {
+
+class DescriptorTbl;
+class TExecPlanFragmentParams;
+
+// The parts of a prepared plan fragment that don't depend on the query it runs for.
+// They are immutable, so all executions of the same plan share them.
+struct FragmentTemplate {
+    FragmentTemplate() : desc_tbl(NULL), plan_fingerprint(0), bytes(0) { }
+
+    ObjectPool pool;
+    // lives in pool
+    DescriptorTbl* desc_tbl;
+    // see MemArbitrator::plan_fingerprint()
+    int64_t plan_fingerprint;
+    // approximate memory used by the template
+    int64_t bytes;
+};
+
+// LRU cache of fragment templates, bounded by config::fragment_template_cache_capacity_bytes.
+//
+// A template is keyed by the serialized descriptor table and plan of the fragment, so
+// the descriptors are created once for the fragments of a query shape executed over and
+// over, like point queries, instead of in every prepare(). Scan ranges and the other
+// parameters of an execution are not part of the key and are still bound per fragment
+// instance. ExecNodes and Exprs keep per query state and are created per instance too.
+class FragmentTemplateCache {
+public:
+    FragmentTemplateCache(int64_t capacity_bytes) : _lru(capacity_bytes) { }
+
+    // Returns true if the template of the fragment of 'request' can be shared. The
+    // descriptors cache llvm objects of the query they are used for, so fragments that
+    // use codegen get their own.
+    static bool is_cacheable(const TExecPlanFragmentParams& request);
+
+    // Sets '*tmpl' to the template of the fragment of 'request', which is created and
+    // cached if there is none yet.
+    Status get_or_create(const TExecPlanFragmentParams& request,
+                         boost::shared_ptr<const FragmentTemplate>* tmpl);
+
+    // Creates the template of the fragment of 'request' without caching it.
+    static Status create(const TExecPlanFragmentParams& request,
+                         boost::shared_ptr<const FragmentTemplate>* tmpl);
+
+    int64_t size_bytes() {
+        return _lru.size_bytes();
+    }
+
+private:
+    static Status init_template(const TExecPlanFragmentParams& request,
+                                FragmentTemplate* tmpl);
+
+    ResultLru<FragmentTemplate> _lru;
+};
+
+}
+
+#endif // BDG_PALO_BE_RUNTIME_FRAGMENT_TEMPLATE_CACHE_H
@@ -0,0 +1,165 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/mem_arbitrator.h"
+
+#include <algorithm>
+#include <deque>
+#include <set>
+#include <string>
+
+#include <boost/thread/locks.hpp>
+
+#include "common/config.h"
+#include "common/logging.h"
+#include "gen_cpp/PlanNodes_types.h"
+#include "runtime/mem_tracker.h"
+#include "util/hash_util.hpp"
+#include "util/thrift_util.h"
+
+namespace palo {
+
+using boost::lock_guard;
+using boost::mutex;
+
+// Plans that exceeded the memory limit, the oldest are forgotten first.
+static mutex _s_exceeded_plans_lock;
+static std::set<int64_t> _s_exceeded_plans;
+static std::deque<int64_t> _s_exceeded_plans_order;
+
+MemArbitrator::MemArbitrator(MemTracker* mem_tracker) :
+        _mem_tracker(mem_tracker),
+        _plan_fingerprint(0),
+        _num_spillers(0),
+        _num_reliefs(0),
+        _spill_generation(0) {
+}
+
+void MemArbitrator::add_reclaimer(void* owner, const ReclaimFunction& f) {
+    lock_guard<mutex> l(_lock);
+    _reclaimers.push_back(std::make_pair(owner, f));
+}
+
+void MemArbitrator::remove_reclaimers(void* owner) {
+    lock_guard<mutex> l(_lock);
+    for (int i = _reclaimers.size() - 1; i >= 0; --i) {
+        if (_reclaimers[i].first == owner) {
+            _reclaimers.erase(_reclaimers.begin() + i);
+        }
+    }
+}
+
+int64_t MemArbitrator::register_spiller() {
+    lock_guard<mutex> l(_lock);
+    ++_num_spillers;
+    return _spill_generation.load();
+}
+
+void MemArbitrator::unregister_spiller() {
+    lock_guard<mutex> l(_lock);
+    DCHECK_GT(_num_spillers, 0);
+    --_num_spillers;
+}
+
+bool MemArbitrator::spill_requested(int64_t* generation) const {
+    int64_t current = _spill_generation.load();
+    if (current == *generation) {
+        return false;
+    }
+    *generation = current;
+    return true;
+}
+
+bool MemArbitrator::relieve() {
+    if (!config::enable_mem_limit_degradation) {
+        return false;
+    }
+    lock_guard<mutex> l(_lock);
+    int64_t bytes_to_free = bytes_over_limit();
+    if (bytes_to_free == 0) {
+        // another thread of the instance got there first
+        return true;
+    }
+    ++_num_reliefs;
+    for (int i = 0; i < _reclaimers.size() && bytes_to_free > 0; ++i) {
+        bytes_to_free -= _reclaimers[i].second(bytes_to_free);
+    }
+    if (!_mem_tracker->any_limit_exceeded()) {
+        return true;
+    }
+    if (_num_spillers == 0) {
+        return false;
+    }
+    ++_spill_generation;
+    return !beyond_grace();
+}
+
+void MemArbitrator::record_exceeded() {
+    if (_plan_fingerprint == 0) {
+        return;
+    }
+    lock_guard<mutex> l(_s_exceeded_plans_lock);
+    if (!_s_exceeded_plans.insert(_plan_fingerprint).second) {
+        return;
+    }
+    _s_exceeded_plans_order.push_back(_plan_fingerprint);
+    size_t capacity = std::max(config::mem_limit_exceeded_plan_cache_size, 0);
+    while (_s_exceeded_plans_order.size() > capacity) {
+        _s_exceeded_plans.erase(_s_exceeded_plans_order.front());
+        _s_exceeded_plans_order.pop_front();
+    }
+}
+
+int64_t MemArbitrator::plan_fingerprint(const TPlan& plan) {
+    ThriftSerializer serializer(false, 4096);
+    std::string bytes;
+    if (!serializer.serialize(const_cast<TPlan*>(&plan), &bytes).ok()) {
+        return 0;
+    }
+    return HashUtil::hash64(bytes.data(), bytes.size(), 0);
+}
+
+bool MemArbitrator::plan_exceeded_before(int64_t fingerprint) {
+    if (fingerprint == 0) {
+        return false;
+    }
+    lock_guard<mutex> l(_s_exceeded_plans_lock);
+    return _s_exceeded_plans.find(fingerprint) != _s_exceeded_plans.end();
+}
+
+int64_t MemArbitrator::bytes_over_limit() const {
+    int64_t bytes = 0;
+    for (MemTracker* tracker = _mem_tracker; tracker != NULL; tracker = tracker->parent()) {
+        if (tracker->limit_exceeded()) {
+            bytes = std::max(bytes, tracker->consumption() - tracker->limit());
+        }
+    }
+    return bytes;
+}
+
+bool MemArbitrator::beyond_grace() const {
+    for (MemTracker* tracker = _mem_tracker; tracker != NULL; tracker = tracker->parent()) {
+        if (!tracker->has_limit()) {
+            continue;
+        }
+        int64_t grace = tracker->limit() / 100 * std::max(config::mem_limit_grace_percent, 0);
+        if (tracker->consumption() > tracker->limit() + grace) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
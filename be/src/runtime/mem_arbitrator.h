@@ -0,0 +1,115 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_RUNTIME_MEM_ARBITRATOR_H
+#define BDG_PALO_BE_RUNTIME_MEM_ARBITRATOR_H
+
+#include <stdint.h>
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+#include "common/atomic.h"
+
+namespace palo {
+
+class MemTracker;
+class TPlan;
+
+// Decides what a fragment instance does when it exceeds its memory limit, instead of
+// failing it right away.
+//
+// Nodes that hold memory they can give up register a reclaimer, which frees what it
+// can immediately, e.g. cached row batches, and may shrink queues so that less memory
+// is held later on. Nodes that can spill register as spillers and poll
+// spill_requested() between batches. If the reclaimers don't bring the consumption
+// back under the limits, the spillers are asked to spill and the instance may go on,
+// as long as it overruns no limit by more than config::mem_limit_grace_percent. Only
+// then it fails.
+//
+// A plan whose instance failed nevertheless is remembered, so that its next run uses
+// the spilling implementations of aggregations and hash joins. Thread safe.
+class MemArbitrator {
+public:
+    // Frees up to 'bytes_to_free' bytes, returns the number of bytes it freed.
+    typedef std::function<int64_t(int64_t bytes_to_free)> ReclaimFunction;
+
+    // 'mem_tracker' is the tracker of the instance, its limit and the ones of its
+    // ancestors are arbitrated.
+    explicit MemArbitrator(MemTracker* mem_tracker);
+
+    // Adds 'f' to the reclaimers, they are called in the order they were added.
+    // 'owner' identifies it for remove_reclaimers().
+    void add_reclaimer(void* owner, const ReclaimFunction& f);
+
+    // Removes the reclaimers of 'owner'. It's not called afterwards.
+    void remove_reclaimers(void* owner);
+
+    // Returns the current spill request generation for the new spiller.
+    int64_t register_spiller();
+    void unregister_spiller();
+
+    // Returns true if spilling was requested since '*generation' and updates it.
+    bool spill_requested(int64_t* generation) const;
+
+    // Called when a limit is exceeded. Runs the reclaimers and requests the spillers to
+    // spill. Returns false if the instance should fail.
+    bool relieve();
+
+    // The fingerprint of the plan of the instance, see record_exceeded().
+    void set_plan_fingerprint(int64_t fingerprint) {
+        _plan_fingerprint = fingerprint;
+    }
+
+    // Remembers the plan of the instance as one that exceeded the memory limit.
+    void record_exceeded();
+
+    int64_t num_reliefs() const {
+        return _num_reliefs;
+    }
+
+    // Returns a fingerprint of 'plan' that is equal for reruns of the same query.
+    static int64_t plan_fingerprint(const TPlan& plan);
+
+    // Returns true if an instance with the plan of 'fingerprint' exceeded its memory
+    // limit before.
+    static bool plan_exceeded_before(int64_t fingerprint);
+
+private:
+    // Returns the most bytes by which the consumption exceeds the limit of the tracker
+    // or one of its ancestors, 0 if no limit is exceeded.
+    int64_t bytes_over_limit() const;
+
+    // Returns true if the consumption exceeds a limit by more than the grace.
+    bool beyond_grace() const;
+
+    MemTracker* _mem_tracker;
+    int64_t _plan_fingerprint;
+
+    boost::mutex _lock;
+    std::vector<std::pair<void*, ReclaimFunction> > _reclaimers;
+    int _num_spillers;
+    int64_t _num_reliefs;
+
+    // Incremented for every request to spill.
+    AtomicInt64 _spill_generation;
+};
+
+}
+
+#endif // BDG_PALO_BE_RUNTIME_MEM_ARBITRATOR_H
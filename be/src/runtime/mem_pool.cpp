@@ -19,6 +19,7 @@
 // under the License.
 
 #include "runtime/mem_pool.h"
+#include "runtime/chunk_allocator.h"
 #include "runtime/mem_tracker.h"
 #include "runtime/mem_tracker.h"
 #include "util/palo_metrics.h"
@@ -72,7 +73,7 @@ MemPool::~MemPool() {
         }
 
         total_bytes_released += _chunks[i].size;
-        free(_chunks[i].data);
+        ChunkAllocator::instance()->free(_chunks[i].data, _chunks[i].size);
     }
     _chunks.clear();
 
@@ -91,7 +92,7 @@ void MemPool::free_all() {
             continue;
         }
         total_bytes_released += _chunks[i].size;
-        free(_chunks[i].data);
+        ChunkAllocator::instance()->free(_chunks[i].data, _chunks[i].size);
     }
     _chunks.clear();
     _current_chunk_idx = -1;
@@ -105,6 +106,32 @@ void MemPool::free_all() {
     }
 }
 
+void MemPool::clear_and_trim(int64_t max_retained_bytes) {
+    clear();
+    int64_t retained_bytes = 0;
+    int64_t total_bytes_released = 0;
+    int num_retained = 0;
+    for (size_t i = 0; i < _chunks.size(); ++i) {
+        if (_chunks[i].owns_data && retained_bytes + _chunks[i].size <= max_retained_bytes) {
+            retained_bytes += _chunks[i].size;
+            _chunks[num_retained++] = _chunks[i];
+            continue;
+        }
+        if (_chunks[i].owns_data) {
+            total_bytes_released += _chunks[i].size;
+            ChunkAllocator::instance()->free(_chunks[i].data, _chunks[i].size);
+        }
+    }
+    _chunks.resize(num_retained);
+    _last_offset_conversion_chunk_idx = -1;
+    _total_reserved_bytes = retained_bytes;
+
+    _mem_tracker->release(total_bytes_released);
+    if (PaloMetrics::mem_pool_total_bytes() != NULL) {
+        PaloMetrics::mem_pool_total_bytes()->increment(-total_bytes_released);
+    }
+}
+
 bool MemPool::find_chunk(int64_t min_size, bool check_limits) {
     // Try to allocate from a free chunk. The first free chunk, if any, will be immediately
     // after the current chunk.
@@ -152,7 +179,7 @@ bool MemPool::find_chunk(int64_t min_size, bool check_limits) {
         }
 
         // Allocate a new chunk. Return early if malloc fails.
-        uint8_t* buf = reinterpret_cast<uint8_t*>(malloc(chunk_size));
+        uint8_t* buf = ChunkAllocator::instance()->allocate(chunk_size);
         if (UNLIKELY(buf == NULL)) {
             _mem_tracker->release(chunk_size);
             DCHECK_EQ(_current_chunk_idx, static_cast<int>(_chunks.size()));
@@ -83,6 +83,9 @@ class MemTracker;
 // remains unchanged.
 // The one remaining (empty) chunk is released:
 //    delete p;
+//
+// Chunks come from and go back to ChunkAllocator, which keeps freed chunks of the
+// common sizes for reuse.
 
 class MemPool {
 public:
@@ -136,6 +139,11 @@ public:
         DCHECK(check_integrity(false));
     }
 
+    // Like clear(), but only keeps chunks up to a total size of 'max_retained_bytes'
+    // and frees the others. Lets a pool that is reset for every row batch reuse its
+    // chunks without holding on to the memory of an unusually large batch.
+    void clear_and_trim(int64_t max_retained_bytes);
+
     // Deletes all allocated chunks. FreeAll() or AcquireData() must be called for
     // each mem pool
     void free_all();
@@ -20,13 +20,17 @@
 
 #include "runtime/mem_tracker.h"
 
+#include <sched.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <limits>
 #include <memory>
 //#include <boost/lexical_cast.hpp>
 //#include <boost/shared_ptr.hpp>
 //include <boost/weak_ptr.hpp>
 
+#include "common/config.h"
 #include "gutil/strings/substitute.h"
 #include "runtime/exec_env.h"
 #include "runtime/runtime_state.h"
@@ -46,6 +50,7 @@
 namespace palo {
 
 const std::string MemTracker::COUNTER_NAME = "PeakMemoryUsage";
+const int MemTracker::NUM_CONSUMPTION_SHARDS;
 
 // Name for request pool MemTrackers. '$0' is replaced with the pool name.
 const std::string REQUEST_POOL_MEM_TRACKER_LABEL_FORMAT = "RequestPool=$0";
@@ -57,6 +62,7 @@ MemTracker::MemTracker(
     _parent(parent),
     _consumption(&_local_counter),
     _local_counter(TUnit::BYTES),
+    _consumption_batch_bytes(0),
     _consumption_metric(NULL),
     _log_usage_if_zero(log_usage_if_zero),
     _num_gcs_metric(NULL),
@@ -74,6 +80,7 @@ MemTracker::MemTracker(RuntimeProfile* profile, int64_t byte_limit,
     _parent(parent),
     _consumption(profile->AddHighWaterMarkCounter(COUNTER_NAME, TUnit::BYTES)),
     _local_counter(TUnit::BYTES),
+    _consumption_batch_bytes(0),
     _consumption_metric(NULL),
     _log_usage_if_zero(true),
     _num_gcs_metric(NULL),
@@ -91,6 +98,7 @@ MemTracker::MemTracker(
     _parent(NULL),
     _consumption(&_local_counter),
     _local_counter(TUnit::BYTES),
+    _consumption_batch_bytes(0),
     _consumption_metric(consumption_metric),
     _log_usage_if_zero(true),
     _num_gcs_metric(NULL),
@@ -180,10 +188,59 @@ MemTracker* MemTracker::CreateQueryMemTracker(const TUniqueId& id,
 }
 
 MemTracker::~MemTracker() {
-    DCHECK_EQ(_consumption->current_value(), 0) << _label << "\n"
+    DCHECK_EQ(consumption(), 0) << _label << "\n"
         << get_stack_trace() << "\n"
         << LogUsage("");
     delete _reservation_counters.load();
+    free(_consumption_shards.load());
+}
+
+void MemTracker::init_consumption_shards() {
+    if (config::mem_tracker_consume_batch_bytes <= 0 || _consumption_metric != NULL) {
+        return;
+    }
+
+    void* shards = NULL;
+
+    if (posix_memalign(&shards, CACHELINE_SIZE,
+                       NUM_CONSUMPTION_SHARDS * sizeof(ConsumptionShard)) != 0) {
+        return;
+    }
+
+    memset(shards, 0, NUM_CONSUMPTION_SHARDS * sizeof(ConsumptionShard));
+    _consumption_batch_bytes = config::mem_tracker_consume_batch_bytes;
+    _consumption_shards.store(reinterpret_cast<ConsumptionShard*>(shards));
+}
+
+void MemTracker::flush_consumption_shards() {
+    ConsumptionShard* shards = _consumption_shards.load();
+
+    if (shards == NULL) {
+        return;
+    }
+
+    for (int i = 0; i < NUM_CONSUMPTION_SHARDS; ++i) {
+        // skip the atomic write for idle cpus
+        if (shards[i].bytes.load() != 0) {
+            _consumption->Add(shards[i].bytes.swap(0));
+        }
+    }
+}
+
+int64_t MemTracker::buffered_consumption() const {
+    ConsumptionShard* shards = _consumption_shards.load();
+    int64_t bytes = 0;
+
+    for (int i = 0; i < NUM_CONSUMPTION_SHARDS; ++i) {
+        bytes += shards[i].bytes.load();
+    }
+
+    return bytes;
+}
+
+int MemTracker::current_shard() {
+    int cpu = sched_getcpu();
+    return cpu < 0 ? 0 : cpu % NUM_CONSUMPTION_SHARDS;
 }
 
 // Calling this on the query tracker results in output like:
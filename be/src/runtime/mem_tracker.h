@@ -30,6 +30,8 @@
 #include "gen_cpp/Types_types.h"
 #include <util/palo_metrics.h>
 #include "util/runtime_profile.h"
+#include "common/atomic.h"
+#include "gutil/port.h"
 #include "util/spinlock.h"
 
 namespace palo {
@@ -130,10 +132,7 @@ public:
         }
         for (std::vector<MemTracker*>::iterator tracker = _all_trackers.begin();
              tracker != _all_trackers.end(); ++tracker) {
-            (*tracker)->_consumption->Add(bytes);
-            if ((*tracker)->_consumption_metric == NULL) {
-                DCHECK_GE((*tracker)->_consumption->current_value(), 0);
-            }
+            (*tracker)->add_consumption(bytes);
         }
     }
 
@@ -147,7 +146,7 @@ public:
         for (int i = 0; i < _all_trackers.size(); ++i) {
             if (_all_trackers[i] == end_tracker) return;
             DCHECK(!_all_trackers[i]->has_limit());
-            _all_trackers[i]->_consumption->Add(bytes);
+            _all_trackers[i]->add_consumption(bytes);
         }
         DCHECK(false) << "end_tracker is not an ancestor";
     }
@@ -169,9 +168,12 @@ public:
         for (i = _all_trackers.size() - 1; i >= 0; --i) {
             MemTracker* tracker = _all_trackers[i];
             const int64_t limit = tracker->limit();
-            if (limit < 0) {
-                tracker->_consumption->Add(bytes); // No limit at this tracker.
+            if (limit < 0 || (tracker->_consumption_shards.load() != NULL
+                        && !tracker->near_limit(bytes))) {
+                // No limit at this tracker, or far enough from it to buffer 'bytes'.
+                tracker->add_consumption(bytes);
             } else {
+                tracker->flush_consumption_shards();
                 // If TryConsume fails, we can try to GC, but we may need to try several times if
                 // there are concurrent consumers because we don't take a lock before trying to
                 // update _consumption.
@@ -185,7 +187,7 @@ public:
                         DCHECK_GE(i, 0);
                         // Failed for this mem tracker. Roll back the ones that succeeded.
                         for (int j = _all_trackers.size() - 1; j > i; --j) {
-                            _all_trackers[j]->_consumption->Add(-bytes);
+                            _all_trackers[j]->add_consumption(-bytes);
                         }
                         return false;
                     }
@@ -213,14 +215,17 @@ public:
         }
         for (std::vector<MemTracker*>::iterator tracker = _all_trackers.begin();
              tracker != _all_trackers.end(); ++tracker) {
-            (*tracker)->_consumption->Add(-bytes);
+            (*tracker)->add_consumption(-bytes);
             /// If a UDF calls FunctionContext::TrackAllocation() but allocates less than the
             /// reported amount, the subsequent call to FunctionContext::Free() may cause the
             /// process mem tracker to go negative until it is synced back to the tcmalloc
             /// metric. Don't blow up in this case. (Note that this doesn't affect non-process
             /// trackers since we can enforce that the reported memory usage is internally
             /// consistent.)
-            if ((*tracker)->_consumption_metric == NULL) {
+            /// Trackers with consumption shards may go below zero while the bytes of a
+            /// consume() are still buffered on another cpu.
+            if ((*tracker)->_consumption_metric == NULL
+                    && (*tracker)->_consumption_shards.load() == NULL) {
                 DCHECK_GE((*tracker)->_consumption->current_value(), 0)
                     << std::endl << (*tracker)->LogUsage();
             }
@@ -297,13 +302,17 @@ public:
     int64_t GetPoolMemReserved() const;
 
     int64_t consumption() const {
-        return _consumption->current_value();;
+        if (_consumption_shards.load() == NULL) {
+            return _consumption->current_value();
+        }
+        return _consumption->current_value() + buffered_consumption();
     }
 
 
     /// Note that if _consumption is based on _consumption_metric, this will the max value
     /// we've recorded in consumption(), not necessarily the highest value
     /// _consumption_metric has ever reached.
+    /// The peak of a tracker with consumption shards may miss the bytes buffered then.
     int64_t peak_consumption() const { return _consumption->value(); }
 
     MemTracker* parent() const {
@@ -365,7 +374,7 @@ public:
     std::string debug_string() {
         std::stringstream msg;
         msg << "limit: " << _limit << "; "
-            << "consumption: " << _consumption->current_value() << "; "
+            << "consumption: " << consumption() << "; "
             << "label: " << _label << "; "
             << "all tracker size: " << _all_trackers.size() << "; "
             << "limit trackers size: " << _limit_trackers.size() << "; "
@@ -388,8 +397,65 @@ private:
     void add_child_tracker(MemTracker* tracker) {
         std::lock_guard<std::mutex> l(_child_trackers_lock);
         tracker->_child_tracker_it = _child_trackers.insert(_child_trackers.end(), tracker);
+        if (_consumption_shards.load() == NULL) {
+            init_consumption_shards();
+        }
+    }
+
+    /// Consumption of one cpu not yet added to _consumption, alone in its cache line.
+    struct CACHELINE_ALIGNED ConsumptionShard {
+        AtomicInt64 bytes;
+    };
+
+    static const int NUM_CONSUMPTION_SHARDS = 32;
+
+    /// Creates _consumption_shards if config::mem_tracker_consume_batch_bytes > 0 and this
+    /// tracker isn't based on a metric. Called with _child_trackers_lock held.
+    void init_consumption_shards();
+
+    /// Returns true if 'bytes' more may leave less room below the limit than the shards
+    /// can buffer. Such changes are applied to _consumption directly, so that the limit
+    /// is checked precisely.
+    bool near_limit(int64_t bytes) const {
+        return _limit >= 0 && _consumption->current_value() + bytes
+            + NUM_CONSUMPTION_SHARDS * _consumption_batch_bytes > _limit;
+    }
+
+    /// Adds 'bytes' to the consumption of this tracker alone. If it has consumption
+    /// shards and isn't near its limit, 'bytes' goes to the shard of the current cpu,
+    /// which is added to _consumption once it holds more than _consumption_batch_bytes
+    /// either way.
+    void add_consumption(int64_t bytes) {
+        ConsumptionShard* shards = _consumption_shards.load();
+
+        if (shards == NULL) {
+            _consumption->Add(bytes);
+            return;
+        }
+
+        if (UNLIKELY(near_limit(bytes))) {
+            flush_consumption_shards();
+            _consumption->Add(bytes);
+            return;
+        }
+
+        ConsumptionShard* shard = &shards[current_shard()];
+        int64_t buffered = shard->bytes.add(bytes);
+
+        if (UNLIKELY(buffered > _consumption_batch_bytes
+                || buffered < -_consumption_batch_bytes)) {
+            _consumption->Add(shard->bytes.swap(0));
+        }
     }
 
+    /// Adds the bytes buffered in all shards to _consumption.
+    void flush_consumption_shards();
+
+    /// Sum of the bytes buffered in all shards.
+    int64_t buffered_consumption() const;
+
+    static int current_shard();
+
     /// Log consumption of all the trackers provided. Returns the sum of consumption in
     /// 'logged_consumption'.
     static std::string LogUsage(const std::string& prefix,
@@ -427,6 +493,14 @@ private:
     /// holds _consumption counter if not tied to a profile
     RuntimeProfile::HighWaterMarkCounter _local_counter;
 
+    /// NUM_CONSUMPTION_SHARDS changes of the consumption by cpu, not yet in _consumption.
+    /// Only trackers with children have them, since those are updated by many threads
+    /// at once and their _consumption would be contended otherwise. NULL before.
+    AtomicPtr<ConsumptionShard> _consumption_shards;
+
+    /// config::mem_tracker_consume_batch_bytes when the shards were created
+    int64_t _consumption_batch_bytes;
+
     /// If non-NULL, used to measure consumption (in bytes) rather than the values provided
     /// to Consume()/Release(). Only used for the process tracker, thus parent_ should be
     /// NULL if _consumption_metric is set.
@@ -23,8 +23,10 @@
 #include "runtime/row_batch.h"
 #include "runtime/runtime_state.h"
 #include "util/runtime_profile.h"
+#include "util/sort_key_normalizer.h"
 #include <string>
 #include <boost/foreach.hpp>
+#include "common/config.h"
 #include "runtime/mem_tracker.h"
 
 namespace palo {
@@ -157,7 +159,9 @@ public:
 
     void sort(Run* run) {
         _run = run;
-        sort_helper(TupleIterator(this, 0), TupleIterator(this, _run->_num_tuples));
+        if (!sort_normalized()) {
+            sort_helper(TupleIterator(this, 0), TupleIterator(this, _run->_num_tuples));
+        }
         run->_is_sorted = true;
     }
 
@@ -281,6 +285,15 @@ private:
 
     // Swaps tuples pointed to by left and right using the swap buffer.
     void swap(uint8_t* left, uint8_t* right);
+
+    // Sorts the tuples of the run by their normalized keys. Returns false and leaves the
+    // tuples as they are if the keys can't be normalized or the memory for them is not
+    // available.
+    bool sort_normalized();
+
+    // Encodes the keys of _less_than_comp, its width is 0 if enable_normalized_sort_key
+    // is off or the first key can't be normalized.
+    SortKeyNormalizer _normalizer;
 }; // class TupleSorter
 
 // MergeSorter::Run methods
@@ -482,6 +495,29 @@ MergeSorter::TupleSorter::TupleSorter(const TupleRowComparator& comp, int64_t bl
     _temp_tuple_buffer = new uint8_t[tuple_size];
     _temp_tuple_row = reinterpret_cast<TupleRow*>(&_temp_tuple_buffer);
     _swap_buffer = new uint8_t[tuple_size];
+    if (config::enable_normalized_sort_key) {
+        _normalizer.init(_less_than_comp);
+    }
+}
+
+bool MergeSorter::TupleSorter::sort_normalized() {
+    int64_t num_tuples = _run->_num_tuples;
+    if (_normalizer.width() == 0 || num_tuples <= INSERTION_THRESHOLD) {
+        return false;
+    }
+    MemTracker* mem_tracker = _state->instance_mem_tracker();
+    int64_t mem = _normalizer.sort_memory(num_tuples) + num_tuples * sizeof(uint8_t*);
+    if (!mem_tracker->try_consume(mem)) {
+        return false;
+    }
+    std::vector<uint8_t*> tuples;
+    tuples.reserve(num_tuples);
+    for (TupleIterator iter(this, 0); iter._index < num_tuples; iter.next()) {
+        tuples.push_back(iter._current_tuple);
+    }
+    _normalizer.sort_tuples(tuples.data(), num_tuples, _tuple_size, _less_than_comp);
+    mem_tracker->release(mem);
+    return true;
 }
 
 
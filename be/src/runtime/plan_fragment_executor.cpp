@@ -31,17 +31,23 @@
 #include "exec/data_sink.h"
 #include "exec/exec_node.h"
 #include "exec/exchange_node.h"
+#include "exec/olap_scan_node.h"
 #include "exec/scan_node.h"
 #include "exprs/expr.h"
 #include "runtime/descriptors.h"
 #include "runtime/data_stream_mgr.h"
+#include "runtime/fragment_template_cache.h"
+#include "runtime/mem_arbitrator.h"
 #include "runtime/result_buffer_mgr.h"
+#include "runtime/result_cache.h"
+#include "runtime/result_sink.h"
 #include "runtime/row_batch.h"
 #include "runtime/mem_tracker.h"
 #include "util/cpu_info.h"
 #include "util/debug_util.h"
 #include "util/container_util.hpp"
 #include "util/parse_util.h"
+#include "util/query_trace.h"
 #include "util/mem_info.h"
 
 namespace palo {
@@ -55,7 +61,8 @@ PlanFragmentExecutor::PlanFragmentExecutor(
       _prepared(false),
       _closed(false),
       _has_thread_token(false),
-      _is_report_success(true) {
+      _is_report_success(true),
+      _is_result_cache_hit(false) {
 }
 
 PlanFragmentExecutor::~PlanFragmentExecutor() {
@@ -77,6 +84,13 @@ Status PlanFragmentExecutor::prepare(const TExecPlanFragmentParams& request) {
 
     _runtime_state.reset(new RuntimeState(
             request, request.query_options, request.query_globals.now_string, _exec_env));
+    if (request.query_options.enable_query_trace) {
+        _runtime_state->set_query_trace(QueryTraceMgr::instance()->get_or_create(_query_id));
+    }
+    ScopedTraceSpan prepare_span(_runtime_state->query_trace(), "fragment", "prepare");
+    if (prepare_span.enabled()) {
+        prepare_span.set_detail("instance_id=" + print_id(params.fragment_instance_id));
+    }
 
     RETURN_IF_ERROR(_runtime_state->init_mem_trackers(_query_id));
     _runtime_state->set_be_number(request.backend_num);
@@ -133,16 +147,30 @@ Status PlanFragmentExecutor::prepare(const TExecPlanFragmentParams& request) {
 
     RETURN_IF_ERROR(_runtime_state->create_block_mgr());
 
-    // set up desc tbl
-    DescriptorTbl* desc_tbl = NULL;
+    // set up desc tbl, shared with the other executions of the plan if possible
     DCHECK(request.__isset.desc_tbl);
-    RETURN_IF_ERROR(DescriptorTbl::create(obj_pool(), request.desc_tbl, &desc_tbl));
+    DCHECK(request.__isset.fragment);
+    if (config::fragment_template_cache_capacity_bytes > 0
+            && FragmentTemplateCache::is_cacheable(request)) {
+        RETURN_IF_ERROR(_exec_env->fragment_template_cache()->get_or_create(
+                request, &_fragment_template));
+    } else {
+        RETURN_IF_ERROR(FragmentTemplateCache::create(request, &_fragment_template));
+    }
+    DescriptorTbl* desc_tbl = _fragment_template->desc_tbl;
     _runtime_state->set_desc_tbl(desc_tbl);
 
     // set up plan
-    DCHECK(request.__isset.fragment);
-    RETURN_IF_ERROR(
-            ExecNode::create_tree(obj_pool(), request.fragment.plan, *desc_tbl, &_plan));
+    // a plan that exceeded its memory limit before runs with the spilling nodes
+    int64_t plan_fingerprint = _fragment_template->plan_fingerprint;
+    _runtime_state->mem_arbitrator()->set_plan_fingerprint(plan_fingerprint);
+    bool prefer_spilling = MemArbitrator::plan_exceeded_before(plan_fingerprint);
+    if (prefer_spilling) {
+        LOG(INFO) << "Plan of fragment instance " << print_id(params.fragment_instance_id)
+                  << " exceeded its memory limit before, using spilling nodes";
+    }
+    RETURN_IF_ERROR(ExecNode::create_tree(
+            obj_pool(), request.fragment.plan, *desc_tbl, prefer_spilling, &_plan));
     _runtime_state->set_fragment_root_id(_plan->id());
 
     if (request.params.__isset.debug_node_id) {
@@ -172,6 +200,12 @@ Status PlanFragmentExecutor::prepare(const TExecPlanFragmentParams& request) {
     VLOG(1) << "scan_nodes.size()=" << scan_nodes.size();
     VLOG(1) << "params.per_node_scan_ranges.size()=" << params.per_node_scan_ranges.size();
 
+    if (config::partial_agg_cache_capacity_bytes > 0
+            && request.fragment.__isset.output_sink
+            && request.fragment.output_sink.type == TDataSinkType::DATA_STREAM_SINK) {
+        set_partial_agg_cache(request, scan_nodes);
+    }
+
     for (int i = 0; i < scan_nodes.size(); ++i) {
         ScanNode* scan_node = static_cast<ScanNode*>(scan_nodes[i]);
         const std::vector<TScanRangeParams>& scan_ranges =
@@ -195,6 +229,15 @@ Status PlanFragmentExecutor::prepare(const TExecPlanFragmentParams& request) {
         if (sink_profile != NULL) {
             profile()->add_child(sink_profile, true, NULL);
         }
+
+        std::string cache_key;
+
+        if (config::result_cache_capacity_bytes > 0
+                && ResultCache::make_key(request, &cache_key)) {
+            ResultSink* result_sink = static_cast<ResultSink*>(_sink.get());
+            result_sink->set_result_cache(_exec_env->result_cache(), cache_key);
+            _is_result_cache_hit = result_sink->has_cached_result();
+        }
     } else {
         _sink.reset(NULL);
     }
@@ -284,8 +327,20 @@ Status PlanFragmentExecutor::open() {
 }
 
 Status PlanFragmentExecutor::open_internal() {
+    if (_is_result_cache_hit) {
+        SCOPED_TIMER(profile()->total_time_counter());
+        RETURN_IF_ERROR(_sink->open(runtime_state()));
+        RETURN_IF_ERROR(static_cast<ResultSink*>(_sink.get())->send_cached_result(
+                runtime_state()));
+        return close_sink();
+    }
+
     {
         SCOPED_TIMER(profile()->total_time_counter());
+        ScopedTraceSpan open_span(_runtime_state->query_trace(), "fragment", "open");
+        if (open_span.enabled()) {
+            open_span.set_detail("instance_id=" + print_id(_runtime_state->fragment_instance_id()));
+        }
         RETURN_IF_ERROR(_plan->open(_runtime_state.get()));
     }
 
@@ -294,6 +349,10 @@ Status PlanFragmentExecutor::open_internal() {
     }
     RETURN_IF_ERROR(_sink->open(runtime_state()));
 
+    if (_cached_partial_agg.get() != NULL) {
+        RETURN_IF_ERROR(send_cached_partial_agg());
+    }
+
     // If there is a sink, do all the work of driving it here, so that
     // when this returns the query has actually finished
     RowBatch* batch = NULL;
@@ -315,10 +374,102 @@ Status PlanFragmentExecutor::open_internal() {
             }
         }
 
+        if (_partial_agg_fill.get() != NULL) {
+            fill_partial_agg_cache(batch);
+        }
+
         SCOPED_TIMER(profile()->total_time_counter());
         RETURN_IF_ERROR(_sink->send(runtime_state(), batch));
     }
 
+    RETURN_IF_ERROR(close_sink());
+
+    if (_partial_agg_fill.get() != NULL) {
+        _exec_env->partial_agg_cache()->insert(_partial_agg_cache_key, _partial_agg_fill);
+        _partial_agg_fill.reset();
+    }
+
+    return Status::OK;
+}
+
+void PlanFragmentExecutor::set_partial_agg_cache(
+        const TExecPlanFragmentParams& request, const std::vector<ExecNode*>& scan_nodes) {
+    TabletVersionMap versions;
+
+    if (scan_nodes.size() != 1
+            || !PartialAggCache::make_key(request, &_partial_agg_cache_key, &versions)) {
+        return;
+    }
+
+    PartialAggCache* cache = _exec_env->partial_agg_cache();
+    std::map<int64_t, int64_t> start_versions;
+    _cached_partial_agg = cache->lookup(_partial_agg_cache_key);
+
+    if (_cached_partial_agg.get() != NULL && !PartialAggCache::get_start_versions(
+                _cached_partial_agg->versions, versions, &start_versions)) {
+        _cached_partial_agg.reset();
+    }
+
+    _partial_agg_fill.reset(new CachedPartialAgg());
+    _partial_agg_fill->versions = versions;
+
+    if (_cached_partial_agg.get() == NULL) {
+        profile()->add_info_string("PartialAggCache", "miss");
+        return;
+    }
+
+    profile()->add_info_string("PartialAggCache", "hit");
+    static_cast<OlapScanNode*>(scan_nodes[0])->set_start_versions(start_versions);
+    bool has_new_versions = false;
+
+    for (TabletVersionMap::const_iterator it = versions.begin(); it != versions.end(); ++it) {
+        if (start_versions[it->first] <= it->second.version) {
+            has_new_versions = true;
+        }
+    }
+
+    if (!has_new_versions) {
+        // the entry is up to date
+        _partial_agg_fill.reset();
+        return;
+    }
+
+    // the new entry covers the cached versions as well as the deltas
+    _partial_agg_fill->batches = _cached_partial_agg->batches;
+    _partial_agg_fill->bytes = _cached_partial_agg->bytes;
+}
+
+Status PlanFragmentExecutor::send_cached_partial_agg() {
+    SCOPED_TIMER(profile()->total_time_counter());
+    const std::vector<TRowBatch>& batches = _cached_partial_agg->batches;
+
+    for (int i = 0; i < batches.size(); ++i) {
+        RETURN_IF_CANCELLED(runtime_state());
+        RowBatch batch(row_desc(), batches[i], runtime_state()->instance_mem_tracker());
+        RETURN_IF_ERROR(_sink->send(runtime_state(), &batch));
+    }
+
+    _cached_partial_agg.reset();
+    return Status::OK;
+}
+
+void PlanFragmentExecutor::fill_partial_agg_cache(RowBatch* batch) {
+    if (batch->num_rows() == 0) {
+        return;
+    }
+
+    _partial_agg_fill->batches.push_back(TRowBatch());
+    TRowBatch* thrift_batch = &_partial_agg_fill->batches.back();
+    batch->serialize(thrift_batch);
+    _partial_agg_fill->bytes += RowBatch::get_batch_size(*thrift_batch);
+
+    if (_partial_agg_fill->bytes > config::partial_agg_cache_max_entry_bytes) {
+        // too large to be cached
+        _partial_agg_fill.reset();
+    }
+}
+
+Status PlanFragmentExecutor::close_sink() {
     // Close the sink *before* stopping the report thread. Close may
     // need to add some important information to the last report that
     // gets sent. (e.g. table sinks record the files they have written
@@ -504,6 +655,12 @@ void PlanFragmentExecutor::cancel() {
     _runtime_state->result_mgr()->cancel(_runtime_state->fragment_instance_id());
 }
 
+void PlanFragmentExecutor::abort(const Status& status) {
+    DCHECK(!status.ok());
+    cancel();
+    update_status(status);
+}
+
 const RowDescriptor& PlanFragmentExecutor::row_desc() {
     return _plan->row_desc();
 }
@@ -21,8 +21,10 @@
 #ifndef BDG_PALO_BE_RUNTIME_PLAN_FRAGMENT_EXECUTOR_H
 #define BDG_PALO_BE_RUNTIME_PLAN_FRAGMENT_EXECUTOR_H
 
+#include <string>
 #include <vector>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/function.hpp>
 
 #include "common/status.h"
@@ -44,6 +46,8 @@ class TPlanExecRequest;
 class TPlanFragment;
 class TPlanFragmentExecParams;
 class TPlanExecParams;
+struct CachedPartialAgg;
+struct FragmentTemplate;
 
 // PlanFragmentExecutor handles all aspects of the execution of a single plan fragment,
 // including setup and tear-down, both in the success and error case.
@@ -120,6 +124,10 @@ public:
     // Initiate cancellation. Must not be called until after prepare() returned.
     void cancel();
 
+    // Cancels the fragment and reports 'status' as its final status to the
+    // coordinator. Called instead of open() for a fragment that won't be executed.
+    void abort(const Status& status);
+
     // Releases the thread token for this fragment executor.
     void release_thread_token();
 
@@ -174,6 +182,17 @@ private:
 
     bool _is_report_success;
 
+    // true if the result sink found the result of this fragment in the result cache,
+    // open() sends it instead of running the plan
+    bool _is_result_cache_hit;
+
+    // key of this fragment in the partial aggregation cache, see PartialAggCache
+    std::string _partial_agg_cache_key;
+    // cached output over the older tablet versions, sent before the output of the plan
+    boost::shared_ptr<const CachedPartialAgg> _cached_partial_agg;
+    // the output recorded for the partial aggregation cache, NULL if it's not cached
+    boost::shared_ptr<CachedPartialAgg> _partial_agg_fill;
+
     // Overall execution status. Either ok() or set to the first error status that
     // was encountered.
     Status _status;
@@ -184,6 +203,10 @@ private:
     // 2. _status_lock
     boost::mutex _status_lock;
 
+    // descriptor table of the plan, maybe shared with other fragments, see
+    // FragmentTemplateCache. Declared before _runtime_state to outlive it.
+    boost::shared_ptr<const FragmentTemplate> _fragment_template;
+
     // Output sink for rows sent to this fragment. May not be set, in which case rows are
     // returned via get_next's row batch
     // Created in prepare (if required), owned by this object.
@@ -242,6 +265,22 @@ private:
     // have been stopped. _sink will be set to NULL after successful execution.
     Status open_internal();
 
+    // Closes the sink after all rows were sent, sends the final report and stops the
+    // report thread. Part of open_internal().
+    Status close_sink();
+
+    // Looks up the output of this fragment in the partial aggregation cache and, if it
+    // was made over older versions of the same tablets, makes the scan node read only
+    // the newer ones. Must be called before the scan ranges are set.
+    void set_partial_agg_cache(const TExecPlanFragmentParams& request,
+                               const std::vector<ExecNode*>& scan_nodes);
+
+    // Sends the output found by set_partial_agg_cache() to the sink.
+    Status send_cached_partial_agg();
+
+    // Records 'batch' in _partial_agg_fill, dropping it if it gets too large.
+    void fill_partial_agg_cache(RowBatch* batch);
+
     // Executes get_next() logic and returns resulting status.
     Status get_next_internal(RowBatch** batch);
 
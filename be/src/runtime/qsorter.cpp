@@ -20,15 +20,22 @@
 
 #include "runtime/qsorter.h"
 
+#include <string.h>
+
 #include <algorithm>
+#include <thread>
 
+#include "common/config.h"
 #include "exprs/expr.h"
 #include "runtime/descriptors.h"
 #include "runtime/raw_value.h"
 #include "runtime/row_batch.h"
 #include "runtime/runtime_state.h"
+#include "runtime/string_value.h"
 #include "runtime/tuple_row.h"
+#include "runtime/datetime_value.h"
 #include "util/debug_util.h"
+#include "util/radix_sort.h"
 
 namespace palo {
 
@@ -81,6 +88,78 @@ bool TupleRowLessThan::operator()(TupleRow* const& lhs, TupleRow* const& rhs) co
     return false;
 }
 
+// A row with the prefix of its first sort key, which is a string.
+struct SortEntry {
+    StringValuePrefix key;
+    TupleRow* row;
+};
+
+// Orders entries by the key prefixes where they are enough and by the rows otherwise,
+// so that most comparisons of short or distinct keys don't evaluate exprs or touch the
+// string data.
+class SortEntryLessThan {
+public:
+    SortEntryLessThan(const TupleRowLessThan& row_less_than) :
+            _row_less_than(row_less_than) {
+    }
+
+    bool operator()(const SortEntry& lhs, const SortEntry& rhs) const {
+        if (!lhs.key.is_null() && !rhs.key.is_null()) {
+            bool decided = false;
+            int result = lhs.key.compare(rhs.key, &decided);
+            if (decided && result != 0) {
+                return result < 0;
+            }
+        } else if (lhs.key.is_null() != rhs.key.is_null()) {
+            // same order of NULLs as TupleRowLessThan
+            return lhs.key.is_null();
+        }
+        return _row_less_than(lhs.row, rhs.row);
+    }
+
+private:
+    const TupleRowLessThan& _row_less_than;
+};
+
+// Rows sorted per thread at least, fewer rows are sorted on the calling thread
+static const int MIN_ROWS_PER_SORT_THREAD = 64 * 1024;
+// Keys sampled per thread to pick the splitters of the sample sort
+static const int SAMPLES_PER_SORT_THREAD = 128;
+
+// A row with its normalized key. The first 8 bytes of the key are kept in the entry
+// as a number, so that most comparisons don't touch the key bytes.
+struct NormalizedEntry {
+    uint64_t head;
+    const uint8_t* key;
+    TupleRow* row;
+};
+
+class NormalizedEntryLessThan {
+public:
+    // 'row_less_than' breaks the ties of incomplete keys, NULL if the keys are complete.
+    NormalizedEntryLessThan(int key_width, const TupleRowLessThan* row_less_than) :
+            _key_width(key_width),
+            _row_less_than(row_less_than) {
+    }
+
+    bool operator()(const NormalizedEntry& lhs, const NormalizedEntry& rhs) const {
+        if (lhs.head != rhs.head) {
+            return lhs.head < rhs.head;
+        }
+        if (_key_width > 8) {
+            int result = memcmp(lhs.key + 8, rhs.key + 8, _key_width - 8);
+            if (result != 0) {
+                return result < 0;
+            }
+        }
+        return _row_less_than != NULL && (*_row_less_than)(lhs.row, rhs.row);
+    }
+
+private:
+    int _key_width;
+    const TupleRowLessThan* _row_less_than;
+};
+
 QSorter::QSorter(
             const RowDescriptor& row_desc,
             const std::vector<ExprContext*>& order_expr_ctxs,
@@ -93,6 +172,23 @@ QSorter::QSorter(
 Status QSorter::prepare(RuntimeState* state) {
     RETURN_IF_ERROR(Expr::clone_if_not_exists(_order_expr_ctxs, state, &_lhs_expr_ctxs));
     RETURN_IF_ERROR(Expr::clone_if_not_exists(_order_expr_ctxs, state, &_rhs_expr_ctxs));
+
+    if (config::enable_normalized_sort_key) {
+        // ascending, NULLs go at the end like in TupleRowLessThan
+        _normalizer.init(_lhs_expr_ctxs, std::vector<bool>(_lhs_expr_ctxs.size(), true),
+                         std::vector<int8_t>(_lhs_expr_ctxs.size(), 1));
+        if (_normalizer.width() > 0 && !_normalizer.complete()) {
+            // ties are compared with the exprs, every sort thread needs its own
+            for (int i = 1; i < config::dpp_sort_threads; ++i) {
+                _thread_lhs_expr_ctxs.emplace_back();
+                _thread_rhs_expr_ctxs.emplace_back();
+                RETURN_IF_ERROR(Expr::clone_if_not_exists(
+                        _order_expr_ctxs, state, &_thread_lhs_expr_ctxs.back()));
+                RETURN_IF_ERROR(Expr::clone_if_not_exists(
+                        _order_expr_ctxs, state, &_thread_rhs_expr_ctxs.back()));
+            }
+        }
+    }
     return Status::OK;
 }
 
@@ -117,12 +213,125 @@ Status QSorter::add_batch(RowBatch* batch) {
 
 // Reverse result in priority_queue
 Status QSorter::input_done() {
-    std::sort(_sorted_rows.begin(), _sorted_rows.end(),
-              TupleRowLessThan(_lhs_expr_ctxs, _rhs_expr_ctxs));
+    if (_normalizer.width() > 0) {
+        sort_normalized();
+        _next_iter = _sorted_rows.begin();
+        return Status::OK;
+    }
+    TupleRowLessThan row_less_than(_lhs_expr_ctxs, _rhs_expr_ctxs);
+    if (config::enable_string_key_prefix && !_lhs_expr_ctxs.empty()
+            && _lhs_expr_ctxs[0]->root()->type().is_string_type()) {
+        std::vector<SortEntry> entries(_sorted_rows.size());
+        for (int i = 0; i < _sorted_rows.size(); ++i) {
+            void* value = _lhs_expr_ctxs[0]->get_value(_sorted_rows[i]);
+            if (value != NULL) {
+                entries[i].key = StringValuePrefix(*reinterpret_cast<StringValue*>(value));
+            }
+            entries[i].row = _sorted_rows[i];
+        }
+        std::sort(entries.begin(), entries.end(), SortEntryLessThan(row_less_than));
+        for (int i = 0; i < entries.size(); ++i) {
+            _sorted_rows[i] = entries[i].row;
+        }
+    } else {
+        std::sort(_sorted_rows.begin(), _sorted_rows.end(), row_less_than);
+    }
     _next_iter = _sorted_rows.begin();
     return Status::OK;
 }
 
+void QSorter::sort_normalized() {
+    int num_rows = _sorted_rows.size();
+    int key_width = _normalizer.width();
+    // the head of an entry is read from the first 8 bytes of the key
+    int stride = std::max(key_width, 8);
+    std::vector<uint8_t> keys((size_t) num_rows * stride, 0);
+    std::vector<NormalizedEntry> entries(num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+        uint8_t* key = &keys[(size_t) i * stride];
+        _normalizer.encode(_sorted_rows[i], key);
+        uint64_t head = 0;
+        for (int j = 0; j < 8; ++j) {
+            head = (head << 8) | key[j];
+        }
+        entries[i].head = head;
+        entries[i].key = key;
+        entries[i].row = _sorted_rows[i];
+    }
+
+    TupleRowLessThan row_less_than(_lhs_expr_ctxs, _rhs_expr_ctxs);
+    NormalizedEntryLessThan less_than(
+        key_width, _normalizer.complete() ? NULL : &row_less_than);
+    int num_threads = std::min(config::dpp_sort_threads, num_rows / MIN_ROWS_PER_SORT_THREAD);
+    if (!_normalizer.complete()) {
+        num_threads = std::min<int>(num_threads, _thread_lhs_expr_ctxs.size() + 1);
+    }
+    if (num_threads <= 1) {
+        radix_sort(entries.data(), entries.data() + num_rows, less_than);
+        for (int i = 0; i < num_rows; ++i) {
+            _sorted_rows[i] = entries[i].row;
+        }
+        return;
+    }
+
+    // Sample sort: splitters picked from a sample divide the entries into one range per
+    // thread, equal keys always fall into the same range, and the threads sort the
+    // ranges. Only the key bytes decide the range, the exprs break ties within one.
+    NormalizedEntryLessThan key_less_than(key_width, NULL);
+    int num_samples = num_threads * SAMPLES_PER_SORT_THREAD;
+    std::vector<NormalizedEntry> samples;
+    samples.reserve(num_samples);
+    for (int i = 0; i < num_samples; ++i) {
+        samples.push_back(entries[(int64_t) i * num_rows / num_samples]);
+    }
+    std::sort(samples.begin(), samples.end(), key_less_than);
+    std::vector<NormalizedEntry> splitters;
+    for (int i = 1; i < num_threads; ++i) {
+        splitters.push_back(samples[i * SAMPLES_PER_SORT_THREAD]);
+    }
+
+    std::vector<int> ranges(num_rows);
+    std::vector<int> offsets(num_threads + 1, 0);
+    for (int i = 0; i < num_rows; ++i) {
+        ranges[i] = std::upper_bound(splitters.begin(), splitters.end(), entries[i],
+                                     key_less_than) - splitters.begin();
+        ++offsets[ranges[i] + 1];
+    }
+    for (int i = 1; i <= num_threads; ++i) {
+        offsets[i] += offsets[i - 1];
+    }
+    std::vector<NormalizedEntry> partitioned(num_rows);
+    std::vector<int> next(offsets.begin(), offsets.end() - 1);
+    for (int i = 0; i < num_rows; ++i) {
+        partitioned[next[ranges[i]]++] = entries[i];
+    }
+
+    auto sort_range = [&partitioned, &offsets, key_width](
+            int range, const TupleRowLessThan* tie_less_than) {
+        radix_sort(partitioned.data() + offsets[range],
+                   partitioned.data() + offsets[range + 1],
+                   NormalizedEntryLessThan(key_width, tie_less_than));
+    };
+    std::vector<TupleRowLessThan> thread_less_thans;
+    if (!_normalizer.complete()) {
+        for (int i = 0; i < num_threads - 1; ++i) {
+            thread_less_thans.emplace_back(_thread_lhs_expr_ctxs[i], _thread_rhs_expr_ctxs[i]);
+        }
+    }
+    std::vector<std::thread> threads;
+    for (int i = 1; i < num_threads; ++i) {
+        threads.emplace_back(sort_range, i,
+                             _normalizer.complete() ? NULL : &thread_less_thans[i - 1]);
+    }
+    sort_range(0, _normalizer.complete() ? NULL : &row_less_than);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int i = 0; i < num_rows; ++i) {
+        _sorted_rows[i] = partitioned[i].row;
+    }
+}
+
 Status QSorter::get_next(RowBatch* batch, bool* eos) {
     while (!batch->is_full() && (_next_iter != _sorted_rows.end())) {
         int row_idx = batch->add_row();
@@ -141,6 +350,10 @@ Status QSorter::close(RuntimeState* state) {
     _tuple_pool.reset();
     Expr::close(_lhs_expr_ctxs, state);
     Expr::close(_rhs_expr_ctxs, state);
+    for (int i = 0; i < _thread_lhs_expr_ctxs.size(); ++i) {
+        Expr::close(_thread_lhs_expr_ctxs[i], state);
+        Expr::close(_thread_rhs_expr_ctxs[i], state);
+    }
     return Status::OK;
 }
 
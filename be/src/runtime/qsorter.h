@@ -27,6 +27,7 @@
 
 #include "common/status.h"
 #include "runtime/sorter.h"
+#include "util/sort_key_normalizer.h"
 
 namespace palo {
 
@@ -70,11 +71,20 @@ public:
 private:
     Status insert_tuple_row(TupleRow* input_row);
 
+    // Sorts '_sorted_rows' by their normalized keys, see enable_normalized_sort_key.
+    void sort_normalized();
+
     const RowDescriptor& _row_desc;
     const std::vector<ExprContext*>& _order_expr_ctxs;
     std::vector<ExprContext*> _lhs_expr_ctxs;
     std::vector<ExprContext*> _rhs_expr_ctxs;
 
+    // Encodes the normalized keys of the rows, its width is 0 if they are not used
+    SortKeyNormalizer _normalizer;
+    // Copies of the order exprs for the threads that sort beyond the first one
+    std::vector<std::vector<ExprContext*>> _thread_lhs_expr_ctxs;
+    std::vector<std::vector<ExprContext*>> _thread_rhs_expr_ctxs;
+
     // After computing the TopN in the priority_queue, pop them and put them in this vector
     std::vector<TupleRow*> _sorted_rows;
     std::vector<TupleRow*>::iterator _next_iter;
@@ -85,6 +85,16 @@ public:
         return get_hash_value_fvn(value, type.type, seed);
     }
 
+    // Get the hash value using HashUtil::fast_hash64(), which gives uncorrelated hashes
+    // with different seeds and the same hashes on all hosts. 'value' is NULL for null.
+    static uint64_t get_hash_value_fast64(
+        const void* value, const TypeDescriptor& type, uint64_t seed);
+
+    // get_hash_value_fast64() of a null value
+    static uint64_t get_null_hash_value_fast64(uint64_t seed) {
+        return HashUtil::fmix64(seed ^ 0x9e3779b97f4a7c15ULL);
+    }
+
     // Get the hash value using the fvn hash function.  Using different seeds with FVN
     // results in different hash functions.  get_hash_value() does not have this property
     // and cannot be safely used as the first step in data repartitioning.
@@ -351,6 +361,51 @@ inline uint32_t RawValue::get_hash_value_fvn(
     }
 }
 
+inline uint64_t RawValue::get_hash_value_fast64(
+        const void* v, const TypeDescriptor& type, uint64_t seed) {
+    if (v == NULL) {
+        return get_null_hash_value_fast64(seed);
+    }
+
+    switch (type.type) {
+    case TYPE_VARCHAR:
+    case TYPE_CHAR:
+    case TYPE_HLL: {
+        const StringValue* string_value = reinterpret_cast<const StringValue*>(v);
+        return HashUtil::fast_hash64(string_value->ptr, string_value->len, seed);
+    }
+
+    case TYPE_BOOLEAN:
+    case TYPE_TINYINT:
+        return HashUtil::fast_hash64(v, 1, seed);
+
+    case TYPE_SMALLINT:
+        return HashUtil::fast_hash64(v, 2, seed);
+
+    case TYPE_INT:
+    case TYPE_FLOAT:
+        return HashUtil::fast_hash64(v, 4, seed);
+
+    case TYPE_BIGINT:
+    case TYPE_DOUBLE:
+        return HashUtil::fast_hash64(v, 8, seed);
+
+    case TYPE_DATE:
+    case TYPE_DATETIME:
+        return HashUtil::fast_hash64(v, 12, seed);
+
+    case TYPE_DECIMAL:
+        return reinterpret_cast<const DecimalValue*>(v)->fast_hash64(seed);
+
+    case TYPE_LARGEINT:
+        return HashUtil::fast_hash64(v, 16, seed);
+
+    default:
+        DCHECK(false) << "invalid type: " << type;
+        return 0;
+    }
+}
+
 // NOTE: this is just for split data, decimal use old palo hash function
 // Because crc32 hardware is not equal with zlib crc32
 inline uint32_t RawValue::zlib_crc32(const void* v, const TypeDescriptor& type, uint32_t seed) {
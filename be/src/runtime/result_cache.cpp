@@ -0,0 +1,292 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#include "runtime/result_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "common/logging.h"
+#include "gen_cpp/PaloInternalService_types.h"
+#include "gen_cpp/PlanNodes_types.h"
+#include "olap/olap_engine.h"
+#include "olap/olap_table.h"
+#include "util/container_util.hpp"
+#include "util/thrift_util.h"
+
+namespace palo {
+
+// Functions whose result differs between runs of the same plan.
+static const char* NON_DETERMINISTIC_FNS[] = {
+    "rand", "random", "uuid", "sleep", "now", "current_timestamp", "localtime",
+    "localtimestamp", "curdate", "current_date", "curtime", "current_time",
+    "unix_timestamp", "utc_timestamp", "connection_id", NULL
+};
+
+// Returns true if the binary serialized thrift object 'bytes' contains the string
+// 'str', e.g. as the name of a function. Strings are serialized as their 4 byte big
+// endian length followed by the bytes, so this doesn't match 'str' inside of longer
+// strings like column names.
+static bool contains_thrift_string(const std::string& bytes, const char* str) {
+    uint32_t len = strlen(str);
+    std::string needle(4, '\0');
+    needle[0] = (len >> 24) & 0xff;
+    needle[1] = (len >> 16) & 0xff;
+    needle[2] = (len >> 8) & 0xff;
+    needle[3] = len & 0xff;
+    needle.append(str, len);
+    return bytes.find(needle) != std::string::npos;
+}
+
+// Returns true if the output of a node of 'node_type' only depends on its children, the
+// tablet versions of its scan ranges and the plan. Exchanges read other fragment
+// instances, and scans other than OLAP_SCAN_NODE read data without versions, like
+// MySQL tables, information_schema or broker files.
+static bool is_cacheable_node(TPlanNodeType::type node_type) {
+    switch (node_type) {
+    case TPlanNodeType::OLAP_SCAN_NODE:
+    case TPlanNodeType::HASH_JOIN_NODE:
+    case TPlanNodeType::MERGE_JOIN_NODE:
+    case TPlanNodeType::AGGREGATION_NODE:
+    case TPlanNodeType::PRE_AGGREGATION_NODE:
+    case TPlanNodeType::SORT_NODE:
+    case TPlanNodeType::MERGE_NODE:
+    case TPlanNodeType::SELECT_NODE:
+    case TPlanNodeType::CROSS_JOIN_NODE:
+    case TPlanNodeType::ANALYTIC_EVAL_NODE:
+    case TPlanNodeType::EMPTY_SET_NODE:
+    case TPlanNodeType::UNION_NODE:
+    case TPlanNodeType::PARTITION_TOPN_NODE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void append_int(int32_t value, std::string* key) {
+    key->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Sets 'key' to the serialized fragment and descriptor table of 'request'. Returns
+// false if they call a non-deterministic function or can't be serialized.
+static bool append_fragment(const TExecPlanFragmentParams& request,
+                            ThriftSerializer* serializer, std::string* key) {
+    std::string bytes;
+
+    if (!serializer->serialize(const_cast<TPlanFragment*>(&request.fragment), &bytes).ok()) {
+        return false;
+    }
+
+    for (int i = 0; NON_DETERMINISTIC_FNS[i] != NULL; ++i) {
+        if (contains_thrift_string(bytes, NON_DETERMINISTIC_FNS[i])) {
+            return false;
+        }
+    }
+
+    // the serialized thrift objects delimit themselves
+    key->swap(bytes);
+
+    if (request.__isset.desc_tbl) {
+        if (!serializer->serialize(const_cast<TDescriptorTable*>(&request.desc_tbl),
+                                   &bytes).ok()) {
+            return false;
+        }
+        key->append(bytes);
+    }
+
+    return true;
+}
+
+bool ResultCache::make_key(const TExecPlanFragmentParams& request, std::string* key) {
+    const TPlanFragment& fragment = request.fragment;
+
+    if (!fragment.__isset.output_sink
+            || fragment.output_sink.type != TDataSinkType::RESULT_SINK) {
+        return false;
+    }
+
+    if (fragment.__isset.plan) {
+        for (int i = 0; i < fragment.plan.nodes.size(); ++i) {
+            if (!is_cacheable_node(fragment.plan.nodes[i].node_type)) {
+                return false;
+            }
+        }
+    }
+
+    ThriftSerializer serializer(false, 4096);
+
+    if (!append_fragment(request, &serializer, key)) {
+        return false;
+    }
+
+    // the scan ranges of olap scan nodes carry the versions of the tablets
+    const std::map<TPlanNodeId, std::vector<TScanRangeParams> >& per_node_scan_ranges =
+        request.params.per_node_scan_ranges;
+    std::string bytes;
+
+    for (std::map<TPlanNodeId, std::vector<TScanRangeParams> >::const_iterator it =
+                per_node_scan_ranges.begin(); it != per_node_scan_ranges.end(); ++it) {
+        append_int(it->first, key);
+        append_int(it->second.size(), key);
+
+        for (int i = 0; i < it->second.size(); ++i) {
+            if (!it->second[i].scan_range.__isset.palo_scan_range
+                    || !serializer.serialize(
+                        const_cast<TScanRange*>(&it->second[i].scan_range), &bytes).ok()) {
+                return false;
+            }
+            key->append(bytes);
+        }
+    }
+
+    return true;
+}
+
+bool PartialAggCache::make_key(const TExecPlanFragmentParams& request, std::string* key,
+                               TabletVersionMap* versions) {
+    const TPlanFragment& fragment = request.fragment;
+
+    if (!fragment.__isset.output_sink
+            || fragment.output_sink.type != TDataSinkType::DATA_STREAM_SINK
+            || !fragment.__isset.plan || fragment.plan.nodes.size() != 2) {
+        return false;
+    }
+
+    const TPlanNode& agg_node = fragment.plan.nodes[0];
+    const TPlanNode& scan_node = fragment.plan.nodes[1];
+
+    if (agg_node.node_type != TPlanNodeType::AGGREGATION_NODE
+            || agg_node.agg_node.need_finalize || agg_node.limit >= 0
+            || scan_node.node_type != TPlanNodeType::OLAP_SCAN_NODE
+            || scan_node.limit >= 0) {
+        return false;
+    }
+
+    const TOlapScanNode& olap_scan_node = scan_node.olap_scan_node;
+
+    // without pre-aggregation, the rows of a key must be merged across all versions
+    if (!olap_scan_node.is_preaggregation
+            || (olap_scan_node.__isset.push_agg_op
+                && olap_scan_node.push_agg_op != TPushAggOp::NONE)) {
+        return false;
+    }
+
+    ThriftSerializer serializer(false, 4096);
+
+    if (!append_fragment(request, &serializer, key)) {
+        return false;
+    }
+
+    std::vector<TScanRangeParams> no_scan_ranges;
+    const std::vector<TScanRangeParams>& scan_ranges = find_with_default(
+            request.params.per_node_scan_ranges, scan_node.node_id, no_scan_ranges);
+    std::string bytes;
+    versions->clear();
+    append_int(scan_ranges.size(), key);
+
+    for (int i = 0; i < scan_ranges.size(); ++i) {
+        if (!scan_ranges[i].scan_range.__isset.palo_scan_range) {
+            return false;
+        }
+
+        // the versions are kept in the entry instead
+        TScanRange scan_range = scan_ranges[i].scan_range;
+        TPaloScanRange& palo_scan_range = scan_range.palo_scan_range;
+        TabletVersion& version = (*versions)[palo_scan_range.tablet_id];
+
+        if (version.version != 0) {
+            // the tablet is scanned more than once
+            return false;
+        }
+
+        version.version = strtoll(palo_scan_range.version.c_str(), NULL, 10);
+        version.version_hash = strtoll(palo_scan_range.version_hash.c_str(), NULL, 10);
+        version.schema_hash = strtol(palo_scan_range.schema_hash.c_str(), NULL, 10);
+
+        if (version.version <= 0) {
+            return false;
+        }
+
+        palo_scan_range.version.clear();
+        palo_scan_range.version_hash.clear();
+
+        if (!serializer.serialize(&scan_range, &bytes).ok()) {
+            return false;
+        }
+        key->append(bytes);
+    }
+
+    return !versions->empty();
+}
+
+bool PartialAggCache::get_start_versions(const TabletVersionMap& cached,
+                                         const TabletVersionMap& requested,
+                                         std::map<int64_t, int64_t>* start_versions) {
+    if (cached.size() != requested.size()) {
+        return false;
+    }
+
+    for (TabletVersionMap::const_iterator it = requested.begin();
+            it != requested.end(); ++it) {
+        TabletVersionMap::const_iterator cached_it = cached.find(it->first);
+
+        if (cached_it == cached.end()) {
+            return false;
+        }
+
+        const TabletVersion& from = cached_it->second;
+        const TabletVersion& to = it->second;
+
+        if (from.version > to.version || from.schema_hash != to.schema_hash
+                || (from.version == to.version && from.version_hash != to.version_hash)) {
+            return false;
+        }
+
+        (*start_versions)[it->first] = from.version + 1;
+
+        if (from.version == to.version) {
+            continue;
+        }
+
+        // Published versions don't change, but the deltas must still be there one by
+        // one, not merged with the cached versions, and must not delete any of their
+        // rows.
+        SmartOLAPTable table = OLAPEngine::get_instance()->get_table(
+                it->first, to.schema_hash);
+        std::vector<Version> span_versions;
+        bool readable = false;
+
+        if (table.get() != NULL) {
+            table->obtain_header_rdlock();
+            readable = table->select_versions_to_span(
+                    Version(from.version + 1, to.version), &span_versions) == OLAP_SUCCESS;
+
+            for (const DeleteDataConditionMessage& cond : table->delete_data_conditions()) {
+                if (cond.version() > from.version && cond.version() <= to.version) {
+                    readable = false;
+                }
+            }
+
+            table->release_header_lock();
+        }
+
+        if (!readable) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,226 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#ifndef BDG_PALO_BE_RUNTIME_RESULT_CACHE_H
+#define BDG_PALO_BE_RUNTIME_RESULT_CACHE_H
+
+#include <stdint.h>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "gen_cpp/Data_types.h"
+
+namespace palo {
+
+class TExecPlanFragmentParams;
+
+// LRU map from keys to immutable values of type T, bounded by the total size of the
+// keys and the values' 'bytes'. Thread safe.
+template <typename T>
+class ResultLru {
+public:
+    ResultLru(int64_t capacity_bytes) : _capacity_bytes(capacity_bytes), _size_bytes(0) { }
+
+    // Returns the value of 'key', NULL if there is none.
+    boost::shared_ptr<const T> lookup(const std::string& key) {
+        boost::lock_guard<boost::mutex> l(_lock);
+        typename EntryMap::iterator it = _entry_map.find(key);
+
+        if (it == _entry_map.end()) {
+            return boost::shared_ptr<const T>();
+        }
+
+        // move to the front
+        _entries.splice(_entries.begin(), _entries, it->second);
+        return it->second->value;
+    }
+
+    // Sets the value of 'key' to 'value', evicting least recently used entries to make
+    // room. Values larger than the capacity are ignored.
+    void insert(const std::string& key, const boost::shared_ptr<const T>& value) {
+        int64_t bytes = key.size() * 2 + value->bytes;
+
+        if (bytes > _capacity_bytes) {
+            return;
+        }
+
+        boost::lock_guard<boost::mutex> l(_lock);
+        typename EntryMap::iterator it = _entry_map.find(key);
+
+        if (it != _entry_map.end()) {
+            _size_bytes -= it->second->bytes;
+            _entries.erase(it->second);
+            _entry_map.erase(it);
+        }
+
+        while (_size_bytes + bytes > _capacity_bytes) {
+            _size_bytes -= _entries.back().bytes;
+            _entry_map.erase(_entries.back().key);
+            _entries.pop_back();
+        }
+
+        _entries.push_front(Entry());
+        Entry& entry = _entries.front();
+        entry.key = key;
+        entry.value = value;
+        entry.bytes = bytes;
+        _entry_map[key] = _entries.begin();
+        _size_bytes += bytes;
+    }
+
+    int64_t size_bytes() {
+        boost::lock_guard<boost::mutex> l(_lock);
+        return _size_bytes;
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        boost::shared_ptr<const T> value;
+        int64_t bytes;
+    };
+
+    typedef std::list<Entry> EntryList;
+    typedef boost::unordered_map<std::string, typename EntryList::iterator> EntryMap;
+
+    const int64_t _capacity_bytes;
+
+    // Protects all fields below.
+    boost::mutex _lock;
+    // most recently used entry first
+    EntryList _entries;
+    EntryMap _entry_map;
+    int64_t _size_bytes;
+};
+
+// The mysql rows of a query result, in the batches the result sink produced them.
+struct CachedResult {
+    CachedResult() : bytes(0) { }
+
+    std::vector<std::vector<std::string> > batches;
+    // total size of the rows, -1 if the result got too large to be cached
+    int64_t bytes;
+};
+
+// LRU cache of query results on this backend, bounded by
+// config::result_cache_capacity_bytes.
+//
+// A result is keyed by the plan fragment that produced it, its descriptor table and its
+// scan ranges, which include the exact version of every tablet the fragment reads, see
+// make_key(). Loading into a tablet creates a new version, so a changed tablet gives a
+// new key and the old result is never hit again; it is dropped when it becomes the least
+// recently used entry.
+class ResultCache {
+public:
+    ResultCache(int64_t capacity_bytes) : _lru(capacity_bytes) { }
+
+    // Sets 'key' for the fragment of 'request' and returns true if its result can be
+    // cached: it must end in a result sink, read all of its input through its own scan
+    // ranges, i.e. have no exchange node, and must not call functions whose result
+    // differs between runs, like now() or rand().
+    static bool make_key(const TExecPlanFragmentParams& request, std::string* key);
+
+    // Returns the result cached for 'key', NULL if there is none.
+    boost::shared_ptr<const CachedResult> lookup(const std::string& key) {
+        return _lru.lookup(key);
+    }
+
+    // Caches 'result' under 'key', evicting least recently used entries to make room.
+    // Results larger than the capacity are ignored.
+    void insert(const std::string& key, const boost::shared_ptr<const CachedResult>& result) {
+        _lru.insert(key, result);
+    }
+
+    int64_t size_bytes() {
+        return _lru.size_bytes();
+    }
+
+private:
+    ResultLru<CachedResult> _lru;
+};
+
+// Version of a tablet a fragment instance reads, by tablet id.
+struct TabletVersion {
+    TabletVersion() : version(0), version_hash(0), schema_hash(0) { }
+
+    int64_t version;
+    int64_t version_hash;
+    int32_t schema_hash;
+};
+
+typedef std::map<int64_t, TabletVersion> TabletVersionMap;
+
+// The output of a partial aggregation over the versions 'versions' of some tablets.
+struct CachedPartialAgg {
+    CachedPartialAgg() : bytes(0) { }
+
+    TabletVersionMap versions;
+    std::vector<TRowBatch> batches;
+    // total serialized size of the batches, -1 if they got too large to be cached
+    int64_t bytes;
+};
+
+// LRU cache of the output of fragment instances that pre-aggregate the rows of the
+// local tablets they scan, i.e. of the form AGGREGATION_NODE(need_finalize = false) ->
+// OLAP_SCAN_NODE with a data stream sink, bounded by
+// config::partial_agg_cache_capacity_bytes.
+//
+// The output is keyed like in ResultCache but without the tablet versions, which are
+// kept in the entry. A fragment instance that finds an entry whose tablets only got
+// new delta versions since then scans just those deltas and sends the cached output
+// together with the output over the deltas. The merging aggregation downstream
+// combines them like the output of different instances. This needs the scan to be a
+// pre-aggregation, i.e. to be correct without merging the rows of the same key across
+// versions, and no delete in the new versions. See get_start_versions().
+class PartialAggCache {
+public:
+    PartialAggCache(int64_t capacity_bytes) : _lru(capacity_bytes) { }
+
+    // Sets 'key' and '*versions', the versions of the tablets scanned, for the fragment
+    // of 'request' and returns true if it has the form described above, scans every
+    // tablet once and doesn't call functions whose result differs between runs.
+    static bool make_key(const TExecPlanFragmentParams& request, std::string* key,
+                         TabletVersionMap* versions);
+
+    // Returns true if the tablets can be read from the versions following 'cached' up
+    // to 'requested', which must contain the same tablets. Sets '*start_versions' to
+    // the first version to read of each tablet, which is beyond the requested version
+    // if there is nothing new.
+    static bool get_start_versions(const TabletVersionMap& cached,
+                                   const TabletVersionMap& requested,
+                                   std::map<int64_t, int64_t>* start_versions);
+
+    boost::shared_ptr<const CachedPartialAgg> lookup(const std::string& key) {
+        return _lru.lookup(key);
+    }
+
+    // Replaces the entry of 'key' with 'agg'.
+    void insert(const std::string& key, const boost::shared_ptr<const CachedPartialAgg>& agg) {
+        _lru.insert(key, agg);
+    }
+
+private:
+    ResultLru<CachedPartialAgg> _lru;
+};
+
+}
+
+#endif // BDG_PALO_BE_RUNTIME_RESULT_CACHE_H
@@ -22,10 +22,12 @@
 
 #include "util/debug_util.h"
 #include "exprs/expr.h"
+#include "exprs/subexpr_cache.h"
 #include "runtime/row_batch.h"
 #include "runtime/runtime_state.h"
 #include "runtime/exec_env.h"
 #include "runtime/result_buffer_mgr.h"
+#include "runtime/result_cache.h"
 #include "runtime/buffer_control_block.h"
 #include "runtime/result_writer.h"
 #include "runtime/mem_tracker.h"
@@ -36,7 +38,9 @@ ResultSink::ResultSink(const RowDescriptor& row_desc, const std::vector<TExpr>&
                        const TResultSink& sink, int buffer_size)
     : _row_desc(row_desc),
       _t_output_expr(t_output_expr),
-      _buf_size(buffer_size) {
+      _buf_size(buffer_size),
+      _wait_timer(NULL),
+      _result_cache(NULL) {
 }
 
 ResultSink::~ResultSink() {
@@ -49,6 +53,7 @@ Status ResultSink::prepare_exprs(RuntimeState* state) {
     // Prepare the exprs to run.
     RETURN_IF_ERROR(Expr::prepare(
             _output_expr_ctxs, state, _row_desc, _expr_mem_tracker.get()));
+    SubExprCache::create(state->obj_pool(), _output_expr_ctxs);
     return Status::OK;
 }
 
@@ -66,6 +71,8 @@ Status ResultSink::prepare(RuntimeState* state) {
     // create writer
     _writer.reset(new(std::nothrow) ResultWriter(_sender.get(), _output_expr_ctxs));
     RETURN_IF_ERROR(_writer->init(state));
+    _wait_timer = ADD_TIMER(_profile, "WaitFetchTime");
+    _writer->set_wait_timer(_wait_timer);
 
     return Status::OK;
 }
@@ -78,10 +85,54 @@ Status ResultSink::send(RuntimeState* state, RowBatch* batch) {
     return _writer->append_row_batch(batch);
 }
 
+void ResultSink::set_result_cache(ResultCache* cache, const std::string& key) {
+    _result_cache = cache;
+    _result_cache_key = key;
+    _cached_result = cache->lookup(key);
+
+    if (_cached_result.get() != NULL) {
+        _profile->add_info_string("ResultCache", "hit");
+    } else {
+        _profile->add_info_string("ResultCache", "miss");
+        _cache_fill.reset(new CachedResult());
+        _writer->set_cache_fill(_cache_fill.get());
+    }
+}
+
+Status ResultSink::send_cached_result(RuntimeState* state) {
+    DCHECK(_cached_result.get() != NULL);
+    const std::vector<std::vector<std::string> >& batches = _cached_result->batches;
+
+    for (int i = 0; i < batches.size(); ++i) {
+        RETURN_IF_CANCELLED(state);
+        TFetchDataResult* result = new(std::nothrow) TFetchDataResult();
+
+        if (NULL == result) {
+            return Status("no memory to alloc.");
+        }
+
+        result->result_batch.rows = batches[i];
+        Status status = _sender->add_batch(result, _wait_timer);
+
+        if (!status.ok()) {
+            delete result;
+            return status;
+        }
+    }
+
+    return Status::OK;
+}
+
 Status ResultSink::close(RuntimeState* state, Status exec_status) {
     if (_closed) {
         return Status::OK;
     }
+
+    if (exec_status.ok() && _cache_fill.get() != NULL && _cache_fill->bytes >= 0) {
+        _writer->set_cache_fill(NULL);
+        _result_cache->insert(_result_cache_key, _cache_fill);
+        _cache_fill.reset();
+    }
     // close sender, this is normal path end
     if (_sender) {
         _sender->close(exec_status);
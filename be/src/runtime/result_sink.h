@@ -21,8 +21,13 @@
 #ifndef BDG_PALO_BE_RUNTIME_RESULT_SINK_H
 #define  BDG_PALO_BE_RUNTIME_RESULT_SINK_H
 
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+
 #include "common/status.h"
 #include "exec/data_sink.h"
+#include "util/runtime_profile.h"
 
 #include "gen_cpp/PaloInternalService_types.h"
 #include "gen_cpp/PlanNodes_types.h"
@@ -38,6 +43,8 @@ class BufferControlBlock;
 class ExprContext;
 class ResultWriter;
 class MemTracker;
+class ResultCache;
+struct CachedResult;
 
 class ResultSink : public DataSink {
 public:
@@ -59,6 +66,19 @@ public:
         return _profile;
     }
 
+    // Looks up the result of this fragment in 'cache' under 'key', see
+    // ResultCache::make_key(). If there is none, the result is recorded while it's sent
+    // and put into the cache by a successful close(). Must be called after prepare().
+    void set_result_cache(ResultCache* cache, const std::string& key);
+
+    // True if set_result_cache() found the result, which send_cached_result() sends
+    // instead of running the plan.
+    bool has_cached_result() const {
+        return _cached_result.get() != NULL;
+    }
+
+    Status send_cached_result(RuntimeState* state);
+
 private:
     Status prepare_exprs(RuntimeState* state);
 
@@ -74,6 +94,14 @@ private:
     boost::shared_ptr<ResultWriter> _writer;
     RuntimeProfile* _profile; // Allocated from _pool
     int _buf_size; // Allocated from _pool
+    // Time spent waiting for the FE to fetch from the full result buffer
+    RuntimeProfile::Counter* _wait_timer;
+
+    ResultCache* _result_cache;
+    std::string _result_cache_key;
+    boost::shared_ptr<const CachedResult> _cached_result;
+    // the result recorded for the cache, NULL if it's not cached
+    boost::shared_ptr<CachedResult> _cache_fill;
 };
 
 }
@@ -20,11 +20,17 @@
 
 #include "result_writer.h"
 
+#include <string.h>
+
+#include "common/config.h"
 #include "exprs/expr.h"
+#include "exprs/expr_context.h"
+#include "exprs/subexpr_cache.h"
 #include "runtime/primitive_type.h"
 #include "runtime/row_batch.h"
 #include "runtime/tuple_row.h"
 #include "runtime/result_buffer_mgr.h"
+#include "runtime/result_cache.h"
 #include "runtime/buffer_control_block.h"
 #include "util/mysql_row_buffer.h"
 
@@ -32,16 +38,38 @@
 
 namespace palo {
 
+// Encodes the values of a column of a fixed size type, see ResultWriter::add_columns().
+template <typename T, int (MysqlRowBuffer::*PUSH)(T)>
+static int push_fixed_column(const ExprColumn& column, MysqlRowBuffer* buffer,
+                             int* row_ends) {
+    const T* values = column.values<T>();
+    int num_rows = column.num_rows();
+    int ret = 0;
+
+    for (int i = 0; 0 == ret && i < num_rows; ++i) {
+        ret = column.is_null(i) ? buffer->push_null() : (buffer->*PUSH)(values[i]);
+        row_ends[i] = buffer->length();
+    }
+
+    return ret;
+}
+
 ResultWriter::ResultWriter(
         BufferControlBlock* sinker,
         const std::vector<ExprContext*>& output_expr_ctxs) : 
             _sinker(sinker),
             _output_expr_ctxs(output_expr_ctxs),
-            _row_buffer(NULL) {
+            _row_buffer(NULL),
+            _cache_fill(NULL),
+            _wait_timer(NULL) {
 }
 
 ResultWriter::~ResultWriter() {
     delete _row_buffer;
+
+    for (int i = 0; i < _column_buffers.size(); ++i) {
+        delete _column_buffers[i];
+    }
 }
 
 Status ResultWriter::init(RuntimeState* state) {
@@ -55,112 +83,222 @@ Status ResultWriter::init(RuntimeState* state) {
         return Status("no memory to alloc.");
     }
 
+    _columns.resize(_output_expr_ctxs.size());
+    _column_row_ends.resize(_output_expr_ctxs.size());
+
+    for (int i = 0; i < _output_expr_ctxs.size(); ++i) {
+        MysqlRowBuffer* buffer = new(std::nothrow) MysqlRowBuffer();
+
+        if (NULL == buffer) {
+            return Status("no memory to alloc.");
+        }
+
+        _column_buffers.push_back(buffer);
+    }
+
     return Status::OK;
 }
 
+int ResultWriter::push_value(int col, void* item, MysqlRowBuffer* buffer) {
+    if (NULL == item) {
+        return buffer->push_null();
+    }
+
+    int ret = 0;
+
+    switch (_output_expr_ctxs[col]->root()->type().type) {
+    case TYPE_BOOLEAN:
+    case TYPE_TINYINT:
+        ret = buffer->push_tinyint(*static_cast<int8_t*>(item));
+        break;
+
+    case TYPE_SMALLINT:
+        ret = buffer->push_smallint(*static_cast<int16_t*>(item));
+        break;
+
+    case TYPE_INT:
+        ret = buffer->push_int(*static_cast<int32_t*>(item));
+        break;
+
+    case TYPE_BIGINT:
+        ret = buffer->push_bigint(*static_cast<int64_t*>(item));
+        break;
+
+    case TYPE_LARGEINT: {
+        const __int128* large_int_val = reinterpret_cast<const __int128*>(item);
+        char buf[48];
+        int len = 48;
+        char* v = LargeIntValue::to_string(*large_int_val, buf, &len);
+        ret = buffer->push_string(v, len);
+        break;
+    }
+
+    case TYPE_FLOAT:
+        ret = buffer->push_float(*static_cast<float*>(item));
+        break;
+
+    case TYPE_DOUBLE:
+        ret = buffer->push_double(*static_cast<double*>(item));
+        break;
+
+    case TYPE_DATE:
+    case TYPE_DATETIME: {
+        char buf[64];
+        const DateTimeValue* time_val = (const DateTimeValue*)(item);
+        // TODO(zhaochun), this function has core risk
+        char* pos = time_val->to_string(buf);
+        ret = buffer->push_string(buf, pos - buf - 1);
+        break;
+    }
+
+    case TYPE_VARCHAR:
+    case TYPE_HLL:
+    case TYPE_CHAR: {
+        const StringValue* string_val = (const StringValue*)(item);
+
+        if (string_val->ptr == NULL) {
+            if (string_val->len == 0) {
+                // 0x01 is a magic num, not usefull actually, just for present ""
+                char* tmp_val = reinterpret_cast<char*>(0x01);
+                ret = buffer->push_string(tmp_val, string_val->len);
+            } else {
+                ret = buffer->push_null();
+            }
+        } else {
+            ret = buffer->push_string(string_val->ptr, string_val->len);
+        }
+
+        break;
+    }
+
+    case TYPE_DECIMAL: {
+        const DecimalValue* decimal_val = reinterpret_cast<const DecimalValue*>(item);
+        std::string decimal_str;
+        int output_scale = _output_expr_ctxs[col]->root()->output_scale();
+
+        if (output_scale > 0 && output_scale <= 30) {
+            decimal_str = decimal_val->to_string(output_scale);
+        } else {
+            decimal_str = decimal_val->to_string();
+        }
+
+        ret = buffer->push_string(decimal_str.c_str(), decimal_str.length());
+        break;
+    }
+
+    default:
+        LOG(WARNING) << "can't convert this type to mysql type. type = " <<
+                     _output_expr_ctxs[col]->root()->type();
+        ret = -1;
+        break;
+    }
+
+    return ret;
+}
+
 Status ResultWriter::add_one_row(TupleRow* row) {
     _row_buffer->reset();
     int num_columns = _output_expr_ctxs.size();
     int buf_ret = 0;
+    SubExprCache::RowScope scope(
+            num_columns > 0 ? _output_expr_ctxs[0]->subexpr_cache() : NULL, row);
 
     for (int i = 0; 0 == buf_ret && i < num_columns; ++i) {
-        void* item = _output_expr_ctxs[i]->get_value(row);
+        buf_ret = push_value(i, _output_expr_ctxs[i]->get_value(row), _row_buffer);
+    }
 
-        if (NULL == item) {
-            buf_ret = _row_buffer->push_null();
-            continue;
-        }
+    if (0 != buf_ret) {
+        return Status("pack mysql buffer failed.");
+    }
 
-        switch (_output_expr_ctxs[i]->root()->type().type) {
+    return Status::OK;
+}
+
+Status ResultWriter::add_columns(RowBatch* batch, TFetchDataResult* result) {
+    int num_rows = batch->num_rows();
+    int num_columns = _output_expr_ctxs.size();
+
+    for (int col = 0; col < num_columns; ++col) {
+        ExprColumn& column = _columns[col];
+        MysqlRowBuffer* buffer = _column_buffers[col];
+        int* row_ends = NULL;
+        int ret = 0;
+
+        _output_expr_ctxs[col]->evaluate_batch(batch, NULL, num_rows, &column);
+        buffer->reset();
+        _column_row_ends[col].resize(num_rows);
+        row_ends = &_column_row_ends[col][0];
+
+        switch (column.type().type) {
         case TYPE_BOOLEAN:
         case TYPE_TINYINT:
-            buf_ret = _row_buffer->push_tinyint(*static_cast<int8_t*>(item));
+            ret = push_fixed_column<int8_t, &MysqlRowBuffer::push_tinyint>(
+                    column, buffer, row_ends);
             break;
 
         case TYPE_SMALLINT:
-            buf_ret = _row_buffer->push_smallint(*static_cast<int16_t*>(item));
+            ret = push_fixed_column<int16_t, &MysqlRowBuffer::push_smallint>(
+                    column, buffer, row_ends);
             break;
 
         case TYPE_INT:
-            buf_ret = _row_buffer->push_int(*static_cast<int32_t*>(item));
+            ret = push_fixed_column<int32_t, &MysqlRowBuffer::push_int>(
+                    column, buffer, row_ends);
             break;
 
         case TYPE_BIGINT:
-            buf_ret = _row_buffer->push_bigint(*static_cast<int64_t*>(item));
+            ret = push_fixed_column<int64_t, &MysqlRowBuffer::push_bigint>(
+                    column, buffer, row_ends);
             break;
 
-        case TYPE_LARGEINT: {
-            const __int128* large_int_val = reinterpret_cast<const __int128*>(item);
-            char buf[48];
-            int len = 48;
-            char* v = LargeIntValue::to_string(*large_int_val, buf, &len);
-            buf_ret = _row_buffer->push_string(v, len);
-            break;
-        }
-
         case TYPE_FLOAT:
-            buf_ret = _row_buffer->push_float(*static_cast<float*>(item));
+            ret = push_fixed_column<float, &MysqlRowBuffer::push_float>(
+                    column, buffer, row_ends);
             break;
 
         case TYPE_DOUBLE:
-            buf_ret = _row_buffer->push_double(*static_cast<double*>(item));
+            ret = push_fixed_column<double, &MysqlRowBuffer::push_double>(
+                    column, buffer, row_ends);
             break;
 
-        case TYPE_DATE:
-        case TYPE_DATETIME: {
-            char buf[64];
-            const DateTimeValue* time_val = (const DateTimeValue*)(item);
-            // TODO(zhaochun), this function has core risk
-            char* pos = time_val->to_string(buf);
-            buf_ret = _row_buffer->push_string(buf, pos - buf - 1);
-            break;
-        }
-
-        case TYPE_VARCHAR:
-        case TYPE_HLL:
-        case TYPE_CHAR: {
-            const StringValue* string_val = (const StringValue*)(item);
-
-            if (string_val->ptr == NULL) {
-                if (string_val->len == 0) {
-                    // 0x01 is a magic num, not usefull actually, just for present ""
-                    char* tmp_val = reinterpret_cast<char*>(0x01);
-                    buf_ret = _row_buffer->push_string(tmp_val, string_val->len);
-                } else {
-                    buf_ret = _row_buffer->push_null();
-                }
-            } else {
-                buf_ret = _row_buffer->push_string(string_val->ptr, string_val->len);
+        default:
+            for (int i = 0; 0 == ret && i < num_rows; ++i) {
+                ret = push_value(col, column.get_value(i), buffer);
+                row_ends[i] = buffer->length();
             }
 
             break;
         }
 
-        case TYPE_DECIMAL: {
-            const DecimalValue* decimal_val = reinterpret_cast<const DecimalValue*>(item);
-            std::string decimal_str;
-            int output_scale = _output_expr_ctxs[i]->root()->output_scale();
+        if (0 != ret) {
+            return Status("pack mysql buffer failed.");
+        }
+    }
 
-            if (output_scale > 0 && output_scale <= 30) {
-                decimal_str = decimal_val->to_string(output_scale);
-            } else {
-                decimal_str = decimal_val->to_string();
-            }
+    // put the rows together, every row string is allocated once
+    for (int i = 0; i < num_rows; ++i) {
+        int length = 0;
 
-            buf_ret = _row_buffer->push_string(decimal_str.c_str(), decimal_str.length());
-            break;
+        for (int col = 0; col < num_columns; ++col) {
+            const std::vector<int>& row_ends = _column_row_ends[col];
+            length += row_ends[i] - (i == 0 ? 0 : row_ends[i - 1]);
         }
 
-        default:
-            LOG(WARNING) << "can't convert this type to mysql type. type = " <<
-                         _output_expr_ctxs[i]->root()->type();
-            buf_ret = -1;
-            break;
+        std::string& row = result->result_batch.rows[i];
+        row.resize(length);
+
+        if (length == 0) {
+            continue;
         }
-    }
 
-    if (0 != buf_ret) {
-        return Status("pack mysql buffer failed.");
+        char* dst = &row[0];
+
+        for (int col = 0; col < num_columns; ++col) {
+            const std::vector<int>& row_ends = _column_row_ends[col];
+            int begin = (i == 0 ? 0 : row_ends[i - 1]);
+            memcpy(dst, _column_buffers[col]->buf() + begin, row_ends[i] - begin);
+            dst += row_ends[i] - begin;
+        }
     }
 
     return Status::OK;
@@ -177,21 +315,48 @@ Status ResultWriter::append_row_batch(RowBatch* batch) {
     int num_rows = batch->num_rows();
     result->result_batch.rows.resize(num_rows);
 
-    for (int i = 0; status.ok() && i < num_rows; ++i) {
-        TupleRow* row = batch->get_row(i);
-        status = add_one_row(row);
+    // Exprs sharing common sub-expressions per row through a SubExprCache are
+    // evaluated row by row, see SubExprCache.
+    if (!_output_expr_ctxs.empty() && _output_expr_ctxs[0]->subexpr_cache() != NULL) {
+        for (int i = 0; status.ok() && i < num_rows; ++i) {
+            TupleRow* row = batch->get_row(i);
+            status = add_one_row(row);
 
-        if (status.ok()) {
-            result->result_batch.rows[i].assign(_row_buffer->buf(), _row_buffer->length());
+            if (status.ok()) {
+                result->result_batch.rows[i].assign(
+                        _row_buffer->buf(), _row_buffer->length());
+            } else {
+                LOG(WARNING) << "convert row to mysql result failed.";
+                break;
+            }
+        }
+    } else {
+        status = add_columns(batch, result);
+
+        if (!status.ok()) {
+            LOG(WARNING) << "convert batch to mysql result failed.";
+        }
+    }
+
+    if (status.ok() && _cache_fill != NULL && _cache_fill->bytes >= 0) {
+        const std::vector<std::string>& rows = result->result_batch.rows;
+
+        for (int i = 0; i < rows.size(); ++i) {
+            _cache_fill->bytes += rows[i].size() + sizeof(std::string);
+        }
+
+        if (_cache_fill->bytes > config::result_cache_max_entry_bytes) {
+            // too large to be cached
+            _cache_fill->batches.clear();
+            _cache_fill->bytes = -1;
         } else {
-            LOG(WARNING) << "convert row to mysql result failed.";
-            break;
+            _cache_fill->batches.push_back(rows);
         }
     }
 
     if (status.ok()) {
         // push this batch to back
-        status = _sinker->add_batch(result);
+        status = _sinker->add_batch(result, _wait_timer);
 
         if (status.ok()) {
             result = NULL;
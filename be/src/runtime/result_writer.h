@@ -24,6 +24,8 @@
 #include <vector>
 
 #include "common/status.h"
+#include "exprs/expr_column.h"
+#include "util/runtime_profile.h"
 
 namespace palo {
 
@@ -33,6 +35,8 @@ class ExprContext;
 class MysqlRowBuffer;
 class BufferControlBlock;
 class RuntimeState;
+class TFetchDataResult;
+struct CachedResult;
 
 //convert the row batch to mysql protol row
 class ResultWriter {
@@ -45,14 +49,44 @@ public:
     // append this batch to the result sink
     Status append_row_batch(RowBatch* batch);
 
+    // Makes append_row_batch() record a copy of the rows it sends in 'cache_fill', until
+    // they exceed config::result_cache_max_entry_bytes. NULL stops recording.
+    void set_cache_fill(CachedResult* cache_fill) {
+        _cache_fill = cache_fill;
+    }
+
+    // Time append_row_batch() waits for the FE to fetch from a full result buffer.
+    void set_wait_timer(RuntimeProfile::Counter* wait_timer) {
+        _wait_timer = wait_timer;
+    }
+
 private:
     // convert one tuple row
     Status add_one_row(TupleRow* row);
 
+    // Converts all rows of 'batch' into 'result' column by column: every output expr is
+    // evaluated over the whole batch and its values are encoded in a tight loop per
+    // type into a buffer of the column, then the rows are put together from the
+    // encoded columns. Produces the same rows as add_one_row().
+    Status add_columns(RowBatch* batch, TFetchDataResult* result);
+
+    // Encodes the value 'item' of output column 'col', NULL for null, into 'buffer'.
+    // Returns 0 on success.
+    int push_value(int col, void* item, MysqlRowBuffer* buffer);
+
     // The expressions that are run to create tuples to be written to hbase.
     BufferControlBlock* _sinker;
     const std::vector<ExprContext*>& _output_expr_ctxs;
     MysqlRowBuffer* _row_buffer;
+    CachedResult* _cache_fill;
+    RuntimeProfile::Counter* _wait_timer;
+
+    // Per output column: the values of the current batch, their encoding and the end
+    // offset of the encoding of each row in the buffer. Kept across batches to reuse
+    // the memory.
+    std::vector<ExprColumn> _columns;
+    std::vector<MysqlRowBuffer*> _column_buffers;
+    std::vector<std::vector<int> > _column_row_ends;
 };
 
 }
@@ -22,7 +22,9 @@
 
 #include <stdint.h>  // for intptr_t
 #include <snappy/snappy.h>
+#include <boost/unordered_map.hpp>
 
+#include "runtime/columnar_row_batch_codec.h"
 #include "runtime/runtime_state.h"
 #include "runtime/string_value.h"
 #include "runtime/tuple_row.h"
@@ -36,6 +38,68 @@ namespace palo {
 const int RowBatch::AT_CAPACITY_MEM_USAGE = 8 * 1024 * 1024;
 const int RowBatch::FIXED_LEN_BUFFER_LIMIT = AT_CAPACITY_MEM_USAGE / 2;
 
+// Dictionary of the strings of one slot written to a serialized batch. A repeated
+// string gets the offset of its first copy instead of its bytes, the receiver then
+// turns all of them into pointers to that copy. Slots with mostly distinct strings
+// stop using it after the first values.
+class SerializedStringDict {
+public:
+    SerializedStringDict() : _num_values(0), _enabled(true) { }
+
+    // Returns the offset of an earlier copy of 'value', or -1 after recording that
+    // it is written at 'offset'.
+    int find_or_insert(const StringValue& value, int offset) {
+        if (!_enabled) {
+            return -1;
+        }
+        ++_num_values;
+        boost::unordered_map<StringValue, int>::iterator it = _offsets.find(value);
+        if (it != _offsets.end()) {
+            return it->second;
+        }
+        _offsets.insert(std::make_pair(value, offset));
+        if (_num_values >= MIN_SAMPLE_VALUES && _offsets.size() * 2 > _num_values) {
+            _enabled = false;
+            _offsets.clear();
+        }
+        return -1;
+    }
+
+private:
+    static const int MIN_SAMPLE_VALUES = 32;
+
+    boost::unordered_map<StringValue, int> _offsets;
+    int _num_values;
+    bool _enabled;
+};
+
+// Tuple::deep_copy() with convert_ptrs, but writes each string of 'dicts' once.
+static void serialize_tuple(const Tuple* tuple, const TupleDescriptor& desc,
+                            std::vector<SerializedStringDict>* dicts,
+                            char** data, int* offset) {
+    Tuple* dst = reinterpret_cast<Tuple*>(*data);
+    memcpy(dst, tuple, desc.byte_size());
+    *data += desc.byte_size();
+    *offset += desc.byte_size();
+
+    const vector<SlotDescriptor*>& string_slots = desc.string_slots();
+    for (int i = 0; i < string_slots.size(); ++i) {
+        if (dst->is_null(string_slots[i]->null_indicator_offset())) {
+            continue;
+        }
+        StringValue* string_v = dst->get_string_slot(string_slots[i]->tuple_offset());
+        int copy_offset = (*dicts)[i].find_or_insert(*string_v, *offset);
+        if (copy_offset != -1) {
+            string_v->ptr = reinterpret_cast<char*>(copy_offset);
+            continue;
+        }
+        memcpy(*data, string_v->ptr, string_v->len);
+        string_v->ptr = reinterpret_cast<char*>(*offset);
+        *data += string_v->len;
+        *offset += string_v->len;
+    }
+}
+
 RowBatch::RowBatch(const RowDescriptor& row_desc, int capacity, MemTracker* mem_tracker) :
         _mem_tracker(mem_tracker),
         _has_in_flight_row(false),
@@ -68,35 +132,69 @@ RowBatch::RowBatch(const RowDescriptor& row_desc, int capacity, MemTracker* mem_
 //              xfer += iprot->readString(this->tuple_data[_i9]);
 // to allocated string data in special mempool
 // (change via python script that runs over Data_types.cc)
-RowBatch::RowBatch(const RowDescriptor& row_desc, const TRowBatch& input_batch, MemTracker* tracker) :
+RowBatch::RowBatch(const RowDescriptor& row_desc, const TRowBatch& input_batch, MemTracker* tracker,
+                   const std::shared_ptr<uint8_t>& tuple_data, int64_t tuple_data_size) :
         _mem_tracker(tracker),
         _has_in_flight_row(false),
-        _num_rows(input_batch.num_rows),
-        _capacity(_num_rows),
+        _num_rows(0),
+        _capacity(0),
         _flush(FlushMode::NO_FLUSH_RESOURCES),
         _needs_deep_copy(false),
         _num_tuples_per_row(input_batch.row_tuples.size()),
         _row_desc(row_desc),
+        _tuple_ptrs(NULL),
+        _tuple_ptrs_size(0),
         _auxiliary_mem_usage(0),
         _need_to_return(false),
         _tuple_data_pool(new MemPool(_mem_tracker)) {
     DCHECK(_mem_tracker != NULL);
-    _tuple_ptrs_size = _num_rows * input_batch.row_tuples.size() * sizeof(Tuple*);
-    DCHECK_GT(_tuple_ptrs_size, 0);
+    deserialize(input_batch, tuple_data, tuple_data_size);
+}
+
+void RowBatch::deserialize(const TRowBatch& input_batch,
+                           const std::shared_ptr<uint8_t>& tuple_data_buffer,
+                           int64_t tuple_data_buffer_size) {
+    DCHECK_EQ(_num_rows, 0);
+    DCHECK_EQ(_num_tuples_per_row, input_batch.row_tuples.size());
+    _num_rows = input_batch.num_rows;
+    _capacity = _num_rows;
+    int tuple_ptrs_size = _num_rows * _num_tuples_per_row * sizeof(Tuple*);
+    DCHECK_GT(tuple_ptrs_size, 0);
+    // A reused batch keeps its tuple pointers if they are large enough.
     // TODO: switch to Init() pattern so we can check memory limit and return Status.
-    if (config::enable_partitioned_aggregation) {
-        _mem_tracker->consume(_tuple_ptrs_size);
-        _tuple_ptrs = reinterpret_cast<Tuple**>(malloc(_tuple_ptrs_size));
-        DCHECK(_tuple_ptrs != NULL);
-    } else {
-        _tuple_ptrs = reinterpret_cast<Tuple**>(_tuple_data_pool->allocate(_tuple_ptrs_size));
+    if (tuple_ptrs_size > _tuple_ptrs_size) {
+        if (config::enable_partitioned_aggregation) {
+            if (_tuple_ptrs != NULL) {
+                free(_tuple_ptrs);
+                _mem_tracker->release(_tuple_ptrs_size);
+            }
+            _mem_tracker->consume(tuple_ptrs_size);
+            _tuple_ptrs = reinterpret_cast<Tuple**>(malloc(tuple_ptrs_size));
+            DCHECK(_tuple_ptrs != NULL);
+        } else {
+            _tuple_ptrs = reinterpret_cast<Tuple**>(_tuple_data_pool->allocate(tuple_ptrs_size));
+        }
+        _tuple_ptrs_size = tuple_ptrs_size;
+    }
+
+    if (input_batch.__isset.is_columnar && input_batch.is_columnar) {
+        // The tuples are rebuilt from their columns in the data pool
+        DCHECK(tuple_data_buffer == nullptr);
+        ColumnarRowBatchCodec::decode(_row_desc, input_batch, _tuple_data_pool.get(), _tuple_ptrs);
+        return;
     }
 
+    const char* input_data = input_batch.tuple_data.c_str();
+    size_t input_size = input_batch.tuple_data.size();
+    if (tuple_data_buffer != nullptr) {
+        input_data = reinterpret_cast<const char*>(tuple_data_buffer.get());
+        input_size = tuple_data_buffer_size;
+    }
     uint8_t* tuple_data = NULL;
     if (input_batch.is_compressed) {
         // Decompress tuple data into data pool
-        const char* compressed_data = input_batch.tuple_data.c_str();
-        size_t compressed_size = input_batch.tuple_data.size();
+        const char* compressed_data = input_data;
+        size_t compressed_size = input_size;
         size_t uncompressed_size = 0;
         bool success = snappy::GetUncompressedLength(compressed_data, compressed_size,
                        &uncompressed_size);
@@ -105,10 +203,14 @@ RowBatch::RowBatch(const RowDescriptor& row_desc, const TRowBatch& input_batch,
         success = snappy::RawUncompress(
                 compressed_data, compressed_size, reinterpret_cast<char*>(tuple_data));
         DCHECK(success) << "snappy::RawUncompress failed";
+    } else if (tuple_data_buffer != nullptr) {
+        // Tuple data uncompressed, the tuples stay where they were received
+        tuple_data = tuple_data_buffer.get();
+        add_external_buffer(tuple_data_buffer, tuple_data_buffer_size);
     } else {
         // Tuple data uncompressed, copy directly into data pool
-        tuple_data = _tuple_data_pool->allocate(input_batch.tuple_data.size());
-        memcpy(tuple_data, input_batch.tuple_data.c_str(), input_batch.tuple_data.size());
+        tuple_data = _tuple_data_pool->allocate(input_size);
+        memcpy(tuple_data, input_data, input_size);
     }
 
     // convert input_batch.tuple_offsets into pointers
@@ -175,6 +277,7 @@ void RowBatch::clear() {
     for (int i = 0; i < _io_buffers.size(); ++i) {
         _io_buffers[i]->return_buffer();
     }
+    release_external_buffers();
     close_tuple_streams();
     for (int i = 0; i < _blocks.size(); ++i) {
         _blocks[i]->del();
@@ -197,9 +300,17 @@ int RowBatch::serialize(TRowBatch* output_batch) {
     output_batch->row_tuples.clear();
     output_batch->tuple_offsets.clear();
     output_batch->is_compressed = false;
+    output_batch->is_columnar = false;
+    output_batch->__isset.is_columnar = false;
 
     output_batch->num_rows = _num_rows;
     _row_desc.to_thrift(&output_batch->row_tuples);
+
+    if (config::columnar_rowbatches) {
+        // Tuple data is stored column by column and compressed per column instead
+        int raw_size = ColumnarRowBatchCodec::encode(this, output_batch);
+        return get_batch_size(*output_batch) - output_batch->tuple_data.size() + raw_size;
+    }
     output_batch->tuple_offsets.reserve(_num_rows * _num_tuples_per_row);
 
     int size = total_byte_size();
@@ -209,6 +320,15 @@ int RowBatch::serialize(TRowBatch* output_batch) {
     // pointers into offsets in the process)
     int offset = 0; // current offset into output_batch->tuple_data
     char* tuple_data = const_cast<char*>(output_batch->tuple_data.c_str());
+    // the dictionaries of the string slots of each tuple id, if they are shared
+    std::vector<std::vector<SerializedStringDict> > string_dicts;
+    if (config::share_rowbatch_strings && _row_desc.has_varlen_slots()) {
+        const vector<TupleDescriptor*>& tuple_descs = _row_desc.tuple_descriptors();
+        string_dicts.resize(tuple_descs.size());
+        for (int j = 0; j < tuple_descs.size(); ++j) {
+            string_dicts[j].resize(tuple_descs[j]->string_slots().size());
+        }
+    }
 
     for (int i = 0; i < _num_rows; ++i) {
         TupleRow* row = get_row(i);
@@ -224,12 +344,25 @@ int RowBatch::serialize(TRowBatch* output_batch) {
 
             // Record offset before creating copy (which increments offset and tuple_data)
             output_batch->tuple_offsets.push_back(offset);
-            row->get_tuple(j)->deep_copy(**desc, &tuple_data, &offset, /* convert_ptrs */ true);
+            if (string_dicts.empty() || (*desc)->string_slots().empty()) {
+                row->get_tuple(j)->deep_copy(**desc, &tuple_data, &offset,
+                                             /* convert_ptrs */ true);
+            } else {
+                serialize_tuple(row->get_tuple(j), **desc, &string_dicts[j],
+                                &tuple_data, &offset);
+            }
             DCHECK_LE(offset, size);
         }
     }
 
-    DCHECK_EQ(offset, size);
+    if (string_dicts.empty()) {
+        DCHECK_EQ(offset, size);
+    } else {
+        // repeated strings were written once
+        DCHECK_LE(offset, size);
+        size = offset;
+        output_batch->tuple_data.resize(size);
+    }
 
     if (config::compress_rowbatches && size > 0) {
         // Try compressing tuple_data to _compression_scratch, swap if compressed data is
@@ -285,6 +418,20 @@ Status RowBatch::resize_and_allocate_tuple_buffer(RuntimeState* state,
   return Status::OK;
 }
 
+void RowBatch::add_external_buffer(const std::shared_ptr<uint8_t>& buffer, int64_t size) {
+    DCHECK(buffer != nullptr);
+    _external_buffers.push_back(std::make_pair(buffer, size));
+    _auxiliary_mem_usage += size;
+    _mem_tracker->consume(size);
+}
+
+void RowBatch::release_external_buffers() {
+    for (int i = 0; i < _external_buffers.size(); ++i) {
+        _mem_tracker->release(_external_buffers[i].second);
+    }
+    _external_buffers.clear();
+}
+
 void RowBatch::add_tuple_stream(BufferedTupleStream2* stream) {
     DCHECK(stream != NULL);
     _tuple_streams.push_back(stream);
@@ -302,12 +449,13 @@ void RowBatch::reset() {
     _num_rows = 0;
     _capacity = _tuple_ptrs_size / (_num_tuples_per_row * sizeof(Tuple*));
     _has_in_flight_row = false;
-    // TODO: Change this to Clear() and investigate the repercussions.
-    _tuple_data_pool->free_all();
+    // Keep some chunks so that refilling the batch doesn't have to allocate them again.
+    _tuple_data_pool->clear_and_trim(config::row_batch_max_retained_bytes);
     for (int i = 0; i < _io_buffers.size(); ++i) {
         _io_buffers[i]->return_buffer();
     }
     _io_buffers.clear();
+    release_external_buffers();
 
     close_tuple_streams();
     for (int i = 0; i < _blocks.size(); ++i) {
@@ -341,6 +489,10 @@ void RowBatch::transfer_resource_ownership(RowBatch* dest) {
         buffer->set_mem_tracker(dest->_mem_tracker);
     }
     _io_buffers.clear();
+    for (int i = 0; i < _external_buffers.size(); ++i) {
+        dest->add_external_buffer(_external_buffers[i].first, _external_buffers[i].second);
+    }
+    release_external_buffers();
     for (int i = 0; i < _tuple_streams.size(); ++i) {
         dest->_tuple_streams.push_back(_tuple_streams[i]);
         dest->_auxiliary_mem_usage += _tuple_streams[i]->byte_size();
@@ -389,6 +541,10 @@ void RowBatch::acquire_state(RowBatch* src) {
         buffer->set_mem_tracker(_mem_tracker);
     }
     src->_io_buffers.clear();
+    for (int i = 0; i < src->_external_buffers.size(); ++i) {
+        add_external_buffer(src->_external_buffers[i].first, src->_external_buffers[i].second);
+    }
+    src->release_external_buffers();
     src->_auxiliary_mem_usage = 0;
 
     DCHECK(src->_tuple_streams.empty());
@@ -414,9 +570,9 @@ void RowBatch::swap(RowBatch* other) {
     DCHECK_EQ(_num_tuples_per_row, other->_num_tuples_per_row);
     DCHECK_EQ(_tuple_ptrs_size, other->_tuple_ptrs_size);
 
-    // The destination row batch should be empty.
+    // The destination row batch should be empty, a reset batch may keep free chunks.
     DCHECK(!_has_in_flight_row);
-    DCHECK_EQ(_tuple_data_pool->get_total_chunk_sizes(), 0);
+    DCHECK_EQ(_num_rows, 0);
 
     std::swap(_has_in_flight_row, other->_has_in_flight_row);
     std::swap(_num_rows, other->_num_rows);
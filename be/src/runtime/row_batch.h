@@ -23,6 +23,7 @@
 
 #include <vector>
 #include <cstring>
+#include <memory>
 #include <boost/scoped_ptr.hpp>
 
 #include "common/logging.h"
@@ -89,9 +90,13 @@ public:
     // Populate a row batch from input_batch by copying input_batch's
     // tuple_data into the row batch's mempool and converting all offsets
     // in the data back into pointers.
-    // TODO: figure out how to transfer the data from input_batch to this RowBatch
-    // (so that we don't need to make yet another copy)
-    RowBatch(const RowDescriptor& row_desc, const TRowBatch& input_batch, MemTracker* tracker);
+    // If 'tuple_data' is set, it holds the tuple data of the batch instead of
+    // input_batch.tuple_data, e.g. in the rpc message the batch arrived in. Uncompressed
+    // tuples are then used in place and the batch keeps 'tuple_data' alive instead of
+    // copying it.
+    RowBatch(const RowDescriptor& row_desc, const TRowBatch& input_batch, MemTracker* tracker,
+             const std::shared_ptr<uint8_t>& tuple_data = nullptr,
+             int64_t tuple_data_size = 0);
 
     // Releases all resources accumulated at this row batch.  This includes
     //  - tuple_ptrs
@@ -251,12 +256,25 @@ public:
         return _tuple_streams.size();
     }
 
-    // Resets the row batch, returning all resources it has accumulated.
+    // Resets the row batch, returning all resources it has accumulated. The tuple data
+    // pool keeps up to config::row_batch_max_retained_bytes of its chunks for the next
+    // rows.
     void reset();
 
+    // Populates this empty batch like RowBatch(row_desc, input_batch, tracker), so that
+    // a reset batch can be reused for the next input batch. The tuple pointers only
+    // grow if 'input_batch' has more rows than any batch before.
+    void deserialize(const TRowBatch& input_batch,
+                     const std::shared_ptr<uint8_t>& tuple_data = nullptr,
+                     int64_t tuple_data_size = 0);
+
     // Add io buffer to this row batch.
     void add_io_buffer(DiskIoMgr::BufferDescriptor* buffer);
 
+    // Adds a buffer of 'size' bytes that rows of this batch point into. The buffer is
+    // shared with whoever else holds it and is counted against the batch's tracker.
+    void add_external_buffer(const std::shared_ptr<uint8_t>& buffer, int64_t size);
+
     // Add tuple stream to this row batch. The row batch takes ownership of the stream
     // and will call Close() on the stream and delete it when freeing resources.
     void add_tuple_stream(BufferedTupleStream2* stream);
@@ -327,6 +345,21 @@ public:
                 num_rows * _num_tuples_per_row * sizeof(Tuple*));
     }
 
+    // Keeps only the rows 'sel[0..num_sel)', in ascending order, and moves them to the
+    // front of the batch. Only the row pointers are moved, the tuples stay where they are.
+    void keep_rows(const int* sel, int num_sel) {
+        DCHECK_LE(num_sel, _num_rows);
+        for (int i = 0; i < num_sel; ++i) {
+            DCHECK_LE(i, sel[i]);
+            if (sel[i] != i) {
+                memcpy(_tuple_ptrs + _num_tuples_per_row * i,
+                       _tuple_ptrs + _num_tuples_per_row * sel[i],
+                       _num_tuples_per_row * sizeof(Tuple*));
+            }
+        }
+        _num_rows = num_sel;
+    }
+
     void clear_row(TupleRow* row) {
         memset(row, 0, _num_tuples_per_row * sizeof(Tuple*));
     }
@@ -353,6 +386,8 @@ public:
     // snappy-compressed unless the compressed data is larger than the uncompressed
     // data. Use output_batch.is_compressed to determine whether tuple_data is compressed.
     // If an in-flight row is present in this row batch, it is ignored.
+    // With share_rowbatch_strings, repeated strings of a slot are written once and
+    // referenced by the offset of that copy, which deserialize() handles as usual.
     // This function does not reset().
     // Returns the uncompressed serialized size (this will be the true size of output_batch
     // if tuple_data is actually uncompressed).
@@ -418,6 +453,9 @@ private:
     // Close owned tuple streams and delete if needed.
     void close_tuple_streams();
 
+    // Releases the buffers added with add_external_buffer().
+    void release_external_buffers();
+
     // All members need to be handled in RowBatch::swap()
 
     bool _has_in_flight_row;  // if true, last row hasn't been committed yet
@@ -472,6 +510,9 @@ private:
     // (i.e. they are not ref counted) so most row batches don't own any.
     std::vector<DiskIoMgr::BufferDescriptor*> _io_buffers;
 
+    // Buffers added with add_external_buffer() and their sizes.
+    std::vector<std::pair<std::shared_ptr<uint8_t>, int64_t> > _external_buffers;
+
     // Tuple streams currently owned by this row batch.
     std::vector<BufferedTupleStream2*> _tuple_streams;
 
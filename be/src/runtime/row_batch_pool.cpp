@@ -0,0 +1,104 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/row_batch_pool.h"
+
+#include "runtime/mem_pool.h"
+#include "runtime/row_batch.h"
+#include "gen_cpp/Data_types.h"
+
+namespace palo {
+
+using boost::lock_guard;
+using boost::mutex;
+
+RowBatchPool::RowBatchPool(const RowDescriptor& row_desc, MemTracker* mem_tracker,
+                           int max_free_batches) :
+        _row_desc(row_desc),
+        _mem_tracker(mem_tracker),
+        _max_free_batches(max_free_batches) {
+}
+
+RowBatchPool::~RowBatchPool() {
+    for (int i = 0; i < _free_batches.size(); ++i) {
+        delete _free_batches[i];
+    }
+}
+
+RowBatch* RowBatchPool::get(int capacity) {
+    {
+        lock_guard<mutex> l(_lock);
+        for (int i = _free_batches.size() - 1; i >= 0; --i) {
+            RowBatch* batch = _free_batches[i];
+            if (batch->capacity() == capacity) {
+                _free_batches[i] = _free_batches.back();
+                _free_batches.pop_back();
+                return batch;
+            }
+        }
+    }
+    return new RowBatch(_row_desc, capacity, _mem_tracker);
+}
+
+RowBatch* RowBatchPool::get(const TRowBatch& input_batch,
+                            const std::shared_ptr<uint8_t>& tuple_data,
+                            int64_t tuple_data_size) {
+    RowBatch* batch = NULL;
+    {
+        lock_guard<mutex> l(_lock);
+        if (!_free_batches.empty()) {
+            batch = _free_batches.back();
+            _free_batches.pop_back();
+        }
+    }
+    if (batch == NULL) {
+        return new RowBatch(_row_desc, input_batch, _mem_tracker, tuple_data, tuple_data_size);
+    }
+    batch->deserialize(input_batch, tuple_data, tuple_data_size);
+    return batch;
+}
+
+void RowBatchPool::put(RowBatch* batch) {
+    batch->reset();
+    {
+        lock_guard<mutex> l(_lock);
+        if (_free_batches.size() < _max_free_batches) {
+            _free_batches.push_back(batch);
+            return;
+        }
+    }
+    delete batch;
+}
+
+int64_t RowBatchPool::release_free_batches() {
+    std::vector<RowBatch*> batches;
+    {
+        lock_guard<mutex> l(_lock);
+        batches.swap(_free_batches);
+    }
+    int64_t bytes = 0;
+    for (int i = 0; i < batches.size(); ++i) {
+        bytes += batches[i]->tuple_data_pool()->total_reserved_bytes();
+        delete batches[i];
+    }
+    return bytes;
+}
+
+int RowBatchPool::num_free_batches() {
+    lock_guard<mutex> l(_lock);
+    return _free_batches.size();
+}
+
+}
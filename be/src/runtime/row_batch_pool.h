@@ -0,0 +1,75 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_RUNTIME_ROW_BATCH_POOL_H
+#define BDG_PALO_BE_RUNTIME_ROW_BATCH_POOL_H
+
+#include <memory>
+#include <vector>
+
+#include <boost/thread/mutex.hpp>
+
+#include "runtime/descriptors.h"
+
+namespace palo {
+
+class MemTracker;
+class RowBatch;
+class TRowBatch;
+
+// Recycles the row batches of a node that produces a stream of them, e.g. the
+// scanner threads of a scan node or the senders of an exchange. A batch that was
+// consumed is put back and reset, it keeps its tuple pointers and some of its pool
+// chunks (see RowBatch::reset()), so the next batch costs no allocations.
+//
+// At most 'max_free_batches' batches are kept, further ones are deleted. The
+// batches are charged to 'mem_tracker', the pool must be destroyed before it.
+// Thread safe.
+class RowBatchPool {
+public:
+    RowBatchPool(const RowDescriptor& row_desc, MemTracker* mem_tracker,
+                 int max_free_batches);
+    ~RowBatchPool();
+
+    // Returns an empty batch for 'capacity' rows, a recycled one if there is one
+    // with that capacity.
+    RowBatch* get(int capacity);
+
+    // Returns a batch with the rows of 'input_batch', deserialized into a recycled
+    // batch if there is one. 'tuple_data' is passed on to RowBatch::deserialize().
+    RowBatch* get(const TRowBatch& input_batch,
+                  const std::shared_ptr<uint8_t>& tuple_data = nullptr,
+                  int64_t tuple_data_size = 0);
+
+    // Resets 'batch' and keeps it for reuse or deletes it.
+    void put(RowBatch* batch);
+
+    // Deletes the kept batches, returns the bytes of their pool chunks.
+    int64_t release_free_batches();
+
+    int num_free_batches();
+
+private:
+    const RowDescriptor _row_desc;
+    MemTracker* _mem_tracker;
+    const int _max_free_batches;
+
+    boost::mutex _lock;
+    std::vector<RowBatch*> _free_batches;
+};
+
+}
+
+#endif // BDG_PALO_BE_RUNTIME_ROW_BATCH_POOL_H
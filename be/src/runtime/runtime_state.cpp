@@ -32,6 +32,7 @@
 #include "runtime/buffered_block_mgr.h"
 #include "runtime/buffered_block_mgr2.h"
 #include "runtime/descriptors.h"
+#include "runtime/mem_arbitrator.h"
 #include "runtime/runtime_state.h"
 #include "runtime/load_path_mgr.h"
 #include "util/cpu_info.h"
@@ -122,6 +123,7 @@ RuntimeState::~RuntimeState() {
         _instance_mem_tracker->unregister_from_parent();
     }
 
+    _mem_arbitrator.reset();
     _instance_mem_tracker.reset();
     _query_mem_tracker.reset();
 }
@@ -177,6 +179,7 @@ Status RuntimeState::init_mem_trackers(const TUniqueId& query_id) {
             new MemTracker(bytes_limit, runtime_profile()->name(), _exec_env->process_mem_tracker()));
     _instance_mem_tracker.reset(
             new MemTracker(-1, runtime_profile()->name(), _query_mem_tracker.get()));
+    _mem_arbitrator.reset(new MemArbitrator(_instance_mem_tracker.get()));
 
     /*
     // TODO: this is a stopgap until we implement ExprContext
@@ -259,6 +262,9 @@ Status RuntimeState::set_mem_limit_exceeded(
         boost::lock_guard<boost::mutex> l(_process_status_lock);
         if (_process_status.ok()) {
             _process_status = Status::MEM_LIMIT_EXCEEDED;
+            if (_mem_arbitrator.get() != NULL) {
+                _mem_arbitrator->record_exceeded();
+            }
             if (msg != NULL) {
                 // _process_status.MergeStatus(*msg);
                 _process_status.add_error_msg(*msg);
@@ -299,7 +305,7 @@ Status RuntimeState::set_mem_limit_exceeded(
 Status RuntimeState::check_query_state() {
     // TODO: it would be nice if this also checked for cancellation, but doing so breaks
     // cases where we use Status::CANCELLED to indicate that the limit was reached.
-    if (_instance_mem_tracker->any_limit_exceeded()) {
+    if (_instance_mem_tracker->any_limit_exceeded() && !_mem_arbitrator->relieve()) {
         return set_mem_limit_exceeded();
     }
     return query_status();
@@ -349,6 +355,7 @@ void RuntimeState::append_error_msg_to_file(
     if (_query_options.query_type != TQueryType::LOAD) {
         return;
     }
+    boost::lock_guard<boost::mutex> l(_error_log_file_lock);
     // If file havn't been opened, open it here
     if (_error_log_file == nullptr) {
         Status status = create_error_log_file();
@@ -380,11 +387,11 @@ void RuntimeState::append_error_msg_to_file(
 
     (*_error_log_file) << out.str() << std::endl;
 
-    export_load_error(out.str());
+    if (!out.str().empty()) {
+        export_load_error(out.str());
+    }
 }
 
-const int64_t HUB_MAX_ERROR_NUM = 10;
-
 void RuntimeState::export_load_error(const std::string& err_msg) {
     if (_error_hub == nullptr) {
         if (_load_error_hub_info == nullptr) {
@@ -393,11 +400,9 @@ void RuntimeState::export_load_error(const std::string& err_msg) {
         LoadErrorHub::create_hub(_load_error_hub_info.get(), &_error_hub);
     }
 
-    if (_error_row_number <= HUB_MAX_ERROR_NUM) {
-        LoadErrorHub::ErrorMsg err(_load_job_id, err_msg);
-        // TODO(lingbin): think if should check return value?
-        _error_hub->export_error(err);
-    }
+    // the hub samples the errors and writes them behind
+    LoadErrorHub::ErrorMsg err(_load_job_id, err_msg);
+    _error_hub->export_error(err);
 }
 
 Status RuntimeState::get_codegen(LlvmCodeGen** codegen, bool initialize) {
@@ -53,6 +53,7 @@ class Expr;
 class LlvmCodeGen;
 class DateTimeValue;
 class MemTracker;
+class MemArbitrator;
 class DataStreamRecvr;
 class ResultBufferMgr;
 class ThreadPool;
@@ -61,6 +62,7 @@ class TmpFileMgr;
 class BufferedBlockMgr;
 class BufferedBlockMgr2;
 class LoadErrorHub;
+class QueryTrace;
 
 // A collection of items that are part of the global state of a
 // query and shared across all execution nodes of that query.
@@ -178,6 +180,14 @@ public:
     MemTracker* query_mem_tracker() { {
         return _query_mem_tracker.get(); }
     }
+    // For the objects that are charged to the query but may outlive this instance.
+    const boost::shared_ptr<MemTracker>& shared_query_mem_tracker() {
+        return _query_mem_tracker;
+    }
+    // NULL until init_mem_trackers() was called.
+    MemArbitrator* mem_arbitrator() {
+        return _mem_arbitrator.get();
+    }
     ThreadResourceMgr::ResourcePool* resource_pool() {
         return _resource_pool;
     }
@@ -307,6 +317,17 @@ public:
         return _be_number;
     }
 
+    // NULL unless the query runs with enable_query_trace
+    QueryTrace* query_trace() const {
+        return _query_trace.get();
+    }
+    const std::shared_ptr<QueryTrace>& query_trace_ptr() const {
+        return _query_trace;
+    }
+    void set_query_trace(const std::shared_ptr<QueryTrace>& query_trace) {
+        _query_trace = query_trace;
+    }
+
     // Sets _process_status with err_msg if no error has been set yet.
     void set_process_status(const std::string& err_msg) {
         boost::lock_guard<boost::mutex> l(_process_status_lock);
@@ -520,6 +541,9 @@ private:
     // Memory usage of this fragment instance
     boost::scoped_ptr<MemTracker> _instance_mem_tracker;
 
+    // Decides what happens when _instance_mem_tracker or an ancestor exceeds its limit
+    boost::scoped_ptr<MemArbitrator> _mem_arbitrator;
+
     // if true, execution should stop with a CANCELLED status
     bool _is_cancelled;
 
@@ -528,6 +552,9 @@ private:
     // used as send id
     int _be_number;
 
+    // shared by the fragments of the query on this backend
+    std::shared_ptr<QueryTrace> _query_trace;
+
     // Non-OK if an error has occurred and query execution should abort. Used only for
     // asynchronously reporting such errors (e.g., when a UDF reports an error), so this
     // will not necessarily be set in all error cases.
@@ -569,6 +596,9 @@ private:
     std::string _error_log_file_path;
     std::ofstream* _error_log_file; // error file path, absolute path
     std::unique_ptr<LoadErrorHub> _error_hub;
+    // Protects _error_log_file and _error_hub, scanners of one instance may append
+    // error rows concurrently.
+    boost::mutex _error_log_file_lock;
 
     // prohibit copies
     RuntimeState(const RuntimeState&);
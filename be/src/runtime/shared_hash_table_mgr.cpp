@@ -0,0 +1,116 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/shared_hash_table_mgr.h"
+
+#include <boost/thread/locks.hpp>
+
+#include "common/logging.h"
+#include "exec/hash_table.h"
+#include "runtime/mem_pool.h"
+#include "runtime/mem_tracker.h"
+#include "runtime/runtime_state.h"
+#include "util/blocking_aware_thread_pool.h"
+
+namespace palo {
+
+using boost::lock_guard;
+using boost::mutex;
+using boost::shared_ptr;
+using boost::unique_lock;
+
+SharedHashTable::SharedHashTable(const shared_ptr<MemTracker>& parent_tracker) :
+        _parent_tracker(parent_tracker),
+        _mem_tracker(new MemTracker(-1, "SharedHashTable", parent_tracker.get())),
+        _is_published(false),
+        _table(NULL) {
+}
+
+SharedHashTable::~SharedHashTable() {
+    if (_adopted_table != NULL) {
+        _adopted_table->close();
+        _adopted_table.reset();
+    }
+    if (_build_pool != NULL) {
+        _build_pool->free_all();
+        _build_pool.reset();
+    }
+    _mem_tracker->unregister_from_parent();
+}
+
+void SharedHashTable::publish(HashTable* table, const Status& status) {
+    {
+        lock_guard<mutex> l(_lock);
+        if (_is_published) {
+            return;
+        }
+        _is_published = true;
+        _build_status = status;
+        _table = status.ok() ? table : NULL;
+    }
+    _published_cv.notify_all();
+}
+
+void SharedHashTable::adopt(HashTable* table, MemPool* build_pool) {
+    lock_guard<mutex> l(_lock);
+    DCHECK(_is_published);
+    DCHECK(_table == NULL || _table == table);
+    _adopted_table.reset(table);
+    _build_pool.reset(build_pool);
+}
+
+Status SharedHashTable::wait_for_table(RuntimeState* state,
+        const std::vector<ExprContext*>& build_exprs,
+        const std::vector<ExprContext*>& probe_exprs,
+        MemTracker* mem_tracker, HashTable** table) {
+    unique_lock<mutex> l(_lock);
+    while (!_is_published) {
+        if (state->is_cancelled()) {
+            return Status::CANCELLED;
+        }
+        // The builder does not know about the cancellation of this instance, so check
+        // it now and then.
+        BlockingAwareThreadPool::ScopedBlocking blocking(&l);
+        _published_cv.timed_wait(l, boost::posix_time::milliseconds(100));
+    }
+    RETURN_IF_ERROR(_build_status);
+    DCHECK(_table != NULL);
+    *table = new HashTable(*_table, build_exprs, probe_exprs, mem_tracker);
+    return Status::OK;
+}
+
+shared_ptr<SharedHashTable> SharedHashTableMgr::register_instance(
+        const TUniqueId& query_id, PlanNodeId node_id,
+        const shared_ptr<MemTracker>& query_mem_tracker, bool* is_builder) {
+    lock_guard<mutex> l(_lock);
+    Entry& entry = _tables[std::make_pair(query_id, node_id)];
+    *is_builder = (entry.table == NULL);
+    if (*is_builder) {
+        entry.table.reset(new SharedHashTable(query_mem_tracker));
+    }
+    ++entry.num_instances;
+    return entry.table;
+}
+
+void SharedHashTableMgr::unregister_instance(const TUniqueId& query_id, PlanNodeId node_id) {
+    lock_guard<mutex> l(_lock);
+    TableMap::iterator it = _tables.find(std::make_pair(query_id, node_id));
+    DCHECK(it != _tables.end());
+    if (it != _tables.end() && --it->second.num_instances == 0) {
+        _tables.erase(it);
+    }
+}
+
+}
@@ -0,0 +1,130 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_RUNTIME_SHARED_HASH_TABLE_MGR_H
+#define BDG_PALO_BE_RUNTIME_SHARED_HASH_TABLE_MGR_H
+
+#include <utility>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "common/status.h"
+#include "runtime/descriptors.h"  // for PlanNodeId
+#include "gen_cpp/Types_types.h"  // for TUniqueId
+#include "util/uid_util.h"
+
+namespace palo {
+
+class ExprContext;
+class HashTable;
+class MemPool;
+class MemTracker;
+class RuntimeState;
+
+// The build side of a broadcast hash join, built once by one fragment instance of a
+// query on this backend and probed by all other instances of the same join node here.
+// Every instance receives the complete build input, so the result is the same no
+// matter which instance builds it.
+//
+// The build rows and hash table nodes are tracked by the own MemTracker of this
+// object instead of the builder's instance tracker, since they must survive the
+// builder if other instances are still probing. Its parent is the query tracker of
+// the builder, so they count against the memory limit of the query, and is kept alive
+// until the last instance drops its reference and they are freed.
+class SharedHashTable {
+public:
+    SharedHashTable(const boost::shared_ptr<MemTracker>& parent_tracker);
+    ~SharedHashTable();
+
+    // Tracker the builder must allocate the hash table and the build rows with.
+    MemTracker* mem_tracker() {
+        return _mem_tracker.get();
+    }
+
+    // Called by the builder once 'table' is complete, or with an error status if the
+    // build failed. 'table' is still owned by the builder until it calls adopt().
+    // Only the first call has an effect.
+    void publish(HashTable* table, const Status& status);
+
+    // Called by the builder when it closes: takes over the hash table and the pool
+    // holding the build rows, so they stay valid for the other instances.
+    void adopt(HashTable* table, MemPool* build_pool);
+
+    // Blocks until the builder published the table and returns its build status. On
+    // success, '*table' is set to a read-only copy probed with 'probe_exprs' that is
+    // owned by the caller. Returns CANCELLED if 'state' is cancelled while waiting.
+    Status wait_for_table(RuntimeState* state,
+                          const std::vector<ExprContext*>& build_exprs,
+                          const std::vector<ExprContext*>& probe_exprs,
+                          MemTracker* mem_tracker, HashTable** table);
+
+private:
+    // Declared before _mem_tracker, which must be destroyed first.
+    boost::shared_ptr<MemTracker> _parent_tracker;
+    boost::scoped_ptr<MemTracker> _mem_tracker;
+
+    // Protects all fields below.
+    boost::mutex _lock;
+    boost::condition_variable _published_cv;
+    bool _is_published;
+    Status _build_status;
+
+    // The published table, owned by the builder until adopt() was called.
+    HashTable* _table;
+    boost::scoped_ptr<HashTable> _adopted_table;
+    boost::scoped_ptr<MemPool> _build_pool;
+};
+
+// Registry of the shared hash tables of the queries running on this backend, keyed by
+// query id and join node id.
+class SharedHashTableMgr {
+public:
+    SharedHashTableMgr() { }
+
+    // Registers a fragment instance with the join node 'node_id' of query 'query_id'.
+    // The first instance to register sets '*is_builder' and has to build the table,
+    // which is charged to its 'query_mem_tracker', the others probe it.
+    boost::shared_ptr<SharedHashTable> register_instance(
+            const TUniqueId& query_id, PlanNodeId node_id,
+            const boost::shared_ptr<MemTracker>& query_mem_tracker, bool* is_builder);
+
+    // Must be called by every registered instance when it is closed. The table is
+    // removed from the registry with its last instance, an instance that registers
+    // afterwards builds a new one.
+    void unregister_instance(const TUniqueId& query_id, PlanNodeId node_id);
+
+private:
+    struct Entry {
+        Entry() : num_instances(0) { }
+
+        boost::shared_ptr<SharedHashTable> table;
+        int num_instances;
+    };
+
+    typedef std::pair<TUniqueId, PlanNodeId> Key;
+    typedef boost::unordered_map<Key, Entry> TableMap;
+
+    boost::mutex _lock;
+    TableMap _tables;
+};
+
+}
+
+#endif // BDG_PALO_BE_RUNTIME_SHARED_HASH_TABLE_MGR_H
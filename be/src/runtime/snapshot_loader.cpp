@@ -0,0 +1,484 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/snapshot_loader.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <boost/filesystem.hpp>
+
+#include "common/config.h"
+#include "common/logging.h"
+#include "exec/broker_reader.h"
+#include "exec/broker_writer.h"
+#include "gen_cpp/PaloBrokerService_types.h"
+#include "gen_cpp/TPaloBrokerService.h"
+#include "olap/file_helper.h"
+#include "runtime/client_cache.h"
+#include "runtime/exec_env.h"
+#include "util/hash_util.hpp"
+#include "util/io_throttle.h"
+
+namespace palo {
+
+namespace {
+
+const size_t TRANSFER_BUFFER_SIZE = 1024 * 1024;
+const char* const PART_FILE_SUFFIX = ".part";
+const char* const CRC_FILE_SUFFIX = ".crc";
+
+bool ends_with(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size()
+            && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+Status local_file_crc(const std::string& path, int64_t size, uint32_t* crc) {
+    FileHandler file;
+    if (file.open(path, O_RDONLY) != OLAP_SUCCESS) {
+        return Status("fail to open local file " + path);
+    }
+
+    std::unique_ptr<char[]> buf(new char[TRANSFER_BUFFER_SIZE]);
+    *crc = 0;
+    for (int64_t offset = 0; offset < size; offset += TRANSFER_BUFFER_SIZE) {
+        size_t length = std::min<int64_t>(TRANSFER_BUFFER_SIZE, size - offset);
+        if (file.pread(buf.get(), length, offset) != OLAP_SUCCESS) {
+            return Status("fail to read local file " + path);
+        }
+        *crc = HashUtil::zlib_crc_hash(buf.get(), length, *crc);
+    }
+
+    return Status::OK;
+}
+
+// Broker may return paths with scheme and authority, e.g. hdfs://host:port/a/b,
+// whether remote_dir has them or not. Returns the part of path under remote_dir.
+bool remote_relative_path(const std::string& remote_dir, const std::string& path,
+                          std::string* relative_path) {
+    std::string dir = remote_dir;
+    size_t pos = dir.find("://");
+    if (pos != std::string::npos) {
+        pos = dir.find('/', pos + 3);
+        dir = pos == std::string::npos ? "" : dir.substr(pos);
+    }
+    while (!dir.empty() && dir.back() == '/') {
+        dir.pop_back();
+    }
+
+    pos = path.find(dir + "/");
+    if (dir.empty() || pos == std::string::npos) {
+        return false;
+    }
+    *relative_path = path.substr(pos + dir.size() + 1);
+    return !relative_path->empty();
+}
+
+// Calls an rpc of broker which is not bound to a reader or writer
+template <typename Request, typename Response>
+Status call_broker(const TNetworkAddress& broker_addr,
+                   void (TPaloBrokerServiceClient::*rpc)(Response&, const Request&),
+                   const Request& request,
+                   Response* response) {
+    try {
+        Status status;
+        BrokerServiceConnection client(
+                ExecEnv::GetInstance()->broker_client_cache(), broker_addr, 10000, &status);
+        if (!status.ok()) {
+            LOG(WARNING) << "Create broker client failed. broker=" << broker_addr
+                << ", status=" << status.get_error_msg();
+            return status;
+        }
+
+        try {
+            (client.operator->()->*rpc)(*response, request);
+        } catch (apache::thrift::transport::TTransportException& e) {
+            RETURN_IF_ERROR(client.reopen());
+            (client.operator->()->*rpc)(*response, request);
+        }
+    } catch (apache::thrift::TException& e) {
+        std::stringstream ss;
+        ss << "Call broker failed, broker:" << broker_addr << " failed:" << e.what();
+        LOG(WARNING) << ss.str();
+        return Status(TStatusCode::THRIFT_RPC_ERROR, ss.str(), false);
+    }
+
+    return Status::OK;
+}
+
+Status broker_status(const TBrokerOperationStatus& op_status, const std::string& action) {
+    if (op_status.statusCode == TBrokerOperationStatusCode::OK) {
+        return Status::OK;
+    }
+
+    std::stringstream ss;
+    ss << "Fail to " << action << ", msg:" << op_status.message;
+    LOG(WARNING) << ss.str();
+    return Status(ss.str());
+}
+
+}  // namespace
+
+SnapshotLoader::SnapshotLoader(
+        const std::vector<TNetworkAddress>& broker_addresses,
+        const std::map<std::string, std::string>& properties) :
+            _broker_addresses(broker_addresses),
+            _properties(properties) {
+}
+
+template <typename Transfer>
+Status SnapshotLoader::_run_parallel(size_t num_files, const Transfer& transfer) {
+    std::atomic<size_t> next_file(0);
+    std::atomic<bool> failed(false);
+    std::mutex lock;
+    Status first_error = Status::OK;
+
+    auto worker = [&]() {
+        ScopedIoClass io_class(IO_CLASS_BACKUP);
+        while (!failed) {
+            size_t i = next_file++;
+            if (i >= num_files) {
+                return;
+            }
+
+            Status status = transfer(i);
+            if (!status.ok()) {
+                std::lock_guard<std::mutex> l(lock);
+                if (!failed) {
+                    first_error = status;
+                    failed = true;
+                }
+            }
+        }
+    };
+
+    size_t num_threads = std::min<size_t>(
+            std::max(config::snapshot_transfer_thread_num, 1), num_files);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    return first_error;
+}
+
+Status SnapshotLoader::upload(const std::string& local_dir, const std::string& remote_dir) {
+    if (_broker_addresses.empty()) {
+        return Status("no broker to upload snapshot");
+    }
+
+    FileSizeMap local_files;
+    RETURN_IF_ERROR(_list_local_files(local_dir, &local_files));
+    FileSizeMap remote_files;
+    RETURN_IF_ERROR(_list_remote_files(remote_dir, &remote_files));
+
+    std::vector<std::pair<std::string, int64_t>> files(local_files.begin(), local_files.end());
+    LOG(INFO) << "begin to upload snapshot. local_dir=" << local_dir
+        << ", remote_dir=" << remote_dir << ", num_files=" << files.size();
+    Status status = _run_parallel(files.size(), [&](size_t i) {
+        return _upload_file(local_dir, remote_dir, files[i].first, files[i].second, remote_files);
+    });
+    LOG(INFO) << "finish uploading snapshot. local_dir=" << local_dir
+        << ", status=" << status.get_error_msg();
+    return status;
+}
+
+Status SnapshotLoader::download(const std::string& remote_dir, const std::string& local_dir) {
+    if (_broker_addresses.empty()) {
+        return Status("no broker to download snapshot");
+    }
+
+    FileSizeMap remote_files;
+    RETURN_IF_ERROR(_list_remote_files(remote_dir, &remote_files));
+
+    std::vector<std::pair<std::string, int64_t>> files;
+    for (const auto& it : remote_files) {
+        if (!ends_with(it.first, CRC_FILE_SUFFIX) && !ends_with(it.first, PART_FILE_SUFFIX)) {
+            files.push_back(it);
+        }
+    }
+    LOG(INFO) << "begin to download snapshot. remote_dir=" << remote_dir
+        << ", local_dir=" << local_dir << ", num_files=" << files.size();
+    Status status = _run_parallel(files.size(), [&](size_t i) {
+        return _download_file(remote_dir, local_dir, files[i].first, files[i].second,
+                              remote_files);
+    });
+    LOG(INFO) << "finish downloading snapshot. remote_dir=" << remote_dir
+        << ", status=" << status.get_error_msg();
+    return status;
+}
+
+Status SnapshotLoader::_list_local_files(const std::string& local_dir, FileSizeMap* files) {
+    try {
+        boost::filesystem::path root(local_dir);
+        boost::filesystem::recursive_directory_iterator end;
+        for (boost::filesystem::recursive_directory_iterator it(root); it != end; ++it) {
+            if (!boost::filesystem::is_regular_file(it->status())) {
+                continue;
+            }
+
+            std::string path = it->path().string();
+            std::string relative_path = path.substr(root.string().size());
+            while (!relative_path.empty() && relative_path[0] == '/') {
+                relative_path.erase(0, 1);
+            }
+            (*files)[relative_path] = boost::filesystem::file_size(it->path());
+        }
+    } catch (boost::filesystem::filesystem_error& e) {
+        std::stringstream ss;
+        ss << "fail to list local dir " << local_dir << ", error:" << e.what();
+        LOG(WARNING) << ss.str();
+        return Status(ss.str());
+    }
+
+    return Status::OK;
+}
+
+Status SnapshotLoader::_list_remote_files(const std::string& remote_dir, FileSizeMap* files) {
+    TBrokerListPathRequest request;
+    request.__set_version(TBrokerVersion::VERSION_ONE);
+    request.__set_path(remote_dir);
+    request.__set_isRecursive(true);
+    request.__set_properties(_properties);
+
+    TBrokerListResponse response;
+    RETURN_IF_ERROR(call_broker(_broker_addresses[0], &TPaloBrokerServiceClient::listPath,
+                                request, &response));
+    // nothing was uploaded yet
+    if (response.opStatus.statusCode == TBrokerOperationStatusCode::FILE_NOT_FOUND) {
+        return Status::OK;
+    }
+    RETURN_IF_ERROR(broker_status(response.opStatus, "list " + remote_dir));
+
+    for (const TBrokerFileStatus& file_status : response.files) {
+        std::string relative_path;
+        if (file_status.isDir
+                || !remote_relative_path(remote_dir, file_status.path, &relative_path)) {
+            continue;
+        }
+        (*files)[relative_path] = file_status.size;
+    }
+
+    return Status::OK;
+}
+
+Status SnapshotLoader::_upload_file(const std::string& local_dir,
+                                    const std::string& remote_dir,
+                                    const std::string& file,
+                                    int64_t size,
+                                    const FileSizeMap& remote_files) {
+    std::string local_path = local_dir + "/" + file;
+    std::string remote_path = remote_dir + "/" + file;
+    std::string crc_path = remote_path + CRC_FILE_SUFFIX;
+    std::string part_path = remote_path + PART_FILE_SUFFIX;
+
+    // uploaded by the previous try
+    FileSizeMap::const_iterator it = remote_files.find(file);
+    if (it != remote_files.end() && it->second == size
+            && remote_files.find(file + CRC_FILE_SUFFIX) != remote_files.end()) {
+        uint32_t remote_crc = 0;
+        uint32_t local_crc = 0;
+        RETURN_IF_ERROR(_read_remote_crc(crc_path, &remote_crc));
+        RETURN_IF_ERROR(local_file_crc(local_path, size, &local_crc));
+        if (remote_crc == local_crc) {
+            VLOG(3) << "skip uploaded file " << local_path;
+            return Status::OK;
+        }
+    }
+
+    FileHandler local_file;
+    if (local_file.open(local_path, O_RDONLY) != OLAP_SUCCESS) {
+        return Status("fail to open local file " + local_path);
+    }
+
+    RETURN_IF_ERROR(_delete_remote_file(part_path));
+    uint32_t crc = 0;
+    {
+        BrokerWriter writer(NULL, _broker_addresses, _properties, part_path, 0);
+        RETURN_IF_ERROR(writer.open());
+
+        std::unique_ptr<char[]> buf(new char[TRANSFER_BUFFER_SIZE]);
+        for (int64_t offset = 0; offset < size; offset += TRANSFER_BUFFER_SIZE) {
+            size_t length = std::min<int64_t>(TRANSFER_BUFFER_SIZE, size - offset);
+            if (local_file.pread(buf.get(), length, offset) != OLAP_SUCCESS) {
+                return Status("fail to read local file " + local_path);
+            }
+            crc = HashUtil::zlib_crc_hash(buf.get(), length, crc);
+
+            size_t written_length = 0;
+            RETURN_IF_ERROR(writer.write(
+                    reinterpret_cast<const uint8_t*>(buf.get()), length, &written_length));
+        }
+        writer.close();
+    }
+
+    // a stale crc must not be left beside the new file
+    RETURN_IF_ERROR(_delete_remote_file(crc_path));
+    RETURN_IF_ERROR(_delete_remote_file(remote_path));
+    RETURN_IF_ERROR(_rename_remote_file(part_path, remote_path));
+    return _write_remote_file(crc_path, std::to_string(crc));
+}
+
+Status SnapshotLoader::_download_file(const std::string& remote_dir,
+                                      const std::string& local_dir,
+                                      const std::string& file,
+                                      int64_t size,
+                                      const FileSizeMap& remote_files) {
+    std::string remote_path = remote_dir + "/" + file;
+    std::string local_path = local_dir + "/" + file;
+    std::string part_path = local_path + PART_FILE_SUFFIX;
+
+    // files uploaded by trans_file_tool_path have no crc
+    bool has_crc = remote_files.find(file + CRC_FILE_SUFFIX) != remote_files.end();
+    uint32_t expected_crc = 0;
+    if (has_crc) {
+        RETURN_IF_ERROR(_read_remote_crc(remote_path + CRC_FILE_SUFFIX, &expected_crc));
+    }
+
+    // downloaded by the previous try
+    boost::system::error_code ec;
+    if (boost::filesystem::exists(local_path, ec)
+            && static_cast<int64_t>(boost::filesystem::file_size(local_path, ec)) == size) {
+        uint32_t local_crc = 0;
+        if (!has_crc || (local_file_crc(local_path, size, &local_crc).ok()
+                         && local_crc == expected_crc)) {
+            VLOG(3) << "skip downloaded file " << local_path;
+            return Status::OK;
+        }
+    }
+
+    boost::filesystem::create_directories(boost::filesystem::path(local_path).parent_path(), ec);
+    if (ec) {
+        return Status("fail to create dir for " + local_path + ", error:" + ec.message());
+    }
+
+    FileHandler local_file;
+    if (local_file.open_with_mode(part_path, O_CREAT | O_TRUNC | O_WRONLY, 0644)
+            != OLAP_SUCCESS) {
+        return Status("fail to open local file " + part_path);
+    }
+
+    uint32_t crc = 0;
+    int64_t downloaded_size = 0;
+    {
+        BrokerReader reader(NULL, _broker_addresses, _properties, remote_path, 0);
+        RETURN_IF_ERROR(reader.open());
+
+        std::unique_ptr<uint8_t[]> buf(new uint8_t[TRANSFER_BUFFER_SIZE]);
+        while (true) {
+            size_t length = TRANSFER_BUFFER_SIZE;
+            bool eof = false;
+            RETURN_IF_ERROR(reader.read(buf.get(), &length, &eof));
+            if (eof) {
+                break;
+            }
+
+            crc = HashUtil::zlib_crc_hash(buf.get(), length, crc);
+            if (local_file.write(buf.get(), length) != OLAP_SUCCESS) {
+                return Status("fail to write local file " + part_path);
+            }
+            downloaded_size += length;
+        }
+        reader.close();
+    }
+    local_file.close();
+
+    if (downloaded_size != size || (has_crc && crc != expected_crc)) {
+        std::stringstream ss;
+        ss << "downloaded file is corrupted. path=" << remote_path
+            << ", size=" << downloaded_size << ", expected_size=" << size
+            << ", crc=" << crc << ", expected_crc=" << expected_crc;
+        LOG(WARNING) << ss.str();
+        boost::filesystem::remove(part_path, ec);
+        return Status(ss.str());
+    }
+
+    boost::filesystem::rename(part_path, local_path, ec);
+    if (ec) {
+        return Status("fail to rename " + part_path + ", error:" + ec.message());
+    }
+
+    return Status::OK;
+}
+
+Status SnapshotLoader::_read_remote_crc(const std::string& crc_path, uint32_t* crc) {
+    BrokerReader reader(NULL, _broker_addresses, _properties, crc_path, 0);
+    RETURN_IF_ERROR(reader.open());
+
+    uint8_t buf[32];
+    size_t length = sizeof(buf) - 1;
+    bool eof = false;
+    RETURN_IF_ERROR(reader.read(buf, &length, &eof));
+    reader.close();
+    if (eof || length == 0) {
+        return Status("empty crc file " + crc_path);
+    }
+
+    buf[length] = '\0';
+    *crc = strtoul(reinterpret_cast<const char*>(buf), NULL, 10);
+    return Status::OK;
+}
+
+Status SnapshotLoader::_write_remote_file(const std::string& path, const std::string& content) {
+    BrokerWriter writer(NULL, _broker_addresses, _properties, path, 0);
+    RETURN_IF_ERROR(writer.open());
+    size_t written_length = 0;
+    RETURN_IF_ERROR(writer.write(
+            reinterpret_cast<const uint8_t*>(content.data()), content.size(), &written_length));
+    writer.close();
+    return Status::OK;
+}
+
+Status SnapshotLoader::_rename_remote_file(const std::string& src_path,
+                                           const std::string& dest_path) {
+    TBrokerRenamePathRequest request;
+    request.__set_version(TBrokerVersion::VERSION_ONE);
+    request.__set_srcPath(src_path);
+    request.__set_destPath(dest_path);
+    request.__set_properties(_properties);
+
+    TBrokerOperationStatus response;
+    RETURN_IF_ERROR(call_broker(_broker_addresses[0], &TPaloBrokerServiceClient::renamePath,
+                                request, &response));
+    return broker_status(response, "rename " + src_path);
+}
+
+Status SnapshotLoader::_delete_remote_file(const std::string& path) {
+    TBrokerDeletePathRequest request;
+    request.__set_version(TBrokerVersion::VERSION_ONE);
+    request.__set_path(path);
+    request.__set_properties(_properties);
+
+    TBrokerOperationStatus response;
+    RETURN_IF_ERROR(call_broker(_broker_addresses[0], &TPaloBrokerServiceClient::deletePath,
+                                request, &response));
+    if (response.statusCode == TBrokerOperationStatusCode::FILE_NOT_FOUND) {
+        return Status::OK;
+    }
+    return broker_status(response, "delete " + path);
+}
+
+}  // namespace palo
@@ -0,0 +1,82 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_RUNTIME_SNAPSHOT_LOADER_H
+#define BDG_PALO_BE_SRC_RUNTIME_SNAPSHOT_LOADER_H
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/status.h"
+#include "gen_cpp/Types_types.h"
+
+namespace palo {
+
+// Moves the files of a tablet snapshot between local disk and remote storage
+// through broker, used by backup and restore instead of the external
+// trans_file_tool_path script.
+//  * config::snapshot_transfer_thread_num files are transferred at the same time
+//  * a crc32 of every file is computed while it is streamed and stored beside it
+//    as "<file>.crc", downloads are verified against it
+//  * a transfer can be resumed after failure: files already transferred with the
+//    same size and crc are skipped, a file being transferred is written to
+//    "<file>.part" and renamed when it is complete
+//  * the file IO is charged to IO_CLASS_BACKUP, so the bandwidth of all transfers
+//    together is limited by config::io_rate_limit_backup_mbytes_per_sec
+class SnapshotLoader {
+public:
+    SnapshotLoader(const std::vector<TNetworkAddress>& broker_addresses,
+                   const std::map<std::string, std::string>& properties);
+    ~SnapshotLoader() {}
+
+    // Uploads all files under local_dir to remote_dir, keeping their relative paths.
+    Status upload(const std::string& local_dir, const std::string& remote_dir);
+
+    // Downloads all files under remote_dir to local_dir, keeping their relative paths.
+    Status download(const std::string& remote_dir, const std::string& local_dir);
+
+private:
+    // relative path -> size
+    typedef std::map<std::string, int64_t> FileSizeMap;
+
+    Status _list_local_files(const std::string& local_dir, FileSizeMap* files);
+    Status _list_remote_files(const std::string& remote_dir, FileSizeMap* files);
+
+    Status _upload_file(const std::string& local_dir, const std::string& remote_dir,
+                        const std::string& file, int64_t size, const FileSizeMap& remote_files);
+    Status _download_file(const std::string& remote_dir, const std::string& local_dir,
+                          const std::string& file, int64_t size, const FileSizeMap& remote_files);
+
+    // Runs transfer(i) for every i in [0, num_files) in several threads,
+    // returns the first failure.
+    template <typename Transfer>
+    Status _run_parallel(size_t num_files, const Transfer& transfer);
+
+    Status _read_remote_crc(const std::string& crc_path, uint32_t* crc);
+    Status _write_remote_file(const std::string& path, const std::string& content);
+    Status _rename_remote_file(const std::string& src_path, const std::string& dest_path);
+    // Succeeds if the file does not exist
+    Status _delete_remote_file(const std::string& path);
+
+    const std::vector<TNetworkAddress> _broker_addresses;
+    const std::map<std::string, std::string> _properties;
+};
+
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_RUNTIME_SNAPSHOT_LOADER_H
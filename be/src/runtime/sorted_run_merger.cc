@@ -35,8 +35,7 @@ using std::vector;
 namespace palo {
 
 // BatchedRowSupplier returns individual rows in a batch obtained from a sorted input
-// run (a RunBatchSupplier). Used as the heap element in the min heap maintained by the
-// merger.
+// run (a RunBatchSupplier). Used as a leaf of the loser tree maintained by the merger.
 // next() advances the row supplier to the next row in the input batch and retrieves
 // the next batch from the input if the current input batch is exhausted. Transfers
 // ownership from the current input batch to an output batch if requested.
@@ -89,6 +88,15 @@ public:
         return _input_row_batch->get_row(_input_row_batch_index);
     }
 
+    TupleRow* last_row() const {
+        return _input_row_batch->get_row(_input_row_batch->num_rows() - 1);
+    }
+
+    // Rows of the current batch from the current one on.
+    int num_rows_left() const {
+        return _input_row_batch->num_rows() - _input_row_batch_index;
+    }
+
 private:
     friend class SortedRunMerger;
 
@@ -105,99 +113,158 @@ private:
     SortedRunMerger* _parent;
 };
 
-void SortedRunMerger::heapify(int parent_index) {
-    int left_index = 2 * parent_index + 1;
-    int right_index = left_index + 1;
-    if (left_index >= _min_heap.size()) {
-        return;
-    }
-    int least_child = 0;
-    // Find the least child of parent.
-    if (right_index >= _min_heap.size() ||
-            _compare_less_than(_min_heap[left_index]->current_row(),
-                _min_heap[right_index]->current_row())) {
-        least_child = left_index;
-    } else {
-        least_child = right_index;
+bool SortedRunMerger::run_less_than(int lhs, int rhs) const {
+    if (_exhausted[lhs]) {
+        return false;
+    }
+    if (_exhausted[rhs]) {
+        return true;
     }
+    return _compare_less_than(_runs[lhs]->current_row(), _runs[rhs]->current_row());
+}
 
-    // If the parent is out of place, swap it with the least child and invoke
-    // heapify recursively.
-    if (_compare_less_than(_min_heap[least_child]->current_row(),
-                _min_heap[parent_index]->current_row())) {
-        iter_swap(_min_heap.begin() + least_child, _min_heap.begin() + parent_index);
-        heapify(least_child);
+int SortedRunMerger::build_tree(int node) {
+    int num_runs = _runs.size();
+    if (node >= num_runs) {
+        return node - num_runs;
+    }
+    int left = build_tree(2 * node);
+    int right = build_tree(2 * node + 1);
+    if (run_less_than(right, left)) {
+        _tree[node] = left;
+        return right;
     }
+    _tree[node] = right;
+    return left;
+}
+
+void SortedRunMerger::replay(int run) {
+    int winner = run;
+    for (int node = (run + _runs.size()) / 2; node >= 1; node /= 2) {
+        if (run_less_than(_tree[node], winner)) {
+            std::swap(_tree[node], winner);
+        }
+    }
+    _tree[0] = winner;
+}
+
+TupleRow* SortedRunMerger::runner_up_row() const {
+    int runner_up = -1;
+    for (int node = (_tree[0] + _runs.size()) / 2; node >= 1; node /= 2) {
+        if (runner_up == -1 || run_less_than(_tree[node], runner_up)) {
+            runner_up = _tree[node];
+        }
+    }
+    if (runner_up == -1 || _exhausted[runner_up]) {
+        return NULL;
+    }
+    return _runs[runner_up]->current_row();
+}
+
+Status SortedRunMerger::copy_row(
+        BatchedRowSupplier* supplier, RowBatch* output_batch, bool* done) {
+    int output_row_index = output_batch->add_row();
+    TupleRow* output_row = output_batch->get_row(output_row_index);
+    if (_deep_copy_input) {
+        supplier->current_row()->deep_copy(output_row, _input_row_desc->tuple_descriptors(),
+                output_batch->tuple_data_pool(), false);
+    } else {
+        // Simply copy tuple pointers if deep_copy is false.
+        memcpy(output_row, supplier->current_row(),
+                _input_row_desc->tuple_descriptors().size() * sizeof(Tuple*));
+    }
+    output_batch->commit_last_row();
+
+    // Advance to the next row. output_batch is supplied to transfer resource ownership
+    // if the input batch is exhausted.
+    return supplier->next(_deep_copy_input ? NULL : output_batch, done);
 }
 
 SortedRunMerger::SortedRunMerger(const TupleRowComparator& compare_less_than,
         RowDescriptor* row_desc, RuntimeProfile* profile, bool deep_copy_input) :
             _compare_less_than(compare_less_than),
             _input_row_desc(row_desc),
-            _deep_copy_input(deep_copy_input) {
+            _deep_copy_input(deep_copy_input),
+            _num_active_runs(0) {
         _get_next_timer = ADD_TIMER(profile, "MergeGetNext");
         _get_next_batch_timer = ADD_TIMER(profile, "MergeGetNextBatch");
+        _streak_rows_counter = ADD_COUNTER(profile, "MergeStreakRows", TUnit::UNIT);
     }
 
 Status SortedRunMerger::prepare(const vector<RunBatchSupplier>& input_runs) {
-    DCHECK_EQ(_min_heap.size(), 0);
-    _min_heap.reserve(input_runs.size());
+    DCHECK_EQ(_runs.size(), 0);
+    _runs.reserve(input_runs.size());
     BOOST_FOREACH(const RunBatchSupplier& input_run, input_runs) {
         BatchedRowSupplier* new_elem = _pool.add(new BatchedRowSupplier(this, input_run));
         DCHECK(new_elem != NULL);
         bool empty = false;
         RETURN_IF_ERROR(new_elem->init(&empty));
         if (!empty) {
-            _min_heap.push_back(new_elem);
+            _runs.push_back(new_elem);
         }
     }
 
-    // Construct the min heap from the sorted runs.
-    const int last_parent = (_min_heap.size() / 2) - 1;
-    for (int i = last_parent; i >= 0; --i) {
-        heapify(i);
+    // Construct the loser tree from the sorted runs.
+    _num_active_runs = _runs.size();
+    _exhausted.assign(_runs.size(), false);
+    if (!_runs.empty()) {
+        _tree.assign(_runs.size(), 0);
+        _tree[0] = build_tree(1);
     }
     return Status::OK;
 }
 
 Status SortedRunMerger::get_next(RowBatch* output_batch, bool* eos) {
     ScopedTimer<MonotonicStopWatch> timer(_get_next_timer);
-    if (_min_heap.empty()) {
+    if (_num_active_runs == 0) {
         *eos = true;
         return Status::OK;
     }
 
     while (!output_batch->at_capacity()) {
-        BatchedRowSupplier* min = _min_heap[0];
-        int output_row_index = output_batch->add_row();
-        TupleRow* output_row = output_batch->get_row(output_row_index);
-        if (_deep_copy_input) {
-            min->current_row()->deep_copy(output_row, _input_row_desc->tuple_descriptors(),
-                    output_batch->tuple_data_pool(), false);
-        } else {
-            // Simply copy tuple pointers if deep_copy is false.
-            memcpy(output_row, min->current_row(),
-                    _input_row_desc->tuple_descriptors().size() * sizeof(Tuple*));
+        int winner = _tree[0];
+        BatchedRowSupplier* supplier = _runs[winner];
+        bool done = false;
+        RETURN_IF_ERROR(copy_row(supplier, output_batch, &done));
+        if (!done) {
+            replay(winner);
+            if (_tree[0] != winner) {
+                continue;
+            }
+            // The run won twice in a row, its rows up to the smallest row of the other
+            // runs go next. The rest of a batch is copied without comparisons if its
+            // last row is not greater.
+            TupleRow* runner_up = runner_up_row();
+            int64_t num_streak_rows = 0;
+            while (!done && !output_batch->at_capacity()) {
+                int num_rows = 1;
+                if (runner_up == NULL
+                        || !_compare_less_than(runner_up, supplier->last_row())) {
+                    num_rows = supplier->num_rows_left();
+                } else if (_compare_less_than(runner_up, supplier->current_row())) {
+                    break;
+                }
+                for (int i = 0; i < num_rows && !done && !output_batch->at_capacity(); ++i) {
+                    RETURN_IF_ERROR(copy_row(supplier, output_batch, &done));
+                    ++num_streak_rows;
+                }
+            }
+            COUNTER_UPDATE(_streak_rows_counter, num_streak_rows);
+            if (num_streak_rows == 0) {
+                continue;
+            }
         }
-
-        output_batch->commit_last_row();
-
-        bool min_run_complete = false;
-        // Advance to the next element in min. output_batch is supplied to transfer
-        // resource ownership if the input batch in min is exhausted.
-        RETURN_IF_ERROR(min->next(_deep_copy_input ? NULL : output_batch,
-                    &min_run_complete));
-        if (min_run_complete) {
-            // Remove the element from the heap.
-            iter_swap(_min_heap.begin(), _min_heap.end() - 1);
-            _min_heap.pop_back();
-            if (_min_heap.empty()) break;
+        if (done) {
+            _exhausted[winner] = true;
+            --_num_active_runs;
+            if (_num_active_runs == 0) {
+                break;
+            }
         }
-
-        heapify(0);
+        replay(winner);
     }
 
-    *eos = _min_heap.empty();
+    *eos = _num_active_runs == 0;
     return Status::OK;
 }
 
@@ -35,8 +35,10 @@ class RuntimeProfile;
 
 // SortedRunMerger is used to merge multiple sorted runs of tuples. A run is a sorted
 // sequence of row batches, which are fetched from a RunBatchSupplier function object.
-// Merging is implemented using a binary min-heap that maintains the run with the next
-// tuple in sorted order at the top of the heap.
+// Merging is implemented using a loser tree, which finds the run with the next tuple in
+// sorted order with one comparison per level of the tree. When a run wins twice in a
+// row, its rows are copied without the tree up to the smallest row of the other runs,
+// whole batches of it without any comparison if they all go first.
 //
 // Merged batches of rows are retrieved from SortedRunMerger via calls to get_next().
 // The merger is constructed with a boolean flag deep_copy_input.
@@ -57,8 +59,7 @@ public:
     ~SortedRunMerger() {}
 
     // Prepare this merger to merge and return rows from the sorted runs in 'input_runs'.
-    // Retrieves the first batch from each run and sets up the binary heap implementing
-    // the priority queue.
+    // Retrieves the first batch from each run and sets up the loser tree.
     Status prepare(const std::vector<RunBatchSupplier>& input_runs);
 
     // Return the next batch of sorted rows from this merger.
@@ -71,18 +72,37 @@ public:
 private:
     class BatchedRowSupplier;
 
-    // Assuming the element at parent_index is the only out of place element in the heap,
-    // restore the heap property (i.e. swap elements so parent <= children).
-    void heapify(int parent_index);
+    // Returns true if the current row of run 'lhs' goes before the one of run 'rhs'.
+    // The rows of exhausted runs go after all the others.
+    bool run_less_than(int lhs, int rhs) const;
 
-    // The binary min-heap used to merge rows from the sorted input runs. Since the heap is
-    // stored in a 0-indexed array, the 0-th element is the minimum element in the heap,
-    // and the children of the element at index i are 2*i+1 and 2*i+2. The heap property is
-    // that row of the parent element is <= the rows of the child elements according to the
-    // comparator _compare_less_than.
-    // The BatchedRowSupplier objects used in the _min_heap are owned by this
-    // SortedRunMerger instance.
-    std::vector<BatchedRowSupplier*> _min_heap;
+    // Returns the winner of the subtree under 'node' and stores the losers of its nodes.
+    int build_tree(int node);
+
+    // Replays the matches from the leaf of 'run' to the root after its current row
+    // changed, setting the new winner to _tree[0].
+    void replay(int run);
+
+    // Returns the smallest current row of the runs other than the winner, NULL if they
+    // are all exhausted. Only the losers on the path of the winner can hold it.
+    TupleRow* runner_up_row() const;
+
+    // Copies the current row of 'supplier' to 'output_batch' and advances the supplier.
+    Status copy_row(BatchedRowSupplier* supplier, RowBatch* output_batch, bool* done);
+
+    // The sorted input runs, the BatchedRowSupplier objects are owned by _pool.
+    std::vector<BatchedRowSupplier*> _runs;
+
+    // True for the runs without rows left
+    std::vector<bool> _exhausted;
+
+    // The loser tree over _runs. Node i has the children 2 * i and 2 * i + 1, the leaf of
+    // run r is _runs.size() + r and the internal nodes 1 .. _runs.size() - 1 hold the run
+    // that lost the match at the node. _tree[0] holds the overall winner.
+    std::vector<int> _tree;
+
+    // Runs left to merge
+    int _num_active_runs;
 
     // Row comparator. Returns true if lhs < rhs.
     TupleRowComparator _compare_less_than;
@@ -102,6 +122,9 @@ private:
 
     // Times calls to get the next batch of rows from the input run.
     RuntimeProfile::Counter* _get_next_batch_timer;
+
+    // Rows copied from a winning run without replaying the loser tree.
+    RuntimeProfile::Counter* _streak_rows_counter;
 };
 
 } // namespace palo
@@ -24,13 +24,22 @@
 #include <sstream>
 
 #include <boost/mem_fn.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 
+#include "common/config.h"
+#include "exprs/expr.h"
 #include "runtime/buffered_block_mgr2.h"
+#include "runtime/mem_tracker.h"
 #include "runtime/row_batch.h"
 #include "runtime/runtime_state.h"
 #include "runtime/sorted_run_merger.h"
+#include "runtime/thread_resource_mgr.h"
 #include "util/runtime_profile.h"
 #include "util/debug_util.h"
+#include "util/query_trace.h"
+#include "util/sort_key_normalizer.h"
 
 using std::deque;
 using std::string;
@@ -46,6 +55,11 @@ namespace palo {
 // Number of pinned blocks required for a merge.
 const int BLOCKS_REQUIRED_FOR_MERGE = 3;
 
+// A parallel sort stops splitting ranges of a run below this number of tuples.
+const int64_t PARALLEL_SORT_MIN_RANGE = 4096;
+
+const int64_t SpillSorter::PARALLEL_SORT_MIN_TUPLES;
+
 // Error message when pinning fixed or variable length blocks failed.
 // TODO: Add the node id that iniated the sort
 const string PIN_FAILED_ERROR_MSG_1 = "Failed to pin block for ";
@@ -259,6 +273,14 @@ public:
     // is returned - the caller must check for cancellation.
     void sort(Run* run);
 
+    // Sorts the tuples in the range [first, last) of 'run'. Unlike sort(), the run is
+    // not marked as sorted. Used by the threads of a parallel sort.
+    void sort_range(Run* run, int64_t first, int64_t last);
+
+    // Partitions the tuples in the range [first, last) of 'run' around its middle tuple
+    // and returns the index of the first tuple of the second group.
+    int64_t partition_range(Run* run, int64_t first, int64_t last);
+
 private:
     static const int INSERTION_THRESHOLD = 16;
 
@@ -380,8 +402,64 @@ private:
 
     // Swaps tuples pointed to by left and right using the swap buffer.
     void swap(uint8_t* left, uint8_t* right);
+
+    // Sorts the tuples in the range [first, last) of the run by their normalized keys.
+    // Returns false and leaves the tuples as they are if the keys can't be normalized
+    // or the memory for them is not available.
+    bool sort_normalized(int64_t first, int64_t last);
+
+    // Encodes the keys of _less_than_comp, its width is 0 if enable_normalized_sort_key
+    // is off or the first key can't be normalized.
+    SortKeyNormalizer _normalizer;
 }; // class TupleSorter
 
+// The comparator and in-memory sorter used by one helper thread of a parallel sort.
+// The sort exprs are cloned since an ExprContext cannot be evaluated by several
+// threads at once.
+class SpillSorter::SortHelper {
+public:
+    SortHelper() {}
+
+    Status init(const TupleRowComparator& less_than_comp, int64_t block_size,
+            int tuple_size, RuntimeState* state) {
+        RETURN_IF_ERROR(Expr::clone_if_not_exists(
+                    less_than_comp.key_expr_ctxs_lhs(), state, &_lhs_expr_ctxs));
+        RETURN_IF_ERROR(Expr::clone_if_not_exists(
+                    less_than_comp.key_expr_ctxs_rhs(), state, &_rhs_expr_ctxs));
+        _less_than_comp.reset(
+                new TupleRowComparator(less_than_comp, _lhs_expr_ctxs, _rhs_expr_ctxs));
+        _sorter.reset(new TupleSorter(*_less_than_comp, block_size, tuple_size, state));
+        return Status::OK;
+    }
+
+    void close(RuntimeState* state) {
+        Expr::close(_lhs_expr_ctxs, state);
+        Expr::close(_rhs_expr_ctxs, state);
+    }
+
+    TupleSorter* sorter() {
+        return _sorter.get();
+    }
+
+private:
+    std::vector<ExprContext*> _lhs_expr_ctxs;
+    std::vector<ExprContext*> _rhs_expr_ctxs;
+    scoped_ptr<TupleRowComparator> _less_than_comp;
+    scoped_ptr<TupleSorter> _sorter;
+};
+
+// Ranges [first, last) of a run that still have to be sorted by a parallel sort.
+// 'num_busy' is the number of threads working on a range they took; the sort is done
+// once no range is left and no thread is busy.
+struct SpillSorter::SortRangeQueue {
+    SortRangeQueue() : num_busy(0) {}
+
+    boost::mutex lock;
+    boost::condition_variable range_available;
+    deque<std::pair<int64_t, int64_t> > ranges;
+    int num_busy;
+};
+
 // SpillSorter::Run methods
 SpillSorter::Run::Run(
         SpillSorter* parent, TupleDescriptor* sort_tuple_desc, bool materialize_slots) :
@@ -582,6 +660,11 @@ void SpillSorter::Run::delete_all_blocks() {
 }
 
 Status SpillSorter::Run::unpin_all_blocks() {
+    ScopedTraceSpan span(_sorter->_state->query_trace(), "spill", "spill_sort_run");
+    if (span.enabled()) {
+        span.set_detail("blocks=" + std::to_string(_fixed_len_blocks.size()
+                + _var_len_blocks.size()));
+    }
     vector<BufferedBlockMgr2::Block*> sorted_var_len_blocks;
     sorted_var_len_blocks.reserve(_var_len_blocks.size());
     vector<StringValue*> string_values;
@@ -904,6 +987,9 @@ SpillSorter::TupleSorter::TupleSorter(
     _temp_tuple_buffer = new uint8_t[tuple_size];
     _temp_tuple_row = reinterpret_cast<TupleRow*>(&_temp_tuple_buffer);
     _swap_buffer = new uint8_t[tuple_size];
+    if (config::enable_normalized_sort_key) {
+        _normalizer.init(_less_than_comp);
+    }
 }
 
 SpillSorter::TupleSorter::~TupleSorter() {
@@ -913,10 +999,46 @@ SpillSorter::TupleSorter::~TupleSorter() {
 
 void SpillSorter::TupleSorter::sort(Run* run) {
     _run = run;
-    sort_helper(TupleIterator(this, 0), TupleIterator(this, _run->_num_tuples));
+    if (!sort_normalized(0, _run->_num_tuples)) {
+        sort_helper(TupleIterator(this, 0), TupleIterator(this, _run->_num_tuples));
+    }
     run->_is_sorted = true;
 }
 
+void SpillSorter::TupleSorter::sort_range(Run* run, int64_t first, int64_t last) {
+    _run = run;
+    if (!sort_normalized(first, last)) {
+        sort_helper(TupleIterator(this, first), TupleIterator(this, last));
+    }
+}
+
+bool SpillSorter::TupleSorter::sort_normalized(int64_t first, int64_t last) {
+    int64_t num_tuples = last - first;
+    if (_normalizer.width() == 0 || num_tuples <= INSERTION_THRESHOLD) {
+        return false;
+    }
+    MemTracker* mem_tracker = _state->instance_mem_tracker();
+    int64_t mem = _normalizer.sort_memory(num_tuples) + num_tuples * sizeof(uint8_t*);
+    if (!mem_tracker->try_consume(mem)) {
+        return false;
+    }
+    std::vector<uint8_t*> tuples;
+    tuples.reserve(num_tuples);
+    for (TupleIterator iter(this, first); iter._index < last; iter.next()) {
+        tuples.push_back(iter._current_tuple);
+    }
+    _normalizer.sort_tuples(tuples.data(), num_tuples, _tuple_size, _less_than_comp);
+    mem_tracker->release(mem);
+    return true;
+}
+
+int64_t SpillSorter::TupleSorter::partition_range(Run* run, int64_t first, int64_t last) {
+    _run = run;
+    TupleIterator pivot(this, first + (last - first) / 2);
+    return partition(TupleIterator(this, first), TupleIterator(this, last),
+            reinterpret_cast<Tuple*>(pivot._current_tuple))._index;
+}
+
 // Sort the sequence of tuples from [first, last).
 // Begin with a sorted sequence of size 1 [first, first+1).
 // During each pass of the outermost loop, add the next tuple (at position 'i') to
@@ -1033,6 +1155,7 @@ SpillSorter::SpillSorter(const TupleRowComparator& compare_less_than,
     _initial_runs_counter(NULL),
     _num_merges_counter(NULL),
     _in_mem_sort_timer(NULL),
+    _in_mem_sort_threads(NULL),
     _sorted_data_size(NULL) {
 }
 
@@ -1050,6 +1173,10 @@ SpillSorter::~SpillSorter() {
         _unsorted_run->delete_all_blocks();
     }
     _block_mgr->clear_reservations(_block_mgr_client);
+    for (int i = 0; i < _sort_helpers.size(); ++i) {
+        _sort_helpers[i]->close(_state);
+        delete _sort_helpers[i];
+    }
 }
 
 Status SpillSorter::init() {
@@ -1063,6 +1190,7 @@ Status SpillSorter::init() {
     _initial_runs_counter = ADD_COUNTER(_profile, "InitialRunsCreated", TUnit::UNIT);
     _num_merges_counter = ADD_COUNTER(_profile, "TotalMergesPerformed", TUnit::UNIT);
     _in_mem_sort_timer = ADD_TIMER(_profile, "InMemorySortTime");
+    _in_mem_sort_threads = ADD_COUNTER(_profile, "InMemorySortThreads", TUnit::UNIT);
     _sorted_data_size = ADD_COUNTER(_profile, "SortDataSize", TUnit::BYTES);
 
     int min_blocks_required = BLOCKS_REQUIRED_FOR_MERGE;
@@ -1199,7 +1327,16 @@ Status SpillSorter::sort_run() {
     }
     {
         SCOPED_TIMER(_in_mem_sort_timer);
-        _in_mem_tuple_sorter->sort(_unsorted_run);
+        int num_helpers = acquire_sort_threads(_unsorted_run->_num_tuples);
+        if (num_helpers > 0) {
+            Status status = parallel_sort(_unsorted_run, num_helpers);
+            for (int i = 0; i < num_helpers; ++i) {
+                _state->resource_pool()->release_thread_token(false);
+            }
+            RETURN_IF_ERROR(status);
+        } else {
+            _in_mem_tuple_sorter->sort(_unsorted_run);
+        }
         RETURN_IF_CANCELLED(_state);
     }
     _sorted_runs.push_back(_unsorted_run);
@@ -1207,6 +1344,84 @@ Status SpillSorter::sort_run() {
     return Status::OK;
 }
 
+int SpillSorter::acquire_sort_threads(int64_t num_tuples) {
+    ThreadResourceMgr::ResourcePool* pool = _state->resource_pool();
+    if (pool == NULL || num_tuples < PARALLEL_SORT_MIN_TUPLES) {
+        return 0;
+    }
+    int num_helpers = 0;
+    while (num_helpers + 1 < config::spill_sort_max_threads
+            && pool->try_acquire_thread_token()) {
+        ++num_helpers;
+    }
+    return num_helpers;
+}
+
+Status SpillSorter::parallel_sort(Run* run, int num_helpers) {
+    TupleDescriptor* sort_tuple_desc = _output_row_desc->tuple_descriptors()[0];
+    while (_sort_helpers.size() < num_helpers) {
+        _sort_helpers.push_back(new SortHelper());
+        RETURN_IF_ERROR(_sort_helpers.back()->init(_compare_less_than,
+                    _block_mgr->max_block_size(), sort_tuple_desc->byte_size(), _state));
+    }
+    if (num_helpers + 1 > _in_mem_sort_threads->value()) {
+        _in_mem_sort_threads->set(static_cast<int64_t>(num_helpers + 1));
+    }
+
+    // Split the run into a few ranges per thread so that threads that got small ranges
+    // can help with the others.
+    int64_t split_size = run->_num_tuples / (4 * (num_helpers + 1));
+    if (split_size < PARALLEL_SORT_MIN_RANGE) {
+        split_size = PARALLEL_SORT_MIN_RANGE;
+    }
+    SortRangeQueue queue;
+    queue.ranges.push_back(std::pair<int64_t, int64_t>(0, run->_num_tuples));
+    boost::thread_group helper_threads;
+    for (int i = 0; i < num_helpers; ++i) {
+        helper_threads.add_thread(new boost::thread(&SpillSorter::sort_ranges,
+                    _sort_helpers[i]->sorter(), run, &queue, split_size, _state));
+    }
+    sort_ranges(_in_mem_tuple_sorter.get(), run, &queue, split_size, _state);
+    helper_threads.join_all();
+    run->_is_sorted = true;
+    return Status::OK;
+}
+
+void SpillSorter::sort_ranges(TupleSorter* sorter, Run* run, SortRangeQueue* queue,
+        int64_t split_size, RuntimeState* state) {
+    boost::unique_lock<boost::mutex> l(queue->lock);
+    while (true) {
+        while (queue->ranges.empty() && queue->num_busy > 0) {
+            queue->range_available.wait(l);
+        }
+        if (queue->ranges.empty()) {
+            // Nothing left to sort, wake up the other threads so that they exit too.
+            queue->range_available.notify_all();
+            return;
+        }
+        std::pair<int64_t, int64_t> range = queue->ranges.front();
+        queue->ranges.pop_front();
+        ++queue->num_busy;
+        l.unlock();
+
+        if (range.second - range.first > split_size && !state->is_cancelled()) {
+            int64_t cut = sorter->partition_range(run, range.first, range.second);
+            l.lock();
+            queue->ranges.push_back(std::make_pair(range.first, cut));
+            queue->ranges.push_back(std::make_pair(cut, range.second));
+            queue->range_available.notify_all();
+        } else {
+            // Returns early if the query is cancelled, the caller checks for it.
+            sorter->sort_range(run, range.first, range.second);
+            l.lock();
+        }
+        --queue->num_busy;
+        if (queue->num_busy == 0 && queue->ranges.empty()) {
+            queue->range_available.notify_all();
+        }
+    }
+}
+
 uint64_t SpillSorter::estimate_merge_mem(
         uint64_t available_blocks, RowDescriptor* row_desc, int merge_batch_size) {
     bool has_var_len_slots = row_desc->tuple_descriptors()[0]->has_varlen_slots();
@@ -22,6 +22,7 @@
 #define BDG_PALO_BE_SRC_RUNTIME_SPILL_SORTER_H
 
 #include <deque>
+#include <vector>
 
 #include "runtime/buffered_block_mgr2.h"
 #include "util/tuple_row_compare.h"
@@ -61,7 +62,10 @@ class RowBatch;
 // converted to offsets from the start of the first var-len data block. When a block is
 // read back, these offsets are converted back to pointers.
 // The in-memory sorter sorts the fixed-length tuples in-place. The output rows have the
-// same schema as the materialized sort tuples.
+// same schema as the materialized sort tuples. If the query has thread tokens left, a
+// large run is sorted by up to config::spill_sort_max_threads threads: a thread takes a
+// range of the run, partitions it and queues both halves again until the ranges are
+// small enough to be sorted by one thread each.
 //
 // After the input is consumed, the sorter is left with one or more sorted runs. The
 // client calls get_next(output_batch) to retrieve batches of sorted rows. If there are
@@ -135,6 +139,11 @@ public:
 private:
     class Run;
     class TupleSorter;
+    class SortHelper;
+    struct SortRangeQueue;
+
+    // Runs smaller than this are always sorted by the fragment thread alone.
+    static const int64_t PARALLEL_SORT_MIN_TUPLES = 64 * 1024;
 
     // Create a SortedRunMerger from the first 'num_runs' sorted runs in _sorted_runs and
     // assign it to _merger. The runs to be merged are removed from _sorted_runs.
@@ -154,6 +163,18 @@ private:
     // blocks at the end of the run. Updates the sort bytes counter if necessary.
     Status sort_run();
 
+    // Acquires optional thread tokens for sorting a run of 'num_tuples' tuples in
+    // parallel. Returns the number of tokens acquired, which the caller must release.
+    int acquire_sort_threads(int64_t num_tuples);
+
+    // Sorts 'run' with the fragment thread and 'num_helpers' more threads.
+    Status parallel_sort(Run* run, int num_helpers);
+
+    // Takes ranges of 'run' from 'queue' until all of it is sorted. Executed by every
+    // thread of a parallel sort, each with its own 'sorter'.
+    static void sort_ranges(TupleSorter* sorter, Run* run, SortRangeQueue* queue,
+            int64_t split_size, RuntimeState* state);
+
     // Runtime state instance used to check for cancellation. Not owned.
     RuntimeState* const _state;
 
@@ -161,6 +182,10 @@ private:
     TupleRowComparator _compare_less_than;
     boost::scoped_ptr<TupleSorter> _in_mem_tuple_sorter;
 
+    // Sorters of the helper threads of a parallel sort. Created on the first parallel sort
+    // and kept until the SpillSorter is destroyed. Owned.
+    std::vector<SortHelper*> _sort_helpers;
+
     // Block manager object used to allocate, pin and release runs. Not owned by SpillSorter.
     BufferedBlockMgr2* _block_mgr;
 
@@ -214,6 +239,7 @@ private:
     RuntimeProfile::Counter* _initial_runs_counter;
     RuntimeProfile::Counter* _num_merges_counter;
     RuntimeProfile::Counter* _in_mem_sort_timer;
+    RuntimeProfile::Counter* _in_mem_sort_threads;
     RuntimeProfile::Counter* _sorted_data_size;
 };
 
@@ -0,0 +1,182 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "runtime/stream_load_pipe.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/locks.hpp>
+
+#include "common/config.h"
+#include "common/logging.h"
+#include "util/blocking_aware_thread_pool.h"
+
+namespace palo {
+
+using boost::mutex;
+using boost::unique_lock;
+
+static const std::string PIPE_PATH_PREFIX = "stream_load_pipe://";
+
+StreamLoadPipe::StreamLoadPipe(int64_t max_buffered_bytes) :
+        _max_buffered_bytes(std::max<int64_t>(max_buffered_bytes, 1)),
+        _offset(0),
+        _buffered_bytes(0),
+        _finished(false),
+        _cancelled(false) {
+}
+
+Status StreamLoadPipe::append(const char* data, int64_t size) {
+    unique_lock<mutex> l(_lock);
+    boost::system_time deadline = boost::get_system_time()
+            + boost::posix_time::seconds(config::streaming_mini_load_timeout_s);
+    while (!_cancelled && _buffered_bytes >= _max_buffered_bytes) {
+        BlockingAwareThreadPool::ScopedBlocking blocking(&l);
+        if (!_put_cv.timed_wait(l, deadline) && _buffered_bytes >= _max_buffered_bytes) {
+            _cancelled = true;
+            _cancel_reason = "the etl job of the load didn't read its data in time";
+            _get_cv.notify_all();
+        }
+    }
+    if (_cancelled) {
+        return Status(_cancel_reason);
+    }
+    DCHECK(!_finished);
+    _chunks.push_back(std::string(data, size));
+    _buffered_bytes += size;
+    _get_cv.notify_one();
+    return Status::OK;
+}
+
+void StreamLoadPipe::finish() {
+    {
+        boost::lock_guard<mutex> l(_lock);
+        _finished = true;
+    }
+    _get_cv.notify_all();
+}
+
+void StreamLoadPipe::cancel(const std::string& reason) {
+    {
+        boost::lock_guard<mutex> l(_lock);
+        if (_cancelled) {
+            return;
+        }
+        _cancelled = true;
+        _cancel_reason = reason;
+    }
+    _get_cv.notify_all();
+    _put_cv.notify_all();
+}
+
+Status StreamLoadPipe::read_line(std::string* line, bool* eos) {
+    line->clear();
+    *eos = false;
+    unique_lock<mutex> l(_lock);
+    boost::system_time deadline = boost::get_system_time()
+            + boost::posix_time::seconds(config::streaming_mini_load_timeout_s);
+    while (true) {
+        if (_cancelled) {
+            return Status(_cancel_reason);
+        }
+        if (!_chunks.empty()) {
+            const std::string& chunk = _chunks.front();
+            size_t end = chunk.find('\n', _offset);
+            size_t len = (end == std::string::npos ? chunk.size() : end) - _offset;
+            line->append(chunk, _offset, len);
+            _offset += len;
+            if (end != std::string::npos) {
+                // skip the delimiter
+                ++_offset;
+            }
+            if (_offset == chunk.size()) {
+                _buffered_bytes -= chunk.size();
+                _chunks.pop_front();
+                _offset = 0;
+                _put_cv.notify_one();
+            }
+            if (end != std::string::npos) {
+                return Status::OK;
+            }
+            continue;
+        }
+        if (_finished) {
+            // the last line may lack its '\n'
+            *eos = line->empty();
+            return Status::OK;
+        }
+        BlockingAwareThreadPool::ScopedBlocking blocking(&l);
+        if (!_get_cv.timed_wait(l, deadline) && _chunks.empty() && !_finished
+                && !_cancelled) {
+            _cancelled = true;
+            _cancel_reason = "the data of the load didn't arrive in time";
+            _put_cv.notify_all();
+        }
+    }
+}
+
+StreamLoadPipeMgr::StreamLoadPipeMgr() : _next_id(0) {
+}
+
+bool StreamLoadPipeMgr::is_pipe_path(const std::string& path) {
+    return path.compare(0, PIPE_PATH_PREFIX.size(), PIPE_PATH_PREFIX) == 0;
+}
+
+std::string StreamLoadPipeMgr::register_pipe(
+        const std::string& name, const std::shared_ptr<StreamLoadPipe>& pipe) {
+    boost::lock_guard<mutex> l(_lock);
+    time_t now = time(NULL);
+    gc_expired_pipes(now);
+    std::stringstream ss;
+    ss << PIPE_PATH_PREFIX << name << "." << _next_id++;
+    Entry& entry = _pipes[ss.str()];
+    entry.pipe = pipe;
+    entry.register_time = now;
+    return ss.str();
+}
+
+void StreamLoadPipeMgr::unregister_pipe(const std::string& path) {
+    boost::lock_guard<mutex> l(_lock);
+    _pipes.erase(path);
+}
+
+std::shared_ptr<StreamLoadPipe> StreamLoadPipeMgr::open_pipe(const std::string& path) {
+    boost::lock_guard<mutex> l(_lock);
+    std::map<std::string, Entry>::iterator it = _pipes.find(path);
+    if (it == _pipes.end()) {
+        return std::shared_ptr<StreamLoadPipe>();
+    }
+    std::shared_ptr<StreamLoadPipe> pipe = it->second.pipe;
+    _pipes.erase(it);
+    return pipe;
+}
+
+void StreamLoadPipeMgr::gc_expired_pipes(time_t now) {
+    std::map<std::string, Entry>::iterator it = _pipes.begin();
+    while (it != _pipes.end()) {
+        if (now - it->second.register_time > config::streaming_mini_load_timeout_s) {
+            LOG(WARNING) << "nobody read the data of load " << it->first << " in time";
+            it->second.pipe->cancel("the etl job of the load didn't start in time");
+            _pipes.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+}
+
+}
@@ -0,0 +1,111 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef BDG_PALO_BE_RUNTIME_STREAM_LOAD_PIPE_H
+#define BDG_PALO_BE_RUNTIME_STREAM_LOAD_PIPE_H
+
+#include <stdint.h>
+#include <time.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "common/status.h"
+
+namespace palo {
+
+// A bounded in-memory byte stream from the http body of a mini load to the csv scanner
+// of its etl job, which replaces staging the body in a local file.
+//
+// append() blocks while 'max_buffered_bytes' are buffered and read_line() blocks while
+// nothing is, both for at most config::streaming_mini_load_timeout_s. Either side may
+// cancel the pipe, which fails the calls of the other one.
+class StreamLoadPipe {
+public:
+    explicit StreamLoadPipe(int64_t max_buffered_bytes);
+
+    // Appends 'size' bytes of 'data'.
+    Status append(const char* data, int64_t size);
+
+    // Called by the writer after the last append().
+    void finish();
+
+    // Fails the pending and future calls of both sides with 'reason'.
+    void cancel(const std::string& reason);
+
+    // Reads the next line into 'line', without its '\n'. Sets 'eos' once the writer
+    // finished and everything was read.
+    Status read_line(std::string* line, bool* eos);
+
+private:
+    const int64_t _max_buffered_bytes;
+
+    boost::mutex _lock;
+    // Signalled when data is appended, the pipe is finished or cancelled.
+    boost::condition_variable _get_cv;
+    // Signalled when data is read or the pipe is cancelled.
+    boost::condition_variable _put_cv;
+    std::deque<std::string> _chunks;
+    // Read offset in _chunks.front().
+    size_t _offset;
+    int64_t _buffered_bytes;
+    bool _finished;
+    std::string _cancel_reason;
+    bool _cancelled;
+};
+
+// Hands the pipes of mini loads over to the csv scanners of their etl jobs. A pipe is
+// known by a path, which the etl job gets as the path of its file.
+class StreamLoadPipeMgr {
+public:
+    StreamLoadPipeMgr();
+
+    // Returns true if 'path' names a pipe rather than a file.
+    static bool is_pipe_path(const std::string& path);
+
+    // Registers 'pipe' under a path derived from 'name' and returns the path.
+    std::string register_pipe(const std::string& name,
+                              const std::shared_ptr<StreamLoadPipe>& pipe);
+
+    // Unregisters the pipe of 'path' if it wasn't opened yet.
+    void unregister_pipe(const std::string& path);
+
+    // Hands the pipe of 'path' over to its reader, NULL if it is unknown or was opened
+    // already. A pipe is read once.
+    std::shared_ptr<StreamLoadPipe> open_pipe(const std::string& path);
+
+private:
+    struct Entry {
+        std::shared_ptr<StreamLoadPipe> pipe;
+        time_t register_time;
+    };
+
+    // Cancels the pipes that nobody opened in time. Must be called with _lock held.
+    void gc_expired_pipes(time_t now);
+
+    boost::mutex _lock;
+    std::map<std::string, Entry> _pipes;
+    int64_t _next_id;
+};
+
+}
+
+#endif // BDG_PALO_BE_RUNTIME_STREAM_LOAD_PIPE_H
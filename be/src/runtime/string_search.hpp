@@ -27,11 +27,16 @@
 
 #include "common/logging.h"
 #include "runtime/string_value.h"
+#include "util/cpu_info.h"
+#ifdef __SSE4_2__
+#include "util/sse_util.hpp"
+#endif
 
 namespace palo {
 
-// TODO: This can be sped up with SIDD_CMP_EQUAL_ORDERED or at the very least rewritten
-// from published algorithms.
+// With SSE4.2, patterns of at least 2 chars are first searched 16 positions at a time by
+// comparing the first and the last char of the pattern, only the candidates found are
+// compared completely. The rest of the string is searched as below.
 //
 // This is taken from the python search string function doing string search (substring)
 // using an optimized boyer-moore-horspool algorithm.
@@ -140,12 +145,22 @@ public:
             return -1;
         }
 
+        int start = 0;
+#ifdef __SSE4_2__
+        if (CpuInfo::is_supported(CpuInfo::SSE4_2)) {
+            start = sse_search(s, w, p, m);
+            if (start < 0) {
+                return -(start + 1);
+            }
+        }
+#endif
+
         // General case.
         int j;
         // TODO: the original code seems to have an off by one error. It is possible
         // to index at w + m which is the length of the input string. Checks have
         // been added to make sure that w + m < str->len.
-        for (int i = 0; i <= w; i++) {
+        for (int i = start; i <= w; i++) {
             // note: using mlast in the skip path slows things down on x86
             if (s[i + m - 1] == p[m - 1]) {
                 // candidate match
@@ -178,6 +193,34 @@ public:
 private:
     static const int BLOOM_WIDTH = 64;
 
+#ifdef __SSE4_2__
+    // Searches the pattern 'p' of length 'm' >= 2 at the positions [0, w] of 's', 16
+    // at a time. Returns -(offset + 1) if the pattern was found at offset, otherwise the
+    // first position that still has to be searched.
+    static int sse_search(const char* s, int w, const char* p, int m) {
+        const __m128i first = _mm_set1_epi8(p[0]);
+        const __m128i last = _mm_set1_epi8(p[m - 1]);
+        int i = 0;
+        // The loads for the positions [i, i + 16) end at s[i + 16 + m - 2] <= s[w + m - 1].
+        for (; i + sse_util::CHARS_PER_128_BIT_REGISTER <= w + 1;
+                i += sse_util::CHARS_PER_128_BIT_REGISTER) {
+            __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+            __m128i block_last =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i + m - 1));
+            int mask = _mm_movemask_epi8(_mm_and_si128(
+                    _mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last)));
+            while (mask != 0) {
+                int offset = i + __builtin_ctz(mask);
+                if (memcmp(s + offset + 1, p + 1, m - 2) == 0) {
+                    return -(offset + 1);
+                }
+                mask &= mask - 1;
+            }
+        }
+        return i;
+    }
+#endif
+
     void bloom_add(char c) {
         _mask |= (1UL << (c & (BLOOM_WIDTH - 1)));
     }
@@ -131,6 +131,76 @@ struct StringValue {
 };
 
 // This function must be called 'hash_value' to be picked up by boost.
+// The length and the first bytes of a StringValue, held inline in 16 bytes. Strings
+// of up to MAX_INLINE_LENGTH bytes are held completely, such as codes, flags and
+// enum-like values, so two of them are compared without dereferencing any string
+// data. Longer strings are only told apart by their length and prefix.
+//
+// StringValue itself keeps its pointer and length layout, which the tuple layout of
+// the frontend and the codegen'd code rely on. This is for structures that keep their
+// own copy of string keys next to the rows, like hash table nodes and sort entries.
+struct StringValuePrefix {
+    static const int MAX_INLINE_LENGTH = 12;
+
+    // -1 if this is the prefix of a NULL value.
+    int32_t len;
+    // The first bytes of the string, zero padded.
+    char data[MAX_INLINE_LENGTH];
+
+    StringValuePrefix() : len(-1) {
+        memset(data, 0, MAX_INLINE_LENGTH);
+    }
+
+    explicit StringValuePrefix(const StringValue& v) : len(v.len) {
+        memset(data, 0, MAX_INLINE_LENGTH);
+        memcpy(data, v.ptr, v.len < MAX_INLINE_LENGTH ? v.len : MAX_INLINE_LENGTH);
+    }
+
+    bool is_null() const {
+        return len < 0;
+    }
+
+    // True if the whole string is held inline.
+    bool is_complete() const {
+        return len <= MAX_INLINE_LENGTH;
+    }
+
+    // Returns false if the strings differ. Otherwise they are equal if is_complete(),
+    // and may be equal if not.
+    bool may_eq(const StringValuePrefix& other) const {
+        uint64_t head;
+        uint64_t other_head;
+        memcpy(&head, this, sizeof(head));
+        memcpy(&other_head, &other, sizeof(other_head));
+        if (head != other_head) {
+            return false;
+        }
+        uint64_t tail;
+        uint64_t other_tail;
+        memcpy(&tail, data + 4, sizeof(tail));
+        memcpy(&other_tail, other.data + 4, sizeof(other_tail));
+        return tail == other_tail;
+    }
+
+    // Compares like StringValue::compare() and sets '*decided' if the prefixes are
+    // enough to order the strings, i.e. unless both strings are longer than the
+    // prefixes and their prefixes are equal.
+    int compare(const StringValuePrefix& other, bool* decided) const {
+        int common_len = len < other.len ? len : other.len;
+        if (common_len > MAX_INLINE_LENGTH) {
+            common_len = MAX_INLINE_LENGTH;
+        }
+        int result = memcmp(data, other.data, common_len);
+        if (result != 0) {
+            *decided = true;
+            return result;
+        }
+        // A complete string that matched is a prefix of the other one.
+        *decided = is_complete() || other.is_complete();
+        return len - other.len;
+    }
+};
+
 inline std::size_t hash_value(const StringValue& v) {
     return HashUtil::hash(v.ptr, v.len, 0);
 }
@@ -20,15 +20,41 @@
 
 #include "runtime/thread_resource_mgr.h"
 
+#include <algorithm>
+#include <fstream>
 #include <vector>
 
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
+#include "common/config.h"
 #include "common/logging.h"
 #include "util/cpu_info.h"
 
 namespace palo {
 
+// Reads the busy and total CPU time of the machine from /proc/stat. Returns false if
+// they are not available.
+static bool read_cpu_times(int64_t* busy, int64_t* total) {
+    std::ifstream stat("/proc/stat");
+    std::string cpu;
+    stat >> cpu;
+    if (!stat.good() || cpu != "cpu") {
+        return false;
+    }
+    // user nice system idle iowait irq softirq steal
+    int64_t times[8] = { 0 };
+    for (int i = 0; i < 8 && stat >> times[i]; ++i) {
+    }
+    *total = 0;
+    for (int i = 0; i < 8; ++i) {
+        *total += times[i];
+    }
+    *busy = *total - times[3] - times[4];
+    return true;
+}
+
 ThreadResourceMgr::ThreadResourceMgr(int threads_quota) {
     DCHECK_GE(threads_quota, 0);
 
@@ -38,12 +64,36 @@ ThreadResourceMgr::ThreadResourceMgr(int threads_quota) {
         _system_threads_quota = threads_quota;
     }
 
-    _per_pool_quota = 0;
+    init();
 }
 
 ThreadResourceMgr::ThreadResourceMgr() {
     _system_threads_quota = CpuInfo::num_cores() * config::num_threads_per_core;
+    init();
+}
+
+void ThreadResourceMgr::init() {
+    _effective_threads_quota = _system_threads_quota;
     _per_pool_quota = 0;
+    _stop_rebalance = false;
+    _last_cpu_busy = -1;
+    _last_cpu_total = -1;
+    _cpu_busy_percent = -1;
+    if (config::thread_quota_rebalance_interval_ms > 0) {
+        _rebalance_thread.reset(new boost::thread(
+                boost::bind(&ThreadResourceMgr::rebalance_thread, this)));
+    }
+}
+
+ThreadResourceMgr::~ThreadResourceMgr() {
+    if (_rebalance_thread != NULL) {
+        {
+            boost::lock_guard<boost::mutex> l(_lock);
+            _stop_rebalance = true;
+        }
+        _stop_cv.notify_all();
+        _rebalance_thread->join();
+    }
 }
 
 ThreadResourceMgr::ResourcePool::ResourcePool(ThreadResourceMgr* parent)
@@ -53,8 +103,22 @@ ThreadResourceMgr::ResourcePool::ResourcePool(ThreadResourceMgr* parent)
 void ThreadResourceMgr::ResourcePool::reset() {
     _num_threads = 0;
     _num_reserved_optional_threads = 0;
+    _num_blocked_threads = 0;
+    _num_denied = 0;
     _thread_available_fn = NULL;
     _max_quota = INT_MAX;
+    _dynamic_quota = INT_MAX;
+}
+
+void ThreadResourceMgr::ResourcePool::begin_blocking() {
+    __sync_fetch_and_add(&_num_blocked_threads, 1);
+    // the blocked thread leaves room for another one
+    notify_thread_available();
+}
+
+void ThreadResourceMgr::ResourcePool::end_blocking() {
+    int blocked = __sync_sub_and_fetch(&_num_blocked_threads, 1);
+    DCHECK_GE(blocked, 0);
 }
 
 void ThreadResourceMgr::ResourcePool::reserve_optional_tokens(int num) {
@@ -104,10 +168,11 @@ void ThreadResourceMgr::update_pool_quotas(ResourcePool* new_pool) {
     }
 
     _per_pool_quota =
-        ceil(static_cast<double>(_system_threads_quota) / _pools.size());
+        ceil(static_cast<double>(_effective_threads_quota) / _pools.size());
 
     for (Pools::iterator it = _pools.begin(); it != _pools.end(); ++it) {
         ResourcePool* pool = *it;
+        pool->_dynamic_quota = _per_pool_quota;
 
         if (pool == new_pool) {
             continue;
@@ -121,5 +186,78 @@ void ThreadResourceMgr::update_pool_quotas(ResourcePool* new_pool) {
     }
 }
 
+void ThreadResourceMgr::rebalance(int cpu_busy_percent) {
+    boost::lock_guard<boost::mutex> l(_lock);
+    if (cpu_busy_percent >= config::thread_quota_contention_cpu_percent) {
+        _effective_threads_quota -= std::max(_effective_threads_quota / 8, 1);
+    } else if (cpu_busy_percent >= 0
+            && cpu_busy_percent < config::thread_quota_contention_cpu_percent - 10) {
+        _effective_threads_quota += std::max(_system_threads_quota / 8, 1);
+    }
+    _effective_threads_quota = std::min(_effective_threads_quota, _system_threads_quota);
+    _effective_threads_quota = std::max(_effective_threads_quota,
+            std::min(static_cast<int>(_pools.size()), _system_threads_quota));
+    _effective_threads_quota = std::max(_effective_threads_quota, 1);
+    if (_pools.empty()) {
+        return;
+    }
+
+    int fair_quota = ceil(static_cast<double>(_effective_threads_quota) / _pools.size());
+    _per_pool_quota = fair_quota;
+
+    // Pools that got by with fewer threads than their share keep one more than they
+    // used, the rest goes to the pools that were denied threads.
+    int spare = 0;
+    std::vector<ResourcePool*> demanding;
+    for (Pools::iterator it = _pools.begin(); it != _pools.end(); ++it) {
+        ResourcePool* pool = *it;
+        int64_t denied = __sync_lock_test_and_set(&pool->_num_denied, 0);
+        if (denied > 0) {
+            demanding.push_back(pool);
+            continue;
+        }
+        int used = std::max(
+                static_cast<int>(pool->num_threads()) - pool->num_blocked_threads(), 0);
+        pool->_dynamic_quota = std::min(fair_quota, used + 1);
+        spare += fair_quota - pool->_dynamic_quota;
+    }
+    for (int i = 0; i < demanding.size(); ++i) {
+        int share = spare / (demanding.size() - i);
+        demanding[i]->_dynamic_quota = fair_quota + share;
+        spare -= share;
+    }
+
+    for (Pools::iterator it = _pools.begin(); it != _pools.end(); ++it) {
+        (*it)->notify_thread_available();
+    }
 }
 
+void ThreadResourceMgr::rebalance_thread() {
+    while (true) {
+        {
+            boost::unique_lock<boost::mutex> l(_lock);
+            if (!_stop_rebalance) {
+                _stop_cv.timed_wait(l, boost::posix_time::milliseconds(
+                        config::thread_quota_rebalance_interval_ms));
+            }
+            if (_stop_rebalance) {
+                return;
+            }
+        }
+
+        int cpu_busy_percent = -1;
+        int64_t busy = 0;
+        int64_t total = 0;
+        if (read_cpu_times(&busy, &total)) {
+            if (_last_cpu_total >= 0 && total > _last_cpu_total) {
+                cpu_busy_percent = (busy - _last_cpu_busy) * 100 / (total - _last_cpu_total);
+            }
+            _last_cpu_busy = busy;
+            _last_cpu_total = total;
+        }
+        _cpu_busy_percent = cpu_busy_percent;
+        rebalance(cpu_busy_percent);
+    }
+}
+
+}
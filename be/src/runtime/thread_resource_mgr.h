@@ -26,6 +26,7 @@
 #include <boost/function.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/thread.hpp>
 
@@ -64,6 +65,16 @@ namespace palo {
 //  - Admission control
 //  - Integration with other nodes/statestore
 //  - Priorities for different pools
+// Unless config::thread_quota_rebalance_interval_ms is 0, the quotas are
+// rebalanced periodically on top of the even split:
+//  - Threads blocked on IO or on other fragments (see ScopedBlockedThread) don't
+//    count against the quota of their pool.
+//  - Pools that didn't use their share give all but one spare thread of it to the
+//    pools that were denied tokens since the last rebalance.
+//  - While the CPUs of the machine are busier than
+//    config::thread_quota_contention_cpu_percent, the system quota shrinks by an
+//    eighth per interval, down to one thread per pool, and grows back the same way
+//    once they are not.
 // If both the mgr and pool locks need to be taken, the mgr lock must
 // be taken first.
 class ThreadResourceMgr {
@@ -146,19 +157,31 @@ public:
             return num_required_threads() + num_optional_threads();
         }
 
+        // Returns the number of threads of this pool that are blocked, they don't count
+        // against the quota.
+        int num_blocked_threads() const {
+            return _num_blocked_threads;
+        }
+
         // Returns the number of optional threads that can still be used.
         int num_available_threads() const {
-            int value = std::max(quota() - static_cast<int>(num_threads()),
-                                 _num_reserved_optional_threads - num_optional_threads());
+            int value = std::max(
+                    quota() - static_cast<int>(num_threads()) + num_blocked_threads(),
+                    _num_reserved_optional_threads - num_optional_threads());
             return std::max(0, value);
         }
 
         // Returns the quota for this pool.  Note this changes dynamically
         // based on system load.
         int quota() const {
-            return std::min(_max_quota, _parent->_per_pool_quota);
+            return std::min(_max_quota, _dynamic_quota);
         }
 
+        // Marks one thread of this pool as blocked, e.g. waiting for IO or for data of
+        // another fragment, until end_blocking(). Use ScopedBlockedThread.
+        void begin_blocking();
+        void end_blocking();
+
         // Sets the max thread quota for this pool.  This is only used for testing since
         // the dynamic values should be used normally.  The actual quota is the min of this
         // value and the dynamic quota.
@@ -174,10 +197,18 @@ public:
         // Resets internal state.
         void reset();
 
+        // Calls the thread available callback if a thread is available.
+        void notify_thread_available();
+
         ThreadResourceMgr* _parent;
 
         int _max_quota;
+        // The share of the pool, set by the mgr.
+        int _dynamic_quota;
         int _num_reserved_optional_threads;
+        int _num_blocked_threads;
+        // Number of failed try_acquire_thread_token() calls since the last rebalance.
+        int64_t _num_denied;
 
         // A single 64 bit value to store both the number of optional and
         // required threads.  This is combined to allow using compare and
@@ -198,6 +229,7 @@ public:
     // based on the hardware.
     ThreadResourceMgr(int threads_quota);
     ThreadResourceMgr();
+    ~ThreadResourceMgr();
 
     int system_threads_quota() const {
         return _system_threads_quota;
@@ -211,10 +243,49 @@ public:
     // This updates the quotas for the remaining pools.
     void unregister_pool(ResourcePool* pool);
 
+    // Redistributes the threads between the pools as described above. Called
+    // periodically by a thread of the mgr, public for testing. 'cpu_busy_percent' is
+    // the share of the time the CPUs of the machine were busy since the last call, -1
+    // if it's unknown.
+    void rebalance(int cpu_busy_percent);
+
+    // The number of threads for the entire process after shrinking under contention.
+    int effective_threads_quota() const {
+        return _effective_threads_quota;
+    }
+
+    // The share of the time the CPUs of the machine were busy in the last rebalance
+    // interval, -1 if it's unknown, e.g. rebalancing is disabled.
+    int cpu_busy_percent() const {
+        return _cpu_busy_percent;
+    }
+
+    // Marks a thread of 'pool' as blocked for its lifetime. 'pool' may be NULL.
+    class ScopedBlockedThread {
+    public:
+        explicit ScopedBlockedThread(ResourcePool* pool) : _pool(pool) {
+            if (_pool != NULL) {
+                _pool->begin_blocking();
+            }
+        }
+
+        ~ScopedBlockedThread() {
+            if (_pool != NULL) {
+                _pool->end_blocking();
+            }
+        }
+
+    private:
+        ResourcePool* _pool;
+    };
+
 private:
     // 'Optimal' number of threads for the entire process.
     int _system_threads_quota;
 
+    // _system_threads_quota, shrunk while the CPUs are contended.
+    int _effective_threads_quota;
+
     // Lock for the entire object.  Protects all fields below.
     boost::mutex _lock;
 
@@ -222,7 +293,7 @@ private:
     typedef std::set<ResourcePool*> Pools;
     Pools _pools;
 
-    // Each pool currently gets the same share.  This is the ceil of the
+    // The fair share of each pool.  This is the ceil of the effective
     // system quota divided by the number of pools.
     int _per_pool_quota;
 
@@ -234,9 +305,24 @@ private:
     // If new_pool is non-null, new_pool will *not* be notified.
     void update_pool_quotas(ResourcePool* new_pool);
 
+    // Common part of the constructors.
+    void init();
+
     void update_pool_quotas() {
         update_pool_quotas(NULL); 
     }
+
+    // Calls rebalance() every config::thread_quota_rebalance_interval_ms.
+    void rebalance_thread();
+
+    boost::scoped_ptr<boost::thread> _rebalance_thread;
+    bool _stop_rebalance;
+    boost::condition_variable _stop_cv;
+
+    // The CPU times of the last sample of /proc/stat.
+    int64_t _last_cpu_busy;
+    int64_t _last_cpu_total;
+    volatile int _cpu_busy_percent;
 };
 
 inline void ThreadResourceMgr::ResourcePool::acquire_thread_token() {
@@ -250,7 +336,9 @@ inline bool ThreadResourceMgr::ResourcePool::try_acquire_thread_token() {
         int64_t new_required_threads = previous_num_threads & 0xFFFFFFFF;
 
         if (new_optional_threads > _num_reserved_optional_threads &&
-                new_optional_threads + new_required_threads > quota()) {
+                new_optional_threads + new_required_threads - _num_blocked_threads
+                    > quota()) {
+            __sync_fetch_and_add(&_num_denied, 1);
             return false;
         }
 
@@ -283,6 +371,10 @@ inline void ThreadResourceMgr::ResourcePool::release_thread_token(bool required)
         }
     }
 
+    notify_thread_available();
+}
+
+inline void ThreadResourceMgr::ResourcePool::notify_thread_available() {
     // We need to grab a lock before issuing the callback to prevent the
     // callback from being removed while it is happening.
     // Note: this is unlikely to be a big deal for performance currently
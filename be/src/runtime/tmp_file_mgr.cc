@@ -130,6 +130,7 @@ Status TmpFileMgr::init_custom(
     //        std::set<std::string>()));
     _active_scratch_dirs_metric = SetMetric<string>::CreateAndRegister(
     metrics, TMP_FILE_MGR_ACTIVE_SCRATCH_DIRS_LIST, std::set<std::string>());
+    _pending_write_bytes.assign(_tmp_dirs.size(), 0);
     _num_active_scratch_dirs_metric->update(_tmp_dirs.size());
     for (int i = 0; i < _tmp_dirs.size(); ++i) {
         _active_scratch_dirs_metric->add(_tmp_dirs[i].path());
@@ -224,6 +225,21 @@ vector<TmpFileMgr::DeviceId> TmpFileMgr::active_tmp_devices() {
     return devices;
 }
 
+void TmpFileMgr::update_pending_write_bytes(DeviceId device_id, int64_t delta) {
+    DCHECK(_initialized);
+    DCHECK(device_id >= 0 && device_id < _tmp_dirs.size());
+    boost::lock_guard<SpinLock> l(_dir_status_lock);
+    _pending_write_bytes[device_id] += delta;
+    DCHECK_GE(_pending_write_bytes[device_id], 0);
+}
+
+int64_t TmpFileMgr::pending_write_bytes(DeviceId device_id) {
+    DCHECK(_initialized);
+    DCHECK(device_id >= 0 && device_id < _tmp_dirs.size());
+    boost::lock_guard<SpinLock> l(_dir_status_lock);
+    return _pending_write_bytes[device_id];
+}
+
 TmpFileMgr::File::File(TmpFileMgr* mgr, DeviceId device_id, const string& path) :
         _mgr(mgr),
         _path(path),
@@ -75,6 +75,9 @@ public:
         int disk_id() const {
             return _disk_id;
         }
+        DeviceId device_id() const {
+            return _device_id;
+        }
         bool is_blacklisted() const {
             return _blacklisted;
         }
@@ -149,6 +152,14 @@ public:
     // I.e. those that haven't been blacklisted.
     std::vector<DeviceId> active_tmp_devices();
 
+    // Adds 'delta' to the bytes queued for writing to the device. Writers add the length
+    // of a write when they issue it and subtract it when it completes, so that all
+    // queries can pick the least loaded device for their next write.
+    void update_pending_write_bytes(DeviceId device_id, int64_t delta);
+
+    // Bytes currently queued for writing to the device.
+    int64_t pending_write_bytes(DeviceId device_id);
+
 private:
     // Dir stores information about a temporary directory.
     class Dir {
@@ -193,6 +204,9 @@ private:
     // The created tmp directories.
     std::vector<Dir> _tmp_dirs;
 
+    // Bytes queued for writing per tmp directory, protected by _dir_status_lock.
+    std::vector<int64_t> _pending_write_bytes;
+
     // MetricGroup to track active scratch directories.
     IntGauge* _num_active_scratch_dirs_metric;
     SetMetric<std::string>* _active_scratch_dirs_metric;
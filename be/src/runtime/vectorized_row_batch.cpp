@@ -38,6 +38,29 @@ VectorizedRowBatch::VectorizedRowBatch(
     }
 }
 
+void VectorizedRowBatch::prepare_storage_columns() {
+    for (int i = 0; i < _num_cols; ++i) {
+        size_t width = 0;
+        switch (_schema[i].type) {
+        case OLAP_FIELD_TYPE_CHAR:
+        case OLAP_FIELD_TYPE_VARCHAR:
+        case OLAP_FIELD_TYPE_HLL:
+            width = sizeof(StringValue);
+            break;
+        default:
+            width = _schema[i].length;
+            break;
+        }
+
+        _columns[i]->set_col_data(_mem_pool->allocate(width * _capacity));
+        _columns[i]->set_byte_size(width * _capacity);
+        // VectorizedFilter reads the null flags 4 bytes at a time
+        _columns[i]->set_is_null(reinterpret_cast<bool*>(
+                _mem_pool->allocate(sizeof(bool) * _capacity + sizeof(int32_t) - 1)));
+        _columns[i]->reset_dict_rows();
+    }
+}
+
 bool VectorizedRowBatch::get_next_tuple(Tuple* tuple, const TupleDescriptor& tuple_desc) {
     if (_row_iter < _size) {
         std::vector<SlotDescriptor*> slots = tuple_desc.slots();
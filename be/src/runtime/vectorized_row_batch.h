@@ -77,23 +77,82 @@ public:
     void set_byte_size(int byte_size) {
         _byte_size = byte_size;
     }
+
+    // null flag of each row, only set when the column is filled by storage layer
+    bool* is_null() {
+        return _is_null;
+    }
+    void set_is_null(bool* is_null) {
+        _is_null = is_null;
+    }
+
+    // Dictionary codes of a string column. The consumer of the batch enables them,
+    // then the storage layer writes the code of each row (-1 for NULL) while decoding
+    // a dictionary encoded column.
+    void enable_dict_codes(int capacity) {
+        _dict_codes.resize(capacity);
+    }
+    bool is_dict_codes_enabled() const {
+        return !_dict_codes.empty();
+    }
+    int32_t* dict_codes() {
+        return &_dict_codes[0];
+    }
+    // Called by the storage layer after decoding num_rows rows with the dictionary
+    // identified by dict_version, which is unique among all the dictionaries read.
+    void add_dict_rows(uint64_t dict_version, uint32_t dict_size, int num_rows) {
+        if (_dict_rows > 0 && dict_version != _dict_version) {
+            _is_dict_mixed = true;
+        }
+        _dict_version = dict_version;
+        _dict_size = dict_size;
+        _dict_rows += num_rows;
+    }
+    void reset_dict_rows() {
+        _dict_version = 0;
+        _dict_size = 0;
+        _dict_rows = 0;
+        _is_dict_mixed = false;
+        _has_dict_codes = false;
+    }
+    // Called after the storage layer filled the batch with num_rows rows
+    void finish_dict_rows(int num_rows) {
+        _has_dict_codes = is_dict_codes_enabled() && !_is_dict_mixed
+            && _dict_rows > 0 && _dict_rows == num_rows;
+    }
+    // The dictionary of the rows decoded last in this batch, 0 if none
+    uint64_t dict_version() const {
+        return _dict_version;
+    }
+    uint32_t dict_size() const {
+        return _dict_size;
+    }
+    // True if all the rows of the batch have codes of one dictionary
+    bool has_dict_codes() const {
+        return _has_dict_codes;
+    }
 private:
     ColumnVector(int size) {
         _is_repeating = false;
-        //_no_nulls = true;
-        //_is_null = new bool[size];
+        _is_null = NULL;
         _col_data = NULL;
         _col_string_data = NULL;
         _byte_size = 0;
+        reset_dict_rows();
     }
     friend class VectorizedRowBatch;
     void* _col_data;
     void* _col_string_data;
     int _byte_size;
     bool _is_repeating;
-    // this is no null in palo now
-    //bool _no_nulls;
-    //bool* _is_null;
+    bool* _is_null;
+
+    std::vector<int32_t> _dict_codes;
+    uint64_t _dict_version;
+    uint32_t _dict_size;
+    int _dict_rows;
+    bool _is_dict_mixed;
+    bool _has_dict_codes;
 };
 
 class VectorizedRowBatch : public RowBatchInterface {
@@ -106,6 +165,10 @@ public:
         return _mem_pool.get();
     }
 
+    const std::vector<FieldInfo>& schema() const {
+        return _schema;
+    }
+
     void add_column(int index, const TypeDescriptor& type) {
         if (-1 == index) {
             return;
@@ -198,6 +261,13 @@ public:
         _row_iter = 0;
     }
 
+    // return index of the next row to be consumed, selected vector is used if in use
+    inline int next_row_index() {
+        int index = _selected_in_use ? _selected[_row_iter] : _row_iter;
+        ++_row_iter;
+        return index;
+    }
+
     inline void reset() {
         _size = 0;
         _selected_in_use = false;
@@ -207,6 +277,19 @@ public:
         _selected = reinterpret_cast<int*>(_mem_pool->allocate(sizeof(int) * _capacity));
     }
 
+    // Allocate data and null flags of every column in storage format, so that
+    // the storage layer can fill the ColumnVector directly. CHAR/VARCHAR/HLL
+    // columns are StringValue arrays, other columns use the field length as
+    // stride, which is the same layout as RowBlock::_load_to_vectorized_row_batch.
+    // Must be called again after reset().
+    void prepare_storage_columns();
+    // Called after the storage layer filled the columns
+    void finish_storage_columns() {
+        for (int i = 0; i < _num_cols; ++i) {
+            _columns[i]->finish_dict_rows(_size);
+        }
+    }
+
     bool get_next_tuple(Tuple* tuple, const TupleDescriptor& tuple_desc);
 
     void to_row_batch(RowBatch* row_batch, const TupleDescriptor& tuple_desc);
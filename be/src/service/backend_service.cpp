@@ -82,7 +82,7 @@ Status BackendService::create_service(ExecEnv* exec_env, int port, ThriftServer*
 }
 
 Status BackendService::create_rpc_service(ExecEnv* exec_env) {
-    ReactorFactory::initialize(config::rpc_reactor_threads);
+    ReactorFactory::initialize(config::rpc_reactor_threads, config::rpc_reactor_cpu_affinity);
 
     struct sockaddr_in addr;
     InetAddr::initialize(&addr, BackendOptions::get_localhost().c_str(), config::be_rpc_port);
@@ -92,7 +92,7 @@ Status BackendService::create_rpc_service(ExecEnv* exec_env) {
     ConnectionHandlerFactoryPtr handler_factory = std::make_shared<HandlerFactory>(dhp);
 
     Status status = Status::OK;
-    int error = comm->listen(addr, handler_factory, dhp);
+    int error = comm->listen(addr, handler_factory, dhp, config::rpc_listen_sockets);
     if (error != error::OK) {
         status = Status("create rpc server failed.");
     }
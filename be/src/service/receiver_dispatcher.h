@@ -88,8 +88,27 @@ public:
             const uint8_t *buf_ptr = (uint8_t*)event_ptr->payload;
             uint32_t sz = event_ptr->payload_len;
 
+            // senders that don't flag the compact protocol use the binary one
+            bool compact = event_ptr->header.flags & CommHeader::FLAGS_BIT_COMPACT_PROTOCOL;
             TTransmitDataParams params;
-            deserialize_thrift_msg(buf_ptr, &sz, false, &params);
+            deserialize_thrift_msg(buf_ptr, &sz, compact, &params);
+
+            // the tuple data sent behind the params stays in the payload, which the
+            // row batch keeps alive through the event
+            std::shared_ptr<uint8_t> tuple_data;
+            int64_t tuple_data_size = 0;
+            uint32_t offset = DataStreamMgr::tuple_data_offset(sz);
+            if (event_ptr->payload_len > offset) {
+                uint8_t* data = const_cast<uint8_t*>(buf_ptr) + offset;
+                tuple_data_size = event_ptr->payload_len - offset;
+                if (params.row_batch.__isset.is_columnar && params.row_batch.is_columnar) {
+                    params.row_batch.tuple_data.assign(
+                            reinterpret_cast<const char*>(data), tuple_data_size);
+                    tuple_data_size = 0;
+                } else {
+                    tuple_data = std::shared_ptr<uint8_t>(event_ptr, data);
+                }
+            }
 
             TTransmitDataResult return_val;
             if (params.__isset.packet_seq) {
@@ -102,7 +121,7 @@ public:
 
             uint8_t* buf_res = 0;
             uint32_t size = 0;
-            ThriftSerializer thrift_serializer(false, 100);
+            ThriftSerializer thrift_serializer(compact, 100);
             thrift_serializer.serialize(&return_val, &size, &buf_res);
 
             CommHeader header;
@@ -116,6 +135,8 @@ public:
                         params.dest_fragment_instance_id,
                         params.dest_node_id,
                         params.row_batch,
+                        tuple_data,
+                        tuple_data_size,
                         params.sender_id,
                         &buffer_overflow,
                         std::make_pair(event_ptr->addr, response));
@@ -0,0 +1,223 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "testutil/join_test_util.h"
+
+#include <limits>
+#include <sstream>
+
+#include "common/object_pool.h"
+#include "gen_cpp/Exprs_types.h"
+#include "runtime/descriptors.h"
+#include "runtime/mem_pool.h"
+#include "runtime/row_batch.h"
+#include "runtime/runtime_state.h"
+#include "runtime/tuple.h"
+#include "runtime/tuple_row.h"
+#include "testutil/desc_tbl_builder.h"
+
+using std::string;
+using std::vector;
+
+namespace palo {
+
+const int32_t KeyValRow::NULL_VALUE = std::numeric_limits<int32_t>::min();
+
+static void write_slot(Tuple* tuple, const SlotDescriptor* slot, int32_t value) {
+    if (value == KeyValRow::NULL_VALUE) {
+        tuple->set_null(slot->null_indicator_offset());
+    } else {
+        *reinterpret_cast<int32_t*>(tuple->get_slot(slot->tuple_offset())) = value;
+    }
+}
+
+RowsSourceNode::RowsSourceNode(ObjectPool* pool, const TPlanNode& tnode,
+                               const DescriptorTbl& descs, const vector<KeyValRow>& rows) :
+        ExecNode(pool, tnode, descs),
+        _rows(rows),
+        _next_row(0) {
+}
+
+Status RowsSourceNode::open(RuntimeState* state) {
+    RETURN_IF_ERROR(ExecNode::open(state));
+    _next_row = 0;
+    return Status::OK;
+}
+
+Status RowsSourceNode::get_next(RuntimeState* state, RowBatch* row_batch, bool* eos) {
+    RETURN_IF_CANCELLED(state);
+    const TupleDescriptor* tuple_desc = row_desc().tuple_descriptors()[0];
+    const SlotDescriptor* key_slot = tuple_desc->slots()[0];
+    const SlotDescriptor* val_slot = tuple_desc->slots()[1];
+    while (_next_row < _rows.size() && !row_batch->at_capacity()) {
+        Tuple* tuple = reinterpret_cast<Tuple*>(
+                row_batch->tuple_data_pool()->allocate(tuple_desc->byte_size()));
+        tuple->init(tuple_desc->byte_size());
+        write_slot(tuple, key_slot, _rows[_next_row].key);
+        write_slot(tuple, val_slot, _rows[_next_row].val);
+
+        int row_idx = row_batch->add_row();
+        row_batch->get_row(row_idx)->set_tuple(0, tuple);
+        row_batch->commit_last_row();
+        ++_next_row;
+        ++_num_rows_returned;
+    }
+    *eos = (_next_row == _rows.size());
+    return Status::OK;
+}
+
+static TExprNode int_slot_ref(SlotId slot_id, TupleId tuple_id) {
+    TSlotRef slot_ref;
+    slot_ref.__set_slot_id(slot_id);
+    slot_ref.__set_tuple_id(tuple_id);
+
+    TExprNode node;
+    node.__set_node_type(TExprNodeType::SLOT_REF);
+    node.__set_type(TypeDescriptor(TYPE_INT).to_thrift());
+    node.__set_num_children(0);
+    node.__set_output_scale(-1);
+    node.__set_slot_ref(slot_ref);
+    return node;
+}
+
+JoinTestPlan::JoinTestPlan(ObjectPool* pool) {
+    DescriptorTblBuilder builder(pool);
+    builder.declare_tuple() << TYPE_INT << TYPE_INT;
+    builder.declare_tuple() << TYPE_INT << TYPE_INT;
+    _desc_tbl = builder.build();
+}
+
+TPlanNode JoinTestPlan::join_node(TJoinOp::type join_op, bool val_less_than) const {
+    TEqJoinCondition eq_join_conjunct;
+    eq_join_conjunct.left.nodes.push_back(int_slot_ref(0, 0));
+    eq_join_conjunct.right.nodes.push_back(int_slot_ref(2, 1));
+
+    THashJoinNode hash_join_node;
+    hash_join_node.__set_join_op(join_op);
+    hash_join_node.eq_join_conjuncts.push_back(eq_join_conjunct);
+    // No IN predicate is pushed down to the probe source.
+    hash_join_node.__set_is_push_down(false);
+    if (val_less_than) {
+        TExprNode less_than;
+        less_than.__set_node_type(TExprNodeType::BINARY_PRED);
+        less_than.__set_type(TypeDescriptor(TYPE_BOOLEAN).to_thrift());
+        less_than.__set_opcode(TExprOpcode::LT);
+        less_than.__set_child_type(TPrimitiveType::INT);
+        less_than.__set_num_children(2);
+        less_than.__set_output_scale(-1);
+
+        TExpr other_join_conjunct;
+        other_join_conjunct.nodes.push_back(less_than);
+        other_join_conjunct.nodes.push_back(int_slot_ref(1, 0));
+        other_join_conjunct.nodes.push_back(int_slot_ref(3, 1));
+        hash_join_node.__set_other_join_conjuncts(vector<TExpr>(1, other_join_conjunct));
+    }
+
+    TPlanNode tnode;
+    tnode.__set_node_id(JOIN_NODE_ID);
+    tnode.__set_node_type(TPlanNodeType::HASH_JOIN_NODE);
+    tnode.__set_num_children(2);
+    tnode.__set_limit(-1);
+    tnode.__set_compact_data(false);
+    tnode.row_tuples.push_back(0);
+    tnode.row_tuples.push_back(1);
+    tnode.nullable_tuples.push_back(
+            join_op == TJoinOp::RIGHT_OUTER_JOIN || join_op == TJoinOp::FULL_OUTER_JOIN);
+    tnode.nullable_tuples.push_back(
+            join_op == TJoinOp::LEFT_OUTER_JOIN || join_op == TJoinOp::FULL_OUTER_JOIN);
+    tnode.__set_hash_join_node(hash_join_node);
+    return tnode;
+}
+
+TPlanNode JoinTestPlan::source_node(bool probe) const {
+    TPlanNode tnode;
+    tnode.__set_node_id(probe ? PROBE_NODE_ID : BUILD_NODE_ID);
+    // The node type only names the profile of the node.
+    tnode.__set_node_type(TPlanNodeType::OLAP_SCAN_NODE);
+    tnode.__set_num_children(0);
+    tnode.__set_limit(-1);
+    tnode.__set_compact_data(false);
+    tnode.row_tuples.push_back(probe ? 0 : 1);
+    tnode.nullable_tuples.push_back(false);
+    return tnode;
+}
+
+string JoinTestPlan::print_tuple(TupleRow* row, int tuple_idx) const {
+    Tuple* tuple = row->get_tuple(tuple_idx);
+    if (tuple == NULL) {
+        return "null";
+    }
+    const TupleDescriptor* tuple_desc = _desc_tbl->get_tuple_descriptor(tuple_idx);
+    std::stringstream out;
+    out << "(";
+    for (int i = 0; i < 2; ++i) {
+        const SlotDescriptor* slot = tuple_desc->slots()[i];
+        if (i != 0) {
+            out << ",";
+        }
+        if (tuple->is_null(slot->null_indicator_offset())) {
+            out << "null";
+        } else {
+            out << *reinterpret_cast<int32_t*>(tuple->get_slot(slot->tuple_offset()));
+        }
+    }
+    out << ")";
+    return out.str();
+}
+
+Status JoinTestPlan::execute(ExecNode* join, TJoinOp::type join_op, RuntimeState* state,
+                             vector<string>* rows) const {
+    Status status = join->prepare(state);
+    if (!status.ok()) {
+        status.add_error(join->close(state));
+        return status;
+    }
+    return fetch(join, join_op, state, rows);
+}
+
+Status JoinTestPlan::fetch(ExecNode* join, TJoinOp::type join_op, RuntimeState* state,
+                           vector<string>* rows) const {
+    const bool print_probe = join_op != TJoinOp::RIGHT_SEMI_JOIN
+        && join_op != TJoinOp::RIGHT_ANTI_JOIN;
+    const bool print_build = join_op != TJoinOp::LEFT_SEMI_JOIN
+        && join_op != TJoinOp::LEFT_ANTI_JOIN
+        && join_op != TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN;
+
+    Status status = join->open(state);
+    if (status.ok()) {
+        RowBatch batch(join->row_desc(), state->batch_size(), state->instance_mem_tracker());
+        bool eos = false;
+        while (status.ok() && !eos) {
+            status = join->get_next(state, &batch, &eos);
+            for (int i = 0; status.ok() && i < batch.num_rows(); ++i) {
+                TupleRow* row = batch.get_row(i);
+                string printed;
+                if (print_probe) {
+                    printed += print_tuple(row, 0);
+                }
+                if (print_build) {
+                    printed += print_tuple(row, 1);
+                }
+                rows->push_back(printed);
+            }
+            batch.reset();
+        }
+    }
+    // The join is closed even if it failed, it must not be destroyed open.
+    status.add_error(join->close(state));
+    return status;
+}
+
+} // end namespace palo
@@ -0,0 +1,101 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_TESTUTIL_JOIN_TEST_UTIL_H
+#define BDG_PALO_BE_SRC_TESTUTIL_JOIN_TEST_UTIL_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "exec/exec_node.h"
+#include "gen_cpp/PlanNodes_types.h"
+
+namespace palo {
+
+class DescriptorTbl;
+class ObjectPool;
+class RowBatch;
+class RuntimeState;
+class TupleRow;
+
+// One input row of the join tests: a tuple of two nullable INT slots, the join key
+// and a value.
+struct KeyValRow {
+    // Stands for a NULL slot.
+    static const int32_t NULL_VALUE;
+
+    int32_t key;
+    int32_t val;
+};
+
+// Leaf node which returns the given rows, the input of the join nodes under test.
+class RowsSourceNode : public ExecNode {
+public:
+    // 'rows' must outlive the node.
+    RowsSourceNode(ObjectPool* pool, const TPlanNode& tnode, const DescriptorTbl& descs,
+                   const std::vector<KeyValRow>& rows);
+    virtual ~RowsSourceNode() {}
+
+    virtual Status open(RuntimeState* state);
+    virtual Status get_next(RuntimeState* state, RowBatch* row_batch, bool* eos);
+
+private:
+    const std::vector<KeyValRow>& _rows;
+    size_t _next_row;
+};
+
+// The plan of a hash join on probe.key = build.key. The probe rows are tuple 0 with
+// slots 0 (key) and 1 (val), the build rows are tuple 1 with slots 2 and 3.
+class JoinTestPlan {
+public:
+    static const int JOIN_NODE_ID = 0;
+    static const int PROBE_NODE_ID = 1;
+    static const int BUILD_NODE_ID = 2;
+
+    explicit JoinTestPlan(ObjectPool* pool);
+
+    DescriptorTbl* desc_tbl() const {
+        return _desc_tbl;
+    }
+
+    // The join node, its row has the probe and the build tuple, nullable as the FE
+    // plans them for 'join_op'. If 'val_less_than' is true, probe.val < build.val is
+    // an other join conjunct.
+    TPlanNode join_node(TJoinOp::type join_op, bool val_less_than) const;
+
+    // The source node of the probe (left) or the build (right) rows.
+    TPlanNode source_node(bool probe) const;
+
+    // Prepares and opens 'join', prints all of its rows into 'rows' and closes it.
+    // Only the tuples of the sides returned by 'join_op' are printed, as "(key,val)",
+    // "null" for a NULL slot or a missing tuple.
+    Status execute(ExecNode* join, TJoinOp::type join_op, RuntimeState* state,
+                   std::vector<std::string>* rows) const;
+
+    // Same as execute() for a 'join' that is already prepared.
+    Status fetch(ExecNode* join, TJoinOp::type join_op, RuntimeState* state,
+                 std::vector<std::string>* rows) const;
+
+private:
+    std::string print_tuple(TupleRow* row, int tuple_idx) const;
+
+    DescriptorTbl* _desc_tbl;
+};
+
+} // end namespace palo
+
+#endif // BDG_PALO_BE_SRC_TESTUTIL_JOIN_TEST_UTIL_H
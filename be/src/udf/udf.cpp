@@ -375,8 +375,13 @@ StringVal StringVal::copy_from(FunctionContext* ctx, const uint8_t* buf, size_t
 }
 
 StringVal StringVal::create_temp_string_val(FunctionContext* ctx, int len) {
-    ctx->impl()->string_result().resize(len);
-    return StringVal((uint8_t*)ctx->impl()->string_result().c_str(), len);
+    // The buffer only grows. Shrinking it to every row's length would make the
+    // next longer row zero-fill the tail again in resize().
+    std::string& buffer = ctx->impl()->string_result();
+    if (buffer.size() < len) {
+        buffer.resize(len);
+    }
+    return StringVal((uint8_t*)&buffer[0], len);
 }
 
 void StringVal::append(FunctionContext* ctx, const uint8_t* buf, size_t buf_len) {
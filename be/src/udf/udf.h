@@ -296,6 +296,39 @@ typedef void (*UdfPrepare)(FunctionContext* context,
 typedef void (*UdfClose)(FunctionContext* context,
                          FunctionContext::FunctionStateScope scope);
 
+/// --- Batch Functions ---
+/// -----------------------
+/// A scalar UDF can optionally include a batch function which evaluates it over many
+/// rows in one call, without packing every argument into an AnyVal. It is used instead
+/// of the row-at-a-time function when the UDF is evaluated over a batch of rows and all
+/// the argument and return types are supported. Its symbol is given by the
+/// "batch_fn_symbol" of the function. For a UDF created with an unmangled symbol, a batch
+/// function declared extern "C" as the symbol followed by "_batch" is picked up as well.
+//
+/// 'arg_values[i]' points to the 'num_rows' values of the i-th argument (including the
+/// varargs) and 'arg_nulls[i]' to one byte per row which is non-zero if the value is
+/// null. The function writes its 'num_rows' results to 'result_values' and sets the byte
+/// of a null result in 'result_nulls', which are all zero on entry. Values are laid out
+/// as:
+///   BOOLEAN                   bool
+///   TINYINT/SMALLINT/INT      int8_t/int16_t/int32_t
+///   BIGINT/LARGEINT           int64_t/__int128
+///   FLOAT/DOUBLE              float/double
+///   CHAR/VARCHAR/HLL          BatchStringVal
+/// Functions with other argument or return types are always evaluated row by row.
+//
+/// Memory for string results follows the rules of the row-at-a-time function: it may
+/// point into the arguments or be allocated by the StringVal(FunctionContext*, int) c'tor.
+/// Errors are reported through FunctionContext::set_error() as well.
+struct BatchStringVal {
+    char* ptr;
+    int len;
+};
+
+typedef void (*UdfBatchFn)(FunctionContext* context, int num_rows,
+                           const void* const* arg_values, const uint8_t* const* arg_nulls,
+                           void* result_values, uint8_t* result_nulls);
+
 //----------------------------------------------------------------------------
 //------------------------------- UDAs ---------------------------------------
 //----------------------------------------------------------------------------
@@ -617,7 +650,9 @@ struct StringVal : public AnyVal {
     // string memory.
     StringVal(FunctionContext* context, int len);
 
-    // Creates a StringVal, which memory is avaliable when this funciont context is used next time
+    // Creates a StringVal, which memory is avaliable when this funciont context is used next time.
+    // The memory is a scratch buffer owned by the context and reused by every call, so results
+    // that are slices of an argument should just point into the argument instead.
     static StringVal create_temp_string_val(FunctionContext* ctx, int len);
 
     bool operator==(const StringVal& other) const {
@@ -0,0 +1,193 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/bitmap_value.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <iterator>
+
+namespace palo {
+
+const int BitmapValue::ARRAY_MAX_CARDINALITY;
+const int BitmapValue::BITSET_WORDS;
+
+void BitmapValue::Container::add(uint16_t value) {
+    if (is_bitset()) {
+        uint64_t mask = 1UL << (value & 63);
+        if ((bits[value >> 6] & mask) == 0) {
+            bits[value >> 6] |= mask;
+            ++cardinality;
+        }
+        return;
+    }
+    std::vector<uint16_t>::iterator it = std::lower_bound(array.begin(), array.end(), value);
+    if (it != array.end() && *it == value) {
+        return;
+    }
+    array.insert(it, value);
+    ++cardinality;
+    if (cardinality > ARRAY_MAX_CARDINALITY) {
+        to_bitset();
+    }
+}
+
+void BitmapValue::Container::merge(const uint16_t* values, int num_values,
+                                   const uint64_t* words) {
+    if (words != NULL) {
+        to_bitset();
+        cardinality = 0;
+        for (int i = 0; i < BITSET_WORDS; ++i) {
+            bits[i] |= words[i];
+            cardinality += __builtin_popcountll(bits[i]);
+        }
+    } else if (is_bitset()) {
+        for (int i = 0; i < num_values; ++i) {
+            add(values[i]);
+        }
+    } else {
+        std::vector<uint16_t> merged;
+        merged.reserve(array.size() + num_values);
+        std::set_union(array.begin(), array.end(), values, values + num_values,
+                       std::back_inserter(merged));
+        array.swap(merged);
+        cardinality = array.size();
+        if (cardinality > ARRAY_MAX_CARDINALITY) {
+            to_bitset();
+        }
+    }
+}
+
+void BitmapValue::Container::to_bitset() {
+    if (is_bitset()) {
+        return;
+    }
+    bits.assign(BITSET_WORDS, 0);
+    for (size_t i = 0; i < array.size(); ++i) {
+        bits[array[i] >> 6] |= 1UL << (array[i] & 63);
+    }
+    std::vector<uint16_t>().swap(array);
+}
+
+void BitmapValue::add(uint32_t value) {
+    _containers[value >> 16].add(value & 0xffff);
+}
+
+void BitmapValue::merge(const BitmapValue& other) {
+    for (std::map<uint16_t, Container>::const_iterator it = other._containers.begin();
+            it != other._containers.end(); ++it) {
+        const Container& src = it->second;
+        if (src.is_bitset()) {
+            _containers[it->first].merge(NULL, 0, &src.bits[0]);
+        } else if (!src.array.empty()) {
+            _containers[it->first].merge(&src.array[0], src.array.size(), NULL);
+        }
+    }
+}
+
+bool BitmapValue::merge_serialized(const char* data, size_t len) {
+    const char* end = data + len;
+    uint32_t num_containers = 0;
+    if (len < sizeof(num_containers)) {
+        return false;
+    }
+    memcpy(&num_containers, data, sizeof(num_containers));
+    data += sizeof(num_containers);
+
+    // the values are copied out, 'data' need not be aligned
+    std::vector<uint16_t> values;
+    std::vector<uint64_t> words;
+    for (uint32_t i = 0; i < num_containers; ++i) {
+        uint16_t key = 0;
+        uint32_t cardinality = 0;
+        if ((size_t)(end - data) < sizeof(key) + sizeof(cardinality)) {
+            return false;
+        }
+        memcpy(&key, data, sizeof(key));
+        memcpy(&cardinality, data + sizeof(key), sizeof(cardinality));
+        data += sizeof(key) + sizeof(cardinality);
+
+        if (cardinality <= ARRAY_MAX_CARDINALITY) {
+            if ((size_t)(end - data) < cardinality * sizeof(uint16_t)) {
+                return false;
+            }
+            values.resize(cardinality);
+            memcpy(values.data(), data, cardinality * sizeof(uint16_t));
+            data += cardinality * sizeof(uint16_t);
+            if (cardinality > 0) {
+                _containers[key].merge(values.data(), cardinality, NULL);
+            }
+        } else {
+            if ((size_t)(end - data) < BITSET_WORDS * sizeof(uint64_t)) {
+                return false;
+            }
+            words.resize(BITSET_WORDS);
+            memcpy(words.data(), data, BITSET_WORDS * sizeof(uint64_t));
+            data += BITSET_WORDS * sizeof(uint64_t);
+            _containers[key].merge(NULL, 0, words.data());
+        }
+    }
+    return data == end;
+}
+
+int64_t BitmapValue::cardinality() const {
+    int64_t result = 0;
+    for (std::map<uint16_t, Container>::const_iterator it = _containers.begin();
+            it != _containers.end(); ++it) {
+        result += it->second.cardinality;
+    }
+    return result;
+}
+
+size_t BitmapValue::serialized_size() const {
+    size_t size = sizeof(uint32_t);
+    for (std::map<uint16_t, Container>::const_iterator it = _containers.begin();
+            it != _containers.end(); ++it) {
+        size += sizeof(uint16_t) + sizeof(uint32_t);
+        if (it->second.is_bitset()) {
+            size += BITSET_WORDS * sizeof(uint64_t);
+        } else {
+            size += it->second.array.size() * sizeof(uint16_t);
+        }
+    }
+    return size;
+}
+
+void BitmapValue::serialize(char* dst) const {
+    uint32_t num_containers = _containers.size();
+    memcpy(dst, &num_containers, sizeof(num_containers));
+    dst += sizeof(num_containers);
+    for (std::map<uint16_t, Container>::const_iterator it = _containers.begin();
+            it != _containers.end(); ++it) {
+        const Container& container = it->second;
+        uint16_t key = it->first;
+        uint32_t cardinality = container.cardinality;
+        memcpy(dst, &key, sizeof(key));
+        memcpy(dst + sizeof(key), &cardinality, sizeof(cardinality));
+        dst += sizeof(key) + sizeof(cardinality);
+        // a bitset always has more than ARRAY_MAX_CARDINALITY values, so the
+        // cardinality tells the reader which layout follows
+        if (container.is_bitset()) {
+            memcpy(dst, &container.bits[0], BITSET_WORDS * sizeof(uint64_t));
+            dst += BITSET_WORDS * sizeof(uint64_t);
+        } else {
+            memcpy(dst, container.array.data(), container.array.size() * sizeof(uint16_t));
+            dst += container.array.size() * sizeof(uint16_t);
+        }
+    }
+}
+
+}
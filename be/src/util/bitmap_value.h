@@ -0,0 +1,87 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_UTIL_BITMAP_VALUE_H
+#define BDG_PALO_BE_SRC_UTIL_BITMAP_VALUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <map>
+#include <vector>
+
+namespace palo {
+
+// Compressed set of 32-bit unsigned integers, laid out like a Roaring bitmap: the
+// values are grouped by their upper 16 bits, and each group keeps its lower 16 bits
+// either in a sorted array while it has at most ARRAY_MAX_CARDINALITY values, or in a
+// 65536-bit bitset beyond that. Sets of a few values stay small, dense sets cost one bit
+// per value, and unions work group by group.
+//
+// Serialized format, in host byte order:
+//   uint32 number of groups, then for every group in ascending key order:
+//   uint16 key, uint32 cardinality, and either 'cardinality' sorted uint16 values if
+//   cardinality <= ARRAY_MAX_CARDINALITY or BITSET_WORDS uint64 bitset words
+class BitmapValue {
+public:
+    static const int ARRAY_MAX_CARDINALITY = 4096;
+    static const int BITSET_WORDS = 65536 / 64;
+
+    BitmapValue() { }
+
+    void add(uint32_t value);
+
+    void merge(const BitmapValue& other);
+
+    // Merges a bitmap in the format written by serialize(). Returns false if 'data' is
+    // not a valid serialized bitmap; the values merged before the error are kept.
+    bool merge_serialized(const char* data, size_t len);
+
+    // Number of distinct values
+    int64_t cardinality() const;
+
+    size_t serialized_size() const;
+
+    // Writes serialized_size() bytes to 'dst'.
+    void serialize(char* dst) const;
+
+private:
+    struct Container {
+        Container() : cardinality(0) { }
+
+        bool is_bitset() const {
+            return !bits.empty();
+        }
+
+        void add(uint16_t value);
+
+        // Merges the sorted 'values' or the bitset 'words', whichever is not NULL.
+        void merge(const uint16_t* values, int num_values, const uint64_t* words);
+
+        void to_bitset();
+
+        // Sorted lower 16 bits, used while the container is not a bitset
+        std::vector<uint16_t> array;
+        // BITSET_WORDS words once the container has more than ARRAY_MAX_CARDINALITY values
+        std::vector<uint64_t> bits;
+        int cardinality;
+    };
+
+    std::map<uint16_t, Container> _containers;
+};
+
+}
+
+#endif // BDG_PALO_BE_SRC_UTIL_BITMAP_VALUE_H
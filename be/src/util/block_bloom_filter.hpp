@@ -0,0 +1,160 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_COMMON_UTIL_BLOCK_BLOOM_FILTER_HPP
+#define BDG_PALO_BE_SRC_COMMON_UTIL_BLOCK_BLOOM_FILTER_HPP
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <new>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace palo {
+
+// Split block bloom filter. The filter is an array of 256-bit blocks, and each key
+// only touches one block: the high 32 bits of the hash select the block, and the low
+// 32 bits set one bit in each of the 8 32-bit words of the block. So a probe reads a
+// single cache line, and it is done with a few AVX2 instructions when available.
+//
+// The static functions work on a buffer owned by the caller, which is used by the
+// column file bloom filter index. The object owns its buffer and can be used for
+// filters built at runtime, e.g. runtime filters of hash join. Those should be fed
+// with HashUtil::fast_hash64(), whose bits are all well mixed; the column file index
+// keeps HashUtil::hash64() since its filters are stored.
+class BlockBloomFilter {
+public:
+    static const uint32_t BLOCK_BITS = 256;
+    static const uint32_t BLOCK_WORDS = BLOCK_BITS / 32;
+
+    BlockBloomFilter() : _data(NULL), _block_num(0) {}
+
+    ~BlockBloomFilter() {
+        delete[] _data;
+    }
+
+    // Create filter for expected_entries with false positive probability fpp,
+    // the block number is computed by: fpp = (1 - e^(-8 * n / m)) ^ 8
+    bool init(int64_t expected_entries, double fpp) {
+        double bit_num = -8.0 * expected_entries / log(1 - pow(fpp, 1.0 / BLOCK_WORDS));
+        uint32_t block_num = (uint32_t) ceil(bit_num / BLOCK_BITS);
+        return init_with_block_num(block_num > 0 ? block_num : 1);
+    }
+
+    bool init_with_block_num(uint32_t block_num) {
+        delete[] _data;
+        _block_num = block_num;
+        _data = new(std::nothrow) uint64_t[block_num * BLOCK_BITS / 64];
+        if (_data == NULL) {
+            _block_num = 0;
+            return false;
+        }
+        memset(_data, 0, block_num * BLOCK_BITS / 8);
+        return true;
+    }
+
+    void insert(uint64_t hash) {
+        insert(_data, _block_num, hash);
+    }
+
+    bool find(uint64_t hash) const {
+        return find(_data, _block_num, hash);
+    }
+
+    // Merge with another filter which has the same block number
+    bool merge(const BlockBloomFilter& other) {
+        if (_block_num != other._block_num) {
+            return false;
+        }
+        for (uint32_t i = 0; i < _block_num * BLOCK_BITS / 64; ++i) {
+            _data[i] |= other._data[i];
+        }
+        return true;
+    }
+
+    uint32_t block_num() const {
+        return _block_num;
+    }
+
+    static void insert(uint64_t* data, uint32_t block_num, uint64_t hash) {
+        uint32_t* block = reinterpret_cast<uint32_t*>(data)
+                + _block_index(block_num, hash) * BLOCK_WORDS;
+        uint32_t key = (uint32_t) hash;
+#ifdef __AVX2__
+        __m256i* block_ptr = reinterpret_cast<__m256i*>(block);
+        __m256i mask = _make_mask(key);
+        _mm256_storeu_si256(block_ptr, _mm256_or_si256(_mm256_loadu_si256(block_ptr), mask));
+#else
+        for (uint32_t i = 0; i < BLOCK_WORDS; ++i) {
+            block[i] |= 1U << ((key * _salt(i)) >> 27);
+        }
+#endif
+    }
+
+    static bool find(const uint64_t* data, uint32_t block_num, uint64_t hash) {
+        const uint32_t* block = reinterpret_cast<const uint32_t*>(data)
+                + _block_index(block_num, hash) * BLOCK_WORDS;
+        uint32_t key = (uint32_t) hash;
+#ifdef __AVX2__
+        __m256i block_bits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+        return _mm256_testc_si256(block_bits, _make_mask(key));
+#else
+        uint32_t missed = 0;
+        for (uint32_t i = 0; i < BLOCK_WORDS; ++i) {
+            missed |= ~block[i] & (1U << ((key * _salt(i)) >> 27));
+        }
+        return missed == 0;
+#endif
+    }
+
+private:
+    // Map the high 32 bits of hash to [0, block_num) without division
+    static uint32_t _block_index(uint32_t block_num, uint64_t hash) {
+        return (uint32_t) (((hash >> 32) * block_num) >> 32);
+    }
+
+#ifdef __AVX2__
+    static __m256i _make_mask(uint32_t key) {
+        const __m256i salt = _mm256_setr_epi32(
+                _salt(0), _salt(1), _salt(2), _salt(3),
+                _salt(4), _salt(5), _salt(6), _salt(7));
+        __m256i shift = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(key), salt), 27);
+        return _mm256_sllv_epi32(_mm256_set1_epi32(1), shift);
+    }
+#endif
+
+    // Odd constants to compute the bit in each word of the block
+    static uint32_t _salt(uint32_t i) {
+        static const uint32_t SALT[BLOCK_WORDS] = {
+            0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+            0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+        };
+        return SALT[i];
+    }
+
+    uint64_t* _data;
+    uint32_t _block_num;
+
+    BlockBloomFilter(const BlockBloomFilter&);
+    BlockBloomFilter& operator=(const BlockBloomFilter&);
+};
+
+}  // namespace palo
+
+#endif // BDG_PALO_BE_SRC_COMMON_UTIL_BLOCK_BLOOM_FILTER_HPP
@@ -0,0 +1,217 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/blocking_aware_thread_pool.h"
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "common/logging.h"
+#include "util/thread_name.h"
+
+namespace palo {
+
+using boost::lock_guard;
+using boost::mutex;
+using boost::unique_lock;
+
+const int BlockingAwareThreadPool::IDLE_THREAD_TIMEOUT_S;
+
+__thread BlockingAwareThreadPool* BlockingAwareThreadPool::_s_current_pool = NULL;
+__thread int BlockingAwareThreadPool::_s_blocking_depth = 0;
+
+BlockingAwareThreadPool::ScopedBlocking::ScopedBlocking(unique_lock<mutex>* lock) :
+        _pool(NULL),
+        _lock(lock) {
+    if (_s_current_pool != NULL && _s_blocking_depth++ == 0) {
+        _pool = _s_current_pool;
+        _pool->begin_blocking();
+    }
+}
+
+BlockingAwareThreadPool::ScopedBlocking::~ScopedBlocking() {
+    if (_s_current_pool != NULL) {
+        --_s_blocking_depth;
+    }
+    if (_pool != NULL) {
+        if (_lock != NULL && _lock->owns_lock()) {
+            _lock->unlock();
+            _pool->end_blocking();
+            _lock->lock();
+        } else {
+            _pool->end_blocking();
+        }
+    }
+}
+
+BlockingAwareThreadPool::BlockingAwareThreadPool(
+        uint32_t num_active_threads, uint32_t max_threads, uint32_t queue_size,
+        const std::string& name) :
+        _num_active_threads(num_active_threads == 0 ? max_threads
+                            : std::min(num_active_threads, max_threads)),
+        _max_threads(max_threads),
+        _queue_size(queue_size),
+        _name(name),
+        _shutdown(false),
+        _num_threads(0),
+        _num_idle(0),
+        _num_active(0),
+        _num_waiting_for_slot(0) {
+    DCHECK_GT(max_threads, 0);
+    lock_guard<mutex> l(_lock);
+    for (uint32_t i = 0; i < _num_active_threads; ++i) {
+        start_thread();
+    }
+}
+
+BlockingAwareThreadPool::~BlockingAwareThreadPool() {
+    shutdown();
+    join();
+}
+
+bool BlockingAwareThreadPool::offer(WorkFunction func) {
+    unique_lock<mutex> l(_lock);
+    while (!_shutdown && _queue.size() >= _queue_size) {
+        _not_full_cv.wait(l);
+    }
+    if (_shutdown) {
+        return false;
+    }
+    _queue.push_back(func);
+    if (_num_active + _num_waiting_for_slot < _num_active_threads) {
+        if (_num_idle > 0) {
+            _work_cv.notify_one();
+        } else if (_num_threads < _max_threads) {
+            // All threads are blocked
+            start_thread();
+        }
+    }
+    return true;
+}
+
+void BlockingAwareThreadPool::shutdown() {
+    {
+        lock_guard<mutex> l(_lock);
+        _shutdown = true;
+    }
+    _work_cv.notify_all();
+    _slot_cv.notify_all();
+    _not_full_cv.notify_all();
+    _empty_cv.notify_all();
+}
+
+void BlockingAwareThreadPool::join() {
+    unique_lock<mutex> l(_lock);
+    while (_num_threads > 0) {
+        _no_threads_cv.wait(l);
+    }
+}
+
+void BlockingAwareThreadPool::drain_and_shutdown() {
+    {
+        unique_lock<mutex> l(_lock);
+        while (!_shutdown && !_queue.empty()) {
+            _empty_cv.wait(l);
+        }
+    }
+    shutdown();
+    join();
+}
+
+uint32_t BlockingAwareThreadPool::get_queue_size() {
+    lock_guard<mutex> l(_lock);
+    return _queue.size();
+}
+
+void BlockingAwareThreadPool::start_thread() {
+    ++_num_threads;
+    boost::thread(boost::bind(&BlockingAwareThreadPool::work_thread, this)).detach();
+}
+
+void BlockingAwareThreadPool::work_thread() {
+    set_current_thread_name(_name);
+    _s_current_pool = this;
+    unique_lock<mutex> l(_lock);
+    while (true) {
+        bool timed_out = false;
+        while (!_shutdown && (_queue.empty()
+                    || _num_active + _num_waiting_for_slot >= _num_active_threads)) {
+            ++_num_idle;
+            timed_out = !_work_cv.timed_wait(
+                    l, boost::posix_time::seconds(IDLE_THREAD_TIMEOUT_S));
+            --_num_idle;
+            if (timed_out && _num_threads > _num_active_threads) {
+                break;
+            }
+        }
+        if (_shutdown || (timed_out && _num_threads > _num_active_threads)) {
+            break;
+        }
+
+        WorkFunction work_function = _queue.front();
+        _queue.pop_front();
+        ++_num_active;
+        _not_full_cv.notify_one();
+        if (_queue.empty()) {
+            _empty_cv.notify_all();
+        }
+
+        l.unlock();
+        work_function();
+        l.lock();
+
+        --_num_active;
+        slot_freed();
+    }
+    --_num_threads;
+    if (_num_threads == 0) {
+        _no_threads_cv.notify_all();
+    }
+    _s_current_pool = NULL;
+}
+
+void BlockingAwareThreadPool::slot_freed() {
+    if (_num_waiting_for_slot > 0) {
+        _slot_cv.notify_one();
+    } else if (!_queue.empty()) {
+        if (_num_idle > 0) {
+            _work_cv.notify_one();
+        } else if (_num_threads < _max_threads) {
+            start_thread();
+        }
+    }
+}
+
+void BlockingAwareThreadPool::begin_blocking() {
+    lock_guard<mutex> l(_lock);
+    DCHECK_GT(_num_active, 0);
+    --_num_active;
+    slot_freed();
+}
+
+void BlockingAwareThreadPool::end_blocking() {
+    unique_lock<mutex> l(_lock);
+    ++_num_waiting_for_slot;
+    while (!_shutdown && _num_active >= _num_active_threads) {
+        _slot_cv.wait(l);
+    }
+    --_num_waiting_for_slot;
+    ++_num_active;
+}
+
+}
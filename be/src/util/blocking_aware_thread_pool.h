@@ -0,0 +1,146 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_UTIL_BLOCKING_AWARE_THREAD_POOL_H
+#define BDG_PALO_BE_SRC_UTIL_BLOCKING_AWARE_THREAD_POOL_H
+
+#include <stdint.h>
+
+#include <deque>
+#include <string>
+
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace palo {
+
+// Thread pool that separates the number of work items running on a CPU from the number
+// of threads. At most 'num_active_threads' threads run work at the same time. A work
+// item that waits for something else (data from an exchange, an rpc ack, a scanner)
+// marks the wait with a ScopedBlocking, which gives its slot to the next queued item,
+// starting another thread if no idle one is left, up to 'max_threads'. When the wait
+// is over, the thread waits for a free slot before it continues, so that the number of
+// runnable threads stays at 'num_active_threads'.
+//
+// Threads beyond 'num_active_threads' exit after being idle for a while. Work items are
+// taken in FIFO order; threads that return from a blocking wait get a free slot before
+// new work items.
+class BlockingAwareThreadPool {
+public:
+    typedef boost::function<void ()> WorkFunction;
+
+    // Marks the current thread as blocked for its lifetime if it is a thread of a
+    // BlockingAwareThreadPool, does nothing otherwise. May be nested.
+    //
+    // Taking back the slot may wait for other work items. If 'lock' is given, it's
+    // released meanwhile, so that the waiting thread doesn't hold up the ones running;
+    // the caller must re-check whatever it waited for afterwards. Typically:
+    //   while (!done) {
+    //       BlockingAwareThreadPool::ScopedBlocking blocking(&l);
+    //       cv.wait(l);
+    //   }
+    class ScopedBlocking {
+    public:
+        ScopedBlocking(boost::unique_lock<boost::mutex>* lock = NULL);
+        ~ScopedBlocking();
+
+    private:
+        BlockingAwareThreadPool* _pool;
+        boost::unique_lock<boost::mutex>* _lock;
+    };
+
+    //  -- num_active_threads: max number of threads running work and not being blocked,
+    //     0 means no limit other than max_threads
+    //  -- max_threads: max number of threads, including blocked ones
+    //  -- queue_size: max number of queued work items, offer() blocks if it is reached
+    //  -- name: the name of the threads
+    BlockingAwareThreadPool(uint32_t num_active_threads, uint32_t max_threads,
+                            uint32_t queue_size, const std::string& name = "pool");
+
+    // Shuts the pool down and waits for all threads to finish.
+    ~BlockingAwareThreadPool();
+
+    // Puts a work item on the queue, blocking while the queue is full. Returns false if
+    // the pool was shut down.
+    bool offer(WorkFunction func);
+
+    // Stops accepting work. Threads terminate once they finished their current work
+    // item; queued items are not run anymore.
+    void shutdown();
+
+    // Blocks until all threads have terminated.
+    void join();
+
+    // Blocks until the work queue is empty, then shuts down and joins the threads.
+    void drain_and_shutdown();
+
+    uint32_t get_queue_size();
+
+private:
+    // Seconds a thread beyond num_active_threads waits for work before it exits.
+    static const int IDLE_THREAD_TIMEOUT_S = 10;
+
+    void work_thread();
+
+    // Must be called with _lock held.
+    void start_thread();
+
+    // Gives up / takes back the slot of the current thread.
+    void begin_blocking();
+    void end_blocking();
+
+    // Wakes up a thread that can take the slot that was just freed. Must be called with
+    // _lock held.
+    void slot_freed();
+
+    const uint32_t _num_active_threads;
+    const uint32_t _max_threads;
+    const uint32_t _queue_size;
+    const std::string _name;
+
+    // Protects all fields below.
+    boost::mutex _lock;
+    std::deque<WorkFunction> _queue;
+    bool _shutdown;
+
+    // Number of threads, of idle threads waiting for work, of threads holding a slot
+    // and of threads that returned from a blocking wait and wait for a slot.
+    uint32_t _num_threads;
+    uint32_t _num_idle;
+    uint32_t _num_active;
+    uint32_t _num_waiting_for_slot;
+
+    // Signalled when a work item is queued or a slot is freed for idle threads.
+    boost::condition_variable _work_cv;
+    // Signalled when a slot is freed for threads returning from a blocking wait.
+    boost::condition_variable _slot_cv;
+    // Signalled when an item is taken from the queue.
+    boost::condition_variable _not_full_cv;
+    // Signalled when the queue becomes empty.
+    boost::condition_variable _empty_cv;
+    // Signalled when the last thread terminates.
+    boost::condition_variable _no_threads_cv;
+
+    // The pool the current thread belongs to and how deep it is nested in
+    // ScopedBlocking.
+    static __thread BlockingAwareThreadPool* _s_current_pool;
+    static __thread int _s_blocking_depth;
+};
+
+}
+
+#endif // BDG_PALO_BE_SRC_UTIL_BLOCKING_AWARE_THREAD_POOL_H
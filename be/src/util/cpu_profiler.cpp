@@ -0,0 +1,352 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/cpu_profiler.h"
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include <gperftools/stacktrace.h>
+
+#include "common/logging.h"
+#include "util/bfd_parser.h"
+#include "util/cpu_info.h"
+#include "util/symbols_util.h"
+
+namespace palo {
+
+static const int MAX_STACK_DEPTH = 48;
+// about 40MB of samples
+static const int MAX_SAMPLES = 100000;
+// including the terminating zero, see PR_GET_NAME
+static const int THREAD_NAME_LEN = 16;
+
+struct StackSample {
+    char thread_name[THREAD_NAME_LEN];
+    int depth;
+    void* pcs[MAX_STACK_DEPTH];
+};
+
+// Only one profile at a time.
+static std::mutex s_profile_lock;
+
+// Set up before the timer starts and read by the signal handler.
+static StackSample* s_samples = NULL;
+static int s_capacity = 0;
+static bool s_filter_query = false;
+static int64_t s_query_hi = 0;
+static int64_t s_query_lo = 0;
+static char s_thread_name[THREAD_NAME_LEN];
+static size_t s_thread_name_len = 0;
+
+static std::atomic<bool> s_sampling(false);
+static std::atomic<int> s_num_samples(0);
+static std::atomic<int> s_running_handlers(0);
+
+static __thread bool t_has_query = false;
+static __thread int64_t t_query_hi = 0;
+static __thread int64_t t_query_lo = 0;
+
+CpuProfiler::ScopedQueryTag::ScopedQueryTag(const TUniqueId& query_id) :
+        _prev_has_query(t_has_query),
+        _prev_hi(t_query_hi),
+        _prev_lo(t_query_lo) {
+    t_query_hi = query_id.hi;
+    t_query_lo = query_id.lo;
+    t_has_query = true;
+}
+
+CpuProfiler::ScopedQueryTag::~ScopedQueryTag() {
+    t_has_query = _prev_has_query;
+    t_query_hi = _prev_hi;
+    t_query_lo = _prev_lo;
+}
+
+// Must stay async-signal-safe.
+static void prof_handler(int sig, siginfo_t* info, void* context) {
+    int saved_errno = errno;
+    // counted before s_sampling is checked, so that stop_sampling() can wait for us
+    s_running_handlers.fetch_add(1);
+    if (s_sampling.load() && (!s_filter_query
+            || (t_has_query && t_query_hi == s_query_hi && t_query_lo == s_query_lo))) {
+        char name[THREAD_NAME_LEN] = {0};
+        prctl(PR_GET_NAME, name, 0, 0, 0);
+        if (strncmp(name, s_thread_name, s_thread_name_len) == 0) {
+            int idx = s_num_samples.fetch_add(1);
+            if (idx < s_capacity) {
+                StackSample* sample = &s_samples[idx];
+                memcpy(sample->thread_name, name, THREAD_NAME_LEN);
+                int depth = 0;
+#ifdef __x86_64__
+                // the interrupted pc, the unwinder may start at its caller
+                sample->pcs[depth++] = reinterpret_cast<void*>(
+                        static_cast<ucontext_t*>(context)->uc_mcontext.gregs[REG_RIP]);
+#endif
+                // skips this handler and the signal trampoline
+                depth += GetStackTraceWithContext(
+                        sample->pcs + depth, MAX_STACK_DEPTH - depth, 2, context);
+                sample->depth = depth;
+            }
+        }
+    }
+    s_running_handlers.fetch_sub(1);
+    errno = saved_errno;
+}
+
+static void set_timer(int frequency) {
+    struct itimerval timer;
+    timer.it_interval.tv_sec = 0;
+    timer.it_interval.tv_usec = frequency > 0 ? 1000000 / frequency : 0;
+    timer.it_value = timer.it_interval;
+    setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+// Name of the function at 'pc', its address if it can't be resolved.
+static std::string symbolize(BfdParser* symbolizer, void* pc) {
+    char addr[32];
+    snprintf(addr, sizeof(addr), "0x%lx", reinterpret_cast<uintptr_t>(pc));
+    std::string name;
+    if (symbolizer != NULL) {
+        std::string file_name;
+        std::string func_name;
+        unsigned int lineno = 0;
+        const char* end = NULL;
+        if (symbolizer->decode_address(addr, &end, &file_name, &func_name, &lineno) == 0) {
+            name = SymbolsUtil::demangle_no_args(func_name);
+        }
+    }
+    if (name.empty()) {
+        // shared libraries are not covered by the symbols of the binary
+        Dl_info info;
+        if (dladdr(pc, &info) != 0) {
+            if (info.dli_sname != NULL) {
+                name = SymbolsUtil::demangle_no_args(info.dli_sname);
+            } else if (info.dli_fname != NULL) {
+                const char* base = strrchr(info.dli_fname, '/');
+                name = std::string("[") + (base != NULL ? base + 1 : info.dli_fname) + "]";
+            }
+        }
+    }
+    if (name.empty()) {
+        name = addr;
+    }
+    // ';' separates the frames of a collapsed stack
+    std::replace(name.begin(), name.end(), ';', ':');
+    return name;
+}
+
+Status CpuProfiler::profile(const Options& options, BfdParser* symbolizer,
+                            std::map<std::string, int64_t>* stacks) {
+    std::unique_lock<std::mutex> l(s_profile_lock, std::try_to_lock);
+    if (!l.owns_lock()) {
+        return Status("Another CPU profile is running");
+    }
+    int seconds = std::min(std::max(options.seconds, 1), 300);
+    int frequency = std::min(std::max(options.frequency, 1), 1000);
+    int64_t capacity = static_cast<int64_t>(seconds) * frequency * CpuInfo::num_cores();
+    std::vector<StackSample> samples(std::min<int64_t>(capacity, MAX_SAMPLES));
+
+    s_samples = samples.data();
+    s_capacity = samples.size();
+    s_filter_query = options.filter_query;
+    s_query_hi = options.query_id.hi;
+    s_query_lo = options.query_id.lo;
+    s_thread_name_len = std::min<size_t>(options.thread_name.size(), THREAD_NAME_LEN - 1);
+    memcpy(s_thread_name, options.thread_name.data(), s_thread_name_len);
+    s_thread_name[s_thread_name_len] = '\0';
+    s_num_samples = 0;
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = prof_handler;
+    action.sa_flags = SA_RESTART | SA_SIGINFO;
+    sigemptyset(&action.sa_mask);
+    struct sigaction old_action;
+    if (sigaction(SIGPROF, &action, &old_action) != 0) {
+        return Status("Failed to install the SIGPROF handler");
+    }
+    s_sampling = true;
+    set_timer(frequency);
+    sleep(seconds);
+    set_timer(0);
+    s_sampling = false;
+    while (s_running_handlers.load() > 0) {
+        usleep(1000);
+    }
+    // A signal may still be pending on some thread, don't let the default action of
+    // SIGPROF terminate the process.
+    if (!(old_action.sa_flags & SA_SIGINFO) && old_action.sa_handler == SIG_DFL) {
+        old_action.sa_handler = SIG_IGN;
+    }
+    sigaction(SIGPROF, &old_action, NULL);
+
+    int num_samples = s_num_samples.load();
+    if (num_samples > s_capacity) {
+        LOG(WARNING) << "CPU profile dropped " << num_samples - s_capacity
+            << " of " << num_samples << " samples";
+        num_samples = s_capacity;
+    }
+    std::unordered_map<void*, std::string> names;
+    for (int i = 0; i < num_samples; ++i) {
+        const StackSample& sample = samples[i];
+        std::string stack = sample.thread_name;
+        for (int j = sample.depth - 1; j >= 0; --j) {
+            void* pc = sample.pcs[j];
+            if (j == 0 && sample.depth > 1 && pc == sample.pcs[1]) {
+                continue;
+            }
+            auto it = names.find(pc);
+            if (it == names.end()) {
+                // return addresses point behind the call, look up the call itself
+                void* lookup_pc = j == 0 ? pc : static_cast<char*>(pc) - 1;
+                it = names.insert(std::make_pair(pc, symbolize(symbolizer, lookup_pc))).first;
+            }
+            stack.push_back(';');
+            stack.append(it->second);
+        }
+        ++(*stacks)[stack];
+    }
+    return Status::OK;
+}
+
+std::string CpuProfiler::to_collapsed(const std::map<std::string, int64_t>& stacks) {
+    std::stringstream ss;
+    for (auto& it : stacks) {
+        ss << it.first << " " << it.second << "\n";
+    }
+    return ss.str();
+}
+
+namespace {
+
+struct FrameNode {
+    FrameNode() : count(0) {}
+    int64_t count;
+    std::map<std::string, std::unique_ptr<FrameNode>> children;
+};
+
+std::string escape_xml(const std::string& str) {
+    std::string result;
+    for (char c : str) {
+        switch (c) {
+        case '&': result.append("&amp;"); break;
+        case '<': result.append("&lt;"); break;
+        case '>': result.append("&gt;"); break;
+        case '"': result.append("&quot;"); break;
+        default: result.push_back(c); break;
+        }
+    }
+    return result;
+}
+
+const double SVG_WIDTH = 1200;
+const double SVG_MARGIN = 10;
+const int FRAME_HEIGHT = 16;
+// width of a character of the 12px font
+const double CHAR_WIDTH = 7;
+
+int tree_depth(const FrameNode& node) {
+    int depth = 0;
+    for (auto& it : node.children) {
+        depth = std::max(depth, tree_depth(*it.second) + 1);
+    }
+    return depth;
+}
+
+void draw_frames(const std::string& name, const FrameNode& node, int64_t total,
+                 double x, int depth, int bottom, std::stringstream* ss) {
+    double width = (SVG_WIDTH - 2 * SVG_MARGIN) * node.count / total;
+    if (width < 0.1) {
+        return;
+    }
+    int y = bottom - (depth + 1) * FRAME_HEIGHT;
+    // warm colors, stable for a function name
+    size_t hash = std::hash<std::string>()(name);
+    (*ss) << "<g><title>" << escape_xml(name) << " (" << node.count << " samples, "
+        << std::fixed << std::setprecision(2) << 100.0 * node.count / total
+        << "%)</title><rect x=\"" << x << "\" y=\"" << y << "\" width=\"" << width
+        << "\" height=\"" << FRAME_HEIGHT - 1 << "\" fill=\"rgb(" << 205 + hash % 50
+        << "," << (hash >> 8) % 230 << "," << (hash >> 16) % 55 << ")\" rx=\"2\"/>";
+    size_t max_chars = static_cast<size_t>((width - 6) / CHAR_WIDTH);
+    if (max_chars >= 3) {
+        std::string text = name.size() <= max_chars ? name : name.substr(0, max_chars - 2) + "..";
+        (*ss) << "<text x=\"" << x + 3 << "\" y=\"" << y + FRAME_HEIGHT - 4 << "\">"
+            << escape_xml(text) << "</text>";
+    }
+    (*ss) << "</g>\n";
+    for (auto& it : node.children) {
+        draw_frames(it.first, *it.second, total, x, depth + 1, bottom, ss);
+        x += (SVG_WIDTH - 2 * SVG_MARGIN) * it.second->count / total;
+    }
+}
+
+}
+
+std::string CpuProfiler::to_flame_graph_svg(const std::map<std::string, int64_t>& stacks,
+                                            const std::string& title) {
+    FrameNode root;
+    for (auto& it : stacks) {
+        root.count += it.second;
+        FrameNode* node = &root;
+        size_t begin = 0;
+        while (begin <= it.first.size()) {
+            size_t end = it.first.find(';', begin);
+            if (end == std::string::npos) {
+                end = it.first.size();
+            }
+            std::unique_ptr<FrameNode>& child = node->children[it.first.substr(begin, end - begin)];
+            if (child == nullptr) {
+                child.reset(new FrameNode());
+            }
+            child->count += it.second;
+            node = child.get();
+            begin = end + 1;
+        }
+    }
+
+    int depth = tree_depth(root) + 1;
+    int height = (depth + 3) * FRAME_HEIGHT;
+    int bottom = height - FRAME_HEIGHT;
+    std::stringstream ss;
+    ss << "<?xml version=\"1.0\" standalone=\"no\"?>\n"
+        << "<svg version=\"1.1\" width=\"" << SVG_WIDTH << "\" height=\"" << height
+        << "\" xmlns=\"http://www.w3.org/2000/svg\" font-family=\"Verdana\" font-size=\"12\">\n"
+        << "<rect x=\"0\" y=\"0\" width=\"100%\" height=\"100%\" fill=\"#f8f8f8\"/>\n"
+        << "<text x=\"" << SVG_WIDTH / 2 << "\" y=\"" << FRAME_HEIGHT + 4
+        << "\" text-anchor=\"middle\" font-size=\"16\">" << escape_xml(title) << "</text>\n";
+    if (root.count > 0) {
+        draw_frames("all", root, root.count, SVG_MARGIN, 0, bottom, &ss);
+    }
+    ss << "</svg>\n";
+    return ss.str();
+}
+
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_UTIL_CPU_PROFILER_H
+#define BDG_PALO_BE_SRC_UTIL_CPU_PROFILER_H
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+
+#include "common/status.h"
+#include "gen_cpp/Types_types.h"
+
+namespace palo {
+
+class BfdParser;
+
+// Samples the stacks of the threads running on a CPU with SIGPROF and aggregates them
+// into collapsed stacks ("thread;outer;...;inner count" per line) symbolized in process,
+// which flamegraph.pl, speedscope or to_flame_graph_svg() render. Unlike the gperftools
+// profile of /pprof/profile it needs neither the binary nor the pprof tool, and can be
+// limited to the threads of one query or of one thread pool.
+//
+// Only one profile runs at a time, and it must not overlap with the gperftools CPU
+// profiler, which uses SIGPROF as well.
+class CpuProfiler {
+public:
+    struct Options {
+        Options() : seconds(10), frequency(99), filter_query(false) {}
+
+        int seconds;
+        // samples per second of CPU time
+        int frequency;
+        // only sample the threads working for 'query_id', see ScopedQueryTag
+        bool filter_query;
+        TUniqueId query_id;
+        // only sample the threads whose name starts with it, e.g. "scanner"
+        std::string thread_name;
+    };
+
+    // Marks the calling thread as working for 'query_id' for the lifetime of the tag.
+    class ScopedQueryTag {
+    public:
+        explicit ScopedQueryTag(const TUniqueId& query_id);
+        ~ScopedQueryTag();
+
+    private:
+        bool _prev_has_query;
+        int64_t _prev_hi;
+        int64_t _prev_lo;
+    };
+
+    // Samples for options.seconds, blocking the calling thread, and symbolizes the
+    // stacks with 'symbolizer'. Fails if another profile is running.
+    static Status profile(const Options& options, BfdParser* symbolizer,
+                          std::map<std::string, int64_t>* stacks);
+
+    // Writes 'stacks' in the collapsed format.
+    static std::string to_collapsed(const std::map<std::string, int64_t>& stacks);
+
+    // Renders 'stacks' as a standalone flame graph SVG, the root at the bottom.
+    static std::string to_flame_graph_svg(const std::map<std::string, int64_t>& stacks,
+                                          const std::string& title);
+};
+
+}
+
+#endif
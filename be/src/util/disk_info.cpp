@@ -141,6 +141,50 @@ int DiskInfo::disk_id(const char* path) {
     return it->second;
 }
 
+bool DiskInfo::get_disk_stats(std::map<int, DiskStats>* disk_stats) {
+    // Format of this file is:
+    //    major, minor, name, reads completed, reads merged, sectors read, time reading(ms),
+    //    writes completed, writes merged, sectors written, time writing(ms),
+    //    IOs in progress, time doing IOs(ms), weighted time doing IOs(ms), ...
+    std::ifstream diskstats("/proc/diskstats", std::ios::in);
+    if (!diskstats.good()) {
+        return false;
+    }
+
+    disk_stats->clear();
+    while (diskstats.good() && !diskstats.eof()) {
+        std::string line;
+        getline(diskstats, line);
+        boost::trim(line);
+
+        std::vector<std::string> fields;
+        boost::split(fields, line, boost::is_any_of(" "), boost::token_compress_on);
+        if (fields.size() < 14) {
+            continue;
+        }
+
+        // Only the whole disk is counted, partitions are skipped
+        std::map<std::string, int>::iterator it = _s_disk_name_to_disk_id.find(fields[2]);
+        if (it == _s_disk_name_to_disk_id.end()) {
+            continue;
+        }
+
+        DiskStats stats;
+        stats.reads_completed = atoll(fields[3].c_str());
+        stats.read_time_ms = atoll(fields[6].c_str());
+        stats.writes_completed = atoll(fields[7].c_str());
+        stats.write_time_ms = atoll(fields[10].c_str());
+        stats.io_time_ms = atoll(fields[12].c_str());
+        stats.weighted_io_time_ms = atoll(fields[13].c_str());
+        (*disk_stats)[it->second] = stats;
+    }
+
+    if (diskstats.is_open()) {
+        diskstats.close();
+    }
+    return true;
+}
+
 std::string DiskInfo::debug_string() {
     DCHECK(_s_initialized);
     std::stringstream stream;
@@ -23,6 +23,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include <boost/cstdint.hpp>
 #include "common/logging.h"
@@ -78,6 +79,25 @@ public:
         return _s_disks[disk_id].is_rotational;
     }
 
+    // IO counters of a disk, pulled from /proc/diskstats.
+    struct DiskStats {
+        DiskStats() : reads_completed(0), read_time_ms(0), writes_completed(0),
+                write_time_ms(0), io_time_ms(0), weighted_io_time_ms(0) {}
+
+        int64_t reads_completed;
+        int64_t read_time_ms;
+        int64_t writes_completed;
+        int64_t write_time_ms;
+        // time spent doing IOs, used to compute IO utilization
+        int64_t io_time_ms;
+        // weighted time spent doing IOs, used to compute average queue size
+        int64_t weighted_io_time_ms;
+    };
+
+    // Reads the IO counters of all disks, keyed by disk id.
+    // Returns false if /proc/diskstats can not be read.
+    static bool get_disk_stats(std::map<int, DiskStats>* disk_stats);
+
     static std::string debug_string();
 
 private:
@@ -0,0 +1,137 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/disk_io_stats.h"
+
+#include <mutex>
+#include <vector>
+
+namespace palo {
+
+// Bound of the paths the families tell apart, more than the disks of any host
+static const int MAX_PATHS = 128;
+
+// All stats, by path. Guards the creation of the families as well.
+static std::mutex _s_lock;
+static std::vector<DiskIoStats*> _s_stats;
+
+static HistogramFamily* _s_read_latency = NULL;
+static HistogramFamily* _s_write_latency = NULL;
+static MetricFamily<IntCounter>* _s_read_bytes = NULL;
+static MetricFamily<IntCounter>* _s_write_bytes = NULL;
+static MetricFamily<IntCounter>* _s_reads = NULL;
+static MetricFamily<IntCounter>* _s_writes = NULL;
+
+static void create_families() {
+    if (_s_read_latency != NULL) {
+        return;
+    }
+    _s_read_latency = new HistogramFamily(
+            MetricDefs::Get("palo_be.disk.read_latency"), "path", MAX_PATHS);
+    _s_write_latency = new HistogramFamily(
+            MetricDefs::Get("palo_be.disk.write_latency"), "path", MAX_PATHS);
+    _s_read_bytes = new MetricFamily<IntCounter>(
+            MetricDefs::Get("palo_be.disk.read_bytes"), "path", MAX_PATHS);
+    _s_write_bytes = new MetricFamily<IntCounter>(
+            MetricDefs::Get("palo_be.disk.write_bytes"), "path", MAX_PATHS);
+    _s_reads = new MetricFamily<IntCounter>(
+            MetricDefs::Get("palo_be.disk.reads"), "path", MAX_PATHS);
+    _s_writes = new MetricFamily<IntCounter>(
+            MetricDefs::Get("palo_be.disk.writes"), "path", MAX_PATHS);
+}
+
+static std::string normalize(const std::string& path) {
+    std::string normalized = path;
+    while (normalized.size() > 1 && normalized[normalized.size() - 1] == '/') {
+        normalized.resize(normalized.size() - 1);
+    }
+    return normalized;
+}
+
+void DiskIoStats::add_path(const std::string& path) {
+    std::string normalized = normalize(path);
+    std::lock_guard<std::mutex> l(_s_lock);
+    for (DiskIoStats* stats : _s_stats) {
+        if (stats->_path == normalized) {
+            return;
+        }
+    }
+    create_families();
+    _s_stats.push_back(new DiskIoStats(normalized));
+}
+
+DiskIoStats* DiskIoStats::find(const std::string& file_name) {
+    std::lock_guard<std::mutex> l(_s_lock);
+    DiskIoStats* found = NULL;
+    for (DiskIoStats* stats : _s_stats) {
+        const std::string& path = stats->_path;
+        if (file_name.compare(0, path.size(), path) == 0
+                && (file_name.size() == path.size() || file_name[path.size()] == '/')
+                && (found == NULL || path.size() > found->_path.size())) {
+            found = stats;
+        }
+    }
+    return found;
+}
+
+void DiskIoStats::register_metrics(MetricGroup* metrics) {
+    std::lock_guard<std::mutex> l(_s_lock);
+    create_families();
+    metrics->register_metric(_s_read_latency);
+    metrics->register_metric(_s_write_latency);
+    metrics->register_metric(_s_read_bytes);
+    metrics->register_metric(_s_write_bytes);
+    metrics->register_metric(_s_reads);
+    metrics->register_metric(_s_writes);
+}
+
+DiskIoStats::DiskIoStats(const std::string& path) :
+        _path(path),
+        _read_latency(_s_read_latency->get(path)),
+        _write_latency(_s_write_latency->get(path)),
+        _read_bytes(_s_read_bytes->get(path)),
+        _write_bytes(_s_write_bytes->get(path)),
+        _reads(_s_reads->get(path)),
+        _writes(_s_writes->get(path)) {
+}
+
+void DiskIoStats::record_read(int64_t bytes, int64_t latency_ns) {
+    _read_latency->update(latency_ns);
+    _read_bytes->increment(bytes);
+    _reads->increment(1);
+}
+
+void DiskIoStats::record_write(int64_t bytes, int64_t latency_ns) {
+    _write_latency->update(latency_ns);
+    _write_bytes->increment(bytes);
+    _writes->increment(1);
+}
+
+int64_t DiskIoStats::read_latency_since_last(double quantile) {
+    HistogramMetric::Snapshot reads;
+    _read_latency->snapshot(&reads);
+    HistogramMetric::Snapshot interval;
+    for (int i = 0; i < HistogramMetric::NUM_BUCKETS; ++i) {
+        interval.buckets[i] = reads.buckets[i] - _last_reads.buckets[i];
+        interval.count += interval.buckets[i];
+    }
+    interval.sum = reads.sum - _last_reads.sum;
+    // the largest value of the interval isn't known, the one of all time bounds it
+    interval.max = reads.max;
+    _last_reads = reads;
+    return interval.value_at_quantile(quantile);
+}
+
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_UTIL_DISK_IO_STATS_H
+#define BDG_PALO_BE_SRC_UTIL_DISK_IO_STATS_H
+
+#include <string>
+
+#include "util/histogram_metric.h"
+#include "util/metrics.h"
+
+namespace palo {
+
+// Latency and throughput of the blocking file IO under a path, usually a root path of
+// the storage engine, so that a disk which degrades shows in the tail latency before
+// it fails outright.
+//
+// The stats of all paths are exported as metric families labeled by path once
+// register_metrics() was called. Paths may be added before that, as the storage engine
+// is started before the metrics are created.
+class DiskIoStats {
+public:
+    // Starts to keep the stats of the IO under 'path'. Paths are never dropped, as file
+    // handlers keep pointers to their stats.
+    static void add_path(const std::string& path);
+
+    // The stats of the longest path added that 'file_name' is under, NULL if there is
+    // none.
+    static DiskIoStats* find(const std::string& file_name);
+
+    // Registers the metric families of the stats in 'metrics', which owns them then.
+    // Must be called once at most.
+    static void register_metrics(MetricGroup* metrics);
+
+    void record_read(int64_t bytes, int64_t latency_ns);
+    void record_write(int64_t bytes, int64_t latency_ns);
+
+    // The 'quantile' of the latency in nanoseconds of the reads since the last call, 0
+    // if there were none. Meant for a single monitor thread, it's not thread safe.
+    int64_t read_latency_since_last(double quantile);
+
+    const std::string& path() const {
+        return _path;
+    }
+
+private:
+    DiskIoStats(const std::string& path);
+
+    const std::string _path;
+    HistogramMetric* _read_latency;
+    HistogramMetric* _write_latency;
+    IntCounter* _read_bytes;
+    IntCounter* _write_bytes;
+    IntCounter* _reads;
+    IntCounter* _writes;
+
+    // read_latency_since_last() diffs against this
+    HistogramMetric::Snapshot _last_reads;
+
+    DISALLOW_COPY_AND_ASSIGN(DiskIoStats);
+};
+
+}
+
+#endif
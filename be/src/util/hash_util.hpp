@@ -21,6 +21,8 @@
 #ifndef BDG_PALO_BE_SRC_COMMON_UTIL_HASH_UTIL_HPP
 #define BDG_PALO_BE_SRC_COMMON_UTIL_HASH_UTIL_HPP
 
+#include <string.h>
+
 #include "common/logging.h"
 #include "common/compiler_util.h"
 
@@ -256,6 +258,75 @@ public:
 #endif
     }
 
+    // CRC32C of the 8 bytes of 'v' (little endian) on top of 'crc', i.e. the
+    // _mm_crc32_u64() instruction, computed with a lookup table when SSE4.2 is not
+    // available so that the result doesn't depend on the host.
+    static uint32_t crc32c_u64(uint32_t crc, uint64_t v) {
+#ifdef __SSE4_2__
+        if (LIKELY(CpuInfo::is_supported(CpuInfo::SSE4_2))) {
+            return _mm_crc32_u64(crc, v);
+        }
+#endif
+        const uint32_t* table = crc32c_table();
+        for (int i = 0; i < 8; ++i) {
+            crc = table[(crc ^ v) & 0xff] ^ (crc >> 8);
+            v >>= 8;
+        }
+        return crc;
+    }
+
+    // Finalizer of MurmurHash3, spreads every input bit over all the 64 output bits.
+    static uint64_t fmix64(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // 64-bit hash for hash tables, shuffles and bloom filters. The input is consumed in
+    // two interleaved CRC32C lanes, which run at the throughput of the crc32
+    // instruction, and the lanes, the length and the seed are then mixed by fmix64() so
+    // that all the bits of the result are usable and different seeds give unrelated
+    // hashes, unlike crc_hash(). The result is the same with and without SSE4.2, so it
+    // can be used to partition data across hosts.
+    static uint64_t fast_hash64(const void* data, int32_t bytes, uint64_t seed) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+        uint32_t h1 = (uint32_t)seed;
+        uint32_t h2 = (uint32_t)(seed >> 32) ^ FAST_HASH_LANE_SEED;
+        int32_t len = bytes;
+        uint64_t v1 = 0;
+        uint64_t v2 = 0;
+        while (bytes >= 16) {
+            memcpy(&v1, p, 8);
+            memcpy(&v2, p + 8, 8);
+            h1 = crc32c_u64(h1, v1);
+            h2 = crc32c_u64(h2, v2);
+            p += 16;
+            bytes -= 16;
+        }
+        if (bytes >= 8) {
+            memcpy(&v1, p, 8);
+            h1 = crc32c_u64(h1, v1);
+            p += 8;
+            bytes -= 8;
+        }
+        if (bytes > 0) {
+            v2 = 0;
+            memcpy(&v2, p, bytes);
+            h2 = crc32c_u64(h2, v2);
+        }
+        uint64_t h = ((uint64_t)h1 << 32) | h2;
+        return fmix64(h ^ seed ^ ((uint64_t)len * MURMUR_PRIME));
+    }
+
+    // fast_hash64() folded to 32 bits, for hash tables with 32-bit hash values
+    static uint32_t fast_hash(const void* data, int32_t bytes, uint32_t seed) {
+        uint64_t h = fast_hash64(data, bytes, seed);
+        return (uint32_t)(h ^ (h >> 32));
+    }
+
     static uint64_t hash64(const void* data, int32_t bytes, uint64_t seed) {
 #ifdef _SSE4_2_
         if (LIKELY(CpuInfo::is_supported(CpuInfo::SSE4_2))) {
@@ -274,6 +345,25 @@ public:
 
     }
 
+private:
+    static const uint32_t FAST_HASH_LANE_SEED = 0x9e3779b9;
+
+    static const uint32_t* crc32c_table() {
+        struct Table {
+            uint32_t data[256];
+            Table() {
+                for (uint32_t i = 0; i < 256; ++i) {
+                    uint32_t crc = i;
+                    for (int j = 0; j < 8; ++j) {
+                        crc = (crc >> 1) ^ (0x82f63b78 & (0 - (crc & 1)));
+                    }
+                    data[i] = crc;
+                }
+            }
+        };
+        static const Table table;
+        return table.data;
+    }
 };
 
 }
@@ -37,6 +37,11 @@ uint32_t ir_crc_hash(const void* data, int32_t bytes, uint32_t hash) {
     return HashUtil::fnv_hash(data, bytes, hash);
 #endif
 }
+
+extern "C"
+uint32_t ir_fast_hash(const void* data, int32_t bytes, uint32_t hash) {
+    return HashUtil::fast_hash(data, bytes, hash);
+}
 #else
 #error "This file should only be compiled by clang."
 #endif
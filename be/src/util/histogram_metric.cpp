@@ -0,0 +1,240 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/histogram_metric.h"
+
+#include <iomanip>
+
+namespace palo {
+
+// The shard of the calling thread, assigned round robin when it first records a value
+static __thread int _s_shard = -1;
+static std::atomic<int> _s_next_shard(0);
+
+HistogramMetric::Shard::Shard() : count(0), sum(0), max(0) {
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        buckets[i] = 0;
+    }
+}
+
+HistogramMetric::HistogramMetric(const TMetricDef& def) :
+        Metric(def),
+        _unit(def.units) {
+    for (int i = 0; i < NUM_SHARDS; ++i) {
+        _shards[i] = NULL;
+    }
+}
+
+HistogramMetric::~HistogramMetric() {
+    for (int i = 0; i < NUM_SHARDS; ++i) {
+        delete _shards[i].load();
+    }
+}
+
+int HistogramMetric::bucket_index(int64_t value) {
+    if (value < SUB_BUCKETS) {
+        return value < 0 ? 0 : value;
+    }
+    int bits = 63 - __builtin_clzll(value);
+    if (bits >= MAX_BITS) {
+        return NUM_BUCKETS - 1;
+    }
+    int shift = bits - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+int64_t HistogramMetric::bucket_lower_bound(int index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    int shift = index / SUB_BUCKETS - 1;
+    return (int64_t)(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+}
+
+int64_t HistogramMetric::bucket_upper_bound(int index) {
+    if (index < SUB_BUCKETS) {
+        return index + 1;
+    }
+    return bucket_lower_bound(index) + ((int64_t)1 << (index / SUB_BUCKETS - 1));
+}
+
+HistogramMetric::Shard* HistogramMetric::get_shard() {
+    if (UNLIKELY(_s_shard < 0)) {
+        _s_shard = _s_next_shard.fetch_add(1) % NUM_SHARDS;
+    }
+    Shard* shard = _shards[_s_shard].load(std::memory_order_acquire);
+    if (UNLIKELY(shard == NULL)) {
+        Shard* new_shard = new Shard();
+        if (_shards[_s_shard].compare_exchange_strong(shard, new_shard)) {
+            shard = new_shard;
+        } else {
+            // another thread of the shard was first, 'shard' is its copy now
+            delete new_shard;
+        }
+    }
+    return shard;
+}
+
+void HistogramMetric::update(int64_t value) {
+    value = std::max<int64_t>(value, 0);
+    Shard* shard = get_shard();
+    shard->buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    shard->count.fetch_add(1, std::memory_order_relaxed);
+    shard->sum.fetch_add(value, std::memory_order_relaxed);
+    int64_t max = shard->max.load(std::memory_order_relaxed);
+    while (value > max
+            && !shard->max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+}
+
+void HistogramMetric::snapshot(Snapshot* snapshot) const {
+    for (int i = 0; i < NUM_SHARDS; ++i) {
+        const Shard* shard = _shards[i].load(std::memory_order_acquire);
+        if (shard == NULL) {
+            continue;
+        }
+        for (int j = 0; j < NUM_BUCKETS; ++j) {
+            snapshot->buckets[j] += shard->buckets[j].load(std::memory_order_relaxed);
+        }
+        snapshot->sum += shard->sum.load(std::memory_order_relaxed);
+        snapshot->max = std::max(snapshot->max, shard->max.load(std::memory_order_relaxed));
+    }
+    // counted from the buckets, so that it's consistent with them even if values were
+    // recorded while they were read
+    for (int j = 0; j < NUM_BUCKETS; ++j) {
+        snapshot->count += snapshot->buckets[j];
+    }
+}
+
+int64_t HistogramMetric::count() const {
+    int64_t count = 0;
+    for (int i = 0; i < NUM_SHARDS; ++i) {
+        const Shard* shard = _shards[i].load(std::memory_order_acquire);
+        if (shard != NULL) {
+            count += shard->count.load(std::memory_order_relaxed);
+        }
+    }
+    return count;
+}
+
+int64_t HistogramMetric::Snapshot::value_at_quantile(double quantile) const {
+    if (count == 0) {
+        return 0;
+    }
+    // the rank of the value, 1-based
+    int64_t rank = std::max<int64_t>(1, (int64_t)(quantile * count + 0.5));
+    int64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            // the middle of the bucket, but never beyond the largest value recorded
+            int64_t mid = (bucket_lower_bound(i) + bucket_upper_bound(i) - 1) / 2;
+            return std::min(mid, max);
+        }
+    }
+    return max;
+}
+
+static const double QUANTILES[] = { 0.5, 0.9, 0.99, 0.999 };
+static const char* QUANTILE_NAMES[] = { "p50", "p90", "p99", "p999" };
+
+std::string HistogramMetric::ToHumanReadable() {
+    std::stringstream ss;
+    print_value(&ss);
+    return ss.str();
+}
+
+void HistogramMetric::print_value(std::stringstream* out) {
+    Snapshot s;
+    snapshot(&s);
+    (*out) << "count=" << s.count;
+    for (int i = 0; i < sizeof(QUANTILES) / sizeof(QUANTILES[0]); ++i) {
+        (*out) << " " << QUANTILE_NAMES[i] << "="
+            << PrettyPrinter::print(s.value_at_quantile(QUANTILES[i]), _unit);
+    }
+    (*out) << " max=" << PrettyPrinter::print(s.max, _unit);
+}
+
+void HistogramMetric::print_value_json(std::stringstream* out) {
+    Snapshot s;
+    snapshot(&s);
+    (*out) << "{\"count\": " << s.count << ", \"sum\": " << s.sum;
+    for (int i = 0; i < sizeof(QUANTILES) / sizeof(QUANTILES[0]); ++i) {
+        (*out) << ", \"" << QUANTILE_NAMES[i] << "\": " << s.value_at_quantile(QUANTILES[i]);
+    }
+    (*out) << ", \"max\": " << s.max << "}";
+}
+
+void HistogramMetric::ToJson(rapidjson::Document* document, rapidjson::Value* val) {
+    Snapshot s;
+    snapshot(&s);
+    rapidjson::Value container(rapidjson::kObjectType);
+    AddStandardFields(document, &container);
+    container.AddMember("count", s.count, document->GetAllocator());
+    container.AddMember("sum", s.sum, document->GetAllocator());
+    for (int i = 0; i < sizeof(QUANTILES) / sizeof(QUANTILES[0]); ++i) {
+        container.AddMember(rapidjson::StringRef(QUANTILE_NAMES[i]),
+                            s.value_at_quantile(QUANTILES[i]), document->GetAllocator());
+    }
+    container.AddMember("max", s.max, document->GetAllocator());
+    container.AddMember("kind", "HISTOGRAM", document->GetAllocator());
+    rapidjson::Value units(PrintTUnit(_unit).c_str(), document->GetAllocator());
+    container.AddMember("units", units, document->GetAllocator());
+    *val = container;
+}
+
+void HistogramMetric::ToLegacyJson(rapidjson::Document* document) {
+    rapidjson::Value val(ToHumanReadable().c_str(), document->GetAllocator());
+    rapidjson::Value key(_key.c_str(), document->GetAllocator());
+    document->AddMember(key, val, document->GetAllocator());
+}
+
+void HistogramMetric::print_prometheus(
+        const std::string& name, const std::string& labels, std::stringstream* out) {
+    Snapshot s;
+    snapshot(&s);
+    // Prometheus wants times in seconds
+    double scale = 1;
+    int first_bits = 0;
+    if (_unit == TUnit::TIME_NS) {
+        scale = 1e-9;
+        // ~1us
+        first_bits = 10;
+    } else if (_unit == TUnit::TIME_MS) {
+        scale = 1e-3;
+    } else if (_unit == TUnit::TIME_S) {
+        scale = 1;
+    }
+    std::string sep = labels.empty() ? "" : ",";
+
+    // the le bounds are powers of four, all of them are bucket bounds
+    int64_t cumulative = 0;
+    int index = 0;
+    for (int bits = first_bits; bits <= MAX_BITS; bits += 2) {
+        int64_t bound = (int64_t)1 << bits;
+        while (index < NUM_BUCKETS - 1 && bucket_upper_bound(index) <= bound) {
+            cumulative += s.buckets[index++];
+        }
+        (*out) << name << "_bucket{" << labels << sep << "le=\""
+            << std::setprecision(6) << bound * scale << "\"} " << cumulative << "\n";
+    }
+    (*out) << name << "_bucket{" << labels << sep << "le=\"+Inf\"} " << s.count << "\n";
+    std::string braced_labels = labels.empty() ? "" : "{" + labels + "}";
+    (*out) << name << "_sum" << braced_labels << " " << std::setprecision(9)
+        << s.sum * scale << "\n";
+    (*out) << name << "_count" << braced_labels << " " << s.count << "\n";
+}
+
+}
@@ -0,0 +1,143 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_UTIL_HISTOGRAM_METRIC_H
+#define BDG_PALO_BE_SRC_UTIL_HISTOGRAM_METRIC_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "util/metrics.h"
+#include "util/stopwatch.hpp"
+
+namespace palo {
+
+// A metric recording the distribution of a value, typically a latency, so that its
+// percentiles can be told and not only its average.
+//
+// The values are counted in log-linear buckets: values below SUB_BUCKETS have a bucket
+// each, above that every power of two is split into SUB_BUCKETS buckets of equal width,
+// so a percentile is off by at most 1 / (2 * SUB_BUCKETS) of its value. Values beyond
+// 2^MAX_BITS are counted in the last bucket.
+//
+// update() is lock free. To keep threads that record at the same time from contending
+// on the counters, every thread counts into one of NUM_SHARDS copies of the buckets,
+// which are allocated the first time a thread of that shard records a value. Readers
+// add the shards up.
+//
+// Values are in the unit of the metric definition. When exported to Prometheus, times
+// are converted to seconds and the buckets are coarsened to powers of four.
+class HistogramMetric : public Metric {
+public:
+    static const int SUB_BUCKET_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_BITS = 44;
+    static const int NUM_BUCKETS = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+    static const int NUM_SHARDS = 8;
+
+    HistogramMetric(const TMetricDef& def);
+    virtual ~HistogramMetric();
+
+    // Records 'value', negative values are recorded as 0.
+    void update(int64_t value);
+
+    // The sum of all shards
+    struct Snapshot {
+        Snapshot() : count(0), sum(0), max(0), buckets(NUM_BUCKETS, 0) { }
+
+        int64_t count;
+        int64_t sum;
+        int64_t max;
+        std::vector<int64_t> buckets;
+
+        // The value below which 'quantile' (0 to 1) of the values fall, 0 if nothing
+        // was recorded.
+        int64_t value_at_quantile(double quantile) const;
+    };
+
+    void snapshot(Snapshot* snapshot) const;
+
+    int64_t count() const;
+
+    TUnit::type unit() const {
+        return _unit;
+    }
+
+    // Index of the bucket of 'value' and the bounds [lower, upper) of a bucket
+    static int bucket_index(int64_t value);
+    static int64_t bucket_lower_bound(int index);
+    static int64_t bucket_upper_bound(int index);
+
+    virtual void ToJson(rapidjson::Document* document, rapidjson::Value* val);
+    virtual void ToLegacyJson(rapidjson::Document* document);
+    // e.g. "count=10 p50=1.00ms p90=2.00ms p99=2.50ms p999=2.50ms max=2.51ms"
+    virtual std::string ToHumanReadable();
+
+    virtual const char* prometheus_type() {
+        return "histogram";
+    }
+
+    virtual void print_prometheus(const std::string& name, const std::string& labels,
+                                  std::stringstream* out);
+
+protected:
+    virtual void print_value(std::stringstream* out);
+    virtual void print_value_json(std::stringstream* out);
+
+private:
+    struct Shard {
+        Shard();
+
+        std::atomic<int64_t> count;
+        std::atomic<int64_t> sum;
+        std::atomic<int64_t> max;
+        std::atomic<int64_t> buckets[NUM_BUCKETS];
+        // keeps the counters of the next shard off the cache lines of this one
+        char padding[64];
+    };
+
+    Shard* get_shard();
+
+    const TUnit::type _unit;
+    std::atomic<Shard*> _shards[NUM_SHARDS];
+
+    DISALLOW_COPY_AND_ASSIGN(HistogramMetric);
+};
+
+// Records the time from its construction to its destruction in nanoseconds in
+// 'histogram', which may be NULL.
+class ScopedLatencyRecorder {
+public:
+    ScopedLatencyRecorder(HistogramMetric* histogram) : _histogram(histogram) {
+        _watch.start();
+    }
+
+    ~ScopedLatencyRecorder() {
+        if (_histogram != NULL) {
+            _histogram->update(_watch.elapsed_time());
+        }
+    }
+
+private:
+    HistogramMetric* _histogram;
+    MonotonicStopWatch _watch;
+};
+
+typedef MetricFamily<HistogramMetric> HistogramFamily;
+
+}
+
+#endif
@@ -0,0 +1,121 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/huge_page_allocator.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+
+#include "common/config.h"
+#include "common/logging.h"
+#include "util/bit_util.h"
+
+namespace palo {
+
+static int64_t round_up_to_huge_page(int64_t size) {
+    return BitUtil::round_up(size, HugePageAllocator::HUGE_PAGE_SIZE);
+}
+
+bool HugePageAllocator::is_mapped(int64_t size) {
+    // Read once, so that an array is freed the way it was allocated.
+    static const int64_t min_bytes = config::hash_table_huge_page_min_bytes;
+    return min_bytes >= 0 && size >= min_bytes && size > 0;
+}
+
+void* HugePageAllocator::map(int64_t size) {
+    int64_t mapped_size = round_up_to_huge_page(size);
+    // Over-map by a huge page and trim, only aligned 2MB ranges can be huge pages.
+    int64_t reserved_size = mapped_size + HUGE_PAGE_SIZE;
+    void* reserved = mmap(NULL, reserved_size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) {
+        LOG(WARNING) << "failed to map " << mapped_size << " bytes: " << strerror(errno);
+        return NULL;
+    }
+    uintptr_t begin = reinterpret_cast<uintptr_t>(reserved);
+    uintptr_t aligned = BitUtil::round_up(begin, HUGE_PAGE_SIZE);
+    if (aligned > begin) {
+        munmap(reserved, aligned - begin);
+    }
+    uintptr_t end = begin + reserved_size;
+    if (end > aligned + mapped_size) {
+        munmap(reinterpret_cast<void*>(aligned + mapped_size), end - aligned - mapped_size);
+    }
+    void* ptr = reinterpret_cast<void*>(aligned);
+    // Fails harmlessly if transparent huge pages are disabled.
+    madvise(ptr, mapped_size, MADV_HUGEPAGE);
+    return ptr;
+}
+
+void HugePageAllocator::unmap(void* ptr, int64_t size) {
+    munmap(ptr, round_up_to_huge_page(size));
+}
+
+void* HugePageAllocator::allocate(int64_t size) {
+    if (is_mapped(size)) {
+        return map(size);
+    }
+    return malloc(size);
+}
+
+void* HugePageAllocator::reallocate(void* ptr, int64_t old_size, int64_t new_size) {
+    if (ptr == NULL) {
+        return allocate(new_size);
+    }
+    bool old_mapped = is_mapped(old_size);
+    bool new_mapped = is_mapped(new_size);
+    if (!old_mapped && !new_mapped) {
+        return realloc(ptr, new_size);
+    }
+    if (old_mapped && new_mapped) {
+        int64_t old_mapped_size = round_up_to_huge_page(old_size);
+        int64_t new_mapped_size = round_up_to_huge_page(new_size);
+        if (old_mapped_size == new_mapped_size) {
+            return ptr;
+        }
+        void* new_ptr = mremap(ptr, old_mapped_size, new_mapped_size, MREMAP_MAYMOVE);
+        if (new_ptr == MAP_FAILED) {
+            LOG(WARNING) << "failed to remap " << old_mapped_size << " to "
+                << new_mapped_size << " bytes: " << strerror(errno);
+            return NULL;
+        }
+        madvise(new_ptr, new_mapped_size, MADV_HUGEPAGE);
+        return new_ptr;
+    }
+    void* new_ptr = allocate(new_size);
+    if (new_ptr == NULL) {
+        return NULL;
+    }
+    memcpy(new_ptr, ptr, std::min(old_size, new_size));
+    free(ptr, old_size);
+    return new_ptr;
+}
+
+void HugePageAllocator::free(void* ptr, int64_t size) {
+    if (ptr == NULL) {
+        return;
+    }
+    if (is_mapped(size)) {
+        unmap(ptr, size);
+    } else {
+        ::free(ptr);
+    }
+}
+
+}
@@ -0,0 +1,52 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_UTIL_HUGE_PAGE_ALLOCATOR_H
+#define BDG_PALO_BE_SRC_UTIL_HUGE_PAGE_ALLOCATOR_H
+
+#include <stdint.h>
+
+namespace palo {
+
+// Allocates the large arrays of hash tables, which are accessed at random, from
+// anonymous mappings advised to be backed by transparent huge pages, so that the
+// accesses miss the TLB less. A mapped array grows with mremap(), which moves its pages
+// instead of copying them. Arrays smaller than config::hash_table_huge_page_min_bytes
+// come from malloc.
+// The size of an array must be passed back to reallocate() and free(), it tells where
+// the array came from. Returns NULL if the memory can't be allocated.
+class HugePageAllocator {
+public:
+    static const int64_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    static void* allocate(int64_t size);
+
+    // Resizes the array at 'ptr' from 'old_size' to 'new_size' bytes, keeping the
+    // content up to the smaller size. The bytes beyond 'old_size' are undefined.
+    static void* reallocate(void* ptr, int64_t old_size, int64_t new_size);
+
+    static void free(void* ptr, int64_t size);
+
+    // Returns true if an array of 'size' bytes is mapped.
+    static bool is_mapped(int64_t size);
+
+private:
+    static void* map(int64_t size);
+    static void unmap(void* ptr, int64_t size);
+};
+
+}
+
+#endif
@@ -0,0 +1,183 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/io_throttle.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "common/config.h"
+#include "common/logging.h"
+
+namespace palo {
+
+using boost::lock_guard;
+using boost::mutex;
+
+static __thread IoClass _s_current_io_class = IO_CLASS_QUERY;
+
+// Budget of a capped class in bytes, refilled at its rate.
+struct IoBudget {
+    mutex lock;
+    int64_t balance;
+    int64_t last_refill_us;
+
+    IoBudget() : balance(0), last_refill_us(-1) { }
+};
+
+static IoBudget _s_budgets[NUM_IO_CLASSES];
+
+static int64_t monotonic_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+// Refills the budget for the time since the last refill. Called with its lock held.
+static void refill(IoBudget* budget, int64_t rate) {
+    int64_t now = monotonic_us();
+    if (budget->last_refill_us < 0) {
+        budget->balance = rate;
+    } else {
+        // The budget holds at most one second of the rate, a longer idle time adds
+        // nothing.
+        int64_t elapsed_us = std::min<int64_t>(now - budget->last_refill_us, 1000000);
+        budget->balance = std::min(rate, budget->balance + elapsed_us * rate / 1000000L);
+    }
+    budget->last_refill_us = now;
+}
+
+const char* io_class_name(IoClass io_class) {
+    switch (io_class) {
+    case IO_CLASS_QUERY:
+        return "query";
+    case IO_CLASS_LOAD:
+        return "load";
+    case IO_CLASS_COMPACTION:
+        return "compaction";
+    case IO_CLASS_CLONE:
+        return "clone";
+    case IO_CLASS_BACKUP:
+        return "backup";
+    default:
+        return "unknown";
+    }
+}
+
+int io_class_share(IoClass io_class) {
+    int share = 1;
+    switch (io_class) {
+    case IO_CLASS_QUERY:
+        share = config::io_share_query;
+        break;
+    case IO_CLASS_LOAD:
+        share = config::io_share_load;
+        break;
+    case IO_CLASS_COMPACTION:
+        share = config::io_share_compaction;
+        break;
+    case IO_CLASS_CLONE:
+        share = config::io_share_clone;
+        break;
+    case IO_CLASS_BACKUP:
+        share = config::io_share_backup;
+        break;
+    default:
+        DCHECK(false) << io_class;
+    }
+    return std::max(share, 1);
+}
+
+int64_t IoThrottle::rate_limit(IoClass io_class) {
+    int64_t mbytes_per_sec = 0;
+    switch (io_class) {
+    case IO_CLASS_QUERY:
+        mbytes_per_sec = config::io_rate_limit_query_mbytes_per_sec;
+        break;
+    case IO_CLASS_LOAD:
+        mbytes_per_sec = config::io_rate_limit_load_mbytes_per_sec;
+        break;
+    case IO_CLASS_COMPACTION:
+        mbytes_per_sec = config::io_rate_limit_compaction_mbytes_per_sec;
+        break;
+    case IO_CLASS_CLONE:
+        mbytes_per_sec = config::io_rate_limit_clone_mbytes_per_sec;
+        break;
+    case IO_CLASS_BACKUP:
+        mbytes_per_sec = config::io_rate_limit_backup_mbytes_per_sec;
+        break;
+    default:
+        DCHECK(false) << io_class;
+    }
+    return std::max<int64_t>(mbytes_per_sec, 0) * 1024 * 1024;
+}
+
+int64_t IoThrottle::wait_time_us(IoClass io_class) {
+    int64_t rate = rate_limit(io_class);
+    if (rate == 0) {
+        return 0;
+    }
+    IoBudget* budget = &_s_budgets[io_class];
+    lock_guard<mutex> l(budget->lock);
+    refill(budget, rate);
+    if (budget->balance >= 0) {
+        return 0;
+    }
+    return -budget->balance * 1000000L / rate + 1;
+}
+
+void IoThrottle::charge(IoClass io_class, int64_t bytes) {
+    int64_t rate = rate_limit(io_class);
+    if (rate == 0) {
+        return;
+    }
+    IoBudget* budget = &_s_budgets[io_class];
+    lock_guard<mutex> l(budget->lock);
+    refill(budget, rate);
+    budget->balance -= bytes;
+}
+
+void IoThrottle::acquire(IoClass io_class, int64_t bytes) {
+    if (rate_limit(io_class) == 0) {
+        return;
+    }
+    while (true) {
+        int64_t wait_us = wait_time_us(io_class);
+        if (wait_us == 0) {
+            break;
+        }
+        usleep(wait_us);
+    }
+    charge(io_class, bytes);
+}
+
+IoClass current_io_class() {
+    return _s_current_io_class;
+}
+
+ScopedIoClass::ScopedIoClass(IoClass io_class) : _prev_io_class(_s_current_io_class) {
+    _s_current_io_class = io_class;
+}
+
+ScopedIoClass::~ScopedIoClass() {
+    _s_current_io_class = _prev_io_class;
+}
+
+}
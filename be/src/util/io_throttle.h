@@ -0,0 +1,79 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_UTIL_IO_THROTTLE_H
+#define BDG_PALO_BE_SRC_UTIL_IO_THROTTLE_H
+
+#include <stdint.h>
+
+namespace palo {
+
+// Classes of disk IO. When they compete for a disk, the DiskIoMgr serves them in
+// proportion to their shares, and each class can be capped to a rate, so that
+// compactions and clones don't wreck the latency of interactive queries.
+enum IoClass {
+    IO_CLASS_QUERY = 0,
+    IO_CLASS_LOAD,
+    IO_CLASS_COMPACTION,
+    IO_CLASS_CLONE,
+    IO_CLASS_BACKUP,
+    NUM_IO_CLASSES
+};
+
+const char* io_class_name(IoClass io_class);
+
+// The share of 'io_class' from config::io_share_*, at least 1.
+int io_class_share(IoClass io_class);
+
+// Backend wide rate caps of the IO classes, from config::io_rate_limit_*_mbytes_per_sec.
+//
+// IO is charged after it was issued, so a class may overdraw its budget by one
+// request. It is then held back until the budget, which refills at the rate of the
+// class and holds at most one second of it, is positive again. Classes without a cap
+// are never held back.
+class IoThrottle {
+public:
+    // Returns 0 if 'io_class' may issue IO now, otherwise the time in microseconds
+    // until it may.
+    static int64_t wait_time_us(IoClass io_class);
+
+    // Charges 'bytes' of issued IO to 'io_class'.
+    static void charge(IoClass io_class, int64_t bytes);
+
+    // Waits until 'io_class' may issue IO and charges 'bytes' to it. Used by blocking
+    // IO that doesn't go through the DiskIoMgr, e.g. the file IO of the storage engine.
+    static void acquire(IoClass io_class, int64_t bytes);
+
+    // Bytes per second, 0 if 'io_class' isn't capped.
+    static int64_t rate_limit(IoClass io_class);
+};
+
+// The IO class that the file IO of the current thread is charged to. IO_CLASS_QUERY
+// unless a ScopedIoClass is active.
+IoClass current_io_class();
+
+// Sets the IO class of the current thread for its lifetime.
+class ScopedIoClass {
+public:
+    explicit ScopedIoClass(IoClass io_class);
+    ~ScopedIoClass();
+
+private:
+    IoClass _prev_io_class;
+};
+
+}
+
+#endif // BDG_PALO_BE_SRC_UTIL_IO_THROTTLE_H
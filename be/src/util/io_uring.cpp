@@ -0,0 +1,258 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/io_uring.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <sstream>
+
+#include "common/logging.h"
+#include "util/error_util.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+// IORING_OP_READ and IORING_OP_WRITE came with this feature flag in Linux 5.6.
+#ifdef IORING_FEAT_RW_CUR_POS
+#define PALO_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+#ifdef PALO_HAVE_IO_URING
+// The numbers are the same on all architectures, old libc headers may lack them.
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#endif
+
+using boost::lock_guard;
+using boost::mutex;
+
+namespace palo {
+
+#ifdef PALO_HAVE_IO_URING
+
+static Status errno_status(const char* call) {
+    std::stringstream ss;
+    ss << call << " failed with errno=" << errno << " description=" << get_str_err_msg();
+    return Status(ss.str());
+}
+
+static uint32_t* ring_field(void* ring, uint32_t offset) {
+    return reinterpret_cast<uint32_t*>(static_cast<char*>(ring) + offset);
+}
+
+#endif
+
+IoUring::IoUring() :
+        _ring_fd(-1),
+        _queue_depth(0),
+        _sq_ring(NULL),
+        _sq_ring_size(0),
+        _cq_ring(NULL),
+        _cq_ring_size(0),
+        _sqes(NULL),
+        _sqes_size(0),
+        _sq_head(NULL),
+        _sq_tail(NULL),
+        _sq_mask(NULL),
+        _sq_array(NULL),
+        _cq_head(NULL),
+        _cq_tail(NULL),
+        _cq_mask(NULL),
+        _cqes(NULL) {
+}
+
+IoUring::~IoUring() {
+    if (_sqes != NULL) {
+        munmap(_sqes, _sqes_size);
+    }
+    if (_cq_ring != NULL) {
+        munmap(_cq_ring, _cq_ring_size);
+    }
+    if (_sq_ring != NULL) {
+        munmap(_sq_ring, _sq_ring_size);
+    }
+    if (_ring_fd >= 0) {
+        close(_ring_fd);
+    }
+}
+
+#ifdef PALO_HAVE_IO_URING
+
+Status IoUring::init(uint32_t queue_depth) {
+    DCHECK_EQ(_ring_fd, -1);
+    DCHECK_GT(queue_depth, 0);
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    _ring_fd = syscall(__NR_io_uring_setup, queue_depth, &params);
+    if (_ring_fd < 0) {
+        return errno_status("io_uring_setup()");
+    }
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+        return Status("io_uring of this kernel doesn't support plain reads and writes");
+    }
+    // The kernel rounds the depth up to a power of two.
+    _queue_depth = params.sq_entries;
+
+    _sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    _sq_ring = mmap(NULL, _sq_ring_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQ_RING);
+    if (_sq_ring == MAP_FAILED) {
+        _sq_ring = NULL;
+        return errno_status("mmap() of the io_uring submission ring");
+    }
+    _cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    _cq_ring = mmap(NULL, _cq_ring_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_CQ_RING);
+    if (_cq_ring == MAP_FAILED) {
+        _cq_ring = NULL;
+        return errno_status("mmap() of the io_uring completion ring");
+    }
+    _sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    _sqes = mmap(NULL, _sqes_size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQES);
+    if (_sqes == MAP_FAILED) {
+        _sqes = NULL;
+        return errno_status("mmap() of the io_uring submission entries");
+    }
+
+    _sq_head = ring_field(_sq_ring, params.sq_off.head);
+    _sq_tail = ring_field(_sq_ring, params.sq_off.tail);
+    _sq_mask = ring_field(_sq_ring, params.sq_off.ring_mask);
+    _sq_array = ring_field(_sq_ring, params.sq_off.array);
+    _cq_head = ring_field(_cq_ring, params.cq_off.head);
+    _cq_tail = ring_field(_cq_ring, params.cq_off.tail);
+    _cq_mask = ring_field(_cq_ring, params.cq_off.ring_mask);
+    _cqes = static_cast<char*>(_cq_ring) + params.cq_off.cqes;
+    return Status::OK;
+}
+
+Status IoUring::submit(uint8_t opcode, int fd, uint64_t addr, uint32_t len,
+                       int64_t offset, void* user_data) {
+    DCHECK_GE(_ring_fd, 0);
+    lock_guard<mutex> l(_submit_lock);
+    uint32_t tail = *_sq_tail;
+    uint32_t head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+    if (tail - head >= _queue_depth) {
+        return Status("io_uring submission queue is full");
+    }
+    uint32_t index = tail & *_sq_mask;
+    struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(_sqes) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = addr;
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = reinterpret_cast<uint64_t>(user_data);
+    _sq_array[index] = index;
+    __atomic_store_n(_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    while (true) {
+        int ret = syscall(__NR_io_uring_enter, _ring_fd, 1, 0, 0, NULL, 0);
+        if (ret >= 0) {
+            return Status::OK;
+        }
+        if (errno != EINTR && errno != EAGAIN) {
+            Status status = errno_status("io_uring_enter()");
+            // Take the entry back unless the kernel consumed it, the caller frees
+            // 'user_data' on error.
+            if (__atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) == tail) {
+                __atomic_store_n(_sq_tail, tail, __ATOMIC_RELEASE);
+            }
+            return status;
+        }
+    }
+}
+
+Status IoUring::submit_read(int fd, void* buf, uint32_t len, int64_t offset,
+                            void* user_data) {
+    return submit(IORING_OP_READ, fd, reinterpret_cast<uint64_t>(buf), len, offset,
+                  user_data);
+}
+
+Status IoUring::submit_write(int fd, const void* buf, uint32_t len, int64_t offset,
+                             void* user_data) {
+    return submit(IORING_OP_WRITE, fd, reinterpret_cast<uint64_t>(buf), len, offset,
+                  user_data);
+}
+
+Status IoUring::submit_nop(void* user_data) {
+    return submit(IORING_OP_NOP, -1, 0, 0, 0, user_data);
+}
+
+Status IoUring::wait_completion(void** user_data, int* result) {
+    DCHECK_GE(_ring_fd, 0);
+    while (true) {
+        uint32_t head = *_cq_head;
+        uint32_t tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+        if (head != tail) {
+            struct io_uring_cqe* cqe =
+                static_cast<struct io_uring_cqe*>(_cqes) + (head & *_cq_mask);
+            *user_data = reinterpret_cast<void*>(cqe->user_data);
+            *result = cqe->res;
+            __atomic_store_n(_cq_head, head + 1, __ATOMIC_RELEASE);
+            return Status::OK;
+        }
+        int ret = syscall(__NR_io_uring_enter, _ring_fd, 0, 1, IORING_ENTER_GETEVENTS,
+                          NULL, 0);
+        if (ret < 0 && errno != EINTR) {
+            return errno_status("io_uring_enter()");
+        }
+    }
+}
+
+#else
+
+Status IoUring::init(uint32_t queue_depth) {
+    return Status("io_uring is not supported by this build");
+}
+
+Status IoUring::submit(uint8_t opcode, int fd, uint64_t addr, uint32_t len,
+                       int64_t offset, void* user_data) {
+    return Status("io_uring is not supported by this build");
+}
+
+Status IoUring::submit_read(int fd, void* buf, uint32_t len, int64_t offset,
+                            void* user_data) {
+    return submit(0, fd, 0, len, offset, user_data);
+}
+
+Status IoUring::submit_write(int fd, const void* buf, uint32_t len, int64_t offset,
+                             void* user_data) {
+    return submit(0, fd, 0, len, offset, user_data);
+}
+
+Status IoUring::submit_nop(void* user_data) {
+    return submit(0, -1, 0, 0, 0, user_data);
+}
+
+Status IoUring::wait_completion(void** user_data, int* result) {
+    return Status("io_uring is not supported by this build");
+}
+
+#endif
+
+}
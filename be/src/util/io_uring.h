@@ -0,0 +1,92 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_UTIL_IO_URING_H
+#define BDG_PALO_BE_SRC_UTIL_IO_URING_H
+
+#include <stdint.h>
+
+#include <boost/thread/mutex.hpp>
+
+#include "common/status.h"
+
+namespace palo {
+
+// A minimal io_uring instance for reads and writes of regular files, driven through
+// the raw system calls so that it needs neither liburing nor a recent glibc.
+//
+// Requests are submitted one at a time from any thread. Completions are reaped by a
+// single thread with wait_completion(), which returns the 'user_data' given at
+// submission together with the result of the operation (bytes transferred or
+// -errno). The caller must not have more requests in flight than the queue depth
+// given to init().
+//
+// init() fails if the backend was built without <linux/io_uring.h> or the kernel
+// doesn't support io_uring (before 5.1, or disabled by seccomp/sysctl), in which case
+// the caller is expected to fall back to blocking IO.
+class IoUring {
+public:
+    IoUring();
+    ~IoUring();
+
+    // Sets up rings with 'queue_depth' submission entries.
+    Status init(uint32_t queue_depth);
+
+    Status submit_read(int fd, void* buf, uint32_t len, int64_t offset, void* user_data);
+
+    Status submit_write(int fd, const void* buf, uint32_t len, int64_t offset,
+                        void* user_data);
+
+    // Submits an operation that completes immediately, to wake up the reaping thread.
+    Status submit_nop(void* user_data);
+
+    // Blocks until the next request completes.
+    Status wait_completion(void** user_data, int* result);
+
+    uint32_t queue_depth() const {
+        return _queue_depth;
+    }
+
+private:
+    Status submit(uint8_t opcode, int fd, uint64_t addr, uint32_t len, int64_t offset,
+                  void* user_data);
+
+    int _ring_fd;
+    uint32_t _queue_depth;
+
+    // Submission and completion rings and the submission entries mapped from the kernel.
+    void* _sq_ring;
+    size_t _sq_ring_size;
+    void* _cq_ring;
+    size_t _cq_ring_size;
+    void* _sqes;
+    size_t _sqes_size;
+
+    uint32_t* _sq_head;
+    uint32_t* _sq_tail;
+    uint32_t* _sq_mask;
+    uint32_t* _sq_array;
+    uint32_t* _cq_head;
+    uint32_t* _cq_tail;
+    uint32_t* _cq_mask;
+    void* _cqes;
+
+    // Serializes submitters, the kernel only sees the tail move.
+    boost::mutex _submit_lock;
+};
+
+}
+
+#endif // BDG_PALO_BE_SRC_UTIL_IO_URING_H
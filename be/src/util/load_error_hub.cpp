@@ -23,10 +23,19 @@
 #include "util/null_load_error_hub.h"
 #include <thrift/protocol/TDebugProtocol.h>
 
+#include <algorithm>
+#include <chrono>
+
+#include "common/config.h"
 #include "gen_cpp/PaloInternalService_types.h"
 
 namespace palo {
 
+// Errors written at once, a batch is also written when it waited FLUSH_INTERVAL_MS
+// for more.
+static const size_t FLUSH_BATCH_SIZE = 50;
+static const int64_t FLUSH_INTERVAL_MS = 1000;
+
 Status LoadErrorHub::create_hub(const TLoadErrorHubInfo* t_hub_info,
                                           std::unique_ptr<LoadErrorHub>* hub) {
     LoadErrorHub* tmp_hub = nullptr;
@@ -60,5 +69,84 @@ Status LoadErrorHub::create_hub(const TLoadErrorHubInfo* t_hub_info,
     return Status::OK;
 }
 
+Status LoadErrorHub::export_error(const ErrorMsg& error_msg) {
+    std::lock_guard<std::mutex> lock(_mtx);
+    ++_total_error_num;
+    if (!_is_valid || _closed) {
+        return Status::OK;
+    }
+
+    int64_t sample_after = config::load_error_hub_sample_after;
+    if (_total_error_num > sample_after) {
+        int64_t rate = config::load_error_hub_sample_rate;
+        if (rate <= 0 || (_total_error_num - sample_after) % rate != 0) {
+            ++_num_sampled_out;
+            return Status::OK;
+        }
+    }
+    size_t buffer_size = std::max(config::load_error_hub_buffer_size, 1);
+    if (_error_msgs.size() >= buffer_size) {
+        ++_num_dropped;
+        return Status::OK;
+    }
+
+    _error_msgs.push_back(error_msg);
+    if (!_flush_thread.joinable()) {
+        _flush_thread = std::thread(&LoadErrorHub::flush_errors, this);
+    }
+    if (_error_msgs.size() >= std::min(FLUSH_BATCH_SIZE, buffer_size)) {
+        _cv.notify_one();
+    }
+    return Status::OK;
+}
+
+void LoadErrorHub::flush_errors() {
+    std::vector<ErrorMsg> batch;
+    std::unique_lock<std::mutex> lock(_mtx);
+    while (true) {
+        if (!_closed && _error_msgs.size() < FLUSH_BATCH_SIZE) {
+            _cv.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS));
+        }
+        if (_error_msgs.empty()) {
+            if (_closed) {
+                return;
+            }
+            continue;
+        }
+        size_t batch_size = std::min(_error_msgs.size(), FLUSH_BATCH_SIZE);
+        batch.assign(_error_msgs.begin(), _error_msgs.begin() + batch_size);
+        _error_msgs.erase(_error_msgs.begin(), _error_msgs.begin() + batch_size);
+
+        lock.unlock();
+        Status status = write_errors(batch);
+        lock.lock();
+        if (!status.ok()) {
+            LOG(WARNING) << "stop exporting load errors. " << status.get_error_msg();
+            _num_dropped += _error_msgs.size();
+            _error_msgs.clear();
+            _write_status = status;
+            _is_valid = false;
+        }
+    }
+}
+
+Status LoadErrorHub::close() {
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _closed = true;
+    }
+    _cv.notify_one();
+    if (_flush_thread.joinable()) {
+        _flush_thread.join();
+    }
+    std::lock_guard<std::mutex> lock(_mtx);
+    return _write_status;
+}
+
+void LoadErrorHub::debug_counters(std::stringstream* out) const {
+    std::lock_guard<std::mutex> lock(_mtx);
+    (*out) << ", sampled_out=" << _num_sampled_out << ", dropped=" << _num_dropped;
+}
+
 } // end namespace palo
 
@@ -21,7 +21,14 @@
 #ifndef BDG_PALO_BE_SRC_UTIL_LOAD_ERROR_HUB_H
 #define BDG_PALO_BE_SRC_UTIL_LOAD_ERROR_HUB_H
 
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "common/status.h"
 
@@ -44,6 +51,8 @@ public:
     LoadErrorHub() {
     }
 
+    // Subclasses must call close() in their destructor, the background thread calls
+    // write_errors() until then.
     virtual ~LoadErrorHub() {
     }
 
@@ -52,18 +61,45 @@ public:
 
     virtual Status prepare() = 0;
 
-    virtual Status export_error(const ErrorMsg& error_msg) = 0;
+    // Buffers 'error_msg', a background thread writes the buffered errors in batches so
+    // that the loading thread never waits for the hub. Only the first
+    // config::load_error_hub_sample_after errors are all kept, 1 in
+    // config::load_error_hub_sample_rate of the later ones, and errors arriving while
+    // config::load_error_hub_buffer_size of them wait to be written are dropped.
+    Status export_error(const ErrorMsg& error_msg);
 
-    virtual Status close() = 0;
+    // Writes the buffered errors and stops the background thread. Returns the first
+    // error of a write, after which the hub stopped exporting.
+    Status close();
 
     virtual std::string debug_string() const = 0;
 
 protected:
-    // to show mysql url is valid
+    // Writes a batch of errors, called by one thread at a time.
+    virtual Status write_errors(const std::vector<ErrorMsg>& error_msgs) = 0;
+
+    // Appends the counters of the errors that were not written to 'out'.
+    void debug_counters(std::stringstream* out) const;
+
+    // to show mysql url is valid, errors are only buffered while it is set
     bool _is_valid = false;
 
     int32_t _total_error_num = 0;
 
+private:
+    void flush_errors();
+
+    // Protects everything above and below except '_flush_thread'.
+    mutable std::mutex _mtx;
+    std::condition_variable _cv;
+    std::deque<ErrorMsg> _error_msgs;
+    bool _closed = false;
+    // Errors left out by sampling or dropped for a full buffer.
+    int64_t _num_sampled_out = 0;
+    int64_t _num_dropped = 0;
+    Status _write_status;
+    std::thread _flush_thread;
+
 }; // end class LoadErrorHub
 
 } // end namespace palo
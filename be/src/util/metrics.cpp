@@ -19,6 +19,7 @@
 // under the License.
 
 #include "util/metrics.h"
+#include <algorithm>
 #include <sstream>
 #include <memory>
 #include <functional>
@@ -277,6 +278,37 @@ std::string MetricGroup::debug_string_json() {
     return ss.str();
 }
 
+static std::string prometheus_name(const std::string& key) {
+    std::string name = key;
+    for (char& c : name) {
+        if (!isalnum(c) && c != '_') {
+            c = '_';
+        }
+    }
+    return name;
+}
+
+void MetricGroup::print_prometheus(std::stringstream* output) {
+    std::lock_guard<SpinLock> l(_lock);
+    for (const MetricMap::value_type& m : _metric_map) {
+        const char* type = m.second->prometheus_type();
+        if (type == NULL) {
+            continue;
+        }
+        std::string name = prometheus_name(m.first);
+        if (!m.second->description().empty()) {
+            std::string help = m.second->description();
+            std::replace(help.begin(), help.end(), '\n', ' ');
+            (*output) << "# HELP " << name << " " << help << "\n";
+        }
+        (*output) << "# TYPE " << name << " " << type << "\n";
+        m.second->print_prometheus(name, "", output);
+    }
+    for (const ChildGroupMap::value_type& child : _children) {
+        child.second->print_prometheus(output);
+    }
+}
+
 void MetricGroup::text_callback(const WebPageHandler::ArgumentMap& args, std::stringstream* output) {
     (*output) << "<pre>";
     print_metric_map(output);
@@ -27,6 +27,7 @@
 #include <stack>
 #include <string>
 #include <sstream>
+#include <type_traits>
 
 #include <boost/scoped_ptr.hpp>
 #include <rapidjson/document.h>
@@ -128,6 +129,18 @@ public:
         print_value_json(out);
     }
 
+    // The type of this metric in the Prometheus text format, e.g. "counter" or
+    // "histogram". NULL if the metric is not exported to Prometheus.
+    virtual const char* prometheus_type() {
+        return NULL;
+    }
+
+    // Writes the samples of this metric in the Prometheus text format to 'out', named
+    // 'name' and with the extra 'labels' ("" or 'key="value"' pairs separated by ',').
+    virtual void print_prometheus(const std::string& name, const std::string& labels,
+                                  std::stringstream* out) {
+    }
+
 protected:
     // Subclasses are required to implement this to print a string
     // representation of the metric to the supplied stringstream.
@@ -173,7 +186,7 @@ protected:
 template<typename T, TMetricKind::type metric_kind=TMetricKind::GAUGE>
 class SimpleMetric : public Metric {
 public:
-    SimpleMetric(const TMetricDef& metric_def, const T& initial_value)
+    SimpleMetric(const TMetricDef& metric_def, const T& initial_value = T())
         : Metric(metric_def), _unit(metric_def.units), _value(initial_value) {
             DCHECK_EQ(metric_kind, metric_def.kind) << "Metric kind does not match definition: "
                 << metric_def.key;
@@ -241,6 +254,26 @@ public:
     TUnit::type unit() const { return _unit; }
     TMetricKind::type kind() const { return metric_kind; }
 
+    // Only numeric and boolean metrics are exported, properties as gauges
+    virtual const char* prometheus_type() {
+        if (!std::is_arithmetic<T>::value) {
+            return NULL;
+        }
+        return metric_kind == TMetricKind::COUNTER ? "counter" : "gauge";
+    }
+
+    virtual void print_prometheus(const std::string& name, const std::string& labels,
+                                  std::stringstream* out) {
+        if (!std::is_arithmetic<T>::value) {
+            return;
+        }
+        (*out) << name;
+        if (!labels.empty()) {
+            (*out) << "{" << labels << "}";
+        }
+        (*out) << " " << value() << "\n";
+    }
+
 protected:
     /// Called to compute value_ if necessary during calls to value(). The more natural
     /// approach would be to have virtual T value(), but that's not possible in C++.
@@ -287,6 +320,167 @@ private:
     std::vector<SimpleMetric<T, TMetricKind::GAUGE>*> _metrics;
 };
 
+/// A family of metrics sharing one definition whose values are told apart by the value
+/// of a label, e.g. the latency of every rpc method. They are exported to Prometheus as
+/// one metric with a sample per label value, and printed as "key{label=value}" in the
+/// other formats. Children are created on first use by constructing an 'M' from the
+/// definition. To keep a label of unbounded values (e.g. tablet ids) from growing the
+/// family without bound, all values beyond the first 'max_children' share one child
+/// labeled "other".
+template <typename M>
+class MetricFamily : public Metric {
+public:
+    MetricFamily(const TMetricDef& def, const std::string& label, int max_children)
+        : Metric(def), _def(def), _label(label), _max_children(max_children),
+          _other(NULL) { }
+
+    virtual ~MetricFamily() {
+        for (auto& it : _children) {
+            delete it.second;
+        }
+        delete _other;
+    }
+
+    /// Returns the child for 'label_value', creating it if needed. The children are
+    /// never removed, callers on hot paths should cache the result.
+    M* get(const std::string& label_value) {
+        std::lock_guard<std::mutex> l(_lock);
+        auto it = _children.find(label_value);
+        if (it != _children.end()) {
+            return it->second;
+        }
+        if (_children.size() >= _max_children) {
+            if (_other == NULL) {
+                _other = new M(_def);
+            }
+            return _other;
+        }
+        M* child = new M(_def);
+        _children[label_value] = child;
+        return child;
+    }
+
+    virtual void ToJson(rapidjson::Document* document, rapidjson::Value* val) {
+        rapidjson::Value container(rapidjson::kObjectType);
+        AddStandardFields(document, &container);
+        rapidjson::Value children(rapidjson::kArrayType);
+        std::lock_guard<std::mutex> l(_lock);
+        for (auto& it : _children) {
+            rapidjson::Value child;
+            it.second->ToJson(document, &child);
+            children.PushBack(child, document->GetAllocator());
+        }
+        container.AddMember("children", children, document->GetAllocator());
+        *val = container;
+    }
+
+    virtual void ToLegacyJson(rapidjson::Document* document) {
+        std::lock_guard<std::mutex> l(_lock);
+        for (auto& it : _children) {
+            it.second->ToLegacyJson(document);
+        }
+    }
+
+    virtual std::string ToHumanReadable() {
+        std::lock_guard<std::mutex> l(_lock);
+        std::stringstream ss;
+        print_value(&ss);
+        return ss.str();
+    }
+
+    // One line per child
+    virtual void print(std::stringstream* out) {
+        std::lock_guard<std::mutex> l(_lock);
+        bool first = true;
+        for_each_child([this, &first, out] (const std::string& value, M* child) {
+            (*out) << (first ? "" : "\n") << _key << "{" << _label << "=" << value << "}:"
+                << child->ToHumanReadable();
+            first = false;
+        });
+    }
+
+    virtual void print_json(std::stringstream* out) {
+        std::lock_guard<std::mutex> l(_lock);
+        (*out) << "\"" << _key << "\": ";
+        print_value_json(out);
+    }
+
+    // NULL until the first child is created, there is nothing to export before
+    virtual const char* prometheus_type() {
+        std::lock_guard<std::mutex> l(_lock);
+        if (!_children.empty()) {
+            return _children.begin()->second->prometheus_type();
+        }
+        return _other != NULL ? _other->prometheus_type() : NULL;
+    }
+
+    virtual void print_prometheus(const std::string& name, const std::string& labels,
+                                  std::stringstream* out) {
+        std::lock_guard<std::mutex> l(_lock);
+        for_each_child([this, &name, &labels, out] (const std::string& value, M* child) {
+            std::stringstream child_labels;
+            if (!labels.empty()) {
+                child_labels << labels << ",";
+            }
+            child_labels << _label << "=\"";
+            for (char c : value) {
+                if (c == '\\' || c == '"') {
+                    child_labels << '\\' << c;
+                } else if (c == '\n') {
+                    child_labels << "\\n";
+                } else {
+                    child_labels << c;
+                }
+            }
+            child_labels << "\"";
+            child->print_prometheus(name, child_labels.str(), out);
+        });
+    }
+
+protected:
+    virtual void print_value(std::stringstream* out) {
+        bool first = true;
+        for_each_child([&first, out] (const std::string& value, M* child) {
+            (*out) << (first ? "" : ", ") << value << ": " << child->ToHumanReadable();
+            first = false;
+        });
+    }
+
+    virtual void print_value_json(std::stringstream* out) {
+        (*out) << "{";
+        bool first = true;
+        for_each_child([&first, out] (const std::string& value, M* child) {
+            (*out) << (first ? "" : ", ") << "\"" << value << "\": ";
+            std::stringstream ss;
+            child->print_json(&ss);
+            // strip the key of the child
+            std::string child_json = ss.str();
+            (*out) << child_json.substr(child_json.find(": ") + 2);
+            first = false;
+        });
+        (*out) << "}";
+    }
+
+private:
+    // Called with _lock taken
+    template <typename F>
+    void for_each_child(const F& f) {
+        for (auto& it : _children) {
+            f(it.first, it.second);
+        }
+        if (_other != NULL) {
+            f("other", _other);
+        }
+    }
+
+    const TMetricDef _def;
+    const std::string _label;
+    const size_t _max_children;
+    std::map<std::string, M*> _children;
+    // the child shared by the values beyond _max_children
+    M* _other;
+};
+
 /// Container for a set of metrics. A MetricGroup owns the memory for every metric
 /// contained within it (see Add*() to create commonly used metric
 /// types). Metrics are 'registered' with a MetricGroup, once registered they cannot be
@@ -399,6 +593,11 @@ public:
     // Same as above, but for Json output
     std::string debug_string_json();
 
+    // Writes all metrics of this group and its children that have a Prometheus type in
+    // the Prometheus text exposition format. The keys are turned into metric names by
+    // replacing all characters but letters, digits and '_' with '_'.
+    void print_prometheus(std::stringstream* out);
+
     const std::string& name() const { return _name; }
 
 private:
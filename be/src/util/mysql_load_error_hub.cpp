@@ -28,6 +28,7 @@ MysqlLoadErrorHub::MysqlLoadErrorHub(const TMysqlErrorHubInfo& info) : _info(inf
 }
 
 MysqlLoadErrorHub::~MysqlLoadErrorHub() {
+    close();
 }
 
 Status MysqlLoadErrorHub::prepare() {
@@ -35,54 +36,19 @@ Status MysqlLoadErrorHub::prepare() {
     return Status::OK;
 }
 
-Status MysqlLoadErrorHub::export_error(const ErrorMsg& error_msg) {
-    std::lock_guard<std::mutex> lock(_mtx);
-    ++_total_error_num;
-
-    if (!_is_valid) {
-        return Status::OK;
-    }
-
-    _error_msgs.push(error_msg);
-    if (_error_msgs.size() >= EXPORTER_THRESHOLD) {
-        RETURN_IF_ERROR(write_mysql());
-    }
-
-    return Status::OK;
-}
-
-Status MysqlLoadErrorHub::close() {
-    std::lock_guard<std::mutex> lock(_mtx);
-
-    if (!_is_valid) {
-        return Status::OK;
-    }
-
-    if (!_error_msgs.empty()) {
-        RETURN_IF_ERROR(write_mysql());
-    }
-
-    return Status::OK;
-}
-
-Status MysqlLoadErrorHub::write_mysql() {
+Status MysqlLoadErrorHub::write_errors(const std::vector<ErrorMsg>& error_msgs) {
     MYSQL* my_conn = nullptr;
-    Status st = open_mysql_conn(&my_conn);
-    if (!st.ok()) {
-        _is_valid = false;
-        return st;
-    }
+    RETURN_IF_ERROR(open_mysql_conn(&my_conn));
 
     DeferOp close_mysql_conn(std::bind<void>(&mysql_close, my_conn));
 
     Status status;
     std::stringstream sql_stream;
-    while (!_error_msgs.empty()) {
-        status = gen_sql(my_conn, _error_msgs.front(), &sql_stream);
+    for (const ErrorMsg& error_msg : error_msgs) {
+        status = gen_sql(my_conn, error_msg, &sql_stream);
         if (!status.ok()) {
             return error_status("fail to gen sql", my_conn);
         }
-        _error_msgs.pop();
     }
 
     int sql_result = mysql_query(my_conn, sql_stream.str().c_str());
@@ -145,7 +111,9 @@ Status MysqlLoadErrorHub::error_status(const std::string& prefix, MYSQL* my_conn
 
 std::string MysqlLoadErrorHub::debug_string() const {
     std::stringstream out;
-    out << "(tatal_error_num=" << _total_error_num << ")";
+    out << "(tatal_error_num=" << _total_error_num;
+    debug_counters(&out);
+    out << ")";
     return out.str();
 }
 
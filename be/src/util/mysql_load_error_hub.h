@@ -21,10 +21,10 @@
 #ifndef BDG_PALO_BE_SRC_UTIL_MYSQL_LOAD_ERROR_HUB_H
 #define BDG_PALO_BE_SRC_UTIL_MYSQL_LOAD_ERROR_HUB_H
 
+#include <array>
 #include <sstream>
 #include <string>
-#include <mutex>
-#include <queue>
+#include <vector>
 
 #include <mysql/mysql.h>
 
@@ -36,6 +36,7 @@ namespace palo {
 // For now every load job has its own mysql connection,
 // and we use short connection to avoid to many connections.
 // we write to mysql in a batch of data, not every data error msg,
+// from the background thread of LoadErrorHub.
 
 class MysqlLoadErrorHub : public LoadErrorHub {
 public:
@@ -65,17 +66,14 @@ public:
 
     virtual Status prepare();
 
-    virtual Status export_error(const ErrorMsg& error_msg);
-
-    virtual Status close();
-
     virtual std::string debug_string() const;
 
+protected:
+    virtual Status write_errors(const std::vector<ErrorMsg>& error_msgs);
+
 private:
     Status open_mysql_conn(MYSQL** my_conn);
 
-    Status write_mysql();
-
     Status gen_sql(MYSQL* my_conn,
                    const LoadErrorHub::ErrorMsg& error_msg,
                    std::stringstream* sql_stream);
@@ -84,17 +82,9 @@ private:
 
     MysqlInfo _info;
 
-    // the number in a write batch.
-    static const int32_t EXPORTER_THRESHOLD = 10;
-    static const int32_t EXPORTER_MAX_ERROR_NUM = 50;
-
     // the max size of one line
     static const int32_t EXPORTER_MAX_LINE_SIZE = 500;
 
-    std::mutex _mtx;
-    std::queue<ErrorMsg> _error_msgs;
-    int32_t _total_error_num = 0;
-
     // should at least (line_length * 2 + 1) long
     std::array<char, 2 * EXPORTER_MAX_LINE_SIZE + 1> _escape_buff;
 
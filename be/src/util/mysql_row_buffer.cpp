@@ -20,8 +20,12 @@
 
 #include "util/mysql_row_buffer.h"
 
+#include <float.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <cmath>
 
 #include "common/logging.h"
 #include "util/mysql_dtoa.h"
@@ -58,6 +62,325 @@ static char* pack_vlen(char* packet, uint64_t length) {
     int8store(packet, length);
     return packet + 8;
 }
+
+// Two ASCII digits for each number in [0, 100).
+static const char DIGIT_PAIRS[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Writes the decimal digits of 'value' to 'to', returns the end of the written digits.
+static char* write_unsigned(uint64_t value, char* to) {
+    char tmp[MAX_BIGINT_WIDTH];
+    char* p = tmp + sizeof(tmp);
+
+    while (value >= 100) {
+        int idx = (value % 100) * 2;
+        value /= 100;
+        p -= 2;
+        p[0] = DIGIT_PAIRS[idx];
+        p[1] = DIGIT_PAIRS[idx + 1];
+    }
+
+    if (value >= 10) {
+        p -= 2;
+        p[0] = DIGIT_PAIRS[value * 2];
+        p[1] = DIGIT_PAIRS[value * 2 + 1];
+    } else {
+        *--p = '0' + value;
+    }
+
+    int length = tmp + sizeof(tmp) - p;
+    memcpy(to, p, length);
+    return to + length;
+}
+
+static char* write_signed(int64_t value, char* to) {
+    uint64_t abs_value = value;
+
+    if (value < 0) {
+        *to++ = '-';
+        abs_value = 0 - abs_value;
+    }
+
+    return write_unsigned(abs_value, to);
+}
+
+// Exactly representable powers of ten.
+static const double EXACT_POW10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+static const int MAX_EXACT_POW10 = sizeof(EXACT_POW10) / sizeof(EXACT_POW10[0]) - 1;
+
+// Largest integer below which all integers are doubles.
+static const double MAX_EXACT_INT_DOUBLE = 9007199254740992.0;
+
+// Sets 'digits' and '*decpt' to the shortest decimal digits that read back as 'value',
+// which is positive, and the position of the decimal point, like dtoa() in mode 0.
+// Only handles values with up to 22 decimal places that are exact in the 53 bit
+// mantissa after scaling, and returns the number of digits or -1 otherwise.
+static int shortest_double_digits(double value, char* digits, int* decpt) {
+    for (int k = 0; k <= MAX_EXACT_POW10; ++k) {
+        double scaled = value * EXACT_POW10[k];
+
+        if (scaled >= MAX_EXACT_INT_DOUBLE) {
+            return -1;
+        }
+
+        // 'scaled' is off by less than one, so the shortest digits with k decimal
+        // places, if any, are one of the neighbours of the rounded value.
+        uint64_t rounded = static_cast<uint64_t>(scaled + 0.5);
+        uint64_t found = 0;
+        int num_found = 0;
+
+        for (uint64_t cand = (rounded > 0 ? rounded - 1 : 0); cand <= rounded + 1; ++cand) {
+            if (cand > 0 && static_cast<double>(cand) / EXACT_POW10[k] == value) {
+                found = cand;
+                ++num_found;
+            }
+        }
+
+        if (num_found > 1) {
+            // dtoa() takes the closest one, leave the tie to it
+            return -1;
+        }
+
+        if (num_found == 1) {
+            char* end = write_unsigned(found, digits);
+            int length = end - digits;
+            *decpt = length - k;
+
+            while (digits[length - 1] == '0') {
+                --length;
+            }
+
+            return length;
+        }
+    }
+
+    return -1;
+}
+
+// Sets 'digits' and '*decpt' to 'value', which is positive, rounded to FLT_DIG
+// significant digits, like dtoa() in mode 4 does for floats. Returns the number of
+// digits with trailing zeros removed, or -1 if the value is out of the handled range
+// or too close to a tie to round here.
+static int float_digits(double value, char* digits, int* decpt) {
+    static const double LOWER = EXACT_POW10[FLT_DIG - 1];
+    static const double UPPER = EXACT_POW10[FLT_DIG];
+
+    int k = FLT_DIG - 1 - static_cast<int>(floor(log10(value)));
+
+    for (int i = 0; i < 2; ++i) {
+        if (k < -MAX_EXACT_POW10 || k > MAX_EXACT_POW10) {
+            return -1;
+        }
+
+        double scaled = k >= 0 ? value * EXACT_POW10[k] : value / EXACT_POW10[-k];
+
+        if (scaled >= UPPER) {
+            --k;
+            continue;
+        }
+
+        if (scaled < LOWER) {
+            ++k;
+            continue;
+        }
+
+        double fraction = scaled - floor(scaled);
+
+        if (fabs(fraction - 0.5) < 1e-7) {
+            return -1;
+        }
+
+        uint64_t rounded = static_cast<uint64_t>(scaled + 0.5);
+
+        if (rounded >= UPPER) {
+            // rounded up to the next power of ten
+            rounded /= 10;
+            --k;
+        }
+
+        write_unsigned(rounded, digits);
+        *decpt = FLT_DIG - k;
+
+        int length = FLT_DIG;
+
+        while (digits[length - 1] == '0') {
+            --length;
+        }
+
+        return length;
+    }
+
+    return -1;
+}
+
+// Lays out 'len' significant digits with the decimal point at 'decpt' the way my_gcvt()
+// does for a field of 'width' characters, returns the length written to 'to' or -1 if
+// my_gcvt() would have to round the digits to fit, which is left to it.
+static int format_gcvt_digits(const char* digits, int len, int decpt, bool negative,
+                              int width, char* to) {
+    char* dst = to;
+
+    if (negative) {
+        width--;
+    }
+
+    int exp_len = 1 + (decpt >= 101 || decpt <= -99) + (decpt >= 11 || decpt <= -9);
+    bool have_space = (decpt <= 0 ? len - decpt + 2 :
+                       decpt < len ? len + 1 : decpt) <= width;
+    bool force_e_format = (decpt <= 0 && width <= 2 - decpt && width >= 3 + exp_len);
+
+    if ((have_space
+            || ((decpt <= width && (decpt >= -1 || (decpt == -2
+                        && (len > 1 || !force_e_format))))
+                && !force_e_format))
+            && (!have_space || (decpt >= -MAX_DECPT_FOR_F_FORMAT + 1
+                    && (decpt <= MAX_DECPT_FOR_F_FORMAT || len > decpt)))) {
+        // 'f' format
+        if (width - (decpt < len) - (decpt <= 0 ? 1 - decpt : 0) < len) {
+            return -1;
+        }
+
+        if (negative) {
+            *dst++ = '-';
+        }
+
+        if (decpt <= 0) {
+            *dst++ = '0';
+            *dst++ = '.';
+
+            for (int i = decpt; i < 0; ++i) {
+                *dst++ = '0';
+            }
+
+            memcpy(dst, digits, len);
+            dst += len;
+        } else if (decpt < len) {
+            memcpy(dst, digits, decpt);
+            dst += decpt;
+            *dst++ = '.';
+            memcpy(dst, digits + decpt, len - decpt);
+            dst += len - decpt;
+        } else {
+            memcpy(dst, digits, len);
+            dst += len;
+            memset(dst, '0', decpt - len);
+            dst += decpt - len;
+        }
+    } else {
+        // 'e' format
+        int exponent = decpt - 1;
+        bool exponent_negative = exponent < 0;
+
+        if (exponent_negative) {
+            exponent = -exponent;
+            width--;
+        }
+
+        width -= 1 + exp_len + (len > 1);
+
+        if (width < len) {
+            return -1;
+        }
+
+        if (negative) {
+            *dst++ = '-';
+        }
+
+        *dst++ = digits[0];
+
+        if (len > 1) {
+            *dst++ = '.';
+            memcpy(dst, digits + 1, len - 1);
+            dst += len - 1;
+        }
+
+        *dst++ = 'e';
+
+        if (exponent_negative) {
+            *dst++ = '-';
+        }
+
+        if (exponent >= 100) {
+            *dst++ = '0' + exponent / 100;
+            exponent %= 100;
+            *dst++ = '0' + exponent / 10;
+        } else if (exponent >= 10) {
+            *dst++ = '0' + exponent / 10;
+        }
+
+        *dst++ = '0' + exponent % 10;
+    }
+
+    *dst = '\0';
+    return dst - to;
+}
+
+// Same output as my_gcvt(value, MY_GCVT_ARG_DOUBLE, width, to, NULL) where the digits
+// can be found without big number arithmetic, which covers the common values in
+// query results; falls back to my_gcvt() for the rest.
+static int double_to_text(double value, int width, char* to) {
+    if (value == 0 && !std::signbit(value)) {
+        to[0] = '0';
+        to[1] = '\0';
+        return 1;
+    }
+
+    if (value != 0 && !std::isinf(value) && !std::isnan(value)) {
+        char digits[MAX_BIGINT_WIDTH];
+        int decpt = 0;
+        bool negative = value < 0;
+        int len = shortest_double_digits(fabs(value), digits, &decpt);
+
+        if (len > 0) {
+            int length = format_gcvt_digits(digits, len, decpt, negative, width, to);
+
+            if (length >= 0) {
+                return length;
+            }
+        }
+    }
+
+    return my_gcvt(value, MY_GCVT_ARG_DOUBLE, width, to, NULL);
+}
+
+// Same as double_to_text() for floats, which my_gcvt() rounds to FLT_DIG digits.
+static int float_to_text(float value, int width, char* to) {
+    if (value == 0 && !std::signbit(value)) {
+        to[0] = '0';
+        to[1] = '\0';
+        return 1;
+    }
+
+    if (value != 0 && !std::isinf(value) && !std::isnan(value)) {
+        char digits[MAX_BIGINT_WIDTH];
+        int decpt = 0;
+        bool negative = value < 0;
+        int len = float_digits(fabs(static_cast<double>(value)), digits, &decpt);
+
+        if (len > 0) {
+            int length = format_gcvt_digits(digits, len, decpt, negative, width, to);
+
+            if (length >= 0) {
+                return length;
+            }
+        }
+    }
+
+    return my_gcvt(value, MY_GCVT_ARG_FLOAT, width, to, NULL);
+}
+
 MysqlRowBuffer::MysqlRowBuffer():
     _pos(_default_buf),
     _buf(_default_buf),
@@ -112,15 +435,10 @@ int MysqlRowBuffer::push_tinyint(int8_t data) {
         return ret;
     }
 
-    int length = snprintf(_pos + 1, MAX_TINYINT_WIDTH + 2, "%d", data);
-
-    if (length < 0) {
-        LOG(ERROR) << "snprintf failed. data = " << data;
-        return length;
-    }
-
-    int1store(_pos, length);
-    _pos += length + 1;
+    char* end = write_signed(data, _pos + 1);
+    *end = '\0';
+    int1store(_pos, end - _pos - 1);
+    _pos = end;
     return 0;
 }
 
@@ -133,15 +451,10 @@ int MysqlRowBuffer::push_smallint(int16_t data) {
         return ret;
     }
 
-    int length = snprintf(_pos + 1, MAX_SMALLINT_WIDTH + 2, "%d", data);
-
-    if (length < 0) {
-        LOG(ERROR) << "snprintf failed. data = " << data;
-        return length;
-    }
-
-    int1store(_pos, length);
-    _pos += length + 1;
+    char* end = write_signed(data, _pos + 1);
+    *end = '\0';
+    int1store(_pos, end - _pos - 1);
+    _pos = end;
     return 0;
 }
 
@@ -154,15 +467,10 @@ int MysqlRowBuffer::push_int(int32_t data) {
         return ret;
     }
 
-    int length = snprintf(_pos + 1, MAX_INT_WIDTH + 2, "%d", data);
-
-    if (length < 0) {
-        LOG(ERROR) << "snprintf failed. data = " << data;
-        return length;
-    }
-
-    int1store(_pos, length);
-    _pos += length + 1;
+    char* end = write_signed(data, _pos + 1);
+    *end = '\0';
+    int1store(_pos, end - _pos - 1);
+    _pos = end;
     return 0;
 }
 
@@ -175,15 +483,10 @@ int MysqlRowBuffer::push_bigint(int64_t data) {
         return ret;
     }
 
-    int length = snprintf(_pos + 1, MAX_BIGINT_WIDTH + 2, "%ld", data);
-
-    if (length < 0) {
-        LOG(ERROR) << "snprintf failed. data = " << data;
-        return length;
-    }
-
-    int1store(_pos, length);
-    _pos += length + 1;
+    char* end = write_signed(data, _pos + 1);
+    *end = '\0';
+    int1store(_pos, end - _pos - 1);
+    _pos = end;
     return 0;
 }
 
@@ -196,15 +499,10 @@ int MysqlRowBuffer::push_unsigned_bigint(uint64_t data) {
         return ret;
     }
 
-    int length = snprintf(_pos + 1, MAX_BIGINT_WIDTH + 3, "%ld", data);
-
-    if (length < 0) {
-        LOG(ERROR) << "snprintf failed. data = " << data;
-        return length;
-    }
-
-    int1store(_pos, length);
-    _pos += length + 1;
+    char* end = write_unsigned(data, _pos + 1);
+    *end = '\0';
+    int1store(_pos, end - _pos - 1);
+    _pos = end;
     return 0;
 }
 
@@ -217,7 +515,7 @@ int MysqlRowBuffer::push_float(float data) {
         return ret;
     }
 
-    int length = my_gcvt(data, MY_GCVT_ARG_FLOAT, MAX_FLOAT_STR_LENGTH + 2, _pos + 1, NULL);
+    int length = float_to_text(data, MAX_FLOAT_STR_LENGTH + 2, _pos + 1);
 
     if (length < 0) {
         LOG(ERROR) << "gcvt float failed. data = " << data;
@@ -238,7 +536,7 @@ int MysqlRowBuffer::push_double(double data) {
         return ret;
     }
 
-    int length = my_gcvt(data, MY_GCVT_ARG_DOUBLE, MAX_DOUBLE_STR_LENGTH + 2, _pos + 1, NULL);
+    int length = double_to_text(data, MAX_DOUBLE_STR_LENGTH + 2, _pos + 1);
 
     if (length < 0) {
         LOG(ERROR) << "gcvt double failed. data = " << data;
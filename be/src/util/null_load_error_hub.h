@@ -23,10 +23,7 @@
 
 #include <sstream>
 #include <string>
-#include <mutex>
-#include <queue>
-
-#include <mysql/mysql.h>
+#include <vector>
 
 #include "load_error_hub.h"
 
@@ -43,15 +40,10 @@ public:
 
     virtual Status prepare();
 
-    virtual Status export_error(const ErrorMsg& error_msg);
-
-    virtual Status close();
-
     virtual std::string debug_string() const;
 
-private:
-    std::mutex _mtx;
-    std::queue<ErrorMsg> _error_msgs;
+protected:
+    virtual Status write_errors(const std::vector<ErrorMsg>& error_msgs);
 
 }; // end class NullLoadErrorHub
 
@@ -0,0 +1,114 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "util/numa_info.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+#include <fstream>
+#include <sstream>
+
+#include <boost/algorithm/string.hpp>
+
+#include "common/config.h"
+
+namespace palo {
+
+bool NumaInfo::_s_initialized = false;
+std::vector<std::vector<int> > NumaInfo::_s_node_cpus;
+
+// Parses a cpu list like "0-5,12-17".
+static std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    std::vector<std::string> ranges;
+    boost::split(ranges, list, boost::is_any_of(","), boost::token_compress_on);
+    for (int i = 0; i < ranges.size(); ++i) {
+        int first = -1;
+        int last = -1;
+        if (sscanf(ranges[i].c_str(), "%d-%d", &first, &last) == 1) {
+            last = first;
+        }
+        for (int cpu = first; first >= 0 && cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+void NumaInfo::init() {
+    _s_node_cpus.clear();
+    for (int node = 0; ; ++node) {
+        std::stringstream path;
+        path << "/sys/devices/system/node/node" << node << "/cpulist";
+        std::ifstream cpulist(path.str().c_str());
+        std::string line;
+        if (!cpulist.good() || !std::getline(cpulist, line)) {
+            break;
+        }
+        boost::trim(line);
+        _s_node_cpus.push_back(parse_cpu_list(line));
+    }
+    if (_s_node_cpus.empty()) {
+        // no NUMA support, all cpus are on one node
+        _s_node_cpus.resize(1);
+    }
+    _s_initialized = true;
+}
+
+bool NumaInfo::enabled() {
+    return config::enable_numa_affinity && _s_initialized && _s_node_cpus.size() > 1;
+}
+
+int NumaInfo::node_of_device(const std::string& device_name) {
+    std::ifstream numa_node(("/sys/block/" + device_name + "/device/numa_node").c_str());
+    int node = -1;
+    if (!(numa_node >> node) || node >= num_nodes()) {
+        return -1;
+    }
+    return node;
+}
+
+bool NumaInfo::bind_current_thread(int node) {
+    if (node < 0 || node >= num_nodes() || _s_node_cpus[node].empty()) {
+        return false;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int i = 0; i < _s_node_cpus[node].size(); ++i) {
+        CPU_SET(_s_node_cpus[node][i], &cpu_set);
+    }
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    if (ret != 0) {
+        LOG(WARNING) << "failed to bind thread to numa node " << node << ", errno=" << ret;
+        return false;
+    }
+    return true;
+}
+
+std::string NumaInfo::debug_string() {
+    std::stringstream stream;
+    stream << "Numa Info: " << std::endl;
+    stream << "  Num nodes: " << _s_node_cpus.size() << std::endl;
+    for (int node = 0; node < _s_node_cpus.size(); ++node) {
+        stream << "  Node " << node << ": " << _s_node_cpus[node].size() << " cpus"
+            << std::endl;
+    }
+    return stream.str();
+}
+
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef BDG_PALO_BE_SRC_UTIL_NUMA_INFO_H
+#define BDG_PALO_BE_SRC_UTIL_NUMA_INFO_H
+
+#include <string>
+#include <vector>
+
+#include "common/logging.h"
+
+namespace palo {
+
+// NumaInfo is an interface to query for the NUMA nodes of the machine at runtime.
+// This information is pulled from /sys/devices/system/node. Without NUMA support
+// the machine has a single node.
+class NumaInfo {
+public:
+    // Initialize NumaInfo.  Must be called before any other functions.
+    static void init();
+
+    // Returns the number of NUMA nodes, at least 1.
+    static int num_nodes() {
+        DCHECK(_s_initialized);
+        return _s_node_cpus.size();
+    }
+
+    // Returns true if config::enable_numa_affinity is set and the machine has more
+    // than one node.
+    static bool enabled();
+
+    // Returns the node of the controller of 'device_name' (e.g. sda), -1 if unknown.
+    static int node_of_device(const std::string& device_name);
+
+    // Restricts the current thread to the cpus of 'node'. Memory the thread touches
+    // first is then allocated on the node as well.
+    static bool bind_current_thread(int node);
+
+    static std::string debug_string();
+
+private:
+    static bool _s_initialized;
+    // The cpus of each node.
+    static std::vector<std::vector<int> > _s_node_cpus;
+};
+
+}
+
+#endif
@@ -20,7 +20,9 @@
 
 #include "util/palo_metrics.h"
 
+#include "common/config.h"
 #include "util/debug_util.h"
+#include "util/disk_io_stats.h"
 
 namespace palo {
 
@@ -36,6 +38,8 @@ const char* MEM_POOL_TOTAL_BYTES = "palo_be.mem_pool.total_bytes";
 const char* HASH_TABLE_TOTAL_BYTES = "palo_be.hash_table.total_bytes";
 const char* OLAP_LRU_CACHE_LOOKUP_COUNT = "palo_be.olap.lru_cache.lookup_count";
 const char* OLAP_LRU_CACHE_HIT_COUNT = "palo_be.olap.lru_cache.hit_count";
+const char* OLAP_DATA_PAGE_CACHE_LOOKUP_COUNT = "palo_be.olap.data_page_cache.lookup_count";
+const char* OLAP_DATA_PAGE_CACHE_HIT_COUNT = "palo_be.olap.data_page_cache.hit_count";
 const char* PALO_PUSH_COUNT = "palo_be.olap.push_count";
 const char* PALO_FETCH_COUNT = "palo_be.olap.fetch_count";
 const char* PALO_REQUEST_COUNT = "palo_be.olap.request_count";
@@ -43,6 +47,9 @@ const char* BE_MERGE_DELTA_NUM = "palo_be.olap.be_merge.delta_num";
 const char* BE_MERGE_SIZE = "palo_be.olap.be_merge_size";
 const char* CE_MERGE_DELTA_NUM = "palo_be.olap.ce_merge.delta_num";
 const char* CE_MERGE_SIZE = "palo_be.olap.ce_merge_size";
+const char* COLUMN_FILE_CONVERT_DELTA_NUM = "palo_be.olap.column_file_convert.delta_num";
+const char* COLUMN_FILE_CONVERT_SIZE = "palo_be.olap.column_file_convert.size";
+const char* LEGACY_TABLET_NUM = "palo_be.olap.legacy_tablet_num";
 
 const char* IO_MGR_NUM_BUFFERS = "palo_be.io_mgr.num_buffers";
 const char* IO_MGR_NUM_OPEN_FILES = "palo_be.io_mgr.num_open_files";
@@ -60,6 +67,15 @@ const char* IO_MGR_TOTAL_BYTES = "palo_be.io_mgr.total_bytes";
 const char* IO_MGR_BYTES_WRITTEN = "palo_be.io_mgr.bytes_written";
 
 const char* NUM_QUERIES_SPILLED = "palo_be.num_queries_spilled";
+const char* ADMISSION_QUEUED_FRAGMENTS = "palo_be.admission.queued_fragments";
+const char* ADMISSION_TIMED_OUT_FRAGMENTS = "palo_be.admission.timed_out_fragments";
+const char* ADMISSION_QUEUE_WAIT_MS = "palo_be.admission.queue_wait_ms";
+const char* FRAGMENT_LATENCY = "palo_be.fragment.latency";
+const char* TABLET_SCAN_LATENCY = "palo_be.olap.tablet_scan_latency";
+const char* TABLET_SCAN_ROWS = "palo_be.olap.tablet_scan_rows";
+const char* TABLET_READ_BYTES = "palo_be.olap.tablet_read_bytes";
+const char* PUSH_LATENCY = "palo_be.olap.push.latency";
+const char* COMPACTION_LATENCY = "palo_be.olap.compaction.latency";
 
 
 // These are created by palo_be during startup.
@@ -73,6 +89,8 @@ IntGauge* PaloMetrics::_s_mem_pool_total_bytes = NULL;
 IntGauge* PaloMetrics::_s_hash_table_total_bytes = NULL;
 IntCounter* PaloMetrics::_s_olap_lru_cache_lookup_count = NULL;
 IntCounter* PaloMetrics::_s_olap_lru_cache_hit_count = NULL;
+IntCounter* PaloMetrics::_s_olap_data_page_cache_lookup_count = NULL;
+IntCounter* PaloMetrics::_s_olap_data_page_cache_hit_count = NULL;
 IntCounter* PaloMetrics::_s_palo_push_count = NULL;
 IntCounter* PaloMetrics::_s_palo_fetch_count = NULL;
 IntCounter* PaloMetrics::_s_palo_request_count = NULL;
@@ -80,6 +98,9 @@ IntCounter* PaloMetrics::_s_be_merge_delta_num = NULL;
 IntCounter* PaloMetrics::_s_be_merge_size = NULL;
 IntCounter* PaloMetrics::_s_ce_merge_delta_num = NULL;
 IntCounter* PaloMetrics::_s_ce_merge_size = NULL;
+IntCounter* PaloMetrics::_s_column_file_convert_delta_num = NULL;
+IntCounter* PaloMetrics::_s_column_file_convert_size = NULL;
+IntGauge* PaloMetrics::_s_legacy_tablet_num = NULL;
 
 IntGauge* PaloMetrics::_s_io_mgr_num_buffers = NULL;
 IntGauge* PaloMetrics::_s_io_mgr_num_open_files = NULL;
@@ -97,6 +118,15 @@ IntGauge* PaloMetrics::_s_io_mgr_total_bytes = NULL;
 IntCounter* PaloMetrics::_s_io_mgr_bytes_written = NULL;
 
 IntCounter* PaloMetrics::_s_num_queries_spilled = NULL;
+IntGauge* PaloMetrics::_s_admission_queued_fragments = NULL;
+IntCounter* PaloMetrics::_s_admission_timed_out_fragments = NULL;
+IntCounter* PaloMetrics::_s_admission_queue_wait_ms = NULL;
+HistogramMetric* PaloMetrics::_s_fragment_latency = NULL;
+HistogramFamily* PaloMetrics::_s_tablet_scan_latency = NULL;
+MetricFamily<IntCounter>* PaloMetrics::_s_tablet_scan_rows = NULL;
+MetricFamily<IntCounter>* PaloMetrics::_s_tablet_read_bytes = NULL;
+HistogramMetric* PaloMetrics::_s_push_latency = NULL;
+HistogramFamily* PaloMetrics::_s_compaction_latency = NULL;
 
 void PaloMetrics::create_metrics(MetricGroup* m) {
     // Initialize impalad metrics
@@ -118,6 +148,9 @@ void PaloMetrics::create_metrics(MetricGroup* m) {
     // Initialize olap metrics
     _s_olap_lru_cache_lookup_count = m->AddCounter(OLAP_LRU_CACHE_LOOKUP_COUNT, 0L);
     _s_olap_lru_cache_hit_count = m->AddCounter(OLAP_LRU_CACHE_HIT_COUNT, 0L);
+    _s_olap_data_page_cache_lookup_count =
+            m->AddCounter(OLAP_DATA_PAGE_CACHE_LOOKUP_COUNT, 0L);
+    _s_olap_data_page_cache_hit_count = m->AddCounter(OLAP_DATA_PAGE_CACHE_HIT_COUNT, 0L);
 
     // Initialize push_count, fetch_count, request_count metrics
     _s_palo_push_count = m->AddCounter(PALO_PUSH_COUNT, 0L);
@@ -130,6 +163,11 @@ void PaloMetrics::create_metrics(MetricGroup* m) {
     _s_ce_merge_delta_num = m->AddCounter(CE_MERGE_DELTA_NUM, 0L);
     _s_ce_merge_size = m->AddCounter(CE_MERGE_SIZE, 0L);
 
+    // Initialize metrics of converting row-oriented tablets to column files
+    _s_column_file_convert_delta_num = m->AddCounter(COLUMN_FILE_CONVERT_DELTA_NUM, 0L);
+    _s_column_file_convert_size = m->AddCounter(COLUMN_FILE_CONVERT_SIZE, 0L);
+    _s_legacy_tablet_num = m->AddGauge(LEGACY_TABLET_NUM, 0L);
+
     // Initialize metrics relate to spilling to disk
     // _s_io_mgr_bytes_read
     //         = m->AddGauge(IO_MGR_BYTES_READ, 0L);
@@ -153,6 +191,31 @@ void PaloMetrics::create_metrics(MetricGroup* m) {
             = m->AddGauge(IO_MGR_TOTAL_BYTES, 0L);
 
     _s_num_queries_spilled = m->AddCounter(NUM_QUERIES_SPILLED, 0L);
+
+    // Initialize metrics of the admission control of fragments
+    _s_admission_queued_fragments = m->AddGauge(ADMISSION_QUEUED_FRAGMENTS, 0L);
+    _s_admission_timed_out_fragments = m->AddCounter(ADMISSION_TIMED_OUT_FRAGMENTS, 0L);
+    _s_admission_queue_wait_ms = m->AddCounter(ADMISSION_QUEUE_WAIT_MS, 0L);
+
+    // Initialize latency histograms
+    _s_fragment_latency = m->register_metric(
+            new HistogramMetric(MetricDefs::Get(FRAGMENT_LATENCY)));
+    _s_tablet_scan_latency = m->register_metric(
+            new HistogramFamily(MetricDefs::Get(TABLET_SCAN_LATENCY), "tablet_id",
+                                config::tablet_scan_latency_max_tablets));
+    _s_tablet_scan_rows = m->register_metric(
+            new MetricFamily<IntCounter>(MetricDefs::Get(TABLET_SCAN_ROWS), "tablet_id",
+                                         config::tablet_scan_latency_max_tablets));
+    _s_tablet_read_bytes = m->register_metric(
+            new MetricFamily<IntCounter>(MetricDefs::Get(TABLET_READ_BYTES), "tablet_id",
+                                         config::tablet_scan_latency_max_tablets));
+    _s_push_latency = m->register_metric(
+            new HistogramMetric(MetricDefs::Get(PUSH_LATENCY)));
+    _s_compaction_latency = m->register_metric(
+            new HistogramFamily(MetricDefs::Get(COMPACTION_LATENCY), "type", 2));
+
+    // Initialize IO metrics of the root paths of the storage engine
+    DiskIoStats::register_metrics(m);
 }
 
 }
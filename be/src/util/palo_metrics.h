@@ -21,6 +21,7 @@
 #ifndef BDG_PALO_BE_SRC_COMMON_UTIL_PALO_METRICS_H
 #define BDG_PALO_BE_SRC_COMMON_UTIL_PALO_METRICS_H
 
+#include "util/histogram_metric.h"
 #include "util/metrics.h"
 
 namespace palo {
@@ -64,6 +65,12 @@ public:
     static IntCounter* olap_lru_cache_hit_count() {
         return _s_olap_lru_cache_hit_count;
     }
+    static IntCounter* olap_data_page_cache_lookup_count() {
+        return _s_olap_data_page_cache_lookup_count;
+    }
+    static IntCounter* olap_data_page_cache_hit_count() {
+        return _s_olap_data_page_cache_hit_count;
+    }
     static IntCounter* palo_push_count() {
         return _s_palo_push_count;
     }
@@ -85,6 +92,16 @@ public:
     static IntCounter* ce_merge_size() {
         return _s_ce_merge_size;
     }
+    static IntCounter* column_file_convert_delta_num() {
+        return _s_column_file_convert_delta_num;
+    }
+    static IntCounter* column_file_convert_size() {
+        return _s_column_file_convert_size;
+    }
+    // number of tablets still in row-oriented OLAPData format
+    static IntGauge* legacy_tablet_num() {
+        return _s_legacy_tablet_num;
+    }
 
     // static IntGauge* io_mgr_bytes_read() {
     //     return _s_io_mgr_bytes_read;
@@ -121,6 +138,41 @@ public:
     static IntCounter* num_queries_spilled() {
         return _s_num_queries_spilled;
     }
+    // fragments waiting for admission into their resource group
+    static IntGauge* admission_queued_fragments() {
+        return _s_admission_queued_fragments;
+    }
+    static IntCounter* admission_timed_out_fragments() {
+        return _s_admission_timed_out_fragments;
+    }
+    // total time fragments waited for admission
+    static IntCounter* admission_queue_wait_ms() {
+        return _s_admission_queue_wait_ms;
+    }
+
+    // execution time of fragment instances
+    static HistogramMetric* fragment_latency() {
+        return _s_fragment_latency;
+    }
+    // time from opening to closing the scan of a tablet, labeled by tablet id
+    static HistogramFamily* tablet_scan_latency() {
+        return _s_tablet_scan_latency;
+    }
+    // rows read from storage and bytes read from files by the scans of a tablet,
+    // labeled by tablet id like tablet_scan_latency()
+    static MetricFamily<IntCounter>* tablet_scan_rows() {
+        return _s_tablet_scan_rows;
+    }
+    static MetricFamily<IntCounter>* tablet_read_bytes() {
+        return _s_tablet_read_bytes;
+    }
+    static HistogramMetric* push_latency() {
+        return _s_push_latency;
+    }
+    // labeled by "base" or "cumulative"
+    static HistogramFamily* compaction_latency() {
+        return _s_compaction_latency;
+    }
 
 private:
     static StringProperty* _s_palo_be_start_time;
@@ -133,6 +185,8 @@ private:
     static IntGauge* _s_hash_table_total_bytes;
     static IntCounter* _s_olap_lru_cache_lookup_count;
     static IntCounter* _s_olap_lru_cache_hit_count;
+    static IntCounter* _s_olap_data_page_cache_lookup_count;
+    static IntCounter* _s_olap_data_page_cache_hit_count;
     static IntCounter* _s_palo_push_count;
     static IntCounter* _s_palo_fetch_count;
     static IntCounter* _s_palo_request_count;
@@ -140,6 +194,9 @@ private:
     static IntCounter* _s_be_merge_size;
     static IntCounter* _s_ce_merge_delta_num;
     static IntCounter* _s_ce_merge_size;
+    static IntCounter* _s_column_file_convert_delta_num;
+    static IntCounter* _s_column_file_convert_size;
+    static IntGauge* _s_legacy_tablet_num;
 
     // static IntGauge* _s_io_mgr_bytes_read;
     // static IntGauge* _s_io_mgr_local_bytes_read;
@@ -157,6 +214,15 @@ private:
     static IntGauge* _s_io_mgr_total_bytes;
 
     static IntCounter* _s_num_queries_spilled;
+    static IntGauge* _s_admission_queued_fragments;
+    static IntCounter* _s_admission_timed_out_fragments;
+    static IntCounter* _s_admission_queue_wait_ms;
+    static HistogramMetric* _s_fragment_latency;
+    static HistogramFamily* _s_tablet_scan_latency;
+    static MetricFamily<IntCounter>* _s_tablet_scan_rows;
+    static MetricFamily<IntCounter>* _s_tablet_read_bytes;
+    static HistogramMetric* _s_push_latency;
+    static HistogramFamily* _s_compaction_latency;
 
 };
 
@@ -21,47 +21,85 @@
 #ifndef BDG_PALO_BE_SRC_COMMON_UTIL_PRIORITY_THREAD_POOL_HPP
 #define BDG_PALO_BE_SRC_COMMON_UTIL_PRIORITY_THREAD_POOL_HPP
 
-#include "util/blocking_priority_queue.hpp"
+#include <stdint.h>
+
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/bind/mem_fn.hpp>
 
+#include "common/logging.h"
+#include "util/numa_info.h"
+#include "util/stopwatch.hpp"
+#include "util/thread_name.h"
+
 namespace palo {
 
-// Simple threadpool which processes items (of type T) in parallel which were placed on a
-// blocking queue by Offer(). Each item is processed by a single user-supplied method.
+// Threadpool which processes tasks in parallel which were placed on a queue by offer().
+//
+// The threads are shared between resource groups and, within a group, between queries
+// by weighted fair queueing: every group and every query has a virtual time, which is
+// advanced by the run time of its tasks divided by its weight, and the next task is
+// taken from the group and then the query with the smallest virtual time. A query that
+// has been idle starts at the smallest virtual time of the active queries of its
+// group, so it can't bank credit, and a new query gets the threads as soon as the
+// running tasks of the others end. Within a query, tasks with a higher priority run
+// first.
+//
+// The weight of a query is its priority plus one, so a query whose tasks lose priority
+// as it runs longer (see OlapScanNode::_nice) also gets a smaller share of the threads.
+// Group weights are set by set_group_weights(), groups without one have weight 1.
+//
+// With several NUMA nodes, the threads are bound to the nodes in turn and every node
+// has a queue of its own. A task runs on the node it asks for, or else on the node
+// with the fewest queued tasks. A thread whose queue is empty takes tasks from the
+// longest queue of the other nodes, so no thread idles while tasks wait.
 class PriorityThreadPool {
 public:
-    // Signature of a work-processing function. Takes the integer id of the thread which is
-    // calling it (ids run from 0 to num_threads - 1) and a reference to the item to
-    // process.
+    // Signature of a work-processing function.
     typedef boost::function<void ()> WorkFunction;
 
     struct Task {
     public:
+        Task() : priority(0), query_key(0), numa_node(-1) { }
+
         int priority;
         WorkFunction work_function;
+        // Resource group and query the task is accounted to. Tasks without them share
+        // the default group and query.
+        std::string group;
+        int64_t query_key;
+        // The NUMA node the task prefers to run on, -1 if any.
+        int numa_node;
+
         bool operator< (const Task& o) const {
             return priority < o.priority;
         }
-
-        Task& operator++() {
-            priority += 2;
-            return *this;
-        }
     };
 
     // Creates a new thread pool and start num_threads threads.
     //  -- num_threads: how many threads are part of this pool
-    //  -- queue_size: the maximum size of the queue on which work items are offered. If the
-    //     queue exceeds this size, subsequent calls to Offer will block until there is
-    //     capacity available.
-    //  -- work_function: the function to run every time an item is consumed from the queue
-    PriorityThreadPool(uint32_t num_threads, uint32_t queue_size) :
+    //  -- queue_size: the maximum number of tasks queued in the pool. If it is reached,
+    //     subsequent calls to offer() will block until there is capacity available.
+    //  -- num_numa_nodes: how many NUMA nodes the threads are bound to, 1 doesn't bind
+    //     them.
+    //  -- name: the name of the threads
+    PriorityThreadPool(uint32_t num_threads, uint32_t queue_size, int num_numa_nodes = 1,
+                       const std::string& name = "priority_pool") :
             _thread_num(num_threads),
-            _work_queue(queue_size),
+            _name(name),
+            _max_queued(queue_size),
+            _queues(std::max(num_numa_nodes, 1)),
+            _num_queued(0),
+            _last_gc_ns(0),
             _shutdown(false) {
+        _clock.start();
         for (int i = 0; i < num_threads; ++i) {
             _threads.create_thread(
                     boost::bind<void>(
@@ -76,10 +114,34 @@ public:
         join();
     }
 
-    // Blocking operation that puts a work item on the queue. If the queue is full, blocks
+    // Sets the weights of resource groups from a spec like "normal:1,high:4". Invalid
+    // entries are logged and skipped.
+    void set_group_weights(const std::string& spec) {
+        boost::lock_guard<boost::mutex> l(_lock);
+        std::stringstream ss(spec);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            size_t pos = item.rfind(':');
+            int weight = 0;
+            if (pos == std::string::npos || pos == 0
+                    || !(std::istringstream(item.substr(pos + 1)) >> weight) || weight <= 0) {
+                LOG(WARNING) << "invalid scanner group weight: '" << item << "'";
+                continue;
+            }
+            _group_weights[item.substr(0, pos)] = weight;
+            for (int i = 0; i < _queues.size(); ++i) {
+                GroupMap::iterator it = _queues[i].groups.find(item.substr(0, pos));
+                if (it != _queues[i].groups.end()) {
+                    it->second.weight = weight;
+                }
+            }
+        }
+    }
+
+    // Blocking operation that puts a task on the queue. If the queue is full, blocks
     // until there is capacity available.
     //
-    // 'work' is copied into the work queue, but may be referenced at any time in the
+    // 'task' is copied into the work queue, but may be referenced at any time in the
     // future. Therefore the caller needs to ensure that any data referenced by work (if T
     // is, e.g., a pointer type) remains valid until work has been processed, and it's up to
     // the caller to provide their own signalling mechanism to detect this (or to wait until
@@ -88,7 +150,44 @@ public:
     // Returns true if the work item was successfully added to the queue, false otherwise
     // (which typically means that the thread pool has already been shut down).
     bool offer(Task task) {
-        return _work_queue.blocking_put(task);
+        boost::unique_lock<boost::mutex> l(_lock);
+        while (_num_queued >= _max_queued && !_shutdown) {
+            _put_cv.wait(l);
+        }
+        if (_shutdown) {
+            return false;
+        }
+        if (task.numa_node < 0 || task.numa_node >= _queues.size()) {
+            task.numa_node = 0;
+            for (int i = 1; i < _queues.size(); ++i) {
+                if (_queues[i].num_queued < _queues[task.numa_node].num_queued) {
+                    task.numa_node = i;
+                }
+            }
+        }
+        NodeQueue& queue = _queues[task.numa_node];
+        GroupMap::iterator group_it = queue.groups.find(task.group);
+        if (group_it == queue.groups.end()) {
+            WeightMap::iterator weight_it = _group_weights.find(task.group);
+            group_it = queue.groups.insert(std::make_pair(task.group, Group(
+                    weight_it != _group_weights.end() ? weight_it->second : 1))).first;
+        }
+        Group& group = group_it->second;
+        if (!group.is_active()) {
+            group.vtime = std::max(group.vtime, min_active_vtime(queue.groups, group.vtime));
+        }
+        Query& query = group.queries[task.query_key];
+        if (!query.is_active()) {
+            query.vtime = std::max(query.vtime, min_active_vtime(group.queries, query.vtime));
+        }
+        query.tasks.push(task);
+        ++group.num_queued;
+        ++queue.num_queued;
+        ++_num_queued;
+        gc_idle_entries();
+        l.unlock();
+        _get_cv.notify_one();
+        return true;
     }
 
     // Shuts the thread pool down, causing the work queue to cease accepting offered work
@@ -100,7 +199,8 @@ public:
             boost::lock_guard<boost::mutex> l(_lock);
             _shutdown = true;
         }
-        _work_queue.shutdown();
+        _get_cv.notify_all();
+        _put_cv.notify_all();
     }
 
     // Blocks until all threads are finished. shutdown does not need to have been called,
@@ -110,7 +210,8 @@ public:
     }
 
     uint32_t get_queue_size() const {
-        return _work_queue.get_size();
+        boost::lock_guard<boost::mutex> l(_lock);
+        return _num_queued;
     }
 
     // Blocks until the work queue is empty, and then calls shutdown to stop the worker
@@ -119,7 +220,7 @@ public:
     void drain_and_shutdown() {
         {
             boost::unique_lock<boost::mutex> l(_lock);
-            while (_work_queue.get_size() != 0) {
+            while (_num_queued != 0) {
                 _empty_cv.wait(l);
             }
         }
@@ -128,41 +229,221 @@ public:
     }
 
 private:
+    // Idle groups and queries are forgotten after this long.
+    static const int64_t IDLE_ENTRY_EXPIRE_NS = 60L * 1000 * 1000 * 1000;
+
+    // State of a query or a resource group. An entry is active while it has queued or
+    // running tasks.
+    struct Entry {
+        Entry() : vtime(0), num_running(0), last_active_ns(0) { }
+
+        double vtime;
+        int num_running;
+        int64_t last_active_ns;
+    };
+
+    struct Query : public Entry {
+        bool is_active() const {
+            return num_running > 0 || !tasks.empty();
+        }
+
+        std::priority_queue<Task> tasks;
+    };
+
+    typedef std::map<int64_t, Query> QueryMap;
+
+    struct Group : public Entry {
+        explicit Group(int weight_) : weight(weight_), num_queued(0) { }
+
+        bool is_active() const {
+            return num_running > 0 || num_queued > 0;
+        }
+
+        int weight;
+        int num_queued;
+        QueryMap queries;
+    };
+
+    typedef std::map<std::string, Group> GroupMap;
+    typedef std::map<std::string, int> WeightMap;
+
+    // The queued tasks of a NUMA node.
+    struct NodeQueue {
+        NodeQueue() : num_queued(0) { }
+
+        GroupMap groups;
+        uint32_t num_queued;
+    };
+
+    // Returns the smallest virtual time of the active entries of 'entries', or
+    // 'default_vtime' if none is active.
+    template <typename Map>
+    static double min_active_vtime(const Map& entries, double default_vtime) {
+        double min_vtime = 0;
+        bool found = false;
+        for (typename Map::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+            if (it->second.is_active() && (!found || it->second.vtime < min_vtime)) {
+                min_vtime = it->second.vtime;
+                found = true;
+            }
+        }
+        return found ? min_vtime : default_vtime;
+    }
+
+    // Takes the next task to run on 'numa_node', in fair queueing order. Must be
+    // called with _lock held and _num_queued > 0.
+    void take_task(int numa_node, Task* task) {
+        int node = numa_node;
+        if (_queues[node].num_queued == 0) {
+            for (int i = 0; i < _queues.size(); ++i) {
+                if (_queues[i].num_queued > _queues[node].num_queued) {
+                    node = i;
+                }
+            }
+        }
+        NodeQueue& queue = _queues[node];
+        GroupMap::iterator group_it = queue.groups.end();
+        for (GroupMap::iterator it = queue.groups.begin(); it != queue.groups.end(); ++it) {
+            if (it->second.num_queued > 0
+                    && (group_it == queue.groups.end()
+                        || it->second.vtime < group_it->second.vtime)) {
+                group_it = it;
+            }
+        }
+        DCHECK(group_it != queue.groups.end());
+        Group& group = group_it->second;
+        QueryMap::iterator query_it = group.queries.end();
+        for (QueryMap::iterator it = group.queries.begin(); it != group.queries.end(); ++it) {
+            if (!it->second.tasks.empty()
+                    && (query_it == group.queries.end()
+                        || it->second.vtime < query_it->second.vtime)) {
+                query_it = it;
+            }
+        }
+        DCHECK(query_it != group.queries.end());
+        Query& query = query_it->second;
+        *task = query.tasks.top();
+        query.tasks.pop();
+        ++query.num_running;
+        --group.num_queued;
+        ++group.num_running;
+        --queue.num_queued;
+        --_num_queued;
+    }
+
+    // Charges the run time of 'task' to its query and group.
+    void finish_task(const Task& task, int64_t run_time_ns) {
+        int64_t now = _clock.elapsed_time();
+        Group& group = _queues[task.numa_node].groups.find(task.group)->second;
+        Query& query = group.queries.find(task.query_key)->second;
+        query.vtime += (double)run_time_ns / std::max(1, task.priority + 1);
+        --query.num_running;
+        query.last_active_ns = now;
+        group.vtime += (double)run_time_ns / group.weight;
+        --group.num_running;
+        group.last_active_ns = now;
+    }
+
+    // Drops the groups and queries which have been idle for IDLE_ENTRY_EXPIRE_NS, at
+    // most once per second. Must be called with _lock held.
+    void gc_idle_entries() {
+        int64_t now = _clock.elapsed_time();
+        if (now - _last_gc_ns < 1000L * 1000 * 1000) {
+            return;
+        }
+        _last_gc_ns = now;
+        for (int i = 0; i < _queues.size(); ++i) {
+            gc_idle_entries(now, &_queues[i].groups);
+        }
+    }
+
+    // Drops the idle groups and queries of 'groups'.
+    void gc_idle_entries(int64_t now, GroupMap* groups) {
+        GroupMap::iterator group_it = groups->begin();
+        while (group_it != groups->end()) {
+            QueryMap& queries = group_it->second.queries;
+            QueryMap::iterator query_it = queries.begin();
+            while (query_it != queries.end()) {
+                if (!query_it->second.is_active()
+                        && now - query_it->second.last_active_ns > IDLE_ENTRY_EXPIRE_NS) {
+                    queries.erase(query_it++);
+                } else {
+                    ++query_it;
+                }
+            }
+            if (!group_it->second.is_active() && queries.empty()
+                    && now - group_it->second.last_active_ns > IDLE_ENTRY_EXPIRE_NS) {
+                groups->erase(group_it++);
+            } else {
+                ++group_it;
+            }
+        }
+    }
+
     // Driver method for each thread in the pool. Continues to read work from the queue
     // until the pool is shutdown.
     void work_thread(int thread_id) {
-        while (!is_shutdown()) {
-            Task task;
-            if (_work_queue.blocking_get(&task)) {
-                task.work_function();
+        set_current_thread_name(_name);
+        int numa_node = thread_id % _queues.size();
+        if (_queues.size() > 1) {
+            NumaInfo::bind_current_thread(numa_node);
+        }
+        boost::unique_lock<boost::mutex> l(_lock);
+        while (!_shutdown) {
+            if (_num_queued == 0) {
+                _get_cv.wait(l);
+                continue;
             }
-            if (_work_queue.get_size() == 0) {
+            Task task;
+            take_task(numa_node, &task);
+            if (_num_queued == 0) {
                 _empty_cv.notify_all();
             }
-        }
-    }
+            l.unlock();
+            _put_cv.notify_one();
 
-    // Returns value of _shutdown under a lock, forcing visibility to threads in the pool.
-    bool is_shutdown() {
-        boost::lock_guard<boost::mutex> l(_lock);
-        return _shutdown;
+            MonotonicStopWatch run_timer;
+            run_timer.start();
+            task.work_function();
+            int64_t run_time_ns = run_timer.elapsed_time();
+
+            l.lock();
+            finish_task(task, run_time_ns);
+        }
     }
 
     uint32_t _thread_num;
+    const std::string _name;
 
-    // Queue on which work items are held until a thread is available to process them in
-    // FIFO order.
-    BlockingPriorityQueue<Task> _work_queue;
+    // Max number of queued tasks.
+    const uint32_t _max_queued;
 
     // Collection of worker threads that process work from the queue.
     boost::thread_group _threads;
 
-    // Guards _shutdown and _empty_cv
-    boost::mutex _lock;
+    // Started at construction, the time base of the fields below.
+    MonotonicStopWatch _clock;
+
+    // Guards all fields below.
+    mutable boost::mutex _lock;
+
+    // The queued tasks by NUMA node, resource group and query and the number of
+    // queued tasks.
+    std::vector<NodeQueue> _queues;
+    uint32_t _num_queued;
+
+    WeightMap _group_weights;
+
+    // Time of the last gc_idle_entries() pass.
+    int64_t _last_gc_ns;
 
     // Set to true when threads should stop doing work and terminate.
     bool _shutdown;
 
+    // Signalled when a task is queued or the pool is shut down.
+    boost::condition_variable _get_cv;
+    // Signalled when a task is taken from the queue or the pool is shut down.
+    boost::condition_variable _put_cv;
     // Signalled when the queue becomes empty
     boost::condition_variable _empty_cv;
 };
@@ -53,6 +53,11 @@ public:
     // VLOG_PROGRESS
     void update(int64_t delta);
 
+    // 'delta' more work items are added.
+    void add_total(int64_t delta) {
+        _total += delta;
+    }
+
     // Returns if all tasks are done.
     bool done() const {
         return _num_complete >= _total;
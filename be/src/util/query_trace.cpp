@@ -0,0 +1,206 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/query_trace.h"
+
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include "common/config.h"
+#include "util/debug_util.h"
+
+namespace palo {
+
+static std::atomic<int64_t> s_next_trace_serial(1);
+
+__thread int64_t QueryTrace::_t_serial = 0;
+__thread QueryTrace::ThreadBuffer* QueryTrace::_t_buffer = NULL;
+
+QueryTrace::QueryTrace(const TUniqueId& query_id) :
+        _query_id(query_id),
+        _serial(s_next_trace_serial.fetch_add(1)) {
+}
+
+QueryTrace::~QueryTrace() {
+}
+
+int64_t QueryTrace::now_us() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000L + tv.tv_usec;
+}
+
+QueryTrace::ThreadBuffer* QueryTrace::thread_buffer() {
+    if (_t_serial == _serial) {
+        return _t_buffer;
+    }
+    int64_t tid = syscall(SYS_gettid);
+    std::lock_guard<std::mutex> l(_lock);
+    std::unique_ptr<ThreadBuffer>& buffer = _buffers[tid];
+    if (buffer == nullptr) {
+        buffer.reset(new ThreadBuffer(
+                tid, std::max(config::query_trace_max_events_per_thread, 0)));
+    }
+    _t_serial = _serial;
+    _t_buffer = buffer.get();
+    return _t_buffer;
+}
+
+void QueryTrace::add_span(const char* category, const char* name,
+                          int64_t start_us, int64_t end_us, const std::string& detail) {
+    ThreadBuffer* buffer = thread_buffer();
+    int idx = buffer->num_events.load(std::memory_order_relaxed);
+    if (idx >= static_cast<int>(buffer->events.size())) {
+        buffer->num_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Event& event = buffer->events[idx];
+    event.category = category;
+    event.name = name;
+    event.start_us = start_us;
+    event.duration_us = std::max<int64_t>(end_us - start_us, 0);
+    event.detail = detail;
+    buffer->num_events.store(idx + 1, std::memory_order_release);
+}
+
+int64_t QueryTrace::num_events() const {
+    std::lock_guard<std::mutex> l(_lock);
+    int64_t num = 0;
+    for (auto& it : _buffers) {
+        num += it.second->num_events.load(std::memory_order_acquire);
+    }
+    return num;
+}
+
+int64_t QueryTrace::num_dropped_events() const {
+    std::lock_guard<std::mutex> l(_lock);
+    int64_t num = 0;
+    for (auto& it : _buffers) {
+        num += it.second->num_dropped.load(std::memory_order_relaxed);
+    }
+    return num;
+}
+
+std::string QueryTrace::to_json(const std::string& process_name) const {
+    int64_t pid = getpid();
+    int64_t num_dropped = 0;
+    rapidjson::StringBuffer out;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(out);
+    writer.StartObject();
+    writer.Key("traceEvents");
+    writer.StartArray();
+
+    writer.StartObject();
+    writer.Key("name");
+    writer.String("process_name");
+    writer.Key("ph");
+    writer.String("M");
+    writer.Key("pid");
+    writer.Int64(pid);
+    writer.Key("args");
+    writer.StartObject();
+    writer.Key("name");
+    writer.String(process_name.c_str());
+    writer.EndObject();
+    writer.EndObject();
+
+    {
+        std::lock_guard<std::mutex> l(_lock);
+        for (auto& it : _buffers) {
+            const ThreadBuffer& buffer = *it.second;
+            int num = buffer.num_events.load(std::memory_order_acquire);
+            for (int i = 0; i < num; ++i) {
+                const Event& event = buffer.events[i];
+                writer.StartObject();
+                writer.Key("name");
+                writer.String(event.name);
+                writer.Key("cat");
+                writer.String(event.category);
+                writer.Key("ph");
+                writer.String("X");
+                writer.Key("ts");
+                writer.Int64(event.start_us);
+                writer.Key("dur");
+                writer.Int64(event.duration_us);
+                writer.Key("pid");
+                writer.Int64(pid);
+                writer.Key("tid");
+                writer.Int64(buffer.tid);
+                if (!event.detail.empty()) {
+                    writer.Key("args");
+                    writer.StartObject();
+                    writer.Key("detail");
+                    writer.String(event.detail.c_str());
+                    writer.EndObject();
+                }
+                writer.EndObject();
+            }
+            num_dropped += buffer.num_dropped.load(std::memory_order_relaxed);
+        }
+    }
+    writer.EndArray();
+
+    writer.Key("displayTimeUnit");
+    writer.String("ms");
+    writer.Key("otherData");
+    writer.StartObject();
+    writer.Key("query_id");
+    writer.String(print_id(_query_id).c_str());
+    writer.Key("dropped_events");
+    writer.Int64(num_dropped);
+    writer.EndObject();
+    writer.EndObject();
+    return out.GetString();
+}
+
+QueryTraceMgr* QueryTraceMgr::instance() {
+    static QueryTraceMgr s_instance;
+    return &s_instance;
+}
+
+std::shared_ptr<QueryTrace> QueryTraceMgr::get_or_create(const TUniqueId& query_id) {
+    std::lock_guard<std::mutex> l(_lock);
+    std::shared_ptr<QueryTrace>& trace = _traces[query_id];
+    if (trace != nullptr) {
+        return trace;
+    }
+    trace.reset(new QueryTrace(query_id));
+    std::shared_ptr<QueryTrace> result = trace;
+    _order.push_back(query_id);
+    // running fragments hold their own reference, evicting only stops the export
+    size_t max_queries = std::max(config::query_trace_max_queries, 1);
+    while (_order.size() > max_queries) {
+        _traces.erase(_order.front());
+        _order.pop_front();
+    }
+    return result;
+}
+
+std::shared_ptr<QueryTrace> QueryTraceMgr::find(const TUniqueId& query_id) {
+    std::lock_guard<std::mutex> l(_lock);
+    auto it = _traces.find(query_id);
+    if (it == _traces.end()) {
+        return nullptr;
+    }
+    return it->second;
+}
+
+}
@@ -0,0 +1,154 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_UTIL_QUERY_TRACE_H
+#define BDG_PALO_BE_SRC_UTIL_QUERY_TRACE_H
+
+#include <stdint.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "gen_cpp/Types_types.h"
+#include "util/hash_util.hpp"
+
+namespace palo {
+
+// Timeline of one query on this backend: fragment prepare/open, tablet scans,
+// exchange batches and spills, exported in the Chrome trace event format which
+// chrome://tracing and Perfetto load.
+//
+// Each thread appends its spans to a buffer of its own, so recording a span takes
+// no lock. The lock is only taken the first time a thread records a span of the
+// query and when the trace is exported. A buffer holds at most
+// config::query_trace_max_events_per_thread spans, the following ones are dropped.
+class QueryTrace {
+public:
+    explicit QueryTrace(const TUniqueId& query_id);
+    ~QueryTrace();
+
+    const TUniqueId& query_id() const {
+        return _query_id;
+    }
+
+    // Records a span of the calling thread. 'category' and 'name' must outlive the
+    // trace, e.g. string literals. 'detail' is shown in the args of the span.
+    void add_span(const char* category, const char* name, int64_t start_us, int64_t end_us,
+                  const std::string& detail);
+
+    // Writes the spans of all threads as a Chrome trace JSON object.
+    // 'process_name' labels the spans of this backend when traces are merged.
+    std::string to_json(const std::string& process_name) const;
+
+    int64_t num_events() const;
+    int64_t num_dropped_events() const;
+
+    // Microseconds since the epoch, so the traces of different backends line up.
+    static int64_t now_us();
+
+private:
+    struct Event {
+        const char* category;
+        const char* name;
+        int64_t start_us;
+        int64_t duration_us;
+        std::string detail;
+    };
+
+    // Only the owner thread writes a buffer. It publishes a filled slot by a release
+    // store of 'num_events', the exporter reads the slots below it.
+    struct ThreadBuffer {
+        ThreadBuffer(int64_t tid_, int capacity) :
+                tid(tid_), events(capacity), num_events(0), num_dropped(0) {}
+        const int64_t tid;
+        std::vector<Event> events;
+        std::atomic<int> num_events;
+        std::atomic<int64_t> num_dropped;
+    };
+
+    ThreadBuffer* thread_buffer();
+
+    const TUniqueId _query_id;
+    // unique over the process lifetime, unlike 'this', to validate the cached buffer
+    const int64_t _serial;
+
+    mutable std::mutex _lock;
+    std::unordered_map<int64_t, std::unique_ptr<ThreadBuffer>> _buffers;
+
+    // the buffer the calling thread used last, valid if its serial matches
+    static __thread int64_t _t_serial;
+    static __thread ThreadBuffer* _t_buffer;
+};
+
+// Records a span from the construction to the destruction. Does nothing if 'trace'
+// is NULL, i.e. the query doesn't enable tracing.
+class ScopedTraceSpan {
+public:
+    ScopedTraceSpan(QueryTrace* trace, const char* category, const char* name) :
+            _trace(trace), _category(category), _name(name),
+            _start_us(trace != NULL ? QueryTrace::now_us() : 0) {
+    }
+
+    ~ScopedTraceSpan() {
+        if (_trace != NULL) {
+            _trace->add_span(_category, _name, _start_us, QueryTrace::now_us(), _detail);
+        }
+    }
+
+    // Only evaluate the detail if the query is traced.
+    bool enabled() const {
+        return _trace != NULL;
+    }
+
+    void set_detail(const std::string& detail) {
+        _detail = detail;
+    }
+
+private:
+    QueryTrace* _trace;
+    const char* _category;
+    const char* _name;
+    int64_t _start_us;
+    std::string _detail;
+};
+
+// Traces of the queries run with the query option enable_query_trace. The traces of
+// the last config::query_trace_max_queries queries are kept after they finish, so
+// they can be fetched from /api/query_trace?query_id=xxx.
+class QueryTraceMgr {
+public:
+    static QueryTraceMgr* instance();
+
+    // Returns the trace of the query, all fragments of the query share one.
+    std::shared_ptr<QueryTrace> get_or_create(const TUniqueId& query_id);
+
+    // Returns NULL if the query isn't traced or its trace was evicted.
+    std::shared_ptr<QueryTrace> find(const TUniqueId& query_id);
+
+private:
+    std::mutex _lock;
+    std::unordered_map<TUniqueId, std::shared_ptr<QueryTrace>> _traces;
+    // query ids in the order their traces were created
+    std::deque<TUniqueId> _order;
+};
+
+}
+
+#endif
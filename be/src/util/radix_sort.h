@@ -0,0 +1,92 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_UTIL_RADIX_SORT_H
+#define BDG_PALO_BE_SRC_UTIL_RADIX_SORT_H
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace palo {
+
+// Fewer entries than this are sorted by comparisons only, the histograms and the
+// buffer of a radix sort don't pay off for them.
+static const size_t RADIX_SORT_MIN_ENTRIES = 4096;
+
+// Sorts the entries in [begin, end) by 'head', an uint64_t member of Entry, with a least
+// significant digit radix sort over its bytes, then sorts each run of entries with equal
+// heads by 'less_than', which must order entries by their heads first. Passes over a
+// byte that is the same in every head are skipped, so keys that span a small range, like
+// timestamps of one day, take a few passes only.
+// Takes a buffer as large as the entries.
+template <typename Entry, typename LessThan>
+void radix_sort(Entry* begin, Entry* end, const LessThan& less_than) {
+    size_t num_entries = end - begin;
+    if (num_entries < RADIX_SORT_MIN_ENTRIES) {
+        std::sort(begin, end, less_than);
+        return;
+    }
+
+    // the histograms of all the bytes are counted in one pass
+    std::vector<size_t> counts(8 * 256, 0);
+    for (Entry* entry = begin; entry != end; ++entry) {
+        uint64_t head = entry->head;
+        for (int i = 0; i < 8; ++i) {
+            ++counts[i * 256 + (head & 0xFF)];
+            head >>= 8;
+        }
+    }
+
+    std::vector<Entry> buffer(num_entries);
+    Entry* src = begin;
+    Entry* dst = buffer.data();
+    std::vector<size_t> offsets(256);
+    for (int i = 0; i < 8; ++i) {
+        const size_t* count = &counts[i * 256];
+        int shift = i * 8;
+        if (count[(src[0].head >> shift) & 0xFF] == num_entries) {
+            continue;
+        }
+        size_t offset = 0;
+        for (int j = 0; j < 256; ++j) {
+            offsets[j] = offset;
+            offset += count[j];
+        }
+        for (size_t j = 0; j < num_entries; ++j) {
+            dst[offsets[(src[j].head >> shift) & 0xFF]++] = src[j];
+        }
+        std::swap(src, dst);
+    }
+    if (src != begin) {
+        std::copy(src, src + num_entries, begin);
+    }
+
+    for (Entry* first = begin; first != end;) {
+        Entry* last = first + 1;
+        while (last != end && last->head == first->head) {
+            ++last;
+        }
+        if (last - first > 1) {
+            std::sort(first, last, less_than);
+        }
+        first = last;
+    }
+}
+
+}
+
+#endif
@@ -52,6 +52,8 @@ namespace palo {
       (profile)->add_counter(name, TUnit::TIME_NS, parent)
 #define SCOPED_TIMER(c) \
       ScopedTimer<MonotonicStopWatch> MACRO_CONCAT(SCOPED_TIMER, __COUNTER__)(c)
+#define SCOPED_CPU_TIMER(c) \
+      ScopedTimer<ThreadCpuStopWatch> MACRO_CONCAT(SCOPED_CPU_TIMER, __COUNTER__)(c)
 #define COUNTER_UPDATE(c, v) (c)->update(v)
 #define COUNTER_SET(c, v) (c)->set(v)
 #define ADD_THREAD_COUNTERS(profile, prefix) (profile)->add_thread_counters(prefix)
@@ -62,6 +64,7 @@ namespace palo {
 #define ADD_COUNTER(profile, name, type) NULL
 #define ADD_TIMER(profile, name) NULL
 #define SCOPED_TIMER(c)
+#define SCOPED_CPU_TIMER(c)
 #define COUNTER_UPDATE(c, v)
 #define COUNTER_SET(c, v)
 #define ADD_THREADCOUNTERS(profile, prefix) NULL
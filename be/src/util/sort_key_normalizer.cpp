@@ -0,0 +1,274 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/sort_key_normalizer.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "exprs/expr.h"
+#include "runtime/datetime_value.h"
+#include "runtime/string_value.h"
+#include "runtime/tuple_row.h"
+#include "util/radix_sort.h"
+#include "util/tuple_row_compare.h"
+
+namespace palo {
+
+// Bytes of the prefix of a string key in a normalized key
+static const int NORMALIZED_STRING_PREFIX = 8;
+
+static inline void put_big_endian(uint64_t value, int bytes, uint8_t* dst) {
+    for (int i = bytes - 1; i >= 0; --i) {
+        dst[i] = value & 0xFF;
+        value >>= 8;
+    }
+}
+
+// A tuple being sorted with its normalized key. The first 8 bytes of the key are kept
+// in the entry as a number, so that most comparisons don't touch the key bytes.
+struct NormalizedTuple {
+    uint64_t head;
+    const uint8_t* key;
+    int64_t index;
+};
+
+class NormalizedTupleLessThan {
+public:
+    // 'less_than' breaks the ties of incomplete keys, NULL if the keys are complete.
+    NormalizedTupleLessThan(int key_width, uint8_t** tuples,
+                            const TupleRowComparator* less_than) :
+            _key_width(key_width),
+            _tuples(tuples),
+            _less_than(less_than) {
+    }
+
+    bool operator()(const NormalizedTuple& lhs, const NormalizedTuple& rhs) const {
+        if (lhs.head != rhs.head) {
+            return lhs.head < rhs.head;
+        }
+        if (_key_width > 8) {
+            int result = memcmp(lhs.key + 8, rhs.key + 8, _key_width - 8);
+            if (result != 0) {
+                return result < 0;
+            }
+        }
+        // a row of a single tuple is the address of its tuple pointer
+        return _less_than != NULL
+            && (*_less_than)(reinterpret_cast<TupleRow*>(&_tuples[lhs.index]),
+                             reinterpret_cast<TupleRow*>(&_tuples[rhs.index]));
+    }
+
+private:
+    int _key_width;
+    uint8_t** _tuples;
+    const TupleRowComparator* _less_than;
+};
+
+SortKeyNormalizer::SortKeyNormalizer() : _width(0), _complete(true) {
+}
+
+void SortKeyNormalizer::init(const std::vector<ExprContext*>& key_expr_ctxs,
+                             const std::vector<bool>& is_asc,
+                             const std::vector<int8_t>& nulls_first) {
+    DCHECK_EQ(key_expr_ctxs.size(), is_asc.size());
+    DCHECK_EQ(key_expr_ctxs.size(), nulls_first.size());
+    _key_expr_ctxs.clear();
+    _value_widths.clear();
+    _is_asc.clear();
+    _nulls_first.clear();
+    _width = 0;
+    _complete = true;
+    // a key stored as a prefix ends the normalized keys
+    for (int i = 0; i < key_expr_ctxs.size() && _complete; ++i) {
+        bool complete = true;
+        int width = value_width(key_expr_ctxs[i]->root()->type(), &complete);
+        if (width == 0) {
+            _complete = false;
+            break;
+        }
+        _key_expr_ctxs.push_back(key_expr_ctxs[i]);
+        _value_widths.push_back(width);
+        _is_asc.push_back(is_asc[i]);
+        _nulls_first.push_back(nulls_first[i] < 0);
+        _width += 1 + width;
+        _complete = complete;
+    }
+}
+
+void SortKeyNormalizer::init(const TupleRowComparator& comparator) {
+    init(comparator.key_expr_ctxs_lhs(), comparator.is_asc(), comparator.nulls_first());
+}
+
+void SortKeyNormalizer::encode(TupleRow* row, uint8_t* dst) const {
+    for (int i = 0; i < _key_expr_ctxs.size(); ++i) {
+        void* value = _key_expr_ctxs[i]->get_value(row);
+        // NULLs are ordered the same for ASC and DESC
+        if (value == NULL) {
+            dst[0] = _nulls_first[i] ? 0 : 1;
+            memset(dst + 1, 0, _value_widths[i]);
+        } else {
+            dst[0] = _nulls_first[i] ? 1 : 0;
+            encode_value(value, _key_expr_ctxs[i]->root()->type(), _value_widths[i],
+                         _is_asc[i], dst + 1);
+        }
+        dst += 1 + _value_widths[i];
+    }
+}
+
+int64_t SortKeyNormalizer::sort_memory(int64_t num_tuples) const {
+    // the entries and the buffer of the radix sort
+    return num_tuples * (std::max(_width, 8) + 2 * sizeof(NormalizedTuple));
+}
+
+void SortKeyNormalizer::sort_tuples(uint8_t** tuples, int64_t num_tuples, int tuple_size,
+                                    const TupleRowComparator& less_than) const {
+    DCHECK_GT(_width, 0);
+    // the head of an entry is read from the first 8 bytes of the key
+    int stride = std::max(_width, 8);
+    std::vector<uint8_t> keys(num_tuples * stride, 0);
+    std::vector<NormalizedTuple> entries(num_tuples);
+    for (int64_t i = 0; i < num_tuples; ++i) {
+        uint8_t* key = &keys[i * stride];
+        encode(reinterpret_cast<TupleRow*>(&tuples[i]), key);
+        uint64_t head = 0;
+        for (int j = 0; j < 8; ++j) {
+            head = (head << 8) | key[j];
+        }
+        entries[i].head = head;
+        entries[i].key = key;
+        entries[i].index = i;
+    }
+    radix_sort(entries.data(), entries.data() + num_tuples,
+               NormalizedTupleLessThan(_width, tuples, _complete ? NULL : &less_than));
+
+    // Move the tuples along the cycles of the permutation, entries[i].index is the tuple
+    // that goes to i. An entry is set to its own position once its tuple is in place.
+    std::vector<uint8_t> temp(tuple_size);
+    for (int64_t i = 0; i < num_tuples; ++i) {
+        if (entries[i].index == i) {
+            continue;
+        }
+        memcpy(temp.data(), tuples[i], tuple_size);
+        int64_t dst = i;
+        while (true) {
+            int64_t src = entries[dst].index;
+            entries[dst].index = dst;
+            if (src == i) {
+                memcpy(tuples[dst], temp.data(), tuple_size);
+                break;
+            }
+            memcpy(tuples[dst], tuples[src], tuple_size);
+            dst = src;
+        }
+    }
+}
+
+int SortKeyNormalizer::value_width(const TypeDescriptor& type, bool* complete) {
+    *complete = true;
+    switch (type.type) {
+    case TYPE_BOOLEAN:
+    case TYPE_TINYINT:
+        return 1;
+    case TYPE_SMALLINT:
+        return 2;
+    case TYPE_INT:
+    case TYPE_FLOAT:
+        return 4;
+    case TYPE_BIGINT:
+    case TYPE_DOUBLE:
+    case TYPE_DATE:
+    case TYPE_DATETIME:
+        return 8;
+    case TYPE_LARGEINT:
+        return 16;
+    case TYPE_CHAR:
+    case TYPE_VARCHAR:
+        *complete = false;
+        return NORMALIZED_STRING_PREFIX;
+    default:
+        return 0;
+    }
+}
+
+void SortKeyNormalizer::encode_value(const void* value, const TypeDescriptor& type,
+                                     int width, bool is_asc, uint8_t* dst) {
+    switch (type.type) {
+    case TYPE_BOOLEAN:
+        dst[0] = *reinterpret_cast<const bool*>(value);
+        break;
+    case TYPE_TINYINT:
+        dst[0] = *reinterpret_cast<const uint8_t*>(value) ^ 0x80;
+        break;
+    case TYPE_SMALLINT:
+        put_big_endian(*reinterpret_cast<const uint16_t*>(value) ^ 0x8000, 2, dst);
+        break;
+    case TYPE_INT:
+        put_big_endian(*reinterpret_cast<const uint32_t*>(value) ^ 0x80000000U, 4, dst);
+        break;
+    case TYPE_BIGINT:
+        put_big_endian(*reinterpret_cast<const uint64_t*>(value) ^ (1ULL << 63), 8, dst);
+        break;
+    case TYPE_LARGEINT: {
+        unsigned __int128 v = *reinterpret_cast<const unsigned __int128*>(value);
+        put_big_endian((uint64_t)(v >> 64) ^ (1ULL << 63), 8, dst);
+        put_big_endian((uint64_t) v, 8, dst + 8);
+        break;
+    }
+    case TYPE_FLOAT: {
+        float f = *reinterpret_cast<const float*>(value);
+        // -0.0 equals 0.0
+        f = f == 0 ? 0 : f;
+        uint32_t bits = 0;
+        memcpy(&bits, &f, sizeof(bits));
+        put_big_endian((bits & 0x80000000U) ? ~bits : (bits | 0x80000000U), 4, dst);
+        break;
+    }
+    case TYPE_DOUBLE: {
+        double d = *reinterpret_cast<const double*>(value);
+        d = d == 0 ? 0 : d;
+        uint64_t bits = 0;
+        memcpy(&bits, &d, sizeof(bits));
+        put_big_endian((bits & (1ULL << 63)) ? ~bits : (bits | (1ULL << 63)), 8, dst);
+        break;
+    }
+    case TYPE_DATE:
+    case TYPE_DATETIME: {
+        int64_t packed =
+            reinterpret_cast<const DateTimeValue*>(value)->to_int64_datetime_packed();
+        put_big_endian((uint64_t) packed ^ (1ULL << 63), 8, dst);
+        break;
+    }
+    case TYPE_CHAR:
+    case TYPE_VARCHAR: {
+        // shorter strings are padded with zeros, the exprs break the ties
+        const StringValue* sv = reinterpret_cast<const StringValue*>(value);
+        int len = std::min(sv->len, width);
+        memcpy(dst, sv->ptr, len);
+        memset(dst + len, 0, width - len);
+        break;
+    }
+    default:
+        DCHECK(false) << "invalid type: " << type.type;
+    }
+    if (!is_asc) {
+        for (int i = 0; i < width; ++i) {
+            dst[i] = ~dst[i];
+        }
+    }
+}
+
+}
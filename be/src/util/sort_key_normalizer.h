@@ -0,0 +1,95 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_UTIL_SORT_KEY_NORMALIZER_H
+#define BDG_PALO_BE_SRC_UTIL_SORT_KEY_NORMALIZER_H
+
+#include <stdint.h>
+
+#include <vector>
+
+namespace palo {
+
+class ExprContext;
+class TupleRow;
+class TupleRowComparator;
+struct TypeDescriptor;
+
+// Encodes the ordering keys of a row into bytes that memcmp orders like the keys
+// compare, so that a sort compares most rows without evaluating the exprs.
+// A key is one indicator byte, which puts NULLs first or last, followed by the value:
+// integers are big endian with the sign bit flipped, the bits of negative floats are
+// inverted, strings keep a prefix padded with zeros, and the value bytes of a DESC key
+// are inverted. Keys after a string or a type that can't be normalized are left out,
+// ties of such keys must be broken by comparing the rows.
+class SortKeyNormalizer {
+public:
+    SortKeyNormalizer();
+
+    // Normalizes the longest prefix of 'key_expr_ctxs' that can be. 'nulls_first' is
+    // -1 for a key whose NULLs go first and 1 otherwise, like in TupleRowComparator.
+    void init(const std::vector<ExprContext*>& key_expr_ctxs,
+              const std::vector<bool>& is_asc,
+              const std::vector<int8_t>& nulls_first);
+
+    // Initializes with the exprs and the order of 'comparator', evaluating the lhs exprs.
+    void init(const TupleRowComparator& comparator);
+
+    // Bytes of a normalized key, 0 if the first key can't be normalized.
+    int width() const {
+        return _width;
+    }
+
+    // True if the normalized keys of two rows are equal only if their keys are.
+    bool complete() const {
+        return _complete;
+    }
+
+    // Writes the width() bytes of the normalized key of 'row' to 'dst'.
+    void encode(TupleRow* row, uint8_t* dst) const;
+
+    // Bytes of memory sort_tuples() takes for 'num_tuples' tuples.
+    int64_t sort_memory(int64_t num_tuples) const;
+
+    // Sorts the 'num_tuples' tuples of 'tuple_size' bytes at 'tuples' by a radix sort of
+    // their normalized keys, and by 'less_than' where they tie and the keys are not complete. The tuples are
+    // moved in place, so that tuples[i] holds the i-th smallest one afterwards.
+    // width() must not be 0.
+    void sort_tuples(uint8_t** tuples, int64_t num_tuples, int tuple_size,
+                     const TupleRowComparator& less_than) const;
+
+    // Returns the bytes a value of 'type' takes in a normalized key, not counting the
+    // null indicator, or 0 if the type can't be normalized. Sets 'complete' to false if
+    // the bytes are only a prefix of the value.
+    static int value_width(const TypeDescriptor& type, bool* complete);
+
+    // Writes the 'width' bytes of 'value' to 'dst', 'width' is value_width() of 'type'.
+    static void encode_value(const void* value, const TypeDescriptor& type, int width,
+                             bool is_asc, uint8_t* dst);
+
+private:
+    // The normalized keys
+    std::vector<ExprContext*> _key_expr_ctxs;
+    std::vector<int> _value_widths;
+    std::vector<bool> _is_asc;
+    std::vector<bool> _nulls_first;
+
+    int _width;
+    bool _complete;
+};
+
+}
+
+#endif
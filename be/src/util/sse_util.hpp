@@ -21,6 +21,8 @@
 #ifndef BDG_PALO_BE_SRC_COMMON_UTIL_SSE_UTIL_H
 #define BDG_PALO_BE_SRC_COMMON_UTIL_SSE_UTIL_H
 
+#include <stddef.h>
+
 #include <nmmintrin.h>
 #include <smmintrin.h>
 
@@ -72,6 +74,28 @@ static const int SSE_BITMASK[CHARS_PER_128_BIT_REGISTER] = {
     1 << 15,
 };
 
+// Calls 'f' with the offset of every byte in [data, data + len) that equals 'c', in
+// ascending order. Compares 16 bytes at a time, which is several times faster than a
+// byte loop for finding the separators of text lines.
+template <typename F>
+inline void for_each_char(const char* data, size_t len, char c, F f) {
+    const __m128i pattern = _mm_set1_epi8(c);
+    size_t i = 0;
+    for (; i + CHARS_PER_128_BIT_REGISTER <= len; i += CHARS_PER_128_BIT_REGISTER) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern));
+        while (mask != 0) {
+            f(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    for (; i < len; ++i) {
+        if (data[i] == c) {
+            f(i);
+        }
+    }
+}
+
 }
 }
 
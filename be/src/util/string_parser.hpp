@@ -47,11 +47,14 @@ namespace palo {
 // data type.  This is different from hive, which returns NULL for overflow slots for int types
 // and inf/-inf for float types.
 //
+// Integers are parsed eight digits at a time (see parse_eight_digits()) as long as the
+// input has that many digits left. Floats without exponent and with few enough digits are
+// converted exactly with one division (see string_to_float_exact()).
+//
 // Things we tried that did not work:
 //  - lookup table for converting character to digit
 // Improvements (TODO):
 //  - Validate input using _sidd_compare_ranges
-//  - Since we know the length, we can parallelize this: i.e. result = 100*s[0] + 10*s[1] + s[2]
 class StringParser {
 public:
     enum ParseResult {
@@ -149,6 +152,33 @@ private:
     template <typename T>
     static inline T string_to_float_internal(const char* s, int len, ParseResult* result);
 
+    // Parses '[+-]digits[.digits]' followed by optional whitespace if the digits, without
+    // the decimal point, are an integer of at most 2^53 and there are at most 22 digits
+    // after the point. Both are exact doubles then, so their quotient is the correctly
+    // rounded result, as strtod() returns it. Returns false for any other input.
+    template <typename T>
+    static inline bool string_to_float_exact(const char* s, int len, T* val);
+
+    // Returns true if all eight bytes of 'chunk', loaded from a string, are digits.
+    static inline bool is_eight_digits(uint64_t chunk) {
+        // A digit is 0x30 - 0x39: its high nibble must be 3 and adding 6 must not carry
+        // into the high nibble.
+        return ((chunk & 0xF0F0F0F0F0F0F0F0ULL)
+                | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+            == 0x3333333333333333ULL;
+    }
+
+    // Returns the number of the eight digits in 'chunk', which is loaded from a string
+    // (first digit in the lowest byte, i.e. little endian).
+    static inline uint32_t parse_eight_digits(uint64_t chunk) {
+        chunk -= 0x3030303030303030ULL;
+        // Combine pairs of digits, then pairs of two-digit numbers and so on
+        chunk = (chunk * 10) + (chunk >> 8);
+        chunk = (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32)))
+                + (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+        return static_cast<uint32_t>(chunk);
+    }
+
     // parses a string for 'true' or 'false', case insensitive
     // Return PARSE_FAILURE on leading whitespace. Trailing whitespace is allowed.
     static inline bool string_to_bool_internal(const char* s, int len, ParseResult* result);
@@ -300,14 +330,26 @@ inline T StringParser::string_to_int_no_overflow(const char* s, int len, ParseRe
         *result = PARSE_SUCCESS;
         return val;
     }
-    // Factor out the first char for error handling speeds up the loop.
-    if (LIKELY(s[0] >= '0' && s[0] <= '9')) {
-        val = s[0] - '0';
-    } else {
-        *result = PARSE_FAILURE;
-        return 0;
+    int i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t chunk;
+        memcpy(&chunk, s + i, sizeof(chunk));
+        if (!is_eight_digits(chunk)) {
+            break;
+        }
+        val = static_cast<T>(val * 100000000 + parse_eight_digits(chunk));
+    }
+    if (i == 0) {
+        // Factor out the first char for error handling speeds up the loop.
+        if (LIKELY(s[0] >= '0' && s[0] <= '9')) {
+            val = s[0] - '0';
+        } else {
+            *result = PARSE_FAILURE;
+            return 0;
+        }
+        i = 1;
     }
-    for (int i = 1; i < len; ++i) {
+    for (; i < len; ++i) {
         if (LIKELY(s[i] >= '0' && s[i] <= '9')) {
             T digit = s[i] - '0';
             val = val * 10 + digit;
@@ -330,6 +372,11 @@ inline T StringParser::string_to_float_internal(const char* s, int len, ParseRes
         *result = PARSE_FAILURE;
         return 0;
     }
+    T exact_val;
+    if (LIKELY(string_to_float_exact(s, len, &exact_val))) {
+        *result = PARSE_SUCCESS;
+        return exact_val;
+    }
 
     // Use double here to not lose precision while accumulating the result
     double val = 0;
@@ -441,6 +488,47 @@ inline T StringParser::string_to_float_internal(const char* s, int len, ParseRes
     return (T)(negative ? -val : val);
 }
 
+template <typename T>
+inline bool StringParser::string_to_float_exact(const char* s, int len, T* val) {
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    bool negative = false;
+    int i = 0;
+    switch (*s) {
+    case '-':
+        negative = true;
+    case '+':
+        i = 1;
+    }
+    uint64_t mantissa = 0;
+    int num_digits = 0;
+    int frac_digits = 0;
+    bool decimal = false;
+    for (; i < len; ++i) {
+        if (LIKELY(s[i] >= '0' && s[i] <= '9')) {
+            // 19 digits always fit into uint64_t
+            if (UNLIKELY(++num_digits > 19)) {
+                return false;
+            }
+            mantissa = mantissa * 10 + (s[i] - '0');
+            frac_digits += decimal;
+        } else if (s[i] == '.' && !decimal) {
+            decimal = true;
+        } else if (num_digits > 0 && is_all_whitespace(s + i, len - i)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    if (num_digits == 0 || mantissa > (1ULL << 53) || frac_digits > 22) {
+        return false;
+    }
+    double result = static_cast<double>(mantissa) / pow10[frac_digits];
+    *val = static_cast<T>(negative ? -result : result);
+    return true;
+}
+
 inline bool StringParser::string_to_bool_internal(const char* s, int len, ParseResult* result) {
     *result = PARSE_SUCCESS;
 
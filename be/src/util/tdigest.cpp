@@ -0,0 +1,163 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/tdigest.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace palo {
+
+const double TDigest::DEFAULT_COMPRESSION = 100;
+
+TDigest::TDigest(double compression) :
+        _compression(compression),
+        _min(std::numeric_limits<double>::max()),
+        _max(-std::numeric_limits<double>::max()),
+        _total_weight(0) {
+}
+
+void TDigest::add(double value, double weight) {
+    _unmerged.push_back(Centroid(value, weight));
+    _min = std::min(_min, value);
+    _max = std::max(_max, value);
+    _total_weight += weight;
+    // Compressing sorts the buffer, so don't do it for every value
+    if (_unmerged.size() >= 10 * _compression) {
+        compress();
+    }
+}
+
+void TDigest::merge(TDigest* other) {
+    other->compress();
+    for (int i = 0; i < other->_centroids.size(); ++i) {
+        add(other->_centroids[i].mean, other->_centroids[i].weight);
+    }
+    if (!other->empty()) {
+        _min = std::min(_min, other->_min);
+        _max = std::max(_max, other->_max);
+    }
+}
+
+bool TDigest::merge_serialized(const char* data, size_t len) {
+    double header[3];
+    uint32_t num_centroids = 0;
+    if (len < sizeof(header) + sizeof(num_centroids)) {
+        return false;
+    }
+    memcpy(header, data, sizeof(header));
+    memcpy(&num_centroids, data + sizeof(header), sizeof(num_centroids));
+    data += sizeof(header) + sizeof(num_centroids);
+    len -= sizeof(header) + sizeof(num_centroids);
+    if (len != num_centroids * 2 * sizeof(double)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < num_centroids; ++i) {
+        double centroid[2];
+        memcpy(centroid, data, sizeof(centroid));
+        data += sizeof(centroid);
+        add(centroid[0], centroid[1]);
+    }
+    if (num_centroids > 0) {
+        _min = std::min(_min, header[1]);
+        _max = std::max(_max, header[2]);
+    }
+    return true;
+}
+
+void TDigest::compress() {
+    if (_unmerged.empty()) {
+        return;
+    }
+    _unmerged.insert(_unmerged.end(), _centroids.begin(), _centroids.end());
+    std::sort(_unmerged.begin(), _unmerged.end());
+    _centroids.clear();
+
+    // A centroid covering the quantiles [q0, q2] may have a weight of at most
+    // 4 * total * q * (1 - q) / compression, with q the one of q0, q2 closer to a tail.
+    Centroid current = _unmerged[0];
+    double weight_so_far = 0;
+    double normalizer = 4 * _total_weight / _compression;
+    for (int i = 1; i < _unmerged.size(); ++i) {
+        const Centroid& next = _unmerged[i];
+        double proposed_weight = current.weight + next.weight;
+        double q0 = weight_so_far / _total_weight;
+        double q2 = (weight_so_far + proposed_weight) / _total_weight;
+        double limit = normalizer * std::min(q0 * (1 - q0), q2 * (1 - q2));
+        if (proposed_weight <= limit) {
+            current.mean += (next.mean - current.mean) * next.weight / proposed_weight;
+            current.weight = proposed_weight;
+        } else {
+            weight_so_far += current.weight;
+            _centroids.push_back(current);
+            current = next;
+        }
+    }
+    _centroids.push_back(current);
+    _unmerged.clear();
+}
+
+double TDigest::quantile(double q) {
+    compress();
+    if (_centroids.size() == 1) {
+        return _centroids[0].mean;
+    }
+
+    // Interpolate between the centers of the two centroids around 'index', treating
+    // min and max as the centers of centroids of weight 0.
+    double index = q * _total_weight;
+    const Centroid& first = _centroids.front();
+    if (index < first.weight / 2) {
+        return _min + (first.mean - _min) * index / (first.weight / 2);
+    }
+    double weight_so_far = first.weight / 2;
+    for (int i = 1; i < _centroids.size(); ++i) {
+        double delta = (_centroids[i - 1].weight + _centroids[i].weight) / 2;
+        if (index < weight_so_far + delta) {
+            double left = _centroids[i - 1].mean;
+            double right = _centroids[i].mean;
+            return left + (right - left) * (index - weight_so_far) / delta;
+        }
+        weight_so_far += delta;
+    }
+    const Centroid& last = _centroids.back();
+    double remaining = last.weight / 2;
+    double offset = std::min(index - weight_so_far, remaining);
+    return last.mean + (_max - last.mean) * offset / remaining;
+}
+
+size_t TDigest::serialized_size() {
+    compress();
+    return 3 * sizeof(double) + sizeof(uint32_t) + _centroids.size() * 2 * sizeof(double);
+}
+
+void TDigest::serialize(char* dst) {
+    compress();
+    double header[3] = { _compression, _min, _max };
+    uint32_t num_centroids = _centroids.size();
+    memcpy(dst, header, sizeof(header));
+    memcpy(dst + sizeof(header), &num_centroids, sizeof(num_centroids));
+    dst += sizeof(header) + sizeof(num_centroids);
+    for (int i = 0; i < _centroids.size(); ++i) {
+        double centroid[2] = { _centroids[i].mean, _centroids[i].weight };
+        memcpy(dst, centroid, sizeof(centroid));
+        dst += sizeof(centroid);
+    }
+}
+
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_UTIL_TDIGEST_H
+#define BDG_PALO_BE_SRC_UTIL_TDIGEST_H
+
+#include <stddef.h>
+
+#include <vector>
+
+namespace palo {
+
+// Mergeable sketch of a distribution of doubles for approximate quantiles (Dunning's
+// merging t-digest). The values are summarized by centroids (mean, weight) that are
+// small near the tails and larger around the median, so that extreme quantiles stay
+// accurate. Size and error are bounded by 'compression': a digest keeps at most about
+// 2 * compression centroids no matter how many values were added, and digests built on
+// different nodes can be merged without loss beyond that of a single digest.
+//
+// Serialized format, in host byte order:
+//   double compression, double min, double max, uint32 number of centroids, then
+//   (double mean, double weight) for every centroid in ascending mean order
+class TDigest {
+public:
+    static const double DEFAULT_COMPRESSION;
+
+    TDigest(double compression = DEFAULT_COMPRESSION);
+
+    void add(double value, double weight = 1);
+
+    void merge(TDigest* other);
+
+    // Merges a digest in the format written by serialize(). Returns false if 'data' is
+    // not a valid serialized digest.
+    bool merge_serialized(const char* data, size_t len);
+
+    // Returns the approximate value at quantile 'q' in [0, 1]. The digest must not be
+    // empty.
+    double quantile(double q);
+
+    bool empty() const {
+        return _total_weight == 0;
+    }
+
+    size_t serialized_size();
+
+    // Writes serialized_size() bytes to 'dst'.
+    void serialize(char* dst);
+
+private:
+    struct Centroid {
+        Centroid(double mean_, double weight_) : mean(mean_), weight(weight_) { }
+
+        bool operator<(const Centroid& other) const {
+            return mean < other.mean;
+        }
+
+        double mean;
+        double weight;
+    };
+
+    // Merges the buffered values into the centroids.
+    void compress();
+
+    double _compression;
+    double _min;
+    double _max;
+    double _total_weight;
+    // Sorted by mean and compressed
+    std::vector<Centroid> _centroids;
+    // Values added since the last compress()
+    std::vector<Centroid> _unmerged;
+};
+
+}
+
+#endif // BDG_PALO_BE_SRC_UTIL_TDIGEST_H
@@ -0,0 +1,33 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_SRC_UTIL_THREAD_NAME_H
+#define BDG_PALO_BE_SRC_UTIL_THREAD_NAME_H
+
+#include <sys/prctl.h>
+
+#include <string>
+
+namespace palo {
+
+// Names the calling thread as shown by top -H, gdb and the CPU profiles of
+// /pprof/flamegraph. Linux keeps the first 15 characters.
+inline void set_current_thread_name(const std::string& name) {
+    prctl(PR_SET_NAME, name.c_str(), 0, 0, 0);
+}
+
+}
+
+#endif
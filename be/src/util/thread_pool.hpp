@@ -22,6 +22,7 @@
 #define BDG_PALO_BE_SRC_COMMON_UTIL_THREAD_POOL_HPP
 
 #include "util/blocking_queue.hpp"
+#include "util/thread_name.h"
 
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
@@ -44,7 +45,10 @@ public:
     //     queue exceeds this size, subsequent calls to Offer will block until there is
     //     capacity available.
     //  -- work_function: the function to run every time an item is consumed from the queue
-    ThreadPool(uint32_t num_threads, uint32_t queue_size) : 
+    //  -- name: the name of the threads
+    ThreadPool(uint32_t num_threads, uint32_t queue_size,
+               const std::string& name = "thread_pool") :
+            _name(name),
             _work_queue(queue_size),
             _shutdown(false) {
         for (int i = 0; i < num_threads; ++i) {
@@ -116,6 +120,7 @@ private:
     // Driver method for each thread in the pool. Continues to read work from the queue
     // until the pool is shutdown.
     void work_thread(int thread_id) {
+        set_current_thread_name(_name);
         while (!is_shutdown()) {
             WorkFunction work_function;
 
@@ -135,6 +140,8 @@ private:
         return _shutdown;
     }
 
+    const std::string _name;
+
     // Queue on which work items are held until a thread is available to process them in
     // FIFO order.
     BlockingQueue<WorkFunction> _work_queue;
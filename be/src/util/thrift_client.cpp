@@ -20,6 +20,8 @@
 
 #include <util/thrift_client.h>
 
+#include <poll.h>
+
 #include <ostream>
 
 #include <boost/assign.hpp>
@@ -68,6 +70,19 @@ Status ThriftClientImpl::open_with_retry(int num_tries, int wait_ms) {
     return status;
 }
 
+bool ThriftClientImpl::is_alive() {
+    if (!_transport->isOpen()) {
+        return false;
+    }
+    // Nothing is sent to an idle client, so the socket is only readable if the server
+    // closed the connection or it failed.
+    struct pollfd fd;
+    fd.fd = _socket->getSocketFD();
+    fd.events = POLLIN;
+    fd.revents = 0;
+    return poll(&fd, 1, 0) == 0;
+}
+
 Status ThriftClientImpl::close() {
     if (_transport->isOpen()) {
         _transport->close();
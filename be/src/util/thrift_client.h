@@ -67,6 +67,10 @@ public:
     // repeatedly.
     Status close();
 
+    // Returns false if the connection is closed or the server closed its end. Must only
+    // be called while no rpc is in progress.
+    bool is_alive();
+
     // Set the connect timeout
     void set_conn_timeout(int ms) {
         _socket->setConnTimeout(ms);
@@ -86,6 +90,8 @@ protected:
             _ipaddress(ipaddress),
             _port(port),
             _socket(new apache::thrift::transport::TSocket(ipaddress, port)) {
+        // lets the kernel find connections to hosts that went away while they were idle
+        _socket->setKeepAlive(true);
     }
 
 private:
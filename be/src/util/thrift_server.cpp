@@ -35,8 +35,40 @@
 #include <thrift/transport/TSocket.h>
 #include <thrift/transport/TServerSocket.h>
 
+#include "util/histogram_metric.h"
+#include "util/stopwatch.hpp"
+
 namespace palo {
 
+// Records the time every call takes in the rpc latency histogram of a server, by method.
+class RpcLatencyEventHandler : public apache::thrift::TProcessorEventHandler {
+public:
+    RpcLatencyEventHandler(HistogramFamily* latency) : _latency(latency) {
+    }
+
+    virtual ~RpcLatencyEventHandler() {
+    }
+
+    // The context of a call is its stop watch
+    virtual void* getContext(const char* fn_name, void* server_context) {
+        MonotonicStopWatch* watch = new MonotonicStopWatch();
+        watch->start();
+        return watch;
+    }
+
+    virtual void freeContext(void* ctx, const char* fn_name) {
+        MonotonicStopWatch* watch = static_cast<MonotonicStopWatch*>(ctx);
+        _latency->get(fn_name)->update(watch->elapsed_time());
+        delete watch;
+    }
+
+private:
+    HistogramFamily* _latency;
+};
+
+// Bound of the methods the rpc latency histogram tells apart, more than any service has
+static const int MAX_RPC_METHODS = 100;
+
 // Helper class that starts a server in a separate thread, and handles
 // the inter-thread communication to monitor whether it started
 // correctly.
@@ -286,6 +318,11 @@ ThriftServer::ThriftServer(
         std::stringstream max_ss;
         max_ss << "palo_be.thrift_server." << name << ".total_connections";
         _total_connections_metric = metrics->AddCounter(max_ss.str(), 0L);
+        HistogramFamily* rpc_latency = metrics->register_metric(new HistogramFamily(
+                    MetricDefs::Get("palo_be.thrift_server.$0.rpc_latency", name),
+                    "method", MAX_RPC_METHODS));
+        _processor->setEventHandler(boost::shared_ptr<apache::thrift::TProcessorEventHandler>(
+                    new RpcLatencyEventHandler(rpc_latency)));
     } else {
         _metrics_enabled = false;
     }
@@ -100,6 +100,40 @@ public:
             _codegend_compare_fn(NULL) {
     }
 
+    // Copies the sort order of 'other' but evaluates 'key_expr_ctxs_lhs' and
+    // 'key_expr_ctxs_rhs', which must be clones of the exprs of 'other'. ExprContexts
+    // cannot be evaluated by several threads at once, so each thread comparing rows
+    // needs a comparator of its own.
+    TupleRowComparator(
+            const TupleRowComparator& other,
+            const std::vector<ExprContext*>& key_expr_ctxs_lhs,
+            const std::vector<ExprContext*>& key_expr_ctxs_rhs) :
+                _key_expr_ctxs_lhs(key_expr_ctxs_lhs),
+                _key_expr_ctxs_rhs(key_expr_ctxs_rhs),
+                _is_asc(other._is_asc),
+                _nulls_first(other._nulls_first),
+                _codegend_compare_fn(other._codegend_compare_fn) {
+        DCHECK_EQ(key_expr_ctxs_lhs.size(), other._key_expr_ctxs_lhs.size());
+        DCHECK_EQ(key_expr_ctxs_rhs.size(), other._key_expr_ctxs_rhs.size());
+    }
+
+    const std::vector<ExprContext*>& key_expr_ctxs_lhs() const {
+        return _key_expr_ctxs_lhs;
+    }
+
+    const std::vector<ExprContext*>& key_expr_ctxs_rhs() const {
+        return _key_expr_ctxs_rhs;
+    }
+
+    const std::vector<bool>& is_asc() const {
+        return _is_asc;
+    }
+
+    // -1 for a key whose NULLs go first, 1 otherwise
+    const std::vector<int8_t>& nulls_first() const {
+        return _nulls_first;
+    }
+
     // Returns a negative value if lhs is less than rhs, a positive value if lhs is greater
     // than rhs, or 0 if they are equal. All exprs (_key_exprs_lhs and _key_exprs_rhs)
     // must have been prepared and opened before calling this. i.e. 'sort_key_exprs' in the
@@ -0,0 +1,121 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "agent/tablet_report_tracker.h"
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "util/logging.h"
+
+namespace palo {
+
+static void add_tablet(TReportRequest* request, TTabletId tablet_id, TVersion version) {
+    TTabletInfo info;
+    info.tablet_id = tablet_id;
+    info.schema_hash = 1;
+    info.version = version;
+    info.version_hash = 0;
+    info.row_count = 10;
+    info.data_size = 100;
+    request->tablets[tablet_id].tablet_infos.push_back(info);
+}
+
+TEST(TabletReportTrackerTest, Incremental) {
+    config::report_olap_table_full_interval_seconds = 3600;
+    TabletReportTracker tracker;
+
+    TReportRequest request;
+    add_tablet(&request, 1, 2);
+    add_tablet(&request, 2, 2);
+    add_tablet(&request, 3, 2);
+    ASSERT_FALSE(tracker.prepare(1, &request));
+    ASSERT_EQ(3, request.tablets.size());
+    tracker.acknowledge(true);
+
+    // only the changes since the acknowledged report are sent
+    request = TReportRequest();
+    add_tablet(&request, 1, 2);
+    add_tablet(&request, 2, 3);
+    add_tablet(&request, 4, 2);
+    ASSERT_TRUE(tracker.prepare(1, &request));
+    ASSERT_EQ(2, request.tablets.size());
+    ASSERT_EQ(1, request.tablets.count(2));
+    ASSERT_EQ(1, request.tablets.count(4));
+    ASSERT_EQ(1, request.removed_tablets.size());
+    ASSERT_EQ(1, request.removed_tablets.count(3));
+
+    // without an acknowledgement they are sent again
+    request = TReportRequest();
+    add_tablet(&request, 1, 2);
+    add_tablet(&request, 2, 3);
+    add_tablet(&request, 4, 2);
+    ASSERT_TRUE(tracker.prepare(1, &request));
+    ASSERT_EQ(2, request.tablets.size());
+    ASSERT_EQ(1, request.removed_tablets.size());
+    tracker.acknowledge(true);
+
+    request = TReportRequest();
+    add_tablet(&request, 1, 2);
+    add_tablet(&request, 2, 3);
+    add_tablet(&request, 4, 2);
+    ASSERT_TRUE(tracker.prepare(1, &request));
+    ASSERT_TRUE(request.tablets.empty());
+    ASSERT_TRUE(request.removed_tablets.empty());
+
+    // a new master gets a full report
+    request = TReportRequest();
+    add_tablet(&request, 1, 2);
+    ASSERT_FALSE(tracker.prepare(2, &request));
+    ASSERT_EQ(1, request.tablets.size());
+}
+
+TEST(TabletReportTrackerTest, OldMaster) {
+    config::report_olap_table_full_interval_seconds = 3600;
+    TabletReportTracker tracker;
+    TReportRequest request;
+    add_tablet(&request, 1, 2);
+    add_tablet(&request, 2, 2);
+    ASSERT_FALSE(tracker.prepare(1, &request));
+    tracker.acknowledge(false);
+
+    // a master that doesn't know incremental reports only gets full ones
+    ASSERT_FALSE(tracker.prepare(1, &request));
+    ASSERT_EQ(2, request.tablets.size());
+    ASSERT_FALSE(request.__isset.incremental);
+    tracker.acknowledge(true);
+
+    ASSERT_TRUE(tracker.prepare(1, &request));
+    ASSERT_TRUE(request.tablets.empty());
+}
+
+TEST(TabletReportTrackerTest, FullInterval) {
+    config::report_olap_table_full_interval_seconds = 0;
+    TabletReportTracker tracker;
+    TReportRequest request;
+    add_tablet(&request, 1, 2);
+    ASSERT_FALSE(tracker.prepare(1, &request));
+    tracker.acknowledge(true);
+    ASSERT_FALSE(tracker.prepare(1, &request));
+    ASSERT_EQ(1, request.tablets.size());
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
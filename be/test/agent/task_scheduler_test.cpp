@@ -0,0 +1,110 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "agent/task_scheduler.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "util/logging.h"
+
+namespace palo {
+
+static TAgentTaskRequest make_task(TTaskType::type type, int64_t signature) {
+    TAgentTaskRequest task;
+    task.task_type = type;
+    task.signature = signature;
+    return task;
+}
+
+TEST(AgentTaskSchedulerTest, Priority) {
+    config::agent_task_priority_aging_seconds = 0;
+    TAgentTaskRequest urgent = make_task(TTaskType::CLONE, 1);
+    urgent.__set_priority(TPriority::HIGH);
+    ASSERT_EQ(AgentTaskScheduler::HIGH, AgentTaskScheduler::priority_of(urgent));
+    ASSERT_EQ(AgentTaskScheduler::NORMAL,
+              AgentTaskScheduler::priority_of(make_task(TTaskType::CLONE, 2)));
+    ASSERT_EQ(AgentTaskScheduler::LOW,
+              AgentTaskScheduler::priority_of(make_task(TTaskType::SCHEMA_CHANGE, 3)));
+
+    AgentTaskScheduler scheduler(1, 0);
+    TAgentTaskRequest alter = make_task(TTaskType::SCHEMA_CHANGE, 3);
+    scheduler.task_queued(alter);
+    scheduler.task_queued(urgent);
+
+    std::vector<int64_t> order;
+    std::mutex order_lock;
+    auto run = [&scheduler, &order, &order_lock](const TAgentTaskRequest& task) {
+        AgentTaskScheduler::Slot slot(&scheduler, task, "");
+        std::lock_guard<std::mutex> l(order_lock);
+        order.push_back(task.signature);
+    };
+    std::unique_ptr<std::thread> alter_thread;
+    std::unique_ptr<std::thread> urgent_thread;
+    {
+        AgentTaskScheduler::Slot slot(&scheduler, make_task(TTaskType::PUSH, 4), "");
+        // the alter waits first, the urgent clone still runs before it
+        alter_thread.reset(new std::thread(run, alter));
+        usleep(50 * 1000);
+        urgent_thread.reset(new std::thread(run, urgent));
+        usleep(50 * 1000);
+        ASSERT_TRUE(order.empty());
+    }
+    alter_thread->join();
+    urgent_thread->join();
+    ASSERT_EQ(2, order.size());
+    ASSERT_EQ(1, order[0]);
+    ASSERT_EQ(3, order[1]);
+
+    std::stringstream ss;
+    scheduler.debug(&ss);
+    ASSERT_NE(std::string::npos, ss.str().find("SCHEMA_CHANGE\t0\t1\t"));
+}
+
+TEST(AgentTaskSchedulerTest, PerDisk) {
+    AgentTaskScheduler scheduler(0, 1);
+    std::atomic<bool> started(false);
+    std::unique_ptr<std::thread> waiter;
+    {
+        AgentTaskScheduler::Slot slot(&scheduler, make_task(TTaskType::PUSH, 1), "/data1");
+        // other disks and unknown ones have room
+        AgentTaskScheduler::Slot other(&scheduler, make_task(TTaskType::PUSH, 2), "/data2");
+        AgentTaskScheduler::Slot unknown(&scheduler, make_task(TTaskType::CLONE, 3), "");
+        waiter.reset(new std::thread([&scheduler, &started] {
+            AgentTaskScheduler::Slot slot(&scheduler, make_task(TTaskType::PUSH, 4), "/data1");
+            started = true;
+        }));
+        usleep(50 * 1000);
+        ASSERT_FALSE(started);
+    }
+    waiter->join();
+    ASSERT_TRUE(started);
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -763,6 +763,49 @@ TEST(TaskWorkerPoolTest, TestPush) {
     task_worker_pool._pusher = original_pusher;
 }
 
+TEST(TaskWorkerPoolTest, TestTakePushBatch) {
+    TMasterInfo master_info;
+    TaskWorkerPool task_worker_pool(
+            TaskWorkerPool::TaskWorkerType::PUSH,
+            master_info);
+    config::push_batch_max_tasks = 3;
+    config::push_batch_window_ms = 0;
+
+    auto push_task = [](int64_t signature, TTabletId tablet_id, int64_t version,
+                        TPushType::type push_type) {
+        TAgentTaskRequest task;
+        task.task_type = TTaskType::PUSH;
+        task.signature = signature;
+        task.push_req.tablet_id = tablet_id;
+        task.push_req.schema_hash = 1;
+        task.push_req.version = version;
+        task.push_req.push_type = push_type;
+        return task;
+    };
+    task_worker_pool._tasks.push_back(push_task(1, 10, 3, TPushType::LOAD));
+    task_worker_pool._tasks.push_back(push_task(2, 11, 3, TPushType::LOAD));
+    task_worker_pool._tasks.push_back(push_task(3, 10, 5, TPushType::LOAD));
+    task_worker_pool._tasks.push_back(push_task(4, 10, 4, TPushType::DELETE));
+    task_worker_pool._tasks.push_back(push_task(5, 10, 4, TPushType::LOAD));
+    task_worker_pool._tasks.push_back(push_task(6, 10, 6, TPushType::LOAD));
+
+    // versions 3 and 4 follow, 5 is beyond the limit
+    vector<TAgentTaskRequest> batch(1, push_task(7, 10, 2, TPushType::LOAD));
+    task_worker_pool._take_push_batch(&batch);
+    ASSERT_EQ(3, batch.size());
+    EXPECT_EQ(1, batch[1].signature);
+    EXPECT_EQ(5, batch[2].signature);
+    ASSERT_EQ(4, task_worker_pool._tasks.size());
+
+    // nothing follows version 3 of tablet 11
+    vector<TAgentTaskRequest> single(1, push_task(8, 11, 3, TPushType::LOAD));
+    task_worker_pool._take_push_batch(&single);
+    EXPECT_EQ(1, single.size());
+
+    task_worker_pool._tasks.clear();
+    config::push_batch_max_tasks = 8;
+}
+
 TEST(TaskWorkerPoolTest, TestClone) {
     TMasterInfo master_info;
     TAgentTaskRequest agent_task_request;
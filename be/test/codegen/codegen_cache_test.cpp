@@ -0,0 +1,96 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "codegen/codegen_cache.h"
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "util/logging.h"
+
+namespace palo {
+
+static boost::shared_ptr<CodegenCache::Entry> make_entry(int fn) {
+    boost::shared_ptr<CodegenCache::Entry> entry(new CodegenCache::Entry());
+    entry->fn_ptrs.push_back(reinterpret_cast<void*>(fn));
+    return entry;
+}
+
+TEST(CodegenCacheTest, Disabled) {
+    CodegenCache cache(0);
+    cache.insert("a", make_entry(1));
+    EXPECT_TRUE(cache.lookup("a") == NULL);
+    EXPECT_TRUE(cache._entries.empty());
+}
+
+TEST(CodegenCacheTest, DisabledByDefault) {
+    EXPECT_EQ(0, config::codegen_cache_capacity);
+    CodegenCache::instance()->insert("a", make_entry(1));
+    EXPECT_TRUE(CodegenCache::instance()->lookup("a") == NULL);
+}
+
+TEST(CodegenCacheTest, Lookup) {
+    CodegenCache cache(4);
+    boost::shared_ptr<CodegenCache::Entry> entry = make_entry(1);
+    cache.insert("a", entry);
+    EXPECT_TRUE(cache.lookup("a") == entry);
+    EXPECT_TRUE(cache.lookup("b") == NULL);
+
+    // The first entry for a key stays.
+    cache.insert("a", make_entry(2));
+    EXPECT_TRUE(cache.lookup("a") == entry);
+    EXPECT_EQ(1, cache._entries.size());
+}
+
+TEST(CodegenCacheTest, EvictLeastRecentlyUsed) {
+    CodegenCache cache(2);
+    cache.insert("a", make_entry(1));
+    cache.insert("b", make_entry(2));
+    // "a" becomes the most recently used, "b" is evicted next.
+    ASSERT_TRUE(cache.lookup("a") != NULL);
+    cache.insert("c", make_entry(3));
+    EXPECT_TRUE(cache.lookup("a") != NULL);
+    EXPECT_TRUE(cache.lookup("b") == NULL);
+    EXPECT_TRUE(cache.lookup("c") != NULL);
+    EXPECT_EQ(2, cache._entries.size());
+    EXPECT_EQ(2, cache._index.size());
+}
+
+TEST(CodegenCacheTest, EvictedEntryStaysValid) {
+    CodegenCache cache(1);
+    boost::shared_ptr<CodegenCache::Entry> entry = make_entry(1);
+    cache.insert("a", entry);
+    boost::shared_ptr<CodegenCache::Entry> in_use = cache.lookup("a");
+    entry.reset();
+    cache.insert("b", make_entry(2));
+    EXPECT_TRUE(cache.lookup("a") == NULL);
+    // Still usable by the LlvmCodeGen that looked it up.
+    ASSERT_TRUE(in_use != NULL);
+    EXPECT_EQ(reinterpret_cast<void*>(1), in_use->fn_ptrs[0]);
+    EXPECT_TRUE(in_use.unique());
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,169 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "exec/async_file_writer.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+#include <lz4/lz4frame.h>
+#include <zstd/zstd.h>
+
+#include "exec/local_file_writer.h"
+
+namespace palo {
+
+// Fails every write after the first 'ok_writes' ones.
+class FailingFileWriter : public FileWriter {
+public:
+    FailingFileWriter(int ok_writes) : _ok_writes(ok_writes) { }
+
+    virtual Status open() override {
+        return Status::OK;
+    }
+
+    virtual Status write(const uint8_t* buf, size_t buf_len, size_t* written_len) override {
+        if (_ok_writes-- <= 0) {
+            return Status("write failed");
+        }
+        *written_len = buf_len;
+        return Status::OK;
+    }
+
+    virtual void close() override { }
+
+private:
+    int _ok_writes;
+};
+
+class AsyncFileWriterTest : public testing::Test {
+protected:
+    virtual void SetUp() {
+        std::stringstream ss;
+        ss << "./async_file_writer_test_" << getpid();
+        _path = ss.str();
+        for (int i = 0; i < 10000; ++i) {
+            _data += std::to_string(i) + "\t" + std::to_string(i * 7) + "\n";
+        }
+    }
+
+    virtual void TearDown() {
+        unlink(_path.c_str());
+    }
+
+    // Writes '_data' in pieces of different sizes.
+    Status write_data(TCompressKind::type compress_kind) {
+        AsyncFileWriter writer(new LocalFileWriter(_path, 0), compress_kind, 4096, 2);
+        RETURN_IF_ERROR(writer.open());
+        size_t offset = 0;
+        for (size_t len = 1; offset < _data.size(); len = len * 3 % 10007) {
+            len = std::min(len, _data.size() - offset);
+            size_t written_len = 0;
+            RETURN_IF_ERROR(writer.write(
+                    reinterpret_cast<const uint8_t*>(_data.data()) + offset, len, &written_len));
+            EXPECT_EQ(len, written_len);
+            offset += len;
+        }
+        RETURN_IF_ERROR(writer.finish());
+        EXPECT_EQ(read_file().size(), writer.bytes_written());
+        return Status::OK;
+    }
+
+    std::string read_file() {
+        std::ifstream in(_path, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+    std::string _path;
+    std::string _data;
+};
+
+TEST_F(AsyncFileWriterTest, Plain) {
+    ASSERT_TRUE(write_data(TCompressKind::NONE).ok());
+    ASSERT_EQ(_data, read_file());
+}
+
+TEST_F(AsyncFileWriterTest, Zstd) {
+    ASSERT_TRUE(write_data(TCompressKind::ZSTD).ok());
+    std::string compressed = read_file();
+    ASSERT_LT(compressed.size(), _data.size());
+    // a zstd frame per chunk
+    std::string decompressed(_data.size(), '\0');
+    size_t ret = ZSTD_decompress(&decompressed[0], decompressed.size(),
+                                 compressed.data(), compressed.size());
+    ASSERT_FALSE(ZSTD_isError(ret));
+    ASSERT_EQ(_data.size(), ret);
+    ASSERT_EQ(_data, decompressed);
+}
+
+TEST_F(AsyncFileWriterTest, Lz4) {
+    ASSERT_TRUE(write_data(TCompressKind::LZ4).ok());
+    std::string compressed = read_file();
+    ASSERT_LT(compressed.size(), _data.size());
+
+    LZ4F_dctx* dctx = nullptr;
+    ASSERT_FALSE(LZ4F_isError(LZ4F_createDecompressionContext(&dctx, LZ4F_VERSION)));
+    std::string decompressed;
+    size_t offset = 0;
+    while (offset < compressed.size()) {
+        char buf[8192];
+        size_t src_len = compressed.size() - offset;
+        size_t dst_len = sizeof(buf);
+        size_t ret = LZ4F_decompress(dctx, buf, &dst_len, compressed.data() + offset,
+                                     &src_len, nullptr);
+        ASSERT_FALSE(LZ4F_isError(ret));
+        offset += src_len;
+        decompressed.append(buf, dst_len);
+    }
+    LZ4F_freeDecompressionContext(dctx);
+    ASSERT_EQ(_data, decompressed);
+}
+
+TEST_F(AsyncFileWriterTest, WriteError) {
+    AsyncFileWriter writer(new FailingFileWriter(1), TCompressKind::NONE, 16, 1);
+    ASSERT_TRUE(writer.open().ok());
+    uint8_t buf[16] = { 0 };
+    Status status = Status::OK;
+    // the error shows up in a later write or in finish()
+    for (int i = 0; i < 10 && status.ok(); ++i) {
+        size_t written_len = 0;
+        status = writer.write(buf, sizeof(buf), &written_len);
+    }
+    if (status.ok()) {
+        status = writer.finish();
+    }
+    ASSERT_FALSE(status.ok());
+    ASSERT_FALSE(writer.finish().ok());
+}
+
+TEST_F(AsyncFileWriterTest, UnsupportedCompression) {
+    AsyncFileWriter writer(new FailingFileWriter(0), TCompressKind::LZO, 16, 1);
+    ASSERT_FALSE(writer.open().ok());
+}
+
+} // end namespace palo
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -21,6 +21,7 @@
 
 #include <gtest/gtest.h>
 
+#include "common/config.h"
 #include "common/object_pool.h"
 #include "runtime/tuple.h"
 #include "exec/local_file_reader.h"
@@ -344,6 +345,8 @@ void BrokerScanNodeTest::init() {
 }
 
 TEST_F(BrokerScanNodeTest, normal) {
+    // one scanner returns the batches in the order of the ranges
+    config::broker_scanner_num_threads = 1;
     BrokerScanNode scan_node(&_obj_pool, _tnode, *_desc_tbl);
     auto status = scan_node.prepare(&_runtime_state);
     ASSERT_TRUE(status.ok());
@@ -421,6 +424,58 @@ TEST_F(BrokerScanNodeTest, normal) {
     }
 }
 
+TEST_F(BrokerScanNodeTest, split) {
+    config::broker_scanner_num_threads = 4;
+    BrokerScanNode scan_node(&_obj_pool, _tnode, *_desc_tbl);
+    auto status = scan_node.prepare(&_runtime_state);
+    ASSERT_TRUE(status.ok());
+
+    std::vector<TScanRangeParams> scan_ranges;
+    {
+        TScanRangeParams scan_range_params;
+
+        TBrokerScanRange broker_scan_range;
+        broker_scan_range.params = _params;
+
+        // 24 bytes
+        TBrokerRangeDesc range;
+        range.path = "./be/test/exec/test_data/broker_scanner/normal.csv";
+        range.start_offset = 0;
+        range.size = 24;
+        range.file_type = TFileType::FILE_LOCAL;
+        range.format_type = TFileFormatType::FORMAT_CSV_PLAIN;
+        range.splittable = true;
+        broker_scan_range.ranges.push_back(range);
+
+        scan_range_params.scan_range.__set_broker_scan_range(broker_scan_range);
+
+        scan_ranges.push_back(scan_range_params);
+    }
+    BrokerScanNode::split_scan_ranges(10, &scan_ranges);
+    ASSERT_EQ(3, scan_ranges.size());
+    ASSERT_EQ(10, scan_ranges[1].scan_range.broker_scan_range.ranges[0].start_offset);
+    ASSERT_EQ(10, scan_ranges[1].scan_range.broker_scan_range.ranges[0].size);
+    ASSERT_EQ(20, scan_ranges[2].scan_range.broker_scan_range.ranges[0].start_offset);
+    ASSERT_EQ(4, scan_ranges[2].scan_range.broker_scan_range.ranges[0].size);
+
+    scan_node.set_scan_ranges(scan_ranges);
+    status = scan_node.open(&_runtime_state);
+    ASSERT_TRUE(status.ok());
+
+    // every line is read by exactly one of the scanners
+    int num_rows = 0;
+    bool eos = false;
+    while (!eos) {
+        RowBatch batch(scan_node.row_desc(), 1024, _runtime_state.instance_mem_tracker());
+        status = scan_node.get_next(&_runtime_state, &batch, &eos);
+        ASSERT_TRUE(status.ok());
+        num_rows += batch.num_rows();
+    }
+    ASSERT_EQ(3, num_rows);
+
+    scan_node.close(&_runtime_state);
+}
+
 }
 
 int main(int argc, char** argv) {
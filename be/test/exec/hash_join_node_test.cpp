@@ -0,0 +1,366 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/hash_join_node.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "common/object_pool.h"
+#include "runtime/mem_tracker.h"
+#include "runtime/shared_hash_table_mgr.h"
+#include "runtime/test_env.h"
+#include "testutil/join_test_util.h"
+#include "util/cpu_info.h"
+#include "util/disk_info.h"
+#include "util/logging.h"
+
+using std::string;
+using std::vector;
+
+using boost::scoped_ptr;
+
+namespace palo {
+
+static const int32_t NULL_VALUE = KeyValRow::NULL_VALUE;
+
+class HashJoinNodeTest : public testing::Test {
+public:
+    HashJoinNodeTest() : _next_query_id(0) {}
+    ~HashJoinNodeTest() {}
+
+protected:
+    virtual void SetUp() {
+        _test_env.reset(new TestEnv());
+        _plan.reset(new JoinTestPlan(&_pool));
+
+        // (key, val) of the probe rows
+        add_row(&_probe_rows, 1, 10);
+        add_row(&_probe_rows, 2, 20);
+        add_row(&_probe_rows, 3, 30);
+        add_row(&_probe_rows, NULL_VALUE, 40);
+        add_row(&_probe_rows, 5, NULL_VALUE);
+
+        // the build rows without NULL keys
+        add_row(&_build_rows, 1, 5);
+        add_row(&_build_rows, 1, 15);
+        add_row(&_build_rows, 2, 10);
+        add_row(&_build_rows, 6, 60);
+        _build_rows_with_null = _build_rows;
+        add_row(&_build_rows_with_null, NULL_VALUE, 25);
+    }
+
+    virtual void TearDown() {
+        // The nodes are destroyed before the runtime states their memory trackers
+        // belong to.
+        _pool.clear();
+        _test_env.reset();
+    }
+
+    static void add_row(vector<KeyValRow>* rows, int32_t key, int32_t val) {
+        KeyValRow row;
+        row.key = key;
+        row.val = val;
+        rows->push_back(row);
+    }
+
+    // Joins the probe rows with 'build_rows' and checks the sorted result.
+    void check_join(TJoinOp::type join_op, bool val_less_than,
+                    const vector<KeyValRow>& build_rows, vector<string> expected) {
+        SCOPED_TRACE(testing::Message() << "join op " << join_op
+                << ", probe.val < build.val " << val_less_than);
+        RuntimeState* state = NULL;
+        ASSERT_TRUE(_test_env->create_query_state(
+                _next_query_id++, -1, 8 * 1024 * 1024, &state).ok());
+        state->set_desc_tbl(_plan->desc_tbl());
+        state->init_mem_trackers(TUniqueId());
+
+        TPlanNode tnode = _plan->join_node(join_op, val_less_than);
+        HashJoinNode* join = _pool.add(new HashJoinNode(&_pool, tnode, *_plan->desc_tbl()));
+        join->_children.push_back(_pool.add(new RowsSourceNode(
+                &_pool, _plan->source_node(true), *_plan->desc_tbl(), _probe_rows)));
+        join->_children.push_back(_pool.add(new RowsSourceNode(
+                &_pool, _plan->source_node(false), *_plan->desc_tbl(), build_rows)));
+        ASSERT_TRUE(join->init(tnode).ok());
+
+        vector<string> result;
+        Status status = _plan->execute(join, join_op, state, &result);
+        ASSERT_TRUE(status.ok()) << status.get_error_msg();
+        std::sort(result.begin(), result.end());
+        std::sort(expected.begin(), expected.end());
+        EXPECT_EQ(expected, result);
+    }
+
+    // Creates and prepares an instance of a broadcast inner join of query 'query_id' on
+    // the probe rows and _build_rows, whose build child is an exchange.
+    HashJoinNode* prepare_broadcast_join(int64_t query_id, RuntimeState** state) {
+        EXPECT_TRUE(_test_env->create_query_state(
+                query_id, -1, 8 * 1024 * 1024, state).ok());
+        (*state)->set_desc_tbl(_plan->desc_tbl());
+        (*state)->init_mem_trackers(TUniqueId());
+
+        TPlanNode tnode = _plan->join_node(TJoinOp::INNER_JOIN, false);
+        tnode.hash_join_node.__set_is_broadcast(true);
+        TPlanNode build_tnode = _plan->source_node(false);
+        build_tnode.__set_node_type(TPlanNodeType::EXCHANGE_NODE);
+        HashJoinNode* join = _pool.add(new HashJoinNode(&_pool, tnode, *_plan->desc_tbl()));
+        join->_children.push_back(_pool.add(new RowsSourceNode(
+                &_pool, _plan->source_node(true), *_plan->desc_tbl(), _probe_rows)));
+        join->_children.push_back(_pool.add(new RowsSourceNode(
+                &_pool, build_tnode, *_plan->desc_tbl(), _build_rows)));
+        EXPECT_TRUE(join->init(tnode).ok());
+        EXPECT_TRUE(join->prepare(*state).ok());
+        return join;
+    }
+
+    struct InstanceResult {
+        Status status;
+        vector<string> rows;
+    };
+
+    // Opens the prepared 'join', reads all rows into 'result' and closes it.
+    void fetch_rows(HashJoinNode* join, RuntimeState* state, InstanceResult* result) {
+        result->status = _plan->fetch(join, TJoinOp::INNER_JOIN, state, &result->rows);
+        std::sort(result->rows.begin(), result->rows.end());
+    }
+
+    SharedHashTableMgr* shared_hash_table_mgr() {
+        return _test_env->exec_env()->shared_hash_table_mgr();
+    }
+
+    ObjectPool _pool;
+    scoped_ptr<TestEnv> _test_env;
+    scoped_ptr<JoinTestPlan> _plan;
+    int64_t _next_query_id;
+    vector<KeyValRow> _probe_rows;
+    vector<KeyValRow> _build_rows;
+    vector<KeyValRow> _build_rows_with_null;
+};
+
+TEST_F(HashJoinNodeTest, NoNullBuildKeys) {
+    check_join(TJoinOp::INNER_JOIN, false, _build_rows,
+               {"(1,10)(1,5)", "(1,10)(1,15)", "(2,20)(2,10)"});
+    check_join(TJoinOp::LEFT_OUTER_JOIN, false, _build_rows,
+               {"(1,10)(1,5)", "(1,10)(1,15)", "(2,20)(2,10)",
+                "(3,30)null", "(null,40)null", "(5,null)null"});
+    check_join(TJoinOp::LEFT_SEMI_JOIN, false, _build_rows, {"(1,10)", "(2,20)"});
+    check_join(TJoinOp::LEFT_ANTI_JOIN, false, _build_rows,
+               {"(3,30)", "(null,40)", "(5,null)"});
+    // 'NULL NOT IN (1, 1, 2, 6)' is NULL
+    check_join(TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN, false, _build_rows,
+               {"(3,30)", "(5,null)"});
+}
+
+TEST_F(HashJoinNodeTest, NullBuildKeys) {
+    // The build row with a NULL key never matches
+    check_join(TJoinOp::INNER_JOIN, false, _build_rows_with_null,
+               {"(1,10)(1,5)", "(1,10)(1,15)", "(2,20)(2,10)"});
+    check_join(TJoinOp::LEFT_SEMI_JOIN, false, _build_rows_with_null, {"(1,10)", "(2,20)"});
+    check_join(TJoinOp::LEFT_ANTI_JOIN, false, _build_rows_with_null,
+               {"(3,30)", "(null,40)", "(5,null)"});
+    // 'x NOT IN (1, 1, 2, 6, NULL)' is NULL for any x which is not in the list
+    check_join(TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN, false, _build_rows_with_null, {});
+}
+
+// The other join conjunct is probe.val < build.val.
+TEST_F(HashJoinNodeTest, OtherJoinConjuncts) {
+    // (2,20) only has the key of (2,10)
+    check_join(TJoinOp::LEFT_SEMI_JOIN, true, _build_rows_with_null, {"(1,10)"});
+    check_join(TJoinOp::LEFT_ANTI_JOIN, true, _build_rows_with_null,
+               {"(2,20)", "(3,30)", "(null,40)", "(5,null)"});
+    check_join(TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN, true, _build_rows,
+               {"(2,20)", "(3,30)", "(5,null)"});
+    // (null,25) is a candidate match of (2,20) only, 20 < 25. (null,40) is NULL, 40 < 60
+    // of (6,60). (5,null) has no candidate, NULL < val is never true.
+    check_join(TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN, true, _build_rows_with_null,
+               {"(3,30)", "(5,null)"});
+}
+
+TEST_F(HashJoinNodeTest, EmptyBuild) {
+    vector<KeyValRow> empty;
+    vector<string> all_probe_rows = {"(1,10)", "(2,20)", "(3,30)", "(null,40)", "(5,null)"};
+    check_join(TJoinOp::INNER_JOIN, false, empty, {});
+    check_join(TJoinOp::LEFT_SEMI_JOIN, false, empty, {});
+    check_join(TJoinOp::LEFT_ANTI_JOIN, false, empty, all_probe_rows);
+    // 'x NOT IN ()' is true, even for a NULL x
+    check_join(TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN, false, empty, all_probe_rows);
+    check_join(TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN, true, empty, all_probe_rows);
+}
+
+class SharedHashTableTest : public HashJoinNodeTest {
+protected:
+    virtual void SetUp() {
+        HashJoinNodeTest::SetUp();
+        _enable_shared_broadcast_hash_table = config::enable_shared_broadcast_hash_table;
+        config::enable_shared_broadcast_hash_table = true;
+        _expected_rows = {"(1,10)(1,15)", "(1,10)(1,5)", "(2,20)(2,10)"};
+    }
+
+    virtual void TearDown() {
+        config::enable_shared_broadcast_hash_table = _enable_shared_broadcast_hash_table;
+        HashJoinNodeTest::TearDown();
+    }
+
+    bool _enable_shared_broadcast_hash_table;
+    vector<string> _expected_rows;
+};
+
+// The first instance builds the table, the others wait for it and probe it. The
+// builder is closed before the others finish probing.
+TEST_F(SharedHashTableTest, Build) {
+    const int num_instances = 4;
+    vector<RuntimeState*> states(num_instances);
+    vector<HashJoinNode*> joins(num_instances);
+    for (int i = 0; i < num_instances; ++i) {
+        joins[i] = prepare_broadcast_join(1, &states[i]);
+        EXPECT_EQ(i == 0, joins[i]->_is_shared_builder);
+        EXPECT_EQ(joins[0]->_shared_hash_tbl, joins[i]->_shared_hash_tbl);
+    }
+
+    // The build memory is charged to the query of the builder. The table is held here so
+    // that it can be checked after all instances are closed.
+    boost::shared_ptr<SharedHashTable> shared = joins[0]->_shared_hash_tbl;
+    EXPECT_EQ(states[0]->query_mem_tracker(), shared->mem_tracker()->parent());
+
+    vector<InstanceResult> results(num_instances);
+    boost::thread_group probers;
+    for (int i = 1; i < num_instances; ++i) {
+        probers.add_thread(new boost::thread(boost::bind(
+                &SharedHashTableTest::fetch_rows, this, joins[i], states[i], &results[i])));
+    }
+    fetch_rows(joins[0], states[0], &results[0]);
+    EXPECT_GT(shared->mem_tracker()->consumption(), 0);
+    EXPECT_GE(states[0]->query_mem_tracker()->consumption(),
+              shared->mem_tracker()->consumption());
+    probers.join_all();
+
+    for (int i = 0; i < num_instances; ++i) {
+        EXPECT_TRUE(results[i].status.ok()) << results[i].status.get_error_msg();
+        EXPECT_EQ(_expected_rows, results[i].rows);
+    }
+    EXPECT_TRUE(shared_hash_table_mgr()->_tables.empty());
+}
+
+// The builder is closed without building the table, the instances waiting for it fail.
+TEST_F(SharedHashTableTest, BuilderFailed) {
+    RuntimeState* builder_state = NULL;
+    HashJoinNode* builder = prepare_broadcast_join(1, &builder_state);
+    ASSERT_TRUE(builder->_is_shared_builder);
+    RuntimeState* prober_state = NULL;
+    HashJoinNode* prober = prepare_broadcast_join(1, &prober_state);
+    ASSERT_FALSE(prober->_is_shared_builder);
+
+    InstanceResult result;
+    boost::thread thread(boost::bind(
+            &SharedHashTableTest::fetch_rows, this, prober, prober_state, &result));
+    EXPECT_TRUE(builder->close(builder_state).ok());
+    thread.join();
+    EXPECT_TRUE(result.status.is_cancelled());
+    EXPECT_TRUE(shared_hash_table_mgr()->_tables.empty());
+}
+
+// An instance waiting for the table stops waiting when it is cancelled.
+TEST_F(SharedHashTableTest, ProberCancelled) {
+    RuntimeState* builder_state = NULL;
+    HashJoinNode* builder = prepare_broadcast_join(1, &builder_state);
+    RuntimeState* prober_state = NULL;
+    HashJoinNode* prober = prepare_broadcast_join(1, &prober_state);
+
+    InstanceResult result;
+    boost::thread thread(boost::bind(
+            &SharedHashTableTest::fetch_rows, this, prober, prober_state, &result));
+    boost::this_thread::sleep(boost::posix_time::milliseconds(200));
+    prober_state->set_is_cancelled(true);
+    thread.join();
+    EXPECT_TRUE(result.status.is_cancelled());
+
+    // The builder is not affected.
+    InstanceResult builder_result;
+    fetch_rows(builder, builder_state, &builder_result);
+    EXPECT_TRUE(builder_result.status.ok()) << builder_result.status.get_error_msg();
+    EXPECT_EQ(_expected_rows, builder_result.rows);
+    EXPECT_TRUE(shared_hash_table_mgr()->_tables.empty());
+}
+
+// An instance that registers after the builder finished probes the table built before
+// as long as another instance still holds it, and builds a new one otherwise.
+TEST_F(SharedHashTableTest, LateInstance) {
+    RuntimeState* builder_state = NULL;
+    HashJoinNode* builder = prepare_broadcast_join(1, &builder_state);
+    RuntimeState* prober_state = NULL;
+    HashJoinNode* prober = prepare_broadcast_join(1, &prober_state);
+    InstanceResult builder_result;
+    fetch_rows(builder, builder_state, &builder_result);
+    EXPECT_TRUE(builder_result.status.ok()) << builder_result.status.get_error_msg();
+
+    RuntimeState* late_state = NULL;
+    HashJoinNode* late = prepare_broadcast_join(1, &late_state);
+    EXPECT_FALSE(late->_is_shared_builder);
+    EXPECT_EQ(prober->_shared_hash_tbl, late->_shared_hash_tbl);
+    InstanceResult late_result;
+    fetch_rows(late, late_state, &late_result);
+    EXPECT_TRUE(late_result.status.ok()) << late_result.status.get_error_msg();
+    EXPECT_EQ(_expected_rows, late_result.rows);
+
+    InstanceResult prober_result;
+    fetch_rows(prober, prober_state, &prober_result);
+    EXPECT_TRUE(prober_result.status.ok()) << prober_result.status.get_error_msg();
+    EXPECT_EQ(_expected_rows, prober_result.rows);
+    EXPECT_TRUE(shared_hash_table_mgr()->_tables.empty());
+
+    RuntimeState* new_state = NULL;
+    HashJoinNode* new_builder = prepare_broadcast_join(1, &new_state);
+    EXPECT_TRUE(new_builder->_is_shared_builder);
+    InstanceResult new_result;
+    fetch_rows(new_builder, new_state, &new_result);
+    EXPECT_TRUE(new_result.status.ok()) << new_result.status.get_error_msg();
+    EXPECT_EQ(_expected_rows, new_result.rows);
+}
+
+// Instances of different queries never share a table.
+TEST_F(SharedHashTableTest, OtherQuery) {
+    RuntimeState* state1 = NULL;
+    HashJoinNode* join1 = prepare_broadcast_join(1, &state1);
+    RuntimeState* state2 = NULL;
+    HashJoinNode* join2 = prepare_broadcast_join(2, &state2);
+    EXPECT_TRUE(join1->_is_shared_builder);
+    EXPECT_TRUE(join2->_is_shared_builder);
+    EXPECT_TRUE(join1->close(state1).ok());
+    EXPECT_TRUE(join2->close(state2).ok());
+}
+
+} // end namespace palo
+
+int main(int argc, char** argv) {
+    palo::config::query_scratch_dirs = "/tmp";
+    palo::config::read_size = 8388608;
+    palo::config::min_buffer_size = 1024;
+    palo::config::disable_mem_pools = false;
+
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+
+    palo::CpuInfo::init();
+    palo::DiskInfo::init();
+
+    return RUN_ALL_TESTS();
+}
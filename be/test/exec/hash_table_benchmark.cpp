@@ -0,0 +1,557 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+// Micro benchmarks of the hash tables behind joins and aggregations.
+//
+// For every key type, cardinality and key distribution it measures on HashTable and
+// on PartitionedHashTable, with linear and quadratic probing:
+//   - join: building the table from 'cardinality' distinct keys, then probing it
+//     row by row and, for PartitionedHashTable, in prefetched batches, with about
+//     half of the probe rows matching
+//   - agg: grouping rows of 'cardinality' distinct keys and counting them, the inner
+//     loop of the aggregation nodes
+// It reports the build/probe throughput in million rows per second and the bytes
+// the table itself takes per entry, the tuples excluded. Run it by hand, e.g.
+//
+//     hash_table_benchmark [--rows=4194304] [--max_cardinality=10000000] [filter]
+//
+// where only the cases whose name contains 'filter' run. The cases use the
+// interpreted exprs, the codegen'd versions are only built inside a fragment.
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/object_pool.h"
+#include "exec/hash_table.hpp"
+#include "exec/partitioned_hash_table.inline.h"
+#include "exprs/expr.h"
+#include "exprs/expr_context.h"
+#include "exprs/slot_ref.h"
+#include "runtime/buffered_block_mgr2.h"
+#include "runtime/descriptors.h"
+#include "runtime/mem_pool.h"
+#include "runtime/mem_tracker.h"
+#include "runtime/runtime_state.h"
+#include "runtime/string_value.h"
+#include "runtime/test_env.h"
+#include "runtime/tuple_row.h"
+#include "util/cpu_info.h"
+#include "util/disk_info.h"
+#include "util/logging.h"
+#include "util/stopwatch.hpp"
+
+namespace palo {
+
+// Key slots are at the head of the tuple, the count of the agg cases after them.
+static const int KEY_SIZE = 16;
+static const int COUNT_OFFSET = KEY_SIZE;
+static const int TUPLE_SIZE = KEY_SIZE + sizeof(int64_t);
+static const int BATCH_SIZE = 1024;
+
+enum KeyType {
+    INT_KEY = 0,
+    COMPOSITE_KEY,
+    SHORT_STRING_KEY,
+    LONG_STRING_KEY,
+    NUM_KEY_TYPES
+};
+
+static const char* KEY_TYPE_NAMES[] = {"int", "int_bigint", "short_str", "long_str"};
+
+enum Distribution {
+    UNIFORM = 0,
+    SKEWED,
+    NUM_DISTRIBUTIONS
+};
+
+static const char* DISTRIBUTION_NAMES[] = {"uniform", "skewed"};
+
+#define CHECK_STATUS(stmt) \
+    do { \
+        Status _status = (stmt); \
+        if (!_status.ok()) { \
+            std::cerr << #stmt << " failed: " << _status.get_error_msg() << std::endl; \
+            exit(1); \
+        } \
+    } while (false)
+
+// Rows of a single tuple holding the key slots and a count.
+class KeyRows {
+public:
+    KeyRows(KeyType key_type, MemTracker* tracker) :
+            _key_type(key_type), _pool(tracker) {
+    }
+
+    KeyType key_type() const {
+        return _key_type;
+    }
+
+    // Appends a row for 'key'.
+    void add(int64_t key) {
+        Tuple* tuple = Tuple::create(TUPLE_SIZE, &_pool);
+        set_key(tuple, key);
+        TupleRow* row = reinterpret_cast<TupleRow*>(_pool.allocate(sizeof(Tuple*)));
+        row->set_tuple(0, tuple);
+        _rows.push_back(row);
+    }
+
+    const std::vector<TupleRow*>& rows() const {
+        return _rows;
+    }
+
+    // Copies the key of 'row' into a new tuple with a zero count.
+    Tuple* copy_key(TupleRow* row) {
+        Tuple* tuple = reinterpret_cast<Tuple*>(_pool.allocate(TUPLE_SIZE));
+        memcpy(tuple, row->get_tuple(0), KEY_SIZE);
+        *count(tuple) = 0;
+        return tuple;
+    }
+
+    static int64_t* count(Tuple* tuple) {
+        return reinterpret_cast<int64_t*>(reinterpret_cast<uint8_t*>(tuple) + COUNT_OFFSET);
+    }
+
+    // The slot refs over the key slots.
+    void create_exprs(ObjectPool* pool, std::vector<ExprContext*>* ctxs) const {
+        switch (_key_type) {
+        case INT_KEY:
+            ctxs->push_back(pool->add(new ExprContext(pool->add(new SlotRef(TYPE_INT, 0)))));
+            break;
+        case COMPOSITE_KEY:
+            ctxs->push_back(pool->add(new ExprContext(pool->add(new SlotRef(TYPE_INT, 0)))));
+            ctxs->push_back(pool->add(new ExprContext(pool->add(new SlotRef(TYPE_BIGINT, 8)))));
+            break;
+        default:
+            ctxs->push_back(pool->add(new ExprContext(
+                    pool->add(new SlotRef(TYPE_VARCHAR, 0)))));
+            break;
+        }
+    }
+
+private:
+    void set_key(Tuple* tuple, int64_t key) {
+        uint8_t* slots = reinterpret_cast<uint8_t*>(tuple);
+        switch (_key_type) {
+        case INT_KEY:
+            *reinterpret_cast<int32_t*>(slots) = key;
+            break;
+        case COMPOSITE_KEY:
+            *reinterpret_cast<int32_t*>(slots) = key % 1000;
+            *reinterpret_cast<int64_t*>(slots + 8) = key / 1000 * 7919;
+            break;
+        default: {
+            // long strings share a prefix, which the equality check has to compare
+            std::string str = _key_type == SHORT_STRING_KEY
+                ? "k" + std::to_string(key)
+                : std::string(48, 'x') + std::to_string(key);
+            char* data = reinterpret_cast<char*>(_pool.allocate(str.size()));
+            memcpy(data, str.data(), str.size());
+            *reinterpret_cast<StringValue*>(slots) = StringValue(data, str.size());
+            break;
+        }
+        }
+    }
+
+    const KeyType _key_type;
+    MemPool _pool;
+    std::vector<TupleRow*> _rows;
+};
+
+// Draws keys in [0, key_space).
+class KeyGenerator {
+public:
+    KeyGenerator(Distribution distribution, int64_t key_space) :
+            _distribution(distribution), _key_space(key_space), _rng(42), _uniform(0, 1) {
+    }
+
+    int64_t next() {
+        double u = _uniform(_rng);
+        if (_distribution == SKEWED) {
+            // a power law, the lowest keys get most of the rows
+            u = pow(u, 4);
+        }
+        return std::min(static_cast<int64_t>(u * _key_space), _key_space - 1);
+    }
+
+private:
+    const Distribution _distribution;
+    const int64_t _key_space;
+    std::mt19937_64 _rng;
+    std::uniform_real_distribution<double> _uniform;
+};
+
+struct CaseResult {
+    double build_mrows = 0;
+    double probe_mrows = 0;
+    double batch_probe_mrows = 0;
+    double bytes_per_entry = 0;
+    int64_t entries = 0;
+};
+
+class HashTableBenchmark {
+public:
+    HashTableBenchmark(int64_t rows, const std::string& filter) :
+            _rows(rows), _filter(filter), _test_env(new TestEnv()), _query_id(0) {
+        std::cout << std::left << std::setw(56) << "Benchmark"
+            << std::right << std::setw(12) << "entries"
+            << std::setw(12) << "build Mr/s"
+            << std::setw(12) << "probe Mr/s"
+            << std::setw(12) << "batch Mr/s"
+            << std::setw(12) << "bytes/entry" << std::endl;
+    }
+
+    void run(KeyType key_type, Distribution distribution, int64_t cardinality) {
+        std::string suffix = std::string(KEY_TYPE_NAMES[key_type]) + "/"
+            + DISTRIBUTION_NAMES[distribution] + "/" + std::to_string(cardinality);
+        int64_t num_rows = std::max(_rows, cardinality);
+
+        // the build side has every key once, the probe side hits about half of them
+        KeyRows build_rows(key_type, &_tracker);
+        std::vector<int64_t> keys(cardinality);
+        for (int64_t i = 0; i < cardinality; ++i) {
+            keys[i] = i;
+        }
+        std::shuffle(keys.begin(), keys.end(), std::mt19937_64(7));
+        for (int64_t key : keys) {
+            build_rows.add(key);
+        }
+        KeyRows probe_rows(key_type, &_tracker);
+        KeyGenerator probe_keys(distribution, cardinality * 2);
+        for (int64_t i = 0; i < num_rows; ++i) {
+            probe_rows.add(probe_keys.next());
+        }
+        KeyRows agg_rows(key_type, &_tracker);
+        KeyGenerator agg_keys(distribution, cardinality);
+        for (int64_t i = 0; i < num_rows; ++i) {
+            agg_rows.add(agg_keys.next());
+        }
+
+        report("hash_table/join/" + suffix, [&]() {
+            return hash_table_join(build_rows, probe_rows);
+        });
+        report("hash_table/agg/" + suffix, [&]() {
+            return hash_table_agg(&agg_rows);
+        });
+        for (bool quadratic : {false, true}) {
+            std::string probing = quadratic ? "quadratic/" : "linear/";
+            report("partitioned/join/" + probing + suffix, [&]() {
+                return partitioned_join(quadratic, build_rows, probe_rows);
+            });
+            report("partitioned/agg/" + probing + suffix, [&]() {
+                return partitioned_agg(quadratic, &agg_rows);
+            });
+        }
+    }
+
+private:
+    template <typename Fn>
+    void report(const std::string& name, const Fn& fn) {
+        if (name.find(_filter) == std::string::npos) {
+            return;
+        }
+        CaseResult result = fn();
+        std::cout << std::left << std::setw(56) << name
+            << std::right << std::setw(12) << result.entries
+            << std::fixed << std::setprecision(2)
+            << std::setw(12) << result.build_mrows
+            << std::setw(12) << result.probe_mrows
+            << std::setw(12) << result.batch_probe_mrows
+            << std::setprecision(1) << std::setw(12) << result.bytes_per_entry << std::endl;
+    }
+
+    static double mrows_per_sec(int64_t rows, int64_t elapsed_ns) {
+        return elapsed_ns > 0 ? rows * 1e3 / elapsed_ns : 0;
+    }
+
+    void prepare_exprs(const KeyRows& rows, std::vector<ExprContext*>* build_ctxs,
+                       std::vector<ExprContext*>* probe_ctxs) {
+        RowDescriptor desc;
+        rows.create_exprs(&_obj_pool, build_ctxs);
+        rows.create_exprs(&_obj_pool, probe_ctxs);
+        CHECK_STATUS(Expr::prepare(*build_ctxs, NULL, desc, &_tracker));
+        CHECK_STATUS(Expr::open(*build_ctxs, NULL));
+        CHECK_STATUS(Expr::prepare(*probe_ctxs, NULL, desc, &_tracker));
+        CHECK_STATUS(Expr::open(*probe_ctxs, NULL));
+    }
+
+    CaseResult hash_table_join(const KeyRows& build_rows, const KeyRows& probe_rows) {
+        std::vector<ExprContext*> build_ctxs;
+        std::vector<ExprContext*> probe_ctxs;
+        prepare_exprs(build_rows, &build_ctxs, &probe_ctxs);
+        MemTracker tracker;
+        HashTable table(build_ctxs, probe_ctxs, 1, false, 0, &tracker, 1024);
+
+        CaseResult result;
+        MonotonicStopWatch watch;
+        watch.start();
+        for (TupleRow* row : build_rows.rows()) {
+            table.insert(row);
+        }
+        result.build_mrows = mrows_per_sec(build_rows.rows().size(), watch.elapsed_time());
+
+        int64_t matches = 0;
+        watch.reset();
+        for (TupleRow* row : probe_rows.rows()) {
+            if (table.find(row) != table.end()) {
+                ++matches;
+            }
+        }
+        result.probe_mrows = mrows_per_sec(probe_rows.rows().size(), watch.elapsed_time());
+        check_matches(matches);
+
+        result.entries = table.size();
+        result.bytes_per_entry = static_cast<double>(table.byte_size()) / table.size();
+        table.close();
+        Expr::close(build_ctxs, NULL);
+        Expr::close(probe_ctxs, NULL);
+        return result;
+    }
+
+    CaseResult hash_table_agg(KeyRows* rows) {
+        std::vector<ExprContext*> build_ctxs;
+        std::vector<ExprContext*> probe_ctxs;
+        prepare_exprs(*rows, &build_ctxs, &probe_ctxs);
+        MemTracker tracker;
+        HashTable table(build_ctxs, probe_ctxs, 1, false, 0, &tracker, 1024);
+
+        CaseResult result;
+        MonotonicStopWatch watch;
+        watch.start();
+        for (TupleRow* row : rows->rows()) {
+            HashTable::Iterator it = table.find(row);
+            Tuple* tuple = NULL;
+            if (it == table.end()) {
+                tuple = rows->copy_key(row);
+                table.insert(reinterpret_cast<TupleRow*>(&tuple));
+            } else {
+                tuple = it.get_row()->get_tuple(0);
+            }
+            ++*KeyRows::count(tuple);
+        }
+        result.build_mrows = mrows_per_sec(rows->rows().size(), watch.elapsed_time());
+
+        result.entries = table.size();
+        result.bytes_per_entry = static_cast<double>(table.byte_size()) / table.size();
+        table.close();
+        Expr::close(build_ctxs, NULL);
+        Expr::close(probe_ctxs, NULL);
+        return result;
+    }
+
+    // A table over a block manager without a memory limit.
+    PartitionedHashTable* create_partitioned(bool quadratic) {
+        RuntimeState* state = NULL;
+        CHECK_STATUS(_test_env->create_query_state(_query_id++, -1, 8 * 1024 * 1024, &state));
+        state->init_mem_trackers(TUniqueId());
+        BufferedBlockMgr2::Client* client = NULL;
+        CHECK_STATUS(state->block_mgr2()->register_client(0, &_tracker, state, &client));
+        PartitionedHashTable* table = new PartitionedHashTable(
+                quadratic, state, client, 1, NULL, 1L << 31, 1024);
+        if (!table->init()) {
+            std::cerr << "failed to init the hash table" << std::endl;
+            exit(1);
+        }
+        return table;
+    }
+
+    static void check_and_resize(PartitionedHashTable* table, PartitionedHashTableCtx* ctx,
+                                 int64_t rows) {
+        if (!table->check_and_resize(rows, ctx)) {
+            std::cerr << "failed to resize the hash table" << std::endl;
+            exit(1);
+        }
+    }
+
+    CaseResult partitioned_join(bool quadratic, const KeyRows& build_rows,
+                                const KeyRows& probe_rows) {
+        std::vector<ExprContext*> build_ctxs;
+        std::vector<ExprContext*> probe_ctxs;
+        prepare_exprs(build_rows, &build_ctxs, &probe_ctxs);
+        std::unique_ptr<PartitionedHashTable> table(create_partitioned(quadratic));
+        PartitionedHashTableCtx ctx(build_ctxs, probe_ctxs, false, false, 1, 0, 1);
+
+        CaseResult result;
+        const std::vector<TupleRow*>& build = build_rows.rows();
+        uint32_t hash = 0;
+        MonotonicStopWatch watch;
+        watch.start();
+        for (size_t start = 0; start < build.size(); start += BATCH_SIZE) {
+            size_t end = std::min(build.size(), start + BATCH_SIZE);
+            check_and_resize(table.get(), &ctx, end - start);
+            for (size_t i = start; i < end; ++i) {
+                if (ctx.eval_and_hash_build(build[i], &hash)) {
+                    table->insert(&ctx, build[i]->get_tuple(0), hash);
+                }
+            }
+        }
+        result.build_mrows = mrows_per_sec(build.size(), watch.elapsed_time());
+
+        const std::vector<TupleRow*>& probe = probe_rows.rows();
+        int64_t matches = 0;
+        watch.reset();
+        for (TupleRow* row : probe) {
+            if (ctx.eval_and_hash_probe(row, &hash) && !table->find(&ctx, hash).at_end()) {
+                ++matches;
+            }
+        }
+        result.probe_mrows = mrows_per_sec(probe.size(), watch.elapsed_time());
+        check_matches(matches);
+
+        // evaluate and prefetch a group of rows before looking them up
+        uint32_t hashes[PartitionedHashTableCtx::ROW_CACHE_SIZE];
+        bool valid[PartitionedHashTableCtx::ROW_CACHE_SIZE];
+        int64_t batch_matches = 0;
+        watch.reset();
+        for (size_t start = 0; start < probe.size();
+                start += PartitionedHashTableCtx::ROW_CACHE_SIZE) {
+            int num_rows = std::min<size_t>(
+                    probe.size() - start, PartitionedHashTableCtx::ROW_CACHE_SIZE);
+            for (int i = 0; i < num_rows; ++i) {
+                valid[i] = ctx.eval_and_hash_probe(probe[start + i], &hashes[i]);
+                if (valid[i]) {
+                    ctx.cache_last_row(i);
+                    table->prefetch_bucket(hashes[i]);
+                }
+            }
+            for (int i = 0; i < num_rows; ++i) {
+                if (!valid[i]) {
+                    continue;
+                }
+                ctx.load_cached_row(i);
+                if (!table->find(&ctx, hashes[i]).at_end()) {
+                    ++batch_matches;
+                }
+            }
+        }
+        result.batch_probe_mrows = mrows_per_sec(probe.size(), watch.elapsed_time());
+        if (batch_matches != matches) {
+            std::cerr << "batched probe found " << batch_matches << " matches instead of "
+                << matches << std::endl;
+            exit(1);
+        }
+
+        result.entries = table->size();
+        result.bytes_per_entry = static_cast<double>(table->current_mem_size()) / table->size();
+        table->close();
+        ctx.close();
+        Expr::close(build_ctxs, NULL);
+        Expr::close(probe_ctxs, NULL);
+        return result;
+    }
+
+    CaseResult partitioned_agg(bool quadratic, KeyRows* rows) {
+        std::vector<ExprContext*> build_ctxs;
+        std::vector<ExprContext*> probe_ctxs;
+        prepare_exprs(*rows, &build_ctxs, &probe_ctxs);
+        std::unique_ptr<PartitionedHashTable> table(create_partitioned(quadratic));
+        PartitionedHashTableCtx ctx(build_ctxs, probe_ctxs, false, false, 1, 0, 1);
+
+        CaseResult result;
+        const std::vector<TupleRow*>& input = rows->rows();
+        uint32_t hash = 0;
+        MonotonicStopWatch watch;
+        watch.start();
+        for (size_t start = 0; start < input.size(); start += BATCH_SIZE) {
+            size_t end = std::min(input.size(), start + BATCH_SIZE);
+            check_and_resize(table.get(), &ctx, end - start);
+            for (size_t i = start; i < end; ++i) {
+                if (!ctx.eval_and_hash_probe(input[i], &hash)) {
+                    continue;
+                }
+                bool found = false;
+                PartitionedHashTable::Iterator it = table->find_bucket(&ctx, hash, &found);
+                Tuple* tuple = NULL;
+                if (found) {
+                    tuple = it.get_tuple();
+                } else {
+                    tuple = rows->copy_key(input[i]);
+                    it.set_tuple(tuple, hash);
+                }
+                ++*KeyRows::count(tuple);
+            }
+        }
+        result.build_mrows = mrows_per_sec(input.size(), watch.elapsed_time());
+
+        result.entries = table->size();
+        result.bytes_per_entry = static_cast<double>(table->current_mem_size()) / table->size();
+        table->close();
+        ctx.close();
+        Expr::close(build_ctxs, NULL);
+        Expr::close(probe_ctxs, NULL);
+        return result;
+    }
+
+    void check_matches(int64_t matches) {
+        if (matches == 0) {
+            std::cerr << "the probe found no match" << std::endl;
+            exit(1);
+        }
+    }
+
+    const int64_t _rows;
+    const std::string _filter;
+    std::unique_ptr<TestEnv> _test_env;
+    int64_t _query_id;
+    ObjectPool _obj_pool;
+    MemTracker _tracker;
+};
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    int64_t rows = 4 * 1024 * 1024;
+    int64_t max_cardinality = 10 * 1000 * 1000;
+    std::string filter;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 7, "--rows=") == 0) {
+            rows = atol(arg.c_str() + 7);
+        } else if (arg.compare(0, 18, "--max_cardinality=") == 0) {
+            max_cardinality = atol(arg.c_str() + 18);
+        } else {
+            filter = arg;
+        }
+    }
+    palo::config::query_scratch_dirs = "/tmp";
+    palo::config::read_size = 8388608;
+    palo::config::min_buffer_size = 1024;
+    palo::config::disable_mem_pools = false;
+    palo::init_glog("be-benchmark");
+    palo::CpuInfo::init();
+    palo::DiskInfo::init();
+
+    palo::HashTableBenchmark benchmark(rows, filter);
+    for (int key_type = 0; key_type < palo::NUM_KEY_TYPES; ++key_type) {
+        for (int distribution = 0; distribution < palo::NUM_DISTRIBUTIONS; ++distribution) {
+            // 10 up to 100M distinct keys, capped to keep the default run in memory
+            for (int64_t cardinality = 10; cardinality <= std::min<int64_t>(
+                        max_cardinality, 100 * 1000 * 1000); cardinality *= 100) {
+                benchmark.run(static_cast<palo::KeyType>(key_type),
+                              static_cast<palo::Distribution>(distribution), cardinality);
+            }
+        }
+    }
+    return 0;
+}
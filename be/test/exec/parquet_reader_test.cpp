@@ -0,0 +1,130 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/parquet_reader.h"
+
+#include <gtest/gtest.h>
+
+#include "exec/local_file_reader.h"
+#include "util/logging.h"
+
+namespace palo {
+
+// normal.parquet has the columns id int32, name string (dictionary encoded and gzip
+// compressed), price decimal(10, 2) as int64 in a data page v2, dt date in a page per
+// row, score double and flag boolean. The first row group holds 3 rows and starts at
+// offset 4, the second holds 1 row and starts at offset 259.
+static const char* FILE_PATH = "./be/test/exec/test_data/parquet_scanner/normal.parquet";
+
+static std::vector<std::string> column_names() {
+    return {"ID", "name", "price", "dt", "score", "flag"};
+}
+
+TEST(ParquetReaderTest, normal) {
+    LocalFileReader file_reader(FILE_PATH, 0);
+    ASSERT_TRUE(file_reader.open().ok());
+    ParquetReader reader(&file_reader, 0, -1);
+    ASSERT_TRUE(reader.open(column_names()).ok());
+
+    bool eof = false;
+    ASSERT_TRUE(reader.read_row(&eof).ok());
+    ASSERT_FALSE(eof);
+    ASSERT_EQ("1", reader.value(0));
+    ASSERT_EQ("alice", reader.value(1));
+    ASSERT_EQ("123.45", reader.value(2));
+    ASSERT_EQ("2018-03-01", reader.value(3));
+    ASSERT_EQ("1.5", reader.value(4));
+    ASSERT_EQ("1", reader.value(5));
+
+    ASSERT_TRUE(reader.read_row(&eof).ok());
+    ASSERT_FALSE(eof);
+    ASSERT_EQ("2", reader.value(0));
+    ASSERT_TRUE(reader.is_null(1));
+    ASSERT_EQ("-0.05", reader.value(2));
+    ASSERT_EQ("1969-12-31", reader.value(3));
+    ASSERT_EQ("0", reader.value(5));
+
+    ASSERT_TRUE(reader.read_row(&eof).ok());
+    ASSERT_FALSE(eof);
+    ASSERT_EQ("alice", reader.value(1));
+    ASSERT_TRUE(reader.is_null(2));
+    ASSERT_EQ("2000-02-29", reader.value(3));
+    ASSERT_EQ("-2.25", reader.value(4));
+
+    ASSERT_TRUE(reader.read_row(&eof).ok());
+    ASSERT_FALSE(eof);
+    ASSERT_EQ("4", reader.value(0));
+    ASSERT_EQ("bob", reader.value(1));
+    ASSERT_EQ("1.00", reader.value(2));
+    LOG(INFO) << reader.debug_row();
+
+    ASSERT_TRUE(reader.read_row(&eof).ok());
+    ASSERT_TRUE(eof);
+    file_reader.close();
+}
+
+TEST(ParquetReaderTest, ranges) {
+    LocalFileReader file_reader(FILE_PATH, 0);
+    ASSERT_TRUE(file_reader.open().ok());
+
+    // the first row group starts within [0, 100)
+    ParquetReader first(&file_reader, 0, 100);
+    ASSERT_TRUE(first.open(column_names()).ok());
+    int rows = 0;
+    bool eof = false;
+    while (true) {
+        ASSERT_TRUE(first.read_row(&eof).ok());
+        if (eof) {
+            break;
+        }
+        ++rows;
+    }
+    ASSERT_EQ(3, rows);
+
+    // the rest of the file holds just the second one
+    ParquetReader second(&file_reader, 100, -1);
+    ASSERT_TRUE(second.open(column_names()).ok());
+    ASSERT_TRUE(second.read_row(&eof).ok());
+    ASSERT_FALSE(eof);
+    ASSERT_EQ("4", second.value(0));
+    ASSERT_TRUE(second.read_row(&eof).ok());
+    ASSERT_TRUE(eof);
+    file_reader.close();
+}
+
+TEST(ParquetReaderTest, missing_column) {
+    LocalFileReader file_reader(FILE_PATH, 0);
+    ASSERT_TRUE(file_reader.open().ok());
+    ParquetReader reader(&file_reader, 0, -1);
+    ASSERT_FALSE(reader.open({"id", "nosuch"}).ok());
+    file_reader.close();
+}
+
+TEST(ParquetReaderTest, not_parquet) {
+    LocalFileReader file_reader(
+        "./be/test/exec/test_data/plain_text_line_reader/test_file.csv", 0);
+    ASSERT_TRUE(file_reader.open().ok());
+    ParquetReader reader(&file_reader, 0, -1);
+    ASSERT_FALSE(reader.open(column_names()).ok());
+    file_reader.close();
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,252 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/partitioned_hash_join_node.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "common/object_pool.h"
+#include "exec/hash_join_node.h"
+#include "runtime/test_env.h"
+#include "testutil/join_test_util.h"
+#include "util/cpu_info.h"
+#include "util/disk_info.h"
+#include "util/logging.h"
+#include "util/runtime_profile.h"
+
+using std::string;
+using std::vector;
+
+using boost::scoped_ptr;
+
+namespace palo {
+
+// NULL_AWARE_LEFT_ANTI_JOIN is only executed by HashJoinNode.
+static const TJoinOp::type JOIN_OPS[] = {
+    TJoinOp::INNER_JOIN,
+    TJoinOp::LEFT_OUTER_JOIN,
+    TJoinOp::LEFT_SEMI_JOIN,
+    TJoinOp::LEFT_ANTI_JOIN,
+    TJoinOp::RIGHT_OUTER_JOIN,
+    TJoinOp::RIGHT_SEMI_JOIN,
+    TJoinOp::RIGHT_ANTI_JOIN,
+    TJoinOp::FULL_OUTER_JOIN,
+};
+static const int NUM_JOIN_OPS = sizeof(JOIN_OPS) / sizeof(JOIN_OPS[0]);
+
+class PartitionedHashJoinNodeTest : public testing::Test {
+public:
+    PartitionedHashJoinNodeTest() : _next_query_id(0) {}
+    ~PartitionedHashJoinNodeTest() {}
+
+protected:
+    virtual void SetUp() {
+        _test_env.reset(new TestEnv());
+        _plan.reset(new JoinTestPlan(&_pool));
+    }
+
+    virtual void TearDown() {
+        // The nodes are destroyed before the runtime states their memory trackers
+        // belong to.
+        _pool.clear();
+        _test_env.reset();
+    }
+
+    // A runtime state with a block manager of 'max_buffers' blocks of 'block_size',
+    // -1 means no limit.
+    RuntimeState* create_state(int max_buffers, int block_size) {
+        RuntimeState* state = NULL;
+        EXPECT_TRUE(_test_env->create_query_state(
+                _next_query_id++, max_buffers, block_size, &state).ok());
+        state->set_desc_tbl(_plan->desc_tbl());
+        state->init_mem_trackers(TUniqueId());
+        return state;
+    }
+
+    ExecNode* create_join(bool partitioned, TJoinOp::type join_op, bool val_less_than,
+                          const vector<KeyValRow>& probe_rows,
+                          const vector<KeyValRow>& build_rows) {
+        TPlanNode tnode = _plan->join_node(join_op, val_less_than);
+        ExecNode* join = NULL;
+        if (partitioned) {
+            join = _pool.add(new PartitionedHashJoinNode(&_pool, tnode, *_plan->desc_tbl()));
+        } else {
+            join = _pool.add(new HashJoinNode(&_pool, tnode, *_plan->desc_tbl()));
+        }
+        join->_children.push_back(_pool.add(new RowsSourceNode(
+                &_pool, _plan->source_node(true), *_plan->desc_tbl(), probe_rows)));
+        join->_children.push_back(_pool.add(new RowsSourceNode(
+                &_pool, _plan->source_node(false), *_plan->desc_tbl(), build_rows)));
+        EXPECT_TRUE(join->init(tnode).ok());
+        return join;
+    }
+
+    // Joins the rows with HashJoinNode and with PartitionedHashJoinNode, whose block
+    // manager has 'max_buffers' blocks of 'block_size', and checks both return the same
+    // rows. Returns the partitioned join for its counters.
+    ExecNode* check_same_rows(TJoinOp::type join_op, bool val_less_than,
+                              const vector<KeyValRow>& probe_rows,
+                              const vector<KeyValRow>& build_rows,
+                              int max_buffers, int block_size) {
+        SCOPED_TRACE(testing::Message() << "join op " << join_op
+                << ", probe.val < build.val " << val_less_than);
+        // HashJoinNode's hash table matches a NULL probe key with the NULL build keys
+        // when it keeps the build rows with NULL keys, PartitionedHashJoinNode never
+        // matches NULL keys. The probe rows with NULL keys are left out for those joins.
+        vector<KeyValRow> probe;
+        for (int i = 0; i < probe_rows.size(); ++i) {
+            if (!keeps_null_build_keys(join_op) || probe_rows[i].key != KeyValRow::NULL_VALUE) {
+                probe.push_back(probe_rows[i]);
+            }
+        }
+
+        vector<string> expected;
+        ExecNode* hash_join = create_join(false, join_op, val_less_than, probe, build_rows);
+        Status status = _plan->execute(hash_join, join_op, create_state(-1, 8 * 1024 * 1024),
+                                       &expected);
+        EXPECT_TRUE(status.ok()) << status.get_error_msg();
+
+        vector<string> result;
+        ExecNode* partitioned_join = create_join(
+                true, join_op, val_less_than, probe, build_rows);
+        status = _plan->execute(partitioned_join, join_op,
+                                create_state(max_buffers, block_size), &result);
+        EXPECT_TRUE(status.ok()) << status.get_error_msg();
+
+        std::sort(expected.begin(), expected.end());
+        std::sort(result.begin(), result.end());
+        EXPECT_FALSE(expected.empty());
+        EXPECT_EQ(expected.size(), result.size());
+        EXPECT_TRUE(expected == result);
+        return partitioned_join;
+    }
+
+    static bool keeps_null_build_keys(TJoinOp::type join_op) {
+        return join_op == TJoinOp::RIGHT_OUTER_JOIN
+            || join_op == TJoinOp::FULL_OUTER_JOIN
+            || join_op == TJoinOp::RIGHT_SEMI_JOIN
+            || join_op == TJoinOp::RIGHT_ANTI_JOIN;
+    }
+
+    static int64_t counter_value(ExecNode* node, const string& name) {
+        RuntimeProfile::Counter* counter = node->runtime_profile()->get_counter(name);
+        EXPECT_TRUE(counter != NULL) << name;
+        return counter == NULL ? 0 : counter->value();
+    }
+
+    ObjectPool _pool;
+    scoped_ptr<TestEnv> _test_env;
+    scoped_ptr<JoinTestPlan> _plan;
+    int64_t _next_query_id;
+};
+
+// Small inputs with duplicate keys, NULL keys and NULL values on both sides, all
+// partitions fit in memory.
+TEST_F(PartitionedHashJoinNodeTest, SameRowsAsHashJoinNode) {
+    vector<KeyValRow> probe_rows;
+    for (int i = 0; i < 1000; ++i) {
+        KeyValRow row;
+        row.key = (i % 37 == 0) ? KeyValRow::NULL_VALUE : i % 300;
+        row.val = (i % 41 == 0) ? KeyValRow::NULL_VALUE : i % 13;
+        probe_rows.push_back(row);
+    }
+    vector<KeyValRow> build_rows;
+    for (int i = 0; i < 800; ++i) {
+        KeyValRow row;
+        row.key = (i % 29 == 0) ? KeyValRow::NULL_VALUE : (i * 3) % 400;
+        row.val = (i % 31 == 0) ? KeyValRow::NULL_VALUE : i % 17;
+        build_rows.push_back(row);
+    }
+
+    for (int i = 0; i < NUM_JOIN_OPS; ++i) {
+        ExecNode* join = check_same_rows(
+                JOIN_OPS[i], false, probe_rows, build_rows, -1, 8 * 1024 * 1024);
+        EXPECT_EQ(0, counter_value(join, "SpilledPartitions"));
+        check_same_rows(JOIN_OPS[i], true, probe_rows, build_rows, -1, 8 * 1024 * 1024);
+    }
+}
+
+// An empty build side.
+TEST_F(PartitionedHashJoinNodeTest, EmptyBuild) {
+    vector<KeyValRow> probe_rows;
+    for (int i = 0; i < 100; ++i) {
+        KeyValRow row;
+        row.key = (i % 10 == 0) ? KeyValRow::NULL_VALUE : i;
+        row.val = i;
+        probe_rows.push_back(row);
+    }
+    vector<KeyValRow> build_rows;
+
+    const TJoinOp::type join_ops[] = {
+        TJoinOp::LEFT_OUTER_JOIN, TJoinOp::LEFT_ANTI_JOIN, TJoinOp::FULL_OUTER_JOIN
+    };
+    for (int i = 0; i < sizeof(join_ops) / sizeof(join_ops[0]); ++i) {
+        check_same_rows(join_ops[i], false, probe_rows, build_rows, -1, 8 * 1024 * 1024);
+    }
+}
+
+// The build rows are about 1.8MB, the block manager only has 48 blocks of 8KB, which
+// are smaller than the initial small buffers so all buffers of the streams are
+// IO-sized. The partitions spill while the build rows are partitioned. A spilled
+// partition has about 12500 rows, its hash table needs 32768 buckets of 16 bytes,
+// 64 blocks, so it can't be built and the partition is repartitioned.
+TEST_F(PartitionedHashJoinNodeTest, SpillAndRepartition) {
+    vector<KeyValRow> probe_rows;
+    for (int i = 0; i < 50000; ++i) {
+        KeyValRow row;
+        row.key = (i % 1000 == 0) ? KeyValRow::NULL_VALUE : (i * 7) % 120000;
+        row.val = i % 100;
+        probe_rows.push_back(row);
+    }
+    vector<KeyValRow> build_rows;
+    for (int i = 0; i < 200000; ++i) {
+        KeyValRow row;
+        row.key = (i % 1000 == 0) ? KeyValRow::NULL_VALUE : i / 2;
+        row.val = i % 97;
+        build_rows.push_back(row);
+    }
+
+    for (int i = 0; i < NUM_JOIN_OPS; ++i) {
+        for (int val_less_than = 0; val_less_than < 2; ++val_less_than) {
+            ExecNode* join = check_same_rows(
+                    JOIN_OPS[i], val_less_than, probe_rows, build_rows, 48, 8 * 1024);
+            EXPECT_GT(counter_value(join, "SpilledPartitions"), 0) << JOIN_OPS[i];
+            EXPECT_GT(counter_value(join, "NumRepartitions"), 0) << JOIN_OPS[i];
+        }
+    }
+}
+
+} // end namespace palo
+
+int main(int argc, char** argv) {
+    palo::config::query_scratch_dirs = "/tmp";
+    palo::config::read_size = 8388608;
+    palo::config::min_buffer_size = 1024;
+    palo::config::disable_mem_pools = false;
+
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+
+    palo::CpuInfo::init();
+    palo::DiskInfo::init();
+
+    return RUN_ALL_TESTS();
+}
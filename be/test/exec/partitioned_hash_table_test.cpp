@@ -572,6 +572,46 @@ TEST_F(PartitionedHashTableTest, HashEmpty) {
     ht_ctx.close();
 }
 
+// Evaluates a group of probe rows before looking them up, as the aggregation does.
+TEST_F(PartitionedHashTableTest, CachedRowsTest) {
+    TupleRow* build_rows[5];
+    for (int i = 0; i < 5; ++i) {
+        build_rows[i] = CreateTupleRow(i);
+    }
+    scoped_ptr<PartitionedHashTable> hash_table;
+    ASSERT_TRUE(CreateHashTable(true, 64, &hash_table));
+    PartitionedHashTableCtx ht_ctx(_build_expr_ctxs, _probe_expr_ctxs, false, false, 1, 0, 1);
+    ASSERT_TRUE(hash_table->check_and_resize(5, &ht_ctx));
+    uint32_t hash = 0;
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(ht_ctx.eval_and_hash_build(build_rows[i], &hash));
+        EXPECT_TRUE(hash_table->insert(&ht_ctx, build_rows[i]->get_tuple(0), hash));
+    }
+
+    TupleRow* probe_rows[10];
+    uint32_t hashes[10];
+    for (int i = 0; i < 10; ++i) {
+        probe_rows[i] = CreateTupleRow(i);
+        ASSERT_TRUE(ht_ctx.eval_and_hash_probe(probe_rows[i], &hashes[i]));
+        ht_ctx.cache_last_row(i);
+        hash_table->prefetch_bucket(hashes[i]);
+    }
+    for (int i = 0; i < 10; ++i) {
+        ht_ctx.load_cached_row(i);
+        EXPECT_EQ(i, *reinterpret_cast<int32_t*>(ht_ctx.last_expr_value(0)));
+        PartitionedHashTable::Iterator iter = hash_table->find(&ht_ctx, hashes[i]);
+        if (i < 5) {
+            ASSERT_FALSE(iter.at_end());
+            EXPECT_EQ(build_rows[i]->get_tuple(0), iter.get_tuple());
+        } else {
+            EXPECT_TRUE(iter.at_end());
+        }
+    }
+
+    hash_table->close();
+    ht_ctx.close();
+}
+
 TEST_F(PartitionedHashTableTest, VeryLowMemTest) {
     VeryLowMemTest(true);
     VeryLowMemTest(false);
@@ -17,6 +17,7 @@
 
 #include <gtest/gtest.h>
 
+#include "common/config.h"
 #include "exec/local_file_reader.h"
 #include "exec/decompressor.h"
 #include "util/runtime_profile.h"
@@ -89,6 +90,59 @@ TEST_F(PlainTextLineReaderTest, gzip_normal_use) {
     ASSERT_TRUE(eof);
 }
 
+TEST_F(PlainTextLineReaderTest, bgzip_normal_use) {
+    LocalFileReader file_reader(
+            "./be/test/exec/test_data/plain_text_line_reader/test_file.csv.bgz", 0);
+    auto st = file_reader.open();
+    ASSERT_TRUE(st.ok());
+    
+    // every 4 bytes are a block of their own
+    config::load_decompress_threads = 2;
+    Decompressor* decompressor;
+    st = Decompressor::create_decompressor(CompressType::GZIP, &decompressor);
+    ASSERT_TRUE(st.ok());
+
+    PlainTextLineReader line_reader(&_profile, &file_reader, decompressor, -1, '\n');
+    const uint8_t* ptr;
+    size_t size;
+    bool eof;
+
+    // 1,2
+    st = line_reader.read_line(&ptr, &size, &eof);
+    ASSERT_TRUE(st.ok());
+    ASSERT_EQ(3, size);
+    ASSERT_FALSE(eof);
+    LOG(INFO) << std::string((const char*)ptr, size);
+
+    // Empty
+    st = line_reader.read_line(&ptr, &size, &eof);
+    ASSERT_TRUE(st.ok());
+    ASSERT_EQ(0, size);
+    ASSERT_FALSE(eof);
+
+    // 1,2,3,4
+    st = line_reader.read_line(&ptr, &size, &eof);
+    ASSERT_TRUE(st.ok());
+    ASSERT_EQ(7, size);
+    ASSERT_FALSE(eof);
+    LOG(INFO) << std::string((const char*)ptr, size);
+
+    // Empty
+    st = line_reader.read_line(&ptr, &size, &eof);
+    ASSERT_TRUE(st.ok());
+    ASSERT_FALSE(eof);
+
+    // Empty
+    st = line_reader.read_line(&ptr, &size, &eof);
+    ASSERT_TRUE(st.ok());
+    ASSERT_FALSE(eof);
+
+    // Empty
+    st = line_reader.read_line(&ptr, &size, &eof);
+    ASSERT_TRUE(st.ok());
+    ASSERT_TRUE(eof);
+}
+
 TEST_F(PlainTextLineReaderTest, gzip_test_limit) {
     LocalFileReader file_reader("./be/test/exec/test_data/plain_text_line_reader/limit.csv.gz", 0);
     auto st = file_reader.open();
@@ -0,0 +1,326 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/topn_runtime_bound.h"
+
+#include <string.h>
+
+#include <string>
+
+#include <boost/scoped_ptr.hpp>
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "gen_cpp/Descriptors_types.h"
+#include "runtime/datetime_value.h"
+#include "runtime/descriptors.h"
+#include "runtime/tuple.h"
+#include "util/logging.h"
+
+using std::string;
+
+using boost::scoped_ptr;
+
+namespace palo {
+
+// The slot of the bound lives at this offset of the test tuple, after its null byte.
+static const int SLOT_OFFSET = 16;
+
+class TopNRuntimeBoundTest : public testing::Test {
+public:
+    TopNRuntimeBoundTest() {}
+    ~TopNRuntimeBoundTest() {}
+
+protected:
+    virtual void SetUp() {
+        memset(_tuple_buf, 0, sizeof(_tuple_buf));
+    }
+
+    // A slot of column "k1" of 'type' at SLOT_OFFSET, which has a null indicator if
+    // 'nullable' is true.
+    void create_slot(const TypeDescriptor& type, bool nullable) {
+        TSlotDescriptor tdesc;
+        tdesc.__set_id(0);
+        tdesc.__set_parent(0);
+        tdesc.__set_slotType(type.to_thrift());
+        tdesc.__set_columnPos(0);
+        tdesc.__set_byteOffset(SLOT_OFFSET);
+        tdesc.__set_nullIndicatorByte(0);
+        tdesc.__set_nullIndicatorBit(nullable ? 0 : -1);
+        tdesc.__set_colName("k1");
+        tdesc.__set_slotIdx(0);
+        tdesc.__set_isMaterialized(true);
+        _slot_desc.reset(new SlotDescriptor(tdesc));
+    }
+
+    Tuple* tuple() {
+        return reinterpret_cast<Tuple*>(_tuple_buf);
+    }
+
+    // The test tuple with the slot set to 'value'.
+    Tuple* int_tuple(int32_t value) {
+        tuple()->set_not_null(_slot_desc->null_indicator_offset());
+        *reinterpret_cast<int32_t*>(tuple()->get_slot(SLOT_OFFSET)) = value;
+        return tuple();
+    }
+
+    Tuple* null_tuple() {
+        tuple()->set_null(_slot_desc->null_indicator_offset());
+        return tuple();
+    }
+
+    // Returns whether the row with value 'value' may qualify for the current bound.
+    bool int_may_qualify(const TopNRuntimeBound& bound, int32_t value) {
+        TopNRuntimeBound::Snapshot snapshot;
+        bound.refresh(&snapshot);
+        return bound.may_qualify(snapshot, int_tuple(value));
+    }
+
+    bool null_may_qualify(const TopNRuntimeBound& bound) {
+        TopNRuntimeBound::Snapshot snapshot;
+        bound.refresh(&snapshot);
+        return bound.may_qualify(snapshot, null_tuple());
+    }
+
+    scoped_ptr<SlotDescriptor> _slot_desc;
+    __int128 _tuple_buf[4];
+};
+
+TEST_F(TopNRuntimeBoundTest, NoBound) {
+    create_slot(TYPE_INT, true);
+    TopNRuntimeBound bound(_slot_desc.get(), true, false);
+
+    EXPECT_TRUE(int_may_qualify(bound, 100));
+    EXPECT_TRUE(null_may_qualify(bound));
+    TCondition condition;
+    EXPECT_FALSE(bound.to_olap_condition(&condition));
+}
+
+TEST_F(TopNRuntimeBoundTest, Asc) {
+    create_slot(TYPE_INT, false);
+    TopNRuntimeBound bound(_slot_desc.get(), true, false);
+    int32_t value = 10;
+    bound.set(&value);
+
+    EXPECT_TRUE(int_may_qualify(bound, -5));
+    EXPECT_TRUE(int_may_qualify(bound, 9));
+    // Ties at the bound are kept, a later ORDER BY expr may still let them in.
+    EXPECT_TRUE(int_may_qualify(bound, 10));
+    EXPECT_FALSE(int_may_qualify(bound, 11));
+
+    TCondition condition;
+    ASSERT_TRUE(bound.to_olap_condition(&condition));
+    EXPECT_EQ("k1", condition.column_name);
+    EXPECT_EQ("<=", condition.condition_op);
+    ASSERT_EQ(1, condition.condition_values.size());
+    EXPECT_EQ("10", condition.condition_values[0]);
+}
+
+TEST_F(TopNRuntimeBoundTest, Desc) {
+    create_slot(TYPE_INT, false);
+    TopNRuntimeBound bound(_slot_desc.get(), false, false);
+    int32_t value = -10;
+    bound.set(&value);
+
+    EXPECT_TRUE(int_may_qualify(bound, 100));
+    EXPECT_TRUE(int_may_qualify(bound, -10));
+    EXPECT_FALSE(int_may_qualify(bound, -11));
+
+    TCondition condition;
+    ASSERT_TRUE(bound.to_olap_condition(&condition));
+    EXPECT_EQ(">=", condition.condition_op);
+    ASSERT_EQ(1, condition.condition_values.size());
+    EXPECT_EQ("-10", condition.condition_values[0]);
+}
+
+// A new bound is picked up by a snapshot that was taken before.
+TEST_F(TopNRuntimeBoundTest, Tighten) {
+    create_slot(TYPE_INT, false);
+    TopNRuntimeBound bound(_slot_desc.get(), true, false);
+    TopNRuntimeBound::Snapshot snapshot;
+    bound.refresh(&snapshot);
+    EXPECT_TRUE(bound.may_qualify(snapshot, int_tuple(50)));
+
+    int32_t value = 100;
+    bound.set(&value);
+    bound.refresh(&snapshot);
+    EXPECT_TRUE(bound.may_qualify(snapshot, int_tuple(50)));
+
+    value = 20;
+    bound.set(&value);
+    bound.refresh(&snapshot);
+    EXPECT_FALSE(bound.may_qualify(snapshot, int_tuple(50)));
+    EXPECT_TRUE(bound.may_qualify(snapshot, int_tuple(20)));
+}
+
+TEST_F(TopNRuntimeBoundTest, NullsLast) {
+    create_slot(TYPE_INT, true);
+    TopNRuntimeBound bound(_slot_desc.get(), true, false);
+    int32_t value = 10;
+    bound.set(&value);
+
+    // The bound is not NULL, the NULLs are behind it.
+    EXPECT_FALSE(null_may_qualify(bound));
+    EXPECT_TRUE(int_may_qualify(bound, 10));
+    EXPECT_FALSE(int_may_qualify(bound, 11));
+
+    // The storage conditions never accept NULL, which is fine here.
+    TCondition condition;
+    ASSERT_TRUE(bound.to_olap_condition(&condition));
+    EXPECT_EQ("<=", condition.condition_op);
+    EXPECT_EQ("10", condition.condition_values[0]);
+}
+
+TEST_F(TopNRuntimeBoundTest, NullsFirst) {
+    create_slot(TYPE_INT, true);
+    TopNRuntimeBound bound(_slot_desc.get(), false, true);
+    int32_t value = 10;
+    bound.set(&value);
+
+    EXPECT_TRUE(null_may_qualify(bound));
+    EXPECT_TRUE(int_may_qualify(bound, 10));
+    EXPECT_FALSE(int_may_qualify(bound, 9));
+
+    // A storage condition would drop the NULLs, which are in front of the bound.
+    TCondition condition;
+    EXPECT_FALSE(bound.to_olap_condition(&condition));
+}
+
+// NULLS FIRST does not matter if the key column is not nullable.
+TEST_F(TopNRuntimeBoundTest, NullsFirstNotNullable) {
+    create_slot(TYPE_INT, false);
+    TopNRuntimeBound bound(_slot_desc.get(), false, true);
+    int32_t value = 10;
+    bound.set(&value);
+
+    EXPECT_FALSE(int_may_qualify(bound, 9));
+    TCondition condition;
+    ASSERT_TRUE(bound.to_olap_condition(&condition));
+    EXPECT_EQ(">=", condition.condition_op);
+    EXPECT_EQ("10", condition.condition_values[0]);
+}
+
+TEST_F(TopNRuntimeBoundTest, TinyInt) {
+    create_slot(TYPE_TINYINT, false);
+    TopNRuntimeBound bound(_slot_desc.get(), true, false);
+    int8_t value = -3;
+    bound.set(&value);
+
+    TCondition condition;
+    ASSERT_TRUE(bound.to_olap_condition(&condition));
+    // Printed as a number, not as a character.
+    EXPECT_EQ("-3", condition.condition_values[0]);
+}
+
+TEST_F(TopNRuntimeBoundTest, LargeInt) {
+    create_slot(TYPE_LARGEINT, false);
+    TopNRuntimeBound bound(_slot_desc.get(), false, false);
+    __int128 value = static_cast<__int128>(1) << 100;
+    bound.set(&value);
+
+    TopNRuntimeBound::Snapshot snapshot;
+    bound.refresh(&snapshot);
+    tuple()->set_not_null(_slot_desc->null_indicator_offset());
+    *reinterpret_cast<__int128*>(tuple()->get_slot(SLOT_OFFSET)) = value - 1;
+    EXPECT_FALSE(bound.may_qualify(snapshot, tuple()));
+    *reinterpret_cast<__int128*>(tuple()->get_slot(SLOT_OFFSET)) = value;
+    EXPECT_TRUE(bound.may_qualify(snapshot, tuple()));
+
+    TCondition condition;
+    ASSERT_TRUE(bound.to_olap_condition(&condition));
+    EXPECT_EQ(">=", condition.condition_op);
+    EXPECT_EQ("1267650600228229401496703205376", condition.condition_values[0]);
+
+    value = -value;
+    bound.set(&value);
+    ASSERT_TRUE(bound.to_olap_condition(&condition));
+    EXPECT_EQ("-1267650600228229401496703205376", condition.condition_values[0]);
+}
+
+TEST_F(TopNRuntimeBoundTest, Date) {
+    create_slot(TYPE_DATE, false);
+    TopNRuntimeBound bound(_slot_desc.get(), true, false);
+    DateTimeValue value;
+    const string str = "2017-10-01";
+    ASSERT_TRUE(value.from_date_str(str.c_str(), str.size()));
+    bound.set(&value);
+
+    TopNRuntimeBound::Snapshot snapshot;
+    bound.refresh(&snapshot);
+    DateTimeValue row_value;
+    const string later = "2017-10-02";
+    ASSERT_TRUE(row_value.from_date_str(later.c_str(), later.size()));
+    tuple()->set_not_null(_slot_desc->null_indicator_offset());
+    *reinterpret_cast<DateTimeValue*>(tuple()->get_slot(SLOT_OFFSET)) = row_value;
+    EXPECT_FALSE(bound.may_qualify(snapshot, tuple()));
+    *reinterpret_cast<DateTimeValue*>(tuple()->get_slot(SLOT_OFFSET)) = value;
+    EXPECT_TRUE(bound.may_qualify(snapshot, tuple()));
+
+    TCondition condition;
+    ASSERT_TRUE(bound.to_olap_condition(&condition));
+    EXPECT_EQ("<=", condition.condition_op);
+    EXPECT_EQ("2017-10-01", condition.condition_values[0]);
+}
+
+TEST_F(TopNRuntimeBoundTest, DateTime) {
+    create_slot(TYPE_DATETIME, false);
+    TopNRuntimeBound bound(_slot_desc.get(), false, false);
+    DateTimeValue value;
+    const string str = "2017-10-01 12:30:45";
+    ASSERT_TRUE(value.from_date_str(str.c_str(), str.size()));
+    bound.set(&value);
+
+    TCondition condition;
+    ASSERT_TRUE(bound.to_olap_condition(&condition));
+    EXPECT_EQ(">=", condition.condition_op);
+    EXPECT_EQ("2017-10-01 12:30:45", condition.condition_values[0]);
+}
+
+// A string bound is applied to the rows, but not expressed as a storage condition.
+TEST_F(TopNRuntimeBoundTest, String) {
+    create_slot(TypeDescriptor::create_varchar_type(10), false);
+    TopNRuntimeBound bound(_slot_desc.get(), true, false);
+    string bound_str = "bcd";
+    StringValue value(const_cast<char*>(bound_str.data()), bound_str.size());
+    bound.set(&value);
+    // The bound keeps its own copy.
+    bound_str = "zzz";
+
+    TopNRuntimeBound::Snapshot snapshot;
+    bound.refresh(&snapshot);
+    string row_str = "bcd";
+    tuple()->set_not_null(_slot_desc->null_indicator_offset());
+    *reinterpret_cast<StringValue*>(tuple()->get_slot(SLOT_OFFSET)) =
+        StringValue(const_cast<char*>(row_str.data()), row_str.size());
+    EXPECT_TRUE(bound.may_qualify(snapshot, tuple()));
+    row_str = "bce";
+    EXPECT_FALSE(bound.may_qualify(snapshot, tuple()));
+
+    TCondition condition;
+    EXPECT_FALSE(bound.to_olap_condition(&condition));
+}
+
+} // end namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
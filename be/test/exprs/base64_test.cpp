@@ -0,0 +1,88 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exprs/base64.h"
+
+#include <string>
+#include <gtest/gtest.h>
+
+namespace palo {
+
+class Base64Test : public testing::Test {
+public:
+    Base64Test() { }
+
+protected:
+    std::string encode(const std::string& src) {
+        std::string dst((src.size() + 2) / 3 * 4, '\0');
+        size_t len = base64_encode2((const unsigned char*)src.data(), src.size(),
+                                    (unsigned char*)&dst[0]);
+        dst.resize(len);
+        return dst;
+    }
+
+    bool decode(const std::string& src, std::string* dst) {
+        dst->assign(src.size() + 1, '\0');
+        int64_t len = base64_decode2(src.data(), src.size(), &(*dst)[0]);
+        if (len < 0) {
+            return false;
+        }
+        dst->resize(len);
+        return true;
+    }
+};
+
+TEST_F(Base64Test, known_values) {
+    ASSERT_EQ("", encode(""));
+    ASSERT_EQ("Zg==", encode("f"));
+    ASSERT_EQ("Zm8=", encode("fo"));
+    ASSERT_EQ("Zm9v", encode("foo"));
+    ASSERT_EQ("Zm9vYmFy", encode("foobar"));
+    // long enough for the vectorized blocks
+    ASSERT_EQ("VGhlIHF1aWNrIGJyb3duIGZveCBqdW1wcyBvdmVyIHRoZSBsYXp5IGRvZw==",
+              encode("The quick brown fox jumps over the lazy dog"));
+
+    std::string out;
+    ASSERT_TRUE(decode("VGhlIHF1aWNrIGJyb3duIGZveCBqdW1wcyBvdmVyIHRoZSBsYXp5IGRvZw==", &out));
+    ASSERT_EQ("The quick brown fox jumps over the lazy dog", out);
+    ASSERT_TRUE(decode("Zm9v\nYmFy", &out));
+    ASSERT_EQ("foobar", out);
+}
+
+TEST_F(Base64Test, round_trip) {
+    srand(1);
+    for (int i = 0; i < 1000; ++i) {
+        std::string src(i % 100, '\0');
+        for (int j = 0; j < src.size(); ++j) {
+            src[j] = rand();
+        }
+        std::string out;
+        ASSERT_TRUE(decode(encode(src), &out));
+        ASSERT_EQ(src, out);
+    }
+}
+
+TEST_F(Base64Test, invalid) {
+    std::string out;
+    ASSERT_FALSE(decode("VGhlIHF1aWNrIGJyb3duIGZveC*qdW1wcyBvdmVy", &out));
+    ASSERT_FALSE(decode("Zm9v*mFy", &out));
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -322,6 +322,47 @@ TEST_F(HybirdSetTest, string) {
     b.len = 5;
     ASSERT_FALSE(set->find(&b));
 }
+
+// More values than are searched linearly
+TEST_F(HybirdSetTest, large_bigint) {
+    HybirdSetBase* set = HybirdSetBase::create_set(TYPE_BIGINT);
+    for (int64_t i = -100; i < 100; i += 2) {
+        set->insert(&i);
+        set->insert(&i);
+    }
+    ASSERT_EQ(100, set->size());
+
+    int num_values = 0;
+    HybirdSetBase::IteratorBase* base = set->begin();
+    while (base->has_next()) {
+        ASSERT_EQ(0, *(int64_t*)base->get_value() % 2);
+        ++num_values;
+        base->next();
+    }
+    ASSERT_EQ(100, num_values);
+
+    for (int64_t i = -101; i < 101; ++i) {
+        ASSERT_EQ(i % 2 == 0 && i >= -100 && i < 100, set->find(&i));
+    }
+}
+
+TEST_F(HybirdSetTest, large_string) {
+    HybirdSetBase* set = HybirdSetBase::create_set(TYPE_VARCHAR);
+    char buf[100];
+    for (int i = 0; i < 100; ++i) {
+        StringValue a(buf, snprintf(buf, 100, "value_%d", i * 2));
+        set->insert(&a);
+        set->insert(&a);
+    }
+    ASSERT_EQ(100, set->size());
+
+    for (int i = 0; i < 200; ++i) {
+        StringValue a(buf, snprintf(buf, 100, "value_%d", i));
+        ASSERT_EQ(i % 2 == 0, set->find(&a));
+    }
+    StringValue empty(buf, 0);
+    ASSERT_FALSE(set->find(&empty));
+}
 TEST_F(HybirdSetTest, timestamp) {
     HybirdSetBase* set = HybirdSetBase::create_set(TYPE_DATETIME);
     char s1[] = "2012-01-20 01:10:01";
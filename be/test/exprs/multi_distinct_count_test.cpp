@@ -0,0 +1,100 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exprs/aggregate_functions.h"
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "udf/udf.h"
+
+namespace palo {
+
+using palo_udf::BigIntVal;
+using palo_udf::FunctionContext;
+using palo_udf::StringVal;
+
+class MultiDistinctCountTest : public testing::Test {
+public:
+    MultiDistinctCountTest() : _ctx(FunctionContext::create_test_context()) {
+    }
+
+    ~MultiDistinctCountTest() {
+        delete _ctx;
+    }
+
+protected:
+    FunctionContext* _ctx;
+};
+
+TEST_F(MultiDistinctCountTest, integers) {
+    StringVal state;
+    AggregateFunctions::multi_distinct_count_init(_ctx, &state);
+    for (int64_t value : {1L, 2L, 1L, -5L, -5L, 1L << 40, 2L}) {
+        AggregateFunctions::multi_distinct_count_update_int(_ctx, BigIntVal(value), &state);
+    }
+    AggregateFunctions::multi_distinct_count_update_int(_ctx, BigIntVal::null(), &state);
+    BigIntVal result = AggregateFunctions::multi_distinct_count_finalize(_ctx, state);
+    EXPECT_FALSE(result.is_null);
+    EXPECT_EQ(4, result.val);
+}
+
+TEST_F(MultiDistinctCountTest, merge_serialized) {
+    StringVal left;
+    StringVal right;
+    AggregateFunctions::multi_distinct_count_init(_ctx, &left);
+    AggregateFunctions::multi_distinct_count_init(_ctx, &right);
+    std::string values[] = {"a", "bb", "", "a", "ccc"};
+    for (int i = 0; i < 3; ++i) {
+        AggregateFunctions::multi_distinct_count_update_string(
+            _ctx, StringVal((uint8_t*) values[i].data(), values[i].size()), &left);
+    }
+    for (int i = 2; i < 5; ++i) {
+        AggregateFunctions::multi_distinct_count_update_string(
+            _ctx, StringVal((uint8_t*) values[i].data(), values[i].size()), &right);
+    }
+
+    StringVal serialized = AggregateFunctions::multi_distinct_count_serialize(_ctx, left);
+    ASSERT_FALSE(serialized.is_null);
+    StringVal merged;
+    AggregateFunctions::multi_distinct_count_init(_ctx, &merged);
+    AggregateFunctions::multi_distinct_count_merge(_ctx, serialized, &merged);
+    _ctx->free(serialized.ptr);
+    serialized = AggregateFunctions::multi_distinct_count_serialize(_ctx, right);
+    AggregateFunctions::multi_distinct_count_merge(_ctx, serialized, &merged);
+    _ctx->free(serialized.ptr);
+    EXPECT_FALSE(_ctx->has_error());
+
+    BigIntVal result = AggregateFunctions::multi_distinct_count_finalize(_ctx, merged);
+    EXPECT_EQ(4, result.val);
+}
+
+TEST_F(MultiDistinctCountTest, invalid_set) {
+    StringVal state;
+    AggregateFunctions::multi_distinct_count_init(_ctx, &state);
+    uint8_t garbage[] = {0xFF, 0xFF, 0xFF, 0x7F, 1};
+    AggregateFunctions::multi_distinct_count_merge(_ctx, StringVal(garbage, sizeof(garbage)),
+                                                   &state);
+    EXPECT_TRUE(_ctx->has_error());
+    AggregateFunctions::multi_distinct_count_finalize(_ctx, state);
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exprs/aggregate_functions.h"
+
+#include <gtest/gtest.h>
+
+#include "runtime/decimal_value.h"
+#include "udf/udf.h"
+
+namespace palo {
+
+using palo_udf::BigIntVal;
+using palo_udf::DecimalVal;
+using palo_udf::FunctionContext;
+using palo_udf::StringVal;
+
+class MultiDistinctSumTest : public testing::Test {
+public:
+    MultiDistinctSumTest() : _ctx(FunctionContext::create_test_context()) {
+    }
+
+    ~MultiDistinctSumTest() {
+        delete _ctx;
+    }
+
+protected:
+    FunctionContext* _ctx;
+};
+
+TEST_F(MultiDistinctSumTest, merge_serialized) {
+    StringVal left;
+    StringVal right;
+    AggregateFunctions::multi_distinct_sum_init<BigIntVal>(_ctx, &left);
+    AggregateFunctions::multi_distinct_sum_init<BigIntVal>(_ctx, &right);
+    for (int64_t value : {1L, 2L, 2L, -7L}) {
+        AggregateFunctions::multi_distinct_sum_update(_ctx, BigIntVal(value), &left);
+    }
+    for (int64_t value : {2L, 10L, 1L}) {
+        AggregateFunctions::multi_distinct_sum_update(_ctx, BigIntVal(value), &right);
+    }
+    AggregateFunctions::multi_distinct_sum_update(_ctx, BigIntVal::null(), &right);
+
+    StringVal merged;
+    AggregateFunctions::multi_distinct_sum_init<BigIntVal>(_ctx, &merged);
+    StringVal serialized = AggregateFunctions::multi_distinct_sum_serialize<BigIntVal>(_ctx, left);
+    ASSERT_FALSE(serialized.is_null);
+    AggregateFunctions::multi_distinct_sum_merge<BigIntVal>(_ctx, serialized, &merged);
+    _ctx->free(serialized.ptr);
+    serialized = AggregateFunctions::multi_distinct_sum_serialize<BigIntVal>(_ctx, right);
+    AggregateFunctions::multi_distinct_sum_merge<BigIntVal>(_ctx, serialized, &merged);
+    _ctx->free(serialized.ptr);
+    EXPECT_FALSE(_ctx->has_error());
+
+    BigIntVal result = AggregateFunctions::multi_distinct_sum_finalize<BigIntVal>(_ctx, merged);
+    EXPECT_FALSE(result.is_null);
+    EXPECT_EQ(6, result.val);
+}
+
+TEST_F(MultiDistinctSumTest, decimal) {
+    StringVal state;
+    AggregateFunctions::multi_distinct_sum_init<DecimalVal>(_ctx, &state);
+    for (const char* value : {"1.5", "2.25", "1.5"}) {
+        DecimalVal val;
+        DecimalValue(std::string(value)).to_decimal_val(&val);
+        AggregateFunctions::multi_distinct_sum_update(_ctx, val, &state);
+    }
+    StringVal serialized =
+        AggregateFunctions::multi_distinct_sum_serialize<DecimalVal>(_ctx, state);
+    StringVal merged;
+    AggregateFunctions::multi_distinct_sum_init<DecimalVal>(_ctx, &merged);
+    AggregateFunctions::multi_distinct_sum_merge<DecimalVal>(_ctx, serialized, &merged);
+    _ctx->free(serialized.ptr);
+
+    DecimalVal result = AggregateFunctions::multi_distinct_sum_finalize<DecimalVal>(_ctx, merged);
+    EXPECT_FALSE(result.is_null);
+    EXPECT_EQ("3.75", DecimalValue::from_decimal_val(result).to_string(2));
+}
+
+TEST_F(MultiDistinctSumTest, empty) {
+    StringVal state;
+    AggregateFunctions::multi_distinct_sum_init<BigIntVal>(_ctx, &state);
+    AggregateFunctions::multi_distinct_sum_update(_ctx, BigIntVal::null(), &state);
+    EXPECT_TRUE(AggregateFunctions::multi_distinct_sum_finalize<BigIntVal>(_ctx, state).is_null);
+}
+
+TEST_F(MultiDistinctSumTest, invalid_set) {
+    StringVal state;
+    AggregateFunctions::multi_distinct_sum_init<BigIntVal>(_ctx, &state);
+    uint8_t garbage[] = {0xFF, 0xFF, 0xFF, 0x7F, 1};
+    AggregateFunctions::multi_distinct_sum_merge<BigIntVal>(
+        _ctx, StringVal(garbage, sizeof(garbage)), &state);
+    EXPECT_TRUE(_ctx->has_error());
+    AggregateFunctions::multi_distinct_sum_finalize<BigIntVal>(_ctx, state);
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,170 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "olap/column_file/bitmap_index_reader.h"
+#include "olap/column_file/bitmap_index_writer.h"
+#include "olap/column_file/byte_buffer.h"
+#include "olap/column_file/out_stream.h"
+#include "util/logging.h"
+
+using std::string;
+
+namespace palo {
+namespace column_file {
+
+class TestBitmapIndex : public testing::Test {
+public:
+    virtual ~TestBitmapIndex() {}
+
+    virtual void SetUp() {}
+    virtual void TearDown() {}
+
+    // copy the content of an uncompressed out stream without stream heads
+    void read_stream(OutStream* out_stream, string* bytes) {
+        bytes->clear();
+        for (ByteBuffer* buffer : out_stream->output_buffers()) {
+            ASSERT_GE(buffer->limit(), sizeof(StreamHead));
+            bytes->append(buffer->array() + sizeof(StreamHead),
+                          buffer->limit() - sizeof(StreamHead));
+        }
+    }
+};
+
+// Test the normal read and write process
+TEST_F(TestBitmapIndex, normal_read_and_write) {
+    Field* field = Field::create_by_type(OLAP_FIELD_TYPE_INT);
+    ASSERT_TRUE(NULL != field);
+    ASSERT_TRUE(field->allocate());
+
+    // rows: 3, NULL, 7, 3, ..., 3 at row 299
+    BitmapIndexWriter writer(16);
+    const char* values[] = {"3", NULL, "7", "3"};
+    for (int i = 0; i < 300; ++i) {
+        const char* value = i == 299 ? "3" : values[i % 4];
+        if (NULL == value) {
+            field->set_null();
+        } else {
+            field->set_not_null();
+            field->from_string(value);
+        }
+        writer.add(field);
+    }
+    ASSERT_FALSE(writer.is_abandoned());
+
+    OutStream out_stream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, NULL);
+    ASSERT_EQ(OLAP_SUCCESS, writer.write_to_buffer(&out_stream));
+    ASSERT_EQ(OLAP_SUCCESS, out_stream.flush());
+
+    string bytes;
+    read_stream(&out_stream, &bytes);
+
+    BitmapIndexReader reader;
+    ASSERT_EQ(OLAP_SUCCESS, reader.init(&bytes[0], bytes.size(), true));
+    ASSERT_EQ(300U, reader.row_count());
+
+    RowBitmap rows;
+    rows.init(reader.row_count(), false);
+    field->set_not_null();
+    field->from_string("3");
+    ASSERT_EQ(OLAP_SUCCESS, reader.add_rows(field, &rows));
+    for (uint64_t i = 0; i < 300; ++i) {
+        ASSERT_EQ(i == 299 || i % 4 == 0 || i % 4 == 3, rows.test(i));
+    }
+
+    rows.init(reader.row_count(), false);
+    ASSERT_EQ(OLAP_SUCCESS, reader.add_null_rows(&rows));
+    for (uint64_t i = 0; i < 300; ++i) {
+        ASSERT_EQ(i != 299 && i % 4 == 1, rows.test(i));
+    }
+    rows.flip();
+    ASSERT_FALSE(rows.test(1));
+    ASSERT_TRUE(rows.test(299));
+
+    // value not in this segment
+    rows.init(reader.row_count(), false);
+    field->from_string("5");
+    ASSERT_EQ(OLAP_SUCCESS, reader.add_rows(field, &rows));
+    ASSERT_FALSE(rows.any(0, 300));
+
+    SAFE_DELETE(field);
+}
+
+// Test that the index is abandoned when there are too many distinct values
+TEST_F(TestBitmapIndex, abandon_high_cardinality) {
+    Field* field = Field::create_by_type(OLAP_FIELD_TYPE_INT);
+    ASSERT_TRUE(NULL != field);
+    ASSERT_TRUE(field->allocate());
+
+    BitmapIndexWriter writer(2);
+    field->set_not_null();
+    field->from_string("1");
+    writer.add(field);
+    field->from_string("2");
+    writer.add(field);
+    field->from_string("1");
+    writer.add(field);
+    ASSERT_FALSE(writer.is_abandoned());
+
+    field->from_string("3");
+    writer.add(field);
+    ASSERT_TRUE(writer.is_abandoned());
+
+    OutStream out_stream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, NULL);
+    ASSERT_NE(OLAP_SUCCESS, writer.write_to_buffer(&out_stream));
+
+    SAFE_DELETE(field);
+}
+
+// Test the bit operations of RowBitmap
+TEST_F(TestBitmapIndex, row_bitmap) {
+    RowBitmap left;
+    RowBitmap right;
+    left.init(130, true);
+    right.init(130, false);
+    ASSERT_FALSE(right.any(0, 130));
+
+    right.set(65);
+    right.set(129);
+    left.intersect(right);
+    ASSERT_TRUE(left.test(65));
+    ASSERT_TRUE(left.test(129));
+    ASSERT_FALSE(left.test(64));
+    ASSERT_FALSE(left.any(0, 65));
+    ASSERT_TRUE(left.any(0, 66));
+    ASSERT_FALSE(left.any(66, 129));
+
+    left.flip();
+    ASSERT_FALSE(left.test(65));
+    ASSERT_TRUE(left.test(0));
+    ASSERT_TRUE(left.any(66, 129));
+}
+
+} // namespace column_file
+} // namespace palo
+
+int main(int argc, char **argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
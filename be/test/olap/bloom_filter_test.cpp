@@ -14,6 +14,7 @@
 // under the License.
 
 #include <gtest/gtest.h>
+#include <stdio.h>
 
 #include <string>
 
@@ -101,6 +102,43 @@ TEST_F(TestBloomFilter, add_and_test_bytes) {
     ASSERT_TRUE(bf.test_bytes(bytes.c_str(), bytes.size()));
 }
 
+TEST_F(TestBloomFilter, blocked_bloom_filter) {
+    BloomFilter bf;
+    ASSERT_TRUE(bf.init(1024, 0.05, true));
+    ASSERT_TRUE(bf.is_blocked());
+
+    bf.add_bytes(NULL, 0);
+    ASSERT_TRUE(bf.test_bytes(NULL, 0));
+
+    char buf[16];
+    for (int i = 0; i < 1024; ++i) {
+        int len = snprintf(buf, sizeof(buf), "%d", i);
+        bf.add_bytes(buf, len);
+    }
+    for (int i = 0; i < 1024; ++i) {
+        int len = snprintf(buf, sizeof(buf), "%d", i);
+        ASSERT_TRUE(bf.test_bytes(buf, len));
+    }
+
+    // reopen the same buffer in blocked layout
+    BloomFilter reader;
+    reader.init(bf.bit_set_data(), bf.bit_num() / 64, bf.hash_function_num(), true);
+    string bytes = "1023";
+    ASSERT_TRUE(reader.test_bytes(bytes.c_str(), bytes.size()));
+
+    BloomFilter new_bf;
+    new_bf.init(1024, 0.05, true);
+    bytes = "world";
+    new_bf.add_bytes(bytes.c_str(), bytes.size());
+    ASSERT_TRUE(bf.merge(new_bf));
+    ASSERT_TRUE(bf.test_bytes(bytes.c_str(), bytes.size()));
+
+    // can not merge with the standard layout
+    BloomFilter standard_bf;
+    standard_bf.init(1024, 0.05);
+    ASSERT_FALSE(bf.merge(standard_bf));
+}
+
 // Print bloom filter buffer and points of specified string
 TEST_F(TestBloomFilter, bloom_filter_info) {
     string bytes;
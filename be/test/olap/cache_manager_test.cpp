@@ -0,0 +1,144 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/cache_manager.h"
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "util/logging.h"
+
+namespace palo {
+
+class CacheManagerTest : public testing::Test {
+public:
+    static void deleter(const CacheKey& key, void* value) {
+    }
+
+    void insert(Cache* cache, int key, int charge) {
+        std::string k = std::to_string(key);
+        cache->release(cache->insert(CacheKey(k.c_str(), k.size()), NULL, charge, &deleter));
+    }
+
+    bool lookup(Cache* cache, int key) {
+        std::string k = std::to_string(key);
+        Cache::Handle* handle = cache->lookup(CacheKey(k.c_str(), k.size()));
+        if (handle == NULL) {
+            return false;
+        }
+        cache->release(handle);
+        return true;
+    }
+
+    size_t usage(Cache* cache) {
+        CacheStats stats;
+        cache->get_stats(&stats);
+        return stats.usage;
+    }
+
+    size_t capacity(Cache* cache) {
+        CacheStats stats;
+        cache->get_stats(&stats);
+        return stats.capacity;
+    }
+};
+
+TEST_F(CacheManagerTest, FreeMemory) {
+    config::cache_memory_budget_bytes = 0;
+    std::unique_ptr<Cache> cold(new_lru_cache(1600));
+    std::unique_ptr<Cache> hot(new_lru_cache(1600));
+    std::unique_ptr<Cache> fds(new_lru_cache(1600));
+    CacheManager* manager = CacheManager::get_instance();
+    manager->register_cache("cold", cold.get(), true);
+    manager->register_cache("hot", hot.get(), true);
+    manager->register_cache("fds", fds.get(), false);
+
+    for (int i = 0; i < 20; ++i) {
+        insert(cold.get(), i, 10);
+        insert(hot.get(), i, 10);
+        insert(fds.get(), i, 10);
+    }
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_TRUE(lookup(hot.get(), i));
+    }
+    manager->update();
+
+    // the cache with fewer hits per byte goes first, the file descriptors are no memory
+    ASSERT_GE(manager->free_memory(50), 50);
+    ASSERT_LT(usage(cold.get()), 200);
+    ASSERT_EQ(200, usage(hot.get()));
+    ASSERT_EQ(200, usage(fds.get()));
+
+    size_t left = usage(cold.get()) + usage(hot.get());
+    ASSERT_EQ(left, manager->free_memory(10000));
+    ASSERT_EQ(0, usage(cold.get()));
+    ASSERT_EQ(0, usage(hot.get()));
+    ASSERT_EQ(200, usage(fds.get()));
+
+    std::stringstream ss;
+    manager->debug(ss);
+    ASSERT_NE(std::string::npos, ss.str().find("\nhot\ttrue\t"));
+
+    manager->unregister_cache(cold.get());
+    manager->unregister_cache(hot.get());
+    manager->unregister_cache(fds.get());
+}
+
+TEST_F(CacheManagerTest, Rebalance) {
+    std::unique_ptr<Cache> cold(new_lru_cache(800));
+    std::unique_ptr<Cache> hot(new_lru_cache(800));
+    CacheManager* manager = CacheManager::get_instance();
+    manager->register_cache("cold", cold.get(), true);
+    manager->register_cache("hot", hot.get(), true);
+
+    // the capacities are scaled to the budget first
+    config::cache_memory_budget_bytes = 3200;
+    manager->update();
+    ASSERT_EQ(1600, capacity(cold.get()));
+    ASSERT_EQ(1600, capacity(hot.get()));
+
+    // a full cache with hits gets capacity from the one without
+    for (int i = 0; i < 1000; ++i) {
+        insert(hot.get(), i, 10);
+    }
+    ASSERT_EQ(1600, usage(hot.get()));
+    ASSERT_TRUE(lookup(hot.get(), 999));
+    manager->update();
+    ASSERT_EQ(1600 - 160, capacity(cold.get()));
+    ASSERT_EQ(1600 + 160, capacity(hot.get()));
+
+    // no cache shrinks below its minimum share
+    for (int i = 0; i < 100; ++i) {
+        for (int j = 0; j < 1000; ++j) {
+            insert(hot.get(), j, 10);
+        }
+        ASSERT_TRUE(lookup(hot.get(), 999));
+        manager->update();
+    }
+    ASSERT_EQ(160, capacity(cold.get()));
+    ASSERT_EQ(3200 - 160, capacity(hot.get()));
+
+    manager->unregister_cache(cold.get());
+    manager->unregister_cache(hot.get());
+    config::cache_memory_budget_bytes = 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,680 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Micro benchmarks of the column file encodings and codecs.
+//
+// Every case encodes or decodes synthetic data of several distributions and reports
+// the time per iteration, the throughput over the raw data and the compression ratio,
+// raw bytes over encoded bytes. Run it by hand, e.g.
+//
+//     column_file_benchmark [--min_time_ms=500] [filter]
+//
+// where only the cases whose name contains 'filter' run.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "olap/column_file/bit_field_reader.h"
+#include "olap/column_file/bit_field_writer.h"
+#include "olap/column_file/byte_buffer.h"
+#include "olap/column_file/column_reader.h"
+#include "olap/column_file/compress.h"
+#include "olap/column_file/file_stream.h"
+#include "olap/column_file/out_stream.h"
+#include "olap/column_file/run_length_byte_reader.h"
+#include "olap/column_file/run_length_byte_writer.h"
+#include "olap/column_file/run_length_integer_reader.h"
+#include "olap/column_file/run_length_integer_writer.h"
+#include "olap/column_file/stream_name.h"
+#include "olap/file_helper.h"
+#include "util/cpu_info.h"
+#include "util/logging.h"
+#include "util/stopwatch.hpp"
+
+namespace palo {
+namespace column_file {
+
+static const int64_t NUM_VALUES = 1 << 20;
+static const int64_t NUM_STRINGS = 1 << 18;
+
+enum Distribution {
+    SORTED = 0,
+    RANDOM,
+    LOW_CARDINALITY,
+    SKEWED,
+    NUM_DISTRIBUTIONS
+};
+
+static const char* DISTRIBUTION_NAMES[] = {"sorted", "random", "low_card", "skewed"};
+
+#define CHECK_OLAP(stmt) \
+    do { \
+        OLAPStatus _res = (stmt); \
+        if (_res != OLAP_SUCCESS) { \
+            std::cerr << #stmt << " failed: " << _res << std::endl; \
+            exit(1); \
+        } \
+    } while (false)
+
+// Runs the cases and prints one line per case.
+class BenchmarkRunner {
+public:
+    BenchmarkRunner(int64_t min_time_ms, const std::string& filter) :
+            _min_time_ns(min_time_ms * 1000000L), _filter(filter) {
+        std::cout << std::left << std::setw(40) << "Benchmark"
+            << std::right << std::setw(14) << "ns/iter"
+            << std::setw(8) << "iters"
+            << std::setw(12) << "MB/s"
+            << std::setw(10) << "ratio" << std::endl;
+    }
+
+    // Runs 'fn', which processes 'raw_bytes' of data that take 'encoded_bytes'
+    // encoded, until it took at least the minimum time.
+    void run(const std::string& name, int64_t raw_bytes, int64_t encoded_bytes,
+             const std::function<void()>& fn) {
+        if (name.find(_filter) == std::string::npos) {
+            return;
+        }
+        // warm up the caches and the allocator
+        fn();
+        int64_t iterations = 0;
+        MonotonicStopWatch watch;
+        watch.start();
+        while (iterations == 0 || watch.elapsed_time() < _min_time_ns) {
+            fn();
+            ++iterations;
+        }
+        int64_t elapsed_ns = watch.elapsed_time();
+        double ns_per_iter = static_cast<double>(elapsed_ns) / iterations;
+        double mb_per_sec = raw_bytes / ns_per_iter * 1e9 / (1 << 20);
+        double ratio = encoded_bytes > 0 ? static_cast<double>(raw_bytes) / encoded_bytes : 0;
+        std::cout << std::left << std::setw(40) << name
+            << std::right << std::fixed << std::setprecision(0) << std::setw(14) << ns_per_iter
+            << std::setw(8) << iterations
+            << std::setprecision(1) << std::setw(12) << mb_per_sec
+            << std::setprecision(2) << std::setw(10) << ratio << std::endl;
+    }
+
+private:
+    const int64_t _min_time_ns;
+    const std::string _filter;
+};
+
+// Writes out streams to a temporary file and opens readers over them.
+class StreamFile {
+public:
+    StreamFile() : _shared_buffer(NULL) {
+        char path[] = "./column_file_benchmark_XXXXXX";
+        int fd = mkstemp(path);
+        if (fd < 0) {
+            std::cerr << "failed to create a temporary file" << std::endl;
+            exit(1);
+        }
+        close(fd);
+        _path = path;
+        CHECK_OLAP(_handler.open_with_mode(_path, O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR));
+    }
+
+    ~StreamFile() {
+        clear_streams();
+        delete _shared_buffer;
+        _handler.close();
+        unlink(_path.c_str());
+    }
+
+    void add(const StreamName& name, OutStream* stream) {
+        CHECK_OLAP(stream->flush());
+        Extent extent;
+        extent.offset = _handler.tell();
+        CHECK_OLAP(stream->write_to_file(&_handler, 0));
+        extent.length = stream->get_stream_length();
+        _extents[name] = extent;
+    }
+
+    // Done writing, the file is reopened for reading.
+    void seal() {
+        _handler.close();
+        CHECK_OLAP(_handler.open_with_mode(_path, O_RDONLY, S_IRUSR | S_IWUSR));
+        _shared_buffer = ByteBuffer::create(
+                OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE + sizeof(StreamHead));
+    }
+
+    int64_t length() const {
+        int64_t length = 0;
+        for (auto& it : _extents) {
+            length += it.second.length;
+        }
+        return length;
+    }
+
+    // Opens fresh streams over all extents, positioned at their beginning.
+    std::map<StreamName, ReadOnlyFileStream*>* open_streams() {
+        clear_streams();
+        for (auto& it : _extents) {
+            ReadOnlyFileStream* stream = new ReadOnlyFileStream(
+                    &_handler, &_shared_buffer, it.second.offset, it.second.length,
+                    NULL, OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE);
+            CHECK_OLAP(stream->init());
+            _streams[it.first] = stream;
+        }
+        return &_streams;
+    }
+
+    ReadOnlyFileStream* open_stream(const StreamName& name) {
+        return (*open_streams())[name];
+    }
+
+private:
+    struct Extent {
+        int64_t offset;
+        int64_t length;
+    };
+
+    void clear_streams() {
+        for (auto& it : _streams) {
+            delete it.second;
+        }
+        _streams.clear();
+    }
+
+    std::string _path;
+    FileHandler _handler;
+    ByteBuffer* _shared_buffer;
+    std::map<StreamName, Extent> _extents;
+    std::map<StreamName, ReadOnlyFileStream*> _streams;
+};
+
+static std::vector<int64_t> make_integers(Distribution distribution, bool is_signed) {
+    std::mt19937_64 rng(distribution);
+    std::vector<int64_t> values(NUM_VALUES);
+    for (int64_t i = 0; i < NUM_VALUES; ++i) {
+        int64_t value = 0;
+        switch (distribution) {
+        case SORTED:
+            // small, slightly varying deltas like ids or timestamps
+            value = i * 3 + rng() % 3;
+            break;
+        case RANDOM:
+            value = rng() & ((1L << 40) - 1);
+            break;
+        case LOW_CARDINALITY:
+            value = (rng() % 16) * 1000;
+            break;
+        case SKEWED: {
+            // most values are small, few are large
+            double u = std::uniform_real_distribution<double>(0, 1)(rng);
+            value = static_cast<int64_t>(u * u * u * u * 1000000);
+            break;
+        }
+        default:
+            break;
+        }
+        if (is_signed && (rng() & 1) != 0) {
+            value = -value;
+        }
+        values[i] = value;
+    }
+    return values;
+}
+
+static std::vector<char> make_bytes(Distribution distribution) {
+    std::mt19937_64 rng(distribution);
+    std::vector<char> values(NUM_VALUES);
+    for (int64_t i = 0; i < NUM_VALUES; ++i) {
+        switch (distribution) {
+        case SORTED:
+            values[i] = static_cast<char>(i * 256 / NUM_VALUES);
+            break;
+        case RANDOM:
+            values[i] = static_cast<char>(rng());
+            break;
+        case LOW_CARDINALITY:
+            values[i] = static_cast<char>(rng() % 4);
+            break;
+        case SKEWED:
+            values[i] = rng() % 100 < 95 ? 0 : static_cast<char>(rng());
+            break;
+        default:
+            break;
+        }
+    }
+    return values;
+}
+
+static std::vector<bool> make_bits(Distribution distribution) {
+    std::mt19937_64 rng(distribution);
+    std::vector<bool> values(NUM_VALUES);
+    for (int64_t i = 0; i < NUM_VALUES; ++i) {
+        switch (distribution) {
+        case SORTED:
+            values[i] = i >= NUM_VALUES / 2;
+            break;
+        case RANDOM:
+            values[i] = (rng() & 1) != 0;
+            break;
+        case LOW_CARDINALITY:
+            values[i] = (i / 64) % 2 != 0;
+            break;
+        case SKEWED:
+            values[i] = rng() % 100 < 95;
+            break;
+        default:
+            break;
+        }
+    }
+    return values;
+}
+
+static std::string random_string(std::mt19937_64* rng, int min_length, int max_length) {
+    static const char CHARS[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+    int length = min_length + (*rng)() % (max_length - min_length + 1);
+    std::string str(length, ' ');
+    for (int i = 0; i < length; ++i) {
+        str[i] = CHARS[(*rng)() % (sizeof(CHARS) - 1)];
+    }
+    return str;
+}
+
+static std::vector<std::string> make_strings(Distribution distribution) {
+    std::mt19937_64 rng(distribution);
+    std::vector<std::string> words;
+    if (distribution == LOW_CARDINALITY || distribution == SKEWED) {
+        words.resize(distribution == LOW_CARDINALITY ? 16 : 10000);
+        for (auto& word : words) {
+            word = random_string(&rng, 4, 16);
+        }
+    }
+    std::vector<std::string> values(NUM_STRINGS);
+    for (int64_t i = 0; i < NUM_STRINGS; ++i) {
+        switch (distribution) {
+        case SORTED: {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "user_%010ld", i);
+            values[i] = buf;
+            break;
+        }
+        case RANDOM:
+            values[i] = random_string(&rng, 8, 24);
+            break;
+        case LOW_CARDINALITY:
+            values[i] = words[rng() % words.size()];
+            break;
+        case SKEWED: {
+            double u = std::uniform_real_distribution<double>(0, 1)(rng);
+            values[i] = words[static_cast<size_t>(u * u * u * u * words.size())];
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    return values;
+}
+
+static void benchmark_rle_integer(BenchmarkRunner* runner) {
+    for (int signed_case = 0; signed_case < 2; ++signed_case) {
+        bool is_signed = signed_case != 0;
+        for (int d = 0; d < NUM_DISTRIBUTIONS; ++d) {
+            std::vector<int64_t> values = make_integers(Distribution(d), is_signed);
+            std::string prefix = std::string("rle_int/") + (is_signed ? "signed/" : "unsigned/")
+                    + DISTRIBUTION_NAMES[d];
+            int64_t raw_bytes = values.size() * sizeof(int64_t);
+
+            StreamFile file;
+            {
+                OutStream stream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, NULL);
+                RunLengthIntegerWriter writer(&stream, is_signed);
+                for (int64_t value : values) {
+                    CHECK_OLAP(writer.write(value));
+                }
+                CHECK_OLAP(writer.flush());
+                file.add(StreamName(0, StreamInfoMessage::DATA), &stream);
+            }
+            file.seal();
+            int64_t encoded_bytes = file.length();
+
+            runner->run(prefix + "/write", raw_bytes, encoded_bytes, [&values, is_signed] {
+                OutStream stream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, NULL);
+                RunLengthIntegerWriter writer(&stream, is_signed);
+                for (int64_t value : values) {
+                    CHECK_OLAP(writer.write(value));
+                }
+                CHECK_OLAP(writer.flush());
+                CHECK_OLAP(stream.flush());
+            });
+            runner->run(prefix + "/read", raw_bytes, encoded_bytes, [&file, is_signed] {
+                RunLengthIntegerReader reader(
+                        file.open_stream(StreamName(0, StreamInfoMessage::DATA)), is_signed);
+                int64_t value = 0;
+                for (int64_t i = 0; i < NUM_VALUES; ++i) {
+                    CHECK_OLAP(reader.next(&value));
+                }
+            });
+            runner->run(prefix + "/read_batch", raw_bytes, encoded_bytes, [&file, is_signed] {
+                RunLengthIntegerReader reader(
+                        file.open_stream(StreamName(0, StreamInfoMessage::DATA)), is_signed);
+                std::vector<int64_t> batch(1024);
+                for (int64_t i = 0; i < NUM_VALUES; i += batch.size()) {
+                    CHECK_OLAP(reader.next(&batch[0], batch.size()));
+                }
+            });
+        }
+    }
+}
+
+static void benchmark_rle_byte(BenchmarkRunner* runner) {
+    for (int d = 0; d < NUM_DISTRIBUTIONS; ++d) {
+        std::vector<char> values = make_bytes(Distribution(d));
+        std::string prefix = std::string("rle_byte/") + DISTRIBUTION_NAMES[d];
+
+        StreamFile file;
+        {
+            OutStream stream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, NULL);
+            RunLengthByteWriter writer(&stream);
+            for (char value : values) {
+                CHECK_OLAP(writer.write(value));
+            }
+            CHECK_OLAP(writer.flush());
+            file.add(StreamName(0, StreamInfoMessage::DATA), &stream);
+        }
+        file.seal();
+        int64_t encoded_bytes = file.length();
+
+        runner->run(prefix + "/write", values.size(), encoded_bytes, [&values] {
+            OutStream stream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, NULL);
+            RunLengthByteWriter writer(&stream);
+            for (char value : values) {
+                CHECK_OLAP(writer.write(value));
+            }
+            CHECK_OLAP(writer.flush());
+            CHECK_OLAP(stream.flush());
+        });
+        runner->run(prefix + "/read", values.size(), encoded_bytes, [&file] {
+            RunLengthByteReader reader(file.open_stream(StreamName(0, StreamInfoMessage::DATA)));
+            char value = 0;
+            for (int64_t i = 0; i < NUM_VALUES; ++i) {
+                CHECK_OLAP(reader.next(&value));
+            }
+        });
+    }
+}
+
+static void benchmark_bit_field(BenchmarkRunner* runner) {
+    for (int d = 0; d < NUM_DISTRIBUTIONS; ++d) {
+        std::vector<bool> values = make_bits(Distribution(d));
+        std::string prefix = std::string("bit_field/") + DISTRIBUTION_NAMES[d];
+        // one byte per value, like the null flags the stream replaces
+        int64_t raw_bytes = values.size();
+
+        StreamFile file;
+        {
+            OutStream stream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, NULL);
+            BitFieldWriter writer(&stream);
+            CHECK_OLAP(writer.init());
+            for (bool value : values) {
+                CHECK_OLAP(writer.write(value));
+            }
+            CHECK_OLAP(writer.flush());
+            file.add(StreamName(0, StreamInfoMessage::PRESENT), &stream);
+        }
+        file.seal();
+        int64_t encoded_bytes = file.length();
+
+        runner->run(prefix + "/write", raw_bytes, encoded_bytes, [&values] {
+            OutStream stream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, NULL);
+            BitFieldWriter writer(&stream);
+            CHECK_OLAP(writer.init());
+            for (bool value : values) {
+                CHECK_OLAP(writer.write(value));
+            }
+            CHECK_OLAP(writer.flush());
+            CHECK_OLAP(stream.flush());
+        });
+        runner->run(prefix + "/read", raw_bytes, encoded_bytes, [&file] {
+            BitFieldReader reader(file.open_stream(StreamName(0, StreamInfoMessage::PRESENT)));
+            CHECK_OLAP(reader.init());
+            char value = 0;
+            for (int64_t i = 0; i < NUM_VALUES; ++i) {
+                CHECK_OLAP(reader.next(&value));
+            }
+        });
+    }
+}
+
+// Writes 'values' the way VarStringColumnWriter does with the direct encoding.
+static void write_direct_strings(const std::vector<std::string>& values, StreamFile* file) {
+    OutStream data_stream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, NULL);
+    OutStream length_stream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, NULL);
+    RunLengthIntegerWriter length_writer(&length_stream, false);
+    for (const std::string& value : values) {
+        CHECK_OLAP(data_stream.write(value.data(), value.size()));
+        CHECK_OLAP(length_writer.write(value.size()));
+    }
+    CHECK_OLAP(length_writer.flush());
+    if (file != NULL) {
+        file->add(StreamName(0, StreamInfoMessage::DATA), &data_stream);
+        file->add(StreamName(0, StreamInfoMessage::LENGTH), &length_stream);
+    } else {
+        CHECK_OLAP(data_stream.flush());
+        CHECK_OLAP(length_stream.flush());
+    }
+}
+
+// Writes 'values' with the dictionary encoding, the sorted distinct values followed
+// by the code of every value. Returns the size of the dictionary.
+static size_t write_dictionary_strings(const std::vector<std::string>& values, StreamFile* file) {
+    std::map<std::string, uint32_t> dictionary;
+    for (const std::string& value : values) {
+        dictionary.insert(std::make_pair(value, 0));
+    }
+    OutStream dictionary_stream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, NULL);
+    OutStream length_stream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, NULL);
+    OutStream data_stream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, NULL);
+    RunLengthIntegerWriter length_writer(&length_stream, false);
+    RunLengthIntegerWriter id_writer(&data_stream, false);
+    uint32_t code = 0;
+    for (auto& it : dictionary) {
+        it.second = code++;
+        CHECK_OLAP(dictionary_stream.write(it.first.data(), it.first.size()));
+        CHECK_OLAP(length_writer.write(it.first.size()));
+    }
+    for (const std::string& value : values) {
+        CHECK_OLAP(id_writer.write(dictionary[value]));
+    }
+    CHECK_OLAP(length_writer.flush());
+    CHECK_OLAP(id_writer.flush());
+    if (file != NULL) {
+        file->add(StreamName(0, StreamInfoMessage::DICTIONARY_DATA), &dictionary_stream);
+        file->add(StreamName(0, StreamInfoMessage::LENGTH), &length_stream);
+        file->add(StreamName(0, StreamInfoMessage::DATA), &data_stream);
+    } else {
+        CHECK_OLAP(dictionary_stream.flush());
+        CHECK_OLAP(length_stream.flush());
+        CHECK_OLAP(data_stream.flush());
+    }
+    return dictionary.size();
+}
+
+static void benchmark_strings(BenchmarkRunner* runner) {
+    for (int d = 0; d < NUM_DISTRIBUTIONS; ++d) {
+        std::vector<std::string> values = make_strings(Distribution(d));
+        int64_t raw_bytes = 0;
+        for (const std::string& value : values) {
+            raw_bytes += value.size();
+        }
+
+        std::string prefix = std::string("string_direct/") + DISTRIBUTION_NAMES[d];
+        StreamFile direct_file;
+        write_direct_strings(values, &direct_file);
+        direct_file.seal();
+        runner->run(prefix + "/write", raw_bytes, direct_file.length(), [&values] {
+            write_direct_strings(values, NULL);
+        });
+        runner->run(prefix + "/read", raw_bytes, direct_file.length(), [&direct_file] {
+            StringColumnDirectReader reader(0, 0);
+            CHECK_OLAP(reader.init(direct_file.open_streams()));
+            char buffer[64];
+            for (int64_t i = 0; i < NUM_STRINGS; ++i) {
+                uint32_t length = sizeof(buffer);
+                CHECK_OLAP(reader.next(buffer, &length));
+            }
+        });
+
+        prefix = std::string("string_dict/") + DISTRIBUTION_NAMES[d];
+        StreamFile dictionary_file;
+        size_t dictionary_size = write_dictionary_strings(values, &dictionary_file);
+        dictionary_file.seal();
+        runner->run(prefix + "/write", raw_bytes, dictionary_file.length(), [&values] {
+            write_dictionary_strings(values, NULL);
+        });
+        runner->run(prefix + "/read", raw_bytes, dictionary_file.length(),
+                    [&dictionary_file, dictionary_size] {
+            StringColumnDictionaryReader reader(0, dictionary_size);
+            CHECK_OLAP(reader.init(dictionary_file.open_streams()));
+            char buffer[64];
+            for (int64_t i = 0; i < NUM_STRINGS; ++i) {
+                uint32_t length = sizeof(buffer);
+                CHECK_OLAP(reader.next(buffer, &length));
+            }
+        });
+    }
+}
+
+// Compresses and decompresses 'data' in blocks of the column stream buffer size,
+// like OutStream and the file streams do.
+static void benchmark_codec(BenchmarkRunner* runner, const std::string& name,
+                            CompressKind kind, const std::string& data) {
+    Compressor compressor = NULL;
+    Decompressor decompressor = NULL;
+    CHECK_OLAP(get_compressor(kind, 0, &compressor));
+    CHECK_OLAP(get_decompressor(kind, &decompressor));
+
+    uint64_t block_size = OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE;
+    std::vector<ByteBuffer*> blocks;
+    std::vector<ByteBuffer*> compressed_blocks;
+    int64_t compressed_bytes = 0;
+    for (uint64_t offset = 0; offset < data.size(); offset += block_size) {
+        uint64_t length = std::min<uint64_t>(block_size, data.size() - offset);
+        ByteBuffer* block = ByteBuffer::create(length);
+        CHECK_OLAP(block->put(data.data() + offset, length));
+        block->flip();
+        blocks.push_back(block);
+
+        ByteBuffer* compressed = ByteBuffer::create(length + length / 16 + 1024);
+        bool smaller = false;
+        CHECK_OLAP(compressor(block, compressed, &smaller));
+        if (smaller) {
+            compressed->flip();
+            compressed_bytes += compressed->limit();
+            compressed_blocks.push_back(compressed);
+        } else {
+            // the streams store such blocks uncompressed
+            compressed_bytes += length;
+            delete compressed;
+        }
+    }
+
+    ByteBuffer* output = ByteBuffer::create(block_size + block_size / 16 + 1024);
+    runner->run(name + "/compress", data.size(), compressed_bytes, [&blocks, compressor, output] {
+        for (ByteBuffer* block : blocks) {
+            block->set_position(0);
+            output->set_limit(output->capacity());
+            output->set_position(0);
+            bool smaller = false;
+            CHECK_OLAP(compressor(block, output, &smaller));
+        }
+    });
+    runner->run(name + "/decompress", data.size(), compressed_bytes,
+                [&compressed_blocks, decompressor, output] {
+        for (ByteBuffer* block : compressed_blocks) {
+            block->set_position(0);
+            output->set_limit(output->capacity());
+            output->set_position(0);
+            CHECK_OLAP(decompressor(block, output));
+        }
+    });
+
+    delete output;
+    for (ByteBuffer* block : blocks) {
+        delete block;
+    }
+    for (ByteBuffer* block : compressed_blocks) {
+        delete block;
+    }
+}
+
+static void benchmark_codecs(BenchmarkRunner* runner) {
+    static const struct {
+        CompressKind kind;
+        const char* name;
+    } CODECS[] = {
+        {COMPRESS_LZO, "lzo"},
+        {COMPRESS_LZ4, "lz4"},
+        {COMPRESS_ZSTD, "zstd"},
+    };
+    for (int d = 0; d < NUM_DISTRIBUTIONS; ++d) {
+        std::vector<int64_t> integers = make_integers(Distribution(d), false);
+        std::string integer_data(reinterpret_cast<const char*>(&integers[0]),
+                                 integers.size() * sizeof(int64_t));
+        std::string string_data;
+        for (const std::string& value : make_strings(Distribution(d))) {
+            string_data.append(value);
+        }
+        for (auto& codec : CODECS) {
+            benchmark_codec(runner, std::string("codec/") + codec.name + "/int64/"
+                            + DISTRIBUTION_NAMES[d], codec.kind, integer_data);
+            benchmark_codec(runner, std::string("codec/") + codec.name + "/string/"
+                            + DISTRIBUTION_NAMES[d], codec.kind, string_data);
+        }
+    }
+}
+
+}  // namespace column_file
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    int64_t min_time_ms = 500;
+    std::string filter;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 14, "--min_time_ms=") == 0) {
+            min_time_ms = atol(arg.c_str() + 14);
+        } else {
+            filter = arg;
+        }
+    }
+    palo::init_glog("be-benchmark");
+    palo::CpuInfo::init();
+
+    palo::column_file::BenchmarkRunner runner(min_time_ms, filter);
+    palo::column_file::benchmark_rle_integer(&runner);
+    palo::column_file::benchmark_rle_byte(&runner);
+    palo::column_file::benchmark_bit_field(&runner);
+    palo::column_file::benchmark_strings(&runner);
+    palo::column_file::benchmark_codecs(&runner);
+    return 0;
+}
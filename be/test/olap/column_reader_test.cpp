@@ -13,16 +13,24 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <limits>
+#include <memory>
+
 #include <gtest/gtest.h>
 
 #include "olap/column_file/byte_buffer.h"
 #include "olap/column_file/stream_name.h"
 #include "olap/column_file/column_reader.h"
 #include "olap/column_file/column_writer.h"
+#include "olap/column_file/compress.h"
+#include "olap/column_file/file_stream.h"
+#include "olap/column_file/out_stream.h"
 #include "olap/field.h"
+#include "olap/lru_cache.h"
 #include "olap/olap_define.h"
 #include "olap/olap_common.h"
 #include "olap/row_cursor.h"
+#include "util/cpu_info.h"
 #include "util/logging.h"
 
 using std::string;
@@ -211,6 +219,7 @@ public:
         field_info.frac = 10000;
         field_info.unique_id = 0;
         field_info.is_bf_column = false;
+        field_info.is_blocked_bf = false;
     }
 
     void create_and_save_last_position() {
@@ -3030,6 +3039,169 @@ TEST_F(TestColumn, DirectVarcharColumnWith65533) {
 }
 
 
+TEST(TestDataPageCache, ReadCompressedChunkFromCache) {
+    const uint64_t data_size = OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE * 3;
+    std::vector<char> data(data_size);
+    for (uint64_t i = 0; i < data_size; ++i) {
+        data[i] = i % 251;
+    }
+
+    OutStream out_stream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, lzo_compress);
+    ASSERT_EQ(OLAP_SUCCESS, out_stream.write(&data[0], data_size));
+    ASSERT_EQ(OLAP_SUCCESS, out_stream.flush());
+
+    system("rm -f ./page_cache_file");
+    FileHandler writer;
+    ASSERT_EQ(OLAP_SUCCESS, writer.open_with_mode("page_cache_file",
+            O_CREAT | O_EXCL | O_WRONLY, S_IRUSR | S_IWUSR));
+    ASSERT_EQ(OLAP_SUCCESS, out_stream.write_to_file(&writer, 0));
+    uint64_t stream_length = out_stream.get_stream_length();
+    ASSERT_EQ(OLAP_SUCCESS, writer.close());
+
+    FileHandler reader;
+    ASSERT_EQ(OLAP_SUCCESS, reader.open_with_mode("page_cache_file",
+            O_RDONLY, S_IRUSR | S_IWUSR));
+    ByteBuffer* shared_buffer = ByteBuffer::create(
+            OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE + sizeof(StreamHead));
+    ASSERT_TRUE(shared_buffer != NULL);
+    std::unique_ptr<Cache> cache(new_lru_cache(16 * 1024 * 1024));
+
+    std::vector<char> result(data_size);
+    ReadOnlyFileStream first(&reader, &shared_buffer, 0, stream_length,
+                             lzo_decompress, OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE);
+    ASSERT_EQ(OLAP_SUCCESS, first.init());
+    first.set_page_cache(cache.get());
+    uint64_t read_size = data_size;
+    ASSERT_EQ(OLAP_SUCCESS, first.read(&result[0], &read_size));
+    ASSERT_EQ(data_size, read_size);
+    ASSERT_EQ(0, memcmp(&data[0], &result[0], data_size));
+    ASSERT_GE(cache->get_memory_usage(), data_size);
+
+    // 覆盖文件内容, 之后只有从cache中才能读到正确的数据
+    FileHandler overwriter;
+    ASSERT_EQ(OLAP_SUCCESS, overwriter.open_with_mode("page_cache_file",
+            O_WRONLY, S_IRUSR | S_IWUSR));
+    std::vector<char> zeros(stream_length, 0);
+    ASSERT_EQ(OLAP_SUCCESS, overwriter.pwrite(&zeros[0], stream_length, 0));
+    ASSERT_EQ(OLAP_SUCCESS, overwriter.close());
+
+    ReadOnlyFileStream second(&reader, &shared_buffer, 0, stream_length,
+                              lzo_decompress, OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE);
+    ASSERT_EQ(OLAP_SUCCESS, second.init());
+    second.set_page_cache(cache.get());
+    result.assign(data_size, 0);
+    read_size = data_size;
+    ASSERT_EQ(OLAP_SUCCESS, second.read(&result[0], &read_size));
+    ASSERT_EQ(data_size, read_size);
+    ASSERT_EQ(0, memcmp(&data[0], &result[0], data_size));
+
+    SAFE_DELETE(shared_buffer);
+    reader.close();
+}
+
+// 将out_stream写入文件后用decompressor读出, 与data比较
+static void check_stream_content(OutStream* out_stream,
+                                 Decompressor decompressor,
+                                 const std::vector<char>& data) {
+    ASSERT_EQ(OLAP_SUCCESS, out_stream->flush());
+
+    system("rm -f ./compress_file");
+    FileHandler writer;
+    ASSERT_EQ(OLAP_SUCCESS, writer.open_with_mode("compress_file",
+            O_CREAT | O_EXCL | O_WRONLY, S_IRUSR | S_IWUSR));
+    ASSERT_EQ(OLAP_SUCCESS, out_stream->write_to_file(&writer, 0));
+    ASSERT_EQ(OLAP_SUCCESS, writer.close());
+    // 数据可压缩, 压缩后应当变小
+    ASSERT_LT(out_stream->get_stream_length(), data.size());
+
+    FileHandler reader;
+    ASSERT_EQ(OLAP_SUCCESS, reader.open_with_mode("compress_file",
+            O_RDONLY, S_IRUSR | S_IWUSR));
+    ByteBuffer* shared_buffer = ByteBuffer::create(
+            OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE + sizeof(StreamHead));
+    ASSERT_TRUE(shared_buffer != NULL);
+
+    ReadOnlyFileStream in_stream(&reader, &shared_buffer, 0, out_stream->get_stream_length(),
+                                 decompressor, OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE);
+    ASSERT_EQ(OLAP_SUCCESS, in_stream.init());
+    std::vector<char> result(data.size());
+    uint64_t read_size = data.size();
+    ASSERT_EQ(OLAP_SUCCESS, in_stream.read(&result[0], &read_size));
+    ASSERT_EQ(data.size(), read_size);
+    ASSERT_EQ(0, memcmp(&data[0], &result[0], data.size()));
+
+    SAFE_DELETE(shared_buffer);
+    reader.close();
+}
+
+TEST(TestCompress, ZstdWithLevel) {
+    std::vector<char> data(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE * 3 + 100);
+    for (uint64_t i = 0; i < data.size(); ++i) {
+        data[i] = (i / 7) % 31;
+    }
+
+    Decompressor decompressor = NULL;
+    ASSERT_EQ(OLAP_SUCCESS, get_decompressor(COMPRESS_ZSTD, &decompressor));
+    int levels[] = {0, 1, 9, 100};
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); ++i) {
+        Compressor compressor = NULL;
+        ASSERT_EQ(OLAP_SUCCESS, get_compressor(COMPRESS_ZSTD, levels[i], &compressor));
+        ASSERT_TRUE(compressor != NULL);
+
+        OutStream out_stream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, compressor);
+        ASSERT_EQ(OLAP_SUCCESS, out_stream.write(&data[0], data.size()));
+        check_stream_content(&out_stream, decompressor, data);
+    }
+}
+
+TEST(TestCompress, ColumnCompressKind) {
+    OutStreamFactory factory(COMPRESS_LZO, OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE);
+    ASSERT_EQ(OLAP_SUCCESS, factory.set_column_compress_kind(1, COMPRESS_ZSTD, 5));
+    ASSERT_EQ(OLAP_SUCCESS, factory.set_column_compress_kind(2, COMPRESS_NONE, 0));
+
+    ASSERT_EQ(COMPRESS_LZO, factory.create_stream(0, StreamInfoMessage::DATA)->compress_kind());
+    ASSERT_EQ(COMPRESS_ZSTD, factory.create_stream(1, StreamInfoMessage::DATA)->compress_kind());
+    ASSERT_EQ(COMPRESS_ZSTD, factory.create_stream(1, StreamInfoMessage::LENGTH)->compress_kind());
+    ASSERT_EQ(COMPRESS_NONE, factory.create_stream(2, StreamInfoMessage::DATA)->compress_kind());
+    // 索引流不压缩, 使用segment的压缩类型
+    ASSERT_EQ(COMPRESS_LZO,
+              factory.create_stream(1, StreamInfoMessage::ROW_INDEX)->compress_kind());
+}
+
+TEST(TestCompress, AdaptiveCompress) {
+    bool enable_adaptive_compress = config::enable_adaptive_compress;
+    int32_t min_decompress_speed = config::adaptive_compress_min_decompress_mb_per_sec;
+    config::enable_adaptive_compress = true;
+    config::adaptive_compress_min_decompress_mb_per_sec = 0;
+
+    std::vector<char> data(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE * 3);
+    for (uint64_t i = 0; i < data.size(); ++i) {
+        data[i] = (i / 7) % 31;
+    }
+
+    OutStreamFactory factory(COMPRESS_LZ4, OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE);
+    OutStream* out_stream = factory.create_stream(0, StreamInfoMessage::DATA);
+    ASSERT_TRUE(out_stream != NULL);
+    ASSERT_EQ(OLAP_SUCCESS, out_stream->write(&data[0], data.size()));
+    ASSERT_EQ(OLAP_SUCCESS, out_stream->flush());
+    ASSERT_NE(COMPRESS_NONE, out_stream->compress_kind());
+
+    Decompressor decompressor = NULL;
+    ASSERT_EQ(OLAP_SUCCESS, get_decompressor(out_stream->compress_kind(), &decompressor));
+    check_stream_content(out_stream, decompressor, data);
+
+    // 没有满足解压速度要求的压缩方式时, 保持原来的压缩方式
+    config::adaptive_compress_min_decompress_mb_per_sec = std::numeric_limits<int32_t>::max();
+    out_stream = factory.create_stream(1, StreamInfoMessage::DATA);
+    ASSERT_TRUE(out_stream != NULL);
+    ASSERT_EQ(OLAP_SUCCESS, out_stream->write(&data[0], data.size()));
+    ASSERT_EQ(OLAP_SUCCESS, out_stream->flush());
+    ASSERT_EQ(COMPRESS_LZ4, out_stream->compress_kind());
+
+    config::enable_adaptive_compress = enable_adaptive_compress;
+    config::adaptive_compress_min_decompress_mb_per_sec = min_decompress_speed;
+}
+
 }
 }
 
@@ -3040,6 +3212,7 @@ int main(int argc, char** argv) {
         return -1;
     }
     palo::init_glog("be-test");
+    palo::CpuInfo::init();
     int ret = palo::OLAP_SUCCESS;
     testing::InitGoogleTest(&argc, argv);
     ret = RUN_ALL_TESTS();
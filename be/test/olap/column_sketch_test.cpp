@@ -0,0 +1,167 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/column_sketch.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "util/logging.h"
+
+namespace palo {
+
+class ColumnSketchTest : public testing::Test {
+public:
+    void SetUp() {
+        _field_info.name = "k1";
+        _field_info.type = OLAP_FIELD_TYPE_INT;
+        _field_info.aggregation = OLAP_FIELD_AGGREGATION_NONE;
+        _field_info.length = 4;
+        _field_info.is_allow_null = true;
+        _field_info.is_key = true;
+        _field_info.precision = 0;
+        _field_info.frac = 0;
+        _field_info.unique_id = 3;
+        _field_info.is_bf_column = false;
+        _field_info.is_blocked_bf = false;
+
+        _field.reset(Field::create(_field_info));
+        ASSERT_TRUE(_field->allocate());
+    }
+
+    void add_range(ColumnSketch* sketch, int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            _field->set_not_null();
+            ASSERT_EQ(OLAP_SUCCESS, _field->from_string(std::to_string(i)));
+            sketch->add(_field.get());
+        }
+    }
+
+    void add_nulls(ColumnSketch* sketch, int count) {
+        _field->set_null();
+        for (int i = 0; i < count; ++i) {
+            sketch->add(_field.get());
+        }
+    }
+
+protected:
+    FieldInfo _field_info;
+    std::unique_ptr<Field> _field;
+};
+
+TEST_F(ColumnSketchTest, Cardinality) {
+    ColumnSketch sketch(_field_info);
+    ASSERT_EQ(0, sketch.estimate_cardinality());
+
+    add_range(&sketch, 0, 100);
+    // small cardinality is estimated by linear counting
+    ASSERT_NEAR(100, sketch.estimate_cardinality(), 10);
+
+    // duplicated values do not change the estimate
+    add_range(&sketch, 0, 100);
+    ASSERT_NEAR(100, sketch.estimate_cardinality(), 10);
+
+    add_range(&sketch, 100, 100000);
+    ASSERT_NEAR(100000, sketch.estimate_cardinality(), 100000 * 0.1);
+
+    add_nulls(&sketch, 10);
+    ASSERT_EQ(100110U, sketch.num_rows());
+    ASSERT_EQ(10U, sketch.num_nulls());
+}
+
+TEST_F(ColumnSketchTest, Histogram) {
+    ColumnSketch sketch(_field_info);
+    add_range(&sketch, 0, 10000);
+    add_nulls(&sketch, 100);
+
+    ColumnSketchMessage message;
+    ASSERT_EQ(OLAP_SUCCESS, sketch.to_pb(&message));
+    ASSERT_EQ(3U, message.unique_id());
+    ASSERT_EQ(10100U, message.num_rows());
+    ASSERT_EQ(100U, message.num_nulls());
+    ASSERT_EQ(static_cast<int>(ColumnSketch::NUM_BUCKETS) + 1, message.histogram_bound_size());
+
+    int last = -1;
+    for (int i = 0; i < message.histogram_bound_size(); ++i) {
+        int bound = std::stoi(message.histogram_bound(i));
+        ASSERT_LE(last, bound);
+        // every bucket holds about 10000 / NUM_BUCKETS rows
+        ASSERT_NEAR(10000.0 * i / ColumnSketch::NUM_BUCKETS, bound, 1000);
+        last = bound;
+    }
+    ASSERT_NEAR(message.num_rows() - message.num_nulls(),
+                ColumnSketch::estimate_cardinality(message), 1000);
+}
+
+TEST_F(ColumnSketchTest, SkewedHistogram) {
+    ColumnSketch sketch(_field_info);
+    // 3/4 of the rows have the same value
+    for (int i = 0; i < 3000; ++i) {
+        add_range(&sketch, 7, 8);
+    }
+    add_range(&sketch, 0, 1000);
+
+    ColumnSketchMessage message;
+    ASSERT_EQ(OLAP_SUCCESS, sketch.to_pb(&message));
+    int num_skewed_bounds = 0;
+    for (int i = 0; i < message.histogram_bound_size(); ++i) {
+        if (message.histogram_bound(i) == "7") {
+            ++num_skewed_bounds;
+        }
+    }
+    ASSERT_GE(num_skewed_bounds, static_cast<int>(ColumnSketch::NUM_BUCKETS) / 2);
+}
+
+TEST_F(ColumnSketchTest, Merge) {
+    ColumnSketch first(_field_info);
+    add_range(&first, 0, 5000);
+    add_nulls(&first, 10);
+    ColumnSketchMessage first_message;
+    ASSERT_EQ(OLAP_SUCCESS, first.to_pb(&first_message));
+
+    ColumnSketch second(_field_info);
+    add_range(&second, 2500, 10000);
+    ColumnSketchMessage second_message;
+    ASSERT_EQ(OLAP_SUCCESS, second.to_pb(&second_message));
+
+    ColumnSketch merged(_field_info);
+    ASSERT_EQ(OLAP_SUCCESS, merged.merge(first_message));
+    ASSERT_EQ(OLAP_SUCCESS, merged.merge(second_message));
+    ASSERT_EQ(12510U, merged.num_rows());
+    ASSERT_EQ(10U, merged.num_nulls());
+    // HLL counts the overlapped values once
+    ASSERT_NEAR(10000, merged.estimate_cardinality(), 1000);
+
+    ColumnSketchMessage message;
+    ASSERT_EQ(OLAP_SUCCESS, merged.to_pb(&message));
+    ASSERT_EQ(static_cast<int>(ColumnSketch::NUM_BUCKETS) + 1, message.histogram_bound_size());
+    ASSERT_NEAR(0, std::stoi(message.histogram_bound(0)), 500);
+    // rows of [2500, 5000) come from both inputs, the median moves down to 4375
+    ASSERT_NEAR(4375, std::stoi(message.histogram_bound(ColumnSketch::NUM_BUCKETS / 2)), 1000);
+    ASSERT_NEAR(10000, std::stoi(message.histogram_bound(ColumnSketch::NUM_BUCKETS)), 500);
+
+    // sketch of another column can not be merged
+    second_message.set_unique_id(4);
+    ASSERT_NE(OLAP_SUCCESS, merged.merge(second_message));
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
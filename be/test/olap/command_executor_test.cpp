@@ -862,6 +862,21 @@ TEST_F(TestComputeChecksum, compute_checksum) {
             push_req.version, push_req.version_hash, &checksum);
     ASSERT_EQ(OLAP_SUCCESS, res);
     ASSERT_EQ(BASE_TABLE_PUSH_DATA_CHECKSUM, checksum);
+
+    // 4. Checksum is cached in header, and can be recomputed by force.
+    uint32_t cached_checksum = 0;
+    tablet->obtain_header_rdlock();
+    ASSERT_TRUE(tablet->get_cached_checksum(
+            push_req.version, push_req.version_hash, &cached_checksum));
+    tablet->release_header_lock();
+    ASSERT_EQ(BASE_TABLE_PUSH_DATA_CHECKSUM, cached_checksum);
+
+    checksum = 0;
+    res = _command_executor->compute_checksum(
+            push_req.tablet_id, push_req.schema_hash,
+            push_req.version, push_req.version_hash, true, &checksum);
+    ASSERT_EQ(OLAP_SUCCESS, res);
+    ASSERT_EQ(BASE_TABLE_PUSH_DATA_CHECKSUM, checksum);
 }
 
 class TestBaseExpansion : public ::testing::Test {
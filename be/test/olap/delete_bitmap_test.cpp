@@ -0,0 +1,138 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/delete_bitmap.h"
+
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+namespace palo {
+
+class DeleteBitmapTest : public testing::Test {
+public:
+    static void SetUpTestCase() {
+        boost::filesystem::remove_all(_s_test_data_path);
+        ASSERT_TRUE(boost::filesystem::create_directory(_s_test_data_path));
+    }
+
+    static void TearDownTestCase() {
+        boost::filesystem::remove_all(_s_test_data_path);
+    }
+
+    static std::string _s_test_data_path;
+};
+
+std::string DeleteBitmapTest::_s_test_data_path = "./delete_bitmap_test_data";
+
+TEST_F(DeleteBitmapTest, AddAndGet) {
+    DeleteBitmap bitmap;
+    Version base(0, 5);
+    bitmap.add(base, 0, 10, 7);
+    bitmap.add(base, 0, 3, 6);
+    bitmap.add(base, 1, 4, 8);
+    // the oldest replacing version is kept
+    bitmap.add(base, 0, 10, 9);
+    bitmap.add(base, 1, 4, 6);
+    ASSERT_EQ(3, bitmap.num_deleted_rows());
+
+    ASSERT_FALSE(bitmap.is_deleted(base, 0, 10, 6));
+    ASSERT_TRUE(bitmap.is_deleted(base, 0, 10, 7));
+    ASSERT_TRUE(bitmap.is_deleted(base, 1, 4, 6));
+    ASSERT_FALSE(bitmap.is_deleted(base, 2, 4, 9));
+    ASSERT_FALSE(bitmap.is_deleted(Version(6, 6), 0, 3, 9));
+
+    DeleteBitmap::DeletedRows rows;
+    bitmap.get_deleted_rows(base, 6, &rows);
+    ASSERT_EQ(2, rows.size());
+    ASSERT_EQ(std::vector<uint64_t>({3}), rows[0]);
+    ASSERT_EQ(std::vector<uint64_t>({4}), rows[1]);
+
+    bitmap.get_deleted_rows(base, 9, &rows);
+    ASSERT_EQ(std::vector<uint64_t>({3, 10}), rows[0]);
+
+    bitmap.get_deleted_rows(base, 5, &rows);
+    ASSERT_TRUE(rows.empty());
+}
+
+TEST_F(DeleteBitmapTest, Remove) {
+    DeleteBitmap bitmap;
+    bitmap.add(Version(0, 5), 0, 1, 6);
+    bitmap.add(Version(0, 5), 0, 2, 7);
+    bitmap.add(Version(6, 6), 0, 1, 7);
+    bitmap.set_marked(Version(6, 6));
+    bitmap.set_marked(Version(7, 7));
+
+    bitmap.remove_deleted_by(Version(7, 7));
+    ASSERT_EQ(1, bitmap.num_deleted_rows());
+    ASSERT_TRUE(bitmap.is_deleted(Version(0, 5), 0, 1, 6));
+
+    bitmap.remove_version(Version(6, 6));
+    ASSERT_FALSE(bitmap.is_marked(Version(6, 6)));
+    ASSERT_TRUE(bitmap.is_marked(Version(7, 7)));
+}
+
+TEST_F(DeleteBitmapTest, Prune) {
+    DeleteBitmap bitmap;
+    bitmap.add(Version(0, 5), 0, 1, 6);
+    bitmap.add(Version(0, 5), 0, 2, 8);
+    bitmap.add(Version(0, 5), 0, 3, 9);
+    bitmap.add(Version(6, 6), 0, 1, 8);
+    bitmap.set_marked(Version(6, 6));
+    bitmap.set_marked(Version(7, 8));
+
+    // [6, 6] is compacted into [6, 8], and [9, 9] is gone
+    std::vector<Version> versions = {Version(0, 5), Version(6, 8)};
+    bitmap.prune(versions);
+    ASSERT_EQ(2, bitmap.num_deleted_rows());
+    ASSERT_TRUE(bitmap.is_deleted(Version(0, 5), 0, 1, 8));
+    ASSERT_TRUE(bitmap.is_deleted(Version(0, 5), 0, 2, 8));
+    ASSERT_FALSE(bitmap.is_marked(Version(6, 6)));
+    ASSERT_FALSE(bitmap.is_marked(Version(7, 8)));
+}
+
+TEST_F(DeleteBitmapTest, SaveAndLoad) {
+    std::string file_name = _s_test_data_path + "/1.hdr.delete_bitmap";
+    DeleteBitmap bitmap;
+    ASSERT_EQ(OLAP_ERR_FILE_NOT_EXIST, bitmap.load(file_name));
+
+    bitmap.add(Version(0, 5), 0, 1, 6);
+    bitmap.add(Version(0, 5), 2, 100000, 7);
+    bitmap.add(Version(6, 6), 1, 5, 7);
+    bitmap.set_marked(Version(6, 6));
+    bitmap.set_marked(Version(7, 7));
+    ASSERT_EQ(OLAP_SUCCESS, bitmap.save(file_name));
+    ASSERT_FALSE(boost::filesystem::exists(file_name + ".tmp"));
+
+    DeleteBitmap loaded;
+    ASSERT_EQ(OLAP_SUCCESS, loaded.load(file_name));
+    ASSERT_EQ(3, loaded.num_deleted_rows());
+    ASSERT_TRUE(loaded.is_deleted(Version(0, 5), 0, 1, 6));
+    ASSERT_FALSE(loaded.is_deleted(Version(0, 5), 2, 100000, 6));
+    ASSERT_TRUE(loaded.is_deleted(Version(0, 5), 2, 100000, 7));
+    ASSERT_TRUE(loaded.is_deleted(Version(6, 6), 1, 5, 7));
+    ASSERT_TRUE(loaded.is_marked(Version(6, 6)));
+    ASSERT_TRUE(loaded.is_marked(Version(7, 7)));
+    ASSERT_FALSE(loaded.is_marked(Version(0, 5)));
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1054,6 +1054,62 @@ TEST_F(TestDeleteHandler, FilterDataConditions) {
     _delete_handler.finalize();
 }
 
+// 测试只用condition_mask中指定的过滤条件判定数据
+TEST_F(TestDeleteHandler, FilterDataConditionMask) {
+    OLAPStatus res;
+    DeleteConditionHandler cond_handler;
+    std::vector<TCondition> conditions;
+
+    // 过滤条件1
+    TCondition condition;
+    condition.column_name = "k1";
+    condition.condition_op = "=";
+    condition.condition_values.clear();
+    condition.condition_values.push_back("3");
+    conditions.push_back(condition);
+
+    res = cond_handler.store_cond(_olap_table, 3, conditions);
+    ASSERT_EQ(OLAP_SUCCESS, res);
+    ASSERT_EQ(OLAP_SUCCESS, push_empty_delta(3));
+
+    // 过滤条件2
+    conditions.clear();
+    condition.column_name = "k2";
+    condition.condition_op = "=";
+    condition.condition_values.clear();
+    condition.condition_values.push_back("5");
+    conditions.push_back(condition);
+
+    res = cond_handler.store_cond(_olap_table, 4, conditions);
+    ASSERT_EQ(OLAP_SUCCESS, res);
+    ASSERT_EQ(OLAP_SUCCESS, push_empty_delta(4));
+
+    _delete_handler.init(_olap_table, 10);
+
+    vector<string> data_str;
+    data_str.push_back("4");
+    data_str.push_back("5");
+    data_str.push_back("8");
+    data_str.push_back("-1");
+    data_str.push_back("16");
+    data_str.push_back("1.2");
+    data_str.push_back("2014-01-01");
+    data_str.push_back("2014-01-01 00:00:00");
+    data_str.push_back("YWFH");
+    data_str.push_back("YWFH==");
+    data_str.push_back("1");
+    res = _data_row_cursor.from_string(data_str);
+    ASSERT_EQ(OLAP_SUCCESS, res);
+    // 这行数据只满足过滤条件2
+    ASSERT_TRUE(_delete_handler.is_filter_data(1, _data_row_cursor, 0x3));
+    ASSERT_TRUE(_delete_handler.is_filter_data(1, _data_row_cursor, 0x2));
+    // 过滤条件2被mask掉后，这行数据不会被过滤
+    ASSERT_FALSE(_delete_handler.is_filter_data(1, _data_row_cursor, 0x1));
+    ASSERT_FALSE(_delete_handler.is_filter_data(1, _data_row_cursor, 0x0));
+
+    _delete_handler.finalize();
+}
+
 // 测试在过滤时，版本号小于数据版本的过滤条件将不起作用
 TEST_F(TestDeleteHandler, FilterDataVersion) {
     OLAPStatus res;
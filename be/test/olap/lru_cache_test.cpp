@@ -226,6 +226,39 @@ TEST_F(CacheTest, HeavyEntries) {
     ASSERT_LE(cached_weight, kCacheSize + kCacheSize / 10);
 }
 
+TEST_F(CacheTest, EvictAndSetCapacity) {
+    for (int i = 0; i < 100; i++) {
+        Insert(i, 1000 + i, 1);
+    }
+
+    std::string result;
+    Cache::Handle* h = _cache->lookup(EncodeKey(&result, 7));
+    // the pinned entry is kept
+    ASSERT_EQ(99, _cache->evict(kCacheSize));
+    ASSERT_EQ(1007, Lookup(7));
+    ASSERT_EQ(-1, Lookup(8));
+
+    CacheStats stats;
+    _cache->get_stats(&stats);
+    ASSERT_EQ(3, stats.lookup_count);
+    ASSERT_EQ(2, stats.hit_count);
+    ASSERT_EQ(99, stats.evict_count);
+    ASSERT_EQ(1, stats.usage);
+    ASSERT_GE(stats.capacity, kCacheSize);
+    _cache->release(h);
+
+    _cache->set_capacity(32);
+    for (int i = 0; i < 100; i++) {
+        Insert(i, 1000 + i, 1);
+    }
+    CacheStats shrunk;
+    _cache->get_stats(&shrunk);
+    ASSERT_EQ(32, shrunk.capacity);
+    ASSERT_LE(shrunk.usage, 32);
+    // the old entry 7 is either replaced or evicted
+    ASSERT_GE(shrunk.evict_count, 99 + 100 - shrunk.usage);
+}
+
 TEST_F(CacheTest, NewId) {
     uint64_t a = _cache->new_id();
     uint64_t b = _cache->new_id();
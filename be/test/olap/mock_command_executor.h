@@ -29,6 +29,10 @@ public:
     MOCK_METHOD2(
             push,
             OLAPStatus(const TPushReq& request, std::vector<TTabletInfo>* tablet_info_vec));
+    MOCK_METHOD2(
+            push_batch,
+            OLAPStatus(const std::vector<TPushReq>& requests,
+                       std::vector<std::vector<TTabletInfo>>* tablet_info_vecs));
     MOCK_METHOD1(report_tablet_info, OLAPStatus(TTabletInfo* tablet_info));
     MOCK_METHOD1(
             report_all_tablets_info,
@@ -58,6 +62,12 @@ public:
             OLAPStatus(const std::string& root_path,
                        TTabletId tablet_id,
                        TSchemaHash schema_hash));
+    MOCK_METHOD4(
+            clone_incremental_data,
+            OLAPStatus(const std::string& clone_dir,
+                       TTabletId tablet_id,
+                       TSchemaHash schema_hash,
+                       const std::vector<Version>& missing_versions));
     MOCK_METHOD1(release_snapshot, OLAPStatus(const std::string& snapshot_path));
     MOCK_METHOD2(
             delete_data,
@@ -0,0 +1,209 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/olap_header.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+#include "boost/filesystem.hpp"
+#include "common/config.h"
+#include "util/logging.h"
+
+namespace palo {
+
+class OLAPHeaderTest : public testing::Test {
+public:
+    virtual void SetUp() {
+        config::header_log_max_records = 4;
+        boost::filesystem::remove_all(_s_test_data_path);
+        ASSERT_TRUE(boost::filesystem::create_directory(_s_test_data_path));
+        _header_file = _s_test_data_path + "/10.hdr";
+        _log_file = _header_file + ".log";
+    }
+
+    virtual void TearDown() {
+        config::header_log_max_records = 0;
+        boost::filesystem::remove_all(_s_test_data_path);
+    }
+
+protected:
+    // a header with version 0-0 saved for the first time
+    void init_header(OLAPHeader* header) {
+        header->set_num_rows_per_data_block(1024);
+        header->set_cumulative_layer_point(-1);
+        header->set_num_short_key_fields(1);
+        header->set_creation_time(1);
+        ASSERT_EQ(OLAP_SUCCESS, header->add_version(Version(0, 0), 0, 1, 0, 10, 100, 5));
+        ASSERT_EQ(OLAP_SUCCESS, header->save());
+    }
+
+    void add_version(OLAPHeader* header, int version) {
+        ASSERT_EQ(OLAP_SUCCESS, header->add_version(
+                Version(version, version), version, 1, 0, 10, 100, 5));
+    }
+
+    static bool has_version(const OLAPHeader& header, int start, int end) {
+        for (const FileVersionMessage& version : header.file_version()) {
+            if (version.start_version() == start && version.end_version() == end) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static std::string read_file(const std::string& path) {
+        std::ifstream in(path.c_str(), std::ios::binary);
+        std::stringstream content;
+        content << in.rdbuf();
+        return content.str();
+    }
+
+    static void write_file(const std::string& path, const std::string& content) {
+        std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+        out << content;
+    }
+
+    static std::string _s_test_data_path;
+    std::string _header_file;
+    std::string _log_file;
+};
+
+std::string OLAPHeaderTest::_s_test_data_path = "./olap_header_test_dir";
+
+TEST_F(OLAPHeaderTest, replay_log) {
+    OLAPHeader header(_header_file);
+    init_header(&header);
+    std::string header_content = read_file(_header_file);
+    ASSERT_FALSE(boost::filesystem::exists(_log_file));
+
+    add_version(&header, 1);
+    ASSERT_EQ(OLAP_SUCCESS, header.save());
+    add_version(&header, 2);
+    ASSERT_EQ(OLAP_SUCCESS, header.delete_version(Version(1, 1)));
+    ASSERT_EQ(OLAP_SUCCESS, header.save());
+
+    // only versions changed, they are appended to the log
+    ASSERT_EQ(header_content, read_file(_header_file));
+    ASSERT_TRUE(boost::filesystem::exists(_log_file));
+
+    OLAPHeader loaded(_header_file);
+    ASSERT_EQ(OLAP_SUCCESS, loaded.load());
+    ASSERT_EQ(2, loaded.file_version_size());
+    ASSERT_TRUE(has_version(loaded, 0, 0));
+    ASSERT_FALSE(has_version(loaded, 1, 1));
+    ASSERT_TRUE(has_version(loaded, 2, 2));
+    ASSERT_EQ(header.header_log_id(), loaded.header_log_id());
+}
+
+TEST_F(OLAPHeaderTest, rewrite_after_max_records) {
+    config::header_log_max_records = 2;
+    OLAPHeader header(_header_file);
+    init_header(&header);
+    int64_t log_id = header.header_log_id();
+
+    add_version(&header, 1);
+    ASSERT_EQ(OLAP_SUCCESS, header.save());
+    add_version(&header, 2);
+    ASSERT_EQ(OLAP_SUCCESS, header.save());
+    ASSERT_TRUE(boost::filesystem::exists(_log_file));
+
+    add_version(&header, 3);
+    ASSERT_EQ(OLAP_SUCCESS, header.save());
+    ASSERT_FALSE(boost::filesystem::exists(_log_file));
+    ASSERT_EQ(log_id + 1, header.header_log_id());
+
+    OLAPHeader loaded(_header_file);
+    ASSERT_EQ(OLAP_SUCCESS, loaded.load());
+    ASSERT_EQ(4, loaded.file_version_size());
+}
+
+TEST_F(OLAPHeaderTest, torn_tail) {
+    OLAPHeader header(_header_file);
+    init_header(&header);
+    add_version(&header, 1);
+    ASSERT_EQ(OLAP_SUCCESS, header.save());
+    add_version(&header, 2);
+    ASSERT_EQ(OLAP_SUCCESS, header.save());
+
+    // the second record was partially written
+    std::string log_content = read_file(_log_file);
+    ASSERT_EQ(0, truncate(_log_file.c_str(), log_content.size() - 3));
+
+    OLAPHeader loaded(_header_file);
+    ASSERT_EQ(OLAP_SUCCESS, loaded.load());
+    ASSERT_TRUE(has_version(loaded, 1, 1));
+    ASSERT_FALSE(has_version(loaded, 2, 2));
+
+    // records appended behind the torn tail could not be replayed, so the next save
+    // rewrites the whole header
+    add_version(&loaded, 2);
+    ASSERT_EQ(OLAP_SUCCESS, loaded.save());
+    ASSERT_FALSE(boost::filesystem::exists(_log_file));
+
+    OLAPHeader reloaded(_header_file);
+    ASSERT_EQ(OLAP_SUCCESS, reloaded.load());
+    ASSERT_EQ(3, reloaded.file_version_size());
+    ASSERT_TRUE(has_version(reloaded, 2, 2));
+}
+
+TEST_F(OLAPHeaderTest, stale_log) {
+    OLAPHeader header(_header_file);
+    init_header(&header);
+    add_version(&header, 1);
+    ASSERT_EQ(OLAP_SUCCESS, header.save());
+    std::string stale_log = read_file(_log_file);
+
+    // a change of other fields rewrites the header with a new log id
+    ASSERT_EQ(OLAP_SUCCESS, header.delete_version(Version(1, 1)));
+    header.set_cumulative_layer_point(1);
+    ASSERT_EQ(OLAP_SUCCESS, header.save());
+    ASSERT_FALSE(boost::filesystem::exists(_log_file));
+
+    // the log survived, e.g. removing it failed, its records are ignored
+    write_file(_log_file, stale_log);
+    OLAPHeader loaded(_header_file);
+    ASSERT_EQ(OLAP_SUCCESS, loaded.load());
+    ASSERT_EQ(1, loaded.file_version_size());
+    ASSERT_FALSE(has_version(loaded, 1, 1));
+    ASSERT_EQ(1, loaded.cumulative_layer_point());
+}
+
+TEST_F(OLAPHeaderTest, disabled) {
+    config::header_log_max_records = 0;
+    OLAPHeader header(_header_file);
+    init_header(&header);
+    ASSERT_EQ(0, header.header_log_id());
+    add_version(&header, 1);
+    ASSERT_EQ(OLAP_SUCCESS, header.save());
+    ASSERT_FALSE(boost::filesystem::exists(_log_file));
+
+    OLAPHeader loaded(_header_file);
+    ASSERT_EQ(OLAP_SUCCESS, loaded.load());
+    ASSERT_EQ(2, loaded.file_version_size());
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -28,6 +28,7 @@
 #include "runtime/row_batch.h"
 #include "runtime/string_value.h"
 #include "runtime/tuple_row.h"
+#include "runtime/vectorized_row_batch.h"
 #include "util/runtime_profile.h"
 #include "util/debug_util.h"
 #include "util/logging.h"
@@ -526,6 +527,69 @@ TEST_F(TestOLAPReaderRow, next_tuple_with_key_range) {
             (tuple->get_slot(tuple_desc->slots()[8]->tuple_offset())));
 }
 
+TEST_F(TestOLAPReaderRow, split_key_ranges) {
+    init_scan_node();
+
+    TFetchRequest fetch_reques;
+
+    fetch_reques.__set_aggregation(false);
+    fetch_reques.__set_schema_hash(1508825676);
+    fetch_reques.__set_version(_push_req.version);
+    fetch_reques.__set_version_hash(_push_req.version_hash);
+    fetch_reques.__set_tablet_id(10003);
+
+    std::vector<TFetchStartKey> start_keys;
+    std::vector<TFetchEndKey> end_keys;
+    for (int i = 0; i < 3; ++i) {
+        TFetchStartKey start_key;
+        start_key.__set_key(std::vector<std::string>(1, std::to_string(i * 20)));
+        start_keys.push_back(start_key);
+        TFetchEndKey end_key;
+        end_key.__set_key(std::vector<std::string>(1, std::to_string(i * 20 + 10)));
+        end_keys.push_back(end_key);
+    }
+    fetch_reques.__set_start_key(start_keys);
+    fetch_reques.__set_range("ge");
+    fetch_reques.__set_end_key(end_keys);
+    fetch_reques.__set_end_range("le");
+
+    std::vector<std::string> field_vec;
+    field_vec.push_back("k1");
+    field_vec.push_back("k2");
+    field_vec.push_back("k3");
+    field_vec.push_back("k4");
+    field_vec.push_back("k5");
+    field_vec.push_back("k6");
+    field_vec.push_back("k7");
+    field_vec.push_back("k8");
+    field_vec.push_back("v");
+    fetch_reques.__set_field(field_vec);
+
+    TupleDescriptor *tuple_desc = _desc_tbl->get_tuple_descriptor(0);
+    OLAPReader olap_reader(*tuple_desc);
+    ASSERT_EQ(-1, olap_reader.split_key_ranges());
+    ASSERT_TRUE(olap_reader.init(fetch_reques, NULL, _profile).ok());
+
+    // the first key range is being read, half of the other two is given up each time
+    ASSERT_EQ(2, olap_reader.split_key_ranges());
+    ASSERT_EQ(1, olap_reader.split_key_ranges());
+    ASSERT_EQ(-1, olap_reader.split_key_ranges());
+
+    char tuple_buf[1024];
+    Tuple *tuple = reinterpret_cast<Tuple*>(tuple_buf);
+    bool eof = false;
+    int64_t raw_rows_read = 0;
+    while (true) {
+        bzero(tuple_buf, 1024);
+        ASSERT_TRUE(olap_reader.next_tuple(tuple, &raw_rows_read, &eof).ok());
+        if (eof) {
+            break;
+        }
+        ASSERT_GE(10, *reinterpret_cast<const int8_t*>(
+                tuple->get_slot(tuple_desc->slots()[0]->tuple_offset())));
+    }
+}
+
 TEST_F(TestOLAPReaderRow, next_tuple_with_where_condition) {
     init_scan_node();
     
@@ -1149,6 +1213,57 @@ TEST_F(TestOLAPReaderColumn, next_tuple_with_aggregation) {
             (tuple->get_slot(tuple_desc->slots()[1]->tuple_offset())));
 }
 
+TEST_F(TestOLAPReaderColumn, next_batch_with_aggregation) {
+    init_scan_node_k1_v();
+    
+    TFetchRequest fetch_reques;
+
+    fetch_reques.__set_aggregation(true);
+    fetch_reques.__set_schema_hash(1508825676);
+    fetch_reques.__set_version(_push_req.version);
+    fetch_reques.__set_version_hash(_push_req.version_hash);
+    fetch_reques.__set_tablet_id(10003);
+
+    TFetchStartKey start_key;
+    start_key.__set_key(std::vector<std::string>(1, "0"));
+    fetch_reques.__set_start_key(std::vector<TFetchStartKey>(1, start_key));
+    fetch_reques.__set_range("ge");
+
+    TFetchEndKey end_key;
+    end_key.__set_key(std::vector<std::string>(1, "100"));
+    fetch_reques.__set_end_key(std::vector<TFetchEndKey>(1, end_key));
+    fetch_reques.__set_end_range("le");
+
+    std::vector<std::string> field_vec;
+    field_vec.push_back("k1");
+    field_vec.push_back("v");
+    fetch_reques.__set_field(field_vec);
+
+    TupleDescriptor *tuple_desc = _desc_tbl->get_tuple_descriptor(0);
+    OLAPReader olap_reader(*tuple_desc);
+    ASSERT_TRUE(olap_reader.init(fetch_reques, NULL, _profile).ok());
+    ASSERT_TRUE(olap_reader.is_vectorized_supported());
+
+    // value column v is aggregated in batch, result is the same as next_tuple
+    std::unique_ptr<VectorizedRowBatch> batch(olap_reader.create_vectorized_row_batch(1));
+    ASSERT_TRUE(batch.get() != NULL);
+    bool eof = false;
+    int64_t raw_rows_read = 0;
+    ASSERT_TRUE(olap_reader.next_batch(batch.get(), &raw_rows_read, &eof).ok());
+    ASSERT_FALSE(eof);
+    ASSERT_EQ(1, batch->size());
+
+    char tuple_buf[1024]; 
+    bzero(tuple_buf, 1024);
+    Tuple *tuple = reinterpret_cast<Tuple*>(tuple_buf);
+    ASSERT_TRUE(olap_reader.convert_batch_to_tuples(batch.get(), tuple).ok());
+
+    ASSERT_EQ(0, *reinterpret_cast<const int8_t*>
+            (tuple->get_slot(tuple_desc->slots()[0]->tuple_offset())));
+    ASSERT_EQ(153600, *reinterpret_cast<const int64_t*>
+            (tuple->get_slot(tuple_desc->slots()[1]->tuple_offset())));
+}
+
 class TestOLAPReaderColumnDeleteCondition : public testing::Test {
 public:
     TestOLAPReaderColumnDeleteCondition() : _runtime_stat("test") {
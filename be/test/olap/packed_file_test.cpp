@@ -0,0 +1,217 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "olap/column_file/byte_buffer.h"
+#include "olap/column_file/compress.h"
+#include "olap/column_file/file_stream.h"
+#include "olap/column_file/out_stream.h"
+#include "olap/file_helper.h"
+#include "olap/lru_cache.h"
+#include "olap/olap_define.h"
+#include "olap/olap_engine.h"
+#include "olap/olap_main.cpp"
+#include "olap/packed_file.h"
+#include "olap/utils.h"
+#include "util/logging.h"
+
+using std::string;
+using std::vector;
+
+namespace palo {
+
+static const uint32_t MAX_PATH_LEN = 1024;
+static const uint32_t SEGMENT_NUM = 3;
+
+void set_up() {
+    char buffer[MAX_PATH_LEN];
+    getcwd(buffer, MAX_PATH_LEN);
+    config::storage_root_path = string(buffer) + "/packed_file_test";
+    remove_all_dir(config::storage_root_path);
+    create_dir(config::storage_root_path);
+    // 打开打包文件中的一段需要句柄cache
+    touch_all_singleton();
+}
+
+void tear_down() {
+    remove_all_dir(config::storage_root_path);
+}
+
+namespace column_file {
+
+class TestPackedFile : public testing::Test {
+public:
+    virtual void SetUp() {
+        _pack_path = config::storage_root_path + "/10_0_1_0.pack";
+        unlink(_pack_path.c_str());
+
+        // 每个segment的数据流内容不同, 但在各自数据文件中的位置都是0
+        for (uint32_t seg = 0; seg < SEGMENT_NUM; ++seg) {
+            string prefix = config::storage_root_path + "/10_0_1_0_" + std::to_string(seg);
+            _index_paths.push_back(prefix + ".idx");
+            _data_paths.push_back(prefix + ".dat");
+
+            vector<char> index(100 + seg, 'i' + seg);
+            _write_file(_index_paths[seg], &index[0], index.size());
+
+            vector<char> data(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE * 2 + seg);
+            for (uint64_t i = 0; i < data.size(); ++i) {
+                data[i] = (i / 3 + seg * 17) % 251;
+            }
+            OutStream out_stream(OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE, lzo_compress);
+            ASSERT_EQ(OLAP_SUCCESS, out_stream.write(&data[0], data.size()));
+            ASSERT_EQ(OLAP_SUCCESS, out_stream.flush());
+
+            FileHandler writer;
+            unlink(_data_paths[seg].c_str());
+            ASSERT_EQ(OLAP_SUCCESS, writer.open_with_mode(_data_paths[seg],
+                    O_CREAT | O_EXCL | O_WRONLY, S_IRUSR | S_IWUSR));
+            ASSERT_EQ(OLAP_SUCCESS, out_stream.write_to_file(&writer, 0));
+            ASSERT_EQ(OLAP_SUCCESS, writer.close());
+
+            _index_contents.push_back(index);
+            _data_contents.push_back(data);
+            _stream_lengths.push_back(out_stream.get_stream_length());
+        }
+    }
+
+    virtual void TearDown() {
+        unlink(_pack_path.c_str());
+        for (uint32_t seg = 0; seg < SEGMENT_NUM; ++seg) {
+            unlink(_index_paths[seg].c_str());
+            unlink(_data_paths[seg].c_str());
+        }
+    }
+
+    // 通过page cache读出第seg个segment的数据流, 与写入的内容比较
+    void check_data_region(const PackedSegment& segment, uint32_t seg, Cache* page_cache) {
+        FileHandler reader;
+        ASSERT_EQ(OLAP_SUCCESS, reader.open_region_with_cache(
+                _pack_path, segment.data.offset, segment.data.length));
+        ASSERT_EQ(segment.data.offset, static_cast<uint64_t>(reader.region_offset()));
+
+        ByteBuffer* shared_buffer = ByteBuffer::create(
+                OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE + sizeof(StreamHead));
+        ASSERT_TRUE(shared_buffer != NULL);
+        ReadOnlyFileStream in_stream(&reader, &shared_buffer, 0, _stream_lengths[seg],
+                                     lzo_decompress, OLAP_DEFAULT_COLUMN_STREAM_BUFFER_SIZE);
+        ASSERT_EQ(OLAP_SUCCESS, in_stream.init());
+        in_stream.set_page_cache(page_cache);
+
+        const vector<char>& data = _data_contents[seg];
+        vector<char> result(data.size());
+        uint64_t read_size = data.size();
+        ASSERT_EQ(OLAP_SUCCESS, in_stream.read(&result[0], &read_size));
+        ASSERT_EQ(data.size(), read_size);
+        ASSERT_EQ(0, memcmp(&data[0], &result[0], data.size()));
+
+        SAFE_DELETE(shared_buffer);
+        reader.close();
+    }
+
+protected:
+    void _write_file(const string& path, const char* buf, size_t len) {
+        unlink(path.c_str());
+        FileHandler writer;
+        ASSERT_EQ(OLAP_SUCCESS, writer.open_with_mode(path,
+                O_CREAT | O_EXCL | O_WRONLY, S_IRUSR | S_IWUSR));
+        ASSERT_EQ(OLAP_SUCCESS, writer.write(buf, len));
+        ASSERT_EQ(OLAP_SUCCESS, writer.close());
+    }
+
+    string _pack_path;
+    vector<string> _index_paths;
+    vector<string> _data_paths;
+    vector<vector<char> > _index_contents;
+    vector<vector<char> > _data_contents;
+    vector<uint64_t> _stream_lengths;
+};
+
+TEST_F(TestPackedFile, ReadSegmentsThroughCaches) {
+    ASSERT_EQ(OLAP_SUCCESS, pack_segment_files(_index_paths, _data_paths, _pack_path));
+    // 打包后原来的文件被删除
+    for (uint32_t seg = 0; seg < SEGMENT_NUM; ++seg) {
+        ASSERT_FALSE(check_dir_existed(_index_paths[seg]));
+        ASSERT_FALSE(check_dir_existed(_data_paths[seg]));
+    }
+
+    vector<PackedSegment> segments;
+    ASSERT_EQ(OLAP_SUCCESS, read_packed_directory(_pack_path, &segments));
+    ASSERT_EQ(SEGMENT_NUM, segments.size());
+    for (uint32_t seg = 0; seg < SEGMENT_NUM; ++seg) {
+        ASSERT_EQ(_index_contents[seg].size(), segments[seg].index.length);
+        ASSERT_EQ(_stream_lengths[seg], segments[seg].data.length);
+        if (seg > 0) {
+            ASSERT_GT(segments[seg].index.offset, segments[seg - 1].data.offset);
+        }
+
+        FileHandler reader;
+        ASSERT_EQ(OLAP_SUCCESS, reader.open_region_with_cache(
+                _pack_path, segments[seg].index.offset, segments[seg].index.length));
+        ASSERT_EQ(static_cast<off_t>(_index_contents[seg].size()), reader.length());
+        vector<char> index(_index_contents[seg].size());
+        ASSERT_EQ(OLAP_SUCCESS, reader.pread(&index[0], index.size(), 0));
+        ASSERT_TRUE(index == _index_contents[seg]);
+        reader.close();
+    }
+
+    // 所有segment的数据流都在各自区域的0位置, page cache的key要用打包文件中的位置区分
+    std::unique_ptr<Cache> page_cache(new_lru_cache(16 * 1024 * 1024));
+    for (uint32_t seg = 0; seg < SEGMENT_NUM; ++seg) {
+        check_data_region(segments[seg], seg, page_cache.get());
+    }
+
+    // 覆盖打包文件中的数据, 之后只有从cache中才能读到各segment正确的数据
+    FileHandler overwriter;
+    ASSERT_EQ(OLAP_SUCCESS, overwriter.open_with_mode(_pack_path, O_WRONLY, S_IRUSR | S_IWUSR));
+    for (uint32_t seg = 0; seg < SEGMENT_NUM; ++seg) {
+        vector<char> zeros(segments[seg].data.length, 0);
+        ASSERT_EQ(OLAP_SUCCESS, overwriter.pwrite(
+                &zeros[0], zeros.size(), segments[seg].data.offset));
+    }
+    ASSERT_EQ(OLAP_SUCCESS, overwriter.close());
+
+    for (uint32_t seg = SEGMENT_NUM; seg > 0; --seg) {
+        check_data_region(segments[seg - 1], seg - 1, page_cache.get());
+    }
+}
+
+}  // namespace column_file
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    int ret = palo::OLAP_SUCCESS;
+    testing::InitGoogleTest(&argc, argv);
+
+    palo::set_up();
+    ret = RUN_ALL_TESTS();
+    palo::tear_down();
+
+    google::protobuf::ShutdownProtobufLibrary();
+    return ret;
+}
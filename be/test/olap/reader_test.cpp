@@ -0,0 +1,639 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "olap/i_data.h"
+#include "olap/merger.h"
+#include "olap/olap_cond.h"
+#include "olap/olap_index.h"
+#include "olap/olap_main.cpp"
+#include "olap/reader.h"
+#include "olap/row_cursor.h"
+#include "olap/test_tablet.h"
+#include "olap/utils.h"
+#include "runtime/vectorized_row_batch.h"
+#include "util/cpu_info.h"
+#include "util/logging.h"
+
+using std::string;
+using std::vector;
+
+namespace palo {
+
+// A row of the test tablet as returned by Reader: k1, v1.
+typedef std::pair<int32_t, int64_t> Row;
+
+// Tests of the AGG_KEYS tablet k1 INT, v1 BIGINT SUM, read by Reader as READER_FETCH
+// with aggregation, the way OLAPReader reads it.
+class ReaderTest : public testing::Test {
+public:
+    ReaderTest() {}
+    ~ReaderTest() {}
+
+protected:
+    virtual void SetUp() {
+        _sample_rows = config::storage_merge_sample_rows;
+        _min_reduction = config::storage_merge_min_reduction;
+        config::storage_merge_sample_rows = 256;
+        config::storage_merge_min_reduction = 1.5;
+
+        _tablet.reset(new TestTablet(50001, TKeysType::AGG_KEYS));
+        _tablet->add_column("k1", TPrimitiveType::INT, true);
+        _tablet->add_column("v1", TPrimitiveType::BIGINT, false, TAggregationType::SUM);
+        ASSERT_EQ(OLAP_SUCCESS, _tablet->create());
+        _num_rows = 0;
+    }
+
+    virtual void TearDown() {
+        _tablet.reset();
+        config::storage_merge_sample_rows = _sample_rows;
+        config::storage_merge_min_reduction = _min_reduction;
+    }
+
+    // Writes the keys [begin, end) with v1 'value' as the next version.
+    void write_version(int begin, int end, int64_t value, bool delete_flag = false) {
+        vector<vector<string> > rows;
+        for (int key = begin; key < end; ++key) {
+            rows.push_back({std::to_string(key), std::to_string(value)});
+            if (delete_flag) {
+                _expected.erase(key);
+            } else {
+                _expected[key] += value;
+            }
+        }
+        ASSERT_EQ(OLAP_SUCCESS, _tablet->write_version(rows, delete_flag));
+        _num_rows += rows.size();
+    }
+
+    void init_reader(bool adaptive_aggregation, Reader* reader) {
+        ReaderParams params;
+        params.olap_table = _tablet->table();
+        params.reader_type = READER_FETCH;
+        params.aggregation = true;
+        params.adaptive_aggregation = adaptive_aggregation;
+        params.version = Version(0, _tablet->table()->latest_version()->end_version());
+        params.return_columns = {0, 1};
+        ASSERT_EQ(OLAP_SUCCESS, reader->init(params));
+    }
+
+    static Row to_row(const RowCursor& row_cursor) {
+        vector<string> values = row_cursor.to_string_vector();
+        return Row(std::stoi(values[0]), std::stoll(values[1]));
+    }
+
+    // Reads all rows of 'reader' the way OLAPReader::next_tuple() does.
+    void read_rows(Reader* reader, vector<Row>* rows, int64_t* raw_rows) {
+        RowCursor row_cursor;
+        ASSERT_EQ(OLAP_SUCCESS,
+                  row_cursor.init(_tablet->table()->tablet_schema(), reader->return_columns()));
+        while (true) {
+            const RowCursor* row = &row_cursor;
+            bool eof = false;
+            OLAPStatus res = OLAP_SUCCESS;
+            if (reader->is_aggregation_free()) {
+                res = reader->next_row(&row, raw_rows, &eof);
+            } else {
+                res = reader->next_row_with_aggregation(&row_cursor, raw_rows, &eof);
+            }
+            ASSERT_EQ(OLAP_SUCCESS, res);
+            if (eof) {
+                break;
+            }
+            rows->push_back(to_row(*row));
+        }
+    }
+
+    // Reads all rows of 'reader' the way OLAPReader::next_batch() does.
+    void read_batches(Reader* reader, vector<Row>* rows, int64_t* raw_rows) {
+        vector<FieldInfo> schema;
+        for (uint32_t column_id : reader->return_columns()) {
+            schema.push_back(_tablet->table()->tablet_schema()[column_id]);
+        }
+        VectorizedRowBatch batch(schema, 100);
+        bool eof = false;
+        while (!eof) {
+            batch.reset();
+            batch.prepare_storage_columns();
+            OLAPStatus res = OLAP_SUCCESS;
+            if (reader->is_merge_free()) {
+                res = reader->next_block(&batch, raw_rows, &eof);
+            } else {
+                res = reader->next_block_with_aggregation(&batch, raw_rows, &eof);
+            }
+            ASSERT_EQ(OLAP_SUCCESS, res);
+            batch.finish_storage_columns();
+            const int32_t* k1 = reinterpret_cast<const int32_t*>(batch.column(0)->col_data());
+            const int64_t* v1 = reinterpret_cast<const int64_t*>(batch.column(1)->col_data());
+            for (int i = 0; i < batch.size(); ++i) {
+                rows->push_back(Row(k1[i], v1[i]));
+            }
+        }
+    }
+
+    void read(bool adaptive_aggregation, bool vectorized, vector<Row>* rows,
+              int64_t* raw_rows, bool* merge_free) {
+        Reader reader;
+        init_reader(adaptive_aggregation, &reader);
+        *raw_rows = 0;
+        if (vectorized) {
+            ASSERT_TRUE(reader.is_block_aggregation_supported());
+            read_batches(&reader, rows, raw_rows);
+        } else {
+            read_rows(&reader, rows, raw_rows);
+        }
+        *merge_free = reader.is_merge_free();
+        reader.close();
+    }
+
+    // The rows aggregated again by key, as the aggregation above the scan does.
+    static std::map<int32_t, int64_t> aggregate(const vector<Row>& rows) {
+        std::map<int32_t, int64_t> result;
+        for (const Row& row : rows) {
+            result[row.first] += row.second;
+        }
+        return result;
+    }
+
+    static int count_key(const vector<Row>& rows, int32_t key) {
+        int count = 0;
+        for (const Row& row : rows) {
+            count += (row.first == key);
+        }
+        return count;
+    }
+
+    // The head of the versions overlaps, so the reader merges rows at first. After
+    // [3000, 3500) of the base version overlaps again, which the reader has stopped
+    // merging by then.
+    void write_partly_overlapping_versions() {
+        write_version(0, 4000, 1);
+        write_version(0, 500, 10);
+        write_version(3000, 3500, 100);
+    }
+
+    int64_t _sample_rows;
+    double _min_reduction;
+    std::unique_ptr<TestTablet> _tablet;
+    // v1 of each key after all versions are merged
+    std::map<int32_t, int64_t> _expected;
+    int64_t _num_rows;
+};
+
+TEST_F(ReaderTest, SwitchToMergeFree) {
+    write_partly_overlapping_versions();
+    for (int vectorized = 0; vectorized < 2; ++vectorized) {
+        SCOPED_TRACE(testing::Message() << "vectorized " << vectorized);
+        vector<Row> merged_rows;
+        int64_t merged_raw_rows = 0;
+        bool merge_free = true;
+        read(false, vectorized, &merged_rows, &merged_raw_rows, &merge_free);
+        EXPECT_FALSE(merge_free);
+        EXPECT_EQ(_expected.size(), merged_rows.size());
+        EXPECT_EQ(_num_rows, merged_raw_rows);
+
+        vector<Row> rows;
+        int64_t raw_rows = 0;
+        read(true, vectorized, &rows, &raw_rows, &merge_free);
+        EXPECT_TRUE(merge_free);
+        // every row is read once, into exactly one returned row
+        EXPECT_EQ(_num_rows, raw_rows);
+        EXPECT_GT(rows.size(), _expected.size());
+        EXPECT_LT(static_cast<int64_t>(rows.size()), _num_rows);
+        // the rows of the head were merged, the later ones returned unmerged
+        ASSERT_FALSE(rows.empty());
+        EXPECT_EQ(Row(0, 11), rows[0]);
+        EXPECT_EQ(1, count_key(rows, 100));
+        EXPECT_EQ(2, count_key(rows, 3200));
+        EXPECT_EQ(1, count_key(merged_rows, 3200));
+
+        EXPECT_TRUE(_expected == aggregate(merged_rows));
+        EXPECT_TRUE(_expected == aggregate(rows));
+    }
+}
+
+// Merging halves the rows, the reader keeps merging.
+TEST_F(ReaderTest, KeepMergingOnHighReduction) {
+    write_version(0, 3000, 1);
+    write_version(0, 3000, 2);
+    for (int vectorized = 0; vectorized < 2; ++vectorized) {
+        SCOPED_TRACE(testing::Message() << "vectorized " << vectorized);
+        vector<Row> rows;
+        int64_t raw_rows = 0;
+        bool merge_free = true;
+        read(true, vectorized, &rows, &raw_rows, &merge_free);
+        EXPECT_FALSE(merge_free);
+        EXPECT_EQ(_num_rows, raw_rows);
+        EXPECT_EQ(_expected.size(), rows.size());
+        EXPECT_TRUE(_expected == aggregate(rows));
+    }
+}
+
+// A delete version removes the rows with equal key of the older versions by merging
+// with them, the reader doesn't stop merging however little it reduces.
+TEST_F(ReaderTest, DeleteVersionKeepsMerging) {
+    write_version(0, 4000, 1);
+    write_version(0, 200, 10);
+    write_version(3000, 3500, 0, true);
+    for (int vectorized = 0; vectorized < 2; ++vectorized) {
+        SCOPED_TRACE(testing::Message() << "vectorized " << vectorized);
+        vector<Row> rows;
+        int64_t raw_rows = 0;
+        bool merge_free = true;
+        read(true, vectorized, &rows, &raw_rows, &merge_free);
+        EXPECT_FALSE(merge_free);
+        EXPECT_EQ(_expected.size(), rows.size());
+        EXPECT_EQ(0, count_key(rows, 3200));
+        EXPECT_TRUE(_expected == aggregate(rows));
+    }
+}
+
+// Reads the rows of 'reader' by next_row() as strings, while it is aggregation free.
+// Checks that each row stays unchanged until the next call, and that a copy of the
+// previous row is not clobbered by the next call.
+static void read_rows_without_copy(Reader* reader, const vector<FieldInfo>& schema,
+                                   vector<string>* rows, int64_t* raw_rows) {
+    RowCursor last_row;
+    ASSERT_EQ(OLAP_SUCCESS, last_row.init(schema, reader->return_columns()));
+    const RowCursor* last = NULL;
+    string last_string;
+    while (reader->is_aggregation_free()) {
+        if (last != NULL) {
+            EXPECT_EQ(last_string, last->to_string());
+        }
+        const RowCursor* row = NULL;
+        bool eof = false;
+        ASSERT_EQ(OLAP_SUCCESS, reader->next_row(&row, raw_rows, &eof));
+        if (last != NULL) {
+            EXPECT_EQ(last_string, last_row.to_string());
+        }
+        if (eof) {
+            break;
+        }
+        ASSERT_TRUE(row != NULL);
+        last = row;
+        last_string = row->to_string();
+        rows->push_back(last_string);
+        ASSERT_EQ(OLAP_SUCCESS, last_row.copy(*row));
+    }
+}
+
+// next_row() of a DUP_KEYS tablet returns the rows held by the data sources, through
+// the ends of the blocks and of the versions.
+TEST(ReaderNextRowTest, DupKeys) {
+    int32_t rows_per_block = config::default_num_rows_per_column_file_block;
+    config::default_num_rows_per_column_file_block = 100;
+    TestTablet tablet(50002, TKeysType::DUP_KEYS);
+    tablet.add_column("k1", TPrimitiveType::INT, true);
+    tablet.add_column("v1", TPrimitiveType::VARCHAR, false);
+    tablet.add_column("v2", TPrimitiveType::BIGINT, false);
+    ASSERT_EQ(OLAP_SUCCESS, tablet.create());
+    // keys [1000, 2000) are in both versions
+    vector<vector<string> > expected;
+    for (int version = 0; version < 2; ++version) {
+        vector<vector<string> > rows;
+        for (int key = version * 1000; key < version * 1000 + 2000; ++key) {
+            rows.push_back({std::to_string(key), "s" + std::to_string(key % 13 * 1000 + version),
+                            std::to_string(key * 3)});
+        }
+        ASSERT_EQ(OLAP_SUCCESS, tablet.write_version(rows));
+        expected.insert(expected.end(), rows.begin(), rows.end());
+    }
+    config::default_num_rows_per_column_file_block = rows_per_block;
+
+    ReaderParams params;
+    params.olap_table = tablet.table();
+    params.reader_type = READER_FETCH;
+    params.aggregation = false;
+    params.version = Version(0, tablet.table()->latest_version()->end_version());
+    params.return_columns = {0, 1, 2};
+    Reader reader;
+    ASSERT_EQ(OLAP_SUCCESS, reader.init(params));
+    ASSERT_TRUE(reader.is_aggregation_free());
+
+    vector<string> rows;
+    int64_t raw_rows = 0;
+    read_rows_without_copy(&reader, tablet.table()->tablet_schema(), &rows, &raw_rows);
+    reader.close();
+    EXPECT_EQ(static_cast<int64_t>(expected.size()), raw_rows);
+
+    // the rows as printed by RowCursor::to_string()
+    vector<string> expected_strings;
+    for (const vector<string>& values : expected) {
+        expected_strings.push_back("0&" + values[0] + "|0&" + values[1] + "|0&" + values[2]);
+    }
+    std::sort(expected_strings.begin(), expected_strings.end());
+    std::sort(rows.begin(), rows.end());
+    EXPECT_EQ(expected_strings.size(), rows.size());
+    EXPECT_TRUE(expected_strings == rows);
+}
+
+// next_row() after the reader stopped merging rows of an AGG_KEYS tablet.
+TEST_F(ReaderTest, MergeFreeNextRow) {
+    write_partly_overlapping_versions();
+    Reader reader;
+    init_reader(true, &reader);
+    RowCursor row_cursor;
+    ASSERT_EQ(OLAP_SUCCESS,
+              row_cursor.init(_tablet->table()->tablet_schema(), reader.return_columns()));
+    vector<Row> rows;
+    int64_t raw_rows = 0;
+    bool eof = false;
+    while (!reader.is_aggregation_free()) {
+        ASSERT_EQ(OLAP_SUCCESS, reader.next_row_with_aggregation(&row_cursor, &raw_rows, &eof));
+        ASSERT_FALSE(eof);
+        rows.push_back(to_row(row_cursor));
+    }
+    EXPECT_FALSE(rows.empty());
+
+    vector<string> unmerged_rows;
+    read_rows_without_copy(&reader, _tablet->table()->tablet_schema(),
+                           &unmerged_rows, &raw_rows);
+    reader.close();
+    EXPECT_EQ(_num_rows, raw_rows);
+    for (const string& row : unmerged_rows) {
+        // "0&k1|0&v1"
+        size_t sep = row.find('|');
+        rows.push_back(Row(std::stoi(row.substr(2, sep - 2)), std::stoll(row.substr(sep + 3))));
+    }
+    EXPECT_TRUE(_expected == aggregate(rows));
+}
+
+// Merger keeps only the key columns of the previous row to count the distinct
+// prefixes of the keys in base expansion.
+TEST(MergerTest, BaseExpansionSelectivities) {
+    TestTablet tablet(50003, TKeysType::AGG_KEYS);
+    tablet.add_column("k1", TPrimitiveType::INT, true);
+    tablet.add_column("k2", TPrimitiveType::INT, true);
+    tablet.add_column("v1", TPrimitiveType::VARCHAR, false, TAggregationType::REPLACE);
+    ASSERT_EQ(OLAP_SUCCESS, tablet.create());
+    // k1 [0, 100) with k2 [0, 10), and k1 [0, 50) with k2 [5, 15)
+    vector<vector<string> > rows;
+    for (int k1 = 0; k1 < 100; ++k1) {
+        for (int k2 = 0; k2 < 10; ++k2) {
+            rows.push_back({std::to_string(k1), std::to_string(k2), "a" + std::to_string(k2)});
+        }
+    }
+    ASSERT_EQ(OLAP_SUCCESS, tablet.write_version(rows));
+    rows.clear();
+    for (int k1 = 0; k1 < 50; ++k1) {
+        for (int k2 = 5; k2 < 15; ++k2) {
+            rows.push_back({std::to_string(k1), std::to_string(k2), "bb" + std::to_string(k2)});
+        }
+    }
+    ASSERT_EQ(OLAP_SUCCESS, tablet.write_version(rows));
+
+    SmartOLAPTable table = tablet.table();
+    Version version(0, table->latest_version()->end_version());
+    vector<IData*> data_sources;
+    table->obtain_header_rdlock();
+    table->acquire_data_sources(version, &data_sources);
+    table->release_header_lock();
+    ASSERT_FALSE(data_sources.empty());
+
+    OLAPIndex* new_base = new OLAPIndex(table.get(), version, 0, false, 0, 0);
+    Merger merger(table, new_base, READER_BASE_EXPANSION);
+    uint64_t merged_rows = 0;
+    uint64_t filted_rows = 0;
+    EXPECT_EQ(OLAP_SUCCESS, merger.merge(data_sources, false, &merged_rows, &filted_rows));
+    // 50 * 15 + 50 * 10 distinct keys of 100 distinct k1
+    EXPECT_EQ(1250, merger.row_count());
+    EXPECT_EQ(250, merged_rows);
+    EXPECT_EQ(0, filted_rows);
+    ASSERT_EQ(2, merger.selectivities().size());
+    EXPECT_EQ(12, merger.selectivities()[0]);
+    EXPECT_EQ(1, merger.selectivities()[1]);
+
+    new_base->delete_all_files();
+    delete new_base;
+    table->release_data_sources(&data_sources);
+}
+
+// Base expansion of tablets with 5 value columns, merged row by row and column group
+// by column group.
+class VerticalMergeTest : public testing::Test {
+public:
+    VerticalMergeTest() {}
+    ~VerticalMergeTest() {}
+
+protected:
+    virtual void SetUp() {
+        _column_group_size = config::vertical_compaction_column_group_size;
+        _max_buffered_segment_size = config::compaction_max_buffered_segment_size;
+        _rows_per_block = config::default_num_rows_per_column_file_block;
+        config::default_num_rows_per_column_file_block = 100;
+    }
+
+    virtual void TearDown() {
+        config::vertical_compaction_column_group_size = _column_group_size;
+        config::compaction_max_buffered_segment_size = _max_buffered_segment_size;
+        config::default_num_rows_per_column_file_block = _rows_per_block;
+    }
+
+    // Reads all rows of 'index' as RowCursor::to_string().
+    static void read_index(OLAPIndex* index, vector<string>* rows) {
+        std::unique_ptr<IData> data(IData::create(index));
+        ASSERT_TRUE(data != NULL);
+        ASSERT_EQ(OLAP_SUCCESS, data->init());
+        vector<uint32_t> return_columns;
+        for (uint32_t i = 0; i < index->table()->tablet_schema().size(); ++i) {
+            return_columns.push_back(i);
+        }
+        std::set<uint32_t> load_bf_columns;
+        Conditions conditions;
+        vector<RowCursor*> no_keys;
+        data->set_read_params(return_columns, load_bf_columns, conditions,
+                              no_keys, no_keys, false, NULL);
+        for (const RowCursor* row = data->get_first_row(); row != NULL;
+                row = data->get_next_row()) {
+            rows->push_back(row->to_string());
+        }
+        EXPECT_TRUE(data->eof());
+    }
+
+    // Merges all versions of 'tablet' into a base version with 'version_hash' and
+    // reads its rows. Vertical merge is configured with 'column_group_size', and is
+    // expected to be used if 'is_vertical'.
+    void merge(TestTablet* tablet, int32_t column_group_size, bool is_vertical,
+               VersionHash version_hash, vector<string>* rows, uint32_t* num_segments,
+               vector<uint32_t>* selectivities) {
+        config::vertical_compaction_column_group_size = column_group_size;
+        SmartOLAPTable table = tablet->table();
+        Version version(0, table->latest_version()->end_version());
+        vector<IData*> data_sources;
+        table->obtain_header_rdlock();
+        table->acquire_data_sources(version, &data_sources);
+        table->release_header_lock();
+        ASSERT_FALSE(data_sources.empty());
+        uint64_t source_rows = 0;
+        for (IData* i_data : data_sources) {
+            source_rows += i_data->num_rows();
+        }
+
+        OLAPIndex* new_base = new OLAPIndex(table.get(), version, version_hash, false, 0, 0);
+        Merger merger(table, new_base, READER_BASE_EXPANSION);
+        EXPECT_EQ(is_vertical, merger._check_vertical_merge(data_sources));
+        uint64_t merged_rows = 0;
+        uint64_t filted_rows = 0;
+        EXPECT_EQ(OLAP_SUCCESS, merger.merge(data_sources, false, &merged_rows, &filted_rows));
+        EXPECT_EQ(OLAP_SUCCESS, new_base->load());
+        // the row check of base expansion
+        EXPECT_EQ(source_rows, new_base->num_rows() + merged_rows + filted_rows);
+        EXPECT_EQ(merger.row_count(), static_cast<uint64_t>(new_base->num_rows()));
+        *num_segments = new_base->num_segments();
+        *selectivities = merger.selectivities();
+        read_index(new_base, rows);
+
+        new_base->delete_all_files();
+        delete new_base;
+        table->release_data_sources(&data_sources);
+    }
+
+    // Checks that vertical merges with column groups of 1 to 3 columns, with one or
+    // many segments, write the rows of the row by row merge.
+    void check_vertical_merge(TestTablet* tablet) {
+        vector<string> expected;
+        uint32_t num_segments = 0;
+        vector<uint32_t> expected_selectivities;
+        merge(tablet, 0, false, 100, &expected, &num_segments, &expected_selectivities);
+        ASSERT_FALSE(expected.empty());
+
+        VersionHash version_hash = 101;
+        for (int64_t max_segment_size : {0, 1}) {
+            config::compaction_max_buffered_segment_size = max_segment_size;
+            for (int32_t column_group_size = 1; column_group_size <= 3; ++column_group_size) {
+                SCOPED_TRACE(testing::Message() << "max segment size " << max_segment_size
+                        << ", column group size " << column_group_size);
+                vector<string> rows;
+                vector<uint32_t> selectivities;
+                merge(tablet, column_group_size, true, version_hash++, &rows, &num_segments,
+                      &selectivities);
+                EXPECT_EQ(expected.size(), rows.size());
+                EXPECT_TRUE(expected == rows);
+                EXPECT_TRUE(expected_selectivities == selectivities);
+                // segments of at least a block are cut where the key changes
+                if (max_segment_size > 0) {
+                    EXPECT_LT(1u, num_segments);
+                } else {
+                    EXPECT_EQ(1u, num_segments);
+                }
+            }
+        }
+    }
+
+    int32_t _column_group_size;
+    int64_t _max_buffered_segment_size;
+    int32_t _rows_per_block;
+};
+
+// SUM, REPLACE, MAX and MIN of overlapping versions, with NULL values.
+TEST_F(VerticalMergeTest, AggKeys) {
+    TestTablet tablet(50004, TKeysType::AGG_KEYS);
+    tablet.add_column("k1", TPrimitiveType::INT, true);
+    tablet.add_column("k2", TPrimitiveType::INT, true);
+    tablet.add_column("v1", TPrimitiveType::BIGINT, false, TAggregationType::SUM);
+    tablet.add_column("v2", TPrimitiveType::VARCHAR, false, TAggregationType::REPLACE);
+    tablet.add_column("v3", TPrimitiveType::INT, false, TAggregationType::MAX);
+    tablet.add_column("v4", TPrimitiveType::INT, false, TAggregationType::MIN);
+    tablet.add_column("v5", TPrimitiveType::DECIMAL, false, TAggregationType::SUM);
+    ASSERT_EQ(OLAP_SUCCESS, tablet.create());
+
+    // k1 [0, 3000), k1 [1000, 2000) and even k1 [1500, 4000)
+    auto write_version = [&tablet](int begin, int end, int step, int value) {
+        vector<vector<string> > rows;
+        for (int k1 = begin; k1 < end; k1 += step) {
+            rows.push_back({std::to_string(k1),
+                            std::to_string(k1 % 3),
+                            std::to_string(k1 * value),
+                            k1 % 5 == value ? "NULL" : "s" + std::to_string(k1 % 7 + value),
+                            k1 % 13 == 0 ? "NULL" : std::to_string(k1 % 100 + value),
+                            k1 % 4 == value ? "NULL" : std::to_string(k1 % 50 - value),
+                            std::to_string(value) + ".25"});
+        }
+        ASSERT_EQ(OLAP_SUCCESS, tablet.write_version(rows));
+    };
+    write_version(0, 3000, 1, 1);
+    write_version(1000, 2000, 1, 2);
+    write_version(1500, 4000, 2, 3);
+
+    check_vertical_merge(&tablet);
+
+    // rows filtered by delete conditions are merged row by row
+    ASSERT_EQ(OLAP_SUCCESS, tablet.delete_version({TestTablet::condition("k1", "<<", {"100"})}));
+    vector<string> rows;
+    uint32_t num_segments = 0;
+    vector<uint32_t> selectivities;
+    merge(&tablet, 2, false, 200, &rows, &num_segments, &selectivities);
+    EXPECT_EQ(3400u, rows.size());
+}
+
+// Rows with equal key in and across versions are kept in the order of versions.
+TEST_F(VerticalMergeTest, DupKeys) {
+    TestTablet tablet(50005, TKeysType::DUP_KEYS);
+    tablet.add_column("k1", TPrimitiveType::INT, true);
+    tablet.add_column("v1", TPrimitiveType::INT, false);
+    tablet.add_column("v2", TPrimitiveType::VARCHAR, false);
+    tablet.add_column("v3", TPrimitiveType::BIGINT, false);
+    tablet.add_column("v4", TPrimitiveType::INT, false);
+    tablet.add_column("v5", TPrimitiveType::BIGINT, false);
+    ASSERT_EQ(OLAP_SUCCESS, tablet.create());
+
+    // each k1 3 times in the first version and twice in the second one
+    for (int copies = 3; copies >= 2; --copies) {
+        vector<vector<string> > rows;
+        for (int i = 0; i < 3000; ++i) {
+            rows.push_back({std::to_string(i / copies),
+                            std::to_string(i),
+                            i % 11 == 0 ? "NULL" : "s" + std::to_string(i * copies),
+                            std::to_string(i % copies),
+                            std::to_string(copies),
+                            i % 7 == 0 ? "NULL" : std::to_string(-i)});
+        }
+        ASSERT_EQ(OLAP_SUCCESS, tablet.write_version(rows));
+    }
+
+    check_vertical_merge(&tablet);
+}
+
+} // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    palo::CpuInfo::init();
+    testing::InitGoogleTest(&argc, argv);
+
+    palo::config::storage_root_path = "./reader_test";
+    palo::remove_all_dir(palo::config::storage_root_path);
+    palo::create_dir(palo::config::storage_root_path);
+    palo::touch_all_singleton();
+
+    int ret = RUN_ALL_TESTS();
+    palo::remove_all_dir(palo::config::storage_root_path);
+    return ret;
+}
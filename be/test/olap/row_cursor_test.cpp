@@ -0,0 +1,121 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/row_cursor.h"
+
+#include <gtest/gtest.h>
+
+#include "util/logging.h"
+
+namespace palo {
+
+class RowCursorTest : public testing::Test {
+public:
+    void SetUp() {
+        add_field("k1", OLAP_FIELD_TYPE_INT, 4, true);
+        add_field("k2", OLAP_FIELD_TYPE_VARCHAR, 12, true);
+        add_field("k3", OLAP_FIELD_TYPE_DATETIME, 8, true);
+        add_field("v", OLAP_FIELD_TYPE_BIGINT, 8, false);
+    }
+
+    void add_field(const std::string& name, FieldType type, uint32_t length, bool is_key) {
+        FieldInfo field_info;
+        field_info.name = name;
+        field_info.type = type;
+        field_info.aggregation = is_key ? OLAP_FIELD_AGGREGATION_NONE : OLAP_FIELD_AGGREGATION_SUM;
+        field_info.length = length;
+        field_info.is_allow_null = true;
+        field_info.is_key = is_key;
+        field_info.precision = 0;
+        field_info.frac = 0;
+        field_info.unique_id = _schema.size();
+        field_info.is_bf_column = false;
+        field_info.is_blocked_bf = false;
+        _schema.push_back(field_info);
+    }
+
+    void init_row(RowCursor* row, const std::vector<std::string>& values) {
+        ASSERT_EQ(OLAP_SUCCESS, row->init(_schema));
+        ASSERT_EQ(OLAP_SUCCESS, row->from_string(values));
+    }
+
+    // the comparators picked by type must agree with Field::cmp
+    int field_cmp(const RowCursor& left, const RowCursor& right) {
+        for (size_t i = 0; i < 3; ++i) {
+            int res = left.get_field_by_index(i)->cmp(right.get_field_by_index(i));
+            if (res != 0) {
+                return res;
+            }
+        }
+        return 0;
+    }
+
+protected:
+    std::vector<FieldInfo> _schema;
+};
+
+TEST_F(RowCursorTest, Cmp) {
+    std::vector<std::vector<std::string>> rows = {
+        {"1", "a", "2017-10-01 00:00:00", "1"},
+        {"1", "ab", "2017-10-01 00:00:00", "2"},
+        {"1", "ab", "2017-10-02 00:00:00", "3"},
+        {"-2", "b", "2017-10-01 00:00:00", "4"},
+        {"1", "", "2017-10-01 00:00:00", "5"},
+        {"1", "a", "2017-10-01 00:00:00", "6"},
+    };
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        for (size_t j = 0; j < rows.size(); ++j) {
+            RowCursor left;
+            RowCursor right;
+            init_row(&left, rows[i]);
+            init_row(&right, rows[j]);
+            ASSERT_EQ(field_cmp(left, right), left.cmp(right)) << i << " " << j;
+            ASSERT_EQ(left.cmp(right), left.full_key_cmp(right)) << i << " " << j;
+        }
+    }
+
+    RowCursor first;
+    RowCursor second;
+    init_row(&first, rows[0]);
+    init_row(&second, rows[1]);
+    ASSERT_GT(0, first.cmp(second));
+    ASSERT_LT(0, second.cmp(first));
+    ASSERT_EQ(0, first.cmp(first));
+}
+
+TEST_F(RowCursorTest, CmpNull) {
+    RowCursor null_row;
+    RowCursor row;
+    init_row(&null_row, {"1", "a", "2017-10-01 00:00:00", "1"});
+    init_row(&row, {"-100", "a", "2017-10-01 00:00:00", "1"});
+    null_row.set_null(0);
+
+    // NULL is less than any value
+    ASSERT_GT(0, null_row.cmp(row));
+    ASSERT_LT(0, row.cmp(null_row));
+    ASSERT_EQ(field_cmp(null_row, row), null_row.cmp(row));
+
+    row.set_null(0);
+    ASSERT_EQ(0, null_row.cmp(row));
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -20,8 +20,10 @@
 #include "olap/column_file/in_stream.h"
 #include "olap/column_file/run_length_integer_writer.h"
 #include "olap/column_file/run_length_integer_reader.h"
+#include "olap/column_file/serialize.h"
 #include "olap/column_file/stream_index_writer.h"
 #include "olap/column_file/stream_index_reader.h"
+#include "util/cpu_info.h"
 #include "util/logging.h"
 
 namespace palo {
@@ -573,6 +575,78 @@ TEST_F(TestRunLengthUnsignInteger, ReadWriteMassInteger) {
 
 }
 
+TEST_F(TestRunLengthUnsignInteger, ReadWriteMassIntegerInBatch) {
+    // write data
+    for (int64_t i = 0; i < 100000; i++) {
+        ASSERT_EQ(OLAP_SUCCESS, _writer->write(i * 7));
+    }
+
+    ASSERT_EQ(OLAP_SUCCESS, _writer->flush());
+
+    // read data, batch size does not align to runs
+    CreateReader();
+
+    int64_t values[300];
+    for (int64_t i = 0; i < 100000; i += 300) {
+        uint64_t count = std::min(static_cast<int64_t>(300), 100000 - i);
+        ASSERT_EQ(OLAP_SUCCESS, _reader->next(values, count));
+        for (uint64_t j = 0; j < count; ++j) {
+            ASSERT_EQ(values[j], (i + j) * 7);
+        }
+    }
+
+    ASSERT_FALSE(_reader->has_next());
+    ASSERT_NE(OLAP_SUCCESS, _reader->next(values, 1));
+}
+
+// pack values in the same layout as ser::write_ints
+static void pack_ints(const int64_t* data, uint32_t count, uint32_t bit_width, char* output) {
+    uint64_t bit_pos = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        for (int32_t bit = bit_width - 1; bit >= 0; --bit, ++bit_pos) {
+            if ((static_cast<uint64_t>(data[i]) >> bit) & 1) {
+                output[bit_pos >> 3] |= (0x80 >> (bit_pos & 7));
+            }
+        }
+    }
+}
+
+TEST(TestUnpackInts, AllFixedBitWidth) {
+    const uint32_t count = 100;
+    int64_t data[count];
+    int64_t result[count];
+    char packed[count * sizeof(int64_t) + sizeof(uint64_t)];
+
+    // the first round uses SSE4.1 kernels if supported, the second one uses scalar kernels
+    bool sse_supported = palo::CpuInfo::is_supported(palo::CpuInfo::SSE4_1);
+    for (int round = 0; round < 2; ++round) {
+        if (1 == round) {
+            palo::CpuInfo::enable_feature(palo::CpuInfo::SSE4_1, false);
+        }
+
+        for (uint32_t fixed = ser::ONE; fixed <= ser::SIXTYFOUR; ++fixed) {
+            uint32_t bit_width = ser::decode_bit_width(fixed);
+            for (uint32_t i = 0; i < count; ++i) {
+                uint64_t value = 0x9E3779B97F4A7C15UL * (i + 1);
+                data[i] = bit_width == 64 ? value : value >> (64 - bit_width);
+            }
+
+            memset(packed, 0, sizeof(packed));
+            pack_ints(data, count, bit_width, packed);
+            memset(result, 0, sizeof(result));
+            ser::unpack_ints(packed, result, count, bit_width);
+
+            for (uint32_t i = 0; i < count; ++i) {
+                ASSERT_EQ(data[i], result[i]) << "bit_width=" << bit_width << " i=" << i;
+            }
+        }
+    }
+
+    if (sse_supported) {
+        palo::CpuInfo::enable_feature(palo::CpuInfo::SSE4_1, true);
+    }
+}
+
 TEST_F(TestRunLengthSignInteger, PatchedBaseEncoding1) { 
     // write data
     int64_t write_data[] = {1703, 6054, -876012345678912, 902, 9292, 184932,873624, 827364, 999, 8,
@@ -843,6 +917,7 @@ int main(int argc, char** argv) {
         return -1;
     }
     palo::init_glog("be-test");
+    palo::CpuInfo::init();
     int ret = palo::OLAP_SUCCESS;
     testing::InitGoogleTest(&argc, argv);
     ret = RUN_ALL_TESTS();
@@ -0,0 +1,251 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "olap/olap_main.cpp"
+#include "olap/test_tablet.h"
+#include "olap/utils.h"
+#include "util/cpu_info.h"
+#include "util/logging.h"
+
+using std::string;
+using std::vector;
+
+namespace palo {
+
+static const int NUM_ROWS = 1000;
+static const int ROWS_PER_BLOCK = 100;
+
+// A row of the test tablet: k1 is the key 0..999, v1 has 10 distinct values and is
+// NULL in every 13th row, v2 has 7 distinct values and v3 is 3 * k1.
+struct TestRow {
+    int k1;
+    bool v1_is_null;
+    int v1;
+    string v2;
+    int64_t v3;
+};
+
+class SegmentReaderTest : public testing::Test {
+public:
+    SegmentReaderTest() {}
+    ~SegmentReaderTest() {}
+
+protected:
+    virtual void SetUp() {
+        _late_materialization = config::enable_segment_late_materialization;
+        _bitmap_index_max_cardinality = config::bitmap_index_max_cardinality;
+        _rows_per_block = config::default_num_rows_per_column_file_block;
+        config::default_num_rows_per_column_file_block = ROWS_PER_BLOCK;
+
+        for (int i = 0; i < NUM_ROWS; ++i) {
+            TestRow row;
+            row.k1 = i;
+            row.v1_is_null = (i % 13 == 0);
+            row.v1 = i % 10;
+            row.v2 = "s" + std::to_string(i % 7);
+            row.v3 = 3 * i;
+            _rows.push_back(row);
+        }
+    }
+
+    virtual void TearDown() {
+        _tablet.reset();
+        config::enable_segment_late_materialization = _late_materialization;
+        config::bitmap_index_max_cardinality = _bitmap_index_max_cardinality;
+        config::default_num_rows_per_column_file_block = _rows_per_block;
+    }
+
+    static void add_columns(TestTablet* tablet) {
+        tablet->add_column("k1", TPrimitiveType::INT, true);
+        tablet->add_column("v1", TPrimitiveType::INT, false);
+        tablet->add_column("v2", TPrimitiveType::VARCHAR, false);
+        tablet->add_column("v3", TPrimitiveType::BIGINT, false);
+    }
+
+    // Writes all rows as one version into a DUP_KEYS tablet with blocks of
+    // ROWS_PER_BLOCK rows. Columns with at most 'bitmap_index_max_cardinality'
+    // distinct values get a bitmap index.
+    void create_tablet(int bitmap_index_max_cardinality) {
+        config::bitmap_index_max_cardinality = bitmap_index_max_cardinality;
+        _tablet.reset(new TestTablet(30001, TKeysType::DUP_KEYS));
+        add_columns(_tablet.get());
+        ASSERT_EQ(OLAP_SUCCESS, _tablet->create());
+
+        vector<vector<string> > rows;
+        for (const TestRow& row : _rows) {
+            rows.push_back({std::to_string(row.k1),
+                            row.v1_is_null ? "NULL" : std::to_string(row.v1),
+                            row.v2,
+                            std::to_string(row.v3)});
+        }
+        ASSERT_EQ(OLAP_SUCCESS, _tablet->write_version(rows));
+    }
+
+    // The rows accepted by 'pred' as printed by a scan of k1, v1, v2, v3, followed by
+    // 'suffix'.
+    vector<string> expected_rows(const std::function<bool(const TestRow&)>& pred,
+                                 const string& suffix = "") {
+        vector<string> result;
+        for (const TestRow& row : _rows) {
+            if (pred(row)) {
+                result.push_back(std::to_string(row.k1) + ","
+                        + (row.v1_is_null ? "NULL" : std::to_string(row.v1)) + ","
+                        + row.v2 + "," + std::to_string(row.v3) + suffix);
+            }
+        }
+        return result;
+    }
+
+    // Scans 'tablet' with and without late materialization, row by row and in batches,
+    // and checks that all of them return 'expected'.
+    void check_scan(const TestTablet& tablet, const vector<string>& fields,
+                    const vector<TCondition>& where, const vector<string>& expected) {
+        for (int late = 0; late < 2; ++late) {
+            for (int vectorized = 0; vectorized < 2; ++vectorized) {
+                SCOPED_TRACE(testing::Message() << "late materialization " << late
+                        << ", vectorized " << vectorized);
+                config::enable_segment_late_materialization = late;
+                vector<string> rows;
+                Status status = tablet.scan(fields, where, false, vectorized, &rows);
+                ASSERT_TRUE(status.ok()) << status.get_error_msg();
+                EXPECT_EQ(expected.size(), rows.size());
+                EXPECT_TRUE(expected == rows);
+            }
+        }
+    }
+
+    void check_scan(const vector<TCondition>& where, const vector<string>& expected) {
+        check_scan(*_tablet, {"k1", "v1", "v2", "v3"}, where, expected);
+    }
+
+    static TCondition condition(const string& column, const string& op,
+                                const vector<string>& values) {
+        return TestTablet::condition(column, op, values);
+    }
+
+    bool _late_materialization;
+    int32_t _bitmap_index_max_cardinality;
+    int32_t _rows_per_block;
+    vector<TestRow> _rows;
+    std::unique_ptr<TestTablet> _tablet;
+};
+
+// The min/max of every block admits the values, but no row has one of them.
+TEST_F(SegmentReaderTest, NoSelectedRows) {
+    create_tablet(0);
+    check_scan({condition("v3", "*=", {"1", "301", "601", "901"})}, {});
+    check_scan({condition("v3", "*=", {"1", "300", "601"})},
+               expected_rows([](const TestRow& row) { return row.v3 == 300; }));
+    // The rows of the first blocks match v2, the ones of the last blocks match v3.
+    check_scan({condition("v2", "=", {"s1"}), condition("v3", ">=", {"2400"})},
+               expected_rows([](const TestRow& row) {
+                   return row.v2 == "s1" && row.v3 >= 2400;
+               }));
+}
+
+// Every block has selected and filtered rows.
+TEST_F(SegmentReaderTest, PartiallySelectedBlocks) {
+    create_tablet(0);
+    check_scan({condition("v1", "=", {"3"})},
+               expected_rows([](const TestRow& row) {
+                   return !row.v1_is_null && row.v1 == 3;
+               }));
+    check_scan({condition("v1", "is", {"null"})},
+               expected_rows([](const TestRow& row) { return row.v1_is_null; }));
+    check_scan({condition("v2", "*=", {"s2", "s5"}), condition("v3", "<<", {"1500"})},
+               expected_rows([](const TestRow& row) {
+                   return (row.v2 == "s2" || row.v2 == "s5") && row.v3 < 1500;
+               }));
+    // Only the condition column is returned with k1.
+    vector<string> expected;
+    for (const TestRow& row : _rows) {
+        if (row.v2 == "s4") {
+            expected.push_back(std::to_string(row.k1) + "," + row.v2);
+        }
+    }
+    check_scan(*_tablet, {"k1", "v2"}, {condition("v2", "=", {"s4"})}, expected);
+}
+
+// Conditions on a column added by a schema change, whose reader returns its default
+// value and has no index in the old segments.
+TEST_F(SegmentReaderTest, DefaultValueColumn) {
+    create_tablet(0);
+    TestTablet new_tablet(30002, TKeysType::DUP_KEYS, 7654321);
+    add_columns(&new_tablet);
+    new_tablet.add_column("v4", TPrimitiveType::INT, false)->__set_default_value("5");
+    ASSERT_EQ(OLAP_SUCCESS, _tablet->schema_change(&new_tablet));
+
+    vector<string> fields = {"k1", "v1", "v2", "v3", "v4"};
+    check_scan(new_tablet, fields,
+               {condition("v4", "=", {"5"}), condition("v1", "=", {"3"})},
+               expected_rows([](const TestRow& row) {
+                   return !row.v1_is_null && row.v1 == 3;
+               }, ",5"));
+    check_scan(new_tablet, fields, {condition("v4", "=", {"6"})}, {});
+    check_scan(new_tablet, fields,
+               {condition("v4", ">=", {"5"}), condition("v3", ">>", {"2900"})},
+               expected_rows([](const TestRow& row) { return row.v3 > 2900; }, ",5"));
+    new_tablet.drop();
+}
+
+// Conditions answered by the bitmap indexes of v1 and v2 together with conditions
+// on v3, which has no bitmap index.
+TEST_F(SegmentReaderTest, BitmapIndexWithConditions) {
+    create_tablet(16);
+    check_scan({condition("v1", "*=", {"3", "4"}), condition("v3", ">=", {"1500"})},
+               expected_rows([](const TestRow& row) {
+                   return !row.v1_is_null && (row.v1 == 3 || row.v1 == 4) && row.v3 >= 1500;
+               }));
+    check_scan({condition("v1", "is", {"null"}), condition("v2", "=", {"s3"})},
+               expected_rows([](const TestRow& row) {
+                   return row.v1_is_null && row.v2 == "s3";
+               }));
+    check_scan({condition("v2", "=", {"s6"}), condition("v3", "<=", {"600"})},
+               expected_rows([](const TestRow& row) {
+                   return row.v2 == "s6" && row.v3 <= 600;
+               }));
+    // No row has both values.
+    check_scan({condition("v1", "=", {"1"}), condition("v3", "*=", {"6", "9"})}, {});
+}
+
+} // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    palo::CpuInfo::init();
+    testing::InitGoogleTest(&argc, argv);
+
+    palo::config::storage_root_path = "./segment_reader_test";
+    palo::remove_all_dir(palo::config::storage_root_path);
+    palo::create_dir(palo::config::storage_root_path);
+    palo::touch_all_singleton();
+
+    int ret = RUN_ALL_TESTS();
+    palo::remove_all_dir(palo::config::storage_root_path);
+    return ret;
+}
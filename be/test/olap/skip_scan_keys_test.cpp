@@ -0,0 +1,119 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/skip_scan_keys.h"
+
+#include <gtest/gtest.h>
+
+#include "util/logging.h"
+
+namespace palo {
+
+class SkipScanKeysTest : public testing::Test {
+public:
+    void SetUp() {
+        add_field("k1", OLAP_FIELD_TYPE_INT, OLAP_FIELD_AGGREGATION_NONE, true);
+        add_field("k2", OLAP_FIELD_TYPE_INT, OLAP_FIELD_AGGREGATION_NONE, true);
+        add_field("v", OLAP_FIELD_TYPE_BIGINT, OLAP_FIELD_AGGREGATION_SUM, false);
+    }
+
+    void add_field(const std::string& name, FieldType type,
+                   FieldAggregationMethod aggregation, bool is_key) {
+        FieldInfo field_info;
+        field_info.name = name;
+        field_info.type = type;
+        field_info.aggregation = aggregation;
+        field_info.length = type == OLAP_FIELD_TYPE_INT ? 4 : 8;
+        field_info.is_allow_null = false;
+        field_info.is_key = is_key;
+        field_info.precision = 0;
+        field_info.frac = 0;
+        field_info.unique_id = _schema.size();
+        field_info.is_bf_column = false;
+        field_info.is_blocked_bf = false;
+        _schema.push_back(field_info);
+    }
+
+    std::string current(const SkipScanKeys& keys) {
+        return keys.current()->to_string(",");
+    }
+
+    bool seek(SkipScanKeys* keys, const std::vector<std::string>& row_strings) {
+        RowCursor row;
+        EXPECT_EQ(OLAP_SUCCESS, row.init(_schema));
+        std::vector<std::string> values = row_strings;
+        values.push_back("0");
+        EXPECT_EQ(OLAP_SUCCESS, row.from_string(values));
+        return keys->seek(row);
+    }
+
+protected:
+    std::vector<FieldInfo> _schema;
+};
+
+TEST_F(SkipScanKeysTest, Next) {
+    SkipScanKeys keys;
+    // values are sorted by the storage order of the column
+    ASSERT_EQ(OLAP_SUCCESS, keys.init(_schema, {{"3", "1"}, {"20", "10", "-5"}}));
+    ASSERT_EQ(2, keys.num_columns());
+    ASSERT_EQ("1,-5", current(keys));
+    ASSERT_TRUE(keys.next());
+    ASSERT_EQ("1,10", current(keys));
+    ASSERT_TRUE(keys.next());
+    ASSERT_EQ("1,20", current(keys));
+    ASSERT_TRUE(keys.next());
+    ASSERT_EQ("3,-5", current(keys));
+    ASSERT_TRUE(keys.next());
+    ASSERT_TRUE(keys.next());
+    ASSERT_EQ("3,20", current(keys));
+    ASSERT_FALSE(keys.next());
+    ASSERT_FALSE(keys.next());
+}
+
+TEST_F(SkipScanKeysTest, Seek) {
+    SkipScanKeys keys;
+    ASSERT_EQ(OLAP_SUCCESS, keys.init(_schema, {{"1", "3", "5"}, {"10", "20"}}));
+
+    // the combination of the row
+    ASSERT_TRUE(seek(&keys, {"1", "20"}));
+    ASSERT_EQ("1,20", current(keys));
+    // the next value of the second column
+    ASSERT_TRUE(seek(&keys, {"3", "15"}));
+    ASSERT_EQ("3,20", current(keys));
+    // no value of the first column, starts from the first value of the second column
+    ASSERT_TRUE(seek(&keys, {"4", "30"}));
+    ASSERT_EQ("5,10", current(keys));
+    // carry to the first column
+    ASSERT_TRUE(seek(&keys, {"3", "25"}));
+    ASSERT_EQ("5,10", current(keys));
+    // beyond the last combination
+    ASSERT_FALSE(seek(&keys, {"5", "21"}));
+    ASSERT_FALSE(keys.next());
+}
+
+TEST_F(SkipScanKeysTest, InvalidValues) {
+    SkipScanKeys keys;
+    ASSERT_NE(OLAP_SUCCESS, keys.init(_schema, {}));
+    SkipScanKeys empty_column;
+    ASSERT_NE(OLAP_SUCCESS, empty_column.init(_schema, {{"1"}, {}}));
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
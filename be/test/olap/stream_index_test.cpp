@@ -383,6 +383,86 @@ TEST_F(TestStreamIndex, statistic) {
     }
 }
 
+TEST_F(TestStreamIndex, statistic_with_null_count) {
+    StreamIndexWriter writer(OLAP_FIELD_TYPE_INT);
+    PositionEntryWriter entry;
+    ColumnStatistics stat;
+
+    ASSERT_EQ(OLAP_SUCCESS, stat.init(OLAP_FIELD_TYPE_INT, true, true));
+    ASSERT_TRUE(stat.has_null_count());
+
+    Field* field = Field::create_by_type(OLAP_FIELD_TYPE_INT);
+    ASSERT_TRUE(NULL != field);
+    ASSERT_TRUE(field->allocate());
+
+    // entry 0: 3, NULL, 7
+    entry.add_position(0);
+    field->set_not_null();
+    field->from_string("3");
+    stat.add(field);
+    field->set_null();
+    stat.add(field);
+    field->set_not_null();
+    field->from_string("7");
+    stat.add(field);
+    ASSERT_EQ(1U, stat.null_count());
+    ASSERT_FALSE(stat.minimum()->is_null());
+    entry.set_statistic(&stat);
+    writer.add_index_entry(entry);
+    entry.reset_write_offset();
+    stat.reset();
+
+    // entry 1: NULL, NULL
+    entry.add_position(1);
+    field->set_null();
+    stat.add(field);
+    stat.add(field);
+    entry.set_statistic(&stat);
+    writer.add_index_entry(entry);
+    entry.reset_write_offset();
+    stat.reset();
+
+    // entry 2: 10
+    entry.add_position(2);
+    field->set_not_null();
+    field->from_string("10");
+    stat.add(field);
+    entry.set_statistic(&stat);
+    writer.add_index_entry(entry);
+    entry.reset_write_offset();
+
+    size_t output_size = sizeof(StreamIndexHeader)
+                         + 3 * (sizeof(uint32_t) + (1 + sizeof(int32_t)) * 2 + sizeof(uint32_t));
+    ASSERT_EQ(output_size, writer.output_size());
+
+    char* buffer = new char[output_size];
+    ASSERT_EQ(OLAP_SUCCESS, writer.write_to_buffer(buffer, output_size));
+
+    StreamIndexReader reader;
+    ASSERT_EQ(OLAP_SUCCESS, reader.init(buffer, output_size, OLAP_FIELD_TYPE_INT, true, true));
+    ASSERT_EQ(3U, reader.entry_count());
+
+    const PositionEntryReader& e0 = reader.entry(0);
+    ASSERT_TRUE(e0.column_statistic().has_null_count());
+    ASSERT_EQ(1U, e0.column_statistic().null_count());
+    ASSERT_STREQ("3", e0.column_statistic().minimum()->to_string().c_str());
+    ASSERT_STREQ("7", e0.column_statistic().maximum()->to_string().c_str());
+    ASSERT_FALSE(e0.all_null());
+
+    const PositionEntryReader& e1 = reader.entry(1);
+    ASSERT_EQ(1, e1.positions(0));
+    ASSERT_EQ(2U, e1.column_statistic().null_count());
+    ASSERT_TRUE(e1.all_null());
+
+    const PositionEntryReader& e2 = reader.entry(2);
+    ASSERT_EQ(0U, e2.column_statistic().null_count());
+    ASSERT_STREQ("10", e2.column_statistic().minimum()->to_string().c_str());
+    ASSERT_FALSE(e2.all_null());
+
+    delete [] buffer;
+    delete field;
+}
+
 }
 }
 
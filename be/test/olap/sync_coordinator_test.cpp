@@ -0,0 +1,108 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "olap/sync_coordinator.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+
+#include "olap/file_helper.h"
+
+namespace palo {
+
+class SyncCoordinatorTest : public testing::Test {
+public:
+    static void SetUpTestCase() {
+        boost::filesystem::remove_all(_s_test_data_path);
+        ASSERT_TRUE(boost::filesystem::create_directory(_s_test_data_path));
+        SyncCoordinator::add_path(_s_test_data_path + "/");
+    }
+
+    static void TearDownTestCase() {
+        boost::filesystem::remove_all(_s_test_data_path);
+    }
+
+    static std::string _s_test_data_path;
+};
+
+std::string SyncCoordinatorTest::_s_test_data_path = "./sync_coordinator_test_data";
+
+TEST_F(SyncCoordinatorTest, Find) {
+    SyncCoordinator* coordinator = SyncCoordinator::find(_s_test_data_path + "/a/b");
+    ASSERT_TRUE(coordinator != NULL);
+    ASSERT_EQ(_s_test_data_path, coordinator->path());
+    ASSERT_TRUE(SyncCoordinator::find(_s_test_data_path + "x/a") == NULL);
+
+    SyncCoordinator::add_path(_s_test_data_path + "/a");
+    ASSERT_EQ(_s_test_data_path + "/a",
+              SyncCoordinator::find(_s_test_data_path + "/a/b")->path());
+    ASSERT_EQ(coordinator, SyncCoordinator::find(_s_test_data_path + "/b"));
+}
+
+TEST_F(SyncCoordinatorTest, ConcurrentWriters) {
+    SyncCoordinator* coordinator = SyncCoordinator::find(_s_test_data_path + "/c");
+    ASSERT_TRUE(coordinator != NULL);
+    int64_t groups_before = coordinator->num_groups();
+
+    const int num_threads = 8;
+    const int files_per_thread = 16;
+    std::vector<int> failures(num_threads, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([t, &failures]() {
+            for (int i = 0; i < files_per_thread; ++i) {
+                std::string file_name = _s_test_data_path + "/c_"
+                        + std::to_string(t) + "_" + std::to_string(i);
+                FileHandler file_handler;
+                std::string data(4096, 'a' + i);
+                if (file_handler.open_with_mode(file_name,
+                        O_CREAT | O_TRUNC | O_WRONLY, S_IRUSR | S_IWUSR) != OLAP_SUCCESS
+                        || file_handler.write(data.data(), data.size()) != OLAP_SUCCESS
+                        || file_handler.close() != OLAP_SUCCESS) {
+                    ++failures[t];
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    for (int t = 0; t < num_threads; ++t) {
+        ASSERT_EQ(0, failures[t]);
+        for (int i = 0; i < files_per_thread; ++i) {
+            std::string file_name = _s_test_data_path + "/c_"
+                    + std::to_string(t) + "_" + std::to_string(i);
+            ASSERT_EQ(4096, boost::filesystem::file_size(file_name));
+        }
+    }
+    int64_t groups = coordinator->num_groups() - groups_before;
+    ASSERT_GT(groups, 0);
+    ASSERT_LE(groups, num_threads * files_per_thread);
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
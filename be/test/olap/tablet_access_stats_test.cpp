@@ -0,0 +1,75 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#include "olap/tablet_access_stats.h"
+
+#include <gtest/gtest.h>
+
+namespace palo {
+
+class TabletAccessStatsTest : public testing::Test {
+};
+
+TEST_F(TabletAccessStatsTest, Decay) {
+    TabletAccessStats stats;
+    stats.add_scan(100, 1000);
+    stats.add_scan(50, 3000);
+    stats.add_read_bytes(4096);
+    ASSERT_EQ(2, stats.scans());
+    ASSERT_EQ(150, stats.rows());
+    ASSERT_EQ(4096, stats.read_bytes());
+    ASSERT_EQ(4000, stats.scan_time_ns());
+    ASSERT_EQ(0, stats.row_rate());
+
+    stats.decay(0.5);
+    ASSERT_DOUBLE_EQ(2, stats.scan_rate());
+    ASSERT_DOUBLE_EQ(150, stats.row_rate());
+    ASSERT_DOUBLE_EQ(4096, stats.read_bytes_rate());
+
+    // only the counts since the last decay are added
+    stats.add_scan(10, 1000);
+    stats.decay(0.5);
+    ASSERT_DOUBLE_EQ(2, stats.scan_rate());
+    ASSERT_DOUBLE_EQ(85, stats.row_rate());
+    ASSERT_DOUBLE_EQ(2048, stats.read_bytes_rate());
+    // the totals are not decayed
+    ASSERT_EQ(160, stats.rows());
+}
+
+TEST_F(TabletAccessStatsTest, ScopedReadBytes) {
+    TabletAccessStats outer_stats;
+    TabletAccessStats inner_stats;
+    int64_t outer_bytes = 0;
+    TabletAccessStats::record_read_bytes(10);
+    {
+        TabletAccessStats::ScopedReadBytes outer(&outer_stats, &outer_bytes);
+        TabletAccessStats::record_read_bytes(10);
+        {
+            TabletAccessStats::ScopedReadBytes inner(&inner_stats, NULL);
+            TabletAccessStats::record_read_bytes(20);
+        }
+        TabletAccessStats::record_read_bytes(30);
+    }
+    TabletAccessStats::record_read_bytes(10);
+    ASSERT_EQ(40, outer_stats.read_bytes());
+    ASSERT_EQ(40, outer_bytes);
+    ASSERT_EQ(20, inner_stats.read_bytes());
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
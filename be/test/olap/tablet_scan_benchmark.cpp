@@ -0,0 +1,566 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+// End-to-end benchmark of tablet scans.
+//
+// It creates a synthetic tablet through the real writer, one delta per version plus
+// optional delete versions, and scans it through OLAPReader, the reader OlapScanner
+// runs for every scan range, with the given predicates and projection. It reports the
+// scanned rows per second, the raw rows read, the on-disk size of the tablet and the
+// per-stage times of the reader profile. Run it by hand, e.g.
+//
+//     tablet_scan_benchmark --keys_type=agg --versions=20 --key_distribution=random \
+//         --delete_every=5 --where=k0:>=:1000 --columns=k0,v0
+//
+// Options:
+//     --storage_type=column|row          storage type of the tablet (column)
+//     --keys_type=agg|unique|dup         keys type of the tablet (agg)
+//     --key_columns=N                    number of BIGINT key columns (2)
+//     --value_columns=N                  number of BIGINT value columns (2)
+//     --varchar_columns=N                number of VARCHAR value columns (1)
+//     --rows_per_version=N               rows written per version (100000)
+//     --versions=N                       number of data versions (10)
+//     --key_distribution=sequential|random|skewed
+//                                        sequential writes disjoint key ranges per
+//                                        version, random and skewed overlap (random)
+//     --delete_every=N                   add a delete version every N data versions (0)
+//     --where=column:op:value            storage condition, may be repeated, op is
+//                                        one of << >> <= >= *= != (none)
+//     --columns=c1,c2,...                returned columns (all)
+//     --aggregation=true|false           merge rows of the same key (true)
+//     --vectorized=true|false            use the batch interface when supported (true)
+//     --iterations=N                     number of scans (5)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "common/object_pool.h"
+#include "gen_cpp/AgentService_types.h"
+#include "gen_cpp/Descriptors_types.h"
+#include "gen_cpp/PaloInternalService_types.h"
+#include "olap/command_executor.h"
+#include "olap/olap_main.cpp"
+#include "olap/olap_reader.h"
+#include "olap/row_cursor.h"
+#include "olap/writer.h"
+#include "runtime/descriptors.h"
+#include "runtime/primitive_type.h"
+#include "runtime/string_value.h"
+#include "runtime/tuple.h"
+#include "runtime/vectorized_row_batch.h"
+#include "util/cpu_info.h"
+#include "util/logging.h"
+#include "util/runtime_profile.h"
+#include "util/stopwatch.hpp"
+
+namespace palo {
+
+static const TTabletId TABLET_ID = 20001;
+static const TSchemaHash SCHEMA_HASH = 1234567;
+static const int VARCHAR_LEN = 32;
+static const int BATCH_SIZE = 1024;
+
+#define CHECK_OLAP(stmt) \
+    do { \
+        OLAPStatus _res = (stmt); \
+        if (_res != OLAP_SUCCESS) { \
+            std::cerr << #stmt << " failed: " << _res << std::endl; \
+            exit(1); \
+        } \
+    } while (false)
+
+#define CHECK_STATUS(stmt) \
+    do { \
+        Status _status = (stmt); \
+        if (!_status.ok()) { \
+            std::cerr << #stmt << " failed: " << _status.get_error_msg() << std::endl; \
+            exit(1); \
+        } \
+    } while (false)
+
+struct BenchmarkOptions {
+    TStorageType::type storage_type = TStorageType::COLUMN;
+    TKeysType::type keys_type = TKeysType::AGG_KEYS;
+    int key_columns = 2;
+    int value_columns = 2;
+    int varchar_columns = 1;
+    int64_t rows_per_version = 100000;
+    int versions = 10;
+    std::string key_distribution = "random";
+    int delete_every = 0;
+    std::vector<TCondition> where;
+    std::vector<std::string> columns;
+    bool aggregation = true;
+    bool vectorized = true;
+    int iterations = 5;
+};
+
+static std::vector<std::string> split(const std::string& str, char sep) {
+    std::vector<std::string> parts;
+    std::stringstream ss(str);
+    std::string part;
+    while (std::getline(ss, part, sep)) {
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+static bool parse_option(const std::string& arg, BenchmarkOptions* options) {
+    size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) {
+        return false;
+    }
+    std::string key = arg.substr(2, eq - 2);
+    std::string value = arg.substr(eq + 1);
+    if (key == "storage_type") {
+        options->storage_type = value == "row" ? TStorageType::ROW : TStorageType::COLUMN;
+    } else if (key == "keys_type") {
+        if (value == "dup") {
+            options->keys_type = TKeysType::DUP_KEYS;
+        } else if (value == "unique") {
+            options->keys_type = TKeysType::UNIQUE_KEYS;
+        } else {
+            options->keys_type = TKeysType::AGG_KEYS;
+        }
+    } else if (key == "key_columns") {
+        options->key_columns = std::max(1, atoi(value.c_str()));
+    } else if (key == "value_columns") {
+        options->value_columns = std::max(0, atoi(value.c_str()));
+    } else if (key == "varchar_columns") {
+        options->varchar_columns = std::max(0, atoi(value.c_str()));
+    } else if (key == "rows_per_version") {
+        options->rows_per_version = std::max(1L, atol(value.c_str()));
+    } else if (key == "versions") {
+        options->versions = std::max(1, atoi(value.c_str()));
+    } else if (key == "key_distribution") {
+        options->key_distribution = value;
+    } else if (key == "delete_every") {
+        options->delete_every = std::max(0, atoi(value.c_str()));
+    } else if (key == "where") {
+        std::vector<std::string> parts = split(value, ':');
+        if (parts.size() != 3) {
+            return false;
+        }
+        TCondition condition;
+        condition.column_name = parts[0];
+        condition.condition_op = parts[1];
+        condition.condition_values = split(parts[2], ',');
+        options->where.push_back(condition);
+    } else if (key == "columns") {
+        options->columns = split(value, ',');
+    } else if (key == "aggregation") {
+        options->aggregation = value == "true";
+    } else if (key == "vectorized") {
+        options->vectorized = value == "true";
+    } else if (key == "iterations") {
+        options->iterations = std::max(1, atoi(value.c_str()));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// The column layout of the synthetic tablet: key columns k0.., BIGINT value
+// columns v0.. and VARCHAR value columns s0...
+class SyntheticTablet {
+public:
+    explicit SyntheticTablet(const BenchmarkOptions& options) :
+            _options(options), _rng(42), _next_version(2) {
+        for (int i = 0; i < options.key_columns; ++i) {
+            _columns.push_back(column("k" + std::to_string(i), TPrimitiveType::BIGINT, true));
+        }
+        for (int i = 0; i < options.value_columns; ++i) {
+            _columns.push_back(column("v" + std::to_string(i), TPrimitiveType::BIGINT, false));
+        }
+        for (int i = 0; i < options.varchar_columns; ++i) {
+            _columns.push_back(column("s" + std::to_string(i), TPrimitiveType::VARCHAR, false));
+        }
+    }
+
+    const std::vector<TColumn>& columns() const {
+        return _columns;
+    }
+
+    SmartOLAPTable table() const {
+        return _table;
+    }
+
+    void create() {
+        TCreateTabletReq request;
+        request.tablet_id = TABLET_ID;
+        request.__set_version(1);
+        request.__set_version_hash(0);
+        request.tablet_schema.schema_hash = SCHEMA_HASH;
+        request.tablet_schema.short_key_column_count = _options.key_columns;
+        request.tablet_schema.keys_type = _options.keys_type;
+        request.tablet_schema.storage_type = _options.storage_type;
+        request.tablet_schema.columns = _columns;
+        CommandExecutor executor;
+        CHECK_OLAP(executor.create_table(request));
+        _table = executor.get_table(TABLET_ID, SCHEMA_HASH);
+        if (_table.get() == NULL) {
+            std::cerr << "failed to get the created tablet" << std::endl;
+            exit(1);
+        }
+    }
+
+    void load() {
+        for (int i = 0; i < _options.versions; ++i) {
+            write_version(i);
+            if (_options.delete_every > 0 && (i + 1) % _options.delete_every == 0) {
+                delete_version(i);
+            }
+        }
+    }
+
+    void drop() {
+        if (_table.get() != NULL) {
+            _table.reset();
+            OLAPEngine::get_instance()->drop_table(TABLET_ID, SCHEMA_HASH);
+        }
+    }
+
+private:
+    TColumn column(const std::string& name, TPrimitiveType::type type, bool is_key) {
+        TColumn column;
+        column.column_name = name;
+        column.column_type.type = type;
+        if (type == TPrimitiveType::VARCHAR) {
+            column.column_type.__set_len(VARCHAR_LEN);
+        }
+        if (!is_key) {
+            if (_options.keys_type == TKeysType::DUP_KEYS) {
+                column.__set_aggregation_type(TAggregationType::NONE);
+            } else if (_options.keys_type == TKeysType::UNIQUE_KEYS
+                    || type == TPrimitiveType::VARCHAR) {
+                column.__set_aggregation_type(TAggregationType::REPLACE);
+            } else {
+                column.__set_aggregation_type(TAggregationType::SUM);
+            }
+        }
+        return column;
+    }
+
+    // The first key of every row of the 'index'th data version, sorted.
+    std::vector<int64_t> generate_keys(int index) {
+        int64_t rows = _options.rows_per_version;
+        int64_t key_space = rows * _options.versions;
+        std::vector<int64_t> keys(rows);
+        if (_options.key_distribution == "sequential") {
+            for (int64_t i = 0; i < rows; ++i) {
+                keys[i] = index * rows + i;
+            }
+        } else if (_options.key_distribution == "skewed") {
+            // most rows hit a few hot keys, the rest spread over the key space
+            std::geometric_distribution<int64_t> hot(0.01);
+            std::uniform_int_distribution<int64_t> cold(0, key_space - 1);
+            std::uniform_int_distribution<int> coin(0, 9);
+            for (int64_t i = 0; i < rows; ++i) {
+                keys[i] = coin(_rng) < 8 ? hot(_rng) : cold(_rng);
+            }
+        } else {
+            std::uniform_int_distribution<int64_t> uniform(0, key_space - 1);
+            for (int64_t i = 0; i < rows; ++i) {
+                keys[i] = uniform(_rng);
+            }
+        }
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    }
+
+    // Writes a delta the way the push handler does.
+    void write_version(int index) {
+        int64_t version = _next_version++;
+        OLAPIndex* olap_index = new OLAPIndex(
+                _table.get(), Version(version, version), version, false, 0, 0);
+        std::unique_ptr<IWriter> writer(IWriter::create(_table, olap_index, true));
+        if (writer.get() == NULL) {
+            std::cerr << "failed to create the writer" << std::endl;
+            exit(1);
+        }
+        CHECK_OLAP(writer->init());
+        RowCursor row;
+        CHECK_OLAP(row.init(_table->tablet_schema()));
+
+        std::vector<int64_t> keys = generate_keys(index);
+        std::vector<std::string> values(_columns.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            int64_t key = keys[i];
+            // the remaining key columns derive from the first one, so rows with the
+            // same first key have the same full key and get merged
+            for (int c = 0; c < _options.key_columns; ++c) {
+                values[c] = std::to_string(c == 0 ? key : key % (c * 100 + 7));
+            }
+            for (int c = 0; c < _options.value_columns; ++c) {
+                values[_options.key_columns + c] = std::to_string(version * (c + 1) + i % 1000);
+            }
+            for (int c = 0; c < _options.varchar_columns; ++c) {
+                values[_options.key_columns + _options.value_columns + c] =
+                    "value_" + std::to_string((key * 31 + c) % 100000);
+            }
+            CHECK_OLAP(writer->attached_by(&row));
+            CHECK_OLAP(row.from_string(values));
+            writer->next(row);
+        }
+        CHECK_OLAP(writer->finalize());
+        CHECK_OLAP(olap_index->load());
+
+        std::vector<Version> unused_versions;
+        std::vector<OLAPIndex*> new_indices(1, olap_index);
+        std::vector<OLAPIndex*> unused_indices;
+        _table->obtain_push_lock();
+        _table->obtain_header_wrlock();
+        OLAPStatus res = _table->replace_data_sources(
+                &unused_versions, &new_indices, &unused_indices);
+        if (res == OLAP_SUCCESS) {
+            res = _table->save_header();
+        }
+        _table->release_header_lock();
+        _table->release_push_lock();
+        CHECK_OLAP(res);
+    }
+
+    // Deletes the lowest keys of the written versions, a tenth of a version's rows.
+    void delete_version(int index) {
+        TPushReq request;
+        request.tablet_id = TABLET_ID;
+        request.schema_hash = SCHEMA_HASH;
+        request.version = _next_version++;
+        request.version_hash = request.version;
+        request.timeout = 86400;
+        request.push_type = TPushType::DELETE;
+        TCondition condition;
+        condition.column_name = "k0";
+        condition.condition_op = "<";
+        condition.condition_values.push_back(
+                std::to_string((index + 1) * _options.rows_per_version / 10));
+        request.__set_delete_conditions(std::vector<TCondition>(1, condition));
+
+        std::vector<TTabletInfo> tablet_infos;
+        CommandExecutor executor;
+        CHECK_OLAP(executor.delete_data(request, &tablet_infos));
+    }
+
+    const BenchmarkOptions& _options;
+    std::vector<TColumn> _columns;
+    std::mt19937_64 _rng;
+    int64_t _next_version;
+    SmartOLAPTable _table;
+};
+
+// Builds the tuple of the returned columns, in their order.
+static TupleDescriptor* create_tuple_desc(
+        const SyntheticTablet& tablet, const std::vector<std::string>& fields,
+        ObjectPool* obj_pool) {
+    TDescriptorTable t_desc_table;
+    TTableDescriptor t_table_desc;
+    t_table_desc.id = 0;
+    t_table_desc.tableType = TTableType::OLAP_TABLE;
+    t_table_desc.numCols = 0;
+    t_table_desc.numClusteringCols = 0;
+    t_table_desc.olapTable.tableName = "";
+    t_table_desc.tableName = "";
+    t_table_desc.dbName = "";
+    t_table_desc.__isset.mysqlTable = true;
+    t_desc_table.tableDescriptors.push_back(t_table_desc);
+    t_desc_table.__isset.tableDescriptors = true;
+
+    int offset = 1;
+    for (int i = 0; i < fields.size(); ++i) {
+        TPrimitiveType::type type = TPrimitiveType::BIGINT;
+        for (const TColumn& column : tablet.columns()) {
+            if (column.column_name == fields[i]) {
+                type = column.column_type.type;
+            }
+        }
+        TSlotDescriptor t_slot_desc;
+        t_slot_desc.__set_id(i);
+        t_slot_desc.__set_slotType(gen_type_desc(type));
+        t_slot_desc.__set_columnPos(i);
+        t_slot_desc.__set_byteOffset(offset);
+        t_slot_desc.__set_nullIndicatorByte(0);
+        t_slot_desc.__set_nullIndicatorBit(-1);
+        t_slot_desc.__set_slotIdx(i);
+        t_slot_desc.__set_isMaterialized(true);
+        t_slot_desc.__set_colName(fields[i]);
+        t_desc_table.slotDescriptors.push_back(t_slot_desc);
+        offset += type == TPrimitiveType::VARCHAR ? sizeof(StringValue) : sizeof(int64_t);
+    }
+    t_desc_table.__isset.slotDescriptors = true;
+
+    TTupleDescriptor t_tuple_desc;
+    t_tuple_desc.id = 0;
+    t_tuple_desc.byteSize = offset;
+    t_tuple_desc.numNullBytes = 1;
+    t_tuple_desc.tableId = 0;
+    t_tuple_desc.__isset.tableId = true;
+    t_desc_table.tupleDescriptors.push_back(t_tuple_desc);
+
+    DescriptorTbl* desc_tbl = NULL;
+    CHECK_STATUS(DescriptorTbl::create(obj_pool, t_desc_table, &desc_tbl));
+    return desc_tbl->get_tuple_descriptor(0);
+}
+
+struct ScanResult {
+    int64_t rows = 0;
+    int64_t raw_rows = 0;
+    bool vectorized = false;
+};
+
+static ScanResult scan(const BenchmarkOptions& options, const SyntheticTablet& tablet,
+                       const std::vector<std::string>& fields,
+                       const TupleDescriptor& tuple_desc, RuntimeProfile* profile) {
+    const FileVersionMessage* latest = tablet.table()->latest_version();
+    TFetchRequest request;
+    request.__set_use_compression(false);
+    request.__set_schema_hash(SCHEMA_HASH);
+    request.__set_tablet_id(TABLET_ID);
+    request.__set_version(latest->end_version());
+    request.__set_version_hash(latest->version_hash());
+    request.__set_aggregation(options.aggregation);
+    request.__set_field(fields);
+    request.__set_where(options.where);
+
+    ScanResult result;
+    OLAPReader reader(tuple_desc);
+    CHECK_STATUS(reader.init(request, NULL, profile));
+
+    int tuple_size = tuple_desc.byte_size();
+    std::vector<char> tuple_buf(tuple_size * BATCH_SIZE);
+    bool eof = false;
+    if (options.vectorized && reader.is_vectorized_supported()) {
+        result.vectorized = true;
+        std::unique_ptr<VectorizedRowBatch> batch(
+                reader.create_vectorized_row_batch(BATCH_SIZE));
+        while (!eof) {
+            batch->reset();
+            CHECK_STATUS(reader.next_batch(batch.get(), &result.raw_rows, &eof));
+            if (batch->size() == 0) {
+                continue;
+            }
+            memset(tuple_buf.data(), 0, tuple_size * batch->size());
+            CHECK_STATUS(reader.convert_batch_to_tuples(
+                    batch.get(), reinterpret_cast<Tuple*>(tuple_buf.data())));
+            result.rows += batch->size();
+        }
+    } else {
+        Tuple* tuple = reinterpret_cast<Tuple*>(tuple_buf.data());
+        while (true) {
+            memset(tuple_buf.data(), 0, tuple_size);
+            CHECK_STATUS(reader.next_tuple(tuple, &result.raw_rows, &eof));
+            if (eof) {
+                break;
+            }
+            ++result.rows;
+        }
+    }
+    CHECK_STATUS(reader.close());
+    return result;
+}
+
+static int run(const BenchmarkOptions& options) {
+    SyntheticTablet tablet(options);
+    tablet.create();
+
+    MonotonicStopWatch load_watch;
+    load_watch.start();
+    tablet.load();
+    std::cout << "loaded " << options.versions << " versions of "
+        << options.rows_per_version << " rows in "
+        << load_watch.elapsed_time() / 1000000 << " ms, tablet data size "
+        << tablet.table()->get_data_size() << " bytes, "
+        << tablet.table()->get_num_rows() << " rows" << std::endl;
+
+    std::vector<std::string> fields = options.columns;
+    if (fields.empty()) {
+        for (const TColumn& column : tablet.columns()) {
+            fields.push_back(column.column_name);
+        }
+    }
+    ObjectPool obj_pool;
+    TupleDescriptor* tuple_desc = create_tuple_desc(tablet, fields, &obj_pool);
+    RuntimeProfile* profile = obj_pool.add(new RuntimeProfile(&obj_pool, "OlapScanner"));
+    OLAPReader::init_profile(profile);
+
+    std::cout << std::left << std::setw(10) << "iteration"
+        << std::right << std::setw(12) << "ms"
+        << std::setw(14) << "rows"
+        << std::setw(14) << "raw rows"
+        << std::setw(14) << "rows/s"
+        << std::setw(14) << "disk MB/s" << std::endl;
+    int64_t data_size = tablet.table()->get_data_size();
+    bool vectorized = false;
+    for (int i = 0; i < options.iterations; ++i) {
+        MonotonicStopWatch watch;
+        watch.start();
+        ScanResult result = scan(options, tablet, fields, *tuple_desc, profile);
+        double seconds = watch.elapsed_time() / 1e9;
+        vectorized = result.vectorized;
+        std::cout << std::left << std::setw(10) << i
+            << std::right << std::fixed << std::setprecision(1)
+            << std::setw(12) << seconds * 1000
+            << std::setw(14) << result.rows
+            << std::setw(14) << result.raw_rows
+            << std::setprecision(0) << std::setw(14) << result.rows / seconds
+            << std::setprecision(1) << std::setw(14) << data_size / seconds / (1 << 20)
+            << std::endl;
+    }
+    std::cout << (vectorized ? "vectorized" : "row by row") << " reads, profile of all "
+        << options.iterations << " iterations:" << std::endl;
+    profile->pretty_print(&std::cout);
+
+    tablet.drop();
+    return 0;
+}
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    palo::BenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (!palo::parse_option(argv[i], &options)) {
+            std::cerr << "invalid option " << argv[i]
+                << ", see the head of tablet_scan_benchmark.cpp" << std::endl;
+            return -1;
+        }
+    }
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-benchmark");
+    palo::CpuInfo::init();
+
+    palo::config::storage_root_path = "./tablet_scan_benchmark";
+    system("rm -rf ./tablet_scan_benchmark");
+    palo::create_dir(palo::config::storage_root_path);
+    palo::touch_all_singleton();
+
+    int ret = palo::run(options);
+    system("rm -rf ./tablet_scan_benchmark");
+    return ret;
+}
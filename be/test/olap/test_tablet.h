@@ -0,0 +1,502 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#ifndef BDG_PALO_BE_TEST_OLAP_TEST_TABLET_H
+#define BDG_PALO_BE_TEST_OLAP_TEST_TABLET_H
+
+#include <string.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/object_pool.h"
+#include "exec/exec_node.h"
+#include "exprs/expr.h"
+#include "exprs/expr_context.h"
+#include "gen_cpp/AgentService_types.h"
+#include "gen_cpp/Descriptors_types.h"
+#include "gen_cpp/PaloInternalService_types.h"
+#include "olap/command_executor.h"
+#include "olap/olap_engine.h"
+#include "olap/olap_index.h"
+#include "olap/olap_reader.h"
+#include "olap/olap_table.h"
+#include "olap/row_cursor.h"
+#include "olap/writer.h"
+#include "runtime/descriptors.h"
+#include "runtime/mem_tracker.h"
+#include "runtime/primitive_type.h"
+#include "runtime/raw_value.h"
+#include "runtime/runtime_state.h"
+#include "runtime/tuple.h"
+#include "runtime/vectorized_row_batch.h"
+#include "util/runtime_profile.h"
+
+namespace palo {
+
+// A tablet of the storage tests. Its versions are written from rows of strings
+// through the writer the push handler uses, and it is scanned through OLAPReader,
+// the reader of OlapScanner, with the rows printed as strings again.
+//
+// A value "NULL" stands for a NULL field, the columns are nullable.
+class TestTablet {
+public:
+    TestTablet(TTabletId tablet_id, TKeysType::type keys_type,
+               TSchemaHash schema_hash = 1234567) :
+            _tablet_id(tablet_id),
+            _schema_hash(schema_hash),
+            _keys_type(keys_type),
+            _num_key_columns(0),
+            _next_version(2) {
+    }
+
+    ~TestTablet() {
+        drop();
+    }
+
+    // Key columns have to be added before the value columns. A value column of an
+    // AGG_KEYS or UNIQUE_KEYS tablet is aggregated with 'aggregation'.
+    TColumn* add_column(const std::string& name, TPrimitiveType::type type, bool is_key,
+                        TAggregationType::type aggregation = TAggregationType::SUM) {
+        TColumn column;
+        column.column_name = name;
+        column.column_type.type = type;
+        if (type == TPrimitiveType::VARCHAR || type == TPrimitiveType::CHAR) {
+            column.column_type.__set_len(32);
+        } else if (type == TPrimitiveType::DECIMAL) {
+            column.column_type.__set_precision(12);
+            column.column_type.__set_scale(3);
+        }
+        column.__set_is_key(is_key);
+        column.__set_is_allow_null(true);
+        if (is_key) {
+            ++_num_key_columns;
+        } else if (_keys_type == TKeysType::DUP_KEYS) {
+            column.__set_aggregation_type(TAggregationType::NONE);
+        } else if (_keys_type == TKeysType::UNIQUE_KEYS) {
+            column.__set_aggregation_type(TAggregationType::REPLACE);
+        } else {
+            column.__set_aggregation_type(aggregation);
+        }
+        _columns.push_back(column);
+        return &_columns.back();
+    }
+
+    const std::vector<TColumn>& columns() const {
+        return _columns;
+    }
+
+    TTabletId tablet_id() const {
+        return _tablet_id;
+    }
+
+    TSchemaHash schema_hash() const {
+        return _schema_hash;
+    }
+
+    SmartOLAPTable table() const {
+        return _table;
+    }
+
+    OLAPStatus create() {
+        CommandExecutor executor;
+        OLAPStatus res = executor.create_table(create_request());
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
+        _table = executor.get_table(_tablet_id, _schema_hash);
+        return _table.get() == NULL ? OLAP_ERR_TABLE_NOT_FOUND : OLAP_SUCCESS;
+    }
+
+    // Creates 'new_tablet', whose columns are the ones of this tablet followed by new
+    // value columns with default values, through a schema change of this tablet and
+    // waits until it is done. The versions of this tablet are linked into the new one,
+    // so their segments do not have the new columns.
+    OLAPStatus schema_change(TestTablet* new_tablet) {
+        TAlterTabletReq request;
+        request.base_tablet_id = _tablet_id;
+        request.base_schema_hash = _schema_hash;
+        request.__set_new_tablet_req(new_tablet->create_request());
+        CommandExecutor executor;
+        OLAPStatus res = executor.schema_change(request);
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
+        for (int i = 0; i < 60; ++i) {
+            AlterTableStatus status = executor.show_alter_table_status(_tablet_id, _schema_hash);
+            if (status == ALTER_TABLE_DONE) {
+                new_tablet->_table = executor.get_table(
+                        new_tablet->_tablet_id, new_tablet->_schema_hash);
+                new_tablet->_next_version = _next_version;
+                return new_tablet->_table.get() == NULL ? OLAP_ERR_TABLE_NOT_FOUND : OLAP_SUCCESS;
+            }
+            if (status == ALTER_TABLE_FAILED) {
+                return OLAP_ERR_OTHER_ERROR;
+            }
+            sleep(1);
+        }
+        return OLAP_ERR_OTHER_ERROR;
+    }
+
+    // Writes 'rows', sorted by their key, as the delta of the next version. The rows
+    // of a version with 'delete_flag' remove the rows with equal key of the older
+    // versions, as a LOAD_DELETE push does.
+    OLAPStatus write_version(const std::vector<std::vector<std::string> >& rows,
+                             bool delete_flag = false) {
+        int64_t version = _next_version++;
+        OLAPIndex* olap_index = new OLAPIndex(
+                _table.get(), Version(version, version), version, delete_flag, 0, 0);
+        std::unique_ptr<IWriter> writer(IWriter::create(_table, olap_index, true));
+        if (writer.get() == NULL) {
+            delete olap_index;
+            return OLAP_ERR_MALLOC_ERROR;
+        }
+        OLAPStatus res = writer->init();
+        RowCursor row;
+        if (res == OLAP_SUCCESS) {
+            res = row.init(_table->tablet_schema());
+        }
+        for (size_t i = 0; res == OLAP_SUCCESS && i < rows.size(); ++i) {
+            res = write_row(rows[i], writer.get(), &row);
+        }
+        if (res == OLAP_SUCCESS) {
+            res = writer->finalize();
+        }
+        if (res == OLAP_SUCCESS) {
+            res = olap_index->load();
+        }
+        if (res != OLAP_SUCCESS) {
+            olap_index->delete_all_files();
+            delete olap_index;
+            return res;
+        }
+
+        std::vector<Version> unused_versions;
+        std::vector<OLAPIndex*> new_indices(1, olap_index);
+        std::vector<OLAPIndex*> unused_indices;
+        _table->obtain_push_lock();
+        _table->obtain_header_wrlock();
+        res = _table->replace_data_sources(&unused_versions, &new_indices, &unused_indices);
+        if (res == OLAP_SUCCESS) {
+            res = _table->save_header();
+        }
+        _table->release_header_lock();
+        _table->release_push_lock();
+        return res;
+    }
+
+    // Adds a delete version with 'conditions'.
+    OLAPStatus delete_version(const std::vector<TCondition>& conditions) {
+        TPushReq request;
+        request.tablet_id = _tablet_id;
+        request.schema_hash = _schema_hash;
+        request.version = _next_version++;
+        request.version_hash = request.version;
+        request.timeout = 86400;
+        request.push_type = TPushType::DELETE;
+        request.__set_delete_conditions(conditions);
+        std::vector<TTabletInfo> tablet_infos;
+        CommandExecutor executor;
+        return executor.delete_data(request, &tablet_infos);
+    }
+
+    void drop() {
+        if (_table.get() != NULL) {
+            _table.reset();
+            OLAPEngine::get_instance()->drop_table(_tablet_id, _schema_hash);
+        }
+    }
+
+    // Scans the latest version through OLAPReader, returns the rows of 'fields' as
+    // "v1,v2,...". Uses next_batch() if 'vectorized' and the reader supports it,
+    // next_tuple() otherwise. '*raw_rows' is set to the rows read from the segments.
+    Status scan(const std::vector<std::string>& fields, const std::vector<TCondition>& where,
+                bool aggregation, bool vectorized, std::vector<std::string>* rows,
+                int64_t* raw_rows = NULL) const {
+        ObjectPool obj_pool;
+        const TupleDescriptor* tuple_desc =
+                create_desc_tbl(fields, &obj_pool)->get_tuple_descriptor(0);
+        return read(*tuple_desc, where, aggregation, vectorized, NULL, rows, raw_rows, NULL);
+    }
+
+    // Scans like scan() and returns the rows for which all of 'conjuncts' are true.
+    // The slot ids of 'fields' are their positions, their tuple id is 0. next_batch()
+    // evaluates the conjuncts which OLAPReader::init_batch_filter() takes on the
+    // columns of each batch, '*num_vec_conjuncts' is set to their number.
+    Status scan_with_conjuncts(const std::vector<std::string>& fields,
+                               const std::vector<TExpr>& conjuncts, bool vectorized,
+                               std::vector<std::string>* rows,
+                               int* num_vec_conjuncts = NULL) const {
+        ObjectPool obj_pool;
+        DescriptorTbl* desc_tbl = create_desc_tbl(fields, &obj_pool);
+        RuntimeState state("");
+        state.set_desc_tbl(desc_tbl);
+        RowDescriptor row_desc(*desc_tbl, std::vector<TTupleId>(1, 0),
+                               std::vector<bool>(1, false));
+        MemTracker tracker;
+        std::vector<ExprContext*> conjunct_ctxs;
+        RETURN_IF_ERROR(Expr::create_expr_trees(&obj_pool, conjuncts, &conjunct_ctxs));
+        RETURN_IF_ERROR(Expr::prepare(conjunct_ctxs, &state, row_desc, &tracker));
+        RETURN_IF_ERROR(Expr::open(conjunct_ctxs, &state));
+        std::vector<ExprContext*> all_conjunct_ctxs = conjunct_ctxs;
+        Status status = read(*desc_tbl->get_tuple_descriptor(0), {}, false, vectorized,
+                             &conjunct_ctxs, rows, NULL, num_vec_conjuncts);
+        Expr::close(all_conjunct_ctxs, &state);
+        return status;
+    }
+
+    // A condition of a scan or a delete version.
+    static TCondition condition(const std::string& column, const std::string& op,
+                                const std::vector<std::string>& values) {
+        TCondition condition;
+        condition.column_name = column;
+        condition.condition_op = op;
+        condition.condition_values = values;
+        return condition;
+    }
+
+private:
+    Status read(const TupleDescriptor& tuple_desc, const std::vector<TCondition>& where,
+                bool aggregation, bool vectorized, std::vector<ExprContext*>* conjunct_ctxs,
+                std::vector<std::string>* rows, int64_t* raw_rows,
+                int* num_vec_conjuncts) const {
+        ObjectPool obj_pool;
+        RuntimeProfile* profile = obj_pool.add(new RuntimeProfile(&obj_pool, "OlapScanner"));
+        OLAPReader::init_profile(profile);
+
+        std::vector<std::string> fields;
+        for (const SlotDescriptor* slot : tuple_desc.slots()) {
+            fields.push_back(slot->col_name());
+        }
+        const FileVersionMessage* latest = _table->latest_version();
+        TFetchRequest request;
+        request.__set_use_compression(false);
+        request.__set_schema_hash(_schema_hash);
+        request.__set_tablet_id(_tablet_id);
+        request.__set_version(latest->end_version());
+        request.__set_version_hash(latest->version_hash());
+        request.__set_aggregation(aggregation);
+        request.__set_field(fields);
+        request.__set_where(where);
+
+        OLAPReader reader(tuple_desc);
+        RETURN_IF_ERROR(reader.init(request, NULL, profile));
+        std::vector<ExprContext*> row_conjunct_ctxs;
+        if (conjunct_ctxs != NULL) {
+            row_conjunct_ctxs = *conjunct_ctxs;
+        }
+        int64_t raw_rows_read = 0;
+        int tuple_size = tuple_desc.byte_size();
+        std::vector<char> tuple_buf;
+        bool eof = false;
+        if (vectorized && reader.is_vectorized_supported()) {
+            std::vector<ExprContext*> vec_conjunct_ctxs;
+            reader.init_batch_filter(&row_conjunct_ctxs, &vec_conjunct_ctxs);
+            if (num_vec_conjuncts != NULL) {
+                *num_vec_conjuncts = vec_conjunct_ctxs.size();
+            }
+            std::unique_ptr<VectorizedRowBatch> batch(reader.create_vectorized_row_batch(256));
+            while (!eof) {
+                RETURN_IF_ERROR(reader.next_batch(batch.get(), &raw_rows_read, &eof));
+                if (batch->size() == 0) {
+                    continue;
+                }
+                tuple_buf.assign(tuple_size * batch->size(), 0);
+                reader.filter_batch(batch.get());
+                RETURN_IF_ERROR(reader.convert_batch_to_tuples(
+                        batch.get(), reinterpret_cast<Tuple*>(tuple_buf.data())));
+                for (int i = 0; i < batch->size(); ++i) {
+                    int row = batch->selected_in_use() ? batch->selected()[i] : i;
+                    Tuple* tuple = reinterpret_cast<Tuple*>(tuple_buf.data() + row * tuple_size);
+                    if (ExecNode::eval_conjuncts(row_conjunct_ctxs.data(),
+                                                 row_conjunct_ctxs.size(),
+                                                 reinterpret_cast<TupleRow*>(&tuple))) {
+                        rows->push_back(print_tuple(tuple, tuple_desc));
+                    }
+                }
+            }
+        } else {
+            if (num_vec_conjuncts != NULL) {
+                *num_vec_conjuncts = 0;
+            }
+            tuple_buf.assign(tuple_size, 0);
+            Tuple* tuple = reinterpret_cast<Tuple*>(tuple_buf.data());
+            while (true) {
+                memset(tuple_buf.data(), 0, tuple_size);
+                RETURN_IF_ERROR(reader.next_tuple(tuple, &raw_rows_read, &eof));
+                if (eof) {
+                    break;
+                }
+                if (ExecNode::eval_conjuncts(row_conjunct_ctxs.data(), row_conjunct_ctxs.size(),
+                                             reinterpret_cast<TupleRow*>(&tuple))) {
+                    rows->push_back(print_tuple(tuple, tuple_desc));
+                }
+            }
+        }
+        if (raw_rows != NULL) {
+            *raw_rows = raw_rows_read;
+        }
+        return reader.close();
+    }
+
+    TCreateTabletReq create_request() const {
+        TCreateTabletReq request;
+        request.tablet_id = _tablet_id;
+        request.__set_version(1);
+        request.__set_version_hash(0);
+        request.tablet_schema.schema_hash = _schema_hash;
+        request.tablet_schema.short_key_column_count = _num_key_columns;
+        request.tablet_schema.keys_type = _keys_type;
+        request.tablet_schema.storage_type = TStorageType::COLUMN;
+        request.tablet_schema.columns = _columns;
+        return request;
+    }
+
+    const TColumn& column(const std::string& name) const {
+        for (size_t i = 0; i < _columns.size(); ++i) {
+            if (_columns[i].column_name == name) {
+                return _columns[i];
+            }
+        }
+        DCHECK(false) << "no column " << name;
+        return _columns[0];
+    }
+
+    OLAPStatus write_row(const std::vector<std::string>& values, IWriter* writer,
+                         RowCursor* row) const {
+        OLAPStatus res = writer->attached_by(row);
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
+        // The NULL fields get any valid value first.
+        std::vector<std::string> not_null_values = values;
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (values[i] == "NULL") {
+                not_null_values[i] = null_placeholder(_table->tablet_schema()[i].type);
+            }
+        }
+        res = row->from_string(not_null_values);
+        if (res != OLAP_SUCCESS) {
+            return res;
+        }
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (values[i] == "NULL") {
+                row->set_null(i);
+            } else {
+                row->set_not_null(i);
+            }
+        }
+        writer->next(*row);
+        return OLAP_SUCCESS;
+    }
+
+    static std::string null_placeholder(FieldType type) {
+        switch (type) {
+        case OLAP_FIELD_TYPE_DATE:
+            return "1970-01-01";
+        case OLAP_FIELD_TYPE_DATETIME:
+            return "1970-01-01 00:00:00";
+        case OLAP_FIELD_TYPE_CHAR:
+        case OLAP_FIELD_TYPE_VARCHAR:
+            return "";
+        default:
+            return "0";
+        }
+    }
+
+    // Tuple 0 has the slots of 'fields' in their order, all slots are nullable.
+    DescriptorTbl* create_desc_tbl(const std::vector<std::string>& fields,
+                                   ObjectPool* obj_pool) const {
+        TDescriptorTable t_desc_table;
+        TTableDescriptor t_table_desc;
+        t_table_desc.id = 0;
+        t_table_desc.tableType = TTableType::OLAP_TABLE;
+        t_table_desc.numCols = 0;
+        t_table_desc.numClusteringCols = 0;
+        t_table_desc.olapTable.tableName = "";
+        t_table_desc.tableName = "";
+        t_table_desc.dbName = "";
+        t_table_desc.__isset.mysqlTable = true;
+        t_desc_table.tableDescriptors.push_back(t_table_desc);
+        t_desc_table.__isset.tableDescriptors = true;
+
+        int num_null_bytes = (fields.size() + 7) / 8;
+        // Every slot starts at a multiple of 16 bytes.
+        int offset = 16;
+        for (int i = 0; i < fields.size(); ++i) {
+            TPrimitiveType::type type = column(fields[i]).column_type.type;
+            TSlotDescriptor t_slot_desc;
+            t_slot_desc.__set_id(i);
+            t_slot_desc.__set_parent(0);
+            t_slot_desc.__set_slotType(gen_type_desc(type));
+            t_slot_desc.__set_columnPos(i);
+            t_slot_desc.__set_byteOffset(offset);
+            t_slot_desc.__set_nullIndicatorByte(i / 8);
+            t_slot_desc.__set_nullIndicatorBit(i % 8);
+            t_slot_desc.__set_slotIdx(i);
+            t_slot_desc.__set_isMaterialized(true);
+            t_slot_desc.__set_colName(fields[i]);
+            t_desc_table.slotDescriptors.push_back(t_slot_desc);
+            int slot_size = TypeDescriptor::from_thrift(gen_type_desc(type)).get_slot_size();
+            offset += (slot_size + 15) / 16 * 16;
+        }
+        DCHECK_LE(num_null_bytes, 16);
+        t_desc_table.__isset.slotDescriptors = true;
+
+        TTupleDescriptor t_tuple_desc;
+        t_tuple_desc.id = 0;
+        t_tuple_desc.byteSize = offset;
+        t_tuple_desc.numNullBytes = num_null_bytes;
+        t_tuple_desc.tableId = 0;
+        t_tuple_desc.__isset.tableId = true;
+        t_desc_table.tupleDescriptors.push_back(t_tuple_desc);
+
+        DescriptorTbl* desc_tbl = NULL;
+        Status status = DescriptorTbl::create(obj_pool, t_desc_table, &desc_tbl);
+        DCHECK(status.ok()) << status.get_error_msg();
+        return desc_tbl;
+    }
+
+    static std::string print_tuple(const Tuple* tuple, const TupleDescriptor& tuple_desc) {
+        std::string row;
+        for (size_t i = 0; i < tuple_desc.slots().size(); ++i) {
+            const SlotDescriptor* slot = tuple_desc.slots()[i];
+            std::string value;
+            RawValue::print_value(
+                    tuple->is_null(slot->null_indicator_offset())
+                        ? NULL : tuple->get_slot(slot->tuple_offset()),
+                    slot->type(), -1, &value);
+            if (i > 0) {
+                row += ",";
+            }
+            row += value;
+        }
+        return row;
+    }
+
+    const TTabletId _tablet_id;
+    const TSchemaHash _schema_hash;
+    const TKeysType::type _keys_type;
+    std::vector<TColumn> _columns;
+    int _num_key_columns;
+    int64_t _next_version;
+    SmartOLAPTable _table;
+};
+
+} // namespace palo
+
+#endif // BDG_PALO_BE_TEST_OLAP_TEST_TABLET_H
@@ -0,0 +1,352 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "gen_cpp/Exprs_types.h"
+#include "olap/olap_main.cpp"
+#include "olap/test_tablet.h"
+#include "olap/utils.h"
+#include "runtime/types.h"
+#include "util/cpu_info.h"
+#include "util/logging.h"
+
+using std::string;
+using std::vector;
+
+namespace palo {
+
+static const int NUM_ROWS = 2000;
+
+// The slots of a scan of FIELDS, their slot ids are their positions.
+static const vector<string> FIELDS = {"k1", "v1", "v2", "v3", "v4"};
+static const int V1_SLOT = 1;
+static const int V2_SLOT = 2;
+static const int V3_SLOT = 3;
+static const int V4_SLOT = 4;
+
+// A row of the test tablet: k1 is the key, v1 has 10 distinct values and is NULL in
+// every 11th row, v2 has 5 distinct values and is NULL in every 7th row, v3 is a
+// DECIMAL x.25 with 40 distinct values and v4 is k1.
+struct TestRow {
+    int k1;
+    bool v1_is_null;
+    int v1;
+    bool v2_is_null;
+    string v2;
+    double v3;
+    int64_t v4;
+};
+
+// Expr trees of the conjuncts, the nodes of a TExpr are in pre-order.
+class ExprBuilder {
+public:
+    static TExprNode slot_ref(int slot_id, const TypeDescriptor& type) {
+        TSlotRef slot_ref;
+        slot_ref.__set_slot_id(slot_id);
+        slot_ref.__set_tuple_id(0);
+        TExprNode node;
+        node.__set_node_type(TExprNodeType::SLOT_REF);
+        node.__set_type(type.to_thrift());
+        node.__set_num_children(0);
+        node.__set_output_scale(-1);
+        node.__set_slot_ref(slot_ref);
+        return node;
+    }
+
+    static TExprNode int_literal(PrimitiveType type, int64_t value) {
+        TIntLiteral int_literal;
+        int_literal.__set_value(value);
+        TExprNode node;
+        node.__set_node_type(TExprNodeType::INT_LITERAL);
+        node.__set_type(TypeDescriptor(type).to_thrift());
+        node.__set_num_children(0);
+        node.__set_output_scale(-1);
+        node.__set_int_literal(int_literal);
+        return node;
+    }
+
+    static TExprNode string_literal(const string& value) {
+        TStringLiteral string_literal;
+        string_literal.__set_value(value);
+        TExprNode node;
+        node.__set_node_type(TExprNodeType::STRING_LITERAL);
+        node.__set_type(TypeDescriptor::create_varchar_type(32).to_thrift());
+        node.__set_num_children(0);
+        node.__set_output_scale(-1);
+        node.__set_string_literal(string_literal);
+        return node;
+    }
+
+    static TExprNode decimal_literal(const string& value) {
+        TDecimalLiteral decimal_literal;
+        decimal_literal.__set_value(value);
+        TExprNode node;
+        node.__set_node_type(TExprNodeType::DECIMAL_LITERAL);
+        node.__set_type(TypeDescriptor::create_decimal_type(12, 3).to_thrift());
+        node.__set_num_children(0);
+        node.__set_output_scale(-1);
+        node.__set_decimal_literal(decimal_literal);
+        return node;
+    }
+
+    static TExprNode binary_pred(TExprOpcode::type op, TPrimitiveType::type child_type) {
+        TExprNode node;
+        node.__set_node_type(TExprNodeType::BINARY_PRED);
+        node.__set_type(TypeDescriptor(TYPE_BOOLEAN).to_thrift());
+        node.__set_opcode(op);
+        node.__set_child_type(child_type);
+        node.__set_num_children(2);
+        node.__set_output_scale(-1);
+        return node;
+    }
+
+    static TExprNode compound_pred(TExprOpcode::type op) {
+        TExprNode node;
+        node.__set_node_type(TExprNodeType::COMPOUND_PRED);
+        node.__set_type(TypeDescriptor(TYPE_BOOLEAN).to_thrift());
+        node.__set_opcode(op);
+        node.__set_num_children(2);
+        node.__set_output_scale(-1);
+        return node;
+    }
+
+    // slot op literal, or literal op slot if 'literal_first'
+    static TExpr compare(TExprOpcode::type op, const TExprNode& slot,
+                         const TExprNode& literal, TPrimitiveType::type child_type,
+                         bool literal_first = false) {
+        TExpr expr;
+        expr.nodes.push_back(binary_pred(op, child_type));
+        expr.nodes.push_back(literal_first ? literal : slot);
+        expr.nodes.push_back(literal_first ? slot : literal);
+        return expr;
+    }
+
+    static TExpr compound(TExprOpcode::type op, const TExpr& left, const TExpr& right) {
+        TExpr expr;
+        expr.nodes.push_back(compound_pred(op));
+        expr.nodes.insert(expr.nodes.end(), left.nodes.begin(), left.nodes.end());
+        expr.nodes.insert(expr.nodes.end(), right.nodes.begin(), right.nodes.end());
+        return expr;
+    }
+};
+
+static TExpr v1_compare(TExprOpcode::type op, int value, bool literal_first = false) {
+    return ExprBuilder::compare(op, ExprBuilder::slot_ref(V1_SLOT, TypeDescriptor(TYPE_INT)),
+                                ExprBuilder::int_literal(TYPE_INT, value),
+                                TPrimitiveType::INT, literal_first);
+}
+
+static TExpr v2_compare(TExprOpcode::type op, const string& value) {
+    return ExprBuilder::compare(
+            op, ExprBuilder::slot_ref(V2_SLOT, TypeDescriptor::create_varchar_type(32)),
+            ExprBuilder::string_literal(value), TPrimitiveType::VARCHAR);
+}
+
+static TExpr v3_compare(TExprOpcode::type op, const string& value) {
+    return ExprBuilder::compare(
+            op, ExprBuilder::slot_ref(V3_SLOT, TypeDescriptor::create_decimal_type(12, 3)),
+            ExprBuilder::decimal_literal(value), TPrimitiveType::DECIMAL);
+}
+
+static TExpr v4_compare(TExprOpcode::type op, int64_t value) {
+    return ExprBuilder::compare(
+            op, ExprBuilder::slot_ref(V4_SLOT, TypeDescriptor(TYPE_BIGINT)),
+            ExprBuilder::int_literal(TYPE_BIGINT, value), TPrimitiveType::BIGINT);
+}
+
+class VectorizedScanTest : public testing::Test {
+public:
+    VectorizedScanTest() {}
+    ~VectorizedScanTest() {}
+
+protected:
+    virtual void SetUp() {
+        for (int i = 0; i < NUM_ROWS; ++i) {
+            TestRow row;
+            row.k1 = i;
+            row.v1_is_null = (i % 11 == 0);
+            row.v1 = i % 10;
+            row.v2_is_null = (i % 7 == 0);
+            row.v2 = "s" + std::to_string(i % 5);
+            row.v3 = i % 40 + 0.25;
+            row.v4 = i;
+            _rows.push_back(row);
+        }
+
+        // Two versions of a DUP_KEYS tablet, whose key ranges overlap.
+        _tablet.reset(new TestTablet(40001, TKeysType::DUP_KEYS));
+        _tablet->add_column("k1", TPrimitiveType::INT, true);
+        _tablet->add_column("v1", TPrimitiveType::INT, false);
+        _tablet->add_column("v2", TPrimitiveType::VARCHAR, false);
+        _tablet->add_column("v3", TPrimitiveType::DECIMAL, false);
+        _tablet->add_column("v4", TPrimitiveType::BIGINT, false);
+        ASSERT_EQ(OLAP_SUCCESS, _tablet->create());
+        for (int version = 0; version < 2; ++version) {
+            vector<vector<string> > rows;
+            for (const TestRow& row : _rows) {
+                if (row.k1 % 2 != version) {
+                    continue;
+                }
+                rows.push_back({std::to_string(row.k1),
+                                row.v1_is_null ? "NULL" : std::to_string(row.v1),
+                                row.v2_is_null ? "NULL" : row.v2,
+                                std::to_string(row.k1 % 40) + ".25",
+                                std::to_string(row.v4)});
+            }
+            ASSERT_EQ(OLAP_SUCCESS, _tablet->write_version(rows));
+        }
+    }
+
+    virtual void TearDown() {
+        _tablet.reset();
+    }
+
+    // Scans with 'conjuncts' row by row and in batches and checks that both return the
+    // rows 'pred' accepts. 'num_vec_conjuncts' of them are evaluated on the columns of
+    // the batches.
+    void check_scan(const vector<TExpr>& conjuncts,
+                    const std::function<bool(const TestRow&)>& pred, int num_vec_conjuncts) {
+        vector<string> row_result;
+        Status status = _tablet->scan_with_conjuncts(FIELDS, conjuncts, false, &row_result);
+        ASSERT_TRUE(status.ok()) << status.get_error_msg();
+
+        vector<string> batch_result;
+        int num_vec = -1;
+        status = _tablet->scan_with_conjuncts(FIELDS, conjuncts, true, &batch_result, &num_vec);
+        ASSERT_TRUE(status.ok()) << status.get_error_msg();
+        EXPECT_EQ(num_vec_conjuncts, num_vec);
+
+        vector<int> expected_keys;
+        for (const TestRow& row : _rows) {
+            if (pred(row)) {
+                expected_keys.push_back(row.k1);
+            }
+        }
+        EXPECT_FALSE(expected_keys.empty());
+
+        // The versions may be read one after another.
+        std::sort(row_result.begin(), row_result.end());
+        std::sort(batch_result.begin(), batch_result.end());
+        EXPECT_EQ(expected_keys.size(), row_result.size());
+        EXPECT_TRUE(row_result == batch_result);
+
+        vector<int> keys;
+        for (const string& row : batch_result) {
+            keys.push_back(std::stoi(row.substr(0, row.find(','))));
+        }
+        std::sort(keys.begin(), keys.end());
+        EXPECT_TRUE(expected_keys == keys);
+    }
+
+    vector<TestRow> _rows;
+    std::unique_ptr<TestTablet> _tablet;
+};
+
+TEST_F(VectorizedScanTest, NoConjuncts) {
+    check_scan({}, [](const TestRow& row) { return true; }, 0);
+}
+
+// An INT conjunct on the column vector, a string conjunct on the tuples.
+TEST_F(VectorizedScanTest, IntAndString) {
+    check_scan({v1_compare(TExprOpcode::GE, 3), v2_compare(TExprOpcode::EQ, "s2")},
+               [](const TestRow& row) {
+                   return !row.v1_is_null && row.v1 >= 3 && !row.v2_is_null && row.v2 == "s2";
+               }, 1);
+}
+
+// A BIGINT conjunct on the column vector, a DECIMAL conjunct on the tuples.
+TEST_F(VectorizedScanTest, BigIntAndDecimal) {
+    check_scan({v4_compare(TExprOpcode::LT, 1500), v3_compare(TExprOpcode::GT, "10.5")},
+               [](const TestRow& row) { return row.v4 < 1500 && row.v3 > 10.5; }, 1);
+}
+
+// NULL values are not selected by any comparison.
+TEST_F(VectorizedScanTest, NullValues) {
+    check_scan({v1_compare(TExprOpcode::NE, 7)},
+               [](const TestRow& row) { return !row.v1_is_null && row.v1 != 7; }, 1);
+    check_scan({v1_compare(TExprOpcode::GT, 5, true)},
+               [](const TestRow& row) { return !row.v1_is_null && row.v1 < 5; }, 1);
+}
+
+// OR and AND of comparisons, the same column compared twice is a range.
+TEST_F(VectorizedScanTest, Compound) {
+    check_scan({ExprBuilder::compound(TExprOpcode::COMPOUND_OR,
+                                      v1_compare(TExprOpcode::EQ, 4),
+                                      v4_compare(TExprOpcode::GT, 1800))},
+               [](const TestRow& row) {
+                   return (!row.v1_is_null && row.v1 == 4) || row.v4 > 1800;
+               }, 1);
+    check_scan({ExprBuilder::compound(TExprOpcode::COMPOUND_AND,
+                                      v4_compare(TExprOpcode::GE, 300),
+                                      v4_compare(TExprOpcode::LE, 700)),
+                v2_compare(TExprOpcode::NE, "s1")},
+               [](const TestRow& row) {
+                   return row.v4 >= 300 && row.v4 <= 700 && !row.v2_is_null && row.v2 != "s1";
+               }, 1);
+}
+
+// A conjunct mixing a vectorized and a string comparison stays on the tuples.
+TEST_F(VectorizedScanTest, OnlyRowConjuncts) {
+    check_scan({ExprBuilder::compound(TExprOpcode::COMPOUND_OR,
+                                      v1_compare(TExprOpcode::EQ, 2),
+                                      v2_compare(TExprOpcode::EQ, "s3")),
+                v3_compare(TExprOpcode::LE, "20")},
+               [](const TestRow& row) {
+                   return ((!row.v1_is_null && row.v1 == 2) || (!row.v2_is_null && row.v2 == "s3"))
+                       && row.v3 <= 20;
+               }, 0);
+}
+
+// No row survives the conjuncts on the column vectors.
+TEST_F(VectorizedScanTest, NoSelectedRows) {
+    vector<string> row_result;
+    vector<string> batch_result;
+    vector<TExpr> conjuncts = {v1_compare(TExprOpcode::GT, 100),
+                               v2_compare(TExprOpcode::EQ, "s1")};
+    ASSERT_TRUE(_tablet->scan_with_conjuncts(FIELDS, conjuncts, false, &row_result).ok());
+    ASSERT_TRUE(_tablet->scan_with_conjuncts(FIELDS, conjuncts, true, &batch_result).ok());
+    EXPECT_TRUE(row_result.empty());
+    EXPECT_TRUE(batch_result.empty());
+}
+
+} // namespace palo
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    palo::init_glog("be-test");
+    palo::CpuInfo::init();
+    testing::InitGoogleTest(&argc, argv);
+
+    palo::config::storage_root_path = "./vectorized_scan_test";
+    palo::remove_all_dir(palo::config::storage_root_path);
+    palo::create_dir(palo::config::storage_root_path);
+    palo::touch_all_singleton();
+
+    int ret = RUN_ALL_TESTS();
+    palo::remove_all_dir(palo::config::storage_root_path);
+    return ret;
+}
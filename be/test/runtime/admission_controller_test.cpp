@@ -0,0 +1,103 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/admission_controller.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "util/logging.h"
+
+namespace palo {
+
+static bool not_cancelled() {
+    return false;
+}
+
+static bool cancelled() {
+    return true;
+}
+
+static TUniqueId query(int64_t lo) {
+    TUniqueId id;
+    id.hi = 0;
+    id.lo = lo;
+    return id;
+}
+
+TEST(AdmissionControllerTest, FragmentSlots) {
+    config::admission_queue_timeout_ms = 10000;
+    AdmissionController controller(1, 0);
+    ASSERT_TRUE(controller.admit("g", query(1), 0, not_cancelled).ok());
+    // fragments of a running query and of other groups don't wait
+    ASSERT_TRUE(controller.admit("g", query(1), 0, not_cancelled).ok());
+    ASSERT_TRUE(controller.admit("other", query(2), 0, not_cancelled).ok());
+
+    std::atomic<bool> admitted(false);
+    std::thread waiter([&controller, &admitted] {
+        admitted = controller.admit("g", query(3), 0, not_cancelled).ok();
+    });
+    usleep(100 * 1000);
+    ASSERT_FALSE(admitted);
+    controller.release("g", query(1), 0);
+    usleep(100 * 1000);
+    ASSERT_FALSE(admitted);
+    controller.release("g", query(1), 0);
+    waiter.join();
+    ASSERT_TRUE(admitted);
+
+    controller.release("g", query(3), 0);
+    controller.release("other", query(2), 0);
+}
+
+TEST(AdmissionControllerTest, MemoryBudget) {
+    config::admission_queue_timeout_ms = 50;
+    AdmissionController controller(0, 100);
+    // an empty group admits a fragment beyond the budget
+    ASSERT_TRUE(controller.admit("g", query(1), 200, not_cancelled).ok());
+    controller.release("g", query(1), 200);
+
+    ASSERT_TRUE(controller.admit("g", query(1), 60, not_cancelled).ok());
+    ASSERT_TRUE(controller.admit("g", query(2), 40, not_cancelled).ok());
+    Status status = controller.admit("g", query(3), 10, not_cancelled);
+    ASSERT_FALSE(status.ok());
+    ASSERT_FALSE(status.is_cancelled());
+
+    controller.release("g", query(2), 40);
+    ASSERT_TRUE(controller.admit("g", query(3), 10, not_cancelled).ok());
+    controller.release("g", query(3), 10);
+    controller.release("g", query(1), 60);
+}
+
+TEST(AdmissionControllerTest, Cancel) {
+    config::admission_queue_timeout_ms = 10000;
+    AdmissionController controller(1, 0);
+    ASSERT_TRUE(controller.admit("g", query(1), 0, not_cancelled).ok());
+    ASSERT_TRUE(controller.admit("g", query(2), 0, cancelled).is_cancelled());
+    controller.release("g", query(1), 0);
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -687,6 +687,49 @@ TEST_F(BufferedBlockMgrTest, Pin) {
     TearDownMgrs();
 }
 
+// Test that spilled blocks are compressed when configured and read back intact.
+TEST_F(BufferedBlockMgrTest, CompressedSpill) {
+    config::compress_spilled_blocks = true;
+    int max_num_blocks = 3;
+    const int block_size = 1024;
+    BufferedBlockMgr2* block_mgr;
+    BufferedBlockMgr2::Client* client;
+    block_mgr = CreateMgrAndClient(0, max_num_blocks, block_size, 0, _client_tracker.get(),
+            &client);
+
+    // Twice as many blocks as buffers, so some must be written and evicted.
+    vector<BufferedBlockMgr2::Block*> blocks;
+    for (int i = 0; i < 2 * max_num_blocks; ++i) {
+        BufferedBlockMgr2::Block* block = NULL;
+        EXPECT_TRUE(block_mgr->get_new_block(client, NULL, &block).ok());
+        ASSERT_TRUE(block != NULL);
+        memset(block->allocate<uint8_t>(block_size), i, block_size);
+        EXPECT_TRUE(block->unpin().ok());
+        blocks.push_back(block);
+    }
+    WaitForWrites(block_mgr);
+
+    for (int i = 0; i < blocks.size(); ++i) {
+        bool pinned = false;
+        EXPECT_TRUE(blocks[i]->pin(&pinned).ok());
+        ASSERT_TRUE(pinned);
+        EXPECT_EQ(block_size, blocks[i]->valid_data_len());
+        for (int j = 0; j < block_size; ++j) {
+            ASSERT_EQ(i, blocks[i]->buffer()[j]) << "block " << i;
+        }
+        EXPECT_TRUE(blocks[i]->unpin().ok());
+    }
+    WaitForWrites(block_mgr);
+
+    RuntimeProfile* profile = block_mgr->profile();
+    int64_t bytes_written = profile->get_counter("BytesWritten")->value();
+    EXPECT_GT(bytes_written, 0);
+    EXPECT_LT(profile->get_counter("CompressedBytesWritten")->value(), bytes_written);
+
+    TearDownMgrs();
+    config::compress_spilled_blocks = false;
+}
+
 // Test the eviction policy of the block mgr. No writes issued until more than
 // the max available buffers are allocated. Writes must be issued in LIFO order.
 TEST_F(BufferedBlockMgrTest, Eviction) {
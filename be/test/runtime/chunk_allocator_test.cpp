@@ -0,0 +1,102 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#include <gtest/gtest.h>
+
+#include <boost/thread/thread.hpp>
+
+#include "runtime/chunk_allocator.h"
+#include "util/logging.h"
+
+namespace palo {
+
+static void allocate_and_free(ChunkAllocator* allocator, int64_t size) {
+    allocator->free(allocator->allocate(size), size);
+}
+
+TEST(ChunkAllocatorTest, reuse_in_thread) {
+    ChunkAllocator allocator(64 * 1024, 0);
+    uint8_t* data = allocator.allocate(8 * 1024);
+    ASSERT_TRUE(data != NULL);
+    ASSERT_EQ(1, allocator.stats().mallocs);
+
+    allocator.free(data, 8 * 1024);
+    ASSERT_EQ(8 * 1024, allocator.reserved_bytes());
+
+    // another size doesn't get it
+    uint8_t* data2 = allocator.allocate(16 * 1024);
+    ASSERT_EQ(2, allocator.stats().mallocs);
+    ASSERT_EQ(data, allocator.allocate(8 * 1024));
+    ASSERT_EQ(1, allocator.stats().thread_hits);
+    ASSERT_EQ(0, allocator.reserved_bytes());
+
+    allocator.free(data, 8 * 1024);
+    allocator.free(data2, 16 * 1024);
+    ASSERT_EQ(24 * 1024, allocator.reserved_bytes());
+}
+
+TEST(ChunkAllocatorTest, not_cached_sizes) {
+    ChunkAllocator allocator(1024 * 1024, 1024 * 1024);
+    int64_t sizes[] = { 1024, 12 * 1024, 1024 * 1024 };
+
+    for (int i = 0; i < 3; ++i) {
+        allocator.free(allocator.allocate(sizes[i]), sizes[i]);
+    }
+
+    ASSERT_EQ(0, allocator.reserved_bytes());
+    ASSERT_EQ(3, allocator.stats().mallocs);
+}
+
+TEST(ChunkAllocatorTest, shared_lists) {
+    ChunkAllocator allocator(4 * 1024, 8 * 1024);
+    uint8_t* data[4];
+
+    for (int i = 0; i < 4; ++i) {
+        data[i] = allocator.allocate(4 * 1024);
+    }
+
+    // one chunk in this thread, two in the shared lists, the last one is freed
+    for (int i = 0; i < 4; ++i) {
+        allocator.free(data[i], 4 * 1024);
+    }
+    ASSERT_EQ(12 * 1024, allocator.reserved_bytes());
+
+    ASSERT_EQ(data[0], allocator.allocate(4 * 1024));
+    ASSERT_EQ(1, allocator.stats().thread_hits);
+    allocator.allocate(4 * 1024);
+    allocator.allocate(4 * 1024);
+    ASSERT_EQ(2, allocator.stats().shared_hits);
+    ASSERT_EQ(0, allocator.reserved_bytes());
+    ASSERT_EQ(4, allocator.stats().mallocs);
+}
+
+TEST(ChunkAllocatorTest, thread_exit) {
+    ChunkAllocator allocator(64 * 1024, 64 * 1024);
+    // the chunk the thread keeps goes to the shared lists when it exits
+    boost::thread thread(allocate_and_free, &allocator, 32 * 1024);
+    thread.join();
+    ASSERT_EQ(32 * 1024, allocator.reserved_bytes());
+
+    uint8_t* data = allocator.allocate(32 * 1024);
+    ASSERT_EQ(1, allocator.stats().shared_hits);
+    allocator.free(data, 32 * 1024);
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
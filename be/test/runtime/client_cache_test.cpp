@@ -0,0 +1,149 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/client_cache.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "util/logging.h"
+#include "util/network_util.h"
+
+namespace palo {
+
+// Stands in for a generated thrift client, the cache only opens its transport.
+class DummyServiceClient {
+public:
+    DummyServiceClient(boost::shared_ptr<apache::thrift::protocol::TProtocol> protocol) { }
+};
+
+typedef ClientCache<DummyServiceClient> DummyClientCache;
+typedef ClientConnection<DummyServiceClient> DummyConnection;
+
+// Listens on localhost, the kernel completes connections without them being accepted.
+class ClientCacheTest : public testing::Test {
+protected:
+    virtual void SetUp() {
+        config::thrift_client_cache_max_per_host = 0;
+        _listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT_GE(_listen_fd, 0);
+        sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        ASSERT_EQ(0, bind(_listen_fd, (sockaddr*)&addr, sizeof(addr)));
+        ASSERT_EQ(0, listen(_listen_fd, 16));
+        socklen_t len = sizeof(addr);
+        ASSERT_EQ(0, getsockname(_listen_fd, (sockaddr*)&addr, &len));
+        _address = make_network_address("127.0.0.1", ntohs(addr.sin_port));
+    }
+
+    virtual void TearDown() {
+        close(_listen_fd);
+    }
+
+    int _listen_fd;
+    TNetworkAddress _address;
+};
+
+TEST_F(ClientCacheTest, Reuse) {
+    DummyClientCache cache;
+    DummyServiceClient* first = NULL;
+    {
+        Status status;
+        DummyConnection client(&cache, _address, &status);
+        ASSERT_TRUE(status.ok());
+        first = client.operator->();
+    }
+    Status status;
+    DummyConnection client(&cache, _address, &status);
+    ASSERT_TRUE(status.ok());
+    ASSERT_EQ(first, client.operator->());
+}
+
+TEST_F(ClientCacheTest, ClosedByServer) {
+    DummyClientCache cache;
+    {
+        Status status;
+        DummyConnection client(&cache, _address, &status);
+        ASSERT_TRUE(status.ok());
+    }
+    int fd = accept(_listen_fd, NULL, NULL);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    usleep(10 * 1000);
+
+    // the idle client is found closed and replaced
+    Status status;
+    DummyConnection client(&cache, _address, &status);
+    ASSERT_TRUE(status.ok());
+    ASSERT_NE(std::string::npos, cache.debug_string().find("(created=2 broken=1"));
+}
+
+TEST_F(ClientCacheTest, MaxPerHost) {
+    config::thrift_client_cache_max_per_host = 1;
+    config::thrift_connect_timeout_seconds = 1;
+    DummyClientCache cache;
+    std::atomic<bool> got_client(false);
+    std::unique_ptr<std::thread> waiter;
+    {
+        Status status;
+        DummyConnection client(&cache, _address, &status);
+        ASSERT_TRUE(status.ok());
+        DummyServiceClient* first = client.operator->();
+        waiter.reset(new std::thread([&cache, &got_client, first, this] {
+            Status status;
+            DummyConnection client(&cache, _address, &status);
+            got_client = status.ok() && client.operator->() == first;
+        }));
+        usleep(100 * 1000);
+        ASSERT_FALSE(got_client);
+    }
+    waiter->join();
+    ASSERT_TRUE(got_client);
+
+    // nobody releases the client in time
+    Status status;
+    DummyConnection client(&cache, _address, &status);
+    ASSERT_TRUE(status.ok());
+    Status timed_out;
+    DummyConnection other(&cache, _address, &timed_out);
+    ASSERT_FALSE(timed_out.ok());
+}
+
+TEST_F(ClientCacheTest, WarmUp) {
+    DummyClientCache cache;
+    ASSERT_TRUE(cache.warm_up(_address, 3).ok());
+    ASSERT_TRUE(cache.warm_up(_address, 2).ok());
+    ASSERT_NE(std::string::npos, cache.debug_string().find(":3/3(created=3"));
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,575 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+// Throughput benchmark of the exchange, DataStreamSender to DataStreamRecvr over the
+// rpc Comm layer.
+//
+// N sender threads send row batches to M receivers with the given partitioning. Every
+// row carries the wall time it was sent at, so the receivers can record the end to end
+// latency of the batches they get. It reports rows/s, bytes/s, the CPU time of the
+// process per byte sent, the serialization and transmit times of the senders and a
+// latency histogram. Run it by hand, e.g.
+//
+//     data_stream_benchmark --senders=4 --receivers=4 --partition=hash --compress=false
+//
+// To run the senders and the receivers in separate processes, start the receivers
+// first with --role=receiver and then the senders with --role=sender --host=<receiver
+// host>, both with the same --senders and --receivers. Senders of several processes
+// take disjoint ids with --first_sender; --senders of the receiver process is the
+// total. Across hosts the latencies are only as exact as the synchronization of the
+// clocks.
+//
+// Options:
+//     --role=all|sender|receiver          (all)
+//     --host=<receiver host>              (127.0.0.1)
+//     --senders=N                         (2)
+//     --first_sender=N                    id of the first sender of this process (0)
+//     --receivers=N                       (2)
+//     --partition=broadcast|random|hash|range  (hash)
+//     --batches=N                         batches per sender (1000)
+//     --batch_size=N                      rows per batch (1024)
+//     --row_width=N                       bytes per row, 16 of them are fixed (64)
+//     --compress=true|false               config compress_rowbatches (true)
+//     --columnar=true|false               config columnar_rowbatches (false)
+//     --compact=true|false                config exchange_use_compact_protocol
+//     --local=true|false                  config enable_local_exchange (false)
+//     --channel_buffer_size=N             bytes buffered per channel (65536)
+//     --recvr_buffer_size=N               bytes buffered per receiver (10485760)
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "common/config.h"
+#include "common/object_pool.h"
+#include "gen_cpp/DataSinks_types.h"
+#include "gen_cpp/Descriptors_types.h"
+#include "gen_cpp/PaloInternalService_types.h"
+#include "gen_cpp/Partitions_types.h"
+#include "rpc/reactor_factory.h"
+#include "runtime/data_stream_mgr.h"
+#include "runtime/data_stream_recvr.h"
+#include "runtime/data_stream_sender.h"
+#include "runtime/descriptors.h"
+#include "runtime/exec_env.h"
+#include "runtime/mem_pool.h"
+#include "runtime/mem_tracker.h"
+#include "runtime/row_batch.h"
+#include "runtime/runtime_state.h"
+#include "runtime/string_value.h"
+#include "runtime/tuple_row.h"
+#include "service/backend_options.h"
+#include "service/backend_service.h"
+#include "util/cpu_info.h"
+#include "util/disk_info.h"
+#include "util/logging.h"
+#include "util/mem_info.h"
+#include "util/runtime_profile.h"
+#include "util/stopwatch.hpp"
+
+namespace palo {
+
+static const PlanNodeId DEST_NODE_ID = 1;
+// The fixed part of a row: the partition key and the send time.
+static const int FIXED_ROW_WIDTH = 2 * sizeof(int64_t);
+static const int64_t KEY_SPACE = 1L << 30;
+
+#define CHECK_STATUS(stmt) \
+    do { \
+        Status _status = (stmt); \
+        if (!_status.ok()) { \
+            std::cerr << #stmt << " failed: " << _status.get_error_msg() << std::endl; \
+            exit(1); \
+        } \
+    } while (false)
+
+struct BenchmarkOptions {
+    std::string role = "all";
+    std::string host = "127.0.0.1";
+    int senders = 2;
+    int first_sender = 0;
+    int receivers = 2;
+    TPartitionType::type partition = TPartitionType::HASH_PARTITIONED;
+    int batches = 1000;
+    int batch_size = 1024;
+    int row_width = 64;
+    int channel_buffer_size = 65536;
+    int recvr_buffer_size = 10 * 1024 * 1024;
+};
+
+static bool parse_bool(const std::string& value) {
+    return value == "true";
+}
+
+static bool parse_option(const std::string& arg, BenchmarkOptions* options) {
+    size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos) {
+        return false;
+    }
+    std::string key = arg.substr(2, eq - 2);
+    std::string value = arg.substr(eq + 1);
+    if (key == "role") {
+        options->role = value;
+    } else if (key == "host") {
+        options->host = value;
+    } else if (key == "senders") {
+        options->senders = std::max(1, atoi(value.c_str()));
+    } else if (key == "first_sender") {
+        options->first_sender = std::max(0, atoi(value.c_str()));
+    } else if (key == "receivers") {
+        options->receivers = std::max(1, atoi(value.c_str()));
+    } else if (key == "partition") {
+        if (value == "broadcast") {
+            options->partition = TPartitionType::UNPARTITIONED;
+        } else if (value == "random") {
+            options->partition = TPartitionType::RANDOM;
+        } else if (value == "range") {
+            options->partition = TPartitionType::RANGE_PARTITIONED;
+        } else {
+            options->partition = TPartitionType::HASH_PARTITIONED;
+        }
+    } else if (key == "batches") {
+        options->batches = std::max(1, atoi(value.c_str()));
+    } else if (key == "batch_size") {
+        options->batch_size = std::max(1, atoi(value.c_str()));
+    } else if (key == "row_width") {
+        options->row_width = std::max(FIXED_ROW_WIDTH, atoi(value.c_str()));
+    } else if (key == "compress") {
+        config::compress_rowbatches = parse_bool(value);
+    } else if (key == "columnar") {
+        config::columnar_rowbatches = parse_bool(value);
+    } else if (key == "compact") {
+        config::exchange_use_compact_protocol = parse_bool(value);
+    } else if (key == "local") {
+        config::enable_local_exchange = parse_bool(value);
+    } else if (key == "channel_buffer_size") {
+        options->channel_buffer_size = std::max(1, atoi(value.c_str()));
+    } else if (key == "recvr_buffer_size") {
+        options->recvr_buffer_size = std::max(1, atoi(value.c_str()));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static int64_t wall_time_us() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+static int64_t process_cpu_ns() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000L
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000L;
+}
+
+// Latencies in power of two buckets of microseconds.
+class LatencyHistogram {
+public:
+    static const int NUM_BUCKETS = 40;
+
+    LatencyHistogram() : _buckets(NUM_BUCKETS, 0), _count(0), _max_us(0) {
+    }
+
+    void add(int64_t latency_us) {
+        latency_us = std::max(latency_us, 0L);
+        int bucket = 0;
+        while (bucket < NUM_BUCKETS - 1 && (1L << bucket) <= latency_us) {
+            ++bucket;
+        }
+        ++_buckets[bucket];
+        ++_count;
+        _max_us = std::max(_max_us, latency_us);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (int i = 0; i < NUM_BUCKETS; ++i) {
+            _buckets[i] += other._buckets[i];
+        }
+        _count += other._count;
+        _max_us = std::max(_max_us, other._max_us);
+    }
+
+    // The upper bound of the bucket holding the 'percentile'th latency.
+    int64_t percentile_us(double percentile) const {
+        int64_t rank = static_cast<int64_t>(_count * percentile / 100);
+        int64_t seen = 0;
+        for (int i = 0; i < NUM_BUCKETS; ++i) {
+            seen += _buckets[i];
+            if (seen > rank) {
+                return std::min(1L << i, _max_us);
+            }
+        }
+        return _max_us;
+    }
+
+    void print(std::ostream* out) const {
+        *out << "batch latency: count=" << _count
+            << " p50<=" << percentile_us(50) << "us"
+            << " p90<=" << percentile_us(90) << "us"
+            << " p99<=" << percentile_us(99) << "us"
+            << " max=" << _max_us << "us" << std::endl;
+        for (int i = 0; i < NUM_BUCKETS; ++i) {
+            if (_buckets[i] == 0) {
+                continue;
+            }
+            *out << "    < " << std::setw(12) << (1L << i) << "us "
+                << std::setw(10) << _buckets[i] << std::endl;
+        }
+    }
+
+private:
+    std::vector<int64_t> _buckets;
+    int64_t _count;
+    int64_t _max_us;
+};
+
+class ExchangeBenchmark {
+public:
+    ExchangeBenchmark(const BenchmarkOptions& options, ExecEnv* exec_env) :
+            _options(options),
+            _exec_env(exec_env),
+            _payload(options.row_width - FIXED_ROW_WIDTH, 'x'),
+            _rows_received(0),
+            _bytes_sent(0),
+            _serialize_ns(0),
+            _transmit_ns(0) {
+        create_row_desc();
+        create_sink();
+        for (int i = 0; i < _options.receivers; ++i) {
+            TPlanFragmentDestination dest;
+            dest.fragment_instance_id = instance_id(i);
+            dest.server.hostname = _options.host;
+            dest.server.port = config::be_rpc_port;
+            _destinations.push_back(dest);
+        }
+    }
+
+    void run() {
+        bool run_receivers = _options.role != "sender";
+        bool run_senders = _options.role != "receiver";
+
+        RuntimeState recvr_state(TUniqueId(), TQueryOptions(), "", _exec_env);
+        recvr_state.set_desc_tbl(_desc_tbl);
+        recvr_state.init_mem_trackers(TUniqueId());
+        std::vector<boost::shared_ptr<DataStreamRecvr>> recvrs;
+        std::vector<LatencyHistogram> histograms(_options.receivers);
+        std::vector<std::thread> threads;
+        RuntimeProfile* recvr_profile = NULL;
+        if (run_receivers) {
+            for (int i = 0; i < _options.receivers; ++i) {
+                RuntimeProfile* profile = _obj_pool.add(
+                        new RuntimeProfile(&_obj_pool, "DataStreamRecvr"));
+                recvr_profile = recvr_profile == NULL ? profile : recvr_profile;
+                recvrs.push_back(_exec_env->stream_mgr()->create_recvr(
+                        &recvr_state, *_row_desc, instance_id(i), DEST_NODE_ID,
+                        _options.senders, _options.recvr_buffer_size, profile, false));
+            }
+        }
+
+        int64_t cpu_start = process_cpu_ns();
+        MonotonicStopWatch watch;
+        watch.start();
+        if (run_receivers) {
+            for (int i = 0; i < _options.receivers; ++i) {
+                threads.emplace_back(&ExchangeBenchmark::receive, this,
+                                     recvrs[i].get(), &histograms[i]);
+            }
+        }
+        if (run_senders) {
+            for (int i = 0; i < _options.senders; ++i) {
+                threads.emplace_back(&ExchangeBenchmark::send, this,
+                                     _options.first_sender + i);
+            }
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        double seconds = watch.elapsed_time() / 1e9;
+        int64_t cpu_ns = process_cpu_ns() - cpu_start;
+        for (auto& recvr : recvrs) {
+            recvr->close();
+        }
+
+        int64_t rows_sent = run_senders
+            ? static_cast<int64_t>(_options.senders) * _options.batches * _options.batch_size
+            : 0;
+        std::cout << std::fixed << std::setprecision(1);
+        if (run_senders) {
+            std::cout << "sent " << rows_sent << " rows, " << _bytes_sent << " bytes in "
+                << seconds << " s: " << rows_sent / seconds / 1e6 << " M rows/s, "
+                << _bytes_sent / seconds / (1 << 20) << " MB/s" << std::endl;
+            std::cout << "senders spent " << _serialize_ns / 1e6 << " ms serializing and "
+                << _transmit_ns / 1e6 << " ms transmitting" << std::endl;
+        }
+        if (run_receivers) {
+            std::cout << "received " << _rows_received << " rows: "
+                << _rows_received / seconds / 1e6 << " M rows/s" << std::endl;
+        }
+        std::cout << "process cpu " << cpu_ns / 1e6 << " ms";
+        if (_bytes_sent > 0) {
+            std::cout << ", " << std::setprecision(2)
+                << static_cast<double>(cpu_ns) / _bytes_sent << " cpu ns per byte sent";
+        }
+        std::cout << std::endl;
+        if (run_receivers) {
+            LatencyHistogram all;
+            for (const LatencyHistogram& histogram : histograms) {
+                all.merge(histogram);
+            }
+            all.print(&std::cout);
+            std::cout << "profile of the first receiver:" << std::endl;
+            recvr_profile->pretty_print(&std::cout);
+        }
+    }
+
+private:
+    static TUniqueId instance_id(int receiver) {
+        TUniqueId id;
+        id.hi = 0x5eed;
+        id.lo = receiver;
+        return id;
+    }
+
+    static TExpr key_expr() {
+        TExprNode expr_node;
+        expr_node.node_type = TExprNodeType::SLOT_REF;
+        expr_node.type.types.push_back(TTypeNode());
+        expr_node.type.types.back().__isset.scalar_type = true;
+        expr_node.type.types.back().scalar_type.type = TPrimitiveType::BIGINT;
+        expr_node.num_children = 0;
+        TSlotRef slot_ref;
+        slot_ref.slot_id = 0;
+        slot_ref.tuple_id = 0;
+        expr_node.__set_slot_ref(slot_ref);
+        TExpr expr;
+        expr.nodes.push_back(expr_node);
+        return expr;
+    }
+
+    static TPartitionKey range_key(int sign, int64_t value) {
+        TPartitionKey key;
+        key.sign = sign;
+        if (sign == 0) {
+            key.__set_type(TPrimitiveType::BIGINT);
+            key.__set_key(std::to_string(value));
+        }
+        return key;
+    }
+
+    // A tuple of the key, the send time and a string padding the row to its width.
+    void create_row_desc() {
+        TDescriptorTable thrift_desc_tbl;
+        TTupleDescriptor tuple_desc;
+        tuple_desc.__set_id(0);
+        tuple_desc.__set_byteSize(FIXED_ROW_WIDTH + sizeof(StringValue));
+        tuple_desc.__set_numNullBytes(0);
+        thrift_desc_tbl.tupleDescriptors.push_back(tuple_desc);
+
+        TPrimitiveType::type types[] = {
+            TPrimitiveType::BIGINT, TPrimitiveType::BIGINT, TPrimitiveType::VARCHAR};
+        int offsets[] = {0, sizeof(int64_t), FIXED_ROW_WIDTH};
+        for (int i = 0; i < 3; ++i) {
+            TSlotDescriptor slot_desc;
+            slot_desc.__set_id(i);
+            slot_desc.__set_parent(0);
+            slot_desc.slotType.types.push_back(TTypeNode());
+            slot_desc.slotType.types.back().__isset.scalar_type = true;
+            slot_desc.slotType.types.back().scalar_type.type = types[i];
+            if (types[i] == TPrimitiveType::VARCHAR) {
+                slot_desc.slotType.types.back().scalar_type.__set_len(
+                        std::max<int>(_payload.size(), 1));
+            }
+            slot_desc.__set_columnPos(i);
+            slot_desc.__set_byteOffset(offsets[i]);
+            slot_desc.__set_nullIndicatorByte(0);
+            slot_desc.__set_nullIndicatorBit(-1);
+            slot_desc.__set_slotIdx(i);
+            slot_desc.__set_isMaterialized(true);
+            thrift_desc_tbl.slotDescriptors.push_back(slot_desc);
+        }
+        CHECK_STATUS(DescriptorTbl::create(&_obj_pool, thrift_desc_tbl, &_desc_tbl));
+        _row_desc = _obj_pool.add(new RowDescriptor(
+                    *_desc_tbl, std::vector<TTupleId>(1, 0), std::vector<bool>(1, false)));
+    }
+
+    void create_sink() {
+        _sink.dest_node_id = DEST_NODE_ID;
+        _sink.output_partition.type = _options.partition;
+        if (_options.partition == TPartitionType::HASH_PARTITIONED
+                || _options.partition == TPartitionType::RANGE_PARTITIONED) {
+            _sink.output_partition.__isset.partition_exprs = true;
+            _sink.output_partition.partition_exprs.push_back(key_expr());
+        }
+        if (_options.partition == TPartitionType::RANGE_PARTITIONED) {
+            // ranges of equal width over the key space, each distributed by the key
+            int num_parts = _options.receivers * 4;
+            int64_t step = KEY_SPACE / num_parts;
+            for (int i = 0; i < num_parts; ++i) {
+                TRangePartition partition;
+                partition.partition_id = i;
+                partition.range.start_key = range_key(i == 0 ? -1 : 0, i * step);
+                partition.range.end_key = range_key(i == num_parts - 1 ? 1 : 0, (i + 1) * step);
+                partition.range.include_start_key = true;
+                partition.range.include_end_key = false;
+                partition.__set_distributed_exprs(std::vector<TExpr>(1, key_expr()));
+                partition.__set_distribute_bucket(8);
+                _sink.output_partition.partition_infos.push_back(partition);
+            }
+            _sink.output_partition.__isset.partition_infos = true;
+        }
+    }
+
+    void fill_batch(RowBatch* batch, std::mt19937_64* rng) {
+        batch->reset();
+        int tuple_size = FIXED_ROW_WIDTH + sizeof(StringValue);
+        uint8_t* tuple_mem = batch->tuple_data_pool()->allocate(
+                tuple_size * _options.batch_size);
+        int64_t now = wall_time_us();
+        std::uniform_int_distribution<int64_t> keys(0, KEY_SPACE - 1);
+        for (int i = 0; i < _options.batch_size; ++i) {
+            uint8_t* tuple = tuple_mem + i * tuple_size;
+            *reinterpret_cast<int64_t*>(tuple) = keys(*rng);
+            *reinterpret_cast<int64_t*>(tuple + sizeof(int64_t)) = now;
+            *reinterpret_cast<StringValue*>(tuple + FIXED_ROW_WIDTH) =
+                StringValue(const_cast<char*>(_payload.data()), _payload.size());
+            int idx = batch->add_row();
+            batch->get_row(idx)->set_tuple(0, reinterpret_cast<Tuple*>(tuple));
+            batch->commit_last_row();
+        }
+    }
+
+    void send(int sender_id) {
+        ObjectPool pool;
+        RuntimeState state(TUniqueId(), TQueryOptions(), "", _exec_env);
+        state.set_desc_tbl(_desc_tbl);
+        state.init_mem_trackers(TUniqueId());
+        DataStreamSender sender(&pool, sender_id, *_row_desc, _sink, _destinations,
+                                _options.channel_buffer_size);
+        TDataSink data_sink;
+        data_sink.__set_type(TDataSinkType::DATA_STREAM_SINK);
+        data_sink.__set_stream_sink(_sink);
+        CHECK_STATUS(sender.init(data_sink));
+        CHECK_STATUS(sender.prepare(&state));
+        CHECK_STATUS(sender.open(&state));
+
+        MemTracker tracker;
+        RowBatch batch(*_row_desc, _options.batch_size, &tracker);
+        std::mt19937_64 rng(sender_id);
+        for (int i = 0; i < _options.batches; ++i) {
+            fill_batch(&batch, &rng);
+            CHECK_STATUS(sender.send(&state, &batch));
+        }
+        CHECK_STATUS(sender.close(&state, Status::OK));
+        batch.reset();
+
+        std::lock_guard<std::mutex> l(_lock);
+        _bytes_sent += sender.get_num_data_bytes_sent();
+        _serialize_ns += counter_value(sender.profile(), "SerializeBatchTime");
+        _transmit_ns += counter_value(sender.profile(), "ThriftTransmitTime(*)");
+    }
+
+    static int64_t counter_value(RuntimeProfile* profile, const std::string& name) {
+        RuntimeProfile::Counter* counter = profile->get_counter(name);
+        return counter == NULL ? 0 : counter->value();
+    }
+
+    void receive(DataStreamRecvr* recvr, LatencyHistogram* histogram) {
+        int64_t rows = 0;
+        while (true) {
+            RowBatch* batch = NULL;
+            CHECK_STATUS(recvr->get_batch(&batch));
+            if (batch == NULL) {
+                break;
+            }
+            if (batch->num_rows() == 0) {
+                continue;
+            }
+            // rows are appended in the order they were sent, the first is the oldest
+            int64_t sent_us = *reinterpret_cast<int64_t*>(
+                    batch->get_row(0)->get_tuple(0)->get_slot(sizeof(int64_t)));
+            histogram->add(wall_time_us() - sent_us);
+            rows += batch->num_rows();
+        }
+        std::lock_guard<std::mutex> l(_lock);
+        _rows_received += rows;
+    }
+
+    const BenchmarkOptions& _options;
+    ExecEnv* _exec_env;
+    const std::string _payload;
+    ObjectPool _obj_pool;
+    DescriptorTbl* _desc_tbl;
+    const RowDescriptor* _row_desc;
+    TDataStreamSink _sink;
+    std::vector<TPlanFragmentDestination> _destinations;
+
+    std::mutex _lock;
+    int64_t _rows_received;
+    int64_t _bytes_sent;
+    int64_t _serialize_ns;
+    int64_t _transmit_ns;
+};
+
+}  // namespace palo
+
+int main(int argc, char** argv) {
+    palo::config::enable_local_exchange = false;
+    palo::BenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (!palo::parse_option(argv[i], &options)) {
+            std::cerr << "invalid option " << argv[i]
+                << ", see the head of data_stream_benchmark.cpp" << std::endl;
+            return -1;
+        }
+    }
+    palo::init_glog("be-benchmark");
+    palo::CpuInfo::init();
+    palo::DiskInfo::init();
+    palo::MemInfo::init();
+    if (!palo::BackendOptions::init()) {
+        std::cerr << "failed to init the backend options" << std::endl;
+        return -1;
+    }
+
+    palo::ExecEnv exec_env;
+    exec_env.set_enable_webserver(false);
+    if (options.role != "sender") {
+        CHECK_STATUS(palo::BackendService::create_rpc_service(&exec_env));
+    } else {
+        palo::ReactorFactory::initialize(
+                palo::config::rpc_reactor_threads, palo::config::rpc_reactor_cpu_affinity);
+    }
+    CHECK_STATUS(exec_env.start_services());
+
+    palo::ExchangeBenchmark benchmark(options, &exec_env);
+    benchmark.run();
+    return 0;
+}
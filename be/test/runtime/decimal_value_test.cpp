@@ -537,6 +537,42 @@ TEST_F(DecimalValueTest, float_to_decimal) {
     ASSERT_STREQ("1.2", value->to_string().c_str());
     delete value;
 }
+
+TEST_F(DecimalValueTest, decimal_sum) {
+    const char* values[] = {
+        "1.5", "-0.25", "999999999999999999.999999999", "12345678901234567890123.5",
+        "-3", "0.0000000001", "7.123456789"};
+    DecimalSum sum;
+    sum.init();
+    DecimalValue expected(0);
+    for (int i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+        DecimalValue value = DecimalValue(std::string(values[i]));
+        palo_udf::DecimalVal val;
+        value.to_decimal_val(&val);
+        sum.add(val);
+        expected = expected + value;
+    }
+    ASSERT_STREQ(expected.to_string().c_str(), sum.value().to_string().c_str());
+
+    // sums of values that are kept as scaled int128 are moved to the wide sum when large
+    DecimalValue big = DecimalValue(std::string("999999999999999999.999999999"));
+    palo_udf::DecimalVal big_val;
+    big.to_decimal_val(&big_val);
+    DecimalSum other;
+    other.init();
+    for (int i = 0; i < 100000; ++i) {
+        other.add(big_val);
+        expected = expected + big;
+    }
+    other.subtract(big_val);
+    expected = expected - big;
+    sum.merge(other);
+    ASSERT_STREQ(expected.to_string().c_str(), sum.value().to_string().c_str());
+
+    DecimalSum empty;
+    empty.init();
+    ASSERT_STREQ("0", empty.value().to_string().c_str());
+}
 } // end namespace palo
 
 int main(int argc, char** argv) {
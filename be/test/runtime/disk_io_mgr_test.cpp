@@ -430,6 +430,89 @@ TEST_F(DiskIoMgrTest, SingleReader) {
     EXPECT_EQ(mem_tracker.consumption(), 0);
 }
 
+// Reads and writes through io_uring. Disks fall back to blocking threads if the kernel
+// doesn't support it, the results must be the same either way.
+TEST_F(DiskIoMgrTest, UringReaderWriter) {
+    config::disk_io_uring_queue_depth = 4;
+    MemTracker mem_tracker(LARGE_MEM_LIMIT);
+    const char* tmp_file = "/tmp/disk_io_mgr_test.txt";
+    const char* data = "abcdefghijklm";
+    int len = strlen(data);
+    CreateTempFile(tmp_file, data);
+    struct stat stat_val;
+    stat(tmp_file, &stat_val);
+
+    for (int num_disks = 1; num_disks <= 3; num_disks += 2) {
+        _pool.reset(new ObjectPool);
+        DiskIoMgr io_mgr(num_disks, 1, 1, 1);
+        Status status = io_mgr.init(&mem_tracker);
+        ASSERT_TRUE(status.ok());
+        MemTracker reader_mem_tracker(LARGE_MEM_LIMIT);
+        DiskIoMgr::RequestContext* reader;
+        status = io_mgr.register_context(&reader, &reader_mem_tracker);
+        ASSERT_TRUE(status.ok());
+
+        vector<DiskIoMgr::ScanRange*> ranges;
+        for (int i = 0; i < len; ++i) {
+            ranges.push_back(init_range(2, tmp_file, 0, len, i % num_disks,
+                        stat_val.st_mtime));
+        }
+        status = io_mgr.add_scan_ranges(reader, ranges);
+        ASSERT_TRUE(status.ok());
+
+        AtomicInt<int> num_ranges_processed;
+        thread_group threads;
+        for (int i = 0; i < 3; ++i) {
+            threads.add_thread(new thread(scan_range_thread, &io_mgr, reader, data,
+                        len, Status::OK, 0, &num_ranges_processed));
+        }
+        threads.join_all();
+        EXPECT_EQ(num_ranges_processed, ranges.size());
+        io_mgr.unregister_context(reader);
+        EXPECT_EQ(reader_mem_tracker.consumption(), 0);
+    }
+
+    // Write 4-byte integers and validate each by reading it back.
+    const int num_ranges = 50;
+    ASSERT_EQ(0, CreateTempFile(tmp_file, num_ranges * sizeof(int32_t)));
+    scoped_ptr<DiskIoMgr> read_io_mgr(new DiskIoMgr(1, 1, 1, 10));
+    MemTracker reader_mem_tracker(LARGE_MEM_LIMIT);
+    ASSERT_TRUE(read_io_mgr->init(&reader_mem_tracker).ok());
+    DiskIoMgr::RequestContext* reader;
+    ASSERT_TRUE(read_io_mgr->register_context(&reader, &reader_mem_tracker).ok());
+    {
+        _pool.reset(new ObjectPool);
+        _num_ranges_written = 0;
+        DiskIoMgr io_mgr(2, 1, 1, 10);
+        ASSERT_TRUE(io_mgr.init(&mem_tracker).ok());
+        DiskIoMgr::RequestContext* writer;
+        io_mgr.register_context(&writer, &mem_tracker);
+        for (int i = 0; i < num_ranges; ++i) {
+            int32_t* data = _pool->add(new int32_t);
+            *data = rand();
+            DiskIoMgr::WriteRange** new_range = _pool->add(new DiskIoMgr::WriteRange*);
+            DiskIoMgr::WriteRange::WriteDoneCallback callback =
+                bind(mem_fn(&DiskIoMgrTest::write_validate_callback), this, num_ranges,
+                        new_range, read_io_mgr.get(), reader, data, Status::OK, _1);
+            *new_range = _pool->add(new DiskIoMgr::WriteRange(tmp_file,
+                        i * sizeof(int32_t), i % 2, callback));
+            (*new_range)->set_data(reinterpret_cast<uint8_t*>(data), sizeof(int32_t));
+            EXPECT_TRUE(io_mgr.add_write_range(writer, *new_range).ok());
+        }
+        {
+            unique_lock<mutex> lock(_written_mutex);
+            while (_num_ranges_written < num_ranges) {
+                _writes_done.wait(lock);
+            }
+        }
+        io_mgr.unregister_context(writer);
+    }
+    read_io_mgr->unregister_context(reader);
+    read_io_mgr.reset();
+    EXPECT_EQ(mem_tracker.consumption(), 0);
+    config::disk_io_uring_queue_depth = 0;
+}
+
 // This test issues adding additional scan ranges while there are some still in flight.
 TEST_F(DiskIoMgrTest, AddScanRangeTest) {
     MemTracker mem_tracker(LARGE_MEM_LIMIT);
@@ -0,0 +1,98 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "gen_cpp/PaloInternalService_types.h"
+#include "runtime/descriptors.h"
+#include "runtime/fragment_template_cache.h"
+#include "util/logging.h"
+
+namespace palo {
+
+class FragmentTemplateCacheTest : public testing::Test {
+public:
+    FragmentTemplateCacheTest() { }
+
+protected:
+    TExecPlanFragmentParams make_request(int byte_size, TPlanNodeType::type node_type) {
+        TExecPlanFragmentParams request;
+        TTupleDescriptor tuple_desc;
+        tuple_desc.id = 0;
+        tuple_desc.byteSize = byte_size;
+        tuple_desc.numNullBytes = 0;
+        request.__isset.desc_tbl = true;
+        request.desc_tbl.tupleDescriptors.push_back(tuple_desc);
+
+        TPlanNode node;
+        node.node_id = 0;
+        node.node_type = node_type;
+        request.__isset.fragment = true;
+        request.fragment.__isset.plan = true;
+        request.fragment.plan.nodes.push_back(node);
+        request.query_options.disable_codegen = true;
+        return request;
+    }
+};
+
+TEST_F(FragmentTemplateCacheTest, share_template) {
+    FragmentTemplateCache cache(1024 * 1024);
+    TExecPlanFragmentParams request = make_request(8, TPlanNodeType::OLAP_SCAN_NODE);
+    ASSERT_TRUE(FragmentTemplateCache::is_cacheable(request));
+
+    boost::shared_ptr<const FragmentTemplate> tmpl;
+    ASSERT_TRUE(cache.get_or_create(request, &tmpl).ok());
+    ASSERT_TRUE(tmpl->desc_tbl != NULL);
+    ASSERT_EQ(8, tmpl->desc_tbl->get_tuple_descriptor(0)->byte_size());
+    ASSERT_NE(0, tmpl->plan_fingerprint);
+
+    // other scan ranges and instances of the same plan share it
+    request.params.fragment_instance_id.lo = 1;
+    boost::shared_ptr<const FragmentTemplate> other;
+    ASSERT_TRUE(cache.get_or_create(request, &other).ok());
+    ASSERT_EQ(tmpl.get(), other.get());
+
+    // another descriptor table
+    ASSERT_TRUE(cache.get_or_create(make_request(16, TPlanNodeType::OLAP_SCAN_NODE),
+                                    &other).ok());
+    ASSERT_NE(tmpl.get(), other.get());
+    ASSERT_EQ(16, other->desc_tbl->get_tuple_descriptor(0)->byte_size());
+
+    // another plan
+    ASSERT_TRUE(cache.get_or_create(make_request(8, TPlanNodeType::EXCHANGE_NODE),
+                                    &other).ok());
+    ASSERT_NE(tmpl.get(), other.get());
+    ASSERT_NE(tmpl->plan_fingerprint, other->plan_fingerprint);
+}
+
+TEST_F(FragmentTemplateCacheTest, codegen_not_cacheable) {
+    TExecPlanFragmentParams request = make_request(8, TPlanNodeType::OLAP_SCAN_NODE);
+    request.query_options.disable_codegen = false;
+    ASSERT_FALSE(FragmentTemplateCache::is_cacheable(request));
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/mem_arbitrator.h"
+
+#include <algorithm>
+#include <functional>
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "gen_cpp/PlanNodes_types.h"
+#include "runtime/mem_tracker.h"
+#include "util/logging.h"
+
+namespace palo {
+
+// Releases up to 'available' bytes from 'tracker'.
+static int64_t release_from(MemTracker* tracker, int64_t* available, int64_t bytes) {
+    int64_t freed = std::min(*available, bytes);
+    tracker->release(freed);
+    *available -= freed;
+    return freed;
+}
+
+TEST(MemArbitratorTest, Reclaim) {
+    MemTracker query_tracker(1000);
+    MemTracker instance_tracker(-1, "instance", &query_tracker);
+    MemArbitrator arbitrator(&instance_tracker);
+
+    int64_t cached = 300;
+    int owner = 0;
+    arbitrator.add_reclaimer(&owner, std::bind(release_from, &instance_tracker, &cached,
+                                               std::placeholders::_1));
+    instance_tracker.consume(1200);
+    ASSERT_TRUE(instance_tracker.any_limit_exceeded());
+    ASSERT_TRUE(arbitrator.relieve());
+    ASSERT_EQ(1000, query_tracker.consumption());
+    ASSERT_EQ(100, cached);
+
+    // nothing left to reclaim and nobody to spill
+    instance_tracker.consume(500);
+    ASSERT_FALSE(arbitrator.relieve());
+    ASSERT_EQ(0, cached);
+
+    arbitrator.remove_reclaimers(&owner);
+    instance_tracker.release(1400);
+}
+
+TEST(MemArbitratorTest, Spill) {
+    MemTracker query_tracker(1000);
+    MemTracker instance_tracker(-1, "instance", &query_tracker);
+    MemArbitrator arbitrator(&instance_tracker);
+    config::mem_limit_grace_percent = 10;
+
+    int64_t generation = arbitrator.register_spiller();
+    ASSERT_FALSE(arbitrator.spill_requested(&generation));
+
+    // within the grace the spillers get a chance
+    instance_tracker.consume(1050);
+    ASSERT_TRUE(arbitrator.relieve());
+    ASSERT_TRUE(arbitrator.spill_requested(&generation));
+    ASSERT_FALSE(arbitrator.spill_requested(&generation));
+
+    // beyond it the instance fails
+    instance_tracker.consume(100);
+    ASSERT_FALSE(arbitrator.relieve());
+    ASSERT_EQ(2, arbitrator.num_reliefs());
+
+    // without a spiller there is no grace
+    arbitrator.unregister_spiller();
+    instance_tracker.release(100);
+    ASSERT_FALSE(arbitrator.relieve());
+    instance_tracker.release(1050);
+}
+
+TEST(MemArbitratorTest, ExceededPlans) {
+    TPlan plan;
+    plan.nodes.resize(1);
+    plan.nodes[0].node_id = 1;
+    int64_t fingerprint = MemArbitrator::plan_fingerprint(plan);
+    ASSERT_EQ(fingerprint, MemArbitrator::plan_fingerprint(plan));
+    ASSERT_FALSE(MemArbitrator::plan_exceeded_before(fingerprint));
+
+    MemTracker tracker(100);
+    MemArbitrator arbitrator(&tracker);
+    arbitrator.set_plan_fingerprint(fingerprint);
+    arbitrator.record_exceeded();
+    ASSERT_TRUE(MemArbitrator::plan_exceeded_before(fingerprint));
+
+    plan.nodes[0].node_id = 2;
+    ASSERT_FALSE(MemArbitrator::plan_exceeded_before(MemArbitrator::plan_fingerprint(plan)));
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
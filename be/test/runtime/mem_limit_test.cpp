@@ -17,6 +17,7 @@
 
 #include <gtest/gtest.h>
 
+#include "common/config.h"
 #include "util/metrics.h"
 #include "util/logging.h"
 
@@ -186,6 +187,35 @@ TEST(MemTestTest, TrackerHierarchyTryConsume) {
     EXPECT_FALSE(p.limit_exceeded());
 }
 
+TEST(MemTestTest, ConsumptionShards) {
+    config::mem_tracker_consume_batch_bytes = 1024;
+    // far from the limit, the bytes of p are buffered per cpu
+    MemTracker p(1024 * 1024);
+    MemTracker c1(-1, "", &p);
+    MemTracker c2(-1, "", &p);
+
+    for (int i = 0; i < 100; ++i) {
+        c1.consume(100);
+    }
+    EXPECT_EQ(p.consumption(), 100 * 100);
+    EXPECT_EQ(c1.consumption(), 100 * 100);
+
+    // near the limit, try_consume() is precise
+    EXPECT_TRUE(c2.try_consume(1000 * 1024 - 100 * 100));
+    EXPECT_FALSE(c2.try_consume(24 * 1024 + 1));
+    EXPECT_EQ(p.consumption(), 1000 * 1024);
+    EXPECT_TRUE(c1.try_consume(24 * 1024));
+    EXPECT_EQ(p.consumption(), 1024 * 1024);
+    EXPECT_FALSE(p.limit_exceeded());
+    c1.consume(1);
+    EXPECT_TRUE(p.limit_exceeded());
+
+    c1.release(100 * 100 + 24 * 1024 + 1);
+    c2.release(1000 * 1024 - 100 * 100);
+    EXPECT_EQ(p.consumption(), 0);
+    config::mem_tracker_consume_batch_bytes = 0;
+}
+
 #if 0
 class GcFunctionHelper {
     public:
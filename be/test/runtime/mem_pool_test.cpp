@@ -118,6 +118,30 @@ TEST(MemPoolTest, Keep) {
     EXPECT_EQ(p2.get_total_chunk_sizes(), 4 * 1024);
 }
 
+// Tests that clear_and_trim() keeps chunks up to the limit and frees the others.
+TEST(MemPoolTest, ClearAndTrim) {
+    MemTracker tracker(-1);
+    MemPool p(&tracker);
+    p.allocate(4 * 1024);
+    p.allocate(8 * 1024);
+    p.allocate(16 * 1024);
+    EXPECT_EQ(tracker.consumption(), (4 + 8 + 16) * 1024);
+    p.clear_and_trim(20 * 1024);
+    EXPECT_EQ(p.total_allocated_bytes(), 0);
+    EXPECT_EQ(p.get_total_chunk_sizes(), (4 + 8) * 1024);
+    EXPECT_EQ(p.total_reserved_bytes(), (4 + 8) * 1024);
+    EXPECT_EQ(tracker.consumption(), (4 + 8) * 1024);
+
+    // the kept chunks are reused
+    p.allocate(8 * 1024);
+    EXPECT_EQ(p.get_total_chunk_sizes(), (4 + 8) * 1024);
+    EXPECT_EQ(p.total_allocated_bytes(), 8 * 1024);
+
+    p.clear_and_trim(0);
+    EXPECT_EQ(p.get_total_chunk_sizes(), 0);
+    EXPECT_EQ(tracker.consumption(), 0);
+}
+
 // Tests that we can return partial allocations.
 TEST(MemPoolTest, ReturnPartial) {
     MemTracker tracker(-1);
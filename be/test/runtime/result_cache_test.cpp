@@ -0,0 +1,236 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "gen_cpp/PaloInternalService_types.h"
+#include "runtime/result_cache.h"
+#include "util/logging.h"
+
+namespace palo {
+
+class ResultCacheTest : public testing::Test {
+public:
+    ResultCacheTest() { }
+
+protected:
+    boost::shared_ptr<const CachedResult> make_result(const std::string& row, int num_rows) {
+        boost::shared_ptr<CachedResult> result(new CachedResult());
+        result->batches.push_back(std::vector<std::string>(num_rows, row));
+        result->bytes = row.size() * num_rows;
+        return result;
+    }
+
+    TExecPlanFragmentParams make_request(TPlanNodeType::type node_type) {
+        TExecPlanFragmentParams request;
+        TPlanNode node;
+        node.node_id = 0;
+        node.node_type = node_type;
+        request.fragment.__isset.plan = true;
+        request.fragment.plan.nodes.push_back(node);
+        request.fragment.__isset.output_sink = true;
+        request.fragment.output_sink.type = TDataSinkType::RESULT_SINK;
+        return request;
+    }
+
+    TExecPlanFragmentParams make_partial_agg_request() {
+        TExecPlanFragmentParams request;
+        TPlanNode agg_node;
+        agg_node.node_id = 0;
+        agg_node.node_type = TPlanNodeType::AGGREGATION_NODE;
+        agg_node.limit = -1;
+        agg_node.agg_node.need_finalize = false;
+        TPlanNode scan_node;
+        scan_node.node_id = 1;
+        scan_node.node_type = TPlanNodeType::OLAP_SCAN_NODE;
+        scan_node.limit = -1;
+        scan_node.olap_scan_node.is_preaggregation = true;
+        request.fragment.__isset.plan = true;
+        request.fragment.plan.nodes.push_back(agg_node);
+        request.fragment.plan.nodes.push_back(scan_node);
+        request.fragment.__isset.output_sink = true;
+        request.fragment.output_sink.type = TDataSinkType::DATA_STREAM_SINK;
+        add_tablet(&request, 10, "2");
+        return request;
+    }
+
+    void add_tablet(TExecPlanFragmentParams* request, int64_t tablet_id,
+                    const std::string& version) {
+        TScanRangeParams scan_range;
+        scan_range.scan_range.__isset.palo_scan_range = true;
+        scan_range.scan_range.palo_scan_range.tablet_id = tablet_id;
+        scan_range.scan_range.palo_scan_range.version = version;
+        scan_range.scan_range.palo_scan_range.version_hash = "0";
+        scan_range.scan_range.palo_scan_range.schema_hash = "0";
+        request->params.per_node_scan_ranges[1].push_back(scan_range);
+    }
+};
+
+TEST_F(ResultCacheTest, lookup_insert) {
+    ResultCache cache(1024);
+    ASSERT_TRUE(cache.lookup("key1").get() == NULL);
+
+    cache.insert("key1", make_result("abc", 10));
+    boost::shared_ptr<const CachedResult> result = cache.lookup("key1");
+    ASSERT_TRUE(result.get() != NULL);
+    ASSERT_EQ(1, result->batches.size());
+    ASSERT_EQ(10, result->batches[0].size());
+    ASSERT_EQ("abc", result->batches[0][3]);
+    ASSERT_TRUE(cache.lookup("key2").get() == NULL);
+}
+
+TEST_F(ResultCacheTest, evict_least_recently_used) {
+    ResultCache cache(100);
+    cache.insert("k1", make_result("0123456789", 3));
+    cache.insert("k2", make_result("0123456789", 3));
+    // k1 is used more recently than k2 now
+    ASSERT_TRUE(cache.lookup("k1").get() != NULL);
+    cache.insert("k3", make_result("0123456789", 3));
+
+    ASSERT_TRUE(cache.lookup("k1").get() != NULL);
+    ASSERT_TRUE(cache.lookup("k2").get() == NULL);
+    ASSERT_TRUE(cache.lookup("k3").get() != NULL);
+    ASSERT_LE(cache.size_bytes(), 100);
+
+    // larger than the whole cache
+    cache.insert("k4", make_result("0123456789", 20));
+    ASSERT_TRUE(cache.lookup("k4").get() == NULL);
+    ASSERT_TRUE(cache.lookup("k1").get() != NULL);
+}
+
+TEST_F(ResultCacheTest, make_key) {
+    std::string key1;
+    std::string key2;
+    TExecPlanFragmentParams request = make_request(TPlanNodeType::OLAP_SCAN_NODE);
+    ASSERT_TRUE(ResultCache::make_key(request, &key1));
+    ASSERT_TRUE(ResultCache::make_key(request, &key2));
+    ASSERT_EQ(key1, key2);
+
+    // a new tablet version gives a new key
+    TScanRangeParams scan_range;
+    scan_range.scan_range.__isset.palo_scan_range = true;
+    scan_range.scan_range.palo_scan_range.tablet_id = 10;
+    scan_range.scan_range.palo_scan_range.version = "2";
+    request.params.per_node_scan_ranges[0].push_back(scan_range);
+    ASSERT_TRUE(ResultCache::make_key(request, &key1));
+    request.params.per_node_scan_ranges[0][0].scan_range.palo_scan_range.version = "3";
+    ASSERT_TRUE(ResultCache::make_key(request, &key2));
+    ASSERT_NE(key1, key2);
+
+    // a scan range without tablet versions
+    request.params.per_node_scan_ranges[0][0].scan_range.__isset.palo_scan_range = false;
+    request.params.per_node_scan_ranges[0][0].scan_range.__isset.broker_scan_range = true;
+    ASSERT_FALSE(ResultCache::make_key(request, &key1));
+
+    // input from other fragment instances
+    ASSERT_FALSE(ResultCache::make_key(make_request(TPlanNodeType::EXCHANGE_NODE), &key1));
+
+    // scans of data without versions
+    ASSERT_FALSE(ResultCache::make_key(make_request(TPlanNodeType::MYSQL_SCAN_NODE), &key1));
+    ASSERT_FALSE(ResultCache::make_key(make_request(TPlanNodeType::SCHEMA_SCAN_NODE), &key1));
+    ASSERT_FALSE(ResultCache::make_key(make_request(TPlanNodeType::BROKER_SCAN_NODE), &key1));
+    ASSERT_FALSE(ResultCache::make_key(make_request(TPlanNodeType::KUDU_SCAN_NODE), &key1));
+
+    // a function with a different result every time
+    request = make_request(TPlanNodeType::OLAP_SCAN_NODE);
+    TExprNode fn_node;
+    fn_node.node_type = TExprNodeType::FUNCTION_CALL;
+    fn_node.__isset.fn = true;
+    fn_node.fn.name.function_name = "now";
+    request.fragment.plan.nodes[0].conjuncts.resize(1);
+    request.fragment.plan.nodes[0].__isset.conjuncts = true;
+    request.fragment.plan.nodes[0].conjuncts[0].nodes.push_back(fn_node);
+    ASSERT_FALSE(ResultCache::make_key(request, &key1));
+
+    // a column named like that is fine
+    request.fragment.plan.nodes[0].conjuncts[0].nodes[0].fn.name.function_name = "nowhere";
+    ASSERT_TRUE(ResultCache::make_key(request, &key1));
+}
+
+TEST_F(ResultCacheTest, partial_agg_make_key) {
+    std::string key1;
+    std::string key2;
+    TabletVersionMap versions1;
+    TabletVersionMap versions2;
+    TExecPlanFragmentParams request = make_partial_agg_request();
+    ASSERT_TRUE(PartialAggCache::make_key(request, &key1, &versions1));
+    ASSERT_EQ(1, versions1.size());
+    ASSERT_EQ(2, versions1[10].version);
+
+    // a new tablet version keeps the key
+    request.params.per_node_scan_ranges[1][0].scan_range.palo_scan_range.version = "5";
+    ASSERT_TRUE(PartialAggCache::make_key(request, &key2, &versions2));
+    ASSERT_EQ(key1, key2);
+    ASSERT_EQ(5, versions2[10].version);
+
+    // another tablet doesn't
+    add_tablet(&request, 11, "5");
+    ASSERT_TRUE(PartialAggCache::make_key(request, &key2, &versions2));
+    ASSERT_NE(key1, key2);
+
+    // the same tablet twice
+    add_tablet(&request, 11, "5");
+    ASSERT_FALSE(PartialAggCache::make_key(request, &key2, &versions2));
+
+    request = make_partial_agg_request();
+    request.fragment.plan.nodes[0].agg_node.need_finalize = true;
+    ASSERT_FALSE(PartialAggCache::make_key(request, &key1, &versions1));
+
+    request = make_partial_agg_request();
+    request.fragment.plan.nodes[1].olap_scan_node.is_preaggregation = false;
+    ASSERT_FALSE(PartialAggCache::make_key(request, &key1, &versions1));
+
+    request = make_partial_agg_request();
+    request.fragment.output_sink.type = TDataSinkType::RESULT_SINK;
+    ASSERT_FALSE(PartialAggCache::make_key(request, &key1, &versions1));
+}
+
+TEST_F(ResultCacheTest, partial_agg_start_versions) {
+    TabletVersionMap cached;
+    cached[10].version = 2;
+    cached[10].version_hash = 7;
+    TabletVersionMap requested = cached;
+    std::map<int64_t, int64_t> start_versions;
+
+    // nothing new to read
+    ASSERT_TRUE(PartialAggCache::get_start_versions(cached, requested, &start_versions));
+    ASSERT_EQ(3, start_versions[10]);
+
+    // the same version with other data
+    requested[10].version_hash = 8;
+    ASSERT_FALSE(PartialAggCache::get_start_versions(cached, requested, &start_versions));
+
+    // older than the cached version
+    requested[10].version = 1;
+    ASSERT_FALSE(PartialAggCache::get_start_versions(cached, requested, &start_versions));
+
+    // other tablets
+    requested = cached;
+    requested[11] = cached[10];
+    ASSERT_FALSE(PartialAggCache::get_start_versions(cached, requested, &start_versions));
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
+    if (!palo::config::init(conffile.c_str(), false)) {
+        fprintf(stderr, "error read config file. \n");
+        return -1;
+    }
+    init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
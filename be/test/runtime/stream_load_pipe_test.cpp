@@ -0,0 +1,107 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "runtime/stream_load_pipe.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "util/logging.h"
+
+namespace palo {
+
+TEST(StreamLoadPipeTest, ReadLines) {
+    StreamLoadPipe pipe(1024);
+    ASSERT_TRUE(pipe.append("a,1\nb,", 6).ok());
+    ASSERT_TRUE(pipe.append("2\n\nc,3", 6).ok());
+    pipe.finish();
+
+    std::string line;
+    bool eos = false;
+    ASSERT_TRUE(pipe.read_line(&line, &eos).ok());
+    ASSERT_EQ("a,1", line);
+    ASSERT_TRUE(pipe.read_line(&line, &eos).ok());
+    ASSERT_EQ("b,2", line);
+    ASSERT_TRUE(pipe.read_line(&line, &eos).ok());
+    ASSERT_EQ("", line);
+    ASSERT_FALSE(eos);
+    ASSERT_TRUE(pipe.read_line(&line, &eos).ok());
+    ASSERT_EQ("c,3", line);
+    ASSERT_FALSE(eos);
+    ASSERT_TRUE(pipe.read_line(&line, &eos).ok());
+    ASSERT_TRUE(eos);
+}
+
+TEST(StreamLoadPipeTest, Backpressure) {
+    config::streaming_mini_load_timeout_s = 10;
+    StreamLoadPipe pipe(8);
+    std::thread writer([&pipe] {
+        for (int i = 0; i < 100; ++i) {
+            ASSERT_TRUE(pipe.append("0123456789\n", 11).ok());
+        }
+        pipe.finish();
+    });
+    std::string line;
+    bool eos = false;
+    int num_lines = 0;
+    while (true) {
+        ASSERT_TRUE(pipe.read_line(&line, &eos).ok());
+        if (eos) {
+            break;
+        }
+        ASSERT_EQ("0123456789", line);
+        ++num_lines;
+    }
+    writer.join();
+    ASSERT_EQ(100, num_lines);
+}
+
+TEST(StreamLoadPipeTest, Cancel) {
+    StreamLoadPipe pipe(1024);
+    ASSERT_TRUE(pipe.append("a\n", 2).ok());
+    pipe.cancel("client went away");
+    std::string line;
+    bool eos = false;
+    ASSERT_FALSE(pipe.read_line(&line, &eos).ok());
+    ASSERT_FALSE(pipe.append("b\n", 2).ok());
+}
+
+TEST(StreamLoadPipeTest, Mgr) {
+    StreamLoadPipeMgr mgr;
+    std::shared_ptr<StreamLoadPipe> pipe(new StreamLoadPipe(1024));
+    std::string path = mgr.register_pipe("tbl", pipe);
+    ASSERT_TRUE(StreamLoadPipeMgr::is_pipe_path(path));
+    ASSERT_FALSE(StreamLoadPipeMgr::is_pipe_path("/home/palo/tbl.csv"));
+    ASSERT_EQ(pipe, mgr.open_pipe(path));
+    // a pipe is read once
+    ASSERT_EQ(nullptr, mgr.open_pipe(path));
+
+    path = mgr.register_pipe("tbl", pipe);
+    mgr.unregister_pipe(path);
+    ASSERT_EQ(nullptr, mgr.open_pipe(path));
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
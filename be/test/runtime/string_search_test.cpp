@@ -0,0 +1,69 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <stdlib.h>
+
+#include <string>
+#include <gtest/gtest.h>
+
+#include "runtime/string_search.hpp"
+#include "util/cpu_info.h"
+
+namespace palo {
+
+static int search(const std::string& str, const std::string& pattern) {
+    StringValue str_value(const_cast<char*>(str.data()), str.size());
+    StringValue pattern_value(const_cast<char*>(pattern.data()), pattern.size());
+    StringSearch search(&pattern_value);
+    return search.search(&str_value);
+}
+
+TEST(StringSearchTest, Basic) {
+    EXPECT_EQ(-1, search("", "abc"));
+    EXPECT_EQ(-1, search("ab", "abc"));
+    EXPECT_EQ(0, search("abc", "abc"));
+    EXPECT_EQ(2, search("xxabc", "abc"));
+    EXPECT_EQ(2, search("abcabc", "cab"));
+    EXPECT_EQ(1, search("xa", "a"));
+    // found by the 16 char blocks and in the rest of the string
+    EXPECT_EQ(20, search("aaaaaaaaaaaaaaaaaaaakeyword", "keyword"));
+    EXPECT_EQ(37, search(std::string(37, 'k') + "keyword", "keyword"));
+    EXPECT_EQ(-1, search(std::string(100, 'k') + "keywor", "keyword"));
+}
+
+TEST(StringSearchTest, CompareWithStdString) {
+    srand(1);
+    for (int i = 0; i < 100000; ++i) {
+        std::string str(rand() % 64, 'a');
+        std::string pattern(1 + rand() % 6, 'a');
+        for (int j = 0; j < str.size(); ++j) {
+            str[j] += rand() % 3;
+        }
+        for (int j = 0; j < pattern.size(); ++j) {
+            pattern[j] += rand() % 3;
+        }
+        size_t expected = str.find(pattern);
+        ASSERT_EQ(expected == std::string::npos ? -1 : static_cast<int>(expected),
+                  search(str, pattern)) << str << " " << pattern;
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    palo::CpuInfo::init();
+    return RUN_ALL_TESTS();
+}
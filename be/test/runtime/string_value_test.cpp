@@ -76,6 +76,38 @@ TEST(StringValueTest, TestCompare) {
     }
 }
 
+TEST(StringValueTest, TestPrefix) {
+    // Must be in lexical order, the last two only differ after the prefix
+    std::string strs[] = {"", "abc", "abcdef", "abcdefghijkl", "abcdefghijklm",
+                          "abcdefghijklmn", "abcdefghijklmz", "xyz"};
+    const int NUM_STRINGS = sizeof(strs) / sizeof(strs[0]);
+
+    for (int i = 0; i < NUM_STRINGS; ++i) {
+        StringValuePrefix lhs(FromStdString(strs[i]));
+        EXPECT_FALSE(lhs.is_null());
+        EXPECT_EQ(strs[i].size() <= StringValuePrefix::MAX_INLINE_LENGTH, lhs.is_complete());
+        for (int j = 0; j < NUM_STRINGS; ++j) {
+            StringValuePrefix rhs(FromStdString(strs[j]));
+            bool decided = false;
+            int result = lhs.compare(rhs, &decided);
+            if (i == j) {
+                EXPECT_TRUE(lhs.may_eq(rhs));
+                EXPECT_EQ(lhs.is_complete(), decided);
+                EXPECT_EQ(0, result);
+            } else if (lhs.is_complete() || rhs.is_complete()) {
+                EXPECT_FALSE(lhs.may_eq(rhs));
+                EXPECT_TRUE(decided);
+                EXPECT_EQ(i < j, result < 0);
+            } else if (!decided) {
+                // the long strings share their prefix
+                EXPECT_EQ(strs[i].size() == strs[j].size(), lhs.may_eq(rhs));
+            } else {
+                EXPECT_EQ(i < j, result < 0);
+            }
+        }
+    }
+}
+
 }
 
 int main(int argc, char** argv) {
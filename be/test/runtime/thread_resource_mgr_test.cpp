@@ -89,6 +89,53 @@ TEST(ThreadResourceMgr, BasicTest) {
     EXPECT_EQ(counter2.counter(), 1);
 }
 
+TEST(ThreadResourceMgr, RebalanceTest) {
+    ThreadResourceMgr mgr(8);
+    ThreadResourceMgr::ResourcePool* c1 = mgr.register_pool();
+    ThreadResourceMgr::ResourcePool* c2 = mgr.register_pool();
+    EXPECT_EQ(c1->quota(), 4);
+    EXPECT_EQ(c2->quota(), 4);
+
+    // Blocked threads don't count against the quota
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(c1->try_acquire_thread_token());
+    }
+    EXPECT_FALSE(c1->try_acquire_thread_token());
+    {
+        ThreadResourceMgr::ScopedBlockedThread blocked(c1);
+        EXPECT_EQ(c1->num_available_threads(), 1);
+        EXPECT_TRUE(c1->try_acquire_thread_token());
+        c1->release_thread_token(false);
+    }
+    EXPECT_EQ(c1->num_available_threads(), 0);
+
+    // The idle pool keeps one spare thread, the denied one gets the rest
+    mgr.rebalance(-1);
+    EXPECT_EQ(c1->quota(), 7);
+    EXPECT_EQ(c2->quota(), 1);
+    EXPECT_TRUE(c1->try_acquire_thread_token());
+
+    // The pools get their fair share back when nobody is denied
+    mgr.rebalance(-1);
+    EXPECT_EQ(c1->quota(), 4);
+    EXPECT_EQ(c2->quota(), 1);
+
+    // Under contention the quotas shrink, down to one thread per pool
+    for (int i = 0; i < 20; ++i) {
+        mgr.rebalance(100);
+    }
+    EXPECT_EQ(mgr.effective_threads_quota(), 2);
+    EXPECT_EQ(c1->quota(), 1);
+    mgr.rebalance(0);
+    EXPECT_EQ(mgr.effective_threads_quota(), 3);
+
+    for (int i = 0; i < 5; ++i) {
+        c1->release_thread_token(false);
+    }
+    mgr.unregister_pool(c1);
+    mgr.unregister_pool(c2);
+}
+
 }
 
 int main(int argc, char** argv) {
@@ -97,6 +144,8 @@ int main(int argc, char** argv) {
         fprintf(stderr, "error read config file. \n");
         return -1;
     }
+    // the tests rebalance the quotas themselves
+    palo::config::thread_quota_rebalance_interval_ms = 0;
     init_glog("be-test");
     ::testing::InitGoogleTest(&argc, argv);
     palo::CpuInfo::Init();
@@ -123,6 +123,34 @@ TEST_F(TmpFileMgrTest, TestOneDirPerDevice) {
     check_metrics(&tmp_file_mgr);
 }
 
+// Test that the bytes queued for writing are tracked per device.
+TEST_F(TmpFileMgrTest, TestPendingWriteBytes) {
+    vector<string> tmp_dirs;
+    tmp_dirs.push_back("/tmp/tmp-file-mgr-test.1");
+    tmp_dirs.push_back("/tmp/tmp-file-mgr-test.2");
+    for (int i = 0; i < tmp_dirs.size(); ++i) {
+        EXPECT_TRUE(FileSystemUtil::create_directory(tmp_dirs[i]).ok());
+    }
+    TmpFileMgr tmp_file_mgr;
+    tmp_file_mgr.init_custom(tmp_dirs, false, _metrics.get());
+    vector<TmpFileMgr::DeviceId> devices = tmp_file_mgr.active_tmp_devices();
+    EXPECT_EQ(2, devices.size());
+
+    tmp_file_mgr.update_pending_write_bytes(devices[0], 1024);
+    tmp_file_mgr.update_pending_write_bytes(devices[0], 512);
+    EXPECT_EQ(1536, tmp_file_mgr.pending_write_bytes(devices[0]));
+    EXPECT_EQ(0, tmp_file_mgr.pending_write_bytes(devices[1]));
+    tmp_file_mgr.update_pending_write_bytes(devices[0], -1536);
+    EXPECT_EQ(0, tmp_file_mgr.pending_write_bytes(devices[0]));
+
+    TUniqueId id;
+    TmpFileMgr::File* file;
+    EXPECT_TRUE(tmp_file_mgr.get_file(devices[1], id, &file).ok());
+    EXPECT_EQ(devices[1], file->device_id());
+    delete file;
+    FileSystemUtil::remove_paths(tmp_dirs);
+}
+
 // Test that we can do custom initialization with two dirs on same device.
 TEST_F(TmpFileMgrTest, TestMultiDirsPerDevice) {
     vector<string> tmp_dirs;
@@ -0,0 +1,102 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/bitmap_value.h"
+
+#include <stdlib.h>
+
+#include <set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace palo {
+
+static BitmapValue round_trip(const BitmapValue& bitmap) {
+    std::vector<char> buf(bitmap.serialized_size());
+    bitmap.serialize(&buf[0]);
+    BitmapValue result;
+    EXPECT_TRUE(result.merge_serialized(&buf[0], buf.size()));
+    return result;
+}
+
+TEST(BitmapValueTest, empty) {
+    BitmapValue bitmap;
+    EXPECT_EQ(0, bitmap.cardinality());
+    EXPECT_EQ(0, round_trip(bitmap).cardinality());
+}
+
+TEST(BitmapValueTest, add) {
+    BitmapValue bitmap;
+    bitmap.add(1);
+    bitmap.add(1);
+    bitmap.add(65536);
+    bitmap.add(4294967295U);
+    EXPECT_EQ(3, bitmap.cardinality());
+    EXPECT_EQ(3, round_trip(bitmap).cardinality());
+}
+
+TEST(BitmapValueTest, dense) {
+    // more than ARRAY_MAX_CARDINALITY values in one container
+    BitmapValue bitmap;
+    for (uint32_t i = 0; i < 10000; ++i) {
+        bitmap.add(i * 2);
+    }
+    EXPECT_EQ(10000, bitmap.cardinality());
+    BitmapValue copy = round_trip(bitmap);
+    EXPECT_EQ(10000, copy.cardinality());
+    EXPECT_EQ(bitmap.serialized_size(), copy.serialized_size());
+}
+
+TEST(BitmapValueTest, merge) {
+    std::set<uint32_t> expected;
+    BitmapValue left;
+    BitmapValue right;
+    for (int i = 0; i < 20000; ++i) {
+        uint32_t value = rand() % 200000;
+        expected.insert(value);
+        if (i % 2 == 0) {
+            left.add(value);
+        } else {
+            right.add(value);
+        }
+    }
+    BitmapValue merged;
+    merged.merge(left);
+    merged.merge(round_trip(right));
+    EXPECT_EQ(expected.size(), merged.cardinality());
+
+    std::vector<char> buf(right.serialized_size());
+    right.serialize(&buf[0]);
+    EXPECT_TRUE(left.merge_serialized(&buf[0], buf.size()));
+    EXPECT_EQ(expected.size(), left.cardinality());
+}
+
+TEST(BitmapValueTest, invalid) {
+    BitmapValue bitmap;
+    bitmap.add(7);
+    std::vector<char> buf(bitmap.serialized_size());
+    bitmap.serialize(&buf[0]);
+    BitmapValue result;
+    EXPECT_FALSE(result.merge_serialized(&buf[0], buf.size() - 1));
+    EXPECT_FALSE(result.merge_serialized(&buf[0], 2));
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
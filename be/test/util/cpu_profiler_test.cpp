@@ -0,0 +1,111 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/cpu_profiler.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "util/logging.h"
+#include "util/thread_name.h"
+
+namespace palo {
+
+static std::atomic<bool> s_stop(false);
+static volatile double s_sink = 0;
+
+static void burn_cpu(const std::string& name, const TUniqueId& query_id) {
+    set_current_thread_name(name);
+    CpuProfiler::ScopedQueryTag tag(query_id);
+    while (!s_stop) {
+        for (int i = 0; i < 1000; ++i) {
+            s_sink = s_sink + i;
+        }
+    }
+}
+
+static TUniqueId query(int64_t lo) {
+    TUniqueId id;
+    id.hi = 0;
+    id.lo = lo;
+    return id;
+}
+
+static int64_t total_samples(const std::map<std::string, int64_t>& stacks,
+                             const std::string& thread_name) {
+    int64_t total = 0;
+    for (auto& it : stacks) {
+        if (it.first.compare(0, thread_name.size() + 1, thread_name + ";") == 0) {
+            total += it.second;
+        }
+    }
+    return total;
+}
+
+TEST(CpuProfilerTest, Filters) {
+    std::thread scanner(burn_cpu, "scanner", query(1));
+    std::thread other(burn_cpu, "other", query(2));
+
+    CpuProfiler::Options options;
+    options.seconds = 1;
+    options.frequency = 200;
+    options.thread_name = "scan";
+    std::map<std::string, int64_t> stacks;
+    ASSERT_TRUE(CpuProfiler::profile(options, NULL, &stacks).ok());
+    ASSERT_GT(total_samples(stacks, "scanner"), 0);
+    ASSERT_EQ(0, total_samples(stacks, "other"));
+
+    options.thread_name = "";
+    options.filter_query = true;
+    options.query_id = query(2);
+    stacks.clear();
+    ASSERT_TRUE(CpuProfiler::profile(options, NULL, &stacks).ok());
+    ASSERT_EQ(0, total_samples(stacks, "scanner"));
+    ASSERT_GT(total_samples(stacks, "other"), 0);
+
+    options.query_id = query(3);
+    stacks.clear();
+    ASSERT_TRUE(CpuProfiler::profile(options, NULL, &stacks).ok());
+    ASSERT_TRUE(stacks.empty());
+
+    s_stop = true;
+    scanner.join();
+    other.join();
+}
+
+TEST(CpuProfilerTest, Output) {
+    std::map<std::string, int64_t> stacks;
+    stacks["scanner;main;scan"] = 3;
+    stacks["scanner;main;decompress<int>"] = 1;
+    ASSERT_EQ("scanner;main;decompress<int> 1\nscanner;main;scan 3\n",
+              CpuProfiler::to_collapsed(stacks));
+
+    std::string svg = CpuProfiler::to_flame_graph_svg(stacks, "CPU");
+    ASSERT_NE(std::string::npos, svg.find("<title>main (4 samples, 100.00%)</title>"));
+    ASSERT_NE(std::string::npos, svg.find("<title>scan (3 samples, 75.00%)</title>"));
+    ASSERT_NE(std::string::npos, svg.find("decompress&lt;int&gt;"));
+    ASSERT_EQ(std::string::npos, svg.find("decompress<int>"));
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
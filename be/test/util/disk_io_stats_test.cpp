@@ -0,0 +1,93 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/disk_io_stats.h"
+
+#include <gtest/gtest.h>
+
+#include "util/logging.h"
+
+namespace palo {
+
+TEST(DiskIoStatsTest, Find) {
+    DiskIoStats::add_path("/home/disk1/palo/");
+    DiskIoStats::add_path("/home/disk1/palo/ssd");
+    DiskIoStats::add_path("/home/disk1/palo");
+
+    DiskIoStats* stats = DiskIoStats::find(
+            "/home/disk1/palo/data/0/10001/1234/10001_0_0_0.dat");
+    ASSERT_TRUE(stats != NULL);
+    ASSERT_EQ("/home/disk1/palo", stats->path());
+    ASSERT_EQ(stats, DiskIoStats::find("/home/disk1/palo"));
+
+    // the longest path wins
+    stats = DiskIoStats::find("/home/disk1/palo/ssd/data/0/10002/1234/10002_0_0_0.dat");
+    ASSERT_TRUE(stats != NULL);
+    ASSERT_EQ("/home/disk1/palo/ssd", stats->path());
+
+    ASSERT_TRUE(DiskIoStats::find("/home/disk1/palo2/data") == NULL);
+    ASSERT_TRUE(DiskIoStats::find("/home/disk2/palo/data") == NULL);
+}
+
+TEST(DiskIoStatsTest, ReadLatency) {
+    DiskIoStats::add_path("/home/disk3/palo");
+    DiskIoStats* stats = DiskIoStats::find("/home/disk3/palo/data");
+    ASSERT_TRUE(stats != NULL);
+    ASSERT_EQ(0, stats->read_latency_since_last(0.99));
+
+    for (int i = 0; i < 100; ++i) {
+        stats->record_read(4096, 1000000);
+    }
+    int64_t p99 = stats->read_latency_since_last(0.99);
+    ASSERT_NEAR(1000000, p99, 1000000 / 16);
+
+    // only the reads since the last call count
+    for (int i = 0; i < 100; ++i) {
+        stats->record_read(4096, 50000000);
+    }
+    p99 = stats->read_latency_since_last(0.99);
+    ASSERT_NEAR(50000000, p99, 50000000 / 16);
+    ASSERT_EQ(0, stats->read_latency_since_last(0.99));
+}
+
+TEST(DiskIoStatsTest, Metrics) {
+    DiskIoStats::add_path("/home/disk4/palo");
+    DiskIoStats* stats = DiskIoStats::find("/home/disk4/palo/data");
+    ASSERT_TRUE(stats != NULL);
+    stats->record_read(100, 1000);
+    stats->record_write(200, 1000);
+    stats->record_write(300, 1000);
+
+    MetricGroup metrics("test");
+    DiskIoStats::register_metrics(&metrics);
+    std::stringstream ss;
+    metrics.print_prometheus(&ss);
+    std::string text = ss.str();
+    ASSERT_NE(std::string::npos, text.find(
+                "palo_be_disk_read_bytes{path=\"/home/disk4/palo\"} 100\n"));
+    ASSERT_NE(std::string::npos, text.find(
+                "palo_be_disk_write_bytes{path=\"/home/disk4/palo\"} 500\n"));
+    ASSERT_NE(std::string::npos, text.find("palo_be_disk_writes{path=\"/home/disk4/palo\"} 2\n"));
+    ASSERT_NE(std::string::npos, text.find(
+                "palo_be_disk_write_latency_count{path=\"/home/disk4/palo\"} 2\n"));
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/hash_util.hpp"
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "util/cpu_info.h"
+
+namespace palo {
+
+static std::vector<uint64_t> hash_inputs(uint64_t seed) {
+    std::vector<uint64_t> hashes;
+    std::string str;
+    for (int len = 0; len < 40; ++len) {
+        hashes.push_back(HashUtil::fast_hash64(str.data(), str.size(), seed));
+        str.push_back('a' + len % 26);
+    }
+    return hashes;
+}
+
+TEST(HashUtilTest, FastHashSameWithoutSse) {
+    // fast_hash64() partitions rows across hosts, so the result must not depend on
+    // the instructions the host supports
+    std::vector<uint64_t> hashes = hash_inputs(0);
+    std::vector<uint64_t> seeded_hashes = hash_inputs(12345);
+    bool sse = CpuInfo::is_supported(CpuInfo::SSE4_2);
+    if (sse) {
+        CpuInfo::enable_feature(CpuInfo::SSE4_2, false);
+    }
+    ASSERT_EQ(hashes, hash_inputs(0));
+    ASSERT_EQ(seeded_hashes, hash_inputs(12345));
+    if (sse) {
+        CpuInfo::enable_feature(CpuInfo::SSE4_2, true);
+    }
+}
+
+TEST(HashUtilTest, FastHashDistinct) {
+    // trailing zero bytes and the length are part of the hash
+    char zeros[16] = {0};
+    std::set<uint64_t> hashes;
+    for (int len = 0; len <= 16; ++len) {
+        hashes.insert(HashUtil::fast_hash64(zeros, len, 0));
+    }
+    ASSERT_EQ(17, hashes.size());
+
+    // different seeds give unrelated hashes: the low bits of consecutive keys are
+    // spread over the buckets with every seed
+    for (uint64_t seed = 0; seed < 4; ++seed) {
+        int buckets[16] = {0};
+        for (int64_t key = 0; key < 16 * 1024; ++key) {
+            ++buckets[HashUtil::fast_hash64(&key, sizeof(key), seed) & 15];
+        }
+        for (int i = 0; i < 16; ++i) {
+            ASSERT_GT(buckets[i], 900);
+            ASSERT_LT(buckets[i], 1150);
+        }
+    }
+    int64_t key = 42;
+    ASSERT_NE(HashUtil::fast_hash64(&key, sizeof(key), 1),
+              HashUtil::fast_hash64(&key, sizeof(key), 2));
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    palo::CpuInfo::init();
+    return RUN_ALL_TESTS();
+}
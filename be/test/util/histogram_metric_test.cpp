@@ -0,0 +1,142 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/histogram_metric.h"
+
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "util/logging.h"
+
+namespace palo {
+
+static TMetricDef latency_def(const std::string& key) {
+    TMetricDef def = MakeTMetricDef(key, TMetricKind::HISTOGRAM, TUnit::TIME_NS);
+    def.__set_description("test latency");
+    return def;
+}
+
+TEST(HistogramMetricTest, Buckets) {
+    for (int i = 0; i < HistogramMetric::NUM_BUCKETS; ++i) {
+        int64_t lower = HistogramMetric::bucket_lower_bound(i);
+        int64_t upper = HistogramMetric::bucket_upper_bound(i);
+        ASSERT_LT(lower, upper);
+        ASSERT_EQ(i, HistogramMetric::bucket_index(lower));
+        ASSERT_EQ(i, HistogramMetric::bucket_index(upper - 1));
+        if (i + 1 < HistogramMetric::NUM_BUCKETS) {
+            ASSERT_EQ(upper, HistogramMetric::bucket_lower_bound(i + 1));
+        }
+    }
+    ASSERT_EQ(0, HistogramMetric::bucket_index(-5));
+    ASSERT_EQ(HistogramMetric::NUM_BUCKETS - 1,
+              HistogramMetric::bucket_index(std::numeric_limits<int64_t>::max()));
+}
+
+TEST(HistogramMetricTest, Quantiles) {
+    HistogramMetric histogram(latency_def("latency"));
+    HistogramMetric::Snapshot empty;
+    histogram.snapshot(&empty);
+    ASSERT_EQ(0, empty.count);
+    ASSERT_EQ(0, empty.value_at_quantile(0.99));
+
+    for (int64_t i = 1; i <= 10000; ++i) {
+        histogram.update(i * 1000);
+    }
+    HistogramMetric::Snapshot s;
+    histogram.snapshot(&s);
+    ASSERT_EQ(10000, s.count);
+    ASSERT_EQ(10000L * 10001 / 2 * 1000, s.sum);
+    ASSERT_EQ(10000000, s.max);
+    // a percentile is off by at most 1 / (2 * SUB_BUCKETS)
+    double error = 1.0 / (2 * HistogramMetric::SUB_BUCKETS);
+    ASSERT_NEAR(5000000, s.value_at_quantile(0.5), 5000000 * error);
+    ASSERT_NEAR(9900000, s.value_at_quantile(0.99), 9900000 * error);
+    ASSERT_LE(s.value_at_quantile(1), s.max);
+}
+
+TEST(HistogramMetricTest, ConcurrentUpdates) {
+    HistogramMetric histogram(latency_def("latency"));
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 16; ++i) {
+        threads.emplace_back([&histogram] {
+            for (int j = 0; j < 10000; ++j) {
+                histogram.update(j);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(16 * 10000, histogram.count());
+}
+
+TEST(HistogramMetricTest, Prometheus) {
+    MetricGroup metrics("test");
+    HistogramMetric* histogram = metrics.register_metric(
+            new HistogramMetric(latency_def("palo_be.test.latency")));
+    histogram->update(500);
+    histogram->update(2000000000);
+    metrics.register_metric(new IntCounter(
+            MakeTMetricDef("palo_be.test.count", TMetricKind::COUNTER, TUnit::UNIT), 7));
+
+    std::stringstream ss;
+    metrics.print_prometheus(&ss);
+    std::string text = ss.str();
+    ASSERT_NE(std::string::npos, text.find("# HELP palo_be_test_latency test latency\n"));
+    ASSERT_NE(std::string::npos, text.find("# TYPE palo_be_test_latency histogram\n"));
+    // 500ns is below the first bound of ~1us
+    ASSERT_NE(std::string::npos, text.find("palo_be_test_latency_bucket{le=\"1.024e-06\"} 1\n"));
+    ASSERT_NE(std::string::npos, text.find("palo_be_test_latency_bucket{le=\"+Inf\"} 2\n"));
+    ASSERT_NE(std::string::npos, text.find("palo_be_test_latency_count 2\n"));
+    ASSERT_NE(std::string::npos, text.find("# TYPE palo_be_test_count counter\n"));
+    ASSERT_NE(std::string::npos, text.find("palo_be_test_count 7\n"));
+}
+
+TEST(HistogramMetricTest, Family) {
+    MetricGroup metrics("test");
+    HistogramFamily* family = metrics.register_metric(
+            new HistogramFamily(latency_def("palo_be.test.rpc_latency"), "method", 2));
+    family->get("exec")->update(1000);
+    family->get("exec")->update(1000);
+    family->get("fetch")->update(1000);
+    // beyond the bound of 2 children
+    HistogramMetric* other = family->get("cancel");
+    ASSERT_EQ(other, family->get("report"));
+    other->update(1000);
+
+    std::stringstream ss;
+    metrics.print_prometheus(&ss);
+    std::string text = ss.str();
+    ASSERT_NE(std::string::npos, text.find("# TYPE palo_be_test_rpc_latency histogram\n"));
+    ASSERT_NE(std::string::npos, text.find("palo_be_test_rpc_latency_count{method=\"exec\"} 2\n"));
+    ASSERT_NE(std::string::npos, text.find("palo_be_test_rpc_latency_count{method=\"fetch\"} 1\n"));
+    ASSERT_NE(std::string::npos, text.find("palo_be_test_rpc_latency_count{method=\"other\"} 1\n"));
+    ASSERT_NE(std::string::npos, text.find(
+                "palo_be_test_rpc_latency_bucket{method=\"exec\",le=\"+Inf\"} 2\n"));
+
+    std::string debug = metrics.debug_string();
+    ASSERT_NE(std::string::npos, debug.find("palo_be.test.rpc_latency{method=exec}:count=2"));
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/huge_page_allocator.h"
+
+#include <gtest/gtest.h>
+
+#include <string.h>
+
+namespace palo {
+
+static void fill(uint8_t* ptr, int64_t size) {
+    for (int64_t i = 0; i < size; ++i) {
+        ptr[i] = i % 251;
+    }
+}
+
+static bool check(const uint8_t* ptr, int64_t size) {
+    for (int64_t i = 0; i < size; ++i) {
+        if (ptr[i] != i % 251) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(HugePageAllocatorTest, MappedOnlyWhenLarge) {
+    ASSERT_FALSE(HugePageAllocator::is_mapped(1024));
+    ASSERT_TRUE(HugePageAllocator::is_mapped(HugePageAllocator::HUGE_PAGE_SIZE));
+
+    int64_t size = 3 * HugePageAllocator::HUGE_PAGE_SIZE + 100;
+    uint8_t* ptr = reinterpret_cast<uint8_t*>(HugePageAllocator::allocate(size));
+    ASSERT_TRUE(ptr != NULL);
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(ptr) % HugePageAllocator::HUGE_PAGE_SIZE);
+    fill(ptr, size);
+    ASSERT_TRUE(check(ptr, size));
+    HugePageAllocator::free(ptr, size);
+}
+
+TEST(HugePageAllocatorTest, GrowKeepsContent) {
+    // from malloc to malloc, to a mapping, and within mappings
+    int64_t sizes[] = {
+        1024, 64 * 1024, 4 * 1024 * 1024, 16 * 1024 * 1024 + 8, 16 * 1024 * 1024 + 16 };
+    int64_t size = sizes[0];
+    uint8_t* ptr = reinterpret_cast<uint8_t*>(HugePageAllocator::allocate(size));
+    fill(ptr, size);
+    for (int i = 1; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+        ptr = reinterpret_cast<uint8_t*>(
+                HugePageAllocator::reallocate(ptr, size, sizes[i]));
+        ASSERT_TRUE(ptr != NULL);
+        ASSERT_TRUE(check(ptr, size));
+        size = sizes[i];
+        fill(ptr, size);
+    }
+
+    // and back to malloc
+    ptr = reinterpret_cast<uint8_t*>(HugePageAllocator::reallocate(ptr, size, 512));
+    ASSERT_TRUE(check(ptr, 512));
+    HugePageAllocator::free(ptr, 512);
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/io_throttle.h"
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+
+namespace palo {
+
+TEST(IoThrottleTest, scoped_io_class) {
+    EXPECT_EQ(IO_CLASS_QUERY, current_io_class());
+    {
+        ScopedIoClass compaction(IO_CLASS_COMPACTION);
+        EXPECT_EQ(IO_CLASS_COMPACTION, current_io_class());
+        {
+            ScopedIoClass clone(IO_CLASS_CLONE);
+            EXPECT_EQ(IO_CLASS_CLONE, current_io_class());
+        }
+        EXPECT_EQ(IO_CLASS_COMPACTION, current_io_class());
+    }
+    EXPECT_EQ(IO_CLASS_QUERY, current_io_class());
+}
+
+TEST(IoThrottleTest, shares) {
+    config::io_share_query = 8;
+    config::io_share_clone = 0;
+    EXPECT_EQ(8, io_class_share(IO_CLASS_QUERY));
+    // a share below 1 would starve the class
+    EXPECT_EQ(1, io_class_share(IO_CLASS_CLONE));
+}
+
+TEST(IoThrottleTest, rate_limit) {
+    // not capped
+    config::io_rate_limit_load_mbytes_per_sec = 0;
+    IoThrottle::charge(IO_CLASS_LOAD, 1L << 40);
+    EXPECT_EQ(0, IoThrottle::wait_time_us(IO_CLASS_LOAD));
+
+    config::io_rate_limit_compaction_mbytes_per_sec = 1;
+    // the budget starts with one second of the rate
+    EXPECT_EQ(0, IoThrottle::wait_time_us(IO_CLASS_COMPACTION));
+    IoThrottle::acquire(IO_CLASS_COMPACTION, 1024 * 1024);
+    IoThrottle::charge(IO_CLASS_COMPACTION, 512 * 1024);
+    int64_t wait_us = IoThrottle::wait_time_us(IO_CLASS_COMPACTION);
+    EXPECT_GT(wait_us, 400 * 1000);
+    EXPECT_LE(wait_us, 500 * 1000 + 1);
+    // other classes aren't affected
+    EXPECT_EQ(0, IoThrottle::wait_time_us(IO_CLASS_QUERY));
+    config::io_rate_limit_compaction_mbytes_per_sec = 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
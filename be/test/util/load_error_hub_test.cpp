@@ -0,0 +1,134 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/load_error_hub.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <mutex>
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+#include "common/config.h"
+#include "util/logging.h"
+
+namespace palo {
+
+// Records the written errors, 'gate' holds back the writes while the test locks it.
+class TestLoadErrorHub : public LoadErrorHub {
+public:
+    TestLoadErrorHub() : writing(false), num_batches(0) { }
+
+    virtual ~TestLoadErrorHub() {
+        close();
+    }
+
+    virtual Status prepare() {
+        _is_valid = true;
+        return Status::OK;
+    }
+
+    virtual std::string debug_string() const {
+        std::stringstream out;
+        out << "(tatal_error_num=" << _total_error_num;
+        debug_counters(&out);
+        out << ")";
+        return out.str();
+    }
+
+    std::mutex gate;
+    std::atomic<bool> writing;
+    std::atomic<int> num_batches;
+    std::vector<int64_t> job_ids;
+    Status write_status;
+
+protected:
+    virtual Status write_errors(const std::vector<ErrorMsg>& error_msgs) {
+        writing = true;
+        std::lock_guard<std::mutex> l(gate);
+        for (const ErrorMsg& msg : error_msgs) {
+            job_ids.push_back(msg.job_id);
+        }
+        ++num_batches;
+        return write_status;
+    }
+};
+
+static void export_errors(LoadErrorHub* hub, int64_t from, int64_t to) {
+    for (int64_t i = from; i < to; ++i) {
+        ASSERT_TRUE(hub->export_error(LoadErrorHub::ErrorMsg(i, "error")).ok());
+    }
+}
+
+TEST(LoadErrorHubTest, Sampling) {
+    config::load_error_hub_buffer_size = 1000;
+    config::load_error_hub_sample_after = 5;
+    config::load_error_hub_sample_rate = 10;
+    TestLoadErrorHub hub;
+    hub.prepare();
+    export_errors(&hub, 1, 31);
+    ASSERT_TRUE(hub.close().ok());
+
+    std::vector<int64_t> expected = { 1, 2, 3, 4, 5, 15, 25 };
+    ASSERT_EQ(expected, hub.job_ids);
+    ASSERT_EQ("(tatal_error_num=30, sampled_out=23, dropped=0)", hub.debug_string());
+}
+
+TEST(LoadErrorHubTest, FullBuffer) {
+    config::load_error_hub_buffer_size = 5;
+    config::load_error_hub_sample_after = 1000;
+    TestLoadErrorHub hub;
+    hub.prepare();
+    {
+        std::unique_lock<std::mutex> l(hub.gate);
+        // a full buffer wakes up the writer
+        export_errors(&hub, 0, 5);
+        while (!hub.writing) {
+            usleep(1000);
+        }
+        export_errors(&hub, 5, 13);
+    }
+    ASSERT_TRUE(hub.close().ok());
+    ASSERT_EQ(10, hub.job_ids.size());
+    ASSERT_EQ(9, hub.job_ids.back());
+    ASSERT_EQ("(tatal_error_num=13, sampled_out=0, dropped=3)", hub.debug_string());
+}
+
+TEST(LoadErrorHubTest, WriteError) {
+    config::load_error_hub_buffer_size = 1000;
+    config::load_error_hub_sample_after = 1000;
+    TestLoadErrorHub hub;
+    hub.prepare();
+    hub.write_status = Status("mysql is gone");
+    export_errors(&hub, 0, 60);
+    while (hub.num_batches == 0) {
+        usleep(1000);
+    }
+    // the hub stops exporting after the failed write
+    export_errors(&hub, 60, 70);
+    ASSERT_FALSE(hub.close().ok());
+    ASSERT_EQ(1, hub.num_batches);
+    ASSERT_TRUE(hub.export_error(LoadErrorHub::ErrorMsg(70, "error")).ok());
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -13,8 +13,19 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include <limits>
+#include <random>
+#include <string>
+
 #include <gtest/gtest.h>
 
+#include "util/logging.h"
+#include "util/mysql_dtoa.h"
+#include "util/mysql_global.h"
 #include "util/mysql_row_buffer.h"
 
 using namespace std;
@@ -34,17 +45,17 @@ protected:
 TEST_F(MysqlRowBufferTest, tinyint) {
     MysqlRowBuffer buffer;
 
-    ASSERT_EQ(0, buffer.PushTinyInt(-111));
+    ASSERT_EQ(0, buffer.push_tinyint(-111));
     ASSERT_EQ(4, *(int8_t*)buffer.buf());
     ASSERT_STREQ("-111", buffer.buf() + 1);
 
-    buffer.Reset();
-    ASSERT_EQ(0, buffer.PushTinyInt(100));
+    buffer.reset();
+    ASSERT_EQ(0, buffer.push_tinyint(100));
     ASSERT_EQ(3, *(int8_t*)buffer.buf());
     ASSERT_STREQ("100", buffer.buf() + 1);
 
-    buffer.Reset();
-    ASSERT_EQ(0, buffer.PushTinyInt(255));
+    buffer.reset();
+    ASSERT_EQ(0, buffer.push_tinyint(255));
     ASSERT_EQ(2, *(int8_t*)buffer.buf());
     ASSERT_STREQ("-1", buffer.buf() + 1);
 }
@@ -52,17 +63,17 @@ TEST_F(MysqlRowBufferTest, tinyint) {
 TEST_F(MysqlRowBufferTest, smallint) {
     MysqlRowBuffer buffer;
 
-    ASSERT_EQ(0, buffer.PushSmallInt(-10000));
+    ASSERT_EQ(0, buffer.push_smallint(-10000));
     ASSERT_EQ(6, *(int8_t*)buffer.buf());
     ASSERT_STREQ("-10000", buffer.buf() + 1);
 
-    buffer.Reset();
-    ASSERT_EQ(0, buffer.PushSmallInt(32767));
+    buffer.reset();
+    ASSERT_EQ(0, buffer.push_smallint(32767));
     ASSERT_EQ(5, *(int8_t*)buffer.buf());
     ASSERT_STREQ("32767", buffer.buf() + 1);
 
-    buffer.Reset();
-    ASSERT_EQ(0, buffer.PushSmallInt(65535));
+    buffer.reset();
+    ASSERT_EQ(0, buffer.push_smallint(65535));
     ASSERT_EQ(2, *(int8_t*)buffer.buf());
     ASSERT_STREQ("-1", buffer.buf() + 1);
 }
@@ -70,71 +81,199 @@ TEST_F(MysqlRowBufferTest, smallint) {
 TEST_F(MysqlRowBufferTest, int) {
     MysqlRowBuffer buffer;
 
-    ASSERT_EQ(0, buffer.PushInt(-10000));
+    ASSERT_EQ(0, buffer.push_int(-10000));
     ASSERT_EQ(6, *(int8_t*)buffer.buf());
     ASSERT_STREQ("-10000", buffer.buf() + 1);
 
-    buffer.Reset();
-    ASSERT_EQ(0, buffer.PushInt(32767));
+    buffer.reset();
+    ASSERT_EQ(0, buffer.push_int(32767));
     ASSERT_EQ(5, *(int8_t*)buffer.buf());
     ASSERT_STREQ("32767", buffer.buf() + 1);
 
-    buffer.Reset();
-    ASSERT_EQ(0, buffer.PushInt(4294967295));
+    buffer.reset();
+    ASSERT_EQ(0, buffer.push_int(4294967295));
     ASSERT_EQ(2, *(int8_t*)buffer.buf());
     ASSERT_STREQ("-1", buffer.buf() + 1);
 }
 TEST_F(MysqlRowBufferTest, bigint) {
     MysqlRowBuffer buffer;
 
-    ASSERT_EQ(0, buffer.PushBigInt(-1000000000));
+    ASSERT_EQ(0, buffer.push_bigint(-1000000000));
     ASSERT_EQ(11, *(int8_t*)buffer.buf());
     ASSERT_STREQ("-1000000000", buffer.buf() + 1);
 
-    buffer.Reset();
-    ASSERT_EQ(0, buffer.PushBigInt(1000032767));
+    buffer.reset();
+    ASSERT_EQ(0, buffer.push_bigint(1000032767));
     ASSERT_EQ(10, *(int8_t*)buffer.buf());
     ASSERT_STREQ("1000032767", buffer.buf() + 1);
 }
 TEST_F(MysqlRowBufferTest, float) {
     MysqlRowBuffer buffer;
 
-    ASSERT_EQ(0, buffer.PushFloat(-1.1));
+    ASSERT_EQ(0, buffer.push_float(-1.1));
     ASSERT_EQ(4, *(int8_t*)buffer.buf());
     ASSERT_STREQ("-1.1", buffer.buf() + 1);
 
-    buffer.Reset();
-    ASSERT_EQ(0, buffer.PushFloat(1000.12));
+    buffer.reset();
+    ASSERT_EQ(0, buffer.push_float(1000.12));
     ASSERT_EQ(7, *(int8_t*)buffer.buf());
     ASSERT_STREQ("1000.12", buffer.buf() + 1);
 }
 TEST_F(MysqlRowBufferTest, double) {
     MysqlRowBuffer buffer;
 
-    ASSERT_EQ(0, buffer.PushDouble(-1.1));
+    ASSERT_EQ(0, buffer.push_double(-1.1));
     ASSERT_EQ(4, *(int8_t*)buffer.buf());
     ASSERT_STREQ("-1.1", buffer.buf() + 1);
 
-    buffer.Reset();
-    ASSERT_EQ(0, buffer.PushDouble(1000.001));
+    buffer.reset();
+    ASSERT_EQ(0, buffer.push_double(1000.001));
     ASSERT_EQ(8, *(int8_t*)buffer.buf());
     ASSERT_STREQ("1000.001", buffer.buf() + 1);
 }
 
+// push_float() and push_double() only call my_gcvt() for values they can't format
+// themselves, their output must be the same as my_gcvt() gives for all values.
+static void check_double(double value) {
+    char expected[MAX_DOUBLE_STR_LENGTH + 8];
+    size_t expected_len = my_gcvt(value, MY_GCVT_ARG_DOUBLE, MAX_DOUBLE_STR_LENGTH + 2,
+                                  expected, NULL);
+    MysqlRowBuffer buffer;
+    ASSERT_EQ(0, buffer.push_double(value));
+    ASSERT_EQ(expected_len, *(uint8_t*)buffer.buf()) << "value: " << value;
+    ASSERT_EQ(std::string(expected, expected_len), std::string(buffer.buf() + 1, expected_len))
+        << "value: " << value;
+}
+
+static void check_float(float value) {
+    char expected[MAX_FLOAT_STR_LENGTH + 8];
+    size_t expected_len = my_gcvt(value, MY_GCVT_ARG_FLOAT, MAX_FLOAT_STR_LENGTH + 2,
+                                  expected, NULL);
+    MysqlRowBuffer buffer;
+    ASSERT_EQ(0, buffer.push_float(value));
+    ASSERT_EQ(expected_len, *(uint8_t*)buffer.buf()) << "value: " << value;
+    ASSERT_EQ(std::string(expected, expected_len), std::string(buffer.buf() + 1, expected_len))
+        << "value: " << value;
+}
+
+TEST_F(MysqlRowBufferTest, double_same_as_gcvt) {
+    // zeros
+    check_double(0.0);
+    check_double(-0.0);
+
+    // decimal ties and values whose shortest digits round up
+    double ties[] = {
+        0.5, 1.5, 2.5, 0.125, 0.15, 0.25, 0.35, 1.005, 2.675, 1234567.5,
+        9.5, 99.95, 999999.5, 0.045, 5e-5, 1e23, 9007199254740993.0,
+        123456789012345.5, 0.1 + 0.2, 1.0 / 3, 2.0 / 3
+    };
+    for (double value : ties) {
+        check_double(value);
+        check_double(-value);
+    }
+
+    // denormals and the limits
+    double limits[] = {
+        std::numeric_limits<double>::denorm_min(), 2 * std::numeric_limits<double>::denorm_min(),
+        1e-310, 2.2250738585072009e-308, DBL_MIN, DBL_MAX, DBL_EPSILON,
+        std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN()
+    };
+    for (double value : limits) {
+        check_double(value);
+        check_double(-value);
+    }
+
+    // around the powers of ten, where the format and the number of digits change
+    for (int exp = -30; exp <= 30; ++exp) {
+        double value = pow(10, exp);
+        check_double(value);
+        check_double(nextafter(value, 0));
+        check_double(nextafter(value, DBL_MAX));
+        check_double(-value);
+    }
+
+    // near 1e15 to 1e17, where integers stop having fractions and stop being exact
+    for (double base : {1e15, 1e16, 1e17}) {
+        double value = base;
+        for (int i = 0; i < 1000; ++i) {
+            check_double(value);
+            value = nextafter(value, DBL_MAX);
+        }
+        value = base;
+        for (int i = 0; i < 1000; ++i) {
+            check_double(value);
+            value = nextafter(value, 0);
+        }
+    }
+    check_double(999999999999999.9);
+    check_double(9999999999999998.0);
+    check_double(123456789012345678.0);
+
+    // random bit patterns and random decimal values
+    std::mt19937_64 rng(20180301);
+    for (int i = 0; i < 200000; ++i) {
+        uint64_t bits = rng();
+        double value = 0;
+        memcpy(&value, &bits, sizeof(value));
+        check_double(value);
+        check_double(static_cast<double>(rng() % 100000000) / pow(10, rng() % 12));
+    }
+}
+
+TEST_F(MysqlRowBufferTest, float_same_as_gcvt) {
+    check_float(0.0f);
+    check_float(-0.0f);
+
+    // values my_gcvt() rounds to FLT_DIG digits
+    float values[] = {
+        0.1f, 1.1f, 1000.12f, 123456.789f, 9.999999f, 0.3333333f, 1e-7f, 99999.995f,
+        16777216.0f, 16777217.0f, 1234567.5f, 0.5f, 2.5f, 0.15f, 1.005f, 3.14159265f,
+        999999.94f, 9999999.0f, 1e10f, 1.5e-5f
+    };
+    for (float value : values) {
+        check_float(value);
+        check_float(-value);
+    }
+
+    float limits[] = {
+        std::numeric_limits<float>::denorm_min(), 1e-40f, FLT_MIN, FLT_MAX, FLT_EPSILON,
+        std::numeric_limits<float>::infinity(), std::numeric_limits<float>::quiet_NaN()
+    };
+    for (float value : limits) {
+        check_float(value);
+        check_float(-value);
+    }
+
+    for (int exp = -20; exp <= 20; ++exp) {
+        float value = powf(10, exp);
+        check_float(value);
+        check_float(nextafterf(value, 0));
+        check_float(nextafterf(value, FLT_MAX));
+    }
+
+    std::mt19937 rng(20180301);
+    for (int i = 0; i < 200000; ++i) {
+        uint32_t bits = rng();
+        float value = 0;
+        memcpy(&value, &bits, sizeof(value));
+        check_float(value);
+    }
+}
+
 TEST_F(MysqlRowBufferTest, string) {
     MysqlRowBuffer buffer;
 
-    ASSERT_EQ(0, buffer.PushString("hello", 6));
+    ASSERT_EQ(0, buffer.push_string("hello", 6));
     ASSERT_EQ(6, *(int8_t*)buffer.buf());
     ASSERT_STREQ("hello", buffer.buf() + 1);
-    ASSERT_NE(0, buffer.PushString(NULL, 6));
+    ASSERT_NE(0, buffer.push_string(NULL, 6));
 }
 
 TEST_F(MysqlRowBufferTest, long_buffer) {
     MysqlRowBuffer buffer;
 
     for (int i = 0; i < 5000; ++i) {
-        ASSERT_EQ(0, buffer.PushInt(10000));
+        ASSERT_EQ(0, buffer.push_int(10000));
     }
 
     ASSERT_EQ(30000, buffer.length());
@@ -143,12 +282,7 @@ TEST_F(MysqlRowBufferTest, long_buffer) {
 }
 
 int main(int argc, char** argv) {
-    std::string conffile = std::string(getenv("PALO_HOME")) + "/conf/be.conf";
-    if (!palo::config::init(conffile.c_str(), false)) {
-        fprintf(stderr, "error read config file. \n");
-        return -1;
-    }
-    init_glog("be-test");
+    palo::init_glog("be-test");
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
 }
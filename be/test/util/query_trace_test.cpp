@@ -0,0 +1,113 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/query_trace.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <rapidjson/document.h>
+
+#include "common/config.h"
+#include "util/logging.h"
+
+namespace palo {
+
+static TUniqueId query(int64_t lo) {
+    TUniqueId id;
+    id.hi = 0;
+    id.lo = lo;
+    return id;
+}
+
+TEST(QueryTraceTest, Spans) {
+    config::query_trace_max_events_per_thread = 100;
+    QueryTrace trace(query(1));
+    {
+        ScopedTraceSpan span(&trace, "fragment", "prepare");
+        ASSERT_TRUE(span.enabled());
+        span.set_detail("instance_id=1:2");
+    }
+    {
+        ScopedTraceSpan span(NULL, "fragment", "open");
+        ASSERT_FALSE(span.enabled());
+    }
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&trace] {
+            for (int j = 0; j < 150; ++j) {
+                int64_t now = QueryTrace::now_us();
+                trace.add_span("exchange", "send_batch", now, now + 10, "");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(401, trace.num_events());
+    ASSERT_EQ(200, trace.num_dropped_events());
+
+    rapidjson::Document document;
+    document.Parse(trace.to_json("be test").c_str());
+    ASSERT_FALSE(document.HasParseError());
+    const rapidjson::Value& events = document["traceEvents"];
+    // the process name and the spans
+    ASSERT_EQ(402u, events.Size());
+    ASSERT_STREQ("M", events[0]["ph"].GetString());
+    ASSERT_STREQ("be test", events[0]["args"]["name"].GetString());
+    int num_prepare = 0;
+    for (rapidjson::SizeType i = 1; i < events.Size(); ++i) {
+        const rapidjson::Value& event = events[i];
+        ASSERT_STREQ("X", event["ph"].GetString());
+        if (std::string("prepare") == event["name"].GetString()) {
+            ASSERT_STREQ("fragment", event["cat"].GetString());
+            ASSERT_STREQ("instance_id=1:2", event["args"]["detail"].GetString());
+            ++num_prepare;
+        } else {
+            ASSERT_STREQ("exchange", event["cat"].GetString());
+            ASSERT_EQ(10, event["dur"].GetInt64());
+            ASSERT_FALSE(event.HasMember("args"));
+        }
+    }
+    ASSERT_EQ(1, num_prepare);
+    ASSERT_EQ(200, document["otherData"]["dropped_events"].GetInt64());
+}
+
+TEST(QueryTraceTest, Mgr) {
+    config::query_trace_max_queries = 2;
+    QueryTraceMgr* mgr = QueryTraceMgr::instance();
+    std::shared_ptr<QueryTrace> trace = mgr->get_or_create(query(10));
+    ASSERT_EQ(trace, mgr->get_or_create(query(10)));
+    ASSERT_EQ(trace, mgr->find(query(10)));
+    ASSERT_TRUE(mgr->find(query(11)) == nullptr);
+
+    mgr->get_or_create(query(11));
+    mgr->get_or_create(query(12));
+    // the oldest trace is evicted, but stays valid for its holders
+    ASSERT_TRUE(mgr->find(query(10)) == nullptr);
+    ASSERT_TRUE(mgr->find(query(12)) != nullptr);
+    trace->add_span("scan", "scan_tablet", 0, 1, "tablet_id=1");
+    ASSERT_EQ(1, trace->num_events());
+}
+
+}
+
+int main(int argc, char** argv) {
+    palo::init_glog("be-test");
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
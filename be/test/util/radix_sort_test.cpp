@@ -0,0 +1,92 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/radix_sort.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace palo {
+
+struct Entry {
+    uint64_t head;
+    int tie;
+};
+
+struct EntryLessThan {
+    bool operator()(const Entry& lhs, const Entry& rhs) const {
+        if (lhs.head != rhs.head) {
+            return lhs.head < rhs.head;
+        }
+        return lhs.tie < rhs.tie;
+    }
+};
+
+static void check_sorted(std::vector<Entry> entries) {
+    std::vector<Entry> expected = entries;
+    std::sort(expected.begin(), expected.end(), EntryLessThan());
+    radix_sort(entries.data(), entries.data() + entries.size(), EntryLessThan());
+    ASSERT_EQ(expected.size(), entries.size());
+    for (int i = 0; i < entries.size(); ++i) {
+        EXPECT_EQ(expected[i].head, entries[i].head) << i;
+        EXPECT_EQ(expected[i].tie, entries[i].tie) << i;
+    }
+}
+
+TEST(RadixSortTest, small) {
+    std::vector<Entry> entries;
+    for (int i = 0; i < 100; ++i) {
+        entries.push_back({(uint64_t) rand(), rand() % 3});
+    }
+    check_sorted(entries);
+}
+
+TEST(RadixSortTest, random) {
+    std::vector<Entry> entries;
+    for (int i = 0; i < 100000; ++i) {
+        uint64_t head = ((uint64_t) rand() << 33) ^ ((uint64_t) rand() << 2) ^ rand();
+        entries.push_back({head, rand() % 3});
+    }
+    check_sorted(entries);
+}
+
+TEST(RadixSortTest, narrow_range) {
+    // timestamps of one day only differ in their low bytes
+    std::vector<Entry> entries;
+    uint64_t base = 20180101000000ULL;
+    for (int i = 0; i < 50000; ++i) {
+        entries.push_back({base + rand() % 86400, rand() % 100});
+    }
+    check_sorted(entries);
+}
+
+TEST(RadixSortTest, ties) {
+    std::vector<Entry> entries;
+    for (int i = 0; i < 20000; ++i) {
+        entries.push_back({(uint64_t)(i % 7) << 56, rand()});
+    }
+    check_sorted(entries);
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
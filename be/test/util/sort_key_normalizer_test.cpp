@@ -0,0 +1,107 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/sort_key_normalizer.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "runtime/raw_value.h"
+#include "runtime/string_value.h"
+#include "runtime/types.h"
+
+namespace palo {
+
+// Returns the sign of the memcmp of the normalized 'lhs' and 'rhs'
+static int compare_normalized(const void* lhs, const void* rhs, const TypeDescriptor& type,
+                              bool is_asc) {
+    bool complete = true;
+    int width = SortKeyNormalizer::value_width(type, &complete);
+    std::vector<uint8_t> lhs_key(width);
+    std::vector<uint8_t> rhs_key(width);
+    SortKeyNormalizer::encode_value(lhs, type, width, is_asc, lhs_key.data());
+    SortKeyNormalizer::encode_value(rhs, type, width, is_asc, rhs_key.data());
+    int result = memcmp(lhs_key.data(), rhs_key.data(), width);
+    return result < 0 ? -1 : (result > 0 ? 1 : 0);
+}
+
+static int sign(int value) {
+    return value < 0 ? -1 : (value > 0 ? 1 : 0);
+}
+
+TEST(SortKeyNormalizerTest, width) {
+    bool complete = false;
+    EXPECT_EQ(4, SortKeyNormalizer::value_width(TypeDescriptor(TYPE_INT), &complete));
+    EXPECT_TRUE(complete);
+    EXPECT_EQ(16, SortKeyNormalizer::value_width(TypeDescriptor(TYPE_LARGEINT), &complete));
+    EXPECT_TRUE(complete);
+    EXPECT_EQ(8, SortKeyNormalizer::value_width(TypeDescriptor::create_varchar_type(10),
+                                                 &complete));
+    EXPECT_FALSE(complete);
+    EXPECT_EQ(0, SortKeyNormalizer::value_width(TypeDescriptor(TYPE_DECIMAL), &complete));
+}
+
+TEST(SortKeyNormalizerTest, integers) {
+    TypeDescriptor type(TYPE_BIGINT);
+    std::vector<int64_t> values = {INT64_MIN, -1000000000000, -1, 0, 1, 255, 256, INT64_MAX};
+    for (int64_t lhs : values) {
+        for (int64_t rhs : values) {
+            int expected = sign(RawValue::compare(&lhs, &rhs, type));
+            EXPECT_EQ(expected, compare_normalized(&lhs, &rhs, type, true));
+            EXPECT_EQ(-expected, compare_normalized(&lhs, &rhs, type, false));
+        }
+    }
+}
+
+TEST(SortKeyNormalizerTest, doubles) {
+    TypeDescriptor type(TYPE_DOUBLE);
+    std::vector<double> values = {-1e300, -2.5, -0.0, 0.0, 1e-300, 2.5, 1e300};
+    for (double lhs : values) {
+        for (double rhs : values) {
+            int expected = sign(RawValue::compare(&lhs, &rhs, type));
+            EXPECT_EQ(expected, compare_normalized(&lhs, &rhs, type, true));
+            EXPECT_EQ(-expected, compare_normalized(&lhs, &rhs, type, false));
+        }
+    }
+}
+
+TEST(SortKeyNormalizerTest, string_prefix) {
+    TypeDescriptor type = TypeDescriptor::create_varchar_type(64);
+    std::string abc("abc");
+    std::string ab("ab");
+    std::string long1("abcdefgh1");
+    std::string long2("abcdefgh2");
+    StringValue abc_value(const_cast<char*>(abc.data()), abc.size());
+    StringValue ab_value(const_cast<char*>(ab.data()), ab.size());
+    StringValue long1_value(const_cast<char*>(long1.data()), long1.size());
+    StringValue long2_value(const_cast<char*>(long2.data()), long2.size());
+    EXPECT_EQ(1, compare_normalized(&abc_value, &ab_value, type, true));
+    // a longer string comes first in DESC order
+    EXPECT_EQ(-1, compare_normalized(&abc_value, &ab_value, type, false));
+    // only the prefixes are kept, the rows break the tie
+    EXPECT_EQ(0, compare_normalized(&long1_value, &long2_value, type, true));
+    EXPECT_EQ(-1, compare_normalized(&abc_value, &long1_value, type, true));
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,52 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "util/sse_util.hpp"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace palo {
+
+static std::vector<size_t> find_all(const std::string& str, char c) {
+    std::vector<size_t> positions;
+    sse_util::for_each_char(str.data(), str.size(), c,
+                            [&positions](size_t pos) { positions.push_back(pos); });
+    return positions;
+}
+
+TEST(SseUtilTest, ForEachChar) {
+    ASSERT_TRUE(find_all("", ',').empty());
+    ASSERT_TRUE(find_all("abc", ',').empty());
+    ASSERT_EQ(std::vector<size_t>({0, 2}), find_all(",a,", ','));
+
+    // matches in the 16 byte blocks and in the tail
+    std::string str(50, 'x');
+    std::vector<size_t> expected({0, 1, 15, 16, 31, 32, 47, 49});
+    for (size_t pos : expected) {
+        str[pos] = '\t';
+    }
+    ASSERT_EQ(expected, find_all(str, '\t'));
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -177,6 +177,14 @@ TEST(StringToInt, Basic) {
     test_int_value<int16_t>("-0", 0, StringParser::PARSE_SUCCESS);
     test_int_value<int32_t>("+0", 0, StringParser::PARSE_SUCCESS);
     test_int_value<int64_t>("-0", 0, StringParser::PARSE_SUCCESS);
+
+    // Parsed eight digits at a time
+    test_int_value<int32_t>("123456789", 123456789, StringParser::PARSE_SUCCESS);
+    test_int_value<int64_t>("1234567890123456", 1234567890123456, StringParser::PARSE_SUCCESS);
+    test_int_value<int64_t>("-123456789012345678", -123456789012345678,
+            StringParser::PARSE_SUCCESS);
+    test_int_value<int64_t>("12345678a", 0, StringParser::PARSE_FAILURE);
+    test_int_value<int64_t>("1234567/9012345", 0, StringParser::PARSE_FAILURE);
 }
 
 TEST(StringToInt, InvalidLeadingTrailing) {
@@ -366,6 +374,11 @@ TEST(StringToFloat, Basic) {
     test_all_float_variants(".456", StringParser::PARSE_SUCCESS);
     test_all_float_variants("456.0", StringParser::PARSE_SUCCESS);
     test_all_float_variants("456.789", StringParser::PARSE_SUCCESS);
+    // Converted exactly, as strtod() does
+    test_all_float_variants("0.1", StringParser::PARSE_SUCCESS);
+    test_all_float_variants("9007199254740.992", StringParser::PARSE_SUCCESS);
+    test_all_float_variants("0.0000000000000000000123", StringParser::PARSE_SUCCESS);
+    test_all_float_variants("123456789.123456789", StringParser::PARSE_SUCCESS);
 
     // Scientific notation.
     test_all_float_variants("1e10", StringParser::PARSE_SUCCESS);
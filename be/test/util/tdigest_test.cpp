@@ -0,0 +1,85 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/tdigest.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace palo {
+
+TEST(TDigestTest, single_value) {
+    TDigest digest;
+    digest.add(3.5);
+    EXPECT_FALSE(digest.empty());
+    EXPECT_EQ(3.5, digest.quantile(0));
+    EXPECT_EQ(3.5, digest.quantile(0.5));
+    EXPECT_EQ(3.5, digest.quantile(1));
+}
+
+TEST(TDigestTest, uniform) {
+    TDigest digest;
+    for (int i = 0; i < 100000; ++i) {
+        digest.add(i);
+    }
+    EXPECT_EQ(0, digest.quantile(0));
+    EXPECT_EQ(99999, digest.quantile(1));
+    EXPECT_NEAR(50000, digest.quantile(0.5), 500);
+    EXPECT_NEAR(99000, digest.quantile(0.99), 100);
+    EXPECT_NEAR(1000, digest.quantile(0.01), 100);
+}
+
+TEST(TDigestTest, merge) {
+    std::vector<double> values;
+    TDigest left;
+    TDigest right;
+    for (int i = 0; i < 50000; ++i) {
+        double value = exp((rand() % 10000) / 1000.0);
+        values.push_back(value);
+        if (i % 3 == 0) {
+            left.add(value);
+        } else {
+            right.add(value);
+        }
+    }
+    std::sort(values.begin(), values.end());
+
+    std::vector<char> buf(right.serialized_size());
+    right.serialize(&buf[0]);
+    TDigest merged;
+    merged.merge(&left);
+    EXPECT_TRUE(merged.merge_serialized(&buf[0], buf.size()));
+    EXPECT_FALSE(merged.merge_serialized(&buf[0], buf.size() - 1));
+
+    double qs[] = { 0.01, 0.5, 0.95, 0.99 };
+    for (int i = 0; i < 4; ++i) {
+        double expected = values[static_cast<int>(qs[i] * values.size())];
+        EXPECT_NEAR(expected, merged.quantile(qs[i]), expected * 0.05) << qs[i];
+    }
+    EXPECT_EQ(values.front(), merged.quantile(0));
+    EXPECT_EQ(values.back(), merged.quantile(1));
+}
+
+}
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
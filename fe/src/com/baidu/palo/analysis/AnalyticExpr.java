@@ -495,10 +495,12 @@ public class AnalyticExpr extends Expr {
 
         standardize(analyzer);
 
-        // min/max is not currently supported on sliding windows (i.e. start bound is not
-        // unbounded).
+        // min/max on sliding windows (i.e. start bound is not unbounded) is evaluated by
+        // the backend without removing rows, which does not support string arguments.
         if (window != null && isMinMax(fn) &&
-                window.getLeftBoundary().getType() != BoundaryType.UNBOUNDED_PRECEDING) {
+                window.getLeftBoundary().getType() != BoundaryType.UNBOUNDED_PRECEDING &&
+                (window.getType() != AnalyticWindow.Type.ROWS
+                || getFnCall().getChild(0).getType().isStringType())) {
             throw new AnalysisException(
                 "'" + getFnCall().toSql() + "' is only supported with an "
                 + "UNBOUNDED PRECEDING start bound.");
@@ -832,7 +832,8 @@ public class SelectStmt extends QueryStmt {
         ExprSubstitutionMap avgSMap = createAvgSMap(aggExprs, analyzer);
 
         // Optionally rewrite all count(distinct <expr>) into equivalent NDV() calls.
-        ExprSubstitutionMap ndvSmap = avgSMap;
+        ExprSubstitutionMap ndvSmap = ExprSubstitutionMap.compose(
+                avgSMap, createMultiDistinctSMap(aggExprs, analyzer), analyzer);
 
         // When DISTINCT aggregates are present, non-distinct (i.e. ALL) aggregates are
         // evaluated in two phases (see AggregateInfo for more details). In particular,
@@ -957,6 +958,65 @@ public class SelectStmt extends QueryStmt {
         return result;
     }
 
+    /**
+     * Build smap COUNT(DISTINCT <expr>) -> MULTI_DISTINCT_COUNT(<expr>) and
+     * SUM(DISTINCT <expr>) -> MULTI_DISTINCT_SUM(<expr>) if the DISTINCT aggregates have
+     * different parameters. Grouping by the parameters of all of them multiplies the
+     * groups of the first aggregation phase, while the multi_distinct functions keep a
+     * set of the values per group and merge the sets between phases. Unlike the
+     * COUNT_DISTINCT/SUM_DISTINCT the BE would otherwise evaluate, their sets can be
+     * serialized, so the aggregation can spill.
+     */
+    private ExprSubstitutionMap createMultiDistinctSMap(
+            List<FunctionCallExpr> aggExprs, Analyzer analyzer) throws AnalysisException {
+        ExprSubstitutionMap result = new ExprSubstitutionMap();
+        if (analyzer.getContext() != null
+                && !analyzer.getContext().getSessionVariable().isEnableMultiDistinctCount()) {
+            return result;
+        }
+        List<Expr> distinctParams = null;
+        boolean isMultiDistinct = false;
+        for (FunctionCallExpr aggExpr : aggExprs) {
+            if (!aggExpr.isDistinct()) {
+                continue;
+            }
+            List<Expr> params = Lists.newArrayList();
+            for (Expr child : aggExpr.getChildren()) {
+                params.add(child.ignoreImplicitCast());
+            }
+            if (distinctParams == null) {
+                distinctParams = params;
+            } else if (!Expr.equalLists(distinctParams, params)) {
+                isMultiDistinct = true;
+            }
+        }
+        if (!isMultiDistinct) {
+            return result;
+        }
+        for (FunctionCallExpr aggExpr : aggExprs) {
+            if (!aggExpr.isDistinct() || aggExpr.getChildren().size() != 1) {
+                continue;
+            }
+            String fnName = aggExpr.getFnName().getFunction();
+            Type type = aggExpr.getChild(0).getType();
+            String multiDistinctFnName = null;
+            if (fnName.equalsIgnoreCase("count")
+                    && (type.isIntegerType() || type.isDateType() || type.isStringType())) {
+                multiDistinctFnName = "multi_distinct_count";
+            } else if (fnName.equalsIgnoreCase("sum") && type.isNumericType()) {
+                multiDistinctFnName = "multi_distinct_sum";
+            } else {
+                continue;
+            }
+            FunctionCallExpr multiDistinctExpr = new FunctionCallExpr(multiDistinctFnName,
+                    Lists.newArrayList(aggExpr.getChild(0).clone(null)));
+            multiDistinctExpr.analyze(analyzer);
+            result.put(aggExpr, multiDistinctExpr);
+        }
+        LOG.debug("multi distinct smap: {}", result.debugString());
+        return result;
+    }
+
     /**
      * Create a map from COUNT([ALL]) -> zeroifnull(COUNT([ALL])) if
      * i) There is no GROUP-BY, and
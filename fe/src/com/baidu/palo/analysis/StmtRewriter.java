@@ -510,8 +510,15 @@ public class StmtRewriter {
             // For the case of a NOT IN with an eq join conjunct, replace the join
             // conjunct with a conjunct that uses the null-matching eq operator.
             if (expr instanceof InPredicate) {
-                // joinOp = JoinOperator.NULL_AWARE_LEFT_ANTI_JOIN;
-                joinOp = JoinOperator.LEFT_ANTI_JOIN;
+                // A NULL on either side makes NOT IN unknown instead of true. The hash
+                // join handles this for the NOT IN conjunct alone, so correlated NOT IN
+                // subqueries, whose correlation predicates are join conjuncts as well,
+                // stay plain anti joins.
+                if (onClausePredicate.getConjuncts().size() == 1) {
+                    joinOp = JoinOperator.NULL_AWARE_LEFT_ANTI_JOIN;
+                } else {
+                    joinOp = JoinOperator.LEFT_ANTI_JOIN;
+                }
                 List<TupleId> tIds = Lists.newArrayList();
                 joinConjunct.getIds(tIds, null);
                 if (tIds.size() <= 1 || !tIds.contains(inlineView.getDesc().getId())) {
@@ -559,7 +566,8 @@ public class StmtRewriter {
             for (int j = 0; j < tableIdx; ++j) {
                 TableRef tableRef = stmt.fromClause_.get(j);
                 if (tableRef.getJoinOp() == JoinOperator.LEFT_SEMI_JOIN ||
-                        tableRef.getJoinOp() == JoinOperator.LEFT_ANTI_JOIN) {
+                        tableRef.getJoinOp() == JoinOperator.LEFT_ANTI_JOIN ||
+                        tableRef.getJoinOp() == JoinOperator.NULL_AWARE_LEFT_ANTI_JOIN) {
                     continue;
                 }
                 newItems.add(SelectListItem.createStarItem(tableRef.getAliasAsName()));
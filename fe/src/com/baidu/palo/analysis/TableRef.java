@@ -483,6 +483,8 @@ public class TableRef implements ParseNode {
                 return "LEFT SEMI JOIN";
             case LEFT_ANTI_JOIN:
                 return "LEFT ANTI JOIN";
+            case NULL_AWARE_LEFT_ANTI_JOIN:
+                return "NULL AWARE LEFT ANTI JOIN";
             case RIGHT_SEMI_JOIN:
                 return "RIGHT SEMI JOIN";
             case RIGHT_ANTI_JOIN:
@@ -183,6 +183,52 @@ public class FunctionSet {
                 .put(Type.HLL,
                     "20hll_union_agg_updateEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_")
                 .build();
+
+    // bitmap_union/bitmap_count take integers or bitmaps serialized by bitmap_union
+    private static final Map<Type, String> BITMAP_UPDATE_SYMBOL =
+        ImmutableMap.<Type, String>builder()
+                .put(Type.TINYINT,
+                    "17bitmap_update_intIN8palo_udf10TinyIntValEEEvPNS2_15FunctionContextERKT_PNS2_9StringValE")
+                .put(Type.SMALLINT,
+                    "17bitmap_update_intIN8palo_udf11SmallIntValEEEvPNS2_15FunctionContextERKT_PNS2_9StringValE")
+                .put(Type.INT,
+                    "17bitmap_update_intIN8palo_udf6IntValEEEvPNS2_15FunctionContextERKT_PNS2_9StringValE")
+                .put(Type.BIGINT,
+                    "17bitmap_update_intIN8palo_udf9BigIntValEEEvPNS2_15FunctionContextERKT_PNS2_9StringValE")
+                .put(Type.VARCHAR,
+                    "13bitmap_updateEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_")
+                .build();
+
+    // multi_distinct_count, which COUNT(DISTINCT) is rewritten to when a query has
+    // several of them over different columns
+    private static final Map<Type, String> MULTI_DISTINCT_COUNT_UPDATE_SYMBOL =
+        ImmutableMap.<Type, String>builder()
+                .put(Type.TINYINT,
+                    "31multi_distinct_count_update_intIN8palo_udf10TinyIntValEEEvPNS2_15FunctionContextERKT_PNS2_9StringValE")
+                .put(Type.SMALLINT,
+                    "31multi_distinct_count_update_intIN8palo_udf11SmallIntValEEEvPNS2_15FunctionContextERKT_PNS2_9StringValE")
+                .put(Type.INT,
+                    "31multi_distinct_count_update_intIN8palo_udf6IntValEEEvPNS2_15FunctionContextERKT_PNS2_9StringValE")
+                .put(Type.BIGINT,
+                    "31multi_distinct_count_update_intIN8palo_udf9BigIntValEEEvPNS2_15FunctionContextERKT_PNS2_9StringValE")
+                .put(Type.DATE,
+                    "36multi_distinct_count_update_datetimeEPN8palo_udf15FunctionContextERKNS1_11DateTimeValEPNS1_9StringValE")
+                .put(Type.DATETIME,
+                    "36multi_distinct_count_update_datetimeEPN8palo_udf15FunctionContextERKNS1_11DateTimeValEPNS1_9StringValE")
+                .put(Type.CHAR,
+                    "34multi_distinct_count_update_stringEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_")
+                .put(Type.VARCHAR,
+                    "34multi_distinct_count_update_stringEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_")
+                .build();
+
+    // the types multi_distinct_sum is defined for, with the mangled name of their *Val
+    private static final Map<Type, String> MULTI_DISTINCT_SUM_TYPES =
+        ImmutableMap.<Type, String>builder()
+                .put(Type.BIGINT, "9BigIntVal")
+                .put(Type.LARGEINT, "11LargeIntVal")
+                .put(Type.DOUBLE, "9DoubleVal")
+                .put(Type.DECIMAL, "10DecimalVal")
+                .build();
  
     private static final Map<Type, String> OFFSET_FN_INIT_SYMBOL =
         ImmutableMap.<Type, String>builder()
@@ -562,7 +608,7 @@ public class FunctionSet {
                     prefix + "8hll_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
                     prefix + HLL_UPDATE_SYMBOL.get(t),
                     prefix + "9hll_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
-                    null,
+                    stringValSerializeOrFinalize,
                     prefix + "12hll_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
                     true, false, true));
 
@@ -572,17 +618,51 @@ public class FunctionSet {
                     prefix + "18hll_union_agg_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
                     prefix + HLL_UNION_AGG_UPDATE_SYMBOL.get(t),
                     prefix + "19hll_union_agg_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
-                    null,
+                    stringValSerializeOrFinalize,
                     prefix + "22hll_union_agg_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
                     true, false, true));
 
+            // BITMAP_UNION, BITMAP_COUNT
+            if (BITMAP_UPDATE_SYMBOL.containsKey(t)) {
+                String bitmapSerialize = prefix
+                        + "16bitmap_serializeEPN8palo_udf15FunctionContextERKNS1_9StringValE";
+                addBuiltin(AggregateFunction.createBuiltin("bitmap_union",
+                        Lists.newArrayList(t), Type.VARCHAR, Type.VARCHAR,
+                        prefix + "11bitmap_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
+                        prefix + BITMAP_UPDATE_SYMBOL.get(t),
+                        prefix + "12bitmap_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
+                        bitmapSerialize,
+                        bitmapSerialize,
+                        true, false, true));
+                addBuiltin(AggregateFunction.createBuiltin("bitmap_count",
+                        Lists.newArrayList(t), Type.BIGINT, Type.VARCHAR,
+                        prefix + "11bitmap_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
+                        prefix + BITMAP_UPDATE_SYMBOL.get(t),
+                        prefix + "12bitmap_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
+                        bitmapSerialize,
+                        prefix + "21bitmap_count_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
+                        true, false, true));
+            }
+
+            // MULTI_DISTINCT_COUNT
+            if (MULTI_DISTINCT_COUNT_UPDATE_SYMBOL.containsKey(t)) {
+                addBuiltin(AggregateFunction.createBuiltin("multi_distinct_count",
+                        Lists.newArrayList(t), Type.BIGINT, Type.VARCHAR,
+                        prefix + "25multi_distinct_count_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
+                        prefix + MULTI_DISTINCT_COUNT_UPDATE_SYMBOL.get(t),
+                        prefix + "26multi_distinct_count_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
+                        prefix + "30multi_distinct_count_serializeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
+                        prefix + "29multi_distinct_count_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
+                        true, false, true));
+            }
+
             if (STDDEV_UPDATE_SYMBOL.containsKey(t)) {
                 addBuiltin(AggregateFunction.createBuiltin("stddev",
                         Lists.newArrayList(t), Type.DOUBLE, Type.VARCHAR,
                         prefix + "14knuth_var_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
                         prefix + STDDEV_UPDATE_SYMBOL.get(t),
                         prefix + "15knuth_var_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
-                        null,
+                        stringValSerializeOrFinalize,
                         prefix + "21knuth_stddev_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
                         false, false, false));
                 addBuiltin(AggregateFunction.createBuiltin("stddev_samp",
@@ -590,7 +670,7 @@ public class FunctionSet {
                         prefix + "14knuth_var_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
                         prefix + STDDEV_UPDATE_SYMBOL.get(t),
                         prefix + "15knuth_var_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
-                        null,
+                        stringValSerializeOrFinalize,
                         prefix + "21knuth_stddev_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
                         false, false, false));
                 addBuiltin(AggregateFunction.createBuiltin("stddev_pop",
@@ -598,7 +678,7 @@ public class FunctionSet {
                         prefix + "14knuth_var_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
                         prefix + STDDEV_UPDATE_SYMBOL.get(t),
                         prefix + "15knuth_var_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
-                        null,
+                        stringValSerializeOrFinalize,
                         prefix + "25knuth_stddev_pop_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
                         false, false, false));
                 addBuiltin(AggregateFunction.createBuiltin("variance",
@@ -606,7 +686,7 @@ public class FunctionSet {
                         prefix + "14knuth_var_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
                         prefix + STDDEV_UPDATE_SYMBOL.get(t),
                         prefix + "15knuth_var_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
-                        null,
+                        stringValSerializeOrFinalize,
                         prefix + "18knuth_var_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
                         false, false, false));
                 addBuiltin(AggregateFunction.createBuiltin("variance_samp",
@@ -614,7 +694,7 @@ public class FunctionSet {
                         prefix + "14knuth_var_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
                         prefix + STDDEV_UPDATE_SYMBOL.get(t),
                         prefix + "15knuth_var_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
-                        null,
+                        stringValSerializeOrFinalize,
                         prefix + "18knuth_var_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
                         false, false, false));
                 addBuiltin(AggregateFunction.createBuiltin("var_samp",
@@ -622,7 +702,7 @@ public class FunctionSet {
                         prefix + "14knuth_var_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
                         prefix + STDDEV_UPDATE_SYMBOL.get(t),
                         prefix + "15knuth_var_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
-                        null,
+                        stringValSerializeOrFinalize,
                         prefix + "18knuth_var_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
                         false, false, false));
                 addBuiltin(AggregateFunction.createBuiltin("variance_pop",
@@ -630,7 +710,7 @@ public class FunctionSet {
                         prefix + "14knuth_var_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
                         prefix + STDDEV_UPDATE_SYMBOL.get(t),
                         prefix + "15knuth_var_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
-                        null,
+                        stringValSerializeOrFinalize,
                         prefix + "22knuth_var_pop_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
                         false, false, false));
                 addBuiltin(AggregateFunction.createBuiltin("var_pop",
@@ -638,7 +718,7 @@ public class FunctionSet {
                         prefix + "14knuth_var_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
                         prefix + STDDEV_UPDATE_SYMBOL.get(t),
                         prefix + "15knuth_var_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
-                        null,
+                        stringValSerializeOrFinalize,
                         prefix + "22knuth_var_pop_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
                         false, false, false));
             }
@@ -662,13 +742,27 @@ public class FunctionSet {
                     null, null,
                     prefix + "10sum_removeIN8palo_udf9DoubleValES3_EEvPNS2_15FunctionContextERKT_PT0_",
                     null, false, true, false));
-            addBuiltin(AggregateFunction.createBuiltin(name,
-                    Lists.<Type>newArrayList(Type.DECIMAL), Type.DECIMAL, Type.DECIMAL, initNull,
-                    prefix + "3sumIN8palo_udf10DecimalValES3_EEvPNS2_15FunctionContextERKT_PT0_",
-                    prefix + "3sumIN8palo_udf10DecimalValES3_EEvPNS2_15FunctionContextERKT_PT0_",
-                    null, null,
-                    prefix + "10sum_removeIN8palo_udf10DecimalValES3_EEvPNS2_15FunctionContextERKT_PT0_",
-                    null, false, true, false));
+            if (name.equals("sum")) {
+                // Keeps the running sum in the intermediate value of avg(decimal)
+                addBuiltin(AggregateFunction.createBuiltin(name,
+                        Lists.<Type>newArrayList(Type.DECIMAL), Type.DECIMAL, Type.VARCHAR,
+                        prefix + "16decimal_avg_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
+                        prefix + "18decimal_avg_updateEPN8palo_udf15FunctionContextERKNS1_10DecimalValEPNS1_9StringValE",
+                        prefix + "17decimal_avg_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
+                        stringValSerializeOrFinalize,
+                        prefix + "21decimal_sum_get_valueEPN8palo_udf15FunctionContextERKNS1_9StringValE",
+                        prefix + "18decimal_avg_removeEPN8palo_udf15FunctionContextERKNS1_10DecimalValEPNS1_9StringValE",
+                        prefix + "20decimal_sum_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
+                        false, true, false));
+            } else {
+                addBuiltin(AggregateFunction.createBuiltin(name,
+                        Lists.<Type>newArrayList(Type.DECIMAL), Type.DECIMAL, Type.DECIMAL, initNull,
+                        prefix + "3sumIN8palo_udf10DecimalValES3_EEvPNS2_15FunctionContextERKT_PT0_",
+                        prefix + "3sumIN8palo_udf10DecimalValES3_EEvPNS2_15FunctionContextERKT_PT0_",
+                        null, null,
+                        prefix + "10sum_removeIN8palo_udf10DecimalValES3_EEvPNS2_15FunctionContextERKT_PT0_",
+                        null, false, true, false));
+            }
             addBuiltin(AggregateFunction.createBuiltin(name,
                     Lists.<Type>newArrayList(Type.LARGEINT), Type.LARGEINT, Type.LARGEINT, initNull,
                     prefix + "3sumIN8palo_udf11LargeIntValES3_EEvPNS2_15FunctionContextERKT_PT0_",
@@ -678,6 +772,25 @@ public class FunctionSet {
                     null, false, true, false));
         }
 
+        // MULTI_DISTINCT_SUM, which SUM(DISTINCT) is rewritten to when a query has several
+        // distinct aggregates over different columns
+        for (Type t : MULTI_DISTINCT_SUM_TYPES.keySet()) {
+            String valType = MULTI_DISTINCT_SUM_TYPES.get(t);
+            addBuiltin(AggregateFunction.createBuiltin("multi_distinct_sum",
+                    Lists.<Type>newArrayList(t), t, Type.VARCHAR,
+                    prefix + "23multi_distinct_sum_initIN8palo_udf" + valType
+                            + "EEEvPNS2_15FunctionContextEPNS2_9StringValE",
+                    prefix + "25multi_distinct_sum_updateIN8palo_udf" + valType
+                            + "EEEvPNS2_15FunctionContextERKT_PNS2_9StringValE",
+                    prefix + "24multi_distinct_sum_mergeIN8palo_udf" + valType
+                            + "EEEvPNS2_15FunctionContextERKNS2_9StringValEPS6_",
+                    prefix + "28multi_distinct_sum_serializeIN8palo_udf" + valType
+                            + "EEENS2_9StringValEPNS2_15FunctionContextERKS4_",
+                    prefix + "27multi_distinct_sum_finalizeIN8palo_udf" + valType
+                            + "EEET_PNS2_15FunctionContextERKNS2_9StringValE",
+                    false, false, false));
+        }
+
 
         // Avg
         // TODO: switch to CHAR(sizeof(AvgIntermediateType) when that becomes available
@@ -750,6 +863,16 @@ public class FunctionSet {
                 prefix + "22string_concat_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
                 false, false, false));
 
+        // Percentile_approx(double, double)
+        addBuiltin(AggregateFunction.createBuiltin("percentile_approx",
+                Lists.<Type>newArrayList(Type.DOUBLE, Type.DOUBLE), Type.DOUBLE, Type.VARCHAR,
+                prefix + "22percentile_approx_initEPN8palo_udf15FunctionContextEPNS1_9StringValE",
+                prefix + "24percentile_approx_updateEPN8palo_udf15FunctionContextERKNS1_9DoubleValES6_PNS1_9StringValE",
+                prefix + "23percentile_approx_mergeEPN8palo_udf15FunctionContextERKNS1_9StringValEPS4_",
+                prefix + "27percentile_approx_serializeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
+                prefix + "26percentile_approx_finalizeEPN8palo_udf15FunctionContextERKNS1_9StringValE",
+                false, false, false));
+
         // analytic functions
         // Rank
         addBuiltin(AggregateFunction.createAnalyticBuiltin("rank",
@@ -17,6 +17,7 @@ package com.baidu.palo.catalog;
 
 import com.baidu.palo.common.io.Text;
 import com.baidu.palo.common.io.Writable;
+import com.baidu.palo.thrift.TColumnSketch;
 
 import org.apache.logging.log4j.Logger;
 import org.apache.logging.log4j.LogManager;
@@ -25,6 +26,7 @@ import java.io.DataInput;
 import java.io.DataOutput;
 import java.io.IOException;
 import java.util.Comparator;
+import java.util.List;
 
 /**
  * This class represents the olap replica related metadata.
@@ -47,6 +49,8 @@ public class Replica implements Writable {
     private long dataSize;
     private long rowCount;
     private ReplicaState state;
+    // column statistics in the latest tablet report, not persisted
+    private volatile List<TColumnSketch> columnSketches;
     
     public Replica() {
     }
@@ -109,6 +113,14 @@ public class Replica implements Writable {
         LOG.debug("update {}", this.toString());
     }
 
+    public List<TColumnSketch> getColumnSketches() {
+        return columnSketches;
+    }
+
+    public void setColumnSketches(List<TColumnSketch> columnSketches) {
+        this.columnSketches = columnSketches;
+    }
+
     public boolean checkVersionCatchUp(long committedVersion, long committedVersionHash) {
         if (this.version < committedVersion
                 || (this.version == committedVersion && this.versionHash != committedVersionHash)) {
@@ -45,6 +45,9 @@ public class ScalarFunction extends Function {
     private String symbolName;
     private String prepareFnSymbol;
     private String closeFnSymbol;
+    // Optional function evaluating the function over a batch of rows, see UdfBatchFn in
+    // the BE's udf.h
+    private String batchFnSymbol;
 
     public ScalarFunction(
             FunctionName fnName, ArrayList<Type> argTypes, Type retType, boolean hasVarArgs) {
@@ -210,10 +213,12 @@ public class ScalarFunction extends Function {
     public void setSymbolName(String s) { symbolName = s; }
     public void setPrepareFnSymbol(String s) { prepareFnSymbol = s; }
     public void setCloseFnSymbol(String s) { closeFnSymbol = s; }
+    public void setBatchFnSymbol(String s) { batchFnSymbol = s; }
 
     public String getSymbolName() { return symbolName; }
     public String getPrepareFnSymbol() { return prepareFnSymbol; }
     public String getCloseFnSymbol() { return closeFnSymbol; }
+    public String getBatchFnSymbol() { return batchFnSymbol; }
 
     @Override
     public String toSql(boolean ifNotExists) {
@@ -237,6 +242,9 @@ public class ScalarFunction extends Function {
         if (closeFnSymbol != null) {
             fn.getScalar_fn().setClose_fn_symbol(closeFnSymbol);
         }
+        if (batchFnSymbol != null) {
+            fn.getScalar_fn().setBatch_fn_symbol(batchFnSymbol);
+        }
         return fn;
     }
 }
@@ -92,7 +92,10 @@ public class TabletInvertedIndex {
         this.lock.writeLock().unlock();
     }
 
+    // an incremental report only carries the tablets which changed on the backend, the
+    // tablets it dropped are in 'removedTablets' and the others are left alone
     public void tabletReport(long backendId, Map<Long, TTablet> backendTablets,
+                             boolean incremental, Set<Long> removedTablets,
                              final HashMap<Long, TStorageMedium> storageMediumMap,
                              ListMultimap<Long, Long> tabletSyncMap,
                              ListMultimap<Long, Long> tabletDeleteFromMeta,
@@ -105,7 +108,24 @@ public class TabletInvertedIndex {
         try {
             LOG.info("begin to do tablet diff with backend[{}]. num: {}", backendId, backendTablets.size());
             start = System.currentTimeMillis();
-            Map<Long, Replica> replicaMetaWithBackend = replicaMetaTable.column(backendId);
+            Map<Long, Replica> replicaMetaWithBackend;
+            if (incremental) {
+                replicaMetaWithBackend = Maps.newHashMap();
+                for (long tabletId : backendTablets.keySet()) {
+                    Replica replica = replicaMetaTable.get(tabletId, backendId);
+                    if (replica != null) {
+                        replicaMetaWithBackend.put(tabletId, replica);
+                    }
+                }
+                for (long tabletId : removedTablets) {
+                    Replica replica = replicaMetaTable.get(tabletId, backendId);
+                    if (replica != null) {
+                        replicaMetaWithBackend.put(tabletId, replica);
+                    }
+                }
+            } else {
+                replicaMetaWithBackend = replicaMetaTable.column(backendId);
+            }
             if (replicaMetaWithBackend != null) {
                 // traverse replicas in meta with this backend
                 for (Map.Entry<Long, Replica> entry : replicaMetaWithBackend.entrySet()) {
@@ -119,6 +139,9 @@ public class TabletInvertedIndex {
                         for (TTabletInfo backendTabletInfo : backendTablet.getTablet_infos()) {
                             if (tabletMeta.containsSchemaHash(backendTabletInfo.getSchema_hash())) {
                                 foundTabletsWithValidSchema.add(tabletId);
+                                if (backendTabletInfo.isSetColumn_sketches()) {
+                                    replica.setColumnSketches(backendTabletInfo.getColumn_sketches());
+                                }
                                 // 1. (intersection)
                                 if (checkSync(replica, backendTabletInfo.getVersion(),
                                               backendTabletInfo.getVersion_hash())) {
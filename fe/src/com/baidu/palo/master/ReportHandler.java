@@ -69,6 +69,7 @@ public class ReportHandler {
         TMasterResult result = new TMasterResult();
         TStatus tStatus = new TStatus(TStatusCode.OK);
         result.setStatus(tStatus);
+        result.setAccepts_incremental_report(true);
 
         // get backend
         TBackend tBackend = request.getBackend();
@@ -98,12 +99,21 @@ public class ReportHandler {
             if (request.getReport_version() >= backendReportVersion) {
                 LOG.debug("REPORTING[TABLET] begin. backend[{}-{}-{}]", backendId, host, bePort);
                 long start = System.currentTimeMillis();
-                ReportHandler.tabletReport(backendId, request.getTablets(), request.getReport_version());
+                boolean incremental = request.isSetIncremental() && request.isIncremental();
+                Set<Long> removedTablets = request.isSetRemoved_tablets()
+                        ? request.getRemoved_tablets() : new HashSet<Long>();
+                ReportHandler.tabletReport(backendId, request.getTablets(), incremental, removedTablets,
+                                           request.getReport_version());
                 long end = System.currentTimeMillis();
                 LOG.debug("REPORTING[TABLET] end. backend[{}-{}-{}]. cost: {}", backendId, host, bePort, (end - start));
             } else {
                 LOG.warn("out of date report[{}] from backend[{}]. current report version[{}]",
                          request.getReport_version(), backendId, backendReportVersion);
+                // the backend sends the tablets again with its next report
+                tStatus.setStatus_code(TStatusCode.CANCELLED);
+                List<String> errorMsgs = new ArrayList<String>();
+                errorMsgs.add("out of date report[" + request.getReport_version() + "]");
+                tStatus.setError_msgs(errorMsgs);
             }
         }
 
@@ -117,10 +127,11 @@ public class ReportHandler {
         return result;
     }
 
-    private static void tabletReport(long backendId, Map<Long, TTablet> backendTablets, long backendReportVersion) {
+    private static void tabletReport(long backendId, Map<Long, TTablet> backendTablets, boolean incremental,
+                                     Set<Long> removedTablets, long backendReportVersion) {
         long start = System.currentTimeMillis();
-        LOG.info("backend[{}] reports {} tablet(s). report version: {}",
-                 backendId, backendTablets.size(), backendReportVersion);
+        LOG.info("backend[{}] reports {} tablet(s), {} removed. incremental: {}. report version: {}",
+                 backendId, backendTablets.size(), removedTablets.size(), incremental, backendReportVersion);
 
         // storage medium map
         HashMap<Long, TStorageMedium> storageMediumMap = Catalog.getInstance().getPartitionIdToStorageMediumMap();
@@ -137,7 +148,8 @@ public class ReportHandler {
         ListMultimap<TStorageMedium, Long> tabletMigrationMap = LinkedListMultimap.create();
 
         // 1. do the diff. find out (intersection) / (be - meta) / (meta - be)
-        Catalog.getCurrentInvertedIndex().tabletReport(backendId, backendTablets, storageMediumMap,
+        Catalog.getCurrentInvertedIndex().tabletReport(backendId, backendTablets, incremental, removedTablets,
+                                                       storageMediumMap,
                                                        tabletSyncMap,
                                                        tabletDeleteFromMeta,
                                                        foundTabletsWithValidSchema,
@@ -55,6 +55,10 @@ public class AggregationNode extends PlanNode {
     // node is the root node of a distributed aggregation.
     private boolean needsFinalize;
 
+    // If true, this node is the first phase of a multi-phase aggregation and the backend
+    // may pass rows through to the merge aggregation if they are not reduced enough.
+    private boolean useStreamingPreagg;
+
     /**
      * Create an agg node that is not an intermediate node.
      * isIntermediate is true if it is a slave node in a 2-part agg plan.
@@ -74,6 +78,7 @@ public class AggregationNode extends PlanNode {
         super(id, src, "AGGREGATE");
         aggInfo = src.aggInfo;
         needsFinalize = src.needsFinalize;
+        useStreamingPreagg = src.useStreamingPreagg;
     }
 
     public AggregateInfo getAggInfo() {
@@ -88,6 +93,15 @@ public class AggregationNode extends PlanNode {
         updateplanNodeName();
     }
 
+    /**
+     * Sets this node as the preaggregation of a multi-phase aggregation. Only
+     * aggregations with grouping exprs can stream.
+     */
+    public void setIsPreagg() {
+        List<Expr> groupingExprs = aggInfo.getGroupingExprs();
+        useStreamingPreagg = groupingExprs != null && !groupingExprs.isEmpty();
+    }
+
     @Override
     public void setCompactData(boolean on) {
         this.compactData = on;
@@ -248,6 +262,7 @@ public class AggregationNode extends PlanNode {
         if (groupingExprs != null) {
             msg.agg_node.setGrouping_exprs(Expr.treesToThrift(groupingExprs));
         }
+        msg.agg_node.setUse_streaming_preaggregation(useStreamingPreagg);
     }
 
     @Override
@@ -260,6 +275,9 @@ public class AggregationNode extends PlanNode {
         // TODO: group by can be very long. Break it into multiple lines
         output.append(detailPrefix + "group by: ").append(
           getExplainString(aggInfo.getGroupingExprs()) + "\n");
+        if (useStreamingPreagg) {
+            output.append(detailPrefix + "streaming: true\n");
+        }
         if (!conjuncts.isEmpty()) {
             output.append(detailPrefix + "having: ").append(getExplainString(conjuncts) + "\n");
         }
@@ -107,6 +107,12 @@ public class AnalyticEvalNode extends PlanNode {
     public List<OrderByElement> getOrderByElements() {
         return orderByElements;
     }
+    public List<Expr> getAnalyticFnCalls() {
+        return analyticFnCalls;
+    }
+    public TupleDescriptor getOutputTupleDesc() {
+        return outputTupleDesc;
+    }
 
     @Override
     public void init(Analyzer analyzer) throws InternalException {
@@ -420,6 +420,7 @@ public class AnalyticPlanner {
             // to be executed like a regular distributed sort
             if (!partitionByExprs.isEmpty()) {
                 sortNode.setIsAnalyticSort(true);
+                sortNode.setNumAnalyticPartitionExprs(partitionByExprs.size());
             }
 
             if (partitionExprs != null) {
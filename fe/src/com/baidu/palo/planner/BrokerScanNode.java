@@ -542,6 +542,8 @@ public class BrokerScanNode extends ScanNode {
             return TFileFormatType.FORMAT_CSV_LZ4FRAME;
         } else if (lowerCasePath.endsWith(".lzo")) {
             return TFileFormatType.FORMAT_CSV_LZOP;
+        } else if (lowerCasePath.endsWith(".zst")) {
+            return TFileFormatType.FORMAT_CSV_ZSTD;
         } else {
             return TFileFormatType.FORMAT_CSV_PLAIN;
         }
@@ -25,10 +25,16 @@ import com.baidu.palo.analysis.Expr;
 import com.baidu.palo.analysis.InsertStmt;
 import com.baidu.palo.analysis.JoinOperator;
 import com.baidu.palo.analysis.QueryStmt;
+import com.baidu.palo.analysis.SlotDescriptor;
+import com.baidu.palo.analysis.SlotRef;
+import com.baidu.palo.catalog.Column;
+import com.baidu.palo.catalog.HashDistributionInfo;
+import com.baidu.palo.catalog.PrimitiveType;
 import com.baidu.palo.catalog.Table;
 import com.baidu.palo.common.AnalysisException;
 import com.baidu.palo.common.InternalException;
 import com.baidu.palo.common.Pair;
+import com.baidu.palo.qe.ConnectContext;
 import com.baidu.palo.thrift.TPartitionType;
 
 import com.google.common.base.Preconditions;
@@ -39,6 +45,8 @@ import org.apache.logging.log4j.Logger;
 
 import java.util.ArrayList;
 import java.util.List;
+import java.util.Map;
+import java.util.Set;
 
 /**
  * The distributed planner is responsible for creating an executable, distributed plan
@@ -187,7 +195,7 @@ public class DistributedPlanner {
         } else if (root instanceof HashJoinNode) {
             Preconditions.checkState(childFragments.size() == 2);
             result = createHashJoinFragment((HashJoinNode) root, childFragments.get(1),
-                    childFragments.get(0), perNodeMemLimit);
+                    childFragments.get(0), perNodeMemLimit, fragments);
         } else if (root instanceof CrossJoinNode) {
             result = createCrossJoinFragment((CrossJoinNode) root, childFragments.get(1),
                     childFragments.get(0));
@@ -272,8 +280,29 @@ public class DistributedPlanner {
      * don't create a broadcast join if we already anticipate that this will exceed the query's memory budget.
      */
     private PlanFragment createHashJoinFragment(HashJoinNode node, PlanFragment rightChildFragment,
-                                                PlanFragment leftChildFragment, long perNodeMemLimit)
+                                                PlanFragment leftChildFragment, long perNodeMemLimit,
+                                                ArrayList<PlanFragment> fragments)
             throws InternalException {
+        if (canColocateJoin(node, leftChildFragment, rightChildFragment)) {
+            node.setDistributionMode(HashJoinNode.DistributionMode.COLOCATE);
+            // Both scans are executed in the leftChildFragment, and the coordinator
+            // assigns the tablets of the same bucket sequence of both to one instance,
+            // so the rows of a join key meet there without any exchange
+            node.setChild(0, leftChildFragment.getPlanRoot());
+            node.setChild(1, rightChildFragment.getPlanRoot());
+            leftChildFragment.setPlanRoot(node);
+            leftChildFragment.setColocate(true);
+            fragments.remove(rightChildFragment);
+
+            if (!node.getJoinOp().isOuterJoin() && !node.getJoinOp().isSemiAntiJoin()) {
+                node.setIsPushDown(true);
+            }
+            if (node.getJoinOp().isLeftSemiJoin()) {
+                node.setIsPushDown(true);
+            }
+            return leftChildFragment;
+        }
+
         // broadcast: send the rightChildFragment's output to each node executing
         // the leftChildFragment; the cost across all nodes is proportional to the
         // total amount of data sent
@@ -310,6 +339,8 @@ public class DistributedPlanner {
         LOG.info(rhsTree.getExplainString());
 
         boolean doBroadcast;
+        // a NULL_AWARE_LEFT_ANTI_JOIN is always broadcast, every probe row has to see
+        // whether the whole build input is empty or has a NULL key
         // we do a broadcast join if
         // - we're explicitly told to do so
         // - or if it's cheaper and we weren't explicitly told to do a partitioned join
@@ -318,7 +349,9 @@ public class DistributedPlanner {
         // - and the expected size of the hash tbl doesn't exceed perNodeMemLimit
         // we do a "<=" comparison of the costs so that we default to broadcast joins if
         // we're unable to estimate the cost
-        if (node.getJoinOp() != JoinOperator.RIGHT_OUTER_JOIN
+        if (node.getJoinOp() == JoinOperator.NULL_AWARE_LEFT_ANTI_JOIN) {
+            doBroadcast = true;
+        } else if (node.getJoinOp() != JoinOperator.RIGHT_OUTER_JOIN
                 && node.getJoinOp() != JoinOperator.FULL_OUTER_JOIN
                 && (perNodeMemLimit == 0 || Math.round(
                 (double) rhsDataSize * PlannerContext.HASH_TBL_SPACE_OVERHEAD) <= perNodeMemLimit)
@@ -393,6 +426,83 @@ public class DistributedPlanner {
         }
     }
 
+    /**
+     * Returns true if the join can be executed bucket by bucket where the tablets are:
+     * both inputs are scans of olap tables hash distributed into the same number of
+     * buckets, on columns of the same types which are equated by the eq-join
+     * conjuncts position by position, so the rows of a join key are in the tablets
+     * of the same bucket sequence on both sides. The tablets of every bucket sequence
+     * also need a replica on one backend.
+     */
+    private boolean canColocateJoin(HashJoinNode node, PlanFragment leftChildFragment,
+                                    PlanFragment rightChildFragment) {
+        ConnectContext connectContext = ctx_.getRootAnalyzer().getContext();
+        if (connectContext == null || !connectContext.getSessionVariable().isEnableColocateJoin()) {
+            return false;
+        }
+        if (node.getInnerRef().isBroadcastJoin() || node.getInnerRef().isPartitionJoin()) {
+            return false;
+        }
+        // whether the build side has a NULL isn't known bucket by bucket
+        if (node.getJoinOp() == JoinOperator.NULL_AWARE_LEFT_ANTI_JOIN) {
+            return false;
+        }
+        if (!(leftChildFragment.getPlanRoot() instanceof OlapScanNode)
+                || !(rightChildFragment.getPlanRoot() instanceof OlapScanNode)) {
+            return false;
+        }
+        OlapScanNode lhsScan = (OlapScanNode) leftChildFragment.getPlanRoot();
+        OlapScanNode rhsScan = (OlapScanNode) rightChildFragment.getPlanRoot();
+        HashDistributionInfo lhsInfo = lhsScan.getHashDistributionInfo();
+        HashDistributionInfo rhsInfo = rhsScan.getHashDistributionInfo();
+        if (lhsInfo == null || rhsInfo == null || lhsInfo.getBucketNum() != rhsInfo.getBucketNum()
+                || lhsInfo.getDistributionColumns().size() != rhsInfo.getDistributionColumns().size()) {
+            return false;
+        }
+
+        for (int i = 0; i < lhsInfo.getDistributionColumns().size(); ++i) {
+            Column lhsColumn = lhsInfo.getDistributionColumns().get(i);
+            Column rhsColumn = rhsInfo.getDistributionColumns().get(i);
+            // the bucket is the hash of the stored value, CHARs are padded to their length
+            if (lhsColumn.getDataType() != rhsColumn.getDataType()
+                    || (lhsColumn.getDataType() == PrimitiveType.CHAR
+                    && lhsColumn.getStrLen() != rhsColumn.getStrLen())) {
+                return false;
+            }
+            boolean isEquated = false;
+            for (Pair<Expr, Expr> pair : node.getEqJoinConjuncts()) {
+                if (isScanColumn(pair.first, lhsScan, lhsColumn) && isScanColumn(pair.second, rhsScan, rhsColumn)) {
+                    isEquated = true;
+                    break;
+                }
+            }
+            if (!isEquated) {
+                return false;
+            }
+        }
+
+        Map<Integer, Set<Long>> bucketSeqToBackends =
+                OlapScanNode.getColocatedBackends(Lists.newArrayList(lhsScan, rhsScan));
+        for (Map.Entry<Integer, Set<Long>> entry : bucketSeqToBackends.entrySet()) {
+            if (entry.getValue().isEmpty()) {
+                LOG.info("no backend has replicas of all tablets of bucket {}, not a colocate join",
+                        entry.getKey());
+                return false;
+            }
+        }
+        return true;
+    }
+
+    private boolean isScanColumn(Expr expr, OlapScanNode scanNode, Column column) {
+        if (!(expr instanceof SlotRef)) {
+            return false;
+        }
+        SlotDescriptor slotDesc = ((SlotRef) expr).getDesc();
+        return slotDesc.getColumn() != null
+                && scanNode.getTupleIds().contains(slotDesc.getParent().getId())
+                && slotDesc.getColumn().getName().equalsIgnoreCase(column.getName());
+    }
+
     /**
      * Modifies the leftChildFragment to execute a cross join. The right child input is provided by an ExchangeNode,
      * which is the destination of the rightChildFragment's output.
@@ -695,8 +805,7 @@ public class DistributedPlanner {
         // and goes into a parent fragment
         childFragment.addPlanRoot(node);
         node.setIntermediateTuple();
-        // TODO(zc)
-        // node.setIsPreagg(ctx_);
+        node.setIsPreagg();
 
         // if there is a limit, we need to transfer it from the pre-aggregation
         // node in the child fragment to the merge aggregation node in the parent
@@ -788,8 +897,7 @@ public class DistributedPlanner {
                     partitionExprs == null ? DataPartition.UNPARTITIONED : DataPartition.hashPartitioned(partitionExprs);
             // Convert the existing node to a preaggregation.
             AggregationNode preaggNode = (AggregationNode)node.getChild(0);
-            // TODO(zc)
-            // preaggNode.setIsPreagg(ctx_);
+            preaggNode.setIsPreagg();
 
             // place a merge aggregation step for the 1st phase in a new fragment
             mergeFragment = createParentFragment(childFragment, mergePartition);
@@ -866,6 +974,14 @@ public class DistributedPlanner {
 
         SortNode sortNode = (SortNode) node;
         Preconditions.checkState(sortNode.isAnalyticSort());
+        if (sortNode.getPartitionTopNLimit() > 0) {
+            // only the first rows of each partition can pass the rank filter above,
+            // drop the others before they are shuffled and sorted
+            PartitionTopNNode topNNode = new PartitionTopNNode(ctx_.getNextNodeId(),
+                    childFragment.getPlanRoot(), sortNode, ctx_.getRootAnalyzer());
+            topNNode.init(ctx_.getRootAnalyzer());
+            childFragment.addPlanRoot(topNNode);
+        }
         PlanFragment analyticFragment = childFragment;
         if (sortNode.getInputPartition() != null) {
             sortNode.getInputPartition().substitute(
@@ -258,6 +258,8 @@ public class HashJoinNode extends PlanNode {
             msg.hash_join_node.addToOther_join_conjuncts(e.treeToThrift());
         }
         msg.hash_join_node.setIs_push_down(isPushDown);
+        msg.hash_join_node.setIs_broadcast(distrMode == DistributionMode.BROADCAST);
+        msg.hash_join_node.setIs_colocate(distrMode == DistributionMode.COLOCATE);
     }
 
     @Override
@@ -291,7 +293,8 @@ public class HashJoinNode extends PlanNode {
     enum DistributionMode {
         NONE("NONE"),
         BROADCAST("BROADCAST"),
-        PARTITIONED("PARTITIONED");
+        PARTITIONED("PARTITIONED"),
+        COLOCATE("COLOCATE");
 
         private final String description;
 
@@ -22,6 +22,7 @@ package com.baidu.palo.planner;
 
 import com.baidu.palo.analysis.Analyzer;
 import com.baidu.palo.analysis.Expr;
+import com.baidu.palo.analysis.JoinOperator;
 import com.baidu.palo.analysis.SlotId;
 import com.baidu.palo.common.Pair;
 import com.baidu.palo.thrift.TEqJoinCondition;
@@ -40,6 +41,9 @@ import java.util.List;
  * Merge join between left child and right child.
  * The right child must be a leaf node, ie, can only materialize
  * a single input tuple.
+ * If joinOp is set, both children must return rows ordered by the cmpConjuncts, e.g.
+ * key ordered scans of tablets, and backend joins them without a hash table.
+ * Only INNER JOIN and LEFT OUTER JOIN are supported. Otherwise the rows are only merged.
  */
 public class MergeJoinNode extends PlanNode {
     private final static Logger LOG = LogManager.getLogger(MergeJoinNode.class);
@@ -48,12 +52,22 @@ public class MergeJoinNode extends PlanNode {
     // join conjuncts from the JOIN clause that aren't equi-join predicates
     private final List<Expr> otherJoinConjuncts;
     private DistributionMode distrMode;
+    // null if only merging the children
+    private final JoinOperator joinOp;
 
     public MergeJoinNode(PlanNodeId id, PlanNode outer, PlanNode inner,
+      List<Pair<Expr, Expr>> cmpConjuncts, List<Expr> otherJoinConjuncts) {
+        this(id, outer, inner, null, cmpConjuncts, otherJoinConjuncts);
+    }
+
+    public MergeJoinNode(PlanNodeId id, PlanNode outer, PlanNode inner, JoinOperator joinOp,
       List<Pair<Expr, Expr>> cmpConjuncts, List<Expr> otherJoinConjuncts) {
         super(id, "MERGE JOIN");
         Preconditions.checkArgument(cmpConjuncts != null);
         Preconditions.checkArgument(otherJoinConjuncts != null);
+        Preconditions.checkArgument(joinOp == null
+          || joinOp == JoinOperator.INNER_JOIN || joinOp == JoinOperator.LEFT_OUTER_JOIN);
+        this.joinOp = joinOp;
         tupleIds.addAll(outer.getTupleIds());
         tupleIds.addAll(inner.getTupleIds());
         this.distrMode = DistributionMode.PARTITIONED;
@@ -74,6 +88,10 @@ public class MergeJoinNode extends PlanNode {
         return cmpConjuncts;
     }
 
+    public JoinOperator getJoinOp() {
+        return joinOp;
+    }
+
     public DistributionMode getDistributionMode() {
         return distrMode;
     }
@@ -121,7 +139,10 @@ public class MergeJoinNode extends PlanNode {
             msg.merge_join_node.addToCmp_conjuncts(eqJoinCondition);
         }
         for (Expr e : otherJoinConjuncts) {
-            msg.hash_join_node.addToOther_join_conjuncts(e.treeToThrift());
+            msg.merge_join_node.addToOther_join_conjuncts(e.treeToThrift());
+        }
+        if (joinOp != null) {
+            msg.merge_join_node.setJoin_op(joinOp.toThrift());
         }
     }
 
@@ -130,7 +151,8 @@ public class MergeJoinNode extends PlanNode {
         String distrModeStr =
           (distrMode != DistributionMode.NONE) ? (" (" + distrMode.toString() + ")") : "";
         StringBuilder output = new StringBuilder().append(
-          detailPrefix + "join op: MERGE JOIN" + distrModeStr + "\n").append(
+          detailPrefix + "join op: MERGE JOIN" + (joinOp != null ? " " + joinOp.toString() : "")
+            + distrModeStr + "\n").append(
           detailPrefix + "hash predicates:\n");
         for (Pair<Expr, Expr> entry : cmpConjuncts) {
             output.append(detailPrefix + "  " +
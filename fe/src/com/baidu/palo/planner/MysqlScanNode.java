@@ -46,6 +46,8 @@ public class MysqlScanNode extends ScanNode {
     private final List<String> columns = new ArrayList<String>();
     private final List<String> filters = new ArrayList<String>();
     private       String     tabName;
+    // integer key column the backend may split the scan on, null if there is none
+    private       String     splitColumn;
 
     /**
      * Constructs node to scan given data files of table 'tbl'.
@@ -54,6 +56,12 @@ public class MysqlScanNode extends ScanNode {
         super(id, desc, "SCAN MYSQL");
         // tabName = ((BaseTableRef)desc.getRef()).mysqlTableRefToSql();
         tabName = "`" + tbl.getMysqlTableName() + "`";
+        for (Column col : tbl.getBaseSchema()) {
+            if (col.isKey() && col.getDataType().isIntegerType()) {
+                splitColumn = "`" + col.getName() + "`";
+                break;
+            }
+        }
     }
 
     @Override
@@ -108,6 +116,9 @@ public class MysqlScanNode extends ScanNode {
     protected void toThrift(TPlanNode msg) {
         msg.node_type = TPlanNodeType.MYSQL_SCAN_NODE;
         msg.mysql_scan_node = new TMySQLScanNode(desc.getId().asInt(), tabName, columns, filters);
+        if (splitColumn != null) {
+            msg.mysql_scan_node.setSplit_column(splitColumn);
+        }
     }
 
     /**
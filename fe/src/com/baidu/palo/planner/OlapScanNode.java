@@ -20,6 +20,7 @@ import com.baidu.palo.analysis.BaseTableRef;
 import com.baidu.palo.analysis.Expr;
 import com.baidu.palo.analysis.InPredicate;
 import com.baidu.palo.analysis.SlotDescriptor;
+import com.baidu.palo.analysis.SlotId;
 import com.baidu.palo.analysis.TupleDescriptor;
 import com.baidu.palo.catalog.Catalog;
 import com.baidu.palo.catalog.Column;
@@ -39,13 +40,16 @@ import com.baidu.palo.common.ErrorCode;
 import com.baidu.palo.common.ErrorReport;
 import com.baidu.palo.common.InternalException;
 import com.baidu.palo.system.Backend;
+import com.baidu.palo.thrift.TAggregationOp;
 import com.baidu.palo.thrift.TExplainLevel;
 import com.baidu.palo.thrift.TNetworkAddress;
+import com.baidu.palo.thrift.TOlapScanAggSlot;
 import com.baidu.palo.thrift.TOlapScanNode;
 import com.baidu.palo.thrift.TPaloScanRange;
 import com.baidu.palo.thrift.TPlanNode;
 import com.baidu.palo.thrift.TPlanNodeType;
 import com.baidu.palo.thrift.TPrimitiveType;
+import com.baidu.palo.thrift.TPushAggOp;
 import com.baidu.palo.thrift.TScanRange;
 import com.baidu.palo.thrift.TScanRangeLocation;
 import com.baidu.palo.thrift.TScanRangeLocations;
@@ -79,6 +83,11 @@ public class OlapScanNode extends ScanNode {
     private List<TScanRangeLocations> result = new ArrayList<TScanRangeLocations>();
     private boolean isPreAggregation = false;
     private boolean canTurnOnPreAggr = true;
+    // aggregation which BE can answer from the meta of tablets
+    private TPushAggOp pushAggOp = TPushAggOp.NONE;
+    // partial aggregation of consecutive rows done by BE scanners, empty if not pushed down
+    private List<SlotId> streamingAggGroupSlots = Lists.newArrayList();
+    private Map<SlotId, TAggregationOp> streamingAggSlots = Maps.newLinkedHashMap();
     private ArrayList<String> tupleColumns = new ArrayList<String>();
     private HashSet<String> predicateColumns = new HashSet<String>();
     private HashSet<String> inPredicateColumns = new HashSet<String>();
@@ -88,6 +97,11 @@ public class OlapScanNode extends ScanNode {
     private long totalTabletsNum = 0;
     private long selectedIndexId = -1;
     private int selectedPartitionNum = 0;
+    // bucket sequence of the tablet of each scan range in 'result'
+    private List<Integer> bucketSeqs = Lists.newArrayList();
+    // the hash distribution of all the selected partitions, null if they are not hash
+    // distributed or not in the same way
+    private HashDistributionInfo hashDistributionInfo = null;
 
     boolean isFinalized = false;
 
@@ -108,6 +122,19 @@ public class OlapScanNode extends ScanNode {
         return isPreAggregation;
     }
 
+    public void setPushAggOp(TPushAggOp pushAggOp) {
+        this.pushAggOp = pushAggOp;
+    }
+
+    public TPushAggOp getPushAggOp() {
+        return pushAggOp;
+    }
+
+    public void setStreamingAgg(List<SlotId> groupSlots, Map<SlotId, TAggregationOp> aggSlots) {
+        this.streamingAggGroupSlots = groupSlots;
+        this.streamingAggSlots = aggSlots;
+    }
+
     public boolean getCanTurnOnPreAggr() {
         return canTurnOnPreAggr;
     }
@@ -393,6 +420,12 @@ public class OlapScanNode extends ScanNode {
         long committedVersionHash = partition.getCommittedVersionHash();
         String committedVersionStr = String.valueOf(committedVersion);
         String committedVersionHashStr = String.valueOf(partition.getCommittedVersionHash());
+        // tablets of an index are in the order of their bucket sequence
+        Map<Long, Integer> tabletIdToBucketSeq = Maps.newHashMap();
+        List<Long> tabletIdsInOrder = index.getTabletIdsInOrder();
+        for (int i = 0; i < tabletIdsInOrder.size(); ++i) {
+            tabletIdToBucketSeq.put(tabletIdsInOrder.get(i), i);
+        }
         for (Tablet tablet : tablets) {
             long tabletId = tablet.getId();
             LOG.debug("{} tabletId={}", (logNum++), tabletId);
@@ -437,6 +470,7 @@ public class OlapScanNode extends ScanNode {
             scanRange.setPalo_scan_range(paloRange);
             scanRangeLocations.setScan_range(scanRange);
             result.add(scanRangeLocations);
+            bucketSeqs.add(tabletIdToBucketSeq.get(tabletId));
         }
     }
 
@@ -511,9 +545,19 @@ public class OlapScanNode extends ScanNode {
 
         MaterializedIndex selectedTable = null;
         int j = 0;
+        boolean isFirstPartition = true;
         for (Long partitionId : partitionIds) {
             Partition partition = olapTable.getPartition(partitionId);
             LOG.debug("selected partition: " + partition.getName());
+            DistributionInfo distributionInfo = partition.getDistributionInfo();
+            if (isFirstPartition) {
+                if (distributionInfo.getType() == DistributionInfo.DistributionInfoType.HASH) {
+                    hashDistributionInfo = (HashDistributionInfo) distributionInfo;
+                }
+                isFirstPartition = false;
+            } else if (hashDistributionInfo != null && !hashDistributionInfo.equals(distributionInfo)) {
+                hashDistributionInfo = null;
+            }
             selectedTable = tables.get(j++).get(partitionPos);
             List<Tablet> tablets = new ArrayList<Tablet>();
             Collection<Long> tabletIds = distributionPrune(selectedTable, partition.getDistributionInfo());
@@ -542,6 +586,38 @@ public class OlapScanNode extends ScanNode {
         return result;
     }
 
+    public List<Integer> getBucketSeqs() {
+        return bucketSeqs;
+    }
+
+    public HashDistributionInfo getHashDistributionInfo() {
+        return hashDistributionInfo;
+    }
+
+    /**
+     * Returns the ids of the backends holding a replica of every tablet of a bucket
+     * sequence in all the given scans, by bucket sequence.
+     */
+    public static Map<Integer, Set<Long>> getColocatedBackends(List<OlapScanNode> scanNodes) {
+        Map<Integer, Set<Long>> bucketSeqToBackends = Maps.newHashMap();
+        for (OlapScanNode scanNode : scanNodes) {
+            for (int i = 0; i < scanNode.result.size(); ++i) {
+                Set<Long> backendIds = Sets.newHashSet();
+                for (TScanRangeLocation location : scanNode.result.get(i).getLocations()) {
+                    backendIds.add(location.getBackend_id());
+                }
+                Integer bucketSeq = scanNode.bucketSeqs.get(i);
+                Set<Long> colocatedBackendIds = bucketSeqToBackends.get(bucketSeq);
+                if (colocatedBackendIds == null) {
+                    bucketSeqToBackends.put(bucketSeq, backendIds);
+                } else {
+                    colocatedBackendIds.retainAll(backendIds);
+                }
+            }
+        }
+        return bucketSeqToBackends;
+    }
+
 
     @Override
     protected String getNodeExplainString(String prefix, TExplainLevel detailLevel) {
@@ -557,6 +633,13 @@ public class OlapScanNode extends ScanNode {
         } else {
             output.append(prefix).append("PREAGGREGATION: OFF").append("\n");
         }
+        if (pushAggOp != TPushAggOp.NONE) {
+            output.append(prefix).append("PUSHDOWN AGGREGATION: ").append(pushAggOp).append("\n");
+        }
+        if (!streamingAggSlots.isEmpty()) {
+            output.append(prefix).append("STREAMING AGGREGATION: group by ")
+                    .append(streamingAggGroupSlots).append(", ").append(streamingAggSlots).append("\n");
+        }
         if (!conjuncts.isEmpty()) {
             output.append(prefix).append("PREDICATES: ").append(
                     getExplainString(conjuncts)).append("\n");
@@ -604,6 +687,18 @@ public class OlapScanNode extends ScanNode {
         if (null != sortColumn) {
             msg.olap_scan_node.setSort_column(sortColumn);
         }
+        if (pushAggOp != TPushAggOp.NONE) {
+            msg.olap_scan_node.setPush_agg_op(pushAggOp);
+        }
+        if (!streamingAggSlots.isEmpty()) {
+            for (SlotId slotId : streamingAggGroupSlots) {
+                msg.olap_scan_node.addToStreaming_agg_group_slots(slotId.asInt());
+            }
+            for (Map.Entry<SlotId, TAggregationOp> entry : streamingAggSlots.entrySet()) {
+                msg.olap_scan_node.addToStreaming_agg_slots(
+                        new TOlapScanAggSlot(entry.getKey().asInt(), entry.getValue()));
+            }
+        }
     }
 
     // export some tablets
@@ -0,0 +1,137 @@
+// Copyright (c) 2017, Baidu.com, Inc. All Rights Reserved
+
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+package com.baidu.palo.planner;
+
+import com.baidu.palo.analysis.Analyzer;
+import com.baidu.palo.analysis.Expr;
+import com.baidu.palo.common.InternalException;
+import com.baidu.palo.thrift.TExplainLevel;
+import com.baidu.palo.thrift.TPartitionTopNNode;
+import com.baidu.palo.thrift.TPlanNode;
+import com.baidu.palo.thrift.TPlanNodeType;
+
+import com.google.common.base.Objects;
+import com.google.common.base.Preconditions;
+import com.google.common.collect.Lists;
+
+import org.apache.logging.log4j.LogManager;
+import org.apache.logging.log4j.Logger;
+
+import java.util.List;
+
+/**
+ * Keeps the first rows of each partition of its input for the analytic sort of a
+ * ROW_NUMBER() or RANK() that is filtered on the rank, see
+ * SortNode.getPartitionTopNLimit(). It is placed in the fragment feeding the sort, below
+ * the exchange, so that only rows which can pass the filter are shuffled and sorted.
+ * Each instance keeps the top-n of the rows it sees, which include the rows of the
+ * global top-n. The rows are passed on unchanged and in no particular order.
+ */
+public class PartitionTopNNode extends PlanNode {
+    private final static Logger LOG = LogManager.getLogger(PartitionTopNNode.class);
+
+    private final List<Expr> partitionExprs;
+    private final List<Expr> orderingExprs;
+    private final List<Boolean> isAscOrder;
+    private final List<Boolean> nullsFirst;
+    private final long partitionLimit;
+    private final boolean keepTies;
+
+    public PartitionTopNNode(PlanNodeId id, PlanNode input, SortNode sortNode,
+                             Analyzer analyzer) {
+        super(id, input.getTupleIds(), "PARTITION TOP-N");
+        Preconditions.checkState(sortNode.getPartitionTopNLimit() > 0);
+        addChild(input);
+        this.tblRefIds = input.tblRefIds;
+        this.nullableTupleIds = input.nullableTupleIds;
+
+        // the sort is on the partition exprs first and on the order by exprs then
+        List<Expr> sortExprs = Expr.substituteList(
+                sortNode.getInputOrderingExprs(analyzer), input.getOutputSmap(), analyzer, false);
+        int numPartitionExprs = sortNode.getNumAnalyticPartitionExprs();
+        List<Boolean> sortIsAscOrder = sortNode.getSortInfo().getIsAscOrder();
+        List<Boolean> sortNullsFirst = sortNode.getSortInfo().getNullsFirst();
+        this.partitionExprs = Lists.newArrayList(sortExprs.subList(0, numPartitionExprs));
+        this.orderingExprs = Lists.newArrayList(
+                sortExprs.subList(numPartitionExprs, sortExprs.size()));
+        this.isAscOrder = Lists.newArrayList(
+                sortIsAscOrder.subList(numPartitionExprs, sortIsAscOrder.size()));
+        this.nullsFirst = Lists.newArrayList(
+                sortNullsFirst.subList(numPartitionExprs, sortNullsFirst.size()));
+        this.partitionLimit = sortNode.getPartitionTopNLimit();
+        this.keepTies = sortNode.isPartitionTopNKeepTies();
+    }
+
+    @Override
+    public void init(Analyzer analyzer) throws InternalException {
+        computeStats(analyzer);
+        createDefaultSmap(analyzer);
+    }
+
+    @Override
+    protected void computeStats(Analyzer analyzer) {
+        super.computeStats(analyzer);
+        cardinality = getChild(0).cardinality;
+        LOG.debug("stats PartitionTopN: cardinality=" + Long.toString(cardinality));
+    }
+
+    @Override
+    protected String debugString() {
+        return Objects.toStringHelper(this)
+                .add("partitionExprs", Expr.debugString(partitionExprs))
+                .add("orderingExprs", Expr.debugString(orderingExprs))
+                .add("partitionLimit", partitionLimit)
+                .add("keepTies", keepTies)
+                .addValue(super.debugString())
+                .toString();
+    }
+
+    @Override
+    protected void toThrift(TPlanNode msg) {
+        msg.node_type = TPlanNodeType.PARTITION_TOPN_NODE;
+        msg.partition_topn_node = new TPartitionTopNNode(
+                Expr.treesToThrift(partitionExprs), Expr.treesToThrift(orderingExprs),
+                isAscOrder, nullsFirst, partitionLimit);
+        msg.partition_topn_node.setKeep_ties(keepTies);
+    }
+
+    @Override
+    protected String getNodeExplainString(String prefix, TExplainLevel detailLevel) {
+        StringBuilder output = new StringBuilder();
+        if (!partitionExprs.isEmpty()) {
+            output.append(prefix + "partition by: " + getExplainString(partitionExprs) + "\n");
+        }
+        if (!orderingExprs.isEmpty()) {
+            output.append(prefix + "order by: ");
+            for (int i = 0; i < orderingExprs.size(); ++i) {
+                if (i > 0) {
+                    output.append(", ");
+                }
+                output.append(orderingExprs.get(i).toSql() + " ");
+                output.append(isAscOrder.get(i) ? "ASC" : "DESC");
+            }
+            output.append("\n");
+        }
+        output.append(prefix + "partition limit: " + partitionLimit
+                + (keepTies ? " with ties" : "") + "\n");
+        return output.toString();
+    }
+
+    @Override
+    public int getNumInstances() {
+        return children.get(0).getNumInstances();
+    }
+}
@@ -101,6 +101,10 @@ public class PlanFragment extends TreeNode<PlanFragment> {
     // if the output is UNPARTITIONED, it is being broadcast
     private DataPartition outputPartition;
 
+    // true if the fragment executes a colocate join: the tablets of the same bucket
+    // sequence of all its olap scans are assigned to the same instance
+    private boolean isColocate = false;
+
     // TODO: SubstitutionMap outputSmap;
     // substitution map to remap exprs onto the output of this fragment, to be applied
     // at destination fragment
@@ -270,4 +274,12 @@ public class PlanFragment extends TreeNode<PlanFragment> {
         return fragmentId;
     }
 
+    public boolean isColocate() {
+        return isColocate;
+    }
+
+    public void setColocate(boolean isColocate) {
+        this.isColocate = isColocate;
+    }
+
 }
@@ -33,6 +33,7 @@ import com.baidu.palo.analysis.ExprSubstitutionMap;
 import com.baidu.palo.analysis.FunctionCallExpr;
 import com.baidu.palo.analysis.InPredicate;
 import com.baidu.palo.analysis.InlineViewRef;
+import com.baidu.palo.analysis.IntLiteral;
 import com.baidu.palo.analysis.IsNullPredicate;
 import com.baidu.palo.analysis.LiteralExpr;
 import com.baidu.palo.analysis.NullLiteral;
@@ -49,11 +50,14 @@ import com.baidu.palo.analysis.UnionStmt;
 import com.baidu.palo.catalog.AggregateType;
 import com.baidu.palo.catalog.Column;
 import com.baidu.palo.catalog.MysqlTable;
+import com.baidu.palo.catalog.PrimitiveType;
 import com.baidu.palo.catalog.Table;
 import com.baidu.palo.common.AnalysisException;
 import com.baidu.palo.common.InternalException;
 import com.baidu.palo.common.Pair;
 import com.baidu.palo.common.Reference;
+import com.baidu.palo.thrift.TAggregationOp;
+import com.baidu.palo.thrift.TPushAggOp;
 
 import com.google.common.base.Preconditions;
 import com.google.common.base.Predicate;
@@ -593,6 +597,130 @@ public class SingleNodePlanner {
         } while (false);
     }
 
+    /**
+     * Let BE answer COUNT(*) or MIN/MAX over key columns from the meta of tablets, when there
+     * is no group by and no predicate. BE checks whether the meta of each tablet is enough
+     * (keys type, versions and delete conditions), and falls back to scan rows if not.
+     */
+    private void pushDownAggToScan(AggregateInfo aggInfo, SelectStmt selectStmt, Analyzer analyzer,
+                                   PlanNode root) {
+        if (aggInfo == null || !(root instanceof OlapScanNode)
+                || selectStmt.getTableRefs().size() != 1
+                || !aggInfo.getGroupingExprs().isEmpty()
+                || aggInfo.getAggregateExprs().isEmpty()
+                || !root.getConjuncts().isEmpty()) {
+            return;
+        }
+        TableRef tableRef = selectStmt.getTableRefs().get(0);
+        List<Expr> allConjuncts = analyzer.getAllConjunt(tableRef.getId());
+        if (allConjuncts != null && !allConjuncts.isEmpty()) {
+            return;
+        }
+
+        TPushAggOp pushAggOp = TPushAggOp.NONE;
+        List<SlotId> aggSlotIds = Lists.newArrayList();
+        for (FunctionCallExpr aggExpr : aggInfo.getAggregateExprs()) {
+            String fnName = aggExpr.getFnName().getFunction();
+            TPushAggOp op = TPushAggOp.NONE;
+            if (fnName.equalsIgnoreCase("count") && aggExpr.getParams().isStar()) {
+                op = TPushAggOp.COUNT;
+            } else if ((fnName.equalsIgnoreCase("min") || fnName.equalsIgnoreCase("max"))
+                    && aggExpr.getChildren().size() == 1
+                    && aggExpr.getChild(0) instanceof SlotRef) {
+                SlotRef slotRef = (SlotRef) aggExpr.getChild(0);
+                if (slotRef.getDesc().getColumn() == null || !slotRef.getDesc().getColumn().isKey()) {
+                    return;
+                }
+                aggSlotIds.add(slotRef.getSlotId());
+                op = TPushAggOp.MINMAX;
+            }
+            if (op == TPushAggOp.NONE || (pushAggOp != TPushAggOp.NONE && pushAggOp != op)) {
+                return;
+            }
+            pushAggOp = op;
+        }
+
+        if (pushAggOp == TPushAggOp.MINMAX) {
+            // every row returned by BE is made of the min or max values of all slots
+            for (SlotDescriptor slot : tableRef.getDesc().getSlots()) {
+                if (slot.isMaterialized() && !aggSlotIds.contains(slot.getId())) {
+                    return;
+                }
+            }
+        }
+
+        LOG.debug("push down aggregation {} to olap scan node", pushAggOp);
+        ((OlapScanNode) root).setPushAggOp(pushAggOp);
+    }
+
+    /**
+     * Let BE scanners aggregate consecutive rows of the same group before sending them to the
+     * aggregation node, for GROUP BY over key columns with SUM/MIN/MAX of columns. Rows come in
+     * key order, so grouping by leading keys merges most of them. The partial results are kept
+     * in the slots of the scan tuple, so a SUM is only pushed down if the slot has the type of
+     * the sum.
+     */
+    private void pushDownStreamingAggToScan(AggregateInfo aggInfo, SelectStmt selectStmt, PlanNode root) {
+        if (aggInfo == null || !(root instanceof OlapScanNode)
+                || selectStmt.getTableRefs().size() != 1
+                || aggInfo.isDistinctAgg()
+                || aggInfo.getGroupingExprs().isEmpty()
+                || aggInfo.getAggregateExprs().isEmpty()
+                || root.getLimit() != -1
+                || ((OlapScanNode) root).getPushAggOp() != TPushAggOp.NONE) {
+            return;
+        }
+
+        List<SlotId> groupSlots = Lists.newArrayList();
+        for (Expr groupExpr : aggInfo.getGroupingExprs()) {
+            if (!(groupExpr instanceof SlotRef)) {
+                return;
+            }
+            SlotRef slotRef = (SlotRef) groupExpr;
+            if (slotRef.getDesc().getColumn() == null || !slotRef.getDesc().getColumn().isKey()) {
+                return;
+            }
+            groupSlots.add(slotRef.getSlotId());
+        }
+
+        Map<SlotId, TAggregationOp> aggSlots = Maps.newLinkedHashMap();
+        for (FunctionCallExpr aggExpr : aggInfo.getAggregateExprs()) {
+            if (aggExpr.isDistinct() || aggExpr.getChildren().size() != 1
+                    || !(aggExpr.getChild(0) instanceof SlotRef)) {
+                return;
+            }
+            SlotRef slotRef = (SlotRef) aggExpr.getChild(0);
+            PrimitiveType type = slotRef.getDesc().getType().getPrimitiveType();
+            String fnName = aggExpr.getFnName().getFunction();
+            TAggregationOp op;
+            if (fnName.equalsIgnoreCase("sum")) {
+                if (type != PrimitiveType.BIGINT && type != PrimitiveType.LARGEINT
+                        && type != PrimitiveType.DOUBLE && type != PrimitiveType.DECIMAL) {
+                    return;
+                }
+                op = TAggregationOp.SUM;
+            } else if (fnName.equalsIgnoreCase("min") || fnName.equalsIgnoreCase("max")) {
+                if (!type.isNumericType() && !type.isDateType()) {
+                    return;
+                }
+                op = fnName.equalsIgnoreCase("min") ? TAggregationOp.MIN : TAggregationOp.MAX;
+            } else {
+                return;
+            }
+
+            SlotId slotId = slotRef.getSlotId();
+            if (groupSlots.contains(slotId)
+                    || (aggSlots.containsKey(slotId) && aggSlots.get(slotId) != op)) {
+                return;
+            }
+            aggSlots.put(slotId, op);
+        }
+
+        LOG.debug("push down streaming aggregation to olap scan node, group by {}, aggregate {}",
+                groupSlots, aggSlots);
+        ((OlapScanNode) root).setStreamingAgg(groupSlots, aggSlots);
+    }
+
     /**
      * Create tree of PlanNodes that implements the Select/Project/Join/Group by/Having
      * of the selectStmt query block.
@@ -653,6 +781,8 @@ public class SingleNodePlanner {
         AggregateInfo aggInfo = selectStmt.getAggInfo();
 
         turnOffPreAgg(aggInfo, selectStmt, analyzer, root);
+        pushDownAggToScan(aggInfo, selectStmt, analyzer, root);
+        pushDownStreamingAggToScan(aggInfo, selectStmt, root);
 
         if (root instanceof OlapScanNode) {
             OlapScanNode olapNode = (OlapScanNode) root;
@@ -1015,10 +1145,95 @@ public class SingleNodePlanner {
         if (!canMigrateConjuncts(inlineViewRef)) {
             rootNode = addUnassignedConjuncts(
                     analyzer, inlineViewRef.getDesc().getId().asList(), rootNode);
+            if (rootNode instanceof SelectNode
+                    && analyzer.getContext().getSessionVariable().isEnablePartitionTopN()) {
+                setPartitionTopN((SelectNode) rootNode);
+            }
         }
         return rootNode;
     }
 
+    /**
+     * If the conjuncts of 'selectNode' limit the ROW_NUMBER() or RANK() computed by the
+     * AnalyticEvalNodes right below it, e.g. "rn <= 10", sets on their analytic sort how
+     * many rows of each partition can pass, so that the others are dropped before the
+     * sort (see PartitionTopNNode).
+     * This requires the analytic functions of the sort group to be ROW_NUMBER() and RANK()
+     * only: the rows that pass include all rows ordered before them, so their values
+     * don't change.
+     */
+    private void setPartitionTopN(SelectNode selectNode) {
+        List<AnalyticEvalNode> analyticNodes = Lists.newArrayList();
+        PlanNode node = selectNode.getChild(0);
+        while (node instanceof AnalyticEvalNode && !node.hasLimit()) {
+            analyticNodes.add((AnalyticEvalNode) node);
+            node = node.getChild(0);
+        }
+        if (analyticNodes.isEmpty() || !(node instanceof SortNode)
+                || !((SortNode) node).isAnalyticSort()) {
+            return;
+        }
+        for (AnalyticEvalNode analyticNode : analyticNodes) {
+            for (Expr fnCall : analyticNode.getAnalyticFnCalls()) {
+                String fnName = ((FunctionCallExpr) fnCall).getFnName().getFunction();
+                if (!fnName.equalsIgnoreCase("row_number") && !fnName.equalsIgnoreCase("rank")) {
+                    return;
+                }
+            }
+        }
+
+        long limit = -1;
+        boolean keepTies = false;
+        for (Expr conjunct : selectNode.getConjuncts()) {
+            if (!(conjunct instanceof BinaryPredicate)) {
+                continue;
+            }
+            BinaryPredicate.Operator op = ((BinaryPredicate) conjunct).getOp();
+            Expr slotExpr = conjunct.getChild(0);
+            Expr boundExpr = conjunct.getChild(1);
+            if (boundExpr instanceof SlotRef) {
+                slotExpr = conjunct.getChild(1);
+                boundExpr = conjunct.getChild(0);
+                op = op.converse();
+            }
+            if (!(slotExpr instanceof SlotRef) || !(boundExpr instanceof IntLiteral)) {
+                continue;
+            }
+            long bound = ((IntLiteral) boundExpr).getLongValue();
+            long rankLimit;
+            switch (op) {
+                case EQ:
+                case LE:
+                    rankLimit = bound;
+                    break;
+                case LT:
+                    rankLimit = bound - 1;
+                    break;
+                default:
+                    continue;
+            }
+            SlotId slotId = ((SlotRef) slotExpr).getSlotId();
+            for (AnalyticEvalNode analyticNode : analyticNodes) {
+                List<SlotDescriptor> outputSlots = analyticNode.getOutputTupleDesc().getSlots();
+                for (int i = 0; i < outputSlots.size(); ++i) {
+                    if (!outputSlots.get(i).getId().equals(slotId)) {
+                        continue;
+                    }
+                    if (limit == -1 || rankLimit < limit) {
+                        limit = rankLimit;
+                        FunctionCallExpr fnCall =
+                                (FunctionCallExpr) analyticNode.getAnalyticFnCalls().get(i);
+                        keepTies = fnCall.getFnName().getFunction().equalsIgnoreCase("rank");
+                    }
+                }
+            }
+        }
+        // nothing passes a limit below 1, which the SelectNode finds out anyway
+        if (limit > 0) {
+            ((SortNode) node).setPartitionTopN(limit, keepTies);
+        }
+    }
+
     /**
      * Migrates unassigned conjuncts into an inline view. Conjuncts are not
      * migrated into the inline view if the view has a LIMIT/OFFSET clause or if the
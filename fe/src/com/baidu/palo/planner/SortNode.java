@@ -57,6 +57,13 @@ public class SortNode extends PlanNode {
     private long offset;
     // if true, the output of this node feeds an AnalyticNode
     private boolean isAnalyticSort;
+    // for an analytic sort, the number of leading ordering exprs that are partition exprs
+    private int numAnalyticPartitionExprs;
+    // for an analytic sort of ROW_NUMBER()/RANK() filtered on the rank, the number of
+    // rows of each partition that can pass the filter, -1 if unknown
+    private long partitionTopNLimit = -1;
+    // true for RANK(), which gives the rows equal to the last one the same rank
+    private boolean partitionTopNKeepTies;
 
     // info_.sortTupleSlotExprs_ substituted with the outputSmap_ for materialized slots in init().
     List<Expr> resolvedTupleExprs;
@@ -67,6 +74,22 @@ public class SortNode extends PlanNode {
     public boolean isAnalyticSort() {
         return isAnalyticSort;
     }
+    public void setNumAnalyticPartitionExprs(int numAnalyticPartitionExprs) {
+        this.numAnalyticPartitionExprs = numAnalyticPartitionExprs;
+    }
+    public int getNumAnalyticPartitionExprs() {
+        return numAnalyticPartitionExprs;
+    }
+    public void setPartitionTopN(long limit, boolean keepTies) {
+        partitionTopNLimit = limit;
+        partitionTopNKeepTies = keepTies;
+    }
+    public long getPartitionTopNLimit() {
+        return partitionTopNLimit;
+    }
+    public boolean isPartitionTopNKeepTies() {
+        return partitionTopNKeepTies;
+    }
     private DataPartition inputPartition;
     public void setInputPartition(DataPartition inputPartition) {
         this.inputPartition = inputPartition;
@@ -112,6 +135,22 @@ public class SortNode extends PlanNode {
         return info;
     }
 
+    /**
+     * Returns the ordering exprs over the input of this node rather than over the sort
+     * tuple. Only valid after init().
+     */
+    public List<Expr> getInputOrderingExprs(Analyzer analyzer) {
+        ExprSubstitutionMap smap = new ExprSubstitutionMap();
+        int exprIdx = 0;
+        for (SlotDescriptor slotDesc : info.getSortTupleDescriptor().getSlots()) {
+            if (!slotDesc.isMaterialized()) {
+                continue;
+            }
+            smap.put(new SlotRef(slotDesc), resolvedTupleExprs.get(exprIdx++));
+        }
+        return Expr.substituteList(info.getOrderingExprs(), smap, analyzer, false);
+    }
+
     @Override
     public void getMaterializedIds(Analyzer analyzer, List<SlotId> ids) {
         super.getMaterializedIds(analyzer, ids);
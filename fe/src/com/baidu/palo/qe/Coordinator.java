@@ -28,6 +28,7 @@ import com.baidu.palo.common.util.RuntimeProfile;
 import com.baidu.palo.planner.DataPartition;
 import com.baidu.palo.planner.DataSink;
 import com.baidu.palo.planner.ExchangeNode;
+import com.baidu.palo.planner.OlapScanNode;
 import com.baidu.palo.planner.PlanFragment;
 import com.baidu.palo.planner.PlanFragmentId;
 import com.baidu.palo.planner.PlanNode;
@@ -82,6 +83,7 @@ import java.util.HashMap;
 import java.util.Iterator;
 import java.util.List;
 import java.util.Map;
+import java.util.Set;
 import java.util.concurrent.ConcurrentMap;
 import java.util.concurrent.CountDownLatch;
 import java.util.concurrent.ExecutorService;
@@ -851,7 +853,13 @@ public class Coordinator {
     // <fragment, <server, nodeId>>
     private void computeScanRangeAssignment() throws Exception {
         // set scan ranges/locations for scan nodes
+        HashMap<PlanFragmentId, List<OlapScanNode>> colocateScanNodes = Maps.newHashMap();
         for (ScanNode scanNode : scanNodes) {
+            if (scanNode.getFragment().isColocate()) {
+                findOrInsert(colocateScanNodes, scanNode.getFragmentId(), new ArrayList<OlapScanNode>())
+                        .add((OlapScanNode) scanNode);
+                continue;
+            }
             // the parameters of getScanRangeLocations may ignore, It dosn't take effect
             List<TScanRangeLocations> locations = scanNode.getScanRangeLocations(0);
             if (locations == null) {
@@ -863,6 +871,66 @@ public class Coordinator {
                     scanRangeAssignment.get(scanNode.getFragmentId());
             computeScanRangeAssignment(scanNode.getId(), locations, assignment);
         }
+        for (Map.Entry<PlanFragmentId, List<OlapScanNode>> entry : colocateScanNodes.entrySet()) {
+            computeColocateScanRangeAssignment(entry.getValue(), scanRangeAssignment.get(entry.getKey()));
+        }
+    }
+
+    // Assigns the scan ranges of the olap scans of a colocate join fragment bucket by
+    // bucket: all the tablets of a bucket sequence go to one backend holding a replica
+    // of each of them, the one with the fewest buckets assigned.
+    private void computeColocateScanRangeAssignment(
+            final List<OlapScanNode> scanNodes,
+            FragmentScanRangeAssignment assignment) throws Exception {
+        Map<Integer, Set<Long>> bucketSeqToBackends = OlapScanNode.getColocatedBackends(scanNodes);
+        HashMap<Long, Integer> assignedBucketsPerBackend = Maps.newHashMap();
+        Map<Integer, Long> bucketSeqToBackendId = Maps.newHashMap();
+        for (Map.Entry<Integer, Set<Long>> entry : bucketSeqToBackends.entrySet()) {
+            Integer minAssignedBuckets = Integer.MAX_VALUE;
+            Long minBackendId = null;
+            for (Long backendId : entry.getValue()) {
+                if (!SimpleScheduler.isAvailable(backendId, this.idToBackend)) {
+                    continue;
+                }
+                Integer assignedBuckets = findOrInsert(assignedBucketsPerBackend, backendId, 0);
+                if (assignedBuckets < minAssignedBuckets) {
+                    minAssignedBuckets = assignedBuckets;
+                    minBackendId = backendId;
+                }
+            }
+            if (minBackendId == null) {
+                throw new InternalException("there is no alive backend with all tablets of bucket "
+                        + entry.getKey() + " of colocate join");
+            }
+            assignedBucketsPerBackend.put(minBackendId, minAssignedBuckets + 1);
+            bucketSeqToBackendId.put(entry.getKey(), minBackendId);
+        }
+
+        for (OlapScanNode scanNode : scanNodes) {
+            List<TScanRangeLocations> locations = scanNode.getScanRangeLocations(0);
+            List<Integer> bucketSeqs = scanNode.getBucketSeqs();
+            for (int i = 0; i < locations.size(); ++i) {
+                TScanRangeLocations scanRangeLocations = locations.get(i);
+                long backendId = bucketSeqToBackendId.get(bucketSeqs.get(i));
+                Backend backend = this.idToBackend.get(backendId);
+                TNetworkAddress execHostPort = new TNetworkAddress(backend.getHost(), backend.getBePort());
+                this.addressToBackendID.put(execHostPort, backendId);
+
+                Map<Integer, List<TScanRangeParams>> scanRanges = findOrInsert(assignment, execHostPort,
+                    new HashMap<Integer, List<TScanRangeParams>>());
+                List<TScanRangeParams> scanRangeParamsList =
+                    findOrInsert(scanRanges, scanNode.getId().asInt(), new ArrayList<TScanRangeParams>());
+                TScanRangeParams scanRangeParams = new TScanRangeParams();
+                scanRangeParams.scan_range = scanRangeLocations.scan_range;
+                for (TScanRangeLocation location : scanRangeLocations.getLocations()) {
+                    if (location.backend_id == backendId) {
+                        scanRangeParams.setVolume_id(location.volume_id);
+                        break;
+                    }
+                }
+                scanRangeParamsList.add(scanRangeParams);
+            }
+        }
     }
 
     // Does a scan range assignment (returned in 'assignment') based on a list
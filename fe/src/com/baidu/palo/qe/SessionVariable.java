@@ -59,6 +59,11 @@ public class SessionVariable implements Serializable, Writable {
     public static final String SQL_SAFE_UPDATES = "sql_safe_updates";
     public static final String NET_BUFFER_LENGTH = "net_buffer_length";
     public static final String CODEGEN_LEVEL = "codegen_level";
+    public static final String DISABLE_DATA_PAGE_CACHE = "disable_data_page_cache";
+    public static final String ENABLE_QUERY_TRACE = "enable_query_trace";
+    public static final String ENABLE_MULTI_DISTINCT_COUNT = "enable_multi_distinct_count";
+    public static final String ENABLE_COLOCATE_JOIN = "enable_colocate_join";
+    public static final String ENABLE_PARTITION_TOPN = "enable_partition_topn";
     
     // max memory used on every backend.
     @VariableMgr.VarAttr(name = EXEC_MEM_LIMIT)
@@ -156,6 +161,31 @@ public class SessionVariable implements Serializable, Writable {
     @VariableMgr.VarAttr(name = CODEGEN_LEVEL)
     private int codegenLevel = 0;    
 
+    // if true, big ad-hoc scans do not pollute the data page cache of backends.
+    @VariableMgr.VarAttr(name = DISABLE_DATA_PAGE_CACHE)
+    private boolean disableDataPageCache = false;
+
+    // record a timeline of the query on the backends, fetched from their /api/query_trace
+    @VariableMgr.VarAttr(name = ENABLE_QUERY_TRACE)
+    private boolean enableQueryTrace = false;
+
+    // if true, several COUNT(DISTINCT) and SUM(DISTINCT) over different columns are
+    // evaluated as multi_distinct_count() and multi_distinct_sum() in one aggregation
+    // instead of grouping by all their columns
+    @VariableMgr.VarAttr(name = ENABLE_MULTI_DISTINCT_COUNT)
+    private boolean enableMultiDistinctCount = true;
+
+    // if true, a join of two olap tables hash distributed on the join columns into the
+    // same number of buckets is executed where the tablets are, bucket by bucket,
+    // instead of shuffling both sides
+    @VariableMgr.VarAttr(name = ENABLE_COLOCATE_JOIN)
+    private boolean enableColocateJoin = true;
+
+    // if true, the rows of ROW_NUMBER()/RANK() filtered on a rank limit are cut to the
+    // first ones of each partition before they are shuffled and sorted
+    @VariableMgr.VarAttr(name = ENABLE_PARTITION_TOPN)
+    private boolean enablePartitionTopN = true;
+
     public long getMaxExecMemByte() {
         return maxExecMemByte;
     }
@@ -356,6 +386,46 @@ public class SessionVariable implements Serializable, Writable {
         this.codegenLevel = codegenLevel;
     }
 
+    public boolean isDisableDataPageCache() {
+        return disableDataPageCache;
+    }
+
+    public void setDisableDataPageCache(boolean disableDataPageCache) {
+        this.disableDataPageCache = disableDataPageCache;
+    }
+
+    public boolean isEnableQueryTrace() {
+        return enableQueryTrace;
+    }
+
+    public void setEnableQueryTrace(boolean enableQueryTrace) {
+        this.enableQueryTrace = enableQueryTrace;
+    }
+
+    public boolean isEnableMultiDistinctCount() {
+        return enableMultiDistinctCount;
+    }
+
+    public void setEnableMultiDistinctCount(boolean enableMultiDistinctCount) {
+        this.enableMultiDistinctCount = enableMultiDistinctCount;
+    }
+
+    public boolean isEnableColocateJoin() {
+        return enableColocateJoin;
+    }
+
+    public void setEnableColocateJoin(boolean enableColocateJoin) {
+        this.enableColocateJoin = enableColocateJoin;
+    }
+
+    public boolean isEnablePartitionTopN() {
+        return enablePartitionTopN;
+    }
+
+    public void setEnablePartitionTopN(boolean enablePartitionTopN) {
+        this.enablePartitionTopN = enablePartitionTopN;
+    }
+
     public void setMaxExecMemByte(long maxExecMemByte) {
         this.maxExecMemByte = maxExecMemByte;
     }
@@ -383,6 +453,8 @@ public class SessionVariable implements Serializable, Writable {
         tResult.setQuery_timeout(queryTimeoutS);
         tResult.setIs_report_success(isReportSucc);
         tResult.setCodegen_level(codegenLevel);
+        tResult.setDisable_data_page_cache(disableDataPageCache);
+        tResult.setEnable_query_trace(enableQueryTrace);
         return tResult;
     }
 
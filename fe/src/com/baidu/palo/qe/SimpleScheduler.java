@@ -85,6 +85,19 @@ public class SimpleScheduler {
         return null;
     }
     
+    public static boolean isAvailable(long backendId, ImmutableMap<Long, Backend> backends) {
+        if (backends == null) {
+            return false;
+        }
+        Backend backend = backends.get(backendId);
+        lock.lock();
+        try {
+            return backend != null && backend.isAlive() && !blacklistBackends.containsKey(backendId);
+        } finally {
+            lock.unlock();
+        }
+    }
+
     public static TNetworkAddress getHost(ImmutableMap<Long, Backend> backends,
                                           Reference<Long> backendIdRef) {
         if (backends == null) {
@@ -15,6 +15,9 @@
 
 package com.baidu.palo.task;
 
+import com.baidu.palo.catalog.BrokerMgr;
+import com.baidu.palo.catalog.Catalog;
+import com.baidu.palo.thrift.TNetworkAddress;
 import com.baidu.palo.thrift.TResourceInfo;
 import com.baidu.palo.thrift.TRestoreReq;
 import com.baidu.palo.thrift.TTaskType;
@@ -57,6 +60,13 @@ public class RestoreTask extends AgentTask {
 
     public TRestoreReq toThrift() {
         TRestoreReq req = new TRestoreReq(tabletId, schemaHash, remoteFilePath, remoteProperties);
+        String brokerName = remoteProperties == null ? null : remoteProperties.get(UploadTask.BROKER_PROPERTY);
+        if (brokerName != null) {
+            BrokerMgr.BrokerAddress brokerAddress = Catalog.getInstance().getBrokerMgr().getAnyBroker(brokerName);
+            if (brokerAddress != null) {
+                req.addToBroker_addrs(new TNetworkAddress(brokerAddress.ip, brokerAddress.port));
+            }
+        }
         return req;
     }
 }
@@ -15,6 +15,9 @@
 
 package com.baidu.palo.task;
 
+import com.baidu.palo.catalog.BrokerMgr;
+import com.baidu.palo.catalog.Catalog;
+import com.baidu.palo.thrift.TNetworkAddress;
 import com.baidu.palo.thrift.TResourceInfo;
 import com.baidu.palo.thrift.TTaskType;
 import com.baidu.palo.thrift.TUploadReq;
@@ -22,6 +25,7 @@ import com.baidu.palo.thrift.TUploadReq;
 import java.util.Map;
 
 public class UploadTask extends AgentTask {
+    public static final String BROKER_PROPERTY = "broker";
 
     private long jobId;
     private String src;
@@ -58,6 +62,14 @@ public class UploadTask extends AgentTask {
     public TUploadReq toThrift() {
         TUploadReq request = new TUploadReq(src, dest, remoteSourceProperties);
         request.setTablet_id(tabletId);
+        // let backend transfer the snapshot through broker itself if one is named
+        String brokerName = remoteSourceProperties == null ? null : remoteSourceProperties.get(BROKER_PROPERTY);
+        if (brokerName != null) {
+            BrokerMgr.BrokerAddress brokerAddress = Catalog.getInstance().getBrokerMgr().getAnyBroker(brokerName);
+            if (brokerAddress != null) {
+                request.addToBroker_addrs(new TNetworkAddress(brokerAddress.ip, brokerAddress.port));
+            }
+        }
         return request;
     }
 }
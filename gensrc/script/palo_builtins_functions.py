@@ -533,13 +533,25 @@ visible_functions = [
 
     # Json functions
     [['get_json_int'], 'INT', ['VARCHAR', 'VARCHAR'], 
-        '_ZN4palo13JsonFunctions12get_json_intEPN8palo_udf15FunctionContextERKNS1_9StringValES6_'],
+        '_ZN4palo13JsonFunctions12get_json_intEPN8palo_udf15FunctionContextERKNS1_9StringValES6_',
+            '_ZN4palo13JsonFunctions17json_path_prepareEPN8palo_udf'
+            '15FunctionContextENS2_18FunctionStateScopeE',
+            '_ZN4palo13JsonFunctions15json_path_closeEPN8palo_udf'
+            '15FunctionContextENS2_18FunctionStateScopeE'],
     [['get_json_double'], 'DOUBLE', ['VARCHAR', 'VARCHAR'], 
         '_ZN4palo13JsonFunctions15get_json_doubleEPN8palo_udf'
-        '15FunctionContextERKNS1_9StringValES6_'],
+        '15FunctionContextERKNS1_9StringValES6_',
+            '_ZN4palo13JsonFunctions17json_path_prepareEPN8palo_udf'
+            '15FunctionContextENS2_18FunctionStateScopeE',
+            '_ZN4palo13JsonFunctions15json_path_closeEPN8palo_udf'
+            '15FunctionContextENS2_18FunctionStateScopeE'],
     [['get_json_string'], 'VARCHAR', ['VARCHAR', 'VARCHAR'], 
         '_ZN4palo13JsonFunctions15get_json_stringEPN8palo_udf'
-        '15FunctionContextERKNS1_9StringValES6_'],
+        '15FunctionContextERKNS1_9StringValES6_',
+            '_ZN4palo13JsonFunctions17json_path_prepareEPN8palo_udf'
+            '15FunctionContextENS2_18FunctionStateScopeE',
+            '_ZN4palo13JsonFunctions15json_path_closeEPN8palo_udf'
+            '15FunctionContextENS2_18FunctionStateScopeE'],
 
     #hll function
     [['hll_cardinality'], 'VARCHAR', ['VARCHAR'],
@@ -551,10 +563,18 @@ visible_functions = [
     # aes and base64 function
     [['aes_encrypt'], 'VARCHAR', ['VARCHAR', 'VARCHAR'],
         '_ZN4palo19EncryptionFunctions11aes_encryptEPN8palo_udf'
-        '15FunctionContextERKNS1_9StringValES6_'],
+        '15FunctionContextERKNS1_9StringValES6_',
+        '_ZN4palo19EncryptionFunctions11aes_prepareEPN8palo_udf'
+        '15FunctionContextENS2_18FunctionStateScopeE',
+        '_ZN4palo19EncryptionFunctions9aes_closeEPN8palo_udf'
+        '15FunctionContextENS2_18FunctionStateScopeE'],
     [['aes_decrypt'], 'VARCHAR', ['VARCHAR', 'VARCHAR'],
         '_ZN4palo19EncryptionFunctions11aes_decryptEPN8palo_udf'
-        '15FunctionContextERKNS1_9StringValES6_'],
+        '15FunctionContextERKNS1_9StringValES6_',
+        '_ZN4palo19EncryptionFunctions11aes_prepareEPN8palo_udf'
+        '15FunctionContextENS2_18FunctionStateScopeE',
+        '_ZN4palo19EncryptionFunctions9aes_closeEPN8palo_udf'
+        '15FunctionContextENS2_18FunctionStateScopeE'],
     [['from_base64'], 'VARCHAR', ['VARCHAR'],
         '_ZN4palo19EncryptionFunctions11from_base64EPN8palo_udf'
         '15FunctionContextERKNS1_9StringValE'],
@@ -33,6 +33,11 @@ struct TColumn {
     5: optional bool is_allow_null
     6: optional string default_value
     7: optional bool is_bloom_filter_column
+    // compression of the column, use the table compression if not set
+    8: optional Types.TCompressKind compress_kind
+    9: optional i32 compress_level
+    // use cache line blocked bloom filter, only valid for bloom filter column
+    10: optional bool is_blocked_bloom_filter
 }
 
 struct TTabletSchema {
@@ -115,6 +120,9 @@ struct TUploadReq {
     2: required string remote_file_path
     3: required map<string, string> remote_source_properties
     4: optional Types.TTabletId tablet_id
+    // if set, files are uploaded through these brokers by backend itself
+    // instead of the external transfer tool
+    5: optional list<Types.TNetworkAddress> broker_addrs
 }
 
 struct TRestoreReq {
@@ -122,6 +130,9 @@ struct TRestoreReq {
     2: required Types.TSchemaHash schema_hash
     3: required string remote_file_path
     4: required map<string, string> remote_source_properties
+    // if set, files are downloaded through these brokers by backend itself
+    // instead of the external transfer tool
+    5: optional list<Types.TNetworkAddress> broker_addrs
 }
 
 struct TSnapshotRequest {
@@ -130,6 +141,8 @@ struct TSnapshotRequest {
     3: optional Types.TVersion version
     4: optional Types.TVersionHash version_hash
     5: optional i64 timeout
+    // only make snapshot of these single deltas, used by incremental clone
+    6: optional list<Types.TVersion> missing_version
 }
 
 struct TReleaseSnapshotRequest {
@@ -47,6 +47,12 @@ struct TRowBatch {
   6: i32 be_number
   // packet seq
   7: i64 packet_seq
+
+  // Indicates whether tuple_data holds the tuples column by column instead of one
+  // tuple after the other, see ColumnarRowBatchCodec. The columns are compressed
+  // one by one, is_compressed is false then. tuple_offsets contains the index of each
+  // tuple among the non-NULL tuples of its tuple id in that case.
+  8: optional bool is_columnar
 }
 
 // this is a union over all possible return types
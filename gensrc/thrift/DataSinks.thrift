@@ -85,6 +85,8 @@ struct TExportSink {
     // properties need to access broker.
     5: optional list<Types.TNetworkAddress> broker_addresses
     6: optional map<string, string> properties;
+    // compression of the exported files, NONE if not set
+    7: optional Types.TCompressKind compress_kind
 }
 
 struct TDataSink {
@@ -37,9 +37,33 @@ struct TBackendInfo {
     3: optional Types.TPort be_rpc_port
 }
 
+// Load of a storage root path, sampled by the disk monitor of the backend
+struct TDiskLoad {
+    1: required string root_path
+    // Share of the time the disk was busy, in percent
+    2: optional i32 io_util_percent
+    // Read latency, the larger of the p99 measured by the storage engine and the
+    // average reported by the kernel
+    3: optional i64 read_latency_us
+}
+
+// Load of a backend, for the frontend to route reads away from busy replicas.
+// A field is unset if the backend can't tell it.
+struct TBackendLoad {
+    // Scanner tasks waiting for a thread
+    1: optional i32 scan_queue_size
+    // Share of the time the CPUs of the machine were busy, in percent
+    2: optional i32 cpu_busy_percent
+    3: optional i64 mem_used_bytes
+    4: optional i64 mem_limit_bytes
+    5: optional i32 num_running_fragments
+    6: optional list<TDiskLoad> disk_loads
+}
+
 struct THeartbeatResult {
     1: required Status.TStatus status 
     2: required TBackendInfo backend_info
+    3: optional TBackendLoad backend_load
 }
 
 service HeartbeatService {
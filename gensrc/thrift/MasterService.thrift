@@ -26,6 +26,19 @@ include "PaloInternalService.thrift"
 include "Types.thrift"
 include "Status.thrift"
 
+// statistics of a column in one tablet, estimated by backend from the
+// sketches recorded in segments
+struct TColumnSketch {
+    1: required string column_name
+    2: required i64 num_rows
+    3: required i64 num_nulls
+    // estimated number of distinct non-null values
+    4: required i64 ndv
+    // bounds of an equi-depth histogram in ascending order, every bucket
+    // holds about the same number of rows
+    5: optional list<string> histogram_bounds
+}
+
 struct TTabletInfo {
     1: required Types.TTabletId tablet_id
     2: required Types.TSchemaHash schema_hash
@@ -34,6 +47,7 @@ struct TTabletInfo {
     5: required Types.TCount row_count
     6: required Types.TSize data_size
     7: optional Types.TStorageMedium storage_medium
+    8: optional list<TColumnSketch> column_sketches
 }
 
 struct TFinishTaskRequest {
@@ -67,11 +81,18 @@ struct TReportRequest {
     3: optional map<Types.TTaskType, set<i64>> tasks // string signature
     4: optional map<Types.TTabletId, TTablet> tablets
     5: optional map<string, TDisk> disks // string root_path
+    // 'tablets' only holds the tablets that changed since the last report the master
+    // accepted, the ones dropped since are in 'removed_tablets'
+    6: optional bool incremental
+    7: optional set<Types.TTabletId> removed_tablets
 }
 
 struct TMasterResult {
     // required in V1
     1: required Status.TStatus status
+    // set by masters that understand TReportRequest.incremental, backends only send
+    // incremental tablet reports after the master said so
+    2: optional bool accepts_incremental_report
 }
 
 // Now we only support CPU share.
@@ -795,6 +795,266 @@ const map<string,TMetricDef> TMetricDefs =
     "label": "OlapEngine cumulative compatcion size", 
     "units": Metrics.TUnit.NONE
   }, 
+  "palo_be.olap.data_page_cache.lookup_count": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "The number of lookups in the cache of decompressed data pages.", 
+    "key": "palo_be.olap.data_page_cache.lookup_count", 
+    "kind": Metrics.TMetricKind.COUNTER, 
+    "label": "OlapEngine data page cache lookups", 
+    "units": Metrics.TUnit.UNIT
+  }, 
+  "palo_be.olap.data_page_cache.hit_count": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "The number of hits in the cache of decompressed data pages.", 
+    "key": "palo_be.olap.data_page_cache.hit_count", 
+    "kind": Metrics.TMetricKind.COUNTER, 
+    "label": "OlapEngine data page cache hits", 
+    "units": Metrics.TUnit.UNIT
+  }, 
+  "palo_be.olap.column_file_convert.delta_num": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "The number of row-oriented versions converted to column files.", 
+    "key": "palo_be.olap.column_file_convert.delta_num", 
+    "kind": Metrics.TMetricKind.COUNTER, 
+    "label": "OlapEngine converted versions", 
+    "units": Metrics.TUnit.UNIT
+  }, 
+  "palo_be.olap.column_file_convert.size": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "The size of the row-oriented versions converted to column files.", 
+    "key": "palo_be.olap.column_file_convert.size", 
+    "kind": Metrics.TMetricKind.COUNTER, 
+    "label": "OlapEngine converted size", 
+    "units": Metrics.TUnit.BYTES
+  }, 
+  "palo_be.olap.legacy_tablet_num": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "The number of tablets still stored in the row-oriented format.", 
+    "key": "palo_be.olap.legacy_tablet_num", 
+    "kind": Metrics.TMetricKind.GAUGE, 
+    "label": "OlapEngine legacy tablets", 
+    "units": Metrics.TUnit.UNIT
+  }, 
+  "palo_be.cache.lookups": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Number of lookups in a cache, by cache.", 
+    "key": "palo_be.cache.lookups", 
+    "kind": Metrics.TMetricKind.COUNTER, 
+    "label": "Cache lookups", 
+    "units": Metrics.TUnit.UNIT
+  }, 
+  "palo_be.cache.hits": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Number of lookups that hit a cache, by cache.", 
+    "key": "palo_be.cache.hits", 
+    "kind": Metrics.TMetricKind.COUNTER, 
+    "label": "Cache hits", 
+    "units": Metrics.TUnit.UNIT
+  }, 
+  "palo_be.cache.evictions": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Number of entries evicted from a cache to make room, by cache.", 
+    "key": "palo_be.cache.evictions", 
+    "kind": Metrics.TMetricKind.COUNTER, 
+    "label": "Cache evictions", 
+    "units": Metrics.TUnit.UNIT
+  }, 
+  "palo_be.cache.usage": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Charge of the entries in a cache, bytes for the memory caches, by cache.", 
+    "key": "palo_be.cache.usage", 
+    "kind": Metrics.TMetricKind.GAUGE, 
+    "label": "Cache usage", 
+    "units": Metrics.TUnit.UNIT
+  }, 
+  "palo_be.cache.capacity": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Capacity of a cache in the unit of its usage, by cache.", 
+    "key": "palo_be.cache.capacity", 
+    "kind": Metrics.TMetricKind.GAUGE, 
+    "label": "Cache capacity", 
+    "units": Metrics.TUnit.UNIT
+  }, 
+  "palo_be.disk.read_latency": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Distribution of the time of the reads of the storage engine, by root path.", 
+    "key": "palo_be.disk.read_latency", 
+    "kind": Metrics.TMetricKind.HISTOGRAM, 
+    "label": "Disk read latency", 
+    "units": Metrics.TUnit.TIME_NS
+  }, 
+  "palo_be.disk.write_latency": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Distribution of the time of the writes of the storage engine, by root path.", 
+    "key": "palo_be.disk.write_latency", 
+    "kind": Metrics.TMetricKind.HISTOGRAM, 
+    "label": "Disk write latency", 
+    "units": Metrics.TUnit.TIME_NS
+  }, 
+  "palo_be.disk.read_bytes": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Bytes read by the storage engine, by root path.", 
+    "key": "palo_be.disk.read_bytes", 
+    "kind": Metrics.TMetricKind.COUNTER, 
+    "label": "Disk bytes read", 
+    "units": Metrics.TUnit.BYTES
+  }, 
+  "palo_be.disk.write_bytes": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Bytes written by the storage engine, by root path.", 
+    "key": "palo_be.disk.write_bytes", 
+    "kind": Metrics.TMetricKind.COUNTER, 
+    "label": "Disk bytes written", 
+    "units": Metrics.TUnit.BYTES
+  }, 
+  "palo_be.disk.reads": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Number of reads of the storage engine, by root path.", 
+    "key": "palo_be.disk.reads", 
+    "kind": Metrics.TMetricKind.COUNTER, 
+    "label": "Disk reads", 
+    "units": Metrics.TUnit.UNIT
+  }, 
+  "palo_be.disk.writes": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Number of writes of the storage engine, by root path.", 
+    "key": "palo_be.disk.writes", 
+    "kind": Metrics.TMetricKind.COUNTER, 
+    "label": "Disk writes", 
+    "units": Metrics.TUnit.UNIT
+  }, 
+  "palo_be.olap.push.latency": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Distribution of the time to process a push.", 
+    "key": "palo_be.olap.push.latency", 
+    "kind": Metrics.TMetricKind.HISTOGRAM, 
+    "label": "OlapEngine push latency", 
+    "units": Metrics.TUnit.TIME_NS
+  }, 
+  "palo_be.olap.compaction.latency": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Distribution of the time to run a compaction, by type of compaction.", 
+    "key": "palo_be.olap.compaction.latency", 
+    "kind": Metrics.TMetricKind.HISTOGRAM, 
+    "label": "OlapEngine compaction latency", 
+    "units": Metrics.TUnit.TIME_NS
+  }, 
+  "palo_be.olap.tablet_scan_latency": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Distribution of the time from opening to closing the scan of a tablet, by tablet.", 
+    "key": "palo_be.olap.tablet_scan_latency", 
+    "kind": Metrics.TMetricKind.HISTOGRAM, 
+    "label": "OlapEngine tablet scan latency", 
+    "units": Metrics.TUnit.TIME_NS
+  }, 
+  "palo_be.olap.tablet_scan_rows": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Rows read from storage by the scans of a tablet, by tablet.", 
+    "key": "palo_be.olap.tablet_scan_rows", 
+    "kind": Metrics.TMetricKind.COUNTER, 
+    "label": "OlapEngine tablet scan rows", 
+    "units": Metrics.TUnit.UNIT
+  }, 
+  "palo_be.olap.tablet_read_bytes": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Bytes read from the files of a tablet by its scans, by tablet.", 
+    "key": "palo_be.olap.tablet_read_bytes", 
+    "kind": Metrics.TMetricKind.COUNTER, 
+    "label": "OlapEngine tablet read bytes", 
+    "units": Metrics.TUnit.BYTES
+  }, 
+  "palo_be.fragment.latency": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Distribution of the execution time of query fragment instances.", 
+    "key": "palo_be.fragment.latency", 
+    "kind": Metrics.TMetricKind.HISTOGRAM, 
+    "label": "Query fragment latency", 
+    "units": Metrics.TUnit.TIME_NS
+  }, 
+  "palo_be.admission.queued_fragments": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "The number of fragments waiting for admission into their resource group.", 
+    "key": "palo_be.admission.queued_fragments", 
+    "kind": Metrics.TMetricKind.GAUGE, 
+    "label": "Queued fragments", 
+    "units": Metrics.TUnit.UNIT
+  }, 
+  "palo_be.admission.timed_out_fragments": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "The number of fragments that timed out waiting for admission.", 
+    "key": "palo_be.admission.timed_out_fragments", 
+    "kind": Metrics.TMetricKind.COUNTER, 
+    "label": "Fragments timed out in the queue", 
+    "units": Metrics.TUnit.UNIT
+  }, 
+  "palo_be.admission.queue_wait_ms": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "The total time fragments waited for admission.", 
+    "key": "palo_be.admission.queue_wait_ms", 
+    "kind": Metrics.TMetricKind.COUNTER, 
+    "label": "Admission queue wait time", 
+    "units": Metrics.TUnit.TIME_MS
+  }, 
+  "palo_be.thrift_server.$0.rpc_latency": {
+    "contexts": [
+      "PALO BE"
+    ], 
+    "description": "Distribution of the time the thrift server $0 takes to process a call, by method.", 
+    "key": "palo_be.thrift_server.$0.rpc_latency", 
+    "kind": Metrics.TMetricKind.HISTOGRAM, 
+    "label": "Thrift server $0 rpc latency", 
+    "units": Metrics.TUnit.TIME_NS
+  }, 
   "palo_be.thrift_server.PaloBackend.connections_in_use": {
     "contexts": [
       "PALO BE"
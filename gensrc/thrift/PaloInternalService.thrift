@@ -88,6 +88,12 @@ struct TQueryOptions {
   // INT64::MAX
   17: optional i64 kudu_latest_observed_ts = 9223372036854775807
   18: optional TQueryType query_type = TQueryType.SELECT
+
+  // if true, storage scan does not read or fill the data page cache
+  19: optional bool disable_data_page_cache = false
+
+  // if true, the backends record a timeline of the query, see /api/query_trace
+  20: optional bool enable_query_trace = false
 }
 
 // A scan range plus the parameters needed to execute that scan.
@@ -299,6 +305,14 @@ struct TFetchRequest {
     13: required list<TCondition> where
     14: optional string end_range
     15: optional bool aggregation
+    16: optional PlanNodes.TPushAggOp push_agg_op
+    // read only the versions [start_version, version] instead of [0, version]
+    17: optional i32 start_version
+    // values of each leading key column to skip-scan the only key range with
+    18: optional list<list<string>> skip_scan_values
+    // rows needn't be returned in key order, so the storage may stop merging rows
+    // with equal key when that reduces few rows. Only meaningful with aggregation.
+    19: optional bool adaptive_aggregation
 }
 
 struct TShowHintsRequest {
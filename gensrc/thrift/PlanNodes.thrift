@@ -46,6 +46,7 @@ enum TPlanNodeType {
   BROKER_SCAN_NODE
   EMPTY_SET_NODE    
   UNION_NODE
+  PARTITION_TOPN_NODE
 }
 
 // phases of an execution node
@@ -95,7 +96,9 @@ enum TFileFormatType {
     FORMAT_CSV_LZO,
     FORMAT_CSV_BZ2,
     FORMAT_CSV_LZ4FRAME,
-    FORMAT_CSV_LZOP
+    FORMAT_CSV_LZOP,
+    FORMAT_PARQUET,
+    FORMAT_CSV_ZSTD
 }
 
 // One broker range information.
@@ -157,6 +160,9 @@ struct TMySQLScanNode {
   2: required string table_name
   3: required list<string> columns
   4: required list<string> filters
+  // Integer key column the scan may split into ranges that are read in parallel,
+  // quoted like columns.
+  5: optional string split_column
 }
 
 struct TBrokerScanNode {
@@ -215,12 +221,55 @@ struct TMetaScanNode {
   5: optional string user
 }
 
+enum TAggregationOp {
+  INVALID,
+  COUNT,
+  MAX,
+  DISTINCT_PC,
+  DISTINCT_PCSA,
+  MIN,
+  SUM,
+  GROUP_CONCAT,
+  HLL,
+  COUNT_DISTINCT,
+  SUM_DISTINCT,
+  LEAD,
+  FIRST_VALUE,
+  LAST_VALUE,
+  RANK,
+  DENSE_RANK,
+  ROW_NUMBER,
+  LAG,
+  HLL_C, 
+}
+
+// Aggregation which can be answered from the meta of tablets
+enum TPushAggOp {
+  NONE,
+  COUNT,
+  MINMAX
+}
+
+// A slot aggregated by olap scanners, op is SUM, MIN or MAX
+struct TOlapScanAggSlot {
+  1: required Types.TSlotId slot_id
+  2: required TAggregationOp op
+}
+
 struct TOlapScanNode {
   1: required Types.TTupleId tuple_id
   2: required list<string> key_column_name
   3: required list<Types.TPrimitiveType> key_column_type
   4: required bool is_preaggregation
   5: optional string sort_column
+  6: optional TPushAggOp push_agg_op
+
+  // If set, the scanners aggregate consecutive rows with equal streaming_agg_group_slots
+  // before sending them up, keeping the layout of the tuple, so the aggregation node
+  // above merges the partial results. Other materialized slots are only used by the
+  // conjuncts of the scan node.
+  7: optional list<Types.TSlotId> streaming_agg_group_slots
+  8: optional list<TOlapScanAggSlot> streaming_agg_slots
 }
 struct TEqJoinCondition {
   // left-hand side of "<a> = <b>"
@@ -263,6 +312,14 @@ struct THashJoinNode {
   // If true, this join node can (but may choose not to) generate slot filters
   // after constructing the build side that can be applied to the probe side.
   5: optional bool add_probe_filters
+
+  // If true, the build input is broadcast to all instances of this join, so the
+  // instances on one backend can share a single hash table.
+  6: optional bool is_broadcast
+
+  // If true, both inputs are scans of the tablets of the same buckets, so the join
+  // runs where the data is and the hash table holds the build rows of these buckets.
+  7: optional bool is_colocate
 }
 
 struct TMergeJoinNode {
@@ -272,28 +329,12 @@ struct TMergeJoinNode {
   // anything from the ON or USING clauses (but *not* the WHERE clause) that's not an
   // equi-join predicate
   2: optional list<Exprs.TExpr> other_join_conjuncts
-}
 
-enum TAggregationOp {
-  INVALID,
-  COUNT,
-  MAX,
-  DISTINCT_PC,
-  DISTINCT_PCSA,
-  MIN,
-  SUM,
-  GROUP_CONCAT,
-  HLL,
-  COUNT_DISTINCT,
-  SUM_DISTINCT,
-  LEAD,
-  FIRST_VALUE,
-  LAST_VALUE,
-  RANK,
-  DENSE_RANK,
-  ROW_NUMBER,
-  LAG,
-  HLL_C, 
+  // If set, both children return rows ordered by cmp_conjuncts (e.g. key ordered scans
+  // of tablets) and the node joins them without building a hash table.
+  // INNER_JOIN and LEFT_OUTER_JOIN are supported. If not set, the rows of the two
+  // children are only merged in order.
+  3: optional TJoinOp join_op
 }
 
 //struct TAggregateFunctionCall {
@@ -325,6 +366,10 @@ struct TAggregationNode {
   // Set to true if this aggregation function requires finalization to complete after all
   // rows have been aggregated, and this node is not an intermediate node.
   5: required bool need_finalize
+
+  // Set by the planner on the first phase of a multi-phase aggregation. The node may
+  // stop aggregating and pass rows through to its parent if it is not reducing them.
+  6: optional bool use_streaming_preaggregation
 }
 
 struct TPreAggregationNode {
@@ -451,6 +496,26 @@ struct TAnalyticNode {
   9: optional Exprs.TExpr order_by_eq
 }
 
+// Keeps the first rows of each partition of its input in the order of ordering_exprs,
+// below the sort of a ROW_NUMBER()/RANK() filtered on the rank. Passes on the rows
+// unchanged and in no particular order.
+struct TPartitionTopNNode {
+  // Exprs that the input is partitioned on, empty for a single partition
+  1: required list<Exprs.TExpr> partition_exprs
+
+  // Exprs that the rows of a partition are ranked on
+  2: required list<Exprs.TExpr> ordering_exprs
+  3: required list<bool> is_asc_order
+  4: required list<bool> nulls_first
+
+  // Number of rows kept per partition
+  5: required i64 partition_limit
+
+  // If true, the rows equal to the last kept row of a partition in ordering_exprs are
+  // kept too, as RANK() gives them the same rank
+  6: optional bool keep_ties
+}
+
 struct TMergeNode {
   // A MergeNode could be the left input of a join and needs to know which tuple to write.
   1: required Types.TTupleId tuple_id
@@ -528,6 +593,7 @@ struct TPlanNode {
   26: optional TOlapRewriteNode olap_rewrite_node
   27: optional TKuduScanNode kudu_scan_node
   28: optional TUnionNode union_node
+  29: optional TPartitionTopNNode partition_topn_node
 }
 
 // A flattened representation of a tree of PlanNodes, obtained by depth-first
@@ -41,6 +41,13 @@ enum TStorageType {
     COLUMN,
 }
 
+enum TCompressKind {
+    NONE,
+    LZO,
+    LZ4,
+    ZSTD,
+}
+
 enum TStorageMedium {
     HDD,
     SSD,
@@ -232,6 +239,8 @@ struct TScalarFunction {
     1: required string symbol
     2: optional string prepare_fn_symbol
     3: optional string close_fn_symbol
+    // Symbol of the UdfBatchFn evaluating the function over a batch of rows
+    4: optional string batch_fn_symbol
 }
 
 struct TAggregateFunction {
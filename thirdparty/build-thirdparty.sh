@@ -341,6 +341,15 @@ build_lz4() {
     INCLUDEDIR=$TP_INCLUDE_DIR/lz4/
 }
 
+# zstd
+build_zstd() {
+    check_if_source_exist $ZSTD_SOURCE
+    cd $TP_SOURCE_DIR/$ZSTD_SOURCE/lib
+
+    make -j$PARALLEL install PREFIX=$TP_INSTALL_DIR \
+    INCLUDEDIR=$TP_INCLUDE_DIR/zstd/
+}
+
 # bzip
 build_bzip() {
     check_if_source_exist $BZIP_SOURCE
@@ -440,6 +449,7 @@ build_libevent
 build_openssl
 build_zlib
 build_lz4
+build_zstd
 build_bzip
 build_lzo2
 build_boost # must before thrift
@@ -124,6 +124,11 @@ LZ4_DOWNLOAD="https://github.com/lz4/lz4/archive/v1.7.5.tar.gz"
 LZ4_NAME=lz4-1.7.5.tar.gz
 LZ4_SOURCE=lz4-1.7.5
 
+# zstd
+ZSTD_DOWNLOAD="https://github.com/facebook/zstd/archive/v1.3.3.tar.gz"
+ZSTD_NAME=zstd-1.3.3.tar.gz
+ZSTD_SOURCE=zstd-1.3.3
+
 # bzip
 BZIP_DOWNLOAD="http://www.bzip.org/1.0.6/bzip2-1.0.6.tar.gz"
 BZIP_NAME=bzip2-1.0.6.tar.gz
@@ -170,4 +175,4 @@ BOOST_FOR_MYSQL_NAME=boost_1_59_0.tar.gz
 BOOST_FOR_MYSQL_SOURCE=boost_1_59_0
 
 # all thirdparties which need to be downloaded is set in array TP_ARCHIVES
-export TP_ARCHIVES=(LIBEVENT OPENSSL THRIFT LLVM CLANG COMPILER_RT PROTOBUF GFLAGS GLOG GTEST RAPIDJSON SNAPPY GPERFTOOLS ZLIB LZ4 BZIP LZO2 NCURSES CURL RE2 BOOST MYSQL BOOST_FOR_MYSQL)
+export TP_ARCHIVES=(LIBEVENT OPENSSL THRIFT LLVM CLANG COMPILER_RT PROTOBUF GFLAGS GLOG GTEST RAPIDJSON SNAPPY GPERFTOOLS ZLIB LZ4 ZSTD BZIP LZO2 NCURSES CURL RE2 BOOST MYSQL BOOST_FOR_MYSQL)